@@ -203,6 +203,8 @@ struct ccat_mac_infoblock {
  * @rx_fifo: fifo used for RX descriptors
  * @tx_fifo: fifo used for TX descriptors
  * @poll_timer: interval timer used to poll CCAT for events like link changed, rx done, tx done
+ *              (not used, when attached to the EtherCAT master)
+ * @ec_watchdog_jiffies: time of the last link check or received frame in EtherCAT mode
  */
 struct ccat_eth_priv {
 	struct ccat_function *func;
@@ -213,6 +215,7 @@ struct ccat_eth_priv {
 	struct hrtimer poll_timer;
 	struct ccat_dma_mem dma_mem;
 	ec_device_t *ecdev;
+	unsigned long ec_watchdog_jiffies;
 	void (*carrier_off) (struct net_device * netdev);
 	 bool(*carrier_ok) (const struct net_device * netdev);
 	void (*carrier_on) (struct net_device * netdev);
@@ -331,11 +334,13 @@ static void ecdev_nop(struct net_device *const netdev)
 static void ecdev_receive_dma(struct ccat_eth_priv *const priv, size_t len)
 {
 	ecdev_receive(priv->ecdev, priv->rx_fifo.dma.next->data, len);
+	priv->ec_watchdog_jiffies = jiffies;
 }
 
 static void ecdev_receive_eim(struct ccat_eth_priv *const priv, size_t len)
 {
 	ecdev_receive(priv->ecdev, priv->rx_fifo.eim.next->data, len);
+	priv->ec_watchdog_jiffies = jiffies;
 }
 
 static void unregister_ecdev(struct net_device *const netdev)
@@ -766,10 +771,21 @@ static void poll_rx(struct ccat_eth_priv *const priv)
 	}
 }
 
+/**
+ * Poll function of the EtherCAT master
+ *
+ * Replaces the poll timer in EtherCAT mode. Transmitted frames need no
+ * reclaim, as the tx fifo state is read from the frame descriptors. The
+ * link register is only read, if no frame was received for a while.
+ */
 static void ec_poll(struct net_device *dev)
 {
 	struct ccat_eth_priv *const priv = netdev_priv(dev);
-	poll_link(priv);
+
+	if (jiffies - priv->ec_watchdog_jiffies >= 2 * HZ) {
+		poll_link(priv);
+		priv->ec_watchdog_jiffies = jiffies;
+	}
 	poll_rx(priv);
 }
 
@@ -919,6 +935,8 @@ static int ccat_eth_init_netdev(struct ccat_eth_priv *priv)
 	priv->ecdev = ecdev_offer(priv->netdev, ec_poll, THIS_MODULE);
 	if (priv->ecdev) {
 		priv->carrier_off(priv->netdev);
+		/* check the link at the first poll */
+		priv->ec_watchdog_jiffies = jiffies - 2 * HZ;
 		if (ecdev_open(priv->ecdev)) {
 			pr_info("unable to register network device.\n");
 			ecdev_withdraw(priv->ecdev);
@@ -56,6 +56,10 @@ typedef struct ec_device ec_device_t; /**< \see ec_device */
  */
 typedef void (*ec_pollfunc_t)(struct net_device *);
 
+/** Device receive interrupt control function type.
+ */
+typedef void (*ec_irqfunc_t)(struct net_device *, int);
+
 /******************************************************************************
  * Offering/withdrawal functions
  *****************************************************************************/
@@ -71,7 +75,16 @@ void ecdev_withdraw(ec_device_t *device);
 int ecdev_open(ec_device_t *device);
 void ecdev_close(ec_device_t *device);
 void ecdev_receive(ec_device_t *device, const void *data, size_t size);
+void ecdev_receive_stamped(ec_device_t *device, const void *data,
+        size_t size, u64 hw_time);
+void ecdev_tx_complete(ec_device_t *device, const struct sk_buff *skb);
+void ecdev_tx_stamped(ec_device_t *device, const struct sk_buff *skb,
+        u64 hw_time);
 void ecdev_set_link(ec_device_t *device, uint8_t state);
+void ecdev_set_split_poll(ec_device_t *device, ec_pollfunc_t rx_poll,
+        ec_pollfunc_t tx_reclaim);
+void ecdev_set_irq_control(ec_device_t *device, ec_irqfunc_t irq_control);
+void ecdev_irq(ec_device_t *device);
 uint8_t ecdev_get_link(const ec_device_t *device);
 
 /*****************************************************************************/
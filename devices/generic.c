@@ -39,6 +39,9 @@
 #include <linux/version.h>
 #include <linux/if_arp.h> /* ARPHRD_ETHER */
 #include <linux/etherdevice.h>
+#include <linux/rtnetlink.h>
+#include <linux/socket.h>
+#include <net/sock.h>
 
 #include "../globals.h"
 #include "ecdev.h"
@@ -49,6 +52,14 @@
 
 #define EC_GEN_RX_BUF_SIZE 1600
 
+/** Number of receive ring slots.
+ */
+#define EC_GEN_RX_RING_SIZE 32
+
+/** Number of transmit ring socket buffers.
+ */
+#define EC_GEN_TX_RING_SIZE 8
+
 /*****************************************************************************/
 
 int __init ec_gen_init_module(void);
@@ -65,8 +76,34 @@ MODULE_VERSION(EC_MASTER_VERSION);
 
 /** \endcond */
 
+/** Use the in-kernel frame rings instead of a packet socket.
+ */
+static unsigned int ec_gen_ring = 1;
+
+/** Steer EtherCAT frames off the interface's receive path.
+ */
+static unsigned int ec_gen_hook = 0;
+
+/** \cond */
+
+module_param_named(ring, ec_gen_ring, uint, S_IRUGO);
+MODULE_PARM_DESC(ring, "Use frame rings instead of a packet socket"
+        " (default 1).");
+module_param_named(hook, ec_gen_hook, uint, S_IRUGO);
+MODULE_PARM_DESC(hook, "Take EtherCAT frames from the interface's receive"
+        " path before the protocol stack (ring only, default 0).");
+
+/** \endcond */
+
 struct list_head generic_devices;
 
+/** Receive ring slot.
+ */
+typedef struct {
+    size_t size; /**< Frame size in byte. */
+    uint8_t data[EC_GEN_RX_BUF_SIZE]; /**< Frame data. */
+} ec_gen_rx_slot_t;
+
 typedef struct {
     struct list_head list;
     struct net_device *netdev;
@@ -74,6 +111,21 @@ typedef struct {
     struct socket *socket;
     ec_device_t *ecdev;
     uint8_t *rx_buf;
+
+    struct packet_type packet_type; /**< Receive handler of the ring
+                                      backend. */
+    unsigned int packet_type_added; /**< \a packet_type is registered. */
+    unsigned int rx_handler_registered; /**< The receive hook is registered
+                                          at \a used_netdev. */
+    ec_gen_rx_slot_t *rx_ring; /**< Receive ring, filled by the receive
+                                 handler and drained in place by the poll
+                                 function. */
+    unsigned int rx_head; /**< Next receive slot to fill. */
+    unsigned int rx_tail; /**< Next receive slot to pass to the master. */
+    spinlock_t rx_lock; /**< Serializes the receive handlers. */
+    unsigned int rx_dropped; /**< Frames dropped due to a full ring. */
+    struct sk_buff *tx_skbs[EC_GEN_TX_RING_SIZE]; /**< Transmit ring. */
+    unsigned int tx_index; /**< Next transmit socket buffer to use. */
 } ec_gen_device_t;
 
 typedef struct {
@@ -148,6 +200,15 @@ int ec_gen_device_init(
     dev->ecdev = NULL;
     dev->socket = NULL;
     dev->rx_buf = NULL;
+    dev->packet_type_added = 0;
+    dev->rx_handler_registered = 0;
+    dev->rx_ring = NULL;
+    dev->rx_head = 0;
+    dev->rx_tail = 0;
+    spin_lock_init(&dev->rx_lock);
+    dev->rx_dropped = 0;
+    memset(dev->tx_skbs, 0, sizeof(dev->tx_skbs));
+    dev->tx_index = 0;
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
     dev->netdev = alloc_netdev(sizeof(ec_gen_device_t *), &null,
@@ -181,6 +242,8 @@ void ec_gen_device_clear(
         ec_gen_device_t *dev
         )
 {
+    unsigned int i;
+
     if (dev->ecdev) {
         ecdev_close(dev->ecdev);
         ecdev_withdraw(dev->ecdev);
@@ -188,11 +251,28 @@ void ec_gen_device_clear(
     if (dev->socket) {
         sock_release(dev->socket);
     }
+    if (dev->packet_type_added) {
+        dev_remove_pack(&dev->packet_type);
+        dev_put(dev->used_netdev);
+    }
+    if (dev->rx_handler_registered) {
+        rtnl_lock();
+        netdev_rx_handler_unregister(dev->used_netdev);
+        rtnl_unlock();
+    }
+    for (i = 0; i < EC_GEN_TX_RING_SIZE; i++) {
+        if (dev->tx_skbs[i]) {
+            kfree_skb(dev->tx_skbs[i]);
+        }
+    }
     free_netdev(dev->netdev);
 
     if (dev->rx_buf) {
         kfree(dev->rx_buf);
     }
+    if (dev->rx_ring) {
+        kfree(dev->rx_ring);
+    }
 }
 
 /*****************************************************************************/
@@ -240,6 +320,160 @@ int ec_gen_device_create_socket(
         return ret;
     }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+    /* Accept launch times (SCM_TXTIME) for the ETF queueing discipline,
+     * which has to be configured with CLOCK_TAI. */
+    sock_set_flag(dev->socket->sk, SOCK_TXTIME);
+    dev->socket->sk->sk_clockid = CLOCK_TAI;
+#endif
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Stores a received frame in the receive ring.
+ *
+ * The frame is copied into the next free receive ring slot; if the ring is
+ * full, the frame is dropped.
+ */
+static void ec_gen_device_ring_store(
+        ec_gen_device_t *dev,
+        const struct sk_buff *skb
+        )
+{
+    int offset = skb_mac_header(skb) - skb->data;
+    unsigned int size = skb->len - offset, head, next;
+
+    if (size > EC_GEN_RX_BUF_SIZE) {
+        return;
+    }
+
+    spin_lock(&dev->rx_lock);
+    head = dev->rx_head;
+    next = (head + 1) % EC_GEN_RX_RING_SIZE;
+    if (next == dev->rx_tail) {
+        dev->rx_dropped++;
+    } else if (!skb_copy_bits(skb, offset, dev->rx_ring[head].data, size)) {
+        dev->rx_ring[head].size = size;
+        smp_wmb(); // publish the slot before advancing the head
+        dev->rx_head = next;
+    }
+    spin_unlock(&dev->rx_lock);
+}
+
+/*****************************************************************************/
+
+/** Receive handler of the ring backend.
+ *
+ * Called by the network stack for every EtherCAT frame received on the used
+ * interface.
+ */
+static int ec_gen_packet_rcv(
+        struct sk_buff *skb,
+        struct net_device *netdev,
+        struct packet_type *pt,
+        struct net_device *orig_dev
+        )
+{
+    ec_gen_device_t *dev = container_of(pt, ec_gen_device_t, packet_type);
+
+    ec_gen_device_ring_store(dev, skb);
+    kfree_skb(skb);
+    return NET_RX_SUCCESS;
+}
+
+/*****************************************************************************/
+
+/** Receive hook of the ring backend.
+ *
+ * Called by the interface's receive path for every frame, before it is
+ * passed to taps and protocol handlers. EtherCAT frames are consumed, all
+ * others are passed on unchanged.
+ */
+static rx_handler_result_t ec_gen_rx_handler(
+        struct sk_buff **pskb
+        )
+{
+    struct sk_buff *skb = *pskb;
+    ec_gen_device_t *dev;
+
+    if (skb->protocol != htons(ETH_P_ETHERCAT)) {
+        return RX_HANDLER_PASS;
+    }
+
+    dev = rcu_dereference(skb->dev->rx_handler_data);
+    ec_gen_device_ring_store(dev, skb);
+    kfree_skb(skb);
+    return RX_HANDLER_CONSUMED;
+}
+
+/*****************************************************************************/
+
+/** Creates the frame rings.
+ *
+ * Instead of a packet socket, a packet handler is registered for the
+ * EtherCAT protocol on the used interface. Received frames are copied once
+ * into a ring, that the poll function reads in place. Frames are sent by
+ * copying them into preallocated socket buffers, that are passed directly
+ * to the interface's queue.
+ *
+ * With the \a hook parameter, frames are instead taken from the
+ * interface's receive path by a receive hook, before the protocol stack
+ * sees them, and sent without the queueing discipline. Only one receive
+ * hook can be registered per interface, so if the interface is enslaved to
+ * a bridge or bond, the packet handler is used as a fallback.
+ */
+int ec_gen_device_create_ring(
+        ec_gen_device_t *dev,
+        ec_gen_interface_desc_t *desc
+        )
+{
+    unsigned int i;
+
+    dev->rx_ring = kmalloc(sizeof(ec_gen_rx_slot_t) * EC_GEN_RX_RING_SIZE,
+            GFP_KERNEL);
+    if (!dev->rx_ring) {
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < EC_GEN_TX_RING_SIZE; i++) {
+        dev->tx_skbs[i] = netdev_alloc_skb(desc->netdev, EC_GEN_RX_BUF_SIZE);
+        if (!dev->tx_skbs[i]) {
+            return -ENOMEM;
+        }
+        dev->tx_skbs[i]->dev = desc->netdev;
+    }
+
+    if (ec_gen_hook) {
+        int ret;
+
+        rtnl_lock();
+        ret = netdev_rx_handler_register(desc->netdev, ec_gen_rx_handler,
+                dev);
+        rtnl_unlock();
+
+        if (!ret) {
+            printk(KERN_INFO PFX "Hooking frame rings into interface"
+                    " %i (%s).\n", desc->ifindex, desc->name);
+            dev->rx_handler_registered = 1;
+            return 0;
+        }
+
+        printk(KERN_WARNING PFX "Failed to hook into interface %i (%s):"
+                " error %i. Using a packet handler.\n",
+                desc->ifindex, desc->name, ret);
+    }
+
+    printk(KERN_INFO PFX "Attaching frame rings to interface %i (%s).\n",
+            desc->ifindex, desc->name);
+
+    dev_hold(desc->netdev);
+    dev->packet_type.type = htons(ETH_P_ETHERCAT);
+    dev->packet_type.dev = desc->netdev;
+    dev->packet_type.func = ec_gen_packet_rcv;
+    dev_add_pack(&dev->packet_type);
+    dev->packet_type_added = 1;
     return 0;
 }
 
@@ -252,14 +486,20 @@ int ec_gen_device_offer(
         ec_gen_interface_desc_t *desc
         )
 {
-    int ret = 0;
+    int ret = 0, err;
 
     dev->used_netdev = desc->netdev;
     memcpy(dev->netdev->dev_addr, desc->dev_addr, ETH_ALEN);
 
     dev->ecdev = ecdev_offer(dev->netdev, ec_gen_poll, THIS_MODULE);
     if (dev->ecdev) {
-        if (ec_gen_device_create_socket(dev, desc)) {
+        if (ec_gen_ring) {
+            err = ec_gen_device_create_ring(dev, desc);
+        } else {
+            err = ec_gen_device_create_socket(dev, desc);
+        }
+
+        if (err) {
             ecdev_withdraw(dev->ecdev);
             dev->ecdev = NULL;
         } else if (ecdev_open(dev->ecdev)) {
@@ -298,6 +538,44 @@ int ec_gen_device_stop(
 
 /*****************************************************************************/
 
+/** Sends a frame via the transmit ring.
+ *
+ * A socket buffer still referenced by the network stack is not reused, so
+ * the frame is rejected, if the stack lags more than the ring size behind.
+ */
+int ec_gen_device_ring_xmit(
+        ec_gen_device_t *dev,
+        struct sk_buff *skb
+        )
+{
+    struct sk_buff *tx_skb = dev->tx_skbs[dev->tx_index];
+
+    if (skb_shared(tx_skb) || skb->len > EC_GEN_RX_BUF_SIZE) {
+        return NETDEV_TX_BUSY;
+    }
+
+    dev->tx_index = (dev->tx_index + 1) % EC_GEN_TX_RING_SIZE;
+
+    skb_trim(tx_skb, 0);
+    memcpy(skb_put(tx_skb, skb->len), skb->data, skb->len);
+    skb_reset_mac_header(tx_skb);
+    tx_skb->protocol = htons(ETH_P_ETHERCAT);
+    tx_skb->tstamp = skb->tstamp; // launch time for hardware offload
+
+    // keep a reference, so that the buffer survives the transmission
+    skb_get(tx_skb);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 18, 0)
+    if (dev->rx_handler_registered) {
+        return dev_direct_xmit(tx_skb, 0) == NETDEV_TX_OK ?
+            NETDEV_TX_OK : NETDEV_TX_BUSY;
+    }
+#endif
+    return dev_queue_xmit(tx_skb) == NET_XMIT_SUCCESS ?
+        NETDEV_TX_OK : NETDEV_TX_BUSY;
+}
+
+/*****************************************************************************/
+
 int ec_gen_device_start_xmit(
         ec_gen_device_t *dev,
         struct sk_buff *skb
@@ -306,14 +584,35 @@ int ec_gen_device_start_xmit(
     struct msghdr msg;
     struct kvec iov;
     size_t len = skb->len;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+    char control[CMSG_SPACE(sizeof(u64))];
+    struct cmsghdr *cmsg;
+#endif
     int ret;
 
     ecdev_set_link(dev->ecdev, netif_carrier_ok(dev->used_netdev));
 
+    if (dev->rx_ring) {
+        return ec_gen_device_ring_xmit(dev, skb);
+    }
+
     iov.iov_base = skb->data;
     iov.iov_len = len;
     memset(&msg, 0, sizeof(msg));
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+    if (ktime_to_ns(skb->tstamp)) {
+        // pass the launch time to the ETF queueing discipline
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_TXTIME;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(u64));
+        *(u64 *) CMSG_DATA(cmsg) = ktime_to_ns(skb->tstamp);
+    }
+#endif
+
     ret = kernel_sendmsg(dev->socket, &msg, &iov, 1, len);
 
     return ret == len ? NETDEV_TX_OK : NETDEV_TX_BUSY;
@@ -321,6 +620,26 @@ int ec_gen_device_start_xmit(
 
 /*****************************************************************************/
 
+/** Passes all frames in the receive ring to the master.
+ */
+void ec_gen_device_ring_poll(
+        ec_gen_device_t *dev
+        )
+{
+    unsigned int tail = dev->rx_tail;
+
+    while (tail != dev->rx_head) {
+        smp_rmb(); // read the slot only after the head
+        ecdev_receive(dev->ecdev, dev->rx_ring[tail].data,
+                dev->rx_ring[tail].size);
+        tail = (tail + 1) % EC_GEN_RX_RING_SIZE;
+        smp_mb(); // finish reading before releasing the slot
+        dev->rx_tail = tail;
+    }
+}
+
+/*****************************************************************************/
+
 /** Polls the device.
  */
 void ec_gen_device_poll(
@@ -333,6 +652,11 @@ void ec_gen_device_poll(
 
     ecdev_set_link(dev->ecdev, netif_carrier_ok(dev->used_netdev));
 
+    if (dev->rx_ring) {
+        ec_gen_device_ring_poll(dev);
+        return;
+    }
+
     do {
         iov.iov_base = dev->rx_buf;
         iov.iov_len = EC_GEN_RX_BUF_SIZE;
@@ -134,6 +134,16 @@ struct vf_data_storage {
 #define IGB_TX_WTHRESH	((hw->mac.type == e1000_82576 && \
 			  (adapter->flags & IGB_FLAG_HAS_MSIX)) ? 1 : 16)
 
+/* EtherCAT operation uses a single queue pair with small descriptor rings,
+ * which are polled cyclically. Only a few frames are exchanged per cycle, so
+ * few descriptors are prefetched and every descriptor is written back at
+ * once.
+ */
+#define IGB_EC_RING_COUNT	32
+#define IGB_EC_RX_PTHRESH	4
+#define IGB_EC_RX_HTHRESH	4
+#define IGB_EC_WTHRESH		1
+
 /* this is the size past which hardware will drop packets when setting LPE=0 */
 #define MAXIMUM_ETHERNET_VLAN_SIZE 1522
 
@@ -474,6 +484,9 @@ struct igb_adapter {
 	/* EtherCAT device variables */
 	ec_device_t *ecdev;
 	unsigned long ec_watchdog_jiffies;
+	struct delayed_work ec_link_task;
+	bool ec_irq;
+	bool ec_irq_enabled;
 };
 
 #define IGB_FLAG_HAS_MSI		(1 << 0)
@@ -549,6 +562,8 @@ void igb_ptp_rx_hang(struct igb_adapter *adapter);
 void igb_ptp_rx_rgtstamp(struct igb_q_vector *q_vector, struct sk_buff *skb);
 void igb_ptp_rx_pktstamp(struct igb_q_vector *q_vector, unsigned char *va,
 			 struct sk_buff *skb);
+void igb_ptp_ec_enable(struct igb_adapter *adapter);
+u64 igb_ptp_ec_systim(struct igb_adapter *adapter, u64 systim);
 int igb_ptp_set_ts_config(struct net_device *netdev, struct ifreq *ifr);
 int igb_ptp_get_ts_config(struct net_device *netdev, struct ifreq *ifr);
 void igb_set_flag_queue_pairs(struct igb_adapter *, const u32);
@@ -147,6 +147,7 @@ static irqreturn_t igb_intr(int irq, void *);
 static irqreturn_t igb_intr_msi(int irq, void *);
 static irqreturn_t igb_msix_other(int irq, void *);
 static irqreturn_t igb_msix_ring(int irq, void *);
+static irqreturn_t igb_ec_msix_ring(int irq, void *);
 #ifdef CONFIG_IGB_DCA
 static void igb_update_dca(struct igb_q_vector *);
 static void igb_setup_dca(struct igb_adapter *);
@@ -952,7 +953,26 @@ static int igb_request_msix(struct igb_adapter *adapter)
 	int i, err = 0, vector = 0, free_vector = 0;
 
 	if (adapter->ecdev) {
-		/* avoid requesting MSI-X. */
+		/* Only request the vector of the single queue pair, that
+		 * signals received frames in the idle phase of the master.
+		 */
+		struct igb_q_vector *q_vector = adapter->q_vector[0];
+
+		q_vector->itr_register = hw->hw_addr + E1000_EITR(1);
+		sprintf(q_vector->name, "%s-ec", netdev->name);
+
+		err = request_irq(adapter->msix_entries[1].vector,
+				  igb_ec_msix_ring, 0, q_vector->name,
+				  q_vector);
+		if (err) {
+			dev_warn(&adapter->pdev->dev,
+				 "Error %d getting interrupt, polling only\n",
+				 err);
+			return 0;
+		}
+
+		adapter->ec_irq = true;
+		igb_configure_msix(adapter);
 		return 0;
 	}
 
@@ -1464,7 +1484,12 @@ request_done:
 static void igb_free_irq(struct igb_adapter *adapter)
 {
 	if (adapter->ecdev) {
-		/* no IRQ to free in EtherCAT operation */
+		/* only the idle phase IRQ to free in EtherCAT operation */
+		if (adapter->ec_irq) {
+			free_irq(adapter->msix_entries[1].vector,
+				 adapter->q_vector[0]);
+			adapter->ec_irq = false;
+		}
 		return;
 	}
 
@@ -2147,16 +2172,7 @@ void ec_poll(struct net_device *netdev)
 {
 	struct igb_adapter *adapter = netdev_priv(netdev);
 	int i;
-	int budget = 64;
-
-	if (jiffies - adapter->ec_watchdog_jiffies >= 2 * HZ) {
-		struct e1000_hw *hw = &adapter->hw;
-		bool link;
-		hw->mac.get_link_status = true;
-		link = igb_has_link(adapter);
-		ecdev_set_link(adapter->ecdev, link);
-		adapter->ec_watchdog_jiffies = jiffies;
-	}
+	int budget = IGB_EC_RING_COUNT;
 
 	for (i = 0; i < adapter->num_q_vectors; i++) {
 		struct igb_q_vector *q_vector = adapter->q_vector[i];
@@ -2170,6 +2186,134 @@ void ec_poll(struct net_device *netdev)
 	}
 }
 
+/**
+ * ec_poll_rx - EtherCAT receive-only poll routine
+ * @netdev: net device structure
+ *
+ * Transmit cleanup is left to ec_reclaim_tx(), unless a transmit time stamp
+ * is pending, which has to be reported before the frame is received.
+ **/
+static void ec_poll_rx(struct net_device *netdev)
+{
+	struct igb_adapter *adapter = netdev_priv(netdev);
+	int i;
+
+	for (i = 0; i < adapter->num_q_vectors; i++) {
+		struct igb_q_vector *q_vector = adapter->q_vector[i];
+
+		if (q_vector->tx.ring && adapter->ptp_tx_skb)
+			igb_clean_tx_irq(q_vector);
+
+		if (q_vector->rx.ring)
+			igb_clean_rx_irq(q_vector, IGB_EC_RING_COUNT);
+	}
+}
+
+/**
+ * ec_reclaim_tx - EtherCAT transmit cleanup routine
+ * @netdev: net device structure
+ **/
+static void ec_reclaim_tx(struct net_device *netdev)
+{
+	struct igb_adapter *adapter = netdev_priv(netdev);
+	int i;
+
+	for (i = 0; i < adapter->num_q_vectors; i++) {
+		struct igb_q_vector *q_vector = adapter->q_vector[i];
+
+		if (q_vector->tx.ring)
+			igb_clean_tx_irq(q_vector);
+	}
+}
+
+/**
+ * igb_ec_irq_control - Enable or disable the EtherCAT receive interrupt
+ * @netdev: net device structure
+ * @enable: non-zero to enable the interrupt
+ *
+ * Called by the master, that waits for received frames in its idle phase.
+ **/
+static void igb_ec_irq_control(struct net_device *netdev, int enable)
+{
+	struct igb_adapter *adapter = netdev_priv(netdev);
+	struct e1000_hw *hw = &adapter->hw;
+	u32 eims = adapter->q_vector[0]->eims_value;
+
+	if (!adapter->ec_irq)
+		return;
+
+	adapter->ec_irq_enabled = enable;
+	if (enable)
+		wr32(E1000_EIMS, eims);
+	else
+		wr32(E1000_EIMC, eims);
+	wrfl();
+}
+
+/**
+ * igb_ec_msix_ring - EtherCAT receive interrupt handler
+ * @irq: interrupt number
+ * @data: pointer to the q_vector
+ **/
+static irqreturn_t igb_ec_msix_ring(int irq, void *data)
+{
+	struct igb_q_vector *q_vector = data;
+	struct igb_adapter *adapter = q_vector->adapter;
+	struct e1000_hw *hw = &adapter->hw;
+
+	ecdev_irq(adapter->ecdev);
+
+	/* re-arm the automatically masked vector */
+	if (adapter->ec_irq_enabled)
+		wr32(E1000_EIMS, q_vector->eims_value);
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * igb_ec_link_task - EtherCAT link check
+ * @work: pointer to work_struct containing our data
+ *
+ * Checks the link outside of the cyclic poll, if no frames were received
+ * recently.
+ **/
+static void igb_ec_link_task(struct work_struct *work)
+{
+	struct igb_adapter *adapter = container_of(work,
+						   struct igb_adapter,
+						   ec_link_task.work);
+
+	if (jiffies - adapter->ec_watchdog_jiffies >= 2 * HZ) {
+		struct e1000_hw *hw = &adapter->hw;
+		bool link;
+		hw->mac.get_link_status = true;
+		link = igb_has_link(adapter);
+		ecdev_set_link(adapter->ecdev, link);
+		adapter->ec_watchdog_jiffies = jiffies;
+	}
+
+	schedule_delayed_work(&adapter->ec_link_task, HZ);
+}
+
+/**
+ * igb_ec_init_queues - Set up the queues for EtherCAT operation
+ * @adapter: board private structure to initialize
+ *
+ * Replaces the RSS queues by a single queue pair with small descriptor
+ * rings, so that ec_poll() only has to look at one vector.
+ **/
+static int igb_ec_init_queues(struct igb_adapter *adapter)
+{
+	igb_clear_interrupt_scheme(adapter);
+
+	adapter->rss_queues = 1;
+	adapter->flags |= IGB_FLAG_QUEUE_PAIRS;
+	adapter->tx_ring_count = IGB_EC_RING_COUNT;
+	adapter->rx_ring_count = IGB_EC_RING_COUNT;
+
+	return igb_init_interrupt_scheme(adapter, true);
+}
+
 /**
  * igb_set_fw_version - Configure version string for ethtool
  * @adapter: adapter struct
@@ -2613,12 +2757,23 @@ static int igb_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 
 	adapter->ecdev = ecdev_offer(netdev, ec_poll, THIS_MODULE);
 	if (adapter->ecdev) {
+		ecdev_set_split_poll(adapter->ecdev, ec_poll_rx, ec_reclaim_tx);
+		err = igb_ec_init_queues(adapter);
+		if (err) {
+			ecdev_withdraw(adapter->ecdev);
+			goto err_register;
+		}
+		if (adapter->flags & IGB_FLAG_HAS_MSIX)
+			ecdev_set_irq_control(adapter->ecdev,
+					      igb_ec_irq_control);
 		err = ecdev_open(adapter->ecdev);
 		if (err) {
 			ecdev_withdraw(adapter->ecdev);
 			goto err_register;
 		}
 		adapter->ec_watchdog_jiffies = jiffies;
+		INIT_DELAYED_WORK(&adapter->ec_link_task, igb_ec_link_task);
+		schedule_delayed_work(&adapter->ec_link_task, HZ);
 	} else {
 		strcpy(netdev->name, "eth%d");
 		err = register_netdev(netdev);
@@ -2664,6 +2819,8 @@ static int igb_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 
 	/* do hw tstamp init after resetting */
 	igb_ptp_init(adapter);
+	if (adapter->ecdev)
+		igb_ptp_ec_enable(adapter);
 
 	dev_info(&pdev->dev, "Intel(R) Gigabit Ethernet Network Connection\n");
 	/* print bus type/speed/width info, not applicable to i354 */
@@ -2871,6 +3028,7 @@ static void igb_remove(struct pci_dev *pdev)
 	struct e1000_hw *hw = &adapter->hw;
 
 	if (adapter->ecdev) {
+		cancel_delayed_work_sync(&adapter->ec_link_task);
 		ecdev_close(adapter->ecdev);
 		ecdev_withdraw(adapter->ecdev);
 	}
@@ -3382,7 +3540,10 @@ void igb_configure_tx_ring(struct igb_adapter *adapter,
 
 	txdctl |= IGB_TX_PTHRESH;
 	txdctl |= IGB_TX_HTHRESH << 8;
-	txdctl |= IGB_TX_WTHRESH << 16;
+	if (adapter->ecdev)
+		txdctl |= IGB_EC_WTHRESH << 16;
+	else
+		txdctl |= IGB_TX_WTHRESH << 16;
 
 	txdctl |= E1000_TXDCTL_QUEUE_ENABLE;
 	wr32(E1000_TXDCTL(reg_idx), txdctl);
@@ -3754,9 +3915,15 @@ void igb_configure_rx_ring(struct igb_adapter *adapter,
 	/* set filtering for VMDQ pools */
 	igb_set_vmolr(adapter, reg_idx & 0x7, true);
 
-	rxdctl |= IGB_RX_PTHRESH;
-	rxdctl |= IGB_RX_HTHRESH << 8;
-	rxdctl |= IGB_RX_WTHRESH << 16;
+	if (adapter->ecdev) {
+		rxdctl |= IGB_EC_RX_PTHRESH;
+		rxdctl |= IGB_EC_RX_HTHRESH << 8;
+		rxdctl |= IGB_EC_WTHRESH << 16;
+	} else {
+		rxdctl |= IGB_RX_PTHRESH;
+		rxdctl |= IGB_RX_HTHRESH << 8;
+		rxdctl |= IGB_RX_WTHRESH << 16;
+	}
 
 	/* enable receive descriptor fetching */
 	rxdctl |= E1000_RXDCTL_QUEUE_ENABLE;
@@ -5134,6 +5301,15 @@ netdev_tx_t igb_xmit_frame_ring(struct sk_buff *skb,
 	first->bytecount = skb->len;
 	first->gso_segs = 1;
 
+	if (adapter->ecdev &&
+	    adapter->tstamp_config.tx_type == HWTSTAMP_TX_ON &&
+	    !test_and_set_bit_lock(__IGB_PTP_TX_IN_PROGRESS,
+				   &adapter->state)) {
+		/* the master owns the skb, so no reference is taken */
+		tx_flags |= IGB_TX_FLAGS_TSTAMP;
+		adapter->ptp_tx_skb = skb;
+	}
+
 	if (unlikely(!adapter->ecdev &&
 				(skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP))) {
 
@@ -6451,6 +6627,29 @@ static int igb_poll(struct napi_struct *napi, int budget)
 	return 0;
 }
 
+/**
+ *  igb_ec_tx_hwtstamp - pass a transmit time stamp to the EtherCAT master
+ *  @adapter: board private structure
+ *
+ *  Reads the time stamp latched for adapter->ptp_tx_skb, which has just
+ *  been transmitted, and releases the time stamp register.
+ **/
+static void igb_ec_tx_hwtstamp(struct igb_adapter *adapter)
+{
+	struct e1000_hw *hw = &adapter->hw;
+	u64 regval;
+
+	if (rd32(E1000_TSYNCTXCTL) & E1000_TSYNCTXCTL_VALID) {
+		regval = rd32(E1000_TXSTMPL);
+		regval |= (u64)rd32(E1000_TXSTMPH) << 32;
+		ecdev_tx_stamped(adapter->ecdev, adapter->ptp_tx_skb,
+				 igb_ptp_ec_systim(adapter, regval));
+	}
+
+	adapter->ptp_tx_skb = NULL;
+	clear_bit_unlock(__IGB_PTP_TX_IN_PROGRESS, &adapter->state);
+}
+
 /**
  *  igb_clean_tx_irq - Reclaim resources after transmit completes
  *  @q_vector: pointer to q_vector containing needed info
@@ -6498,6 +6697,10 @@ static bool igb_clean_tx_irq(struct igb_q_vector *q_vector)
 		if (!adapter->ecdev) {
 			/* free the skb */
 			dev_consume_skb_any(tx_buffer->skb);
+		} else {
+			if (adapter->ptp_tx_skb == tx_buffer->skb)
+				igb_ec_tx_hwtstamp(adapter);
+			ecdev_tx_complete(adapter->ecdev, tx_buffer->skb);
 		}
 
 		/* unmap skb header data */
@@ -6797,7 +7000,17 @@ static struct sk_buff *igb_fetch_rx_buffer(struct igb_ring *rx_ring,
 		unsigned char *va =
 			page_address(rx_buffer->page) + rx_buffer->page_offset;
 		unsigned int size = le16_to_cpu(rx_desc->wb.upper.length);
-		ecdev_receive(adapter->ecdev, va, size);
+		if (igb_test_staterr(rx_desc, E1000_RXDADV_STAT_TSIP)) {
+			/* SYSTIML/SYSTIMH are stored in DWORDs 2 and 3 */
+			__le64 *regval = (__le64 *)va;
+			u64 hw_time = igb_ptp_ec_systim(adapter,
+							le64_to_cpu(regval[1]));
+			ecdev_receive_stamped(adapter->ecdev,
+					      va + IGB_TS_HDR_LEN,
+					      size - IGB_TS_HDR_LEN, hw_time);
+		} else {
+			ecdev_receive(adapter->ecdev, va, size);
+		}
 		adapter->ec_watchdog_jiffies = jiffies;
 		igb_reuse_rx_page(rx_ring, rx_buffer);
 	}
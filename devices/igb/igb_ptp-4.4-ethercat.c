@@ -1005,6 +1005,44 @@ int igb_ptp_set_ts_config(struct net_device *netdev, struct ifreq *ifr)
 		-EFAULT : 0;
 }
 
+/**
+ * igb_ptp_ec_enable - enable time stamping for EtherCAT operation
+ * @adapter: Board private structure
+ *
+ * Time stamps all sent and received frames, if the hardware supports it,
+ * so that they can be passed to the EtherCAT master.
+ **/
+void igb_ptp_ec_enable(struct igb_adapter *adapter)
+{
+	struct hwtstamp_config config;
+
+	if (!(adapter->flags & IGB_FLAG_PTP))
+		return;
+
+	config.flags = 0;
+	config.tx_type = HWTSTAMP_TX_ON;
+	config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+	if (!igb_ptp_set_timestamp_mode(adapter, &config))
+		memcpy(&adapter->tstamp_config, &config,
+		       sizeof(adapter->tstamp_config));
+}
+
+/**
+ * igb_ptp_ec_systim - convert a raw time stamp for the EtherCAT master
+ * @adapter: Board private structure
+ * @systim: SYSTIM value latched by the hardware
+ *
+ * Returns the time stamp in nanoseconds.
+ **/
+u64 igb_ptp_ec_systim(struct igb_adapter *adapter, u64 systim)
+{
+	struct skb_shared_hwtstamps hwtstamps;
+
+	igb_ptp_systim_to_hwtstamp(adapter, &hwtstamps, systim);
+	return ktime_to_ns(hwtstamps.hwtstamp);
+}
+
 void igb_ptp_init(struct igb_adapter *adapter)
 {
 	struct e1000_hw *hw = &adapter->hw;
@@ -0,0 +1,1020 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/** \file
+ * EtherCAT simulated slave device module.
+ *
+ * Offers a virtual network device to the master, that answers the frames
+ * sent to it like a line of EtherCAT slaves. Each simulated slave has the
+ * register and process data memory of an EtherCAT slave controller and
+ * supports all addressing modes, the SII interface, the AL state machine,
+ * FMMUs and the distributed clocks registers. The slaves have no mailbox;
+ * their SII describes one output and one input PDO, and the outputs are
+ * looped back to the inputs.
+ *
+ * This allows to run and profile the master with a large number of slaves
+ * without any hardware.
+ */
+
+/*****************************************************************************/
+
+#include <linux/module.h>
+#include <linux/version.h>
+#include <linux/netdevice.h>
+#include <linux/etherdevice.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+
+#include "../globals.h"
+#include "../include/ecrt.h"
+#include "ecdev.h"
+
+#define PFX "ec_sim: "
+
+/** Maximum frame size.
+ */
+#define EC_SIM_FRAME_SIZE 1600
+
+/** Number of receive ring slots.
+ */
+#define EC_SIM_RX_RING_SIZE 32
+
+/** Maximum number of simulated slaves.
+ */
+#define EC_SIM_MAX_SLAVES 4096
+
+/** Size of the memory of a simulated slave (registers and process data).
+ */
+#define EC_SIM_MEM_SIZE 0x2000
+
+/** Physical address of the outputs.
+ */
+#define EC_SIM_OUTPUT_ADDR 0x1000
+
+/** Physical address of the inputs.
+ */
+#define EC_SIM_INPUT_ADDR 0x1100
+
+/** Maximum size of the outputs and of the inputs in byte.
+ */
+#define EC_SIM_MAX_DATA_SIZE 64
+
+/** Number of FMMUs of a simulated slave.
+ */
+#define EC_SIM_FMMU_COUNT 8
+
+/** Number of sync managers of a simulated slave.
+ */
+#define EC_SIM_SYNC_COUNT 8
+
+/** SII size in byte.
+ */
+#define EC_SIM_SII_SIZE 2048
+
+/** SII header size in byte (up to the first category).
+ */
+#define EC_SIM_SII_HEADER_SIZE 0x80
+
+/** Vendor ID of the simulated slaves.
+ */
+#define EC_SIM_VENDOR_ID 0x00000000
+
+/** Product code of the simulated slaves.
+ */
+#define EC_SIM_PRODUCT_CODE 0x0053494D
+
+/** Size of an EtherCAT datagram header.
+ */
+#define EC_SIM_DATAGRAM_HEADER_SIZE 10
+
+/** Size of an EtherCAT datagram footer (working counter).
+ */
+#define EC_SIM_DATAGRAM_FOOTER_SIZE 2
+
+#define ETH_P_ETHERCAT 0x88A4
+
+/*****************************************************************************/
+
+int __init ec_sim_init_module(void);
+void __exit ec_sim_cleanup_module(void);
+
+/*****************************************************************************/
+
+/** \cond */
+
+MODULE_AUTHOR("Florian Pose <fp@igh-essen.com>");
+MODULE_DESCRIPTION("EtherCAT master simulated slave device module");
+MODULE_LICENSE("GPL");
+MODULE_VERSION(EC_MASTER_VERSION);
+
+/** \endcond */
+
+/** Number of simulated slaves.
+ */
+static unsigned int ec_sim_slave_count = 100;
+
+/** Size of the outputs and of the inputs of each slave in byte.
+ */
+static unsigned int ec_sim_data_size = 4;
+
+/** Simulated propagation delay from one slave to the next in ns.
+ */
+static unsigned int ec_sim_delay = 100;
+
+/** \cond */
+
+module_param_named(slaves, ec_sim_slave_count, uint, S_IRUGO);
+MODULE_PARM_DESC(slaves, "Number of simulated slaves (default 100).");
+module_param_named(data_size, ec_sim_data_size, uint, S_IRUGO);
+MODULE_PARM_DESC(data_size, "Output and input bytes per slave"
+        " (default 4).");
+module_param_named(delay, ec_sim_delay, uint, S_IRUGO);
+MODULE_PARM_DESC(delay, "Propagation delay between slaves in ns"
+        " (default 100).");
+
+/** \endcond */
+
+/** MAC address of the simulated device.
+ */
+static const uint8_t ec_sim_mac[ETH_ALEN] = {
+    0x02, 0x45, 0x43, 0x53, 0x49, 0x4D
+};
+
+/** EtherCAT commands.
+ */
+enum {
+    EC_SIM_APRD = 0x01,
+    EC_SIM_APWR = 0x02,
+    EC_SIM_APRW = 0x03,
+    EC_SIM_FPRD = 0x04,
+    EC_SIM_FPWR = 0x05,
+    EC_SIM_FPRW = 0x06,
+    EC_SIM_BRD = 0x07,
+    EC_SIM_BWR = 0x08,
+    EC_SIM_BRW = 0x09,
+    EC_SIM_LRD = 0x0A,
+    EC_SIM_LWR = 0x0B,
+    EC_SIM_LRW = 0x0C,
+    EC_SIM_ARMW = 0x0D,
+    EC_SIM_FRMW = 0x0E
+};
+
+/** Memory access flags.
+ */
+enum {
+    EC_SIM_READ = 0x01, /**< Read into the datagram. */
+    EC_SIM_WRITE = 0x02, /**< Write from the datagram. */
+    EC_SIM_OR = 0x04 /**< Combine read data with a logical or. */
+};
+
+/** Simulated slave.
+ */
+typedef struct {
+    uint8_t mem[EC_SIM_MEM_SIZE]; /**< Registers and process data memory. */
+    uint16_t station_address; /**< Station address in \a station_map. */
+} ec_sim_slave_t;
+
+/** Receive ring slot.
+ */
+typedef struct {
+    size_t size; /**< Frame size in byte. */
+    uint8_t data[EC_SIM_FRAME_SIZE]; /**< Frame data. */
+} ec_sim_rx_slot_t;
+
+/** Simulated device.
+ */
+typedef struct {
+    struct net_device *netdev; /**< Offered net_device. */
+    ec_device_t *ecdev; /**< EtherCAT device. */
+    ec_sim_slave_t *slaves; /**< Simulated slaves. */
+    unsigned int slave_count; /**< Number of simulated slaves. */
+    uint16_t *station_map; /**< Slave index + 1 for each station address, or
+                             0. */
+    uint8_t sii[EC_SIM_SII_SIZE]; /**< SII contents of all slaves. */
+    u64 frame_time; /**< Local time the current frame is processed at. */
+    uint8_t tmp[EC_SIM_FRAME_SIZE]; /**< Buffer for read/write commands. */
+    ec_sim_rx_slot_t rx_ring[EC_SIM_RX_RING_SIZE]; /**< Frames processed by
+                                                     the slaves. */
+    unsigned int rx_head; /**< Next receive slot to fill. */
+    unsigned int rx_tail; /**< Next receive slot to pass to the master. */
+    unsigned int rx_dropped; /**< Frames dropped due to a full ring. */
+} ec_sim_t;
+
+/** The simulated device.
+ */
+static ec_sim_t *ec_sim;
+
+/*****************************************************************************/
+
+/** Returns the local time of the simulated slaves.
+ */
+static u64 ec_sim_local_time(void)
+{
+    return ktime_to_ns(ktime_get());
+}
+
+/*****************************************************************************/
+
+/** Checks, if two memory areas overlap.
+ */
+static int ec_sim_overlaps(
+        unsigned int offset, /**< Start of the first area. */
+        size_t size, /**< Size of the first area. */
+        unsigned int start, /**< Start of the second area. */
+        size_t length /**< Size of the second area. */
+        )
+{
+    return offset < start + length && start < offset + size;
+}
+
+/*****************************************************************************/
+
+/** Writes an SII category header.
+ *
+ * \return Pointer to the category data.
+ */
+static uint8_t *ec_sim_sii_category(
+        uint8_t *data, /**< Position in the SII. */
+        uint16_t type, /**< Category type. */
+        size_t size /**< Category data size in byte (even). */
+        )
+{
+    EC_WRITE_U16(data, type);
+    EC_WRITE_U16(data + 2, size / 2);
+    memset(data + 4, 0x00, size);
+    return data + 4;
+}
+
+/*****************************************************************************/
+
+/** Writes a PDO category with one PDO of 8 bit entries.
+ *
+ * \return Position behind the category.
+ */
+static uint8_t *ec_sim_sii_pdo(
+        uint8_t *data, /**< Position in the SII. */
+        uint16_t type, /**< Category type. */
+        uint16_t pdo_index, /**< PDO index. */
+        uint8_t sync_index, /**< Sync manager index. */
+        uint16_t entry_index, /**< Index of the PDO entries. */
+        unsigned int entry_count /**< Number of PDO entries. */
+        )
+{
+    unsigned int i;
+
+    data = ec_sim_sii_category(data, type, 8 + 8 * entry_count);
+    EC_WRITE_U16(data, pdo_index);
+    EC_WRITE_U8(data + 2, entry_count);
+    EC_WRITE_U8(data + 3, sync_index);
+    data += 8;
+
+    for (i = 0; i < entry_count; i++) {
+        EC_WRITE_U16(data, entry_index);
+        EC_WRITE_U8(data + 2, i + 1);
+        EC_WRITE_U8(data + 4, 0x05); // UNSIGNED8
+        EC_WRITE_U8(data + 5, 8);
+        data += 8;
+    }
+
+    return data;
+}
+
+/*****************************************************************************/
+
+/** Builds the SII contents of the simulated slaves.
+ */
+static void ec_sim_build_sii(
+        ec_sim_t *sim /**< Simulated device. */
+        )
+{
+    static const char name[] = "Simulated slave";
+    size_t len = sizeof(name) - 1, size = ALIGN(2 + len, 2);
+    uint8_t *data = sim->sii;
+
+    memset(sim->sii, 0xFF, EC_SIM_SII_SIZE);
+    memset(sim->sii, 0x00, EC_SIM_SII_HEADER_SIZE);
+
+    EC_WRITE_U32(data + 0x0008 * 2, EC_SIM_VENDOR_ID);
+    EC_WRITE_U32(data + 0x000A * 2, EC_SIM_PRODUCT_CODE);
+    EC_WRITE_U16(data + 0x003E * 2, EC_SIM_SII_SIZE * 8 / 1024 - 1);
+    EC_WRITE_U16(data + 0x003F * 2, 1); // version
+    data += EC_SIM_SII_HEADER_SIZE;
+
+    data = ec_sim_sii_category(data, 0x000A, size); // strings
+    EC_WRITE_U8(data, 1);
+    EC_WRITE_U8(data + 1, len);
+    memcpy(data + 2, name, len);
+    data += size;
+
+    data = ec_sim_sii_category(data, 0x001E, 32); // general
+    EC_WRITE_U8(data + 3, 1); // name string
+    data += 32;
+
+    data = ec_sim_sii_category(data, 0x0029, 16); // sync managers
+    EC_WRITE_U16(data, EC_SIM_OUTPUT_ADDR);
+    EC_WRITE_U16(data + 2, ec_sim_data_size);
+    EC_WRITE_U8(data + 4, 0x64); // buffered, write access, watchdog
+    EC_WRITE_U8(data + 6, 0x01); // enable
+    EC_WRITE_U8(data + 7, 0x03); // outputs
+    EC_WRITE_U16(data + 8, EC_SIM_INPUT_ADDR);
+    EC_WRITE_U16(data + 10, ec_sim_data_size);
+    EC_WRITE_U8(data + 12, 0x20); // buffered, read access
+    EC_WRITE_U8(data + 14, 0x01); // enable
+    EC_WRITE_U8(data + 15, 0x04); // inputs
+    data += 16;
+
+    data = ec_sim_sii_pdo(data, 0x0032, 0x1A00, 1, 0x6000,
+            ec_sim_data_size); // TxPDO
+    data = ec_sim_sii_pdo(data, 0x0033, 0x1600, 0, 0x7000,
+            ec_sim_data_size); // RxPDO
+
+    EC_WRITE_U16(data, 0xFFFF); // end
+}
+
+/*****************************************************************************/
+
+/** Reads an SII word.
+ */
+static uint16_t ec_sim_sii_word(
+        const ec_sim_t *sim, /**< Simulated device. */
+        uint32_t address /**< Word address. */
+        )
+{
+    if (address >= EC_SIM_SII_SIZE / 2) {
+        return 0xFFFF;
+    }
+
+    return EC_READ_U16(sim->sii + address * 2);
+}
+
+/*****************************************************************************/
+
+/** Initializes the registers of a simulated slave.
+ */
+static void ec_sim_slave_init(
+        ec_sim_t *sim, /**< Simulated device. */
+        unsigned int index /**< Slave position. */
+        )
+{
+    uint8_t *mem = sim->slaves[index].mem;
+    uint16_t dl_status;
+
+    memset(mem, 0x00, EC_SIM_MEM_SIZE);
+    sim->slaves[index].station_address = 0x0000;
+
+    EC_WRITE_U8(mem + 0x0000, 0x11); // type
+    EC_WRITE_U8(mem + 0x0004, EC_SIM_FMMU_COUNT);
+    EC_WRITE_U8(mem + 0x0005, EC_SIM_SYNC_COUNT);
+    EC_WRITE_U8(mem + 0x0006, (EC_SIM_MEM_SIZE - 0x1000) / 1024);
+    EC_WRITE_U8(mem + 0x0007, 0x0F); // ports 0 and 1 MII
+    EC_WRITE_U16(mem + 0x0008, 0x000C); // 64 bit distributed clocks
+
+    /* PDI operational, link and communication on port 0, ports 2 and 3
+     * closed. Port 1 is closed at the end of the line. */
+    dl_status = 0x0001 | 0x0010 | 0x0200 | 0x1000 | 0x4000;
+    if (index + 1 < sim->slave_count) {
+        dl_status |= 0x0020 | 0x0800;
+    } else {
+        dl_status |= 0x0400;
+    }
+    EC_WRITE_U16(mem + 0x0110, dl_status);
+
+    EC_WRITE_U8(mem + 0x0130, 0x01); // INIT
+    EC_WRITE_U8(mem + 0x0502, 0x40); // 8 byte SII reads
+}
+
+/*****************************************************************************/
+
+/** Updates registers, that change without being written, before a read.
+ */
+static void ec_sim_slave_read_hook(
+        ec_sim_t *sim, /**< Simulated device. */
+        ec_sim_slave_t *slave, /**< Simulated slave. */
+        unsigned int offset, /**< Physical address. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    if (ec_sim_overlaps(offset, size, 0x0910, 8)) {
+        // system time = local time + offset
+        EC_WRITE_U64(slave->mem + 0x0910,
+                ec_sim_local_time() + EC_READ_U64(slave->mem + 0x0920));
+    }
+}
+
+/*****************************************************************************/
+
+/** Executes the side effects of a register write.
+ */
+static void ec_sim_slave_write_hook(
+        ec_sim_t *sim, /**< Simulated device. */
+        unsigned int index, /**< Slave position. */
+        unsigned int offset, /**< Physical address. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    ec_sim_slave_t *slave = &sim->slaves[index];
+    uint8_t *mem = slave->mem;
+
+    if (ec_sim_overlaps(offset, size, 0x0010, 2)) {
+        uint16_t address = EC_READ_U16(mem + 0x0010);
+
+        if (sim->station_map[slave->station_address] == index + 1) {
+            sim->station_map[slave->station_address] = 0;
+        }
+        sim->station_map[address] = index + 1;
+        slave->station_address = address;
+    }
+
+    if (ec_sim_overlaps(offset, size, 0x0120, 1)) {
+        uint8_t state = EC_READ_U8(mem + 0x0120) & 0x0F;
+
+        if (state == 0x01 || state == 0x02 || state == 0x03
+                || state == 0x04 || state == 0x08) {
+            EC_WRITE_U8(mem + 0x0130, state);
+            EC_WRITE_U16(mem + 0x0134, 0x0000);
+        }
+    }
+
+    if (ec_sim_overlaps(offset, size, 0x0502, 2)) {
+        uint16_t address = EC_READ_U16(mem + 0x0504);
+        unsigned int i;
+
+        if ((EC_READ_U8(mem + 0x0503) & 0x07) == 0x01) { // read
+            for (i = 0; i < 4; i++) {
+                EC_WRITE_U16(mem + 0x0508 + i * 2,
+                        ec_sim_sii_word(sim, address + i));
+            }
+        }
+
+        /* Write and reload commands are acknowledged without effect. The
+         * command is executed immediately, so the interface is never busy.
+         */
+        EC_WRITE_U8(mem + 0x0502, EC_READ_U8(mem + 0x0502) | 0x40);
+        EC_WRITE_U8(mem + 0x0503, EC_READ_U8(mem + 0x0503) & ~0x07);
+    }
+
+    if (ec_sim_overlaps(offset, size, 0x0900, 4)) {
+        /* Latch the receive times. The frame passes port 0 of each slave on
+         * its way out and port 1 on its way back. */
+        u64 time = sim->frame_time + (u64) index * ec_sim_delay;
+
+        EC_WRITE_U32(mem + 0x0900, (uint32_t) time);
+        if (index + 1 < sim->slave_count) {
+            EC_WRITE_U32(mem + 0x0904, (uint32_t) (time + 2ULL
+                        * (sim->slave_count - 1 - index) * ec_sim_delay));
+        } else {
+            EC_WRITE_U32(mem + 0x0904, 0x00000000);
+        }
+        EC_WRITE_U32(mem + 0x0908, 0x00000000);
+        EC_WRITE_U32(mem + 0x090C, 0x00000000);
+        EC_WRITE_U64(mem + 0x0918, time);
+    }
+
+    if (ec_sim_overlaps(offset, size, EC_SIM_OUTPUT_ADDR, ec_sim_data_size)) {
+        // loop back the outputs
+        memcpy(mem + EC_SIM_INPUT_ADDR, mem + EC_SIM_OUTPUT_ADDR,
+                ec_sim_data_size);
+    }
+}
+
+/*****************************************************************************/
+
+/** Accesses the physical memory of a simulated slave.
+ *
+ * Memory beyond the simulated address space reads as zero.
+ *
+ * \return Working counter increment.
+ */
+static unsigned int ec_sim_slave_access(
+        ec_sim_t *sim, /**< Simulated device. */
+        unsigned int index, /**< Slave position. */
+        unsigned int offset, /**< Physical address. */
+        uint8_t *data, /**< Datagram data. */
+        size_t size, /**< Number of bytes. */
+        unsigned int flags /**< Access flags. */
+        )
+{
+    ec_sim_slave_t *slave = &sim->slaves[index];
+    size_t avail = offset < EC_SIM_MEM_SIZE ? EC_SIM_MEM_SIZE - offset : 0;
+    size_t n = min(size, avail), i;
+    unsigned int wc = 0;
+
+    if (flags & EC_SIM_WRITE) {
+        // keep the data to write, if they are replaced by the read data
+        memcpy(sim->tmp, data, n);
+    }
+
+    if (flags & EC_SIM_READ) {
+        ec_sim_slave_read_hook(sim, slave, offset, n);
+        if (flags & EC_SIM_OR) {
+            for (i = 0; i < n; i++) {
+                data[i] |= slave->mem[offset + i];
+            }
+        } else {
+            memcpy(data, slave->mem + offset, n);
+            memset(data + n, 0x00, size - n);
+        }
+        wc += 1;
+    }
+
+    if (flags & EC_SIM_WRITE) {
+        memcpy(slave->mem + offset, sim->tmp, n);
+        ec_sim_slave_write_hook(sim, index, offset, n);
+        wc += flags & EC_SIM_READ ? 2 : 1;
+    }
+
+    return wc;
+}
+
+/*****************************************************************************/
+
+/** Processes a logical datagram at a simulated slave.
+ *
+ * The FMMUs map byte-wise; bit offsets are ignored.
+ *
+ * \return Working counter increment.
+ */
+static unsigned int ec_sim_slave_logical(
+        ec_sim_t *sim, /**< Simulated device. */
+        unsigned int index, /**< Slave position. */
+        uint8_t cmd, /**< Command. */
+        uint32_t address, /**< Logical address. */
+        uint8_t *data, /**< Datagram data. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    ec_sim_slave_t *slave = &sim->slaves[index];
+    unsigned int pass, i, wc = 0;
+
+    // write first, then read
+    for (pass = 0; pass < 2; pass++) {
+        uint8_t type = pass ? 0x01 : 0x02;
+        unsigned int read = 0, written = 0;
+
+        if ((pass && cmd == EC_SIM_LWR) || (!pass && cmd == EC_SIM_LRD)) {
+            continue;
+        }
+
+        for (i = 0; i < EC_SIM_FMMU_COUNT; i++) {
+            const uint8_t *fmmu = slave->mem + 0x0600 + i * 16;
+            u64 log_start = EC_READ_U32(fmmu), start, end;
+            unsigned int phys;
+            size_t n;
+
+            if (!(EC_READ_U8(fmmu + 12) & 0x01)
+                    || !(EC_READ_U8(fmmu + 11) & type)) {
+                continue;
+            }
+
+            start = max(log_start, (u64) address);
+            end = min(log_start + EC_READ_U16(fmmu + 4), (u64) address + size);
+            if (start >= end) {
+                continue;
+            }
+
+            phys = EC_READ_U16(fmmu + 8) + (unsigned int) (start - log_start);
+            if (phys >= EC_SIM_MEM_SIZE) {
+                continue;
+            }
+            n = min((size_t) (end - start), (size_t) EC_SIM_MEM_SIZE - phys);
+
+            if (pass) {
+                ec_sim_slave_read_hook(sim, slave, phys, n);
+                memcpy(data + (start - address), slave->mem + phys, n);
+                read = 1;
+            } else {
+                memcpy(slave->mem + phys, data + (start - address), n);
+                ec_sim_slave_write_hook(sim, index, phys, n);
+                written = 1;
+            }
+        }
+
+        if (read) {
+            wc += 1;
+        }
+        if (written) {
+            wc += cmd == EC_SIM_LRW ? 2 : 1;
+        }
+    }
+
+    return wc;
+}
+
+/*****************************************************************************/
+
+/** Processes a read-multiple-write datagram.
+ *
+ * The addressed slave reads, all others write.
+ *
+ * \return Working counter increment.
+ */
+static unsigned int ec_sim_rmw(
+        ec_sim_t *sim, /**< Simulated device. */
+        unsigned int addressed, /**< Position of the reading slave. */
+        unsigned int offset, /**< Physical address. */
+        uint8_t *data, /**< Datagram data. */
+        size_t size /**< Number of bytes. */
+        )
+{
+    unsigned int i, wc = 0;
+
+    for (i = 0; i < sim->slave_count; i++) {
+        wc += ec_sim_slave_access(sim, i, offset, data, size,
+                i == addressed ? EC_SIM_READ : EC_SIM_WRITE);
+    }
+
+    return wc;
+}
+
+/*****************************************************************************/
+
+/** Processes a datagram at all simulated slaves.
+ */
+static void ec_sim_process_datagram(
+        ec_sim_t *sim, /**< Simulated device. */
+        uint8_t *datagram, /**< Datagram header. */
+        size_t size /**< Data size. */
+        )
+{
+    static const unsigned int flags[] = {
+        0, EC_SIM_READ, EC_SIM_WRITE, EC_SIM_READ | EC_SIM_WRITE
+    };
+    uint8_t cmd = EC_READ_U8(datagram);
+    uint8_t *data = datagram + EC_SIM_DATAGRAM_HEADER_SIZE;
+    uint16_t adp = EC_READ_U16(datagram + 2);
+    uint16_t ado = EC_READ_U16(datagram + 4);
+    unsigned int wc = EC_READ_U16(data + size), index, i;
+
+    switch (cmd) {
+        case EC_SIM_APRD:
+        case EC_SIM_APWR:
+        case EC_SIM_APRW:
+        case EC_SIM_ARMW:
+            // the slave, that increments the position to zero
+            index = (uint16_t) -adp;
+            if (cmd == EC_SIM_ARMW) {
+                wc += ec_sim_rmw(sim, index, ado, data, size);
+            } else if (index < sim->slave_count) {
+                wc += ec_sim_slave_access(sim, index, ado, data, size,
+                        flags[cmd - EC_SIM_APRD + 1]);
+            }
+            EC_WRITE_U16(datagram + 2, adp + sim->slave_count);
+            break;
+
+        case EC_SIM_FPRD:
+        case EC_SIM_FPWR:
+        case EC_SIM_FPRW:
+        case EC_SIM_FRMW:
+            index = sim->station_map[adp];
+            if (!index) {
+                if (cmd == EC_SIM_FRMW) {
+                    wc += ec_sim_rmw(sim, sim->slave_count, ado, data, size);
+                }
+                break;
+            }
+            index--;
+            if (cmd == EC_SIM_FRMW) {
+                wc += ec_sim_rmw(sim, index, ado, data, size);
+            } else {
+                wc += ec_sim_slave_access(sim, index, ado, data, size,
+                        flags[cmd - EC_SIM_FPRD + 1]);
+            }
+            break;
+
+        case EC_SIM_BRD:
+        case EC_SIM_BWR:
+        case EC_SIM_BRW:
+            for (i = 0; i < sim->slave_count; i++) {
+                wc += ec_sim_slave_access(sim, i, ado, data, size,
+                        flags[cmd - EC_SIM_BRD + 1] | EC_SIM_OR);
+            }
+            EC_WRITE_U16(datagram + 2, adp + sim->slave_count);
+            break;
+
+        case EC_SIM_LRD:
+        case EC_SIM_LWR:
+        case EC_SIM_LRW:
+            for (i = 0; i < sim->slave_count; i++) {
+                wc += ec_sim_slave_logical(sim, i, cmd,
+                        EC_READ_U32(datagram + 2), data, size);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    EC_WRITE_U16(data + size, wc);
+}
+
+/*****************************************************************************/
+
+/** Processes a frame at all simulated slaves.
+ *
+ * \return Non-zero, if the frame is an EtherCAT frame.
+ */
+static int ec_sim_process_frame(
+        ec_sim_t *sim, /**< Simulated device. */
+        uint8_t *frame, /**< Frame data. */
+        size_t size /**< Frame size. */
+        )
+{
+    uint8_t *cur = frame + ETH_HLEN + 2;
+    size_t left;
+    uint16_t header;
+
+    if (size < ETH_HLEN + 2
+            || ((frame[12] << 8) | frame[13]) != ETH_P_ETHERCAT) {
+        return 0;
+    }
+
+    header = EC_READ_U16(frame + ETH_HLEN);
+    if ((header >> 12) != 0x1) { // not a datagram frame
+        return 0;
+    }
+    left = min((size_t) (header & 0x07FF), size - ETH_HLEN - 2);
+
+    // the first slave marks the frame as processed
+    frame[ETH_ALEN] |= 0x02;
+
+    sim->frame_time = ec_sim_local_time();
+
+    while (left >= EC_SIM_DATAGRAM_HEADER_SIZE + EC_SIM_DATAGRAM_FOOTER_SIZE) {
+        uint16_t length = EC_READ_U16(cur + 6);
+        size_t data_size = length & 0x07FF, datagram_size =
+            EC_SIM_DATAGRAM_HEADER_SIZE + data_size
+            + EC_SIM_DATAGRAM_FOOTER_SIZE;
+
+        if (datagram_size > left) {
+            break;
+        }
+
+        ec_sim_process_datagram(sim, cur, data_size);
+
+        if (!(length & 0x8000)) { // last datagram
+            break;
+        }
+        cur += datagram_size;
+        left -= datagram_size;
+    }
+
+    return 1;
+}
+
+/*****************************************************************************/
+
+static int ec_sim_netdev_open(struct net_device *netdev)
+{
+    return 0;
+}
+
+/*****************************************************************************/
+
+static int ec_sim_netdev_stop(struct net_device *netdev)
+{
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Sends a frame to the simulated slaves.
+ *
+ * The frame is processed immediately and stored for the next poll. If the
+ * receive ring is full, the frame is lost.
+ */
+static int ec_sim_netdev_start_xmit(
+        struct sk_buff *skb,
+        struct net_device *netdev
+        )
+{
+    ec_sim_t *sim = *((ec_sim_t **) netdev_priv(netdev));
+    unsigned int head = sim->rx_head,
+                 next = (head + 1) % EC_SIM_RX_RING_SIZE;
+    ec_sim_rx_slot_t *slot = &sim->rx_ring[head];
+
+    if (skb->len > EC_SIM_FRAME_SIZE) {
+        return NETDEV_TX_OK;
+    }
+
+    if (next == sim->rx_tail) {
+        sim->rx_dropped++;
+        return NETDEV_TX_OK;
+    }
+
+    memcpy(slot->data, skb->data, skb->len);
+    if (!ec_sim_process_frame(sim, slot->data, skb->len)) {
+        return NETDEV_TX_OK;
+    }
+    slot->size = skb->len;
+    smp_wmb(); // publish the slot before advancing the head
+    sim->rx_head = next;
+
+    return NETDEV_TX_OK;
+}
+
+/*****************************************************************************/
+
+/** Passes the processed frames to the master.
+ */
+static void ec_sim_poll(
+        struct net_device *netdev
+        )
+{
+    ec_sim_t *sim = *((ec_sim_t **) netdev_priv(netdev));
+    unsigned int tail = sim->rx_tail;
+
+    while (tail != sim->rx_head) {
+        smp_rmb(); // read the slot only after the head
+        ecdev_receive(sim->ecdev, sim->rx_ring[tail].data,
+                sim->rx_ring[tail].size);
+        tail = (tail + 1) % EC_SIM_RX_RING_SIZE;
+        smp_mb(); // finish reading before releasing the slot
+        sim->rx_tail = tail;
+    }
+}
+
+/*****************************************************************************/
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 29)
+static const struct net_device_ops ec_sim_netdev_ops = {
+    .ndo_open       = ec_sim_netdev_open,
+    .ndo_stop       = ec_sim_netdev_stop,
+    .ndo_start_xmit = ec_sim_netdev_start_xmit,
+};
+#endif
+
+/*****************************************************************************/
+
+/** Frees the simulated device.
+ */
+static void ec_sim_clear(
+        ec_sim_t *sim /**< Simulated device. */
+        )
+{
+    if (sim->ecdev) {
+        ecdev_close(sim->ecdev);
+        ecdev_withdraw(sim->ecdev);
+    }
+    if (sim->netdev) {
+        free_netdev(sim->netdev);
+    }
+    if (sim->station_map) {
+        vfree(sim->station_map);
+    }
+    if (sim->slaves) {
+        vfree(sim->slaves);
+    }
+    vfree(sim);
+}
+
+/*****************************************************************************/
+
+/** Module initialization.
+ *
+ * Creates the simulated slaves and offers their device to the master.
+ *
+ * \return 0 on success, else < 0
+ */
+int __init ec_sim_init_module(void)
+{
+    ec_sim_t *sim;
+    ec_sim_t **priv;
+    char null = 0x00;
+    unsigned int i;
+    int ret;
+
+    printk(KERN_INFO PFX "EtherCAT master simulated slave device module %s\n",
+            EC_MASTER_VERSION);
+
+    if (!ec_sim_slave_count || ec_sim_slave_count > EC_SIM_MAX_SLAVES) {
+        printk(KERN_ERR PFX "Invalid number of slaves %u (1 to %u).\n",
+                ec_sim_slave_count, EC_SIM_MAX_SLAVES);
+        return -EINVAL;
+    }
+
+    if (ec_sim_data_size > EC_SIM_MAX_DATA_SIZE) {
+        printk(KERN_ERR PFX "Invalid data size %u (up to %u).\n",
+                ec_sim_data_size, EC_SIM_MAX_DATA_SIZE);
+        return -EINVAL;
+    }
+
+    sim = vzalloc(sizeof(ec_sim_t));
+    if (!sim) {
+        return -ENOMEM;
+    }
+
+    sim->slave_count = ec_sim_slave_count;
+    sim->slaves = vzalloc(sizeof(ec_sim_slave_t) * sim->slave_count);
+    sim->station_map = vzalloc(sizeof(uint16_t) * 0x10000);
+    if (!sim->slaves || !sim->station_map) {
+        ret = -ENOMEM;
+        goto out_clear;
+    }
+
+    ec_sim_build_sii(sim);
+    for (i = 0; i < sim->slave_count; i++) {
+        ec_sim_slave_init(sim, i);
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
+    sim->netdev = alloc_netdev(sizeof(ec_sim_t *), &null,
+            NET_NAME_UNKNOWN, ether_setup);
+#else
+    sim->netdev = alloc_netdev(sizeof(ec_sim_t *), &null, ether_setup);
+#endif
+    if (!sim->netdev) {
+        ret = -ENOMEM;
+        goto out_clear;
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 29)
+    sim->netdev->netdev_ops = &ec_sim_netdev_ops;
+#else
+    sim->netdev->open = ec_sim_netdev_open;
+    sim->netdev->stop = ec_sim_netdev_stop;
+    sim->netdev->hard_start_xmit = ec_sim_netdev_start_xmit;
+#endif
+    memcpy(sim->netdev->dev_addr, ec_sim_mac, ETH_ALEN);
+
+    priv = netdev_priv(sim->netdev);
+    *priv = sim;
+
+    sim->ecdev = ecdev_offer(sim->netdev, ec_sim_poll, THIS_MODULE);
+    if (!sim->ecdev) {
+        printk(KERN_ERR PFX "No master accepted the simulated device"
+                " %pM.\n", ec_sim_mac);
+        ret = -ENODEV;
+        goto out_clear;
+    }
+
+    ret = ecdev_open(sim->ecdev);
+    if (ret) {
+        ecdev_withdraw(sim->ecdev);
+        sim->ecdev = NULL;
+        goto out_clear;
+    }
+
+    ecdev_set_link(sim->ecdev, 1);
+
+    printk(KERN_INFO PFX "Simulating %u slaves with %u output and"
+            " input bytes each.\n", sim->slave_count, ec_sim_data_size);
+
+    ec_sim = sim;
+    return 0;
+
+out_clear:
+    ec_sim_clear(sim);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Module cleanup.
+ *
+ * Withdraws the simulated device from the master.
+ */
+void __exit ec_sim_cleanup_module(void)
+{
+    if (ec_sim->rx_dropped) {
+        printk(KERN_WARNING PFX "%u frames dropped.\n", ec_sim->rx_dropped);
+    }
+    ec_sim_clear(ec_sim);
+    printk(KERN_INFO PFX "Unloading.\n");
+}
+
+/*****************************************************************************/
+
+/** \cond */
+
+module_init(ec_sim_init_module);
+module_exit(ec_sim_cleanup_module);
+
+/** \endcond */
+
+/*****************************************************************************/
@@ -0,0 +1,430 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/** \file
+ * EtherCAT master benchmark module.
+ *
+ * Configures a line of simulated slaves (see devices/sim.c) in a
+ * configurable number of domains and measures the realtime interface in a
+ * tight loop: ecrt_master_receive(), ecrt_domain_process(),
+ * ecrt_domain_queue() and ecrt_master_send(). The results are reported in
+ * ns per call to the kernel log.
+ */
+
+/*****************************************************************************/
+
+#include <linux/version.h>
+#include <linux/module.h>
+#include <linux/kthread.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/err.h>
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 34)
+#include <linux/slab.h>
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 27)
+#include <linux/semaphore.h>
+#else
+#include <asm/semaphore.h>
+#endif
+
+#include "../../include/ecrt.h" // EtherCAT realtime interface
+
+/*****************************************************************************/
+
+#define PFX "ec_bench: "
+
+/** Identity of the simulated slaves.
+ */
+#define SimSlave 0x00000000, 0x0053494D
+
+/** Maximum number of domains.
+ */
+#define EC_BENCH_MAX_DOMAINS 32
+
+/** Maximum process data size per slave and direction.
+ */
+#define EC_BENCH_MAX_DATA_SIZE 64
+
+/** Maximum number of warm-up cycles to wait for the slaves.
+ */
+#define EC_BENCH_WARMUP_CYCLES 10000
+
+/*****************************************************************************/
+
+/** Benchmarked operations.
+ */
+enum {
+    EC_BENCH_RECEIVE,
+    EC_BENCH_PROCESS,
+    EC_BENCH_QUEUE,
+    EC_BENCH_SEND,
+    EC_BENCH_COUNT
+};
+
+/** Operation names.
+ */
+static const char *bench_names[EC_BENCH_COUNT] = {
+    "receive", "process", "queue", "send"
+};
+
+/** Timing results of an operation in ns.
+ */
+typedef struct {
+    u64 min;
+    u64 max;
+    u64 sum;
+} bench_result_t;
+
+/*****************************************************************************/
+
+// Module parameters
+static unsigned int master_index = 0;
+static unsigned int slave_count = 100;
+static unsigned int domain_count = 1;
+static unsigned int data_size = 4;
+static unsigned int cycles = 10000;
+
+/** \cond */
+
+module_param_named(master, master_index, uint, S_IRUGO);
+MODULE_PARM_DESC(master, "Index of the master to use (default 0).");
+module_param_named(slaves, slave_count, uint, S_IRUGO);
+MODULE_PARM_DESC(slaves, "Number of slaves to configure (default 100).");
+module_param_named(domains, domain_count, uint, S_IRUGO);
+MODULE_PARM_DESC(domains, "Number of domains (default 1).");
+module_param_named(data_size, data_size, uint, S_IRUGO);
+MODULE_PARM_DESC(data_size, "Output and input bytes per slave, must match"
+        " the simulated slaves (default 4).");
+module_param_named(cycles, cycles, uint, S_IRUGO);
+MODULE_PARM_DESC(cycles, "Number of measured cycles (default 10000).");
+
+/** \endcond */
+
+// EtherCAT
+static ec_master_t *master = NULL;
+struct semaphore master_sem;
+static ec_domain_t *domains[EC_BENCH_MAX_DOMAINS];
+
+// PDO configuration of the simulated slaves
+static ec_pdo_entry_info_t rx_entries[EC_BENCH_MAX_DATA_SIZE];
+static ec_pdo_entry_info_t tx_entries[EC_BENCH_MAX_DATA_SIZE];
+static ec_pdo_info_t pdos[] = {
+    {0x1600, 0, rx_entries},
+    {0x1A00, 0, tx_entries}
+};
+static ec_sync_info_t syncs[] = {
+    {0, EC_DIR_OUTPUT, 1, pdos + 0, EC_WD_ENABLE},
+    {1, EC_DIR_INPUT, 1, pdos + 1, EC_WD_DISABLE},
+    {0xff}
+};
+
+// Benchmark thread
+static struct task_struct *bench_thread = NULL;
+static bench_result_t results[EC_BENCH_COUNT];
+
+/*****************************************************************************/
+
+void send_callback(void *cb_data)
+{
+    ec_master_t *m = (ec_master_t *) cb_data;
+    down(&master_sem);
+    ecrt_master_send_ext(m);
+    up(&master_sem);
+}
+
+/*****************************************************************************/
+
+void receive_callback(void *cb_data)
+{
+    ec_master_t *m = (ec_master_t *) cb_data;
+    down(&master_sem);
+    ecrt_master_receive(m);
+    up(&master_sem);
+}
+
+/*****************************************************************************/
+
+/** Adds a measurement to an operation's results.
+ */
+static void bench_account(
+        unsigned int op, /**< Operation. */
+        ktime_t start, /**< Start time. */
+        ktime_t end /**< End time. */
+        )
+{
+    bench_result_t *r = &results[op];
+    u64 t = ktime_to_ns(ktime_sub(end, start));
+
+    if (t < r->min) {
+        r->min = t;
+    }
+    if (t > r->max) {
+        r->max = t;
+    }
+    r->sum += t;
+}
+
+/*****************************************************************************/
+
+/** Runs a single cycle.
+ *
+ * \return Non-zero, if all domains exchanged their complete process data.
+ */
+static int bench_cycle(
+        int measure /**< Account the operation times. */
+        )
+{
+    ktime_t t0, t1, t2, t3, t4;
+    ec_domain_state_t ds;
+    unsigned int i;
+    int complete = 1;
+
+    down(&master_sem);
+
+    t0 = ktime_get();
+    ecrt_master_receive(master);
+    t1 = ktime_get();
+    for (i = 0; i < domain_count; i++) {
+        ecrt_domain_process(domains[i]);
+    }
+    t2 = ktime_get();
+    for (i = 0; i < domain_count; i++) {
+        ecrt_domain_queue(domains[i]);
+    }
+    t3 = ktime_get();
+    ecrt_master_send(master);
+    t4 = ktime_get();
+
+    up(&master_sem);
+
+    if (measure) {
+        bench_account(EC_BENCH_RECEIVE, t0, t1);
+        bench_account(EC_BENCH_PROCESS, t1, t2);
+        bench_account(EC_BENCH_QUEUE, t2, t3);
+        bench_account(EC_BENCH_SEND, t3, t4);
+    }
+
+    for (i = 0; i < domain_count; i++) {
+        ecrt_domain_state(domains[i], &ds);
+        if (ds.wc_state != EC_WC_COMPLETE) {
+            complete = 0;
+        }
+    }
+
+    return complete;
+}
+
+/*****************************************************************************/
+
+/** Benchmark thread function.
+ */
+static int bench_thread_func(
+        void *data /**< Unused. */
+        )
+{
+    unsigned int i;
+
+    printk(KERN_INFO PFX "Waiting for the slaves...\n");
+
+    for (i = 0; i < EC_BENCH_WARMUP_CYCLES; i++) {
+        if (kthread_should_stop()) {
+            return 0;
+        }
+        if (bench_cycle(0)) {
+            break;
+        }
+        msleep(1);
+    }
+
+    if (i == EC_BENCH_WARMUP_CYCLES) {
+        printk(KERN_WARNING PFX "Process data incomplete, measuring"
+                " anyway.\n");
+    }
+
+    printk(KERN_INFO PFX "Measuring %u cycles with %u slaves"
+            " in %u domain(s)...\n", cycles, slave_count, domain_count);
+
+    for (i = 0; i < EC_BENCH_COUNT; i++) {
+        results[i].min = ~(u64) 0;
+        results[i].max = 0;
+        results[i].sum = 0;
+    }
+
+    // back-to-back cycles: the simulated slaves answer immediately
+    for (i = 0; i < cycles && !kthread_should_stop(); i++) {
+        bench_cycle(1);
+        if (!(i % 1000)) {
+            cond_resched();
+        }
+    }
+
+    if (i) {
+        unsigned int op;
+
+        for (op = 0; op < EC_BENCH_COUNT; op++) {
+            printk(KERN_INFO PFX "%-8s %6llu / %6llu / %6llu ns"
+                    " (min / avg / max)\n", bench_names[op],
+                    results[op].min, div_u64(results[op].sum, i),
+                    results[op].max);
+        }
+    }
+
+    printk(KERN_INFO PFX "Done.\n");
+
+    while (!kthread_should_stop()) {
+        set_current_state(TASK_INTERRUPTIBLE);
+        schedule();
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int __init init_bench_module(void)
+{
+    int ret = -EINVAL;
+    unsigned int i;
+
+    printk(KERN_INFO PFX "Starting...\n");
+
+    if (!domain_count || domain_count > EC_BENCH_MAX_DOMAINS) {
+        printk(KERN_ERR PFX "Invalid number of domains %u!\n",
+                domain_count);
+        goto out_return;
+    }
+
+    if (!data_size || data_size > EC_BENCH_MAX_DATA_SIZE) {
+        printk(KERN_ERR PFX "Invalid data size %u!\n", data_size);
+        goto out_return;
+    }
+
+    for (i = 0; i < data_size; i++) {
+        rx_entries[i].index = 0x7000;
+        rx_entries[i].subindex = i + 1;
+        rx_entries[i].bit_length = 8;
+        tx_entries[i].index = 0x6000;
+        tx_entries[i].subindex = i + 1;
+        tx_entries[i].bit_length = 8;
+    }
+    pdos[0].n_entries = data_size;
+    pdos[1].n_entries = data_size;
+
+    master = ecrt_request_master(master_index);
+    if (!master) {
+        ret = -EBUSY;
+        printk(KERN_ERR PFX "Requesting master %u failed.\n", master_index);
+        goto out_return;
+    }
+
+    sema_init(&master_sem, 1);
+    ecrt_master_callbacks(master, send_callback, receive_callback, master);
+
+    for (i = 0; i < domain_count; i++) {
+        if (!(domains[i] = ecrt_master_create_domain(master))) {
+            printk(KERN_ERR PFX "Domain creation failed!\n");
+            goto out_release_master;
+        }
+    }
+
+    printk(KERN_INFO PFX "Configuring %u slaves...\n", slave_count);
+
+    for (i = 0; i < slave_count; i++) {
+        ec_domain_t *domain = domains[i % domain_count];
+        ec_slave_config_t *sc;
+
+        if (!(sc = ecrt_master_slave_config(master, 0, i, SimSlave))) {
+            printk(KERN_ERR PFX "Failed to get slave configuration.\n");
+            goto out_release_master;
+        }
+
+        if (ecrt_slave_config_pdos(sc, EC_END, syncs)) {
+            printk(KERN_ERR PFX "Failed to configure PDOs.\n");
+            goto out_release_master;
+        }
+
+        if (ecrt_slave_config_reg_pdo_entry(sc, 0x7000, 1, domain, NULL) < 0
+                || ecrt_slave_config_reg_pdo_entry(
+                    sc, 0x6000, 1, domain, NULL) < 0) {
+            printk(KERN_ERR PFX "PDO entry registration failed!\n");
+            goto out_release_master;
+        }
+    }
+
+    printk(KERN_INFO PFX "Activating master...\n");
+    if (ecrt_master_activate(master)) {
+        printk(KERN_ERR PFX "Failed to activate master!\n");
+        goto out_release_master;
+    }
+
+    bench_thread = kthread_run(bench_thread_func, NULL, "ec_bench");
+    if (IS_ERR(bench_thread)) {
+        ret = PTR_ERR(bench_thread);
+        printk(KERN_ERR PFX "Failed to start benchmark thread!\n");
+        goto out_release_master;
+    }
+
+    printk(KERN_INFO PFX "Started.\n");
+    return 0;
+
+out_release_master:
+    printk(KERN_ERR PFX "Releasing master...\n");
+    ecrt_release_master(master);
+out_return:
+    printk(KERN_ERR PFX "Failed to load. Aborting.\n");
+    return ret;
+}
+
+/*****************************************************************************/
+
+void __exit cleanup_bench_module(void)
+{
+    printk(KERN_INFO PFX "Stopping...\n");
+
+    kthread_stop(bench_thread);
+
+    printk(KERN_INFO PFX "Releasing master...\n");
+    ecrt_release_master(master);
+
+    printk(KERN_INFO PFX "Unloading.\n");
+}
+
+/*****************************************************************************/
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Florian Pose <fp@igh-essen.com>");
+MODULE_DESCRIPTION("EtherCAT master benchmark");
+
+module_init(init_bench_module);
+module_exit(cleanup_bench_module);
+
+/*****************************************************************************/
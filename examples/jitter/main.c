@@ -0,0 +1,753 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2007-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+/** \file
+ * Cycle jitter benchmark.
+ *
+ * Runs a configurable process data load at a configurable cycle time and
+ * records the wake-up latency, the durations of the realtime interface calls
+ * and the DC deviation into log-linear histograms. The results are printed
+ * as a summary and can be written as CSV or JSON.
+ */
+
+/****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <getopt.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/****************************************************************************/
+
+#include "ecrt.h"
+
+/****************************************************************************/
+
+#define CLOCK_TO_USE CLOCK_MONOTONIC
+#define NSEC_PER_SEC (1000000000L)
+
+#define DIFF_NS(A, B) (((B).tv_sec - (A).tv_sec) * NSEC_PER_SEC + \
+        (B).tv_nsec - (A).tv_nsec)
+
+#define TIMESPEC2NS(T) ((uint64_t) (T).tv_sec * NSEC_PER_SEC + (T).tv_nsec)
+
+/** Default slave identity (simulated slaves, see devices/sim.c).
+ */
+#define SIM_VENDOR_ID 0x00000000
+#define SIM_PRODUCT_CODE 0x0053494D
+
+#define MAX_DOMAINS 32
+#define MAX_DATA_SIZE 64
+
+/** Stack size to pre-fault.
+ */
+#define MAX_SAFE_STACK (8 * 1024)
+
+/** Number of sub-buckets per power of two (relative resolution 1/16).
+ */
+#define HIST_SUB_BITS 4
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+
+/** Number of histogram buckets (values up to 2^40 ns).
+ */
+#define HIST_BUCKETS ((40 - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+/****************************************************************************/
+
+/** Log-linear histogram of ns values.
+ */
+typedef struct {
+    const char *name;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[HIST_BUCKETS];
+} histogram_t;
+
+/** Recorded metrics.
+ */
+enum {
+    METRIC_WAKEUP,
+    METRIC_PERIOD,
+    METRIC_RECEIVE,
+    METRIC_PROCESS,
+    METRIC_SEND,
+    METRIC_EXEC,
+    METRIC_DC,
+    METRIC_COUNT
+};
+
+typedef enum {
+    FORMAT_TEXT,
+    FORMAT_CSV,
+    FORMAT_JSON
+} format_t;
+
+/****************************************************************************/
+
+// Options
+static unsigned int master_index = 0;
+static unsigned int cycle_time_us = 1000;
+static unsigned int cycle_count = 10000;
+static unsigned int slave_count = 100;
+static unsigned int domain_count = 1;
+static unsigned int data_size = 4;
+static uint32_t vendor_id = SIM_VENDOR_ID;
+static uint32_t product_code = SIM_PRODUCT_CODE;
+static int cpu = -1;
+static int priority = -1;
+static int use_dc = 0;
+static format_t format = FORMAT_TEXT;
+static const char *output_file = NULL;
+
+// EtherCAT
+static ec_master_t *master = NULL;
+static ec_domain_t *domains[MAX_DOMAINS];
+
+static ec_pdo_entry_info_t rx_entries[MAX_DATA_SIZE];
+static ec_pdo_entry_info_t tx_entries[MAX_DATA_SIZE];
+static ec_pdo_info_t pdos[] = {
+    {0x1600, 0, rx_entries},
+    {0x1A00, 0, tx_entries}
+};
+static ec_sync_info_t syncs[] = {
+    {0, EC_DIR_OUTPUT, 1, pdos + 0, EC_WD_ENABLE},
+    {1, EC_DIR_INPUT, 1, pdos + 1, EC_WD_DISABLE},
+    {0xff}
+};
+
+static histogram_t histograms[METRIC_COUNT] = {
+    {"wakeup"},
+    {"period"},
+    {"receive"},
+    {"process"},
+    {"send"},
+    {"exec"},
+    {"dc"}
+};
+
+static volatile sig_atomic_t run = 1;
+
+/*****************************************************************************/
+
+void signal_handler(int signum)
+{
+    run = 0;
+}
+
+/*****************************************************************************/
+
+struct timespec timespec_add_ns(struct timespec time, uint32_t ns)
+{
+    time.tv_nsec += ns;
+    while (time.tv_nsec >= NSEC_PER_SEC) {
+        time.tv_nsec -= NSEC_PER_SEC;
+        time.tv_sec++;
+    }
+
+    return time;
+}
+
+/*****************************************************************************/
+
+/** Returns the histogram bucket of a value.
+ */
+static unsigned int hist_bucket(uint64_t value)
+{
+    unsigned int exp, index;
+
+    if (value < HIST_SUB_COUNT) {
+        return value;
+    }
+
+    exp = 63 - __builtin_clzll(value);
+    index = (exp - HIST_SUB_BITS + 1) * HIST_SUB_COUNT
+        + ((value >> (exp - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1));
+
+    return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
+}
+
+/*****************************************************************************/
+
+/** Returns the lowest value of a histogram bucket.
+ */
+static uint64_t hist_bucket_low(unsigned int index)
+{
+    unsigned int exp;
+
+    if (index < HIST_SUB_COUNT) {
+        return index;
+    }
+
+    exp = index / HIST_SUB_COUNT + HIST_SUB_BITS - 1;
+    return (uint64_t) (HIST_SUB_COUNT + index % HIST_SUB_COUNT)
+        << (exp - HIST_SUB_BITS);
+}
+
+/*****************************************************************************/
+
+/** Returns the highest value of a histogram bucket.
+ */
+static uint64_t hist_bucket_high(unsigned int index)
+{
+    return hist_bucket_low(index + 1) - 1;
+}
+
+/*****************************************************************************/
+
+static void hist_record(histogram_t *h, uint64_t value)
+{
+    if (!h->count || value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->count++;
+    h->sum += value;
+    h->buckets[hist_bucket(value)]++;
+}
+
+/*****************************************************************************/
+
+/** Returns the value at a percentile.
+ *
+ * The highest value of the bucket is returned, limited by the maximum.
+ */
+static uint64_t hist_percentile(const histogram_t *h, double percentile)
+{
+    uint64_t limit, sum = 0;
+    unsigned int i;
+
+    if (!h->count) {
+        return 0;
+    }
+
+    limit = (uint64_t) (percentile / 100.0 * h->count + 0.5);
+    if (!limit) {
+        limit = 1;
+    }
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        sum += h->buckets[i];
+        if (sum >= limit) {
+            uint64_t high = hist_bucket_high(i);
+            return high < h->max ? high : h->max;
+        }
+    }
+
+    return h->max;
+}
+
+/*****************************************************************************/
+
+static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+#define PERCENTILE_COUNT (sizeof(percentiles) / sizeof(percentiles[0]))
+
+/*****************************************************************************/
+
+static void print_summary(FILE *f)
+{
+    unsigned int i, j;
+
+    fprintf(f, "%-8s %10s %9s %9s", "metric", "count", "min", "mean");
+    for (j = 0; j < PERCENTILE_COUNT; j++) {
+        char str[16];
+        snprintf(str, sizeof(str), "p%g", percentiles[j]);
+        fprintf(f, " %9s", str);
+    }
+    fprintf(f, " %9s  [ns]\n", "max");
+
+    for (i = 0; i < METRIC_COUNT; i++) {
+        const histogram_t *h = &histograms[i];
+
+        if (!h->count) {
+            continue;
+        }
+
+        fprintf(f, "%-8s %10llu %9llu %9llu", h->name,
+                (unsigned long long) h->count,
+                (unsigned long long) h->min,
+                (unsigned long long) (h->sum / h->count));
+        for (j = 0; j < PERCENTILE_COUNT; j++) {
+            fprintf(f, " %9llu",
+                    (unsigned long long) hist_percentile(h, percentiles[j]));
+        }
+        fprintf(f, " %9llu\n", (unsigned long long) h->max);
+    }
+}
+
+/*****************************************************************************/
+
+static void write_csv(FILE *f)
+{
+    unsigned int i, j;
+
+    fprintf(f, "metric,low_ns,high_ns,count\n");
+
+    for (i = 0; i < METRIC_COUNT; i++) {
+        const histogram_t *h = &histograms[i];
+
+        for (j = 0; j < HIST_BUCKETS; j++) {
+            if (h->buckets[j]) {
+                fprintf(f, "%s,%llu,%llu,%llu\n", h->name,
+                        (unsigned long long) hist_bucket_low(j),
+                        (unsigned long long) hist_bucket_high(j),
+                        (unsigned long long) h->buckets[j]);
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
+
+static void write_json(FILE *f)
+{
+    unsigned int i, j;
+    int first_metric = 1;
+
+    fprintf(f, "{\n  \"config\": {\"master\": %u, \"cycle_time_us\": %u,"
+            " \"slaves\": %u, \"domains\": %u, \"data_size\": %u,"
+            " \"cpu\": %d, \"dc\": %s},\n  \"metrics\": {",
+            master_index, cycle_time_us, slave_count, domain_count,
+            data_size, cpu, use_dc ? "true" : "false");
+
+    for (i = 0; i < METRIC_COUNT; i++) {
+        const histogram_t *h = &histograms[i];
+        int first_bucket = 1;
+
+        if (!h->count) {
+            continue;
+        }
+
+        fprintf(f, "%s\n    \"%s\": {\"count\": %llu, \"min\": %llu,"
+                " \"mean\": %llu, \"max\": %llu, \"percentiles\": {",
+                first_metric ? "" : ",", h->name,
+                (unsigned long long) h->count,
+                (unsigned long long) h->min,
+                (unsigned long long) (h->sum / h->count),
+                (unsigned long long) h->max);
+        first_metric = 0;
+
+        for (j = 0; j < PERCENTILE_COUNT; j++) {
+            fprintf(f, "%s\"%g\": %llu", j ? ", " : "", percentiles[j],
+                    (unsigned long long) hist_percentile(h, percentiles[j]));
+        }
+
+        fprintf(f, "},\n      \"buckets\": [");
+        for (j = 0; j < HIST_BUCKETS; j++) {
+            if (h->buckets[j]) {
+                fprintf(f, "%s[%llu, %llu, %llu]",
+                        first_bucket ? "" : ", ",
+                        (unsigned long long) hist_bucket_low(j),
+                        (unsigned long long) hist_bucket_high(j),
+                        (unsigned long long) h->buckets[j]);
+                first_bucket = 0;
+            }
+        }
+        fprintf(f, "]}");
+    }
+
+    fprintf(f, "\n  }\n}\n");
+}
+
+/*****************************************************************************/
+
+/** Returns non-zero, if all domains exchanged their complete process data.
+ */
+static int domains_complete(void)
+{
+    ec_domain_state_t ds;
+    unsigned int i;
+
+    for (i = 0; i < domain_count; i++) {
+        ecrt_domain_state(domains[i], &ds);
+        if (ds.wc_state != EC_WC_COMPLETE) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/****************************************************************************/
+
+static void cyclic_task(void)
+{
+    struct timespec wakeupTime, startTime, lastStartTime = {},
+                    t1, t2, endTime;
+    uint32_t period_ns = cycle_time_us * 1000, dc_diff;
+    unsigned int warmup = 5 * 1000000 / cycle_time_us, i,
+                 measured = 0;
+    int measuring = 0;
+
+    clock_gettime(CLOCK_TO_USE, &wakeupTime);
+
+    while (run && (!cycle_count || measured < cycle_count)) {
+        wakeupTime = timespec_add_ns(wakeupTime, period_ns);
+        clock_nanosleep(CLOCK_TO_USE, TIMER_ABSTIME, &wakeupTime, NULL);
+
+        clock_gettime(CLOCK_TO_USE, &startTime);
+
+        if (use_dc) {
+            ecrt_master_application_time(master, TIMESPEC2NS(wakeupTime));
+        }
+
+        // receive process data
+        ecrt_master_receive(master);
+        clock_gettime(CLOCK_TO_USE, &t1);
+        for (i = 0; i < domain_count; i++) {
+            ecrt_domain_process(domains[i]);
+        }
+        clock_gettime(CLOCK_TO_USE, &t2);
+
+        if (!measuring) {
+            if (domains_complete() || !warmup) {
+                if (!warmup) {
+                    fprintf(stderr, "Process data incomplete,"
+                            " measuring anyway.\n");
+                }
+                fprintf(stderr, "Measuring...\n");
+                measuring = 1;
+            } else {
+                warmup--;
+            }
+        } else {
+            hist_record(&histograms[METRIC_WAKEUP],
+                    DIFF_NS(wakeupTime, startTime));
+            if (measured) {
+                hist_record(&histograms[METRIC_PERIOD],
+                        DIFF_NS(lastStartTime, startTime));
+            }
+            hist_record(&histograms[METRIC_RECEIVE],
+                    DIFF_NS(startTime, t1));
+            hist_record(&histograms[METRIC_PROCESS], DIFF_NS(t1, t2));
+
+            if (use_dc) {
+                dc_diff = ecrt_master_sync_monitor_process(master);
+                if (dc_diff != 0xffffffff) {
+                    hist_record(&histograms[METRIC_DC], dc_diff);
+                }
+            }
+        }
+
+        if (use_dc) {
+            ecrt_master_sync_reference_clock(master);
+            ecrt_master_sync_slave_clocks(master);
+            ecrt_master_sync_monitor_queue(master);
+        }
+
+        // send process data
+        clock_gettime(CLOCK_TO_USE, &t1);
+        for (i = 0; i < domain_count; i++) {
+            ecrt_domain_queue(domains[i]);
+        }
+        ecrt_master_send(master);
+        clock_gettime(CLOCK_TO_USE, &endTime);
+
+        if (measuring) {
+            hist_record(&histograms[METRIC_SEND], DIFF_NS(t1, endTime));
+            hist_record(&histograms[METRIC_EXEC],
+                    DIFF_NS(startTime, endTime));
+            measured++;
+        }
+
+        lastStartTime = startTime;
+    }
+}
+
+/****************************************************************************/
+
+static void stack_prefault(void)
+{
+    unsigned char dummy[MAX_SAFE_STACK];
+
+    memset(dummy, 0, MAX_SAFE_STACK);
+}
+
+/****************************************************************************/
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [OPTIONS]\n"
+            "\n"
+            "Options:\n"
+            "  --master      -m <index>  Master index (default 0).\n"
+            "  --cycle-time  -t <us>     Cycle time in us (default 1000).\n"
+            "  --cycles      -n <count>  Measured cycles, 0 runs until\n"
+            "                            interrupted (default 10000).\n"
+            "  --slaves      -s <count>  Slaves to configure (default"
+            " 100).\n"
+            "  --domains     -d <count>  Number of domains (default 1).\n"
+            "  --data-size   -z <bytes>  Output and input bytes per slave\n"
+            "                            (default 4).\n"
+            "  --identity    -i <v:p>    Vendor ID and product code of\n"
+            "                            the slaves (default: simulated).\n"
+            "  --cpu         -c <cpu>    Pin to a CPU.\n"
+            "  --priority    -p <prio>   SCHED_FIFO priority (default"
+            " max).\n"
+            "  --dc          -D          Use distributed clocks.\n"
+            "  --format      -f <fmt>    Output format for the output file:\n"
+            "                            text, csv or json (default"
+            " text).\n"
+            "  --output-file -o <file>   Write results to a file.\n"
+            "  --help        -h          Show this help.\n",
+            name);
+}
+
+/****************************************************************************/
+
+static void get_options(int argc, char **argv)
+{
+    int c;
+    char *rem;
+
+    static struct option longOptions[] = {
+        //name,         has_arg,           flag, val
+        {"master",      required_argument, NULL, 'm'},
+        {"cycle-time",  required_argument, NULL, 't'},
+        {"cycles",      required_argument, NULL, 'n'},
+        {"slaves",      required_argument, NULL, 's'},
+        {"domains",     required_argument, NULL, 'd'},
+        {"data-size",   required_argument, NULL, 'z'},
+        {"identity",    required_argument, NULL, 'i'},
+        {"cpu",         required_argument, NULL, 'c'},
+        {"priority",    required_argument, NULL, 'p'},
+        {"dc",          no_argument,       NULL, 'D'},
+        {"format",      required_argument, NULL, 'f'},
+        {"output-file", required_argument, NULL, 'o'},
+        {"help",        no_argument,       NULL, 'h'},
+        {}
+    };
+
+    while ((c = getopt_long(argc, argv, "m:t:n:s:d:z:i:c:p:Df:o:h",
+                    longOptions, NULL)) != -1) {
+        switch (c) {
+            case 'm':
+                master_index = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                cycle_time_us = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                cycle_count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                slave_count = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                domain_count = strtoul(optarg, NULL, 0);
+                break;
+            case 'z':
+                data_size = strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                vendor_id = strtoul(optarg, &rem, 0);
+                if (*rem != ':') {
+                    fprintf(stderr, "Invalid identity %s!\n", optarg);
+                    exit(1);
+                }
+                product_code = strtoul(rem + 1, NULL, 0);
+                break;
+            case 'c':
+                cpu = strtol(optarg, NULL, 0);
+                break;
+            case 'p':
+                priority = strtol(optarg, NULL, 0);
+                break;
+            case 'D':
+                use_dc = 1;
+                break;
+            case 'f':
+                if (!strcmp(optarg, "text")) {
+                    format = FORMAT_TEXT;
+                } else if (!strcmp(optarg, "csv")) {
+                    format = FORMAT_CSV;
+                } else if (!strcmp(optarg, "json")) {
+                    format = FORMAT_JSON;
+                } else {
+                    fprintf(stderr, "Invalid format %s!\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (!cycle_time_us || !domain_count || domain_count > MAX_DOMAINS
+            || !data_size || data_size > MAX_DATA_SIZE) {
+        fprintf(stderr, "Invalid parameters!\n");
+        exit(1);
+    }
+}
+
+/****************************************************************************/
+
+int main(int argc, char **argv)
+{
+    ec_slave_config_t *sc;
+    struct sched_param param = {};
+    unsigned int i;
+
+    get_options(argc, argv);
+
+    for (i = 0; i < data_size; i++) {
+        rx_entries[i].index = 0x7000;
+        rx_entries[i].subindex = i + 1;
+        rx_entries[i].bit_length = 8;
+        tx_entries[i].index = 0x6000;
+        tx_entries[i].subindex = i + 1;
+        tx_entries[i].bit_length = 8;
+    }
+    pdos[0].n_entries = data_size;
+    pdos[1].n_entries = data_size;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+        perror("mlockall failed");
+        return -1;
+    }
+
+    master = ecrt_request_master(master_index);
+    if (!master) {
+        return -1;
+    }
+
+    for (i = 0; i < domain_count; i++) {
+        if (!(domains[i] = ecrt_master_create_domain(master))) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < slave_count; i++) {
+        if (!(sc = ecrt_master_slave_config(master, 0, i,
+                        vendor_id, product_code))) {
+            fprintf(stderr, "Failed to get slave configuration.\n");
+            return -1;
+        }
+
+        if (ecrt_slave_config_pdos(sc, EC_END, syncs)) {
+            fprintf(stderr, "Failed to configure PDOs.\n");
+            return -1;
+        }
+
+        if (ecrt_slave_config_reg_pdo_entry(sc, 0x7000, 1,
+                    domains[i % domain_count], NULL) < 0
+                || ecrt_slave_config_reg_pdo_entry(sc, 0x6000, 1,
+                    domains[i % domain_count], NULL) < 0) {
+            fprintf(stderr, "Failed to register PDO entries.\n");
+            return -1;
+        }
+
+        if (use_dc) {
+            ecrt_slave_config_dc(sc, 0x0300, cycle_time_us * 1000,
+                    cycle_time_us * 500, 0, 0);
+        }
+    }
+
+    printf("Activating master...\n");
+    if (ecrt_master_activate(master)) {
+        return -1;
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+            perror("sched_setaffinity failed");
+        }
+    }
+
+    param.sched_priority = priority >= 0 ?
+        priority : sched_get_priority_max(SCHED_FIFO);
+    printf("Using priority %i.\n", param.sched_priority);
+    if (sched_setscheduler(0, SCHED_FIFO, &param) == -1) {
+        perror("sched_setscheduler failed");
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    stack_prefault();
+
+    printf("Running %u slaves in %u domain(s) at %u us.\n",
+            slave_count, domain_count, cycle_time_us);
+    cyclic_task();
+
+    ecrt_release_master(master);
+
+    print_summary(stdout);
+
+    if (output_file) {
+        FILE *f = fopen(output_file, "w");
+
+        if (!f) {
+            fprintf(stderr, "Failed to open %s: %s\n",
+                    output_file, strerror(errno));
+            return -1;
+        }
+
+        switch (format) {
+            case FORMAT_TEXT:
+                print_summary(f);
+                break;
+            case FORMAT_CSV:
+                write_csv(f);
+                break;
+            case FORMAT_JSON:
+                write_json(f);
+                break;
+        }
+
+        fclose(f);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
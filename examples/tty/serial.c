@@ -63,6 +63,9 @@ typedef enum {
 
 #define EL6002_PORT_NAME_SIZE 16
 
+/** Number of data bytes per direction in the PDO image of a port. */
+#define EL60XX_DATA_SIZE 22
+
 typedef struct {
     ec_tty_t *tty;
     char name[EL6002_PORT_NAME_SIZE];
@@ -398,8 +401,8 @@ int el60xx_port_init(el60xx_port_t *port, ec_slave_config_t *sc,
         goto out_return;
     }
 
-    port->max_tx_data_size = 22;
-    port->max_rx_data_size = 22;
+    port->max_tx_data_size = EL60XX_DATA_SIZE;
+    port->max_rx_data_size = EL60XX_DATA_SIZE;
     port->tx_data = NULL;
     port->tx_data_size = 0;
     port->state = SER_REQUEST_INIT;
@@ -551,8 +554,8 @@ void el60xx_port_run(el60xx_port_t *port, u8 *pd)
 
             tx_accepted_toggle = status & 0x0001;
             if (tx_accepted_toggle != port->tx_accepted_toggle) { // ready
-                port->tx_data_size =
-                    ectty_tx_data(port->tty, port->tx_data, port->max_tx_data_size);
+                port->tx_data_size = ectty_tx_data(port->tty,
+                        port->tx_data, port->max_tx_data_size);
                 if (port->tx_data_size) {
 #if DEBUG
                     printk(KERN_INFO PFX "%s: Sending %u bytes.\n",
@@ -567,14 +570,21 @@ void el60xx_port_run(el60xx_port_t *port, u8 *pd)
 
             rx_request_toggle = status & 0x0002;
             if (rx_request_toggle != port->rx_request_toggle) {
-                uint8_t rx_data_size = status >> 8;
-                port->rx_request_toggle = rx_request_toggle;
+                uint8_t rx_data_size = min((size_t) (status >> 8),
+                        port->max_rx_data_size);
+
+                /* Leave the data unacknowledged, if the ring buffer is
+                 * full. The terminal keeps them and applies its own flow
+                 * control. */
+                if (ectty_rx_space(port->tty) >= rx_data_size) {
+                    port->rx_request_toggle = rx_request_toggle;
 #if DEBUG
-                printk(KERN_INFO PFX "%s: Received %u bytes.\n",
-                        port->name, rx_data_size);
+                    printk(KERN_INFO PFX "%s: Received %u bytes.\n",
+                            port->name, rx_data_size);
 #endif
-                ectty_rx_data(port->tty, rx_data, rx_data_size);
-                port->rx_accepted_toggle = !port->rx_accepted_toggle;
+                    ectty_rx_data(port->tty, rx_data, rx_data_size);
+                    port->rx_accepted_toggle = !port->rx_accepted_toggle;
+                }
             }
 
             port->control =
@@ -661,6 +671,8 @@ void el60xx_port_run(el60xx_port_t *port, u8 *pd)
 
     EC_WRITE_U16(pd + port->off_ctrl, port->control);
     memcpy(pd + port->off_tx, port->tx_data, port->tx_data_size);
+
+    ectty_poll(port->tty);
 }
 
 /****************************************************************************/
@@ -39,6 +39,148 @@
  * request a master, to map process data, to communicate with slaves via CoE
  * and to configure and activate the bus.
  *
+ * Changes since version 1.5.2:
+ *
+ * - Added ecrt_domain_zero_copy() to let a domain's process data live in a
+ *   pinned transmit frame, and the feature flag EC_HAVE_ZERO_COPY.
+ * - Added ecrt_domain_set_timeout() to set the reception timeout of a
+ *   domain's datagrams, and the feature flag EC_HAVE_DOMAIN_TIMEOUT.
+ * - Added ecrt_master_cycle() and ec_master_cycle_t to let userspace
+ *   applications do the cyclic master and domain calls with a single
+ *   system call, and the feature flag EC_HAVE_CYCLE.
+ * - Added ecrt_master_set_map_flags() and the EC_MAP_* flags to pre-fault,
+ *   lock and physically contiguously allocate the process data memory of
+ *   userspace applications, and the feature flag EC_HAVE_MAP_FLAGS.
+ * - Added ecrt_master_receive_wait() to busy-poll for the cyclic datagrams
+ *   until a deadline, and the feature flag EC_HAVE_RECEIVE_WAIT.
+ * - Added ecrt_master_set_timed_cycle() to let the master's operation
+ *   thread run the bus cycle at the send interval, ecrt_master_cycle_counter()
+ *   to follow it from userspace, and the feature flag EC_HAVE_TIMED_CYCLE.
+ * - Added ecrt_master_set_traffic_class() and ec_traffic_class_t to set the
+ *   transmit priority and per-cycle byte budget of the datagram classes,
+ *   and the feature flag EC_HAVE_TRAFFIC_CLASS.
+ * - Added ecrt_domain_overlap() to let the inputs and outputs of a domain
+ *   share logical bytes, and the feature flag EC_HAVE_DOMAIN_OVERLAP.
+ * - Added ecrt_domain_double_buffer() to decouple the process data of a
+ *   domain from the datagrams in flight, and the feature flag
+ *   EC_HAVE_DOUBLE_BUFFER.
+ * - Added ecrt_domain_set_pipeline_depth() to keep several process data
+ *   sets of a domain in flight, and the feature flag EC_HAVE_PIPELINE.
+ * - Added ecrt_domain_set_cycle_divisor() to let ecrt_master_send() queue a
+ *   domain automatically every n-th cycle, and the feature flag
+ *   EC_HAVE_CYCLE_DIVISOR.
+ * - Added ecrt_domain_set_alignment() to align the process data blocks of
+ *   the slave configurations in a domain, and the feature flag
+ *   EC_HAVE_DOMAIN_ALIGNMENT.
+ * - Added ecrt_domain_add_route() to let ecrt_domain_process() copy process
+ *   data between slaves without the application, and the feature flag
+ *   EC_HAVE_DOMAIN_ROUTE.
+ * - Added ecrt_domain_changed_inputs() to get a bitmap of the input bytes
+ *   that changed since the previous call, and the feature flag
+ *   EC_HAVE_CHANGED_INPUTS.
+ * - Added ecrt_domain_notify() to wait for the completion of a domain with
+ *   poll() on the master file descriptor, and the feature flag
+ *   EC_HAVE_DOMAIN_NOTIFY.
+ * - Added ecrt_master_sdo_upload_complete() and
+ *   ecrt_sdo_request_index_complete() to upload SDOs via complete access,
+ *   and the feature flag EC_HAVE_SDO_UPLOAD_COMPLETE.
+ * - Added ecrt_master_sdo_requests_submit() to start several SDO request
+ *   operations at once, and the feature flag EC_HAVE_SDO_REQUEST_SUBMIT. The
+ *   SDO requests of a slave configuration are now processed by the slave
+ *   state machines, so that requests of different slaves are processed in
+ *   parallel and queued requests of a slave are processed back to back.
+ * - Added completion notifications for SDO requests, register requests and
+ *   VoE handlers: ecrt_sdo_request_callback(), ecrt_reg_request_callback()
+ *   and ecrt_voe_handler_callback() in kernel space,
+ *   ecrt_sdo_request_eventfd(), ecrt_reg_request_eventfd() and
+ *   ecrt_voe_handler_eventfd() in userspace, and the feature flag
+ *   EC_HAVE_REQUEST_NOTIFY.
+ * - Added ecrt_sdo_request_external_memory() to let SDO requests use memory
+ *   provided by the application, and the feature flag
+ *   EC_HAVE_SDO_REQUEST_EXTERNAL_MEMORY. The blocking SDO transfer methods
+ *   of the master no longer copy the data through an intermediate buffer.
+ * - In userspace, the VoE handler data are placed in the memory mapped by
+ *   ecrt_master_activate(), so that ecrt_voe_handler_data() gives direct
+ *   access without copying, and the feature flag EC_HAVE_VOE_MAPPED_DATA.
+ * - Added ecrt_master_read_idns() and ecrt_master_write_idns() to transfer
+ *   lists of IDNs in one go, the type ec_soe_idn_transfer_t and the feature
+ *   flag EC_HAVE_SOE_IDN_TRANSFERS.
+ * - Added the traffic class EC_TC_DIAGNOSIS for the error counter monitor
+ *   of the master.
+ * - Added a DC servo to the master, that lets the application follow the
+ *   reference clock via ecrt_master_dc_cycle_correction() and
+ *   ecrt_master_dc_time(), and the feature flag EC_HAVE_DC_SERVO.
+ * - Added ecrt_master_select_dc_domain() to send the DC datagrams in front of
+ *   the datagrams of a domain, and the feature flag EC_HAVE_DC_DOMAIN.
+ * - Added ecrt_master_next_send_time() to schedule the sending of the
+ *   process data relative to the SYNC0 events, and the feature flag
+ *   EC_HAVE_NEXT_SEND_TIME.
+ * - Added ecrt_master_reference_clock_time64() and the feature flag
+ *   EC_HAVE_REF_CLOCK_TIME64. With a 64 bit reference clock, the DC sync
+ *   datagrams transfer the whole system time.
+ * - Added ecrt_slave_config_dc_latch() to map the DC latch registers into a
+ *   domain, the EC_DC_LATCH_* offsets and the feature flag EC_HAVE_DC_LATCH.
+ * - Added ecrt_domain_set_segment() to exchange a domain's process data on a
+ *   single one of several independent EtherCAT lines, and the feature flag
+ *   EC_HAVE_DOMAIN_SEGMENT.
+ * - Added ecrt_domain_reg_bit_map(), ecrt_bit_map_gather(),
+ *   ecrt_bit_map_scatter() and ecrt_bit_map_size() to copy lists of bit
+ *   entries from and to packed words, the type ec_bit_map_t and the feature
+ *   flag EC_HAVE_BIT_MAP.
+ * - Added ecrt_slave_config_reg_pdo_array() to register the samples of an
+ *   oversampling channel as a strided array, the type ec_pdo_array_t, the
+ *   userspace methods ecrt_pdo_array_read(), ecrt_pdo_array_write() and
+ *   ecrt_pdo_array_timestamps() and the feature flag EC_HAVE_PDO_ARRAY.
+ * - Added ecrt_master_slave_config_states() to read the states of all slave
+ *   configurations at once, and the feature flag EC_HAVE_CONFIG_STATES. In
+ *   userspace, the states are read from the memory mapped by
+ *   ecrt_master_activate() without a system call.
+ * - Added ecrt_master_reserve_shared() to let several userspace
+ *   applications with separate slave configurations, domains and cycles
+ *   share a master, and the feature flag EC_HAVE_SHARED_MASTER.
+ * - Added ecrt_domain_process_callback() to run in-kernel process data logic
+ *   at the end of ecrt_domain_process(), and the feature flag
+ *   EC_HAVE_DOMAIN_PROCESS_CALLBACK.
+ * - Added ecrt_master_load_config() to create the slave configurations of a
+ *   network description file in one go, and the feature flag
+ *   EC_HAVE_LOAD_CONFIG. The 'net_export' command of the command-line tool
+ *   writes such a file for the slaves on the bus.
+ * - Added ecrt_master_emerg_pending() and ecrt_master_emerg_eventfd() to
+ *   detect CoE emergencies of all slave configurations at once in userspace,
+ *   and the feature flag EC_HAVE_EMERG_NOTIFY. ecrt_slave_config_emerg_pop()
+ *   no longer needs a system call, if the ring is empty.
+ * - Added ecrt_domain_redundancy() and ec_domain_redundancy_t to detect a
+ *   broken ring per frame and to count the failovers and the cycles with
+ *   degraded or lost process data, and the feature flag
+ *   EC_HAVE_REDUNDANCY_STATS.
+ * - Added ecrt_master_send_at() to hand the frames of a cycle to the network
+ *   device with a launch time for time-based transmission, and the feature
+ *   flag EC_HAVE_SEND_AT.
+ * - Added ecrt_domain_split_io(), ecrt_domain_queue_outputs() and
+ *   ecrt_domain_queue_inputs() to exchange the outputs early and the inputs
+ *   late with separate datagrams, and the feature flag EC_HAVE_SPLIT_IO.
+ * - Added ecrt_master_sync0_calibrate() and
+ *   ecrt_master_sync0_shift_correction() to measure the SYNC0 margins and
+ *   derive the smallest safe SYNC0 shift, and the feature flag
+ *   EC_HAVE_SYNC0_CALIBRATION.
+ * - Added ecrt_slave_config_reg_fmmu() to map arbitrary slave registers into
+ *   a domain with a spare FMMU, and the feature flag EC_HAVE_REG_FMMU.
+ * - Added the #EC_CYCLE_TRIGGERED mode flag and ecrt_master_trigger_cycle()
+ *   to let the operation thread busy-poll for cycles triggered by the
+ *   application, and the feature flag EC_HAVE_TRIGGERED_CYCLE.
+ * - EoE datagrams are exchanged by ecrt_master_send() and
+ *   ecrt_master_receive() in operation phase, so that ecrt_master_callbacks()
+ *   is optional and userspace applications get EoE as well. The feature flag
+ *   is EC_HAVE_CALLBACK_FREE_EOE.
+ * - On a working counter drop, the master reads the AL status of the
+ *   domain's slaves and reports the faulty ones with the new members
+ *   wc_fault_count and wc_fault_slaves of ec_domain_state_t. The feature
+ *   flag is EC_HAVE_WC_FAULTS.
+ * - Added ecrt_domain_history(), ecrt_domain_history_data(),
+ *   ecrt_domain_history_state() and ecrt_domain_history_freeze() to record
+ *   the process data of the last cycles in a ring for post-mortem analysis,
+ *   and the feature flag EC_HAVE_DOMAIN_HISTORY.
+ *
  * Changes in version 1.5.2:
  *
  * - Added redundancy_active flag to ec_domain_state_t.
@@ -191,6 +333,195 @@
  */
 #define EC_HAVE_SYNC_TO
 
+/** Defined if the method ecrt_domain_zero_copy() is available (kernel only).
+ */
+#define EC_HAVE_ZERO_COPY
+
+/** Defined if the method ecrt_domain_set_timeout() is available.
+ */
+#define EC_HAVE_DOMAIN_TIMEOUT
+
+/** Defined if the method ecrt_master_cycle() is available (userspace only).
+ */
+#define EC_HAVE_CYCLE
+
+/** Defined if the method ecrt_master_set_map_flags() is available (userspace
+ * only).
+ */
+#define EC_HAVE_MAP_FLAGS
+
+/** Defined if the method ecrt_domain_notify() is available (userspace only).
+ */
+#define EC_HAVE_DOMAIN_NOTIFY
+
+/** Defined if the method ecrt_master_receive_wait() is available.
+ */
+#define EC_HAVE_RECEIVE_WAIT
+
+/** Defined if the method ecrt_master_set_timed_cycle() is available.
+ */
+#define EC_HAVE_TIMED_CYCLE
+
+/** Defined if the method ecrt_master_set_traffic_class() is available.
+ */
+#define EC_HAVE_TRAFFIC_CLASS
+
+/** Defined if the method ecrt_domain_overlap() is available.
+ */
+#define EC_HAVE_DOMAIN_OVERLAP
+
+/** Defined if the method ecrt_domain_double_buffer() is available.
+ */
+#define EC_HAVE_DOUBLE_BUFFER
+
+/** Defined if the method ecrt_domain_set_pipeline_depth() is available.
+ */
+#define EC_HAVE_PIPELINE
+
+/** Defined if the method ecrt_domain_set_cycle_divisor() is available.
+ */
+#define EC_HAVE_CYCLE_DIVISOR
+
+/** Defined if the method ecrt_domain_set_alignment() is available.
+ */
+#define EC_HAVE_DOMAIN_ALIGNMENT
+
+/** Defined if the method ecrt_domain_add_route() is available.
+ */
+#define EC_HAVE_DOMAIN_ROUTE
+
+/** Defined if the method ecrt_domain_changed_inputs() is available.
+ */
+#define EC_HAVE_CHANGED_INPUTS
+
+/** Defined if the methods ecrt_master_sdo_upload_complete() and
+ * ecrt_sdo_request_index_complete() are available.
+ */
+#define EC_HAVE_SDO_UPLOAD_COMPLETE
+
+/** Defined if the method ecrt_master_sdo_requests_submit() is available.
+ */
+#define EC_HAVE_SDO_REQUEST_SUBMIT
+
+/** Defined if the request completion callbacks (kernel space) and eventfd
+ * methods (userspace) are available.
+ */
+#define EC_HAVE_REQUEST_NOTIFY
+
+/** Defined if the method ecrt_sdo_request_external_memory() is available.
+ */
+#define EC_HAVE_SDO_REQUEST_EXTERNAL_MEMORY
+
+/** Defined if the VoE handler data are mapped to userspace on activation.
+ */
+#define EC_HAVE_VOE_MAPPED_DATA
+
+/** Defined if the methods ecrt_master_read_idns() and
+ * ecrt_master_write_idns() are available.
+ */
+#define EC_HAVE_SOE_IDN_TRANSFERS
+
+/** Defined if the methods ecrt_master_dc_cycle_correction() and
+ * ecrt_master_dc_time() are available.
+ */
+#define EC_HAVE_DC_SERVO
+
+/** Defined if the method ecrt_master_select_dc_domain() is available.
+ */
+#define EC_HAVE_DC_DOMAIN
+
+/** Defined if the method ecrt_master_next_send_time() is available.
+ */
+#define EC_HAVE_NEXT_SEND_TIME
+
+/** Defined if the method ecrt_master_reference_clock_time64() is available.
+ */
+#define EC_HAVE_REF_CLOCK_TIME64
+
+/** Defined if the method ecrt_slave_config_dc_latch() is available.
+ */
+#define EC_HAVE_DC_LATCH
+
+/** Defined if the method ecrt_domain_set_segment() is available.
+ */
+#define EC_HAVE_DOMAIN_SEGMENT
+
+/** Defined if the method ecrt_domain_reg_bit_map() and the ecrt_bit_map_*()
+ * methods are available.
+ */
+#define EC_HAVE_BIT_MAP
+
+/** Defined if the method ecrt_slave_config_reg_pdo_array() and the
+ * ecrt_pdo_array_*() methods are available.
+ */
+#define EC_HAVE_PDO_ARRAY
+
+/** Defined if the method ecrt_master_slave_config_states() is available.
+ */
+#define EC_HAVE_CONFIG_STATES
+
+/** Defined if the method ecrt_master_reserve_shared() is available.
+ */
+#define EC_HAVE_SHARED_MASTER
+
+/** Defined if the method ecrt_domain_process_callback() is available (kernel
+ * space only).
+ */
+#define EC_HAVE_DOMAIN_PROCESS_CALLBACK
+
+/** Defined if the method ecrt_master_load_config() is available (userspace
+ * only).
+ */
+#define EC_HAVE_LOAD_CONFIG
+
+/** Defined if the methods ecrt_master_emerg_pending() and
+ * ecrt_master_emerg_eventfd() are available (userspace only).
+ */
+#define EC_HAVE_EMERG_NOTIFY
+
+/** Defined if the method ecrt_domain_redundancy() is available.
+ */
+#define EC_HAVE_REDUNDANCY_STATS
+
+/** Defined if the method ecrt_master_send_at() is available.
+ */
+#define EC_HAVE_SEND_AT
+
+/** Defined if the methods ecrt_domain_split_io(),
+ * ecrt_domain_queue_outputs() and ecrt_domain_queue_inputs() are available.
+ */
+#define EC_HAVE_SPLIT_IO
+
+/** Defined if the methods ecrt_master_sync0_calibrate() and
+ * ecrt_master_sync0_shift_correction() are available.
+ */
+#define EC_HAVE_SYNC0_CALIBRATION
+
+/** Defined if the method ecrt_slave_config_reg_fmmu() is available.
+ */
+#define EC_HAVE_REG_FMMU
+
+/** Defined if the #EC_CYCLE_TRIGGERED flag and the method
+ * ecrt_master_trigger_cycle() are available.
+ */
+#define EC_HAVE_TRIGGERED_CYCLE
+
+/** Defined if EoE works in operation phase without the callbacks set with
+ * ecrt_master_callbacks().
+ */
+#define EC_HAVE_CALLBACK_FREE_EOE
+
+/** Defined if ec_domain_state_t reports the slaves found faulty after a
+ * working counter drop.
+ */
+#define EC_HAVE_WC_FAULTS
+
+/** Defined if the methods ecrt_domain_history(), ecrt_domain_history_data(),
+ * ecrt_domain_history_state() and ecrt_domain_history_freeze() are
+ * available.
+ */
+#define EC_HAVE_DOMAIN_HISTORY
+
 /*****************************************************************************/
 
 /** End of list marker.
@@ -212,6 +543,9 @@
 /** Maximum number of slave ports. */
 #define EC_MAX_PORTS 4
 
+/** Maximum number of faulty slaves listed in ec_domain_state_t. */
+#define EC_MAX_WC_FAULT_SLAVES 8
+
 /** Timeval to nanoseconds conversion.
  *
  * This macro converts a Unix epoch time to EtherCAT DC time.
@@ -229,6 +563,32 @@
  */
 #define EC_COE_EMERGENCY_MSG_SIZE 8
 
+/** Size of the DC latch data in the process data.
+ *
+ * The latch registers 0x09AE to 0x09CF are mapped by
+ * ecrt_slave_config_dc_latch(). Use the EC_DC_LATCH_* offsets relative to
+ * the returned process data offset to access them.
+ */
+#define EC_DC_LATCH_SIZE 34
+
+/** Offset of the Latch0 status (register 0x09AE, 8 bit). */
+#define EC_DC_LATCH0_STATUS 0
+
+/** Offset of the Latch1 status (register 0x09AF, 8 bit). */
+#define EC_DC_LATCH1_STATUS 1
+
+/** Offset of the Latch0 time at the positive edge (0x09B0, 64 bit). */
+#define EC_DC_LATCH0_POS 2
+
+/** Offset of the Latch0 time at the negative edge (0x09B8, 64 bit). */
+#define EC_DC_LATCH0_NEG 10
+
+/** Offset of the Latch1 time at the positive edge (0x09C0, 64 bit). */
+#define EC_DC_LATCH1_POS 18
+
+/** Offset of the Latch1 time at the negative edge (0x09C8, 64 bit). */
+#define EC_DC_LATCH1_NEG 26
+
 /******************************************************************************
  * Data types
  *****************************************************************************/
@@ -242,6 +602,9 @@ typedef struct ec_slave_config ec_slave_config_t; /**< \see ec_slave_config */
 struct ec_domain;
 typedef struct ec_domain ec_domain_t; /**< \see ec_domain */
 
+struct ec_bit_map;
+typedef struct ec_bit_map ec_bit_map_t; /**< \see ec_bit_map */
+
 struct ec_sdo_request;
 typedef struct ec_sdo_request ec_sdo_request_t; /**< \see ec_sdo_request. */
 
@@ -301,6 +664,87 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Flags for ec_master_cycle_t and ecrt_master_set_timed_cycle().
+ *
+ * The actions are done in the order of definition. #EC_CYCLE_TRIGGERED is
+ * not an action, but selects how master-timed cycles are started.
+ */
+enum {
+    EC_CYCLE_RECEIVE = 1 << 0, /**< ecrt_master_receive(). */
+    EC_CYCLE_PROCESS = 1 << 1, /**< ecrt_domain_process() for each domain. */
+    EC_CYCLE_APP_TIME = 1 << 2, /**< ecrt_master_application_time(). */
+    EC_CYCLE_SYNC_REF = 1 << 3, /**< ecrt_master_sync_reference_clock(). */
+    EC_CYCLE_SYNC_REF_TO = 1 << 4, /**< ecrt_master_sync_reference_clock_to()
+                                     with the application time. */
+    EC_CYCLE_SYNC_SLAVES = 1 << 5, /**< ecrt_master_sync_slave_clocks(). */
+    EC_CYCLE_SYNC_MON_QUEUE = 1 << 6, /**< ecrt_master_sync_monitor_queue().
+                                       */
+    EC_CYCLE_QUEUE = 1 << 7, /**< ecrt_domain_queue() for each domain
+                               without a cycle divisor. */
+    EC_CYCLE_SEND = 1 << 8, /**< ecrt_master_send(). */
+    EC_CYCLE_TRIGGERED = 1 << 9 /**< Start each master-timed cycle when the
+                                  application triggers it with
+                                  ecrt_master_trigger_cycle(), instead of at
+                                  the send interval. */
+};
+
+/** Process data memory mapping flags for ecrt_master_set_map_flags().
+ */
+enum {
+    EC_MAP_POPULATE = 1 << 0, /**< Map all pages on mmap(), so that the
+                                first access does not cause page faults. */
+    EC_MAP_LOCK = 1 << 1, /**< Lock the mapped pages with mlock(). */
+    EC_MAP_CONTIGUOUS = 1 << 2 /**< Allocate physically contiguous memory,
+                                  if available. */
+};
+
+/** Traffic class of a datagram.
+ *
+ * \see ecrt_master_set_traffic_class().
+ */
+typedef enum {
+    EC_TC_CYCLIC, /**< Process data of the domains. */
+    EC_TC_DC, /**< Distributed clocks synchronisation. */
+    EC_TC_MASTER_FSM, /**< Master state machine. */
+    EC_TC_MAILBOX, /**< Slave state machines (mailbox protocols). */
+    EC_TC_EOE, /**< Ethernet over EtherCAT. */
+    EC_TC_DIAGNOSIS, /**< Error counter monitor of the master. */
+    EC_TC_COUNT /**< Number of traffic classes. For internal use only. */
+} ec_traffic_class_t;
+
+/** IDN transfer of ecrt_master_read_idns() and ecrt_master_write_idns().
+ */
+typedef struct {
+    uint8_t drive_no; /**< Drive number. */
+    uint16_t idn; /**< SoE IDN (see ecrt_slave_config_idn()). */
+    uint8_t *data; /**< Memory for the read data, or the data to write. */
+    size_t size; /**< Size of \a data for reading, or size of the data to
+                   write. */
+    size_t result_size; /**< Output: Size of the read data. */
+    uint16_t error_code; /**< Output: SoE error code. */
+    int result; /**< Output: Zero on success, otherwise a negative error
+                  code, for example -EOVERFLOW, if the read data do not fit
+                  into \a data. */
+} ec_soe_idn_transfer_t;
+
+#ifndef __KERNEL__
+
+/** Descriptor of the cyclic calls done by ecrt_master_cycle().
+ *
+ * \see ecrt_master_cycle().
+ */
+typedef struct {
+    unsigned int flags; /**< Bitwise OR of the EC_CYCLE_* flags. */
+    uint64_t app_time; /**< Application time for #EC_CYCLE_APP_TIME and
+                         #EC_CYCLE_SYNC_REF_TO. */
+    ec_domain_t **domains; /**< Domains to process and/or queue. */
+    unsigned int domain_count; /**< Number of entries in \a domains. */
+} ec_master_cycle_t;
+
+#endif // #ifndef __KERNEL__
+
+/*****************************************************************************/
+
 /** Slave configuration state.
  *
  * This is used as an output parameter of ecrt_slave_config_state().
@@ -412,10 +856,84 @@ typedef struct {
     unsigned int working_counter; /**< Value of the last working counter. */
     ec_wc_state_t wc_state; /**< Working counter interpretation. */
     unsigned int redundancy_active; /**< Redundant link is in use. */
+    unsigned int wc_fault_count; /**< Number of slaves, that the master found
+                                   faulty after the last working counter
+                                   drop, or zero, if the working counter is
+                                   complete. */
+    uint16_t wc_fault_slaves[EC_MAX_WC_FAULT_SLAVES]; /**< Ring positions of
+                                                        the first faulty
+                                                        slaves. */
 } ec_domain_state_t;
 
 /*****************************************************************************/
 
+/** Ring redundancy statistics of a domain.
+ *
+ * In a redundant ring, each datagram returns via the device, that did not
+ * send it. A datagram returning via its own device was reflected at a break
+ * of the ring. ecrt_domain_process() checks this for every datagram, so that
+ * a break is detected in the first cycle after it occurred, independently of
+ * the working counters and of the link state reported by the device drivers.
+ *
+ * The times are taken from the monotonic clock (CLOCK_MONOTONIC) at the
+ * ecrt_domain_process() call, that detected the event. This is used for the
+ * output parameter of ecrt_domain_redundancy().
+ *
+ * \see ecrt_domain_redundancy()
+ */
+typedef struct {
+    unsigned int ring_broken; /**< A datagram of the last cycle was
+                                reflected. */
+    uint32_t failovers; /**< Number of detected breaks of the ring. */
+    uint64_t failover_time; /**< Time of the last break of the ring in ns,
+                              or zero. */
+    uint64_t restore_time; /**< Time, when the ring was closed again last,
+                             in ns, or zero. */
+    uint32_t degraded_cycles; /**< Number of cycles with a broken ring. */
+    uint32_t lost_cycles; /**< Number of cycles, in which a datagram of the
+                            domain was received via no device at all. */
+} ec_domain_redundancy_t;
+
+/*****************************************************************************/
+
+/** Freeze the process data history after the cycle, in which the working
+ * counter of the domain dropped.
+ *
+ * Flag for ecrt_domain_history().
+ */
+#define EC_HISTORY_FREEZE_ON_WC 0x01
+
+/** Record of a process data history ring.
+ *
+ * The recorded process data bytes follow the header. The records are
+ * ec_history_state_t::record_size bytes apart, and the record with the
+ * sequence number \a n is the (\a n % depth)-th one in the ring. It is
+ * valid, if its \a seq field equals \a n + 1 before and after reading it.
+ *
+ * \see ecrt_domain_history()
+ */
+typedef struct {
+    uint32_t seq; /**< Sequence number + 1, or zero while the record is
+                    written. */
+    uint32_t cycle; /**< Number of the ecrt_domain_process() call (wraps). */
+    uint64_t time; /**< Real time of the record in ns. */
+} ec_history_record_t;
+
+/** State of a process data history ring.
+ *
+ * This is used for the output parameter of ecrt_domain_history_state().
+ */
+typedef struct {
+    unsigned int depth; /**< Number of records in the ring. */
+    size_t record_size; /**< Distance of the records in byte. */
+    size_t offset; /**< Offset of the recorded bytes in the process data. */
+    size_t size; /**< Number of recorded bytes per record. */
+    uint32_t seq; /**< Number of records written. */
+    unsigned int frozen; /**< Recording is stopped. */
+} ec_history_state_t;
+
+/*****************************************************************************/
+
 /** Direction type for PDO assignment functions.
  */
 typedef enum {
@@ -513,6 +1031,22 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Process data layout of an oversampling channel.
+ *
+ * This type is filled by ecrt_slave_config_reg_pdo_array(). Sample i of a
+ * cycle is located at \a offset + i * \a stride in the domain's process
+ * data.
+ */
+typedef struct {
+    unsigned int offset; /**< Offset of the first sample in the process
+                           data. */
+    unsigned int stride; /**< Distance between two samples in bytes. */
+    unsigned int count; /**< Number of samples per cycle. */
+    unsigned int bit_length; /**< Size of a sample in bit (8, 16 or 32). */
+} ec_pdo_array_t;
+
+/*****************************************************************************/
+
 /** Request state.
  *
  * This is used as return type for ecrt_sdo_request_state() and
@@ -619,6 +1153,28 @@ int ecrt_master_reserve(
         ec_master_t *master /**< EtherCAT master */
         );
 
+/** Reserves an EtherCAT master for use together with other applications.
+ *
+ * Instead of ecrt_master_reserve(), several applications can reserve the
+ * same master with this method, as long as it is not activated. Each
+ * application creates its own slave configurations and domains and cycles
+ * them with its own send and receive calls and cycle time. The datagrams
+ * queued by all applications are sent in shared frames.
+ *
+ * The master is activated, as soon as all applications called
+ * ecrt_master_activate(). Master-timed cycles are not available and the
+ * distributed clocks methods shall be called by one application only.
+ * Slaves configured by an application, that releases the master early, keep
+ * their configuration until all applications released the master.
+ *
+ * Not available via RTDM.
+ *
+ * \return 0 in case of success, else < 0
+ */
+int ecrt_master_reserve_shared(
+        ec_master_t *master /**< EtherCAT master */
+        );
+
 #endif // #ifndef __KERNEL__
 
 #ifdef __KERNEL__
@@ -626,10 +1182,12 @@ int ecrt_master_reserve(
 /** Sets the locking callbacks.
  *
  * For concurrent master access, i. e. if other instances than the application
- * want to send and receive datagrams on the bus, the application has to
+ * want to send and receive datagrams on the bus, the application can
  * provide a callback mechanism. This method takes two function pointers as
- * its parameters. Asynchronous master access (like EoE processing) is only
- * possible if the callbacks have been set.
+ * its parameters. The callbacks are optional: Without them, the EoE
+ * datagrams are exchanged by the application's cyclic ecrt_master_receive()
+ * and ecrt_master_send() calls, see EC_HAVE_CALLBACK_FREE_EOE. With them,
+ * EoE processing does not have to wait for the next application cycle.
  *
  * The task of the send callback (\a send_cb) is to decide, if the bus is
  * currently accessible and whether or not to call the ecrt_master_send_ext()
@@ -704,6 +1262,51 @@ ec_slave_config_t *ecrt_master_slave_config(
         uint32_t product_code /**< Expected product code. */
         );
 
+#ifndef __KERNEL__
+
+/** Creates slave configurations from a network description file.
+ *
+ * The file is a text file with one keyword per line. Empty lines and lines
+ * starting with '#' are ignored, numbers can be given in decimal or with a
+ * '0x' prefix in hexadecimal:
+ *
+ * - config <alias> <position> <vendor_id> <product_code>: Obtains a slave
+ *   configuration like ecrt_master_slave_config(). The following lines
+ *   refer to it.
+ * - sync <index> input|output [default|enable|disable]: Configures a sync
+ *   manager. The following 'pdo' lines are assigned to it.
+ * - pdo <index>: Assigns a PDO. The following 'entry' lines are mapped to
+ *   it.
+ * - entry <index> <subindex> <bit_length>: Maps a PDO entry.
+ * - sdo <index> <subindex> <byte>...: Adds an SDO configuration (see
+ *   ecrt_slave_config_sdo()).
+ * - dc <assign_activate> <sync0_cycle> <sync0_shift> <sync1_cycle>
+ *   <sync1_shift>: Configures distributed clocks (see
+ *   ecrt_slave_config_dc()).
+ * - watchdog <divider> <intervals>: Configures the watchdog (see
+ *   ecrt_slave_config_watchdog()).
+ *
+ * The PDO configuration of a slave configuration is applied at once, like
+ * with ecrt_slave_config_pdos(). The 'net_export' command of the
+ * command-line tool writes a file with the PDO configuration of the slaves
+ * on the bus, which can be completed with SDO and DC settings.
+ *
+ * The application obtains the configurations afterwards with
+ * ecrt_master_slave_config() to register PDO entries, for example.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return Number of created slave configurations, or a negative error
+ *         code.
+ */
+int ecrt_master_load_config(
+        ec_master_t *master, /**< EtherCAT master */
+        const char *path /**< Path to the network description file. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 /** Selects the reference clock for distributed clocks.
  *
  * If this method is not called for a certain master, or if the slave
@@ -718,6 +1321,34 @@ int ecrt_master_select_reference_clock(
                                * reference slave (or NULL). */
         );
 
+/** Ties the distributed clocks datagrams to a domain.
+ *
+ * Whenever the datagrams of the given domain are sent by ecrt_master_send(),
+ * the datagram of ecrt_master_sync_slave_clocks() is sent in front of them,
+ * in the same frame, so that the reference clock is always sampled at the
+ * same position in the frame. A datagram of
+ * ecrt_master_sync_reference_clock() or
+ * ecrt_master_sync_reference_clock_to() waits for the domain as well.
+ *
+ * ecrt_master_sync_slave_clocks() does not have to be called any more in
+ * this mode; calls are ignored. The DC datagrams get the traffic class
+ * #EC_TC_CYCLIC. The domain should not use ecrt_domain_zero_copy(), because
+ * that domain is sent in a frame of its own.
+ *
+ * Passing NULL restores the default behaviour. The selection is cleared on
+ * ecrt_master_deactivate().
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \retval 0 Success.
+ * \retval -EBUSY The master is active.
+ */
+int ecrt_master_select_dc_domain(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_domain_t *domain /**< Domain (or NULL). */
+        );
+
 /** Obtains master information.
  *
  * No memory is allocated on the heap in
@@ -863,6 +1494,54 @@ int ecrt_master_sdo_upload(
         uint32_t *abort_code /**< Abort code of the SDO upload. */
         );
 
+/** Executes an SDO upload request to read data from a slave via complete
+ * access.
+ *
+ * All subindices of the SDO are read with a single transfer, starting with
+ * subindex zero.
+ *
+ * This request is processed by the master state machine. This method blocks,
+ * until the request has been processed and may not be called in realtime
+ * context.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_sdo_upload_complete(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        uint16_t index, /**< Index of the SDO. */
+        uint8_t *target, /**< Target buffer for the upload. */
+        size_t target_size, /**< Size of the target buffer. */
+        size_t *result_size, /**< Uploaded data size. */
+        uint32_t *abort_code /**< Abort code of the SDO upload. */
+        );
+
+/** Starts several SDO request operations at once.
+ *
+ * For every SDO request in \a requests, a read operation (\a dirs entry
+ * EC_DIR_INPUT) or a write operation (EC_DIR_OUTPUT) is scheduled, like with
+ * ecrt_sdo_request_read() or ecrt_sdo_request_write(). In userspace, this
+ * needs a single system call only. Either all or none of the operations are
+ * started.
+ *
+ * The queued requests of a slave are processed back to back in the order of
+ * their creation, requests of different slaves are processed in parallel.
+ * Their states have to be checked with ecrt_sdo_request_state().
+ *
+ * \attention This method may not be called while ecrt_sdo_request_state()
+ * returns EC_REQUEST_BUSY for one of the requests.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_sdo_requests_submit(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_sdo_request_t *const *requests, /**< SDO requests. */
+        const ec_direction_t *dirs, /**< Operation for every request. */
+        unsigned int count /**< Number of requests. */
+        );
+
 /** Executes an SoE write request.
  *
  * Starts writing an IDN and blocks until the request was processed, or an
@@ -903,6 +1582,61 @@ int ecrt_master_read_idn(
                                can be stored. */
         );
 
+/** Reads several IDNs of a slave.
+ *
+ * All IDNs are queued at once and are processed back to back in one session
+ * of the slave's state machine, which is much faster than reading them
+ * one by one with ecrt_master_read_idn(), for example for a backup of a
+ * drive's parameters. The method blocks until all transfers were processed.
+ * The results are stored in the \a transfers.
+ *
+ * \retval  0 All IDNs were read.
+ * \retval -EIO At least one of the transfers failed.
+ * \retval <0 Other error code. No IDN was read.
+ */
+int ecrt_master_read_idns(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        ec_soe_idn_transfer_t *transfers, /**< IDNs to read. */
+        unsigned int count /**< Number of \a transfers. */
+        );
+
+/** Writes several IDNs of a slave.
+ *
+ * Like ecrt_master_read_idns(), but writes the IDNs in the order of the
+ * \a transfers, for example to restore a drive's parameters.
+ *
+ * \retval  0 All IDNs were written.
+ * \retval -EIO At least one of the transfers failed.
+ * \retval <0 Other error code. No IDN was written.
+ */
+int ecrt_master_write_idns(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        ec_soe_idn_transfer_t *transfers, /**< IDNs to write. */
+        unsigned int count /**< Number of \a transfers. */
+        );
+
+#ifndef __KERNEL__
+
+/** Sets the flags for mapping the process data memory.
+ *
+ * By default, the pages of the process data memory are mapped on first
+ * access, which may happen inside the realtime loop. With #EC_MAP_POPULATE
+ * and #EC_MAP_LOCK, all pages are mapped and locked by
+ * ecrt_master_activate(). With #EC_MAP_CONTIGUOUS, the kernel allocates the
+ * memory physically contiguously, if possible, to reduce TLB pressure.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ */
+void ecrt_master_set_map_flags(
+        ec_master_t *master, /**< EtherCAT master. */
+        unsigned int flags /**< Bitwise OR of the EC_MAP_* flags. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 /** Finishes the configuration phase and prepares for cyclic operation.
  *
  * This function tells the master that the configuration phase is finished and
@@ -938,33 +1672,189 @@ void ecrt_master_deactivate(
         ec_master_t *master /**< EtherCAT master. */
         );
 
-/** Set interval between calls to ecrt_master_send().
+/** Lets the master run the bus cycle on behalf of the application.
  *
- * This information helps the master to decide, how much data can be appended
- * to a frame by the master state machine. When the master is configured with
- * --enable-hrtimers, this is used to calculate the scheduling of the master
- * thread.
+ * In master-timed mode, the master's operation thread runs the bus cycle
+ * periodically at the send interval (see ecrt_master_set_send_interval()),
+ * driven by a high-resolution timer. Each cycle does the actions selected by
+ * the EC_CYCLE_* flags for all domains, in the order of the flags. The
+ * application time for #EC_CYCLE_APP_TIME and #EC_CYCLE_SYNC_REF_TO is taken
+ * from the system's real-time clock. With #EC_CYCLE_TRIGGERED, each cycle is
+ * started by ecrt_master_trigger_cycle() instead, and no send interval is
+ * needed.
  *
- * \retval 0 on success.
- * \retval <0 Error code.
+ * The application must not call ecrt_master_send(), ecrt_master_receive(),
+ * ecrt_domain_process() and ecrt_domain_queue() itself in this mode, but
+ * only exchanges the process data. Userspace applications can follow the
+ * cycles with ecrt_master_cycle_counter().
+ *
+ * Passing zero flags disables the mode. This method has to be called in
+ * non-realtime context before ecrt_master_activate(). Deactivating the master
+ * disables the mode again.
+ *
+ * \return 0 on success, otherwise negative error code.
  */
-int ecrt_master_set_send_interval(
+int ecrt_master_set_timed_cycle(
         ec_master_t *master, /**< EtherCAT master. */
-        size_t send_interval /**< Send interval in us */
+        unsigned int flags /**< Bitwise OR of the EC_CYCLE_* flags. */
         );
 
-/** Sends all datagrams in the queue.
+#ifndef __KERNEL__
+
+/** Returns the number of bus cycles run by the master.
  *
- * This method takes all datagrams, that have been queued for transmission,
- * puts them into frames, and passes them to the Ethernet device for sending.
+ * The counter is incremented after each cycle run in master-timed mode (see
+ * ecrt_master_set_timed_cycle()), when the inputs of the cycle are available
+ * in the process data. The outputs have to be written before the next cycle
+ * starts. The counter is read from memory without a system call.
  *
- * Has to be called cyclically by the application after ecrt_master_activate()
- * has returned.
+ * \return Cycle counter, or zero, if the master is not activated.
+ */
+uint32_t ecrt_master_cycle_counter(
+        const ec_master_t *master /**< EtherCAT master. */
+        );
+
+#endif // #ifndef __KERNEL__
+
+/** Triggers the next master-timed bus cycle.
+ *
+ * In master-timed mode with the #EC_CYCLE_TRIGGERED flag, the operation
+ * thread busy-polls for this trigger instead of waiting for a timer, and
+ * runs the cycle as soon as it sees it. The outputs have to be written
+ * before. Userspace applications can wait for the cycle to finish with
+ * ecrt_master_cycle_counter(). In userspace, the trigger is written to
+ * memory without a system call, so that the application and the operation
+ * thread exchange the cycles without any system call, when both run on
+ * dedicated CPUs.
+ *
+ * The operation thread polls for at most a send interval (or a millisecond,
+ * if no send interval is set), before it runs the state machines and polls
+ * again.
+ */
+void ecrt_master_trigger_cycle(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+#ifndef __KERNEL__
+
+/** Checks, if any slave configuration has CoE emergency messages pending.
+ *
+ * The check is a single read from the memory mapped by
+ * ecrt_master_activate(), so that it can be done every cycle instead of
+ * calling ecrt_slave_config_emerg_pop() for each slave configuration. If it
+ * is positive, the messages have to be popped from the rings of the slave
+ * configurations; the rings that are empty are skipped without a system
+ * call.
+ *
+ * \return Non-zero, if messages are pending, zero, if not or if the master
+ *         is not activated.
+ */
+int ecrt_master_emerg_pending(
+        const ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Lets the master signal CoE emergencies via an eventfd.
+ *
+ * The counter of the eventfd \a fd (see eventfd(2)) is incremented for each
+ * CoE emergency message that is stored in the ring of one of the
+ * application's slave configurations (see ecrt_slave_config_emerg_size()),
+ * so that a non-realtime thread can wait for emergencies with poll(). A
+ * negative \a fd removes the eventfd.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_master_emerg_eventfd(
+        ec_master_t *master, /**< EtherCAT master. */
+        int fd /**< Eventfd file descriptor, or -1. */
+        );
+
+#endif // #ifndef __KERNEL__
+
+/** Sets the transmit priority and budget of a traffic class.
+ *
+ * When building the frames in ecrt_master_send(), the queued datagrams are
+ * taken by traffic class in the order of ascending \a priority values.
+ * Classes with the same priority are taken in the order of the
+ * ec_traffic_class_t definition. By default, the priority is the class
+ * value itself, so process data always leaves first.
+ *
+ * The \a budget limits the number of bytes (including the datagram headers)
+ * a class may send per call of ecrt_master_send() and device. Datagrams
+ * exceeding the budget stay queued for the next cycle. A budget of zero
+ * means no limit, which is the default. The process data class cannot be
+ * limited.
+ *
+ * The statistics of the traffic classes can be shown with the command-line
+ * tool. This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \retval 0 Success.
+ * \retval -EINVAL Invalid class, or a budget for #EC_TC_CYCLIC.
+ * \retval -EBUSY The master is already activated.
+ */
+int ecrt_master_set_traffic_class(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_traffic_class_t traffic_class, /**< Traffic class. */
+        unsigned int priority, /**< Priority (lower values first). */
+        size_t budget /**< Byte budget per cycle, or zero. */
+        );
+
+/** Set interval between calls to ecrt_master_send().
+ *
+ * This information helps the master to decide, how much data can be appended
+ * to a frame by the master state machine. When the master is configured with
+ * --enable-hrtimers, this is used to calculate the scheduling of the master
+ * thread.
+ *
+ * \retval 0 on success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_set_send_interval(
+        ec_master_t *master, /**< EtherCAT master. */
+        size_t send_interval /**< Send interval in us */
+        );
+
+/** Sends all datagrams in the queue.
+ *
+ * This method takes all datagrams, that have been queued for transmission,
+ * puts them into frames, and passes them to the Ethernet device for sending.
+ * The datagrams of the domains marked with ecrt_domain_queue() are appended
+ * to the queue first. Domains with a cycle divisor (see
+ * ecrt_domain_set_cycle_divisor()) are queued before, if due. Pending EoE
+ * datagrams follow within the EoE share of the cycle.
+ *
+ * Has to be called cyclically by the application after ecrt_master_activate()
+ * has returned.
  */
 void ecrt_master_send(
         ec_master_t *master /**< EtherCAT master. */
         );
 
+/** Sends all datagrams in the queue with a launch time.
+ *
+ * Does the same as ecrt_master_send(), but stamps the frames with a launch
+ * time, so that a network device supporting time-based transmission holds
+ * them back and puts them on the wire exactly at that time. This removes the
+ * jitter of the calling thread from the send time, so that the margins of
+ * the distributed clocks' SYNC0 shift can be reduced. The frames should be
+ * handed over early enough before the launch time.
+ *
+ * The launch time is evaluated by the generic Ethernet driver only (kernel
+ * 4.19 or newer), either by the ETF queueing discipline configured with
+ * CLOCK_TAI, or by the hardware (e. g. i210 LaunchTime via ETF offload). The
+ * native drivers ignore it and send immediately. If launch times are
+ * enabled on the transmit queue, every frame needs one, so
+ * ecrt_master_send() must not be used in that case.
+ *
+ * \retval 0 on success.
+ * \retval <0 Error code.
+ */
+int ecrt_master_send_at(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint64_t tx_time_ns /**< Launch time in nanoseconds, based on
+                              CLOCK_TAI. */
+        );
+
 /** Fetches received frames from the hardware and processes the datagrams.
  *
  * Queries the network device for received frames by calling the interrupt
@@ -979,6 +1869,27 @@ void ecrt_master_receive(
         ec_master_t *master /**< EtherCAT master. */
         );
 
+/** Fetches received frames until the cyclic datagrams are received.
+ *
+ * Repeats ecrt_master_receive() until all domain and distributed clocks
+ * datagrams, that were sent, are received or timed out, or until the
+ * deadline has passed. Other datagrams are not waited for.
+ *
+ * This busy-waits and is intended for applications on isolated CPUs, that
+ * want to start processing as soon as the frames have returned, instead of
+ * waiting a fixed time after ecrt_master_send().
+ *
+ * \retval 0 All cyclic datagrams were received or timed out.
+ * \retval -ETIMEDOUT The deadline has passed before.
+ * \retval <0 Other error code.
+ */
+int ecrt_master_receive_wait(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint64_t deadline_ns /**< Absolute deadline in nanoseconds, based on
+                               CLOCK_MONOTONIC (ktime_get() in kernel
+                               context). */
+        );
+
 /** Sends non-application datagrams.
  *
  * This method has to be called in the send callback function passed via
@@ -988,6 +1899,31 @@ void ecrt_master_send_ext(
         ec_master_t *master /**< EtherCAT master. */
         );
 
+#ifndef __KERNEL__
+
+/** Does the cyclic master and domain calls with a single system call.
+ *
+ * Depending on the flags in the descriptor, this receives frames, processes
+ * the given domains, sets the application time, queues the distributed
+ * clocks datagrams, queues the given domains and sends the frames, in this
+ * order. This is equivalent to the respective separate calls, but saves the
+ * system call overhead of each of them.
+ *
+ * The calls can be split, for example into one call with #EC_CYCLE_RECEIVE
+ * and #EC_CYCLE_PROCESS at the beginning of the application cycle, and one
+ * call with the remaining flags after the outputs have been calculated.
+ *
+ * At most the first 32 domains created can be used with this method.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_master_cycle(
+        ec_master_t *master, /**< EtherCAT master. */
+        const ec_master_cycle_t *cycle /**< Cycle descriptor. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 /** Reads the current master state.
  *
  * Stores the master state information in the given \a state structure.
@@ -1014,6 +1950,25 @@ int ecrt_master_link_state(
                                        */
         );
 
+/** Reads the states of several slave configurations at once.
+ *
+ * Stores the states of the first \a count slave configurations in the order
+ * of their creation with ecrt_master_slave_config(), as
+ * ecrt_slave_config_state() would for each of them. This replaces one call
+ * per configuration when checking all slaves.
+ *
+ * In userspace, the states are published in the memory mapped by
+ * ecrt_master_activate() after each ecrt_master_receive(), so that no
+ * system call is necessary for up to 1024 configurations.
+ *
+ * \return Number of states stored, or negative error code.
+ */
+int ecrt_master_slave_config_states(
+        const ec_master_t *master, /**< EtherCAT master. */
+        ec_slave_config_state_t *states, /**< Array to store the states. */
+        unsigned int count /**< Size of \a states. */
+        );
+
 /** Sets the application time.
  *
  * The master has to know the application's time when operating slaves with
@@ -1087,6 +2042,142 @@ int ecrt_master_reference_clock_time(
         uint32_t *time /**< Pointer to store the queried system time. */
         );
 
+/** Get the 64 bit reference clock system time.
+ *
+ * Works like ecrt_master_reference_clock_time(), but returns the whole
+ * system time. If the reference clock supports 64 bit system times, the
+ * datagrams of ecrt_master_sync_reference_clock() and
+ * ecrt_master_sync_slave_clocks() transfer all 64 bits. Otherwise, the
+ * upper bits are taken from the application time at the last call of
+ * ecrt_master_sync_slave_clocks(), so the application time and the
+ * reference clock must not differ by more than 2 s.
+ *
+ * \attention The returned time is the system time of the reference clock
+ * minus the transmission delay of the reference clock.
+ *
+ * \retval 0 success, system time was written into \a time.
+ * \retval -ENXIO No reference clock found.
+ * \retval -EIO Slave synchronization datagram was not received.
+ */
+int ecrt_master_reference_clock_time64(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint64_t *time /**< Pointer to store the queried system time. */
+        );
+
+/** Get the correction of the application cycle to follow the reference
+ * clock.
+ *
+ * The master runs a PI controller on the difference between the application
+ * time passed to ecrt_master_application_time() and the reference clock
+ * time returned by the datagram of ecrt_master_sync_slave_clocks(). This
+ * replaces the drift compensation in applications, that synchronize the
+ * master to the reference clock instead of using
+ * ecrt_master_sync_reference_clock().
+ *
+ * The method has to be called once per cycle after ecrt_master_receive()
+ * and before ecrt_master_sync_slave_clocks(). The application shall delay
+ * its next wake-up by the returned value and subtract it from its
+ * application time base, so that a positive correction slows down the
+ * application clock. The correction is limited to +/- 1 us per cycle.
+ *
+ * A constant offset between the application time and the reference clock,
+ * caused by the latency between ecrt_master_sync_slave_clocks() and the
+ * actual frame transmission, is not compensated.
+ *
+ * \return Correction of the next cycle in ns, or zero if there is no
+ *         reference clock or the sync datagram was not received.
+ */
+int32_t ecrt_master_dc_cycle_correction(
+        ec_master_t *master /**< EtherCAT master. */
+        );
+
+/** Get the filtered reference clock time.
+ *
+ * Returns a 64 bit estimation of the reference clock system time at the
+ * last call of ecrt_master_sync_slave_clocks(). In contrast to
+ * ecrt_master_reference_clock_time(), the jitter of the single samples is
+ * filtered over the last 16 cycles.
+ *
+ * \retval 0 Success, the time was written into \a time.
+ * \retval -ENXIO No reference clock found.
+ * \retval -EAGAIN No sync datagram was received, yet.
+ */
+int ecrt_master_dc_time(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint64_t *time /**< Pointer to store the filtered time. */
+        );
+
+/** Get the application time for the next call of ecrt_master_send().
+ *
+ * Calculates the latest time to send the process data, so that the frame
+ * passes every slave with an active SYNC0 signal at least \a margin ns
+ * before its next SYNC0 event. The calculation takes into account the
+ * transmission delays of the slaves, the transmission time of the frame
+ * with all domain datagrams and the recently measured duration of
+ * ecrt_master_send(). The returned time is later than the application time
+ * passed with the last call of ecrt_master_application_time(), in the same
+ * time base.
+ *
+ * An application can sleep until the returned time, exchange its process
+ * data and send them, instead of tuning the SYNC0 shift times by hand.
+ * The transmission delay between the master and the reference clock is not
+ * known and not included.
+ *
+ * \retval 0 Success, the time was written into \a time.
+ * \retval -ENXIO No reference clock found.
+ * \retval -EAGAIN The master is not active, no application time was set
+ *                 before activation, or no slave uses SYNC0.
+ */
+int ecrt_master_next_send_time(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint32_t margin, /**< Safety margin in ns. */
+        uint64_t *time /**< Pointer to store the send time. */
+        );
+
+/** Starts a SYNC0 calibration window.
+ *
+ * For the given number of cycles, each evaluated sync datagram (see
+ * ecrt_master_sync_slave_clocks()) records the SYNC0 margin: The time from
+ * the end of the process data frame passing a slave to the next SYNC0 event
+ * of that slave, minimum over all slave configurations with SYNC0. The
+ * margin includes the jitter of the application's send time. The histogram
+ * of the window is shown by the 'ethercat dc' command.
+ *
+ * The window starts with the next ecrt_master_send() call. A previous
+ * window is discarded. The command 'ethercat dc calibrate' calls this method
+ * for a running application.
+ *
+ * \retval 0 Success.
+ * \retval -ENXIO No reference clock found.
+ * \retval -EINVAL \a cycles is zero.
+ */
+int ecrt_master_sync0_calibrate(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint32_t cycles /**< Length of the window in cycles. */
+        );
+
+/** Returns the SYNC0 shift correction of the last calibration window.
+ *
+ * The correction is the value to add to the SYNC0 shift times, so that the
+ * smallest margin measured during the window (see
+ * ecrt_master_sync0_calibrate()) would have been \a margin. A negative
+ * correction means that the SYNC0 events can be shifted earlier, a positive
+ * one that frames arrived too close to or after the SYNC0 event.
+ *
+ * The new shift times are applied by passing them to ecrt_slave_config_dc()
+ * before the next activation of the master. The SYNC0 shift of running
+ * slaves is not changed.
+ *
+ * \retval 0 Success, the correction was written into \a correction.
+ * \retval -ENXIO No reference clock found.
+ * \retval -EAGAIN No calibration window completed yet.
+ */
+int ecrt_master_sync0_shift_correction(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint32_t margin, /**< Safety margin in ns. */
+        int32_t *correction /**< Pointer to store the correction in ns. */
+        );
+
 /** Queues the DC synchrony monitoring datagram for sending.
  *
  * The datagram broadcast-reads all "System time difference" registers (\a
@@ -1353,6 +2444,90 @@ int ecrt_slave_config_reg_pdo_entry_pos(
                                  is desired */
         );
 
+/** Registers the samples of an oversampling channel as an array.
+ *
+ * Oversampling terminals map the samples of a channel as several PDO
+ * entries with the same index and subindex, one per PDO. This method
+ * registers all occurrences of the given entry in the first sync manager
+ * that maps it and stores their layout in \a array. The samples have to
+ * byte-align, have a size of 8, 16 or 32 bit and be equidistant in the
+ * mapping; otherwise an error is returned.
+ *
+ * The samples can then be converted with ecrt_pdo_array_read() and
+ * ecrt_pdo_array_write() in userspace.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_slave_config_reg_pdo_array(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint16_t entry_index, /**< Index of the sample entries. */
+        uint8_t entry_subindex, /**< Subindex of the sample entries. */
+        ec_domain_t *domain, /**< Domain. */
+        ec_pdo_array_t *array /**< Layout of the samples. */
+        );
+
+/** Maps slave registers into a domain.
+ *
+ * A spare FMMU of the slave maps the \a size bytes of ESC registers starting
+ * at \a address into the process data of the given domain, so that they are
+ * read (#EC_DIR_INPUT) or written (#EC_DIR_OUTPUT) with every cycle, without
+ * mailbox communication and without extra datagrams. Examples are the DL
+ * status (0x0110), the error counters (0x0300) or the watchdog status
+ * (0x0440).
+ *
+ * Each mapping needs one FMMU more than the PDOs use, up to 16 FMMUs per
+ * slave configuration. Whether the slave has enough FMMUs is checked
+ * during the slave configuration. Note that reading some registers has side
+ * effects, like clearing event flags.
+ *
+ * Calling this method again with the same parameters returns the same
+ * offset.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \retval >=0 Success: Offset of the register data in the process data.
+ * \retval  <0 Error code.
+ */
+int ecrt_slave_config_reg_fmmu(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        ec_domain_t *domain, /**< Domain. */
+        uint16_t address, /**< First register address. */
+        size_t size, /**< Number of bytes to map. */
+        ec_direction_t dir /**< Read or write the registers. */
+        );
+
+/** Maps the DC latch registers into a domain.
+ *
+ * The latch status and latch time registers (0x09AE to 0x09CF) of the slave
+ * are mapped into the process data of the given domain by a spare FMMU (see
+ * ecrt_slave_config_reg_fmmu()), so that the touch probe timestamps are
+ * exchanged with every cycle, without mailbox communication and without PDO
+ * support of the slave. The layout of the #EC_DC_LATCH_SIZE bytes is given
+ * by the EC_DC_LATCH_* offsets.
+ *
+ * The slave needs DC support and one FMMU more than the PDOs use. The latch
+ * control registers (0x09A8 and 0x09A9) are not changed. Note that in
+ * single event mode, reading the latch times clears the event flags, so an
+ * event is only visible for one cycle.
+ *
+ * Calling this method again for the same domain returns the same offset.
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \retval >=0 Success: Offset of the latch data in the process data.
+ * \retval  <0 Error code.
+ */
+int ecrt_slave_config_dc_latch(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        ec_domain_t *domain /**< Domain. */
+        );
+
 /** Configure distributed clocks.
  *
  * Sets the AssignActivate word and the cycle and shift times for the sync
@@ -1663,6 +2838,231 @@ size_t ecrt_domain_size(
         const ec_domain_t *domain /**< Domain. */
         );
 
+/** Sets the reception timeout of the domain's datagrams.
+ *
+ * By default, all datagrams time out 500 us after sending. For short cycle
+ * times, the timeout of the process data datagrams can be reduced below the
+ * cycle time, so that a lost frame is detected by the ecrt_master_receive()
+ * call of the same cycle. Other datagrams keep the default timeout.
+ *
+ * A timeout of zero restores the default. The maximum is 100 ms.
+ *
+ * This method has to be called in non-realtime context, preferably before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_set_timeout(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int timeout_us /**< Timeout in microseconds. */
+        );
+
+/** Lets inputs and outputs of the domain share logical bytes.
+ *
+ * Normally, each FMMU of the domain gets logical bytes of its own. With the
+ * overlapping layout, the inputs of a slave are placed on top of outputs of
+ * the same or a preceding slave in the ring, because these outputs are
+ * already read when the inputs are written into the frame. For networks with
+ * balanced inputs and outputs, this nearly halves the size of the process
+ * data datagrams.
+ *
+ * The application's process data keep their usual, non-overlapping layout,
+ * so the offsets returned by the PDO entry registration methods stay valid.
+ * ecrt_domain_queue() copies the outputs into the logical image, and
+ * ecrt_domain_process() copies the received inputs back. The layout is
+ * computed from the slaves' ring positions when the master is activated.
+ *
+ * The mode can not be used with redundancy or with ecrt_domain_zero_copy().
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_overlap(
+        ec_domain_t *domain /**< Domain. */
+        );
+
+/** Lets the domain datagrams carry a process data image of their own.
+ *
+ * Normally, the datagrams of a domain carry the process data memory
+ * directly, so the application must not access the process data while the
+ * datagrams are in flight. In double-buffered mode, ecrt_domain_queue()
+ * copies the outputs into a separate image that is sent, and
+ * ecrt_domain_process() copies the received inputs back. Between these
+ * calls, the application may freely work on the process data, so that the
+ * computation of the next outputs can overlap the bus round trip.
+ *
+ * Inputs of datagrams that were not received are left untouched. The
+ * overlapping layout (see ecrt_domain_overlap()) always works this way. The
+ * mode can not be used with redundancy or with ecrt_domain_zero_copy().
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_double_buffer(
+        ec_domain_t *domain /**< Domain. */
+        );
+
+/** Exchanges the outputs and inputs of the domain with separate datagrams.
+ *
+ * Normally, a domain with inputs and outputs uses LRW datagrams, so the
+ * inputs are sampled in the same frame that writes the outputs. With split
+ * inputs and outputs, each such datagram is replaced by an LWR datagram for
+ * the outputs and an LRD datagram for the inputs over the same logical
+ * range. ecrt_domain_queue_outputs() queues the LWR datagrams and
+ * ecrt_domain_queue_inputs() the LRD datagrams, so that the outputs can be
+ * sent as early and the inputs sampled as late in the cycle as needed, each
+ * with a call of ecrt_master_send(). ecrt_domain_queue() still queues both.
+ * ecrt_domain_process() expects both to be received; the expected working
+ * counter is the same as with LRW.
+ *
+ * The mode can not be used with ecrt_domain_zero_copy() or with a pipeline
+ * depth above one. This method has to be called in non-realtime context
+ * before ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_split_io(
+        ec_domain_t *domain /**< Domain. */
+        );
+
+/** Sets the number of process data sets of the domain in flight.
+ *
+ * Normally, the domain datagrams have to be received before they can be
+ * queued again, so the cycle time is limited by the bus round trip time.
+ * With a pipeline depth of \a depth, the domain has \a depth sets of
+ * datagrams that are queued in turn. ecrt_domain_process() always processes
+ * the set that is queued by the following ecrt_domain_queue(), so the
+ * inputs are delivered with a latency of \a depth cycles, and the outputs
+ * written in one cycle are sent at the next ecrt_domain_queue(), as usual.
+ *
+ * The domain works in double-buffered mode (see
+ * ecrt_domain_double_buffer()), so the process data stay valid while the
+ * datagrams are in flight. ecrt_domain_state() reports the working counter
+ * of the last processed set. The reception timeout (see
+ * ecrt_domain_set_timeout()) has to cover \a depth cycles.
+ *
+ * The depth must be between 1 (default, no pipelining) and 8. Pipelining
+ * can not be used with redundancy or with ecrt_domain_zero_copy(). This
+ * method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_set_pipeline_depth(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int depth /**< Number of datagram sets in flight. */
+        );
+
+/** Lets the master queue the domain automatically at a sub-rate.
+ *
+ * With a \a divisor greater than zero, ecrt_master_send() queues the domain
+ * itself in every \a divisor-th call, starting with call number \a phase
+ * (counted from zero after ecrt_master_activate()). The application must
+ * not call ecrt_domain_queue() for the domain, and the #EC_CYCLE_QUEUE flag
+ * of ecrt_master_cycle() and ecrt_master_set_timed_cycle() skips it.
+ * Distributing the phases of slow domains over the divisor period keeps
+ * the frame sizes even.
+ *
+ * A \a divisor of zero (default) restores manual queuing. The \a phase
+ * must be less than \a divisor. This method has to be called in
+ * non-realtime context before ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_set_cycle_divisor(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int divisor, /**< Queue every \a divisor sends, or 0. */
+        unsigned int phase /**< Send cycle to queue the domain in. */
+        );
+
+/** Binds a domain to a single EtherCAT line (segment).
+ *
+ * By default, a master with several devices treats them as redundant links
+ * of one line: The datagrams of each domain are sent on all devices and the
+ * inputs are merged. If the devices instead drive independent lines, each
+ * domain can be bound to the line its slaves are connected to. Its
+ * datagrams are then only sent and received via the device with the index
+ * \a segment (0 for the main device, 1 for the first backup device, and so
+ * on), and the working counter only counts the replies of that line.
+ * Several domains on different lines are exchanged in parallel within the
+ * same ecrt_master_send() / ecrt_master_receive() cycle.
+ *
+ * The distributed clocks datagrams are still exchanged on the main device
+ * only. This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_set_segment(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int segment /**< Device index of the line. */
+        );
+
+/** Aligns the process data blocks of the slave configurations.
+ *
+ * Normally, the PDO entries of all slaves are packed back to back into the
+ * domain's process data, so that the data of different slaves can share a
+ * cache line. With an \a alignment of, say, 64, each slave configuration's
+ * block of process data starts on a 64 byte boundary, relative to the
+ * start of the domain, and the domain itself is aligned accordingly in the
+ * userspace mapping. This avoids false sharing between threads handling
+ * different slaves. A new block is started whenever a PDO entry of another
+ * slave configuration is registered, so the entries should be registered
+ * slave by slave.
+ *
+ * The padding only exists in the application's process data. The
+ * datagrams keep a packed image, like in double-buffered mode (see
+ * ecrt_domain_double_buffer()). The alignment must be a power of two up to
+ * the page size; 0 or 1 disable the alignment. It can not be used with
+ * redundancy or ecrt_domain_zero_copy().
+ *
+ * This method has to be called in non-realtime context before any PDO
+ * entry is registered for the domain.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_set_alignment(
+        ec_domain_t *domain, /**< Domain. */
+        size_t alignment /**< Alignment in bytes. */
+        );
+
+/** Adds a process data route.
+ *
+ * At the end of each ecrt_domain_process() call for \a src_domain, \a bits
+ * bits starting at the given source position are copied to the given
+ * position in the process data of \a dst_domain. The positions are given
+ * the same way the PDO entry registration methods return them, as byte
+ * offsets and bit positions. This way, inputs can be mirrored to outputs
+ * (for example an emergency stop input to the safe torque off outputs of
+ * several drives) before the destination domain is queued, without a round
+ * trip through the application.
+ *
+ * Routes are applied in the order they were added, and both domains may be
+ * the same. Data copied to outputs overwrite those written by the
+ * application before. If the domains are processed and queued by different
+ * threads, the application has to serialise the source domain's processing
+ * with the destination domain's queuing.
+ *
+ * This method has to be called in non-realtime context after the PDO
+ * entries of both domains have been registered and before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_add_route(
+        ec_domain_t *src_domain, /**< Source domain. */
+        unsigned int src_offset, /**< Byte offset in the source domain. */
+        unsigned int src_bit, /**< Bit position of the first source bit. */
+        ec_domain_t *dst_domain, /**< Destination domain. */
+        unsigned int dst_offset, /**< Byte offset in the destination
+                                   domain. */
+        unsigned int dst_bit, /**< Bit position of the first destination
+                                bit. */
+        unsigned int bits /**< Number of bits to copy. */
+        );
+
 #ifdef __KERNEL__
 
 /** Provide external memory to store the domain's process data.
@@ -1683,6 +3083,28 @@ void ecrt_domain_external_memory(
                           data in. */
         );
 
+/** Let the domain's process data live inside a transmit frame.
+ *
+ * The process data are stored directly in a dedicated, pinned transmit
+ * socket buffer of the main device, so that they do not have to be copied
+ * into the frame on ecrt_master_send(). The domain is sent in a frame of its
+ * own. Received data are copied back into the same memory.
+ *
+ * The process data have to fit into a single datagram, and only one domain
+ * per master can use this mode. The mode can not be combined with
+ * ecrt_domain_external_memory(); ecrt_master_activate() fails in this case.
+ * The application must not modify the process data between
+ * ecrt_master_send() and ecrt_master_receive().
+ *
+ * This method has to be called in non-realtime context before
+ * ecrt_master_activate().
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_zero_copy(
+        ec_domain_t *domain /**< Domain. */
+        );
+
 #endif /* __KERNEL__ */
 
 /** Returns the domain's process data.
@@ -1702,31 +3124,116 @@ uint8_t *ecrt_domain_data(
         ec_domain_t *domain /**< Domain. */
         );
 
+#ifndef __KERNEL__
+
+/** Lets the master signal the completion of the domain via poll().
+ *
+ * Returns a file descriptor that can be waited for with poll(), select() or
+ * epoll. While the datagrams of the domain are in flight, the kernel polls
+ * the devices in the context of the waiting thread, sleeping
+ * \a poll_interval_us between the attempts. The descriptor becomes readable
+ * as soon as all datagrams of the domain were received or timed out. It
+ * stays readable until the domain is processed with ecrt_domain_process().
+ *
+ * A call to ecrt_master_receive() is not necessary after waiting. Only one
+ * domain per master can be selected; a further call replaces it.
+ *
+ * This method has to be called after ecrt_master_activate().
+ *
+ * \return File descriptor on success, otherwise negative error code.
+ */
+int ecrt_domain_notify(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int poll_interval_us /**< Poll interval in microseconds. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 /** Determines the states of the domain's datagrams.
  *
  * Evaluates the working counters of the received datagrams and outputs
  * statistics, if necessary. This must be called after ecrt_master_receive()
  * is expected to receive the domain datagrams in order to make
  * ecrt_domain_state() return the result of the last process data exchange.
+ *
+ * Only the domain itself is accessed, so different domains can be processed
+ * concurrently by different threads, as long as this does not overlap with
+ * ecrt_master_receive().
  */
 void ecrt_domain_process(
         ec_domain_t *domain /**< Domain. */
         );
 
+#ifdef __KERNEL__
+
+/** Sets a callback to run at the end of ecrt_domain_process().
+ *
+ * The callback \a cb is called with the domain and \a cb_data in the
+ * context of ecrt_domain_process(), after the inputs were copied and the
+ * working counters were evaluated, so that ecrt_domain_state() already
+ * returns the result of the exchange. It may read the inputs and write the
+ * outputs of the domain's process data, which are sent with the next
+ * ecrt_domain_queue(). This way, short reactions like interlocks or input
+ * filters run with the latency of the process data exchange, even if the
+ * rest of the application runs in a slower task.
+ *
+ * The callback must not block and must not call master methods other than
+ * ecrt_domain_data() and ecrt_domain_state(). A NULL \a cb removes the
+ * callback.
+ */
+void ecrt_domain_process_callback(
+        ec_domain_t *domain, /**< Domain. */
+        void (*cb)(ec_domain_t *, void *), /**< Process callback. */
+        void *cb_data /**< Arbitrary data passed to \a cb. */
+        );
+
+#endif // #ifdef __KERNEL__
+
 /** (Re-)queues all domain datagrams in the master's datagram queue.
  *
  * Call this function to mark the domain's datagrams for exchanging at the
  * next call of ecrt_master_send().
+ *
+ * The datagrams are handed over to the master without touching the
+ * master's datagram queue; ecrt_master_send() appends them. So different
+ * domains can be queued concurrently by different threads, as long as this
+ * does not overlap with ecrt_master_send().
  */
 void ecrt_domain_queue(
         ec_domain_t *domain /**< Domain. */
         );
 
+/** Queues the output datagrams of the domain.
+ *
+ * With split inputs and outputs (see ecrt_domain_split_io()), this marks
+ * the LWR datagrams of the domain for exchanging at the next call of
+ * ecrt_master_send(). Otherwise, it does the same as ecrt_domain_queue().
+ */
+void ecrt_domain_queue_outputs(
+        ec_domain_t *domain /**< Domain. */
+        );
+
+/** Queues the input datagrams of the domain.
+ *
+ * With split inputs and outputs (see ecrt_domain_split_io()), this marks
+ * the LRD datagrams of the domain for exchanging at the next call of
+ * ecrt_master_send(). Otherwise, the inputs are exchanged together with the
+ * outputs and this does nothing.
+ */
+void ecrt_domain_queue_inputs(
+        ec_domain_t *domain /**< Domain. */
+        );
+
 /** Reads the state of a domain.
  *
  * Stores the domain state in the given \a state structure.
  *
  * Using this method, the process data exchange can be monitored in realtime.
+ *
+ * When the working counter drops, the master reads the AL status of all
+ * slaves of the domain, packing many slaves into each frame. Slaves that do not answer, that
+ * are not in their requested state or that have the error flag set are
+ * reported in ec_domain_state_t::wc_fault_slaves a few cycles later.
  */
 void ecrt_domain_state(
         const ec_domain_t *domain, /**< Domain. */
@@ -1734,11 +3241,226 @@ void ecrt_domain_state(
                                    information. */
         );
 
+/** Reads the ring redundancy statistics of a domain.
+ *
+ * The statistics are updated by ecrt_domain_process() for domains, that are
+ * exchanged redundantly on a master with several devices. A
+ * \a degraded_cycles count with a \a lost_cycles count of zero proves, that
+ * the process data were complete in every cycle despite the breaks of the
+ * ring. The counters are not reset while the domain exists.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_redundancy(
+        const ec_domain_t *domain, /**< Domain. */
+        ec_domain_redundancy_t *stats /**< Structure to store the
+                                        statistics. */
+        );
+
+/** Enables the process data history of a domain.
+ *
+ * Each time the domain is queued (see ecrt_domain_queue()), the master
+ * copies \a size bytes of the process data from \a offset on into a ring of
+ * \a depth records, together with the cycle counter and a time stamp. As
+ * the domain is usually queued after ecrt_domain_process() and after the
+ * outputs were written, each record holds the inputs and outputs of one
+ * cycle. Recording costs a single memcpy() per cycle.
+ *
+ * The ring is frozen by ecrt_domain_history_freeze() or, with the
+ * #EC_HISTORY_FREEZE_ON_WC flag, after the cycle with a working counter
+ * drop. It can be read via ecrt_domain_history_data() and exported with the
+ * 'history' command of the command-line tool.
+ *
+ * This method has to be called before ecrt_master_activate(). A \a depth of
+ * zero disables the history.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_history(
+        ec_domain_t *domain, /**< Domain. */
+        unsigned int depth, /**< Number of records. */
+        size_t offset, /**< Offset of the first recorded byte in the process
+                         data. */
+        size_t size, /**< Number of recorded bytes, or zero for the rest of
+                       the process data. */
+        unsigned int flags /**< Freeze triggers (#EC_HISTORY_FREEZE_ON_WC).
+                             */
+        );
+
+/** Returns the memory of the process data history ring.
+ *
+ * The ring consists of ec_history_record_t records, see
+ * ecrt_domain_history_state() for its geometry. For userspace applications,
+ * the ring is part of the memory-mapped process data.
+ *
+ * This method has to be called after ecrt_master_activate().
+ *
+ * \return Pointer to the ring, or NULL, if the history is disabled.
+ */
+const uint8_t *ecrt_domain_history_data(
+        ec_domain_t *domain /**< Domain. */
+        );
+
+/** Reads the state of the process data history ring.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_history_state(
+        const ec_domain_t *domain, /**< Domain. */
+        ec_history_state_t *state /**< Structure to store the state. */
+        );
+
+/** Freezes the process data history or resumes recording.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ecrt_domain_history_freeze(
+        ec_domain_t *domain, /**< Domain. */
+        int freeze /**< Non-zero to freeze, zero to resume recording. */
+        );
+
+/** Determines the input bytes that changed since the previous call.
+ *
+ * Compares the inputs in the domain's process data with a snapshot taken at
+ * the previous call and updates the snapshot. For every changed input byte,
+ * the bit with the byte's offset in the process data is set in \a bitmap
+ * (bit 0 of the first bitmap byte stands for offset 0). Output bytes are
+ * never reported. The initial snapshot is all zero, so the first call
+ * reports all non-zero inputs.
+ *
+ * The bitmap must have a size of at least (ecrt_domain_size() + 7) / 8
+ * bytes. Call this after ecrt_domain_process(). This method has to be called
+ * after ecrt_master_activate().
+ *
+ * \return Number of changed input bytes, otherwise negative error code.
+ */
+int ecrt_domain_changed_inputs(
+        ec_domain_t *domain, /**< Domain. */
+        uint8_t *bitmap /**< Memory to store the change bitmap in. */
+        );
+
+/** Registers a list of bit entries for packed access.
+ *
+ * Registers all PDO entries of the list like
+ * ecrt_domain_reg_pdo_entry_list() and builds a bit map from their positions
+ * in the domain. With ecrt_bit_map_gather() and ecrt_bit_map_scatter(), the
+ * first bit of every entry is then copied from and to an array of packed
+ * words, where bit i of the array (bit i % 64 of word i / 64) stands for
+ * the i-th list record. Entries that are adjacent in the process data are
+ * copied in one go, so that the channels of digital I/O terminals cost a
+ * single word operation per terminal.
+ *
+ * The \a offset and \a bit_position fields of the records may be NULL. If
+ * not, they are filled in as with ecrt_domain_reg_pdo_entry_list(). Entries
+ * need not byte-align.
+ *
+ * The bit map is freed together with the domain. This method has to be
+ * called before ecrt_master_activate().
+ *
+ * \attention The registration array has to be terminated with an empty
+ *            structure, or one with the \a index field set to zero!
+ * \return Pointer to the bit map, or NULL on error.
+ */
+ec_bit_map_t *ecrt_domain_reg_bit_map(
+        ec_domain_t *domain, /**< Domain. */
+        const ec_pdo_entry_reg_t *pdo_entry_regs /**< Array of PDO
+                                                   registrations. */
+        );
+
+/** Returns the number of bits of a bit map.
+ *
+ * The packed arrays used with ecrt_bit_map_gather() and
+ * ecrt_bit_map_scatter() need (ecrt_bit_map_size() + 63) / 64 words.
+ *
+ * \return Number of registered entries.
+ */
+unsigned int ecrt_bit_map_size(
+        const ec_bit_map_t *bit_map /**< Bit map. */
+        );
+
+/** Gathers the bits of a bit map from the process data.
+ *
+ * All words of \a bits are overwritten; bits beyond ecrt_bit_map_size() are
+ * cleared. This can be called in realtime context.
+ */
+void ecrt_bit_map_gather(
+        const ec_bit_map_t *bit_map, /**< Bit map. */
+        const uint8_t *data, /**< Domain process data, see
+                               ecrt_domain_data(). */
+        uint64_t *bits /**< Packed words to store the bits in. */
+        );
+
+/** Scatters the bits of a bit map into the process data.
+ *
+ * Only the bits of the registered entries are modified in the process data.
+ * This can be called in realtime context.
+ */
+void ecrt_bit_map_scatter(
+        const ec_bit_map_t *bit_map, /**< Bit map. */
+        uint8_t *data, /**< Domain process data, see ecrt_domain_data(). */
+        const uint64_t *bits /**< Packed words to read the bits from. */
+        );
+
+/*****************************************************************************
+ * PDO array methods.
+ ****************************************************************************/
+
+#ifndef __KERNEL__
+
+/** Converts the samples of a PDO array to floating point values.
+ *
+ * For every sample of the cycle, \a values[i] = raw * \a scale + \a offset
+ * is stored, where raw is the sample interpreted as signed or unsigned
+ * integer. The conversion is done in one loop per sample size, which the
+ * compiler can vectorize.
+ */
+void ecrt_pdo_array_read(
+        const ec_pdo_array_t *array, /**< PDO array. */
+        const uint8_t *data, /**< Domain process data. */
+        int is_signed, /**< Non-zero, if the samples are signed. */
+        float scale, /**< Scale factor. */
+        float offset, /**< Offset added after scaling. */
+        float *values /**< Memory for ec_pdo_array_t::count values. */
+        );
+
+/** Converts floating point values to the samples of a PDO array.
+ *
+ * This is the inverse of ecrt_pdo_array_read(). The raw values are rounded
+ * to the nearest integer and saturated to the range of the sample type.
+ */
+void ecrt_pdo_array_write(
+        const ec_pdo_array_t *array, /**< PDO array. */
+        uint8_t *data, /**< Domain process data. */
+        int is_signed, /**< Non-zero, if the samples are signed. */
+        float scale, /**< Scale factor (must not be zero). */
+        float offset, /**< Offset added after scaling. */
+        const float *values /**< ec_pdo_array_t::count values. */
+        );
+
+/** Calculates the timestamps of the samples of a PDO array.
+ *
+ * The samples of a cycle are taken in equal intervals of \a cycle_time /
+ * ec_pdo_array_t::count, starting at \a first_time. Usually, \a first_time
+ * is the distributed clocks time of the SYNC event that triggered the
+ * first sample, as configured with ecrt_slave_config_dc().
+ */
+void ecrt_pdo_array_timestamps(
+        const ec_pdo_array_t *array, /**< PDO array. */
+        uint64_t first_time, /**< Time of the first sample in ns. */
+        uint32_t cycle_time, /**< Cycle time in ns. */
+        uint64_t *times /**< Memory for ec_pdo_array_t::count times. */
+        );
+
+#endif // #ifndef __KERNEL__
+
 /*****************************************************************************
  * SDO request methods.
  ****************************************************************************/
 
 /** Set the SDO index and subindex.
+ *
+ * This also disables complete access (see
+ * ecrt_sdo_request_index_complete()).
  *
  * \attention If the SDO index and/or subindex is changed while
  * ecrt_sdo_request_state() returns EC_REQUEST_BUSY, this may lead to
@@ -1750,6 +3472,21 @@ void ecrt_sdo_request_index(
         uint8_t subindex /**< SDO subindex. */
         );
 
+/** Set the SDO index for complete access.
+ *
+ * Subsequent reads and writes transfer all subindices of the SDO at once,
+ * starting with subindex zero, until ecrt_sdo_request_index() is called.
+ * Make sure, that the request's data memory is large enough for the whole
+ * SDO.
+ *
+ * \attention If the SDO index is changed while ecrt_sdo_request_state()
+ * returns EC_REQUEST_BUSY, this may lead to unexpected results.
+ */
+void ecrt_sdo_request_index_complete(
+        ec_sdo_request_t *req, /**< SDO request. */
+        uint16_t index /**< SDO index. */
+        );
+
 /** Set the timeout for an SDO request.
  *
  * If the request cannot be processed in the specified time, if will be marked
@@ -1783,7 +3520,8 @@ void ecrt_sdo_request_timeout(
  *
  * \attention The return value can be invalid during a read operation, because
  * the internal SDO data memory could be re-allocated if the read SDO data do
- * not fit inside.
+ * not fit inside. This does not apply to memory provided with
+ * ecrt_sdo_request_external_memory().
  *
  * \return Pointer to the internal SDO data memory.
  */
@@ -1791,6 +3529,34 @@ uint8_t *ecrt_sdo_request_data(
         ec_sdo_request_t *req /**< SDO request. */
         );
 
+/** Provide external memory for the SDO request's data.
+ *
+ * The internal SDO data memory is released and \a data is used instead, for
+ * example to upload large objects like recorded drive traces. The memory is
+ * never re-allocated: A read operation fails with -EOVERFLOW, if the read
+ * data do not fit inside. The data size is set to \a size, so that the whole
+ * memory is written with the next write operation. ecrt_sdo_request_data()
+ * returns \a data afterwards.
+ *
+ * In kernel space, the read data are stored directly in \a data. In
+ * userspace, the kernel memory of the request is reserved with the same
+ * size, so that it does not have to be re-allocated during a transfer, and
+ * the data are copied to \a data by ecrt_sdo_request_state().
+ *
+ * The memory has to stay valid until the request is freed or another memory
+ * is provided. It is not freed by the master.
+ *
+ * \attention This method may not be called while ecrt_sdo_request_state()
+ * returns EC_REQUEST_BUSY.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ecrt_sdo_request_external_memory(
+        ec_sdo_request_t *req, /**< SDO request. */
+        uint8_t *data, /**< Memory for the SDO data. */
+        size_t size /**< Size of \a data in bytes. */
+        );
+
 /** Returns the current SDO data size.
  *
  * When the SDO request is created, the data size is set to the size of the
@@ -1839,6 +3605,48 @@ void ecrt_sdo_request_read(
         ec_sdo_request_t *req /**< SDO request. */
         );
 
+#ifdef __KERNEL__
+
+/** Sets a callback for the completion of an SDO request.
+ *
+ * The callback \a cb is called with \a cb_data, as soon as a read or write
+ * operation of the request succeeded or failed, i.e. when
+ * ecrt_sdo_request_state() stops returning EC_REQUEST_BUSY. It is called by
+ * the master thread, so it must not block and must not call blocking master
+ * methods. It may schedule a new operation of the request. A NULL \a cb
+ * removes the callback.
+ *
+ * \attention This method may not be called while ecrt_sdo_request_state()
+ * returns EC_REQUEST_BUSY.
+ */
+void ecrt_sdo_request_callback(
+        ec_sdo_request_t *req, /**< SDO request. */
+        void (*cb)(ec_sdo_request_t *, void *), /**< Completion callback. */
+        void *cb_data /**< Arbitrary data passed to \a cb. */
+        );
+
+#else
+
+/** Lets the master signal the completion of an SDO request via an eventfd.
+ *
+ * The counter of the eventfd \a fd (see eventfd(2)) is incremented as soon as
+ * a read or write operation of the request succeeded or failed. This way, a
+ * non-realtime thread can block in read() or poll() on \a fd, instead of
+ * polling ecrt_sdo_request_state(). A negative \a fd removes the eventfd.
+ *
+ * \attention This method may not be called while ecrt_sdo_request_state()
+ * returns EC_REQUEST_BUSY.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_sdo_request_eventfd(
+        ec_sdo_request_t *req, /**< SDO request. */
+        int fd /**< Eventfd file descriptor, or -1. */
+        );
+
+#endif
+
 /*****************************************************************************
  * VoE handler methods.
  ****************************************************************************/
@@ -1888,6 +3696,11 @@ void ecrt_voe_handler_received_header(
  * avoided by reserving enough memory via the \a size parameter of
  * ecrt_slave_config_create_voe_handler().
  *
+ * In userspace, the memory is moved into the area mapped by
+ * ecrt_master_activate(), taking over its content. The pointer has to be
+ * fetched again after activation, but then stays valid, and the data are
+ * read and written without copying them between kernel and application.
+ *
  * \return Pointer to the internal memory.
  */
 uint8_t *ecrt_voe_handler_data(
@@ -1969,6 +3782,48 @@ ec_request_state_t ecrt_voe_handler_execute(
     ec_voe_handler_t *voe /**< VoE handler. */
     );
 
+#ifdef __KERNEL__
+
+/** Sets a callback for the completion of a VoE handler operation.
+ *
+ * The callback \a cb is called with \a cb_data, as soon as a read or write
+ * operation of the handler succeeded or failed, i.e. when
+ * ecrt_voe_handler_execute() stops returning EC_REQUEST_BUSY. It is called
+ * from within the ecrt_voe_handler_execute() call, that completes the
+ * operation. A NULL \a cb removes the callback.
+ *
+ * \attention This method may not be called while ecrt_voe_handler_execute()
+ * returns EC_REQUEST_BUSY.
+ */
+void ecrt_voe_handler_callback(
+        ec_voe_handler_t *voe, /**< VoE handler. */
+        void (*cb)(ec_voe_handler_t *, void *), /**< Completion callback. */
+        void *cb_data /**< Arbitrary data passed to \a cb. */
+        );
+
+#else
+
+/** Lets the master signal the completion of a VoE handler operation via an
+ * eventfd.
+ *
+ * The counter of the eventfd \a fd (see eventfd(2)) is incremented as soon as
+ * a read or write operation of the handler succeeded or failed. This way, a
+ * non-realtime thread can block in read() or poll() on \a fd, instead of
+ * polling ecrt_voe_handler_execute(). A negative \a fd removes the eventfd.
+ *
+ * \attention This method may not be called while ecrt_voe_handler_execute()
+ * returns EC_REQUEST_BUSY.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_voe_handler_eventfd(
+        ec_voe_handler_t *voe, /**< VoE handler. */
+        int fd /**< Eventfd file descriptor, or -1. */
+        );
+
+#endif
+
 /*****************************************************************************
  * Register request methods.
  ****************************************************************************/
@@ -2038,6 +3893,48 @@ void ecrt_reg_request_read(
         size_t size /**< Size to write. */
         );
 
+#ifdef __KERNEL__
+
+/** Sets a callback for the completion of a register request.
+ *
+ * The callback \a cb is called with \a cb_data, as soon as a read or write
+ * operation of the request succeeded or failed, i.e. when
+ * ecrt_reg_request_state() stops returning EC_REQUEST_BUSY. It is called by
+ * the master thread, so it must not block and must not call blocking master
+ * methods. It may schedule a new operation of the request. A NULL \a cb
+ * removes the callback.
+ *
+ * \attention This method may not be called while ecrt_reg_request_state()
+ * returns EC_REQUEST_BUSY.
+ */
+void ecrt_reg_request_callback(
+        ec_reg_request_t *req, /**< Register request. */
+        void (*cb)(ec_reg_request_t *, void *), /**< Completion callback. */
+        void *cb_data /**< Arbitrary data passed to \a cb. */
+        );
+
+#else
+
+/** Lets the master signal the completion of a register request via an eventfd.
+ *
+ * The counter of the eventfd \a fd (see eventfd(2)) is incremented as soon as
+ * a read or write operation of the request succeeded or failed. This way, a
+ * non-realtime thread can block in read() or poll() on \a fd, instead of
+ * polling ecrt_reg_request_state(). A negative \a fd removes the eventfd.
+ *
+ * \attention This method may not be called while ecrt_reg_request_state()
+ * returns EC_REQUEST_BUSY.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+int ecrt_reg_request_eventfd(
+        ec_reg_request_t *req, /**< Register request. */
+        int fd /**< Eventfd file descriptor, or -1. */
+        );
+
+#endif
+
 /******************************************************************************
  * Bitwise read/write macros
  *****************************************************************************/
@@ -0,0 +1,332 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT master userspace library.
+ *
+ *  The IgH EtherCAT master userspace library is free software; you can
+ *  redistribute it and/or modify it under the terms of the GNU Lesser General
+ *  Public License as published by the Free Software Foundation; version 2.1
+ *  of the License.
+ *
+ *  The IgH EtherCAT master userspace library is distributed in the hope that
+ *  it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the IgH EtherCAT master userspace library. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/** \file
+ *
+ * Typed process data access for C++ applications.
+ *
+ * Optional, header-only C++11 layer on top of the EC_READ_* and EC_WRITE_*
+ * macros of ecrt.h. Process data entries are described by their type and
+ * bit offset in the domain:
+ *
+ * - ecrt::pdo_entry<T, BitOffset> takes the offset as a template parameter,
+ *   for example from the header generated by 'ethercat cstruct layout'. All
+ *   address calculations are folded at compile time, so an access compiles
+ *   to the same load or store as hand-written code with a constant offset.
+ *
+ * - ecrt::pdo_entry_ref<T> holds the offset determined at runtime by
+ *   ecrt_domain_reg_pdo_entry_list(). Its reg() method creates the
+ *   registration list entry.
+ *
+ * Both are accessed through an ecrt::domain_view, which binds to the
+ * process data returned by ecrt_domain_data():
+ *
+ * \code
+ * typedef ecrt::pdo_entry<uint16_t, ecrt::bit_offset(2, 0)> status_word;
+ * ecrt::pdo_entry_ref<int32_t> position;
+ *
+ * const ec_pdo_entry_reg_t regs[] = {
+ *     position.reg(0, 1, VENDOR_ID, PRODUCT_CODE, 0x6064, 0x00),
+ *     {}
+ * };
+ * ecrt_domain_reg_pdo_entry_list(domain, regs);
+ * ecrt_master_activate(master);
+ * ecrt::domain_view pd(domain);
+ *
+ * // cyclic
+ * uint16_t status = pd.get<status_word>();
+ * int32_t pos = pd.get(position);
+ * \endcode
+ *
+ * Supported types are bool (single bits), the 8 to 64 bit integer types,
+ * float and double. Values are converted from and to little endian at
+ * compile time, i. e. without any code on little-endian hosts.
+ */
+
+/*****************************************************************************/
+
+#ifndef __ECRT_HPP__
+#define __ECRT_HPP__
+
+#if __cplusplus < 201103L
+#error "ecrt.hpp requires C++11."
+#endif
+
+#include <endian.h>
+#include <string.h>
+#include <type_traits>
+
+#include "ecrt.h"
+
+/*****************************************************************************/
+
+namespace ecrt {
+
+/** Bit offset of a PDO entry from its byte offset and bit position.
+ */
+constexpr unsigned int bit_offset(
+        unsigned int offset, /**< Byte offset in the process data. */
+        unsigned int bit_position = 0 /**< Bit position (0-7). */
+        )
+{
+    return offset * 8 + bit_position;
+}
+
+/*****************************************************************************/
+
+namespace detail {
+
+/** Unsigned integer type of a given size. */
+template <unsigned int Size> struct uint_of;
+template <> struct uint_of<1> { typedef uint8_t type; };
+template <> struct uint_of<2> { typedef uint16_t type; };
+template <> struct uint_of<4> { typedef uint32_t type; };
+template <> struct uint_of<8> { typedef uint64_t type; };
+
+inline uint8_t swap(uint8_t x) { return x; }
+inline uint16_t swap(uint16_t x) { return __builtin_bswap16(x); }
+inline uint32_t swap(uint32_t x) { return __builtin_bswap32(x); }
+inline uint64_t swap(uint64_t x) { return __builtin_bswap64(x); }
+
+/** Converts between little-endian process data and host values.
+ *
+ * memcpy() is used for type punning and unaligned access; compilers
+ * replace it with a single load or store.
+ */
+template <typename T>
+struct value {
+    static_assert(std::is_arithmetic<T>::value,
+            "PDO entries must have an arithmetic type.");
+
+    typedef typename uint_of<sizeof(T)>::type raw_type;
+
+    static T load(const uint8_t *data)
+    {
+        raw_type raw;
+        T val;
+
+        memcpy(&raw, data, sizeof(raw));
+#if __BYTE_ORDER == __BIG_ENDIAN
+        raw = swap(raw);
+#endif
+        memcpy(&val, &raw, sizeof(val));
+        return val;
+    }
+
+    static void store(uint8_t *data, T val)
+    {
+        raw_type raw;
+
+        memcpy(&raw, &val, sizeof(raw));
+#if __BYTE_ORDER == __BIG_ENDIAN
+        raw = swap(raw);
+#endif
+        memcpy(data, &raw, sizeof(raw));
+    }
+};
+
+/** Single bits. */
+template <>
+struct value<bool> {
+    static bool load(const uint8_t *data, unsigned int bit)
+    {
+        return (*data >> bit) & 0x01;
+    }
+
+    static void store(uint8_t *data, unsigned int bit, bool val)
+    {
+        if (val) {
+            *data |= (1 << bit);
+        } else {
+            *data &= ~(1 << bit);
+        }
+    }
+};
+
+} // namespace detail
+
+/*****************************************************************************/
+
+/** PDO entry with a compile-time bit offset in the domain.
+ *
+ * Entries other than bool have to be byte-aligned.
+ */
+template <typename T, unsigned int BitOffset>
+struct pdo_entry {
+    static_assert(std::is_same<T, bool>::value || BitOffset % 8 == 0,
+            "Only bool PDO entries may be unaligned.");
+
+    typedef T value_type;
+    static constexpr unsigned int offset = BitOffset / 8;
+    static constexpr unsigned int bit_position = BitOffset % 8;
+
+    static T read(const uint8_t *pd)
+    {
+        return detail::value<T>::load(pd + offset);
+    }
+
+    static void write(uint8_t *pd, T val)
+    {
+        detail::value<T>::store(pd + offset, val);
+    }
+};
+
+/** Single-bit PDO entry with a compile-time bit offset in the domain.
+ */
+template <unsigned int BitOffset>
+struct pdo_entry<bool, BitOffset> {
+    typedef bool value_type;
+    static constexpr unsigned int offset = BitOffset / 8;
+    static constexpr unsigned int bit_position = BitOffset % 8;
+
+    static bool read(const uint8_t *pd)
+    {
+        return detail::value<bool>::load(pd + offset, bit_position);
+    }
+
+    static void write(uint8_t *pd, bool val)
+    {
+        detail::value<bool>::store(pd + offset, bit_position, val);
+    }
+};
+
+/*****************************************************************************/
+
+/** PDO entry with an offset determined at runtime.
+ *
+ * The offset is filled in by ecrt_domain_reg_pdo_entry_list() via the
+ * registration created with reg().
+ */
+template <typename T>
+struct pdo_entry_ref {
+    typedef T value_type;
+    unsigned int offset; /**< Byte offset in the process data. */
+    unsigned int bit_position; /**< Bit position (bool only). */
+
+    pdo_entry_ref(): offset(0), bit_position(0) {}
+
+    /** Creates an entry of a registration list.
+     *
+     * Only bool entries may be unaligned; for all other types, the
+     * registration fails if the entry does not start at a byte boundary.
+     */
+    ec_pdo_entry_reg_t reg(
+            uint16_t alias, /**< Slave alias. */
+            uint16_t position, /**< Slave position. */
+            uint32_t vendor_id, /**< Vendor ID. */
+            uint32_t product_code, /**< Product code. */
+            uint16_t index, /**< PDO entry index. */
+            uint8_t subindex /**< PDO entry subindex. */
+            )
+    {
+        ec_pdo_entry_reg_t r = {alias, position, vendor_id, product_code,
+            index, subindex, &offset,
+            std::is_same<T, bool>::value ? &bit_position : nullptr};
+        return r;
+    }
+
+    T read(const uint8_t *pd) const
+    {
+        return detail::value<T>::load(pd + offset);
+    }
+
+    void write(uint8_t *pd, T val) const
+    {
+        detail::value<T>::store(pd + offset, val);
+    }
+};
+
+/** Reads a runtime bool entry. */
+template <>
+inline bool pdo_entry_ref<bool>::read(const uint8_t *pd) const
+{
+    return detail::value<bool>::load(pd + offset, bit_position);
+}
+
+/** Writes a runtime bool entry. */
+template <>
+inline void pdo_entry_ref<bool>::write(uint8_t *pd, bool val) const
+{
+    detail::value<bool>::store(pd + offset, bit_position, val);
+}
+
+/*****************************************************************************/
+
+/** Typed view of the process data of a domain.
+ *
+ * Does not own the memory. In userspace, the process data are mapped by
+ * ecrt_master_activate(), so the view has to be created afterwards.
+ */
+class domain_view {
+    public:
+        explicit domain_view(ec_domain_t *domain):
+            pd_(ecrt_domain_data(domain)) {}
+        explicit domain_view(uint8_t *pd): pd_(pd) {}
+
+        uint8_t *data() const { return pd_; }
+
+        /** Reads an entry with a compile-time offset. */
+        template <typename Entry>
+        typename Entry::value_type get() const
+        {
+            return Entry::read(pd_);
+        }
+
+        /** Writes an entry with a compile-time offset. */
+        template <typename Entry>
+        void set(typename Entry::value_type val) const
+        {
+            Entry::write(pd_, val);
+        }
+
+        /** Reads an entry with a runtime offset. */
+        template <typename T>
+        T get(const pdo_entry_ref<T> &entry) const
+        {
+            return entry.read(pd_);
+        }
+
+        /** Writes an entry with a runtime offset. */
+        template <typename T>
+        void set(const pdo_entry_ref<T> &entry,
+                typename std::common_type<T>::type val) const
+        {
+            entry.write(pd_, val);
+        }
+
+    private:
+        uint8_t *pd_; /**< Process data. */
+};
+
+} // namespace ecrt
+
+/*****************************************************************************/
+
+#endif
@@ -100,6 +100,9 @@ unsigned int ectty_tx_data(
         );
 
 /** Pushes received data to the TTY interface.
+ *
+ * Data that do not fit into the receive ring buffer are dropped. Use
+ * ectty_rx_space() to check for enough space beforehand.
  */
 void ectty_rx_data(
         ec_tty_t *tty, /**< TTY interface. */
@@ -107,6 +110,31 @@ void ectty_rx_data(
         size_t size /**< Number of bytes in \a buffer. */
         );
 
+/** Returns the free space in the receive ring buffer.
+ *
+ * The size of the ring buffers can be set via the \a rx_buffer_size and
+ * \a tx_buffer_size module parameters.
+ *
+ * \return Number of bytes, that ectty_rx_data() can accept.
+ */
+unsigned int ectty_rx_space(
+        ec_tty_t *tty /**< TTY interface. */
+        );
+
+/** Passes received data to the TTY core and wakes up waiting writers.
+ *
+ * Should be called once per application cycle, after the data exchange via
+ * ectty_tx_data() and ectty_rx_data(). The first call disables the internal
+ * polling timer, so that the TTY interface is served at the cycle rate.
+ *
+ * Has to be called from Linux (non-RT) context, because it calls into the
+ * TTY core. Applications running in a hard real-time context should not
+ * call this function and rely on the internal timer instead.
+ */
+void ectty_poll(
+        ec_tty_t *tty /**< TTY interface. */
+        );
+
 /*****************************************************************************/
 
 /** @} */
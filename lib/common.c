@@ -83,6 +83,10 @@ ec_master_t *ecrt_open_master(unsigned int master_index)
 
     master->process_data = NULL;
     master->process_data_size = 0;
+    master->mmap_size = 0;
+    master->state = NULL;
+    master->cycle = NULL;
+    master->map_flags = 0;
     master->first_domain = NULL;
     master->first_config = NULL;
 
@@ -0,0 +1,392 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT master userspace library.
+ *
+ *  The IgH EtherCAT master userspace library is free software; you can
+ *  redistribute it and/or modify it under the terms of the GNU Lesser General
+ *  Public License as published by the Free Software Foundation; version 2.1
+ *  of the License.
+ *
+ *  The IgH EtherCAT master userspace library is distributed in the hope that
+ *  it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the IgH EtherCAT master userspace library. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Loading slave configurations from a network description file.
+*/
+
+/*****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#include "master.h"
+
+/*****************************************************************************/
+
+/** Maximum length of a line in a network description file. */
+#define EC_CONFIG_LINE_SIZE 1024
+
+/** Maximum number of tokens in a line. */
+#define EC_CONFIG_MAX_TOKENS 256
+
+/** Sync manager of the configuration being loaded. */
+typedef struct {
+    uint8_t index; /**< Sync manager index. */
+    ec_direction_t dir; /**< Direction. */
+    ec_watchdog_mode_t watchdog_mode; /**< Watchdog mode. */
+    unsigned int first_pdo; /**< Index of the first PDO. */
+    unsigned int n_pdos; /**< Number of PDOs. */
+} ec_config_sync_t;
+
+/** PDO of the configuration being loaded. */
+typedef struct {
+    uint16_t index; /**< PDO index. */
+    unsigned int first_entry; /**< Index of the first entry. */
+    unsigned int n_entries; /**< Number of entries. */
+} ec_config_pdo_t;
+
+/** PDO configuration being loaded for a slave configuration.
+ *
+ * PDOs and entries are collected in growing arrays and referenced by index,
+ * so that the ec_sync_info_t arrays can be built after the last line.
+ */
+typedef struct {
+    ec_slave_config_t *sc; /**< Slave configuration. */
+    ec_config_sync_t syncs[EC_MAX_SYNC_MANAGERS]; /**< Sync managers. */
+    unsigned int n_syncs; /**< Number of sync managers. */
+    ec_config_pdo_t *pdos; /**< PDOs. */
+    unsigned int n_pdos; /**< Number of PDOs. */
+    ec_pdo_entry_info_t *entries; /**< PDO entries. */
+    unsigned int n_entries; /**< Number of PDO entries. */
+} ec_config_file_t;
+
+/*****************************************************************************/
+
+/** Applies the collected PDO configuration to the slave configuration.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+static int ec_config_file_apply_pdos(
+        ec_config_file_t *cf /**< Loader state. */
+        )
+{
+    ec_sync_info_t syncs[EC_MAX_SYNC_MANAGERS + 1];
+    ec_pdo_info_t *pdos = NULL;
+    unsigned int i;
+    int ret;
+
+    if (!cf->sc || !cf->n_syncs) {
+        return 0;
+    }
+
+    if (cf->n_pdos) {
+        pdos = calloc(cf->n_pdos, sizeof(ec_pdo_info_t));
+        if (!pdos) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            return -ENOMEM;
+        }
+    }
+
+    for (i = 0; i < cf->n_pdos; i++) {
+        pdos[i].index = cf->pdos[i].index;
+        pdos[i].n_entries = cf->pdos[i].n_entries;
+        pdos[i].entries = cf->pdos[i].n_entries ?
+            cf->entries + cf->pdos[i].first_entry : NULL;
+    }
+
+    for (i = 0; i < cf->n_syncs; i++) {
+        syncs[i].index = cf->syncs[i].index;
+        syncs[i].dir = cf->syncs[i].dir;
+        syncs[i].n_pdos = cf->syncs[i].n_pdos;
+        syncs[i].pdos = cf->syncs[i].n_pdos ?
+            pdos + cf->syncs[i].first_pdo : NULL;
+        syncs[i].watchdog_mode = cf->syncs[i].watchdog_mode;
+    }
+    syncs[i].index = (uint8_t) EC_END;
+
+    ret = ecrt_slave_config_pdos(cf->sc, EC_END, syncs);
+    free(pdos);
+
+    cf->n_syncs = 0;
+    cf->n_pdos = 0;
+    cf->n_entries = 0;
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Grows an array by one element, if necessary.
+ *
+ * \return 0 on success, otherwise -ENOMEM.
+ */
+static int ec_config_file_grow(
+        void **array, /**< Array to grow. */
+        unsigned int count, /**< Number of used elements. */
+        size_t size /**< Element size. */
+        )
+{
+    void *new_array;
+
+    if (count & (count - 1)) {
+        return 0; // the capacity is the next power of two
+    }
+
+    new_array = realloc(*array, (count ? 2 * count : 1) * size);
+    if (!new_array) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+    *array = new_array;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Parses the numeric arguments of a line.
+ *
+ * \return 0 on success, otherwise -EINVAL.
+ */
+static int ec_config_file_numbers(
+        char **tokens, /**< Argument tokens. */
+        unsigned int count, /**< Number of tokens to parse. */
+        long long *values /**< Parsed values (output). */
+        )
+{
+    unsigned int i;
+    char *end;
+
+    for (i = 0; i < count; i++) {
+        values[i] = strtoll(tokens[i], &end, 0);
+        if (*end) {
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Processes a line of a network description file.
+ *
+ * \return 1, if a slave configuration was created, 0 on success, otherwise
+ *         a negative error code.
+ */
+static int ec_config_file_line(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_config_file_t *cf, /**< Loader state. */
+        char **tokens, /**< Tokens of the line. */
+        unsigned int n_tokens /**< Number of tokens. */
+        )
+{
+    const char *keyword = tokens[0];
+    unsigned int n_args = n_tokens - 1, i;
+    long long values[EC_CONFIG_MAX_TOKENS];
+    int ret;
+
+    if (!strcmp(keyword, "config")) {
+        if (n_args != 4 || ec_config_file_numbers(tokens + 1, 4, values)) {
+            return -EINVAL;
+        }
+        ret = ec_config_file_apply_pdos(cf);
+        if (ret) {
+            return ret;
+        }
+        cf->sc = ecrt_master_slave_config(master, values[0], values[1],
+                values[2], values[3]);
+        return cf->sc ? 1 : -ENOENT;
+    }
+
+    if (!cf->sc) {
+        return -EINVAL; // all other keywords refer to a configuration
+    }
+
+    if (!strcmp(keyword, "sync")) {
+        ec_config_sync_t *sync;
+
+        if (n_args < 2 || n_args > 3
+                || ec_config_file_numbers(tokens + 1, 1, values)
+                || values[0] < 0 || values[0] >= EC_MAX_SYNC_MANAGERS
+                || cf->n_syncs >= EC_MAX_SYNC_MANAGERS) {
+            return -EINVAL;
+        }
+        sync = &cf->syncs[cf->n_syncs];
+        sync->index = values[0];
+        if (!strcmp(tokens[2], "input")) {
+            sync->dir = EC_DIR_INPUT;
+        } else if (!strcmp(tokens[2], "output")) {
+            sync->dir = EC_DIR_OUTPUT;
+        } else {
+            return -EINVAL;
+        }
+        sync->watchdog_mode = EC_WD_DEFAULT;
+        if (n_args == 3) {
+            if (!strcmp(tokens[3], "enable")) {
+                sync->watchdog_mode = EC_WD_ENABLE;
+            } else if (!strcmp(tokens[3], "disable")) {
+                sync->watchdog_mode = EC_WD_DISABLE;
+            } else if (strcmp(tokens[3], "default")) {
+                return -EINVAL;
+            }
+        }
+        sync->first_pdo = cf->n_pdos;
+        sync->n_pdos = 0;
+        cf->n_syncs++;
+        return 0;
+    }
+
+    if (!strcmp(keyword, "pdo")) {
+        ec_config_pdo_t *pdo;
+
+        if (n_args != 1 || ec_config_file_numbers(tokens + 1, 1, values)
+                || !cf->n_syncs) {
+            return -EINVAL;
+        }
+        ret = ec_config_file_grow((void **) &cf->pdos, cf->n_pdos,
+                sizeof(ec_config_pdo_t));
+        if (ret) {
+            return ret;
+        }
+        pdo = &cf->pdos[cf->n_pdos++];
+        pdo->index = values[0];
+        pdo->first_entry = cf->n_entries;
+        pdo->n_entries = 0;
+        cf->syncs[cf->n_syncs - 1].n_pdos++;
+        return 0;
+    }
+
+    if (!strcmp(keyword, "entry")) {
+        ec_pdo_entry_info_t *entry;
+
+        if (n_args != 3 || ec_config_file_numbers(tokens + 1, 3, values)
+                || !cf->n_syncs || !cf->syncs[cf->n_syncs - 1].n_pdos) {
+            return -EINVAL;
+        }
+        ret = ec_config_file_grow((void **) &cf->entries, cf->n_entries,
+                sizeof(ec_pdo_entry_info_t));
+        if (ret) {
+            return ret;
+        }
+        entry = &cf->entries[cf->n_entries++];
+        entry->index = values[0];
+        entry->subindex = values[1];
+        entry->bit_length = values[2];
+        cf->pdos[cf->n_pdos - 1].n_entries++;
+        return 0;
+    }
+
+    if (!strcmp(keyword, "sdo")) {
+        uint8_t data[EC_CONFIG_MAX_TOKENS];
+
+        if (n_args < 3 || ec_config_file_numbers(tokens + 1, n_args, values)) {
+            return -EINVAL;
+        }
+        for (i = 2; i < n_args; i++) {
+            data[i - 2] = values[i];
+        }
+        return ecrt_slave_config_sdo(cf->sc, values[0], values[1], data,
+                n_args - 2);
+    }
+
+    if (!strcmp(keyword, "dc")) {
+        if (n_args != 5 || ec_config_file_numbers(tokens + 1, 5, values)) {
+            return -EINVAL;
+        }
+        ecrt_slave_config_dc(cf->sc, values[0], values[1], values[2],
+                values[3], values[4]);
+        return 0;
+    }
+
+    if (!strcmp(keyword, "watchdog")) {
+        if (n_args != 2 || ec_config_file_numbers(tokens + 1, 2, values)) {
+            return -EINVAL;
+        }
+        ecrt_slave_config_watchdog(cf->sc, values[0], values[1]);
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_load_config(ec_master_t *master, const char *path)
+{
+    ec_config_file_t cf;
+    char line[EC_CONFIG_LINE_SIZE], *tokens[EC_CONFIG_MAX_TOKENS], *save;
+    unsigned int line_number = 0, n_tokens;
+    int ret = 0, count = 0;
+    FILE *file;
+
+    file = fopen(path, "r");
+    if (!file) {
+        ret = -errno;
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(-ret));
+        return ret;
+    }
+
+    memset(&cf, 0, sizeof(cf));
+
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+
+        n_tokens = 0;
+        tokens[0] = strtok_r(line, " \t\r\n", &save);
+        while (tokens[n_tokens] && tokens[n_tokens][0] != '#') {
+            if (++n_tokens == EC_CONFIG_MAX_TOKENS) {
+                break;
+            }
+            tokens[n_tokens] = strtok_r(NULL, " \t\r\n", &save);
+        }
+
+        if (!n_tokens) {
+            continue; // empty line or comment
+        }
+
+        ret = ec_config_file_line(master, &cf, tokens, n_tokens);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to process line %u of %s: %s\n",
+                    line_number, path, strerror(-ret));
+            break;
+        }
+        count += ret;
+        ret = 0;
+    }
+
+    if (!ret && ferror(file)) {
+        ret = -EIO;
+        fprintf(stderr, "Failed to read %s.\n", path);
+    }
+
+    if (!ret) {
+        ret = ec_config_file_apply_pdos(&cf);
+    }
+
+    free(cf.pdos);
+    free(cf.entries);
+    fclose(file);
+    return ret ? ret : count;
+}
+
+/*****************************************************************************/
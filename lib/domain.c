@@ -35,6 +35,7 @@
 
 /*****************************************************************************/
 
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <errno.h> /* ENOENT */
@@ -42,12 +43,17 @@
 #include "ioctl.h"
 #include "domain.h"
 #include "master.h"
+#include "master/bit_map.h"
 
 /*****************************************************************************/
 
 void ec_domain_clear(ec_domain_t *domain)
 {
-    // nothing to do
+    while (domain->bit_maps) {
+        ec_bit_map_t *next = domain->bit_maps->next;
+        ec_bit_map_free(domain->bit_maps);
+        domain->bit_maps = next;
+    }
 }
 
 /*****************************************************************************/
@@ -56,22 +62,117 @@ int ecrt_domain_reg_pdo_entry_list(ec_domain_t *domain,
         const ec_pdo_entry_reg_t *regs)
 {
     const ec_pdo_entry_reg_t *reg;
-    ec_slave_config_t *sc;
+    ec_ioctl_config_record_t *records, *rec;
+    unsigned int count = 0;
     int ret;
 
     for (reg = regs; reg->index; reg++) {
-        if (!(sc = ecrt_master_slave_config(domain->master, reg->alias,
-                        reg->position, reg->vendor_id, reg->product_code)))
-            return -ENOENT;
+        count++;
+    }
 
-        if ((ret = ecrt_slave_config_reg_pdo_entry(sc, reg->index,
-                        reg->subindex, domain, reg->bit_position)) < 0)
-            return ret;
+    if (!count) {
+        return 0;
+    }
 
-        *reg->offset = ret;
+    records = calloc(2 * count, sizeof(ec_ioctl_config_record_t));
+    if (!records) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        return -ENOMEM;
     }
 
-    return 0;
+    // select the slave configuration and register the entry
+    for (reg = regs, rec = records; reg->index; reg++) {
+        rec->type = EC_IOCTL_BATCH_CONFIG;
+        rec->u.config.alias = reg->alias;
+        rec->u.config.position = reg->position;
+        rec->u.config.vendor_id = reg->vendor_id;
+        rec->u.config.product_code = reg->product_code;
+        rec++;
+
+        rec->type = EC_IOCTL_BATCH_REG_PDO_ENTRY;
+        rec->u.reg.entry_index = reg->index;
+        rec->u.reg.entry_subindex = reg->subindex;
+        rec->u.reg.domain_index = domain->index;
+        rec++;
+    }
+
+    ret = ec_master_config_batch(domain->master,
+            EC_IOCTL_CONFIG_BATCH_NO_CONFIG, records, 2 * count);
+
+    for (reg = regs, rec = records + 1; !ret && reg->index;
+            reg++, rec += 2) {
+        if (reg->bit_position) {
+            *reg->bit_position = rec->bit_position;
+        } else if (rec->bit_position) {
+            fprintf(stderr, "PDO entry 0x%04X:%02X does not byte-align "
+                    "in config %u:%u.\n", reg->index, reg->subindex,
+                    reg->alias, reg->position);
+            ret = -EFAULT;
+            break;
+        }
+
+        *reg->offset = rec->result;
+    }
+
+    free(records);
+    return ret;
+}
+
+/*****************************************************************************/
+
+ec_bit_map_t *ecrt_domain_reg_bit_map(ec_domain_t *domain,
+        const ec_pdo_entry_reg_t *regs)
+{
+    const ec_pdo_entry_reg_t *reg;
+    ec_pdo_entry_reg_t *list;
+    unsigned int *offsets, *bit_positions, count = 0, i;
+    ec_bit_map_t *bit_map = NULL;
+
+    for (reg = regs; reg->index; reg++) {
+        count++;
+    }
+
+    list = calloc(count + 1, sizeof(ec_pdo_entry_reg_t));
+    offsets = calloc(2 * count + 1, sizeof(unsigned int));
+    if (!list || !offsets) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        goto out;
+    }
+    bit_positions = offsets + count;
+
+    // register a copy of the list, that stores to the local arrays
+    for (i = 0; i < count; i++) {
+        list[i] = regs[i];
+        list[i].offset = &offsets[i];
+        list[i].bit_position = &bit_positions[i];
+    }
+
+    if (ecrt_domain_reg_pdo_entry_list(domain, list)) {
+        goto out;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (regs[i].offset) {
+            *regs[i].offset = offsets[i];
+        }
+        if (regs[i].bit_position) {
+            *regs[i].bit_position = bit_positions[i];
+        }
+    }
+
+    bit_map = ec_bit_map_create(offsets, bit_positions, count);
+    if (!bit_map) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        goto out;
+    }
+
+    bit_map->next = domain->bit_maps;
+    domain->bit_maps = bit_map;
+
+out:
+    free(offsets);
+    free(list);
+    return bit_map;
 }
 
 /*****************************************************************************/
@@ -91,6 +192,184 @@ size_t ecrt_domain_size(const ec_domain_t *domain)
 
 /*****************************************************************************/
 
+int ecrt_domain_set_timeout(ec_domain_t *domain, unsigned int timeout_us)
+{
+    ec_ioctl_domain_timeout_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.timeout_us = timeout_us;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_TIMEOUT, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set domain timeout: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_overlap(ec_domain_t *domain)
+{
+    int ret;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_OVERLAP, domain->index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set overlapping domain layout: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_split_io(ec_domain_t *domain)
+{
+    int ret;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_SPLIT_IO, domain->index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to split domain inputs and outputs: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_double_buffer(ec_domain_t *domain)
+{
+    int ret;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_DOUBLE_BUFFER,
+            domain->index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set double-buffered domain mode: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_pipeline_depth(ec_domain_t *domain, unsigned int depth)
+{
+    ec_ioctl_domain_pipeline_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.depth = depth;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_PIPELINE, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set domain pipeline depth: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_cycle_divisor(ec_domain_t *domain, unsigned int divisor,
+        unsigned int phase)
+{
+    ec_ioctl_domain_divisor_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.divisor = divisor;
+    data.phase = phase;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_DIVISOR, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set domain cycle divisor: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_segment(ec_domain_t *domain, unsigned int segment)
+{
+    ec_ioctl_domain_segment_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.segment = segment;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_SEGMENT, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set domain segment: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_alignment(ec_domain_t *domain, size_t alignment)
+{
+    ec_ioctl_domain_alignment_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.alignment = alignment;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_ALIGNMENT, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set domain alignment: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_add_route(ec_domain_t *src_domain, unsigned int src_offset,
+        unsigned int src_bit, ec_domain_t *dst_domain,
+        unsigned int dst_offset, unsigned int dst_bit, unsigned int bits)
+{
+    ec_ioctl_domain_route_t data;
+    int ret;
+
+    data.src_domain_index = src_domain->index;
+    data.src_offset = src_offset;
+    data.src_bit = src_bit;
+    data.dst_domain_index = dst_domain->index;
+    data.dst_offset = dst_offset;
+    data.dst_bit = dst_bit;
+    data.bits = bits;
+
+    ret = ioctl(src_domain->master->fd, EC_IOCTL_DOMAIN_ROUTE, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to add process data route: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 uint8_t *ecrt_domain_data(ec_domain_t *domain)
 {
     if (!domain->process_data) {
@@ -138,11 +417,67 @@ void ecrt_domain_queue(ec_domain_t *domain)
 
 /*****************************************************************************/
 
+void ecrt_domain_queue_outputs(ec_domain_t *domain)
+{
+    int ret;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_QUEUE_OUTPUTS,
+            domain->index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to queue domain outputs: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_domain_queue_inputs(ec_domain_t *domain)
+{
+    int ret;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_QUEUE_INPUTS,
+            domain->index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to queue domain inputs: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+    }
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_notify(ec_domain_t *domain, unsigned int poll_interval_us)
+{
+    ec_ioctl_domain_notify_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.poll_interval_us = poll_interval_us;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_NOTIFY, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set domain notification: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return domain->master->fd;
+}
+
+/*****************************************************************************/
+
 void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
 {
+    const ec_master_t *master = domain->master;
     ec_ioctl_domain_state_t data;
     int ret;
 
+    if (master->state && domain->index < master->state->domain_count
+            && !ec_master_read_state(master, state,
+                &master->state->domain_states[domain->index],
+                sizeof(*state))) {
+        return;
+    }
+
     data.domain_index = domain->index;
     data.state = state;
 
@@ -154,3 +489,142 @@ void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
 }
 
 /*****************************************************************************/
+
+int ecrt_domain_redundancy(const ec_domain_t *domain,
+        ec_domain_redundancy_t *stats)
+{
+    ec_ioctl_domain_redundancy_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_REDUNDANCY, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get domain redundancy statistics: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    *stats = data.stats;
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_history(ec_domain_t *domain, unsigned int depth,
+        size_t offset, size_t size, unsigned int flags)
+{
+    ec_ioctl_domain_history_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.depth = depth;
+    data.offset = offset;
+    data.size = size;
+    data.flags = flags;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_HISTORY, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to enable domain history: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+const uint8_t *ecrt_domain_history_data(ec_domain_t *domain)
+{
+    ec_ioctl_domain_history_state_t data;
+    int ret;
+
+    if (domain->history_data || !domain->master->process_data) {
+        return domain->history_data;
+    }
+
+    data.domain_index = domain->index;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_HISTORY_STATE, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get domain history: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return NULL;
+    }
+
+    if (data.map_offset != EC_IOCTL_HISTORY_NOT_MAPPED) {
+        domain->history_data =
+            domain->master->process_data + data.map_offset;
+    }
+
+    return domain->history_data;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_history_state(const ec_domain_t *domain,
+        ec_history_state_t *state)
+{
+    ec_ioctl_domain_history_state_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_HISTORY_STATE, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get domain history state: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    state->depth = data.depth;
+    state->record_size = data.record_size;
+    state->offset = data.offset;
+    state->size = data.size;
+    state->seq = data.seq;
+    state->frozen = data.frozen;
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_history_freeze(ec_domain_t *domain, int freeze)
+{
+    ec_ioctl_domain_history_freeze_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.freeze = freeze;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_HISTORY_FREEZE, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to freeze domain history: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_changed_inputs(ec_domain_t *domain, uint8_t *bitmap)
+{
+    ec_ioctl_domain_changed_inputs_t data;
+    int ret;
+
+    data.domain_index = domain->index;
+    data.bitmap = bitmap;
+
+    ret = ioctl(domain->master->fd, EC_IOCTL_DOMAIN_CHANGED_INPUTS, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get changed domain inputs: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
@@ -37,6 +37,8 @@ struct ec_domain {
     unsigned int index;
     ec_master_t *master;
     uint8_t *process_data;
+    const uint8_t *history_data;
+    ec_bit_map_t *bit_maps;
 };
 
 /*****************************************************************************/
@@ -37,6 +37,8 @@
 #include "master.h"
 #include "domain.h"
 #include "slave_config.h"
+#include "sdo_request.h"
+#include "voe_handler.h"
 
 /****************************************************************************/
 
@@ -53,6 +55,19 @@ int ecrt_master_reserve(ec_master_t *master)
 
 /****************************************************************************/
 
+int ecrt_master_reserve_shared(ec_master_t *master)
+{
+    int ret = ioctl(master->fd, EC_IOCTL_REQUEST_SHARED, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to reserve master for sharing: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+    return 0;
+}
+
+/****************************************************************************/
+
 void ec_master_clear_config(ec_master_t *master)
 {
     ec_domain_t *d, *next_d;
@@ -77,14 +92,55 @@ void ec_master_clear_config(ec_master_t *master)
     master->first_config = NULL;
 
     if (master->process_data)  {
-        munmap(master->process_data, master->process_data_size);
+        munmap(master->process_data, master->mmap_size);
         master->process_data = NULL;
         master->process_data_size = 0;
+        master->mmap_size = 0;
+        master->state = NULL;
+        master->cycle = NULL;
     }
 }
 
 /****************************************************************************/
 
+/** Maximum number of attempts to read the state page, before falling back
+ * to an ioctl().
+ */
+#define EC_STATE_READ_ATTEMPTS 3
+
+/** Copies data from the state page published by the kernel.
+ *
+ * \return 0 on success, otherwise negative error code.
+ */
+int ec_master_read_state(
+        const ec_master_t *master, /**< EtherCAT master. */
+        void *dst, /**< Destination. */
+        const void *src, /**< Source inside the state page. */
+        size_t size /**< Number of bytes to copy. */
+        )
+{
+    const volatile uint32_t *sequence = &master->state->sequence;
+    unsigned int attempt;
+    uint32_t seq;
+
+    for (attempt = 0; attempt < EC_STATE_READ_ATTEMPTS; attempt++) {
+        seq = *sequence;
+        if (seq & 1) {
+            continue; // update in progress
+        }
+        __sync_synchronize();
+        memcpy(dst, src, size);
+        __sync_synchronize();
+        if (*sequence == seq) {
+            return 0;
+        }
+    }
+
+    return -EAGAIN;
+}
+
+/****************************************************************************/
+
 void ec_master_clear(ec_master_t *master)
 {
     ec_master_clear_config(master);
@@ -139,6 +195,8 @@ ec_domain_t *ecrt_master_create_domain(ec_master_t *master)
     domain->index = (unsigned int) index;
     domain->master = master;
     domain->process_data = NULL;
+    domain->history_data = NULL;
+    domain->bit_maps = NULL;
 
     ec_master_add_domain(master, domain);
 
@@ -162,6 +220,30 @@ void ec_master_add_slave_config(ec_master_t *master, ec_slave_config_t *sc)
 
 /****************************************************************************/
 
+int ec_master_config_batch(ec_master_t *master, uint32_t config_index,
+        ec_ioctl_config_record_t *records, unsigned int count)
+{
+    ec_ioctl_config_batch_t data;
+    int ret;
+
+    data.version = EC_IOCTL_CONFIG_BATCH_VERSION;
+    data.config_index = config_index;
+    data.record_count = count;
+    data.records = records;
+    data.processed = 0;
+
+    ret = ioctl(master->fd, EC_IOCTL_CONFIG_BATCH, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to apply configuration record %u of %u: %s\n",
+                data.processed, count, strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 ec_slave_config_t *ecrt_master_slave_config(ec_master_t *master,
         uint16_t alias, uint16_t position, uint32_t vendor_id,
         uint32_t product_code)
@@ -230,6 +312,30 @@ int ecrt_master_select_reference_clock(ec_master_t *master,
 
 /****************************************************************************/
 
+int ecrt_master_select_dc_domain(ec_master_t *master, ec_domain_t *domain)
+{
+    uint32_t domain_index;
+    int ret;
+
+    if (domain) {
+        domain_index = domain->index;
+    }
+    else {
+        domain_index = 0xFFFFFFFF;
+    }
+
+    ret = ioctl(master->fd, EC_IOCTL_SELECT_DC_DOMAIN, domain_index);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to select DC domain: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 int ecrt_master(ec_master_t *master, ec_master_info_t *master_info)
 {
     ec_ioctl_master_t data;
@@ -459,6 +565,37 @@ int ecrt_master_sdo_upload(ec_master_t *master, uint16_t slave_position,
     upload.slave_position = slave_position;
     upload.sdo_index = index;
     upload.sdo_entry_subindex = subindex;
+    upload.complete_access = 0;
+    upload.target_size = target_size;
+    upload.target = target;
+
+    ret = ioctl(master->fd, EC_IOCTL_SLAVE_SDO_UPLOAD, &upload);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        if (EC_IOCTL_ERRNO(ret) == EIO && abort_code) {
+            *abort_code = upload.abort_code;
+        }
+        fprintf(stderr, "Failed to execute SDO upload: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    *result_size = upload.data_size;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_sdo_upload_complete(ec_master_t *master,
+        uint16_t slave_position, uint16_t index, uint8_t *target,
+        size_t target_size, size_t *result_size, uint32_t *abort_code)
+{
+    ec_ioctl_slave_sdo_upload_t upload;
+    int ret;
+
+    upload.slave_position = slave_position;
+    upload.sdo_index = index;
+    upload.sdo_entry_subindex = 0;
+    upload.complete_access = 1;
     upload.target_size = target_size;
     upload.target = target;
 
@@ -478,6 +615,50 @@ int ecrt_master_sdo_upload(ec_master_t *master, uint16_t slave_position,
 
 /****************************************************************************/
 
+int ecrt_master_sdo_requests_submit(ec_master_t *master,
+        ec_sdo_request_t *const *requests, const ec_direction_t *dirs,
+        unsigned int count)
+{
+    ec_ioctl_sdo_request_batch_t batch;
+    ec_ioctl_sdo_request_t *records;
+    unsigned int i;
+    int ret;
+
+    if (!count) {
+        return 0;
+    }
+
+    records = malloc(count * sizeof(ec_ioctl_sdo_request_t));
+    if (!records) {
+        fprintf(stderr, "Failed to allocate %u SDO request records.\n",
+                count);
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        records[i].config_index = requests[i]->config->index;
+        records[i].request_index = requests[i]->index;
+        records[i].dir = dirs[i];
+        records[i].data = requests[i]->data;
+        records[i].size = requests[i]->data_size;
+    }
+
+    batch.count = count;
+    batch.requests = records;
+
+    ret = ioctl(master->fd, EC_IOCTL_SDO_REQUEST_BATCH, &batch);
+    free(records);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to submit SDO requests: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 int ecrt_master_write_idn(ec_master_t *master, uint16_t slave_position,
         uint8_t drive_no, uint16_t idn, uint8_t *data, size_t data_size,
         uint16_t *error_code)
@@ -535,11 +716,78 @@ int ecrt_master_read_idn(ec_master_t *master, uint16_t slave_position,
 
 /****************************************************************************/
 
+int ecrt_master_read_idns(ec_master_t *master, uint16_t slave_position,
+        ec_soe_idn_transfer_t *transfers, unsigned int count)
+{
+    ec_ioctl_slave_soe_idns_t io;
+    int ret;
+
+    if (!count) {
+        return 0;
+    }
+
+    io.slave_position = slave_position;
+    io.count = count;
+    io.transfers = transfers;
+
+    ret = ioctl(master->fd, EC_IOCTL_SLAVE_SOE_READ_IDNS, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        if (EC_IOCTL_ERRNO(ret) != EIO) { // EIO: see transfer results
+            fprintf(stderr, "Failed to read IDNs: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+        }
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_write_idns(ec_master_t *master, uint16_t slave_position,
+        ec_soe_idn_transfer_t *transfers, unsigned int count)
+{
+    ec_ioctl_slave_soe_idns_t io;
+    int ret;
+
+    if (!count) {
+        return 0;
+    }
+
+    io.slave_position = slave_position;
+    io.count = count;
+    io.transfers = transfers;
+
+    ret = ioctl(master->fd, EC_IOCTL_SLAVE_SOE_WRITE_IDNS, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        if (EC_IOCTL_ERRNO(ret) != EIO) { // EIO: see transfer results
+            fprintf(stderr, "Failed to write IDNs: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+        }
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+void ecrt_master_set_map_flags(ec_master_t *master, unsigned int flags)
+{
+    master->map_flags = flags;
+}
+
+/****************************************************************************/
+
 int ecrt_master_activate(ec_master_t *master)
 {
     ec_ioctl_master_activate_t io;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
     int ret;
 
+    io.map_flags = master->map_flags;
+
     ret = ioctl(master->fd, EC_IOCTL_ACTIVATE, &io);
     if (EC_IOCTL_IS_ERROR(ret)) {
         fprintf(stderr, "Failed to activate master: %s\n",
@@ -548,29 +796,48 @@ int ecrt_master_activate(ec_master_t *master)
     }
 
     master->process_data_size = io.process_data_size;
+    master->mmap_size = io.mmap_size;
 
-    if (master->process_data_size) {
 #ifdef USE_RTDM
-        /* memory-mapping was already done in kernel. The user-space addess is
-         * provided in the ioctl data.
-         */
-        master->process_data = io.process_data;
+    /* memory-mapping was already done in kernel. The user-space addess is
+     * provided in the ioctl data.
+     */
+    master->process_data = io.process_data;
 #else
-        master->process_data = mmap(0, master->process_data_size,
-                PROT_READ | PROT_WRITE, MAP_SHARED, master->fd, 0);
-        if (master->process_data == MAP_FAILED) {
-            fprintf(stderr, "Failed to map process data: %s\n",
+    master->process_data = mmap(0, master->mmap_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED, master->fd, 0);
+    if (master->process_data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map process data: %s\n",
+                strerror(errno));
+        master->process_data = NULL;
+        master->process_data_size = 0;
+        master->mmap_size = 0;
+        return -errno;
+    }
+#endif
+
+    if (master->map_flags & EC_MAP_LOCK) {
+        if (mlock(master->process_data, master->mmap_size)) {
+            fprintf(stderr, "Failed to lock process data: %s\n",
                     strerror(errno));
-            master->process_data = NULL;
-            master->process_data_size = 0;
             return -errno;
         }
-#endif
-
+    } else if (master->process_data_size) {
         // Access the mapped region to cause the initial page fault
         master->process_data[0] = 0x00;
     }
 
+    master->state = (const ec_ioctl_state_page_t *)
+        (master->process_data + io.state_offset);
+    master->cycle = &((ec_ioctl_state_page_t *)
+            (master->process_data + io.state_offset))->cycle;
+
+    for (sc = master->first_config; sc; sc = sc->next) {
+        for (voe = sc->first_voe_handler; voe; voe = voe->next) {
+            ec_voe_handler_map(voe);
+        }
+    }
+
     return 0;
 }
 
@@ -609,6 +876,100 @@ int ecrt_master_set_send_interval(ec_master_t *master,
 
 /****************************************************************************/
 
+int ecrt_master_set_timed_cycle(ec_master_t *master, unsigned int flags)
+{
+    uint32_t data = flags;
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_TIMED_CYCLE, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set timed cycle: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_set_traffic_class(ec_master_t *master,
+        ec_traffic_class_t traffic_class, unsigned int priority,
+        size_t budget)
+{
+    ec_ioctl_traffic_class_t data;
+    int ret;
+
+    data.traffic_class = traffic_class;
+    data.priority = priority;
+    data.budget = budget;
+
+    ret = ioctl(master->fd, EC_IOCTL_TRAFFIC_CLASS, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set traffic class: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+uint32_t ecrt_master_cycle_counter(const ec_master_t *master)
+{
+    if (!master->state) {
+        return 0;
+    }
+
+    return *(const volatile uint32_t *) &master->state->cycle_counter;
+}
+
+/****************************************************************************/
+
+void ecrt_master_trigger_cycle(ec_master_t *master)
+{
+    volatile uint32_t *trigger;
+
+    if (!master->state) {
+        return;
+    }
+
+    trigger = (volatile uint32_t *) &master->state->cycle_trigger;
+    __sync_synchronize(); // publish the outputs before the trigger
+    *trigger = *trigger + 1;
+}
+
+/****************************************************************************/
+
+int ecrt_master_emerg_pending(const ec_master_t *master)
+{
+    if (!master->state) {
+        return 0;
+    }
+
+    return *(const volatile uint32_t *) &master->state->emerg_summary != 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_emerg_eventfd(ec_master_t *master, int fd)
+{
+    int32_t data = fd;
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_EMERG_EVENTFD, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set emergency eventfd: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 void ecrt_master_send(ec_master_t *master)
 {
     int ret;
@@ -622,6 +983,22 @@ void ecrt_master_send(ec_master_t *master)
 
 /****************************************************************************/
 
+int ecrt_master_send_at(ec_master_t *master, uint64_t tx_time_ns)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_SEND_AT, &tx_time_ns);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to send: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 void ecrt_master_receive(ec_master_t *master)
 {
     int ret;
@@ -635,10 +1012,33 @@ void ecrt_master_receive(ec_master_t *master)
 
 /****************************************************************************/
 
+int ecrt_master_receive_wait(ec_master_t *master, uint64_t deadline_ns)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_RECEIVE_WAIT, &deadline_ns);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        if (EC_IOCTL_ERRNO(ret) != ETIMEDOUT) {
+            fprintf(stderr, "Failed to receive: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+        }
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 void ecrt_master_state(const ec_master_t *master, ec_master_state_t *state)
 {
     int ret;
 
+    if (master->state && !ec_master_read_state(master, state,
+                &master->state->master_state, sizeof(*state))) {
+        return;
+    }
+
     ret = ioctl(master->fd, EC_IOCTL_MASTER_STATE, state);
     if (EC_IOCTL_IS_ERROR(ret)) {
         fprintf(stderr, "Failed to get master state: %s\n",
@@ -648,12 +1048,45 @@ void ecrt_master_state(const ec_master_t *master, ec_master_state_t *state)
 
 /****************************************************************************/
 
+int ecrt_master_slave_config_states(const ec_master_t *master,
+        ec_slave_config_state_t *states, unsigned int count)
+{
+    ec_ioctl_sc_states_t io;
+    int ret;
+
+    if (master->state && count <= master->state->config_count
+            && !ec_master_read_state(master, states,
+                master->state->config_states, count * sizeof(*states))) {
+        return count;
+    }
+
+    io.count = count;
+    io.states = states;
+
+    ret = ioctl(master->fd, EC_IOCTL_SC_STATES, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get slave configuration states: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return ret;
+}
+
+/****************************************************************************/
+
 int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
         ec_master_link_state_t *state)
 {
     ec_ioctl_link_state_t io;
     int ret;
 
+    if (master->state && dev_idx < master->state->num_devices
+            && !ec_master_read_state(master, state,
+                &master->state->link_states[dev_idx], sizeof(*state))) {
+        return 0;
+    }
+
     io.dev_idx = dev_idx;
     io.state = state;
 
@@ -669,6 +1102,43 @@ int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
 
 /****************************************************************************/
 
+int ecrt_master_cycle(ec_master_t *master, const ec_master_cycle_t *cycle)
+{
+    ec_ioctl_cycle_t io;
+    unsigned int i;
+    int ret;
+
+    io.flags = cycle->flags;
+    io.domain_mask = 0;
+    io.app_time = cycle->app_time;
+
+    for (i = 0; i < cycle->domain_count; i++) {
+        if (cycle->domains[i]->index >= EC_IOCTL_CYCLE_MAX_DOMAINS) {
+            fprintf(stderr, "Domain %u can not be used for a cycle.\n",
+                    cycle->domains[i]->index);
+            return -EINVAL;
+        }
+        io.domain_mask |= 1U << cycle->domains[i]->index;
+    }
+
+    if (master->cycle) {
+        // pass the descriptor in the mapped state page instead of copying
+        *master->cycle = io;
+        ret = ioctl(master->fd, EC_IOCTL_CYCLE_SHARED, NULL);
+    } else {
+        ret = ioctl(master->fd, EC_IOCTL_CYCLE, &io);
+    }
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to do cycle: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 void ecrt_master_application_time(ec_master_t *master, uint64_t app_time)
 {
     uint64_t time;
@@ -743,6 +1213,120 @@ int ecrt_master_reference_clock_time(ec_master_t *master, uint32_t *time)
 
 /****************************************************************************/
 
+int ecrt_master_reference_clock_time64(ec_master_t *master, uint64_t *time)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_REF_CLOCK_TIME64, time);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get reference clock time: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+    }
+
+    return ret;
+}
+
+/****************************************************************************/
+
+int32_t ecrt_master_dc_cycle_correction(ec_master_t *master)
+{
+    ec_ioctl_dc_servo_t data;
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_DC_SERVO, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get DC cycle correction: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return 0;
+    }
+
+    return data.correction;
+}
+
+/****************************************************************************/
+
+int ecrt_master_dc_time(ec_master_t *master, uint64_t *time)
+{
+    ec_ioctl_dc_servo_t data;
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_DC_SERVO, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get DC time: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    if (data.time_result) {
+        return data.time_result;
+    }
+
+    *time = data.time;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_next_send_time(ec_master_t *master, uint32_t margin,
+        uint64_t *time)
+{
+    ec_ioctl_next_send_time_t data;
+    int ret;
+
+    data.margin = margin;
+
+    ret = ioctl(master->fd, EC_IOCTL_NEXT_SEND_TIME, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get next send time: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    *time = data.time;
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_sync0_calibrate(ec_master_t *master, uint32_t cycles)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_SYNC0_CALIBRATE, &cycles);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to start SYNC0 calibration: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_sync0_shift_correction(ec_master_t *master, uint32_t margin,
+        int32_t *correction)
+{
+    ec_ioctl_sync0_shift_correction_t data;
+    int ret;
+
+    data.margin = margin;
+
+    ret = ioctl(master->fd, EC_IOCTL_SYNC0_SHIFT_CORRECTION, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        if (EC_IOCTL_ERRNO(ret) != EAGAIN) {
+            fprintf(stderr, "Failed to get SYNC0 shift correction: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+        }
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    *correction = data.correction;
+    return 0;
+}
+
+/****************************************************************************/
+
 void ecrt_master_sync_monitor_queue(ec_master_t *master)
 {
     int ret;
@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 #include "include/ecrt.h"
+#include "ioctl.h"
 
 /*****************************************************************************/
 
@@ -36,6 +37,10 @@ struct ec_master {
     int fd;
     uint8_t *process_data;
     size_t process_data_size;
+    size_t mmap_size;
+    const ec_ioctl_state_page_t *state;
+    ec_ioctl_cycle_t *cycle; /**< Cycle descriptor in the state page. */
+    unsigned int map_flags;
 
     ec_domain_t *first_domain;
     ec_slave_config_t *first_config;
@@ -44,5 +49,8 @@ struct ec_master {
 /*****************************************************************************/
 
 void ec_master_clear(ec_master_t *);
+int ec_master_read_state(const ec_master_t *, void *, const void *, size_t);
+int ec_master_config_batch(ec_master_t *, uint32_t,
+        ec_ioctl_config_record_t *, unsigned int);
 
 /*****************************************************************************/
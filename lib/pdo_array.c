@@ -0,0 +1,143 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT master userspace library.
+ *
+ *  The IgH EtherCAT master userspace library is free software; you can
+ *  redistribute it and/or modify it under the terms of the GNU Lesser General
+ *  Public License as published by the Free Software Foundation; version 2.1
+ *  of the License.
+ *
+ *  The IgH EtherCAT master userspace library is distributed in the hope that
+ *  it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with the IgH EtherCAT master userspace library. If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Conversion methods for oversampling PDO arrays.
+*/
+
+/*****************************************************************************/
+
+#include "include/ecrt.h"
+
+/*****************************************************************************/
+
+/** Converts the samples of a PDO array with the given read macro.
+ */
+#define EC_PDO_ARRAY_READ(TYPE, READ) \
+    for (i = 0; i < count; i++) { \
+        values[i] = (TYPE) READ(data + i * stride) * scale + offset; \
+    }
+
+/** Converts values to the samples of a PDO array with the given write macro.
+ */
+#define EC_PDO_ARRAY_WRITE(TYPE, MIN, MAX, WRITE) \
+    for (i = 0; i < count; i++) { \
+        float raw = (values[i] - offset) * factor; \
+        raw = raw < (float) (MIN) ? (float) (MIN) : raw; \
+        raw = raw > (float) (MAX) ? (float) (MAX) : raw; \
+        raw += raw < 0.0f ? -0.5f : 0.5f; \
+        WRITE(data + i * stride, (TYPE) raw); \
+    }
+
+/*****************************************************************************/
+
+void ecrt_pdo_array_read(const ec_pdo_array_t *array, const uint8_t *data,
+        int is_signed, float scale, float offset, float *values)
+{
+    unsigned int i, count = array->count, stride = array->stride;
+
+    data += array->offset;
+
+    switch (array->bit_length) {
+        case 8:
+            if (is_signed) {
+                EC_PDO_ARRAY_READ(int8_t, EC_READ_U8);
+            } else {
+                EC_PDO_ARRAY_READ(uint8_t, EC_READ_U8);
+            }
+            break;
+        case 16:
+            if (is_signed) {
+                EC_PDO_ARRAY_READ(int16_t, EC_READ_U16);
+            } else {
+                EC_PDO_ARRAY_READ(uint16_t, EC_READ_U16);
+            }
+            break;
+        case 32:
+            if (is_signed) {
+                EC_PDO_ARRAY_READ(int32_t, EC_READ_U32);
+            } else {
+                EC_PDO_ARRAY_READ(uint32_t, EC_READ_U32);
+            }
+            break;
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_pdo_array_write(const ec_pdo_array_t *array, uint8_t *data,
+        int is_signed, float scale, float offset, const float *values)
+{
+    unsigned int i, count = array->count, stride = array->stride;
+    float factor = 1.0f / scale;
+
+    data += array->offset;
+
+    switch (array->bit_length) {
+        case 8:
+            if (is_signed) {
+                EC_PDO_ARRAY_WRITE(int8_t, INT8_MIN, INT8_MAX, EC_WRITE_S8);
+            } else {
+                EC_PDO_ARRAY_WRITE(uint8_t, 0, UINT8_MAX, EC_WRITE_U8);
+            }
+            break;
+        case 16:
+            if (is_signed) {
+                EC_PDO_ARRAY_WRITE(int16_t, INT16_MIN, INT16_MAX, EC_WRITE_S16);
+            } else {
+                EC_PDO_ARRAY_WRITE(uint16_t, 0, UINT16_MAX, EC_WRITE_U16);
+            }
+            break;
+        case 32:
+            // the saturation limits are rounded to float
+            if (is_signed) {
+                EC_PDO_ARRAY_WRITE(int32_t, -2147483520.0f, 2147483520.0f,
+                        EC_WRITE_S32);
+            } else {
+                EC_PDO_ARRAY_WRITE(uint32_t, 0, 4294967040.0f, EC_WRITE_U32);
+            }
+            break;
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_pdo_array_timestamps(const ec_pdo_array_t *array,
+        uint64_t first_time, uint32_t cycle_time, uint64_t *times)
+{
+    unsigned int i;
+
+    for (i = 0; i < array->count; i++) {
+        times[i] = first_time + (uint64_t) i * cycle_time / array->count;
+    }
+}
+
+/*****************************************************************************/
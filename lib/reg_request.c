@@ -135,3 +135,24 @@ void ecrt_reg_request_read(ec_reg_request_t *reg, uint16_t address,
 }
 
 /*****************************************************************************/
+
+int ecrt_reg_request_eventfd(ec_reg_request_t *reg, int fd)
+{
+    ec_ioctl_request_eventfd_t data;
+    int ret;
+
+    data.config_index = reg->config->index;
+    data.request_index = reg->index;
+    data.fd = fd;
+
+    ret = ioctl(reg->config->master->fd, EC_IOCTL_REG_REQUEST_EVENTFD, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set register request eventfd: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
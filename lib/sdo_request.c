@@ -34,6 +34,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <errno.h> /* EINVAL */
 
 #include "ioctl.h"
 #include "sdo_request.h"
@@ -44,10 +45,10 @@
 
 void ec_sdo_request_clear(ec_sdo_request_t *req)
 {
-    if (req->data) {
+    if (req->data && !req->external_memory) {
         free(req->data);
-        req->data = NULL;
     }
+    req->data = NULL;
 }
 
 /*****************************************************************************
@@ -64,6 +65,7 @@ void ecrt_sdo_request_index(ec_sdo_request_t *req, uint16_t index,
     data.request_index = req->index;
     data.sdo_index = index;
     data.sdo_subindex = subindex;
+    data.complete_access = 0;
 
     ret = ioctl(req->config->master->fd, EC_IOCTL_SDO_REQUEST_INDEX, &data);
     if (EC_IOCTL_IS_ERROR(ret)) {
@@ -74,6 +76,26 @@ void ecrt_sdo_request_index(ec_sdo_request_t *req, uint16_t index,
 
 /*****************************************************************************/
 
+void ecrt_sdo_request_index_complete(ec_sdo_request_t *req, uint16_t index)
+{
+    ec_ioctl_sdo_request_t data;
+    int ret;
+
+    data.config_index = req->config->index;
+    data.request_index = req->index;
+    data.sdo_index = index;
+    data.sdo_subindex = 0;
+    data.complete_access = 1;
+
+    ret = ioctl(req->config->master->fd, EC_IOCTL_SDO_REQUEST_INDEX, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set SDO request index: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+    }
+}
+
+/*****************************************************************************/
+
 void ecrt_sdo_request_timeout(ec_sdo_request_t *req, uint32_t timeout)
 {
     ec_ioctl_sdo_request_t data;
@@ -99,6 +121,38 @@ uint8_t *ecrt_sdo_request_data(ec_sdo_request_t *req)
 
 /*****************************************************************************/
 
+int ecrt_sdo_request_external_memory(ec_sdo_request_t *req, uint8_t *data,
+        size_t size)
+{
+    ec_ioctl_sdo_request_t io;
+    int ret;
+
+    if (!data || !size) {
+        fprintf(stderr, "Invalid external SDO memory.\n");
+        return -EINVAL;
+    }
+
+    io.config_index = req->config->index;
+    io.request_index = req->index;
+    io.size = size;
+
+    ret = ioctl(req->config->master->fd, EC_IOCTL_SDO_REQUEST_MEMORY, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to reserve SDO request memory: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    ec_sdo_request_clear(req);
+    req->data = data;
+    req->mem_size = size;
+    req->data_size = size;
+    req->external_memory = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
 size_t ecrt_sdo_request_data_size(const ec_sdo_request_t *req)
 {
     return req->data_size;
@@ -180,3 +234,24 @@ void ecrt_sdo_request_write(ec_sdo_request_t *req)
 }
 
 /*****************************************************************************/
+
+int ecrt_sdo_request_eventfd(ec_sdo_request_t *req, int fd)
+{
+    ec_ioctl_request_eventfd_t data;
+    int ret;
+
+    data.config_index = req->config->index;
+    data.request_index = req->index;
+    data.fd = fd;
+
+    ret = ioctl(req->config->master->fd, EC_IOCTL_SDO_REQUEST_EVENTFD, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set SDO request eventfd: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
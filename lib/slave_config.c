@@ -211,14 +211,16 @@ int ecrt_slave_config_pdos(ec_slave_config_t *sc,
         unsigned int n_syncs, const ec_sync_info_t syncs[])
 {
     int ret;
-    unsigned int i, j, k;
+    unsigned int i, j, k, count = 0;
     const ec_sync_info_t *sync_info;
     const ec_pdo_info_t *pdo_info;
     const ec_pdo_entry_info_t *entry_info;
+    ec_ioctl_config_record_t *records, *rec;
 
     if (!syncs)
         return 0;
 
+    // count the configuration records
     for (i = 0; i < n_syncs; i++) {
         sync_info = &syncs[i];
 
@@ -231,42 +233,80 @@ int ecrt_slave_config_pdos(ec_slave_config_t *sc,
             return -ENOENT;
         }
 
-        ret = ecrt_slave_config_sync_manager(sc, sync_info->index,
-                sync_info->dir, sync_info->watchdog_mode);
-        if (ret)
-            return ret;
+        count += 2;
 
-        ecrt_slave_config_pdo_assign_clear(sc, sync_info->index);
+        if (sync_info->n_pdos && sync_info->pdos) {
+            for (j = 0; j < sync_info->n_pdos; j++) {
+                pdo_info = &sync_info->pdos[j];
+                count += 2;
+                if (pdo_info->n_entries && pdo_info->entries) {
+                    count += pdo_info->n_entries;
+                }
+            }
+        }
+    }
+
+    if (!count)
+        return 0;
+
+    records = calloc(count, sizeof(ec_ioctl_config_record_t));
+    if (!records) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
+    // apply the whole configuration with a single ioctl()
+    rec = records;
+    for (i = 0; i < n_syncs; i++) {
+        sync_info = &syncs[i];
+
+        if (sync_info->index == (uint8_t) EC_END)
+            break;
+
+        rec->type = EC_IOCTL_BATCH_SYNC;
+        rec->u.sync.sync_index = sync_info->index;
+        rec->u.sync.dir = sync_info->dir;
+        rec->u.sync.watchdog_mode = sync_info->watchdog_mode;
+        rec++;
+
+        rec->type = EC_IOCTL_BATCH_CLEAR_PDOS;
+        rec->u.pdo.sync_index = sync_info->index;
+        rec++;
 
         if (sync_info->n_pdos && sync_info->pdos) {
 
             for (j = 0; j < sync_info->n_pdos; j++) {
                 pdo_info = &sync_info->pdos[j];
 
-                ret = ecrt_slave_config_pdo_assign_add(
-                        sc, sync_info->index, pdo_info->index);
-                if (ret)
-                    return ret;
+                rec->type = EC_IOCTL_BATCH_ADD_PDO;
+                rec->u.pdo.sync_index = sync_info->index;
+                rec->u.pdo.index = pdo_info->index;
+                rec++;
 
-                ecrt_slave_config_pdo_mapping_clear(sc, pdo_info->index);
+                rec->type = EC_IOCTL_BATCH_CLEAR_ENTRIES;
+                rec->u.pdo.index = pdo_info->index;
+                rec++;
 
                 if (pdo_info->n_entries && pdo_info->entries) {
                     for (k = 0; k < pdo_info->n_entries; k++) {
                         entry_info = &pdo_info->entries[k];
 
-                        ret = ecrt_slave_config_pdo_mapping_add(sc,
-                                pdo_info->index, entry_info->index,
-                                entry_info->subindex,
-                                entry_info->bit_length);
-                        if (ret)
-                            return ret;
+                        rec->type = EC_IOCTL_BATCH_ADD_ENTRY;
+                        rec->u.entry.pdo_index = pdo_info->index;
+                        rec->u.entry.entry_index = entry_info->index;
+                        rec->u.entry.entry_subindex = entry_info->subindex;
+                        rec->u.entry.entry_bit_length =
+                            entry_info->bit_length;
+                        rec++;
                     }
                 }
             }
         }
     }
 
-    return 0;
+    ret = ec_master_config_batch(sc->master, sc->index, records, count);
+    free(records);
+    return ret;
 }
 
 /*****************************************************************************/
@@ -310,6 +350,50 @@ int ecrt_slave_config_reg_pdo_entry(
 
 /*****************************************************************************/
 
+int ecrt_slave_config_reg_fmmu(ec_slave_config_t *sc, ec_domain_t *domain,
+        uint16_t address, size_t size, ec_direction_t dir)
+{
+    ec_ioctl_sc_reg_fmmu_t data;
+    int ret;
+
+    data.config_index = sc->index;
+    data.domain_index = domain->index;
+    data.address = address;
+    data.size = size;
+    data.dir = dir;
+
+    ret = ioctl(sc->master->fd, EC_IOCTL_SC_REG_FMMU, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to map registers: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+int ecrt_slave_config_dc_latch(ec_slave_config_t *sc, ec_domain_t *domain)
+{
+    ec_ioctl_sc_dc_latch_t data;
+    int ret;
+
+    data.config_index = sc->index;
+    data.domain_index = domain->index;
+
+    ret = ioctl(sc->master->fd, EC_IOCTL_SC_DC_LATCH, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to map DC latch registers: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
 int ecrt_slave_config_reg_pdo_entry_pos(
         ec_slave_config_t *sc,
         uint8_t sync_index,
@@ -351,6 +435,35 @@ int ecrt_slave_config_reg_pdo_entry_pos(
 
 /*****************************************************************************/
 
+int ecrt_slave_config_reg_pdo_array(
+        ec_slave_config_t *sc,
+        uint16_t index,
+        uint8_t subindex,
+        ec_domain_t *domain,
+        ec_pdo_array_t *array
+        )
+{
+    ec_ioctl_reg_pdo_array_t io;
+    int ret;
+
+    io.config_index = sc->index;
+    io.entry_index = index;
+    io.entry_subindex = subindex;
+    io.domain_index = domain->index;
+
+    ret = ioctl(sc->master->fd, EC_IOCTL_SC_REG_PDO_ARRAY, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to register PDO array: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    *array = io.array;
+    return 0;
+}
+
+/*****************************************************************************/
+
 void ecrt_slave_config_dc(ec_slave_config_t *sc, uint16_t assign_activate,
         uint32_t sync0_cycle_time, int32_t sync0_shift_time,
         uint32_t sync1_cycle_time, int32_t sync1_shift_time)
@@ -479,9 +592,17 @@ int ecrt_slave_config_emerg_size(ec_slave_config_t *sc, size_t elements)
 
 int ecrt_slave_config_emerg_pop(ec_slave_config_t *sc, uint8_t *target)
 {
+    const ec_ioctl_state_page_t *state = sc->master->state;
     ec_ioctl_sc_emerg_t io;
     int ret;
 
+    if (state && sc->index < EC_IOCTL_STATE_MAX_CONFIGS
+            && !(*(const volatile uint32_t *)
+                &state->emerg_pending[sc->index / 32]
+                & (1U << (sc->index % 32)))) {
+        return -ENOENT; // ring is empty, no system call needed
+    }
+
     io.config_index = sc->index;
     io.target = target;
 
@@ -566,6 +687,8 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request(ec_slave_config_t *sc,
         return 0;
     }
 
+    req->external_memory = 0;
+
     if (size) {
         req->data = malloc(size);
         if (!req->data) {
@@ -712,6 +835,7 @@ ec_voe_handler_t *ecrt_slave_config_create_voe_handler(ec_slave_config_t *sc,
     } else {
         voe->data = NULL;
     }
+    voe->map_data = NULL;
 
     data.config_index = sc->index;
     data.size = size;
@@ -49,6 +49,34 @@ void ec_voe_handler_clear(ec_voe_handler_t *voe)
         free(voe->data);
         voe->data = NULL;
     }
+    voe->map_data = NULL;
+}
+
+/*****************************************************************************/
+
+/** Switches to the handler's data memory mapped on activation.
+ *
+ * Data already written to the handler's memory are taken over.
+ */
+void ec_voe_handler_map(ec_voe_handler_t *voe)
+{
+    ec_ioctl_voe_t data;
+    int ret;
+
+    data.config_index = voe->config->index;
+    data.voe_index = voe->index;
+
+    ret = ioctl(voe->config->master->fd, EC_IOCTL_VOE_OFFSET, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to get mapped VoE data memory: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return;
+    }
+
+    voe->map_data = voe->config->master->process_data + data.offset;
+    if (voe->data) {
+        memcpy(voe->map_data, voe->data, voe->mem_size);
+    }
 }
 
 /*****************************************************************************/
@@ -95,7 +123,7 @@ void ecrt_voe_handler_received_header(const ec_voe_handler_t *voe,
 
 uint8_t *ecrt_voe_handler_data(ec_voe_handler_t *voe)
 {
-    return voe->data;
+    return voe->map_data ? voe->map_data : voe->data;
 }
 
 /*****************************************************************************/
@@ -149,7 +177,8 @@ void ecrt_voe_handler_write(ec_voe_handler_t *voe, size_t size)
     data.config_index = voe->config->index;
     data.voe_index = voe->index;
     data.size = size;
-    data.data = voe->data;
+    // mapped data are already in kernel memory
+    data.data = voe->map_data ? NULL : voe->data;
 
     ret = ioctl(voe->config->master->fd, EC_IOCTL_VOE_WRITE, &data);
     if (EC_IOCTL_IS_ERROR(ret)) {
@@ -182,13 +211,15 @@ ec_request_state_t ecrt_voe_handler_execute(ec_voe_handler_t *voe)
             return EC_REQUEST_ERROR;
         }
 
-        data.data = voe->data;
+        if (!voe->map_data) {
+            data.data = voe->data;
 
-        ret = ioctl(voe->config->master->fd, EC_IOCTL_VOE_DATA, &data);
-        if (EC_IOCTL_IS_ERROR(ret)) {
-            fprintf(stderr, "Failed to get VoE data: %s\n",
-                    strerror(EC_IOCTL_ERRNO(ret)));
-            return EC_REQUEST_ERROR;
+            ret = ioctl(voe->config->master->fd, EC_IOCTL_VOE_DATA, &data);
+            if (EC_IOCTL_IS_ERROR(ret)) {
+                fprintf(stderr, "Failed to get VoE data: %s\n",
+                        strerror(EC_IOCTL_ERRNO(ret)));
+                return EC_REQUEST_ERROR;
+            }
         }
         voe->data_size = data.size;
     }
@@ -197,3 +228,24 @@ ec_request_state_t ecrt_voe_handler_execute(ec_voe_handler_t *voe)
 }
 
 /*****************************************************************************/
+
+int ecrt_voe_handler_eventfd(ec_voe_handler_t *voe, int fd)
+{
+    ec_ioctl_request_eventfd_t data;
+    int ret;
+
+    data.config_index = voe->config->index;
+    data.request_index = voe->index;
+    data.fd = fd;
+
+    ret = ioctl(voe->config->master->fd, EC_IOCTL_VOE_EVENTFD, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        fprintf(stderr, "Failed to set VoE handler eventfd: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
@@ -39,10 +39,12 @@ struct ec_voe_handler {
     size_t data_size;
     size_t mem_size;
     uint8_t *data;
+    uint8_t *map_data;
 };
 
 /*****************************************************************************/
 
 void ec_voe_handler_clear(ec_voe_handler_t *);
+void ec_voe_handler_map(ec_voe_handler_t *);
 
 /*****************************************************************************/
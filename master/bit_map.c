@@ -0,0 +1,270 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT bit map for packed access to bit entries.
+
+   This file is compiled into the master module and into the userspace
+   library.
+*/
+
+/*****************************************************************************/
+
+#ifdef __KERNEL__
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+#include "bit_map.h"
+
+/*****************************************************************************/
+
+/** Maximum number of bits per copy operation.
+ *
+ * Together with a bit shift of up to 7, the bits fit into 8 bytes.
+ */
+#define EC_BIT_MAP_MAX_BITS 56
+
+/*****************************************************************************/
+
+/** Plans the copy operations for a list of bit positions.
+ *
+ * Entries, that follow each other in the process data, are merged to runs.
+ * Runs are split, so that no operation crosses a packed word or exceeds
+ * EC_BIT_MAP_MAX_BITS.
+ *
+ * \return Number of operations.
+ */
+static unsigned int ec_bit_map_plan(
+        ec_bit_map_op_t *ops, /**< Operations to fill, or NULL to count. */
+        const unsigned int *offsets, /**< Byte offsets of the entries. */
+        const unsigned int *bit_positions, /**< Bit positions of the
+                                             entries. */
+        unsigned int count /**< Number of entries. */
+        )
+{
+    unsigned int i = 0, op_count = 0;
+
+    while (i < count) {
+        unsigned int src = offsets[i] * 8 + bit_positions[i];
+        unsigned int dst = i, len = 1;
+
+        while (i + len < count &&
+                offsets[i + len] * 8 + bit_positions[i + len] == src + len) {
+            len++;
+        }
+        i += len;
+
+        while (len) {
+            unsigned int chunk = 64 - dst % 64;
+
+            if (chunk > EC_BIT_MAP_MAX_BITS) {
+                chunk = EC_BIT_MAP_MAX_BITS;
+            }
+            if (chunk > len) {
+                chunk = len;
+            }
+
+            if (ops) {
+                ec_bit_map_op_t *op = &ops[op_count];
+                op->mask = (1ULL << chunk) - 1;
+                op->offset = src / 8;
+                op->word = dst / 64;
+                op->shift = src % 8;
+                op->size = (op->shift + chunk + 7) / 8;
+                op->bits_shift = dst % 64;
+            }
+
+            op_count++;
+            src += chunk;
+            dst += chunk;
+            len -= chunk;
+        }
+    }
+
+    return op_count;
+}
+
+/*****************************************************************************/
+
+/** Creates a bit map.
+ *
+ * \return Pointer to the bit map, or NULL if out of memory.
+ */
+ec_bit_map_t *ec_bit_map_create(
+        const unsigned int *offsets, /**< Byte offsets of the entries. */
+        const unsigned int *bit_positions, /**< Bit positions of the
+                                             entries. */
+        unsigned int count /**< Number of entries. */
+        )
+{
+    unsigned int op_count = ec_bit_map_plan(NULL, offsets, bit_positions,
+            count);
+    size_t size = sizeof(ec_bit_map_t) + op_count * sizeof(ec_bit_map_op_t);
+    ec_bit_map_t *bit_map;
+
+#ifdef __KERNEL__
+    bit_map = kmalloc(size, GFP_KERNEL);
+#else
+    bit_map = malloc(size);
+#endif
+    if (!bit_map) {
+        return NULL;
+    }
+
+    bit_map->next = NULL;
+    bit_map->bit_count = count;
+    bit_map->op_count = ec_bit_map_plan(bit_map->ops, offsets,
+            bit_positions, count);
+    return bit_map;
+}
+
+/*****************************************************************************/
+
+/** Frees a bit map.
+ */
+void ec_bit_map_free(
+        ec_bit_map_t *bit_map /**< Bit map. */
+        )
+{
+#ifdef __KERNEL__
+    kfree(bit_map);
+#else
+    free(bit_map);
+#endif
+}
+
+/*****************************************************************************/
+
+/** Loads up to 8 little-endian process data bytes.
+ */
+static inline uint64_t ec_bit_map_load(
+        const uint8_t *data, /**< Process data. */
+        unsigned int size /**< Number of bytes. */
+        )
+{
+    uint64_t value = 0;
+    unsigned int i;
+
+    if (size == 8) {
+        memcpy(&value, data, 8);
+        return le64_to_cpu(value);
+    }
+
+    for (i = 0; i < size; i++) {
+        value |= (uint64_t) data[i] << (8 * i);
+    }
+
+    return value;
+}
+
+/*****************************************************************************/
+
+/** Stores up to 8 little-endian process data bytes.
+ */
+static inline void ec_bit_map_store(
+        uint8_t *data, /**< Process data. */
+        unsigned int size, /**< Number of bytes. */
+        uint64_t value /**< Value to store. */
+        )
+{
+    unsigned int i;
+
+    if (size == 8) {
+        value = cpu_to_le64(value);
+        memcpy(data, &value, 8);
+        return;
+    }
+
+    for (i = 0; i < size; i++) {
+        data[i] = value >> (8 * i);
+    }
+}
+
+/*****************************************************************************
+ *  Application interface
+ ****************************************************************************/
+
+unsigned int ecrt_bit_map_size(const ec_bit_map_t *bit_map)
+{
+    return bit_map->bit_count;
+}
+
+/*****************************************************************************/
+
+void ecrt_bit_map_gather(const ec_bit_map_t *bit_map, const uint8_t *data,
+        uint64_t *bits)
+{
+    const ec_bit_map_op_t *op, *end = bit_map->ops + bit_map->op_count;
+
+    memset(bits, 0, (bit_map->bit_count + 63) / 64 * sizeof(uint64_t));
+
+    for (op = bit_map->ops; op < end; op++) {
+        uint64_t value = ec_bit_map_load(data + op->offset, op->size);
+        bits[op->word] |= ((value >> op->shift) & op->mask) << op->bits_shift;
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_bit_map_scatter(const ec_bit_map_t *bit_map, uint8_t *data,
+        const uint64_t *bits)
+{
+    const ec_bit_map_op_t *op, *end = bit_map->ops + bit_map->op_count;
+
+    for (op = bit_map->ops; op < end; op++) {
+        uint8_t *pd = data + op->offset;
+        uint64_t value = ec_bit_map_load(pd, op->size);
+
+        value &= ~(op->mask << op->shift);
+        value |= ((bits[op->word] >> op->bits_shift) & op->mask) << op->shift;
+        ec_bit_map_store(pd, op->size, value);
+    }
+}
+
+/*****************************************************************************/
+
+#ifdef __KERNEL__
+
+/** \cond */
+
+EXPORT_SYMBOL(ecrt_bit_map_size);
+EXPORT_SYMBOL(ecrt_bit_map_gather);
+EXPORT_SYMBOL(ecrt_bit_map_scatter);
+
+/** \endcond */
+
+#endif
+
+/*****************************************************************************/
@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT bit map for packed access to bit entries.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_BIT_MAP_H__
+#define __EC_BIT_MAP_H__
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** Copy operation of a bit map.
+ *
+ * Copies up to 56 adjacent bits between the process data and one packed
+ * word, so that at most 8 process data bytes are touched.
+ */
+typedef struct {
+    uint64_t mask; /**< Mask of the copied bits, not shifted. */
+    uint32_t offset; /**< Process data offset of the first byte. */
+    uint32_t word; /**< Index of the packed word. */
+    uint8_t shift; /**< Bit position of the first bit in the first byte. */
+    uint8_t size; /**< Number of process data bytes touched (1 to 8). */
+    uint8_t bits_shift; /**< Bit position of the first bit in the word. */
+} ec_bit_map_op_t;
+
+/** Bit map for packed access to a list of bit entries.
+ */
+struct ec_bit_map {
+    ec_bit_map_t *next; /**< Next bit map of the domain. */
+    unsigned int bit_count; /**< Number of registered entries. */
+    unsigned int op_count; /**< Number of copy operations. */
+    ec_bit_map_op_t ops[]; /**< Copy operations. */
+};
+
+/*****************************************************************************/
+
+ec_bit_map_t *ec_bit_map_create(const unsigned int *, const unsigned int *,
+        unsigned int);
+void ec_bit_map_free(ec_bit_map_t *);
+
+/*****************************************************************************/
+
+#endif
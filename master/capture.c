@@ -0,0 +1,214 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Binary frame capture ring.
+*/
+
+/*****************************************************************************/
+
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+
+#include "globals.h"
+#include "capture.h"
+
+/*****************************************************************************/
+
+/** Constructor.
+ */
+void ec_capture_init(
+        ec_capture_t *capture /**< Capture ring. */
+        )
+{
+    capture->frames = NULL;
+    capture->active = 0;
+    capture->seq = 0;
+    capture->start_seq = 0;
+    capture->triggers = 0;
+    capture->post_frames = 0;
+    capture->countdown = 0;
+    capture->triggered = 0;
+}
+
+/*****************************************************************************/
+
+/** Destructor.
+ *
+ * The capture must not be written any more.
+ */
+void ec_capture_clear(
+        ec_capture_t *capture /**< Capture ring. */
+        )
+{
+    if (capture->frames) {
+        vfree(capture->frames);
+        capture->frames = NULL;
+    }
+}
+
+/*****************************************************************************/
+
+/** Starts capturing.
+ *
+ * The ring memory is allocated on the first start and kept until the
+ * capture is cleared, because the writing context is not synchronized.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_capture_start(
+        ec_capture_t *capture, /**< Capture ring. */
+        unsigned int triggers, /**< Events, that stop the capture. */
+        unsigned int post_frames /**< Frames to capture after a trigger. */
+        )
+{
+    capture->active = 0;
+    smp_wmb();
+
+    if (!capture->frames) {
+        capture->frames =
+            vzalloc(sizeof(ec_capture_frame_t) * EC_CAPTURE_RING_SIZE);
+        if (!capture->frames) {
+            return -ENOMEM;
+        }
+    }
+
+    capture->start_seq = capture->seq;
+    capture->triggers = triggers;
+    capture->post_frames = post_frames;
+    capture->countdown = 0;
+    capture->triggered = 0;
+    smp_wmb(); // publish the settings before activating
+    capture->active = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Stops capturing.
+ */
+void ec_capture_stop(
+        ec_capture_t *capture /**< Capture ring. */
+        )
+{
+    capture->active = 0;
+}
+
+/*****************************************************************************/
+
+/** Stores a frame in the capture ring.
+ *
+ * Only to be called, if the capture is active.
+ */
+void ec_capture_frame(
+        ec_capture_t *capture, /**< Capture ring. */
+        u8 dir, /**< Zero for transmitted, one for received frames. */
+        const void *data, /**< Frame data. */
+        size_t size /**< Frame size. */
+        )
+{
+    u32 seq = capture->seq;
+    ec_capture_frame_t *frame = &capture->frames[seq % EC_CAPTURE_RING_SIZE];
+
+    if (capture->triggered) {
+        if (!capture->countdown) {
+            capture->active = 0;
+            return;
+        }
+        capture->countdown--;
+    }
+
+    frame->seq = 0;
+    smp_wmb(); // invalidate the frame before overwriting it
+    frame->time = ktime_to_ns(ktime_get_real());
+    frame->dir = dir;
+    frame->size = min(size, (size_t) ETH_FRAME_LEN);
+    memcpy(frame->data, data, frame->size);
+    smp_wmb(); // complete the frame before marking it valid
+    frame->seq = seq + 1;
+    capture->seq = seq + 1;
+}
+
+/*****************************************************************************/
+
+/** Notifies the capture about an event.
+ *
+ * If the event is one of the triggers, only the configured number of
+ * frames is captured afterwards.
+ */
+void ec_capture_trigger(
+        ec_capture_t *capture, /**< Capture ring. */
+        unsigned int event /**< Event (EC_CAPTURE_UNMATCHED etc.). */
+        )
+{
+    if (capture->active && (capture->triggers & event)
+            && !capture->triggered) {
+        capture->countdown = capture->post_frames;
+        capture->triggered = 1;
+    }
+}
+
+/*****************************************************************************/
+
+/** Reads a frame from the capture ring.
+ *
+ * \retval 0 Success.
+ * \retval -ENOENT The frame is not (or no more) in the ring.
+ */
+int ec_capture_read(
+        const ec_capture_t *capture, /**< Capture ring. */
+        u32 seq, /**< Sequence number of the frame. */
+        ec_capture_frame_t *target /**< Target memory. */
+        )
+{
+    const ec_capture_frame_t *frame;
+
+    if (!capture->frames) {
+        return -ENOENT;
+    }
+
+    frame = &capture->frames[seq % EC_CAPTURE_RING_SIZE];
+    if (frame->seq != seq + 1) {
+        return -ENOENT;
+    }
+    smp_rmb();
+
+    memcpy(target, frame, sizeof(*target));
+
+    // check, if the frame was overwritten during the copy
+    smp_rmb();
+    if (frame->seq != seq + 1) {
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Binary frame capture ring.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_CAPTURE_H__
+#define __EC_CAPTURE_H__
+
+#include <linux/types.h>
+#include <linux/if_ether.h>
+
+/*****************************************************************************/
+
+/** Number of frames in a capture ring.
+ */
+#define EC_CAPTURE_RING_SIZE 1024
+
+/** Capture trigger: A datagram could not be matched.
+ *
+ * Same value as EC_IOCTL_CAPTURE_UNMATCHED.
+ */
+#define EC_CAPTURE_UNMATCHED 0x01
+
+/** Capture trigger: The working counter of a domain changed.
+ *
+ * Same value as EC_IOCTL_CAPTURE_WC_CHANGE.
+ */
+#define EC_CAPTURE_WC_CHANGE 0x02
+
+/*****************************************************************************/
+
+/** Captured frame.
+ */
+typedef struct {
+    u32 seq; /**< Sequence number + 1, or zero while the frame is written. */
+    u16 size; /**< Frame size in byte. */
+    u8 dir; /**< Zero for transmitted, one for received frames. */
+    u64 time; /**< Real time of capture in ns. */
+    u8 data[ETH_FRAME_LEN]; /**< Frame data, beginning with the Ethernet
+                              header. */
+} ec_capture_frame_t;
+
+/** Binary frame capture ring.
+ *
+ * The ring is written lock-free by the context, that sends and receives
+ * frames, and read via ioctl(). Each frame is marked with its sequence
+ * number, so that the reader can detect frames overwritten while reading.
+ */
+typedef struct {
+    ec_capture_frame_t *frames; /**< Ring memory, or NULL. */
+    unsigned int active; /**< Frames are captured. */
+    u32 seq; /**< Number of frames captured since loading. */
+    u32 start_seq; /**< Sequence number of the first frame captured since
+                     the last start. */
+    unsigned int triggers; /**< Events, that stop the capture. */
+    unsigned int post_frames; /**< Frames to capture after a trigger. */
+    unsigned int countdown; /**< Frames left after a trigger. */
+    unsigned int triggered; /**< A trigger event occurred. */
+} ec_capture_t;
+
+/*****************************************************************************/
+
+void ec_capture_init(ec_capture_t *);
+void ec_capture_clear(ec_capture_t *);
+int ec_capture_start(ec_capture_t *, unsigned int, unsigned int);
+void ec_capture_stop(ec_capture_t *);
+void ec_capture_frame(ec_capture_t *, u8, const void *, size_t);
+void ec_capture_trigger(ec_capture_t *, unsigned int);
+int ec_capture_read(const ec_capture_t *, u32, ec_capture_frame_t *);
+
+/*****************************************************************************/
+
+#endif
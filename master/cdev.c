@@ -53,6 +53,10 @@ static int eccdev_open(struct inode *, struct file *);
 static int eccdev_release(struct inode *, struct file *);
 static long eccdev_ioctl(struct file *, unsigned int, unsigned long);
 static int eccdev_mmap(struct file *, struct vm_area_struct *);
+static unsigned int eccdev_poll(struct file *, poll_table *);
+#ifdef EC_HAVE_URING_CMD
+static int eccdev_uring_cmd(struct io_uring_cmd *, unsigned int);
+#endif
 
 /** This is the kernel version from which the .fault member of the
  * vm_operations_struct is usable.
@@ -85,7 +89,11 @@ static struct file_operations eccdev_fops = {
     .open           = eccdev_open,
     .release        = eccdev_release,
     .unlocked_ioctl = eccdev_ioctl,
-    .mmap           = eccdev_mmap
+    .mmap           = eccdev_mmap,
+    .poll           = eccdev_poll,
+#ifdef EC_HAVE_URING_CMD
+    .uring_cmd      = eccdev_uring_cmd,
+#endif
 };
 
 /** Callbacks for a virtual memory area retrieved with ecdevc_mmap().
@@ -167,6 +175,15 @@ int eccdev_open(struct inode *inode, struct file *filp)
     priv->ctx.requested = 0;
     priv->ctx.process_data = NULL;
     priv->ctx.process_data_size = 0;
+    priv->ctx.mmap_size = 0;
+    priv->ctx.state = NULL;
+    priv->ctx.read_only_map = 0;
+    priv->ctx.map_flags = 0;
+    priv->ctx.notify_domain = NULL;
+    priv->ctx.notify_processed = 0;
+    priv->ctx.foe_job = NULL;
+    priv->ctx.foe_stream = NULL;
+    priv->ctx.emerg_eventfd = NULL;
 
     filp->private_data = priv;
 
@@ -185,14 +202,20 @@ int eccdev_release(struct inode *inode, struct file *filp)
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
     ec_master_t *master = priv->cdev->master;
 
-    if (priv->ctx.requested) {
-        ecrt_release_master(master);
+    if (priv->ctx.notify_domain) {
+        hrtimer_cancel(&priv->ctx.poll_timer);
+    }
+
+    if (priv->ctx.foe_job) {
+        ec_ioctl_foe_job_abort(master, &priv->ctx);
     }
 
-    if (priv->ctx.process_data) {
-        vfree(priv->ctx.process_data);
+    if (priv->ctx.foe_stream) {
+        ec_ioctl_foe_stream_abort(master, &priv->ctx);
     }
 
+    ec_ioctl_release(master, &priv->ctx);
+
 #if DEBUG
     EC_MASTER_DBG(master, 0, "File closed.\n");
 #endif
@@ -220,18 +243,96 @@ long eccdev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 
 /*****************************************************************************/
 
+/** Called when the cdev is polled.
+ *
+ * \return Poll mask.
+ */
+unsigned int eccdev_poll(struct file *filp, poll_table *wait)
+{
+    ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+
+    return ec_ioctl_poll(priv->cdev->master, &priv->ctx, filp, wait);
+}
+
+/*****************************************************************************/
+
+#ifdef EC_HAVE_URING_CMD
+
+/** Called when an io_uring command is issued.
+ *
+ * \return -EIOCBQUEUED, if the command completes asynchronously.
+ */
+int eccdev_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags)
+{
+    ec_cdev_priv_t *priv = (ec_cdev_priv_t *) cmd->file->private_data;
+
+    return ec_ioctl_uring_cmd(priv->cdev->master, &priv->ctx, cmd,
+            issue_flags);
+}
+
+#endif
+
+/*****************************************************************************/
+
 #ifndef VM_DONTDUMP
 /** VM_RESERVED disappeared in 3.7.
  */
 #define VM_DONTDUMP VM_RESERVED
 #endif
 
+/** Returns the page of the mapped memory at a given offset.
+ *
+ * With a read-only mapping (see ec_ioctl_map_read_only()), this is the
+ * memory of the application, that activated the master. A reference to the
+ * page is taken, so that it stays valid, even if the application frees the
+ * memory.
+ *
+ * \return Page, or NULL.
+ */
+static struct page *eccdev_get_page(
+        ec_cdev_priv_t *priv, /**< Private data structure of file handle. */
+        unsigned long offset /**< Offset in the mapped memory. */
+        )
+{
+    ec_master_t *master = priv->cdev->master;
+    uint8_t *mem = priv->ctx.process_data;
+    size_t size = priv->ctx.mmap_size;
+    uint32_t flags = priv->ctx.map_flags;
+    struct page *page = NULL;
+
+    if (priv->ctx.read_only_map) {
+        down(&master->master_sem);
+        mem = master->mapped_mem;
+        size = master->mapped_mem_size;
+        flags = master->mapped_mem_flags;
+    }
+
+    if (mem && offset < size) {
+        if (flags & EC_MAP_CONTIGUOUS) {
+            page = virt_to_page(mem + offset);
+        } else {
+            page = vmalloc_to_page(mem + offset);
+        }
+        if (page) {
+            get_page(page);
+        }
+    }
+
+    if (priv->ctx.read_only_map) {
+        up(&master->master_sem);
+    }
+
+    return page;
+}
+
+/*****************************************************************************/
+
 /** Memory-map callback for the EtherCAT character device.
  *
  * The actual mapping will be done in the eccdev_vma_nopage() callback of the
- * virtual memory area.
+ * virtual memory area, unless #EC_MAP_POPULATE was requested.
  *
- * \return Always zero (success).
+ * \return Zero on success, otherwise a negative error code.
  */
 int eccdev_mmap(
         struct file *filp,
@@ -239,13 +340,47 @@ int eccdev_mmap(
         )
 {
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    unsigned long offset, size, pos;
+    int ret;
 
     EC_MASTER_DBG(priv->cdev->master, 1, "mmap()\n");
 
+    if (priv->ctx.read_only_map) {
+        if (vma->vm_flags & VM_WRITE) {
+            return -EPERM;
+        }
+        vma->vm_flags &= ~VM_MAYWRITE;
+    }
+
     vma->vm_ops = &eccdev_vm_ops;
     vma->vm_flags |= VM_DONTDUMP; /* Pages will not be swapped out */
     vma->vm_private_data = priv;
 
+    if (!(priv->ctx.map_flags & EC_MAP_POPULATE)) {
+        return 0;
+    }
+
+    /* Map all pages now instead of on first access. */
+    offset = vma->vm_pgoff << PAGE_SHIFT;
+    size = vma->vm_end - vma->vm_start;
+    if (offset + size > priv->ctx.mmap_size) {
+        return -EINVAL;
+    }
+
+    for (pos = 0; pos < size; pos += PAGE_SIZE) {
+        struct page *page = eccdev_get_page(priv, offset + pos);
+        ret = page ? vm_insert_page(vma, vma->vm_start + pos, page)
+            : -EFAULT;
+        if (page) {
+            put_page(page); // vm_insert_page() took its own reference
+        }
+        if (ret) {
+            EC_MASTER_ERR(priv->cdev->master, "Failed to map page"
+                    " at offset %lu (code %i).\n", offset + pos, ret);
+            return ret;
+        }
+    }
+
     return 0;
 }
 
@@ -274,16 +409,11 @@ static FAULT_RETURN_TYPE eccdev_vma_fault(
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) vma->vm_private_data;
     struct page *page;
 
-    if (offset >= priv->ctx.process_data_size) {
-        return VM_FAULT_SIGBUS;
-    }
-
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
+    page = eccdev_get_page(priv, offset);
     if (!page) {
         return VM_FAULT_SIGBUS;
     }
 
-    get_page(page);
     vmf->page = page;
 
     EC_MASTER_DBG(priv->cdev->master, 1, "Vma fault,"
@@ -313,15 +443,13 @@ struct page *eccdev_vma_nopage(
 
     offset = (address - vma->vm_start) + (vma->vm_pgoff << PAGE_SHIFT);
 
-    if (offset >= priv->ctx.process_data_size)
+    page = eccdev_get_page(priv, offset);
+    if (!page)
         return NOPAGE_SIGBUS;
 
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
-
     EC_MASTER_DBG(master, 1, "Nopage fault vma, address = %#lx,"
             " offset = %#lx, page = %p\n", address, offset, page);
 
-    get_page(page);
     if (type)
         *type = VM_FAULT_MINOR;
 
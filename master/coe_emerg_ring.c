@@ -37,6 +37,7 @@
 
 #include <linux/slab.h>
 
+#include "master.h"
 #include "coe_emerg_ring.h"
 
 /*****************************************************************************/
@@ -54,6 +55,9 @@ void ec_coe_emerg_ring_init(
     ring->read_index = 0;
     ring->write_index = 0;
     ring->overruns = 0;
+    ring->pending = NULL;
+    ring->pending_summary = NULL;
+    ring->eventfd = NULL;
 }
 
 /*****************************************************************************/
@@ -71,6 +75,107 @@ void ec_coe_emerg_ring_clear(
 
 /*****************************************************************************/
 
+/** Atomically sets bits in a word of the state page.
+ */
+static void ec_coe_emerg_set_bits(
+        uint32_t *word, /**< Word. */
+        uint32_t mask /**< Bits to set. */
+        )
+{
+    uint32_t old;
+
+    do {
+        old = READ_ONCE(*word);
+        if ((old & mask) == mask) {
+            return;
+        }
+    } while (cmpxchg(word, old, old | mask) != old);
+}
+
+/*****************************************************************************/
+
+/** Atomically clears bits in a word of the state page.
+ */
+static void ec_coe_emerg_clear_bits(
+        uint32_t *word, /**< Word. */
+        uint32_t mask /**< Bits to clear. */
+        )
+{
+    uint32_t old;
+
+    do {
+        old = READ_ONCE(*word);
+        if (!(old & mask)) {
+            return;
+        }
+    } while (cmpxchg(word, old, old & ~mask) != old);
+}
+
+/*****************************************************************************/
+
+/** Marks the ring as pending in the state page.
+ *
+ * Called by the producer after a message was added.
+ */
+static void ec_coe_emerg_ring_set_pending(
+        ec_coe_emerg_ring_t *ring /**< Emergency ring. */
+        )
+{
+    uint32_t *pending = smp_load_acquire(&ring->pending);
+    unsigned int bit = ring->sc->index;
+
+    if (!pending) {
+        return;
+    }
+
+    ec_coe_emerg_set_bits(&pending[bit / 32], 1U << (bit % 32));
+    ec_coe_emerg_set_bits(ring->pending_summary, 1U << (bit / 32));
+}
+
+/*****************************************************************************/
+
+/** Withdraws the pending mark of an empty ring.
+ *
+ * Called by the consumer after a message was removed. The bits are cleared
+ * before the ring and the bitmap word are checked again, so that a message
+ * added concurrently by the producer always leaves its bits set.
+ */
+static void ec_coe_emerg_ring_update_pending(
+        ec_coe_emerg_ring_t *ring /**< Emergency ring. */
+        )
+{
+    uint32_t *pending = smp_load_acquire(&ring->pending), *word,
+             summary_mask;
+    unsigned int bit = ring->sc->index;
+
+    if (!pending || ring->read_index !=
+            smp_load_acquire(&ring->write_index)) {
+        return;
+    }
+
+    word = &pending[bit / 32];
+    summary_mask = 1U << (bit / 32);
+
+    ec_coe_emerg_clear_bits(word, 1U << (bit % 32));
+    smp_mb();
+    if (ring->read_index != READ_ONCE(ring->write_index)) {
+        ec_coe_emerg_ring_set_pending(ring);
+        return;
+    }
+
+    if (READ_ONCE(*word)) {
+        return;
+    }
+
+    ec_coe_emerg_clear_bits(ring->pending_summary, summary_mask);
+    smp_mb();
+    if (READ_ONCE(*word)) {
+        ec_coe_emerg_set_bits(ring->pending_summary, summary_mask);
+    }
+}
+
+/*****************************************************************************/
+
 /** Set the ring size.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -87,6 +192,7 @@ int ec_coe_emerg_ring_size(
     }
 
     ring->read_index = ring->write_index = 0;
+    ec_coe_emerg_ring_update_pending(ring);
 
     if (ring->msgs) {
         kfree(ring->msgs);
@@ -109,26 +215,40 @@ int ec_coe_emerg_ring_size(
 /*****************************************************************************/
 
 /** Add a new emergency message.
+ *
+ * Called by the producer, i. e. the slave state machines.
  */
 void ec_coe_emerg_ring_push(
         ec_coe_emerg_ring_t *ring, /**< Emergency ring. */
         const u8 *msg /**< Emergency message. */
         )
 {
-    if (!ring->size ||
-            (ring->write_index + 1) % (ring->size + 1) == ring->read_index) {
+    unsigned int next;
+
+    if (!ring->size) {
+        ring->overruns++;
+        return;
+    }
+
+    next = (ring->write_index + 1) % (ring->size + 1);
+    if (next == smp_load_acquire(&ring->read_index)) {
         ring->overruns++;
         return;
     }
 
     memcpy(ring->msgs[ring->write_index].data, msg,
             EC_COE_EMERGENCY_MSG_SIZE);
-    ring->write_index = (ring->write_index + 1) % (ring->size + 1);
+    smp_store_release(&ring->write_index, next);
+
+    ec_coe_emerg_ring_set_pending(ring);
+    ec_request_eventfd_signal(READ_ONCE(ring->eventfd));
 }
 
 /*****************************************************************************/
 
 /** Remove an emergency message from the ring.
+ *
+ * Called by the consumer, i. e. the application.
  *
  * \return Zero on success, otherwise a negative error code.
  */
@@ -137,12 +257,14 @@ int ec_coe_emerg_ring_pop(
         u8 *msg /**< Memory to store the emergency message. */
         )
 {
-    if (ring->read_index == ring->write_index) {
+    if (ring->read_index == smp_load_acquire(&ring->write_index)) {
         return -ENOENT;
     }
 
     memcpy(msg, ring->msgs[ring->read_index].data, EC_COE_EMERGENCY_MSG_SIZE);
-    ring->read_index = (ring->read_index + 1) % (ring->size + 1);
+    smp_store_release(&ring->read_index,
+            (ring->read_index + 1) % (ring->size + 1));
+    ec_coe_emerg_ring_update_pending(ring);
     return 0;
 }
 
@@ -156,8 +278,10 @@ int ec_coe_emerg_ring_clear_ring(
         ec_coe_emerg_ring_t *ring /**< Emergency ring. */
         )
 {
-    ring->read_index = ring->write_index;
+    smp_store_release(&ring->read_index,
+            smp_load_acquire(&ring->write_index));
     ring->overruns = 0;
+    ec_coe_emerg_ring_update_pending(ring);
     return 0;
 }
 
@@ -175,3 +299,29 @@ int ec_coe_emerg_ring_overruns(
 }
 
 /*****************************************************************************/
+
+/*****************************************************************************/
+
+/** Attaches the ring to the emergency pending bitmap of a state page and to
+ * an eventfd.
+ *
+ * Has to be called with the master semaphore held, so that the producer does
+ * not use the previous bitmap and eventfd any more.
+ */
+void ec_coe_emerg_ring_attach(
+        ec_coe_emerg_ring_t *ring, /**< Emergency ring. */
+        uint32_t *pending, /**< Emergency pending bitmap, or NULL. */
+        uint32_t *summary, /**< Summary word of \a pending. */
+        struct eventfd_ctx *eventfd /**< Eventfd, or NULL. */
+        )
+{
+    ring->pending_summary = summary;
+    smp_store_release(&ring->pending, pending);
+    WRITE_ONCE(ring->eventfd, eventfd);
+
+    if (pending && ring->read_index != smp_load_acquire(&ring->write_index)) {
+        ec_coe_emerg_ring_set_pending(ring);
+    }
+}
+
+/*****************************************************************************/
@@ -50,6 +50,15 @@ typedef struct {
 /*****************************************************************************/
 
 /** EtherCAT CoE emergency ring buffer.
+ *
+ * The ring is filled by the slave state machines in the master thread and
+ * emptied by the application. As there is a single producer and a single
+ * consumer, the indices are exchanged with acquire/release semantics and no
+ * lock is needed.
+ *
+ * For userspace applications, the ring additionally maintains the bit of its
+ * slave configuration in the emergency pending bitmap of the state page,
+ * that is set as long as the ring is not empty.
  */
 typedef struct {
     ec_slave_config_t *sc; /**< Slave configuration  owning the ring. */
@@ -57,9 +66,14 @@ typedef struct {
     ec_coe_emerg_msg_t *msgs; /**< Message ring. */
     size_t size; /**< Ring size. */
 
-    unsigned int read_index; /**< Read index. */
-    unsigned int write_index; /**< Write index. */
+    unsigned int read_index; /**< Read index (written by the consumer). */
+    unsigned int write_index; /**< Write index (written by the producer). */
     unsigned int overruns; /**< Number of overruns since last reset. */
+
+    uint32_t *pending; /**< Emergency pending bitmap, or NULL. */
+    uint32_t *pending_summary; /**< Summary word of \a pending. */
+    struct eventfd_ctx *eventfd; /**< Eventfd signalled on each message, or
+                                   NULL. */
 } ec_coe_emerg_ring_t;
 
 /*****************************************************************************/
@@ -72,6 +86,8 @@ void ec_coe_emerg_ring_push(ec_coe_emerg_ring_t *, const u8 *);
 int ec_coe_emerg_ring_pop(ec_coe_emerg_ring_t *, u8 *);
 int ec_coe_emerg_ring_clear_ring(ec_coe_emerg_ring_t *);
 int ec_coe_emerg_ring_overruns(ec_coe_emerg_ring_t *);
+void ec_coe_emerg_ring_attach(ec_coe_emerg_ring_t *, uint32_t *, uint32_t *,
+        struct eventfd_ctx *);
 
 /*****************************************************************************/
 
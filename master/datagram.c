@@ -38,6 +38,7 @@
 
 #include "datagram.h"
 #include "master.h"
+#include "payload.h"
 
 /*****************************************************************************/
 
@@ -88,26 +89,38 @@ static const char *type_strings[] = {
 void ec_datagram_init(ec_datagram_t *datagram /**< EtherCAT datagram. */)
 {
     INIT_LIST_HEAD(&datagram->queue); // mark as unqueued
+    INIT_LIST_HEAD(&datagram->sent);
+    datagram->sent_slot = NULL;
     datagram->device_index = EC_DEVICE_MAIN;
+    datagram->rx_device_index = EC_DEVICE_MAIN;
     datagram->type = EC_DATAGRAM_NONE;
     memset(datagram->address, 0x00, EC_ADDR_LEN);
     datagram->data = NULL;
     datagram->data_origin = EC_ORIG_INTERNAL;
+    datagram->tx_data = NULL;
     datagram->mem_size = 0;
     datagram->data_size = 0;
     datagram->index = 0x00;
     datagram->working_counter = 0x0000;
     datagram->state = EC_DATAGRAM_INIT;
+    datagram->traffic_class = EC_TC_CYCLIC;
 #ifdef EC_HAVE_CYCLES
     datagram->cycles_sent = 0;
 #endif
     datagram->jiffies_sent = 0;
+    datagram->timeout = ktime_set(0, EC_IO_TIMEOUT * NSEC_PER_USEC);
+    datagram->deadline = ktime_set(0, 0);
 #ifdef EC_HAVE_CYCLES
     datagram->cycles_received = 0;
 #endif
     datagram->jiffies_received = 0;
+    datagram->tx_slot = 0;
+    datagram->hw_time_sent = 0;
+    datagram->hw_time_received = 0;
     datagram->skip_count = 0;
+    datagram->queued_size = 0;
     datagram->stats_output_jiffies = 0;
+    memset(&datagram->stats, 0, sizeof(datagram->stats));
     memset(datagram->name, 0x00, EC_DATAGRAM_NAME_SIZE);
 }
 
@@ -120,7 +133,7 @@ void ec_datagram_clear(ec_datagram_t *datagram /**< EtherCAT datagram. */)
     ec_datagram_unqueue(datagram);
 
     if (datagram->data_origin == EC_ORIG_INTERNAL && datagram->data) {
-        kfree(datagram->data);
+        ec_payload_free(datagram->data, datagram->mem_size);
         datagram->data = NULL;
     }
 }
@@ -134,6 +147,30 @@ void ec_datagram_unqueue(ec_datagram_t *datagram /**< EtherCAT datagram. */)
     if (!list_empty(&datagram->queue)) {
         list_del_init(&datagram->queue);
     }
+    if (!list_empty(&datagram->sent)) {
+        list_del_init(&datagram->sent);
+    }
+
+    ec_datagram_release_slot(datagram);
+}
+
+/*****************************************************************************/
+
+/** Removes the datagram from the master's table of sent datagrams.
+ *
+ * This has to be called every time a datagram is matched, unqueued or
+ * cleared, so that a late frame can not reference it any more. Timed out
+ * datagrams keep their entry until the index is reused, so that late
+ * responses can be accounted to them.
+ */
+void ec_datagram_release_slot(
+        ec_datagram_t *datagram /**< EtherCAT datagram. */
+        )
+{
+    if (datagram->sent_slot) {
+        *datagram->sent_slot = NULL;
+        datagram->sent_slot = NULL;
+    }
 }
 
 /*****************************************************************************/
@@ -157,17 +194,18 @@ int ec_datagram_prealloc(
         return 0;
 
     if (datagram->data) {
-        kfree(datagram->data);
+        ec_payload_free(datagram->data, datagram->mem_size);
         datagram->data = NULL;
         datagram->mem_size = 0;
     }
 
-    if (!(datagram->data = kmalloc(size, GFP_KERNEL))) {
+    // pooled payloads have the maximum size, so they never have to grow
+    if (!(datagram->data = ec_payload_alloc(size, &datagram->mem_size))) {
         EC_ERR("Failed to allocate %zu bytes of datagram memory!\n", size);
+        datagram->mem_size = 0;
         return -ENOMEM;
     }
 
-    datagram->mem_size = size;
     return 0;
 }
 
@@ -182,6 +220,41 @@ void ec_datagram_zero(ec_datagram_t *datagram /**< EtherCAT datagram. */)
 
 /*****************************************************************************/
 
+/** Continues a datagram in another datagram object.
+ *
+ * Copies header, payload and reception result of \a source, so that a state
+ * machine written for a single persistent datagram can evaluate the result
+ * and send the datagram again, while using a new datagram every cycle.
+ *
+ * \return Return value of ec_datagram_prealloc().
+ */
+int ec_datagram_repeat(
+        ec_datagram_t *datagram, /**< EtherCAT datagram. */
+        const ec_datagram_t *source /**< Datagram to continue. */
+        )
+{
+    int ret;
+
+    ret = ec_datagram_prealloc(datagram, source->data_size);
+    if (unlikely(ret)) {
+        return ret;
+    }
+
+    datagram->type = source->type;
+    memcpy(datagram->address, source->address, EC_ADDR_LEN);
+    memcpy(datagram->data, source->data, source->data_size);
+    datagram->data_size = source->data_size;
+    datagram->device_index = source->device_index;
+    datagram->index = 0;
+    datagram->working_counter = source->working_counter;
+    datagram->state = source->state;
+    datagram->jiffies_sent = source->jiffies_sent;
+    datagram->jiffies_received = source->jiffies_received;
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Initializes an EtherCAT APRD datagram.
  *
  * \return Return value of ec_datagram_prealloc().
@@ -635,6 +708,74 @@ void ec_datagram_output_stats(
 
 /*****************************************************************************/
 
+/** Returns the round trip time of a received datagram in clock ticks.
+ */
+static u32 ec_datagram_round_trip_ticks(
+        const ec_datagram_t *datagram /**< Received datagram. */
+        )
+{
+#ifdef EC_HAVE_CYCLES
+    return (u32) (datagram->cycles_received - datagram->cycles_sent);
+#else
+    return (u32) (datagram->jiffies_received - datagram->jiffies_sent);
+#endif
+}
+
+/*****************************************************************************/
+
+/** Records the reception of a datagram in its statistics.
+ *
+ * This is called in the realtime context, so no conversion is done here.
+ */
+void ec_datagram_stats_received(
+        ec_datagram_t *datagram /**< Received datagram. */
+        )
+{
+    ec_datagram_stats_t *stats = &datagram->stats;
+    u32 rtt = ec_datagram_round_trip_ticks(datagram);
+
+    if (!stats->received || rtt < stats->rtt_min) {
+        stats->rtt_min = rtt;
+    }
+    if (rtt > stats->rtt_max) {
+        stats->rtt_max = rtt;
+    }
+    stats->rtt_sum += rtt;
+    stats->received++;
+}
+
+/*****************************************************************************/
+
+/** Returns the round trip time of a received datagram.
+ *
+ * \return Round trip time in ns.
+ */
+u32 ec_datagram_round_trip_time(
+        const ec_datagram_t *datagram /**< Received datagram. */
+        )
+{
+    return ec_datagram_ticks_to_ns(ec_datagram_round_trip_ticks(datagram));
+}
+
+/*****************************************************************************/
+
+/** Converts a time in clock ticks (CPU cycles or jiffies) to nanoseconds.
+ *
+ * \return Time in ns.
+ */
+u32 ec_datagram_ticks_to_ns(
+        u64 ticks /**< Time in clock ticks. */
+        )
+{
+#ifdef EC_HAVE_CYCLES
+    return (u32) (ticks * 1000000 / cpu_khz);
+#else
+    return (u32) (ticks * (1000000000 / HZ));
+#endif
+}
+
+/*****************************************************************************/
+
 /** Returns a string describing the datagram type.
  *
  * \return Pointer on a static memory containing the requested string.
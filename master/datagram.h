@@ -39,12 +39,21 @@
 
 #include <linux/list.h>
 #include <linux/time.h>
+#include <linux/ktime.h>
 #include <linux/timex.h>
 
 #include "globals.h"
 
 /*****************************************************************************/
 
+/** Number of distinct datagram indices.
+ *
+ * The datagram index is an 8-bit field in the datagram header.
+ */
+#define EC_DATAGRAM_INDEX_COUNT 256
+
+/*****************************************************************************/
+
 /** EtherCAT datagram type.
  */
 typedef enum {
@@ -82,33 +91,79 @@ typedef enum {
 
 /*****************************************************************************/
 
-/** EtherCAT datagram.
+/** EtherCAT datagram statistics.
+ *
+ * Round trip times are recorded in raw clock ticks (CPU cycles or jiffies)
+ * to keep the realtime path cheap, see ec_datagram_ticks_to_ns().
  */
 typedef struct {
+    u64 received; /**< Number of receptions. */
+    u64 rtt_sum; /**< Sum of all round trip times. */
+    u32 rtt_min; /**< Minimum round trip time. */
+    u32 rtt_max; /**< Maximum round trip time. */
+    u32 timeouts; /**< Number of timeouts. */
+    u32 late; /**< Number of responses that arrived after a timeout. */
+    u32 late_max; /**< Maximum lateness after the timeout in us. */
+    u32 skips; /**< Number of requeues when not yet received. */
+} ec_datagram_stats_t;
+
+/*****************************************************************************/
+
+/** EtherCAT datagram.
+ *
+ * The send and receive paths touch many datagrams per cycle, so the members
+ * they need for every datagram come first and fit into one cache line (on
+ * 64 bit architectures). Timing members follow, bookkeeping and statistics
+ * members are at the end.
+ */
+typedef struct ec_datagram {
+    // frame assembly and response matching
     struct list_head queue; /**< Master datagram queue item. */
-    struct list_head sent; /**< Master list item for sent datagrams. */
-    ec_device_index_t device_index; /**< Device via which the datagram shall
-                                      be / was sent. */
-    ec_datagram_type_t type; /**< Datagram type (APRD, BWR, etc.). */
-    uint8_t address[EC_ADDR_LEN]; /**< Recipient address. */
+    struct list_head sent; /**< Device list item for sent datagrams. */
     uint8_t *data; /**< Datagram payload. */
-    ec_origin_t data_origin; /**< Origin of the \a data memory. */
-    size_t mem_size; /**< Datagram \a data memory size. */
     size_t data_size; /**< Size of the data in \a data. */
+    ec_datagram_type_t type; /**< Datagram type (APRD, BWR, etc.). */
+    uint8_t address[EC_ADDR_LEN]; /**< Recipient address. */
     uint8_t index; /**< Index (set by master). */
     uint16_t working_counter; /**< Working counter. */
     ec_datagram_state_t state; /**< State. */
+
+    // sending and timing
+    const uint8_t *tx_data; /**< Payload to send instead of \a data, or
+                              NULL. */
+    struct ec_datagram **sent_slot; /**< Entry in the master's table of sent
+                                      datagrams, or NULL. */
+    ec_device_index_t device_index; /**< Device via which the datagram shall
+                                      be / was sent. */
+    ec_device_index_t rx_device_index; /**< Device via which the datagram was
+                                         received. */
+    ec_traffic_class_t traffic_class; /**< Traffic class. */
+    unsigned int tx_slot; /**< Transmit ring entry of the device, that
+                            carried the datagram. */
 #ifdef EC_HAVE_CYCLES
     cycles_t cycles_sent; /**< Time, when the datagram was sent. */
 #endif
     unsigned long jiffies_sent; /**< Jiffies, when the datagram was sent. */
+    ktime_t timeout; /**< Time to wait for the reception after sending. */
+    ktime_t deadline; /**< Time, when the sent datagram times out. */
 #ifdef EC_HAVE_CYCLES
     cycles_t cycles_received; /**< Time, when the datagram was received. */
 #endif
     unsigned long jiffies_received; /**< Jiffies, when the datagram was
                                       received. */
+    u64 hw_time_sent; /**< Hardware time stamp of the transmission in ns,
+                        or zero. */
+    u64 hw_time_received; /**< Hardware time stamp of the reception in ns,
+                            or zero. */
+    size_t queued_size; /**< Payload bytes accounted in the master's
+                          \a queued_bytes, or zero. */
+
+    // memory management and statistics
+    ec_origin_t data_origin; /**< Origin of the \a data memory. */
+    size_t mem_size; /**< Datagram \a data memory size. */
     unsigned int skip_count; /**< Number of requeues when not yet received. */
     unsigned long stats_output_jiffies; /**< Last statistics output. */
+    ec_datagram_stats_t stats; /**< Round trip and loss statistics. */
     char name[EC_DATAGRAM_NAME_SIZE]; /**< Description of the datagram. */
 } ec_datagram_t;
 
@@ -117,8 +172,10 @@ typedef struct {
 void ec_datagram_init(ec_datagram_t *);
 void ec_datagram_clear(ec_datagram_t *);
 void ec_datagram_unqueue(ec_datagram_t *);
+void ec_datagram_release_slot(ec_datagram_t *);
 int ec_datagram_prealloc(ec_datagram_t *, size_t);
 void ec_datagram_zero(ec_datagram_t *);
+int ec_datagram_repeat(ec_datagram_t *, const ec_datagram_t *);
 
 int ec_datagram_aprd(ec_datagram_t *, uint16_t, uint16_t, size_t);
 int ec_datagram_apwr(ec_datagram_t *, uint16_t, uint16_t, size_t);
@@ -141,6 +198,9 @@ int ec_datagram_lrw_ext(ec_datagram_t *, uint32_t, size_t, uint8_t *);
 void ec_datagram_print_state(const ec_datagram_t *);
 void ec_datagram_print_wc_error(const ec_datagram_t *);
 void ec_datagram_output_stats(ec_datagram_t *);
+void ec_datagram_stats_received(ec_datagram_t *);
+u32 ec_datagram_round_trip_time(const ec_datagram_t *);
+u32 ec_datagram_ticks_to_ns(u64);
 const char *ec_datagram_type_string(const ec_datagram_t *);
 
 /*****************************************************************************/
@@ -59,6 +59,10 @@ int ec_datagram_pair_init(
 
     INIT_LIST_HEAD(&pair->list);
     pair->domain = domain;
+#if EC_MAX_NUM_DEVICES > 1
+    pair->inputs = NULL;
+    pair->input_count = 0;
+#endif
 
     for (dev_idx = EC_DEVICE_MAIN;
             dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
@@ -70,6 +74,8 @@ int ec_datagram_pair_init(
     }
 
     pair->expected_working_counter = 0U;
+    pair->pipeline_slot = 0;
+    pair->input_phase = 0;
 
     for (dev_idx = EC_DEVICE_BACKUP;
             dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
@@ -81,7 +87,8 @@ int ec_datagram_pair_init(
     }
 
 #if EC_MAX_NUM_DEVICES > 1
-    if (!(pair->send_buffer = kmalloc(data_size, GFP_KERNEL))) {
+    if (!(pair->send_buffer = kmalloc_node(data_size, GFP_KERNEL,
+                    ec_master_node(domain->master)))) {
         EC_MASTER_ERR(domain->master,
                 "Failed to allocate domain send buffer!\n");
         ret = -ENOMEM;
@@ -128,6 +135,15 @@ int ec_datagram_pair_init(
         pair->expected_working_counter = used[EC_DIR_INPUT];
     }
 
+#if EC_MAX_NUM_DEVICES > 1
+    /* backup datagrams send the copy of the main data taken by
+     * ecrt_domain_queue(), their own memory only takes the responses. */
+    for (dev_idx = EC_DEVICE_BACKUP;
+            dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+        pair->datagrams[dev_idx].tx_data = pair->send_buffer;
+    }
+#endif
+
     for (dev_idx = EC_DEVICE_MAIN;
             dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
         ec_datagram_zero(&pair->datagrams[dev_idx]);
@@ -164,6 +180,9 @@ void ec_datagram_pair_clear(
     if (pair->send_buffer) {
         kfree(pair->send_buffer);
     }
+    if (pair->inputs) {
+        kfree(pair->inputs);
+    }
 #endif
 }
 
@@ -44,6 +44,19 @@
 
 /*****************************************************************************/
 
+#if EC_MAX_NUM_DEVICES > 1
+
+/** Input FMMU data range of a datagram pair.
+ */
+typedef struct {
+    uint16_t offset; /**< Offset in the datagram data. */
+    uint16_t size; /**< Size of the input data. */
+} ec_datagram_pair_input_t;
+
+#endif
+
+/*****************************************************************************/
+
 /** Domain datagram pair.
  */
 typedef struct {
@@ -52,8 +65,15 @@ typedef struct {
     ec_datagram_t datagrams[EC_MAX_NUM_DEVICES]; /**< Datagrams.  */
 #if EC_MAX_NUM_DEVICES > 1
     uint8_t *send_buffer;
+    ec_datagram_pair_input_t *inputs; /**< Input data ranges, for the
+                                        redundancy processing. */
+    unsigned int input_count; /**< Number of \a inputs. */
 #endif
     unsigned int expected_working_counter; /**< Expectord working conter. */
+    unsigned int pipeline_slot; /**< Pipeline slot the pair belongs to. */
+    uint8_t input_phase; /**< The pair carries the inputs of a domain with
+                           split inputs and outputs, see
+                           ecrt_domain_queue_inputs(). */
 } ec_datagram_pair_t;
 
 /*****************************************************************************/
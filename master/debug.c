@@ -37,9 +37,12 @@
 #include <linux/version.h>
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
+#include <linux/if_vlan.h>
+#include <linux/vmalloc.h>
 
 #include "globals.h"
 #include "master.h"
+#include "datagram.h"
 #include "debug.h"
 
 /*****************************************************************************/
@@ -80,13 +83,26 @@ int ec_debug_init(
     dbg->device = device;
     dbg->registered = 0;
     dbg->opened = 0;
+    dbg->sample_count[0] = 0;
+    dbg->sample_count[1] = 0;
+    dbg->queue_write = 0;
+    dbg->queue_read = 0;
 
     memset(&dbg->stats, 0, sizeof(struct net_device_stats));
 
+    if (!(dbg->queue = vmalloc(
+                    EC_DEBUG_QUEUE_SIZE * sizeof(ec_debug_queued_frame_t)))) {
+        EC_MASTER_ERR(device->master, "Failed to allocate debug frame"
+                " queue!\n");
+        return -ENOMEM;
+    }
+
     if (!(dbg->dev =
           alloc_netdev(sizeof(ec_debug_t *), name, ether_setup))) {
         EC_MASTER_ERR(device->master, "Unable to allocate net_device"
                 " for debug object!\n");
+        vfree(dbg->queue);
+        dbg->queue = NULL;
         return -ENODEV;
     }
 
@@ -118,6 +134,8 @@ void ec_debug_clear(
 {
     ec_debug_unregister(dbg);
     free_netdev(dbg->dev);
+    vfree(dbg->queue);
+    dbg->queue = NULL;
 }
 
 /*****************************************************************************/
@@ -162,37 +180,144 @@ void ec_debug_unregister(
 
 /*****************************************************************************/
 
+/** Checks, if a frame contains non-logical datagrams.
+ *
+ * Process data is exchanged via logical datagrams only, so any other
+ * datagram marks the frame as acyclic (mailbox, register or state machine)
+ * traffic.
+ *
+ * \return Non-zero, if the frame shall pass the acyclic filter.
+ */
+static int ec_debug_frame_is_acyclic(
+        const uint8_t *data, /**< Frame data (including Ethernet header). */
+        size_t size /**< Size of the frame data. */
+        )
+{
+    const uint8_t *cur, *end = data + size;
+    size_t header_size = ETH_HLEN;
+    uint16_t len_field;
+
+    if (size >= VLAN_ETH_HLEN
+            && ((data[12] << 8) | data[13]) == ETH_P_8021Q) {
+        header_size = VLAN_ETH_HLEN; // skip the IEEE 802.1Q tag
+    }
+
+    if (size < header_size + EC_FRAME_HEADER_SIZE
+            || ((data[header_size - 2] << 8) | data[header_size - 1])
+            != ETH_P_ETHERCAT) {
+        return 1; // not an EtherCAT frame; always interesting
+    }
+    cur = data + header_size + EC_FRAME_HEADER_SIZE;
+
+    while (cur + EC_DATAGRAM_HEADER_SIZE <= end) {
+        if (cur[0] < EC_DATAGRAM_LRD || cur[0] > EC_DATAGRAM_LRW) {
+            return 1;
+        }
+
+        len_field = EC_READ_U16(cur + 6);
+        if (!(len_field & 0x8000)) { // no more datagrams
+            break;
+        }
+
+        cur += EC_DATAGRAM_HEADER_SIZE + (len_field & 0x07FF)
+            + EC_DATAGRAM_FOOTER_SIZE;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Sends frame data to the interface.
+ *
+ * This is called from the sending and receiving context (which may be the
+ * application's realtime context). The frame is only copied into a
+ * pre-allocated queue here, if it passes the sampling rate (\a debug_sample
+ * module parameter) and the filter (\a debug_filter). Passing it to the
+ * network stack is deferred to ec_debug_flush().
  */
 void ec_debug_send(
         ec_debug_t *dbg, /**< debug object */
+        unsigned int dir, /**< Direction (0 = TX, 1 = RX). */
         const uint8_t *data, /**< frame data */
         size_t size /**< size of the frame data */
         )
 {
-    struct sk_buff *skb;
+    ec_debug_queued_frame_t *frame;
+    unsigned int next;
 
     if (!dbg->opened)
         return;
 
-    // allocate socket buffer
-    if (!(skb = dev_alloc_skb(size))) {
+    if (ec_debug_sample > 1) {
+        if (++dbg->sample_count[dir] < ec_debug_sample) {
+            return;
+        }
+        dbg->sample_count[dir] = 0;
+    }
+
+    if ((ec_debug_filter & EC_DEBUG_FILTER_ACYCLIC)
+            && !ec_debug_frame_is_acyclic(data, size)) {
+        return;
+    }
+
+    next = (dbg->queue_write + 1) % EC_DEBUG_QUEUE_SIZE;
+    if (next == dbg->queue_read) { // queue full
         dbg->stats.rx_dropped++;
         return;
     }
 
-    // copy frame contents into socket buffer
-    memcpy(skb_put(skb, size), data, size);
+    if (size > ETH_FRAME_LEN) {
+        size = ETH_FRAME_LEN;
+    }
+
+    frame = &dbg->queue[dbg->queue_write];
+    memcpy(frame->data, data, size);
+    frame->size = size;
+    smp_wmb(); // complete the frame before publishing it
+    dbg->queue_write = next;
+}
+
+/*****************************************************************************/
 
-    // update device statistics
-    dbg->stats.rx_packets++;
-    dbg->stats.rx_bytes += size;
+/** Passes queued frames to the network stack.
+ *
+ * Has to be called from a non-realtime context, i. e. the master's idle or
+ * operation thread.
+ */
+void ec_debug_flush(
+        ec_debug_t *dbg /**< debug object */
+        )
+{
+    const ec_debug_queued_frame_t *frame;
+    struct sk_buff *skb;
 
-    // pass socket buffer to network stack
-    skb->dev = dbg->dev;
-    skb->protocol = eth_type_trans(skb, dbg->dev);
-    skb->ip_summed = CHECKSUM_UNNECESSARY;
-    netif_rx(skb);
+    while (dbg->queue_read != dbg->queue_write) {
+        smp_rmb(); // read the frame after its index
+        frame = &dbg->queue[dbg->queue_read];
+
+        if (!dbg->opened) {
+            // discard
+        } else if (!(skb = dev_alloc_skb(frame->size))) {
+            dbg->stats.rx_dropped++;
+        } else {
+            // copy frame contents into socket buffer
+            memcpy(skb_put(skb, frame->size), frame->data, frame->size);
+
+            // update device statistics
+            dbg->stats.rx_packets++;
+            dbg->stats.rx_bytes += frame->size;
+
+            // pass socket buffer to network stack
+            skb->dev = dbg->dev;
+            skb->protocol = eth_type_trans(skb, dbg->dev);
+            skb->ip_summed = CHECKSUM_UNNECESSARY;
+            netif_rx(skb);
+        }
+
+        smp_mb(); // finish reading the frame before releasing the slot
+        dbg->queue_read = (dbg->queue_read + 1) % EC_DEBUG_QUEUE_SIZE;
+    }
 }
 
 /******************************************************************************
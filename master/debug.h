@@ -37,10 +37,29 @@
 #ifndef __EC_DEBUG_H__
 #define __EC_DEBUG_H__
 
+#include <linux/if_ether.h>
+
 #include "../devices/ecdev.h"
 
 /*****************************************************************************/
 
+/** Number of frames that can be queued for the debug interface between two
+ * flushes.
+ */
+#define EC_DEBUG_QUEUE_SIZE 64
+
+/** Debug filter flag: Only mirror frames that contain at least one
+ * non-logical (i. e. acyclic or mailbox) datagram.
+ */
+#define EC_DEBUG_FILTER_ACYCLIC 0x01
+
+/** Frame queued for the debug interface.
+ */
+typedef struct {
+    size_t size; /**< Frame size. */
+    uint8_t data[ETH_FRAME_LEN]; /**< Frame data. */
+} ec_debug_queued_frame_t;
+
 /** Debugging network interface.
  */
 typedef struct
@@ -50,6 +69,12 @@ typedef struct
     struct net_device_stats stats; /**< device statistics */
     uint8_t registered; /**< net_device is opened */
     uint8_t opened; /**< net_device is opened */
+    unsigned int sample_count[2]; /**< Frames since the last sampled one,
+                                    per direction (0 = TX, 1 = RX). */
+    ec_debug_queued_frame_t *queue; /**< Frames waiting to be passed to the
+                                      network stack. */
+    unsigned int queue_write; /**< Queue write index (RT context). */
+    unsigned int queue_read; /**< Queue read index (flush context). */
 }
 ec_debug_t;
 
@@ -59,7 +84,8 @@ int ec_debug_init(ec_debug_t *, ec_device_t *, const char *);
 void ec_debug_clear(ec_debug_t *);
 void ec_debug_register(ec_debug_t *, const struct net_device *);
 void ec_debug_unregister(ec_debug_t *);
-void ec_debug_send(ec_debug_t *, const uint8_t *, size_t);
+void ec_debug_send(ec_debug_t *, unsigned int, const uint8_t *, size_t);
+void ec_debug_flush(ec_debug_t *);
 
 #endif
 
@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Debugfs interface of the masters.
+
+   Every master gets a directory ethercat/master<index>/ with a 'counters'
+   file, that lists its performance counters as 'name value' lines.
+*/
+
+/*****************************************************************************/
+
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/err.h>
+
+#include "master.h"
+#include "debugfs.h"
+
+/*****************************************************************************/
+
+static struct dentry *ec_debugfs_root; /**< Root directory, or NULL. */
+
+/*****************************************************************************/
+
+/** Outputs the performance counters of a master.
+ *
+ * \return Always zero.
+ */
+static int ec_debugfs_counters_show(
+        struct seq_file *s, /**< Sequential file. */
+        void *unused /**< Unused. */
+        )
+{
+    ec_master_t *master = s->private;
+    ec_master_counters_t *counters = &master->counters;
+    ec_cycle_counters_t cycle;
+    ec_fsm_counters_t fsm;
+    ec_eoe_counters_t eoe;
+    unsigned int seq;
+
+    do {
+        seq = read_seqcount_begin(&counters->cycle_seq);
+        cycle = counters->cycle;
+    } while (read_seqcount_retry(&counters->cycle_seq, seq));
+
+    do {
+        seq = read_seqcount_begin(&counters->fsm_seq);
+        fsm = counters->fsm;
+    } while (read_seqcount_retry(&counters->fsm_seq, seq));
+
+    do {
+        seq = read_seqcount_begin(&counters->eoe_seq);
+        eoe = counters->eoe;
+    } while (read_seqcount_retry(&counters->eoe_seq, seq));
+
+    seq_printf(s, "cycles %llu\n", (unsigned long long) cycle.cycles);
+    seq_printf(s, "frames_per_cycle %u\n", cycle.frames);
+    seq_printf(s, "frames_per_cycle_max %u\n", cycle.frames_max);
+    seq_printf(s, "bytes_per_cycle %u\n", cycle.bytes);
+    seq_printf(s, "bytes_per_cycle_max %u\n", cycle.bytes_max);
+    seq_printf(s, "queue_depth %u\n", cycle.queued);
+    seq_printf(s, "queue_depth_max %u\n", cycle.queued_max);
+    seq_printf(s, "ext_injected %llu\n",
+            (unsigned long long) cycle.injected);
+    seq_printf(s, "ext_deferred %llu\n",
+            (unsigned long long) cycle.deferred);
+    seq_printf(s, "fsm_exec_count %llu\n",
+            (unsigned long long) fsm.exec_count);
+    seq_printf(s, "fsm_exec_time_ns %u\n", fsm.exec_time);
+    seq_printf(s, "fsm_exec_time_max_ns %u\n", fsm.exec_time_max);
+    seq_printf(s, "eoe_handlers %u\n", eoe.handlers);
+    seq_printf(s, "eoe_rx_bytes_per_second %u\n", eoe.rx_rate);
+    seq_printf(s, "eoe_tx_bytes_per_second %u\n", eoe.tx_rate);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Opens the counters file.
+ */
+static int ec_debugfs_counters_open(
+        struct inode *inode, /**< Inode. */
+        struct file *file /**< File. */
+        )
+{
+    return single_open(file, ec_debugfs_counters_show, inode->i_private);
+}
+
+/*****************************************************************************/
+
+/** File operations of the counters file.
+ */
+static const struct file_operations ec_debugfs_counters_fops = {
+    .owner = THIS_MODULE,
+    .open = ec_debugfs_counters_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/*****************************************************************************/
+
+/** Creates the debugfs root directory.
+ *
+ * The debugfs interface is optional, so errors are not fatal.
+ */
+void ec_debugfs_init_module(void)
+{
+    ec_debugfs_root = debugfs_create_dir("ethercat", NULL);
+    if (IS_ERR(ec_debugfs_root)) {
+        ec_debugfs_root = NULL;
+    }
+}
+
+/*****************************************************************************/
+
+/** Removes the debugfs root directory.
+ */
+void ec_debugfs_cleanup_module(void)
+{
+    if (ec_debugfs_root) {
+        debugfs_remove_recursive(ec_debugfs_root);
+        ec_debugfs_root = NULL;
+    }
+}
+
+/*****************************************************************************/
+
+/** Creates the debugfs directory of a master.
+ */
+void ec_debugfs_master_init(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    char name[16];
+
+    master->debugfs_dir = NULL;
+
+    if (!ec_debugfs_root) {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "master%u", master->index);
+    master->debugfs_dir = debugfs_create_dir(name, ec_debugfs_root);
+    if (IS_ERR_OR_NULL(master->debugfs_dir)) {
+        EC_MASTER_WARN(master, "Failed to create debugfs directory.\n");
+        master->debugfs_dir = NULL;
+        return;
+    }
+
+    debugfs_create_file("counters", S_IRUGO, master->debugfs_dir, master,
+            &ec_debugfs_counters_fops);
+}
+
+/*****************************************************************************/
+
+/** Removes the debugfs directory of a master.
+ */
+void ec_debugfs_master_clear(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    if (master->debugfs_dir) {
+        debugfs_remove_recursive(master->debugfs_dir);
+        master->debugfs_dir = NULL;
+    }
+}
+
+/*****************************************************************************/
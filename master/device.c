@@ -37,6 +37,7 @@
 #include <linux/module.h>
 #include <linux/skbuff.h>
 #include <linux/if_ether.h>
+#include <linux/if_vlan.h>
 #include <linux/netdevice.h>
 
 #include "device.h"
@@ -56,18 +57,51 @@
 
 /*****************************************************************************/
 
+/** Writes the Ethernet header of a transmit socket buffer.
+ *
+ * Frames are sent to the broadcast address. If a VLAN tag is configured,
+ * the EtherCAT EtherType follows the IEEE 802.1Q tag.
+ */
+static void ec_device_write_header(
+        const ec_device_t *device, /**< EtherCAT device */
+        struct sk_buff *skb /**< Socket buffer. */
+        )
+{
+    struct ethhdr *eth = (struct ethhdr *) skb->data;
+
+    memset(eth->h_dest, 0xFF, ETH_ALEN);
+    if (device->dev) {
+        memcpy(eth->h_source, device->dev->dev_addr, ETH_ALEN);
+    } else {
+        memset(eth->h_source, 0x00, ETH_ALEN);
+    }
+
+    if (device->vlan_tci) {
+        struct vlan_ethhdr *veth = (struct vlan_ethhdr *) skb->data;
+
+        veth->h_vlan_proto = htons(ETH_P_8021Q);
+        veth->h_vlan_TCI = htons(device->vlan_tci);
+        veth->h_vlan_encapsulated_proto = htons(ETH_P_ETHERCAT);
+    } else {
+        eth->h_proto = htons(ETH_P_ETHERCAT);
+    }
+}
+
+/*****************************************************************************/
+
 /** Constructor.
  *
  * \return 0 in case of success, else < 0
  */
 int ec_device_init(
         ec_device_t *device, /**< EtherCAT device */
-        ec_master_t *master /**< master owning the device */
+        ec_master_t *master, /**< master owning the device */
+        uint16_t vlan_tci /**< VLAN tag control information, or zero for
+                            untagged frames. */
         )
 {
     int ret;
     unsigned int i;
-    struct ethhdr *eth;
 #ifdef EC_DEBUG_IF
     char ifname[10];
     char mb = 'x';
@@ -76,13 +110,31 @@ int ec_device_init(
     device->master = master;
     device->dev = NULL;
     device->poll = NULL;
+    device->rx_poll = NULL;
+    device->tx_reclaim = NULL;
+    device->irq_control = NULL;
+    device->irq_enabled = 0;
     device->module = NULL;
     device->open = 0;
     device->link_state = 0;
-    for (i = 0; i < EC_TX_RING_SIZE; i++) {
-        device->tx_skb[i] = NULL;
-    }
+    device->vlan_tci = vlan_tci;
+    device->header_size = vlan_tci ? VLAN_ETH_HLEN : ETH_HLEN;
+    device->tx_skb = NULL;
+    device->tx_ring_size = ec_tx_ring_size;
     device->tx_ring_index = 0;
+    device->tx_in_flight = NULL;
+    device->tx_completion = 0;
+    device->tx_pending_index = 0;
+    device->tx_pending_size = 0;
+    INIT_LIST_HEAD(&device->datagram_queue);
+    INIT_LIST_HEAD(&device->sent_queue);
+    device->tx_template_count = 0;
+    device->tx_template_valid = NULL;
+    device->rx_plan = NULL;
+    device->tx_hw_time = NULL;
+    device->rx_hw_time = 0;
+    device->tx_pinned_datagram = NULL;
+    device->tx_pinned_size = 0;
 #ifdef EC_HAVE_CYCLES
     device->cycles_poll = 0;
 #endif
@@ -91,8 +143,11 @@ int ec_device_init(
     device->timeval_poll.tv_usec = 0;
 #endif
     device->jiffies_poll = 0;
+    memset(device->timeout_history, 0, sizeof(device->timeout_history));
+    device->timeout_history_index = 0;
 
     ec_device_clear_stats(device);
+    ec_capture_init(&device->capture);
 
 #ifdef EC_DEBUG_RING
     for (i = 0; i < EC_DEBUG_RING_SIZE; i++) {
@@ -126,28 +181,66 @@ int ec_device_init(
     }
 #endif
 
-    for (i = 0; i < EC_TX_RING_SIZE; i++) {
-        if (!(device->tx_skb[i] = dev_alloc_skb(ETH_FRAME_LEN))) {
+    device->tx_skb = kmalloc(sizeof(struct sk_buff *)
+            * (device->tx_ring_size + 1), GFP_KERNEL);
+    device->tx_in_flight = kmalloc(device->tx_ring_size, GFP_KERNEL);
+    device->tx_template_valid = kmalloc(sizeof(unsigned int)
+            * device->tx_ring_size, GFP_KERNEL);
+    device->rx_plan = kmalloc(sizeof(ec_rx_plan_t) * device->tx_ring_size,
+            GFP_KERNEL);
+    device->tx_hw_time = kmalloc(sizeof(u64) * (device->tx_ring_size + 1),
+            GFP_KERNEL);
+    if (!device->tx_skb || !device->tx_in_flight
+            || !device->tx_template_valid || !device->rx_plan
+            || !device->tx_hw_time) {
+        EC_MASTER_ERR(master, "Failed to allocate transmit ring!\n");
+        ret = -ENOMEM;
+        goto out_tx_ring;
+    }
+
+    for (i = 0; i <= device->tx_ring_size; i++) {
+        device->tx_skb[i] = NULL;
+        device->tx_hw_time[i] = 0;
+    }
+    for (i = 0; i < device->tx_ring_size; i++) {
+        device->tx_in_flight[i] = 0;
+        device->tx_template_valid[i] = 0;
+        device->rx_plan[i].count = 0;
+        device->rx_plan[i].size = 0;
+    }
+
+    // the last skb is the pinned one
+    for (i = 0; i <= device->tx_ring_size; i++) {
+        // like dev_alloc_skb(), but on the node of the master threads
+        if (!(device->tx_skb[i] = __alloc_skb(
+                        NET_SKB_PAD + VLAN_ETH_FRAME_LEN,
+                        GFP_KERNEL, 0, ec_master_node(master)))) {
             EC_MASTER_ERR(master, "Error allocating device socket buffer!\n");
             ret = -ENOMEM;
             goto out_tx_ring;
         }
 
-        // add Ethernet-II-header
-        skb_reserve(device->tx_skb[i], ETH_HLEN);
-        eth = (struct ethhdr *) skb_push(device->tx_skb[i], ETH_HLEN);
-        eth->h_proto = htons(0x88A4);
-        memset(eth->h_dest, 0xFF, ETH_ALEN);
+        // add Ethernet-II-header, with an IEEE 802.1Q tag if configured
+        skb_reserve(device->tx_skb[i], NET_SKB_PAD + device->header_size);
+        skb_push(device->tx_skb[i], device->header_size);
+        ec_device_write_header(device, device->tx_skb[i]);
     }
 
     return 0;
 
 out_tx_ring:
-    for (i = 0; i < EC_TX_RING_SIZE; i++) {
-        if (device->tx_skb[i]) {
-            dev_kfree_skb(device->tx_skb[i]);
+    if (device->tx_skb) {
+        for (i = 0; i <= device->tx_ring_size; i++) {
+            if (device->tx_skb[i]) {
+                dev_kfree_skb(device->tx_skb[i]);
+            }
         }
+        kfree(device->tx_skb);
     }
+    kfree(device->tx_in_flight);
+    kfree(device->tx_template_valid);
+    kfree(device->rx_plan);
+    kfree(device->tx_hw_time);
 #ifdef EC_DEBUG_IF
     ec_debug_clear(&device->dbg);
 out_return:
@@ -168,8 +261,14 @@ void ec_device_clear(
     if (device->open) {
         ec_device_close(device);
     }
-    for (i = 0; i < EC_TX_RING_SIZE; i++)
+    for (i = 0; i <= device->tx_ring_size; i++)
         dev_kfree_skb(device->tx_skb[i]);
+    kfree(device->tx_skb);
+    kfree(device->tx_in_flight);
+    kfree(device->tx_template_valid);
+    kfree(device->rx_plan);
+    kfree(device->tx_hw_time);
+    ec_capture_clear(&device->capture);
 #ifdef EC_DEBUG_IF
     ec_debug_clear(&device->dbg);
 #endif
@@ -187,7 +286,6 @@ void ec_device_attach(
         )
 {
     unsigned int i;
-    struct ethhdr *eth;
 
     ec_device_detach(device); // resets fields
 
@@ -195,10 +293,9 @@ void ec_device_attach(
     device->poll = poll;
     device->module = module;
 
-    for (i = 0; i < EC_TX_RING_SIZE; i++) {
+    for (i = 0; i <= device->tx_ring_size; i++) {
         device->tx_skb[i]->dev = net_dev;
-        eth = (struct ethhdr *) (device->tx_skb[i]->data);
-        memcpy(eth->h_source, net_dev->dev_addr, ETH_ALEN);
+        ec_device_write_header(device, device->tx_skb[i]);
     }
 
 #ifdef EC_DEBUG_IF
@@ -222,19 +319,41 @@ void ec_device_detach(
 
     device->dev = NULL;
     device->poll = NULL;
+    device->rx_poll = NULL;
+    device->tx_reclaim = NULL;
+    device->irq_control = NULL;
+    device->irq_enabled = 0;
     device->module = NULL;
     device->open = 0;
     device->link_state = 0; // down
 
     ec_device_clear_stats(device);
 
-    for (i = 0; i < EC_TX_RING_SIZE; i++) {
+    for (i = 0; i <= device->tx_ring_size; i++) {
         device->tx_skb[i]->dev = NULL;
     }
 }
 
 /*****************************************************************************/
 
+/** Marks all transmit ring entries as completed.
+ *
+ * This is called, if the driver can not report outstanding completions any
+ * more (device closed, link down).
+ */
+static void ec_device_reset_in_flight(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < device->tx_ring_size; i++) {
+        device->tx_in_flight[i] = 0;
+    }
+}
+
+/*****************************************************************************/
+
 /** Opens the EtherCAT device.
  *
  * \return 0 in case of success, else < 0
@@ -256,6 +375,7 @@ int ec_device_open(
     }
 
     device->link_state = 0;
+    ec_device_reset_in_flight(device);
 
     ec_device_clear_stats(device);
 
@@ -313,58 +433,304 @@ uint8_t *ec_device_tx_data(
         ec_device_t *device /**< EtherCAT device */
         )
 {
+    unsigned int i;
+
     /* cycle through socket buffers, because otherwise there is a race
      * condition, if multiple frames are sent and the DMA is not scheduled in
-     * between. */
-    device->tx_ring_index++;
-    device->tx_ring_index %= EC_TX_RING_SIZE;
-    return device->tx_skb[device->tx_ring_index]->data + ETH_HLEN;
+     * between. If the driver reports transmit completions, skip the socket
+     * buffers that are still in flight. The held-back frame is skipped in
+     * any case. */
+    for (i = 0; i < device->tx_ring_size; i++) {
+        device->tx_ring_index++;
+        device->tx_ring_index %= device->tx_ring_size;
+        if (device->tx_pending_size
+                && device->tx_ring_index == device->tx_pending_index) {
+            continue; // held back, not sent yet
+        }
+        if (!device->tx_completion
+                || !device->tx_in_flight[device->tx_ring_index]) {
+            device->tx_hw_time[device->tx_ring_index] = 0;
+            return device->tx_skb[device->tx_ring_index]->data
+                + device->header_size;
+        }
+    }
+
+    return NULL; // all socket buffers in flight
 }
 
 /*****************************************************************************/
 
-/** Sends the content of the transmit socket buffer.
+
+/*****************************************************************************/
+
+/** Sets the frame template.
+ *
+ * Presets the headers of the given datagrams (in the given order) at the
+ * start of each transmit socket buffer. As long as a frame starts with the
+ * same datagrams, ec_master_send_datagrams() only has to patch the indices
+ * and copy the payload. The datagrams must not change their type, address
+ * or size while the template is set. Calling this with \a count zero
+ * removes the template.
+ */
+void ec_device_set_frame_template(
+        ec_device_t *device, /**< EtherCAT device */
+        const ec_datagram_t **datagrams, /**< Template datagrams. */
+        unsigned int count /**< Number of datagrams. */
+        )
+{
+    unsigned int i, j;
+    uint8_t *cur_data;
+    const ec_datagram_t *datagram;
+
+    if (count > EC_FRAME_TEMPLATE_SIZE) {
+        count = EC_FRAME_TEMPLATE_SIZE;
+    }
+
+    for (j = 0; j < count; j++) {
+        device->tx_template[j] = datagrams[j];
+    }
+    device->tx_template_count = count;
+
+    for (i = 0; i < device->tx_ring_size; i++) {
+        cur_data = device->tx_skb[i]->data + device->header_size
+            + EC_FRAME_HEADER_SIZE;
+
+        for (j = 0; j < count; j++) {
+            datagram = datagrams[j];
+            EC_WRITE_U8 (cur_data, datagram->type);
+            EC_WRITE_U8 (cur_data + 1, 0x00);
+            memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
+            EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+            EC_WRITE_U16(cur_data + 8, 0x0000);
+            cur_data += EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+                + EC_DATAGRAM_FOOTER_SIZE;
+        }
+
+        device->tx_template_valid[i] = count;
+        device->rx_plan[i].count = 0;
+    }
+}
+
+/*****************************************************************************/
+
+/** Transmits a socket buffer.
  *
  * Cuts the socket buffer content to the (now known) size, and calls the
  * start_xmit() function of the assigned net_device.
+ *
+ * \return Non-zero, if the driver accepted the frame.
  */
-void ec_device_send(
+static int ec_device_xmit(
         ec_device_t *device, /**< EtherCAT device */
-        size_t size /**< number of bytes to send */
+        struct sk_buff *skb, /**< Socket buffer to send. */
+        size_t size, /**< number of bytes to send */
+        int more /**< Non-zero, if another frame follows immediately. */
         )
 {
-    struct sk_buff *skb = device->tx_skb[device->tx_ring_index];
+    netdev_tx_t ret;
 
     // set the right length for the data
-    skb->len = ETH_HLEN + size;
+    size += device->header_size;
+    skb->len = size;
+
+    /* Launch time for drivers and queueing disciplines supporting
+     * time-based transmission (ETF, LaunchTime); zero sends immediately. */
+    skb->tstamp = ns_to_ktime(device->master->tx_launch_time);
 
     if (unlikely(device->master->debug_level > 1)) {
         EC_MASTER_DBG(device->master, 2, "Sending frame:\n");
-        ec_print_data(skb->data, ETH_HLEN + size);
+        ec_print_data(skb->data, size);
     }
 
-    // start sending
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 29)
-    if (device->dev->netdev_ops->ndo_start_xmit(skb, device->dev) ==
-            NETDEV_TX_OK)
+    /* start sending. If another frame follows, the driver may defer
+     * notifying the hardware (xmit_more semantics). */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+    // the xmit_more hint is stored per CPU
+    local_bh_disable();
+    ret = __netdev_start_xmit(device->dev->netdev_ops, skb, device->dev,
+            more);
+    local_bh_enable();
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4, 2, 0)
+    ret = __netdev_start_xmit(device->dev->netdev_ops, skb, device->dev,
+            more);
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 18, 0)
+    skb->xmit_more = more;
+    ret = device->dev->netdev_ops->ndo_start_xmit(skb, device->dev);
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 29)
+    ret = device->dev->netdev_ops->ndo_start_xmit(skb, device->dev);
 #else
-    if (device->dev->hard_start_xmit(skb, device->dev) == NETDEV_TX_OK)
+    ret = device->dev->hard_start_xmit(skb, device->dev);
 #endif
-    {
+
+    if (ret == NETDEV_TX_OK) {
         device->tx_count++;
         device->master->device_stats.tx_count++;
-        device->tx_bytes += ETH_HLEN + size;
-        device->master->device_stats.tx_bytes += ETH_HLEN + size;
+        device->tx_bytes += size;
+        device->master->device_stats.tx_bytes += size;
+        if (unlikely(device->capture.active)) {
+            ec_capture_frame(&device->capture, 0, skb->data, size);
+        }
 #ifdef EC_DEBUG_IF
-        ec_debug_send(&device->dbg, skb->data, ETH_HLEN + size);
+        ec_debug_send(&device->dbg, 0, skb->data, size);
 #endif
 #ifdef EC_DEBUG_RING
-        ec_device_debug_ring_append(
-                device, TX, skb->data + ETH_HLEN, size);
+        ec_device_debug_ring_append(device, TX,
+                skb->data + device->header_size, size - device->header_size);
 #endif
+        return 1;
     } else {
         device->tx_errors++;
+        return 0;
+    }
+}
+
+/*****************************************************************************/
+
+/** Hands the pending frame to the driver.
+ */
+static void ec_device_send_pending(
+        ec_device_t *device, /**< EtherCAT device */
+        int more /**< Non-zero, if another frame follows immediately. */
+        )
+{
+    unsigned int index = device->tx_pending_index;
+    size_t size = device->tx_pending_size;
+
+    device->tx_pending_size = 0;
+
+    if (ec_device_xmit(device, device->tx_skb[index], size, more)) {
+        device->tx_in_flight[index] = 1;
+    }
+}
+
+/*****************************************************************************/
+
+/** Sends the content of the transmit socket buffer.
+ *
+ * Sends the socket buffer last returned by ec_device_tx_data(). To batch
+ * the frames of a cycle, the frame is held back until the next frame is
+ * sent or ec_device_flush() is called, so that the driver can be told,
+ * whether more frames follow.
+ */
+void ec_device_send(
+        ec_device_t *device, /**< EtherCAT device */
+        size_t size /**< number of bytes to send */
+        )
+{
+    if (device->tx_pending_size) {
+        // previous frame is not the last one
+        ec_device_send_pending(device, 1);
+    }
+
+    device->tx_pending_index = device->tx_ring_index;
+    device->tx_pending_size = size;
+}
+
+/*****************************************************************************/
+
+/** Hands a held-back frame to the driver as the last one of a batch.
+ */
+void ec_device_flush(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    if (device->tx_pending_size) {
+        ec_device_send_pending(device, 0);
+    }
+}
+
+/*****************************************************************************/
+
+/** Returns the payload memory of the pinned frame.
+ *
+ * This is where the payload of a pinned datagram has to be stored.
+ *
+ * \return Pointer to the payload memory inside the pinned frame.
+ */
+uint8_t *ec_device_pinned_payload(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    return device->tx_skb[device->tx_ring_size]->data + device->header_size
+        + EC_FRAME_HEADER_SIZE + EC_DATAGRAM_HEADER_SIZE;
+}
+
+/*****************************************************************************/
+
+/** Pins a datagram into the pinned transmit socket buffer.
+ *
+ * The datagram is the only one in the pinned frame, and its payload memory
+ * has to be the one returned by ec_device_pinned_payload(). Its header, the
+ * frame header and the padding are written once here, so that
+ * ec_device_send_pinned() only has to set the index and reset the working
+ * counter.
+ */
+void ec_device_pin_datagram(
+        ec_device_t *device, /**< EtherCAT device */
+        ec_datagram_t *datagram /**< Datagram to pin. */
+        )
+{
+    uint8_t *frame_data =
+        device->tx_skb[device->tx_ring_size]->data + device->header_size;
+    uint8_t *cur_data = frame_data + EC_FRAME_HEADER_SIZE;
+    size_t size = EC_FRAME_HEADER_SIZE + EC_DATAGRAM_HEADER_SIZE
+        + datagram->data_size + EC_DATAGRAM_FOOTER_SIZE;
+
+    // EtherCAT frame header
+    EC_WRITE_U16(frame_data, ((size - EC_FRAME_HEADER_SIZE) & 0x7FF)
+            | 0x1000);
+
+    // EtherCAT datagram header
+    EC_WRITE_U8 (cur_data, datagram->type);
+    EC_WRITE_U8 (cur_data + 1, 0x00);
+    memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
+    EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+    EC_WRITE_U16(cur_data + 8, 0x0000);
+
+    // pad frame
+    memset(frame_data + size - EC_DATAGRAM_FOOTER_SIZE, 0x00,
+            EC_DATAGRAM_FOOTER_SIZE);
+    while (size < ETH_ZLEN - ETH_HLEN) {
+        EC_WRITE_U8(frame_data + size++, 0x00);
     }
+
+    device->tx_pinned_datagram = datagram;
+    device->tx_pinned_size = size;
+}
+
+/*****************************************************************************/
+
+/** Removes the pinned datagram.
+ */
+void ec_device_unpin_datagram(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    device->tx_pinned_datagram = NULL;
+    device->tx_pinned_size = 0;
+}
+
+/*****************************************************************************/
+
+/** Sends the pinned frame.
+ *
+ * The datagram index has to be set before.
+ */
+void ec_device_send_pinned(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    const ec_datagram_t *datagram = device->tx_pinned_datagram;
+    uint8_t *cur_data = device->tx_skb[device->tx_ring_size]->data
+        + device->header_size + EC_FRAME_HEADER_SIZE;
+
+    EC_WRITE_U8(cur_data + 1, datagram->index);
+    EC_WRITE_U16(cur_data + EC_DATAGRAM_HEADER_SIZE + datagram->data_size,
+            0x0000); // reset working counter
+    device->tx_hw_time[device->tx_ring_size] = 0;
+
+    ec_device_xmit(device, device->tx_skb[device->tx_ring_size],
+            device->tx_pinned_size, 0);
 }
 
 /*****************************************************************************/
@@ -387,6 +753,8 @@ void ec_device_clear_stats(
     device->rx_bytes = 0;
     device->last_rx_bytes = 0;
     device->tx_errors = 0;
+    device->round_trip_time = 0;
+    device->max_round_trip_time = 0;
 
     for (i = 0; i < EC_RATE_COUNT; i++) {
         device->tx_frame_rates[i] = 0;
@@ -398,6 +766,61 @@ void ec_device_clear_stats(
 
 /*****************************************************************************/
 
+/** Remembers a timed out datagram, so that a late response can be told from
+ * an unmatched one.
+ */
+void ec_device_timeout_history_add(
+        ec_device_t *device, /**< EtherCAT device */
+        const ec_datagram_t *datagram /**< Timed out datagram. */
+        )
+{
+    ec_timed_out_datagram_t *entry =
+        &device->timeout_history[device->timeout_history_index];
+
+    entry->deadline = datagram->deadline;
+    entry->data_size = datagram->data_size;
+    entry->index = datagram->index;
+    entry->type = datagram->type;
+
+    device->timeout_history_index =
+        (device->timeout_history_index + 1) % EC_TIMEOUT_HISTORY_SIZE;
+}
+
+/*****************************************************************************/
+
+/** Looks up a received datagram in the history of timed out datagrams.
+ *
+ * A matching entry is removed, so that it is accounted only once.
+ *
+ * \retval 1 The datagram timed out before, \a deadline is set.
+ * \retval 0 No timed out datagram matches.
+ */
+int ec_device_timeout_history_match(
+        ec_device_t *device, /**< EtherCAT device */
+        uint8_t index, /**< Datagram index. */
+        uint8_t type, /**< Datagram type. */
+        size_t data_size, /**< Data size. */
+        ktime_t *deadline /**< Missed deadline (output). */
+        )
+{
+    ec_timed_out_datagram_t *entry;
+    unsigned int i;
+
+    for (i = 0; i < EC_TIMEOUT_HISTORY_SIZE; i++) {
+        entry = &device->timeout_history[i];
+        if (ktime_to_ns(entry->deadline) && entry->index == index
+                && entry->type == type && entry->data_size == data_size) {
+            *deadline = entry->deadline;
+            entry->deadline = ktime_set(0, 0);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 #ifdef EC_DEBUG_RING
 /** Appends frame data to the debug ring.
  */
@@ -474,6 +897,9 @@ void ec_device_debug_ring_print(
  * The master itself works without using interrupts. Therefore the processing
  * of received data and status changes of the network device has to be
  * done by the master calling the ISR "manually".
+ *
+ * If the driver split its poll function, only the receive part is called
+ * here, see ec_device_reclaim().
  */
 void ec_device_poll(
         ec_device_t *device /**< EtherCAT device */
@@ -486,7 +912,27 @@ void ec_device_poll(
 #ifdef EC_DEBUG_RING
     do_gettimeofday(&device->timeval_poll);
 #endif
-    device->poll(device->dev);
+    if (device->rx_poll) {
+        device->rx_poll(device->dev);
+    } else {
+        device->poll(device->dev);
+    }
+}
+
+/*****************************************************************************/
+
+/** Cleans up the transmitted frames of the assigned net_device.
+ *
+ * Only does something, if the driver split its poll function. Called before
+ * sending, so that the transmit ring entries are free again.
+ */
+void ec_device_reclaim(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    if (device->tx_reclaim) {
+        device->tx_reclaim(device->dev);
+    }
 }
 
 /*****************************************************************************/
@@ -639,8 +1085,8 @@ void ecdev_receive(
         size_t size /**< number of bytes received */
         )
 {
-    const void *ec_data = data + ETH_HLEN;
-    size_t ec_size = size - ETH_HLEN;
+    const void *ec_data;
+    size_t ec_size, header_size = ETH_HLEN;
 
     if (unlikely(!data)) {
         EC_MASTER_WARN(device->master, "%s() called with NULL data.\n",
@@ -648,6 +1094,15 @@ void ecdev_receive(
         return;
     }
 
+    // untag frames, that still carry their IEEE 802.1Q tag
+    if (size >= VLAN_ETH_HLEN
+            && ((const struct ethhdr *) data)->h_proto
+            == htons(ETH_P_8021Q)) {
+        header_size = VLAN_ETH_HLEN;
+    }
+    ec_data = data + header_size;
+    ec_size = size - header_size;
+
     device->rx_count++;
     device->master->device_stats.rx_count++;
     device->rx_bytes += size;
@@ -658,8 +1113,11 @@ void ecdev_receive(
         ec_print_data(data, size);
     }
 
+    if (unlikely(device->capture.active)) {
+        ec_capture_frame(&device->capture, 1, data, size);
+    }
 #ifdef EC_DEBUG_IF
-    ec_debug_send(&device->dbg, data, size);
+    ec_debug_send(&device->dbg, 1, data, size);
 #endif
 #ifdef EC_DEBUG_RING
     ec_device_debug_ring_append(device, RX, ec_data, ec_size);
@@ -670,6 +1128,83 @@ void ecdev_receive(
 
 /*****************************************************************************/
 
+/** Accepts a received frame together with its hardware time stamp.
+ *
+ * Same as ecdev_receive(), for drivers that can time stamp received frames
+ * in hardware. The time stamp is in nanoseconds and has to come from the
+ * same clock as the ones passed to ecdev_tx_stamped(). Together they give
+ * the on-wire round trip time of the frame.
+ *
+ * \ingroup DeviceInterface
+ */
+void ecdev_receive_stamped(
+        ec_device_t *device, /**< EtherCAT device */
+        const void *data, /**< pointer to received data */
+        size_t size, /**< number of bytes received */
+        u64 hw_time /**< Hardware receive time stamp in ns. */
+        )
+{
+    device->rx_hw_time = hw_time;
+    ecdev_receive(device, data, size);
+    device->rx_hw_time = 0;
+}
+
+/*****************************************************************************/
+
+/** Reports the completed transmission of a frame.
+ *
+ * Native drivers call this from their transmit cleanup routine for every
+ * socket buffer the master handed to them. Once a driver reported a
+ * completion, the master only reuses transmit ring entries that have
+ * completed, so that more frames per cycle can be sent safely.
+ *
+ * \ingroup DeviceInterface
+ */
+void ecdev_tx_complete(
+        ec_device_t *device, /**< EtherCAT device */
+        const struct sk_buff *skb /**< Transmitted socket buffer. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < device->tx_ring_size; i++) {
+        if (device->tx_skb[i] == skb) {
+            device->tx_in_flight[i] = 0;
+            break;
+        }
+    }
+
+    device->tx_completion = 1;
+}
+
+/*****************************************************************************/
+
+/** Reports the hardware transmit time stamp of a frame.
+ *
+ * Drivers, that can time stamp sent frames in hardware, call this before
+ * the reception of the frame is reported, usually from their transmit
+ * cleanup routine. The time stamp is in nanoseconds.
+ *
+ * \ingroup DeviceInterface
+ */
+void ecdev_tx_stamped(
+        ec_device_t *device, /**< EtherCAT device */
+        const struct sk_buff *skb, /**< Transmitted socket buffer. */
+        u64 hw_time /**< Hardware transmit time stamp in ns. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i <= device->tx_ring_size; i++) {
+        if (device->tx_skb[i] == skb) {
+            device->tx_hw_time[i] = hw_time;
+            break;
+        }
+    }
+}
+
+/*****************************************************************************/
+
 /** Sets a new link state.
  *
  * If the device notifies the master about the link being down, the master
@@ -689,6 +1224,9 @@ void ecdev_set_link(
 
     if (likely(state != device->link_state)) {
         device->link_state = state;
+        if (!state) {
+            ec_device_reset_in_flight(device);
+        }
         EC_MASTER_INFO(device->master,
                 "Link state of %s changed to %s.\n",
                 device->dev->name, (state ? "UP" : "DOWN"));
@@ -697,6 +1235,94 @@ void ecdev_set_link(
 
 /*****************************************************************************/
 
+/** Splits the poll function into a receive and a transmit part.
+ *
+ * By default, the master calls the poll function passed to ecdev_offer()
+ * for every reception. A driver can instead provide a receive-only poll
+ * function, that is called in the latency-critical receive path, and a
+ * function to clean up transmitted frames, that the master calls right
+ * before it sends. The transmit part has to report completed frames via
+ * ecdev_tx_complete(). Passing NULL functions restores the default.
+ *
+ * \ingroup DeviceInterface
+ */
+void ecdev_set_split_poll(
+        ec_device_t *device, /**< EtherCAT device */
+        ec_pollfunc_t rx_poll, /**< Receive-only poll function. */
+        ec_pollfunc_t tx_reclaim /**< Transmit cleanup function. */
+        )
+{
+    if (!rx_poll || !tx_reclaim) {
+        rx_poll = NULL;
+        tx_reclaim = NULL;
+    }
+
+    device->rx_poll = rx_poll;
+    device->tx_reclaim = tx_reclaim;
+}
+
+/*****************************************************************************/
+
+/** Enables or disables the receive interrupts of the assigned net_device.
+ *
+ * Does nothing, if the driver does not support receive interrupts in
+ * EtherCAT operation.
+ */
+void ec_device_irq_enable(
+        ec_device_t *device, /**< EtherCAT device */
+        int enable /**< Non-zero to enable the interrupts. */
+        )
+{
+    if (!device->irq_control || device->irq_enabled == !!enable) {
+        return;
+    }
+
+    device->irq_control(device->dev, enable);
+    device->irq_enabled = !!enable;
+}
+
+/*****************************************************************************/
+
+/** Registers a function to control the receive interrupts.
+ *
+ * Normally, the device is operated without interrupts. With a control
+ * function, the master may enable the receive interrupts while it is in
+ * idle phase, so that its idle thread can sleep until a frame arrives,
+ * instead of polling. The driver's interrupt handler then has to call
+ * ecdev_irq(). The master disables the interrupts again before the device
+ * is used by an application.
+ *
+ * \ingroup DeviceInterface
+ */
+void ecdev_set_irq_control(
+        ec_device_t *device, /**< EtherCAT device */
+        ec_irqfunc_t irq_control /**< Interrupt control function, or NULL. */
+        )
+{
+    device->irq_control = irq_control;
+    device->irq_enabled = 0;
+}
+
+/*****************************************************************************/
+
+/** Signals a receive interrupt.
+ *
+ * Wakes up the master's idle thread. May be called in interrupt context.
+ *
+ * \ingroup DeviceInterface
+ */
+void ecdev_irq(
+        ec_device_t *device /**< EtherCAT device */
+        )
+{
+    ec_master_t *master = device->master;
+
+    master->idle_irq_event = 1;
+    wake_up_interruptible(&master->idle_queue);
+}
+
+/*****************************************************************************/
+
 /** Reads the link state.
  *
  * \ingroup DeviceInterface
@@ -723,8 +1349,14 @@ EXPORT_SYMBOL(ecdev_withdraw);
 EXPORT_SYMBOL(ecdev_open);
 EXPORT_SYMBOL(ecdev_close);
 EXPORT_SYMBOL(ecdev_receive);
+EXPORT_SYMBOL(ecdev_receive_stamped);
+EXPORT_SYMBOL(ecdev_tx_complete);
+EXPORT_SYMBOL(ecdev_tx_stamped);
 EXPORT_SYMBOL(ecdev_get_link);
 EXPORT_SYMBOL(ecdev_set_link);
+EXPORT_SYMBOL(ecdev_set_split_poll);
+EXPORT_SYMBOL(ecdev_set_irq_control);
+EXPORT_SYMBOL(ecdev_irq);
 
 /** \endcond */
 
@@ -41,15 +41,50 @@
 
 #include "../devices/ecdev.h"
 #include "globals.h"
+#include "datagram.h"
+#include "capture.h"
 
 /**
- * Size of the transmit ring.
+ * Default size of the transmit ring.
  * This memory ring is used to transmit frames. It is necessary to use
  * different memory regions, because otherwise the network device DMA could
- * send the same data twice, if it is called twice.
+ * send the same data twice, if it is called twice. The size can be changed
+ * with the tx_ring_size module parameter.
  */
 #define EC_TX_RING_SIZE 2
 
+/** Maximum size of the transmit ring.
+ */
+#define EC_MAX_TX_RING_SIZE 64
+
+/** Maximum number of datagrams in a frame template.
+ */
+#define EC_FRAME_TEMPLATE_SIZE 32
+
+/** Number of timed out datagrams remembered per device for the detection of
+ * late responses.
+ */
+#define EC_TIMEOUT_HISTORY_SIZE 16
+
+/** Timed out datagram, see ec_device_t::timeout_history.
+ */
+typedef struct {
+    ktime_t deadline; /**< Missed deadline, or zero, if unused. */
+    uint16_t data_size; /**< Data size of the datagram. */
+    uint8_t index; /**< Datagram index. */
+    uint8_t type; /**< Datagram type. */
+} ec_timed_out_datagram_t;
+
+/** Receive plan of a transmitted frame, see ec_device_t::rx_plan.
+ *
+ * Describes the template datagrams, that the frame starts with, so that
+ * their responses can be processed without parsing.
+ */
+typedef struct {
+    unsigned int count; /**< Number of leading template datagrams. */
+    size_t size; /**< Size of these datagrams with headers and footers. */
+} ec_rx_plan_t;
+
 #ifdef EC_DEBUG_IF
 #include "debug.h"
 #endif
@@ -83,11 +118,51 @@ struct ec_device
     ec_master_t *master; /**< EtherCAT master */
     struct net_device *dev; /**< pointer to the assigned net_device */
     ec_pollfunc_t poll; /**< pointer to the device's poll function */
+    ec_pollfunc_t rx_poll; /**< Receive-only poll function, or NULL. */
+    ec_pollfunc_t tx_reclaim; /**< Transmit cleanup function, or NULL. */
+    ec_irqfunc_t irq_control; /**< Function to enable and disable receive
+                                interrupts, or NULL. */
+    uint8_t irq_enabled; /**< Receive interrupts are enabled. */
     struct module *module; /**< pointer to the device's owning module */
     uint8_t open; /**< true, if the net_device has been opened */
     uint8_t link_state; /**< device link state */
-    struct sk_buff *tx_skb[EC_TX_RING_SIZE]; /**< transmit skb ring */
+    uint16_t vlan_tci; /**< IEEE 802.1Q tag control information of the
+                         transmitted frames (PCP << 13 | VID), or zero for
+                         untagged frames. */
+    size_t header_size; /**< Size of the Ethernet header of the transmitted
+                          frames, including a VLAN tag. */
+    struct sk_buff **tx_skb; /**< transmit skb ring, followed by the pinned
+                               skb that carries a zero-copy domain */
+    unsigned int tx_ring_size; /**< Number of skbs in the transmit ring. */
     unsigned int tx_ring_index; /**< last ring entry used to transmit */
+    uint8_t *tx_in_flight; /**< Per ring entry: Non-zero, if the skb was
+                             handed to the driver and its transmission has
+                             not been completed yet. */
+    uint8_t tx_completion; /**< Non-zero, if the driver reports transmit
+                             completions via ecdev_tx_complete(). */
+    unsigned int tx_pending_index; /**< Ring entry of the held-back frame. */
+    size_t tx_pending_size; /**< Size of the held-back frame, or zero. */
+    struct list_head datagram_queue; /**< Queue of datagrams to send via this
+                                       device. */
+    struct list_head sent_queue; /**< Datagrams sent via this device and
+                                   waiting for reception, in the order of
+                                   sending. */
+    const ec_datagram_t *tx_template[EC_FRAME_TEMPLATE_SIZE]; /**< Cyclic
+                                       datagrams, whose headers are preset at
+                                       the start of each transmit frame. */
+    unsigned int tx_template_count; /**< Number of template datagrams. */
+    ec_datagram_t *tx_pinned_datagram; /**< Zero-copy datagram, whose payload
+                                         lives inside the pinned skb. */
+    size_t tx_pinned_size; /**< Size of the pinned frame. */
+    unsigned int *tx_template_valid; /**< Number of template headers, that
+                                       are still intact in each transmit
+                                       ring entry. */
+    ec_rx_plan_t *rx_plan; /**< Per ring entry: Receive plan of the frame
+                             sent last. */
+    u64 *tx_hw_time; /**< Per ring entry and pinned skb: Hardware time
+                       stamp of the last transmission in ns, or zero. */
+    u64 rx_hw_time; /**< Hardware time stamp of the frame currently being
+                      received in ns, or zero. */
 #ifdef EC_HAVE_CYCLES
     cycles_t cycles_poll; /**< cycles of last poll */
 #endif
@@ -108,6 +183,9 @@ struct ec_device
     u64 last_rx_bytes; /**< Number of bytes received of last statistics cycle.
                         */
     u64 tx_errors; /**< Number of transmit errors. */
+    u32 round_trip_time; /**< Last hardware round trip time of a frame in
+                           ns, or zero. */
+    u32 max_round_trip_time; /**< Maximum hardware round trip time in ns. */
     s32 tx_frame_rates[EC_RATE_COUNT]; /**< Transmit rates in frames/s for
                                          different statistics cycle periods.
                                         */
@@ -119,6 +197,13 @@ struct ec_device
     s32 rx_byte_rates[EC_RATE_COUNT]; /**< Receive rates in byte/s for
                                         different statistics cycle periods. */
 
+    ec_timed_out_datagram_t timeout_history[EC_TIMEOUT_HISTORY_SIZE]; /**<
+                                    Recently timed out datagrams. */
+    unsigned int timeout_history_index; /**< Next entry to overwrite in
+                                          \a timeout_history. */
+
+    ec_capture_t capture; /**< Binary frame capture ring. */
+
 #ifdef EC_DEBUG_IF
     ec_debug_t dbg; /**< debug device */
 #endif
@@ -131,7 +216,11 @@ struct ec_device
 
 /*****************************************************************************/
 
-int ec_device_init(ec_device_t *, ec_master_t *);
+extern unsigned int ec_tx_ring_size;
+
+/*****************************************************************************/
+
+int ec_device_init(ec_device_t *, ec_master_t *, uint16_t);
 void ec_device_clear(ec_device_t *);
 
 void ec_device_attach(ec_device_t *, struct net_device *, ec_pollfunc_t,
@@ -142,10 +231,22 @@ int ec_device_open(ec_device_t *);
 int ec_device_close(ec_device_t *);
 
 void ec_device_poll(ec_device_t *);
+void ec_device_reclaim(ec_device_t *);
+void ec_device_irq_enable(ec_device_t *, int);
 uint8_t *ec_device_tx_data(ec_device_t *);
+void ec_device_set_frame_template(ec_device_t *, const ec_datagram_t **,
+        unsigned int);
 void ec_device_send(ec_device_t *, size_t);
+void ec_device_flush(ec_device_t *);
+uint8_t *ec_device_pinned_payload(ec_device_t *);
+void ec_device_pin_datagram(ec_device_t *, ec_datagram_t *);
+void ec_device_unpin_datagram(ec_device_t *);
+void ec_device_send_pinned(ec_device_t *);
 void ec_device_clear_stats(ec_device_t *);
 void ec_device_update_stats(ec_device_t *);
+void ec_device_timeout_history_add(ec_device_t *, const ec_datagram_t *);
+int ec_device_timeout_history_match(ec_device_t *, uint8_t, uint8_t, size_t,
+        ktime_t *);
 
 #ifdef EC_DEBUG_RING
 void ec_device_debug_ring_append(ec_device_t *, ec_debug_frame_dir_t,
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   CANopen SDO dictionary functions.
+*/
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+
+#include "sdo.h"
+#include "dict.h"
+
+/*****************************************************************************/
+
+/** Constructor.
+ */
+void ec_dict_init(
+        ec_dict_t *dict, /**< SDO dictionary. */
+        uint32_t vendor_id, /**< Vendor ID. */
+        uint32_t product_code, /**< Product code. */
+        uint32_t revision_number /**< Revision number. */
+        )
+{
+    INIT_LIST_HEAD(&dict->list);
+    dict->vendor_id = vendor_id;
+    dict->product_code = product_code;
+    dict->revision_number = revision_number;
+    INIT_LIST_HEAD(&dict->sdos);
+    dict->refs = 0;
+    dict->reader = NULL;
+}
+
+/*****************************************************************************/
+
+/** Destructor.
+ *
+ * Clears and frees all SDOs of the dictionary.
+ */
+void ec_dict_clear(
+        ec_dict_t *dict /**< SDO dictionary. */
+        )
+{
+    ec_sdo_t *sdo, *next;
+
+    list_for_each_entry_safe(sdo, next, &dict->sdos, list) {
+        list_del(&sdo->list);
+        ec_sdo_clear(sdo);
+        kfree(sdo);
+    }
+}
+
+/*****************************************************************************/
+
+/** Releases a slave's reference to the dictionary.
+ *
+ * The dictionary is freed, if it is neither used nor cached any more.
+ */
+void ec_dict_release(
+        ec_dict_t *dict /**< SDO dictionary. */
+        )
+{
+    if (dict->refs) {
+        dict->refs--;
+    }
+
+    if (!dict->refs && list_empty(&dict->list)) {
+        ec_dict_clear(dict);
+        kfree(dict);
+    }
+}
+
+/*****************************************************************************/
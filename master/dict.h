@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   CANopen SDO dictionary.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_DICT_H__
+#define __EC_DICT_H__
+
+#include <linux/list.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** SDO dictionary of a slave model.
+ *
+ * Slaves with the same vendor ID, product code and revision number have the
+ * same dictionary, so a dictionary stored in the master's cache is shared by
+ * all matching slaves. Apart from the entry descriptions, that are fetched
+ * on first access, a shared dictionary is not modified any more.
+ */
+struct ec_dict {
+    struct list_head list; /**< Item of the master's dictionary cache. Empty,
+                             if the dictionary is not cached. */
+    uint32_t vendor_id; /**< Vendor ID. */
+    uint32_t product_code; /**< Product code. */
+    uint32_t revision_number; /**< Revision number. */
+    struct list_head sdos; /**< List of SDOs. */
+    unsigned int refs; /**< Number of slaves using the dictionary. */
+    ec_slave_t *reader; /**< Slave currently reading the dictionary from the
+                          bus, or NULL. */
+};
+
+/*****************************************************************************/
+
+void ec_dict_init(ec_dict_t *, uint32_t, uint32_t, uint32_t);
+void ec_dict_clear(ec_dict_t *);
+void ec_dict_release(ec_dict_t *);
+
+/*****************************************************************************/
+
+#endif
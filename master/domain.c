@@ -35,13 +35,16 @@
 /*****************************************************************************/
 
 #include <linux/module.h>
+#include <asm/unaligned.h>
 
 #include "globals.h"
 #include "master.h"
 #include "slave_config.h"
 
 #include "domain.h"
+#include "bit_map.h"
 #include "datagram_pair.h"
+#include "trace.h"
 
 /** Extra debug output for redundancy functions.
  */
@@ -64,13 +67,43 @@ void ec_domain_init(
     unsigned int dev_idx;
 
     domain->master = master;
+    domain->owner = NULL;
     domain->index = index;
     INIT_LIST_HEAD(&domain->fmmu_configs);
     domain->data_size = 0;
+    domain->alignment = 1;
     domain->data = NULL;
     domain->data_origin = EC_ORIG_INTERNAL;
+    domain->zero_copy = 0;
+    domain->overlap = 0;
+    domain->double_buffer = 0;
+    domain->split_io = 0;
+    domain->image = NULL;
+    domain->image_size = 0;
+    domain->pipeline_depth = 1;
+    domain->pipeline_slot = 0;
+    domain->queue_slot = 0;
+    domain->queue_pending = 0;
+    domain->queue_inputs_pending = 0;
+    domain->cycle_divisor = 0;
+    domain->cycle_phase = 0;
+    domain->cycle_countdown = 0;
+    domain->input_snapshot = NULL;
+    domain->changed_inputs = NULL;
+    domain->timeout = ktime_set(0, EC_IO_TIMEOUT * NSEC_PER_USEC);
+    domain->segment = -1;
     domain->logical_base_address = 0x00000000;
     INIT_LIST_HEAD(&domain->datagram_pairs);
+    domain->pair_pool = NULL;
+    domain->pair_pool_size = 0;
+    domain->pair_pool_used = 0;
+    INIT_LIST_HEAD(&domain->routes);
+    domain->process_cb = NULL;
+    domain->process_cb_data = NULL;
+    domain->bit_maps = NULL;
+    memset(&domain->round_trip, 0, sizeof(domain->round_trip));
+    memset(&domain->process_time, 0, sizeof(domain->process_time));
+    ec_history_init(&domain->history);
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
         domain->working_counter[dev_idx] = 0x0000;
@@ -78,7 +111,69 @@ void ec_domain_init(
     domain->expected_working_counter = 0x0000;
     domain->working_counter_changes = 0;
     domain->redundancy_active = 0;
+    domain->wc_drops = 0;
+    domain->wc_probed_drops = 0;
+    domain->wc_fault_count = 0;
+    memset(&domain->redundancy, 0, sizeof(domain->redundancy));
     domain->notify_jiffies = 0;
+    domain->process_count = 0;
+    domain->map_sequence = NULL;
+}
+
+/*****************************************************************************/
+
+/** Allocates a datagram pair from the pair pool of the domain.
+ *
+ * The pairs are walked in every cycle, so they are allocated as one block
+ * on the master's memory node. The pool is sized for the maximum number of
+ * pairs of the layout: A datagram is only closed, if the next FMMU does not
+ * fit, so two consecutive datagrams always carry more than \a
+ * EC_MAX_DATA_SIZE bytes. Pairs beyond the pool are allocated separately.
+ *
+ * \return Datagram pair, or NULL, if out of memory.
+ */
+static ec_datagram_pair_t *ec_domain_alloc_datagram_pair(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    if (!domain->pair_pool) {
+        unsigned int count =
+            2 * (domain->data_size / EC_MAX_DATA_SIZE + 1) + 1;
+
+        if (domain->split_io) {
+            count *= 2;
+        }
+        count *= domain->pipeline_depth;
+
+        domain->pair_pool = kmalloc_node(sizeof(ec_datagram_pair_t) * count,
+                GFP_KERNEL, ec_master_node(domain->master));
+        if (domain->pair_pool) {
+            domain->pair_pool_size = count;
+        }
+    }
+
+    if (domain->pair_pool_used < domain->pair_pool_size) {
+        return &domain->pair_pool[domain->pair_pool_used++];
+    }
+
+    return kmalloc(sizeof(ec_datagram_pair_t), GFP_KERNEL);
+}
+
+/*****************************************************************************/
+
+/** Frees a datagram pair, unless it belongs to the pair pool.
+ */
+static void ec_domain_free_datagram_pair(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        ec_datagram_pair_t *pair /**< Datagram pair. */
+        )
+{
+    if (pair >= domain->pair_pool
+            && pair < domain->pair_pool + domain->pair_pool_size) {
+        return; // freed with the pool
+    }
+
+    kfree(pair);
 }
 
 /*****************************************************************************/
@@ -88,14 +183,37 @@ void ec_domain_init(
 void ec_domain_clear(ec_domain_t *domain /**< EtherCAT domain */)
 {
     ec_datagram_pair_t *datagram_pair, *next_pair;
+    ec_domain_route_t *route, *next_route;
+    ec_device_t *device = &domain->master->devices[EC_DEVICE_MAIN];
 
     // dequeue and free datagrams
     list_for_each_entry_safe(datagram_pair, next_pair,
             &domain->datagram_pairs, list) {
+        if (device->tx_pinned_datagram ==
+                &datagram_pair->datagrams[EC_DEVICE_MAIN]) {
+            ec_device_unpin_datagram(device);
+        }
         ec_datagram_pair_clear(datagram_pair);
-        kfree(datagram_pair);
+        ec_domain_free_datagram_pair(domain, datagram_pair);
+    }
+
+    if (domain->pair_pool) {
+        kfree(domain->pair_pool);
+        domain->pair_pool = NULL;
+    }
+
+    list_for_each_entry_safe(route, next_route, &domain->routes, list) {
+        list_del(&route->list);
+        kfree(route);
+    }
+
+    while (domain->bit_maps) {
+        ec_bit_map_t *next = domain->bit_maps->next;
+        ec_bit_map_free(domain->bit_maps);
+        domain->bit_maps = next;
     }
 
+    ec_history_clear(&domain->history);
     ec_domain_clear_data(domain);
 }
 
@@ -113,6 +231,18 @@ void ec_domain_clear_data(
 
     domain->data = NULL;
     domain->data_origin = EC_ORIG_INTERNAL;
+
+    if (domain->image) {
+        kfree(domain->image);
+        domain->image = NULL;
+    }
+    domain->image_size = 0;
+
+    if (domain->input_snapshot) {
+        kfree(domain->input_snapshot);
+        domain->input_snapshot = NULL;
+        domain->changed_inputs = NULL;
+    }
 }
 
 /*****************************************************************************/
@@ -126,6 +256,18 @@ void ec_domain_add_fmmu_config(
 {
     fmmu->domain = domain;
 
+    if (domain->alignment > 1 && !list_empty(&domain->fmmu_configs)) {
+        const ec_fmmu_config_t *last = list_entry(domain->fmmu_configs.prev,
+                ec_fmmu_config_t, list);
+
+        if (last->sc != fmmu->sc) {
+            // start the block of the next slave config on a boundary
+            domain->data_size = ALIGN(domain->data_size, domain->alignment);
+            fmmu->logical_start_address = domain->data_size;
+            fmmu->data_offset = domain->data_size;
+        }
+    }
+
     domain->data_size += fmmu->data_size;
     list_add_tail(&fmmu->list, &domain->fmmu_configs);
 
@@ -141,6 +283,11 @@ void ec_domain_add_fmmu_config(
  * The datagrams' types and expected working counters are determined by the
  * number of input and output fmmus that share the datagrams.
  *
+ * In pipelined mode, one pair is allocated per pipeline slot. The \a data of
+ * slot \a n are expected at \a n times the image size behind the given
+ * address. If inputs and outputs are split, a range with both is exchanged
+ * by an LWR pair followed by an LRD pair.
+ *
  * \retval  0 Success.
  * \retval <0 Error code.
  */
@@ -153,19 +300,48 @@ int ec_domain_add_datagram_pair(
         )
 {
     ec_datagram_pair_t *datagram_pair;
+    unsigned int dev_idx, slot;
     int ret;
 
-    if (!(datagram_pair = kmalloc(sizeof(ec_datagram_pair_t), GFP_KERNEL))) {
-        EC_MASTER_ERR(domain->master,
-                "Failed to allocate domain datagram pair!\n");
-        return -ENOMEM;
+    if (domain->split_io && used[EC_DIR_OUTPUT] && used[EC_DIR_INPUT]) {
+        unsigned int split_used[EC_DIR_COUNT] = {};
+
+        split_used[EC_DIR_OUTPUT] = used[EC_DIR_OUTPUT];
+        ret = ec_domain_add_datagram_pair(domain, logical_offset,
+                data_size, data, split_used);
+        if (ret < 0)
+            return ret;
+
+        split_used[EC_DIR_OUTPUT] = 0;
+        split_used[EC_DIR_INPUT] = used[EC_DIR_INPUT];
+        return ec_domain_add_datagram_pair(domain, logical_offset,
+                data_size, data, split_used);
     }
 
-    ret = ec_datagram_pair_init(datagram_pair, domain, logical_offset, data,
-            data_size, used);
-    if (ret) {
-        kfree(datagram_pair);
-        return ret;
+    for (slot = 0; slot < domain->pipeline_depth; slot++) {
+        if (!(datagram_pair = ec_domain_alloc_datagram_pair(domain))) {
+            EC_MASTER_ERR(domain->master,
+                    "Failed to allocate domain datagram pair!\n");
+            return -ENOMEM;
+        }
+
+        ret = ec_datagram_pair_init(datagram_pair, domain, logical_offset,
+                data + slot * domain->image_size, data_size, used);
+        if (ret) {
+            ec_domain_free_datagram_pair(domain, datagram_pair);
+            return ret;
+        }
+
+        datagram_pair->pipeline_slot = slot;
+        datagram_pair->input_phase = domain->split_io
+            && !used[EC_DIR_OUTPUT];
+
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+            datagram_pair->datagrams[dev_idx].timeout = domain->timeout;
+        }
+
+        list_add_tail(&datagram_pair->list, &domain->datagram_pairs);
     }
 
     domain->expected_working_counter +=
@@ -175,8 +351,6 @@ int ec_domain_add_datagram_pair(
             "Adding datagram pair with expected WC %u.\n",
             datagram_pair->expected_working_counter);
 
-
-    list_add_tail(&datagram_pair->list, &domain->datagram_pairs);
     return 0;
 }
 
@@ -213,6 +387,318 @@ int shall_count(
 
 /*****************************************************************************/
 
+/** Checks, if an input FMMU may share logical bytes with an output FMMU.
+ *
+ * The frame passes the slaves in the order of their ring positions. The
+ * outputs have to be read by their slave before the inputs are written to
+ * the same bytes, so the output slave must not come after the input slave.
+ * The ESC reads before it writes, so a slave may also share its own bytes.
+ *
+ * \return Non-zero, if the bytes may be shared.
+ */
+static int ec_domain_may_share(
+        const ec_fmmu_config_t *output, /**< Output FMMU. */
+        const ec_fmmu_config_t *input /**< Input FMMU. */
+        )
+{
+    const ec_slave_t *output_slave = output->sc->slave;
+    const ec_slave_t *input_slave = input->sc->slave;
+
+    return output_slave && input_slave
+        && output_slave->ring_position <= input_slave->ring_position;
+}
+
+/*****************************************************************************/
+
+/** Checks, if an input FMMU can be placed at a certain image offset.
+ *
+ * All outputs and the inputs before \a input in the list are already
+ * placed. The FMMU must not cross a datagram boundary.
+ *
+ * \return Non-zero, if the FMMU fits.
+ */
+static int ec_domain_input_fits(
+        const ec_domain_t *domain, /**< EtherCAT domain. */
+        const ec_fmmu_config_t *input, /**< Input FMMU to place. */
+        uint32_t offset /**< Image offset to check. */
+        )
+{
+    const ec_fmmu_config_t *fmmu;
+    int placed = 1;
+
+    if (offset % EC_MAX_DATA_SIZE + input->data_size > EC_MAX_DATA_SIZE) {
+        return 0;
+    }
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (fmmu == input) {
+            placed = 0; // following inputs are not placed yet
+            continue;
+        }
+
+        if ((fmmu->dir == EC_DIR_INPUT && !placed)
+                || offset >= fmmu->logical_start_address + fmmu->data_size
+                || fmmu->logical_start_address >= offset + input->data_size) {
+            continue;
+        }
+
+        if (fmmu->dir == EC_DIR_INPUT || !ec_domain_may_share(fmmu, input)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Computes the overlapping logical layout.
+ *
+ * The outputs are placed one after another. Then each input is placed at
+ * the lowest offset, where it does not collide with another input and only
+ * covers outputs it may share bytes with (see ec_domain_may_share()). The
+ * FMMU logical addresses are set relative to the domain start and \a
+ * image_size is calculated. The application's process data keep their
+ * non-overlapping layout.
+ */
+static void ec_domain_overlap_layout(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    ec_fmmu_config_t *fmmu;
+    const ec_fmmu_config_t *other;
+    uint32_t offset = 0, best, candidate;
+    int placed;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (fmmu->dir != EC_DIR_OUTPUT) {
+            continue;
+        }
+        if (offset % EC_MAX_DATA_SIZE + fmmu->data_size > EC_MAX_DATA_SIZE) {
+            offset = roundup(offset, EC_MAX_DATA_SIZE);
+        }
+        fmmu->logical_start_address = offset;
+        offset += fmmu->data_size;
+    }
+    domain->image_size = offset;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (fmmu->dir != EC_DIR_INPUT) {
+            continue;
+        }
+
+        // behind everything placed so far always fits
+        best = domain->image_size;
+        if (best % EC_MAX_DATA_SIZE + fmmu->data_size > EC_MAX_DATA_SIZE) {
+            best = roundup(best, EC_MAX_DATA_SIZE);
+        }
+
+        // try the datagram starts and the ends of the placed FMMUs
+        for (candidate = 0; candidate < best;
+                candidate += EC_MAX_DATA_SIZE) {
+            if (ec_domain_input_fits(domain, fmmu, candidate)) {
+                best = candidate;
+                break;
+            }
+        }
+        placed = 1;
+        list_for_each_entry(other, &domain->fmmu_configs, list) {
+            if (other == fmmu) {
+                placed = 0;
+                continue;
+            }
+            if (other->dir == EC_DIR_INPUT && !placed) {
+                continue;
+            }
+            candidate = other->logical_start_address + other->data_size;
+            if (candidate < best
+                    && ec_domain_input_fits(domain, fmmu, candidate)) {
+                best = candidate;
+            }
+        }
+
+        fmmu->logical_start_address = best;
+        if (best + fmmu->data_size > domain->image_size) {
+            domain->image_size = best + fmmu->data_size;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Packs the logical layout of an aligned domain.
+ *
+ * The alignment padding only exists in the application's process data. The
+ * FMMUs are placed back to back in the logical image.
+ */
+static void ec_domain_pack_layout(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    ec_fmmu_config_t *fmmu;
+    uint32_t offset = 0;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        fmmu->logical_start_address = offset;
+        offset += fmmu->data_size;
+    }
+}
+
+/*****************************************************************************/
+
+/** Sets up the datagrams for the overlapping layout.
+ *
+ * The image is split into datagrams of EC_MAX_DATA_SIZE bytes. No FMMU
+ * crosses a datagram boundary.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+static int ec_domain_finish_overlap(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    ec_fmmu_config_t *fmmu;
+    const ec_fmmu_config_t *other;
+    unsigned int used[EC_DIR_COUNT];
+    uint32_t start, end;
+    int ret, counted;
+
+    if (ec_master_num_devices(domain->master) > 1) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Overlapping layout can"
+                " not be used with redundancy!\n", domain->index);
+        return -EINVAL;
+    }
+
+    ec_domain_overlap_layout(domain);
+
+    if (!(domain->image = kzalloc(domain->image_size
+                    * domain->pipeline_depth, GFP_KERNEL))) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate %zu bytes"
+                " logical image for domain %u!\n",
+                domain->image_size * domain->pipeline_depth,
+                domain->index);
+        return -ENOMEM;
+    }
+
+    for (start = 0; start < domain->image_size; start += EC_MAX_DATA_SIZE) {
+        end = min(start + EC_MAX_DATA_SIZE, (uint32_t) domain->image_size);
+        used[EC_DIR_OUTPUT] = 0;
+        used[EC_DIR_INPUT] = 0;
+
+        // count each slave config once per direction
+        list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+            if (fmmu->logical_start_address < start
+                    || fmmu->logical_start_address >= end) {
+                continue;
+            }
+            counted = 0;
+            list_for_each_entry(other, &domain->fmmu_configs, list) {
+                if (other == fmmu) {
+                    break;
+                }
+                if (other->sc == fmmu->sc && other->dir == fmmu->dir
+                        && other->logical_start_address >= start
+                        && other->logical_start_address < end) {
+                    counted = 1;
+                    break;
+                }
+            }
+            if (!counted) {
+                used[fmmu->dir]++;
+            }
+        }
+
+        if (!used[EC_DIR_OUTPUT] && !used[EC_DIR_INPUT]) {
+            continue;
+        }
+
+        ret = ec_domain_add_datagram_pair(domain,
+                domain->logical_base_address + start, end - start,
+                domain->image + start, used);
+        if (ret < 0)
+            return ret;
+    }
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        fmmu->logical_start_address += domain->logical_base_address;
+    }
+
+    EC_MASTER_INFO(domain->master, "Domain%u: Overlapping layout with"
+            " %zu byte instead of %zu.\n", domain->index,
+            domain->image_size, domain->data_size);
+    return 0;
+}
+
+/*****************************************************************************/
+
+#if EC_MAX_NUM_DEVICES > 1
+
+/** Collects the input FMMU data ranges of each datagram pair.
+ *
+ * This lets ecrt_domain_process() merge the redundant datagrams without
+ * walking the FMMU list.
+ *
+ * \retval  0 Success.
+ * \retval <0 Error code.
+ */
+static int ec_domain_prepare_inputs(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    ec_datagram_pair_t *pair;
+    const ec_fmmu_config_t *fmmu;
+    uint32_t start;
+    size_t size;
+    unsigned int count;
+
+    list_for_each_entry(pair, &domain->datagram_pairs, list) {
+        if (pair->datagrams[EC_DEVICE_MAIN].type == EC_DATAGRAM_LWR) {
+            continue; // the inputs come with the LRD pair in split mode
+        }
+
+        start = EC_READ_U32(pair->datagrams[EC_DEVICE_MAIN].address);
+        size = pair->datagrams[EC_DEVICE_MAIN].data_size;
+
+        count = 0;
+        list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+            if (fmmu->dir == EC_DIR_INPUT
+                    && fmmu->logical_start_address >= start
+                    && fmmu->logical_start_address < start + size) {
+                count++;
+            }
+        }
+
+        if (!count) {
+            continue;
+        }
+
+        if (!(pair->inputs = kmalloc(sizeof(ec_datagram_pair_input_t)
+                        * count, GFP_KERNEL))) {
+            EC_MASTER_ERR(domain->master, "Failed to allocate input"
+                    " ranges for domain %u!\n", domain->index);
+            return -ENOMEM;
+        }
+
+        list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+            if (fmmu->dir == EC_DIR_INPUT
+                    && fmmu->logical_start_address >= start
+                    && fmmu->logical_start_address < start + size) {
+                ec_datagram_pair_input_t *input =
+                    &pair->inputs[pair->input_count++];
+                input->offset = fmmu->logical_start_address - start;
+                input->size = fmmu->data_size;
+            }
+        }
+    }
+
+    return 0;
+}
+
+#endif
+
+/*****************************************************************************/
+
 /** Finishes a domain.
  *
  * This allocates the necessary datagrams and writes the correct logical
@@ -230,6 +716,7 @@ int ec_domain_finish(
 {
     uint32_t datagram_offset;
     size_t datagram_size;
+    uint8_t *datagram_data;
     unsigned int datagram_count;
     unsigned int datagram_used[EC_DIR_COUNT];
     ec_fmmu_config_t *fmmu;
@@ -238,10 +725,45 @@ int ec_domain_finish(
     int ret;
 
     domain->logical_base_address = base_address;
+    domain->pipeline_slot = 0;
+    domain->queue_pending = 0;
+    domain->queue_inputs_pending = 0;
+    domain->cycle_countdown = domain->cycle_phase;
+
+    if (domain->zero_copy && domain->data_size) {
+        ec_device_t *device = &domain->master->devices[EC_DEVICE_MAIN];
+
+        if (domain->data_origin == EC_ORIG_EXTERNAL) {
+            EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                    " not be used with external memory!\n", domain->index);
+            return -EINVAL;
+        }
+        if (domain->alignment > 1) {
+            EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                    " not be used with aligned process data!\n",
+                    domain->index);
+            return -EINVAL;
+        }
+        if (domain->data_size > EC_MAX_DATA_SIZE) {
+            EC_MASTER_ERR(domain->master, "Domain %u: %zu bytes of process"
+                    " data exceed the maximum of %u bytes for zero-copy"
+                    " mode!\n", domain->index, domain->data_size,
+                    EC_MAX_DATA_SIZE);
+            return -EOVERFLOW;
+        }
+        if (device->tx_pinned_datagram) {
+            EC_MASTER_ERR(domain->master, "Domain %u: Another domain"
+                    " already uses zero-copy mode!\n", domain->index);
+            return -EBUSY;
+        }
+
+        domain->data = ec_device_pinned_payload(device);
+        domain->data_origin = EC_ORIG_EXTERNAL;
+    }
 
     if (domain->data_size && domain->data_origin == EC_ORIG_INTERNAL) {
-        if (!(domain->data =
-                    (uint8_t *) kmalloc(domain->data_size, GFP_KERNEL))) {
+        if (!(domain->data = (uint8_t *) kmalloc_node(domain->data_size,
+                        GFP_KERNEL, ec_master_node(domain->master)))) {
             EC_MASTER_ERR(domain->master, "Failed to allocate %zu bytes"
                     " internal memory for domain %u!\n",
                     domain->data_size, domain->index);
@@ -249,6 +771,62 @@ int ec_domain_finish(
         }
     }
 
+    if (domain->data_size) {
+        size_t size = domain->data_size +
+            EC_DOMAIN_BITMAP_SIZE(domain->data_size);
+
+        if (!(domain->input_snapshot = kmalloc_node(size, GFP_KERNEL,
+                        ec_master_node(domain->master)))) {
+            EC_MASTER_ERR(domain->master, "Failed to allocate %zu bytes"
+                    " input snapshot for domain %u!\n",
+                    size, domain->index);
+            return -ENOMEM;
+        }
+        memset(domain->input_snapshot, 0x00, domain->data_size);
+        domain->changed_inputs = domain->input_snapshot + domain->data_size;
+    }
+
+    ret = ec_history_alloc(&domain->history, domain->data_size);
+    if (ret) {
+        EC_MASTER_ERR(domain->master, "Failed to set up the process data"
+                " history of domain %u (code %i)!\n", domain->index, ret);
+        return ret;
+    }
+
+    if (domain->overlap && domain->data_size) {
+        ret = ec_domain_finish_overlap(domain);
+        if (ret < 0)
+            return ret;
+        goto out_info;
+    }
+
+    datagram_data = domain->data;
+
+    if ((domain->double_buffer || domain->pipeline_depth > 1
+                || domain->alignment > 1) && domain->data_size) {
+        if (ec_master_num_devices(domain->master) > 1) {
+            EC_MASTER_ERR(domain->master, "Domain %u: Double-buffered,"
+                    " pipelined and aligned mode can not be used with"
+                    " redundancy!\n", domain->index);
+            return -EINVAL;
+        }
+
+        if (domain->alignment > 1) {
+            ec_domain_pack_layout(domain);
+        }
+
+        if (!(domain->image = kzalloc(domain->data_size
+                        * domain->pipeline_depth, GFP_KERNEL))) {
+            EC_MASTER_ERR(domain->master, "Failed to allocate %zu bytes"
+                    " logical image for domain %u!\n",
+                    domain->data_size * domain->pipeline_depth,
+                    domain->index);
+            return -ENOMEM;
+        }
+        domain->image_size = domain->data_size;
+        datagram_data = domain->image;
+    }
+
     // Cycle through all domain FMMUs and
     // - correct the logical base addresses
     // - set up the datagrams to carry the process data
@@ -274,7 +852,7 @@ int ec_domain_finish(
         if (datagram_size + fmmu->data_size > EC_MAX_DATA_SIZE) {
             ret = ec_domain_add_datagram_pair(domain,
                     domain->logical_base_address + datagram_offset,
-                    datagram_size, domain->data + datagram_offset,
+                    datagram_size, datagram_data + datagram_offset,
                     datagram_used);
             if (ret < 0)
                 return ret;
@@ -301,21 +879,51 @@ int ec_domain_finish(
     if (datagram_size) {
         ret = ec_domain_add_datagram_pair(domain,
                 domain->logical_base_address + datagram_offset,
-                datagram_size, domain->data + datagram_offset,
+                datagram_size, datagram_data + datagram_offset,
                 datagram_used);
         if (ret < 0)
             return ret;
         datagram_count++;
     }
 
-    EC_MASTER_INFO(domain->master, "Domain%u: Logical address 0x%08x,"
-            " %zu byte, expected working counter %u.\n", domain->index,
-            domain->logical_base_address, domain->data_size,
+#if EC_MAX_NUM_DEVICES > 1
+    if (ec_master_num_devices(domain->master) > 1) {
+        ret = ec_domain_prepare_inputs(domain);
+        if (ret < 0)
+            return ret;
+    }
+#endif
+
+    if (domain->zero_copy && datagram_count) {
+        ec_datagram_pair_t *pair = list_entry(domain->datagram_pairs.next,
+                ec_datagram_pair_t, list);
+        ec_device_pin_datagram(&domain->master->devices[EC_DEVICE_MAIN],
+                &pair->datagrams[EC_DEVICE_MAIN]);
+    }
+
+out_info:
+    EC_MASTER_INFO(domain->master, "Domain%u: Logical address 0x%08x,"
+            " %zu byte, expected working counter %u.\n", domain->index,
+            domain->logical_base_address, domain->data_size,
             domain->expected_working_counter);
 
+    if (domain->pipeline_depth > 1) {
+        EC_MASTER_INFO(domain->master, "Domain%u: Pipelined with %u"
+                " datagram sets in flight.\n", domain->index,
+                domain->pipeline_depth);
+    }
+
+    if (domain->split_io) {
+        EC_MASTER_INFO(domain->master, "Domain%u: Inputs and outputs are"
+                " queued separately.\n", domain->index);
+    }
+
     list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
         const ec_datagram_t *datagram =
             &datagram_pair->datagrams[EC_DEVICE_MAIN];
+        if (datagram_pair->pipeline_slot) {
+            continue;
+        }
         EC_MASTER_INFO(domain->master, "  Datagram %s: Logical offset 0x%08x,"
                 " %zu byte, type %s.\n", datagram->name,
                 EC_READ_U32(datagram->address), datagram->data_size,
@@ -327,106 +935,919 @@ int ec_domain_finish(
 
 /*****************************************************************************/
 
-/** Get the number of FMMU configurations of the domain.
- */
-unsigned int ec_domain_fmmu_count(const ec_domain_t *domain)
+/** Checks, if any datagram of the domain is queued or waiting for reception.
+ *
+ * In pipelined mode, only the datagrams to be processed next are regarded.
+ *
+ * \return Non-zero, if a datagram is in flight.
+ */
+int ec_domain_in_flight(const ec_domain_t *domain /**< EtherCAT domain. */)
+{
+    const ec_datagram_pair_t *datagram_pair;
+    const ec_datagram_t *datagram;
+    unsigned int dev_idx;
+
+    list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+        if (datagram_pair->pipeline_slot != domain->pipeline_slot) {
+            continue;
+        }
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+            datagram = &datagram_pair->datagrams[dev_idx];
+            if (datagram->state == EC_DATAGRAM_QUEUED
+                    || datagram->state == EC_DATAGRAM_SENT) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Checks, if any datagram of the domain was sent and waits for reception.
+ *
+ * In pipelined mode, only the datagrams to be processed next are regarded.
+ *
+ * \return Non-zero, if a datagram was sent and not yet received.
+ */
+int ec_domain_awaiting_reception(
+        const ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    const ec_datagram_pair_t *datagram_pair;
+    unsigned int dev_idx;
+
+    list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+        if (datagram_pair->pipeline_slot != domain->pipeline_slot) {
+            continue;
+        }
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+            if (datagram_pair->datagrams[dev_idx].state == EC_DATAGRAM_SENT) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queues the domain, if a cycle divisor is set and it is due.
+ *
+ * Called by ecrt_master_send() once per send cycle.
+ */
+void ec_domain_auto_queue(ec_domain_t *domain /**< EtherCAT domain. */)
+{
+    if (!domain->cycle_divisor) {
+        return;
+    }
+
+    if (domain->cycle_countdown) {
+        domain->cycle_countdown--;
+        return;
+    }
+
+    ecrt_domain_queue(domain);
+    domain->cycle_countdown = domain->cycle_divisor - 1;
+}
+
+/*****************************************************************************/
+
+/** Appends the datagrams of the domain to the master's datagram queue, if
+ * ecrt_domain_queue() was called since the last call.
+ *
+ * If inputs and outputs are split, the input and output datagrams are
+ * appended separately, as requested by ecrt_domain_queue_inputs() and
+ * ecrt_domain_queue_outputs().
+ *
+ * Called by ecrt_master_send(), so that only the sending context touches
+ * the datagram queue.
+ */
+void ec_domain_queue_datagrams(ec_domain_t *domain /**< EtherCAT domain. */)
+{
+    ec_datagram_pair_t *datagram_pair;
+    ec_device_index_t dev_idx;
+    unsigned int outputs, inputs;
+
+    outputs = xchg(&domain->queue_pending, 0);
+    inputs = domain->split_io ?
+        xchg(&domain->queue_inputs_pending, 0) : outputs;
+    if (!outputs && !inputs) {
+        return;
+    }
+
+    list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+        if (datagram_pair->pipeline_slot != domain->queue_slot
+                || !(datagram_pair->input_phase ? inputs : outputs)) {
+            continue;
+        }
+
+        if (domain->segment >= 0) {
+            ec_master_queue_datagram(domain->master,
+                    &datagram_pair->datagrams[domain->segment]);
+            continue;
+        }
+
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+            ec_master_queue_datagram(domain->master,
+                    &datagram_pair->datagrams[dev_idx]);
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Get the number of FMMU configurations of the domain.
+ */
+unsigned int ec_domain_fmmu_count(const ec_domain_t *domain)
+{
+    const ec_fmmu_config_t *fmmu;
+    unsigned int num = 0;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        num++;
+    }
+
+    return num;
+}
+
+/*****************************************************************************/
+
+/** Get a certain FMMU configuration via its position in the list.
+ *
+ * \return FMMU at position \a pos, or NULL.
+ */
+const ec_fmmu_config_t *ec_domain_find_fmmu(
+        const ec_domain_t *domain, /**< EtherCAT domain. */
+        unsigned int pos /**< List position. */
+        )
+{
+    const ec_fmmu_config_t *fmmu;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (pos--)
+            continue;
+        return fmmu;
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Gets the result of the last working counter fault probe.
+ *
+ * The probe result is written by the master state machine, so this may be
+ * called in realtime context.
+ *
+ * \return Number of faulty slaves. The ring positions of the first ones (up
+ * to #EC_MAX_WC_FAULT_SLAVES) are stored in \a positions.
+ */
+unsigned int ec_domain_wc_faults(
+        const ec_domain_t *domain, /**< EtherCAT domain. */
+        uint16_t *positions /**< Ring positions of the faulty slaves. */
+        )
+{
+    unsigned int count = smp_load_acquire(&domain->wc_fault_count);
+
+    memcpy(positions, domain->wc_fault_slaves,
+            min(count, (unsigned int) EC_MAX_WC_FAULT_SLAVES)
+            * sizeof(*positions));
+    return count;
+}
+
+/*****************************************************************************/
+
+/** Stores the result of a working counter fault probe.
+ *
+ * Called by the master state machine.
+ */
+void ec_domain_set_wc_faults(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        const uint16_t *positions, /**< Ring positions of the faulty slaves
+                                     (up to #EC_MAX_WC_FAULT_SLAVES). */
+        unsigned int count /**< Number of faulty slaves. */
+        )
+{
+    WRITE_ONCE(domain->wc_fault_count, 0);
+    smp_wmb();
+    memcpy(domain->wc_fault_slaves, positions,
+            min(count, (unsigned int) EC_MAX_WC_FAULT_SLAVES)
+            * sizeof(*positions));
+    smp_store_release(&domain->wc_fault_count, count);
+}
+
+/*****************************************************************************/
+
+/** Copies the outputs from the process data to the logical image of the
+ * current pipeline slot.
+ */
+static void ec_domain_copy_outputs(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    uint8_t *image =
+        domain->image + domain->pipeline_slot * domain->image_size;
+    const ec_fmmu_config_t *fmmu;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        if (fmmu->dir != EC_DIR_OUTPUT) {
+            continue;
+        }
+        memcpy(image + fmmu->logical_start_address
+                - domain->logical_base_address,
+                domain->data + fmmu->data_offset, fmmu->data_size);
+    }
+}
+
+/*****************************************************************************/
+
+/** Copies the received inputs of a datagram pair from the logical image to
+ * the process data.
+ *
+ * If the datagram was not received, the image still contains the outputs, so
+ * the inputs are left untouched.
+ */
+static void ec_domain_copy_inputs(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        const ec_datagram_pair_t *pair /**< Datagram pair. */
+        )
+{
+    const ec_datagram_t *datagram = &pair->datagrams[EC_DEVICE_MAIN];
+    const uint8_t *image =
+        domain->image + pair->pipeline_slot * domain->image_size;
+    const ec_fmmu_config_t *fmmu;
+    uint32_t start, offset;
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        return;
+    }
+
+    start = EC_READ_U32(datagram->address) - domain->logical_base_address;
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        offset = fmmu->logical_start_address - domain->logical_base_address;
+        if (fmmu->dir != EC_DIR_INPUT || offset < start
+                || offset >= start + datagram->data_size) {
+            continue;
+        }
+        memcpy(domain->data + fmmu->data_offset, image + offset,
+                fmmu->data_size);
+    }
+}
+
+/*****************************************************************************/
+
+/** Prepares the datagram pairs of the current pipeline slot for queueing.
+ *
+ * Copies the main data of the pairs to their send buffers, which are also
+ * the payload of the backup datagrams.
+ */
+static void ec_domain_prepare_queue(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        int input_phase /**< Only prepare the input (1) or output (0) pairs
+                          of a domain with split inputs and outputs, or all
+                          pairs (-1). */
+        )
+{
+#if EC_MAX_NUM_DEVICES > 1
+    ec_datagram_pair_t *datagram_pair;
+
+    list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+        if (datagram_pair->pipeline_slot != domain->pipeline_slot
+                || (input_phase >= 0
+                    && datagram_pair->input_phase != input_phase)) {
+            continue;
+        }
+
+        memcpy(datagram_pair->send_buffer,
+                datagram_pair->datagrams[EC_DEVICE_MAIN].data,
+                datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+    }
+#endif
+}
+
+/*****************************************************************************/
+
+/** Copies the process data of all routes with the domain as the source.
+ */
+static void ec_domain_apply_routes(
+        ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    const ec_domain_route_t *route;
+    const uint8_t *src;
+    uint8_t *dst;
+    unsigned int i, s, d;
+
+    list_for_each_entry(route, &domain->routes, list) {
+        src = domain->data;
+        dst = route->dst_domain->data;
+
+        if (!(route->src_offset % 8) && !(route->dst_offset % 8)
+                && !(route->bits % 8)) {
+            memcpy(dst + route->dst_offset / 8, src + route->src_offset / 8,
+                    route->bits / 8);
+            continue;
+        }
+
+        for (i = 0; i < route->bits; i++) {
+            s = route->src_offset + i;
+            d = route->dst_offset + i;
+            if (src[s / 8] & (1 << (s % 8))) {
+                dst[d / 8] |= 1 << (d % 8);
+            } else {
+                dst[d / 8] &= ~(1 << (d % 8));
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
+
+#if EC_MAX_NUM_DEVICES > 1
+
+/** Process received data.
+ *
+ * Compares the received data with the sent data word by word, using a
+ * byte-wise loop only for the remainder.
+ *
+ * \return Non-zero, if the data have been changed by a slave.
+ */
+int data_changed(
+        uint8_t *send_buffer,
+        const ec_datagram_t *datagram,
+        size_t offset,
+        size_t size
+        )
+{
+    const uint8_t *sent = send_buffer + offset;
+    const uint8_t *recv = datagram->data + offset;
+    size_t i = 0;
+
+    for (; i + sizeof(unsigned long) <= size; i += sizeof(unsigned long)) {
+        if (get_unaligned((const unsigned long *) (recv + i)) !=
+                get_unaligned((const unsigned long *) (sent + i))) {
+            return 1;
+        }
+    }
+
+    for (; i < size; i++) {
+        if (recv[i] != sent[i]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Checks, via which devices the datagrams of a redundant pair returned.
+ *
+ * In a closed ring, each datagram returns via another device than the one
+ * that sent it. A datagram returning via its own device was reflected at a
+ * break of the ring.
+ *
+ * \return Non-zero, if a datagram of the pair was reflected.
+ */
+static unsigned int ec_domain_pair_reflected(
+        const ec_datagram_pair_t *pair, /**< Datagram pair. */
+        unsigned int *received /**< Set, if a datagram was received. */
+        )
+{
+    const ec_datagram_t *datagram;
+    unsigned int dev_idx, reflected = 0;
+
+    for (dev_idx = EC_DEVICE_MAIN;
+            dev_idx < ec_master_num_devices(pair->domain->master);
+            dev_idx++) {
+        datagram = &pair->datagrams[dev_idx];
+        if (datagram->state != EC_DATAGRAM_RECEIVED) {
+            continue;
+        }
+        *received = 1;
+        if (datagram->rx_device_index == dev_idx) {
+            reflected = 1;
+        }
+    }
+
+    return reflected;
+}
+
+/*****************************************************************************/
+
+/** Updates the ring redundancy statistics after a cycle.
+ */
+static void ec_domain_update_redundancy(
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        unsigned int reflected, /**< A datagram was reflected. */
+        unsigned int lost, /**< A datagram pair was not received at all. */
+        ktime_t now /**< Time of the check. */
+        )
+{
+    ec_domain_redundancy_t *red = &domain->redundancy;
+
+    if (reflected) {
+        red->degraded_cycles++;
+    }
+    if (lost) {
+        red->lost_cycles++;
+    }
+
+    if (reflected && !red->ring_broken) {
+        red->ring_broken = 1;
+        red->failovers++;
+        red->failover_time = ktime_to_ns(now);
+#ifdef EC_RT_SYSLOG
+        EC_MASTER_RT_WARN(domain->master, EC_RT_LOG_DOMAIN,
+                "Domain %u: Ring broken, datagrams reflected!\n",
+                domain->index);
+#endif
+    } else if (!reflected && !lost && red->ring_broken) {
+        red->ring_broken = 0;
+        red->restore_time = ktime_to_ns(now);
+#ifdef EC_RT_SYSLOG
+        EC_MASTER_RT_INFO(domain->master, EC_RT_LOG_DOMAIN,
+                "Domain %u: Ring closed again.\n", domain->index);
+#endif
+    }
+}
+
+#endif
+
+/******************************************************************************
+ *  Application interface
+ *****************************************************************************/
+
+int ecrt_domain_reg_pdo_entry_list(ec_domain_t *domain,
+        const ec_pdo_entry_reg_t *regs)
+{
+    const ec_pdo_entry_reg_t *reg;
+    ec_slave_config_t *sc;
+    int ret;
+
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_reg_pdo_entry_list("
+            "domain = 0x%p, regs = 0x%p)\n", domain, regs);
+
+    for (reg = regs; reg->index; reg++) {
+        sc = ecrt_master_slave_config_err(domain->master, reg->alias,
+                reg->position, reg->vendor_id, reg->product_code);
+        if (IS_ERR(sc))
+            return PTR_ERR(sc);
+
+        ret = ecrt_slave_config_reg_pdo_entry(sc, reg->index,
+                        reg->subindex, domain, reg->bit_position);
+        if (ret < 0)
+            return ret;
+
+        *reg->offset = ret;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+ec_bit_map_t *ecrt_domain_reg_bit_map(ec_domain_t *domain,
+        const ec_pdo_entry_reg_t *regs)
+{
+    const ec_pdo_entry_reg_t *reg;
+    unsigned int *offsets, *bit_positions, count = 0, i;
+    ec_slave_config_t *sc;
+    ec_bit_map_t *bit_map = NULL;
+    int ret;
+
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_reg_bit_map("
+            "domain = 0x%p, regs = 0x%p)\n", domain, regs);
+
+    for (reg = regs; reg->index; reg++) {
+        count++;
+    }
+
+    offsets = kmalloc((2 * count + 1) * sizeof(unsigned int), GFP_KERNEL);
+    if (!offsets) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate bit map.\n");
+        return NULL;
+    }
+    bit_positions = offsets + count;
+
+    for (reg = regs, i = 0; reg->index; reg++, i++) {
+        sc = ecrt_master_slave_config_err(domain->master, reg->alias,
+                reg->position, reg->vendor_id, reg->product_code);
+        if (IS_ERR(sc))
+            goto out;
+
+        ret = ecrt_slave_config_reg_pdo_entry(sc, reg->index,
+                        reg->subindex, domain, &bit_positions[i]);
+        if (ret < 0)
+            goto out;
+
+        offsets[i] = ret;
+        if (reg->offset)
+            *reg->offset = ret;
+        if (reg->bit_position)
+            *reg->bit_position = bit_positions[i];
+    }
+
+    bit_map = ec_bit_map_create(offsets, bit_positions, count);
+    if (!bit_map) {
+        EC_MASTER_ERR(domain->master, "Failed to allocate bit map.\n");
+        goto out;
+    }
+
+    down(&domain->master->master_sem);
+    bit_map->next = domain->bit_maps;
+    domain->bit_maps = bit_map;
+    up(&domain->master->master_sem);
+
+out:
+    kfree(offsets);
+    return bit_map;
+}
+
+/*****************************************************************************/
+
+size_t ecrt_domain_size(const ec_domain_t *domain)
+{
+    return domain->data_size;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_zero_copy(ec_domain_t *domain)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_zero_copy("
+            "domain = 0x%p)\n", domain);
+
+    down(&domain->master->master_sem);
+
+    if (domain->data_origin == EC_ORIG_EXTERNAL) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                " not be used with external memory!\n", domain->index);
+        return -EINVAL;
+    }
+
+    if (domain->overlap) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                " not be used with the overlapping layout!\n",
+                domain->index);
+        return -EINVAL;
+    }
+
+    if (domain->double_buffer) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                " not be used in double-buffered mode!\n", domain->index);
+        return -EINVAL;
+    }
+
+    if (domain->pipeline_depth > 1) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                " not be used in pipelined mode!\n", domain->index);
+        return -EINVAL;
+    }
+
+    if (domain->split_io) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Zero-copy mode can"
+                " not be used with split inputs and outputs!\n",
+                domain->index);
+        return -EINVAL;
+    }
+
+    domain->zero_copy = 1;
+
+    up(&domain->master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_overlap(ec_domain_t *domain)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_overlap("
+            "domain = 0x%p)\n", domain);
+
+    if (ec_master_num_devices(domain->master) > 1) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Overlapping layout can"
+                " not be used with redundancy!\n", domain->index);
+        return -EINVAL;
+    }
+
+    down(&domain->master->master_sem);
+
+    if (domain->zero_copy) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Overlapping layout can"
+                " not be used in zero-copy mode!\n", domain->index);
+        return -EINVAL;
+    }
+
+    domain->overlap = 1;
+
+    up(&domain->master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_pipeline_depth(ec_domain_t *domain, unsigned int depth)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_set_pipeline_depth("
+            "domain = 0x%p, depth = %u)\n", domain, depth);
+
+    if (!depth || depth > EC_MAX_PIPELINE_DEPTH) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Invalid pipeline"
+                " depth %u!\n", domain->index, depth);
+        return -EINVAL;
+    }
+
+    if (depth > 1 && ec_master_num_devices(domain->master) > 1) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Pipelined mode can"
+                " not be used with redundancy!\n", domain->index);
+        return -EINVAL;
+    }
+
+    down(&domain->master->master_sem);
+
+    if (domain->master->active) {
+        up(&domain->master->master_sem);
+        return -EBUSY;
+    }
+
+    if (depth > 1 && domain->zero_copy) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Pipelined mode can"
+                " not be used in zero-copy mode!\n", domain->index);
+        return -EINVAL;
+    }
+
+    if (depth > 1 && domain->split_io) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Pipelined mode can"
+                " not be used with split inputs and outputs!\n",
+                domain->index);
+        return -EINVAL;
+    }
+
+    domain->pipeline_depth = depth;
+
+    up(&domain->master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_add_route(ec_domain_t *src_domain, unsigned int src_offset,
+        unsigned int src_bit, ec_domain_t *dst_domain,
+        unsigned int dst_offset, unsigned int dst_bit, unsigned int bits)
+{
+    ec_master_t *master = src_domain->master;
+    ec_domain_route_t *route;
+
+    EC_MASTER_DBG(master, 1, "ecrt_domain_add_route(src_domain = 0x%p,"
+            " src_offset = %u, src_bit = %u, dst_domain = 0x%p,"
+            " dst_offset = %u, dst_bit = %u, bits = %u)\n",
+            src_domain, src_offset, src_bit, dst_domain, dst_offset,
+            dst_bit, bits);
+
+    if (dst_domain->master != master) {
+        EC_MASTER_ERR(master, "Route destination belongs to another"
+                " master!\n");
+        return -EINVAL;
+    }
+
+    if (!bits || src_bit > 7 || dst_bit > 7
+            || src_offset * 8ULL + src_bit + bits
+            > src_domain->data_size * 8ULL
+            || dst_offset * 8ULL + dst_bit + bits
+            > dst_domain->data_size * 8ULL) {
+        EC_MASTER_ERR(master, "Invalid process data route from"
+                " domain %u to domain %u!\n",
+                src_domain->index, dst_domain->index);
+        return -EINVAL;
+    }
+
+    if (!(route = kmalloc(sizeof(ec_domain_route_t), GFP_KERNEL))) {
+        EC_MASTER_ERR(master, "Failed to allocate process data route!\n");
+        return -ENOMEM;
+    }
+
+    INIT_LIST_HEAD(&route->list);
+    route->dst_domain = dst_domain;
+    route->src_offset = src_offset * 8 + src_bit;
+    route->dst_offset = dst_offset * 8 + dst_bit;
+    route->bits = bits;
+
+    down(&master->master_sem);
+
+    if (master->active) {
+        up(&master->master_sem);
+        kfree(route);
+        return -EBUSY;
+    }
+
+    list_add_tail(&route->list, &src_domain->routes);
+
+    up(&master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_alignment(ec_domain_t *domain, size_t alignment)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_set_alignment("
+            "domain = 0x%p, alignment = %zu)\n", domain, alignment);
+
+    if (!alignment) {
+        alignment = 1;
+    }
+
+    if (alignment & (alignment - 1) || alignment > PAGE_SIZE) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Invalid alignment %zu!\n",
+                domain->index, alignment);
+        return -EINVAL;
+    }
+
+    if (alignment > 1 && ec_master_num_devices(domain->master) > 1) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Aligned process data can"
+                " not be used with redundancy!\n", domain->index);
+        return -EINVAL;
+    }
+
+    down(&domain->master->master_sem);
+
+    if (!list_empty(&domain->fmmu_configs)) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Alignment has to be set"
+                " before registering PDO entries!\n", domain->index);
+        return -EBUSY;
+    }
+
+    domain->alignment = alignment;
+
+    up(&domain->master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_cycle_divisor(ec_domain_t *domain, unsigned int divisor,
+        unsigned int phase)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_set_cycle_divisor("
+            "domain = 0x%p, divisor = %u, phase = %u)\n",
+            domain, divisor, phase);
+
+    if (divisor ? phase >= divisor : phase) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Invalid cycle phase %u"
+                " for divisor %u!\n", domain->index, phase, divisor);
+        return -EINVAL;
+    }
+
+    down(&domain->master->master_sem);
+
+    if (domain->master->active) {
+        up(&domain->master->master_sem);
+        return -EBUSY;
+    }
+
+    domain->cycle_divisor = divisor;
+    domain->cycle_phase = phase;
+
+    up(&domain->master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_set_segment(ec_domain_t *domain, unsigned int segment)
 {
-    const ec_fmmu_config_t *fmmu;
-    unsigned int num = 0;
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_set_segment("
+            "domain = 0x%p, segment = %u)\n", domain, segment);
 
-    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
-        num++;
+    if (segment >= ec_master_num_devices(domain->master)) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Invalid segment %u!\n",
+                domain->index, segment);
+        return -EINVAL;
     }
 
-    return num;
-}
-
-/*****************************************************************************/
-
-/** Get a certain FMMU configuration via its position in the list.
- *
- * \return FMMU at position \a pos, or NULL.
- */
-const ec_fmmu_config_t *ec_domain_find_fmmu(
-        const ec_domain_t *domain, /**< EtherCAT domain. */
-        unsigned int pos /**< List position. */
-        )
-{
-    const ec_fmmu_config_t *fmmu;
+    down(&domain->master->master_sem);
 
-    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
-        if (pos--)
-            continue;
-        return fmmu;
+    if (domain->master->active) {
+        up(&domain->master->master_sem);
+        return -EBUSY;
     }
 
-    return NULL;
+    domain->segment = segment;
+
+    up(&domain->master->master_sem);
+    return 0;
 }
 
 /*****************************************************************************/
 
-#if EC_MAX_NUM_DEVICES > 1
-
-/** Process received data.
- */
-int data_changed(
-        uint8_t *send_buffer,
-        const ec_datagram_t *datagram,
-        size_t offset,
-        size_t size
-        )
+int ecrt_domain_double_buffer(ec_domain_t *domain)
 {
-    uint8_t *sent = send_buffer + offset;
-    uint8_t *recv = datagram->data + offset;
-    size_t i;
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_double_buffer("
+            "domain = 0x%p)\n", domain);
 
-    for (i = 0; i < size; i++) {
-        if (recv[i] != sent[i]) {
-            return 1;
-        }
+    if (ec_master_num_devices(domain->master) > 1) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Double-buffered mode can"
+                " not be used with redundancy!\n", domain->index);
+        return -EINVAL;
+    }
+
+    down(&domain->master->master_sem);
+
+    if (domain->zero_copy) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Double-buffered mode can"
+                " not be used in zero-copy mode!\n", domain->index);
+        return -EINVAL;
     }
 
+    domain->double_buffer = 1;
+
+    up(&domain->master->master_sem);
     return 0;
 }
 
-#endif
-
-/******************************************************************************
- *  Application interface
- *****************************************************************************/
+/*****************************************************************************/
 
-int ecrt_domain_reg_pdo_entry_list(ec_domain_t *domain,
-        const ec_pdo_entry_reg_t *regs)
+int ecrt_domain_split_io(ec_domain_t *domain)
 {
-    const ec_pdo_entry_reg_t *reg;
-    ec_slave_config_t *sc;
-    int ret;
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_split_io("
+            "domain = 0x%p)\n", domain);
 
-    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_reg_pdo_entry_list("
-            "domain = 0x%p, regs = 0x%p)\n", domain, regs);
+    down(&domain->master->master_sem);
 
-    for (reg = regs; reg->index; reg++) {
-        sc = ecrt_master_slave_config_err(domain->master, reg->alias,
-                reg->position, reg->vendor_id, reg->product_code);
-        if (IS_ERR(sc))
-            return PTR_ERR(sc);
+    if (domain->master->active) {
+        up(&domain->master->master_sem);
+        return -EBUSY;
+    }
 
-        ret = ecrt_slave_config_reg_pdo_entry(sc, reg->index,
-                        reg->subindex, domain, reg->bit_position);
-        if (ret < 0)
-            return ret;
+    if (domain->zero_copy) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Split inputs and outputs"
+                " can not be used in zero-copy mode!\n", domain->index);
+        return -EINVAL;
+    }
 
-        *reg->offset = ret;
+    if (domain->pipeline_depth > 1) {
+        up(&domain->master->master_sem);
+        EC_MASTER_ERR(domain->master, "Domain %u: Split inputs and outputs"
+                " can not be used in pipelined mode!\n", domain->index);
+        return -EINVAL;
     }
 
+    domain->split_io = 1;
+
+    up(&domain->master->master_sem);
     return 0;
 }
 
 /*****************************************************************************/
 
-size_t ecrt_domain_size(const ec_domain_t *domain)
+int ecrt_domain_set_timeout(ec_domain_t *domain, unsigned int timeout_us)
 {
-    return domain->data_size;
+    ec_datagram_pair_t *datagram_pair;
+    unsigned int dev_idx;
+
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_set_timeout("
+            "domain = 0x%p, timeout_us = %u)\n", domain, timeout_us);
+
+    if (!timeout_us) {
+        timeout_us = EC_IO_TIMEOUT;
+    } else if (timeout_us > EC_MAX_IO_TIMEOUT) {
+        EC_MASTER_ERR(domain->master, "Domain %u: Invalid timeout %u us!\n",
+                domain->index, timeout_us);
+        return -EINVAL;
+    }
+
+    down(&domain->master->master_sem);
+
+    domain->timeout = ktime_set(0, timeout_us * NSEC_PER_USEC);
+
+    list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+            datagram_pair->datagrams[dev_idx].timeout = domain->timeout;
+        }
+    }
+
+    up(&domain->master->master_sem);
+    return 0;
 }
 
 /*****************************************************************************/
@@ -457,91 +1878,120 @@ uint8_t *ecrt_domain_data(ec_domain_t *domain)
 
 void ecrt_domain_process(ec_domain_t *domain)
 {
-    uint16_t wc_sum[EC_MAX_NUM_DEVICES] = {}, wc_total;
+    uint16_t wc_sum[EC_MAX_NUM_DEVICES] = {}, wc_total, wc_last;
     ec_datagram_pair_t *pair;
+    const ec_datagram_t *rx_datagram;
+    ktime_t start = ktime_get();
+    u32 round_trip = 0;
+    unsigned int received = 0;
 #if EC_MAX_NUM_DEVICES > 1
     uint16_t datagram_pair_wc, redundant_wc;
-    unsigned int datagram_offset;
-    ec_fmmu_config_t *fmmu = list_first_entry(&domain->fmmu_configs,
-            ec_fmmu_config_t, list);
-    unsigned int redundancy;
-#endif
-    unsigned int dev_idx;
-#ifdef EC_RT_SYSLOG
-    unsigned int wc_change;
+    unsigned int datagram_offset, i;
+    unsigned int redundancy, reflected = 0, lost = 0, pair_received;
 #endif
+    unsigned int dev_idx, wc_change;
 
 #if DEBUG_REDUNDANCY
     EC_MASTER_DBG(domain->master, 1, "domain %u process\n", domain->index);
 #endif
 
+    if (domain->map_sequence) {
+        (*domain->map_sequence)++;
+        smp_wmb();
+    }
+
     list_for_each_entry(pair, &domain->datagram_pairs, list) {
+        if (pair->pipeline_slot != domain->pipeline_slot) {
+            continue;
+        }
+
 #if EC_MAX_NUM_DEVICES > 1
         datagram_pair_wc = ec_datagram_pair_process(pair, wc_sum);
 #else
         ec_datagram_pair_process(pair, wc_sum);
 #endif
 
+        // the domain's round trip ends with its last datagram
+        rx_datagram = &pair->datagrams[
+            domain->segment >= 0 ? domain->segment : EC_DEVICE_MAIN];
+        if (rx_datagram->state == EC_DATAGRAM_RECEIVED) {
+            round_trip = max(round_trip,
+                    ec_datagram_round_trip_time(rx_datagram));
+            received = 1;
+        }
+
 #if EC_MAX_NUM_DEVICES > 1
-        if (ec_master_num_devices(domain->master) > 1) {
+        if (domain->segment > EC_DEVICE_MAIN) {
+            /* The datagram was exchanged on another line only: Its data
+             * replace the main data. */
+            ec_datagram_t *datagram = &pair->datagrams[domain->segment];
+
+            if (datagram->state == EC_DATAGRAM_RECEIVED) {
+                memcpy(pair->datagrams[EC_DEVICE_MAIN].data, datagram->data,
+                        datagram->data_size);
+            }
+        }
+#endif
+
+        if (domain->image) {
+            ec_domain_copy_inputs(domain, pair);
+        }
+
+#if EC_MAX_NUM_DEVICES > 1
+        if (ec_master_num_devices(domain->master) > 1
+                && domain->segment < 0) {
             ec_datagram_t *main_datagram = &pair->datagrams[EC_DEVICE_MAIN];
+#if DEBUG_REDUNDANCY
             uint32_t logical_datagram_address =
                 EC_READ_U32(main_datagram->address);
-            size_t datagram_size = main_datagram->data_size;
 
-#if DEBUG_REDUNDANCY
             EC_MASTER_DBG(domain->master, 1, "dgram %s log=%u\n",
                     main_datagram->name, logical_datagram_address);
 #endif
 
-            /* Redundancy: Go through FMMU configs to detect data changes. */
-            list_for_each_entry_from(fmmu, &domain->fmmu_configs, list) {
+            pair_received = 0;
+            reflected |= ec_domain_pair_reflected(pair, &pair_received);
+            lost |= !pair_received;
+
+            /* Redundancy: Go through the inputs to detect data changes. */
+            for (i = 0; i < pair->input_count; i++) {
                 ec_datagram_t *backup_datagram =
                     &pair->datagrams[EC_DEVICE_BACKUP];
+                size_t input_size = pair->inputs[i].size;
 
-                if (fmmu->dir != EC_DIR_INPUT) {
-                    continue;
-                }
-
-                if (fmmu->logical_start_address >=
-                        logical_datagram_address + datagram_size) {
-                    // fmmu data contained in next datagram pair
-                    break;
-                }
-
-                datagram_offset =
-                    fmmu->logical_start_address - logical_datagram_address;
+                datagram_offset = pair->inputs[i].offset;
 
 #if DEBUG_REDUNDANCY
                 EC_MASTER_DBG(domain->master, 1,
-                        "input fmmu log=%u size=%u offset=%u\n",
-                        fmmu->logical_start_address, fmmu->data_size,
-                        datagram_offset);
+                        "input log=%u size=%zu offset=%u\n",
+                        logical_datagram_address + datagram_offset,
+                        input_size, datagram_offset);
                 if (domain->master->debug_level > 0) {
                     ec_print_data(pair->send_buffer + datagram_offset,
-                            fmmu->data_size);
+                            input_size);
                     ec_print_data(main_datagram->data + datagram_offset,
-                            fmmu->data_size);
+                            input_size);
                     ec_print_data(backup_datagram->data + datagram_offset,
-                            fmmu->data_size);
+                            input_size);
                 }
 #endif
 
                 if (data_changed(pair->send_buffer, main_datagram,
-                            datagram_offset, fmmu->data_size)) {
+                            datagram_offset, input_size)) {
                     /* data changed on main link: no copying necessary. */
 #if DEBUG_REDUNDANCY
                     EC_MASTER_DBG(domain->master, 1, "main changed\n");
 #endif
-                } else if (data_changed(pair->send_buffer, backup_datagram,
-                            datagram_offset, fmmu->data_size)) {
+                } else if (backup_datagram->state == EC_DATAGRAM_RECEIVED
+                        && data_changed(pair->send_buffer, backup_datagram,
+                            datagram_offset, input_size)) {
                     /* data changed on backup link: copy to main memory. */
 #if DEBUG_REDUNDANCY
                     EC_MASTER_DBG(domain->master, 1, "backup changed\n");
 #endif
                     memcpy(main_datagram->data + datagram_offset,
                             backup_datagram->data + datagram_offset,
-                            fmmu->data_size);
+                            input_size);
                 } else if (datagram_pair_wc ==
                         pair->expected_working_counter) {
                     /* no change, but WC complete: use main data. */
@@ -563,6 +2013,10 @@ void ecrt_domain_process(ec_domain_t *domain)
 #endif // EC_MAX_NUM_DEVICES > 1
     }
 
+    if (!list_empty(&domain->routes)) {
+        ec_domain_apply_routes(domain);
+    }
+
 #if EC_MAX_NUM_DEVICES > 1
     redundant_wc = 0;
     for (dev_idx = EC_DEVICE_BACKUP;
@@ -570,15 +2024,19 @@ void ecrt_domain_process(ec_domain_t *domain)
         redundant_wc += wc_sum[dev_idx];
     }
 
-    redundancy = redundant_wc > 0;
+    if (ec_master_num_devices(domain->master) > 1 && domain->segment < 0) {
+        ec_domain_update_redundancy(domain, reflected, lost, start);
+    }
+
+    redundancy = domain->segment < 0 && redundant_wc > 0;
     if (redundancy != domain->redundancy_active) {
 #ifdef EC_RT_SYSLOG
         if (redundancy) {
-            EC_MASTER_WARN(domain->master,
+            EC_MASTER_RT_WARN(domain->master, EC_RT_LOG_DOMAIN,
                     "Domain %u: Redundant link in use!\n",
                     domain->index);
         } else {
-            EC_MASTER_INFO(domain->master,
+            EC_MASTER_RT_INFO(domain->master, EC_RT_LOG_DOMAIN,
                     "Domain %u: Redundant link unused again.\n",
                     domain->index);
         }
@@ -589,21 +2047,32 @@ void ecrt_domain_process(ec_domain_t *domain)
     domain->redundancy_active = 0;
 #endif
 
-#ifdef EC_RT_SYSLOG
     wc_change = 0;
-#endif
     wc_total = 0;
+    wc_last = 0;
     for (dev_idx = EC_DEVICE_MAIN;
             dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
+        wc_last += domain->working_counter[dev_idx];
         if (wc_sum[dev_idx] != domain->working_counter[dev_idx]) {
-#ifdef EC_RT_SYSLOG
             wc_change = 1;
-#endif
             domain->working_counter[dev_idx] = wc_sum[dev_idx];
         }
         wc_total += wc_sum[dev_idx];
     }
 
+    if (wc_change) {
+        trace_ec_domain_wc_change(domain->master->index, domain->index,
+                wc_total, domain->expected_working_counter);
+        ec_master_capture_trigger(domain->master, EC_CAPTURE_WC_CHANGE);
+        if (wc_total < wc_last) {
+            // the master state machine probes the slaves for the culprit
+            WRITE_ONCE(domain->wc_drops, domain->wc_drops + 1);
+            if (domain->history.flags & EC_HISTORY_FREEZE_ON_WC) {
+                ec_history_trigger(&domain->history);
+            }
+        }
+    }
+
 #ifdef EC_RT_SYSLOG
     if (wc_change) {
         domain->working_counter_changes++;
@@ -611,66 +2080,125 @@ void ecrt_domain_process(ec_domain_t *domain)
 
     if (domain->working_counter_changes &&
         jiffies - domain->notify_jiffies > HZ) {
-        domain->notify_jiffies = jiffies;
-        if (domain->working_counter_changes == 1) {
-            EC_MASTER_INFO(domain->master, "Domain %u: Working counter"
-                    " changed to %u/%u", domain->index,
-                    wc_total, domain->expected_working_counter);
-        } else {
-            EC_MASTER_INFO(domain->master, "Domain %u: %u working counter"
-                    " changes - now %u/%u", domain->index,
-                    domain->working_counter_changes,
-                    wc_total, domain->expected_working_counter);
-        }
+        char devs[EC_MAX_NUM_DEVICES * 6 + 3] = "";
 #if EC_MAX_NUM_DEVICES > 1
+        size_t len = 0;
+
         if (ec_master_num_devices(domain->master) > 1) {
-            printk(" (");
             for (dev_idx = EC_DEVICE_MAIN;
                     dev_idx < ec_master_num_devices(domain->master);
                     dev_idx++) {
-                printk("%u", domain->working_counter[dev_idx]);
-                if (dev_idx + 1 < ec_master_num_devices(domain->master)) {
-                    printk("+");
-                }
+                len += scnprintf(devs + len, sizeof(devs) - len, "%s%u",
+                        dev_idx == EC_DEVICE_MAIN ? " (" : "+",
+                        domain->working_counter[dev_idx]);
             }
-            printk(")");
+            scnprintf(devs + len, sizeof(devs) - len, ")");
         }
 #endif
-        printk(".\n");
+
+        domain->notify_jiffies = jiffies;
+        if (domain->working_counter_changes == 1) {
+            EC_MASTER_RT_INFO(domain->master, EC_RT_LOG_DOMAIN,
+                    "Domain %u: Working counter changed to %u/%u%s.\n",
+                    domain->index, wc_total,
+                    domain->expected_working_counter, devs);
+        } else {
+            EC_MASTER_RT_INFO(domain->master, EC_RT_LOG_DOMAIN,
+                    "Domain %u: %u working counter changes"
+                    " - now %u/%u%s.\n", domain->index,
+                    domain->working_counter_changes, wc_total,
+                    domain->expected_working_counter, devs);
+        }
 
         domain->working_counter_changes = 0;
     }
 #endif
+
+    if (domain->process_cb) {
+        domain->process_cb(domain, domain->process_cb_data);
+    }
+
+    if (received) {
+        ec_latency_histogram_add(&domain->round_trip, round_trip);
+    }
+    ec_latency_histogram_add(&domain->process_time,
+            ktime_to_ns(ktime_sub(ktime_get(), start)));
+    domain->process_count++;
+
+    if (domain->map_sequence) {
+        smp_wmb();
+        (*domain->map_sequence)++;
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_domain_process_callback(ec_domain_t *domain,
+        void (*cb)(ec_domain_t *, void *), void *cb_data)
+{
+    domain->process_cb = cb;
+    domain->process_cb_data = cb_data;
 }
 
 /*****************************************************************************/
 
 void ecrt_domain_queue(ec_domain_t *domain)
 {
-    ec_datagram_pair_t *datagram_pair;
-    ec_device_index_t dev_idx;
+    if (domain->history.mem) {
+        ec_history_record(&domain->history, domain->data,
+                domain->process_count);
+    }
 
-    list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+    if (domain->image) {
+        ec_domain_copy_outputs(domain);
+    }
 
-#if EC_MAX_NUM_DEVICES > 1
-        /* copy main data to send buffer */
-        memcpy(datagram_pair->send_buffer,
-                datagram_pair->datagrams[EC_DEVICE_MAIN].data,
-                datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
-#endif
-        ec_master_queue_datagram(domain->master,
-                &datagram_pair->datagrams[EC_DEVICE_MAIN]);
+    ec_domain_prepare_queue(domain, -1);
 
-        /* copy main data to backup datagram */
-        for (dev_idx = EC_DEVICE_BACKUP;
-                dev_idx < ec_master_num_devices(domain->master); dev_idx++) {
-            memcpy(datagram_pair->datagrams[dev_idx].data,
-                    datagram_pair->datagrams[EC_DEVICE_MAIN].data,
-                    datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
-            ec_master_queue_datagram(domain->master,
-                    &datagram_pair->datagrams[dev_idx]);
-        }
+    domain->queue_slot = domain->pipeline_slot;
+    if (++domain->pipeline_slot == domain->pipeline_depth) {
+        domain->pipeline_slot = 0;
+    }
+
+    /* hand the datagrams over to ecrt_master_send() */
+    if (domain->split_io) {
+        smp_store_release(&domain->queue_inputs_pending, 1);
+    }
+    smp_store_release(&domain->queue_pending, 1);
+}
+
+/*****************************************************************************/
+
+void ecrt_domain_queue_outputs(ec_domain_t *domain)
+{
+    if (!domain->split_io) {
+        ecrt_domain_queue(domain);
+        return;
+    }
+
+    if (domain->history.mem) {
+        ec_history_record(&domain->history, domain->data,
+                domain->process_count);
+    }
+
+    if (domain->image) {
+        ec_domain_copy_outputs(domain);
+    }
+
+    ec_domain_prepare_queue(domain, 0);
+    smp_store_release(&domain->queue_pending, 1);
+}
+
+/*****************************************************************************/
+
+void ecrt_domain_queue_inputs(ec_domain_t *domain)
+{
+    if (!domain->split_io) {
+        return; // the inputs are exchanged with the outputs
     }
+
+    ec_domain_prepare_queue(domain, 1);
+    smp_store_release(&domain->queue_inputs_pending, 1);
 }
 
 /*****************************************************************************/
@@ -698,6 +2226,121 @@ void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
     }
 
     state->redundancy_active = domain->redundancy_active;
+
+    if (state->wc_state != EC_WC_COMPLETE) {
+        state->wc_fault_count =
+            ec_domain_wc_faults(domain, state->wc_fault_slaves);
+    } else {
+        state->wc_fault_count = 0;
+    }
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_redundancy(const ec_domain_t *domain,
+        ec_domain_redundancy_t *stats)
+{
+    *stats = domain->redundancy;
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_history(ec_domain_t *domain, unsigned int depth,
+        size_t offset, size_t size, unsigned int flags)
+{
+    EC_MASTER_DBG(domain->master, 1, "ecrt_domain_history(domain = 0x%p,"
+            " depth = %u, offset = %zu, size = %zu, flags = 0x%x)\n",
+            domain, depth, offset, size, flags);
+
+    down(&domain->master->master_sem);
+
+    if (domain->master->active) {
+        up(&domain->master->master_sem);
+        return -EBUSY;
+    }
+
+    ec_history_setup(&domain->history, depth, offset, size, flags);
+
+    up(&domain->master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+const uint8_t *ecrt_domain_history_data(ec_domain_t *domain)
+{
+    return domain->history.mem;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_history_state(const ec_domain_t *domain,
+        ec_history_state_t *state)
+{
+    const ec_history_t *history = &domain->history;
+
+    state->depth = history->mem ? history->depth : 0;
+    state->record_size = history->record_size;
+    state->offset = history->offset;
+    state->size = history->size;
+    state->seq = READ_ONCE(history->seq);
+    state->frozen = READ_ONCE(history->frozen);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_history_freeze(ec_domain_t *domain, int freeze)
+{
+    if (!domain->history.mem) {
+        return -ENODATA;
+    }
+
+    ec_history_freeze(&domain->history, freeze);
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_domain_changed_inputs(ec_domain_t *domain, uint8_t *bitmap)
+{
+    const ec_fmmu_config_t *fmmu;
+    int changed = 0;
+
+    if (!domain->data_size) {
+        return 0;
+    }
+
+    if (!domain->input_snapshot) {
+        return -EINVAL; // master not activated
+    }
+
+    memset(bitmap, 0x00, EC_DOMAIN_BITMAP_SIZE(domain->data_size));
+
+    list_for_each_entry(fmmu, &domain->fmmu_configs, list) {
+        const uint8_t *data = domain->data + fmmu->data_offset;
+        uint8_t *snapshot = domain->input_snapshot + fmmu->data_offset;
+        size_t i;
+
+        if (fmmu->dir != EC_DIR_INPUT
+                || !memcmp(data, snapshot, fmmu->data_size)) {
+            continue;
+        }
+
+        for (i = 0; i < fmmu->data_size; i++) {
+            uint8_t value = data[i];
+
+            if (value != snapshot[i]) {
+                size_t pos = fmmu->data_offset + i;
+                bitmap[pos / 8] |= 1 << (pos % 8);
+                snapshot[i] = value;
+                changed++;
+            }
+        }
+    }
+
+    return changed;
 }
 
 /*****************************************************************************/
@@ -705,12 +2348,32 @@ void ecrt_domain_state(const ec_domain_t *domain, ec_domain_state_t *state)
 /** \cond */
 
 EXPORT_SYMBOL(ecrt_domain_reg_pdo_entry_list);
+EXPORT_SYMBOL(ecrt_domain_reg_bit_map);
 EXPORT_SYMBOL(ecrt_domain_size);
+EXPORT_SYMBOL(ecrt_domain_set_timeout);
 EXPORT_SYMBOL(ecrt_domain_external_memory);
+EXPORT_SYMBOL(ecrt_domain_zero_copy);
+EXPORT_SYMBOL(ecrt_domain_overlap);
+EXPORT_SYMBOL(ecrt_domain_double_buffer);
+EXPORT_SYMBOL(ecrt_domain_split_io);
+EXPORT_SYMBOL(ecrt_domain_set_pipeline_depth);
+EXPORT_SYMBOL(ecrt_domain_set_cycle_divisor);
+EXPORT_SYMBOL(ecrt_domain_set_segment);
+EXPORT_SYMBOL(ecrt_domain_set_alignment);
+EXPORT_SYMBOL(ecrt_domain_add_route);
 EXPORT_SYMBOL(ecrt_domain_data);
 EXPORT_SYMBOL(ecrt_domain_process);
+EXPORT_SYMBOL(ecrt_domain_process_callback);
 EXPORT_SYMBOL(ecrt_domain_queue);
+EXPORT_SYMBOL(ecrt_domain_queue_outputs);
+EXPORT_SYMBOL(ecrt_domain_queue_inputs);
 EXPORT_SYMBOL(ecrt_domain_state);
+EXPORT_SYMBOL(ecrt_domain_redundancy);
+EXPORT_SYMBOL(ecrt_domain_history);
+EXPORT_SYMBOL(ecrt_domain_history_data);
+EXPORT_SYMBOL(ecrt_domain_history_state);
+EXPORT_SYMBOL(ecrt_domain_history_freeze);
+EXPORT_SYMBOL(ecrt_domain_changed_inputs);
 
 /** \endcond */
 
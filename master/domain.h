@@ -41,8 +41,31 @@
 
 #include "globals.h"
 #include "datagram.h"
+#include "datagram_pair.h"
 #include "master.h"
 #include "fmmu_config.h"
+#include "history.h"
+
+/*****************************************************************************/
+
+/** Maximum number of process data sets in flight per domain.
+ */
+#define EC_MAX_PIPELINE_DEPTH 8
+
+/*****************************************************************************/
+
+/** Process data route.
+ *
+ * Copies a bit field of a domain's process data to another location, see
+ * ecrt_domain_add_route().
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    ec_domain_t *dst_domain; /**< Destination domain. */
+    unsigned int src_offset; /**< Source bit offset. */
+    unsigned int dst_offset; /**< Destination bit offset. */
+    unsigned int bits; /**< Number of bits to copy. */
+} ec_domain_route_t;
 
 /*****************************************************************************/
 
@@ -56,22 +79,95 @@ struct ec_domain
     struct list_head list; /**< List item. */
     ec_master_t *master; /**< EtherCAT master owning the domain. */
     unsigned int index; /**< Index (just a number). */
+    const void *owner; /**< File handle context of the userspace
+                         application, that created the domain, or NULL. */
 
     struct list_head fmmu_configs; /**< FMMU configurations contained. */
     size_t data_size; /**< Size of the process data. */
+    size_t alignment; /**< Alignment of the process data blocks of the
+                        slave configurations. */
     uint8_t *data; /**< Memory for the process data. */
     ec_origin_t data_origin; /**< Origin of the \a data memory. */
+    uint8_t zero_copy; /**< The process data shall live in the pinned
+                         transmit frame of the main device. */
+    uint8_t overlap; /**< Inputs may share logical bytes with outputs. */
+    uint8_t double_buffer; /**< The datagrams carry an image of their own,
+                             so that the process data can be accessed while
+                             the datagrams are in flight. */
+    uint8_t split_io; /**< Outputs and inputs are exchanged by separate
+                        LWR and LRD datagrams, that are queued separately. */
+    uint8_t *image; /**< Logical process data images carried by the
+                      datagrams in overlapping, double-buffered or pipelined
+                      mode (one per pipeline slot), or NULL. */
+    size_t image_size; /**< Size of the \a image (per pipeline slot). */
+    unsigned int pipeline_depth; /**< Number of datagram sets rotating
+                                   through the queue. */
+    unsigned int pipeline_slot; /**< Datagram set to be processed and
+                                  queued next. */
+    unsigned int queue_slot; /**< Datagram set to be queued by
+                               ecrt_master_send(). */
+    unsigned int queue_pending; /**< ecrt_domain_queue() was called since
+                                  the last ecrt_master_send(). */
+    unsigned int queue_inputs_pending; /**< In split mode: The input
+                                         datagrams shall be queued by the
+                                         next ecrt_master_send(). */
+    unsigned int cycle_divisor; /**< Queue the domain automatically every
+                                  \a cycle_divisor sends, or 0. */
+    unsigned int cycle_phase; /**< Send cycle within the divisor period, in
+                                which the domain is queued. */
+    unsigned int cycle_countdown; /**< Sends left until the domain is queued
+                                    automatically. */
+    uint8_t *input_snapshot; /**< Inputs at the last call of
+                               ecrt_domain_changed_inputs(), or NULL. */
+    uint8_t *changed_inputs; /**< Change bitmap for the ioctl interface,
+                               allocated together with \a input_snapshot. */
+    ktime_t timeout; /**< Reception timeout of the domain datagrams. */
+    int segment; /**< Index of the device (line) the datagrams are exchanged
+                   on exclusively, or -1 to use all devices redundantly. */
     uint32_t logical_base_address; /**< Logical offset address of the
                                      process data. */
     struct list_head datagram_pairs; /**< Datagrams pairs (main/backup) for
                                        process data exchange. */
+    ec_datagram_pair_t *pair_pool; /**< Contiguous memory for the datagram
+                                     pairs, see
+                                     ec_domain_alloc_datagram_pair(). */
+    unsigned int pair_pool_size; /**< Number of pairs in \a pair_pool. */
+    unsigned int pair_pool_used; /**< Used pairs of \a pair_pool. */
     uint16_t working_counter[EC_MAX_NUM_DEVICES]; /**< Last working counter
                                                 values. */
     uint16_t expected_working_counter; /**< Expected working counter. */
     unsigned int working_counter_changes; /**< Working counter changes
                                              since last notification. */
     unsigned int redundancy_active; /**< Non-zero, if redundancy is in use. */
+    unsigned int wc_drops; /**< Working counter drops seen by
+                             ecrt_domain_process() (wraps). */
+    unsigned int wc_probed_drops; /**< Value of \a wc_drops at the start of
+                                    the last fault probe of the master state
+                                    machine. */
+    unsigned int wc_fault_count; /**< Number of faulty slaves found by the
+                                   last fault probe. */
+    uint16_t wc_fault_slaves[EC_MAX_WC_FAULT_SLAVES]; /**< Ring positions of
+                                                        the first faulty
+                                                        slaves. */
+    ec_domain_redundancy_t redundancy; /**< Ring redundancy statistics. */
     unsigned long notify_jiffies; /**< Time of last notification. */
+    unsigned int process_count; /**< Number of ecrt_domain_process() calls
+                                  (wraps). */
+    uint32_t *map_sequence; /**< Sequence counter in the memory-mapped
+                              state page, that is odd while the inputs are
+                              processed, or NULL. */
+    struct list_head routes; /**< Process data routes with this domain as
+                               the source. */
+    void (*process_cb)(ec_domain_t *, void *); /**< Callback at the end of
+                                                 ecrt_domain_process(). */
+    void *process_cb_data; /**< Data for \a process_cb. */
+    ec_bit_map_t *bit_maps; /**< Bit maps registered with
+                              ecrt_domain_reg_bit_map(). */
+    ec_latency_histogram_t round_trip; /**< Round-trip times of the
+                                         datagrams. */
+    ec_latency_histogram_t process_time; /**< Durations of
+                                           ecrt_domain_process(). */
+    ec_history_t history; /**< Process data history ring. */
 };
 
 /*****************************************************************************/
@@ -81,10 +177,20 @@ void ec_domain_clear(ec_domain_t *);
 
 void ec_domain_add_fmmu_config(ec_domain_t *, ec_fmmu_config_t *);
 int ec_domain_finish(ec_domain_t *, uint32_t);
+int ec_domain_in_flight(const ec_domain_t *);
+int ec_domain_awaiting_reception(const ec_domain_t *);
+void ec_domain_auto_queue(ec_domain_t *);
+void ec_domain_queue_datagrams(ec_domain_t *);
+unsigned int ec_domain_wc_faults(const ec_domain_t *, uint16_t *);
+void ec_domain_set_wc_faults(ec_domain_t *, const uint16_t *, unsigned int);
 
 unsigned int ec_domain_fmmu_count(const ec_domain_t *);
 const ec_fmmu_config_t *ec_domain_find_fmmu(const ec_domain_t *, unsigned int);
 
+/** Size of a change bitmap for \a DATA_SIZE bytes of process data.
+ */
+#define EC_DOMAIN_BITMAP_SIZE(DATA_SIZE) (((DATA_SIZE) + 7) / 8)
+
 /*****************************************************************************/
 
 #endif
@@ -59,15 +59,31 @@
  */
 #define EC_EOE_TX_QUEUE_SIZE 100
 
+/** Number of preallocated receive socket buffers per handler.
+ */
+#define EC_EOE_RX_POOL_SIZE 2
+
 /** Number of tries.
  */
 #define EC_EOE_TRIES 100
 
+/** Control block of a queued transmit socket buffer.
+ */
+typedef struct {
+    unsigned long jiffies_queued; /**< Time, when the frame was queued. */
+} ec_eoe_skb_cb_t;
+
+/** Returns the control block of a queued transmit socket buffer.
+ */
+#define EC_EOE_SKB_CB(skb) ((ec_eoe_skb_cb_t *) (skb)->cb)
+
 /*****************************************************************************/
 
 void ec_eoe_flush(ec_eoe_t *);
 
 // state functions
+void ec_eoe_rx_pool_fill(ec_eoe_t *);
+struct sk_buff *ec_eoe_rx_pool_get(ec_eoe_t *, size_t);
 void ec_eoe_state_rx_start(ec_eoe_t *);
 void ec_eoe_state_rx_check(ec_eoe_t *);
 void ec_eoe_state_rx_fetch(ec_eoe_t *);
@@ -111,20 +127,28 @@ int ec_eoe_init(
     char name[EC_DATAGRAM_NAME_SIZE];
 
     eoe->slave = slave;
+    INIT_LIST_HEAD(&eoe->active);
+    eoe->wakeup = 0;
 
     ec_datagram_init(&eoe->datagram);
+    eoe->datagram.traffic_class = EC_TC_EOE;
     eoe->queue_datagram = 0;
-    eoe->state = ec_eoe_state_rx_start;
+    eoe->state = ec_eoe_state_tx_start;
+    ec_datagram_init(&eoe->rx_datagram);
+    eoe->rx_datagram.traffic_class = EC_TC_EOE;
+    eoe->rx_queue_datagram = 0;
+    eoe->rx_state = ec_eoe_state_rx_start;
     eoe->opened = 0;
     eoe->rx_skb = NULL;
     eoe->rx_expected_fragment = 0;
-    INIT_LIST_HEAD(&eoe->tx_queue);
-    eoe->tx_frame = NULL;
+    skb_queue_head_init(&eoe->rx_pool);
+    skb_queue_head_init(&eoe->tx_queue);
+    eoe->tx_skb = NULL;
     eoe->tx_queue_active = 0;
     eoe->tx_queue_size = EC_EOE_TX_QUEUE_SIZE;
-    eoe->tx_queued_frames = 0;
-
-    sema_init(&eoe->tx_queue_sem, 1);
+    eoe->tx_queue_bytes = ec_eoe_tx_queue_bytes;
+    eoe->tx_queue_delay = ec_eoe_tx_queue_delay * HZ / 1000;
+    eoe->tx_queued_bytes = 0;
     eoe->tx_frame_number = 0xFF;
     memset(&eoe->stats, 0, sizeof(struct net_device_stats));
 
@@ -147,6 +171,7 @@ int ec_eoe_init(
     }
 
     snprintf(eoe->datagram.name, EC_DATAGRAM_NAME_SIZE, name);
+    snprintf(eoe->rx_datagram.name, EC_DATAGRAM_NAME_SIZE, name);
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
     eoe->dev = alloc_netdev(sizeof(ec_eoe_t *), name, NET_NAME_UNKNOWN,
@@ -218,17 +243,18 @@ void ec_eoe_clear(ec_eoe_t *eoe /**< EoE handler */)
     // empty transmit queue
     ec_eoe_flush(eoe);
 
-    if (eoe->tx_frame) {
-        dev_kfree_skb(eoe->tx_frame->skb);
-        kfree(eoe->tx_frame);
-    }
+    if (eoe->tx_skb)
+        dev_kfree_skb(eoe->tx_skb);
 
     if (eoe->rx_skb)
         dev_kfree_skb(eoe->rx_skb);
 
+    __skb_queue_purge(&eoe->rx_pool);
+
     free_netdev(eoe->dev);
 
     ec_datagram_clear(&eoe->datagram);
+    ec_datagram_clear(&eoe->rx_datagram);
 }
 
 /*****************************************************************************/
@@ -237,18 +263,29 @@ void ec_eoe_clear(ec_eoe_t *eoe /**< EoE handler */)
  */
 void ec_eoe_flush(ec_eoe_t *eoe /**< EoE handler */)
 {
-    ec_eoe_frame_t *frame, *next;
-
-    down(&eoe->tx_queue_sem);
+    spin_lock_bh(&eoe->tx_queue.lock);
+    __skb_queue_purge(&eoe->tx_queue);
+    eoe->tx_queued_bytes = 0;
+    spin_unlock_bh(&eoe->tx_queue.lock);
+}
 
-    list_for_each_entry_safe(frame, next, &eoe->tx_queue, queue) {
-        list_del(&frame->queue);
-        dev_kfree_skb(frame->skb);
-        kfree(frame);
-    }
-    eoe->tx_queued_frames = 0;
+/*****************************************************************************/
 
-    up(&eoe->tx_queue_sem);
+/** Checks, if the transmit queue is full.
+ *
+ * The queue is limited by the number of frames and by the number of bytes,
+ * so that slow mailbox links do not buffer seconds of traffic. Must be
+ * called with the queue lock held.
+ *
+ * \return Non-zero, if the queue is full.
+ */
+static int ec_eoe_tx_queue_full(
+        const ec_eoe_t *eoe, /**< EoE handler */
+        unsigned int divisor /**< Divisor for the limits. */
+        )
+{
+    return skb_queue_len(&eoe->tx_queue) >= eoe->tx_queue_size / divisor
+        || eoe->tx_queued_bytes >= eoe->tx_queue_bytes / divisor;
 }
 
 /*****************************************************************************/
@@ -259,20 +296,22 @@ void ec_eoe_flush(ec_eoe_t *eoe /**< EoE handler */)
  */
 int ec_eoe_send(ec_eoe_t *eoe /**< EoE handler */)
 {
-    size_t remaining_size, current_size, complete_offset;
+    size_t remaining_size, current_size, max_size, complete_offset;
     unsigned int last_fragment;
     uint8_t *data;
 #if EOE_DEBUG_LEVEL >= 3
     unsigned int i;
 #endif
 
-    remaining_size = eoe->tx_frame->skb->len - eoe->tx_offset;
+    // the fragments are written to the receive mailbox of the slave
+    max_size = eoe->slave->configured_rx_mailbox_size - 10;
+    remaining_size = eoe->tx_skb->len - eoe->tx_offset;
 
-    if (remaining_size <= eoe->slave->configured_tx_mailbox_size - 10) {
+    if (remaining_size <= max_size) {
         current_size = remaining_size;
         last_fragment = 1;
     } else {
-        current_size = ((eoe->slave->configured_tx_mailbox_size - 10) / 32) * 32;
+        current_size = (max_size / 32) * 32;
         last_fragment = 0;
     }
 
@@ -289,13 +328,13 @@ int ec_eoe_send(ec_eoe_t *eoe /**< EoE handler */)
             " with %u octets (%u). %u frames queued.\n",
             eoe->dev->name, eoe->tx_fragment_number,
             last_fragment ? "" : "+", current_size, complete_offset,
-            eoe->tx_queued_frames);
+            skb_queue_len(&eoe->tx_queue));
 #endif
 
 #if EOE_DEBUG_LEVEL >= 3
     EC_SLAVE_DBG(master, 0, "");
     for (i = 0; i < current_size; i++) {
-        printk("%02X ", eoe->tx_frame->skb->data[eoe->tx_offset + i]);
+        printk("%02X ", eoe->tx_skb->data[eoe->tx_offset + i]);
         if ((i + 1) % 16 == 0) {
             printk("\n");
             EC_SLAVE_DBG(master, 0, "");
@@ -315,7 +354,7 @@ int ec_eoe_send(ec_eoe_t *eoe /**< EoE handler */)
                             (complete_offset & 0x3F) << 6 |
                             (eoe->tx_frame_number & 0x0F) << 12));
 
-    memcpy(data + 4, eoe->tx_frame->skb->data + eoe->tx_offset, current_size);
+    memcpy(data + 4, eoe->tx_skb->data + eoe->tx_offset, current_size);
     eoe->queue_datagram = 1;
 
     eoe->tx_offset += current_size;
@@ -325,19 +364,72 @@ int ec_eoe_send(ec_eoe_t *eoe /**< EoE handler */)
 
 /*****************************************************************************/
 
-/** Runs the EoE state machine.
+/** Checks, if a datagram of the handler is queued or in flight.
+ *
+ * The datagrams are queued and received in the application's cycle, while
+ * the handler runs in the EoE thread, so the state is read with acquire
+ * semantics, see ec_master_take_ext_datagrams().
+ *
+ * \return Non-zero, if the datagram must not be touched.
+ */
+static int ec_eoe_datagram_busy(
+        const ec_datagram_t *datagram /**< Datagram. */
+        )
+{
+    ec_datagram_state_t state = smp_load_acquire(&datagram->state);
+
+    return state == EC_DATAGRAM_QUEUED || state == EC_DATAGRAM_SENT;
+}
+
+/*****************************************************************************/
+
+/** Hands a datagram over to the master's non-application datagram queue.
+ *
+ * The datagram is marked as queued before, so that the handler does not
+ * evaluate it until it was received or timed out.
+ *
+ * \retval 0 Success.
+ * \retval -ENOBUFS The queue is full. Try again later.
+ */
+static int ec_eoe_hand_over(
+        ec_eoe_t *eoe, /**< EoE handler */
+        ec_datagram_t *datagram /**< Datagram. */
+        )
+{
+    ec_datagram_state_t state = datagram->state;
+
+    datagram->state = EC_DATAGRAM_QUEUED;
+    if (ec_master_queue_datagram_ext(eoe->slave->master, datagram)) {
+        datagram->state = state;
+        return -ENOBUFS;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Runs the EoE state machines.
+ *
+ * Receiving and transmitting are done by separate state machines with
+ * separate datagrams, so that checking the send mailbox of the slave and
+ * writing the next fragment to its receive mailbox share one frame.
  */
 void ec_eoe_run(ec_eoe_t *eoe /**< EoE handler */)
 {
     if (!eoe->opened)
         return;
 
-    // if the datagram was not sent, or is not yet received, skip this cycle
-    if (eoe->queue_datagram || eoe->datagram.state == EC_DATAGRAM_SENT)
-        return;
+    // if a datagram was not sent, or is not yet received, skip its state
+    // machine in this cycle
+    if (!eoe->rx_queue_datagram
+            && !ec_eoe_datagram_busy(&eoe->rx_datagram)) {
+        eoe->rx_state(eoe);
+    }
 
-    // call state function
-    eoe->state(eoe);
+    if (!eoe->queue_datagram && !ec_eoe_datagram_busy(&eoe->datagram)) {
+        eoe->state(eoe);
+    }
 
     // update statistics
     if (jiffies - eoe->rate_jiffies > HZ) {
@@ -349,22 +441,39 @@ void ec_eoe_run(ec_eoe_t *eoe /**< EoE handler */)
     }
 
     ec_datagram_output_stats(&eoe->datagram);
+    ec_datagram_output_stats(&eoe->rx_datagram);
 }
 
 /*****************************************************************************/
 
-/** Queues the datagram, if necessary.
+/** Queues the datagrams, if necessary.
  */
 void ec_eoe_queue(ec_eoe_t *eoe /**< EoE handler */)
 {
-   if (eoe->queue_datagram) {
-       ec_master_queue_datagram_ext(eoe->slave->master, &eoe->datagram);
+   if (eoe->rx_queue_datagram &&
+           !ec_eoe_hand_over(eoe, &eoe->rx_datagram)) {
+       eoe->rx_queue_datagram = 0;
+   }
+
+   if (eoe->queue_datagram &&
+           !ec_eoe_hand_over(eoe, &eoe->datagram)) {
        eoe->queue_datagram = 0;
    }
 }
 
 /*****************************************************************************/
 
+/** Returns, if a datagram of the handler has to be queued.
+ *
+ * \return Non-zero, if ec_eoe_queue() has to be called.
+ */
+int ec_eoe_queue_pending(const ec_eoe_t *eoe /**< EoE handler */)
+{
+    return eoe->queue_datagram || eoe->rx_queue_datagram;
+}
+
+/*****************************************************************************/
+
 /** Returns the state of the device.
  *
  * \return 1 if the device is "up", 0 if it is "down"
@@ -402,13 +511,77 @@ void ec_eoe_state_rx_start(ec_eoe_t *eoe /**< EoE handler */)
     if (eoe->slave->error_flag ||
             !eoe->slave->master->devices[EC_DEVICE_MAIN].link_state) {
         eoe->rx_idle = 1;
-        eoe->tx_idle = 1;
+        eoe->rx_state = ec_eoe_state_rx_start;
         return;
     }
 
-    ec_slave_mbox_prepare_check(eoe->slave, &eoe->datagram);
-    eoe->queue_datagram = 1;
-    eoe->state = ec_eoe_state_rx_check;
+    ec_eoe_rx_pool_fill(eoe);
+
+    ec_slave_mbox_prepare_check(eoe->slave, &eoe->rx_datagram);
+    eoe->rx_queue_datagram = 1;
+    eoe->rx_state = ec_eoe_state_rx_check;
+}
+
+/*****************************************************************************/
+
+/** Returns the size of the preallocated receive socket buffers.
+ *
+ * The MTU only limits the frames sent to the slave, which may pass on full
+ * Ethernet frames, so the buffers have at least the size of one.
+ */
+static size_t ec_eoe_rx_pool_skb_size(
+        const ec_eoe_t *eoe /**< EoE handler */
+        )
+{
+    return max_t(size_t, eoe->dev->mtu + ETH_HLEN, ETH_FRAME_LEN);
+}
+
+/*****************************************************************************/
+
+/** Fills up the pool of preallocated receive socket buffers.
+ *
+ * This is done while waiting for the next fragment, so that a new frame
+ * usually does not need an allocation, when its first fragment arrives.
+ */
+void ec_eoe_rx_pool_fill(ec_eoe_t *eoe /**< EoE handler */)
+{
+    struct sk_buff *skb;
+
+    while (skb_queue_len(&eoe->rx_pool) < EC_EOE_RX_POOL_SIZE) {
+        if (!(skb = dev_alloc_skb(ec_eoe_rx_pool_skb_size(eoe)))) {
+            break;
+        }
+        __skb_queue_tail(&eoe->rx_pool, skb);
+    }
+}
+
+/*****************************************************************************/
+
+/** Gets a receive socket buffer for a frame of the given size.
+ *
+ * The buffer is taken from the pool, if it is large enough. Otherwise, a
+ * new one is allocated.
+ *
+ * 
+eturn Socket buffer, or NULL.
+ */
+struct sk_buff *ec_eoe_rx_pool_get(
+        ec_eoe_t *eoe, /**< EoE handler */
+        size_t size /**< Frame size. */
+        )
+{
+    struct sk_buff *skb;
+
+    if (size <= ec_eoe_rx_pool_skb_size(eoe)
+            && (skb = __skb_dequeue(&eoe->rx_pool))) {
+        if (skb_tailroom(skb) >= size) {
+            return skb;
+        }
+        // MTU was changed
+        dev_kfree_skb(skb);
+    }
+
+    return dev_alloc_skb(size);
 }
 
 /*****************************************************************************/
@@ -420,26 +593,27 @@ void ec_eoe_state_rx_start(ec_eoe_t *eoe /**< EoE handler */)
  */
 void ec_eoe_state_rx_check(ec_eoe_t *eoe /**< EoE handler */)
 {
-    if (eoe->datagram.state != EC_DATAGRAM_RECEIVED) {
+    if (eoe->rx_datagram.state != EC_DATAGRAM_RECEIVED) {
         eoe->stats.rx_errors++;
 #if EOE_DEBUG_LEVEL >= 1
         EC_SLAVE_WARN(eoe->slave, "Failed to receive mbox"
                 " check datagram for %s.\n", eoe->dev->name);
 #endif
-        eoe->state = ec_eoe_state_tx_start;
+        eoe->rx_state = ec_eoe_state_rx_start;
         return;
     }
 
-    if (!ec_slave_mbox_check(&eoe->datagram)) {
+    if (!ec_slave_mbox_check(&eoe->rx_datagram)) {
+        // check again immediately
         eoe->rx_idle = 1;
-        eoe->state = ec_eoe_state_tx_start;
+        ec_eoe_state_rx_start(eoe);
         return;
     }
 
     eoe->rx_idle = 0;
-    ec_slave_mbox_prepare_fetch(eoe->slave, &eoe->datagram);
-    eoe->queue_datagram = 1;
-    eoe->state = ec_eoe_state_rx_fetch;
+    ec_slave_mbox_prepare_fetch(eoe->slave, &eoe->rx_datagram);
+    eoe->rx_queue_datagram = 1;
+    eoe->rx_state = ec_eoe_state_rx_fetch;
 }
 
 /*****************************************************************************/
@@ -462,17 +636,17 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
     unsigned int i;
 #endif
 
-    if (eoe->datagram.state != EC_DATAGRAM_RECEIVED) {
+    if (eoe->rx_datagram.state != EC_DATAGRAM_RECEIVED) {
         eoe->stats.rx_errors++;
 #if EOE_DEBUG_LEVEL >= 1
         EC_SLAVE_WARN(eoe->slave, "Failed to receive mbox"
                 " fetch datagram for %s.\n", eoe->dev->name);
 #endif
-        eoe->state = ec_eoe_state_tx_start;
+        eoe->rx_state = ec_eoe_state_rx_start;
         return;
     }
 
-    data = ec_slave_mbox_fetch(eoe->slave, &eoe->datagram,
+    data = ec_slave_mbox_fetch(eoe->slave, &eoe->rx_datagram,
             &mbox_prot, &rec_size);
     if (IS_ERR(data)) {
         eoe->stats.rx_errors++;
@@ -480,7 +654,7 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
         EC_SLAVE_WARN(eoe->slave, "Invalid mailbox response for %s.\n",
                 eoe->dev->name);
 #endif
-        eoe->state = ec_eoe_state_tx_start;
+        eoe->rx_state = ec_eoe_state_rx_start;
         return;
     }
 
@@ -490,7 +664,7 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
         EC_SLAVE_WARN(eoe->slave, "Other mailbox protocol response for %s.\n",
                 eoe->dev->name);
 #endif
-        eoe->state = ec_eoe_state_tx_start;
+        eoe->rx_state = ec_eoe_state_rx_start;
         return;
     }
 
@@ -502,7 +676,7 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
                 " Dropping.\n", eoe->dev->name);
 #endif
         eoe->stats.rx_dropped++;
-        eoe->state = ec_eoe_state_tx_start;
+        eoe->rx_state = ec_eoe_state_rx_start;
         return;
     }
 
@@ -545,12 +719,12 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
         }
 
         // new socket buffer
-        if (!(eoe->rx_skb = dev_alloc_skb(fragment_offset * 32))) {
+        if (!(eoe->rx_skb = ec_eoe_rx_pool_get(eoe, fragment_offset * 32))) {
             if (printk_ratelimit())
                 EC_SLAVE_WARN(eoe->slave, "EoE RX low on mem,"
                         " frame dropped.\n");
             eoe->stats.rx_dropped++;
-            eoe->state = ec_eoe_state_tx_start;
+            eoe->rx_state = ec_eoe_state_rx_start;
             return;
         }
 
@@ -561,7 +735,7 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
     else {
         if (!eoe->rx_skb) {
             eoe->stats.rx_dropped++;
-            eoe->state = ec_eoe_state_tx_start;
+            eoe->rx_state = ec_eoe_state_rx_start;
             return;
         }
 
@@ -576,7 +750,7 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
             EC_SLAVE_WARN(eoe->slave, "Fragmenting error at %s.\n",
                     eoe->dev->name);
 #endif
-            eoe->state = ec_eoe_state_tx_start;
+            eoe->rx_state = ec_eoe_state_rx_start;
             return;
         }
     }
@@ -604,8 +778,6 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
             EC_SLAVE_WARN(eoe->slave, "EoE RX netif_rx failed.\n");
         }
         eoe->rx_skb = NULL;
-
-        eoe->state = ec_eoe_state_tx_start;
     }
     else {
         eoe->rx_expected_fragment++;
@@ -613,16 +785,17 @@ void ec_eoe_state_rx_fetch(ec_eoe_t *eoe /**< EoE handler */)
         EC_SLAVE_DBG(eoe->slave, 0, "EoE %s RX expecting fragment %u\n",
                eoe->dev->name, eoe->rx_expected_fragment);
 #endif
-        eoe->state = ec_eoe_state_rx_start;
     }
+
+    // check for the next fragment in the same cycle
+    ec_eoe_state_rx_start(eoe);
 }
 
 /*****************************************************************************/
 
 /** State: TX START.
  *
- * Starts a new transmit sequence. If no data is available, a new receive
- * sequence is started instead.
+ * Starts a new transmit sequence, if data is available.
  *
  * \todo Use both devices.
  */
@@ -632,29 +805,30 @@ void ec_eoe_state_tx_start(ec_eoe_t *eoe /**< EoE handler */)
     unsigned int wakeup = 0;
 #endif
 
+    eoe->state = ec_eoe_state_tx_start;
+
     if (eoe->slave->error_flag ||
             !eoe->slave->master->devices[EC_DEVICE_MAIN].link_state) {
-        eoe->rx_idle = 1;
         eoe->tx_idle = 1;
         return;
     }
 
-    down(&eoe->tx_queue_sem);
+    spin_lock_bh(&eoe->tx_queue.lock);
 
-    if (!eoe->tx_queued_frames || list_empty(&eoe->tx_queue)) {
-        up(&eoe->tx_queue_sem);
-        eoe->tx_idle = 1;
-        // no data available.
-        // start a new receive immediately.
-        ec_eoe_state_rx_start(eoe);
-        return;
+    // take the first frame out of the queue, dropping frames that waited
+    // too long
+    while ((eoe->tx_skb = __skb_dequeue(&eoe->tx_queue))) {
+        eoe->tx_queued_bytes -= eoe->tx_skb->len;
+        if (!eoe->tx_queue_delay || time_before(jiffies,
+                    EC_EOE_SKB_CB(eoe->tx_skb)->jiffies_queued
+                    + eoe->tx_queue_delay)) {
+            break;
+        }
+        dev_kfree_skb(eoe->tx_skb);
+        eoe->stats.tx_dropped++;
     }
 
-    // take the first frame out of the queue
-    eoe->tx_frame = list_entry(eoe->tx_queue.next, ec_eoe_frame_t, queue);
-    list_del(&eoe->tx_frame->queue);
-    if (!eoe->tx_queue_active &&
-        eoe->tx_queued_frames == eoe->tx_queue_size / 2) {
+    if (!eoe->tx_queue_active && !ec_eoe_tx_queue_full(eoe, 2)) {
         netif_wake_queue(eoe->dev);
         eoe->tx_queue_active = 1;
 #if EOE_DEBUG_LEVEL >= 2
@@ -662,8 +836,12 @@ void ec_eoe_state_tx_start(ec_eoe_t *eoe /**< EoE handler */)
 #endif
     }
 
-    eoe->tx_queued_frames--;
-    up(&eoe->tx_queue_sem);
+    spin_unlock_bh(&eoe->tx_queue.lock);
+
+    if (!eoe->tx_skb) {
+        eoe->tx_idle = 1;
+        return;
+    }
 
     eoe->tx_idle = 0;
 
@@ -673,11 +851,9 @@ void ec_eoe_state_tx_start(ec_eoe_t *eoe /**< EoE handler */)
     eoe->tx_offset = 0;
 
     if (ec_eoe_send(eoe)) {
-        dev_kfree_skb(eoe->tx_frame->skb);
-        kfree(eoe->tx_frame);
-        eoe->tx_frame = NULL;
+        dev_kfree_skb(eoe->tx_skb);
+        eoe->tx_skb = NULL;
         eoe->stats.tx_errors++;
-        eoe->state = ec_eoe_state_rx_start;
 #if EOE_DEBUG_LEVEL >= 1
         EC_SLAVE_WARN(eoe->slave, "Send error at %s.\n", eoe->dev->name);
 #endif
@@ -714,7 +890,9 @@ void ec_eoe_state_tx_sent(ec_eoe_t *eoe /**< EoE handler */)
                     " datagram for %s after %u tries.\n",
                     eoe->dev->name, EC_EOE_TRIES);
 #endif
-            eoe->state = ec_eoe_state_rx_start;
+            dev_kfree_skb(eoe->tx_skb);
+            eoe->tx_skb = NULL;
+            eoe->state = ec_eoe_state_tx_start;
         }
         return;
     }
@@ -730,31 +908,33 @@ void ec_eoe_state_tx_sent(ec_eoe_t *eoe /**< EoE handler */)
                     " for %s after %u tries.\n",
                     eoe->dev->name, EC_EOE_TRIES);
 #endif
-            eoe->state = ec_eoe_state_rx_start;
+            dev_kfree_skb(eoe->tx_skb);
+            eoe->tx_skb = NULL;
+            eoe->state = ec_eoe_state_tx_start;
         }
         return;
     }
 
     // frame completely sent
-    if (eoe->tx_offset >= eoe->tx_frame->skb->len) {
+    if (eoe->tx_offset >= eoe->tx_skb->len) {
         eoe->stats.tx_packets++;
-        eoe->stats.tx_bytes += eoe->tx_frame->skb->len;
-        eoe->tx_counter += eoe->tx_frame->skb->len;
-        dev_kfree_skb(eoe->tx_frame->skb);
-        kfree(eoe->tx_frame);
-        eoe->tx_frame = NULL;
-        eoe->state = ec_eoe_state_rx_start;
+        eoe->stats.tx_bytes += eoe->tx_skb->len;
+        eoe->tx_counter += eoe->tx_skb->len;
+        dev_kfree_skb(eoe->tx_skb);
+        eoe->tx_skb = NULL;
+
+        // start sending the next frame in the same cycle
+        ec_eoe_state_tx_start(eoe);
     }
     else { // send next fragment
         if (ec_eoe_send(eoe)) {
-            dev_kfree_skb(eoe->tx_frame->skb);
-            kfree(eoe->tx_frame);
-            eoe->tx_frame = NULL;
+            dev_kfree_skb(eoe->tx_skb);
+            eoe->tx_skb = NULL;
             eoe->stats.tx_errors++;
 #if EOE_DEBUG_LEVEL >= 1
             EC_SLAVE_WARN(eoe->slave, "Send error at %s.\n", eoe->dev->name);
 #endif
-            eoe->state = ec_eoe_state_rx_start;
+            eoe->state = ec_eoe_state_tx_start;
         }
     }
 }
@@ -780,6 +960,7 @@ int ec_eoedev_open(struct net_device *dev /**< EoE net_device */)
     EC_SLAVE_DBG(eoe->slave, 0, "%s opened.\n", dev->name);
 #endif
     ec_slave_request_state(eoe->slave, EC_SLAVE_STATE_OP);
+    ec_master_eoe_activate(eoe->slave->master, eoe);
     return 0;
 }
 
@@ -816,7 +997,6 @@ int ec_eoedev_tx(struct sk_buff *skb, /**< transmit socket buffer */
                 )
 {
     ec_eoe_t *eoe = *((ec_eoe_t **) netdev_priv(dev));
-    ec_eoe_frame_t *frame;
 
 #if 0
     if (skb->len > eoe->slave->configured_tx_mailbox_size - 10) {
@@ -828,28 +1008,23 @@ int ec_eoedev_tx(struct sk_buff *skb, /**< transmit socket buffer */
     }
 #endif
 
-    if (!(frame =
-          (ec_eoe_frame_t *) kmalloc(sizeof(ec_eoe_frame_t), GFP_ATOMIC))) {
-        if (printk_ratelimit())
-            EC_SLAVE_WARN(eoe->slave, "EoE TX: low on mem. frame dropped.\n");
-        return 1;
-    }
-
-    frame->skb = skb;
+    EC_EOE_SKB_CB(skb)->jiffies_queued = jiffies;
 
-    down(&eoe->tx_queue_sem);
-    list_add_tail(&frame->queue, &eoe->tx_queue);
-    eoe->tx_queued_frames++;
-    if (eoe->tx_queued_frames == eoe->tx_queue_size) {
+    spin_lock_bh(&eoe->tx_queue.lock);
+    __skb_queue_tail(&eoe->tx_queue, skb);
+    eoe->tx_queued_bytes += skb->len;
+    if (ec_eoe_tx_queue_full(eoe, 1)) {
         netif_stop_queue(dev);
         eoe->tx_queue_active = 0;
     }
-    up(&eoe->tx_queue_sem);
+    spin_unlock_bh(&eoe->tx_queue.lock);
+
+    ec_master_eoe_activate(eoe->slave->master, eoe);
 
 #if EOE_DEBUG_LEVEL >= 2
     EC_SLAVE_DBG(eoe->slave, 0, "EoE %s TX queued frame"
             " with %u octets (%u frames queued).\n",
-            eoe->dev->name, skb->len, eoe->tx_queued_frames);
+            eoe->dev->name, skb->len, skb_queue_len(&eoe->tx_queue));
     if (!eoe->tx_queue_active)
         EC_SLAVE_WARN(eoe->slave, "EoE TX queue is now full.\n");
 #endif
@@ -52,16 +52,17 @@
 
 /*****************************************************************************/
 
-/**
-   Queued frame structure.
-*/
+/** Default maximum number of bytes in the EoE transmit queue.
+ */
+#define EC_EOE_TX_QUEUE_BYTES 16384
 
-typedef struct
-{
-    struct list_head queue; /**< list item */
-    struct sk_buff *skb; /**< socket buffer */
-}
-ec_eoe_frame_t;
+/** Default maximum time in ms, that a frame may wait in the EoE transmit
+ * queue.
+ */
+#define EC_EOE_TX_QUEUE_DELAY 100
+
+extern unsigned int ec_eoe_tx_queue_bytes; // see module.c
+extern unsigned int ec_eoe_tx_queue_delay; // see module.c
 
 /*****************************************************************************/
 
@@ -76,10 +77,20 @@ typedef struct ec_eoe ec_eoe_t; /**< \see ec_eoe */
 struct ec_eoe
 {
     struct list_head list; /**< list item */
+    struct list_head active; /**< item of the master's list of active
+                               handlers */
+    unsigned int wakeup; /**< the handler was activated since it was last
+                           processed */
     ec_slave_t *slave; /**< pointer to the corresponding slave */
-    ec_datagram_t datagram; /**< datagram */
+    ec_datagram_t datagram; /**< datagram for sending fragments */
     unsigned int queue_datagram; /**< the datagram is ready for queuing */
-    void (*state)(ec_eoe_t *); /**< state function for the state machine */
+    void (*state)(ec_eoe_t *); /**< state function of the transmit state
+                                 machine */
+    ec_datagram_t rx_datagram; /**< datagram for receiving fragments */
+    unsigned int rx_queue_datagram; /**< \a rx_datagram is ready for
+                                      queuing */
+    void (*rx_state)(ec_eoe_t *); /**< state function of the receive state
+                                    machine */
     struct net_device *dev; /**< net_device for virtual ethernet device */
     struct net_device_stats stats; /**< device statistics */
     unsigned int opened; /**< net_device is opened */
@@ -88,17 +99,25 @@ struct ec_eoe
     struct sk_buff *rx_skb; /**< current rx socket buffer */
     off_t rx_skb_offset; /**< current write pointer in the socket buffer */
     size_t rx_skb_size; /**< size of the allocated socket buffer memory */
+    struct sk_buff_head rx_pool; /**< Preallocated receive socket buffers.
+                                   Only accessed by the receive state
+                                   machine. */
     uint8_t rx_expected_fragment; /**< next expected fragment number */
     uint32_t rx_counter; /**< octets received during last second */
     uint32_t rx_rate; /**< receive rate (bps) */
     unsigned int rx_idle; /**< Idle flag. */
 
-    struct list_head tx_queue; /**< queue for frames to send */
-    unsigned int tx_queue_size; /**< Transmit queue size. */
+    struct sk_buff_head tx_queue; /**< queue for frames to send. Its lock
+                                    also protects \a tx_queue_active and
+                                    \a tx_queued_bytes. */
+    unsigned int tx_queue_size; /**< Transmit queue size in frames. */
+    size_t tx_queue_bytes; /**< Transmit queue size in bytes. */
+    unsigned long tx_queue_delay; /**< Maximum time in jiffies, that a frame
+                                    may wait in the transmit queue, or zero.
+                                    */
     unsigned int tx_queue_active; /**< kernel netif queue started */
-    unsigned int tx_queued_frames; /**< number of frames in the queue */
-    struct semaphore tx_queue_sem; /**< Semaphore for the send queue. */
-    ec_eoe_frame_t *tx_frame; /**< current TX frame */
+    size_t tx_queued_bytes; /**< number of bytes in the queue */
+    struct sk_buff *tx_skb; /**< current TX frame */
     uint8_t tx_frame_number; /**< number of the transmitted frame */
     uint8_t tx_fragment_number; /**< number of the fragment */
     size_t tx_offset; /**< number of octets sent */
@@ -115,6 +134,7 @@ int ec_eoe_init(ec_eoe_t *, ec_slave_t *);
 void ec_eoe_clear(ec_eoe_t *);
 void ec_eoe_run(ec_eoe_t *);
 void ec_eoe_queue(ec_eoe_t *);
+int ec_eoe_queue_pending(const ec_eoe_t *);
 int ec_eoe_is_open(const ec_eoe_t *);
 int ec_eoe_is_idle(const ec_eoe_t *);
 
@@ -58,9 +58,11 @@ void ec_fmmu_config_init(
     INIT_LIST_HEAD(&fmmu->list);
     fmmu->sc = sc;
     fmmu->sync_index = sync_index;
+    fmmu->register_address = 0x0000;
     fmmu->dir = dir;
 
     fmmu->logical_start_address = domain->data_size;
+    fmmu->data_offset = domain->data_size;
     fmmu->data_size = ec_pdo_list_total_size(
             &sc->sync_configs[sync_index].pdos);
 
@@ -69,27 +71,61 @@ void ec_fmmu_config_init(
 
 /*****************************************************************************/
 
+/** FMMU configuration constructor for a register mapping.
+ *
+ * Inits an FMMU configuration, that maps slave registers for reading or
+ * writing into the domain, and adds their size to the domain data size.
+ */
+void ec_fmmu_config_init_registers(
+        ec_fmmu_config_t *fmmu, /**< EtherCAT FMMU configuration. */
+        ec_slave_config_t *sc, /**< EtherCAT slave configuration. */
+        ec_domain_t *domain, /**< EtherCAT domain. */
+        uint16_t address, /**< First register address. */
+        unsigned int size, /**< Size of the mapped registers. */
+        ec_direction_t dir /**< EC_DIR_INPUT to read the registers,
+                             EC_DIR_OUTPUT to write them. */
+        )
+{
+    INIT_LIST_HEAD(&fmmu->list);
+    fmmu->sc = sc;
+    fmmu->sync_index = EC_FMMU_NO_SYNC;
+    fmmu->register_address = address;
+    fmmu->dir = dir;
+
+    fmmu->logical_start_address = domain->data_size;
+    fmmu->data_offset = domain->data_size;
+    fmmu->data_size = size;
+
+    ec_domain_add_fmmu_config(domain, fmmu);
+}
+
+/*****************************************************************************/
+
 /** Initializes an FMMU configuration page.
  *
  * The referenced memory (\a data) must be at least EC_FMMU_PAGE_SIZE bytes.
  */
 void ec_fmmu_config_page(
         const ec_fmmu_config_t *fmmu, /**< EtherCAT FMMU configuration. */
-        const ec_sync_t *sync, /**< Sync manager. */
+        const ec_sync_t *sync, /**< Sync manager, or NULL for a register
+                                 mapping. */
         uint8_t *data /**> Configuration page memory. */
         )
 {
+    uint16_t physical_start_address =
+        sync ? sync->physical_start_address : fmmu->register_address;
+
     EC_CONFIG_DBG(fmmu->sc, 1, "FMMU: LogAddr 0x%08X, Size %3u,"
             " PhysAddr 0x%04X, SM%u, Dir %s\n",
             fmmu->logical_start_address, fmmu->data_size,
-            sync->physical_start_address, fmmu->sync_index,
+            physical_start_address, fmmu->sync_index,
             fmmu->dir == EC_DIR_INPUT ? "in" : "out");
 
     EC_WRITE_U32(data,      fmmu->logical_start_address);
     EC_WRITE_U16(data + 4,  fmmu->data_size); // size of fmmu
     EC_WRITE_U8 (data + 6,  0x00); // logical start bit
     EC_WRITE_U8 (data + 7,  0x07); // logical end bit
-    EC_WRITE_U16(data + 8,  sync->physical_start_address);
+    EC_WRITE_U16(data + 8,  physical_start_address);
     EC_WRITE_U8 (data + 10, 0x00); // physical start bit
     EC_WRITE_U8 (data + 11, fmmu->dir == EC_DIR_INPUT ? 0x01 : 0x02);
     EC_WRITE_U16(data + 12, 0x0001); // enable
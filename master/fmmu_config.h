@@ -41,15 +41,25 @@
 
 /*****************************************************************************/
 
+/** Sync manager index of an FMMU configuration mapping registers.
+ */
+#define EC_FMMU_NO_SYNC 0xff
+
 /** FMMU configuration.
  */
 typedef struct {
     struct list_head list; /**< List node used by domain. */
     const ec_slave_config_t *sc; /**< EtherCAT slave config. */
     const ec_domain_t *domain; /**< Domain. */
-    uint8_t sync_index; /**< Index of sync manager to use. */
+    uint8_t sync_index; /**< Index of sync manager to use, or
+                          #EC_FMMU_NO_SYNC. */
+    uint16_t register_address; /**< Physical start address, if the FMMU
+                                 maps registers instead of a sync manager.
+                                 */
     ec_direction_t dir; /**< FMMU direction. */
     uint32_t logical_start_address; /**< Logical start address. */
+    uint32_t data_offset; /**< Offset of the data in the domain's process
+                            data. */
     unsigned int data_size; /**< Covered PDO size. */
 } ec_fmmu_config_t;
 
@@ -57,6 +67,8 @@ typedef struct {
 
 void ec_fmmu_config_init(ec_fmmu_config_t *, ec_slave_config_t *,
         ec_domain_t *, uint8_t, ec_direction_t);
+void ec_fmmu_config_init_registers(ec_fmmu_config_t *, ec_slave_config_t *,
+        ec_domain_t *, uint16_t, unsigned int, ec_direction_t);
 
 void ec_fmmu_config_page(const ec_fmmu_config_t *, const ec_sync_t *,
         uint8_t *);
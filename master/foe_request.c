@@ -63,12 +63,20 @@ void ec_foe_request_init(
     req->file_name = file_name;
     req->buffer_size = 0;
     req->data_size = 0;
+    req->progress = 0;
     req->dir = EC_DIR_INVALID;
     req->issue_timeout = 0; // no timeout
     req->response_timeout = EC_FOE_REQUEST_RESPONSE_TIMEOUT;
     req->state = EC_INT_REQUEST_INIT;
     req->result = FOE_BUSY;
     req->error_code = 0x00000000;
+    req->stream = 0;
+    req->stream_wait = 0;
+    req->stream_end = 0;
+    req->stream_abort = 0;
+    req->window_offset = 0;
+    req->complete_cb = NULL;
+    req->cb_data = NULL;
 }
 
 /*****************************************************************************/
@@ -236,3 +244,17 @@ void ec_foe_request_write(
 }
 
 /*****************************************************************************/
+
+/** Notifies the issuer about the completion of the request.
+ *
+ * Calls the completion callback, if set. This has to be the last access to
+ * the request, because the callback may free it.
+ */
+void ec_foe_request_notify(ec_foe_request_t *req /**< FoE request. */)
+{
+    if (req->complete_cb) {
+        req->complete_cb(req, req->cb_data);
+    }
+}
+
+/*****************************************************************************/
@@ -47,11 +47,12 @@
 
 /** FoE request.
  */
-typedef struct {
+typedef struct ec_foe_request {
     struct list_head list; /**< List item. */
     uint8_t *buffer; /**< Pointer to FoE data. */
     size_t buffer_size; /**< Size of FoE data memory. */
     size_t data_size; /**< Size of FoE data. */
+    size_t progress; /**< Number of bytes transferred so far. */
 
     uint32_t issue_timeout; /**< Maximum time in ms, the processing of the
                               request may take. */
@@ -67,6 +68,21 @@ typedef struct {
     uint8_t *file_name; /**< Pointer to the filename. */
     uint32_t result; /**< FoE request abort code. Zero on success. */
     uint32_t error_code; /**< Error code from an FoE Error Request. */
+
+    int stream; /**< Non-zero, if \a buffer is only a window into the file,
+                  that is refilled (write) or emptied (read) by the
+                  application while the transfer is in progress. */
+    int stream_wait; /**< The state machine waits for the application to
+                       refill or empty the window. As long as this is set,
+                       the window belongs to the application. */
+    int stream_end; /**< Write: The window contains the end of the file. */
+    int stream_abort; /**< The application aborts the transfer. */
+    size_t window_offset; /**< File offset of the first byte in \a buffer.
+                           */
+    void (*complete_cb)(struct ec_foe_request *, void *); /**< Completion
+                                                            callback, or
+                                                            NULL. */
+    void *cb_data; /**< Data for \a complete_cb. */
 } ec_foe_request_t;
 
 /*****************************************************************************/
@@ -80,6 +96,7 @@ int ec_foe_request_timed_out(const ec_foe_request_t *);
 
 void ec_foe_request_write(ec_foe_request_t *);
 void ec_foe_request_read(ec_foe_request_t *);
+void ec_foe_request_notify(ec_foe_request_t *);
 
 /*****************************************************************************/
 
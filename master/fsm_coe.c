@@ -33,6 +33,8 @@
 
 /*****************************************************************************/
 
+#include <linux/rculist.h>
+
 #include "globals.h"
 #include "master.h"
 #include "mailbox.h"
@@ -68,6 +70,7 @@
 /*****************************************************************************/
 
 void ec_fsm_coe_dict_start(ec_fsm_coe_t *, ec_datagram_t *);
+void ec_fsm_coe_dict_entries_start(ec_fsm_coe_t *, ec_datagram_t *);
 void ec_fsm_coe_dict_request(ec_fsm_coe_t *, ec_datagram_t *);
 void ec_fsm_coe_dict_check(ec_fsm_coe_t *, ec_datagram_t *);
 void ec_fsm_coe_dict_response(ec_fsm_coe_t *, ec_datagram_t *);
@@ -93,6 +96,8 @@ void ec_fsm_coe_up_seg_request(ec_fsm_coe_t *, ec_datagram_t *);
 void ec_fsm_coe_up_seg_check(ec_fsm_coe_t *, ec_datagram_t *);
 void ec_fsm_coe_up_seg_response(ec_fsm_coe_t *, ec_datagram_t *);
 
+void ec_fsm_coe_repeat(ec_fsm_coe_t *, ec_datagram_t *);
+
 void ec_fsm_coe_end(ec_fsm_coe_t *, ec_datagram_t *);
 void ec_fsm_coe_error(ec_fsm_coe_t *, ec_datagram_t *);
 
@@ -188,6 +193,13 @@ void ec_fsm_coe_clear(
 /*****************************************************************************/
 
 /** Starts reading a slaves' SDO dictionary.
+ *
+ * The entry descriptions are only read for SDOs, that are mapped to PDOs.
+ * The entry descriptions of the other SDOs are marked as pending and can be
+ * read later via ec_fsm_coe_dict_entries().
+ *
+ * The SDOs are added to the dictionary object of the slave, that has to be
+ * set before.
  */
 void ec_fsm_coe_dictionary(
         ec_fsm_coe_t *fsm, /**< Finite state machine */
@@ -195,11 +207,32 @@ void ec_fsm_coe_dictionary(
         )
 {
     fsm->slave = slave;
+    fsm->request = NULL;
+    fsm->single_sdo = 0;
     fsm->state = ec_fsm_coe_dict_start;
 }
 
 /*****************************************************************************/
 
+/** Starts reading the entry descriptions of a single SDO.
+ *
+ * Entries, that were read before, are replaced.
+ */
+void ec_fsm_coe_dict_entries(
+        ec_fsm_coe_t *fsm, /**< Finite state machine */
+        ec_slave_t *slave, /**< EtherCAT slave */
+        ec_sdo_t *sdo /**< SDO from the slave's dictionary. */
+        )
+{
+    fsm->slave = slave;
+    fsm->request = NULL;
+    fsm->sdo = sdo;
+    fsm->single_sdo = 1;
+    fsm->state = ec_fsm_coe_dict_entries_start;
+}
+
+/*****************************************************************************/
+
 /** Starts to transfer an SDO to/from a slave.
  */
 void ec_fsm_coe_transfer(
@@ -212,6 +245,7 @@ void ec_fsm_coe_transfer(
     fsm->request = request;
 
     if (request->dir == EC_DIR_OUTPUT) {
+        ec_slave_invalidate_pdo_cache(slave, request->index);
         fsm->state = ec_fsm_coe_down_start;
     }
     else {
@@ -304,6 +338,41 @@ int ec_fsm_coe_check_emergency(
     return 1;
 }
 
+/*****************************************************************************/
+
+/** Requests the repetition of a lost mailbox response.
+ *
+ * If the response datagram got lost, or the mailbox was already emptied by
+ * a datagram that got lost, the slave is asked to write its last response
+ * to the mailbox again. The mailbox is then checked in \a check_state, so
+ * that the transfer does not have to be restarted.
+ *
+ * \return Non-zero, if the repetition was requested.
+ */
+static int ec_fsm_coe_repeat_response(
+        ec_fsm_coe_t *fsm, /**< Finite state machine. */
+        ec_datagram_t *datagram, /**< Datagram to use. */
+        void (*check_state)(ec_fsm_coe_t *, ec_datagram_t *) /**< Mailbox
+                                                               check state.
+                                                               */
+        )
+{
+    if (fsm->datagram->state == EC_DATAGRAM_RECEIVED
+            && fsm->datagram->working_counter) {
+        return 0;
+    }
+
+    if (ec_slave_mbox_request_repeat(fsm->slave, datagram)) {
+        return 0;
+    }
+
+    EC_SLAVE_WARN(fsm->slave, "CoE response lost. Requesting repetition.\n");
+    fsm->check_state = check_state;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_coe_repeat;
+    return 1;
+}
+
 /******************************************************************************
  *  CoE dictionary state machine
  *****************************************************************************/
@@ -511,6 +580,10 @@ void ec_fsm_coe_dict_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram, ec_fsm_coe_dict_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         fsm->state = ec_fsm_coe_error;
         EC_SLAVE_ERR(slave, "Failed to receive CoE dictionary"
@@ -581,7 +654,7 @@ void ec_fsm_coe_dict_response(
         return;
     }
 
-    first_segment = list_empty(&slave->sdo_dictionary) ? true : false;
+    first_segment = list_empty(&slave->dict->sdos) ? true : false;
     index_list_offset = first_segment ? 8 : 6;
 
     if (rec_size < index_list_offset || rec_size % 2) {
@@ -606,8 +679,9 @@ void ec_fsm_coe_dict_response(
             return;
         }
 
-        ec_sdo_init(sdo, slave, sdo_index);
-        list_add_tail(&sdo->list, &slave->sdo_dictionary);
+        ec_sdo_init(sdo, slave->dict, sdo_index);
+        // the slave information ioctl() counts the SDOs without locking
+        list_add_tail_rcu(&sdo->list, &slave->dict->sdos);
     }
 
     fragments_left = EC_READ_U16(data + 4);
@@ -625,14 +699,14 @@ void ec_fsm_coe_dict_response(
         return;
     }
 
-    if (list_empty(&slave->sdo_dictionary)) {
+    if (list_empty(&slave->dict->sdos)) {
         // no SDOs in dictionary. finished.
         fsm->state = ec_fsm_coe_end; // success
         return;
     }
 
     // fetch SDO descriptions
-    fsm->sdo = list_entry(slave->sdo_dictionary.next, ec_sdo_t, list);
+    fsm->sdo = list_entry(slave->dict->sdos.next, ec_sdo_t, list);
 
     fsm->retries = EC_FSM_RETRIES;
     if (ec_fsm_coe_dict_prepare_desc(fsm, datagram)) {
@@ -771,6 +845,57 @@ int ec_fsm_coe_dict_prepare_entry(
 
 /*****************************************************************************/
 
+/** CoE state: DICT ENTRIES START.
+ */
+void ec_fsm_coe_dict_entries_start(
+        ec_fsm_coe_t *fsm, /**< Finite state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (!(slave->sii.mailbox_protocols & EC_MBOX_COE)) {
+        EC_SLAVE_ERR(slave, "Slave does not support CoE!\n");
+        fsm->state = ec_fsm_coe_error;
+        return;
+    }
+
+    ec_sdo_clear_entries(fsm->sdo);
+
+    fsm->subindex = 0;
+    fsm->retries = EC_FSM_RETRIES;
+
+    if (ec_fsm_coe_dict_prepare_entry(fsm, datagram)) {
+        fsm->state = ec_fsm_coe_error;
+    }
+}
+
+/*****************************************************************************/
+
+/** Continues with the description of the next SDO in the dictionary.
+ */
+void ec_fsm_coe_dict_next_sdo(
+        ec_fsm_coe_t *fsm, /**< Finite state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (fsm->sdo->list.next == &slave->dict->sdos) {
+        fsm->state = ec_fsm_coe_end;
+        return;
+    }
+
+    fsm->sdo = list_entry(fsm->sdo->list.next, ec_sdo_t, list);
+    fsm->retries = EC_FSM_RETRIES;
+
+    if (ec_fsm_coe_dict_prepare_desc(fsm, datagram)) {
+        fsm->state = ec_fsm_coe_error;
+    }
+}
+
+/*****************************************************************************/
+
 /**
    CoE state: DICT DESC RESPONSE.
    \todo Timeout behavior
@@ -791,6 +916,11 @@ void ec_fsm_coe_dict_desc_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram,
+                ec_fsm_coe_dict_desc_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         fsm->state = ec_fsm_coe_error;
         EC_SLAVE_ERR(slave, "Failed to receive CoE SDO description"
@@ -894,6 +1024,13 @@ void ec_fsm_coe_dict_desc_response(
         return;
     }
 
+    if (!ec_slave_sdo_mapped(slave, sdo->index)) {
+        // fetch entries on first access
+        sdo->entries_pending = 1;
+        ec_fsm_coe_dict_next_sdo(fsm, datagram);
+        return;
+    }
+
     // start fetching entries
 
     fsm->subindex = 0;
@@ -1027,6 +1164,11 @@ void ec_fsm_coe_dict_entry_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram,
+                ec_fsm_coe_dict_entry_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         fsm->state = ec_fsm_coe_error;
         EC_SLAVE_ERR(slave, "Failed to receive CoE SDO"
@@ -1165,20 +1307,15 @@ void ec_fsm_coe_dict_entry_response(
         return;
     }
 
-    // another SDO description to fetch?
-    if (fsm->sdo->list.next != &slave->sdo_dictionary) {
-
-        fsm->sdo = list_entry(fsm->sdo->list.next, ec_sdo_t, list);
-        fsm->retries = EC_FSM_RETRIES;
-
-        if (ec_fsm_coe_dict_prepare_desc(fsm, datagram)) {
-            fsm->state = ec_fsm_coe_error;
-        }
+    sdo->entries_pending = 0;
 
+    if (fsm->single_sdo) {
+        fsm->state = ec_fsm_coe_end;
         return;
     }
 
-    fsm->state = ec_fsm_coe_end;
+    // another SDO description to fetch?
+    ec_fsm_coe_dict_next_sdo(fsm, datagram);
 }
 
 /******************************************************************************
@@ -1541,6 +1678,10 @@ void ec_fsm_coe_down_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram, ec_fsm_coe_down_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         request->errno = EIO;
         fsm->state = ec_fsm_coe_error;
@@ -1719,6 +1860,11 @@ void ec_fsm_coe_down_seg_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram,
+                ec_fsm_coe_down_seg_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         request->errno = EIO;
         fsm->state = ec_fsm_coe_error;
@@ -1851,9 +1997,11 @@ int ec_fsm_coe_prepare_up(
     }
 
     EC_WRITE_U16(data, 0x2 << 12); // SDO request
-    EC_WRITE_U8 (data + 2, 0x2 << 5); // initiate upload request
+    EC_WRITE_U8 (data + 2, 0x2 << 5 // initiate upload request
+            | ((request->complete_access ? 1 : 0) << 4));
     EC_WRITE_U16(data + 3, request->index);
-    EC_WRITE_U8 (data + 5, request->subindex);
+    EC_WRITE_U8 (data + 5,
+            request->complete_access ? 0x00 : request->subindex);
     memset(data + 6, 0x00, 4);
 
     if (master->debug_level) {
@@ -2079,6 +2227,10 @@ void ec_fsm_coe_up_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram, ec_fsm_coe_up_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         request->errno = EIO;
         fsm->state = ec_fsm_coe_error;
@@ -2383,6 +2535,10 @@ void ec_fsm_coe_up_seg_response(
         return;
     }
 
+    if (ec_fsm_coe_repeat_response(fsm, datagram, ec_fsm_coe_up_seg_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         request->errno = EIO;
         fsm->state = ec_fsm_coe_error;
@@ -2505,6 +2661,52 @@ void ec_fsm_coe_up_seg_response(
     fsm->state = ec_fsm_coe_end; // success
 }
 
+/******************************************************************************
+ *  Common functions
+ *****************************************************************************/
+
+/** CoE state: REPEAT.
+ *
+ * Waits for the repeat request to be written and checks the mailbox again.
+ */
+void ec_fsm_coe_repeat(
+        ec_fsm_coe_t *fsm, /**< Finite state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (fsm->datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        ec_slave_mbox_prepare_repeat(slave, datagram); // can not fail.
+        return;
+    }
+
+    if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
+        if (fsm->request) {
+            fsm->request->errno = EIO;
+        }
+        fsm->state = ec_fsm_coe_error;
+        EC_SLAVE_ERR(slave, "Failed to receive CoE repeat request"
+                " datagram: ");
+        ec_datagram_print_state(fsm->datagram);
+        return;
+    }
+
+    if (fsm->datagram->working_counter != 1) {
+        if (fsm->request) {
+            fsm->request->errno = EIO;
+        }
+        fsm->state = ec_fsm_coe_error;
+        EC_SLAVE_ERR(slave, "Reception of CoE repeat request failed: ");
+        ec_datagram_print_wc_error(fsm->datagram);
+        return;
+    }
+
+    ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = fsm->check_state;
+}
+
 /*****************************************************************************/
 
 /**
@@ -58,12 +58,18 @@ struct ec_fsm_coe {
     unsigned long jiffies_start; /**< CoE timestamp. */
     ec_sdo_t *sdo; /**< current SDO */
     uint8_t subindex; /**< current subindex */
+    unsigned int single_sdo; /**< Only the entry descriptions of \a sdo are
+                               fetched. */
     ec_sdo_request_t *request; /**< SDO request */
     uint32_t complete_size; /**< Used when segmenting. */
     uint8_t toggle; /**< toggle bit for segment commands */
     uint32_t offset; /**< Data offset during segmented download. */
     uint32_t remaining; /**< Remaining bytes during segmented download. */
     size_t segment_size; /**< Current segment size. */
+    void (*check_state)(ec_fsm_coe_t *, ec_datagram_t *); /**< Mailbox check
+                                                            state to continue
+                                                            with after a
+                                                            repeat request. */
 };
 
 /*****************************************************************************/
@@ -72,6 +78,7 @@ void ec_fsm_coe_init(ec_fsm_coe_t *);
 void ec_fsm_coe_clear(ec_fsm_coe_t *);
 
 void ec_fsm_coe_dictionary(ec_fsm_coe_t *, ec_slave_t *);
+void ec_fsm_coe_dict_entries(ec_fsm_coe_t *, ec_slave_t *, ec_sdo_t *);
 void ec_fsm_coe_transfer(ec_fsm_coe_t *, ec_slave_t *, ec_sdo_request_t *);
 
 int ec_fsm_coe_exec(ec_fsm_coe_t *, ec_datagram_t *);
@@ -84,6 +84,7 @@ void ec_foe_set_rx_error(ec_fsm_foe_t *, uint32_t);
 
 void ec_fsm_foe_end(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_error(ec_fsm_foe_t *, ec_datagram_t *);
+void ec_fsm_foe_repeat(ec_fsm_foe_t *, ec_datagram_t *);
 
 void ec_fsm_foe_state_wrq_sent(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_state_rrq_sent(ec_fsm_foe_t *, ec_datagram_t *);
@@ -97,6 +98,8 @@ void ec_fsm_foe_state_data_check(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_state_data_read(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_state_sent_ack(ec_fsm_foe_t *, ec_datagram_t *);
 
+void ec_fsm_foe_state_stream_wait(ec_fsm_foe_t *, ec_datagram_t *);
+
 void ec_fsm_foe_write_start(ec_fsm_foe_t *, ec_datagram_t *);
 void ec_fsm_foe_read_start(ec_fsm_foe_t *, ec_datagram_t *);
 
@@ -177,6 +180,7 @@ void ec_fsm_foe_transfer(
 {
     fsm->slave = slave;
     fsm->request = request;
+    request->progress = 0;
 
     if (request->dir == EC_DIR_OUTPUT) {
         fsm->tx_buffer = fsm->request->buffer;
@@ -229,6 +233,197 @@ void ec_fsm_foe_end(
 
 /*****************************************************************************/
 
+/** Requests the repetition of a lost mailbox response.
+ *
+ * If the response datagram got lost, or the mailbox was already emptied by
+ * a datagram that got lost, the slave is asked to write its last response
+ * to the mailbox again. The mailbox is then checked in \a check_state, so
+ * that the transfer does not have to be restarted.
+ *
+ * \return Non-zero, if the repetition was requested.
+ */
+static int ec_fsm_foe_repeat_response(
+        ec_fsm_foe_t *fsm, /**< FoE statemachine. */
+        ec_datagram_t *datagram, /**< Datagram to use. */
+        void (*check_state)(ec_fsm_foe_t *, ec_datagram_t *) /**< Mailbox
+                                                               check state.
+                                                               */
+        )
+{
+    if (fsm->datagram->state == EC_DATAGRAM_RECEIVED
+            && fsm->datagram->working_counter) {
+        return 0;
+    }
+
+    if (ec_slave_mbox_request_repeat(fsm->slave, datagram)) {
+        return 0;
+    }
+
+    EC_SLAVE_WARN(fsm->slave, "FoE response lost. Requesting repetition.\n");
+    fsm->check_state = check_state;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_foe_repeat;
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** State: REPEAT.
+ *
+ * Waits for the repeat request to be written and checks the mailbox again.
+ */
+void ec_fsm_foe_repeat(
+        ec_fsm_foe_t *fsm, /**< FoE statemachine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
+#ifdef DEBUG_FOE
+    EC_SLAVE_DBG(fsm->slave, 0, "%s()\n", __func__);
+#endif
+
+    if (fsm->datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        ec_slave_mbox_prepare_repeat(slave, datagram); // can not fail.
+        return;
+    }
+
+    if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
+        ec_foe_set_rx_error(fsm, FOE_RECEIVE_ERROR);
+        EC_SLAVE_ERR(slave, "Failed to receive FoE repeat request"
+                " datagram: ");
+        ec_datagram_print_state(fsm->datagram);
+        return;
+    }
+
+    if (fsm->datagram->working_counter != 1) {
+        ec_foe_set_rx_error(fsm, FOE_WC_ERROR);
+        EC_SLAVE_ERR(slave, "Reception of FoE repeat request failed: ");
+        ec_datagram_print_wc_error(fsm->datagram);
+        return;
+    }
+
+    ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = fsm->check_state;
+}
+
+/*****************************************************************************/
+
+/** Prepares a mailbox check and fetches the response immediately, if
+ * possible.
+ *
+ * If the check could be answered from the mailbox status area (see
+ * ec_slave_mbox_prepare_check()) and the slave already signals new mailbox
+ * data, the check round trip is skipped and the mailbox is fetched right
+ * away.
+ */
+static void ec_fsm_foe_prepare_check(
+        ec_fsm_foe_t *fsm, /**< FoE statemachine. */
+        ec_datagram_t *datagram, /**< Datagram to use. */
+        void (*check_state)(ec_fsm_foe_t *, ec_datagram_t *), /**< Mailbox
+                                                                check state.
+                                                                */
+        void (*read_state)(ec_fsm_foe_t *, ec_datagram_t *) /**< Mailbox
+                                                              read state. */
+        )
+{
+    ec_slave_mbox_prepare_check(fsm->slave, datagram); // can not fail.
+    fsm->retries = EC_FSM_RETRIES;
+
+    if (datagram->state == EC_DATAGRAM_RECEIVED
+            && ec_slave_mbox_check(datagram)) {
+        ec_slave_mbox_prepare_fetch(fsm->slave, datagram); // can not fail.
+        fsm->state = read_state;
+    } else {
+        fsm->state = check_state;
+    }
+}
+
+/*****************************************************************************/
+
+/** Returns the maximum FoE data size of a fragment sent to the slave.
+ *
+ * \return Fragment size in byte.
+ */
+static size_t ec_fsm_foe_tx_fragment_size(
+        const ec_fsm_foe_t *fsm /**< Finite state machine. */
+        )
+{
+    // the fragments are written to the receive mailbox of the slave, so
+    // use all of it
+    return fsm->slave->configured_rx_mailbox_size
+        - EC_MBOX_HEADER_SIZE - EC_FOE_HEADER_SIZE;
+}
+
+/*****************************************************************************/
+
+/** Hands the window of a streamed request over to the application.
+ *
+ * The caller has to set the request's \a data_size before. The mailbox is
+ * checked while waiting, so that the state machine keeps a datagram.
+ */
+static void ec_fsm_foe_stream_handover(
+        ec_fsm_foe_t *fsm, /**< Finite state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_foe_request_t *request = fsm->request;
+
+    if (!request->stream_wait) {
+        smp_wmb(); // window contents before the flag
+        request->stream_wait = 1;
+        wake_up_all(&fsm->slave->master->request_queue);
+    }
+
+    fsm->jiffies_start = jiffies;
+    ec_slave_mbox_prepare_check(fsm->slave, datagram); // can not fail.
+    fsm->state = ec_fsm_foe_state_stream_wait;
+}
+
+/*****************************************************************************/
+
+/** Asks the application for new data, if the window of a streamed write
+ * request does not contain the next fragment.
+ *
+ * The bytes not sent yet are moved to the start of the window.
+ *
+ * \return Non-zero, if the state machine has to wait for new data.
+ */
+static int ec_fsm_foe_stream_refill(
+        ec_fsm_foe_t *fsm, /**< Finite state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_foe_request_t *request = fsm->request;
+    size_t remaining_size;
+
+    if (!request->stream) {
+        return 0;
+    }
+
+    if (!request->stream_wait) {
+        remaining_size = fsm->tx_buffer_size - fsm->tx_buffer_offset;
+
+        if (request->stream_end
+                || remaining_size >= ec_fsm_foe_tx_fragment_size(fsm)) {
+            return 0;
+        }
+
+        memmove(fsm->tx_buffer, fsm->tx_buffer + fsm->tx_buffer_offset,
+                remaining_size);
+        request->window_offset += fsm->tx_buffer_offset;
+        request->data_size = remaining_size;
+        fsm->tx_buffer_size = remaining_size;
+        fsm->tx_buffer_offset = 0;
+    }
+
+    ec_fsm_foe_stream_handover(fsm, datagram);
+    return 1;
+}
+
+/*****************************************************************************/
+
 /** Sends a file or the next fragment.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -238,18 +433,17 @@ int ec_foe_prepare_data_send(
         ec_datagram_t *datagram /**< Datagram to use. */
         )
 {
-    size_t remaining_size, current_size;
+    size_t remaining_size, current_size, max_size;
     uint8_t *data;
 
+    max_size = ec_fsm_foe_tx_fragment_size(fsm);
     remaining_size = fsm->tx_buffer_size - fsm->tx_buffer_offset;
 
-    if (remaining_size < fsm->slave->configured_tx_mailbox_size
-            - EC_MBOX_HEADER_SIZE - EC_FOE_HEADER_SIZE) {
+    if (remaining_size < max_size) {
         current_size = remaining_size;
         fsm->tx_last_packet = 1;
     } else {
-        current_size = fsm->slave->configured_tx_mailbox_size
-            - EC_MBOX_HEADER_SIZE - EC_FOE_HEADER_SIZE;
+        current_size = max_size;
     }
 
     data = ec_slave_mbox_prepare_send(fsm->slave,
@@ -378,8 +572,8 @@ void ec_fsm_foe_state_ack_check(
             return;
         }
 
-        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-        fsm->retries = EC_FSM_RETRIES;
+        ec_fsm_foe_prepare_check(fsm, datagram,
+                ec_fsm_foe_state_ack_check, ec_fsm_foe_state_ack_read);
         return;
     }
 
@@ -408,6 +602,11 @@ void ec_fsm_foe_state_ack_read(
     EC_SLAVE_DBG(fsm->slave, 0, "%s()\n", __func__);
 #endif
 
+    if (ec_fsm_foe_repeat_response(fsm, datagram,
+                ec_fsm_foe_state_ack_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         ec_foe_set_rx_error(fsm, FOE_RECEIVE_ERROR);
         EC_SLAVE_ERR(slave, "Failed to receive FoE ack response datagram: ");
@@ -451,12 +650,18 @@ void ec_fsm_foe_state_ack_read(
     if (opCode == EC_FOE_OPCODE_ACK) {
         fsm->tx_packet_no++;
         fsm->tx_buffer_offset += fsm->tx_current_size;
+        fsm->request->progress =
+            fsm->request->window_offset + fsm->tx_buffer_offset;
 
         if (fsm->tx_last_packet) {
             fsm->state = ec_fsm_foe_end;
             return;
         }
 
+        if (ec_fsm_foe_stream_refill(fsm, datagram)) {
+            return;
+        }
+
         if (ec_foe_prepare_data_send(fsm, datagram)) {
             ec_foe_set_tx_error(fsm, FOE_PROT_ERROR);
             return;
@@ -502,10 +707,8 @@ void ec_fsm_foe_state_wrq_sent(
 
     fsm->jiffies_start = fsm->datagram->jiffies_sent;
 
-    ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-
-    fsm->retries = EC_FSM_RETRIES;
-    fsm->state = ec_fsm_foe_state_ack_check;
+    ec_fsm_foe_prepare_check(fsm, datagram,
+            ec_fsm_foe_state_ack_check, ec_fsm_foe_state_ack_read);
 }
 
 /*****************************************************************************/
@@ -540,10 +743,9 @@ void ec_fsm_foe_state_data_sent(
         return;
     }
 
-    ec_slave_mbox_prepare_check(slave, datagram);
     fsm->jiffies_start = jiffies;
-    fsm->retries = EC_FSM_RETRIES;
-    fsm->state = ec_fsm_foe_state_ack_check;
+    ec_fsm_foe_prepare_check(fsm, datagram,
+            ec_fsm_foe_state_ack_check, ec_fsm_foe_state_ack_read);
 }
 
 /*****************************************************************************/
@@ -640,10 +842,8 @@ void ec_fsm_foe_state_rrq_sent(
 
     fsm->jiffies_start = fsm->datagram->jiffies_sent;
 
-    ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-
-    fsm->retries = EC_FSM_RETRIES;
-    fsm->state = ec_fsm_foe_state_data_check;
+    ec_fsm_foe_prepare_check(fsm, datagram,
+            ec_fsm_foe_state_data_check, ec_fsm_foe_state_data_read);
 }
 
 /*****************************************************************************/
@@ -717,8 +917,8 @@ void ec_fsm_foe_state_data_check(
             return;
         }
 
-        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-        fsm->retries = EC_FSM_RETRIES;
+        ec_fsm_foe_prepare_check(fsm, datagram,
+                ec_fsm_foe_state_data_check, ec_fsm_foe_state_data_read);
         return;
     }
 
@@ -747,6 +947,11 @@ void ec_fsm_foe_state_data_read(
     EC_SLAVE_DBG(fsm->slave, 0, "%s()\n", __func__);
 #endif
 
+    if (ec_fsm_foe_repeat_response(fsm, datagram,
+                ec_fsm_foe_state_data_check)) {
+        return;
+    }
+
     if (fsm->datagram->state != EC_DATAGRAM_RECEIVED) {
         ec_foe_set_rx_error(fsm, FOE_RECEIVE_ERROR);
         EC_SLAVE_ERR(slave, "Failed to receive FoE DATA READ datagram: ");
@@ -817,14 +1022,17 @@ void ec_fsm_foe_state_data_read(
         memcpy(fsm->rx_buffer + fsm->rx_buffer_offset,
                 data + EC_FOE_HEADER_SIZE, rec_size);
         fsm->rx_buffer_offset += rec_size;
+        fsm->request->progress =
+            fsm->request->window_offset + fsm->rx_buffer_offset;
     }
 
+    // the slave sends the fragments via its send mailbox
     fsm->rx_last_packet =
         (rec_size + EC_MBOX_HEADER_SIZE + EC_FOE_HEADER_SIZE
-         != slave->configured_rx_mailbox_size);
+         != slave->configured_tx_mailbox_size);
 
     if (fsm->rx_last_packet ||
-            (slave->configured_rx_mailbox_size - EC_MBOX_HEADER_SIZE
+            (slave->configured_tx_mailbox_size - EC_MBOX_HEADER_SIZE
              - EC_FOE_HEADER_SIZE + fsm->rx_buffer_offset)
             <= fsm->rx_buffer_size) {
         // either it was the last packet or a new packet will fit into the
@@ -839,6 +1047,12 @@ void ec_fsm_foe_state_data_read(
 
         fsm->state = ec_fsm_foe_state_sent_ack;
     }
+    else if (fsm->request->stream) {
+        // let the application empty the window before acknowledging, so
+        // that the slave does not send the next fragment too early
+        fsm->request->data_size = fsm->rx_buffer_offset;
+        ec_fsm_foe_stream_handover(fsm, datagram);
+    }
     else {
         // no more data fits into the delivered buffer
         // ... wait for new read request
@@ -846,7 +1060,7 @@ void ec_fsm_foe_state_data_read(
         printk("  rx_buffer_size = %d\n", fsm->rx_buffer_size);
         printk("rx_buffer_offset = %d\n", fsm->rx_buffer_offset);
         printk("        rec_size = %zd\n", rec_size);
-        printk(" rx_mailbox_size = %d\n", slave->configured_rx_mailbox_size);
+        printk(" tx_mailbox_size = %d\n", slave->configured_tx_mailbox_size);
         printk("  rx_last_packet = %d\n", fsm->rx_last_packet);
         fsm->request->result = FOE_READY;
     }
@@ -884,8 +1098,6 @@ void ec_fsm_foe_state_sent_ack(
 
     fsm->jiffies_start = fsm->datagram->jiffies_sent;
 
-    ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-
     if (fsm->rx_last_packet) {
         fsm->rx_expected_packet_no = 0;
         fsm->request->data_size = fsm->rx_buffer_offset;
@@ -893,8 +1105,78 @@ void ec_fsm_foe_state_sent_ack(
     }
     else {
         fsm->rx_expected_packet_no++;
-        fsm->retries = EC_FSM_RETRIES;
-        fsm->state = ec_fsm_foe_state_data_check;
+        ec_fsm_foe_prepare_check(fsm, datagram,
+                ec_fsm_foe_state_data_check, ec_fsm_foe_state_data_read);
+    }
+}
+
+/*****************************************************************************/
+
+/** State: STREAM WAIT.
+ *
+ * Waits for the application to refill (write) or empty (read) the window of
+ * a streamed request, then continues with the next fragment or the
+ * acknowledge of the last one.
+ */
+void ec_fsm_foe_state_stream_wait(
+        ec_fsm_foe_t *fsm, /**< FoE statemachine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_foe_request_t *request = fsm->request;
+
+#ifdef DEBUG_FOE
+    EC_SLAVE_DBG(fsm->slave, 0, "%s()\n", __func__);
+#endif
+
+    if (request->stream_abort) {
+        EC_SLAVE_ERR(slave, "FoE transfer aborted by the application.\n");
+        if (request->dir == EC_DIR_OUTPUT) {
+            ec_foe_set_tx_error(fsm, FOE_NODATA_ERROR);
+        } else {
+            ec_foe_set_rx_error(fsm, FOE_SEND_RX_DATA_ERROR);
+        }
+        return;
+    }
+
+    if (request->stream_wait) {
+        if ((jiffies - fsm->jiffies_start) * 1000 / HZ
+                >= EC_FSM_FOE_TIMEOUT) {
+            EC_SLAVE_ERR(slave, "Timeout while waiting for the"
+                    " application.\n");
+            ec_foe_set_tx_error(fsm, FOE_TIMEOUT_ERROR);
+            return;
+        }
+
+        // keep the mailbox state up to date while waiting
+        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
+        return;
+    }
+
+    smp_rmb(); // flag before the window contents
+
+    if (request->dir == EC_DIR_OUTPUT) {
+        fsm->tx_buffer_size = request->data_size;
+        fsm->tx_buffer_offset = 0;
+
+        if (ec_fsm_foe_stream_refill(fsm, datagram)) {
+            return;
+        }
+
+        if (ec_foe_prepare_data_send(fsm, datagram)) {
+            ec_foe_set_tx_error(fsm, FOE_PROT_ERROR);
+            return;
+        }
+        fsm->state = ec_fsm_foe_state_data_sent;
+    } else {
+        fsm->rx_buffer_offset = request->data_size;
+
+        if (ec_foe_prepare_send_ack(fsm, datagram)) {
+            ec_foe_set_rx_error(fsm, FOE_RX_DATA_ACK_ERROR);
+            return;
+        }
+        fsm->state = ec_fsm_foe_state_sent_ack;
     }
 }
 
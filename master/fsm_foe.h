@@ -77,6 +77,11 @@ struct ec_fsm_foe {
     uint32_t rx_last_packet; /**< Current packet is the last to receive. */
     uint8_t *rx_filename; /**< Name of the file to receive. */
     uint32_t rx_filename_len; /**< Length of the receive file name. */
+
+    void (*check_state)(ec_fsm_foe_t *, ec_datagram_t *); /**< Mailbox check
+                                                            state to continue
+                                                            with after a
+                                                            repeat request. */
 };
 
 /*****************************************************************************/
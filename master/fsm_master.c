@@ -43,6 +43,7 @@
 
 #include "fsm_master.h"
 #include "fsm_foe.h"
+#include "trace.h"
 
 /*****************************************************************************/
 
@@ -50,24 +51,36 @@
  */
 #define EC_SYSTEM_TIME_TOLERANCE_NS 1000000
 
+/** Time [s] to wait for the slaves to follow a grouped OP request.
+ */
+#define EC_GROUP_OP_TIMEOUT 5
+
 /*****************************************************************************/
 
 void ec_fsm_master_state_start(ec_fsm_master_t *);
 void ec_fsm_master_state_broadcast(ec_fsm_master_t *);
 void ec_fsm_master_state_read_state(ec_fsm_master_t *);
 void ec_fsm_master_state_acknowledge(ec_fsm_master_t *);
-void ec_fsm_master_state_configure_slave(ec_fsm_master_t *);
+void ec_fsm_master_state_wait_configs(ec_fsm_master_t *);
 void ec_fsm_master_state_clear_addresses(ec_fsm_master_t *);
 void ec_fsm_master_state_dc_measure_delays(ec_fsm_master_t *);
-void ec_fsm_master_state_scan_slave(ec_fsm_master_t *);
-void ec_fsm_master_state_dc_read_offset(ec_fsm_master_t *);
-void ec_fsm_master_state_dc_write_offset(ec_fsm_master_t *);
-void ec_fsm_master_state_write_sii(ec_fsm_master_t *);
-void ec_fsm_master_state_sdo_dictionary(ec_fsm_master_t *);
-void ec_fsm_master_state_sdo_request(ec_fsm_master_t *);
+void ec_fsm_master_state_scan_slaves(ec_fsm_master_t *);
+void ec_fsm_master_state_scan_mailbox(ec_fsm_master_t *);
+void ec_fsm_master_state_verify_slaves(ec_fsm_master_t *);
+void ec_fsm_master_state_group_op(ec_fsm_master_t *);
+void ec_fsm_master_state_group_op_check(ec_fsm_master_t *);
+void ec_fsm_master_state_dc_read_offsets(ec_fsm_master_t *);
+void ec_fsm_master_state_dc_write_offsets(ec_fsm_master_t *);
 
 void ec_fsm_master_enter_clear_addresses(ec_fsm_master_t *);
 void ec_fsm_master_enter_write_system_times(ec_fsm_master_t *);
+void ec_fsm_master_enter_scan_mailbox(ec_fsm_master_t *);
+void ec_fsm_master_enter_wait_configs(ec_fsm_master_t *);
+void ec_fsm_master_enter_read_state(ec_fsm_master_t *);
+void ec_fsm_master_eval_state(ec_fsm_master_t *, ec_datagram_t *);
+int ec_fsm_master_enter_verify_slaves(ec_fsm_master_t *);
+int ec_fsm_master_enter_group_op(ec_fsm_master_t *);
+void ec_fsm_master_enter_group_op_check(ec_fsm_master_t *);
 
 /*****************************************************************************/
 
@@ -79,8 +92,11 @@ void ec_fsm_master_init(
         ec_datagram_t *datagram /**< Datagram object to use. */
         )
 {
+    unsigned int i;
+
     fsm->master = master;
     fsm->datagram = datagram;
+    ec_startup_timer_init(&fsm->scan_timer);
 
     ec_fsm_master_reset(fsm);
 
@@ -93,7 +109,82 @@ void ec_fsm_master_init(
             &fsm->fsm_change, &fsm->fsm_coe, &fsm->fsm_soe, &fsm->fsm_pdo);
     ec_fsm_slave_scan_init(&fsm->fsm_slave_scan, fsm->datagram,
             &fsm->fsm_slave_config, &fsm->fsm_pdo);
-    ec_fsm_sii_init(&fsm->fsm_sii, fsm->datagram);
+
+    /* The parallel scan state machines only do the non-mailbox part of the
+     * scan, so they get no slave configuration state machine. */
+    for (i = 0; i < EC_FSM_MASTER_SCANS; i++) {
+        ec_datagram_init(&fsm->scan_datagrams[i]);
+        snprintf(fsm->scan_datagrams[i].name, EC_DATAGRAM_NAME_SIZE,
+                "scan%u", i);
+        fsm->scan_datagrams[i].traffic_class = EC_TC_MASTER_FSM;
+        ec_fsm_slave_scan_init(&fsm->scan_fsms[i], &fsm->scan_datagrams[i],
+                NULL, NULL);
+    }
+
+    ec_datagram_init(&fsm->al_datagram);
+    snprintf(fsm->al_datagram.name, EC_DATAGRAM_NAME_SIZE, "al-status");
+    fsm->al_datagram.traffic_class = EC_TC_MASTER_FSM;
+
+    ec_datagram_init(&fsm->mbox_datagram);
+    snprintf(fsm->mbox_datagram.name, EC_DATAGRAM_NAME_SIZE, "mbox-status");
+    fsm->mbox_datagram.traffic_class = EC_TC_MASTER_FSM;
+    fsm->mbox_seq = 0;
+    fsm->mbox_valid_seq = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_MBOX_DATAGRAMS; i++) {
+        ec_datagram_init(&fsm->mbox_data_datagrams[i]);
+        snprintf(fsm->mbox_data_datagrams[i].name, EC_DATAGRAM_NAME_SIZE,
+                "mbox-data%u", i);
+        fsm->mbox_data_datagrams[i].traffic_class = EC_TC_MAILBOX;
+    }
+    fsm->mbox_data_seq = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_STATE_DATAGRAMS; i++) {
+        ec_datagram_init(&fsm->state_datagrams[i]);
+        snprintf(fsm->state_datagrams[i].name, EC_DATAGRAM_NAME_SIZE,
+                "al-state%u", i);
+        fsm->state_datagrams[i].traffic_class = EC_TC_MASTER_FSM;
+    }
+
+    for (i = 0; i < EC_FSM_MASTER_REG_DATAGRAMS; i++) {
+        ec_datagram_init(&fsm->reg_datagrams[i]);
+        snprintf(fsm->reg_datagrams[i].name, EC_DATAGRAM_NAME_SIZE,
+                "reg-batch%u", i);
+        fsm->reg_datagrams[i].traffic_class = EC_TC_MASTER_FSM;
+    }
+    fsm->reg_batch = NULL;
+    memset(&fsm->error_batch, 0, sizeof(fsm->error_batch));
+    memset(&fsm->dc_mon_batch, 0, sizeof(fsm->dc_mon_batch));
+    memset(&fsm->wc_probe_batch, 0, sizeof(fsm->wc_probe_batch));
+    fsm->wc_probe_domain = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_DC_DATAGRAMS; i++) {
+        ec_datagram_init(&fsm->dc_datagrams[i]);
+        snprintf(fsm->dc_datagrams[i].name, EC_DATAGRAM_NAME_SIZE,
+                "dc-offset%u", i);
+        fsm->dc_datagrams[i].traffic_class = EC_TC_MASTER_FSM;
+    }
+    fsm->error_jiffies = jiffies;
+    fsm->dc_mon_jiffies = jiffies;
+    fsm->monitor_interval = 0;
+    fsm->monitor_jiffies = jiffies;
+    fsm->monitor_hold = 0;
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        ec_fsm_master_config_t *config = &fsm->configs[i];
+
+        ec_datagram_init(&config->datagram);
+        snprintf(config->datagram.name, EC_DATAGRAM_NAME_SIZE,
+                "config%u", i);
+        config->datagram.traffic_class = EC_TC_MASTER_FSM;
+        ec_fsm_coe_init(&config->fsm_coe);
+        ec_fsm_soe_init(&config->fsm_soe);
+        ec_fsm_pdo_init(&config->fsm_pdo, &config->fsm_coe);
+        ec_fsm_change_init(&config->fsm_change, &config->datagram);
+        ec_fsm_slave_config_init(&config->fsm_slave_config,
+                &config->datagram, &config->fsm_change, &config->fsm_coe,
+                &config->fsm_soe, &config->fsm_pdo);
+    }
 }
 
 /*****************************************************************************/
@@ -104,6 +195,46 @@ void ec_fsm_master_clear(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
+    unsigned int i;
+
+    for (i = 0; i < EC_FSM_MASTER_SCANS; i++) {
+        ec_fsm_slave_scan_clear(&fsm->scan_fsms[i]);
+        ec_datagram_clear(&fsm->scan_datagrams[i]);
+    }
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        ec_fsm_master_config_t *config = &fsm->configs[i];
+
+        ec_fsm_slave_config_clear(&config->fsm_slave_config);
+        ec_fsm_change_clear(&config->fsm_change);
+        ec_fsm_pdo_clear(&config->fsm_pdo);
+        ec_fsm_soe_clear(&config->fsm_soe);
+        ec_fsm_coe_clear(&config->fsm_coe);
+        ec_datagram_clear(&config->datagram);
+    }
+
+    ec_datagram_clear(&fsm->al_datagram);
+    ec_datagram_clear(&fsm->mbox_datagram);
+
+    for (i = 0; i < EC_FSM_MASTER_MBOX_DATAGRAMS; i++) {
+        ec_datagram_clear(&fsm->mbox_data_datagrams[i]);
+    }
+
+    for (i = 0; i < EC_FSM_MASTER_STATE_DATAGRAMS; i++) {
+        ec_datagram_clear(&fsm->state_datagrams[i]);
+    }
+
+    for (i = 0; i < EC_FSM_MASTER_REG_DATAGRAMS; i++) {
+        ec_datagram_clear(&fsm->reg_datagrams[i]);
+    }
+    ec_reg_batch_clear(&fsm->error_batch);
+    ec_reg_batch_clear(&fsm->dc_mon_batch);
+    ec_reg_batch_clear(&fsm->wc_probe_batch);
+
+    for (i = 0; i < EC_FSM_MASTER_DC_DATAGRAMS; i++) {
+        ec_datagram_clear(&fsm->dc_datagrams[i]);
+    }
+
     // clear sub-state machines
     ec_fsm_coe_clear(&fsm->fsm_coe);
     ec_fsm_soe_clear(&fsm->fsm_soe);
@@ -111,7 +242,6 @@ void ec_fsm_master_clear(
     ec_fsm_change_clear(&fsm->fsm_change);
     ec_fsm_slave_config_clear(&fsm->fsm_slave_config);
     ec_fsm_slave_scan_clear(&fsm->fsm_slave_scan);
-    ec_fsm_sii_clear(&fsm->fsm_sii);
 }
 
 /*****************************************************************************/
@@ -123,6 +253,7 @@ void ec_fsm_master_reset(
         )
 {
     ec_device_index_t dev_idx;
+    unsigned int i;
 
     fsm->state = ec_fsm_master_state_start;
     fsm->idle = 0;
@@ -136,526 +267,1878 @@ void ec_fsm_master_reset(
     }
 
     fsm->rescan_required = 0;
+    fsm->rescan_full = 0;
+    fsm->monitor_interval = 0;
+    fsm->monitor_hold = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_SCANS; i++) {
+        fsm->scan_fsms[i].slave = NULL;
+    }
+    fsm->scan_mask = 0;
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        fsm->configs[i].slave = NULL;
+    }
+    fsm->config_mask = 0;
+    fsm->al_queue = 0;
+    fsm->al_pending = 0;
+    fsm->mbox_queue = 0;
+    fsm->mbox_pending = 0;
+    fsm->mbox_size = 0;
+    fsm->mbox_data_count = 0;
+    fsm->mbox_data_mask = 0;
+    fsm->state_count = 0;
+    fsm->state_mask = 0;
+    fsm->state_inline = 0;
+
+    if (fsm->reg_batch == &fsm->error_batch
+            || fsm->reg_batch == &fsm->dc_mon_batch
+            || fsm->reg_batch == &fsm->wc_probe_batch) {
+        ec_reg_batch_clear(fsm->reg_batch);
+    } else if (fsm->reg_batch) {
+        fsm->reg_batch->state = EC_INT_REQUEST_FAILURE;
+        wake_up_all(&fsm->master->request_queue);
+    }
+    fsm->reg_batch = NULL;
+    fsm->reg_count = 0;
+    fsm->reg_mask = 0;
+
+    fsm->dc_count = 0;
+    fsm->dc_mask = 0;
+
+    fsm->group_op_single = 0;
 }
 
 /*****************************************************************************/
 
-/** Executes the current state of the state machine.
+/** Returns the number of slaves that are currently being configured.
  *
- * If the state machine's datagram is not sent or received yet, the execution
- * of the state machine is delayed to the next cycle.
+ * \return Number of busy configuration units.
+ */
+static unsigned int ec_fsm_master_configs_busy(
+        const ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    unsigned int i, busy = 0;
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        if (fsm->configs[i].slave) {
+            busy++;
+        }
+    }
+
+    return busy;
+}
+
+/*****************************************************************************/
+
+/** Checks, if a slave is currently being configured.
  *
- * \return true, if the state machine was executed
+ * \return Non-zero, if a configuration unit is busy with the slave.
  */
-int ec_fsm_master_exec(
-        ec_fsm_master_t *fsm /**< Master state machine. */
+static int ec_fsm_master_slave_configuring(
+        const ec_fsm_master_t *fsm, /**< Master state machine. */
+        const ec_slave_t *slave /**< EtherCAT slave. */
         )
 {
-    if (fsm->datagram->state == EC_DATAGRAM_SENT
-        || fsm->datagram->state == EC_DATAGRAM_QUEUED) {
-        // datagram was not sent or received yet.
-        return 0;
+    unsigned int i;
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        if (fsm->configs[i].slave == slave) {
+            return 1;
+        }
     }
 
-    fsm->state(fsm);
-    return 1;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/**
- * \return true, if the state machine is in an idle phase
+/** Checks, if a slave waits for a grouped OP request.
+ *
+ * \return Non-zero, if the slave can be brought to OP together with the
+ *         other waiting slaves.
  */
-int ec_fsm_master_idle(
-        const ec_fsm_master_t *fsm /**< Master state machine. */
+static int ec_fsm_master_group_op_waiting(
+        const ec_slave_t *slave /**< EtherCAT slave. */
         )
 {
-    return fsm->idle;
+    return slave->group_op && slave->al_status_mapped
+        && slave->current_state == EC_SLAVE_STATE_SAFEOP
+        && slave->requested_state == EC_SLAVE_STATE_OP
+        && !slave->force_config && !slave->error_flag;
 }
 
 /*****************************************************************************/
 
-/** Restarts the master state machine.
+/** Prepares reading the AL status area.
+ *
+ * If slaves have their AL status mapped via a spare FMMU, the AL states of
+ * all of them are read with a single LRD datagram.
  */
-void ec_fsm_master_restart(
+static void ec_fsm_master_read_al_status(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    fsm->dev_idx = EC_DEVICE_MAIN;
-    fsm->state = ec_fsm_master_state_start;
-    fsm->state(fsm); // execute immediately
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram = &fsm->al_datagram;
+    const ec_slave_t *slave;
+    size_t size = 0;
+
+    if (!ec_al_status_fmmu || datagram->state == EC_DATAGRAM_QUEUED
+            || datagram->state == EC_DATAGRAM_SENT) {
+        return;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (slave->al_status_mapped && slave->station_address > size) {
+            size = slave->station_address;
+        }
+    }
+
+    if (!size || ec_datagram_lrd(datagram, EC_AL_STATUS_LOGICAL_BASE, size)) {
+        return;
+    }
+
+    ec_datagram_zero(datagram);
+    datagram->device_index = EC_DEVICE_MAIN;
+    fsm->al_queue = 1;
+    fsm->al_pending = 1;
 }
 
-/******************************************************************************
- * Master state machine
- *****************************************************************************/
+/*****************************************************************************/
 
-/** Master state: START.
+/** Evaluates the AL status area.
  *
- * Starts with getting slave count and slave states.
+ * \return First mapped slave whose AL state changed, or NULL.
  */
-void ec_fsm_master_state_start(
+static ec_slave_t *ec_fsm_master_check_al_status(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram = &fsm->al_datagram;
+    ec_slave_t *slave;
 
-    fsm->idle = 1;
+    if (!fsm->al_pending) {
+        return NULL;
+    }
+    fsm->al_pending = 0;
 
-    // check for emergency requests
-    if (!list_empty(&master->emerg_reg_requests)) {
-        ec_reg_request_t *request;
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        return NULL;
+    }
 
-        // get first request
-        request = list_entry(master->emerg_reg_requests.next,
-                ec_reg_request_t, list);
-        list_del_init(&request->list); // dequeue
-        request->state = EC_INT_REQUEST_BUSY;
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (slave->al_status_mapped
+                && slave->station_address <= datagram->data_size
+                && EC_READ_U8(datagram->data + slave->station_address - 1)
+                != slave->current_state) {
+            return slave;
+        }
+    }
 
-        if (request->transfer_size > fsm->datagram->mem_size) {
-            EC_MASTER_ERR(master, "Emergency request data too large!\n");
-            request->state = EC_INT_REQUEST_FAILURE;
-            wake_up_all(&master->request_queue);
-            fsm->state(fsm); // continue
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Reads the AL states of the next slaves ahead of the state check.
+ *
+ * The states of up to EC_FSM_MASTER_STATE_DATAGRAMS slaves beginning with
+ * \a first are read with separate datagrams in the same frame as the master
+ * FSM datagram, so that the state check can evaluate them without spending
+ * a cycle per slave.
+ */
+static void ec_fsm_master_read_ahead_states(
+        ec_fsm_master_t *fsm, /**< Master state machine. */
+        unsigned int first /**< Index of the first slave to read. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    unsigned int i;
+
+    fsm->state_count = 0;
+    fsm->state_mask = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_STATE_DATAGRAMS; i++) {
+        if (fsm->state_datagrams[i].state == EC_DATAGRAM_QUEUED
+                || fsm->state_datagrams[i].state == EC_DATAGRAM_SENT) {
             return;
         }
+    }
 
-        if (request->dir != EC_DIR_OUTPUT) {
-            EC_MASTER_ERR(master, "Emergency requests must be"
-                    " write requests!\n");
-            request->state = EC_INT_REQUEST_FAILURE;
-            wake_up_all(&master->request_queue);
-            fsm->state(fsm); // continue
-            return;
+    for (i = 0; i < EC_FSM_MASTER_STATE_DATAGRAMS
+            && first + i < master->slave_count; i++) {
+        const ec_slave_t *slave = master->slaves + first + i;
+        ec_datagram_t *datagram = &fsm->state_datagrams[i];
+
+        if (ec_datagram_fprd(datagram, slave->station_address, 0x0130, 2)) {
+            break;
         }
+        ec_datagram_zero(datagram);
+        datagram->device_index = slave->device_index;
+        fsm->state_stations[i] = slave->station_address;
+        fsm->state_mask |= 1U << i;
+    }
 
-        EC_MASTER_DBG(master, 1, "Writing emergency register request...\n");
-        ec_datagram_apwr(fsm->datagram, request->ring_position,
-                request->address, request->transfer_size);
-        memcpy(fsm->datagram->data, request->data, request->transfer_size);
-        fsm->datagram->device_index = EC_DEVICE_MAIN;
-        request->state = EC_INT_REQUEST_SUCCESS;
-        wake_up_all(&master->request_queue);
-        return;
+    fsm->state_first = first;
+    fsm->state_count = i;
+}
+
+/*****************************************************************************/
+
+/** Looks up the read-ahead AL state of a slave.
+ *
+ * \return Received state datagram of the slave, or NULL.
+ */
+static ec_datagram_t *ec_fsm_master_read_ahead_state(
+        ec_fsm_master_t *fsm, /**< Master state machine. */
+        const ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    unsigned int index = slave - fsm->master->slaves;
+    ec_datagram_t *datagram;
+
+    if (index < fsm->state_first
+            || index >= fsm->state_first + fsm->state_count) {
+        return NULL;
     }
 
-    ec_datagram_brd(fsm->datagram, 0x0130, 2);
-    ec_datagram_zero(fsm->datagram);
-    fsm->datagram->device_index = fsm->dev_idx;
-    fsm->state = ec_fsm_master_state_broadcast;
+    index -= fsm->state_first;
+    datagram = &fsm->state_datagrams[index];
+    if (datagram->state != EC_DATAGRAM_RECEIVED
+            || fsm->state_stations[index] != slave->station_address) {
+        return NULL;
+    }
+
+    return datagram;
 }
 
 /*****************************************************************************/
 
-/** Master state: BROADCAST.
+/** Reads the mailbox status area.
  *
- * Processes the broadcast read slave count and slaves states.
+ * Evaluates the last read of the area and prepares the next one. The read
+ * is only used, if all slaves that have their mailbox status mapped
+ * answered.
  */
-void ec_fsm_master_state_broadcast(
+static void ec_fsm_master_read_mbox_status(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    ec_datagram_t *datagram = fsm->datagram;
-    unsigned int i, size;
-    ec_slave_t *slave;
     ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram = &fsm->mbox_datagram;
+    const ec_slave_t *slave;
+    unsigned int count = 0;
+    size_t size = 0;
 
-    // bus topology change?
-    if (datagram->working_counter != fsm->slaves_responding[fsm->dev_idx]) {
-        fsm->rescan_required = 1;
-        fsm->slaves_responding[fsm->dev_idx] = datagram->working_counter;
-        EC_MASTER_INFO(master, "%u slave(s) responding on %s device.\n",
-                fsm->slaves_responding[fsm->dev_idx],
-                ec_device_names[fsm->dev_idx != 0]);
+    if (datagram->state == EC_DATAGRAM_QUEUED
+            || datagram->state == EC_DATAGRAM_SENT) {
+        return;
     }
 
-    if (fsm->link_state[fsm->dev_idx] &&
-            !master->devices[fsm->dev_idx].link_state) {
-        ec_device_index_t dev_idx;
-
-        EC_MASTER_DBG(master, 1, "Master state machine detected "
-                "link down on %s device. Clearing slave list.\n",
-                ec_device_names[fsm->dev_idx != 0]);
-
+    if (fsm->mbox_pending) {
+        fsm->mbox_pending = 0;
+        if (datagram->state == EC_DATAGRAM_RECEIVED
+                && datagram->working_counter == fsm->mbox_slaves) {
+            memcpy(fsm->mbox_status, datagram->data, datagram->data_size);
+            fsm->mbox_size = datagram->data_size;
+            fsm->mbox_valid_seq = fsm->mbox_seq;
 #ifdef EC_EOE
-        ec_master_eoe_stop(master);
-        ec_master_clear_eoe_handlers(master);
+            ec_master_eoe_mbox_ready(master);
 #endif
-        ec_master_clear_slaves(master);
-
-        for (dev_idx = EC_DEVICE_MAIN;
-                dev_idx < ec_master_num_devices(master); dev_idx++) {
-            fsm->slave_states[dev_idx] = 0x00;
-            fsm->slaves_responding[dev_idx] = 0; /* Reset to trigger rescan on
-                                                    next link up. */
         }
     }
-    fsm->link_state[fsm->dev_idx] = master->devices[fsm->dev_idx].link_state;
 
-    if (datagram->state == EC_DATAGRAM_RECEIVED &&
-            fsm->slaves_responding[fsm->dev_idx]) {
-        uint8_t states = EC_READ_U8(datagram->data);
-        if (states != fsm->slave_states[fsm->dev_idx]) {
-            // slave states changed
-            char state_str[EC_STATE_STRING_SIZE];
-            fsm->slave_states[fsm->dev_idx] = states;
-            ec_state_string(states, state_str, 1);
-            EC_MASTER_INFO(master, "Slave states on %s device: %s.\n",
-                    ec_device_names[fsm->dev_idx != 0], state_str);
+    if (!ec_mbox_status_fmmu) {
+        return;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (slave->mbox_status_mapped) {
+            count++;
+            if (slave->station_address > size) {
+                size = slave->station_address;
+            }
         }
-    } else {
-        fsm->slave_states[fsm->dev_idx] = 0x00;
     }
 
-    fsm->dev_idx++;
-    if (fsm->dev_idx < ec_master_num_devices(master)) {
-        // check number of responding slaves on next device
-        fsm->state = ec_fsm_master_state_start;
-        fsm->state(fsm); // execute immediately
+    if (!size
+            || ec_datagram_lrd(datagram, EC_MBOX_STATUS_LOGICAL_BASE, size)) {
         return;
     }
 
-    if (fsm->rescan_required) {
-        down(&master->scan_sem);
-        if (!master->allow_scan) {
-            up(&master->scan_sem);
-        } else {
-            unsigned int count = 0, next_dev_slave, ring_position;
-            ec_device_index_t dev_idx;
+    ec_datagram_zero(datagram);
+    datagram->device_index = EC_DEVICE_MAIN;
+    fsm->mbox_slaves = count;
+    fsm->mbox_seq++;
+    fsm->mbox_queue = 1;
+    fsm->mbox_pending = 1;
+}
 
-            master->scan_busy = 1;
-            up(&master->scan_sem);
+/*****************************************************************************/
 
-            // clear all slaves and scan the bus
-            fsm->rescan_required = 0;
-            fsm->idle = 0;
-            fsm->scan_jiffies = jiffies;
+/** Stashes the responses read by a mailbox data datagram.
+ *
+ * The master zeroes the datagram, and slaves with an empty send mailbox do
+ * not answer, so every window with a non-zero mailbox header contains a
+ * response.
+ */
+static void ec_fsm_master_stash_mbox_data(
+        ec_fsm_master_t *fsm, /**< Master state machine. */
+        const ec_datagram_t *datagram, /**< Mailbox data datagram. */
+        unsigned int first /**< Ring position of the first slave read. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave;
+    u32 start = EC_READ_U32(datagram->address) - EC_MBOX_DATA_LOGICAL_BASE;
 
-#ifdef EC_EOE
-            ec_master_eoe_stop(master);
-            ec_master_clear_eoe_handlers(master);
-#endif
-            ec_master_clear_slaves(master);
+    for (slave = master->slaves + first;
+            slave < master->slaves + master->slave_count; slave++) {
+        const uint8_t *window;
 
-            for (dev_idx = EC_DEVICE_MAIN;
-                    dev_idx < ec_master_num_devices(master); dev_idx++) {
-                count += fsm->slaves_responding[dev_idx];
-            }
+        if (!slave->mbox_data_mapped) {
+            continue;
+        }
+        if (slave->mbox_data_offset + slave->configured_tx_mailbox_size
+                > start + datagram->data_size) {
+            break;
+        }
 
-            if (!count) {
-                // no slaves present -> finish state machine.
-                master->scan_busy = 0;
-                wake_up_interruptible(&master->scan_queue);
-                ec_fsm_master_restart(fsm);
+        window = datagram->data + slave->mbox_data_offset - start;
+        if (slave->mbox_stash_valid
+                || (!EC_READ_U16(window) && !EC_READ_U8(window + 5))) {
+            continue;
+        }
+
+        memcpy(slave->mbox_stash, window, slave->mbox_stash_size);
+        slave->mbox_stash_valid = 1;
+    }
+}
+
+/*****************************************************************************/
+
+/** Prepares a datagram reading the mailbox data area from the send mailbox
+ * of one slave to the one of another.
+ *
+ * \return Non-zero, if all datagrams are in use.
+ */
+static int ec_fsm_master_prepare_mbox_data(
+        ec_fsm_master_t *fsm, /**< Master state machine. */
+        const ec_slave_t *first, /**< First slave to read. */
+        const ec_slave_t *last /**< Last slave to read. */
+        )
+{
+    ec_datagram_t *datagram =
+        &fsm->mbox_data_datagrams[fsm->mbox_data_count];
+
+    if (ec_datagram_lrd(datagram,
+                EC_MBOX_DATA_LOGICAL_BASE + first->mbox_data_offset,
+                last->mbox_data_offset + last->configured_tx_mailbox_size
+                - first->mbox_data_offset)) {
+        return 0;
+    }
+
+    ec_datagram_zero(datagram);
+    datagram->device_index = EC_DEVICE_MAIN;
+    fsm->mbox_data_first[fsm->mbox_data_count] =
+        first - fsm->master->slaves;
+    fsm->mbox_data_mask |= 1U << fsm->mbox_data_count;
+    fsm->mbox_data_count++;
+
+    return fsm->mbox_data_count == EC_FSM_MASTER_MBOX_DATAGRAMS;
+}
+
+/*****************************************************************************/
+
+/** Reads the send mailboxes of many slaves at once.
+ *
+ * Evaluates the last reads of the mailbox data area and prepares the next
+ * ones. For every slave, whose send mailbox is full according to the last
+ * mailbox status area read, the mailbox is read via the area and the
+ * response is stashed until the slave FSM fetches it (see
+ * ec_slave_mbox_prepare_fetch()). Consecutive slaves are read with a single
+ * LRD datagram.
+ */
+static void ec_fsm_master_read_mbox_data(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave, *first = NULL, *last = NULL;
+    unsigned int i;
+
+    for (i = 0; i < fsm->mbox_data_count; i++) {
+        if (fsm->mbox_data_datagrams[i].state == EC_DATAGRAM_QUEUED
+                || fsm->mbox_data_datagrams[i].state == EC_DATAGRAM_SENT) {
+            return;
+        }
+    }
+
+    for (i = 0; i < fsm->mbox_data_count; i++) {
+        ec_datagram_t *datagram = &fsm->mbox_data_datagrams[i];
+
+        if (datagram->state == EC_DATAGRAM_RECEIVED
+                && datagram->working_counter
+                && fsm->mbox_data_first[i] < master->slave_count) {
+            ec_fsm_master_stash_mbox_data(fsm, datagram,
+                    fsm->mbox_data_first[i]);
+        }
+    }
+
+#ifdef EC_EOE
+    if (fsm->mbox_data_count) {
+        ec_master_eoe_mbox_ready(master);
+    }
+#endif
+    fsm->mbox_data_count = 0;
+
+    if (!ec_mbox_data_fmmu || fsm->mbox_valid_seq == fsm->mbox_data_seq) {
+        return; // no new mailbox states
+    }
+    fsm->mbox_data_seq = fsm->mbox_valid_seq;
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (!slave->mbox_data_mapped) {
+            continue; // not mapped, so reading its window is harmless
+        }
+
+        if (!slave->mbox_data_active || slave->mbox_stash_valid
+                || slave->station_address > fsm->mbox_size) {
+            // must not be read, close the current datagram
+            if (first && ec_fsm_master_prepare_mbox_data(fsm, first, last)) {
                 return;
             }
+            first = NULL;
+            continue;
+        }
 
-            size = sizeof(ec_slave_t) * count;
-            if (!(master->slaves =
-                        (ec_slave_t *) kmalloc(size, GFP_KERNEL))) {
-                EC_MASTER_ERR(master, "Failed to allocate %u bytes"
-                        " of slave memory!\n", size);
-                master->scan_busy = 0;
-                wake_up_interruptible(&master->scan_queue);
-                ec_fsm_master_restart(fsm);
+        if (!(fsm->mbox_status[slave->station_address - 1] & 0x08)) {
+            continue; // empty, but may be read
+        }
+
+        if (first && slave->mbox_data_offset
+                + slave->configured_tx_mailbox_size
+                - first->mbox_data_offset > EC_MAX_DATA_SIZE) {
+            if (ec_fsm_master_prepare_mbox_data(fsm, first, last)) {
                 return;
             }
+            first = NULL;
+        }
 
-            // init slaves
-            dev_idx = EC_DEVICE_MAIN;
-            next_dev_slave = fsm->slaves_responding[dev_idx];
-            ring_position = 0;
-            for (i = 0; i < count; i++, ring_position++) {
-                slave = master->slaves + i;
-                while (i >= next_dev_slave) {
-                    dev_idx++;
-                    next_dev_slave += fsm->slaves_responding[dev_idx];
-                    ring_position = 0;
-                }
+        if (!first) {
+            first = slave;
+        }
+        last = slave;
+    }
 
-                ec_slave_init(slave, master, dev_idx, ring_position, i + 1);
+    if (first) {
+        ec_fsm_master_prepare_mbox_data(fsm, first, last);
+    }
+}
 
-                // do not force reconfiguration in operation phase to avoid
-                // unnecesssary process data interruptions
-                if (master->phase != EC_OPERATION) {
-                    slave->force_config = 1;
-                }
-            }
-            master->slave_count = count;
-            master->fsm_slave = master->slaves;
+/*****************************************************************************/
 
-            /* start with first device with slaves responding; at least one
-             * has responding slaves, otherwise count would be zero. */
-            fsm->dev_idx = EC_DEVICE_MAIN;
-            while (!fsm->slaves_responding[fsm->dev_idx]) {
-                fsm->dev_idx++;
-            }
+/** Starts a sample of the slaves' error counters, if it is due.
+ *
+ * \return Non-zero, if the error counter batch was started.
+ */
+static int ec_fsm_master_start_error_monitor(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_reg_batch_t *batch = &fsm->error_batch;
+    unsigned int i;
 
-            ec_fsm_master_enter_clear_addresses(fsm);
-            return;
-        }
+    if (!ec_error_monitor_interval || !master->slave_count
+            || master->scan_busy
+            || time_before(jiffies, fsm->error_jiffies
+                + msecs_to_jiffies(ec_error_monitor_interval))) {
+        return 0;
     }
 
-    if (master->slave_count) {
+    fsm->error_jiffies = jiffies;
 
-        // application applied configurations
-        if (master->config_changed) {
-            master->config_changed = 0;
+    if (ec_reg_batch_init(batch, master->slave_count,
+                EC_ERROR_COUNTERS_SIZE)) {
+        return 0;
+    }
 
-            EC_MASTER_DBG(master, 1, "Configuration changed.\n");
+    for (i = 0; i < master->slave_count; i++) {
+        batch->positions[i] = i;
+    }
+    batch->dir = EC_DIR_INPUT;
+    batch->address = EC_ERROR_COUNTERS_ADDRESS;
+    batch->traffic_class = EC_TC_DIAGNOSIS;
+    batch->state = EC_INT_REQUEST_BUSY;
+    fsm->reg_batch = batch;
+    return 1;
+}
 
-            fsm->slave = master->slaves; // begin with first slave
-            ec_fsm_master_enter_write_system_times(fsm);
+/*****************************************************************************/
 
-        } else {
-            // fetch state from first slave
-            fsm->slave = master->slaves;
-            ec_datagram_fprd(fsm->datagram, fsm->slave->station_address,
-                    0x0130, 2);
-            ec_datagram_zero(datagram);
-            fsm->datagram->device_index = fsm->slave->device_index;
-            fsm->retries = EC_FSM_RETRIES;
-            fsm->state = ec_fsm_master_state_read_state;
+/** Evaluates a finished sample of the slaves' error counters.
+ */
+static void ec_fsm_master_eval_error_monitor(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_reg_batch_t *batch = &fsm->error_batch;
+    unsigned int i, port;
+
+    for (i = 0; i < batch->count; i++) {
+        uint16_t position = batch->positions[i];
+        ec_slave_t *slave;
+
+        if (batch->working_counters[i] != 1
+                || position >= master->slave_count) {
+            continue;
+        }
+
+        slave = master->slaves + position;
+        ec_slave_update_error_counters(slave,
+                batch->data + i * batch->transfer_size);
+
+        for (port = 0; port < EC_MAX_PORTS; port++) {
+            if (slave->ports[port].errors.delta) {
+                // errors increased: monitor the bus closely again
+                fsm->monitor_interval = 0;
+            }
         }
-    } else {
-        ec_fsm_master_restart(fsm);
     }
+
+    ec_reg_batch_clear(batch);
 }
 
 /*****************************************************************************/
 
-/** Check for pending SII write requests and process one.
+/** Starts a sample of the slaves' DC system time differences, if it is due.
  *
- * \return non-zero, if an SII write request is processed.
+ * Only slaves with a DC system time register are read.
+ *
+ * \return Non-zero, if the time difference batch was started.
  */
-int ec_fsm_master_action_process_sii(
+static int ec_fsm_master_start_dc_monitor(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
-    ec_sii_write_request_t *request;
+    ec_reg_batch_t *batch = &fsm->dc_mon_batch;
+    unsigned int i, count = 0;
 
-    // search the first request to be processed
-    while (1) {
-        if (list_empty(&master->sii_requests))
-            break;
+    if (!ec_dc_monitor_interval || !master->slave_count
+            || master->scan_busy
+            || time_before(jiffies, fsm->dc_mon_jiffies
+                + msecs_to_jiffies(ec_dc_monitor_interval))) {
+        return 0;
+    }
 
-        // get first request
-        request = list_entry(master->sii_requests.next,
-                ec_sii_write_request_t, list);
-        list_del_init(&request->list); // dequeue
-        request->state = EC_INT_REQUEST_BUSY;
+    fsm->dc_mon_jiffies = jiffies;
 
-        // found pending SII write operation. execute it!
-        EC_SLAVE_DBG(request->slave, 1, "Writing SII data...\n");
-        fsm->sii_request = request;
-        fsm->sii_index = 0;
-        ec_fsm_sii_write(&fsm->fsm_sii, request->slave, request->offset,
-                request->words, EC_FSM_SII_USE_CONFIGURED_ADDRESS);
-        fsm->state = ec_fsm_master_state_write_sii;
-        fsm->state(fsm); // execute immediately
-        return 1;
+    for (i = 0; i < master->slave_count; i++) {
+        if (master->slaves[i].has_dc_system_time) {
+            count++;
+        }
     }
 
-    return 0;
+    if (ec_reg_batch_init(batch, count, 4)) {
+        return 0;
+    }
+
+    count = 0;
+    for (i = 0; i < master->slave_count; i++) {
+        if (master->slaves[i].has_dc_system_time) {
+            batch->positions[count++] = i;
+        }
+    }
+    batch->dir = EC_DIR_INPUT;
+    batch->address = EC_DC_TIME_DIFF_ADDRESS;
+    batch->traffic_class = EC_TC_DIAGNOSIS;
+    batch->state = EC_INT_REQUEST_BUSY;
+    fsm->reg_batch = batch;
+    return 1;
 }
 
 /*****************************************************************************/
 
-/** Check for pending SDO requests and process one.
- *
- * \return non-zero, if an SDO request is processed.
+/** Evaluates a finished sample of the slaves' DC system time differences.
  */
-int ec_fsm_master_action_process_sdo(
+static void ec_fsm_master_eval_dc_monitor(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
-    ec_slave_t *slave;
-    ec_sdo_request_t *req;
+    ec_reg_batch_t *batch = &fsm->dc_mon_batch;
+    unsigned int i;
 
-    // search for internal requests to be processed
-    for (slave = master->slaves;
-            slave < master->slaves + master->slave_count;
-            slave++) {
+    for (i = 0; i < batch->count; i++) {
+        uint16_t position = batch->positions[i];
 
-        if (!slave->config) {
-            continue;
+        if (batch->working_counters[i] == 1
+                && position < master->slave_count) {
+            ec_slave_update_dc_time_diff(master->slaves + position,
+                    EC_READ_U32(batch->data + i * batch->transfer_size));
         }
+    }
 
-        list_for_each_entry(req, &slave->config->sdo_requests, list) {
-            if (req->state == EC_INT_REQUEST_QUEUED) {
+    ec_reg_batch_clear(batch);
+}
 
-                if (ec_sdo_request_timed_out(req)) {
-                    req->state = EC_INT_REQUEST_FAILURE;
-                    EC_SLAVE_DBG(slave, 1, "Internal SDO request"
-                            " timed out.\n");
-                    continue;
-                }
+/*****************************************************************************/
 
-                if (slave->current_state == EC_SLAVE_STATE_INIT) {
-                    req->state = EC_INT_REQUEST_FAILURE;
-                    continue;
-                }
+/** Checks, if a slave exchanges process data with a domain.
+ *
+ * \return Non-zero, if one of the slave's FMMUs maps into the domain.
+ */
+static int ec_fsm_master_slave_in_domain(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        const ec_domain_t *domain /**< EtherCAT domain. */
+        )
+{
+    unsigned int i;
 
-                req->state = EC_INT_REQUEST_BUSY;
-                EC_SLAVE_DBG(slave, 1, "Processing internal"
-                        " SDO request...\n");
-                fsm->idle = 0;
-                fsm->sdo_request = req;
-                fsm->slave = slave;
-                fsm->state = ec_fsm_master_state_sdo_request;
-                ec_fsm_coe_transfer(&fsm->fsm_coe, slave, req);
-                ec_fsm_coe_exec(&fsm->fsm_coe, fsm->datagram);
-                return 1;
-            }
+    if (!slave->config) {
+        return 0;
+    }
+
+    for (i = 0; i < slave->config->used_fmmus; i++) {
+        if (slave->config->fmmu_configs[i].domain == domain) {
+            return 1;
         }
     }
+
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Master action: IDLE.
+/** Starts reading the AL states of a domain's slaves, if the working counter
+ * of the domain dropped.
  *
- * Does secondary work.
+ * The probe is started before any other register batch, so that the faulty
+ * slaves are known a few cycles after the drop.
+ *
+ * \return Non-zero, if the probe batch was started.
  */
-void ec_fsm_master_action_idle(
+static int ec_fsm_master_start_wc_probe(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
-    ec_slave_t *slave;
+    ec_reg_batch_t *batch = &fsm->wc_probe_batch;
+    ec_domain_t *domain, *dropped = NULL;
+    unsigned int i, count = 0, drops;
 
-    // Check for pending internal SDO requests
-    if (ec_fsm_master_action_process_sdo(fsm)) {
-        return;
+    if (!master->slave_count || master->scan_busy) {
+        return 0;
     }
 
-    // enable processing of requests
-    for (slave = master->slaves;
-            slave < master->slaves + master->slave_count;
-            slave++) {
-        ec_fsm_slave_set_ready(&slave->fsm);
+    list_for_each_entry(domain, &master->domains, list) {
+        drops = READ_ONCE(domain->wc_drops);
+        if (drops != domain->wc_probed_drops) {
+            domain->wc_probed_drops = drops;
+            dropped = domain;
+            break;
+        }
+    }
+    if (!dropped) {
+        return 0;
     }
+    domain = dropped;
 
-    // check, if slaves have an SDO dictionary to read out.
-    for (slave = master->slaves;
-            slave < master->slaves + master->slave_count;
-            slave++) {
-        if (!(slave->sii.mailbox_protocols & EC_MBOX_COE)
-                || (slave->sii.has_general
-                    && !slave->sii.coe_details.enable_sdo_info)
-                || slave->sdo_dictionary_fetched
-                || slave->current_state == EC_SLAVE_STATE_INIT
-                || slave->current_state == EC_SLAVE_STATE_UNKNOWN
-                || jiffies - slave->jiffies_preop < EC_WAIT_SDO_DICT * HZ
-                ) continue;
-
-        EC_SLAVE_DBG(slave, 1, "Fetching SDO dictionary.\n");
-
-        slave->sdo_dictionary_fetched = 1;
-
-        // start fetching SDO dictionary
-        fsm->idle = 0;
-        fsm->slave = slave;
-        fsm->state = ec_fsm_master_state_sdo_dictionary;
-        ec_fsm_coe_dictionary(&fsm->fsm_coe, slave);
-        ec_fsm_coe_exec(&fsm->fsm_coe, fsm->datagram); // execute immediately
-        fsm->datagram->device_index = fsm->slave->device_index;
-        return;
+    for (i = 0; i < master->slave_count; i++) {
+        if (ec_fsm_master_slave_in_domain(master->slaves + i, domain)) {
+            count++;
+        }
+    }
+
+    if (ec_reg_batch_init(batch, count, 2)) {
+        return 0;
+    }
+
+    count = 0;
+    for (i = 0; i < master->slave_count; i++) {
+        if (ec_fsm_master_slave_in_domain(master->slaves + i, domain)) {
+            batch->positions[count++] = i;
+        }
     }
+    batch->dir = EC_DIR_INPUT;
+    batch->address = 0x0130; // AL status
+    batch->traffic_class = EC_TC_DIAGNOSIS;
+    batch->state = EC_INT_REQUEST_BUSY;
+    fsm->reg_batch = batch;
+    fsm->wc_probe_domain = domain->index;
+    fsm->monitor_interval = 0; // monitor the bus closely again
+
+    EC_MASTER_DBG(master, 1, "Domain %u: Working counter dropped."
+            " Probing %u slaves.\n", domain->index, count);
+    return 1;
+}
 
-    // check for pending SII write operations.
-    if (ec_fsm_master_action_process_sii(fsm)) {
-        return; // SII write request found
-	}
+/*****************************************************************************/
 
-    ec_fsm_master_restart(fsm);
+/** Evaluates the AL states read after a working counter drop.
+ *
+ * A slave is faulty, if it did not answer, if it is not in its requested
+ * state or if its error flag is set.
+ */
+static void ec_fsm_master_eval_wc_probe(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_reg_batch_t *batch = &fsm->wc_probe_batch;
+    uint16_t positions[EC_MAX_WC_FAULT_SLAVES];
+    ec_domain_t *domain;
+    unsigned int i, count = 0;
+
+    for (i = 0; i < batch->count; i++) {
+        uint16_t position = batch->positions[i];
+        uint8_t al_state;
+
+        if (position >= master->slave_count) {
+            continue;
+        }
+
+        al_state = EC_READ_U8(batch->data + i * batch->transfer_size);
+        if (batch->working_counters[i] == 1
+                && !(al_state & EC_SLAVE_STATE_ACK_ERR)
+                && (al_state & EC_SLAVE_STATE_MASK)
+                == master->slaves[position].requested_state) {
+            continue;
+        }
+
+        if (count < EC_MAX_WC_FAULT_SLAVES) {
+            positions[count] = position;
+        }
+        count++;
+    }
+
+    domain = ec_master_find_domain(master, fsm->wc_probe_domain);
+    if (domain) {
+        ec_domain_set_wc_faults(domain, positions, count);
+        if (count) {
+            EC_MASTER_WARN(master, "Domain %u: Working counter dropped."
+                    " %u slave(s) faulty, the first at position %u.\n",
+                    domain->index, count, positions[0]);
+        }
+    }
+
+    ec_reg_batch_clear(batch);
 }
 
 /*****************************************************************************/
 
-/** Master action: Get state of next slave.
+/** Processes the register batch requests.
+ *
+ * Evaluates the datagrams of the last part of the current batch and
+ * prepares the datagrams for the next slaves. As many datagrams are
+ * prepared, as fit into a single frame.
  */
-void ec_fsm_master_action_next_slave_state(
+static void ec_fsm_master_exec_reg_batch(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
+    ec_reg_batch_t *batch = fsm->reg_batch;
+    unsigned int i, max_count;
 
-    // is there another slave to query?
-    fsm->slave++;
-    if (fsm->slave < master->slaves + master->slave_count) {
-        // fetch state from next slave
-        fsm->idle = 1;
-        ec_datagram_fprd(fsm->datagram,
-                fsm->slave->station_address, 0x0130, 2);
-        ec_datagram_zero(fsm->datagram);
-        fsm->datagram->device_index = fsm->slave->device_index;
-        fsm->retries = EC_FSM_RETRIES;
-        fsm->state = ec_fsm_master_state_read_state;
+    fsm->reg_mask = 0;
+
+    if (batch && fsm->reg_count) {
+        for (i = 0; i < fsm->reg_count; i++) {
+            if (fsm->reg_datagrams[i].state == EC_DATAGRAM_QUEUED
+                    || fsm->reg_datagrams[i].state == EC_DATAGRAM_SENT) {
+                return; // not received yet
+            }
+        }
+
+        for (i = 0; i < fsm->reg_count; i++) {
+            ec_datagram_t *datagram = &fsm->reg_datagrams[i];
+            unsigned int index = fsm->reg_indices[i];
+
+            if (datagram->state != EC_DATAGRAM_RECEIVED) {
+                continue;
+            }
+
+            batch->working_counters[index] = datagram->working_counter;
+            if (batch->dir == EC_DIR_INPUT
+                    && datagram->working_counter == 1) {
+                memcpy(batch->data + index * batch->transfer_size,
+                        datagram->data, batch->transfer_size);
+            }
+        }
+        fsm->reg_count = 0;
+    }
+
+    if (batch && batch->index >= batch->count) {
+        if (batch == &fsm->error_batch) {
+            ec_fsm_master_eval_error_monitor(fsm);
+        } else if (batch == &fsm->dc_mon_batch) {
+            ec_fsm_master_eval_dc_monitor(fsm);
+        } else if (batch == &fsm->wc_probe_batch) {
+            ec_fsm_master_eval_wc_probe(fsm);
+        } else {
+            batch->state = EC_INT_REQUEST_SUCCESS;
+            wake_up_all(&master->request_queue);
+        }
+        fsm->reg_batch = batch = NULL;
+    }
+
+    if (!batch) {
+        if (ec_fsm_master_start_wc_probe(fsm)) {
+            batch = fsm->reg_batch;
+        } else if (!list_empty(&master->reg_batches)) {
+            batch = list_entry(master->reg_batches.next,
+                    ec_reg_batch_t, list);
+            list_del_init(&batch->list); // dequeue
+            batch->state = EC_INT_REQUEST_BUSY;
+            batch->index = 0;
+            fsm->reg_batch = batch;
+
+            EC_MASTER_DBG(master, 1, "Processing register batch request"
+                    " for %u slaves.\n", batch->count);
+        } else if (ec_fsm_master_start_error_monitor(fsm)
+                || ec_fsm_master_start_dc_monitor(fsm)) {
+            batch = fsm->reg_batch;
+        } else {
+            return;
+        }
+    }
+
+    max_count = EC_MAX_DATA_SIZE / (EC_DATAGRAM_HEADER_SIZE
+            + batch->transfer_size + EC_DATAGRAM_FOOTER_SIZE);
+    max_count = max(min(max_count, EC_FSM_MASTER_REG_DATAGRAMS), 1U);
+
+    while (fsm->reg_count < max_count && batch->index < batch->count) {
+        ec_datagram_t *datagram = &fsm->reg_datagrams[fsm->reg_count];
+        unsigned int index = batch->index++;
+        uint16_t position = batch->positions[index];
+        const ec_slave_t *slave;
+        int ret;
+
+        batch->working_counters[index] = 0;
+
+        if (position >= master->slave_count) {
+            continue; // slave does not exist (any more)
+        }
+        slave = master->slaves + position;
+
+        if (batch->dir == EC_DIR_INPUT) {
+            ret = ec_datagram_fprd(datagram, slave->station_address,
+                    batch->address, batch->transfer_size);
+            if (!ret) {
+                ec_datagram_zero(datagram);
+            }
+        } else {
+            ret = ec_datagram_fpwr(datagram, slave->station_address,
+                    batch->address, batch->transfer_size);
+            if (!ret) {
+                memcpy(datagram->data,
+                        batch->data + index * batch->transfer_size,
+                        batch->transfer_size);
+            }
+        }
+        if (ret) {
+            continue;
+        }
+
+        datagram->device_index = slave->device_index;
+        datagram->traffic_class = batch->traffic_class;
+        fsm->reg_indices[fsm->reg_count] = index;
+        fsm->reg_mask |= 1U << fsm->reg_count;
+        fsm->reg_count++;
+    }
+}
+
+/*****************************************************************************/
+
+/** Executes the busy slave configuration units.
+ *
+ * The datagrams of the units that were executed are marked in the config
+ * mask, so that they are queued with the master FSM datagram.
+ */
+static void ec_fsm_master_exec_configs(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    unsigned int i, finished = 0;
+
+    fsm->config_mask = 0;
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        ec_fsm_master_config_t *config = &fsm->configs[i];
+
+        if (!config->slave || config->datagram.state == EC_DATAGRAM_QUEUED
+                || config->datagram.state == EC_DATAGRAM_SENT) {
+            continue;
+        }
+
+        if (ec_fsm_slave_config_exec(&config->fsm_slave_config)) {
+            config->datagram.device_index = config->slave->device_index;
+            fsm->config_mask |= 1 << i;
+            continue;
+        }
+
+        config->slave->force_config = 0;
+
+        if (!ec_fsm_slave_config_success(&config->fsm_slave_config)) {
+            // TODO: mark slave_config as failed.
+        } else {
+            config->slave->mbox_data_active =
+                config->slave->mbox_data_mapped;
+        }
+
+        config->slave = NULL;
+        finished = 1;
+    }
+
+    if (finished) {
+        // read-ahead states may predate the configuration
+        fsm->state_count = 0;
+    }
+
+    if (finished && !ec_fsm_master_configs_busy(fsm)) {
+        // configuration finished
+        master->config_busy = 0;
+        wake_up_interruptible(&master->config_queue);
+    }
+}
+
+/*****************************************************************************/
+
+/** Checks, if the bus is stable.
+ *
+ * The bus is stable in operation phase, if all links are up, no rescan or
+ * reconfiguration is pending and all slaves are in OP without errors.
+ *
+ * \return Non-zero, if the bus is stable.
+ */
+static int ec_fsm_master_bus_stable(
+        const ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_device_index_t dev_idx;
+    const ec_slave_t *slave;
+
+    if (!ec_monitor_interval || master->phase != EC_OPERATION
+            || fsm->rescan_required || master->config_changed
+            || !master->slave_count) {
+        return 0;
+    }
+
+    for (dev_idx = EC_DEVICE_MAIN;
+            dev_idx < ec_master_num_devices(master); dev_idx++) {
+        if (!master->devices[dev_idx].link_state
+                || (fsm->slaves_responding[dev_idx]
+                    && fsm->slave_states[dev_idx] != EC_SLAVE_STATE_OP)) {
+            return 0;
+        }
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (slave->error_flag
+                || slave->current_state != EC_SLAVE_STATE_OP) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Checks, if the next bus monitoring round shall be deferred.
+ *
+ * A link change or a configuration change ends the deferral immediately and
+ * switches back to monitoring in every cycle.
+ *
+ * \return Non-zero, if the monitoring round is not due yet.
+ */
+static int ec_fsm_master_monitor_deferred(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_device_index_t dev_idx;
+
+    if (!fsm->monitor_interval) {
+        return 0;
+    }
+
+    if (master->phase != EC_OPERATION || master->config_changed) {
+        fsm->monitor_interval = 0;
+        return 0;
+    }
+
+    for (dev_idx = EC_DEVICE_MAIN;
+            dev_idx < ec_master_num_devices(master); dev_idx++) {
+        if (fsm->link_state[dev_idx]
+                != master->devices[dev_idx].link_state) {
+            fsm->monitor_interval = 0;
+            return 0;
+        }
+    }
+
+    return time_before(jiffies, fsm->monitor_jiffies
+            + msecs_to_jiffies(fsm->monitor_interval));
+}
+
+/*****************************************************************************/
+
+/** Executes the current state of the state machine.
+ *
+ * If the state machine's datagram is not sent or received yet, the execution
+ * of the state machine is delayed to the next cycle.
+ *
+ * \return true, if the state machine was executed
+ */
+int ec_fsm_master_exec(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    void (*state)(ec_fsm_master_t *);
+
+    if (fsm->datagram->state == EC_DATAGRAM_SENT
+        || fsm->datagram->state == EC_DATAGRAM_QUEUED) {
+        // datagram was not sent or received yet.
+        return 0;
+    }
+
+    ec_fsm_master_read_mbox_status(fsm);
+    ec_fsm_master_read_mbox_data(fsm);
+    ec_fsm_master_exec_reg_batch(fsm);
+    ec_fsm_master_exec_configs(fsm);
+    fsm->state_inline = 0;
+    state = fsm->state;
+    fsm->state(fsm);
+    if (fsm->state != state) {
+        trace_ec_fsm_state(fsm->master->index, -1, (const void *) state,
+                (const void *) fsm->state);
+    }
+    return 1;
+}
+
+/*****************************************************************************/
+
+/**
+ * \return true, if the state machine is in an idle phase
+ */
+int ec_fsm_master_idle(
+        const ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    return fsm->idle && !ec_fsm_master_configs_busy(fsm);
+}
+
+/*****************************************************************************/
+
+/** Restarts the master state machine.
+ */
+void ec_fsm_master_restart(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    fsm->dev_idx = EC_DEVICE_MAIN;
+    fsm->state = ec_fsm_master_state_start;
+    fsm->state(fsm); // execute immediately
+}
+
+/******************************************************************************
+ * Master state machine
+ *****************************************************************************/
+
+/** Master state: START.
+ *
+ * Starts with getting slave count and slave states.
+ */
+void ec_fsm_master_state_start(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+
+    fsm->idle = 1;
+    fsm->monitor_hold = 0;
+
+    // check for emergency requests
+    if (!list_empty(&master->emerg_reg_requests)) {
+        ec_reg_request_t *request;
+
+        // get first request
+        request = list_entry(master->emerg_reg_requests.next,
+                ec_reg_request_t, list);
+        list_del_init(&request->list); // dequeue
+        request->state = EC_INT_REQUEST_BUSY;
+
+        if (request->transfer_size > fsm->datagram->mem_size) {
+            EC_MASTER_ERR(master, "Emergency request data too large!\n");
+            request->state = EC_INT_REQUEST_FAILURE;
+            wake_up_all(&master->request_queue);
+            fsm->state(fsm); // continue
+            return;
+        }
+
+        if (request->dir != EC_DIR_OUTPUT) {
+            EC_MASTER_ERR(master, "Emergency requests must be"
+                    " write requests!\n");
+            request->state = EC_INT_REQUEST_FAILURE;
+            wake_up_all(&master->request_queue);
+            fsm->state(fsm); // continue
+            return;
+        }
+
+        EC_MASTER_DBG(master, 1, "Writing emergency register request...\n");
+        ec_datagram_apwr(fsm->datagram, request->ring_position,
+                request->address, request->transfer_size);
+        memcpy(fsm->datagram->data, request->data, request->transfer_size);
+        fsm->datagram->device_index = EC_DEVICE_MAIN;
+        request->state = EC_INT_REQUEST_SUCCESS;
+        wake_up_all(&master->request_queue);
+        return;
+    }
+
+    if (ec_fsm_master_configs_busy(fsm)) {
+        /* Slave configurations are still running (the state check was
+         * aborted). Let them finish before touching the slave list. */
+        fsm->slave = master->slaves + master->slave_count;
+        ec_fsm_master_enter_wait_configs(fsm);
+        return;
+    }
+
+    if (fsm->dev_idx == EC_DEVICE_MAIN) {
+        if (ec_fsm_master_monitor_deferred(fsm)) {
+            /* The bus is stable. Leave the master FSM datagram unqueued
+             * until the next monitoring round is due. */
+            fsm->monitor_hold = 1;
+            return;
+        }
+
+        fsm->monitor_jiffies = jiffies;
+        ec_fsm_master_read_al_status(fsm);
+        ec_fsm_master_read_ahead_states(fsm, 0);
+    }
+
+    ec_datagram_brd(fsm->datagram, 0x0130, 2);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = fsm->dev_idx;
+    fsm->state = ec_fsm_master_state_broadcast;
+}
+
+/*****************************************************************************/
+
+/** Master state: BROADCAST.
+ *
+ * Processes the broadcast read slave count and slaves states.
+ */
+void ec_fsm_master_state_broadcast(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_datagram_t *datagram = fsm->datagram;
+    unsigned int i, size;
+    ec_slave_t *slave;
+    ec_master_t *master = fsm->master;
+
+    // bus topology change?
+    if (datagram->working_counter != fsm->slaves_responding[fsm->dev_idx]) {
+        fsm->rescan_required = 1;
+        fsm->slaves_responding[fsm->dev_idx] = datagram->working_counter;
+        EC_MASTER_INFO(master, "%u slave(s) responding on %s device.\n",
+                fsm->slaves_responding[fsm->dev_idx],
+                ec_device_names[fsm->dev_idx != 0]);
+    }
+
+    if (fsm->link_state[fsm->dev_idx] &&
+            !master->devices[fsm->dev_idx].link_state) {
+        ec_device_index_t dev_idx;
+
+        EC_MASTER_DBG(master, 1, "Master state machine detected "
+                "link down on %s device. Clearing slave list.\n",
+                ec_device_names[fsm->dev_idx != 0]);
+
+#ifdef EC_EOE
+        ec_master_eoe_stop(master);
+        ec_master_clear_eoe_handlers(master);
+#endif
+        ec_master_clear_slaves(master);
+
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(master); dev_idx++) {
+            fsm->slave_states[dev_idx] = 0x00;
+            fsm->slaves_responding[dev_idx] = 0; /* Reset to trigger rescan on
+                                                    next link up. */
+        }
+    }
+    fsm->link_state[fsm->dev_idx] = master->devices[fsm->dev_idx].link_state;
+
+    if (datagram->state == EC_DATAGRAM_RECEIVED &&
+            fsm->slaves_responding[fsm->dev_idx]) {
+        uint8_t states = EC_READ_U8(datagram->data);
+        if (states != fsm->slave_states[fsm->dev_idx]) {
+            // slave states changed
+            char state_str[EC_STATE_STRING_SIZE];
+            fsm->slave_states[fsm->dev_idx] = states;
+            ec_state_string(states, state_str, 1);
+            EC_MASTER_INFO(master, "Slave states on %s device: %s.\n",
+                    ec_device_names[fsm->dev_idx != 0], state_str);
+        }
+    } else {
+        fsm->slave_states[fsm->dev_idx] = 0x00;
+    }
+
+    fsm->dev_idx++;
+    if (fsm->dev_idx < ec_master_num_devices(master)) {
+        // check number of responding slaves on next device
+        fsm->state = ec_fsm_master_state_start;
+        fsm->state(fsm); // execute immediately
+        return;
+    }
+
+    if (fsm->rescan_required && ec_fsm_master_enter_verify_slaves(fsm)) {
+        return; // check, if only slaves at the end of the bus are missing
+    }
+
+    if (fsm->rescan_required) {
+        down(&master->scan_sem);
+        if (!master->allow_scan) {
+            up(&master->scan_sem);
+        } else {
+            unsigned int count = 0, next_dev_slave, ring_position;
+            ec_device_index_t dev_idx;
+
+            master->scan_busy = 1;
+            up(&master->scan_sem);
+
+            // clear all slaves and scan the bus
+            fsm->rescan_required = 0;
+            fsm->state_count = 0;
+            fsm->rescan_full = 0;
+            fsm->idle = 0;
+            fsm->scan_jiffies = jiffies;
+
+            // a bus scan, that is still running, was aborted
+            ec_startup_timer_stop(&master->startup_profile,
+                    &fsm->scan_timer, 1);
+            ec_startup_timer_start(&master->startup_profile,
+                    &fsm->scan_timer, EC_STARTUP_BUS_SCAN,
+                    EC_STARTUP_MASTER);
+
+#ifdef EC_EOE
+            ec_master_eoe_stop(master);
+            ec_master_clear_eoe_handlers(master);
+#endif
+            ec_master_clear_slaves(master);
+
+            for (dev_idx = EC_DEVICE_MAIN;
+                    dev_idx < ec_master_num_devices(master); dev_idx++) {
+                count += fsm->slaves_responding[dev_idx];
+            }
+
+            if (!count) {
+                // no slaves present -> finish state machine.
+                master->scan_busy = 0;
+                wake_up_interruptible(&master->scan_queue);
+                ec_fsm_master_restart(fsm);
+                return;
+            }
+
+            size = sizeof(ec_slave_t) * count;
+            if (!(master->slaves =
+                        (ec_slave_t *) kmalloc(size, GFP_KERNEL))) {
+                EC_MASTER_ERR(master, "Failed to allocate %u bytes"
+                        " of slave memory!\n", size);
+                master->scan_busy = 0;
+                wake_up_interruptible(&master->scan_queue);
+                ec_fsm_master_restart(fsm);
+                return;
+            }
+
+            // init slaves
+            dev_idx = EC_DEVICE_MAIN;
+            next_dev_slave = fsm->slaves_responding[dev_idx];
+            ring_position = 0;
+            for (i = 0; i < count; i++, ring_position++) {
+                slave = master->slaves + i;
+                while (i >= next_dev_slave) {
+                    dev_idx++;
+                    next_dev_slave += fsm->slaves_responding[dev_idx];
+                    ring_position = 0;
+                }
+
+                ec_slave_init(slave, master, dev_idx, ring_position, i + 1);
+
+                // do not force reconfiguration in operation phase to avoid
+                // unnecesssary process data interruptions
+                if (master->phase != EC_OPERATION) {
+                    slave->force_config = 1;
+                }
+            }
+            ec_master_publish_slaves(master, count);
+            master->fsm_slave = master->slaves;
+
+            /* start with first device with slaves responding; at least one
+             * has responding slaves, otherwise count would be zero. */
+            fsm->dev_idx = EC_DEVICE_MAIN;
+            while (!fsm->slaves_responding[fsm->dev_idx]) {
+                fsm->dev_idx++;
+            }
+
+            ec_fsm_master_enter_clear_addresses(fsm);
+            return;
+        }
+    }
+
+    if (master->slave_count) {
+
+        // application applied configurations
+        if (master->config_changed) {
+            master->config_changed = 0;
+
+            EC_MASTER_DBG(master, 1, "Configuration changed.\n");
+
+            fsm->slave = master->slaves; // begin with first slave
+            ec_fsm_master_enter_write_system_times(fsm);
+
+        } else {
+            /* fetch state from first slave, or from the first slave whose
+             * state changed according to the AL status area */
+            fsm->slave = ec_fsm_master_check_al_status(fsm);
+            if (fsm->slave) {
+                EC_SLAVE_DBG(fsm->slave, 1, "AL state changed.\n");
+            } else {
+                fsm->slave = master->slaves;
+            }
+            ec_fsm_master_enter_read_state(fsm);
+        }
+    } else {
+        ec_fsm_master_restart(fsm);
+    }
+}
+
+/*****************************************************************************/
+
+/** Master action: IDLE.
+ *
+ * Does secondary work.
+ */
+void ec_fsm_master_action_idle(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave;
+
+    // enable processing of requests
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count;
+            slave++) {
+        ec_fsm_slave_set_ready(&slave->fsm);
+    }
+
+    // adapt the monitoring rate to the bus condition
+    if (ec_fsm_master_bus_stable(fsm)) {
+        fsm->monitor_interval = min(max(fsm->monitor_interval * 2,
+                    (unsigned int) EC_MONITOR_INTERVAL_MIN),
+                ec_monitor_interval);
+    } else {
+        fsm->monitor_interval = 0;
+    }
+
+    ec_fsm_master_restart(fsm);
+}
+
+/*****************************************************************************/
+
+/** Master action: Get state of next slave.
+ */
+void ec_fsm_master_action_next_slave_state(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+
+    // is there another slave to query?
+    do {
+        fsm->slave++;
+    } while (fsm->slave < master->slaves + master->slave_count
+            && ec_fsm_master_slave_configuring(fsm, fsm->slave));
+
+    if (fsm->slave < master->slaves + master->slave_count) {
+        // fetch state from next slave
+        fsm->idle = 1;
+        ec_fsm_master_enter_read_state(fsm);
+        return;
+    }
+
+    if (ec_fsm_master_configs_busy(fsm)) {
+        // wait for the slave configurations to finish
+        ec_fsm_master_enter_wait_configs(fsm);
+        return;
+    }
+
+    if (ec_fsm_master_enter_group_op(fsm)) {
+        return;
+    }
+
+    // all slaves processed
+    ec_fsm_master_action_idle(fsm);
+}
+
+/*****************************************************************************/
+
+/** Master action: Configure.
+ */
+void ec_fsm_master_action_configure(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave = fsm->slave;
+    ec_fsm_master_config_t *config = NULL;
+    unsigned int i, busy = ec_fsm_master_configs_busy(fsm);
+
+    if (master->config_changed) {
+        if (busy) {
+            // let the running configurations finish first
+            ec_fsm_master_enter_wait_configs(fsm);
+            return;
+        }
+
+        master->config_changed = 0;
+
+        // abort iterating through slaves,
+        // first compensate DC system time offsets,
+        // then begin configuring at slave 0
+        EC_MASTER_DBG(master, 1, "Configuration changed"
+                " (aborting state check).\n");
+
+        fsm->slave = master->slaves; // begin with first slave
+        ec_fsm_master_enter_write_system_times(fsm);
+        return;
+    }
+
+    if (slave->group_op) {
+        if (!ec_fsm_master_group_op_waiting(slave)) {
+            slave->group_op = 0; // configure as usual
+        } else if (!fsm->group_op_single) {
+            // OP is requested for all waiting slaves at once
+            ec_fsm_master_action_next_slave_state(fsm);
+            return;
+        }
+    }
+
+    // Does the slave have to be configured?
+    if ((slave->current_state != slave->requested_state
+                || slave->force_config) && !slave->error_flag) {
+
+        /* The DC reference clock is configured on its own, so that no other
+         * slave is configured while the reference clock is not ready. */
+        if (busy && master->dc_ref_clock
+                && (slave == master->dc_ref_clock
+                    || ec_fsm_master_slave_configuring(fsm,
+                        master->dc_ref_clock))) {
+            ec_fsm_master_enter_wait_configs(fsm);
+            return;
+        }
+
+        if (busy < ec_fsm_master_configs) {
+            for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+                if (!fsm->configs[i].slave) {
+                    config = &fsm->configs[i];
+                    break;
+                }
+            }
+        }
+
+        if (!config) {
+            // all configuration units busy
+            ec_fsm_master_enter_wait_configs(fsm);
+            return;
+        }
+
+        // Start slave configuration
+        down(&master->config_sem);
+        master->config_busy = 1;
+        up(&master->config_sem);
+
+        if (master->debug_level) {
+            char old_state[EC_STATE_STRING_SIZE],
+                 new_state[EC_STATE_STRING_SIZE];
+            ec_state_string(slave->current_state, old_state, 0);
+            ec_state_string(slave->requested_state, new_state, 0);
+            EC_SLAVE_DBG(slave, 1, "Changing state from %s to %s%s.\n",
+                    old_state, new_state,
+                    slave->force_config ? " (forced)" : "");
+        }
+
+        /* The configuration unit is executed with the next execution of the
+         * master state machine, while the state check goes on. */
+        config->slave = slave;
+        if (slave->group_op) {
+            slave->group_op = 0;
+            ec_fsm_slave_config_start_op(&config->fsm_slave_config, slave);
+        } else {
+            ec_fsm_slave_config_start(&config->fsm_slave_config, slave);
+        }
+    }
+
+    // process next slave
+    ec_fsm_master_action_next_slave_state(fsm);
+}
+
+/*****************************************************************************/
+
+/** Enter master state WAIT CONFIGS.
+ *
+ * Waits for a configuration unit to become free, while the master FSM
+ * datagram keeps reading the AL states.
+ */
+void ec_fsm_master_enter_wait_configs(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    fsm->idle = 0;
+    ec_datagram_brd(fsm->datagram, 0x0130, 2);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = EC_DEVICE_MAIN;
+    fsm->state = ec_fsm_master_state_wait_configs;
+}
+
+/*****************************************************************************/
+
+/** Master state: WAIT CONFIGS.
+ */
+void ec_fsm_master_state_wait_configs(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+
+    if (fsm->slave < master->slaves + master->slave_count) {
+        // retry the configuration of the current slave
+        ec_fsm_master_action_configure(fsm);
+    } else if (ec_fsm_master_configs_busy(fsm)) {
+        ec_fsm_master_enter_wait_configs(fsm);
+    } else if (!ec_fsm_master_enter_group_op(fsm)) {
+        // all slaves processed
+        ec_fsm_master_action_idle(fsm);
+    }
+}
+
+/*****************************************************************************/
+
+/** Starts verifying the remaining slaves, if slaves disappeared.
+ *
+ * If fewer slaves respond than are known, and the remaining slaves are the
+ * first ones of the bus, the missing slaves can be removed from the end of
+ * the slave list without a rescan. This is only done without redundancy.
+ *
+ * \return Non-zero, if the verification was started.
+ */
+int ec_fsm_master_enter_verify_slaves(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    unsigned int count = fsm->slaves_responding[EC_DEVICE_MAIN];
+    int allow_scan;
+
+    if (fsm->rescan_full || ec_master_num_devices(master) != 1
+            || !count || count >= master->slave_count) {
+        return 0;
+    }
+
+    down(&master->scan_sem);
+    allow_scan = master->allow_scan;
+    up(&master->scan_sem);
+    if (!allow_scan) {
+        return 0;
+    }
+
+    EC_MASTER_DBG(master, 1, "Checking, if %u slave(s) disappeared"
+            " from the end of the bus.\n", master->slave_count - count);
+
+    // check the station address of each remaining slave
+    fsm->idle = 0;
+    fsm->slave = master->slaves;
+    ec_datagram_aprd(fsm->datagram, fsm->slave->ring_position, 0x0010, 2);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = EC_DEVICE_MAIN;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_verify_slaves;
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Master state: VERIFY SLAVES.
+ */
+void ec_fsm_master_state_verify_slaves(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram = fsm->datagram;
+    unsigned int count = fsm->slaves_responding[EC_DEVICE_MAIN];
+
+    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        return;
+    }
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED
+            || datagram->working_counter != 1
+            || EC_READ_U16(datagram->data) != fsm->slave->station_address) {
+        EC_MASTER_DBG(master, 1, "Slave %u changed. Rescanning bus.\n",
+                fsm->slave->ring_position);
+        fsm->rescan_full = 1;
+        ec_fsm_master_restart(fsm);
+        return;
+    }
+
+    fsm->slave++;
+    if (fsm->slave < master->slaves + count) {
+        ec_datagram_aprd(datagram, fsm->slave->ring_position, 0x0010, 2);
+        ec_datagram_zero(datagram);
+        fsm->retries = EC_FSM_RETRIES;
+        return;
+    }
+
+    EC_MASTER_INFO(master, "Removing %u slave(s) from the end of the bus.\n",
+            master->slave_count - count);
+
+    ec_master_truncate_slaves(master, count);
+    fsm->rescan_required = 0;
+    ec_fsm_master_restart(fsm);
+}
+
+/*****************************************************************************/
+
+/** Requests OP for all slaves waiting in SAFEOP at once.
+ *
+ * AL control is written with a single broadcast datagram. This is only
+ * possible, if all other slaves are already in OP, otherwise the waiting
+ * slaves are brought to OP one by one by the configuration units.
+ *
+ * \return Non-zero, if the grouped OP request was started.
+ */
+int ec_fsm_master_enter_group_op(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    const ec_slave_t *slave;
+    unsigned int waiting = 0, others = 0;
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (ec_fsm_master_group_op_waiting(slave)) {
+            waiting++;
+        } else if (slave->current_state != EC_SLAVE_STATE_OP
+                || slave->requested_state != EC_SLAVE_STATE_OP) {
+            others++;
+        }
+    }
+
+    if (!waiting) {
+        fsm->group_op_single = 0;
+        return 0;
+    }
+
+    if (others || fsm->group_op_single) {
+        if (!fsm->group_op_single) {
+            EC_MASTER_DBG(master, 1, "%u slave(s) not ready for a grouped"
+                    " OP request. Requesting OP one by one.\n", others);
+            fsm->group_op_single = 1;
+        }
+        return 0;
+    }
+
+    EC_MASTER_DBG(master, 1, "Requesting OP for %u slave(s) at once.\n",
+            waiting);
+
+    fsm->idle = 0;
+    ec_datagram_bwr(fsm->datagram, 0x0120, 2);
+    EC_WRITE_U16(fsm->datagram->data, EC_SLAVE_STATE_OP);
+    fsm->datagram->device_index = EC_DEVICE_MAIN;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_group_op;
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Master state: GROUP OP.
+ */
+void ec_fsm_master_state_group_op(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram = fsm->datagram;
+
+    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        return;
+    }
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        EC_MASTER_WARN(master, "Failed to receive grouped OP"
+                " request datagram: ");
+        ec_datagram_print_state(datagram);
+        fsm->group_op_single = 1;
+        ec_fsm_master_restart(fsm);
+        return;
+    }
+
+    if (datagram->working_counter != master->slave_count) {
+        EC_MASTER_WARN(master, "Grouped OP request reached %u of %u"
+                " slaves.\n", datagram->working_counter,
+                master->slave_count);
+        fsm->group_op_single = 1;
+        ec_fsm_master_restart(fsm);
+        return;
+    }
+
+    fsm->group_op_jiffies = datagram->jiffies_received;
+    ec_fsm_master_enter_group_op_check(fsm);
+}
+
+/*****************************************************************************/
+
+/** Reads the AL status area to check the grouped OP request.
+ */
+void ec_fsm_master_enter_group_op_check(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    const ec_slave_t *slave;
+    size_t size = 0;
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (ec_fsm_master_group_op_waiting(slave)
+                && slave->station_address > size) {
+            size = slave->station_address;
+        }
+    }
+
+    ec_datagram_lrd(fsm->datagram, EC_AL_STATUS_LOGICAL_BASE, size);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = EC_DEVICE_MAIN;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_group_op_check;
+}
+
+/*****************************************************************************/
+
+/** Master state: GROUP OP CHECK.
+ *
+ * Evaluates the AL states of the waiting slaves.
+ */
+void ec_fsm_master_state_group_op_check(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram = fsm->datagram;
+    ec_slave_t *slave;
+    unsigned int pending = 0;
+
+    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        return;
+    }
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        EC_MASTER_WARN(master, "Failed to receive AL status area: ");
+        ec_datagram_print_state(datagram);
+        fsm->group_op_single = 1;
+        ec_fsm_master_restart(fsm);
+        return;
+    }
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        uint8_t state;
+
+        if (!ec_fsm_master_group_op_waiting(slave)) {
+            continue;
+        }
+
+        state = EC_READ_U8(datagram->data + slave->station_address - 1);
+        if (state == EC_SLAVE_STATE_OP) {
+            EC_SLAVE_DBG(slave, 1, "Now in OP. Finished configuration.\n");
+            slave->current_state = EC_SLAVE_STATE_OP;
+            slave->group_op = 0;
+        } else if (state & EC_SLAVE_STATE_ACK_ERR) {
+            // let the state change FSM evaluate the error
+            EC_SLAVE_WARN(slave, "Grouped OP request refused.\n");
+            fsm->group_op_single = 1;
+        } else {
+            pending++;
+        }
+    }
+
+    if (fsm->group_op_single || !pending) {
+        ec_fsm_master_restart(fsm);
+        return;
+    }
+
+    if (datagram->jiffies_received - fsm->group_op_jiffies
+            >= EC_GROUP_OP_TIMEOUT * HZ) {
+        EC_MASTER_WARN(master, "Timeout while waiting for %u slave(s)"
+                " to follow the grouped OP request.\n", pending);
+        fsm->group_op_single = 1;
+        ec_fsm_master_restart(fsm);
         return;
     }
 
-    // all slaves processed
-    ec_fsm_master_action_idle(fsm);
+    ec_fsm_master_enter_group_op_check(fsm);
 }
 
 /*****************************************************************************/
 
-/** Master action: Configure.
+/** Enter master state READ STATE.
+ *
+ * If the AL state of the current slave was already read ahead, it is
+ * evaluated immediately. Otherwise it is read with the master FSM datagram,
+ * and the states of the following slaves are read ahead in the same frame.
  */
-void ec_fsm_master_action_configure(
+void ec_fsm_master_enter_read_state(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
-    ec_slave_t *slave = fsm->slave;
-
-    if (master->config_changed) {
-        master->config_changed = 0;
-
-        // abort iterating through slaves,
-        // first compensate DC system time offsets,
-        // then begin configuring at slave 0
-        EC_MASTER_DBG(master, 1, "Configuration changed"
-                " (aborting state check).\n");
+    ec_datagram_t *datagram;
 
-        fsm->slave = master->slaves; // begin with first slave
-        ec_fsm_master_enter_write_system_times(fsm);
+    datagram = ec_fsm_master_read_ahead_state(fsm, fsm->slave);
+    if (datagram && fsm->state_inline < EC_FSM_MASTER_STATE_DATAGRAMS) {
+        fsm->state_inline++;
+        ec_fsm_master_eval_state(fsm, datagram);
         return;
     }
 
-    // Does the slave have to be configured?
-    if ((slave->current_state != slave->requested_state
-                || slave->force_config) && !slave->error_flag) {
-
-        // Start slave configuration
-        down(&master->config_sem);
-        master->config_busy = 1;
-        up(&master->config_sem);
-
-        if (master->debug_level) {
-            char old_state[EC_STATE_STRING_SIZE],
-                 new_state[EC_STATE_STRING_SIZE];
-            ec_state_string(slave->current_state, old_state, 0);
-            ec_state_string(slave->requested_state, new_state, 0);
-            EC_SLAVE_DBG(slave, 1, "Changing state from %s to %s%s.\n",
-                    old_state, new_state,
-                    slave->force_config ? " (forced)" : "");
-        }
+    ec_datagram_fprd(fsm->datagram, fsm->slave->station_address, 0x0130, 2);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = fsm->slave->device_index;
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_read_state;
 
-        fsm->idle = 0;
-        fsm->state = ec_fsm_master_state_configure_slave;
-        ec_fsm_slave_config_start(&fsm->fsm_slave_config, slave);
-        fsm->state(fsm); // execute immediately
-        fsm->datagram->device_index = fsm->slave->device_index;
-        return;
+    if (!datagram) {
+        ec_fsm_master_read_ahead_states(fsm,
+                fsm->slave - master->slaves + 1);
     }
-
-    // process next slave
-    ec_fsm_master_action_next_slave_state(fsm);
 }
 
 /*****************************************************************************/
@@ -682,12 +2165,28 @@ void ec_fsm_master_state_read_state(
         return;
     }
 
+    ec_fsm_master_eval_state(fsm, datagram);
+}
+
+/*****************************************************************************/
+
+/** Evaluates the AL state of the current slave.
+ */
+void ec_fsm_master_eval_state(
+        ec_fsm_master_t *fsm, /**< Master state machine. */
+        ec_datagram_t *datagram /**< Received state datagram. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
     // did the slave not respond to its station address?
     if (datagram->working_counter != 1) {
         if (!slave->error_flag) {
             slave->error_flag = 1;
             EC_SLAVE_DBG(slave, 1, "Slave did not respond to state query.\n");
         }
+        // a power cycle clears the station address and the PDO configuration
+        ec_slave_clear_pdo_cache(slave);
         fsm->rescan_required = 1;
         ec_fsm_master_restart(fsm);
         return;
@@ -838,57 +2337,117 @@ void ec_fsm_master_state_dc_measure_delays(
     EC_MASTER_INFO(master, "Scanning bus.\n");
 
     // begin scanning of slaves
-    fsm->slave = master->slaves;
-    EC_MASTER_DBG(master, 1, "Scanning slave %u on %s link.\n",
-            fsm->slave->ring_position,
-            ec_device_names[fsm->slave->device_index != 0]);
-    fsm->state = ec_fsm_master_state_scan_slave;
-    ec_fsm_slave_scan_start(&fsm->fsm_slave_scan, fsm->slave);
-    ec_fsm_slave_scan_exec(&fsm->fsm_slave_scan); // execute immediately
-    fsm->datagram->device_index = fsm->slave->device_index;
+    fsm->slave = master->slaves; // next slave to scan
+    fsm->state = ec_fsm_master_state_scan_slaves;
+    ec_fsm_master_state_scan_slaves(fsm); // execute immediately
 }
 
 /*****************************************************************************/
 
-/** Master state: SCAN SLAVE.
+/** Master state: SCAN SLAVES.
  *
- * Executes the sub-statemachine for the scanning of a slave.
+ * Runs up to EC_FSM_MASTER_SCANS slave scan state machines in parallel, each
+ * with its own datagram. The datagrams are queued together with the master
+ * FSM datagram, so that they share the same frame. The mailbox part of the
+ * scan is done afterwards, see ec_fsm_master_enter_scan_mailbox().
  */
-void ec_fsm_master_state_scan_slave(
+void ec_fsm_master_state_scan_slaves(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
     ec_master_t *master = fsm->master;
+    ec_slave_t *end = master->slaves + master->slave_count;
+    unsigned int i, running = 0;
+
+    fsm->scan_mask = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_SCANS; i++) {
+        ec_fsm_slave_scan_t *scan = &fsm->scan_fsms[i];
+        ec_datagram_t *datagram = &fsm->scan_datagrams[i];
+
+        if (scan->slave && (datagram->state == EC_DATAGRAM_QUEUED
+                    || datagram->state == EC_DATAGRAM_SENT)) {
+            running++;
+            continue;
+        }
+
+        while (1) {
+            if (!scan->slave) {
+                if (fsm->slave >= end) {
+                    break;
+                }
+                EC_MASTER_DBG(master, 1, "Scanning slave %u on %s link.\n",
+                        fsm->slave->ring_position,
+                        ec_device_names[fsm->slave->device_index != 0]);
+                ec_fsm_slave_scan_start(scan, fsm->slave++);
+            }
+
+            if (ec_fsm_slave_scan_exec(scan)) {
+                datagram->device_index = scan->slave->device_index;
+                fsm->scan_mask |= 1 << i;
+                running++;
+                break;
+            }
+
 #ifdef EC_EOE
-    ec_slave_t *slave = fsm->slave;
+            if (scan->slave->sii.mailbox_protocols & EC_MBOX_EOE) {
+                // create EoE handler for this slave
+                ec_eoe_t *eoe;
+                if (!(eoe = kmalloc(sizeof(ec_eoe_t), GFP_KERNEL))) {
+                    EC_SLAVE_ERR(scan->slave,
+                            "Failed to allocate EoE handler memory!\n");
+                } else if (ec_eoe_init(eoe, scan->slave)) {
+                    EC_SLAVE_ERR(scan->slave,
+                            "Failed to init EoE handler!\n");
+                    kfree(eoe);
+                } else {
+                    list_add_tail(&eoe->list, &master->eoe_handlers);
+                }
+            }
 #endif
 
-    if (ec_fsm_slave_scan_exec(&fsm->fsm_slave_scan)) {
+            scan->slave = NULL;
+        }
+    }
+
+    if (running) {
+        /* Keep the master FSM datagram busy with a harmless read of the AL
+         * status register, so that it paces the scan datagrams. */
+        ec_datagram_brd(fsm->datagram, 0x0130, 2);
+        ec_datagram_zero(fsm->datagram);
+        fsm->datagram->device_index = EC_DEVICE_MAIN;
         return;
     }
 
-#ifdef EC_EOE
-    if (slave->sii.mailbox_protocols & EC_MBOX_EOE) {
-        // create EoE handler for this slave
-        ec_eoe_t *eoe;
-        if (!(eoe = kmalloc(sizeof(ec_eoe_t), GFP_KERNEL))) {
-            EC_SLAVE_ERR(slave, "Failed to allocate EoE handler memory!\n");
-        } else if (ec_eoe_init(eoe, slave)) {
-            EC_SLAVE_ERR(slave, "Failed to init EoE handler!\n");
-            kfree(eoe);
-        } else {
-            list_add_tail(&eoe->list, &master->eoe_handlers);
+    // scan the mailboxes of CoE slaves one after another
+    fsm->slave = master->slaves;
+    ec_fsm_master_enter_scan_mailbox(fsm);
+}
+
+/*****************************************************************************/
+
+/** Start scanning the mailbox of the next CoE slave.
+ *
+ * Reading the PDO assignments uses the slave configuration and PDO state
+ * machines that are shared with the rest of the master FSM, so this is done
+ * for one slave at a time.
+ */
+void ec_fsm_master_enter_scan_mailbox(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_master_t *master = fsm->master;
+
+    for (; fsm->slave < master->slaves + master->slave_count; fsm->slave++) {
+        if (!(fsm->slave->sii.mailbox_protocols & EC_MBOX_COE)) {
+            continue;
         }
-    }
-#endif
 
-    // another slave to fetch?
-    fsm->slave++;
-    if (fsm->slave < master->slaves + master->slave_count) {
-        EC_MASTER_DBG(master, 1, "Scanning slave %u on %s link.\n",
-                fsm->slave->ring_position,
+        EC_MASTER_DBG(master, 1, "Scanning mailbox of slave %u"
+                " on %s link.\n", fsm->slave->ring_position,
                 ec_device_names[fsm->slave->device_index != 0]);
-        ec_fsm_slave_scan_start(&fsm->fsm_slave_scan, fsm->slave);
+        fsm->state = ec_fsm_master_state_scan_mailbox;
+        ec_fsm_slave_scan_start_mailbox(&fsm->fsm_slave_scan, fsm->slave);
         ec_fsm_slave_scan_exec(&fsm->fsm_slave_scan); // execute immediately
         fsm->datagram->device_index = fsm->slave->device_index;
         return;
@@ -896,11 +2455,13 @@ void ec_fsm_master_state_scan_slave(
 
     EC_MASTER_INFO(master, "Bus scanning completed in %lu ms.\n",
             (jiffies - fsm->scan_jiffies) * 1000 / HZ);
+    ec_startup_timer_stop(&master->startup_profile, &fsm->scan_timer, 0);
 
     master->scan_busy = 0;
     wake_up_interruptible(&master->scan_queue);
 
     ec_master_calc_dc(master);
+    ec_master_index_slaves(master);
 
     // Attach slave configurations
     ec_master_attach_slave_configs(master);
@@ -922,37 +2483,88 @@ void ec_fsm_master_state_scan_slave(
 
 /*****************************************************************************/
 
-/** Master state: CONFIGURE SLAVE.
+/** Master state: SCAN MAILBOX.
  *
- * Starts configuring a slave.
+ * Executes the sub-statemachine for the mailbox scan of a slave.
  */
-void ec_fsm_master_state_configure_slave(
+void ec_fsm_master_state_scan_mailbox(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    ec_master_t *master = fsm->master;
-
-    if (ec_fsm_slave_config_exec(&fsm->fsm_slave_config)) {
+    if (ec_fsm_slave_scan_exec(&fsm->fsm_slave_scan)) {
         return;
     }
 
-    fsm->slave->force_config = 0;
+    // another slave to fetch?
+    fsm->slave++;
+    ec_fsm_master_enter_scan_mailbox(fsm);
+}
+
+/*****************************************************************************/
+
+/** Keeps the master FSM datagram busy with a harmless read of the AL status
+ * register, so that it paces the DC offset datagrams.
+ */
+static void ec_fsm_master_dc_pace(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    ec_datagram_brd(fsm->datagram, 0x0130, 2);
+    ec_datagram_zero(fsm->datagram);
+    fsm->datagram->device_index = EC_DEVICE_MAIN;
+}
+
+/*****************************************************************************/
+
+/** Waits for the DC offset datagrams and re-queues timed-out ones.
+ *
+ * \return Non-zero, if the datagrams are not evaluable, yet.
+ */
+static int ec_fsm_master_dc_wait(
+        ec_fsm_master_t *fsm /**< Master state machine. */
+        )
+{
+    unsigned int i, busy = 0, timed_out = 0;
+
+    for (i = 0; i < fsm->dc_count; i++) {
+        ec_datagram_t *datagram = &fsm->dc_datagrams[i];
 
-    // configuration finished
-    master->config_busy = 0;
-    wake_up_interruptible(&master->config_queue);
+        if (!fsm->dc_slaves[i]) {
+            continue;
+        }
 
-    if (!ec_fsm_slave_config_success(&fsm->fsm_slave_config)) {
-        // TODO: mark slave_config as failed.
+        if (datagram->state == EC_DATAGRAM_QUEUED
+                || datagram->state == EC_DATAGRAM_SENT) {
+            busy = 1;
+        } else if (datagram->state == EC_DATAGRAM_TIMED_OUT) {
+            timed_out = 1;
+        }
     }
 
-    fsm->idle = 1;
-    ec_fsm_master_action_next_slave_state(fsm);
+    if (!busy && timed_out && fsm->retries--) {
+        for (i = 0; i < fsm->dc_count; i++) {
+            if (fsm->dc_slaves[i]
+                    && fsm->dc_datagrams[i].state == EC_DATAGRAM_TIMED_OUT) {
+                fsm->dc_mask |= 1U << i;
+            }
+        }
+        busy = 1;
+    }
+
+    if (busy) {
+        ec_fsm_master_dc_pace(fsm);
+    }
+
+    return busy;
 }
 
 /*****************************************************************************/
 
 /** Start writing DC system times.
+ *
+ * Reads the system times and offsets of up to EC_FSM_MASTER_DC_DATAGRAMS
+ * slaves at once, beginning with ec_fsm_master::slave. The datagrams are
+ * queued together with the master FSM datagram, so that they share a frame.
  */
 void ec_fsm_master_enter_write_system_times(
         ec_fsm_master_t *fsm /**< Master state machine. */
@@ -962,7 +2574,13 @@ void ec_fsm_master_enter_write_system_times(
 
     if (master->dc_ref_time) {
 
-        while (fsm->slave < master->slaves + master->slave_count) {
+        fsm->dc_count = 0;
+        fsm->dc_mask = 0;
+
+        while (fsm->slave < master->slaves + master->slave_count
+                && fsm->dc_count < EC_FSM_MASTER_DC_DATAGRAMS) {
+            ec_datagram_t *datagram = &fsm->dc_datagrams[fsm->dc_count];
+
             if (!fsm->slave->base_dc_supported
                     || !fsm->slave->has_dc_system_time) {
                 fsm->slave++;
@@ -974,11 +2592,23 @@ void ec_fsm_master_enter_write_system_times(
             // read DC system time (0x0910, 64 bit)
             //                         gap (64 bit)
             //     and time offset (0x0920, 64 bit)
-            ec_datagram_fprd(fsm->datagram, fsm->slave->station_address,
-                    0x0910, 24);
-            fsm->datagram->device_index = fsm->slave->device_index;
+            if (ec_datagram_fprd(datagram, fsm->slave->station_address,
+                        0x0910, 24)) {
+                EC_SLAVE_ERR(fsm->slave, "Failed to allocate DC datagram.\n");
+                fsm->slave++;
+                continue;
+            }
+            ec_datagram_zero(datagram);
+            datagram->device_index = fsm->slave->device_index;
+            fsm->dc_slaves[fsm->dc_count] = fsm->slave++;
+            fsm->dc_mask |= 1U << fsm->dc_count;
+            fsm->dc_count++;
+        }
+
+        if (fsm->dc_count) {
+            ec_fsm_master_dc_pace(fsm);
             fsm->retries = EC_FSM_RETRIES;
-            fsm->state = ec_fsm_master_state_dc_read_offset;
+            fsm->state = ec_fsm_master_state_dc_read_offsets;
             return;
         }
 
@@ -1003,13 +2633,12 @@ void ec_fsm_master_enter_write_system_times(
  * \return New offset.
  */
 u64 ec_fsm_master_dc_offset32(
-        ec_fsm_master_t *fsm, /**< Master state machine. */
+        ec_slave_t *slave, /**< EtherCAT slave. */
         u64 system_time, /**< System time register. */
         u64 old_offset, /**< Time offset register. */
         unsigned long jiffies_since_read /**< Jiffies for correction. */
         )
 {
-    ec_slave_t *slave = fsm->slave;
     u32 correction, system_time32, old_offset32, new_offset;
     s32 time_diff;
 
@@ -1045,20 +2674,19 @@ u64 ec_fsm_master_dc_offset32(
  * \return New offset.
  */
 u64 ec_fsm_master_dc_offset64(
-        ec_fsm_master_t *fsm, /**< Master state machine. */
+        ec_slave_t *slave, /**< EtherCAT slave. */
         u64 system_time, /**< System time register. */
         u64 old_offset, /**< Time offset register. */
         unsigned long jiffies_since_read /**< Jiffies for correction. */
         )
 {
-    ec_slave_t *slave = fsm->slave;
     u64 new_offset, correction;
     s64 time_diff;
 
     // correct read system time by elapsed time since read operation
     correction = (u64) (jiffies_since_read * 1000 / HZ) * 1000000;
     system_time += correction;
-    time_diff = fsm->slave->master->app_time - system_time;
+    time_diff = slave->master->app_time - system_time;
 
     EC_SLAVE_DBG(slave, 1, "DC 64 bit system time offset calculation:"
             " system_time=%llu (corrected with %llu),"
@@ -1080,222 +2708,113 @@ u64 ec_fsm_master_dc_offset64(
 
 /*****************************************************************************/
 
-/** Master state: DC READ OFFSET.
+/** Master state: DC READ OFFSETS.
+ *
+ * Calculates the new system time offsets and writes them together with the
+ * transmission delays, again in one frame.
  */
-void ec_fsm_master_state_dc_read_offset(
+void ec_fsm_master_state_dc_read_offsets(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    ec_datagram_t *datagram = fsm->datagram;
-    ec_slave_t *slave = fsm->slave;
     u64 system_time, old_offset, new_offset;
     unsigned long jiffies_since_read;
+    unsigned int i, writing = 0;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
-        return;
-
-    if (datagram->state != EC_DATAGRAM_RECEIVED) {
-        EC_SLAVE_ERR(slave, "Failed to receive DC times datagram: ");
-        ec_datagram_print_state(datagram);
-        fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
-        return;
-    }
-
-    if (datagram->working_counter != 1) {
-        EC_SLAVE_WARN(slave, "Failed to get DC times: ");
-        ec_datagram_print_wc_error(datagram);
-        fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
+    if (ec_fsm_master_dc_wait(fsm)) {
         return;
     }
 
-    system_time = EC_READ_U64(datagram->data);     // 0x0910
-    old_offset = EC_READ_U64(datagram->data + 16); // 0x0920
-    jiffies_since_read = jiffies - datagram->jiffies_sent;
+    for (i = 0; i < fsm->dc_count; i++) {
+        ec_datagram_t *datagram = &fsm->dc_datagrams[i];
+        ec_slave_t *slave = fsm->dc_slaves[i];
 
-    if (slave->base_dc_range == EC_DC_32) {
-        new_offset = ec_fsm_master_dc_offset32(fsm,
-                system_time, old_offset, jiffies_since_read);
-    } else {
-        new_offset = ec_fsm_master_dc_offset64(fsm,
-                system_time, old_offset, jiffies_since_read);
-    }
+        if (!slave) {
+            continue;
+        }
 
-    // set DC system time offset and transmission delay
-    ec_datagram_fpwr(datagram, slave->station_address, 0x0920, 12);
-    EC_WRITE_U64(datagram->data, new_offset);
-    EC_WRITE_U32(datagram->data + 8, slave->transmission_delay);
-    fsm->datagram->device_index = slave->device_index;
-    fsm->retries = EC_FSM_RETRIES;
-    fsm->state = ec_fsm_master_state_dc_write_offset;
-}
+        if (datagram->state != EC_DATAGRAM_RECEIVED) {
+            EC_SLAVE_ERR(slave, "Failed to receive DC times datagram: ");
+            ec_datagram_print_state(datagram);
+            fsm->dc_slaves[i] = NULL;
+            continue;
+        }
 
-/*****************************************************************************/
+        if (datagram->working_counter != 1) {
+            EC_SLAVE_WARN(slave, "Failed to get DC times: ");
+            ec_datagram_print_wc_error(datagram);
+            fsm->dc_slaves[i] = NULL;
+            continue;
+        }
 
-/** Master state: DC WRITE OFFSET.
- */
-void ec_fsm_master_state_dc_write_offset(
-        ec_fsm_master_t *fsm /**< Master state machine. */
-        )
-{
-    ec_datagram_t *datagram = fsm->datagram;
-    ec_slave_t *slave = fsm->slave;
+        system_time = EC_READ_U64(datagram->data);     // 0x0910
+        old_offset = EC_READ_U64(datagram->data + 16); // 0x0920
+        jiffies_since_read = jiffies - datagram->jiffies_sent;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
-        return;
+        if (slave->base_dc_range == EC_DC_32) {
+            new_offset = ec_fsm_master_dc_offset32(slave,
+                    system_time, old_offset, jiffies_since_read);
+        } else {
+            new_offset = ec_fsm_master_dc_offset64(slave,
+                    system_time, old_offset, jiffies_since_read);
+        }
 
-    if (datagram->state != EC_DATAGRAM_RECEIVED) {
-        EC_SLAVE_ERR(slave,
-                "Failed to receive DC system time offset datagram: ");
-        ec_datagram_print_state(datagram);
-        fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
-        return;
+        // set DC system time offset and transmission delay
+        ec_datagram_fpwr(datagram, slave->station_address, 0x0920, 12);
+        EC_WRITE_U64(datagram->data, new_offset);
+        EC_WRITE_U32(datagram->data + 8, slave->transmission_delay);
+        datagram->device_index = slave->device_index;
+        fsm->dc_mask |= 1U << i;
+        writing++;
     }
 
-    if (datagram->working_counter != 1) {
-        EC_SLAVE_ERR(slave, "Failed to set DC system time offset: ");
-        ec_datagram_print_wc_error(datagram);
-        fsm->slave++;
+    if (!writing) {
         ec_fsm_master_enter_write_system_times(fsm);
         return;
     }
 
-    fsm->slave++;
-    ec_fsm_master_enter_write_system_times(fsm);
-}
-
-/*****************************************************************************/
-
-/** Master state: WRITE SII.
- */
-void ec_fsm_master_state_write_sii(
-        ec_fsm_master_t *fsm /**< Master state machine. */
-        )
-{
-    ec_master_t *master = fsm->master;
-    ec_sii_write_request_t *request = fsm->sii_request;
-    ec_slave_t *slave = request->slave;
-
-    if (ec_fsm_sii_exec(&fsm->fsm_sii)) return;
-
-    if (!ec_fsm_sii_success(&fsm->fsm_sii)) {
-        EC_SLAVE_ERR(slave, "Failed to write SII data.\n");
-        request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&master->request_queue);
-        ec_fsm_master_restart(fsm);
-        return;
-    }
-
-    fsm->sii_index++;
-    if (fsm->sii_index < request->nwords) {
-        ec_fsm_sii_write(&fsm->fsm_sii, slave,
-                request->offset + fsm->sii_index,
-                request->words + fsm->sii_index,
-                EC_FSM_SII_USE_CONFIGURED_ADDRESS);
-        ec_fsm_sii_exec(&fsm->fsm_sii); // execute immediately
-        return;
-    }
-
-    // finished writing SII
-    EC_SLAVE_DBG(slave, 1, "Finished writing %zu words of SII data.\n",
-            request->nwords);
-
-    if (request->offset <= 4 && request->offset + request->nwords > 4) {
-        // alias was written
-        slave->sii.alias = EC_READ_U16(request->words + 4);
-        // TODO: read alias from register 0x0012
-        slave->effective_alias = slave->sii.alias;
-    }
-    // TODO: Evaluate other SII contents!
-
-    request->state = EC_INT_REQUEST_SUCCESS;
-    wake_up_all(&master->request_queue);
-
-    // check for another SII write request
-    if (ec_fsm_master_action_process_sii(fsm))
-        return; // processing another request
-
-    ec_fsm_master_restart(fsm);
-}
-
-/*****************************************************************************/
-
-/** Master state: SDO DICTIONARY.
- */
-void ec_fsm_master_state_sdo_dictionary(
-        ec_fsm_master_t *fsm /**< Master state machine. */
-        )
-{
-    ec_slave_t *slave = fsm->slave;
-    ec_master_t *master = fsm->master;
-
-    if (ec_fsm_coe_exec(&fsm->fsm_coe, fsm->datagram)) {
-        return;
-    }
-
-    if (!ec_fsm_coe_success(&fsm->fsm_coe)) {
-        ec_fsm_master_restart(fsm);
-        return;
-    }
-
-    // SDO dictionary fetching finished
-
-    if (master->debug_level) {
-        unsigned int sdo_count, entry_count;
-        ec_slave_sdo_dict_info(slave, &sdo_count, &entry_count);
-        EC_SLAVE_DBG(slave, 1, "Fetched %u SDOs and %u entries.\n",
-               sdo_count, entry_count);
-    }
-
-    // attach pdo names from dictionary
-    ec_slave_attach_pdo_names(slave);
-
-    ec_fsm_master_restart(fsm);
+    ec_fsm_master_dc_pace(fsm);
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_dc_write_offsets;
 }
 
 /*****************************************************************************/
 
-/** Master state: SDO REQUEST.
+/** Master state: DC WRITE OFFSETS.
  */
-void ec_fsm_master_state_sdo_request(
+void ec_fsm_master_state_dc_write_offsets(
         ec_fsm_master_t *fsm /**< Master state machine. */
         )
 {
-    ec_sdo_request_t *request = fsm->sdo_request;
-
-    if (!request) {
-        // configuration was cleared in the meantime
-        ec_fsm_master_restart(fsm);
-        return;
-    }
+    unsigned int i;
 
-    if (ec_fsm_coe_exec(&fsm->fsm_coe, fsm->datagram)) {
+    if (ec_fsm_master_dc_wait(fsm)) {
         return;
     }
 
-    if (!ec_fsm_coe_success(&fsm->fsm_coe)) {
-        EC_SLAVE_DBG(fsm->slave, 1,
-                "Failed to process internal SDO request.\n");
-        request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&fsm->master->request_queue);
-        ec_fsm_master_restart(fsm);
-        return;
-    }
+    for (i = 0; i < fsm->dc_count; i++) {
+        ec_datagram_t *datagram = &fsm->dc_datagrams[i];
+        ec_slave_t *slave = fsm->dc_slaves[i];
 
-    // SDO request finished
-    request->state = EC_INT_REQUEST_SUCCESS;
-    wake_up_all(&fsm->master->request_queue);
+        if (!slave) {
+            continue;
+        }
 
-    EC_SLAVE_DBG(fsm->slave, 1, "Finished internal SDO request.\n");
+        if (datagram->state != EC_DATAGRAM_RECEIVED) {
+            EC_SLAVE_ERR(slave,
+                    "Failed to receive DC system time offset datagram: ");
+            ec_datagram_print_state(datagram);
+            continue;
+        }
 
-    // check for another SDO request
-    if (ec_fsm_master_action_process_sdo(fsm)) {
-        return; // processing another request
+        if (datagram->working_counter != 1) {
+            EC_SLAVE_ERR(slave, "Failed to set DC system time offset: ");
+            ec_datagram_print_wc_error(datagram);
+        }
     }
 
-    ec_fsm_master_restart(fsm);
+    // next chunk of slaves
+    ec_fsm_master_enter_write_system_times(fsm);
 }
 
 /*****************************************************************************/
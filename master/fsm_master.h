@@ -40,24 +40,106 @@
 #include "globals.h"
 #include "datagram.h"
 #include "foe_request.h"
+#include "reg_request.h"
 #include "sdo_request.h"
 #include "soe_request.h"
 #include "fsm_slave_config.h"
 #include "fsm_slave_scan.h"
 #include "fsm_pdo.h"
+#include "startup_profile.h"
 
 /*****************************************************************************/
 
-/** SII write request.
+/** Maximum number of slaves to scan in parallel.
+ *
+ * Must not exceed the number of bits in an unsigned int, because of
+ * ec_fsm_master::scan_mask.
+ */
+#define EC_FSM_MASTER_SCANS 8
+
+/** Maximum number of slaves to configure in parallel.
+ *
+ * Must not exceed the number of bits in an unsigned int, because of
+ * ec_fsm_master::config_mask.
+ */
+#define EC_MAX_FSM_MASTER_CONFIGS 8
+
+/** Default number of slaves to configure in parallel.
+ */
+#define EC_FSM_MASTER_CONFIGS 4
+
+extern unsigned int ec_fsm_master_configs;
+
+/** Maximum number of register batch datagrams per cycle.
+ *
+ * Must not exceed the number of bits in an unsigned int, because of
+ * ec_fsm_master::reg_mask.
+ */
+#define EC_FSM_MASTER_REG_DATAGRAMS 32
+
+/** Maximum number of datagrams reading the mailbox data area per cycle.
+ *
+ * Must not exceed the number of bits in an unsigned int, because of
+ * ec_fsm_master::mbox_data_mask.
+ */
+#define EC_FSM_MASTER_MBOX_DATAGRAMS 4
+
+/** Number of AL states that are read ahead of the state check.
+ *
+ * Must not exceed the number of bits in an unsigned int, because of
+ * ec_fsm_master::state_mask.
+ */
+#define EC_FSM_MASTER_STATE_DATAGRAMS 8
+
+/** Maximum number of DC system time offsets to read and write per frame.
+ *
+ * Must not exceed the number of bits in an unsigned int, because of
+ * ec_fsm_master::dc_mask.
+ */
+#define EC_FSM_MASTER_DC_DATAGRAMS 32
+
+/** First error counter register of a slave.
+ */
+#define EC_ERROR_COUNTERS_ADDRESS 0x0300
+
+/** Size of the error counter registers of a slave.
+ */
+#define EC_ERROR_COUNTERS_SIZE 0x14
+
+extern unsigned int ec_error_monitor_interval;
+
+/** DC system time difference register of a slave.
+ */
+#define EC_DC_TIME_DIFF_ADDRESS 0x092C
+
+extern unsigned int ec_dc_monitor_interval;
+
+/** Bus monitoring interval in ms, after the bus became stable.
+ *
+ * The interval is doubled with every stable monitoring round, until the
+ * maximum given by the monitor_interval parameter is reached.
+ */
+#define EC_MONITOR_INTERVAL_MIN 1
+
+extern unsigned int ec_monitor_interval;
+
+/*****************************************************************************/
+
+/** Slave configuration unit of the master state machine.
+ *
+ * Every unit has its own datagram and sub state machines, so that several
+ * slaves can be configured at the same time.
  */
 typedef struct {
-    struct list_head list; /**< List head. */
-    ec_slave_t *slave; /**< EtherCAT slave. */
-    uint16_t offset; /**< SII word offset. */
-    size_t nwords; /**< Number of words. */
-    const uint16_t *words; /**< Pointer to the data words. */
-    ec_internal_request_state_t state; /**< State of the request. */
-} ec_sii_write_request_t;
+    ec_slave_t *slave; /**< Slave being configured, or NULL. */
+    ec_datagram_t datagram; /**< Datagram used by the state machines. */
+    ec_fsm_coe_t fsm_coe; /**< CoE state machine. */
+    ec_fsm_soe_t fsm_soe; /**< SoE state machine. */
+    ec_fsm_pdo_t fsm_pdo; /**< PDO configuration state machine. */
+    ec_fsm_change_t fsm_change; /**< State change state machine. */
+    ec_fsm_slave_config_t fsm_slave_config; /**< Slave configuration state
+                                              machine. */
+} ec_fsm_master_config_t;
 
 /*****************************************************************************/
 
@@ -75,19 +157,21 @@ struct ec_fsm_master {
                                 */
     int idle; /**< state machine is in idle phase */
     unsigned long scan_jiffies; /**< beginning of slave scanning */
+    ec_startup_timer_t scan_timer; /**< Startup profile timer of the bus
+                                     scan. */
     uint8_t link_state[EC_MAX_NUM_DEVICES]; /**< Last link state for every
                                               device. */
     unsigned int slaves_responding[EC_MAX_NUM_DEVICES]; /**< Number of
                                                           responding slaves
                                                           for every device. */
     unsigned int rescan_required; /**< A bus rescan is required. */
+    unsigned int rescan_full; /**< Removing the missing slaves from the end
+                                of the bus is not possible, a full rescan is
+                                required. */
     ec_slave_state_t slave_states[EC_MAX_NUM_DEVICES]; /**< AL states of
                                                          responding slaves for
                                                          every device. */
     ec_slave_t *slave; /**< current slave */
-    ec_sii_write_request_t *sii_request; /**< SII write request */
-    off_t sii_index; /**< index to SII write request data */
-    ec_sdo_request_t *sdo_request; /**< SDO request to process. */
 
     ec_fsm_coe_t fsm_coe; /**< CoE state machine */
     ec_fsm_soe_t fsm_soe; /**< SoE state machine */
@@ -95,7 +179,126 @@ struct ec_fsm_master {
     ec_fsm_change_t fsm_change; /**< State change state machine */
     ec_fsm_slave_config_t fsm_slave_config; /**< slave state machine */
     ec_fsm_slave_scan_t fsm_slave_scan; /**< slave state machine */
-    ec_fsm_sii_t fsm_sii; /**< SII state machine */
+
+    ec_fsm_slave_scan_t scan_fsms[EC_FSM_MASTER_SCANS]; /**< Slave scan state
+                                                          machines running
+                                                          in parallel. */
+    ec_datagram_t scan_datagrams[EC_FSM_MASTER_SCANS]; /**< Datagrams of the
+                                                         parallel slave scan
+                                                         state machines. */
+    unsigned int scan_mask; /**< Bit mask of the scan datagrams that have to
+                              be queued together with the master FSM
+                              datagram. */
+
+    ec_fsm_master_config_t configs[EC_MAX_FSM_MASTER_CONFIGS]; /**< Slave
+                                                                 configuration
+                                                                 units. */
+    unsigned int config_mask; /**< Bit mask of the configuration unit
+                                datagrams that have to be queued together
+                                with the master FSM datagram. */
+
+    ec_datagram_t al_datagram; /**< Datagram reading the AL status area. */
+    unsigned int al_queue; /**< \a al_datagram has to be queued together with
+                             the master FSM datagram. */
+    unsigned int al_pending; /**< \a al_datagram was queued and its result is
+                               not evaluated yet. */
+
+    ec_datagram_t mbox_datagram; /**< Datagram reading the mailbox status
+                                   area. */
+    unsigned int mbox_queue; /**< \a mbox_datagram has to be queued together
+                               with the master FSM datagram. */
+    unsigned int mbox_pending; /**< \a mbox_datagram was queued and its result
+                                 is not evaluated yet. */
+    unsigned int mbox_slaves; /**< Number of slaves expected to answer
+                                \a mbox_datagram. */
+    unsigned int mbox_seq; /**< Number of prepared mailbox status area
+                             reads. */
+    unsigned int mbox_valid_seq; /**< Sequence number of the read, that
+                                   \a mbox_status stems from. */
+    size_t mbox_size; /**< Number of valid bytes in \a mbox_status. */
+    uint8_t mbox_status[EC_MBOX_STATUS_MAX_SLAVES]; /**< Last content of the
+                                                      mailbox status area. */
+    ec_datagram_t mbox_data_datagrams[EC_FSM_MASTER_MBOX_DATAGRAMS]; /**<
+                                              Datagrams reading parts of the
+                                              mailbox data area. */
+    unsigned int mbox_data_first[EC_FSM_MASTER_MBOX_DATAGRAMS]; /**< Ring
+                                                     position of the first
+                                                     slave read by every
+                                                     datagram. */
+    unsigned int mbox_data_count; /**< Number of prepared mailbox data
+                                    datagrams, that are not evaluated yet. */
+    unsigned int mbox_data_mask; /**< Mailbox data datagrams to be queued
+                                   together with the master FSM datagram. */
+    unsigned int mbox_data_seq; /**< Sequence number of the mailbox status
+                                  area read, that the last mailbox data reads
+                                  were based on. */
+
+    ec_datagram_t state_datagrams[EC_FSM_MASTER_STATE_DATAGRAMS]; /**<
+                                                  Datagrams reading the AL
+                                                  states of the next slaves
+                                                  to check. */
+    uint16_t state_stations[EC_FSM_MASTER_STATE_DATAGRAMS]; /**< Station
+                                                             address read
+                                                             by every state
+                                                             datagram. */
+    unsigned int state_first; /**< Index of the slave read by the first
+                                state datagram. */
+    unsigned int state_count; /**< Number of state datagrams, whose results
+                                are not evaluated yet. */
+    unsigned int state_mask; /**< Bit mask of the state datagrams that have
+                               to be queued together with the master FSM
+                               datagram. */
+    unsigned int state_inline; /**< Number of read-ahead states evaluated in
+                                 the current execution. */
+
+    ec_reg_batch_t *reg_batch; /**< Register batch request in progress. */
+    ec_datagram_t reg_datagrams[EC_FSM_MASTER_REG_DATAGRAMS]; /**< Datagrams
+                                                                of the
+                                                                register
+                                                                batch. */
+    unsigned int reg_indices[EC_FSM_MASTER_REG_DATAGRAMS]; /**< Batch slave
+                                                             index of every
+                                                             datagram. */
+    unsigned int reg_count; /**< Number of prepared batch datagrams, whose
+                              results are not evaluated yet. */
+    unsigned int reg_mask; /**< Bit mask of the register batch datagrams
+                             that have to be queued together with the
+                             master FSM datagram. */
+    ec_reg_batch_t error_batch; /**< Register batch of the error counter
+                                  monitor. */
+    unsigned long error_jiffies; /**< Start of the last error counter
+                                   sample. */
+    ec_reg_batch_t dc_mon_batch; /**< Register batch of the DC time
+                                   difference monitor. */
+    unsigned long dc_mon_jiffies; /**< Start of the last DC time difference
+                                    sample. */
+    ec_reg_batch_t wc_probe_batch; /**< Register batch reading the AL states
+                                     of a domain's slaves after a working
+                                     counter drop. */
+    unsigned int wc_probe_domain; /**< Index of the probed domain. */
+    unsigned int monitor_interval; /**< Current bus monitoring interval in
+                                     ms (0 = every cycle). */
+    unsigned long monitor_jiffies; /**< Start of the last bus monitoring
+                                     round. */
+    unsigned int monitor_hold; /**< The bus monitoring is deferred, the
+                                 master FSM datagram shall not be queued. */
+
+    ec_datagram_t dc_datagrams[EC_FSM_MASTER_DC_DATAGRAMS]; /**< Datagrams
+                                                              for reading
+                                                              and writing
+                                                              the DC system
+                                                              time offsets.
+                                                              */
+    ec_slave_t *dc_slaves[EC_FSM_MASTER_DC_DATAGRAMS]; /**< Slave of every DC
+                                                         datagram, or NULL
+                                                         after an error. */
+    unsigned int dc_count; /**< Number of DC datagrams in use. */
+    unsigned int dc_mask; /**< Bit mask of the DC datagrams that have to be
+                            queued together with the master FSM datagram. */
+
+    unsigned int group_op_single; /**< Slaves waiting for a grouped OP
+                                    request are brought to OP one by one. */
+    unsigned long group_op_jiffies; /**< Start of the grouped OP request. */
 };
 
 /*****************************************************************************/
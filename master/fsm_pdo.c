@@ -81,6 +81,8 @@ void ec_fsm_pdo_init(
     ec_pdo_list_init(&fsm->pdos);
     ec_sdo_request_init(&fsm->request);
     ec_pdo_init(&fsm->slave_pdo);
+    fsm->slave_pdo_cached = 0;
+    fsm->mapping_failed = 0;
 }
 
 /*****************************************************************************/
@@ -294,6 +296,7 @@ void ec_fsm_pdo_read_action_next_pdo(
     // finished reading PDO configuration
 
     ec_pdo_list_copy(&fsm->sync->pdos, &fsm->pdos);
+    fsm->sync->pdos_cached = 1;
     ec_pdo_list_clear_pdos(&fsm->pdos);
 
     // next sync manager
@@ -435,6 +438,7 @@ void ec_fsm_pdo_conf_action_next_sync(
             fsm->state = ec_fsm_pdo_state_error;
             return;
         }
+        fsm->mapping_failed = 0;
 
         if (!(fsm->sync = ec_slave_get_sync(fsm->slave, fsm->sync_index))) {
             if (!list_empty(&fsm->pdos.list))
@@ -462,6 +466,33 @@ void ec_fsm_pdo_conf_action_next_sync(
 
 /*****************************************************************************/
 
+/** Finds a PDO in the cached PDO assignment of the slave.
+ *
+ * \return PDO, or NULL, if it is not assigned or its mapping is not known.
+ */
+static const ec_pdo_t *ec_fsm_pdo_find_cached_pdo(
+        const ec_slave_t *slave, /**< Slave. */
+        uint16_t index /**< PDO index. */
+        )
+{
+    unsigned int i;
+    const ec_sync_t *sync;
+    const ec_pdo_t *pdo;
+
+    for (i = 0; i < slave->sii.sync_count; i++) {
+        sync = &slave->sii.syncs[i];
+
+        if (sync->pdos_cached
+                && (pdo = ec_pdo_list_find_pdo_const(&sync->pdos, index))) {
+            return pdo;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
 /** Check if the mapping has to be read, otherwise start to configure it.
  */
 void ec_fsm_pdo_conf_action_pdo_mapping(
@@ -473,10 +504,17 @@ void ec_fsm_pdo_conf_action_pdo_mapping(
 
     fsm->slave_pdo.index = fsm->pdo->index;
 
-    if ((assigned_pdo = ec_slave_find_pdo(fsm->slave, fsm->pdo->index))) {
+    if ((assigned_pdo = ec_fsm_pdo_find_cached_pdo(fsm->slave,
+                    fsm->pdo->index))) {
+        ec_pdo_copy_entries(&fsm->slave_pdo, assigned_pdo);
+        fsm->slave_pdo_cached = 1;
+    } else if ((assigned_pdo = ec_slave_find_pdo(fsm->slave,
+                    fsm->pdo->index))) {
         ec_pdo_copy_entries(&fsm->slave_pdo, assigned_pdo);
+        fsm->slave_pdo_cached = 0;
     } else { // configured PDO is not assigned and thus unknown
         ec_pdo_clear_entries(&fsm->slave_pdo);
+        fsm->slave_pdo_cached = 0;
     }
 
     if (list_empty(&fsm->slave_pdo.entries)) {
@@ -512,6 +550,7 @@ void ec_fsm_pdo_conf_state_read_mapping(
         EC_SLAVE_WARN(fsm->slave,
                 "Failed to read PDO entries for PDO 0x%04X.\n",
                 fsm->pdo->index);
+    fsm->slave_pdo_cached = ec_fsm_pdo_entry_success(&fsm->fsm_pdo_entry);
 
     // check if the mapping must be re-configured
     ec_fsm_pdo_conf_action_check_mapping(fsm, datagram);
@@ -533,7 +572,14 @@ void ec_fsm_pdo_conf_action_check_mapping(
             && fsm->slave->sii.has_general
             && fsm->slave->sii.coe_details.enable_pdo_configuration) {
 
-        // always write PDO mapping
+        if (fsm->slave_pdo_cached
+                && ec_pdo_equal_entries(fsm->pdo, &fsm->slave_pdo)) {
+            EC_SLAVE_DBG(fsm->slave, 1, "Mapping of PDO 0x%04X"
+                    " unchanged.\n", fsm->pdo->index);
+            ec_fsm_pdo_conf_action_next_pdo_mapping(fsm, datagram);
+            return;
+        }
+
         ec_fsm_pdo_entry_start_configuration(&fsm->fsm_pdo_entry, fsm->slave,
                 fsm->pdo, &fsm->slave_pdo);
         fsm->state = ec_fsm_pdo_conf_state_mapping;
@@ -567,10 +613,12 @@ void ec_fsm_pdo_conf_state_mapping(
         return;
     }
 
-    if (!ec_fsm_pdo_entry_success(&fsm->fsm_pdo_entry))
+    if (!ec_fsm_pdo_entry_success(&fsm->fsm_pdo_entry)) {
         EC_SLAVE_WARN(fsm->slave,
                 "Failed to configure mapping of PDO 0x%04X.\n",
                 fsm->pdo->index);
+        fsm->mapping_failed = 1;
+    }
 
     ec_fsm_pdo_conf_action_next_pdo_mapping(fsm, datagram);
 }
@@ -607,7 +655,14 @@ void ec_fsm_pdo_conf_action_check_assignment(
             && fsm->slave->sii.has_general
             && fsm->slave->sii.coe_details.enable_pdo_assign) {
 
-        // always write PDO assignment
+        if (fsm->sync->pdos_cached
+                && ec_pdo_list_equal(&fsm->sync->pdos, &fsm->pdos)) {
+            EC_SLAVE_DBG(fsm->slave, 1, "PDO assignment of SM%u"
+                    " unchanged.\n", fsm->sync_index);
+            ec_fsm_pdo_conf_action_next_sync(fsm, datagram);
+            return;
+        }
+
         if (fsm->slave->master->debug_level) {
             EC_SLAVE_DBG(fsm->slave, 1, "Setting PDO assignment of SM%u:\n",
                     fsm->sync_index);
@@ -771,6 +826,8 @@ void ec_fsm_pdo_conf_state_set_pdo_count(
 
     // PDOs have been configured
     ec_pdo_list_copy(&fsm->sync->pdos, &fsm->pdos);
+    // a failed mapping is not known
+    fsm->sync->pdos_cached = !fsm->mapping_failed;
 
     EC_SLAVE_DBG(fsm->slave, 1, "Successfully configured"
             " PDO assignment of SM%u.\n", fsm->sync_index);
@@ -59,6 +59,10 @@ struct ec_fsm_pdo
     ec_pdo_list_t pdos; /**< PDO configuration. */
     ec_sdo_request_t request; /**< SDO request. */
     ec_pdo_t slave_pdo; /**< PDO actually appearing in a slave. */
+    uint8_t slave_pdo_cached; /**< The mapping in \a slave_pdo is known to
+                                be the slave's current one. */
+    uint8_t mapping_failed; /**< Configuring the mapping of a PDO of the
+                              current sync manager failed. */
 
     ec_slave_t *slave; /**< Slave the FSM runs on. */
     uint8_t sync_index; /**< Current sync manager index. */
@@ -205,6 +205,7 @@ void ec_fsm_sii_state_read_check(
         )
 {
     ec_datagram_t *datagram = fsm->datagram;
+    size_t size;
 
     if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
         return;
@@ -226,13 +227,17 @@ void ec_fsm_sii_state_read_check(
     fsm->jiffies_start = datagram->jiffies_sent;
     fsm->check_once_more = 1;
 
-    // issue check/fetch datagram
+    /* Issue check/fetch datagram. The data registers of slaves that are
+     * known to support 8-byte reads are fetched completely. */
+    size = fsm->slave->sii_read_size == 8 ? 14 : 10;
     switch (fsm->mode) {
         case EC_FSM_SII_USE_INCREMENT_ADDRESS:
-            ec_datagram_aprd(datagram, fsm->slave->ring_position, 0x502, 10);
+            ec_datagram_aprd(datagram, fsm->slave->ring_position, 0x502,
+                    size);
             break;
         case EC_FSM_SII_USE_CONFIGURED_ADDRESS:
-            ec_datagram_fprd(datagram, fsm->slave->station_address, 0x502, 10);
+            ec_datagram_fprd(datagram, fsm->slave->station_address, 0x502,
+                    size);
             break;
     }
 
@@ -306,7 +311,19 @@ void ec_fsm_sii_state_read_fetch(
     }
 
     // SII value received.
-    memcpy(fsm->value, datagram->data + 6, 4);
+    fsm->value_size = 4;
+    if (EC_READ_U8(datagram->data) & 0x40) { // 8-byte read size
+        if (fsm->slave->sii_read_size != 8) {
+            EC_SLAVE_DBG(fsm->slave, 1, "SII supports 8-byte reads.\n");
+            fsm->slave->sii_read_size = 8;
+        } else if (datagram->data_size >= 14) {
+            fsm->value_size = 8;
+        }
+    } else {
+        fsm->slave->sii_read_size = 4;
+    }
+
+    memcpy(fsm->value, datagram->data + 6, fsm->value_size);
     fsm->state = ec_fsm_sii_state_end;
 }
 
@@ -372,6 +389,7 @@ void ec_fsm_sii_state_write_check(
 
     fsm->jiffies_start = datagram->jiffies_sent;
     fsm->check_once_more = 1;
+    fsm->busy_seen = 0;
 
     // issue check datagram
     ec_datagram_fprd(datagram, fsm->slave->station_address, 0x502, 2);
@@ -392,6 +410,7 @@ void ec_fsm_sii_state_write_check2(
 {
     ec_datagram_t *datagram = fsm->datagram;
     unsigned long diff_ms;
+    uint8_t busy;
 
     if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
         return;
@@ -423,10 +442,18 @@ void ec_fsm_sii_state_write_check2(
         return;
     }
 
+    // busy bit or write operation busy bit
+    busy = EC_READ_U8(datagram->data + 1) & 0x82;
+    if (busy) {
+        fsm->busy_seen = 1;
+    }
+
     /* FIXME: some slaves never answer with the busy flag set...
-     * wait a few ms for the write operation to complete. */
+     * wait a few ms for the write operation to complete. If the slave
+     * reported busy before, its cleared busy flag can be trusted, so that
+     * fast EEPROMs are not slowed down. */
     diff_ms = (datagram->jiffies_received - fsm->jiffies_start) * 1000 / HZ;
-    if (diff_ms < SII_INHIBIT) {
+    if (!fsm->busy_seen && diff_ms < SII_INHIBIT) {
 #ifdef SII_DEBUG
         EC_SLAVE_DBG(fsm->slave, 0, "too early.\n");
 #endif
@@ -435,8 +462,7 @@ void ec_fsm_sii_state_write_check2(
         return;
     }
 
-    if (EC_READ_U8(datagram->data + 1) & 0x82) { /* busy bit or
-                                                    write operation busy bit */
+    if (busy) {
         // still busy... timeout?
         if (diff_ms >= SII_TIMEOUT) {
             if (fsm->check_once_more) {
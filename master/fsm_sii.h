@@ -67,9 +67,13 @@ struct ec_fsm_sii
     void (*state)(ec_fsm_sii_t *); /**< SII state function */
     uint16_t word_offset; /**< input: word offset in SII */
     ec_fsm_sii_addressing_t mode; /**< reading via APRD or NPRD */
-    uint8_t value[4]; /**< raw SII value (32bit) */
+    uint8_t value[8]; /**< raw SII value (32 or 64 bit) */
+    size_t value_size; /**< Number of valid bytes in \a value after
+                         reading (4 or 8). */
     unsigned long jiffies_start; /**< Start timestamp. */
     uint8_t check_once_more; /**< one more try after timeout */
+    uint8_t busy_seen; /**< The slave reported the write operation as
+                         busy. */
 };
 
 /*****************************************************************************/
@@ -39,6 +39,7 @@
 #include "slave_config.h"
 
 #include "fsm_slave.h"
+#include "trace.h"
 
 /*****************************************************************************/
 
@@ -48,10 +49,15 @@ int ec_fsm_slave_action_process_sdo(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_sdo_request(ec_fsm_slave_t *, ec_datagram_t *);
 int ec_fsm_slave_action_process_reg(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_reg_request(ec_fsm_slave_t *, ec_datagram_t *);
+int ec_fsm_slave_action_process_sii(ec_fsm_slave_t *, ec_datagram_t *);
+void ec_fsm_slave_state_sii_request(ec_fsm_slave_t *, ec_datagram_t *);
 int ec_fsm_slave_action_process_foe(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_foe_request(ec_fsm_slave_t *, ec_datagram_t *);
 int ec_fsm_slave_action_process_soe(ec_fsm_slave_t *, ec_datagram_t *);
 void ec_fsm_slave_state_soe_request(ec_fsm_slave_t *, ec_datagram_t *);
+int ec_fsm_slave_action_process_dict(ec_fsm_slave_t *, ec_datagram_t *);
+void ec_fsm_slave_state_dict_entries(ec_fsm_slave_t *, ec_datagram_t *);
+void ec_fsm_slave_state_dict(ec_fsm_slave_t *, ec_datagram_t *);
 
 /*****************************************************************************/
 
@@ -64,18 +70,21 @@ void ec_fsm_slave_init(
 {
     fsm->slave = slave;
     INIT_LIST_HEAD(&fsm->list); // mark as unlisted
+    INIT_LIST_HEAD(&fsm->ready);
 
     fsm->state = ec_fsm_slave_state_idle;
     fsm->datagram = NULL;
     fsm->sdo_request = NULL;
     fsm->reg_request = NULL;
+    fsm->sii_request = NULL;
+    ec_fsm_sii_init(&fsm->fsm_sii, NULL);
     fsm->foe_request = NULL;
     fsm->soe_request = NULL;
+    fsm->dict_request = NULL;
 
-    // Init sub-state-machines
-    ec_fsm_coe_init(&fsm->fsm_coe);
-    ec_fsm_foe_init(&fsm->fsm_foe);
-    ec_fsm_soe_init(&fsm->fsm_soe);
+    // the mailbox state machines are allocated on demand, as soon as the
+    // supported mailbox protocols are known
+    fsm->mbox = NULL;
 }
 
 /*****************************************************************************/
@@ -91,16 +100,24 @@ void ec_fsm_slave_clear(
     if (fsm->sdo_request) {
         fsm->sdo_request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&fsm->slave->master->request_queue);
+        ec_sdo_request_notify(fsm->sdo_request);
     }
 
     if (fsm->reg_request) {
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&fsm->slave->master->request_queue);
+        ec_reg_request_notify(fsm->reg_request);
+    }
+
+    if (fsm->sii_request) {
+        fsm->sii_request->state = EC_INT_REQUEST_FAILURE;
+        wake_up_all(&fsm->slave->master->request_queue);
     }
 
     if (fsm->foe_request) {
         fsm->foe_request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&fsm->slave->master->request_queue);
+        ec_foe_request_notify(fsm->foe_request);
     }
 
     if (fsm->soe_request) {
@@ -108,10 +125,25 @@ void ec_fsm_slave_clear(
         wake_up_all(&fsm->slave->master->request_queue);
     }
 
+    if (fsm->dict_request) {
+        ec_sdo_t *sdo =
+            ec_slave_get_sdo(fsm->slave, fsm->dict_request->index);
+        if (sdo) {
+            sdo->entries_busy = 0;
+        }
+        fsm->dict_request->state = EC_INT_REQUEST_FAILURE;
+        wake_up_all(&fsm->slave->master->request_queue);
+    }
+
     // clear sub-state machines
-    ec_fsm_coe_clear(&fsm->fsm_coe);
-    ec_fsm_foe_clear(&fsm->fsm_foe);
-    ec_fsm_soe_clear(&fsm->fsm_soe);
+    ec_fsm_sii_clear(&fsm->fsm_sii);
+    if (fsm->mbox) {
+        ec_fsm_coe_clear(&fsm->mbox->fsm_coe);
+        ec_fsm_foe_clear(&fsm->mbox->fsm_foe);
+        ec_fsm_soe_clear(&fsm->mbox->fsm_soe);
+        kfree(fsm->mbox);
+        fsm->mbox = NULL;
+    }
 }
 
 /*****************************************************************************/
@@ -125,9 +157,15 @@ int ec_fsm_slave_exec(
         ec_datagram_t *datagram /**< New datagram to use. */
         )
 {
+    void (*state)(ec_fsm_slave_t *, ec_datagram_t *) = fsm->state;
     int datagram_used;
 
     fsm->state(fsm, datagram);
+    if (fsm->state != state) {
+        trace_ec_fsm_state(fsm->slave->master->index,
+                fsm->slave->ring_position, (const void *) state,
+                (const void *) fsm->state);
+    }
 
     datagram_used = fsm->state != ec_fsm_slave_state_idle &&
         fsm->state != ec_fsm_slave_state_ready;
@@ -144,14 +182,34 @@ int ec_fsm_slave_exec(
 /*****************************************************************************/
 
 /** Sets the current state of the state machine to READY
+ *
+ * Allocates the mailbox state machines, if the slave supports a mailbox
+ * protocol. If that fails, the state machine stays idle and the allocation
+ * is retried on the next call.
  */
 void ec_fsm_slave_set_ready(
         ec_fsm_slave_t *fsm /**< Slave state machine. */
         )
 {
     if (fsm->state == ec_fsm_slave_state_idle) {
+        if (fsm->slave->sii.mailbox_protocols && !fsm->mbox) {
+            if (!(fsm->mbox = kmalloc(sizeof(ec_fsm_slave_mbox_t),
+                            GFP_KERNEL))) {
+                EC_SLAVE_ERR(fsm->slave, "Failed to allocate mailbox"
+                        " state machines.\n");
+                return;
+            }
+
+            ec_fsm_coe_init(&fsm->mbox->fsm_coe);
+            ec_fsm_foe_init(&fsm->mbox->fsm_foe);
+            ec_fsm_soe_init(&fsm->mbox->fsm_soe);
+        }
+
         EC_SLAVE_DBG(fsm->slave, 1, "Ready for requests.\n");
         fsm->state = ec_fsm_slave_state_ready;
+
+        // serve the requests issued in the meantime
+        ec_master_kick_slave_fsm(fsm->slave->master, fsm->slave);
     }
 }
 
@@ -201,6 +259,11 @@ void ec_fsm_slave_state_ready(
         return;
     }
 
+    // Check for pending SII write requests
+    if (ec_fsm_slave_action_process_sii(fsm, datagram)) {
+        return;
+    }
+
     // Check for pending FoE requests
     if (ec_fsm_slave_action_process_foe(fsm, datagram)) {
         return;
@@ -210,11 +273,19 @@ void ec_fsm_slave_state_ready(
     if (ec_fsm_slave_action_process_soe(fsm, datagram)) {
         return;
     }
+
+    // Check for pending SDO dictionary work
+    if (ec_fsm_slave_action_process_dict(fsm, datagram)) {
+        return;
+    }
 }
 
 /*****************************************************************************/
 
 /** Check for pending SDO requests and process one.
+ *
+ * External requests are processed first, then the internal requests of the
+ * slave configuration in the order of their creation.
  *
  * \return non-zero, if an SDO request is processed.
  */
@@ -224,21 +295,43 @@ int ec_fsm_slave_action_process_sdo(
         )
 {
     ec_slave_t *slave = fsm->slave;
-    ec_sdo_request_t *request;
+    ec_sdo_request_t *request = NULL, *req;
 
-    if (list_empty(&slave->sdo_requests)) {
-        return 0;
+    if (!list_empty(&slave->sdo_requests)) {
+        // take the first external request to be processed
+        request =
+            list_entry(slave->sdo_requests.next, ec_sdo_request_t, list);
+        list_del_init(&request->list); // dequeue
+    } else if (slave->config) {
+        // search the first internal request to be processed
+        list_for_each_entry(req, &slave->config->sdo_requests, list) {
+            if (req->state != EC_INT_REQUEST_QUEUED) {
+                continue;
+            }
+
+            if (ec_sdo_request_timed_out(req)) {
+                req->state = EC_INT_REQUEST_FAILURE;
+                EC_SLAVE_DBG(slave, 1, "Internal SDO request"
+                        " timed out.\n");
+                ec_sdo_request_notify(req);
+                continue;
+            }
+
+            request = req;
+            break;
+        }
     }
 
-    // take the first request to be processed
-    request = list_entry(slave->sdo_requests.next, ec_sdo_request_t, list);
-    list_del_init(&request->list); // dequeue
+    if (!request) { // no SDO request to process
+        return 0;
+    }
 
     if (slave->current_state & EC_SLAVE_STATE_ACK_ERR) {
         EC_SLAVE_WARN(slave, "Aborting SDO request,"
                 " slave has error flag set.\n");
         request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
+        ec_sdo_request_notify(request);
         fsm->state = ec_fsm_slave_state_idle;
         return 1;
     }
@@ -247,10 +340,20 @@ int ec_fsm_slave_action_process_sdo(
         EC_SLAVE_WARN(slave, "Aborting SDO request, slave is in INIT.\n");
         request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
+        ec_sdo_request_notify(request);
         fsm->state = ec_fsm_slave_state_idle;
         return 1;
     }
 
+    if (!fsm->mbox) {
+        EC_SLAVE_ERR(slave, "Aborting SDO request,"
+                " slave does not support a mailbox protocol.\n");
+        request->state = EC_INT_REQUEST_FAILURE;
+        wake_up_all(&slave->master->request_queue);
+        ec_sdo_request_notify(request);
+        return 1;
+    }
+
     fsm->sdo_request = request;
     request->state = EC_INT_REQUEST_BUSY;
 
@@ -259,8 +362,8 @@ int ec_fsm_slave_action_process_sdo(
 
     // Start SDO transfer
     fsm->state = ec_fsm_slave_state_sdo_request;
-    ec_fsm_coe_transfer(&fsm->fsm_coe, slave, request);
-    ec_fsm_coe_exec(&fsm->fsm_coe, datagram); // execute immediately
+    ec_fsm_coe_transfer(&fsm->mbox->fsm_coe, slave, request);
+    ec_fsm_coe_exec(&fsm->mbox->fsm_coe, datagram); // execute immediately
     return 1;
 }
 
@@ -276,14 +379,21 @@ void ec_fsm_slave_state_sdo_request(
     ec_slave_t *slave = fsm->slave;
     ec_sdo_request_t *request = fsm->sdo_request;
 
-    if (ec_fsm_coe_exec(&fsm->fsm_coe, datagram)) {
+    if (!request) {
+        // configuration was cleared in the meantime
+        fsm->state = ec_fsm_slave_state_ready;
+        return;
+    }
+
+    if (ec_fsm_coe_exec(&fsm->mbox->fsm_coe, datagram)) {
         return;
     }
 
-    if (!ec_fsm_coe_success(&fsm->fsm_coe)) {
+    if (!ec_fsm_coe_success(&fsm->mbox->fsm_coe)) {
         EC_SLAVE_ERR(slave, "Failed to process SDO request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
+        ec_sdo_request_notify(request);
         fsm->sdo_request = NULL;
         fsm->state = ec_fsm_slave_state_ready;
         return;
@@ -294,8 +404,12 @@ void ec_fsm_slave_state_sdo_request(
     // SDO request finished
     request->state = EC_INT_REQUEST_SUCCESS;
     wake_up_all(&slave->master->request_queue);
+    ec_sdo_request_notify(request);
     fsm->sdo_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
+
+    // process the next SDO request back to back
+    ec_fsm_slave_action_process_sdo(fsm, datagram);
 }
 
 /*****************************************************************************/
@@ -340,6 +454,7 @@ int ec_fsm_slave_action_process_reg(
                 " slave has error flag set.\n");
         fsm->reg_request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
+        ec_reg_request_notify(fsm->reg_request);
         fsm->reg_request = NULL;
         fsm->state = ec_fsm_slave_state_idle;
         return 1;
@@ -391,6 +506,7 @@ void ec_fsm_slave_state_reg_request(
         ec_datagram_print_state(fsm->datagram);
         reg->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
+        ec_reg_request_notify(reg);
         fsm->reg_request = NULL;
         fsm->state = ec_fsm_slave_state_ready;
         return;
@@ -412,12 +528,217 @@ void ec_fsm_slave_state_reg_request(
     }
 
     wake_up_all(&slave->master->request_queue);
+    ec_reg_request_notify(reg);
     fsm->reg_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
 }
 
 /*****************************************************************************/
 
+/** Check for pending SII write requests and process one.
+ *
+ * The request waits, while a configuration of the slave is pending, because
+ * the configuration may assign the SII to the PDI.
+ *
+ * \return non-zero, if an SII write request is processed.
+ */
+int ec_fsm_slave_action_process_sii(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_sii_write_request_t *request;
+
+    if (list_empty(&slave->sii_requests)) {
+        return 0;
+    }
+
+    if (slave->force_config || (slave->current_state
+                != slave->requested_state && !slave->error_flag)) {
+        return 0; // retried with the next sweep
+    }
+
+    // take the first request to be processed
+    request = list_entry(slave->sii_requests.next,
+            ec_sii_write_request_t, list);
+    list_del_init(&request->list); // dequeue
+    request->state = EC_INT_REQUEST_BUSY;
+    request->verify_error = 0;
+
+    EC_SLAVE_DBG(slave, 1, "Writing SII data...\n");
+
+    fsm->sii_request = request;
+    fsm->sii_index = 0;
+    fsm->sii_verifying = 0;
+    fsm->state = ec_fsm_slave_state_sii_request;
+
+    fsm->fsm_sii.datagram = datagram;
+    ec_fsm_sii_write(&fsm->fsm_sii, slave, request->offset, request->words,
+            EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+    ec_fsm_sii_exec(&fsm->fsm_sii); // execute immediately
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Updates the slave's SII image after a successful SII write.
+ */
+static void ec_fsm_slave_sii_written(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        const ec_sii_write_request_t *request /**< SII write request. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    size_t nwords = request->offset + request->nwords;
+    uint16_t *words;
+
+    EC_SLAVE_DBG(slave, 1, "Finished writing %zu words of SII data.\n",
+            request->nwords);
+
+    if (nwords > slave->sii_nwords) {
+        if (!(words = kmalloc(nwords * 2, GFP_KERNEL))) {
+            EC_SLAVE_WARN(slave, "Failed to allocate %zu words of SII"
+                    " data. Dropping the SII image.\n", nwords);
+            kfree(slave->sii_words);
+            slave->sii_words = NULL;
+            slave->sii_nwords = 0;
+            words = NULL;
+        } else {
+            if (slave->sii_words) {
+                memcpy(words, slave->sii_words, slave->sii_nwords * 2);
+                kfree(slave->sii_words);
+            }
+            memset(words + slave->sii_nwords, 0xff,
+                    (nwords - slave->sii_nwords) * 2);
+            slave->sii_words = words;
+            slave->sii_nwords = nwords;
+        }
+    }
+
+    // keep the image served to sii_read up to date
+    if (slave->sii_words) {
+        memcpy(slave->sii_words + request->offset, request->words,
+                request->nwords * 2);
+    }
+
+    if (request->offset <= 4 && request->offset + request->nwords > 4) {
+        // alias was written
+        slave->sii.alias = EC_READ_U16(request->words + 4);
+        // TODO: read alias from register 0x0012
+        slave->effective_alias = slave->sii.alias;
+        ec_master_index_slaves(slave->master);
+    }
+    // TODO: Evaluate other SII contents!
+
+    // cached images may be outdated now
+    ec_master_sii_cache_clear(slave->master);
+}
+
+/*****************************************************************************/
+
+/** Starts the next step of an SII write request.
+ *
+ * The words are written one after another. If the request asks for it,
+ * they are read back and compared afterwards.
+ *
+ * \return Non-zero, if a step was started, zero if the request is finished.
+ */
+static int ec_fsm_slave_sii_step(
+        ec_fsm_slave_t *fsm /**< Slave state machine. */
+        )
+{
+    ec_sii_write_request_t *request = fsm->sii_request;
+    ec_slave_t *slave = fsm->slave;
+    size_t count;
+
+    if (!ec_fsm_sii_success(&fsm->fsm_sii)) {
+        EC_SLAVE_ERR(slave, "Failed to %s SII data.\n",
+                fsm->sii_verifying ? "verify" : "write");
+        request->state = EC_INT_REQUEST_FAILURE;
+        return 0;
+    }
+
+    if (fsm->sii_verifying) {
+        count = min(fsm->fsm_sii.value_size / 2,
+                request->nwords - (size_t) fsm->sii_index);
+        if (memcmp(fsm->fsm_sii.value, request->words + fsm->sii_index,
+                    count * 2)) {
+            EC_SLAVE_ERR(slave, "SII verification failed at word"
+                    " 0x%04zx.\n", (size_t) request->offset + fsm->sii_index);
+            request->verify_error = 1;
+            request->state = EC_INT_REQUEST_FAILURE;
+            return 0;
+        }
+        fsm->sii_index += count;
+    } else {
+        fsm->sii_index++;
+        if (fsm->sii_index == request->nwords && request->verify) {
+            fsm->sii_verifying = 1;
+            fsm->sii_index = 0;
+        }
+    }
+
+    if (fsm->sii_index < request->nwords) {
+        if (fsm->sii_verifying) {
+            ec_fsm_sii_read(&fsm->fsm_sii, slave,
+                    request->offset + fsm->sii_index,
+                    EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+        } else {
+            ec_fsm_sii_write(&fsm->fsm_sii, slave,
+                    request->offset + fsm->sii_index,
+                    request->words + fsm->sii_index,
+                    EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+        }
+        return 1;
+    }
+
+    ec_fsm_slave_sii_written(fsm, request);
+    request->state = EC_INT_REQUEST_SUCCESS;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Slave state: SII_REQUEST.
+ *
+ * The SII state machine expects to send the same datagram again, so the
+ * previous datagram is continued in the new one first.
+ */
+void ec_fsm_slave_state_sii_request(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_sii_write_request_t *request = fsm->sii_request;
+
+    if (ec_datagram_repeat(datagram, fsm->datagram)) {
+        request->state = EC_INT_REQUEST_FAILURE;
+    } else {
+        fsm->fsm_sii.datagram = datagram;
+
+        while (1) {
+            if (ec_fsm_sii_exec(&fsm->fsm_sii)) {
+                return;
+            }
+
+            if (!ec_fsm_slave_sii_step(fsm)) {
+                break;
+            }
+        }
+    }
+
+    wake_up_all(&slave->master->request_queue);
+    fsm->sii_request = NULL;
+    fsm->state = ec_fsm_slave_state_ready;
+
+    // process the next SII write request back to back
+    ec_fsm_slave_action_process_sii(fsm, datagram);
+}
+
+/*****************************************************************************/
+
 /** Check for pending FoE requests and process one.
  *
  * \return non-zero, if an FoE request is processed.
@@ -443,18 +764,28 @@ int ec_fsm_slave_action_process_foe(
                 " slave has error flag set.\n");
         request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
+        ec_foe_request_notify(request);
         fsm->state = ec_fsm_slave_state_idle;
         return 1;
     }
 
+    if (!fsm->mbox) {
+        EC_SLAVE_ERR(slave, "Aborting FoE request,"
+                " slave does not support a mailbox protocol.\n");
+        request->state = EC_INT_REQUEST_FAILURE;
+        wake_up_all(&slave->master->request_queue);
+        ec_foe_request_notify(request);
+        return 1;
+    }
+
     request->state = EC_INT_REQUEST_BUSY;
     fsm->foe_request = request;
 
     EC_SLAVE_DBG(slave, 1, "Processing FoE request.\n");
 
     fsm->state = ec_fsm_slave_state_foe_request;
-    ec_fsm_foe_transfer(&fsm->fsm_foe, slave, request);
-    ec_fsm_foe_exec(&fsm->fsm_foe, datagram);
+    ec_fsm_foe_transfer(&fsm->mbox->fsm_foe, slave, request);
+    ec_fsm_foe_exec(&fsm->mbox->fsm_foe, datagram);
     return 1;
 }
 
@@ -470,15 +801,16 @@ void ec_fsm_slave_state_foe_request(
     ec_slave_t *slave = fsm->slave;
     ec_foe_request_t *request = fsm->foe_request;
 
-    if (ec_fsm_foe_exec(&fsm->fsm_foe, datagram)) {
+    if (ec_fsm_foe_exec(&fsm->mbox->fsm_foe, datagram)) {
         return;
     }
 
-    if (!ec_fsm_foe_success(&fsm->fsm_foe)) {
+    if (!ec_fsm_foe_success(&fsm->mbox->fsm_foe)) {
         EC_SLAVE_ERR(slave, "Failed to handle FoE request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
         wake_up_all(&slave->master->request_queue);
         fsm->foe_request = NULL;
+        ec_foe_request_notify(request);
         fsm->state = ec_fsm_slave_state_ready;
         return;
     }
@@ -490,6 +822,7 @@ void ec_fsm_slave_state_foe_request(
     request->state = EC_INT_REQUEST_SUCCESS;
     wake_up_all(&slave->master->request_queue);
     fsm->foe_request = NULL;
+    ec_foe_request_notify(request);
     fsm->state = ec_fsm_slave_state_ready;
 }
 
@@ -532,6 +865,14 @@ int ec_fsm_slave_action_process_soe(
         return 0;
     }
 
+    if (!fsm->mbox) {
+        EC_SLAVE_ERR(slave, "Aborting SoE request,"
+                " slave does not support a mailbox protocol.\n");
+        req->state = EC_INT_REQUEST_FAILURE;
+        wake_up_all(&slave->master->request_queue);
+        return 1;
+    }
+
     fsm->soe_request = req;
     req->state = EC_INT_REQUEST_BUSY;
 
@@ -540,8 +881,8 @@ int ec_fsm_slave_action_process_soe(
 
     // Start SoE transfer
     fsm->state = ec_fsm_slave_state_soe_request;
-    ec_fsm_soe_transfer(&fsm->fsm_soe, slave, req);
-    ec_fsm_soe_exec(&fsm->fsm_soe, datagram); // execute immediately
+    ec_fsm_soe_transfer(&fsm->mbox->fsm_soe, slave, req);
+    ec_fsm_soe_exec(&fsm->mbox->fsm_soe, datagram); // execute immediately
     return 1;
 }
 
@@ -557,26 +898,240 @@ void ec_fsm_slave_state_soe_request(
     ec_slave_t *slave = fsm->slave;
     ec_soe_request_t *request = fsm->soe_request;
 
-    if (ec_fsm_soe_exec(&fsm->fsm_soe, datagram)) {
+    if (ec_fsm_soe_exec(&fsm->mbox->fsm_soe, datagram)) {
         return;
     }
 
-    if (!ec_fsm_soe_success(&fsm->fsm_soe)) {
+    if (!ec_fsm_soe_success(&fsm->mbox->fsm_soe)) {
         EC_SLAVE_ERR(slave, "Failed to process SoE request.\n");
         request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&slave->master->request_queue);
-        fsm->soe_request = NULL;
-        fsm->state = ec_fsm_slave_state_ready;
+    } else {
+        EC_SLAVE_DBG(slave, 1, "Finished SoE request.\n");
+        request->state = EC_INT_REQUEST_SUCCESS;
+    }
+
+    wake_up_all(&slave->master->request_queue);
+    fsm->soe_request = NULL;
+    fsm->state = ec_fsm_slave_state_ready;
+
+    // Start the next queued SoE request at once, so that lists of IDNs are
+    // transferred back to back without giving up the datagram.
+    ec_fsm_slave_action_process_soe(fsm, datagram);
+}
+
+/*****************************************************************************/
+
+/** Check for pending SDO dictionary work and process it.
+ *
+ * Requested entry descriptions are fetched first. Otherwise, the SDO
+ * dictionary is fetched once, some time after the slave reached PREOP. If
+ * the dictionary cache contains the dictionary of the slave's type, it is
+ * used instead.
+ *
+ * \return non-zero, if the dictionary is being processed.
+ */
+int ec_fsm_slave_action_process_dict(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_sdo_entries_request_t *req;
+    ec_sdo_t *sdo;
+    ec_dict_t *dict;
+
+    while (!list_empty(&slave->dict_requests)) {
+        req = list_entry(slave->dict_requests.next,
+                ec_sdo_entries_request_t, list);
+        sdo = ec_slave_get_sdo(slave, req->index);
+
+        if (sdo && sdo->entries_busy) {
+            // another slave sharing the dictionary is fetching them
+            break;
+        }
+
+        list_del_init(&req->list); // dequeue
+
+        if (!sdo || !sdo->entries_pending) {
+            // nothing to fetch (any more)
+            req->state = EC_INT_REQUEST_SUCCESS;
+            wake_up_all(&slave->master->request_queue);
+            continue;
+        }
+
+        if (slave->current_state & EC_SLAVE_STATE_ACK_ERR) {
+            EC_SLAVE_WARN(slave, "Aborting SDO entry description request,"
+                    " slave has error flag set.\n");
+            req->state = EC_INT_REQUEST_FAILURE;
+            wake_up_all(&slave->master->request_queue);
+            fsm->state = ec_fsm_slave_state_idle;
+            return 1;
+        }
+
+        if (slave->current_state == EC_SLAVE_STATE_INIT) {
+            EC_SLAVE_WARN(slave, "Aborting SDO entry description request,"
+                    " slave is in INIT.\n");
+            req->state = EC_INT_REQUEST_FAILURE;
+            wake_up_all(&slave->master->request_queue);
+            fsm->state = ec_fsm_slave_state_idle;
+            return 1;
+        }
+
+        if (!fsm->mbox) {
+            req->state = EC_INT_REQUEST_FAILURE;
+            wake_up_all(&slave->master->request_queue);
+            continue;
+        }
+
+        fsm->dict_request = req;
+        req->state = EC_INT_REQUEST_BUSY;
+        sdo->entries_busy = 1;
+
+        EC_SLAVE_DBG(slave, 1, "Fetching entry descriptions of SDO 0x%04X.\n",
+                req->index);
+
+        fsm->state = ec_fsm_slave_state_dict_entries;
+        ec_fsm_coe_dict_entries(&fsm->mbox->fsm_coe, slave, sdo);
+        ec_fsm_coe_exec(&fsm->mbox->fsm_coe, datagram); // execute immediately
+        return 1;
+    }
+
+    if (!(slave->sii.mailbox_protocols & EC_MBOX_COE) || !fsm->mbox
+            || (slave->sii.has_general
+                && !slave->sii.coe_details.enable_sdo_info)
+            || slave->sdo_dictionary_fetched) {
+        return 0;
+    }
+
+    dict = ec_master_dict_cache_find(slave->master, slave->sii.vendor_id,
+            slave->sii.product_code, slave->sii.revision_number);
+    if (dict) {
+        if (dict->reader) {
+            // another slave of the same type is reading it
+            return 0;
+        }
+
+        EC_SLAVE_DBG(slave, 1, "Using cached SDO dictionary.\n");
+
+        slave->sdo_dictionary_fetched = 1;
+        slave->dict = dict;
+        dict->refs++;
+        ec_slave_attach_pdo_names(slave);
+        return 0;
+    }
+
+    if (slave->current_state == EC_SLAVE_STATE_INIT
+            || slave->current_state == EC_SLAVE_STATE_UNKNOWN
+            || slave->current_state & EC_SLAVE_STATE_ACK_ERR
+            || jiffies - slave->jiffies_preop < EC_WAIT_SDO_DICT * HZ) {
+        return 0;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Fetching SDO dictionary.\n");
+
+    slave->sdo_dictionary_fetched = 1;
+
+    if (!(dict = kmalloc(sizeof(ec_dict_t), GFP_KERNEL))) {
+        EC_SLAVE_ERR(slave, "Failed to allocate SDO dictionary!\n");
+        return 0;
+    }
+
+    ec_dict_init(dict, slave->sii.vendor_id, slave->sii.product_code,
+            slave->sii.revision_number);
+    dict->refs = 1;
+    slave->dict = dict;
+
+    if (ec_dict_cache) {
+        // share the dictionary with slaves of the same type
+        dict->reader = slave;
+        list_add_tail(&dict->list, &slave->master->dict_cache);
+    }
+
+    // start fetching SDO dictionary
+    fsm->state = ec_fsm_slave_state_dict;
+    ec_fsm_coe_dictionary(&fsm->mbox->fsm_coe, slave);
+    ec_fsm_coe_exec(&fsm->mbox->fsm_coe, datagram); // execute immediately
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Slave state: DICT_ENTRIES.
+ */
+void ec_fsm_slave_state_dict_entries(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_sdo_entries_request_t *request = fsm->dict_request;
+    ec_sdo_t *sdo;
+
+    if (ec_fsm_coe_exec(&fsm->mbox->fsm_coe, datagram)) {
         return;
     }
 
-    EC_SLAVE_DBG(slave, 1, "Finished SoE request.\n");
+    // do not try again on every access, if the slave refused
+    sdo = ec_slave_get_sdo(slave, request->index);
+    if (sdo) {
+        sdo->entries_pending = 0;
+        sdo->entries_busy = 0;
+    }
+
+    if (!ec_fsm_coe_success(&fsm->mbox->fsm_coe)) {
+        EC_SLAVE_ERR(slave, "Failed to fetch entry descriptions"
+                " of SDO 0x%04X.\n", request->index);
+        request->state = EC_INT_REQUEST_FAILURE;
+    } else {
+        EC_SLAVE_DBG(slave, 1, "Finished fetching entry descriptions.\n");
+        request->state = EC_INT_REQUEST_SUCCESS;
+    }
 
-    // SoE request finished
-    request->state = EC_INT_REQUEST_SUCCESS;
     wake_up_all(&slave->master->request_queue);
-    fsm->soe_request = NULL;
+    fsm->dict_request = NULL;
     fsm->state = ec_fsm_slave_state_ready;
 }
 
 /*****************************************************************************/
+
+/** Slave state: DICT.
+ */
+void ec_fsm_slave_state_dict(
+        ec_fsm_slave_t *fsm, /**< Slave state machine. */
+        ec_datagram_t *datagram /**< Datagram to use. */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (ec_fsm_coe_exec(&fsm->mbox->fsm_coe, datagram)) {
+        return;
+    }
+
+    fsm->state = ec_fsm_slave_state_ready;
+
+    if (slave->dict->reader == slave) {
+        slave->dict->reader = NULL;
+        if (!ec_fsm_coe_success(&fsm->mbox->fsm_coe)) {
+            // do not share an incomplete dictionary
+            list_del_init(&slave->dict->list);
+        }
+    }
+
+    if (!ec_fsm_coe_success(&fsm->mbox->fsm_coe)) {
+        return;
+    }
+
+    // SDO dictionary fetching finished
+
+    if (slave->master->debug_level) {
+        unsigned int sdo_count, entry_count;
+        ec_slave_sdo_dict_info(slave, &sdo_count, &entry_count);
+        EC_SLAVE_DBG(slave, 1, "Fetched %u SDOs and %u entries.\n",
+               sdo_count, entry_count);
+    }
+
+    // attach pdo names from dictionary
+    ec_slave_attach_pdo_names(slave);
+}
+
+/*****************************************************************************/
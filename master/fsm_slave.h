@@ -41,31 +41,69 @@
 #include "datagram.h"
 #include "sdo_request.h"
 #include "reg_request.h"
+#include "sdo.h"
 #include "fsm_coe.h"
 #include "fsm_foe.h"
 #include "fsm_soe.h"
+#include "fsm_sii.h"
+
+/*****************************************************************************/
+
+/** SII write request.
+ */
+typedef struct {
+    struct list_head list; /**< List head. */
+    ec_slave_t *slave; /**< EtherCAT slave. */
+    uint16_t offset; /**< SII word offset. */
+    size_t nwords; /**< Number of words. */
+    const uint16_t *words; /**< Pointer to the data words. */
+    int verify; /**< Read the words back after writing. */
+    int verify_error; /**< The words read back differ from the written
+                        ones. */
+    ec_internal_request_state_t state; /**< State of the request. */
+} ec_sii_write_request_t;
 
 /*****************************************************************************/
 
 typedef struct ec_fsm_slave ec_fsm_slave_t; /**< \see ec_fsm_slave */
 
+/** Mailbox state machines of an EtherCAT slave.
+ *
+ * Only allocated for slaves supporting a mailbox protocol, so that slaves
+ * without mailbox do not carry them.
+ */
+typedef struct {
+    ec_fsm_coe_t fsm_coe; /**< CoE state machine. */
+    ec_fsm_foe_t fsm_foe; /**< FoE state machine. */
+    ec_fsm_soe_t fsm_soe; /**< SoE state machine. */
+} ec_fsm_slave_mbox_t;
+
 /** Finite state machine of an EtherCAT slave.
  */
 struct ec_fsm_slave {
     ec_slave_t *slave; /**< slave the FSM runs on */
     struct list_head list; /**< Used for execution list. */
+    struct list_head ready; /**< Used for the master's list of ready FSMs
+                              with new requests. */
 
     void (*state)(ec_fsm_slave_t *, ec_datagram_t *); /**< State function. */
     ec_datagram_t *datagram; /**< Previous state datagram. */
     ec_sdo_request_t *sdo_request; /**< SDO request to process. */
     ec_reg_request_t *reg_request; /**< Register request to process. */
+    ec_sii_write_request_t *sii_request; /**< SII write request to
+                                           process. */
+    off_t sii_index; /**< Index of the SII word in progress. */
+    int sii_verifying; /**< The written SII words are read back. */
+    ec_fsm_sii_t fsm_sii; /**< SII state machine. */
     ec_foe_request_t *foe_request; /**< FoE request to process. */
     off_t foe_index; /**< Index to FoE write request data. */
     ec_soe_request_t *soe_request; /**< SoE request to process. */
+    ec_sdo_entries_request_t *dict_request; /**< SDO entry description
+                                              request to process. */
 
-    ec_fsm_coe_t fsm_coe; /**< CoE state machine. */
-    ec_fsm_foe_t fsm_foe; /**< FoE state machine. */
-    ec_fsm_soe_t fsm_soe; /**< SoE state machine. */
+    ec_fsm_slave_mbox_t *mbox; /**< Mailbox state machines, or NULL, if the
+                                 slave does not support a mailbox
+                                 protocol. */
 };
 
 /*****************************************************************************/
@@ -62,11 +62,15 @@
 /*****************************************************************************/
 
 void ec_fsm_slave_config_state_start(ec_fsm_slave_config_t *);
+void ec_fsm_slave_config_state_start_op(ec_fsm_slave_config_t *);
+void ec_fsm_slave_config_state_keep_preop(ec_fsm_slave_config_t *);
+void ec_fsm_slave_config_state_keep_dc_clear(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_init(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_clear_fmmus(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_clear_sync(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_dc_clear_assign(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_mbox_sync(ec_fsm_slave_config_t *);
+void ec_fsm_slave_config_state_mbox_status(ec_fsm_slave_config_t *);
 #ifdef EC_SII_ASSIGN
 void ec_fsm_slave_config_state_assign_pdi(ec_fsm_slave_config_t *);
 #endif
@@ -89,10 +93,12 @@ void ec_fsm_slave_config_state_safeop(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_soe_conf_safeop(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_op(ec_fsm_slave_config_t *);
 
+void ec_fsm_slave_config_enter_keep_preop(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_init(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_clear_sync(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_dc_clear_assign(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_mbox_sync(ec_fsm_slave_config_t *);
+void ec_fsm_slave_config_enter_mbox_status(ec_fsm_slave_config_t *);
 #ifdef EC_SII_ASSIGN
 void ec_fsm_slave_config_enter_assign_pdi(ec_fsm_slave_config_t *);
 #endif
@@ -108,6 +114,7 @@ void ec_fsm_slave_config_enter_dc_cycle(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_safeop(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_soe_conf_safeop(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_enter_op(ec_fsm_slave_config_t *);
+void ec_fsm_slave_config_request_op(ec_fsm_slave_config_t *);
 
 void ec_fsm_slave_config_state_end(ec_fsm_slave_config_t *);
 void ec_fsm_slave_config_state_error(ec_fsm_slave_config_t *);
@@ -116,6 +123,19 @@ void ec_fsm_slave_config_reconfigure(ec_fsm_slave_config_t *);
 
 /*****************************************************************************/
 
+/** Starts a phase of the startup profile.
+ */
+static void ec_fsm_slave_config_phase(
+        ec_fsm_slave_config_t *fsm, /**< slave state machine */
+        ec_startup_phase_t phase /**< Phase to start. */
+        )
+{
+    ec_startup_timer_start(&fsm->slave->master->startup_profile,
+            &fsm->timer, phase, fsm->slave->ring_position);
+}
+
+/*****************************************************************************/
+
 /** Constructor.
  */
 void ec_fsm_slave_config_init(
@@ -129,12 +149,15 @@ void ec_fsm_slave_config_init(
 {
     ec_sdo_request_init(&fsm->request_copy);
     ec_soe_request_init(&fsm->soe_request_copy);
+    fsm->request_first = NULL;
+    fsm->sdo_coalesce = 0;
 
     fsm->datagram = datagram;
     fsm->fsm_change = fsm_change;
     fsm->fsm_coe = fsm_coe;
     fsm->fsm_soe = fsm_soe;
     fsm->fsm_pdo = fsm_pdo;
+    ec_startup_timer_init(&fsm->timer);
 }
 
 /*****************************************************************************/
@@ -158,8 +181,33 @@ void ec_fsm_slave_config_start(
         ec_slave_t *slave /**< slave to configure */
         )
 {
+    // a configuration, that is still running, was aborted
+    ec_startup_timer_stop(&slave->master->startup_profile, &fsm->timer, 1);
+
+    // the configuration uses the mailbox with its own datagrams
+    slave->mbox_data_active = 0;
+
     fsm->slave = slave;
     fsm->state = ec_fsm_slave_config_state_start;
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_INIT);
+}
+
+/*****************************************************************************/
+
+/** Start the transition of a configured slave from SAFEOP to OP.
+ *
+ * Used for slaves that waited for a grouped OP request in vain.
+ */
+void ec_fsm_slave_config_start_op(
+        ec_fsm_slave_config_t *fsm, /**< slave state machine */
+        ec_slave_t *slave /**< slave to bring to OP */
+        )
+{
+    ec_startup_timer_stop(&slave->master->startup_profile, &fsm->timer, 1);
+
+    fsm->slave = slave;
+    fsm->state = ec_fsm_slave_config_state_start_op;
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_OP);
 }
 
 /*****************************************************************************/
@@ -195,7 +243,14 @@ int ec_fsm_slave_config_exec(
     }
 
     fsm->state(fsm);
-    return ec_fsm_slave_config_running(fsm);
+
+    if (!ec_fsm_slave_config_running(fsm)) {
+        ec_startup_timer_stop(&fsm->slave->master->startup_profile,
+                &fsm->timer, fsm->state == ec_fsm_slave_config_state_error);
+        return 0;
+    }
+
+    return 1;
 }
 
 /*****************************************************************************/
@@ -220,18 +275,148 @@ void ec_fsm_slave_config_state_start(
         ec_fsm_slave_config_t *fsm /**< slave state machine */
         )
 {
-    EC_SLAVE_DBG(fsm->slave, 1, "Configuring...\n");
+    ec_slave_t *slave = fsm->slave;
+
+    if (ec_handover && slave->config_applied && slave->config
+            && slave->current_state == EC_SLAVE_STATE_SAFEOP
+            && slave->requested_state == EC_SLAVE_STATE_OP
+            && ec_slave_config_fingerprint(slave->config)
+            == slave->config_fingerprint) {
+        EC_SLAVE_DBG(slave, 1, "Taking over the configuration.\n");
+        ec_fsm_slave_config_request_op(fsm);
+        return;
+    }
+
+    if ((ec_reuse_config || ec_handover) && slave->config_applied) {
+        if (!slave->config
+                && slave->requested_state == EC_SLAVE_STATE_PREOP
+                && (slave->current_state == EC_SLAVE_STATE_SAFEOP
+                    || slave->current_state == EC_SLAVE_STATE_OP)) {
+            ec_fsm_slave_config_enter_keep_preop(fsm);
+            return;
+        }
+
+        if (slave->config
+                && slave->current_state == EC_SLAVE_STATE_PREOP
+                && (slave->requested_state == EC_SLAVE_STATE_SAFEOP
+                    || slave->requested_state == EC_SLAVE_STATE_OP)
+                && ec_slave_config_fingerprint(slave->config)
+                == slave->config_fingerprint) {
+            EC_SLAVE_DBG(slave, 1, "Configuration unchanged.\n");
+            ec_fsm_slave_config_enter_dc_cycle(fsm);
+            return;
+        }
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Configuring...\n");
     ec_fsm_slave_config_enter_init(fsm);
 }
 
 /*****************************************************************************/
 
+/** Bring the slave to PREOP without clearing the applied configuration.
+ *
+ * This is used, when the application releases the slave, so that an
+ * unchanged configuration does not have to be applied again.
+ */
+void ec_fsm_slave_config_enter_keep_preop(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    EC_SLAVE_DBG(fsm->slave, 1, "Going to PREOP,"
+            " keeping the applied configuration.\n");
+
+    fsm->state = ec_fsm_slave_config_state_keep_preop;
+    ec_fsm_change_start(fsm->fsm_change, fsm->slave, EC_SLAVE_STATE_PREOP);
+    ec_fsm_change_exec(fsm->fsm_change); // execute immediately
+}
+
+/*****************************************************************************/
+
+/** Slave configuration state: KEEP PREOP.
+ */
+void ec_fsm_slave_config_state_keep_preop(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_datagram_t *datagram = fsm->datagram;
+
+    if (ec_fsm_change_exec(fsm->fsm_change)) return;
+
+    if (!ec_fsm_change_success(fsm->fsm_change)) {
+        if (!fsm->fsm_change->spontaneous_change)
+            slave->error_flag = 1;
+        fsm->state = ec_fsm_slave_config_state_error;
+        return;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Now in PREOP.\n");
+
+    if (!slave->base_dc_supported || !slave->has_dc_system_time) {
+        fsm->state = ec_fsm_slave_config_state_end; // successful
+        return;
+    }
+
+    // the sync signals are activated again with the next configuration
+    EC_SLAVE_DBG(slave, 1, "Clearing DC assignment...\n");
+
+    ec_datagram_fpwr(datagram, slave->station_address, 0x0980, 2);
+    ec_datagram_zero(datagram);
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_slave_config_state_keep_dc_clear;
+}
+
+/*****************************************************************************/
+
+/** Slave configuration state: KEEP DC CLEAR.
+ */
+void ec_fsm_slave_config_state_keep_dc_clear(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_datagram_t *datagram = fsm->datagram;
+
+    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
+        return;
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        fsm->state = ec_fsm_slave_config_state_error;
+        EC_SLAVE_ERR(fsm->slave, "Failed receive DC assignment"
+                " clearing datagram.\n");
+        return;
+    }
+
+    if (datagram->working_counter != 1) {
+        // clearing the DC assignment does not succeed on simple slaves
+        EC_SLAVE_DBG(fsm->slave, 1, "Failed to clear DC assignment: ");
+        ec_datagram_print_wc_error(datagram);
+    }
+
+    fsm->state = ec_fsm_slave_config_state_end; // successful
+}
+
+/*****************************************************************************/
+
+/** Slave configuration state: START OP.
+ */
+void ec_fsm_slave_config_state_start_op(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    EC_SLAVE_DBG(fsm->slave, 1, "Requesting OP without grouping.\n");
+    ec_fsm_slave_config_request_op(fsm);
+}
+
+/*****************************************************************************/
+
 /** Start state change to INIT.
  */
 void ec_fsm_slave_config_enter_init(
         ec_fsm_slave_config_t *fsm /**< slave state machine */
         )
 {
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_INIT);
     ec_fsm_change_start(fsm->fsm_change, fsm->slave, EC_SLAVE_STATE_INIT);
     ec_fsm_change_exec(fsm->fsm_change);
     fsm->state = ec_fsm_slave_config_state_init;
@@ -259,6 +444,12 @@ void ec_fsm_slave_config_state_init(
 
     EC_SLAVE_DBG(slave, 1, "Now in INIT.\n");
 
+    slave->al_status_mapped = 0;
+    slave->mbox_status_mapped = 0;
+    slave->mbox_data_mapped = 0;
+    slave->group_op = 0;
+    slave->config_applied = 0;
+
     if (!slave->base_fmmu_count) { // skip FMMU configuration
         ec_fsm_slave_config_enter_clear_sync(fsm);
         return;
@@ -430,6 +621,8 @@ void ec_fsm_slave_config_enter_mbox_sync(
     ec_datagram_t *datagram = fsm->datagram;
     unsigned int i;
 
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_PREOP);
+
     // slave is now in INIT
     if (slave->current_state == slave->requested_state) {
         fsm->state = ec_fsm_slave_config_state_end; // successful
@@ -542,6 +735,9 @@ void ec_fsm_slave_config_enter_mbox_sync(
             slave->sii.std_tx_mailbox_size;
     }
 
+    // the sync manager configuration clears the repeat request bit
+    slave->mbox_repeat_toggle = 0;
+
     fsm->take_time = 1;
 
     fsm->retries = EC_FSM_RETRIES;
@@ -608,6 +804,160 @@ void ec_fsm_slave_config_state_mbox_sync(
         return;
     }
 
+    ec_fsm_slave_config_enter_mbox_status(fsm);
+}
+
+/*****************************************************************************/
+
+/** Writes an FMMU configuration page, that maps the status register of the
+ * send mailbox sync manager to the mailbox status area.
+ */
+static void ec_fsm_slave_config_mbox_status_page(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        uint8_t *data /**< FMMU configuration page. */
+        )
+{
+    EC_WRITE_U32(data, EC_MBOX_STATUS_LOGICAL_BASE
+            + slave->station_address - 1);
+    EC_WRITE_U16(data + 4,  1); // size of fmmu
+    EC_WRITE_U8 (data + 6,  0x00); // logical start bit
+    EC_WRITE_U8 (data + 7,  0x07); // logical end bit
+    EC_WRITE_U16(data + 8,  0x080D); // SM1 status register
+    EC_WRITE_U8 (data + 10, 0x00); // physical start bit
+    EC_WRITE_U8 (data + 11, 0x01); // read access
+    EC_WRITE_U16(data + 12, 0x0001); // enable
+}
+
+/*****************************************************************************/
+
+/** Prepares the mapping of the send mailbox to the mailbox data area.
+ *
+ * Calculates the offset of the send mailbox in the area and allocates the
+ * buffer for the responses read via the area.
+ *
+ * \return Non-zero, if the send mailbox can be mapped.
+ */
+static int ec_fsm_slave_config_prepare_mbox_data(
+        ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    const ec_slave_t *s;
+    size_t size = slave->configured_tx_mailbox_size;
+    u32 offset = 0;
+
+    if (!ec_mbox_data_fmmu || !size
+            || size != slave->sii.std_tx_mailbox_size) {
+        return 0; // not in BOOT state, where the mailbox sizes differ
+    }
+
+    for (s = slave->master->slaves; s < slave; s++) {
+        offset += s->sii.std_tx_mailbox_size;
+    }
+
+    if (offset + size > EC_MBOX_DATA_AREA_SIZE) {
+        return 0;
+    }
+
+    if (slave->mbox_stash_size != size) {
+        if (slave->mbox_stash) {
+            kfree(slave->mbox_stash);
+        }
+        slave->mbox_stash_size = 0;
+        if (!(slave->mbox_stash = kmalloc(size, GFP_KERNEL))) {
+            EC_SLAVE_WARN(slave, "Failed to allocate mailbox stash.\n");
+            return 0;
+        }
+        slave->mbox_stash_size = size;
+    }
+
+    slave->mbox_data_offset = offset;
+    slave->mbox_stash_valid = 0;
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Writes an FMMU configuration page, that maps the send mailbox to the
+ * mailbox data area.
+ */
+static void ec_fsm_slave_config_mbox_data_page(
+        const ec_slave_t *slave, /**< EtherCAT slave. */
+        uint8_t *data /**< FMMU configuration page. */
+        )
+{
+    EC_WRITE_U32(data, EC_MBOX_DATA_LOGICAL_BASE + slave->mbox_data_offset);
+    EC_WRITE_U16(data + 4,  slave->configured_tx_mailbox_size);
+    EC_WRITE_U8 (data + 6,  0x00); // logical start bit
+    EC_WRITE_U8 (data + 7,  0x07); // logical end bit
+    EC_WRITE_U16(data + 8,  slave->configured_tx_mailbox_offset);
+    EC_WRITE_U8 (data + 10, 0x00); // physical start bit
+    EC_WRITE_U8 (data + 11, 0x01); // read access
+    EC_WRITE_U16(data + 12, 0x0001); // enable
+}
+
+/*****************************************************************************/
+
+/** Map the mailbox status to the mailbox status area.
+ *
+ * The second to last FMMU is used, because the last one is reserved for the
+ * AL status.
+ */
+void ec_fsm_slave_config_enter_mbox_status(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_datagram_t *datagram = fsm->datagram;
+
+    if (!ec_mbox_status_fmmu
+            || slave->requested_state == EC_SLAVE_STATE_BOOT
+            || slave->base_fmmu_count < 2
+            || slave->station_address > EC_MBOX_STATUS_MAX_SLAVES) {
+#ifdef EC_SII_ASSIGN
+        ec_fsm_slave_config_enter_assign_pdi(fsm);
+#else
+        ec_fsm_slave_config_enter_boot_preop(fsm);
+#endif
+        return;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Mapping mailbox status...\n");
+
+    ec_datagram_fpwr(datagram, slave->station_address,
+            0x0600 + EC_FMMU_PAGE_SIZE * (slave->base_fmmu_count - 2),
+            EC_FMMU_PAGE_SIZE);
+    ec_datagram_zero(datagram);
+    ec_fsm_slave_config_mbox_status_page(slave, datagram->data);
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_slave_config_state_mbox_status;
+}
+
+/*****************************************************************************/
+
+/** Slave configuration state: MBOX STATUS.
+ */
+void ec_fsm_slave_config_state_mbox_status(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_datagram_t *datagram = fsm->datagram;
+    ec_slave_t *slave = fsm->slave;
+
+    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--) {
+        return;
+    }
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        EC_SLAVE_WARN(slave, "Failed to receive mailbox status"
+                " mapping datagram: ");
+        ec_datagram_print_state(datagram);
+    } else if (datagram->working_counter != 1) {
+        EC_SLAVE_WARN(slave, "Failed to map mailbox status: ");
+        ec_datagram_print_wc_error(datagram);
+    } else {
+        slave->mbox_status_mapped = 1;
+    }
+
 #ifdef EC_SII_ASSIGN
     ec_fsm_slave_config_enter_assign_pdi(fsm);
 #else
@@ -781,6 +1131,174 @@ cont_sdo_conf:
 
 /*****************************************************************************/
 
+/** Returns the SDO configuration following \a req, or NULL.
+ */
+static ec_sdo_request_t *ec_fsm_slave_config_next_sdo(
+        const ec_fsm_slave_config_t *fsm, /**< slave state machine */
+        const ec_sdo_request_t *req /**< SDO configuration. */
+        )
+{
+    if (req->list.next == &fsm->slave->config->sdo_configs) {
+        return NULL;
+    }
+
+    return list_entry(req->list.next, ec_sdo_request_t, list);
+}
+
+/*****************************************************************************/
+
+/** Returns the size of an SDO entry for a CompleteAccess download.
+ *
+ * The entries of the PDO mapping and assignment objects have fixed sizes.
+ * For other objects, the size is taken from the SDO dictionary, if the
+ * entry descriptions have already been fetched.
+ *
+ * 
+eturn Size in bytes, or zero, if it is not known.
+ */
+static size_t ec_fsm_slave_config_entry_size(
+        ec_slave_t *slave, /**< EtherCAT slave. */
+        uint16_t index, /**< SDO index. */
+        uint8_t subindex /**< SDO subindex. */
+        )
+{
+    ec_sdo_t *sdo;
+    const ec_sdo_entry_t *entry;
+
+    if ((index >= 0x1600 && index < 0x1800)
+            || (index >= 0x1A00 && index < 0x1C00)) {
+        return 4; // mapped PDO entry
+    }
+
+    if (index >= 0x1C10 && index < 0x1C10 + EC_MAX_SYNC_MANAGERS) {
+        return 2; // assigned PDO
+    }
+
+    if (!(sdo = ec_slave_get_sdo(slave, index)) || sdo->entries_pending
+            || !(entry = ec_sdo_get_entry_const(sdo, subindex))
+            || entry->bit_length % 8) {
+        return 0;
+    }
+
+    return entry->bit_length / 8;
+}
+
+/*****************************************************************************/
+
+/** Checks, if an SDO configuration sets the number of entries of an object.
+ *
+ * 
+eturn Non-zero, if \a req writes \a count to subindex 0 of \a index.
+ */
+static int ec_fsm_slave_config_sdo_sets_count(
+        const ec_sdo_request_t *req, /**< SDO configuration, or NULL. */
+        uint16_t index, /**< SDO index. */
+        uint8_t count /**< Number of entries. */
+        )
+{
+    return req && req->index == index && !req->complete_access
+        && req->subindex == 0 && req->data_size == 1
+        && EC_READ_U8(req->data) == count;
+}
+
+/*****************************************************************************/
+
+/** Tries to coalesce SDO configurations into a CompleteAccess download.
+ *
+ * Detects the usual sequence to write an object with a variable number of
+ * entries, starting at \a fsm->request: An optional download of zero to
+ * subindex 0, downloads of subindex 1 to N in order, and finally the download
+ * of N to subindex 0. If the slave supports CompleteAccess and the entry
+ * sizes are known, the data of the sequence are merged into \a
+ * fsm->request_copy. Subindex 0 is padded to 16 bit, as for
+ * ecrt_slave_config_complete_sdo().
+ *
+ * 
+eturn Last SDO configuration of the sequence, or NULL.
+ */
+static ec_sdo_request_t *ec_fsm_slave_config_coalesce_sdos(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    ec_sdo_request_t *req = fsm->request, *first_entry;
+    uint16_t index = req->index;
+    unsigned int count = 0, i;
+    size_t size = 2;
+    uint8_t *data;
+
+    if (!fsm->sdo_coalesce || !slave->sii.has_general
+            || !slave->sii.coe_details.enable_sdo_complete_access) {
+        return NULL;
+    }
+
+    if (ec_fsm_slave_config_sdo_sets_count(req, index, 0)) {
+        req = ec_fsm_slave_config_next_sdo(fsm, req);
+    }
+    first_entry = req;
+
+    while (req && req->index == index && !req->complete_access
+            && req->subindex == count + 1 && count < 0xff
+            && req->data_size == ec_fsm_slave_config_entry_size(slave,
+                index, req->subindex)) {
+        size += req->data_size;
+        count++;
+        req = ec_fsm_slave_config_next_sdo(fsm, req);
+    }
+
+    if (!count || !ec_fsm_slave_config_sdo_sets_count(req, index, count)) {
+        return NULL;
+    }
+
+    if (ec_sdo_request_alloc(&fsm->request_copy, size)) {
+        return NULL;
+    }
+
+    data = fsm->request_copy.data;
+    EC_WRITE_U8(data++, count);
+    EC_WRITE_U8(data++, 0x00); // padding
+    for (i = 0; i < count; i++) {
+        memcpy(data, first_entry->data, first_entry->data_size);
+        data += first_entry->data_size;
+        first_entry = list_entry(first_entry->list.next,
+                ec_sdo_request_t, list);
+    }
+
+    ecrt_sdo_request_index_complete(&fsm->request_copy, index);
+    fsm->request_copy.data_size = size;
+    return req;
+}
+
+/*****************************************************************************/
+
+/** Starts downloading the SDO configuration \a fsm->request.
+ *
+ * If it begins a sequence, that can be coalesced, the whole sequence is
+ * downloaded at once and \a fsm->request is advanced to its end.
+ */
+static void ec_fsm_slave_config_start_sdo_conf(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_sdo_request_t *last = ec_fsm_slave_config_coalesce_sdos(fsm);
+
+    if (last) {
+        EC_SLAVE_DBG(fsm->slave, 1, "Downloading SDO 0x%04X"
+                " via CompleteAccess.\n", fsm->request->index);
+        fsm->request_first = fsm->request;
+        fsm->request = last;
+    } else {
+        fsm->request_first = NULL;
+        ec_sdo_request_copy(&fsm->request_copy, fsm->request);
+    }
+
+    ecrt_sdo_request_write(&fsm->request_copy);
+    ec_fsm_coe_transfer(fsm->fsm_coe, fsm->slave, &fsm->request_copy);
+    ec_fsm_coe_exec(fsm->fsm_coe, fsm->datagram); // execute immediately
+}
+
+/*****************************************************************************/
+
 /** Check for SDO configurations to be applied.
  */
 void ec_fsm_slave_config_enter_sdo_conf(
@@ -794,6 +1312,8 @@ void ec_fsm_slave_config_enter_sdo_conf(
         return;
     }
 
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_SDO);
+
     // No CoE configuration to be applied?
     if (list_empty(&slave->config->sdo_configs)) { // skip SDO configuration
         ec_fsm_slave_config_enter_soe_conf_preop(fsm);
@@ -802,12 +1322,10 @@ void ec_fsm_slave_config_enter_sdo_conf(
 
     // start SDO configuration
     fsm->state = ec_fsm_slave_config_state_sdo_conf;
+    fsm->sdo_coalesce = 1;
     fsm->request = list_entry(fsm->slave->config->sdo_configs.next,
             ec_sdo_request_t, list);
-    ec_sdo_request_copy(&fsm->request_copy, fsm->request);
-    ecrt_sdo_request_write(&fsm->request_copy);
-    ec_fsm_coe_transfer(fsm->fsm_coe, fsm->slave, &fsm->request_copy);
-    ec_fsm_coe_exec(fsm->fsm_coe, fsm->datagram); // execute immediately
+    ec_fsm_slave_config_start_sdo_conf(fsm);
 }
 
 /*****************************************************************************/
@@ -823,6 +1341,17 @@ void ec_fsm_slave_config_state_sdo_conf(
     }
 
     if (!ec_fsm_coe_success(fsm->fsm_coe)) {
+        if (fsm->request_first && fsm->slave->config) {
+            // download the coalesced SDO configurations one by one
+            EC_SLAVE_DBG(fsm->slave, 1, "CompleteAccess download of"
+                    " SDO 0x%04X failed. Retrying without.\n",
+                    fsm->request->index);
+            fsm->sdo_coalesce = 0;
+            fsm->request = fsm->request_first;
+            ec_fsm_slave_config_start_sdo_conf(fsm);
+            return;
+        }
+
         EC_SLAVE_ERR(fsm->slave, "SDO configuration failed.\n");
         fsm->slave->error_flag = 1;
         fsm->state = ec_fsm_slave_config_state_error;
@@ -838,10 +1367,7 @@ void ec_fsm_slave_config_state_sdo_conf(
     if (fsm->request->list.next != &fsm->slave->config->sdo_configs) {
         fsm->request = list_entry(fsm->request->list.next,
                 ec_sdo_request_t, list);
-        ec_sdo_request_copy(&fsm->request_copy, fsm->request);
-        ecrt_sdo_request_write(&fsm->request_copy);
-        ec_fsm_coe_transfer(fsm->fsm_coe, fsm->slave, &fsm->request_copy);
-        ec_fsm_coe_exec(fsm->fsm_coe, fsm->datagram); // execute immediately
+        ec_fsm_slave_config_start_sdo_conf(fsm);
         return;
     }
 
@@ -935,6 +1461,8 @@ void ec_fsm_slave_config_enter_pdo_conf(
         ec_fsm_slave_config_t *fsm /**< slave state machine */
         )
 {
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_PDO);
+
     // Start configuring PDOs
     ec_fsm_pdo_start_configuration(fsm->fsm_pdo, fsm->slave);
     fsm->state = ec_fsm_slave_config_state_pdo_conf;
@@ -1095,6 +1623,8 @@ void ec_fsm_slave_config_enter_pdo_sync(
     unsigned int i, j, offset, num_pdo_syncs;
     uint8_t sync_index;
     const ec_sync_t *sync;
+
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_PDO);
     uint16_t size;
 
     if (slave->sii.mailbox_protocols) {
@@ -1222,7 +1752,9 @@ void ec_fsm_slave_config_enter_fmmu(
     ec_datagram_zero(datagram);
     for (i = 0; i < slave->config->used_fmmus; i++) {
         fmmu = &slave->config->fmmu_configs[i];
-        if (!(sync = ec_slave_get_sync(slave, fmmu->sync_index))) {
+        if (fmmu->sync_index == EC_FMMU_NO_SYNC) {
+            sync = NULL; // register mapping
+        } else if (!(sync = ec_slave_get_sync(slave, fmmu->sync_index))) {
             slave->error_flag = 1;
             fsm->state = ec_fsm_slave_config_state_error;
             EC_SLAVE_ERR(slave, "Failed to determine PDO sync manager"
@@ -1233,6 +1765,46 @@ void ec_fsm_slave_config_enter_fmmu(
                 datagram->data + EC_FMMU_PAGE_SIZE * i);
     }
 
+    if (ec_al_status_fmmu
+            && slave->config->used_fmmus < slave->base_fmmu_count
+            && slave->station_address <= EC_AL_STATUS_MAX_SLAVES) {
+        // map the AL status to the AL status area using the last FMMU
+        uint8_t *data = datagram->data
+            + EC_FMMU_PAGE_SIZE * (slave->base_fmmu_count - 1);
+        EC_WRITE_U32(data, EC_AL_STATUS_LOGICAL_BASE
+                + slave->station_address - 1);
+        EC_WRITE_U16(data + 4,  1); // size of fmmu
+        EC_WRITE_U8 (data + 6,  0x00); // logical start bit
+        EC_WRITE_U8 (data + 7,  0x07); // logical end bit
+        EC_WRITE_U16(data + 8,  0x0130); // AL status register
+        EC_WRITE_U8 (data + 10, 0x00); // physical start bit
+        EC_WRITE_U8 (data + 11, 0x01); // read access
+        EC_WRITE_U16(data + 12, 0x0001); // enable
+        fsm->al_status_fmmu = 1;
+    } else {
+        fsm->al_status_fmmu = 0;
+    }
+
+    if (slave->mbox_status_mapped
+            && slave->config->used_fmmus + 1 < slave->base_fmmu_count) {
+        // keep the mailbox status mapping of the second to last FMMU
+        ec_fsm_slave_config_mbox_status_page(slave, datagram->data
+                + EC_FMMU_PAGE_SIZE * (slave->base_fmmu_count - 2));
+        fsm->mbox_status_fmmu = 1;
+    } else {
+        slave->mbox_status_mapped = 0;
+        fsm->mbox_status_fmmu = 0;
+    }
+
+    fsm->mbox_data_fmmu = fsm->mbox_status_fmmu
+        && slave->config->used_fmmus + 2 < slave->base_fmmu_count
+        && ec_fsm_slave_config_prepare_mbox_data(slave);
+    if (fsm->mbox_data_fmmu) {
+        // map the send mailbox to the mailbox data area
+        ec_fsm_slave_config_mbox_data_page(slave, datagram->data
+                + EC_FMMU_PAGE_SIZE * (slave->base_fmmu_count - 3));
+    }
+
     fsm->retries = EC_FSM_RETRIES;
     fsm->state = ec_fsm_slave_config_state_fmmu;
 }
@@ -1266,6 +1838,10 @@ void ec_fsm_slave_config_state_fmmu(
         return;
     }
 
+    slave->al_status_mapped = fsm->al_status_fmmu;
+    slave->mbox_status_mapped = fsm->mbox_status_fmmu;
+    slave->mbox_data_mapped = fsm->mbox_data_fmmu;
+
     ec_fsm_slave_config_enter_dc_cycle(fsm);
 }
 
@@ -1281,6 +1857,8 @@ void ec_fsm_slave_config_enter_dc_cycle(
     ec_slave_t *slave = fsm->slave;
     ec_slave_config_t *config = slave->config;
 
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_DC);
+
     if (!config) { // config removed in the meantime
         ec_fsm_slave_config_reconfigure(fsm);
         return;
@@ -1536,6 +2114,7 @@ void ec_fsm_slave_config_enter_safeop(
         ec_fsm_slave_config_t *fsm /**< slave state machine */
         )
 {
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_SAFEOP);
     fsm->state = ec_fsm_slave_config_state_safeop;
     ec_fsm_change_start(fsm->fsm_change, fsm->slave, EC_SLAVE_STATE_SAFEOP);
     ec_fsm_change_exec(fsm->fsm_change); // execute immediately
@@ -1564,6 +2143,12 @@ void ec_fsm_slave_config_state_safeop(
 
     EC_SLAVE_DBG(slave, 1, "Now in SAFEOP.\n");
 
+    if (slave->config) {
+        slave->config_fingerprint =
+            ec_slave_config_fingerprint(slave->config);
+        slave->config_applied = 1;
+    }
+
     if (fsm->slave->current_state == fsm->slave->requested_state) {
         fsm->state = ec_fsm_slave_config_state_end; // successful
         EC_SLAVE_DBG(slave, 1, "Finished configuration.\n");
@@ -1654,11 +2239,38 @@ void ec_fsm_slave_config_state_soe_conf_safeop(
 /*****************************************************************************/
 
 /** Bring slave to OP.
+ *
+ * If grouped OP requests are enabled and the AL status of the slave is
+ * mapped, the configuration ends in SAFEOP and the master state machine
+ * requests OP for all waiting slaves at once.
  */
 void ec_fsm_slave_config_enter_op(
         ec_fsm_slave_config_t *fsm /**< slave state machine */
         )
 {
+    ec_slave_t *slave = fsm->slave;
+
+    if (ec_group_op && slave->al_status_mapped
+            && slave->requested_state == EC_SLAVE_STATE_OP) {
+        EC_SLAVE_DBG(slave, 1, "Waiting for grouped OP request.\n");
+        slave->group_op = 1;
+        fsm->state = ec_fsm_slave_config_state_end; // successful
+        return;
+    }
+
+    ec_fsm_slave_config_request_op(fsm);
+}
+
+/*****************************************************************************/
+
+/** Request OP for the slave alone.
+ */
+void ec_fsm_slave_config_request_op(
+        ec_fsm_slave_config_t *fsm /**< slave state machine */
+        )
+{
+    ec_fsm_slave_config_phase(fsm, EC_STARTUP_OP);
+
     // set state to OP
     fsm->state = ec_fsm_slave_config_state_op;
     ec_fsm_change_start(fsm->fsm_change, fsm->slave, EC_SLAVE_STATE_OP);
@@ -43,6 +43,7 @@
 #include "fsm_change.h"
 #include "fsm_coe.h"
 #include "fsm_pdo.h"
+#include "startup_profile.h"
 
 /*****************************************************************************/
 
@@ -64,10 +65,21 @@ struct ec_fsm_slave_config
     unsigned int retries; /**< Retries on datagram timeout. */
     ec_sdo_request_t *request; /**< SDO request for SDO configuration. */
     ec_sdo_request_t request_copy; /**< Copied SDO request. */
+    ec_sdo_request_t *request_first; /**< First SDO configuration of a
+                                       coalesced CompleteAccess download, or
+                                       NULL. */
+    uint8_t sdo_coalesce; /**< SDO configurations may be coalesced. */
     ec_soe_request_t *soe_request; /**< SDO request for SDO configuration. */
     ec_soe_request_t soe_request_copy; /**< Copied SDO request. */
     unsigned long jiffies_start; /**< For timeout calculations. */
     unsigned int take_time; /**< Store jiffies after datagram reception. */
+    unsigned int al_status_fmmu; /**< The FMMU configuration maps the AL
+                                   status. */
+    unsigned int mbox_status_fmmu; /**< The FMMU configuration maps the
+                                     mailbox status. */
+    unsigned int mbox_data_fmmu; /**< The FMMU configuration maps the send
+                                   mailbox. */
+    ec_startup_timer_t timer; /**< Startup profile timer. */
 };
 
 /*****************************************************************************/
@@ -77,6 +89,7 @@ void ec_fsm_slave_config_init(ec_fsm_slave_config_t *, ec_datagram_t *,
 void ec_fsm_slave_config_clear(ec_fsm_slave_config_t *);
 
 void ec_fsm_slave_config_start(ec_fsm_slave_config_t *, ec_slave_t *);
+void ec_fsm_slave_config_start_op(ec_fsm_slave_config_t *, ec_slave_t *);
 
 int ec_fsm_slave_config_exec(ec_fsm_slave_config_t *);
 int ec_fsm_slave_config_success(const ec_fsm_slave_config_t *);
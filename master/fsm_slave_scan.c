@@ -44,6 +44,7 @@
 /*****************************************************************************/
 
 void ec_fsm_slave_scan_state_start(ec_fsm_slave_scan_t *);
+void ec_fsm_slave_scan_state_start_mailbox(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_state_address(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_state_state(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_state_base(ec_fsm_slave_scan_t *);
@@ -53,6 +54,7 @@ void ec_fsm_slave_scan_state_datalink(ec_fsm_slave_scan_t *);
 #ifdef EC_SII_ASSIGN
 void ec_fsm_slave_scan_state_assign_sii(ec_fsm_slave_scan_t *);
 #endif
+void ec_fsm_slave_scan_state_sii_header(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_state_sii_size(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *);
 #ifdef EC_REGALIAS
@@ -66,14 +68,31 @@ void ec_fsm_slave_scan_state_end(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_state_error(ec_fsm_slave_scan_t *);
 
 void ec_fsm_slave_scan_enter_datalink(ec_fsm_slave_scan_t *);
+void ec_fsm_slave_scan_enter_sii_header(ec_fsm_slave_scan_t *);
+void ec_fsm_slave_scan_enter_sii_size(ec_fsm_slave_scan_t *);
+void ec_fsm_slave_scan_evaluate_sii(ec_fsm_slave_scan_t *);
 #ifdef EC_REGALIAS
 void ec_fsm_slave_scan_enter_regalias(ec_fsm_slave_scan_t *);
 #endif
+void ec_fsm_slave_scan_enter_mailbox(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_enter_preop(ec_fsm_slave_scan_t *);
 void ec_fsm_slave_scan_enter_pdos(ec_fsm_slave_scan_t *);
 
 /*****************************************************************************/
 
+/** Starts a phase of the startup profile.
+ */
+static void ec_fsm_slave_scan_phase(
+        ec_fsm_slave_scan_t *fsm, /**< slave state machine */
+        ec_startup_phase_t phase /**< Phase to start. */
+        )
+{
+    ec_startup_timer_start(&fsm->slave->master->startup_profile,
+            &fsm->timer, phase, fsm->slave->ring_position);
+}
+
+/*****************************************************************************/
+
 /** Constructor.
  */
 void ec_fsm_slave_scan_init(
@@ -87,6 +106,7 @@ void ec_fsm_slave_scan_init(
     fsm->datagram = datagram;
     fsm->fsm_slave_config = fsm_slave_config;
     fsm->fsm_pdo = fsm_pdo;
+    ec_startup_timer_init(&fsm->timer);
 
     // init sub state machines
     ec_fsm_sii_init(&fsm->fsm_sii, fsm->datagram);
@@ -113,8 +133,31 @@ void ec_fsm_slave_scan_start(
         ec_slave_t *slave /**< slave to configure */
         )
 {
+    // a scan, that is still running, was aborted
+    ec_startup_timer_stop(&slave->master->startup_profile, &fsm->timer, 1);
+
     fsm->slave = slave;
     fsm->state = ec_fsm_slave_scan_state_start;
+    ec_fsm_slave_scan_phase(fsm, EC_STARTUP_SCAN);
+}
+
+/*****************************************************************************/
+
+/** Start scanning the mailbox information of a slave.
+ *
+ * Used to read the PDO assignment of a CoE slave, if the scan was run
+ * without a slave configuration state machine before.
+ */
+void ec_fsm_slave_scan_start_mailbox(
+        ec_fsm_slave_scan_t *fsm, /**< slave state machine */
+        ec_slave_t *slave /**< slave to scan */
+        )
+{
+    ec_startup_timer_stop(&slave->master->startup_profile, &fsm->timer, 1);
+
+    fsm->slave = slave;
+    fsm->state = ec_fsm_slave_scan_state_start_mailbox;
+    ec_fsm_slave_scan_phase(fsm, EC_STARTUP_MAILBOX);
 }
 
 /*****************************************************************************/
@@ -147,7 +190,14 @@ int ec_fsm_slave_scan_exec(ec_fsm_slave_scan_t *fsm /**< slave state machine */)
     }
 
     fsm->state(fsm);
-    return ec_fsm_slave_scan_running(fsm);
+
+    if (!ec_fsm_slave_scan_running(fsm)) {
+        ec_startup_timer_stop(&fsm->slave->master->startup_profile,
+                &fsm->timer, fsm->state == ec_fsm_slave_scan_state_error);
+        return 0;
+    }
+
+    return 1;
 }
 
 /*****************************************************************************/
@@ -182,6 +232,17 @@ void ec_fsm_slave_scan_state_start(ec_fsm_slave_scan_t *fsm /**< slave state mac
 
 /*****************************************************************************/
 
+/** Slave scan state: START MAILBOX.
+ */
+void ec_fsm_slave_scan_state_start_mailbox(
+        ec_fsm_slave_scan_t *fsm /**< slave state machine */
+        )
+{
+    ec_fsm_slave_scan_enter_preop(fsm);
+}
+
+/*****************************************************************************/
+
 /**
    Slave scan state: ADDRESS.
 */
@@ -442,6 +503,94 @@ void ec_fsm_slave_scan_enter_datalink(
 
 /*****************************************************************************/
 
+/** Enter slave scan state SII_HEADER.
+ *
+ * With the SII cache enabled, the SII header words are read first. If they
+ * match a cached image, the SII size and contents are taken from the cache.
+ */
+void ec_fsm_slave_scan_enter_sii_header(
+        ec_fsm_slave_scan_t *fsm /**< slave state machine */
+        )
+{
+    ec_fsm_slave_scan_phase(fsm, EC_STARTUP_SII);
+    fsm->sii_header_words = 0;
+
+    if (!ec_sii_cache) {
+        ec_fsm_slave_scan_enter_sii_size(fsm);
+        return;
+    }
+
+    ec_fsm_sii_read(&fsm->fsm_sii, fsm->slave, 0x0000,
+            EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+    fsm->state = ec_fsm_slave_scan_state_sii_header;
+    ec_fsm_sii_exec(&fsm->fsm_sii); // execute state immediately
+}
+
+/*****************************************************************************/
+
+/** Slave scan state: SII HEADER.
+ */
+void ec_fsm_slave_scan_state_sii_header(
+        ec_fsm_slave_scan_t *fsm /**< slave state machine */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    const ec_sii_image_t *image;
+    unsigned int words;
+
+    if (ec_fsm_sii_exec(&fsm->fsm_sii))
+        return;
+
+    if (!ec_fsm_sii_success(&fsm->fsm_sii)) {
+        // let the regular SII scan handle the error
+        fsm->sii_header_words = 0;
+        ec_fsm_slave_scan_enter_sii_size(fsm);
+        return;
+    }
+
+    words = min((unsigned int) fsm->fsm_sii.value_size / 2,
+            EC_SII_HEADER_WORDS - fsm->sii_header_words);
+    memcpy(fsm->sii_header + fsm->sii_header_words, fsm->fsm_sii.value,
+            words * 2);
+    fsm->sii_header_words += words;
+
+    if (fsm->sii_header_words < EC_SII_HEADER_WORDS) {
+        ec_fsm_sii_read(&fsm->fsm_sii, slave, fsm->sii_header_words,
+                EC_FSM_SII_USE_CONFIGURED_ADDRESS);
+        ec_fsm_sii_exec(&fsm->fsm_sii); // execute state immediately
+        return;
+    }
+
+    image = ec_master_sii_cache_find(slave->master, fsm->sii_header);
+    if (!image) {
+        ec_fsm_slave_scan_enter_sii_size(fsm);
+        return;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Using cached SII contents.\n");
+
+    if (slave->sii_words) {
+        EC_SLAVE_WARN(slave, "Freeing old SII data...\n");
+        kfree(slave->sii_words);
+    }
+
+    if (!(slave->sii_words =
+                (uint16_t *) kmalloc(image->nwords * 2, GFP_KERNEL))) {
+        EC_SLAVE_ERR(slave, "Failed to allocate %zu words of SII data.\n",
+               image->nwords);
+        slave->sii_nwords = 0;
+        slave->error_flag = 1;
+        fsm->state = ec_fsm_slave_scan_state_error;
+        return;
+    }
+
+    slave->sii_nwords = image->nwords;
+    memcpy(slave->sii_words, image->words, image->nwords * 2);
+    ec_fsm_slave_scan_evaluate_sii(fsm);
+}
+
+/*****************************************************************************/
+
 /** Enter slave scan state SII_SIZE.
  */
 void ec_fsm_slave_scan_enter_sii_size(
@@ -471,6 +620,7 @@ void ec_fsm_slave_scan_enter_assign_sii(
     ec_slave_t *slave = fsm->slave;
 
     EC_SLAVE_DBG(slave, 1, "Assigning SII access to EtherCAT.\n");
+    ec_fsm_slave_scan_phase(fsm, EC_STARTUP_SII);
 
     // assign SII to ECAT
     ec_datagram_fpwr(datagram, slave->station_address, 0x0500, 1);
@@ -527,7 +677,7 @@ void ec_fsm_slave_scan_state_datalink(
 #ifdef EC_SII_ASSIGN
     ec_fsm_slave_scan_enter_assign_sii(fsm);
 #else
-    ec_fsm_slave_scan_enter_sii_size(fsm);
+    ec_fsm_slave_scan_enter_sii_header(fsm);
 #endif
 }
 
@@ -564,7 +714,7 @@ void ec_fsm_slave_scan_state_assign_sii(
     }
 
 continue_with_sii_size:
-    ec_fsm_slave_scan_enter_sii_size(fsm);
+    ec_fsm_slave_scan_enter_sii_header(fsm);
 }
 
 #endif
@@ -632,10 +782,17 @@ alloc_sii:
         return;
     }
 
-    // Start fetching SII contents
+    // Start fetching SII contents, header words may already be known
+
+    fsm->sii_offset = min(fsm->sii_header_words, slave->sii_nwords);
+    memcpy(slave->sii_words, fsm->sii_header, fsm->sii_offset * 2);
+
+    if (fsm->sii_offset == slave->sii_nwords) {
+        ec_fsm_slave_scan_evaluate_sii(fsm);
+        return;
+    }
 
     fsm->state = ec_fsm_slave_scan_state_sii_data;
-    fsm->sii_offset = 0x0000;
     ec_fsm_sii_read(&fsm->fsm_sii, slave, fsm->sii_offset,
             EC_FSM_SII_USE_CONFIGURED_ADDRESS);
     ec_fsm_sii_exec(&fsm->fsm_sii); // execute state immediately
@@ -650,7 +807,7 @@ alloc_sii:
 void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *fsm /**< slave state machine */)
 {
     ec_slave_t *slave = fsm->slave;
-    uint16_t *cat_word, cat_type, cat_size;
+    size_t words;
 
     if (ec_fsm_sii_exec(&fsm->fsm_sii)) return;
 
@@ -661,26 +818,48 @@ void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *fsm /**< slave state
         return;
     }
 
-    // 2 words fetched
-
-    if (fsm->sii_offset + 2 <= slave->sii_nwords) { // 2 words fit
-        memcpy(slave->sii_words + fsm->sii_offset, fsm->fsm_sii.value, 4);
-    } else { // copy the last word
-        memcpy(slave->sii_words + fsm->sii_offset, fsm->fsm_sii.value, 2);
+    // 2 or 4 words fetched, depending on the read size of the slave
+    words = fsm->fsm_sii.value_size / 2;
+    if (fsm->sii_offset + words > slave->sii_nwords) {
+        words = slave->sii_nwords - fsm->sii_offset;
     }
+    memcpy(slave->sii_words + fsm->sii_offset, fsm->fsm_sii.value,
+            words * 2);
 
-    if (fsm->sii_offset + 2 < slave->sii_nwords) {
-        // fetch the next 2 words
-        fsm->sii_offset += 2;
+    if (fsm->sii_offset + words < slave->sii_nwords) {
+        // fetch the next words
+        fsm->sii_offset += words;
         ec_fsm_sii_read(&fsm->fsm_sii, slave, fsm->sii_offset,
                         EC_FSM_SII_USE_CONFIGURED_ADDRESS);
         ec_fsm_sii_exec(&fsm->fsm_sii); // execute state immediately
         return;
     }
 
+    if (ec_sii_cache) {
+        ec_master_sii_cache_store(slave->master, slave->sii_words,
+                slave->sii_nwords);
+    }
+
+    ec_fsm_slave_scan_evaluate_sii(fsm);
+}
+
+/*****************************************************************************/
+
+/** Evaluates the SII contents of a slave.
+ */
+void ec_fsm_slave_scan_evaluate_sii(
+        ec_fsm_slave_scan_t *fsm /**< slave state machine */
+        )
+{
+    ec_slave_t *slave = fsm->slave;
+    uint16_t *cat_word, cat_type, cat_size;
+    size_t cat_nwords;
+    unsigned int shared;
+
     // Evaluate SII contents
 
     ec_slave_clear_sync_managers(slave);
+    ec_slave_clear_sii_data(slave);
 
     slave->sii.alias =
         EC_READ_U16(slave->sii_words + 0x0004);
@@ -724,8 +903,23 @@ void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *fsm /**< slave state
         goto end;
     }
 
-    // evaluate category data
+    // slaves with the same category words share strings, sync managers and
+    // PDO descriptions
     cat_word = slave->sii_words + EC_FIRST_SII_CATEGORY_OFFSET;
+    cat_nwords = slave->sii_nwords - EC_FIRST_SII_CATEGORY_OFFSET;
+    slave->sii.data = ec_master_find_sii_data(slave->master, cat_word,
+            cat_nwords);
+    shared = slave->sii.data != NULL;
+    if (shared) {
+        EC_SLAVE_DBG(slave, 1, "Using shared SII category data.\n");
+        slave->sii.data->refs++;
+    } else if (!(slave->sii.data =
+                ec_sii_data_create(cat_word, cat_nwords))) {
+        EC_SLAVE_ERR(slave, "Failed to allocate SII category data.\n");
+        goto end;
+    }
+
+    // evaluate category data
     while (EC_READ_U16(cat_word) != 0xFFFF) {
 
         // type and size words must fit
@@ -747,8 +941,8 @@ void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *fsm /**< slave state
 
         switch (cat_type) {
             case 0x000A:
-                if (ec_slave_fetch_sii_strings(slave, (uint8_t *) cat_word,
-                            cat_size * 2))
+                if (!shared && ec_slave_fetch_sii_strings(slave,
+                            (uint8_t *) cat_word, cat_size * 2))
                     goto end;
                 break;
             case 0x001E:
@@ -759,19 +953,13 @@ void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *fsm /**< slave state
             case 0x0028:
                 break;
             case 0x0029:
-                if (ec_slave_fetch_sii_syncs(slave, (uint8_t *) cat_word,
-                            cat_size * 2))
+                if (!shared && ec_slave_fetch_sii_syncs(slave,
+                            (uint8_t *) cat_word, cat_size * 2))
                     goto end;
                 break;
-            case 0x0032:
-                if (ec_slave_fetch_sii_pdos( slave, (uint8_t *) cat_word,
-                            cat_size * 2, EC_DIR_INPUT)) // TxPDO
-                    goto end;
-                break;
-            case 0x0033:
-                if (ec_slave_fetch_sii_pdos( slave, (uint8_t *) cat_word,
-                            cat_size * 2, EC_DIR_OUTPUT)) // RxPDO
-                    goto end;
+            case 0x0032: // TxPDO
+            case 0x0033: // RxPDO
+                // parsed on demand, see ec_slave_load_sii_pdos()
                 break;
             default:
                 EC_SLAVE_DBG(slave, 1, "Unknown category type 0x%04X.\n",
@@ -786,14 +974,18 @@ void ec_fsm_slave_scan_state_sii_data(ec_fsm_slave_scan_t *fsm /**< slave state
         }
     }
 
+    if (!shared) {
+        ec_master_share_sii_data(slave->master, slave->sii.data);
+    }
+
+    if (ec_slave_init_sii_syncs(slave)) {
+        goto end;
+    }
+
 #ifdef EC_REGALIAS
     ec_fsm_slave_scan_enter_regalias(fsm);
 #else
-    if (slave->sii.mailbox_protocols & EC_MBOX_COE) {
-        ec_fsm_slave_scan_enter_preop(fsm);
-    } else {
-        fsm->state = ec_fsm_slave_scan_state_end;
-    }
+    ec_fsm_slave_scan_enter_mailbox(fsm);
 #endif
     return;
 
@@ -853,15 +1045,32 @@ void ec_fsm_slave_scan_state_regalias(
                 slave->effective_alias);
     }
 
-    if (slave->sii.mailbox_protocols & EC_MBOX_COE) {
+    ec_fsm_slave_scan_enter_mailbox(fsm);
+}
+
+#endif // defined EC_REGALIAS
+
+/*****************************************************************************/
+
+/** Enter the mailbox part of the slave scan.
+ *
+ * Reading the PDO assignment of CoE slaves needs the slave configuration and
+ * PDO state machines. If the scan was started without them, the mailbox part
+ * is skipped and has to be done via ec_fsm_slave_scan_start_mailbox().
+ */
+void ec_fsm_slave_scan_enter_mailbox(
+        ec_fsm_slave_scan_t *fsm /**< slave state machine */
+        )
+{
+    if (fsm->slave->sii.mailbox_protocols & EC_MBOX_COE
+            && fsm->fsm_slave_config) {
+        ec_fsm_slave_scan_phase(fsm, EC_STARTUP_MAILBOX);
         ec_fsm_slave_scan_enter_preop(fsm);
     } else {
         fsm->state = ec_fsm_slave_scan_state_end;
     }
 }
 
-#endif // defined EC_REGALIAS
-
 /*****************************************************************************/
 
 /** Enter slave scan state PREOP.
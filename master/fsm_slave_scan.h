@@ -44,6 +44,7 @@
 #include "fsm_change.h"
 #include "fsm_coe.h"
 #include "fsm_pdo.h"
+#include "startup_profile.h"
 
 /*****************************************************************************/
 
@@ -57,14 +58,19 @@ struct ec_fsm_slave_scan
     ec_slave_t *slave; /**< Slave the FSM runs on. */
     ec_datagram_t *datagram; /**< Datagram used in the state machine. */
     ec_fsm_slave_config_t *fsm_slave_config; /**< Slave configuration state
-                                               machine to use. */
+                                               machine to use, or NULL to
+                                               skip the mailbox scan. */
     ec_fsm_pdo_t *fsm_pdo; /**< PDO configuration state machine to use. */
     unsigned int retries; /**< Retries on datagram timeout. */
 
     void (*state)(ec_fsm_slave_scan_t *); /**< State function. */
     uint16_t sii_offset; /**< SII offset in words. */
+    uint16_t sii_header[EC_SII_HEADER_WORDS]; /**< SII header words. */
+    unsigned int sii_header_words; /**< Number of valid words in \a
+                                     sii_header. */
 
     ec_fsm_sii_t fsm_sii; /**< SII state machine. */
+    ec_startup_timer_t timer; /**< Startup profile timer. */
 };
 
 /*****************************************************************************/
@@ -74,6 +80,7 @@ void ec_fsm_slave_scan_init(ec_fsm_slave_scan_t *, ec_datagram_t *,
 void ec_fsm_slave_scan_clear(ec_fsm_slave_scan_t *);
 
 void ec_fsm_slave_scan_start(ec_fsm_slave_scan_t *, ec_slave_t *);
+void ec_fsm_slave_scan_start_mailbox(ec_fsm_slave_scan_t *, ec_slave_t *);
 
 int ec_fsm_slave_scan_exec(ec_fsm_slave_scan_t *);
 int ec_fsm_slave_scan_success(const ec_fsm_slave_scan_t *);
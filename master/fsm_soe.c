@@ -251,6 +251,38 @@ int ec_fsm_soe_prepare_read(
 
 /*****************************************************************************/
 
+/** Prepares a mailbox check and fetches the response immediately, if
+ * possible.
+ *
+ * If the check could be answered from the mailbox status area (see
+ * ec_slave_mbox_prepare_check()) and the slave already signals new mailbox
+ * data, the check round trip is skipped and the mailbox is fetched right
+ * away.
+ */
+static void ec_fsm_soe_prepare_check(
+        ec_fsm_soe_t *fsm, /**< finite state machine */
+        ec_datagram_t *datagram, /**< Datagram to use. */
+        void (*check_state)(ec_fsm_soe_t *, ec_datagram_t *), /**< Mailbox
+                                                                check state.
+                                                                */
+        void (*read_state)(ec_fsm_soe_t *, ec_datagram_t *) /**< Mailbox
+                                                              read state. */
+        )
+{
+    ec_slave_mbox_prepare_check(fsm->slave, datagram); // can not fail.
+    fsm->retries = EC_FSM_RETRIES;
+
+    if (datagram->state == EC_DATAGRAM_RECEIVED
+            && ec_slave_mbox_check(datagram)) {
+        ec_slave_mbox_prepare_fetch(fsm->slave, datagram); // can not fail.
+        fsm->state = read_state;
+    } else {
+        fsm->state = check_state;
+    }
+}
+
+/*****************************************************************************/
+
 /** SoE state: READ START.
  */
 void ec_fsm_soe_read_start(
@@ -330,9 +362,8 @@ void ec_fsm_soe_read_request(
     }
 
     fsm->jiffies_start = fsm->datagram->jiffies_sent;
-    ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-    fsm->retries = EC_FSM_RETRIES;
-    fsm->state = ec_fsm_soe_read_check;
+    ec_fsm_soe_prepare_check(fsm, datagram,
+            ec_fsm_soe_read_check, ec_fsm_soe_read_response);
 }
 
 /*****************************************************************************/
@@ -380,8 +411,8 @@ void ec_fsm_soe_read_check(
             return;
         }
 
-        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-        fsm->retries = EC_FSM_RETRIES;
+        ec_fsm_soe_prepare_check(fsm, datagram,
+                ec_fsm_soe_read_check, ec_fsm_soe_read_response);
         return;
     }
 
@@ -502,9 +533,8 @@ void ec_fsm_soe_read_response(
         EC_SLAVE_DBG(slave, 1, "SoE data incomplete. Waiting for fragment"
                 " at offset %zu.\n", req->data_size);
         fsm->jiffies_start = fsm->datagram->jiffies_sent;
-        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-        fsm->retries = EC_FSM_RETRIES;
-        fsm->state = ec_fsm_soe_read_check;
+        ec_fsm_soe_prepare_check(fsm, datagram,
+                ec_fsm_soe_read_check, ec_fsm_soe_read_response);
     } else {
         if (master->debug_level) {
             EC_SLAVE_DBG(slave, 0, "IDN data:\n");
@@ -654,9 +684,8 @@ void ec_fsm_soe_write_request(
     } else {
         // all fragments sent; query response
         fsm->jiffies_start = fsm->datagram->jiffies_sent;
-        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-        fsm->retries = EC_FSM_RETRIES;
-        fsm->state = ec_fsm_soe_write_check;
+        ec_fsm_soe_prepare_check(fsm, datagram,
+                ec_fsm_soe_write_check, ec_fsm_soe_write_response);
     }
 }
 
@@ -703,8 +732,8 @@ void ec_fsm_soe_write_check(
             return;
         }
 
-        ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
-        fsm->retries = EC_FSM_RETRIES;
+        ec_fsm_soe_prepare_check(fsm, datagram,
+                ec_fsm_soe_write_check, ec_fsm_soe_write_response);
         return;
     }
 
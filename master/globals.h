@@ -46,9 +46,20 @@
 /** Datagram timeout in microseconds. */
 #define EC_IO_TIMEOUT 500
 
+/** Maximum datagram timeout in microseconds. */
+#define EC_MAX_IO_TIMEOUT 100000
+
 /** SDO injection timeout in microseconds. */
 #define EC_SDO_INJECTION_TIMEOUT 10000
 
+/** Interval in ns, that mailbox checks back off to first, after a check
+ * found the mailbox empty. */
+#define EC_MBOX_POLL_MIN_NS 100000
+
+/** Maximum interval in ns between two mailbox checks while waiting for a
+ * response. */
+#define EC_MBOX_POLL_MAX_NS 10000000
+
 /** Time to send a byte in nanoseconds.
  *
  * t_ns = 1 / (100 MBit/s / 8 bit/byte) = 80 ns/byte
@@ -62,6 +73,11 @@
     after slave entered PREOP state. */
 #define EC_WAIT_SDO_DICT 3
 
+/** Interval in ms between two sweeps over all slave FSMs. The sweeps catch
+ * work, that is not triggered by a request, like fetching the SDO
+ * dictionary or timing out internal requests. */
+#define EC_SLAVE_FSM_SWEEP_MS 100
+
 /** Minimum size of a buffer used with ec_state_string(). */
 #define EC_STATE_STRING_SIZE 32
 
@@ -97,6 +113,50 @@
 /** Word offset of first SII category. */
 #define EC_FIRST_SII_CATEGORY_OFFSET 0x40
 
+/** Number of SII header words that identify a slave.
+ *
+ * These are the configuration area (including the checksum) and the
+ * identity words (vendor ID, product code, revision and serial number).
+ */
+#define EC_SII_HEADER_WORDS 0x0010
+
+/** Logical start address of the AL status area.
+ *
+ * If enabled, every slave maps the low byte of its AL status register to
+ * the byte at this address plus its station address minus one, using a
+ * spare FMMU.
+ */
+#define EC_AL_STATUS_LOGICAL_BASE 0xFFFF0000
+
+/** Maximum number of slaves in the AL status area. */
+#define EC_AL_STATUS_MAX_SLAVES EC_MAX_DATA_SIZE
+
+/** Logical start address of the mailbox status area.
+ *
+ * If enabled, every slave with mailbox support maps the status register of
+ * its send mailbox sync manager (SM1) to the byte at this address plus its
+ * station address minus one, using a spare FMMU.
+ */
+#define EC_MBOX_STATUS_LOGICAL_BASE 0xFFFE0000
+
+/** Maximum number of slaves in the mailbox status area. */
+#define EC_MBOX_STATUS_MAX_SLAVES EC_MAX_DATA_SIZE
+
+/** Logical start address of the mailbox data area.
+ *
+ * If enabled, every configured slave with a mapped mailbox status also maps
+ * its send mailbox (SM1) to this area using a spare FMMU. The mailboxes are
+ * placed in ring order, see ec_slave::mbox_data_offset.
+ */
+#define EC_MBOX_DATA_LOGICAL_BASE 0xFFE00000
+
+/** Size of the mailbox data area. */
+#define EC_MBOX_DATA_AREA_SIZE (EC_MBOX_STATUS_LOGICAL_BASE \
+        - EC_MBOX_DATA_LOGICAL_BASE)
+
+/** First DC latch register mapped by ecrt_slave_config_dc_latch(). */
+#define EC_DC_LATCH_ADDRESS 0x09AE
+
 /** Size of a sync manager configuration page. */
 #define EC_SYNC_PAGE_SIZE 8
 
@@ -205,6 +265,33 @@ typedef enum {
 
 extern const char *ec_device_names[2]; // only main and backup!
 
+/** Phases of the startup profile.
+ *
+ * \attention If ever changing this, please be sure to adjust the phase names
+ * in tool/CommandStartupProfile.cpp.
+ */
+typedef enum {
+    EC_STARTUP_BUS_SCAN, /**< Bus scan of the master. */
+    EC_STARTUP_ACTIVATE, /**< Activation of the master. */
+    EC_STARTUP_SCAN, /**< Slave scan: Addressing and registers. */
+    EC_STARTUP_SII, /**< Slave scan: SII. */
+    EC_STARTUP_MAILBOX, /**< Slave scan: PDO assignment via mailbox. */
+    EC_STARTUP_INIT, /**< Configuration: INIT and clearing. */
+    EC_STARTUP_PREOP, /**< Configuration: Mailbox setup and PREOP. */
+    EC_STARTUP_SDO, /**< Configuration: SDO and SoE configuration. */
+    EC_STARTUP_PDO, /**< Configuration: PDOs, watchdog and FMMUs. */
+    EC_STARTUP_DC, /**< Configuration: Distributed clocks. */
+    EC_STARTUP_SAFEOP, /**< Configuration: SAFEOP. */
+    EC_STARTUP_OP, /**< Configuration: OP. */
+    EC_STARTUP_PHASE_COUNT /**< Number of phases. */
+} ec_startup_phase_t;
+
+/** Slave position of master-wide startup profile events. */
+#define EC_STARTUP_MASTER 0xFFFF
+
+/** Flag of a startup profile event, that ended with an error. */
+#define EC_STARTUP_FAILED 0x01
+
 /*****************************************************************************/
 
 /** Convenience macro for printing EtherCAT-specific information to syslog.
@@ -266,7 +353,12 @@ size_t ec_state_string(uint8_t, char *, uint8_t);
 ssize_t ec_mac_print(const uint8_t *, char *);
 int ec_mac_is_zero(const uint8_t *);
 
+struct eventfd_ctx;
+int ec_request_eventfd(struct eventfd_ctx **, int);
+void ec_request_eventfd_signal(struct eventfd_ctx *);
+
 ec_master_t *ecrt_request_master_err(unsigned int);
+ec_master_t *ec_request_master_shared_err(unsigned int);
 
 /*****************************************************************************/
 
@@ -311,6 +403,8 @@ typedef enum {
 /*****************************************************************************/
 
 typedef struct ec_slave ec_slave_t; /**< \see ec_slave. */
+typedef struct ec_dict ec_dict_t; /**< \see ec_dict. */
+typedef struct ec_sii_data ec_sii_data_t; /**< \see ec_sii_data. */
 
 /*****************************************************************************/
 
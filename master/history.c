@@ -0,0 +1,325 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Process data history ring.
+*/
+
+/*****************************************************************************/
+
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+
+#include "globals.h"
+#include "history.h"
+
+/*****************************************************************************/
+
+/** Constructor.
+ */
+void ec_history_init(
+        ec_history_t *history /**< History ring. */
+        )
+{
+    history->depth = 0;
+    history->offset = 0;
+    history->size = 0;
+    history->flags = 0;
+    history->record_size = 0;
+    history->mem = NULL;
+    history->mem_origin = EC_ORIG_INTERNAL;
+    history->mem_size = 0;
+    history->seq = 0;
+    history->trigger = 0;
+    history->frozen = 0;
+}
+
+/*****************************************************************************/
+
+/** Destructor.
+ *
+ * The history must not be written any more.
+ */
+void ec_history_clear(
+        ec_history_t *history /**< History ring. */
+        )
+{
+    if (history->mem_origin == EC_ORIG_INTERNAL && history->mem) {
+        vfree(history->mem);
+    }
+
+    history->mem = NULL;
+    history->mem_origin = EC_ORIG_INTERNAL;
+    history->mem_size = 0;
+}
+
+/*****************************************************************************/
+
+/** Configures the history.
+ *
+ * The memory is allocated with ec_history_alloc(), when the process data
+ * size is known.
+ */
+void ec_history_setup(
+        ec_history_t *history, /**< History ring. */
+        unsigned int depth, /**< Number of records, or zero to disable. */
+        size_t offset, /**< Offset of the range in the process data. */
+        size_t size, /**< Size of the range, or zero for the rest of the
+                       process data. */
+        unsigned int flags /**< Freeze triggers. */
+        )
+{
+    history->depth = depth;
+    history->offset = offset;
+    history->size = size;
+    history->flags = flags;
+}
+
+/*****************************************************************************/
+
+/** Calculates the size of the recorded range.
+ *
+ * \return Range size, or zero, if the range exceeds the process data.
+ */
+static size_t ec_history_range_size(
+        const ec_history_t *history, /**< History ring. */
+        size_t data_size /**< Process data size of the domain. */
+        )
+{
+    if (history->offset >= data_size) {
+        return 0;
+    }
+
+    if (!history->size) {
+        return data_size - history->offset;
+    }
+
+    if (history->size > data_size - history->offset) {
+        return 0;
+    }
+
+    return history->size;
+}
+
+/*****************************************************************************/
+
+/** Calculates the size of the ring memory.
+ *
+ * \return Memory size, or zero, if the history is disabled or invalid.
+ */
+size_t ec_history_mem_size(
+        const ec_history_t *history, /**< History ring. */
+        size_t data_size /**< Process data size of the domain. */
+        )
+{
+    size_t range_size = ec_history_range_size(history, data_size);
+    size_t record_size;
+
+    if (!history->depth || !range_size) {
+        return 0;
+    }
+
+    record_size = ALIGN(sizeof(ec_history_record_t) + range_size, 8);
+    if (history->depth > SIZE_MAX / record_size) {
+        return 0;
+    }
+
+    return history->depth * record_size;
+}
+
+/*****************************************************************************/
+
+/** Lets the history use external memory, for example memory mapped by an
+ * application.
+ */
+void ec_history_external_memory(
+        ec_history_t *history, /**< History ring. */
+        uint8_t *mem, /**< External memory. */
+        size_t size /**< Size of \a mem. */
+        )
+{
+    ec_history_clear(history);
+
+    history->mem = mem;
+    history->mem_origin = EC_ORIG_EXTERNAL;
+    history->mem_size = size;
+}
+
+/*****************************************************************************/
+
+/** Prepares the history for recording.
+ *
+ * Resolves the recorded range and allocates the ring memory, unless
+ * external memory was given.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_history_alloc(
+        ec_history_t *history, /**< History ring. */
+        size_t data_size /**< Process data size of the domain. */
+        )
+{
+    size_t mem_size = ec_history_mem_size(history, data_size);
+
+    if (!history->depth) {
+        return 0;
+    }
+
+    if (!mem_size) {
+        return -EINVAL;
+    }
+
+    if (history->mem && history->mem_size < mem_size) {
+        return -EOVERFLOW;
+    }
+
+    if (!history->mem) {
+        history->mem = vzalloc(mem_size);
+        if (!history->mem) {
+            return -ENOMEM;
+        }
+        history->mem_origin = EC_ORIG_INTERNAL;
+        history->mem_size = mem_size;
+    } else {
+        memset(history->mem, 0x00, mem_size);
+    }
+
+    history->size = ec_history_range_size(history, data_size);
+    history->record_size = mem_size / history->depth;
+    history->seq = 0;
+    history->trigger = 0;
+    history->frozen = 0;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Appends the recorded range of the process data to the ring.
+ *
+ * Only to be called, if the memory is allocated.
+ */
+void ec_history_record(
+        ec_history_t *history, /**< History ring. */
+        const uint8_t *data, /**< Process data of the domain. */
+        u32 cycle /**< Cycle counter. */
+        )
+{
+    u32 seq = history->seq;
+    ec_history_record_t *record;
+
+    if (history->frozen) {
+        return;
+    }
+
+    record = (ec_history_record_t *)
+        (history->mem + (seq % history->depth) * history->record_size);
+
+    record->seq = 0;
+    smp_wmb(); // invalidate the record before overwriting it
+    record->cycle = cycle;
+    record->time = ktime_to_ns(ktime_get_real());
+    memcpy(record + 1, data + history->offset, history->size);
+    smp_wmb(); // complete the record before marking it valid
+    record->seq = seq + 1;
+    WRITE_ONCE(history->seq, seq + 1);
+
+    if (history->trigger) {
+        history->trigger = 0;
+        WRITE_ONCE(history->frozen, 1);
+    }
+}
+
+/*****************************************************************************/
+
+/** Freezes the history after the next record.
+ *
+ * Used for trigger events in the cyclic context, so that the record of the
+ * cycle with the event is kept.
+ */
+void ec_history_trigger(
+        ec_history_t *history /**< History ring. */
+        )
+{
+    if (!history->frozen) {
+        history->trigger = 1;
+    }
+}
+
+/*****************************************************************************/
+
+/** Freezes the history immediately or resumes recording.
+ */
+void ec_history_freeze(
+        ec_history_t *history, /**< History ring. */
+        int freeze /**< Non-zero to freeze, zero to resume. */
+        )
+{
+    history->trigger = 0;
+    WRITE_ONCE(history->frozen, freeze ? 1 : 0);
+}
+
+/*****************************************************************************/
+
+/** Reads a record from the history ring.
+ *
+ * \retval 0 Success.
+ * \retval -ENOENT The record is not (or no more) in the ring.
+ */
+int ec_history_read(
+        const ec_history_t *history, /**< History ring. */
+        u32 seq, /**< Sequence number of the record. */
+        uint8_t *target /**< Target memory with \a record_size bytes. */
+        )
+{
+    const ec_history_record_t *record;
+
+    if (!history->mem || !history->record_size) {
+        return -ENOENT;
+    }
+
+    record = (const ec_history_record_t *)
+        (history->mem + (seq % history->depth) * history->record_size);
+    if (READ_ONCE(record->seq) != seq + 1) {
+        return -ENOENT;
+    }
+    smp_rmb();
+
+    memcpy(target, record, history->record_size);
+
+    // check, if the record was overwritten during the copy
+    smp_rmb();
+    if (READ_ONCE(record->seq) != seq + 1) {
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Process data history ring.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_HISTORY_H__
+#define __EC_HISTORY_H__
+
+#include <linux/types.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** Process data history ring of a domain.
+ *
+ * A configured byte range of the process data is copied into the ring each
+ * time the domain is queued, together with the cycle counter and a time
+ * stamp (see ec_history_record_t). The ring is written lock-free by the
+ * application's cyclic context. Each record is marked with its sequence
+ * number, so that readers can detect records overwritten while reading.
+ */
+typedef struct {
+    unsigned int depth; /**< Number of records in the ring, or zero, if the
+                          history is disabled. */
+    size_t offset; /**< Offset of the recorded range in the process data. */
+    size_t size; /**< Size of the recorded range, or zero for the rest of the
+                   process data. */
+    unsigned int flags; /**< Freeze triggers (#EC_HISTORY_FREEZE_ON_WC). */
+    size_t record_size; /**< Distance of the records in the ring. */
+    uint8_t *mem; /**< Ring memory, or NULL. */
+    ec_origin_t mem_origin; /**< Origin of \a mem. */
+    size_t mem_size; /**< Size of \a mem. */
+    u32 seq; /**< Number of records written. */
+    unsigned int trigger; /**< Freeze after the next record. */
+    unsigned int frozen; /**< Recording is stopped. */
+} ec_history_t;
+
+/*****************************************************************************/
+
+void ec_history_init(ec_history_t *);
+void ec_history_clear(ec_history_t *);
+void ec_history_setup(ec_history_t *, unsigned int, size_t, size_t,
+        unsigned int);
+size_t ec_history_mem_size(const ec_history_t *, size_t);
+void ec_history_external_memory(ec_history_t *, uint8_t *, size_t);
+int ec_history_alloc(ec_history_t *, size_t);
+void ec_history_record(ec_history_t *, const uint8_t *, u32);
+void ec_history_trigger(ec_history_t *);
+void ec_history_freeze(ec_history_t *, int);
+int ec_history_read(const ec_history_t *, u32, uint8_t *);
+
+/*****************************************************************************/
+
+#endif
@@ -36,11 +36,13 @@
 
 #include <linux/module.h>
 #include <linux/vmalloc.h>
+#include <linux/rcupdate.h>
 
 #include "master.h"
 #include "slave_config.h"
 #include "voe_handler.h"
 #include "ethernet.h"
+#include "datagram_pair.h"
 #include "ioctl.h"
 
 /** Set to 1 to enable ioctl() latency tracing.
@@ -76,6 +78,124 @@ static void ec_ioctl_strcpy(
 
 /*****************************************************************************/
 
+/** Publishes the master, link and slave configuration states in the state
+ * page.
+ *
+ * The domain states are published by ec_ioctl_publish_domain_state().
+ */
+static void ec_ioctl_publish_states(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_state_page_t *state = ctx->state;
+    unsigned int dev_idx;
+
+    if (!state) {
+        return;
+    }
+
+    state->sequence++;
+    smp_wmb();
+
+    ecrt_master_state(master, &state->master_state);
+    state->num_devices = ec_master_num_devices(master);
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < state->num_devices; dev_idx++) {
+        ecrt_master_link_state(master, dev_idx,
+                &state->link_states[dev_idx]);
+    }
+    ecrt_master_slave_config_states(master, state->config_states,
+            state->config_count);
+
+    smp_wmb();
+    state->sequence++;
+}
+
+/*****************************************************************************/
+
+/** Publishes a domain state in the state page.
+ */
+static void ec_ioctl_publish_domain_state(
+        const ec_domain_t *domain, /**< Domain. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_state_page_t *state = ctx->state;
+
+    if (!state || domain->index >= EC_IOCTL_STATE_MAX_DOMAINS) {
+        return;
+    }
+
+    state->sequence++;
+    smp_wmb();
+
+    ecrt_domain_state(domain, &state->domain_states[domain->index]);
+
+    smp_wmb();
+    state->sequence++;
+}
+
+/*****************************************************************************/
+
+/** Attaches the CoE emergency rings of an application's slave configurations
+ * to its state page and emergency eventfd.
+ *
+ * Has to be called with the master semaphore held.
+ */
+static void ec_ioctl_attach_emerg_rings(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_state_page_t *state = ctx->state;
+    ec_slave_config_t *sc;
+
+    list_for_each_entry(sc, &master->configs, list) {
+        if (sc->owner != ctx) {
+            continue;
+        }
+        if (state && sc->index < EC_IOCTL_STATE_MAX_CONFIGS) {
+            ec_coe_emerg_ring_attach(&sc->emerg_ring, state->emerg_pending,
+                    &state->emerg_summary, ctx->emerg_eventfd);
+        } else {
+            ec_coe_emerg_ring_attach(&sc->emerg_ring, NULL, NULL,
+                    ctx->emerg_eventfd);
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Serializes the cyclic calls of applications sharing the master.
+ *
+ * The applications queue their datagrams into the same queue and receive
+ * each other's frames, so that the datagrams of all applications are sent in
+ * shared frames.
+ */
+static inline void ec_ioctl_lock_io(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    if (master->shared) {
+        down(&master->io_sem);
+    }
+}
+
+/*****************************************************************************/
+
+/** Ends a section started with ec_ioctl_lock_io().
+ */
+static inline void ec_ioctl_unlock_io(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    if (master->shared) {
+        up(&master->io_sem);
+    }
+}
+
+/*****************************************************************************/
+
 /** Get module information.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -147,6 +267,9 @@ static ATTRIBUTES int ec_ioctl_master(
         io.devices[dev_idx].tx_bytes = device->tx_bytes;
         io.devices[dev_idx].rx_bytes = device->rx_bytes;
         io.devices[dev_idx].tx_errors = device->tx_errors;
+        io.devices[dev_idx].round_trip_time = device->round_trip_time;
+        io.devices[dev_idx].max_round_trip_time =
+            device->max_round_trip_time;
         for (j = 0; j < EC_RATE_COUNT; j++) {
             io.devices[dev_idx].tx_frame_rates[j] =
                 device->tx_frame_rates[j];
@@ -184,6 +307,18 @@ static ATTRIBUTES int ec_ioctl_master(
     io.ref_clock =
         master->dc_ref_clock ? master->dc_ref_clock->ring_position : 0xffff;
 
+    for (j = 0; j < EC_TC_COUNT; j++) {
+        const ec_traffic_class_info_t *tc = &master->traffic_classes[j];
+        io.traffic_classes[j].priority = tc->priority;
+        io.traffic_classes[j].budget = tc->budget;
+        io.traffic_classes[j].datagrams = tc->datagrams;
+        io.traffic_classes[j].bytes = tc->bytes;
+        io.traffic_classes[j].deferred = tc->deferred;
+        io.traffic_classes[j].held = tc->held;
+    }
+    io.eoe_share = master->eoe_share;
+    io.bus_delay = master->bus_delay;
+
     if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
         return -EFAULT;
     }
@@ -193,6 +328,130 @@ static ATTRIBUTES int ec_ioctl_master(
 
 /*****************************************************************************/
 
+/** Fills the slave information of an ioctl() structure.
+ */
+static void ec_ioctl_fill_slave(
+        ec_ioctl_slave_t *data, /**< Slave information. */
+        const ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    int i;
+
+    data->position = slave->ring_position;
+    data->device_index = slave->device_index;
+    data->vendor_id = slave->sii.vendor_id;
+    data->product_code = slave->sii.product_code;
+    data->revision_number = slave->sii.revision_number;
+    data->serial_number = slave->sii.serial_number;
+    data->alias = slave->effective_alias;
+    data->boot_rx_mailbox_offset = slave->sii.boot_rx_mailbox_offset;
+    data->boot_rx_mailbox_size = slave->sii.boot_rx_mailbox_size;
+    data->boot_tx_mailbox_offset = slave->sii.boot_tx_mailbox_offset;
+    data->boot_tx_mailbox_size = slave->sii.boot_tx_mailbox_size;
+    data->std_rx_mailbox_offset = slave->sii.std_rx_mailbox_offset;
+    data->std_rx_mailbox_size = slave->sii.std_rx_mailbox_size;
+    data->std_tx_mailbox_offset = slave->sii.std_tx_mailbox_offset;
+    data->std_tx_mailbox_size = slave->sii.std_tx_mailbox_size;
+    data->mailbox_protocols = slave->sii.mailbox_protocols;
+    data->has_general_category = slave->sii.has_general;
+    data->coe_details = slave->sii.coe_details;
+    data->general_flags = slave->sii.general_flags;
+    data->current_on_ebus = slave->sii.current_on_ebus;
+    for (i = 0; i < EC_MAX_PORTS; i++) {
+        data->ports[i].desc = slave->ports[i].desc;
+        data->ports[i].link.link_up = slave->ports[i].link.link_up;
+        data->ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
+        data->ports[i].link.signal_detected =
+            slave->ports[i].link.signal_detected;
+        data->ports[i].receive_time = slave->ports[i].receive_time;
+        if (slave->ports[i].next_slave) {
+            data->ports[i].next_slave =
+                slave->ports[i].next_slave->ring_position;
+        } else {
+            data->ports[i].next_slave = 0xffff;
+        }
+        data->ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
+        data->ports[i].invalid_frames =
+            slave->ports[i].errors.invalid_frames;
+        data->ports[i].rx_errors = slave->ports[i].errors.rx_errors;
+        data->ports[i].forwarded_rx_errors =
+            slave->ports[i].errors.forwarded_rx_errors;
+        data->ports[i].lost_links = slave->ports[i].errors.lost_links;
+        data->ports[i].error_total = slave->ports[i].errors.total;
+        data->ports[i].error_delta = slave->ports[i].errors.delta;
+    }
+    data->error_samples = slave->error_samples;
+    data->error_interval = slave->error_interval;
+    data->processing_unit_errors = slave->processing_unit_errors;
+    data->pdi_errors = slave->pdi_errors;
+    data->fmmu_bit = slave->base_fmmu_bit_operation;
+    data->dc_supported = slave->base_dc_supported;
+    data->dc_range = slave->base_dc_range;
+    data->has_dc_system_time = slave->has_dc_system_time;
+    data->transmission_delay = slave->transmission_delay;
+    data->dc_diff_samples = slave->dc_diff_samples;
+    data->dc_diff = slave->dc_diff;
+    data->dc_diff_max = slave->dc_diff_max;
+    data->dc_drift = slave->dc_drift;
+    data->al_state = slave->current_state;
+    data->error_flag = slave->error_flag;
+
+    data->sync_count = slave->sii.sync_count;
+    data->sdo_count = ec_slave_sdo_count(slave);
+    data->sii_nwords = slave->sii_nwords;
+    ec_ioctl_strcpy(data->group, slave->sii.group);
+    ec_ioctl_strcpy(data->image, slave->sii.image);
+    ec_ioctl_strcpy(data->order, slave->sii.order);
+    ec_ioctl_strcpy(data->name, slave->sii.name);
+}
+
+/*****************************************************************************/
+
+/** Fills the sync manager information of an ioctl() structure.
+ */
+static void ec_ioctl_fill_sync(
+        ec_ioctl_slave_sync_t *data, /**< Sync manager information. */
+        const ec_sync_t *sync /**< Sync manager. */
+        )
+{
+    data->physical_start_address = sync->physical_start_address;
+    data->default_size = sync->default_length;
+    data->control_register = sync->control_register;
+    data->enable = sync->enable;
+    data->pdo_count = ec_pdo_list_count(&sync->pdos);
+}
+
+/*****************************************************************************/
+
+/** Fills the PDO information of an ioctl() structure.
+ */
+static void ec_ioctl_fill_pdo(
+        ec_ioctl_slave_sync_pdo_t *data, /**< PDO information. */
+        const ec_pdo_t *pdo /**< PDO. */
+        )
+{
+    data->index = pdo->index;
+    data->entry_count = ec_pdo_entry_count(pdo);
+    ec_ioctl_strcpy(data->name, pdo->name);
+}
+
+/*****************************************************************************/
+
+/** Fills the PDO entry information of an ioctl() structure.
+ */
+static void ec_ioctl_fill_pdo_entry(
+        ec_ioctl_slave_sync_pdo_entry_t *data, /**< PDO entry information. */
+        const ec_pdo_entry_t *entry /**< PDO entry. */
+        )
+{
+    data->index = entry->index;
+    data->subindex = entry->subindex;
+    data->bit_length = entry->bit_length;
+    ec_ioctl_strcpy(data->name, entry->name);
+}
+
+/*****************************************************************************/
+
 /** Get slave information.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -203,75 +462,32 @@ static ATTRIBUTES int ec_ioctl_slave(
         )
 {
     ec_ioctl_slave_t data;
-    const ec_slave_t *slave;
-    int i;
+    unsigned int seq;
+    int found;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
+    /* Tools poll this for every slave, so it does not take the master
+     * semaphore to avoid delaying the master state machine. The slaves are
+     * freed only after an RCU grace period, see
+     * ec_master_publish_slaves(). */
+    rcu_read_lock();
+    do {
+        seq = read_seqcount_begin(&master->slaves_seq);
+        found = data.position < master->slave_count;
+        if (found) {
+            ec_ioctl_fill_slave(&data, master->slaves + data.position);
+        }
+    } while (read_seqcount_retry(&master->slaves_seq, seq));
+    rcu_read_unlock();
 
-    if (!(slave = ec_master_find_slave_const(
-                    master, 0, data.position))) {
-        up(&master->master_sem);
+    if (!found) {
         EC_MASTER_ERR(master, "Slave %u does not exist!\n", data.position);
         return -EINVAL;
     }
 
-    data.device_index = slave->device_index;
-    data.vendor_id = slave->sii.vendor_id;
-    data.product_code = slave->sii.product_code;
-    data.revision_number = slave->sii.revision_number;
-    data.serial_number = slave->sii.serial_number;
-    data.alias = slave->effective_alias;
-    data.boot_rx_mailbox_offset = slave->sii.boot_rx_mailbox_offset;
-    data.boot_rx_mailbox_size = slave->sii.boot_rx_mailbox_size;
-    data.boot_tx_mailbox_offset = slave->sii.boot_tx_mailbox_offset;
-    data.boot_tx_mailbox_size = slave->sii.boot_tx_mailbox_size;
-    data.std_rx_mailbox_offset = slave->sii.std_rx_mailbox_offset;
-    data.std_rx_mailbox_size = slave->sii.std_rx_mailbox_size;
-    data.std_tx_mailbox_offset = slave->sii.std_tx_mailbox_offset;
-    data.std_tx_mailbox_size = slave->sii.std_tx_mailbox_size;
-    data.mailbox_protocols = slave->sii.mailbox_protocols;
-    data.has_general_category = slave->sii.has_general;
-    data.coe_details = slave->sii.coe_details;
-    data.general_flags = slave->sii.general_flags;
-    data.current_on_ebus = slave->sii.current_on_ebus;
-    for (i = 0; i < EC_MAX_PORTS; i++) {
-        data.ports[i].desc = slave->ports[i].desc;
-        data.ports[i].link.link_up = slave->ports[i].link.link_up;
-        data.ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
-        data.ports[i].link.signal_detected =
-            slave->ports[i].link.signal_detected;
-        data.ports[i].receive_time = slave->ports[i].receive_time;
-        if (slave->ports[i].next_slave) {
-            data.ports[i].next_slave =
-                slave->ports[i].next_slave->ring_position;
-        } else {
-            data.ports[i].next_slave = 0xffff;
-        }
-        data.ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
-    }
-    data.fmmu_bit = slave->base_fmmu_bit_operation;
-    data.dc_supported = slave->base_dc_supported;
-    data.dc_range = slave->base_dc_range;
-    data.has_dc_system_time = slave->has_dc_system_time;
-    data.transmission_delay = slave->transmission_delay;
-    data.al_state = slave->current_state;
-    data.error_flag = slave->error_flag;
-
-    data.sync_count = slave->sii.sync_count;
-    data.sdo_count = ec_slave_sdo_count(slave);
-    data.sii_nwords = slave->sii_nwords;
-    ec_ioctl_strcpy(data.group, slave->sii.group);
-    ec_ioctl_strcpy(data.image, slave->sii.image);
-    ec_ioctl_strcpy(data.order, slave->sii.order);
-    ec_ioctl_strcpy(data.name, slave->sii.name);
-
-    up(&master->master_sem);
-
     if (copy_to_user((void __user *) arg, &data, sizeof(data)))
         return -EFAULT;
 
@@ -290,8 +506,9 @@ static ATTRIBUTES int ec_ioctl_slave_sync(
         )
 {
     ec_ioctl_slave_sync_t data;
-    const ec_slave_t *slave;
+    ec_slave_t *slave;
     const ec_sync_t *sync;
+    int ret;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
@@ -300,7 +517,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync(
     if (down_interruptible(&master->master_sem))
         return -EINTR;
 
-    if (!(slave = ec_master_find_slave_const(
+    if (!(slave = ec_master_find_slave(
                     master, 0, data.slave_position))) {
         up(&master->master_sem);
         EC_MASTER_ERR(master, "Slave %u does not exist!\n",
@@ -308,6 +525,12 @@ static ATTRIBUTES int ec_ioctl_slave_sync(
         return -EINVAL;
     }
 
+    ret = ec_slave_load_sii_pdos(slave);
+    if (ret) {
+        up(&master->master_sem);
+        return ret;
+    }
+
     if (data.sync_index >= slave->sii.sync_count) {
         up(&master->master_sem);
         EC_SLAVE_ERR(slave, "Sync manager %u does not exist!\n",
@@ -317,11 +540,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync(
 
     sync = &slave->sii.syncs[data.sync_index];
 
-    data.physical_start_address = sync->physical_start_address;
-    data.default_size = sync->default_length;
-    data.control_register = sync->control_register;
-    data.enable = sync->enable;
-    data.pdo_count = ec_pdo_list_count(&sync->pdos);
+    ec_ioctl_fill_sync(&data, sync);
 
     up(&master->master_sem);
 
@@ -343,9 +562,10 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo(
         )
 {
     ec_ioctl_slave_sync_pdo_t data;
-    const ec_slave_t *slave;
+    ec_slave_t *slave;
     const ec_sync_t *sync;
     const ec_pdo_t *pdo;
+    int ret;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
@@ -354,7 +574,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo(
     if (down_interruptible(&master->master_sem))
         return -EINTR;
 
-    if (!(slave = ec_master_find_slave_const(
+    if (!(slave = ec_master_find_slave(
                     master, 0, data.slave_position))) {
         up(&master->master_sem);
         EC_MASTER_ERR(master, "Slave %u does not exist!\n",
@@ -362,6 +582,12 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo(
         return -EINVAL;
     }
 
+    ret = ec_slave_load_sii_pdos(slave);
+    if (ret) {
+        up(&master->master_sem);
+        return ret;
+    }
+
     if (data.sync_index >= slave->sii.sync_count) {
         up(&master->master_sem);
         EC_SLAVE_ERR(slave, "Sync manager %u does not exist!\n",
@@ -378,9 +604,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo(
         return -EINVAL;
     }
 
-    data.index = pdo->index;
-    data.entry_count = ec_pdo_entry_count(pdo);
-    ec_ioctl_strcpy(data.name, pdo->name);
+    ec_ioctl_fill_pdo(&data, pdo);
 
     up(&master->master_sem);
 
@@ -402,10 +626,11 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo_entry(
         )
 {
     ec_ioctl_slave_sync_pdo_entry_t data;
-    const ec_slave_t *slave;
+    ec_slave_t *slave;
     const ec_sync_t *sync;
     const ec_pdo_t *pdo;
     const ec_pdo_entry_t *entry;
+    int ret;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
@@ -414,7 +639,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo_entry(
     if (down_interruptible(&master->master_sem))
         return -EINTR;
 
-    if (!(slave = ec_master_find_slave_const(
+    if (!(slave = ec_master_find_slave(
                     master, 0, data.slave_position))) {
         up(&master->master_sem);
         EC_MASTER_ERR(master, "Slave %u does not exist!\n",
@@ -422,6 +647,12 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo_entry(
         return -EINVAL;
     }
 
+    ret = ec_slave_load_sii_pdos(slave);
+    if (ret) {
+        up(&master->master_sem);
+        return ret;
+    }
+
     if (data.sync_index >= slave->sii.sync_count) {
         up(&master->master_sem);
         EC_SLAVE_ERR(slave, "Sync manager %u does not exist!\n",
@@ -446,13 +677,178 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo_entry(
         return -EINVAL;
     }
 
-    data.index = entry->index;
-    data.subindex = entry->subindex;
-    data.bit_length = entry->bit_length;
-    ec_ioctl_strcpy(data.name, entry->name);
+    ec_ioctl_fill_pdo_entry(&data, entry);
+
+    up(&master->master_sem);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Copies a snapshot record to the user buffer.
+ *
+ * If \a buffer is NULL, only the offset is advanced.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_ioctl_snapshot_record(
+        uint8_t __user *buffer, /**< User buffer, or NULL. */
+        size_t *offset, /**< Offset in the buffer. */
+        const void *record, /**< Record to copy. */
+        size_t size /**< Size of the record. */
+        )
+{
+    if (buffer && copy_to_user(buffer + *offset, record, size)) {
+        return -EFAULT;
+    }
+
+    *offset += size;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Serializes all slaves with their sync managers, PDOs and PDO entries.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_ioctl_slave_snapshot_fill(
+        const ec_master_t *master, /**< EtherCAT master. */
+        uint8_t __user *buffer, /**< User buffer, or NULL to get the size. */
+        size_t *size /**< Size of the snapshot. */
+        )
+{
+    ec_ioctl_slave_t slave_data;
+    ec_ioctl_slave_sync_t sync_data;
+    ec_ioctl_slave_sync_pdo_t pdo_data;
+    ec_ioctl_slave_sync_pdo_entry_t entry_data;
+    const ec_slave_t *slave;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    unsigned int i, pdo_pos, entry_pos;
+    size_t offset = 0;
+    int ret;
+
+    memset(&slave_data, 0, sizeof(slave_data));
+    memset(&sync_data, 0, sizeof(sync_data));
+    memset(&pdo_data, 0, sizeof(pdo_data));
+    memset(&entry_data, 0, sizeof(entry_data));
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        if (buffer) {
+            ec_ioctl_fill_slave(&slave_data, slave);
+        }
+        ret = ec_ioctl_snapshot_record(buffer, &offset,
+                &slave_data, sizeof(slave_data));
+        if (ret) {
+            return ret;
+        }
+
+        for (i = 0; i < slave->sii.sync_count; i++) {
+            const ec_sync_t *sync = &slave->sii.syncs[i];
+
+            if (buffer) {
+                sync_data.slave_position = slave->ring_position;
+                sync_data.sync_index = i;
+                ec_ioctl_fill_sync(&sync_data, sync);
+            }
+            ret = ec_ioctl_snapshot_record(buffer, &offset,
+                    &sync_data, sizeof(sync_data));
+            if (ret) {
+                return ret;
+            }
+
+            pdo_pos = 0;
+            list_for_each_entry(pdo, &sync->pdos.list, list) {
+                if (buffer) {
+                    pdo_data.slave_position = slave->ring_position;
+                    pdo_data.sync_index = i;
+                    pdo_data.pdo_pos = pdo_pos;
+                    ec_ioctl_fill_pdo(&pdo_data, pdo);
+                }
+                ret = ec_ioctl_snapshot_record(buffer, &offset,
+                        &pdo_data, sizeof(pdo_data));
+                if (ret) {
+                    return ret;
+                }
+
+                entry_pos = 0;
+                list_for_each_entry(entry, &pdo->entries, list) {
+                    if (buffer) {
+                        entry_data.slave_position = slave->ring_position;
+                        entry_data.sync_index = i;
+                        entry_data.pdo_pos = pdo_pos;
+                        entry_data.entry_pos = entry_pos;
+                        ec_ioctl_fill_pdo_entry(&entry_data, entry);
+                    }
+                    ret = ec_ioctl_snapshot_record(buffer, &offset,
+                            &entry_data, sizeof(entry_data));
+                    if (ret) {
+                        return ret;
+                    }
+                    entry_pos++;
+                }
+
+                pdo_pos++;
+            }
+        }
+    }
+
+    *size = offset;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get a snapshot of all slaves, sync managers, PDOs and PDO entries.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_snapshot(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< Userspace address to store the results. */
+        )
+{
+    ec_ioctl_slave_snapshot_t data;
+    ec_slave_t *slave;
+    size_t size;
+    int ret;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    for (slave = master->slaves;
+            slave < master->slaves + master->slave_count; slave++) {
+        ret = ec_slave_load_sii_pdos(slave);
+        if (ret) {
+            up(&master->master_sem);
+            return ret;
+        }
+    }
+
+    ret = ec_ioctl_slave_snapshot_fill(master, NULL, &size);
+    if (!ret && size <= data.buffer_size) {
+        ret = ec_ioctl_slave_snapshot_fill(master,
+                (uint8_t __user *) data.buffer, &size);
+    }
+    data.data_size = size;
+    data.slave_count = master->slave_count;
 
     up(&master->master_sem);
 
+    if (ret) {
+        return ret;
+    }
+
     if (copy_to_user((void __user *) arg, &data, sizeof(data)))
         return -EFAULT;
 
@@ -472,6 +868,7 @@ static ATTRIBUTES int ec_ioctl_domain(
 {
     ec_ioctl_domain_t data;
     const ec_domain_t *domain;
+    const ec_datagram_pair_t *pair;
     unsigned int dev_idx;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
@@ -495,6 +892,17 @@ static ATTRIBUTES int ec_ioctl_domain(
     }
     data.expected_working_counter = domain->expected_working_counter;
     data.fmmu_count = ec_domain_fmmu_count(domain);
+    data.datagram_count = 0;
+    data.datagram_bytes = 0;
+    list_for_each_entry(pair, &domain->datagram_pairs, list) {
+        if (pair->pipeline_slot) {
+            continue; // the other slots are sent in other cycles
+        }
+        data.datagram_count++;
+        data.datagram_bytes += pair->datagrams[EC_DEVICE_MAIN].data_size;
+    }
+    data.cycle_divisor = domain->cycle_divisor;
+    data.wc_fault_count = ec_domain_wc_faults(domain, data.wc_fault_slaves);
 
     up(&master->master_sem);
 
@@ -546,6 +954,7 @@ static ATTRIBUTES int ec_ioctl_domain_fmmu(
     data.sync_index = fmmu->sync_index;
     data.dir = fmmu->dir;
     data.logical_address = fmmu->logical_start_address;
+    data.data_offset = fmmu->data_offset;
     data.data_size = fmmu->data_size;
 
     up(&master->master_sem);
@@ -591,6 +1000,8 @@ static ATTRIBUTES int ec_ioctl_domain_data(
         return -EFAULT;
     }
 
+    data.process_count = domain->process_count;
+
     if (copy_to_user((void __user *) data.target, domain->data,
                 domain->data_size)) {
         up(&master->master_sem);
@@ -598,29 +1009,80 @@ static ATTRIBUTES int ec_ioctl_domain_data(
     }
 
     up(&master->master_sem);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
+    }
+
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Set master debug level.
+/** Maps the memory of the application read-only.
+ *
+ * After this call, mmap() on the file handle maps the process data and the
+ * state page of the application, that activated the master. Monitoring tools
+ * can so read the process data without system calls. The domains are
+ * described by ec_ioctl_state_page_t::domain_maps.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_master_debug(
+static ATTRIBUTES int ec_ioctl_map_read_only(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    return ec_master_debug_level(master, (unsigned long) arg);
-}
+    ec_ioctl_map_read_only_t data;
 
-/*****************************************************************************/
+    if (ctx->process_data) {
+        return -EBUSY; // the file handle maps its own memory
+    }
 
-/** Issue a bus scan.
- *
- * \return Always zero (success).
- */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!master->mapped_mem) {
+        up(&master->master_sem);
+        return -ENXIO;
+    }
+
+    data.mmap_size = master->mapped_mem_size;
+    data.state_offset = data.mmap_size - PAGE_ALIGN(
+            sizeof(ec_ioctl_state_page_t));
+
+    up(&master->master_sem);
+
+    ctx->read_only_map = 1;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Set master debug level.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_master_debug(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    return ec_master_debug_level(master, (unsigned long) arg);
+}
+
+/*****************************************************************************/
+
+/** Issue a bus scan.
+ *
+ * \return Always zero (success).
+ */
 static ATTRIBUTES int ec_ioctl_master_rescan(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg /**< ioctl() argument. */
@@ -703,6 +1165,7 @@ static ATTRIBUTES int ec_ioctl_slave_sdo(
     }
 
     data.sdo_index = sdo->index;
+    data.object_code = sdo->object_code;
     data.max_subindex = sdo->max_subindex;
     ec_ioctl_strcpy(data.name, sdo->name);
 
@@ -729,11 +1192,13 @@ static ATTRIBUTES int ec_ioctl_slave_sdo_entry(
     const ec_slave_t *slave;
     const ec_sdo_t *sdo;
     const ec_sdo_entry_t *entry;
+    int fetched = 0;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
+lookup:
     if (down_interruptible(&master->master_sem))
         return -EINTR;
 
@@ -762,6 +1227,20 @@ static ATTRIBUTES int ec_ioctl_slave_sdo_entry(
         }
     }
 
+    if (sdo->entries_pending && !fetched) {
+        // entry descriptions are read on the first access
+        uint16_t index = sdo->index;
+        int ret;
+
+        up(&master->master_sem);
+        ret = ec_master_fetch_sdo_entries(master, data.slave_position, index);
+        if (ret == -EINTR) {
+            return ret;
+        }
+        fetched = 1;
+        goto lookup;
+    }
+
     if (!(entry = ec_sdo_get_entry_const(
                     sdo, data.sdo_entry_subindex))) {
         up(&master->master_sem);
@@ -796,6 +1275,159 @@ static ATTRIBUTES int ec_ioctl_slave_sdo_entry(
 
 /*****************************************************************************/
 
+/** Copies an SDO name or entry description from an import record.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_ioctl_dict_string(
+        char **target, /**< Target pointer, remains NULL for empty strings. */
+        const int8_t *source /**< Source with EC_IOCTL_STRING_SIZE bytes. */
+        )
+{
+    size_t len = strnlen((const char *) source, EC_IOCTL_STRING_SIZE - 1);
+
+    if (!len) {
+        return 0;
+    }
+
+    if (!(*target = kmalloc(len + 1, GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    memcpy(*target, source, len);
+    (*target)[len] = 0;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Import an SDO dictionary into the dictionary cache.
+ *
+ * Slaves of the given type, that did not read their dictionary yet, use the
+ * imported dictionary instead of reading it from the bus.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_dict_import(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_dict_import_t data;
+    ec_ioctl_dict_sdo_t *sdos;
+    ec_ioctl_dict_entry_t *entries;
+    ec_dict_t *dict;
+    ec_sdo_t *sdo;
+    ec_sdo_entry_t *entry;
+    uint32_t i, j;
+    int ret = 0;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (!data.sdo_count || data.sdo_count > 0x10000) {
+        return -EINVAL;
+    }
+
+    if (!(sdos = vmalloc(data.sdo_count * sizeof(*sdos)))) {
+        return -ENOMEM;
+    }
+
+    if (!(entries = vmalloc(0x100 * sizeof(*entries)))) {
+        vfree(sdos);
+        return -ENOMEM;
+    }
+
+    if (!(dict = kmalloc(sizeof(ec_dict_t), GFP_KERNEL))) {
+        ret = -ENOMEM;
+        goto out_free;
+    }
+
+    ec_dict_init(dict, data.vendor_id, data.product_code,
+            data.revision_number);
+
+    if (copy_from_user(sdos, (void __user *) data.sdos,
+                data.sdo_count * sizeof(*sdos))) {
+        ret = -EFAULT;
+        goto out_clear;
+    }
+
+    for (i = 0; i < data.sdo_count; i++) {
+        if (sdos[i].entry_count > 0x100) {
+            ret = -EINVAL;
+            goto out_clear;
+        }
+
+        if (copy_from_user(entries, (void __user *) sdos[i].entries,
+                    sdos[i].entry_count * sizeof(*entries))) {
+            ret = -EFAULT;
+            goto out_clear;
+        }
+
+        if (!(sdo = kmalloc(sizeof(ec_sdo_t), GFP_KERNEL))) {
+            ret = -ENOMEM;
+            goto out_clear;
+        }
+
+        ec_sdo_init(sdo, dict, sdos[i].index);
+        list_add_tail(&sdo->list, &dict->sdos);
+        sdo->object_code = sdos[i].object_code;
+        sdo->max_subindex = sdos[i].max_subindex;
+        if ((ret = ec_ioctl_dict_string(&sdo->name, sdos[i].name))) {
+            goto out_clear;
+        }
+
+        for (j = 0; j < sdos[i].entry_count; j++) {
+            if (!(entry = kmalloc(sizeof(ec_sdo_entry_t), GFP_KERNEL))) {
+                ret = -ENOMEM;
+                goto out_clear;
+            }
+
+            ec_sdo_entry_init(entry, sdo, entries[j].subindex);
+            list_add_tail(&entry->list, &sdo->entries);
+            entry->data_type = entries[j].data_type;
+            entry->bit_length = entries[j].bit_length;
+            memcpy(entry->read_access, entries[j].read_access,
+                    sizeof(entry->read_access));
+            memcpy(entry->write_access, entries[j].write_access,
+                    sizeof(entry->write_access));
+            if ((ret = ec_ioctl_dict_string(&entry->description,
+                            entries[j].description))) {
+                goto out_clear;
+            }
+        }
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_clear;
+    }
+
+    ret = ec_master_dict_cache_store(master, dict);
+
+    up(&master->master_sem);
+
+    if (!ret) {
+        EC_MASTER_DBG(master, 1, "Imported SDO dictionary with %u SDOs for"
+                " vendor 0x%08X, product 0x%08X, revision 0x%08X.\n",
+                data.sdo_count, data.vendor_id, data.product_code,
+                data.revision_number);
+    }
+
+out_clear:
+    if (ret) {
+        ec_dict_clear(dict);
+        kfree(dict);
+    }
+out_free:
+    vfree(entries);
+    vfree(sdos);
+    return ret;
+}
+
+/*****************************************************************************/
+
 /** Upload SDO.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -806,32 +1438,47 @@ static ATTRIBUTES int ec_ioctl_slave_sdo_upload(
         )
 {
     ec_ioctl_slave_sdo_upload_t data;
-    uint8_t *target;
+    ec_sdo_request_t request;
     int ret;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    if (!(target = kmalloc(data.target_size, GFP_KERNEL))) {
-        EC_MASTER_ERR(master, "Failed to allocate %zu bytes"
-                " for SDO upload.\n", data.target_size);
-        return -ENOMEM;
+    /* The request memory is allocated with the size announced by the
+     * slave, so the target size is only needed for the final copy. */
+    ec_sdo_request_init(&request);
+    if (data.complete_access) {
+        ecrt_sdo_request_index_complete(&request, data.sdo_index);
+    } else {
+        ecrt_sdo_request_index(&request, data.sdo_index,
+                data.sdo_entry_subindex);
     }
+    ecrt_sdo_request_read(&request);
 
-    ret = ecrt_master_sdo_upload(master, data.slave_position,
-            data.sdo_index, data.sdo_entry_subindex, target,
-            data.target_size, &data.data_size, &data.abort_code);
+    ret = ec_master_exec_sdo_request(master, data.slave_position, &request);
+    if (ret) {
+        ec_sdo_request_clear(&request);
+        return ret;
+    }
 
-    if (!ret) {
-        if (copy_to_user((void __user *) data.target,
-                    target, data.data_size)) {
-            kfree(target);
-            return -EFAULT;
-        }
+    data.abort_code = request.abort_code;
+    data.data_size = 0;
+
+    if (request.state != EC_INT_REQUEST_SUCCESS) {
+        ret = request.errno ? -request.errno : -EIO;
+    } else if (request.data_size > data.target_size) {
+        EC_MASTER_ERR(master, "%s(): Buffer too small.\n", __func__);
+        ret = -EOVERFLOW;
+    } else if (copy_to_user((void __user *) data.target,
+                request.data, request.data_size)) {
+        ec_sdo_request_clear(&request);
+        return -EFAULT;
+    } else {
+        data.data_size = request.data_size;
     }
 
-    kfree(target);
+    ec_sdo_request_clear(&request);
 
     if (__copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
@@ -994,10 +1641,13 @@ static ATTRIBUTES int ec_ioctl_slave_sii_write(
     request.words = words;
     request.offset = data.offset;
     request.nwords = data.nwords;
+    request.verify = 0;
+    request.verify_error = 0;
     request.state = EC_INT_REQUEST_QUEUED;
 
     // schedule SII write request.
-    list_add_tail(&request.list, &master->sii_requests);
+    list_add_tail(&request.list, &slave->sii_requests);
+    ec_master_kick_slave_fsm(master, slave);
 
     up(&master->master_sem);
 
@@ -1016,7 +1666,7 @@ static ATTRIBUTES int ec_ioctl_slave_sii_write(
         up(&master->master_sem);
     }
 
-    // wait until master FSM has finished processing
+    // wait until slave FSM has finished processing
     wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
 
     kfree(words);
@@ -1026,167 +1676,511 @@ static ATTRIBUTES int ec_ioctl_slave_sii_write(
 
 /*****************************************************************************/
 
-/** Read a slave's registers.
+/** Read the SII images of several slaves.
+ *
+ * The images are the ones read during the bus scan, so the bus is not
+ * accessed.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_slave_reg_read(
+static ATTRIBUTES int ec_ioctl_slave_sii_read_batch(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_slave_reg_t io;
-    ec_slave_t *slave;
-    ec_reg_request_t request;
-    int ret;
+    ec_ioctl_slave_sii_batch_t io;
+    ec_ioctl_slave_sii_batch_slave_t *slaves;
+    const ec_slave_t *slave;
+    uint32_t i, offset = 0;
+    int ret = 0;
 
     if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
         return -EFAULT;
     }
 
-    if (!io.size) {
-        return 0;
+    if (!io.slave_count || io.slave_count > master->slave_count) {
+        return -EINVAL;
     }
 
-    // init register request
-    ret = ec_reg_request_init(&request, io.size);
-    if (ret) {
-        return ret;
+    if (!(slaves = vmalloc(io.slave_count * sizeof(*slaves)))) {
+        return -ENOMEM;
     }
 
-    ecrt_reg_request_read(&request, io.address, io.size);
+    if (copy_from_user(slaves, (void __user *) io.slaves,
+                io.slave_count * sizeof(*slaves))) {
+        vfree(slaves);
+        return -EFAULT;
+    }
 
     if (down_interruptible(&master->master_sem)) {
-        ec_reg_request_clear(&request);
+        vfree(slaves);
         return -EINTR;
     }
 
-    if (!(slave = ec_master_find_slave(
-                    master, 0, io.slave_position))) {
-        up(&master->master_sem);
-        ec_reg_request_clear(&request);
-        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
-                io.slave_position);
-        return -EINVAL;
+    for (i = 0; i < io.slave_count; i++) {
+        if (!(slave = ec_master_find_slave_const(
+                        master, 0, slaves[i].slave_position))) {
+            up(&master->master_sem);
+            EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                    slaves[i].slave_position);
+            vfree(slaves);
+            return -EINVAL;
+        }
+        slaves[i].word_offset = offset;
+        slaves[i].nwords = slave->sii_nwords;
+        offset += slave->sii_nwords;
     }
 
-    // schedule request.
-    list_add_tail(&request.list, &slave->reg_requests);
+    io.data_nwords = offset;
+
+    if (offset <= io.nwords) {
+        for (i = 0; i < io.slave_count && !ret; i++) {
+            slave = ec_master_find_slave_const(
+                    master, 0, slaves[i].slave_position);
+            if (copy_to_user((void __user *)
+                        (io.words + slaves[i].word_offset),
+                        slave->sii_words, slaves[i].nwords * 2)) {
+                ret = -EFAULT;
+            }
+        }
+    }
 
     up(&master->master_sem);
 
-    // wait for processing through FSM
-    if (wait_event_interruptible(master->request_queue,
-                request.state != EC_INT_REQUEST_QUEUED)) {
-        // interrupted by signal
-        down(&master->master_sem);
-        if (request.state == EC_INT_REQUEST_QUEUED) {
-            // abort request
-            list_del(&request.list);
-            up(&master->master_sem);
-            ec_reg_request_clear(&request);
-            return -EINTR;
-        }
-        up(&master->master_sem);
+    if (!ret && (copy_to_user((void __user *) io.slaves, slaves,
+                    io.slave_count * sizeof(*slaves))
+                || copy_to_user((void __user *) arg, &io, sizeof(io)))) {
+        ret = -EFAULT;
     }
 
-    // wait until master FSM has finished processing
-    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+    vfree(slaves);
+    return ret;
+}
 
-    if (request.state == EC_INT_REQUEST_SUCCESS) {
-        if (copy_to_user((void __user *) io.data, request.data, io.size)) {
-            return -EFAULT;
+/*****************************************************************************/
+
+/** Counts the SII write requests in a certain state.
+ *
+ * \return Number of requests.
+ */
+static uint32_t ec_ioctl_sii_requests_in_state(
+        const ec_sii_write_request_t *requests, /**< SII write requests. */
+        uint32_t count, /**< Number of requests. */
+        ec_internal_request_state_t state /**< Request state. */
+        )
+{
+    uint32_t i, n = 0;
+
+    for (i = 0; i < count; i++) {
+        if (requests[i].state == state) {
+            n++;
         }
     }
-    ec_reg_request_clear(&request);
 
-    return request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
+    return n;
 }
 
 /*****************************************************************************/
 
-/** Write a slave's registers.
+/** Write the same SII contents to several slaves.
+ *
+ * The master state machine writes to the slaves in parallel. The result of
+ * every slave is returned in its batch entry.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_slave_reg_write(
+static ATTRIBUTES int ec_ioctl_slave_sii_write_batch(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_slave_reg_t io;
+    ec_ioctl_slave_sii_batch_t io;
+    ec_ioctl_slave_sii_batch_slave_t *slaves = NULL;
+    ec_sii_write_request_t *requests = NULL;
     ec_slave_t *slave;
-    ec_reg_request_t request;
-    int ret;
+    uint16_t *words = NULL;
+    uint32_t i;
+    int ret = 0;
 
     if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
         return -EFAULT;
     }
 
-    if (!io.size) {
+    if (!io.nwords) {
         return 0;
     }
 
-    // init register request
-    ret = ec_reg_request_init(&request, io.size);
-    if (ret) {
-        return ret;
+    if (!io.slave_count || io.slave_count > master->slave_count) {
+        return -EINVAL;
     }
 
-    if (copy_from_user(request.data, (void __user *) io.data, io.size)) {
-        ec_reg_request_clear(&request);
-        return -EFAULT;
+    if (!(slaves = vmalloc(io.slave_count * sizeof(*slaves)))
+            || !(requests = vmalloc(io.slave_count * sizeof(*requests)))
+            || !(words = vmalloc(io.nwords * sizeof(*words)))) {
+        ret = -ENOMEM;
+        goto out_free;
     }
 
-    ecrt_reg_request_write(&request, io.address, io.size);
+    if (copy_from_user(slaves, (void __user *) io.slaves,
+                io.slave_count * sizeof(*slaves))
+            || copy_from_user(words, (void __user *) io.words,
+                io.nwords * sizeof(*words))) {
+        ret = -EFAULT;
+        goto out_free;
+    }
 
     if (down_interruptible(&master->master_sem)) {
-        ec_reg_request_clear(&request);
-        return -EINTR;
+        ret = -EINTR;
+        goto out_free;
     }
 
-    if (io.emergency) {
-        request.ring_position = io.slave_position;
-        // schedule request.
-        list_add_tail(&request.list, &master->emerg_reg_requests);
-    }
-    else {
-        if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+    for (i = 0; i < io.slave_count; i++) {
+        if (!(slave = ec_master_find_slave(
+                        master, 0, slaves[i].slave_position))) {
             up(&master->master_sem);
-            ec_reg_request_clear(&request);
             EC_MASTER_ERR(master, "Slave %u does not exist!\n",
-                    io.slave_position);
-            return -EINVAL;
+                    slaves[i].slave_position);
+            ret = -EINVAL;
+            goto out_free;
         }
 
-        // schedule request.
-        list_add_tail(&request.list, &slave->reg_requests);
+        INIT_LIST_HEAD(&requests[i].list);
+        requests[i].slave = slave;
+        requests[i].words = words;
+        requests[i].offset = io.offset;
+        requests[i].nwords = io.nwords;
+        requests[i].verify = io.verify;
+        requests[i].verify_error = 0;
+        requests[i].state = EC_INT_REQUEST_QUEUED;
+    }
+
+    // schedule SII write requests
+    for (i = 0; i < io.slave_count; i++) {
+        list_add_tail(&requests[i].list, &requests[i].slave->sii_requests);
+        ec_master_kick_slave_fsm(master, requests[i].slave);
     }
 
     up(&master->master_sem);
 
     // wait for processing through FSM
     if (wait_event_interruptible(master->request_queue,
-                request.state != EC_INT_REQUEST_QUEUED)) {
-        // interrupted by signal
+                !ec_ioctl_sii_requests_in_state(requests, io.slave_count,
+                    EC_INT_REQUEST_QUEUED))) {
+        // interrupted by signal: abort the requests not started yet
         down(&master->master_sem);
-        if (request.state == EC_INT_REQUEST_QUEUED) {
-            // abort request
-            list_del(&request.list);
-            up(&master->master_sem);
-            ec_reg_request_clear(&request);
-            return -EINTR;
+        for (i = 0; i < io.slave_count; i++) {
+            if (requests[i].state == EC_INT_REQUEST_QUEUED) {
+                list_del(&requests[i].list);
+                requests[i].state = EC_INT_REQUEST_FAILURE;
+            }
         }
         up(&master->master_sem);
+        ret = -EINTR;
     }
 
-    // wait until master FSM has finished processing
-    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+    // wait until slave FSMs has finished processing
+    wait_event(master->request_queue,
+            !ec_ioctl_sii_requests_in_state(requests, io.slave_count,
+                EC_INT_REQUEST_BUSY));
 
-    ec_reg_request_clear(&request);
+    if (ret) {
+        goto out_free;
+    }
 
-    return request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
-}
+    for (i = 0; i < io.slave_count; i++) {
+        slaves[i].state =
+            ec_request_state_translation_table[requests[i].state];
+        slaves[i].verify_error = requests[i].verify_error;
+    }
+
+    if (copy_to_user((void __user *) io.slaves, slaves,
+                io.slave_count * sizeof(*slaves))) {
+        ret = -EFAULT;
+    }
+
+out_free:
+    if (words) {
+        vfree(words);
+    }
+    if (requests) {
+        vfree(requests);
+    }
+    if (slaves) {
+        vfree(slaves);
+    }
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Read a slave's registers.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_reg_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_slave_reg_t io;
+    ec_slave_t *slave;
+    ec_reg_request_t request;
+    int ret;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!io.size) {
+        return 0;
+    }
+
+    // init register request
+    ret = ec_reg_request_init(&request, io.size);
+    if (ret) {
+        return ret;
+    }
+
+    ecrt_reg_request_read(&request, io.address, io.size);
+
+    if (down_interruptible(&master->master_sem)) {
+        ec_reg_request_clear(&request);
+        return -EINTR;
+    }
+
+    if (!(slave = ec_master_find_slave(
+                    master, 0, io.slave_position))) {
+        up(&master->master_sem);
+        ec_reg_request_clear(&request);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                io.slave_position);
+        return -EINVAL;
+    }
+
+    // schedule request.
+    list_add_tail(&request.list, &slave->reg_requests);
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+
+    // wait for processing through FSM
+    if (wait_event_interruptible(master->request_queue,
+                request.state != EC_INT_REQUEST_QUEUED)) {
+        // interrupted by signal
+        down(&master->master_sem);
+        if (request.state == EC_INT_REQUEST_QUEUED) {
+            // abort request
+            list_del(&request.list);
+            up(&master->master_sem);
+            ec_reg_request_clear(&request);
+            return -EINTR;
+        }
+        up(&master->master_sem);
+    }
+
+    // wait until master FSM has finished processing
+    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+
+    if (request.state == EC_INT_REQUEST_SUCCESS) {
+        if (copy_to_user((void __user *) io.data, request.data, io.size)) {
+            return -EFAULT;
+        }
+    }
+    ec_reg_request_clear(&request);
+
+    return request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
+}
+
+/*****************************************************************************/
+
+/** Write a slave's registers.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_reg_write(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_slave_reg_t io;
+    ec_slave_t *slave;
+    ec_reg_request_t request;
+    int ret;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!io.size) {
+        return 0;
+    }
+
+    // init register request
+    ret = ec_reg_request_init(&request, io.size);
+    if (ret) {
+        return ret;
+    }
+
+    if (copy_from_user(request.data, (void __user *) io.data, io.size)) {
+        ec_reg_request_clear(&request);
+        return -EFAULT;
+    }
+
+    ecrt_reg_request_write(&request, io.address, io.size);
+
+    if (down_interruptible(&master->master_sem)) {
+        ec_reg_request_clear(&request);
+        return -EINTR;
+    }
+
+    if (io.emergency) {
+        request.ring_position = io.slave_position;
+        // schedule request.
+        list_add_tail(&request.list, &master->emerg_reg_requests);
+    }
+    else {
+        if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+            up(&master->master_sem);
+            ec_reg_request_clear(&request);
+            EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                    io.slave_position);
+            return -EINVAL;
+        }
+
+        // schedule request.
+        list_add_tail(&request.list, &slave->reg_requests);
+        ec_master_kick_slave_fsm(master, slave);
+    }
+
+    up(&master->master_sem);
+
+    // wait for processing through FSM
+    if (wait_event_interruptible(master->request_queue,
+                request.state != EC_INT_REQUEST_QUEUED)) {
+        // interrupted by signal
+        down(&master->master_sem);
+        if (request.state == EC_INT_REQUEST_QUEUED) {
+            // abort request
+            list_del(&request.list);
+            up(&master->master_sem);
+            ec_reg_request_clear(&request);
+            return -EINTR;
+        }
+        up(&master->master_sem);
+    }
+
+    // wait until master FSM has finished processing
+    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+
+    ec_reg_request_clear(&request);
+
+    return request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
+}
+
+/*****************************************************************************/
+
+/** Read or write the registers of several slaves.
+ *
+ * The working counter of every slave is returned; a slave that could not be
+ * accessed does not fail the whole request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_reg_batch(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_direction_t dir /**< Transfer direction. */
+        )
+{
+    ec_ioctl_slave_reg_batch_t io;
+    ec_reg_batch_t batch;
+    size_t data_size;
+    int ret;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!io.slave_count || !io.size) {
+        return 0;
+    }
+
+    if (io.slave_count > 0x10000
+            || (uint32_t) io.address + io.size > 0x10000) {
+        return -EINVAL;
+    }
+
+    ret = ec_reg_batch_init(&batch, io.slave_count, io.size);
+    if (ret) {
+        return ret;
+    }
+    data_size = io.slave_count * io.size;
+
+    if (copy_from_user(batch.positions, (void __user *) io.slave_positions,
+                io.slave_count * sizeof(*batch.positions))) {
+        ret = -EFAULT;
+        goto out_clear;
+    }
+
+    if (dir == EC_DIR_OUTPUT && copy_from_user(batch.data,
+                (void __user *) io.data, data_size)) {
+        ret = -EFAULT;
+        goto out_clear;
+    }
+
+    batch.dir = dir;
+    batch.address = io.address;
+    batch.state = EC_INT_REQUEST_QUEUED;
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_clear;
+    }
+
+    // schedule request.
+    list_add_tail(&batch.list, &master->reg_batches);
+
+    up(&master->master_sem);
+
+    // wait for processing through FSM
+    if (wait_event_interruptible(master->request_queue,
+                batch.state != EC_INT_REQUEST_QUEUED)) {
+        // interrupted by signal
+        down(&master->master_sem);
+        if (batch.state == EC_INT_REQUEST_QUEUED) {
+            // abort request
+            list_del(&batch.list);
+            up(&master->master_sem);
+            ret = -EINTR;
+            goto out_clear;
+        }
+        up(&master->master_sem);
+    }
+
+    // wait until master FSM has finished processing
+    wait_event(master->request_queue, batch.state != EC_INT_REQUEST_BUSY);
+
+    if (batch.state != EC_INT_REQUEST_SUCCESS) {
+        ret = -EIO;
+        goto out_clear;
+    }
+
+    if (dir == EC_DIR_INPUT && copy_to_user((void __user *) io.data,
+                batch.data, data_size)) {
+        ret = -EFAULT;
+        goto out_clear;
+    }
+
+    if (copy_to_user((void __user *) io.working_counters,
+                batch.working_counters,
+                io.slave_count * sizeof(*batch.working_counters))) {
+        ret = -EFAULT;
+    }
+
+out_clear:
+    ec_reg_batch_clear(&batch);
+    return ret;
+}
 
 /*****************************************************************************/
 
@@ -1536,8 +2530,11 @@ static ATTRIBUTES int ec_ioctl_eoe_handler(
     data.rx_rate = eoe->tx_rate;
     data.tx_bytes = eoe->stats.rx_bytes;
     data.tx_rate = eoe->tx_rate;
-    data.tx_queued_frames = eoe->tx_queued_frames;
+    data.tx_queued_frames = skb_queue_len(&eoe->tx_queue);
+    data.tx_queued_bytes = eoe->tx_queued_bytes;
     data.tx_queue_size = eoe->tx_queue_size;
+    data.tx_queue_bytes = eoe->tx_queue_bytes;
+    data.tx_dropped = eoe->stats.tx_dropped;
 
     up(&master->master_sem);
 
@@ -1576,26 +2573,88 @@ static ATTRIBUTES int ec_ioctl_request(
 
 /*****************************************************************************/
 
-/** Create a domain.
+#ifndef EC_IOCTL_RTDM
+
+/** Request the master from userspace for sharing with other applications.
  *
- * \return Domain index on success, otherwise a negative error code.
+ * Not available via RTDM, because the sharing applications serialize their
+ * cyclic calls with a semaphore.
+ *
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_create_domain(
+static ATTRIBUTES int ec_ioctl_request_shared(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_domain_t *domain;
+    ec_master_t *m;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (ctx->requested) {
+        return -EBUSY;
+    }
 
-    domain = ecrt_master_create_domain_err(master);
-    if (IS_ERR(domain))
-        return PTR_ERR(domain);
+    m = ec_request_master_shared_err(master->index);
+    if (IS_ERR(m)) {
+        return PTR_ERR(m);
+    }
 
-    return domain->index;
+    ctx->requested = 1;
+    return 0;
+}
+
+#endif
+
+/*****************************************************************************/
+
+/** Create a domain.
+ *
+ * \return Domain index on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_create_domain(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    domain = ecrt_master_create_domain_err(master);
+    if (IS_ERR(domain))
+        return PTR_ERR(domain);
+
+    domain->owner = ctx;
+    return domain->index;
+}
+
+/*****************************************************************************/
+
+/** Determines the index of a slave configuration.
+ *
+ * \return Configuration index, otherwise a negative error code.
+ */
+static int ec_ioctl_config_index(
+        ec_master_t *master, /**< EtherCAT master. */
+        const ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    const ec_slave_config_t *entry;
+    int index = 0;
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    list_for_each_entry(entry, &master->configs, list) {
+        if (entry == sc)
+            break;
+        index++;
+    }
+
+    up(&master->master_sem);
+    return index;
 }
 
 /*****************************************************************************/
@@ -1611,7 +2670,8 @@ static ATTRIBUTES int ec_ioctl_create_slave_config(
         )
 {
     ec_ioctl_config_t data;
-    ec_slave_config_t *sc, *entry;
+    ec_slave_config_t *sc;
+    int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -1625,19 +2685,21 @@ static ATTRIBUTES int ec_ioctl_create_slave_config(
     if (IS_ERR(sc))
         return PTR_ERR(sc);
 
-    data.config_index = 0;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    list_for_each_entry(entry, &master->configs, list) {
-        if (entry == sc)
-            break;
-        data.config_index++;
+    down(&master->master_sem);
+    if (sc->owner && sc->owner != ctx) {
+        up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave %u:%u is configured by another"
+                " application!\n", data.alias, data.position);
+        return -EBUSY;
     }
-
+    sc->owner = ctx;
     up(&master->master_sem);
 
+    ret = ec_ioctl_config_index(master, sc);
+    if (ret < 0)
+        return ret;
+    data.config_index = ret;
+
     if (copy_to_user((void __user *) arg, &data, sizeof(data)))
         return -EFAULT;
 
@@ -1687,6 +2749,71 @@ out_return:
 
 /*****************************************************************************/
 
+/** Select the domain for the DC datagrams.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_select_dc_domain(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    unsigned long domain_index = (unsigned long) arg;
+    ec_domain_t *domain = NULL;
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        ret = -EPERM;
+        goto out_return;
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_return;
+    }
+
+    if (domain_index != 0xFFFFFFFF) {
+        if (!(domain = ec_master_find_domain(master, domain_index))) {
+            ret = -ENOENT;
+            goto out_up;
+        }
+    }
+
+    ret = ecrt_master_select_dc_domain(master, domain);
+
+out_up:
+    up(&master->master_sem);
+out_return:
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Returns the size of a VoE handler's memory in the mapped area.
+ *
+ * The memory has to hold the slave's mailboxes, because it can not be
+ * re-allocated after mapping.
+ *
+ * \return Memory size in bytes.
+ */
+static size_t ec_ioctl_voe_map_size(
+        const ec_voe_handler_t *voe /**< VoE handler. */
+        )
+{
+    size_t size = voe->datagram.mem_size;
+    const ec_slave_t *slave = voe->config->slave;
+
+    if (slave) {
+        size = max_t(size_t, size, slave->configured_rx_mailbox_size);
+        size = max_t(size_t, size, slave->configured_tx_mailbox_size);
+    }
+
+    return ALIGN(size, 8);
+}
+
+/*****************************************************************************/
+
 /** Activates the master.
  *
  * \return Zero on success, otherwise a negative error code.
@@ -1699,12 +2826,19 @@ static ATTRIBUTES int ec_ioctl_activate(
 {
     ec_ioctl_master_activate_t io;
     ec_domain_t *domain;
-    off_t offset;
-    int ret;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+    off_t offset, voe_offset, history_offset;
+    size_t voe_size = 0, history_size = 0, size;
+    int activate = 1, ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
     io.process_data = NULL;
 
     /* Get the sum of the domains' process data sizes. */
@@ -1715,51 +2849,191 @@ static ATTRIBUTES int ec_ioctl_activate(
         return -EINTR;
 
     list_for_each_entry(domain, &master->domains, list) {
+        if (domain->owner != ctx) {
+            continue; // domain of another application sharing the master
+        }
+        ctx->process_data_size =
+            ALIGN(ctx->process_data_size, domain->alignment);
         ctx->process_data_size += ecrt_domain_size(domain);
+        history_size += ec_history_mem_size(&domain->history,
+                ecrt_domain_size(domain));
+    }
+
+    list_for_each_entry(sc, &master->configs, list) {
+        if (sc->owner != ctx) {
+            continue;
+        }
+        list_for_each_entry(voe, &sc->voe_handlers, list) {
+            voe_size += ec_ioctl_voe_map_size(voe);
+        }
     }
 
     up(&master->master_sem);
 
-    if (ctx->process_data_size) {
-        ctx->process_data = vmalloc(ctx->process_data_size);
+    /* The state page follows the process data on a page boundary, the VoE
+     * handler memory and the domains' history rings follow the state page.
+     */
+    io.state_offset = PAGE_ALIGN(ctx->process_data_size);
+    voe_offset = io.state_offset + PAGE_ALIGN(sizeof(*ctx->state));
+    history_offset = voe_offset + PAGE_ALIGN(voe_size);
+    ctx->mmap_size = history_offset + PAGE_ALIGN(history_size);
+
+    ctx->map_flags = io.map_flags;
+    ctx->process_data = NULL;
+
+    if (ctx->map_flags & EC_MAP_CONTIGUOUS) {
+        ctx->process_data = alloc_pages_exact(ctx->mmap_size,
+                GFP_KERNEL | __GFP_NOWARN);
         if (!ctx->process_data) {
-            ctx->process_data_size = 0;
-            return -ENOMEM;
+            EC_MASTER_WARN(master, "Failed to allocate %zu bytes of"
+                    " contiguous process data memory.\n", ctx->mmap_size);
+            ctx->map_flags &= ~EC_MAP_CONTIGUOUS;
         }
+    }
 
-        /* Set the memory as external process data memory for the
-         * domains.
-         */
-        offset = 0;
-        list_for_each_entry(domain, &master->domains, list) {
-            ecrt_domain_external_memory(domain,
-                    ctx->process_data + offset);
-            offset += ecrt_domain_size(domain);
+    if (!ctx->process_data) {
+        ctx->process_data = vmalloc_node(ctx->mmap_size,
+                ec_master_node(master));
+    }
+
+    if (!ctx->process_data) {
+        ctx->process_data_size = 0;
+        ctx->mmap_size = 0;
+        return -ENOMEM;
+    }
+
+    /* Set the memory as external process data memory for the
+     * domains.
+     */
+    offset = 0;
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->owner != ctx) {
+            continue;
         }
+        offset = ALIGN(offset, domain->alignment);
+        ecrt_domain_external_memory(domain,
+                ctx->process_data + offset);
+        offset += ecrt_domain_size(domain);
+    }
 
-#ifdef EC_IOCTL_RTDM
-        /* RTDM uses a different approach for memory-mapping, which has to be
-         * initiated by the kernel.
-         */
-        ret = ec_rtdm_mmap(ctx, &io.process_data);
-        if (ret < 0) {
-            EC_MASTER_ERR(master, "Failed to map process data"
-                    " memory to user space (code %i).\n", ret);
-            return ret;
+    /* Move the VoE handler data into the mapped memory, so that the
+     * applications access them without copying. A handler, whose slave's
+     * mailboxes grew in the meantime, keeps its internal memory.
+     */
+    offset = voe_offset;
+    down(&master->master_sem);
+    list_for_each_entry(sc, &master->configs, list) {
+        if (sc->owner != ctx) {
+            continue;
         }
-#endif
+        list_for_each_entry(voe, &sc->voe_handlers, list) {
+            size = ec_ioctl_voe_map_size(voe);
+            if (offset + size > ctx->mmap_size) {
+                continue;
+            }
+            ec_voe_handler_external_memory(voe,
+                    ctx->process_data + offset, size);
+            offset += size;
+        }
+    }
+
+    /* Record the process data history in the mapped memory, so that the
+     * applications read it without copying. */
+    offset = history_offset;
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->owner != ctx) {
+            continue;
+        }
+        size = ec_history_mem_size(&domain->history,
+                ecrt_domain_size(domain));
+        if (!size || offset + size > ctx->mmap_size) {
+            continue;
+        }
+        ec_history_external_memory(&domain->history,
+                ctx->process_data + offset, size);
+        offset += size;
+    }
+    up(&master->master_sem);
+
+    ctx->state = (ec_ioctl_state_page_t *)
+        (ctx->process_data + io.state_offset);
+    memset(ctx->state, 0x00, sizeof(*ctx->state));
+    ctx->state->domain_count = min(ec_master_domain_count(master),
+            (unsigned int) EC_IOCTL_STATE_MAX_DOMAINS);
+    ctx->state->config_count = min(ec_master_config_count(master),
+            (unsigned int) EC_IOCTL_STATE_MAX_CONFIGS);
+
+    /* Describe the domains' process data for read-only mappers (see
+     * ec_ioctl_map_read_only()) and let ecrt_domain_process() maintain
+     * their sequence counters. */
+    offset = 0;
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->owner != ctx) {
+            continue;
+        }
+        offset = ALIGN(offset, domain->alignment);
+        if (domain->index < EC_IOCTL_STATE_MAX_DOMAINS) {
+            ec_ioctl_domain_map_t *map =
+                &ctx->state->domain_maps[domain->index];
+            map->offset = offset;
+            map->size = ecrt_domain_size(domain);
+            domain->map_sequence = &map->sequence;
+        }
+        offset += ecrt_domain_size(domain);
+    }
+
+    down(&master->master_sem);
+    ec_ioctl_attach_emerg_rings(master, ctx);
+    if (!master->shared || !master->mapped_mem) {
+        // sharing applications publish the memory of the first one
+        master->mapped_mem = ctx->process_data;
+        master->mapped_mem_size =
+            io.state_offset + PAGE_ALIGN(sizeof(*ctx->state));
+        master->mapped_mem_flags = ctx->map_flags;
+    }
+    if (master->cycle_cb_data == ctx) {
+        // the application triggers master-timed cycles via the state page
+        master->cycle_trigger_ext = &ctx->state->cycle_trigger;
+        master->cycle_trigger_seen = 0;
     }
+    up(&master->master_sem);
+
+#ifdef EC_IOCTL_RTDM
+    /* RTDM uses a different approach for memory-mapping, which has to be
+     * initiated by the kernel.
+     */
+    ret = ec_rtdm_mmap(ctx, &io.process_data);
+    if (ret < 0) {
+        EC_MASTER_ERR(master, "Failed to map process data"
+                " memory to user space (code %i).\n", ret);
+        return ret;
+    }
+#endif
 
     io.process_data_size = ctx->process_data_size;
+    io.mmap_size = ctx->mmap_size;
 
 #ifndef EC_IOCTL_RTDM
     ecrt_master_callbacks(master, ec_master_internal_send_cb,
             ec_master_internal_receive_cb, master);
 #endif
 
-    ret = ecrt_master_activate(master);
-    if (ret < 0)
-        return ret;
+    /* Sharing applications activate the master together, as soon as the
+     * last of them is ready. */
+    down(&master->master_sem);
+    if (master->shared) {
+        master->activations++;
+        activate = master->activations >= master->reserved;
+    }
+    up(&master->master_sem);
+
+    if (activate) {
+        ret = ecrt_master_activate(master);
+        if (ret < 0)
+            return ret;
+    }
+
+    ec_ioctl_publish_states(master, ctx);
 
     if (copy_to_user((void __user *) arg, &io,
                 sizeof(ec_ioctl_master_activate_t)))
@@ -1783,6 +3057,10 @@ static ATTRIBUTES int ec_ioctl_deactivate(
     if (unlikely(!ctx->requested))
         return -EPERM;
 
+    if (master->reserved > 1) {
+        return -EBUSY; // other applications share the master
+    }
+
     ecrt_master_deactivate(master);
     return 0;
 }
@@ -1835,200 +3113,275 @@ static ATTRIBUTES int ec_ioctl_send(
         return -EPERM;
     }
 
+    ec_ioctl_lock_io(master);
     ecrt_master_send(master);
+    ec_ioctl_unlock_io(master);
+    if (ctx->notify_domain) {
+        wake_up_interruptible(&ctx->poll_queue);
+    }
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Receive frames.
+/** Send frames at a launch time.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_receive(
+static ATTRIBUTES int ec_ioctl_send_at(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
+    uint64_t tx_time;
+    int ret;
+
     if (unlikely(!ctx->requested)) {
         return -EPERM;
     }
 
-    ecrt_master_receive(master);
-    return 0;
+    if (copy_from_user(&tx_time, (void __user *) arg, sizeof(tx_time))) {
+        return -EFAULT;
+    }
+
+    ec_ioctl_lock_io(master);
+    ret = ecrt_master_send_at(master, tx_time);
+    ec_ioctl_unlock_io(master);
+    if (ctx->notify_domain) {
+        wake_up_interruptible(&ctx->poll_queue);
+    }
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Get the master state.
+/** Receive frames.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_master_state(
+static ATTRIBUTES int ec_ioctl_receive(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_master_state_t data;
-
-    ecrt_master_state(master, &data);
-
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
-        return -EFAULT;
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
 
+    ec_ioctl_lock_io(master);
+    ecrt_master_receive(master);
+    ec_ioctl_unlock_io(master);
+    ec_ioctl_publish_states(master, ctx);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Get the link state.
+/** Receive frames until the cyclic datagrams are received.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_master_link_state(
+static ATTRIBUTES int ec_ioctl_receive_wait(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_link_state_t ioctl;
-    ec_master_link_state_t state;
+    uint64_t deadline;
     int ret;
 
-    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
-        return -EFAULT;
-    }
-
-    ret = ecrt_master_link_state(master, ioctl.dev_idx, &state);
-    if (ret < 0) {
-        return ret;
-    }
+    if (unlikely(!ctx->requested))
+        return -EPERM;
 
-    if (copy_to_user((void __user *) ioctl.state, &state, sizeof(state))) {
+    if (copy_from_user(&deadline, (void __user *) arg, sizeof(deadline))) {
         return -EFAULT;
     }
 
-    return 0;
+    ec_ioctl_lock_io(master);
+    ret = ecrt_master_receive_wait(master, deadline);
+    ec_ioctl_unlock_io(master);
+    ec_ioctl_publish_states(master, ctx);
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Set the master DC application time.
- *
- * \return Zero on success, otherwise a negative error code.
+/** Publishes the states after a master-timed cycle.
  */
-static ATTRIBUTES int ec_ioctl_app_time(
+static void ec_ioctl_timed_cycle_cb(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *cb_data /**< Private data structure of file handle. */
         )
 {
-    uint64_t time;
+    ec_ioctl_context_t *ctx = (ec_ioctl_context_t *) cb_data;
+    const ec_domain_t *domain;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (!ctx->state) {
+        return;
+    }
 
-    if (copy_from_user(&time, (void __user *) arg, sizeof(time))) {
-        return -EFAULT;
+    ec_ioctl_publish_states(master, ctx);
+    list_for_each_entry(domain, &master->domains, list) {
+        ec_ioctl_publish_domain_state(domain, ctx);
     }
 
-    ecrt_master_application_time(master, time);
-    return 0;
+    smp_wmb();
+    ctx->state->cycle_counter++;
 }
 
 /*****************************************************************************/
 
-/** Sync the reference clock.
+/** Let the master run the bus cycle.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sync_ref(
+static ATTRIBUTES int ec_ioctl_timed_cycle(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    if (unlikely(!ctx->requested)) {
+    uint32_t flags;
+    int ret;
+
+    if (unlikely(!ctx->requested))
         return -EPERM;
+
+    if (copy_from_user(&flags, (void __user *) arg, sizeof(flags))) {
+        return -EFAULT;
     }
 
-    ecrt_master_sync_reference_clock(master);
-    return 0;
+    if (master->shared) {
+        return -EBUSY; // the applications cycle independently
+    }
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    ret = ecrt_master_set_timed_cycle(master, flags);
+    if (!ret) {
+        master->cycle_cb = flags ? ec_ioctl_timed_cycle_cb : NULL;
+        master->cycle_cb_data = flags ? ctx : NULL;
+    }
+
+    up(&master->master_sem);
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Sync the reference clock.
+/** Set the priority and budget of a traffic class.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sync_ref_to(
+static ATTRIBUTES int ec_ioctl_traffic_class(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    uint64_t time;
+    ec_ioctl_traffic_class_t data;
+    int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&time, (void __user *) arg, sizeof(time))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    ecrt_master_sync_reference_clock_to(master, time);
-    return 0;
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    ret = ecrt_master_set_traffic_class(master,
+            (ec_traffic_class_t) data.traffic_class, data.priority,
+            data.budget);
+
+    up(&master->master_sem);
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Sync the slave clocks.
+/** Does the cyclic master and domain calls of a cycle descriptor.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sync_slaves(
+static ATTRIBUTES int ec_ioctl_do_cycle(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
+        const ec_ioctl_cycle_t *data, /**< Cycle descriptor. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
+    ec_domain_t *domain;
+
+    /* no locking of master_sem needed, because domains will not be deleted
+     * in the meantime. */
+
+    ec_ioctl_lock_io(master);
+
+    if (data->flags & EC_CYCLE_RECEIVE) {
+        ecrt_master_receive(master);
+        ec_ioctl_publish_states(master, ctx);
     }
 
-    ecrt_master_sync_slave_clocks(master);
-    return 0;
-}
+    if (data->flags & EC_CYCLE_PROCESS) {
+        list_for_each_entry(domain, &master->domains, list) {
+            if (domain->index < EC_IOCTL_CYCLE_MAX_DOMAINS
+                    && data->domain_mask & (1U << domain->index)
+                    && domain->owner == ctx) {
+                ecrt_domain_process(domain);
+                ec_ioctl_publish_domain_state(domain, ctx);
+                if (domain == ctx->notify_domain) {
+                    ctx->notify_processed = 1;
+                }
+            }
+        }
+    }
 
-/*****************************************************************************/
+    if (data->flags & EC_CYCLE_APP_TIME) {
+        ecrt_master_application_time(master, data->app_time);
+    }
 
-/** Get the system time of the reference clock.
- *
- * \return Zero on success, otherwise a negative error code.
- */
-static ATTRIBUTES int ec_ioctl_ref_clock_time(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
-        )
-{
-    uint32_t time;
-    int ret;
+    if (data->flags & EC_CYCLE_SYNC_REF) {
+        ecrt_master_sync_reference_clock(master);
+    }
 
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
+    if (data->flags & EC_CYCLE_SYNC_REF_TO) {
+        ecrt_master_sync_reference_clock_to(master, data->app_time);
     }
 
-    ret = ecrt_master_reference_clock_time(master, &time);
-    if (ret) {
-        return ret;
+    if (data->flags & EC_CYCLE_SYNC_SLAVES) {
+        ecrt_master_sync_slave_clocks(master);
     }
 
-    if (copy_to_user((void __user *) arg, &time, sizeof(time))) {
-        return -EFAULT;
+    if (data->flags & EC_CYCLE_SYNC_MON_QUEUE) {
+        ecrt_master_sync_monitor_queue(master);
+    }
+
+    if (data->flags & EC_CYCLE_QUEUE) {
+        list_for_each_entry(domain, &master->domains, list) {
+            if (domain->index < EC_IOCTL_CYCLE_MAX_DOMAINS
+                    && data->domain_mask & (1U << domain->index)
+                    && domain->owner == ctx && !domain->cycle_divisor) {
+                ecrt_domain_queue(domain);
+                if (domain == ctx->notify_domain) {
+                    ctx->notify_processed = 0;
+                }
+            }
+        }
+    }
+
+    if (data->flags & EC_CYCLE_SEND) {
+        ecrt_master_send(master);
+    }
+
+    ec_ioctl_unlock_io(master);
+
+    if (data->flags & EC_CYCLE_SEND && ctx->notify_domain) {
+        wake_up_interruptible(&ctx->poll_queue);
     }
 
     return 0;
@@ -2036,654 +3389,508 @@ static ATTRIBUTES int ec_ioctl_ref_clock_time(
 
 /*****************************************************************************/
 
-/** Queue the sync monitoring datagram.
+/** Do the cyclic master and domain calls.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sync_mon_queue(
+static ATTRIBUTES int ec_ioctl_cycle(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    if (unlikely(!ctx->requested)) {
+    ec_ioctl_cycle_t data;
+
+    if (unlikely(!ctx->requested))
         return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
     }
 
-    ecrt_master_sync_monitor_queue(master);
-    return 0;
+    return ec_ioctl_do_cycle(master, &data, ctx);
 }
 
 /*****************************************************************************/
 
-/** Processes the sync monitoring datagram.
+/** Do the cyclic master and domain calls described in the state page.
+ *
+ * The descriptor is copied once, so that the application can not change it
+ * while the cycle is in progress.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sync_mon_process(
+static ATTRIBUTES int ec_ioctl_cycle_shared(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    uint32_t time_diff;
+    ec_ioctl_cycle_t data;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    time_diff = ecrt_master_sync_monitor_process(master);
-
-    if (copy_to_user((void __user *) arg, &time_diff, sizeof(time_diff)))
-        return -EFAULT;
+    if (unlikely(!ctx->state))
+        return -ENXIO; // not activated
 
-    return 0;
+    memcpy(&data, &ctx->state->cycle, sizeof(data));
+    return ec_ioctl_do_cycle(master, &data, ctx);
 }
 
 /*****************************************************************************/
 
-/** Reset configuration.
+#ifdef EC_IOCTL_RTDM
+
+/** RTDM fast path for EC_IOCTL_CYCLE_SHARED.
  *
- * \return Always zero (success).
+ * Called by the RTDM driver before the generic ioctl() dispatching.
+ *
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_reset(
+int ec_ioctl_rtdm_cycle(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    down(&master->master_sem);
-    ecrt_master_reset(master);
-    up(&master->master_sem);
-    return 0;
+    if (unlikely(!ctx->writable))
+        return -EPERM;
+
+    return ec_ioctl_cycle_shared(master, NULL, ctx);
 }
 
+#endif
+
 /*****************************************************************************/
 
-/** Configure a sync manager.
+/** Get the master state.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_sync(
+static ATTRIBUTES int ec_ioctl_master_state(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_t data;
-    ec_slave_config_t *sc;
-    unsigned int i;
-    int ret = 0;
-
-    if (unlikely(!ctx->requested)) {
-        ret = -EPERM;
-        goto out_return;
-    }
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        ret = -EFAULT;
-        goto out_return;
-    }
-
-    if (down_interruptible(&master->master_sem)) {
-        ret = -EINTR;
-        goto out_return;
-    }
+    ec_master_state_t data;
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        ret = -ENOENT;
-        goto out_up;
-    }
+    ecrt_master_state(master, &data);
 
-    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
-        if (data.syncs[i].config_this) {
-            ret = ecrt_slave_config_sync_manager(sc, i, data.syncs[i].dir,
-                        data.syncs[i].watchdog_mode);
-            if (ret) {
-                goto out_up;
-            }
-        }
-    }
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
 
-out_up:
-    up(&master->master_sem);
-out_return:
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Configure a slave's watchdogs.
+/** Get the link state.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_watchdog(
+static ATTRIBUTES int ec_ioctl_master_link_state(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_t data;
-    ec_slave_config_t *sc;
-    int ret = 0;
-
-    if (unlikely(!ctx->requested)) {
-        ret = -EPERM;
-        goto out_return;
-    }
+    ec_ioctl_link_state_t ioctl;
+    ec_master_link_state_t state;
+    int ret;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        ret = -EFAULT;
-        goto out_return;
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
+        return -EFAULT;
     }
 
-    if (down_interruptible(&master->master_sem)) {
-        ret = -EINTR;
-        goto out_return;
+    ret = ecrt_master_link_state(master, ioctl.dev_idx, &state);
+    if (ret < 0) {
+        return ret;
     }
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        ret = -ENOENT;
-        goto out_up;
+    if (copy_to_user((void __user *) ioctl.state, &state, sizeof(state))) {
+        return -EFAULT;
     }
 
-    ecrt_slave_config_watchdog(sc,
-            data.watchdog_divider, data.watchdog_intervals);
-
-out_up:
-    up(&master->master_sem);
-out_return:
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Add a PDO to the assignment.
+/** Set the master DC application time.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_add_pdo(
+static ATTRIBUTES int ec_ioctl_app_time(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_pdo_t data;
-    ec_slave_config_t *sc;
+    uint64_t time;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+    if (copy_from_user(&time, (void __user *) arg, sizeof(time))) {
         return -EFAULT;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
     }
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    return ecrt_slave_config_pdo_assign_add(sc, data.sync_index, data.index);
+    ecrt_master_application_time(master, time);
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Clears the PDO assignment.
+/** Sync the reference clock.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_clear_pdos(
+static ATTRIBUTES int ec_ioctl_sync_ref(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_pdo_t data;
-    ec_slave_config_t *sc;
-
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
     }
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    ecrt_slave_config_pdo_assign_clear(sc, data.sync_index);
+    ecrt_master_sync_reference_clock(master);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Add an entry to a PDO's mapping.
+/** Sync the reference clock.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_add_entry(
+static ATTRIBUTES int ec_ioctl_sync_ref_to(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_add_pdo_entry_t data;
-    ec_slave_config_t *sc;
+    uint64_t time;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+    if (copy_from_user(&time, (void __user *) arg, sizeof(time))) {
         return -EFAULT;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
     }
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    return ecrt_slave_config_pdo_mapping_add(sc, data.pdo_index,
-            data.entry_index, data.entry_subindex, data.entry_bit_length);
+    ecrt_master_sync_reference_clock_to(master, time);
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Clears the mapping of a PDO.
+/** Sync the slave clocks.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_clear_entries(
+static ATTRIBUTES int ec_ioctl_sync_slaves(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_pdo_t data;
-    ec_slave_config_t *sc;
-
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
+    }
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
-    }
-
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    ecrt_slave_config_pdo_mapping_clear(sc, data.index);
-    return 0;
-}
+    ecrt_master_sync_slave_clocks(master);
+    return 0;
+}
 
 /*****************************************************************************/
 
-/** Registers a PDO entry.
+/** Get the system time of the reference clock.
  *
- * \return Process data offset on success, otherwise a negative error code.
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_reg_pdo_entry(
+static ATTRIBUTES int ec_ioctl_ref_clock_time(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_pdo_entry_t data;
-    ec_slave_config_t *sc;
-    ec_domain_t *domain;
+    uint32_t time;
     int ret;
 
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
     }
 
-    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
+    ret = ecrt_master_reference_clock_time(master, &time);
+    if (ret) {
+        return ret;
     }
 
-    up(&master->master_sem); /** \todo sc or domain could be invalidated */
-
-    ret = ecrt_slave_config_reg_pdo_entry(sc, data.entry_index,
-            data.entry_subindex, domain, &data.bit_position);
-
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+    if (copy_to_user((void __user *) arg, &time, sizeof(time))) {
         return -EFAULT;
+    }
 
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Registers a PDO entry by its position.
+/** Get the 64 bit system time of the reference clock.
  *
- * \return Process data offset on success, otherwise a negative error code.
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_reg_pdo_pos(
+static ATTRIBUTES int ec_ioctl_ref_clock_time64(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_pdo_pos_t io;
-    ec_slave_config_t *sc;
-    ec_domain_t *domain;
+    uint64_t time;
     int ret;
 
     if (unlikely(!ctx->requested)) {
         return -EPERM;
     }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
-        return -EFAULT;
-    }
-
-    if (down_interruptible(&master->master_sem)) {
-        return -EINTR;
-    }
-
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
-    }
-
-    if (!(domain = ec_master_find_domain(master, io.domain_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
+    ret = ecrt_master_reference_clock_time64(master, &time);
+    if (ret) {
+        return ret;
     }
 
-    up(&master->master_sem); /** \todo sc or domain could be invalidated */
-
-    ret = ecrt_slave_config_reg_pdo_entry_pos(sc, io.sync_index,
-            io.pdo_pos, io.entry_pos, domain, &io.bit_position);
-
-    if (copy_to_user((void __user *) arg, &io, sizeof(io)))
+    if (copy_to_user((void __user *) arg, &time, sizeof(time))) {
         return -EFAULT;
+    }
 
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Sets the DC AssignActivate word and the sync signal times.
+/** Get the DC servo correction and the filtered reference clock time.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_dc(
+static ATTRIBUTES int ec_ioctl_dc_servo(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_config_t data;
-    ec_slave_config_t *sc;
+    ec_ioctl_dc_servo_t data;
 
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
     }
 
-    ecrt_slave_config_dc(sc, data.dc_assign_activate,
-            data.dc_sync[0].cycle_time,
-            data.dc_sync[0].shift_time,
-            data.dc_sync[1].cycle_time,
-            data.dc_sync[1].shift_time);
+    data.correction = ecrt_master_dc_cycle_correction(master);
+    data.time = 0ULL;
+    data.time_result = ecrt_master_dc_time(master, &data.time);
 
-    up(&master->master_sem);
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
+    }
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Configures an SDO.
+/** Get the time for the next send call.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_sdo(
+static ATTRIBUTES int ec_ioctl_next_send_time(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sc_sdo_t data;
-    ec_slave_config_t *sc;
-    uint8_t *sdo_data = NULL;
+    ec_ioctl_next_send_time_t data;
     int ret;
 
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    if (!data.size)
-        return -EINVAL;
-
-    if (!(sdo_data = kmalloc(data.size, GFP_KERNEL))) {
-        return -ENOMEM;
     }
 
-    if (copy_from_user(sdo_data, (void __user *) data.data, data.size)) {
-        kfree(sdo_data);
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    if (down_interruptible(&master->master_sem)) {
-        kfree(sdo_data);
-        return -EINTR;
+    ret = ecrt_master_next_send_time(master, data.margin, &data.time);
+    if (ret) {
+        return ret;
     }
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        up(&master->master_sem);
-        kfree(sdo_data);
-        return -ENOENT;
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
     }
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    if (data.complete_access) {
-        ret = ecrt_slave_config_complete_sdo(sc,
-                data.index, sdo_data, data.size);
-    } else {
-        ret = ecrt_slave_config_sdo(sc, data.index, data.subindex, sdo_data,
-                data.size);
-    }
-    kfree(sdo_data);
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Set the emergency ring buffer size.
+/** Start a SYNC0 calibration window.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_size(
+static ATTRIBUTES int ec_ioctl_sync0_calibrate(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
-    int ret;
+    uint32_t cycles;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
-
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
+    if (copy_from_user(&cycles, (void __user *) arg, sizeof(cycles))) {
         return -EFAULT;
-
-    if (down_interruptible(&master->master_sem)) {
-        return -EINTR;
-    }
-
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        up(&master->master_sem);
-        return -ENOENT;
     }
 
-    ret = ecrt_slave_config_emerg_size(sc, io.size);
-
-    up(&master->master_sem);
-
-    return ret;
+    return ecrt_master_sync0_calibrate(master, cycles);
 }
 
 /*****************************************************************************/
 
-/** Get an emergency message from the ring.
+/** Get the SYNC0 shift correction of the last calibration window.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_pop(
+static ATTRIBUTES int ec_ioctl_sync0_shift_correction(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
-    u8 msg[EC_COE_EMERGENCY_MSG_SIZE];
+    ec_ioctl_sync0_shift_correction_t data;
     int ret;
 
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
-    }
-
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    /* no locking of master_sem needed, because configuration will not be
-     * deleted in the meantime. */
-
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
-    }
-
-    ret = ecrt_slave_config_emerg_pop(sc, msg);
-    if (ret < 0) {
+    ret = ecrt_master_sync0_shift_correction(master, data.margin,
+            &data.correction);
+    if (ret) {
         return ret;
     }
 
-    if (copy_to_user((void __user *) io.target, msg, sizeof(msg))) {
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
     }
 
-    return ret;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Clear the emergency ring.
- *
- * \return Zero on success, otherwise a negative error code.
+/** Copies a DC histogram.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_clear(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+static void ec_ioctl_copy_dc_histogram(
+        ec_ioctl_dc_histogram_t *dst, /**< Target. */
+        const ec_dc_histogram_t *src /**< Source. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
-
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
-    }
-
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
-        return -EFAULT;
-    }
-
-    /* no locking of master_sem needed, because configuration will not be
-     * deleted in the meantime. */
+    unsigned int i;
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
+    dst->count = src->count;
+    dst->sum = src->sum;
+    dst->min = src->min;
+    dst->max = src->max;
+    for (i = 0; i < EC_IOCTL_DC_HISTOGRAM_BINS; i++) {
+        dst->bins[i] = src->bins[i];
     }
-
-    return ecrt_slave_config_emerg_clear(sc);
 }
 
 /*****************************************************************************/
 
-/** Get the number of emergency overruns.
+/** Get the DC synchronization statistics.
+ *
+ * The statistics are recorded in the application context without locking,
+ * so a sample may be missing from a single read.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_emerg_overruns(
+static ATTRIBUTES int ec_ioctl_dc_stats(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sc_emerg_t io;
-    ec_slave_config_t *sc;
-    int ret;
-
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
-    }
-
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    const ec_dc_stats_t *stats = &master->dc_stats;
+    ec_ioctl_dc_stats_t data;
+
+    data.cycle_time = stats->cycle_time;
+    ec_ioctl_copy_dc_histogram(&data.sync_monitor, &stats->sync_monitor);
+    ec_ioctl_copy_dc_histogram(&data.ref_offset, &stats->ref_offset);
+    ec_ioctl_copy_dc_histogram(&data.send_jitter, &stats->send_jitter);
+    data.sync0_cycles_left = stats->sync0_calibrate ?
+        stats->sync0_calibrate : stats->sync0_cycles_left;
+    ec_ioctl_copy_dc_histogram(&data.sync0_margin, &stats->sync0_margin);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
     }
 
-    /* no locking of master_sem needed, because configuration will not be
-     * deleted in the meantime. */
+    return 0;
+}
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
-    }
+/*****************************************************************************/
 
-    ret = ecrt_slave_config_emerg_overruns(sc);
-    if (ret < 0) {
-        return ret;
-    }
+/** Reset the DC synchronization statistics.
+ *
+ * The reset is executed by the next ecrt_master_send() call.
+ *
+ * \return Always zero (success).
+ */
+static ATTRIBUTES int ec_ioctl_dc_stats_reset(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    master->dc_stats.reset = 1;
+    return 0;
+}
 
-    io.overruns = ret;
+/*****************************************************************************/
 
-    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+/** Copies a latency histogram.
+ */
+static void ec_ioctl_copy_latency_histogram(
+        ec_ioctl_latency_histogram_t *dst, /**< Target. */
+        const ec_latency_histogram_t *src /**< Source. */
+        )
+{
+    unsigned int i;
+
+    dst->count = src->count;
+    dst->sum = src->sum;
+    dst->min = src->min;
+    dst->max = src->max;
+    for (i = 0; i < EC_IOCTL_LATENCY_HISTOGRAM_BINS; i++) {
+        dst->bins[i] = src->bins[i];
+    }
+}
+
+/*****************************************************************************/
+
+/** Get the latency statistics of the master.
+ *
+ * The statistics are recorded in the application context without locking,
+ * so a sample may be missing from a single read.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_latency_stats(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    const ec_latency_stats_t *stats = &master->latency_stats;
+    ec_ioctl_latency_stats_t data;
+
+    ec_ioctl_copy_latency_histogram(&data.send, &stats->send);
+    ec_ioctl_copy_latency_histogram(&data.receive, &stats->receive);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
     }
 
@@ -2692,103 +3899,114 @@ static ATTRIBUTES int ec_ioctl_sc_emerg_overruns(
 
 /*****************************************************************************/
 
-/** Create an SDO request.
+/** Get the latency statistics of a domain.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
+static ATTRIBUTES int ec_ioctl_domain_latency_stats(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sdo_request_t data;
-    ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    ec_ioctl_domain_latency_stats_t data;
+    const ec_domain_t *domain;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    data.request_index = 0;
-
     if (down_interruptible(&master->master_sem))
         return -EINTR;
 
-    sc = ec_master_get_config(master, data.config_index);
-    if (!sc) {
+    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
         up(&master->master_sem);
-        return -ENOENT;
-    }
-
-    list_for_each_entry(req, &sc->sdo_requests, list) {
-        data.request_index++;
+        EC_MASTER_ERR(master, "Domain %u does not exist!\n",
+                data.domain_index);
+        return -EINVAL;
     }
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
+    ec_ioctl_copy_latency_histogram(&data.round_trip, &domain->round_trip);
+    ec_ioctl_copy_latency_histogram(&data.process, &domain->process_time);
 
-    req = ecrt_slave_config_create_sdo_request_err(sc, data.sdo_index,
-            data.sdo_subindex, data.size);
-    if (IS_ERR(req))
-        return PTR_ERR(req);
+    up(&master->master_sem);
 
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
+    }
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Create a register request.
+/** Reset the latency statistics of the master and of all domains.
+ *
+ * The reset is executed by the next ecrt_master_send() call.
+ *
+ * \return Always zero (success).
+ */
+static ATTRIBUTES int ec_ioctl_latency_stats_reset(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    master->latency_stats.reset = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get events of the startup profile.
+ *
+ * Copies up to \a max_events events, beginning with the one at \a offset.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
+static ATTRIBUTES int ec_ioctl_startup_profile(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_reg_request_t io;
-    ec_slave_config_t *sc;
-    ec_reg_request_t *reg;
-
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
-    }
+    ec_ioctl_startup_profile_t data;
+    const ec_startup_profile_t *profile = &master->startup_profile;
+    const ec_startup_event_t *event;
+    ec_ioctl_startup_event_t io;
+    ec_ioctl_startup_event_t __user *target;
+    unsigned int i;
+    int ret = 0;
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    io.request_index = 0;
+    target = (ec_ioctl_startup_event_t __user *) data.events;
 
-    if (down_interruptible(&master->master_sem)) {
+    if (down_interruptible(&master->master_sem))
         return -EINTR;
-    }
 
-    sc = ec_master_get_config(master, io.config_index);
-    if (!sc) {
-        up(&master->master_sem);
-        return -ENOENT;
+    for (i = 0; i < data.max_events
+            && data.offset + i < profile->count; i++) {
+        event = &profile->events[data.offset + i];
+        io.start = event->start;
+        io.duration = event->duration;
+        io.slave_position = event->position;
+        io.phase = event->phase;
+        io.flags = event->flags;
+        if (copy_to_user(target + i, &io, sizeof(io))) {
+            ret = -EFAULT;
+            break;
+        }
     }
 
-    list_for_each_entry(reg, &sc->reg_requests, list) {
-        io.request_index++;
-    }
+    data.event_count = profile->count;
+    data.lost = profile->lost;
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
+    up(&master->master_sem);
 
-    reg = ecrt_slave_config_create_reg_request_err(sc, io.mem_size);
-    if (IS_ERR(reg)) {
-        return PTR_ERR(reg);
+    if (ret) {
+        return ret;
     }
 
-    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
     }
 
@@ -2797,422 +4015,540 @@ static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
 
 /*****************************************************************************/
 
-/** Create a VoE handler.
+/** Discard the startup profile and restart its timeline.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_create_voe_handler(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+static ATTRIBUTES int ec_ioctl_startup_profile_reset(
+        ec_master_t *master /**< EtherCAT master. */
         )
 {
-    ec_ioctl_voe_t data;
-    ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    ec_startup_profile_reset(&master->startup_profile);
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        return -EFAULT;
-    }
+    up(&master->master_sem);
+    return 0;
+}
 
-    data.voe_index = 0;
+/*****************************************************************************/
 
-    if (down_interruptible(&master->master_sem))
-        return -EINTR;
+/** Copies the slave states, domains and EoE handlers for monitoring.
+ *
+ * Has to be called with the master semaphore held.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_ioctl_monitor_topology(
+        const ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_monitor_t *data /**< Monitor data. */
+        )
+{
+    uint8_t states[64];
+    unsigned int i, j, count;
+    const ec_domain_t *domain;
+    ec_ioctl_monitor_domain_t domain_data;
+#ifdef EC_EOE
+    const ec_eoe_t *eoe;
+    ec_ioctl_monitor_eoe_t eoe_data;
+#endif
 
-    sc = ec_master_get_config(master, data.config_index);
-    if (!sc) {
-        up(&master->master_sem);
-        return -ENOENT;
+    data->slave_count = master->slave_count;
+    count = min(data->slave_count, data->slave_capacity);
+    for (i = 0; i < count; i += j) {
+        for (j = 0; j < ARRAY_SIZE(states) && i + j < count; j++) {
+            states[j] = master->slaves[i + j].current_state;
+        }
+        if (copy_to_user((void __user *) (data->slave_states + i),
+                    states, j)) {
+            return -EFAULT;
+        }
     }
 
-    list_for_each_entry(voe, &sc->voe_handlers, list) {
-        data.voe_index++;
+    i = 0;
+    memset(&domain_data, 0, sizeof(domain_data));
+    list_for_each_entry(domain, &master->domains, list) {
+        if (i < data->domain_capacity) {
+            domain_data.index = domain->index;
+            domain_data.working_counter = 0;
+            for (j = EC_DEVICE_MAIN; j < ec_master_num_devices(master); j++) {
+                domain_data.working_counter += domain->working_counter[j];
+            }
+            domain_data.expected_working_counter =
+                domain->expected_working_counter;
+            domain_data.redundancy_active = domain->redundancy_active;
+            domain_data.process_count = domain->process_count;
+            if (copy_to_user((void __user *) (data->domains + i),
+                        &domain_data, sizeof(domain_data))) {
+                return -EFAULT;
+            }
+        }
+        i++;
     }
+    data->domain_count = i;
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    voe = ecrt_slave_config_create_voe_handler_err(sc, data.size);
-    if (IS_ERR(voe))
-        return PTR_ERR(voe);
-
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
-        return -EFAULT;
+    i = 0;
+#ifdef EC_EOE
+    memset(&eoe_data, 0, sizeof(eoe_data));
+    list_for_each_entry(eoe, &master->eoe_handlers, list) {
+        if (i < data->eoe_capacity) {
+            snprintf(eoe_data.name, EC_DATAGRAM_NAME_SIZE, "%s",
+                    eoe->dev->name);
+            eoe_data.slave_position =
+                eoe->slave ? eoe->slave->ring_position : 0xffff;
+            eoe_data.open = eoe->opened;
+            eoe_data.rx_rate = eoe->rx_rate;
+            eoe_data.tx_rate = eoe->tx_rate;
+            eoe_data.tx_dropped = eoe->stats.tx_dropped;
+            if (copy_to_user((void __user *) (data->eoe_handlers + i),
+                        &eoe_data, sizeof(eoe_data))) {
+                return -EFAULT;
+            }
+        }
+        i++;
+    }
+#endif
+    data->eoe_handler_count = i;
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Get the slave configuration's state.
+/** Get the bus and cycle health for monitoring.
+ *
+ * Collects everything a monitor needs with a single call. The device
+ * statistics, counters and histograms are read without locking. The master
+ * semaphore is only tried, so that a monitor polling a running system never
+ * delays the master state machines; if it is taken, the slave states,
+ * domains and EoE handlers are omitted.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_state(
+static ATTRIBUTES int ec_ioctl_monitor(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sc_state_t data;
-    const ec_slave_config_t *sc;
-    ec_slave_config_state_t state;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    ec_ioctl_monitor_t data;
+    ec_master_counters_t *counters = &master->counters;
+    unsigned int dev_idx, seq;
+    int ret = 0;
 
     if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
-    /* no locking of master_sem needed, because sc will not be deleted in the
-     * meantime. */
+    data.phase = (uint8_t) master->phase;
+    data.active = (uint8_t) master->active;
 
-    if (!(sc = ec_master_get_config_const(master, data.config_index))) {
-        return -ENOENT;
+    data.topology_valid = 0;
+    data.slave_count = 0;
+    data.domain_count = 0;
+    data.eoe_handler_count = 0;
+    if (!down_trylock(&master->master_sem)) {
+        ret = ec_ioctl_monitor_topology(master, &data);
+        up(&master->master_sem);
+        if (ret) {
+            return ret;
+        }
+        data.topology_valid = 1;
     }
 
-    ecrt_slave_config_state(sc, &state);
-
-    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
+    for (dev_idx = EC_DEVICE_MAIN;
+            dev_idx < ec_master_num_devices(master); dev_idx++) {
+        const ec_device_t *device = &master->devices[dev_idx];
+
+        data.devices[dev_idx].link_state = device->link_state ? 1 : 0;
+        data.devices[dev_idx].tx_errors = device->tx_errors;
+        data.devices[dev_idx].tx_frame_rate = device->tx_frame_rates[0];
+        data.devices[dev_idx].rx_frame_rate = device->rx_frame_rates[0];
+    }
+    data.num_devices = ec_master_num_devices(master);
+    data.tx_count = master->device_stats.tx_count;
+    data.rx_count = master->device_stats.rx_count;
+    data.tx_frame_rate = master->device_stats.tx_frame_rates[0];
+    data.rx_frame_rate = master->device_stats.rx_frame_rates[0];
+    data.loss_rate = master->device_stats.loss_rates[0];
+
+    do {
+        seq = read_seqcount_begin(&counters->cycle_seq);
+        data.cycles = counters->cycle.cycles;
+        data.frames = counters->cycle.frames;
+        data.frames_max = counters->cycle.frames_max;
+    } while (read_seqcount_retry(&counters->cycle_seq, seq));
+
+    do {
+        seq = read_seqcount_begin(&counters->fsm_seq);
+        data.fsm_exec_time = counters->fsm.exec_time;
+        data.fsm_exec_time_max = counters->fsm.exec_time_max;
+    } while (read_seqcount_retry(&counters->fsm_seq, seq));
+
+    ec_ioctl_copy_latency_histogram(&data.send, &master->latency_stats.send);
+    ec_ioctl_copy_latency_histogram(&data.receive,
+            &master->latency_stats.receive);
+
+    data.dc_cycle_time = master->dc_stats.cycle_time;
+    ec_ioctl_copy_dc_histogram(&data.sync_monitor,
+            &master->dc_stats.sync_monitor);
+    ec_ioctl_copy_dc_histogram(&data.ref_offset,
+            &master->dc_stats.ref_offset);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
         return -EFAULT;
+    }
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Configures an IDN.
+/** Start capturing frames on all devices.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sc_idn(
+static ATTRIBUTES int ec_ioctl_capture_start(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sc_idn_t ioctl;
-    ec_slave_config_t *sc;
-    uint8_t *data = NULL;
-    int ret;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
-
-    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl)))
-        return -EFAULT;
-
-    if (!ioctl.size)
-        return -EINVAL;
-
-    if (!(data = kmalloc(ioctl.size, GFP_KERNEL))) {
-        return -ENOMEM;
-    }
+    ec_ioctl_capture_start_t data;
+    unsigned int dev_idx;
+    int ret = 0;
 
-    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.size)) {
-        kfree(data);
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
     }
 
     if (down_interruptible(&master->master_sem)) {
-        kfree(data);
         return -EINTR;
     }
 
-    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
-        up(&master->master_sem);
-        kfree(data);
-        return -ENOENT;
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ret = ec_capture_start(&master->devices[dev_idx].capture,
+                data.triggers, data.post_frames);
+        if (ret) {
+            break;
+        }
     }
 
-    up(&master->master_sem); /** \todo sc could be invalidated */
-
-    ret = ecrt_slave_config_idn(
-            sc, ioctl.drive_no, ioctl.idn, ioctl.al_state, data, ioctl.size);
-    kfree(data);
+    up(&master->master_sem);
     return ret;
 }
 
 /*****************************************************************************/
 
-/** Gets the domain's data size.
+/** Stop capturing frames.
  *
- * \return Domain size, or a negative error code.
+ * \return Always zero (success).
  */
-static ATTRIBUTES int ec_ioctl_domain_size(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+static ATTRIBUTES int ec_ioctl_capture_stop(
+        ec_master_t *master /**< EtherCAT master. */
         )
 {
-    const ec_domain_t *domain;
+    unsigned int dev_idx;
 
-    if (unlikely(!ctx->requested)) {
-        return -EPERM;
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ec_capture_stop(&master->devices[dev_idx].capture);
     }
 
-    if (down_interruptible(&master->master_sem)) {
-        return -EINTR;
-    }
-
-    list_for_each_entry(domain, &master->domains, list) {
-        if (domain->index == (unsigned long) arg) {
-            size_t size = ecrt_domain_size(domain);
-            up(&master->master_sem);
-            return size;
-        }
-    }
-
-    up(&master->master_sem);
-    return -ENOENT;
-}
+    return 0;
+}
 
 /*****************************************************************************/
 
-/** Gets the domain's offset in the total process data.
+/** Get the state of a device's capture ring.
  *
- * \return Domain offset, or a negative error code.
+ * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_offset(
+static ATTRIBUTES int ec_ioctl_capture_state(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    int offset = 0;
-    const ec_domain_t *domain;
+    ec_ioctl_capture_state_t data;
+    const ec_capture_t *capture;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
 
-    if (down_interruptible(&master->master_sem)) {
-        return -EINTR;
+    if (data.dev_idx >= ec_master_num_devices(master)) {
+        return -EINVAL;
     }
 
-    list_for_each_entry(domain, &master->domains, list) {
-        if (domain->index == (unsigned long) arg) {
-            up(&master->master_sem);
-            return offset;
-        }
-        offset += ecrt_domain_size(domain);
+    capture = &master->devices[data.dev_idx].capture;
+    data.ring_size = EC_CAPTURE_RING_SIZE;
+    data.active = capture->active;
+    data.triggered = capture->triggered;
+    data.start_seq = capture->start_seq;
+    data.seq = capture->seq;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
     }
 
-    up(&master->master_sem);
-    return -ENOENT;
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Process the domain.
+/** Read captured frames.
+ *
+ * Copies consecutive frames beginning with the given sequence number, until
+ * a frame is not in the ring (yet or any more).
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_domain_process(
+static ATTRIBUTES int ec_ioctl_capture_read(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_domain_t *domain;
+    ec_ioctl_capture_read_t data;
+    ec_capture_frame_t *frame;
+    ec_ioctl_capture_frame_t __user *target;
+    int ret = 0;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
 
-    /* no locking of master_sem needed, because domain will not be deleted in
-     * the meantime. */
+    if (data.dev_idx >= ec_master_num_devices(master)) {
+        return -EINVAL;
+    }
 
-    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
-        return -ENOENT;
+    if (!(frame = kmalloc(sizeof(*frame), GFP_KERNEL))) {
+        return -ENOMEM;
     }
 
-    ecrt_domain_process(domain);
-    return 0;
+    target = (ec_ioctl_capture_frame_t __user *) data.frames;
+    for (data.frame_count = 0; data.frame_count < data.max_frames;
+            data.frame_count++, target++) {
+        if (ec_capture_read(&master->devices[data.dev_idx].capture,
+                    data.seq + data.frame_count, frame)) {
+            break;
+        }
+
+        if (put_user(frame->time, &target->time)
+                || put_user(frame->seq - 1, &target->seq)
+                || put_user(frame->size, &target->size)
+                || put_user(frame->dir, &target->dir)
+                || copy_to_user(target->data, frame->data, frame->size)) {
+            ret = -EFAULT;
+            break;
+        }
+    }
+
+    kfree(frame);
+
+    if (!ret && copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        ret = -EFAULT;
+    }
+
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Queue the domain.
- *
- * \return Zero on success, otherwise a negative error code.
+/** Datagram lookup by position, see ec_ioctl_datagram_stats().
  */
-static ATTRIBUTES int ec_ioctl_domain_queue(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
-        )
-{
-    ec_domain_t *domain;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+typedef struct {
+    unsigned int position; /**< Requested position. */
+    unsigned int count; /**< Number of datagrams visited. */
+    const ec_datagram_t *datagram; /**< Datagram found, or NULL. */
+    int domain_index; /**< Index of the datagram's domain, or -1. */
+} ec_ioctl_datagram_lookup_t;
 
-    /* no locking of master_sem needed, because domain will not be deleted in
-     * the meantime. */
+/*****************************************************************************/
 
-    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
-        return -ENOENT;
+/** Visits a datagram during the lookup.
+ */
+static void ec_ioctl_datagram_visit(
+        ec_ioctl_datagram_lookup_t *lookup, /**< Lookup state. */
+        const ec_datagram_t *datagram, /**< Visited datagram. */
+        int domain_index /**< Index of the datagram's domain, or -1. */
+        )
+{
+    if (lookup->count++ == lookup->position) {
+        lookup->datagram = datagram;
+        lookup->domain_index = domain_index;
     }
-
-    ecrt_domain_queue(domain);
-    return 0;
 }
 
 /*****************************************************************************/
 
-/** Get the domain state.
+/** Walks all long-living datagrams of the master.
  *
- * \return Zero on success, otherwise a negative error code.
+ * These are the master's own datagrams, the master state machine datagrams,
+ * the domain datagrams and the EoE datagrams.
  */
-static ATTRIBUTES int ec_ioctl_domain_state(
-        ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+static void ec_ioctl_datagram_lookup(
+        const ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_datagram_lookup_t *lookup /**< Lookup state. */
         )
 {
-    ec_ioctl_domain_state_t data;
+    const ec_fsm_master_t *fsm = &master->fsm;
     const ec_domain_t *domain;
-    ec_domain_state_t state;
+    const ec_datagram_pair_t *pair;
+#ifdef EC_EOE
+    const ec_eoe_t *eoe;
+#endif
+    unsigned int i, dev_idx;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    ec_ioctl_datagram_visit(lookup, &master->fsm_datagram, -1);
+    ec_ioctl_datagram_visit(lookup, &master->ref_sync_datagram, -1);
+    ec_ioctl_datagram_visit(lookup, &master->sync_datagram, -1);
+    ec_ioctl_datagram_visit(lookup, &master->sync_mon_datagram, -1);
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
-        return -EFAULT;
+    for (i = 0; i < EC_FSM_MASTER_SCANS; i++) {
+        ec_ioctl_datagram_visit(lookup, &fsm->scan_datagrams[i], -1);
     }
-
-    /* no locking of master_sem needed, because domain will not be deleted in
-     * the meantime. */
-
-    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
-        return -ENOENT;
+    ec_ioctl_datagram_visit(lookup, &fsm->al_datagram, -1);
+    ec_ioctl_datagram_visit(lookup, &fsm->mbox_datagram, -1);
+    for (i = 0; i < EC_FSM_MASTER_MBOX_DATAGRAMS; i++) {
+        ec_ioctl_datagram_visit(lookup, &fsm->mbox_data_datagrams[i], -1);
+    }
+    for (i = 0; i < EC_FSM_MASTER_STATE_DATAGRAMS; i++) {
+        ec_ioctl_datagram_visit(lookup, &fsm->state_datagrams[i], -1);
+    }
+    for (i = 0; i < EC_FSM_MASTER_REG_DATAGRAMS; i++) {
+        ec_ioctl_datagram_visit(lookup, &fsm->reg_datagrams[i], -1);
+    }
+    for (i = 0; i < EC_FSM_MASTER_DC_DATAGRAMS; i++) {
+        ec_ioctl_datagram_visit(lookup, &fsm->dc_datagrams[i], -1);
+    }
+    for (i = 0; i < ec_fsm_master_configs; i++) {
+        ec_ioctl_datagram_visit(lookup, &fsm->configs[i].datagram, -1);
     }
 
-    ecrt_domain_state(domain, &state);
-
-    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
-        return -EFAULT;
+    list_for_each_entry(domain, &master->domains, list) {
+        list_for_each_entry(pair, &domain->datagram_pairs, list) {
+            for (dev_idx = EC_DEVICE_MAIN;
+                    dev_idx < ec_master_num_devices(master); dev_idx++) {
+                ec_ioctl_datagram_visit(lookup, &pair->datagrams[dev_idx],
+                        domain->index);
+            }
+        }
+    }
 
-    return 0;
+#ifdef EC_EOE
+    list_for_each_entry(eoe, &master->eoe_handlers, list) {
+        ec_ioctl_datagram_visit(lookup, &eoe->datagram, -1);
+        ec_ioctl_datagram_visit(lookup, &eoe->rx_datagram, -1);
+    }
+#endif
 }
 
 /*****************************************************************************/
 
-/** Sets an SDO request's SDO index and subindex.
+/** Get the round trip and loss statistics of a datagram.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sdo_request_index(
+static ATTRIBUTES int ec_ioctl_datagram_stats(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg, /**< ioctl() argument. */
-        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        void *arg /**< ioctl() argument. */
         )
 {
-    ec_ioctl_sdo_request_t data;
-    ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
+    ec_ioctl_datagram_stats_t data;
+    ec_ioctl_datagram_lookup_t lookup;
+    const ec_datagram_t *datagram;
+    ec_datagram_stats_t stats;
 
-    if (unlikely(!ctx->requested))
-        return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
         return -EFAULT;
+    }
 
-    /* no locking of master_sem needed, because neither sc nor req will not be
-     * deleted in the meantime. */
+    lookup.position = data.position;
+    lookup.count = 0;
+    lookup.datagram = NULL;
+    lookup.domain_index = -1;
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    ec_ioctl_datagram_lookup(master, &lookup);
+
+    if (!(datagram = lookup.datagram)) {
+        up(&master->master_sem);
+        EC_MASTER_ERR(master, "Datagram %u does not exist!\n",
+                data.position);
+        return -EINVAL;
     }
 
-    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
-        return -ENOENT;
+    stats = datagram->stats;
+
+    data.datagram_count = lookup.count;
+    data.domain_index = lookup.domain_index;
+    data.device_index = datagram->device_index;
+    data.type = datagram->type;
+    data.data_size = datagram->data_size;
+    memcpy(data.name, datagram->name, EC_DATAGRAM_NAME_SIZE);
+    data.name[EC_DATAGRAM_NAME_SIZE - 1] = 0;
+
+    up(&master->master_sem);
+
+    data.received = stats.received;
+    data.rtt_min = ec_datagram_ticks_to_ns(stats.rtt_min);
+    data.rtt_avg = stats.received ? ec_datagram_ticks_to_ns(
+            div64_u64(stats.rtt_sum, stats.received)) : 0;
+    data.rtt_max = ec_datagram_ticks_to_ns(stats.rtt_max);
+    data.timeouts = stats.timeouts;
+    data.late = stats.late;
+    data.late_max = stats.late_max;
+    data.skips = stats.skips;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        return -EFAULT;
     }
 
-    ecrt_sdo_request_index(req, data.sdo_index, data.sdo_subindex);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Sets an SDO request's timeout.
+/** Queue the sync monitoring datagram.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sdo_request_timeout(
+static ATTRIBUTES int ec_ioctl_sync_mon_queue(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sdo_request_t data;
-    ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
-
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    /* no locking of master_sem needed, because neither sc nor req will not be
-     * deleted in the meantime. */
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
-    }
-
-    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
-        return -ENOENT;
     }
 
-    ecrt_sdo_request_timeout(req, data.timeout);
+    ecrt_master_sync_monitor_queue(master);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Gets an SDO request's state.
+/** Processes the sync monitoring datagram.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sdo_request_state(
+static ATTRIBUTES int ec_ioctl_sync_mon_process(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sdo_request_t data;
-    ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
+    uint32_t time_diff;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    /* no locking of master_sem needed, because neither sc nor req will not be
-     * deleted in the meantime. */
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
-    }
-
-    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
-        return -ENOENT;
-    }
-
-    data.state = ecrt_sdo_request_state(req);
-    if (data.state == EC_REQUEST_SUCCESS && req->dir == EC_DIR_INPUT)
-        data.size = ecrt_sdo_request_data_size(req);
-    else
-        data.size = 0;
+    time_diff = ecrt_master_sync_monitor_process(master);
 
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+    if (copy_to_user((void __user *) arg, &time_diff, sizeof(time_diff)))
         return -EFAULT;
 
     return 0;
@@ -3220,332 +4556,275 @@ static ATTRIBUTES int ec_ioctl_sdo_request_state(
 
 /*****************************************************************************/
 
-/** Starts an SDO read operation.
+/** Reset configuration.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Always zero (success).
  */
-static ATTRIBUTES int ec_ioctl_sdo_request_read(
+static ATTRIBUTES int ec_ioctl_reset(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sdo_request_t data;
-    ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
-
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
-
-    /* no locking of master_sem needed, because neither sc nor req will not be
-     * deleted in the meantime. */
-
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
-    }
-
-    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
-        return -ENOENT;
-    }
-
-    ecrt_sdo_request_read(req);
+    down(&master->master_sem);
+    ecrt_master_reset(master);
+    up(&master->master_sem);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Starts an SDO write operation.
+/** Configure a sync manager.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sdo_request_write(
+static ATTRIBUTES int ec_ioctl_sc_sync(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sdo_request_t data;
+    ec_ioctl_config_t data;
     ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
-    int ret;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    unsigned int i;
+    int ret = 0;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
+    if (unlikely(!ctx->requested)) {
+        ret = -EPERM;
+        goto out_return;
+    }
 
-    if (!data.size) {
-        EC_MASTER_ERR(master, "SDO download: Data size may not be zero!\n");
-        return -EINVAL;
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        ret = -EFAULT;
+        goto out_return;
     }
 
-    /* no locking of master_sem needed, because neither sc nor req will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_return;
+    }
 
     if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
+        ret = -ENOENT;
+        goto out_up;
     }
 
-    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
-        return -ENOENT;
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        if (data.syncs[i].config_this) {
+            ret = ecrt_slave_config_sync_manager(sc, i, data.syncs[i].dir,
+                        data.syncs[i].watchdog_mode);
+            if (ret) {
+                goto out_up;
+            }
+        }
     }
 
-    ret = ec_sdo_request_alloc(req, data.size);
-    if (ret)
-        return ret;
-
-    if (copy_from_user(req->data, (void __user *) data.data, data.size))
-        return -EFAULT;
-
-    req->data_size = data.size;
-    ecrt_sdo_request_write(req);
-    return 0;
+out_up:
+    up(&master->master_sem);
+out_return:
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Read SDO data.
+/** Configure a slave's watchdogs.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_sdo_request_data(
+static ATTRIBUTES int ec_ioctl_sc_watchdog(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_sdo_request_t data;
+    ec_ioctl_config_t data;
     ec_slave_config_t *sc;
-    ec_sdo_request_t *req;
-
-    if (unlikely(!ctx->requested))
-        return -EPERM;
+    int ret = 0;
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
-        return -EFAULT;
+    if (unlikely(!ctx->requested)) {
+        ret = -EPERM;
+        goto out_return;
+    }
 
-    /* no locking of master_sem needed, because neither sc nor req will not be
-     * deleted in the meantime. */
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        ret = -EFAULT;
+        goto out_return;
+    }
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_return;
     }
 
-    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
-        return -ENOENT;
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        ret = -ENOENT;
+        goto out_up;
     }
 
-    if (copy_to_user((void __user *) data.data, ecrt_sdo_request_data(req),
-                ecrt_sdo_request_data_size(req)))
-        return -EFAULT;
+    ecrt_slave_config_watchdog(sc,
+            data.watchdog_divider, data.watchdog_intervals);
 
-    return 0;
+out_up:
+    up(&master->master_sem);
+out_return:
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Read register data.
+/** Add a PDO to the assignment.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_reg_request_data(
+static ATTRIBUTES int ec_ioctl_sc_add_pdo(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_request_t io;
+    ec_ioctl_config_pdo_t data;
     ec_slave_config_t *sc;
-    ec_reg_request_t *reg;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
-    }
-
-    if (io.mem_size <= 0) {
-        return 0;
-    }
-
-    /* no locking of master_sem needed, because neither sc nor reg will not be
-     * deleted in the meantime. */
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
-    }
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (copy_to_user((void __user *) io.data, ecrt_reg_request_data(reg),
-                min(reg->mem_size, io.mem_size))) {
-        return -EFAULT;
-    }
+    up(&master->master_sem); /** \todo sc could be invalidated */
 
-    return 0;
+    return ecrt_slave_config_pdo_assign_add(sc, data.sync_index, data.index);
 }
 
 /*****************************************************************************/
 
-/** Gets an register request's state.
+/** Clears the PDO assignment.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_reg_request_state(
+static ATTRIBUTES int ec_ioctl_sc_clear_pdos(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_request_t io;
+    ec_ioctl_config_pdo_t data;
     ec_slave_config_t *sc;
-    ec_reg_request_t *reg;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
-    }
-
-    /* no locking of master_sem needed, because neither sc nor reg will not be
-     * deleted in the meantime. */
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
-    }
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    io.state = ecrt_reg_request_state(reg);
-    io.new_data = io.state == EC_REQUEST_SUCCESS && reg->dir == EC_DIR_INPUT;
-
-    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
-        return -EFAULT;
-    }
+    up(&master->master_sem); /** \todo sc could be invalidated */
 
+    ecrt_slave_config_pdo_assign_clear(sc, data.sync_index);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Starts an register write operation.
+/** Add an entry to a PDO's mapping.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_reg_request_write(
+static ATTRIBUTES int ec_ioctl_sc_add_entry(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_request_t io;
+    ec_ioctl_add_pdo_entry_t data;
     ec_slave_config_t *sc;
-    ec_reg_request_t *reg;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
-    }
-
-    /* no locking of master_sem needed, because neither sc nor reg will not be
-     * deleted in the meantime. */
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
-    }
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (io.transfer_size > reg->mem_size) {
-        return -EOVERFLOW;
-    }
-
-    if (copy_from_user(reg->data, (void __user *) io.data,
-                io.transfer_size)) {
-        return -EFAULT;
-    }
+    up(&master->master_sem); /** \todo sc could be invalidated */
 
-    ecrt_reg_request_write(reg, io.address, io.transfer_size);
-    return 0;
+    return ecrt_slave_config_pdo_mapping_add(sc, data.pdo_index,
+            data.entry_index, data.entry_subindex, data.entry_bit_length);
 }
 
 /*****************************************************************************/
 
-/** Starts an register read operation.
+/** Clears the mapping of a PDO.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_reg_request_read(
+static ATTRIBUTES int ec_ioctl_sc_clear_entries(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_reg_request_t io;
+    ec_ioctl_config_pdo_t data;
     ec_slave_config_t *sc;
-    ec_reg_request_t *reg;
 
-    if (unlikely(!ctx->requested)) {
+    if (unlikely(!ctx->requested))
         return -EPERM;
-    }
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
-    }
-
-    /* no locking of master_sem needed, because neither sc nor reg will not be
-     * deleted in the meantime. */
 
-    if (!(sc = ec_master_get_config(master, io.config_index))) {
-        return -ENOENT;
-    }
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
-    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (io.transfer_size > reg->mem_size) {
-        return -EOVERFLOW;
-    }
+    up(&master->master_sem); /** \todo sc could be invalidated */
 
-    ecrt_reg_request_read(reg, io.address, io.transfer_size);
+    ecrt_slave_config_pdo_mapping_clear(sc, data.index);
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Sets the VoE send header.
+/** Registers a PDO entry.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Process data offset on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_send_header(
+static ATTRIBUTES int ec_ioctl_sc_reg_pdo_entry(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_reg_pdo_entry_t data;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
-    uint32_t vendor_id;
-    uint16_t vendor_type;
+    ec_domain_t *domain;
+    int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3553,44 +4832,46 @@ static ATTRIBUTES int ec_ioctl_voe_send_header(
     if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    if (get_user(vendor_id, data.vendor_id))
-        return -EFAULT;
-
-    if (get_user(vendor_type, data.vendor_type))
-        return -EFAULT;
-
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
     if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    ecrt_voe_handler_send_header(voe, vendor_id, vendor_type);
-    return 0;
+    up(&master->master_sem); /** \todo sc or domain could be invalidated */
+
+    ret = ecrt_slave_config_reg_pdo_entry(sc, data.entry_index,
+            data.entry_subindex, domain, &data.bit_position);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Gets the received VoE header.
+/** Registers the samples of an oversampling channel.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_rec_header(
+static ATTRIBUTES int ec_ioctl_sc_reg_pdo_array(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_reg_pdo_array_t data;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
-    uint32_t vendor_id;
-    uint16_t vendor_type;
+    ec_domain_t *domain;
+    int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3598,45 +4879,47 @@ static ATTRIBUTES int ec_ioctl_voe_rec_header(
     if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
     if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    ecrt_voe_handler_received_header(voe, &vendor_id, &vendor_type);
+    up(&master->master_sem); /** \todo sc or domain could be invalidated */
 
-    if (likely(data.vendor_id))
-        if (put_user(vendor_id, data.vendor_id))
-            return -EFAULT;
+    ret = ecrt_slave_config_reg_pdo_array(sc, data.entry_index,
+            data.entry_subindex, domain, &data.array);
+    if (ret)
+        return ret;
 
-    if (likely(data.vendor_type))
-        if (put_user(vendor_type, data.vendor_type))
-            return -EFAULT;
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Starts a VoE read operation.
+/** Maps the DC latch registers of a slave into a domain.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Process data offset on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_read(
+static ATTRIBUTES int ec_ioctl_sc_dc_latch(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_sc_dc_latch_t data;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
+    ec_domain_t *domain;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3644,36 +4927,39 @@ static ATTRIBUTES int ec_ioctl_voe_read(
     if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
     if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    ecrt_voe_handler_read(voe);
-    return 0;
+    up(&master->master_sem); /** \todo sc or domain could be invalidated */
+
+    return ecrt_slave_config_dc_latch(sc, domain);
 }
 
 /*****************************************************************************/
 
-/** Starts a VoE read operation without sending a sync message first.
+/** Maps registers of a slave into a domain.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Process data offset on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_read_nosync(
+static ATTRIBUTES int ec_ioctl_sc_reg_fmmu(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_sc_reg_fmmu_t data;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
+    ec_domain_t *domain;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3681,82 +4967,89 @@ static ATTRIBUTES int ec_ioctl_voe_read_nosync(
     if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
     if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    ecrt_voe_handler_read_nosync(voe);
-    return 0;
+    up(&master->master_sem); /** \todo sc or domain could be invalidated */
+
+    return ecrt_slave_config_reg_fmmu(sc, domain, data.address, data.size,
+            data.dir);
 }
 
 /*****************************************************************************/
 
-/** Starts a VoE write operation.
+/** Registers a PDO entry by its position.
  *
- * \return Zero on success, otherwise a negative error code.
+ * \return Process data offset on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_write(
+static ATTRIBUTES int ec_ioctl_sc_reg_pdo_pos(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_reg_pdo_pos_t io;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
+    ec_domain_t *domain;
+    int ret;
 
-    if (unlikely(!ctx->requested))
+    if (unlikely(!ctx->requested)) {
         return -EPERM;
+    }
 
-    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
         return -EFAULT;
+    }
 
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+    if (!(domain = ec_master_find_domain(master, io.domain_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (data.size) {
-        if (data.size > ec_voe_handler_mem_size(voe))
-            return -EOVERFLOW;
+    up(&master->master_sem); /** \todo sc or domain could be invalidated */
 
-        if (copy_from_user(ecrt_voe_handler_data(voe),
-                    (void __user *) data.data, data.size))
-            return -EFAULT;
-    }
+    ret = ecrt_slave_config_reg_pdo_entry_pos(sc, io.sync_index,
+            io.pdo_pos, io.entry_pos, domain, &io.bit_position);
 
-    ecrt_voe_handler_write(voe, data.size);
-    return 0;
+    if (copy_to_user((void __user *) arg, &io, sizeof(io)))
+        return -EFAULT;
+
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Executes the VoE state machine.
+/** Sets the DC AssignActivate word and the sync signal times.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_exec(
+static ATTRIBUTES int ec_ioctl_sc_dc(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_config_t data;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3764,44 +5057,41 @@ static ATTRIBUTES int ec_ioctl_voe_exec(
     if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
 
     if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
         return -ENOENT;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
-        return -ENOENT;
-    }
-
-    data.state = ecrt_voe_handler_execute(voe);
-    if (data.state == EC_REQUEST_SUCCESS && voe->dir == EC_DIR_INPUT)
-        data.size = ecrt_voe_handler_data_size(voe);
-    else
-        data.size = 0;
+    ecrt_slave_config_dc(sc, data.dc_assign_activate,
+            data.dc_sync[0].cycle_time,
+            data.dc_sync[0].shift_time,
+            data.dc_sync[1].cycle_time,
+            data.dc_sync[1].shift_time);
 
-    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
-        return -EFAULT;
+    up(&master->master_sem);
 
     return 0;
 }
 
 /*****************************************************************************/
 
-/** Reads the received VoE data.
+/** Configures an SDO.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_voe_data(
+static ATTRIBUTES int ec_ioctl_sc_sdo(
         ec_master_t *master, /**< EtherCAT master. */
         void *arg, /**< ioctl() argument. */
         ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_voe_t data;
+    ec_ioctl_sc_sdo_t data;
     ec_slave_config_t *sc;
-    ec_voe_handler_t *voe;
+    uint8_t *sdo_data = NULL;
+    int ret;
 
     if (unlikely(!ctx->requested))
         return -EPERM;
@@ -3809,838 +5099,5097 @@ static ATTRIBUTES int ec_ioctl_voe_data(
     if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
         return -EFAULT;
 
-    /* no locking of master_sem needed, because neither sc nor voe will not be
-     * deleted in the meantime. */
+    if (!data.size)
+        return -EINVAL;
 
-    if (!(sc = ec_master_get_config(master, data.config_index))) {
-        return -ENOENT;
+    if (!(sdo_data = kmalloc(data.size, GFP_KERNEL))) {
+        return -ENOMEM;
     }
 
-    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+    if (copy_from_user(sdo_data, (void __user *) data.data, data.size)) {
+        kfree(sdo_data);
+        return -EFAULT;
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        kfree(sdo_data);
+        return -EINTR;
+    }
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
+        kfree(sdo_data);
         return -ENOENT;
     }
 
-    if (copy_to_user((void __user *) data.data, ecrt_voe_handler_data(voe),
-                ecrt_voe_handler_data_size(voe)))
-        return -EFAULT;
+    up(&master->master_sem); /** \todo sc could be invalidated */
 
-    return 0;
+    if (data.complete_access) {
+        ret = ecrt_slave_config_complete_sdo(sc,
+                data.index, sdo_data, data.size);
+    } else {
+        ret = ecrt_slave_config_sdo(sc, data.index, data.subindex, sdo_data,
+                data.size);
+    }
+    kfree(sdo_data);
+    return ret;
 }
 
 /*****************************************************************************/
 
-/** Read a file from a slave via FoE.
+/** Processes a single configuration batch record.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_slave_foe_read(
+static int ec_ioctl_config_record(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
+        ec_slave_config_t **sc, /**< Selected slave configuration. */
+        ec_ioctl_config_record_t *rec /**< Configuration record. */
         )
 {
-    ec_ioctl_slave_foe_t io;
-    ec_foe_request_t request;
-    ec_slave_t *slave;
+    ec_domain_t *domain;
+    unsigned int bit_position = 0;
     int ret;
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
-        return -EFAULT;
-    }
+    rec->result = 0;
+    rec->bit_position = 0;
 
-    ec_foe_request_init(&request, io.file_name);
-    ret = ec_foe_request_alloc(&request, 10000); // FIXME
-    if (ret) {
-        ec_foe_request_clear(&request);
-        return ret;
+    if (rec->type == EC_IOCTL_BATCH_CONFIG) {
+        *sc = ecrt_master_slave_config_err(master, rec->u.config.alias,
+                rec->u.config.position, rec->u.config.vendor_id,
+                rec->u.config.product_code);
+        if (IS_ERR(*sc)) {
+            ret = PTR_ERR(*sc);
+            *sc = NULL;
+            return ret;
+        }
+
+        ret = ec_ioctl_config_index(master, *sc);
+        if (ret < 0)
+            return ret;
+        rec->result = ret;
+        return 0;
     }
 
-    ec_foe_request_read(&request);
+    if (!*sc)
+        return -ENOENT;
 
-    if (down_interruptible(&master->master_sem)) {
-        ec_foe_request_clear(&request);
-        return -EINTR;
+    switch (rec->type) {
+        case EC_IOCTL_BATCH_SYNC:
+            return ecrt_slave_config_sync_manager(*sc,
+                    rec->u.sync.sync_index, rec->u.sync.dir,
+                    rec->u.sync.watchdog_mode);
+        case EC_IOCTL_BATCH_CLEAR_PDOS:
+            ecrt_slave_config_pdo_assign_clear(*sc, rec->u.pdo.sync_index);
+            return 0;
+        case EC_IOCTL_BATCH_ADD_PDO:
+            return ecrt_slave_config_pdo_assign_add(*sc,
+                    rec->u.pdo.sync_index, rec->u.pdo.index);
+        case EC_IOCTL_BATCH_CLEAR_ENTRIES:
+            ecrt_slave_config_pdo_mapping_clear(*sc, rec->u.pdo.index);
+            return 0;
+        case EC_IOCTL_BATCH_ADD_ENTRY:
+            return ecrt_slave_config_pdo_mapping_add(*sc,
+                    rec->u.entry.pdo_index, rec->u.entry.entry_index,
+                    rec->u.entry.entry_subindex,
+                    rec->u.entry.entry_bit_length);
+        case EC_IOCTL_BATCH_REG_PDO_ENTRY:
+            /* no locking of master_sem needed, because domains will not be
+             * deleted in the meantime. */
+            if (!(domain = ec_master_find_domain(master,
+                            rec->u.reg.domain_index)))
+                return -ENOENT;
+
+            ret = ecrt_slave_config_reg_pdo_entry(*sc,
+                    rec->u.reg.entry_index, rec->u.reg.entry_subindex,
+                    domain, &bit_position);
+            if (ret < 0)
+                return ret;
+            rec->result = ret;
+            rec->bit_position = bit_position;
+            return 0;
+        default:
+            return -EINVAL;
     }
+}
 
-    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
-        up(&master->master_sem);
-        ec_foe_request_clear(&request);
-        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
-                io.slave_position);
+/*****************************************************************************/
+
+/** Applies a batch of configuration records.
+ *
+ * The records are processed in order, until one of them fails. The results
+ * of all processed records are returned with a single copy.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_config_batch(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_config_batch_t data;
+    ec_ioctl_config_record_t *records;
+    ec_slave_config_t *sc = NULL;
+    size_t size;
+    int ret = 0;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    if (data.version != EC_IOCTL_CONFIG_BATCH_VERSION)
         return -EINVAL;
-    }
 
-    EC_SLAVE_DBG(slave, 1, "Scheduling FoE read request.\n");
+    if (!data.record_count || data.record_count
+            > UINT_MAX / sizeof(ec_ioctl_config_record_t))
+        return -EINVAL;
 
-    // schedule request.
-    list_add_tail(&request.list, &slave->foe_requests);
+    size = data.record_count * sizeof(ec_ioctl_config_record_t);
+    if (!(records = vmalloc(size)))
+        return -ENOMEM;
 
-    up(&master->master_sem);
+    if (copy_from_user(records, (void __user *) data.records, size)) {
+        ret = -EFAULT;
+        goto out_free;
+    }
 
-    // wait for processing through FSM
-    if (wait_event_interruptible(master->request_queue,
-                request.state != EC_INT_REQUEST_QUEUED)) {
-        // interrupted by signal
-        down(&master->master_sem);
-        if (request.state == EC_INT_REQUEST_QUEUED) {
-            list_del(&request.list);
-            up(&master->master_sem);
-            ec_foe_request_clear(&request);
-            return -EINTR;
+    if (data.config_index != EC_IOCTL_CONFIG_BATCH_NO_CONFIG) {
+        if (down_interruptible(&master->master_sem)) {
+            ret = -EINTR;
+            goto out_free;
         }
-        // request already processing: interrupt not possible.
-        up(&master->master_sem);
-    }
-
-    // wait until master FSM has finished processing
-    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
 
-    io.result = request.result;
-    io.error_code = request.error_code;
+        sc = ec_master_get_config(master, data.config_index);
+        up(&master->master_sem); /** \todo sc could be invalidated */
 
-    if (request.state != EC_INT_REQUEST_SUCCESS) {
-        io.data_size = 0;
-        ret = -EIO;
-    } else {
-        if (request.data_size > io.buffer_size) {
-            EC_SLAVE_ERR(slave, "%s(): Buffer too small.\n", __func__);
-            ec_foe_request_clear(&request);
-            return -EOVERFLOW;
+        if (!sc) {
+            ret = -ENOENT;
+            goto out_free;
         }
-        io.data_size = request.data_size;
-        if (copy_to_user((void __user *) io.buffer,
-                    request.buffer, io.data_size)) {
-            ec_foe_request_clear(&request);
-            return -EFAULT;
+    }
+
+    for (data.processed = 0; data.processed < data.record_count;
+            data.processed++) {
+        ret = ec_ioctl_config_record(master, &sc,
+                records + data.processed);
+        if (ret) {
+            records[data.processed++].result = ret;
+            break;
         }
-        ret = 0;
     }
 
-    if (__copy_to_user((void __user *) arg, &io, sizeof(io))) {
+    if (copy_to_user((void __user *) data.records, records,
+                data.processed * sizeof(ec_ioctl_config_record_t))
+            || copy_to_user((void __user *) arg, &data, sizeof(data))) {
         ret = -EFAULT;
     }
 
-    ec_foe_request_clear(&request);
+out_free:
+    vfree(records);
     return ret;
 }
 
 /*****************************************************************************/
 
-/** Write a file to a slave via FoE
+/** Set the emergency ring buffer size.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_slave_foe_write(
+static ATTRIBUTES int ec_ioctl_sc_emerg_size(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_slave_foe_t io;
-    ec_foe_request_t request;
-    ec_slave_t *slave;
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
     int ret;
 
-    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
-        return -EFAULT;
-    }
-
-    ec_foe_request_init(&request, io.file_name);
-
-    ret = ec_foe_request_alloc(&request, io.buffer_size);
-    if (ret) {
-        ec_foe_request_clear(&request);
-        return ret;
-    }
+    if (unlikely(!ctx->requested))
+        return -EPERM;
 
-    if (copy_from_user(request.buffer,
-                (void __user *) io.buffer, io.buffer_size)) {
-        ec_foe_request_clear(&request);
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io)))
         return -EFAULT;
-    }
-
-    request.data_size = io.buffer_size;
-    ec_foe_request_write(&request);
 
     if (down_interruptible(&master->master_sem)) {
-        ec_foe_request_clear(&request);
         return -EINTR;
     }
 
-    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
         up(&master->master_sem);
-        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
-                io.slave_position);
-        ec_foe_request_clear(&request);
-        return -EINVAL;
+        return -ENOENT;
     }
 
-    EC_SLAVE_DBG(slave, 1, "Scheduling FoE write request.\n");
-
-    // schedule FoE write request.
-    list_add_tail(&request.list, &slave->foe_requests);
+    ret = ecrt_slave_config_emerg_size(sc, io.size);
 
     up(&master->master_sem);
 
-    // wait for processing through FSM
-    if (wait_event_interruptible(master->request_queue,
-                request.state != EC_INT_REQUEST_QUEUED)) {
-        // interrupted by signal
-        down(&master->master_sem);
-        if (request.state == EC_INT_REQUEST_QUEUED) {
-            // abort request
-            list_del(&request.list);
-            up(&master->master_sem);
-            ec_foe_request_clear(&request);
-            return -EINTR;
-        }
-        up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Get an emergency message from the ring.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_emerg_pop(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
+    u8 msg[EC_COE_EMERGENCY_MSG_SIZE];
+    int ret;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
     }
 
-    // wait until master FSM has finished processing
-    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
 
-    io.result = request.result;
-    io.error_code = request.error_code;
+    /* no locking of master_sem needed, because configuration will not be
+     * deleted in the meantime. */
 
-    ret = request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
 
-    if (__copy_to_user((void __user *) arg, &io, sizeof(io))) {
-        ret = -EFAULT;
+    ret = ecrt_slave_config_emerg_pop(sc, msg);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (copy_to_user((void __user *) io.target, msg, sizeof(msg))) {
+        return -EFAULT;
     }
 
-    ec_foe_request_clear(&request);
     return ret;
 }
 
 /*****************************************************************************/
 
-/** Read an SoE IDN.
+/** Clear the emergency ring.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_slave_soe_read(
+static ATTRIBUTES int ec_ioctl_sc_emerg_clear(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_slave_soe_read_t ioctl;
-    u8 *data;
-    int retval;
-
-    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
-        return -EFAULT;
-    }
-
-    data = kmalloc(ioctl.mem_size, GFP_KERNEL);
-    if (!data) {
-        EC_MASTER_ERR(master, "Failed to allocate %zu bytes of IDN data.\n",
-                ioctl.mem_size);
-        return -ENOMEM;
-    }
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
 
-    retval = ecrt_master_read_idn(master, ioctl.slave_position,
-            ioctl.drive_no, ioctl.idn, data, ioctl.mem_size, &ioctl.data_size,
-            &ioctl.error_code);
-    if (retval) {
-        kfree(data);
-        return retval;
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
     }
 
-    if (copy_to_user((void __user *) ioctl.data,
-                data, ioctl.data_size)) {
-        kfree(data);
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
         return -EFAULT;
     }
-    kfree(data);
 
-    if (__copy_to_user((void __user *) arg, &ioctl, sizeof(ioctl))) {
-        retval = -EFAULT;
+    /* no locking of master_sem needed, because configuration will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
     }
 
-    EC_MASTER_DBG(master, 1, "Finished SoE read request.\n");
-    return retval;
+    return ecrt_slave_config_emerg_clear(sc);
 }
 
 /*****************************************************************************/
 
-/** Write an IDN to a slave via SoE.
+/** Get the number of emergency overruns.
  *
  * \return Zero on success, otherwise a negative error code.
  */
-static ATTRIBUTES int ec_ioctl_slave_soe_write(
+static ATTRIBUTES int ec_ioctl_sc_emerg_overruns(
         ec_master_t *master, /**< EtherCAT master. */
-        void *arg /**< ioctl() argument. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
         )
 {
-    ec_ioctl_slave_soe_write_t ioctl;
-    u8 *data;
-    int retval;
+    ec_ioctl_sc_emerg_t io;
+    ec_slave_config_t *sc;
+    int ret;
 
-    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
-        return -EFAULT;
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
     }
 
-    data = kmalloc(ioctl.data_size, GFP_KERNEL);
-    if (!data) {
-        EC_MASTER_ERR(master, "Failed to allocate %zu bytes of IDN data.\n",
-                ioctl.data_size);
-        return -ENOMEM;
-    }
-    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.data_size)) {
-        kfree(data);
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
         return -EFAULT;
     }
 
-    retval = ecrt_master_write_idn(master, ioctl.slave_position,
-            ioctl.drive_no, ioctl.idn, data, ioctl.data_size,
-            &ioctl.error_code);
-    kfree(data);
-    if (retval) {
-        return retval;
+    /* no locking of master_sem needed, because configuration will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
     }
 
-    if (__copy_to_user((void __user *) arg, &ioctl, sizeof(ioctl))) {
-        retval = -EFAULT;
+    ret = ecrt_slave_config_emerg_overruns(sc);
+    if (ret < 0) {
+        return ret;
     }
 
-    EC_MASTER_DBG(master, 1, "Finished SoE write request.\n");
-    return retval;
+    io.overruns = ret;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** ioctl() function to use.
- */
-#ifdef EC_IOCTL_RTDM
-#define EC_IOCTL ec_ioctl_rtdm
-#else
-#define EC_IOCTL ec_ioctl
-#endif
-
-/** Called when an ioctl() command is issued.
+/** Create an SDO request.
  *
- * \return ioctl() return code.
+ * \return Zero on success, otherwise a negative error code.
  */
-long EC_IOCTL(
+static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
         ec_master_t *master, /**< EtherCAT master. */
-        ec_ioctl_context_t *ctx, /**< Device context. */
-        unsigned int cmd, /**< ioctl() command identifier. */
-        void *arg /**< ioctl() argument. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    data.request_index = 0;
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    sc = ec_master_get_config(master, data.config_index);
+    if (!sc) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(req, &sc->sdo_requests, list) {
+        data.request_index++;
+    }
+
+    up(&master->master_sem); /** \todo sc could be invalidated */
+
+    req = ecrt_slave_config_create_sdo_request_err(sc, data.sdo_index,
+            data.sdo_subindex, data.size);
+    if (IS_ERR(req))
+        return PTR_ERR(req);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Create a register request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_reg_request_t io;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    io.request_index = 0;
+
+    if (down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    sc = ec_master_get_config(master, io.config_index);
+    if (!sc) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(reg, &sc->reg_requests, list) {
+        io.request_index++;
+    }
+
+    up(&master->master_sem); /** \todo sc could be invalidated */
+
+    reg = ecrt_slave_config_create_reg_request_err(sc, io.mem_size);
+    if (IS_ERR(reg)) {
+        return PTR_ERR(reg);
+    }
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Create a VoE handler.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_create_voe_handler(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    data.voe_index = 0;
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    sc = ec_master_get_config(master, data.config_index);
+    if (!sc) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    list_for_each_entry(voe, &sc->voe_handlers, list) {
+        data.voe_index++;
+    }
+
+    up(&master->master_sem); /** \todo sc could be invalidated */
+
+    voe = ecrt_slave_config_create_voe_handler_err(sc, data.size);
+    if (IS_ERR(voe))
+        return PTR_ERR(voe);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get the slave configuration's state.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_state_t data;
+    const ec_slave_config_t *sc;
+    ec_slave_config_state_t state;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because sc will not be deleted in the
+     * meantime. */
+
+    if (!(sc = ec_master_get_config_const(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_slave_config_state(sc, &state);
+
+    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets the states of several slave configurations.
+ *
+ * \return Number of states, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_states(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_states_t data;
+    ec_slave_config_state_t states[64];
+    const ec_slave_config_t *sc;
+    unsigned int i = 0, n = 0;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because configurations will not be
+     * deleted in the meantime. Copy in chunks to keep the stack small. */
+
+    list_for_each_entry(sc, &master->configs, list) {
+        if (i >= data.count) {
+            break;
+        }
+        ecrt_slave_config_state(sc, &states[n++]);
+        if (n == ARRAY_SIZE(states)) {
+            if (copy_to_user((void __user *) (data.states + i), states,
+                        sizeof(states)))
+                return -EFAULT;
+            i += n;
+            n = 0;
+        }
+    }
+
+    if (n && copy_to_user((void __user *) (data.states + i), states,
+                n * sizeof(states[0])))
+        return -EFAULT;
+
+    return i + n;
+}
+
+/*****************************************************************************/
+
+/** Configures an IDN.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sc_idn(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sc_idn_t ioctl;
+    ec_slave_config_t *sc;
+    uint8_t *data = NULL;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl)))
+        return -EFAULT;
+
+    if (!ioctl.size)
+        return -EINVAL;
+
+    if (!(data = kmalloc(ioctl.size, GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.size)) {
+        kfree(data);
+        return -EFAULT;
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        kfree(data);
+        return -EINTR;
+    }
+
+    if (!(sc = ec_master_get_config(master, ioctl.config_index))) {
+        up(&master->master_sem);
+        kfree(data);
+        return -ENOENT;
+    }
+
+    up(&master->master_sem); /** \todo sc could be invalidated */
+
+    ret = ecrt_slave_config_idn(
+            sc, ioctl.drive_no, ioctl.idn, ioctl.al_state, data, ioctl.size);
+    kfree(data);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Gets the domain's data size.
+ *
+ * \return Domain size, or a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_size(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->index == (unsigned long) arg) {
+            size_t size = ecrt_domain_size(domain);
+            up(&master->master_sem);
+            return size;
+        }
+    }
+
+    up(&master->master_sem);
+    return -ENOENT;
+}
+
+/*****************************************************************************/
+
+/** Gets the domain's offset in the total process data.
+ *
+ * \return Domain offset, or a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_offset(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    int offset = 0;
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (down_interruptible(&master->master_sem)) {
+        return -EINTR;
+    }
+
+    list_for_each_entry(domain, &master->domains, list) {
+        if (domain->owner != ctx) {
+            continue; // not in the memory of this application
+        }
+        offset = ALIGN(offset, domain->alignment);
+        if (domain->index == (unsigned long) arg) {
+            up(&master->master_sem);
+            return offset;
+        }
+        offset += ecrt_domain_size(domain);
+    }
+
+    up(&master->master_sem);
+    return -ENOENT;
+}
+
+/*****************************************************************************/
+
+/** Process the domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_process(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))
+            || domain->owner != ctx) {
+        return -ENOENT;
+    }
+
+    ec_ioctl_lock_io(master);
+    ecrt_domain_process(domain);
+    ec_ioctl_unlock_io(master);
+    ec_ioctl_publish_domain_state(domain, ctx);
+    if (domain == ctx->notify_domain) {
+        ctx->notify_processed = 1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queue the domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_queue(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))
+            || domain->owner != ctx) {
+        return -ENOENT;
+    }
+
+    ec_ioctl_lock_io(master);
+    ecrt_domain_queue(domain);
+    ec_ioctl_unlock_io(master);
+    if (domain == ctx->notify_domain) {
+        ctx->notify_processed = 0;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queue the output datagrams of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_queue_outputs(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))
+            || domain->owner != ctx) {
+        return -ENOENT;
+    }
+
+    ec_ioctl_lock_io(master);
+    ecrt_domain_queue_outputs(domain);
+    ec_ioctl_unlock_io(master);
+    if (domain == ctx->notify_domain) {
+        ctx->notify_processed = 0;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queue the input datagrams of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_queue_inputs(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))
+            || domain->owner != ctx) {
+        return -ENOENT;
+    }
+
+    ec_ioctl_lock_io(master);
+    ecrt_domain_queue_inputs(domain);
+    ec_ioctl_unlock_io(master);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Get the domain state.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_state_t data;
+    const ec_domain_t *domain;
+    ec_domain_state_t state;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_domain_state(domain, &state);
+
+    if (copy_to_user((void __user *) data.state, &state, sizeof(state)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets the ring redundancy statistics of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_redundancy(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_redundancy_t data;
+    const ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_domain_redundancy(domain, &data.stats);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Enables the process data history of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_history(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_history_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_history(domain, data.depth, data.offset, data.size,
+            data.flags);
+}
+
+/*****************************************************************************/
+
+/** Gets the state of the process data history of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_history_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_history_state_t data;
+    const ec_domain_t *domain;
+    ec_history_state_t state;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    ecrt_domain_history_state(domain, &state);
+    data.depth = state.depth;
+    data.record_size = state.record_size;
+    data.offset = state.offset;
+    data.size = state.size;
+    data.flags = domain->history.flags;
+    data.seq = state.seq;
+    data.frozen = state.frozen;
+    data.map_offset = EC_IOCTL_HISTORY_NOT_MAPPED;
+    if (ctx->process_data && domain->owner == ctx
+            && domain->history.mem_origin == EC_ORIG_EXTERNAL) {
+        data.map_offset = domain->history.mem - ctx->process_data;
+    }
+
+    up(&master->master_sem);
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Freezes the process data history of a domain or resumes recording.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_history_freeze(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_domain_history_freeze_t data;
+    ec_domain_t *domain;
+    int ret;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    ret = ecrt_domain_history_freeze(domain, data.freeze);
+
+    up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Reads records of the process data history of a domain.
+ *
+ * Copies consecutive records beginning with the given sequence number,
+ * until a record is not in the ring (yet or any more).
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_history_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_domain_history_read_t data;
+    const ec_domain_t *domain;
+    uint8_t *record;
+    uint8_t __user *target;
+    size_t record_size;
+    int ret = 0;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(domain = ec_master_find_domain_const(master, data.domain_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    record_size = domain->history.record_size;
+    if (!domain->history.mem || !record_size) {
+        up(&master->master_sem);
+        return -ENODATA;
+    }
+
+    if (!(record = kmalloc(record_size, GFP_KERNEL))) {
+        up(&master->master_sem);
+        return -ENOMEM;
+    }
+
+    target = (uint8_t __user *) data.records;
+    for (data.record_count = 0; data.record_count < data.max_records;
+            data.record_count++, target += record_size) {
+        if (ec_history_read(&domain->history,
+                    data.seq + data.record_count, record)) {
+            break;
+        }
+
+        if (copy_to_user(target, record, record_size)) {
+            ret = -EFAULT;
+            break;
+        }
+    }
+
+    up(&master->master_sem);
+    kfree(record);
+
+    if (!ret && copy_to_user((void __user *) arg, &data, sizeof(data))) {
+        ret = -EFAULT;
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Sets the reception timeout of the domain datagrams.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_timeout(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_timeout_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_set_timeout(domain, data.timeout_us);
+}
+
+/*****************************************************************************/
+
+/** Enables the overlapping layout of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_overlap(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_overlap(domain);
+}
+
+/*****************************************************************************/
+
+/** Enables the double-buffered mode of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_double_buffer(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_double_buffer(domain);
+}
+
+/*****************************************************************************/
+
+/** Splits the inputs and outputs of a domain into separate datagrams.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_split_io(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, (unsigned long) arg))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_split_io(domain);
+}
+
+/*****************************************************************************/
+
+/** Sets the pipeline depth of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_pipeline(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_pipeline_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_set_pipeline_depth(domain, data.depth);
+}
+
+/*****************************************************************************/
+
+/** Sets the cycle divisor of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_divisor(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_divisor_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_set_cycle_divisor(domain, data.divisor, data.phase);
+}
+
+/*****************************************************************************/
+
+/** Binds a domain to an EtherCAT line.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_segment(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_segment_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_set_segment(domain, data.segment);
+}
+
+/*****************************************************************************/
+
+/** Sets the process data alignment of a domain.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_alignment(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_alignment_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_set_alignment(domain, data.alignment);
+}
+
+/*****************************************************************************/
+
+/** Adds a process data route.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_route(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_route_t data;
+    ec_domain_t *src_domain, *dst_domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domains will not be deleted
+     * in the meantime. */
+
+    if (!(src_domain = ec_master_find_domain(master, data.src_domain_index))
+            || !(dst_domain =
+                ec_master_find_domain(master, data.dst_domain_index))) {
+        return -ENOENT;
+    }
+
+    return ecrt_domain_add_route(src_domain, data.src_offset, data.src_bit,
+            dst_domain, data.dst_offset, data.dst_bit, data.bits);
+}
+
+/*****************************************************************************/
+
+/** Determines the changed inputs of a domain.
+ *
+ * \return Number of changed input bytes, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_changed_inputs(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_changed_inputs_t data;
+    ec_domain_t *domain;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    ret = ecrt_domain_changed_inputs(domain, domain->changed_inputs);
+    if (ret < 0 || !domain->data_size) {
+        return ret;
+    }
+
+    if (copy_to_user((void __user *) data.bitmap, domain->changed_inputs,
+                EC_DOMAIN_BITMAP_SIZE(domain->data_size))) {
+        return -EFAULT;
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+#ifndef EC_IOCTL_RTDM
+
+/** Wakes up poll() to poll the devices again.
+ *
+ * \return Always HRTIMER_NORESTART.
+ */
+static enum hrtimer_restart ec_ioctl_poll_timer(
+        struct hrtimer *timer /**< Poll timer. */
+        )
+{
+    ec_ioctl_context_t *ctx =
+        container_of(timer, ec_ioctl_context_t, poll_timer);
+
+    wake_up_interruptible(&ctx->poll_queue);
+    return HRTIMER_NORESTART;
+}
+
+/*****************************************************************************/
+
+/** Signal the completion of a domain via poll().
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_domain_notify(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_domain_notify_t data;
+    ec_domain_t *domain;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data))) {
+        return -EFAULT;
+    }
+
+    if (!data.poll_interval_us) {
+        return -EINVAL;
+    }
+
+    /* no locking of master_sem needed, because domain will not be deleted in
+     * the meantime. */
+
+    if (!(domain = ec_master_find_domain(master, data.domain_index))) {
+        return -ENOENT;
+    }
+
+    if (!ctx->notify_domain) {
+        init_waitqueue_head(&ctx->poll_queue);
+        hrtimer_init(&ctx->poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+        ctx->poll_timer.function = ec_ioctl_poll_timer;
+    }
+
+    ctx->poll_interval = ktime_set(0, data.poll_interval_us * NSEC_PER_USEC);
+    ctx->notify_processed = 0;
+    ctx->notify_domain = domain;
+    return 0;
+}
+
+#endif
+
+/*****************************************************************************/
+
+/** Sets an SDO request's SDO index and subindex.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_index(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    if (data.complete_access) {
+        ecrt_sdo_request_index_complete(req, data.sdo_index);
+    } else {
+        ecrt_sdo_request_index(req, data.sdo_index, data.sdo_subindex);
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Sets an SDO request's timeout.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_timeout(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_sdo_request_timeout(req, data.timeout);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets an SDO request's state.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    data.state = ecrt_sdo_request_state(req);
+    if (data.state == EC_REQUEST_SUCCESS && req->dir == EC_DIR_INPUT)
+        data.size = ecrt_sdo_request_data_size(req);
+    else
+        data.size = 0;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts an SDO read operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_sdo_request_read(req);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts an SDO write operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_write(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    if (!data.size) {
+        EC_MASTER_ERR(master, "SDO download: Data size may not be zero!\n");
+        return -EINVAL;
+    }
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    ret = ec_sdo_request_alloc(req, data.size);
+    if (ret)
+        return ret;
+
+    if (copy_from_user(req->data, (void __user *) data.data, data.size))
+        return -EFAULT;
+
+    req->data_size = data.size;
+    ecrt_sdo_request_write(req);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts a batch of SDO read and write operations.
+ *
+ * All requests are looked up and the write data are copied first, so that
+ * either all or none of the operations are started.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_batch(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_batch_t data;
+    ec_ioctl_sdo_request_t *records, *rec;
+    ec_sdo_request_t **reqs;
+    ec_slave_config_t *sc;
+    unsigned int i;
+    int ret = 0;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    if (!data.count
+            || data.count > UINT_MAX / sizeof(ec_ioctl_sdo_request_t))
+        return -EINVAL;
+
+    if (!(records = vmalloc(data.count * sizeof(ec_ioctl_sdo_request_t))))
+        return -ENOMEM;
+
+    if (!(reqs = vmalloc(data.count * sizeof(ec_sdo_request_t *)))) {
+        ret = -ENOMEM;
+        goto out_free_records;
+    }
+
+    if (copy_from_user(records, (void __user *) data.requests,
+                data.count * sizeof(ec_ioctl_sdo_request_t))) {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    for (i = 0; i < data.count; i++) {
+        rec = records + i;
+
+        if (!(sc = ec_master_get_config(master, rec->config_index))) {
+            ret = -ENOENT;
+            goto out_free;
+        }
+
+        if (!(reqs[i] = ec_slave_config_find_sdo_request(sc,
+                        rec->request_index))) {
+            ret = -ENOENT;
+            goto out_free;
+        }
+
+        if (rec->dir == EC_DIR_INPUT) {
+            continue;
+        }
+
+        if (rec->dir != EC_DIR_OUTPUT) {
+            EC_MASTER_ERR(master, "Invalid direction %u"
+                    " of SDO request %u!\n", rec->dir, i);
+            ret = -EINVAL;
+            goto out_free;
+        }
+
+        if (!rec->size) {
+            EC_MASTER_ERR(master, "SDO download: Data size may not be"
+                    " zero!\n");
+            ret = -EINVAL;
+            goto out_free;
+        }
+
+        ret = ec_sdo_request_alloc(reqs[i], rec->size);
+        if (ret)
+            goto out_free;
+
+        if (copy_from_user(reqs[i]->data, (void __user *) rec->data,
+                    rec->size)) {
+            ret = -EFAULT;
+            goto out_free;
+        }
+
+        reqs[i]->data_size = rec->size;
+    }
+
+    for (i = 0; i < data.count; i++) {
+        if (records[i].dir == EC_DIR_OUTPUT) {
+            ecrt_sdo_request_write(reqs[i]);
+        } else {
+            ecrt_sdo_request_read(reqs[i]);
+        }
+    }
+
+out_free:
+    vfree(reqs);
+out_free_records:
+    vfree(records);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Read SDO data.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_data(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    if (copy_to_user((void __user *) data.data, ecrt_sdo_request_data(req),
+                ecrt_sdo_request_data_size(req)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Reserves the SDO request memory for the application's external memory.
+ *
+ * The kernel memory is allocated with the size of the external memory, so
+ * that it does not have to be re-allocated during a transfer.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_memory(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_sdo_request_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor req will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc, data.request_index))) {
+        return -ENOENT;
+    }
+
+    if (req->state == EC_INT_REQUEST_QUEUED
+            || req->state == EC_INT_REQUEST_BUSY) {
+        return -EBUSY;
+    }
+
+    return ec_sdo_request_alloc(req, data.size);
+}
+
+/*****************************************************************************/
+
+/** Read register data.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_reg_request_data(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_reg_request_t io;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (io.mem_size <= 0) {
+        return 0;
+    }
+
+    /* no locking of master_sem needed, because neither sc nor reg will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+        return -ENOENT;
+    }
+
+    if (copy_to_user((void __user *) io.data, ecrt_reg_request_data(reg),
+                min(reg->mem_size, io.mem_size))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets an register request's state.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_reg_request_state(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_reg_request_t io;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because neither sc nor reg will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+        return -ENOENT;
+    }
+
+    io.state = ecrt_reg_request_state(reg);
+    io.new_data = io.state == EC_REQUEST_SUCCESS && reg->dir == EC_DIR_INPUT;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts an register write operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_reg_request_write(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_reg_request_t io;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because neither sc nor reg will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+        return -ENOENT;
+    }
+
+    if (io.transfer_size > reg->mem_size) {
+        return -EOVERFLOW;
+    }
+
+    if (copy_from_user(reg->data, (void __user *) io.data,
+                io.transfer_size)) {
+        return -EFAULT;
+    }
+
+    ecrt_reg_request_write(reg, io.address, io.transfer_size);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts an register read operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_reg_request_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_reg_request_t io;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+
+    if (unlikely(!ctx->requested)) {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    /* no locking of master_sem needed, because neither sc nor reg will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, io.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(reg = ec_slave_config_find_reg_request(sc, io.request_index))) {
+        return -ENOENT;
+    }
+
+    if (io.transfer_size > reg->mem_size) {
+        return -EOVERFLOW;
+    }
+
+    ecrt_reg_request_read(reg, io.address, io.transfer_size);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Sets the VoE send header.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_send_header(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+    uint32_t vendor_id;
+    uint16_t vendor_type;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    if (get_user(vendor_id, data.vendor_id))
+        return -EFAULT;
+
+    if (get_user(vendor_type, data.vendor_type))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_voe_handler_send_header(voe, vendor_id, vendor_type);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets the received VoE header.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_rec_header(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+    uint32_t vendor_id;
+    uint16_t vendor_type;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_voe_handler_received_header(voe, &vendor_id, &vendor_type);
+
+    if (likely(data.vendor_id))
+        if (put_user(vendor_id, data.vendor_id))
+            return -EFAULT;
+
+    if (likely(data.vendor_type))
+        if (put_user(vendor_type, data.vendor_type))
+            return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts a VoE read operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_voe_handler_read(voe);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts a VoE read operation without sending a sync message first.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_read_nosync(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    ecrt_voe_handler_read_nosync(voe);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Starts a VoE write operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_write(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    if (data.size) {
+        if (data.size > ec_voe_handler_mem_size(voe))
+            return -EOVERFLOW;
+
+        if (data.data) {
+            if (copy_from_user(ecrt_voe_handler_data(voe),
+                        (void __user *) data.data, data.size))
+                return -EFAULT;
+        } else if (voe->datagram.data_origin != EC_ORIG_EXTERNAL) {
+            return -EFAULT;
+        }
+        // otherwise, the data were written to the mapped memory
+    }
+
+    ecrt_voe_handler_write(voe, data.size);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Executes the VoE state machine.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_exec(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    data.state = ecrt_voe_handler_execute(voe);
+    if (data.state == EC_REQUEST_SUCCESS && voe->dir == EC_DIR_INPUT)
+        data.size = ecrt_voe_handler_data_size(voe);
+    else
+        data.size = 0;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Reads the received VoE data.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_data(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    if (copy_to_user((void __user *) data.data, ecrt_voe_handler_data(voe),
+                ecrt_voe_handler_data_size(voe)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Gets the offset of the VoE data in the memory mapped on activation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_offset(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_voe_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc, data.voe_index))) {
+        return -ENOENT;
+    }
+
+    if (!ctx->process_data || voe->datagram.data_origin != EC_ORIG_EXTERNAL)
+        return -ENODATA;
+
+    data.offset = ecrt_voe_handler_data(voe) - ctx->process_data;
+
+    if (copy_to_user((void __user *) arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+#ifndef EC_IOCTL_RTDM
+
+
+/** Sets the eventfd, that signals the completion of an SDO request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_sdo_request_eventfd(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_request_eventfd_t data;
+    ec_slave_config_t *sc;
+    ec_sdo_request_t *req;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* master_sem is locked, because the request is processed by the slave
+     * state machines, that run with master_sem locked. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    if (!(req = ec_slave_config_find_sdo_request(sc,
+                    data.request_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    ret = ec_request_eventfd(&req->eventfd, data.fd);
+    up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Sets the eventfd, that signals the completion of a register request.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_reg_request_eventfd(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_request_eventfd_t data;
+    ec_slave_config_t *sc;
+    ec_reg_request_t *reg;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* master_sem is locked, because the request is processed by the slave
+     * state machines, that run with master_sem locked. */
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    if (!(reg = ec_slave_config_find_reg_request(sc,
+                    data.request_index))) {
+        up(&master->master_sem);
+        return -ENOENT;
+    }
+
+    ret = ec_request_eventfd(&reg->eventfd, data.fd);
+    up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Sets the eventfd, that signals the completion of a VoE handler operation.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_voe_eventfd(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_request_eventfd_t data;
+    ec_slave_config_t *sc;
+    ec_voe_handler_t *voe;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&data, (void __user *) arg, sizeof(data)))
+        return -EFAULT;
+
+    /* no locking of master_sem needed, because neither sc nor voe will not be
+     * deleted in the meantime. */
+
+    if (!(sc = ec_master_get_config(master, data.config_index))) {
+        return -ENOENT;
+    }
+
+    if (!(voe = ec_slave_config_find_voe_handler(sc,
+                    data.request_index))) {
+        return -ENOENT;
+    }
+
+    return ec_request_eventfd(&voe->eventfd, data.fd);
+}
+
+/*****************************************************************************/
+
+/** Sets the eventfd, that signals CoE emergencies of the application's slave
+ * configurations.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_emerg_eventfd(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    int32_t fd;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+        return -EPERM;
+
+    if (copy_from_user(&fd, (void __user *) arg, sizeof(fd)))
+        return -EFAULT;
+
+    if (down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    ret = ec_request_eventfd(&ctx->emerg_eventfd, fd);
+    if (!ret) {
+        ec_ioctl_attach_emerg_rings(master, ctx);
+    }
+
+    up(&master->master_sem);
+    return ret;
+}
+
+#endif
+
+/*****************************************************************************/
+
+/** Read a file from a slave via FoE.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_foe_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_slave_foe_t io;
+    ec_foe_request_t request;
+    ec_slave_t *slave;
+    int ret;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    ec_foe_request_init(&request, io.file_name);
+    ret = ec_foe_request_alloc(&request, 10000); // FIXME
+    if (ret) {
+        ec_foe_request_clear(&request);
+        return ret;
+    }
+
+    ec_foe_request_read(&request);
+
+    if (down_interruptible(&master->master_sem)) {
+        ec_foe_request_clear(&request);
+        return -EINTR;
+    }
+
+    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+        up(&master->master_sem);
+        ec_foe_request_clear(&request);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                io.slave_position);
+        return -EINVAL;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Scheduling FoE read request.\n");
+
+    // schedule request.
+    list_add_tail(&request.list, &slave->foe_requests);
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+
+    // wait for processing through FSM
+    if (wait_event_interruptible(master->request_queue,
+                request.state != EC_INT_REQUEST_QUEUED)) {
+        // interrupted by signal
+        down(&master->master_sem);
+        if (request.state == EC_INT_REQUEST_QUEUED) {
+            list_del(&request.list);
+            up(&master->master_sem);
+            ec_foe_request_clear(&request);
+            return -EINTR;
+        }
+        // request already processing: interrupt not possible.
+        up(&master->master_sem);
+    }
+
+    // wait until master FSM has finished processing
+    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+
+    io.result = request.result;
+    io.error_code = request.error_code;
+
+    if (request.state != EC_INT_REQUEST_SUCCESS) {
+        io.data_size = 0;
+        ret = -EIO;
+    } else {
+        if (request.data_size > io.buffer_size) {
+            EC_SLAVE_ERR(slave, "%s(): Buffer too small.\n", __func__);
+            ec_foe_request_clear(&request);
+            return -EOVERFLOW;
+        }
+        io.data_size = request.data_size;
+        if (copy_to_user((void __user *) io.buffer,
+                    request.buffer, io.data_size)) {
+            ec_foe_request_clear(&request);
+            return -EFAULT;
+        }
+        ret = 0;
+    }
+
+    if (__copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        ret = -EFAULT;
+    }
+
+    ec_foe_request_clear(&request);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Write a file to a slave via FoE
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_foe_write(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_slave_foe_t io;
+    ec_foe_request_t request;
+    ec_slave_t *slave;
+    int ret;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    ec_foe_request_init(&request, io.file_name);
+
+    ret = ec_foe_request_alloc(&request, io.buffer_size);
+    if (ret) {
+        ec_foe_request_clear(&request);
+        return ret;
+    }
+
+    if (copy_from_user(request.buffer,
+                (void __user *) io.buffer, io.buffer_size)) {
+        ec_foe_request_clear(&request);
+        return -EFAULT;
+    }
+
+    request.data_size = io.buffer_size;
+    ec_foe_request_write(&request);
+
+    if (down_interruptible(&master->master_sem)) {
+        ec_foe_request_clear(&request);
+        return -EINTR;
+    }
+
+    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+        up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                io.slave_position);
+        ec_foe_request_clear(&request);
+        return -EINVAL;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Scheduling FoE write request.\n");
+
+    // schedule FoE write request.
+    list_add_tail(&request.list, &slave->foe_requests);
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+
+    // wait for processing through FSM
+    if (wait_event_interruptible(master->request_queue,
+                request.state != EC_INT_REQUEST_QUEUED)) {
+        // interrupted by signal
+        down(&master->master_sem);
+        if (request.state == EC_INT_REQUEST_QUEUED) {
+            // abort request
+            list_del(&request.list);
+            up(&master->master_sem);
+            ec_foe_request_clear(&request);
+            return -EINTR;
+        }
+        up(&master->master_sem);
+    }
+
+    // wait until master FSM has finished processing
+    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+
+    io.result = request.result;
+    io.error_code = request.error_code;
+
+    ret = request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
+
+    if (__copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        ret = -EFAULT;
+    }
+
+    ec_foe_request_clear(&request);
+    return ret;
+}
+
+/*****************************************************************************/
+
+#ifndef EC_IOCTL_RTDM
+
+/** FoE job.
+ *
+ * Writes the same file to several slaves. Every slave gets its own FoE
+ * request, so that the transfers are processed in parallel by the slave
+ * state machines. The file data are shared by all requests.
+ */
+struct ec_ioctl_foe_job {
+    uint8_t *buffer; /**< File data. */
+    char file_name[32]; /**< Target file name. */
+    uint32_t count; /**< Number of slaves. */
+    ec_ioctl_foe_job_slave_t *slaves; /**< Slave states. */
+    ec_foe_request_t *requests; /**< FoE requests, one per slave. */
+};
+
+/*****************************************************************************/
+
+/** Frees an FoE job.
+ *
+ * The requests must not be queued or processed any more. They are not
+ * cleared, because they do not own the shared buffer.
+ */
+static void ec_ioctl_foe_job_free(
+        struct ec_ioctl_foe_job *job /**< FoE job. */
+        )
+{
+    if (job->buffer) {
+        vfree(job->buffer);
+    }
+    vfree(job->requests);
+    vfree(job->slaves);
+    kfree(job);
+}
+
+/*****************************************************************************/
+
+/** Counts the requests of an FoE job, that are queued or processed.
+ *
+ * \return Number of unfinished requests.
+ */
+static uint32_t ec_ioctl_foe_job_busy(
+        const struct ec_ioctl_foe_job *job /**< FoE job. */
+        )
+{
+    uint32_t i, busy = 0;
+
+    for (i = 0; i < job->count; i++) {
+        if (job->requests[i].state == EC_INT_REQUEST_QUEUED
+                || job->requests[i].state == EC_INT_REQUEST_BUSY) {
+            busy++;
+        }
+    }
+
+    return busy;
+}
+
+/*****************************************************************************/
+
+/** Starts writing a file to several slaves via FoE.
+ *
+ * The call returns as soon as the requests are queued. The progress has to
+ * be queried with EC_IOCTL_FOE_JOB_STATUS.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_foe_job_start(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_foe_job_t io;
+    struct ec_ioctl_foe_job *job;
+    ec_slave_t *slave;
+    uint32_t i;
+    int ret;
+
+    if (ctx->foe_job) {
+        return -EBUSY;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!io.slave_count || io.slave_count > master->slave_count) {
+        return -EINVAL;
+    }
+
+    if (!(job = kzalloc(sizeof(*job), GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    job->count = io.slave_count;
+    memcpy(job->file_name, io.file_name, sizeof(job->file_name));
+    job->file_name[sizeof(job->file_name) - 1] = 0;
+
+    if (!(job->slaves = vmalloc(job->count * sizeof(*job->slaves)))
+            || !(job->requests =
+                vmalloc(job->count * sizeof(*job->requests)))
+            || (io.buffer_size
+                && !(job->buffer = vmalloc(io.buffer_size)))) {
+        ret = -ENOMEM;
+        goto out_free;
+    }
+
+    if (copy_from_user(job->slaves, (void __user *) io.slaves,
+                job->count * sizeof(*job->slaves))
+            || copy_from_user(job->buffer, (void __user *) io.buffer,
+                io.buffer_size)) {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    for (i = 0; i < job->count; i++) {
+        ec_foe_request_t *request = &job->requests[i];
+
+        ec_foe_request_init(request, job->file_name);
+        request->buffer = job->buffer;
+        request->buffer_size = io.buffer_size;
+        request->data_size = io.buffer_size;
+        ec_foe_request_write(request);
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_free;
+    }
+
+    for (i = 0; i < job->count; i++) {
+        if (!ec_master_find_slave(master, 0, job->slaves[i].slave_position)) {
+            up(&master->master_sem);
+            EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                    job->slaves[i].slave_position);
+            ret = -EINVAL;
+            goto out_free;
+        }
+    }
+
+    for (i = 0; i < job->count; i++) {
+        slave = ec_master_find_slave(master, 0,
+                job->slaves[i].slave_position);
+        EC_SLAVE_DBG(slave, 1, "Scheduling FoE write request.\n");
+        list_add_tail(&job->requests[i].list, &slave->foe_requests);
+    }
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+
+    ctx->foe_job = job;
+    return 0;
+
+out_free:
+    ec_ioctl_foe_job_free(job);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Reports the state of the FoE job.
+ *
+ * Waits for the end of the job, but at most half a second, so that the
+ * progress can be displayed. The job is freed, as soon as a status with no
+ * busy slaves was reported.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_foe_job_status(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_foe_job_t io;
+    struct ec_ioctl_foe_job *job = ctx->foe_job;
+    uint32_t i, count;
+
+    if (!job) {
+        return -ENOENT;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (wait_event_interruptible_timeout(master->request_queue,
+                !ec_ioctl_foe_job_busy(job), HZ / 2) < 0) {
+        return -EINTR;
+    }
+
+    for (i = 0; i < job->count; i++) {
+        const ec_foe_request_t *request = &job->requests[i];
+        ec_ioctl_foe_job_slave_t *slave = &job->slaves[i];
+
+        slave->state = ec_request_state_translation_table[request->state];
+        slave->progress = request->progress;
+        slave->result = request->result;
+        slave->error_code = request->error_code;
+    }
+
+    io.busy_count = ec_ioctl_foe_job_busy(job);
+    count = min(io.slave_count, job->count);
+
+    if (copy_to_user((void __user *) io.slaves, job->slaves,
+                count * sizeof(*job->slaves))
+            || copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (!io.busy_count) {
+        ctx->foe_job = NULL;
+        ec_ioctl_foe_job_free(job);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Aborts the FoE job of a file handle.
+ *
+ * Queued requests are dequeued, then the transfers in progress are waited
+ * for.
+ */
+void ec_ioctl_foe_job_abort(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    struct ec_ioctl_foe_job *job = ctx->foe_job;
+    uint32_t i;
+
+    down(&master->master_sem);
+    for (i = 0; i < job->count; i++) {
+        if (job->requests[i].state == EC_INT_REQUEST_QUEUED) {
+            list_del(&job->requests[i].list);
+            job->requests[i].state = EC_INT_REQUEST_FAILURE;
+        }
+    }
+    up(&master->master_sem);
+
+    wait_event(master->request_queue, !ec_ioctl_foe_job_busy(job));
+
+    ctx->foe_job = NULL;
+    ec_ioctl_foe_job_free(job);
+}
+
+/*****************************************************************************/
+
+/** Streamed FoE transfer.
+ *
+ * The request only holds a window of the file, that is refilled (write) or
+ * emptied (read) via EC_IOCTL_FOE_STREAM_TRANSFER, whenever the FoE state
+ * machine asks for it. So the memory needed does not depend on the file
+ * size.
+ */
+struct ec_ioctl_foe_stream {
+    ec_foe_request_t request; /**< FoE request with the window. */
+    char file_name[32]; /**< File name on the slave. */
+};
+
+/*****************************************************************************/
+
+/** Frees a streamed FoE transfer.
+ *
+ * The request must not be queued or processed any more.
+ */
+static void ec_ioctl_foe_stream_free(
+        struct ec_ioctl_foe_stream *stream /**< Streamed transfer. */
+        )
+{
+    ec_foe_request_clear(&stream->request);
+    kfree(stream);
+}
+
+/*****************************************************************************/
+
+/** Checks, if a streamed FoE transfer was finished by the state machine.
+ *
+ * \return Non-zero, if the request is neither queued nor processed.
+ */
+static int ec_ioctl_foe_stream_done(
+        const ec_foe_request_t *request /**< FoE request. */
+        )
+{
+    return request->state != EC_INT_REQUEST_QUEUED
+        && request->state != EC_INT_REQUEST_BUSY;
+}
+
+/*****************************************************************************/
+
+/** Starts a streamed FoE transfer.
+ *
+ * The call returns as soon as the request is queued. The data have to be
+ * passed with EC_IOCTL_FOE_STREAM_TRANSFER.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_foe_stream_start(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_foe_stream_t io;
+    struct ec_ioctl_foe_stream *stream;
+    ec_foe_request_t *request;
+    ec_slave_t *slave;
+    int ret;
+
+    if (ctx->foe_stream) {
+        return -EBUSY;
+    }
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if ((io.dir != EC_DIR_OUTPUT && io.dir != EC_DIR_INPUT)
+            || !io.window_size) {
+        return -EINVAL;
+    }
+
+    if (io.dir == EC_DIR_OUTPUT && !ctx->writable) {
+        return -EPERM;
+    }
+
+    if (!(stream = kzalloc(sizeof(*stream), GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    memcpy(stream->file_name, io.file_name, sizeof(stream->file_name));
+    stream->file_name[sizeof(stream->file_name) - 1] = 0;
+
+    request = &stream->request;
+    ec_foe_request_init(request, stream->file_name);
+    ret = ec_foe_request_alloc(request, io.window_size);
+    if (ret) {
+        goto out_free;
+    }
+
+    request->stream = 1;
+    if (io.dir == EC_DIR_OUTPUT) {
+        // the window is empty, so the application has to fill it first
+        request->stream_wait = 1;
+        ec_foe_request_write(request);
+    } else {
+        ec_foe_request_read(request);
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_free;
+    }
+
+    if (!(slave = ec_master_find_slave(master, 0, io.slave_position))) {
+        up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n",
+                io.slave_position);
+        ret = -EINVAL;
+        goto out_free;
+    }
+
+    // the window has to hold at least one fragment
+    if (io.window_size < slave->configured_rx_mailbox_size
+            || io.window_size < slave->configured_tx_mailbox_size) {
+        up(&master->master_sem);
+        EC_SLAVE_ERR(slave, "FoE window of %u byte is smaller than"
+                " the mailbox.\n", io.window_size);
+        ret = -EINVAL;
+        goto out_free;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Scheduling streamed FoE %s request.\n",
+            io.dir == EC_DIR_OUTPUT ? "write" : "read");
+    list_add_tail(&request->list, &slave->foe_requests);
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+
+    ctx->foe_stream = stream;
+    return 0;
+
+out_free:
+    ec_ioctl_foe_stream_free(stream);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Passes the next block of a streamed FoE transfer.
+ *
+ * Waits, until the state machine asks for the window, or the transfer is
+ * finished. A write then appends the application's block to the window, a
+ * read moves the received data out of it. The transfer is freed, as soon
+ * as a state other than busy was reported.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_foe_stream_transfer(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_foe_stream_t io;
+    struct ec_ioctl_foe_stream *stream = ctx->foe_stream;
+    ec_foe_request_t *request;
+    size_t size;
+    int done;
+
+    if (!stream) {
+        return -ENOENT;
+    }
+    request = &stream->request;
+
+    if (copy_from_user(&io, (void __user *) arg, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (wait_event_interruptible(master->request_queue,
+                request->stream_wait || ec_ioctl_foe_stream_done(request))) {
+        return -EINTR;
+    }
+
+    done = ec_ioctl_foe_stream_done(request);
+    smp_rmb(); // flag before the window contents
+    io.data_size = 0;
+
+    if (request->dir == EC_DIR_OUTPUT) {
+        if (!done) {
+            size = min_t(size_t, io.buffer_size,
+                    request->buffer_size - request->data_size);
+            if (copy_from_user(request->buffer + request->data_size,
+                        (void __user *) io.buffer, size)) {
+                return -EFAULT;
+            }
+            request->data_size += size;
+            io.data_size = size;
+
+            if (io.end && size == io.buffer_size) {
+                request->stream_end = 1;
+            }
+
+            if (request->stream_end
+                    || request->data_size == request->buffer_size) {
+                smp_wmb(); // window contents before the flag
+                request->stream_wait = 0;
+            }
+        }
+    } else if (request->stream_wait
+            || request->state == EC_INT_REQUEST_SUCCESS) {
+        size = min_t(size_t, io.buffer_size, request->data_size);
+        if (copy_to_user((void __user *) io.buffer, request->buffer, size)) {
+            return -EFAULT;
+        }
+        memmove(request->buffer, request->buffer + size,
+                request->data_size - size);
+        request->data_size -= size;
+        request->window_offset += size;
+        io.data_size = size;
+
+        if (!done && !request->data_size) {
+            smp_wmb(); // window contents before the flag
+            request->stream_wait = 0;
+        }
+    }
+
+    io.state = ec_request_state_translation_table[request->state];
+    if (io.state == EC_REQUEST_SUCCESS && request->dir == EC_DIR_INPUT
+            && request->data_size) {
+        // the end of the file is still in the window
+        io.state = EC_REQUEST_BUSY;
+    }
+    io.progress = request->progress;
+    io.result = request->result;
+    io.error_code = request->error_code;
+
+    if (copy_to_user((void __user *) arg, &io, sizeof(io))) {
+        return -EFAULT;
+    }
+
+    if (io.state != EC_REQUEST_BUSY) {
+        ctx->foe_stream = NULL;
+        ec_ioctl_foe_stream_free(stream);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Memory of a sharing application, that released the master early.
+ *
+ * The domains of the application stay configured until the master is
+ * released by all applications, so their memory is kept until then.
+ */
+typedef struct {
+    struct list_head list; /**< Item of the master's \a kept_mem list. */
+    uint8_t *mem; /**< Memory. */
+    size_t size; /**< Size of \a mem. */
+    uint32_t map_flags; /**< Allocation flags (EC_MAP_*) of \a mem. */
+} ec_ioctl_kept_mem_t;
+
+/*****************************************************************************/
+
+/** Frees memory allocated by ec_ioctl_activate().
+ */
+static void ec_ioctl_free_mem(
+        uint8_t *mem, /**< Memory. */
+        size_t size, /**< Size of \a mem. */
+        uint32_t map_flags /**< Allocation flags (EC_MAP_*). */
+        )
+{
+    if (map_flags & EC_MAP_CONTIGUOUS) {
+        free_pages_exact(mem, size);
+    } else {
+        vfree(mem);
+    }
+}
+
+/*****************************************************************************/
+
+/** Releases the master and frees the memory of a file handle.
+ *
+ * The memory is withdrawn from read-only mappers first. Pages, that they
+ * still map, stay allocated until they are unmapped, but are not updated any
+ * more; the domain count in the state page is cleared to tell them.
+ *
+ * If other applications still share the master, the memory is kept until
+ * the last of them releases the master.
+ */
+void ec_ioctl_release(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    ec_ioctl_kept_mem_t *kept, *next;
+    ec_slave_config_t *sc;
+    ec_domain_t *domain;
+    int activate = 0;
+
+    if (ctx->requested) {
+        down(&master->master_sem);
+        list_for_each_entry(sc, &master->configs, list) {
+            if (sc->owner == ctx) {
+                ec_coe_emerg_ring_attach(&sc->emerg_ring, NULL, NULL, NULL);
+                sc->owner = NULL;
+            }
+        }
+        list_for_each_entry(domain, &master->domains, list) {
+            if (domain->owner == ctx) {
+                domain->owner = NULL;
+            }
+        }
+        if (master->shared && !master->active && ctx->process_data) {
+            master->activations--; // withdraw the pending activation
+        }
+        up(&master->master_sem);
+
+        ecrt_release_master(master);
+        ctx->requested = 0;
+
+        down(&master->master_sem);
+        activate = master->shared && !master->active
+            && master->activations
+            && master->activations >= master->reserved;
+        up(&master->master_sem);
+
+        if (activate && ecrt_master_activate(master)) {
+            EC_MASTER_ERR(master, "Failed to activate master for the"
+                    " remaining applications!\n");
+        }
+    }
+
+    ec_request_eventfd(&ctx->emerg_eventfd, -1);
+
+    if (!ctx->process_data) {
+        return;
+    }
+
+    down(&master->master_sem);
+    if (master->mapped_mem == ctx->process_data) {
+        master->mapped_mem = NULL;
+        master->mapped_mem_size = 0;
+        master->mapped_mem_flags = 0;
+    }
+    if (ctx->state
+            && master->cycle_trigger_ext == &ctx->state->cycle_trigger) {
+        master->cycle_trigger_ext = NULL;
+    }
+    up(&master->master_sem);
+
+    if (ctx->state) {
+        ctx->state->domain_count = 0;
+        ctx->state = NULL;
+    }
+
+    if (master->reserved && (kept = kmalloc(sizeof(*kept), GFP_KERNEL))) {
+        // the domains of the application are still in use
+        kept->mem = ctx->process_data;
+        kept->size = ctx->mmap_size;
+        kept->map_flags = ctx->map_flags;
+        down(&master->master_sem);
+        list_add_tail(&kept->list, &master->kept_mem);
+        up(&master->master_sem);
+    } else {
+        if (master->reserved) {
+            EC_MASTER_WARN(master, "Failed to keep released memory.\n");
+        }
+        ec_ioctl_free_mem(ctx->process_data, ctx->mmap_size,
+                ctx->map_flags);
+    }
+    ctx->process_data = NULL;
+
+    if (!master->reserved) {
+        down(&master->master_sem);
+        list_for_each_entry_safe(kept, next, &master->kept_mem, list) {
+            list_del(&kept->list);
+            ec_ioctl_free_mem(kept->mem, kept->size, kept->map_flags);
+            kfree(kept);
+        }
+        up(&master->master_sem);
+    }
+}
+
+/*****************************************************************************/
+
+/** Aborts the streamed FoE transfer of a file handle.
+ *
+ * A queued request is dequeued, a request in progress is aborted, as soon
+ * as the state machine waits for the window.
+ */
+void ec_ioctl_foe_stream_abort(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx /**< Private data structure of file handle. */
+        )
+{
+    struct ec_ioctl_foe_stream *stream = ctx->foe_stream;
+    ec_foe_request_t *request = &stream->request;
+
+    down(&master->master_sem);
+    if (request->state == EC_INT_REQUEST_QUEUED) {
+        list_del(&request->list);
+        request->state = EC_INT_REQUEST_FAILURE;
+    }
+    up(&master->master_sem);
+
+    request->stream_abort = 1;
+    wait_event(master->request_queue, ec_ioctl_foe_stream_done(request));
+
+    ctx->foe_stream = NULL;
+    ec_ioctl_foe_stream_free(stream);
+}
+
+#endif
+
+/*****************************************************************************/
+
+/** Read an SoE IDN.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_soe_read(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_slave_soe_read_t ioctl;
+    u8 *data;
+    int retval;
+
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
+        return -EFAULT;
+    }
+
+    data = kmalloc(ioctl.mem_size, GFP_KERNEL);
+    if (!data) {
+        EC_MASTER_ERR(master, "Failed to allocate %zu bytes of IDN data.\n",
+                ioctl.mem_size);
+        return -ENOMEM;
+    }
+
+    retval = ecrt_master_read_idn(master, ioctl.slave_position,
+            ioctl.drive_no, ioctl.idn, data, ioctl.mem_size, &ioctl.data_size,
+            &ioctl.error_code);
+    if (retval) {
+        kfree(data);
+        return retval;
+    }
+
+    if (copy_to_user((void __user *) ioctl.data,
+                data, ioctl.data_size)) {
+        kfree(data);
+        return -EFAULT;
+    }
+    kfree(data);
+
+    if (__copy_to_user((void __user *) arg, &ioctl, sizeof(ioctl))) {
+        retval = -EFAULT;
+    }
+
+    EC_MASTER_DBG(master, 1, "Finished SoE read request.\n");
+    return retval;
+}
+
+/*****************************************************************************/
+
+/** Write an IDN to a slave via SoE.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_soe_write(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg /**< ioctl() argument. */
+        )
+{
+    ec_ioctl_slave_soe_write_t ioctl;
+    u8 *data;
+    int retval;
+
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
+        return -EFAULT;
+    }
+
+    data = kmalloc(ioctl.data_size, GFP_KERNEL);
+    if (!data) {
+        EC_MASTER_ERR(master, "Failed to allocate %zu bytes of IDN data.\n",
+                ioctl.data_size);
+        return -ENOMEM;
+    }
+    if (copy_from_user(data, (void __user *) ioctl.data, ioctl.data_size)) {
+        kfree(data);
+        return -EFAULT;
+    }
+
+    retval = ecrt_master_write_idn(master, ioctl.slave_position,
+            ioctl.drive_no, ioctl.idn, data, ioctl.data_size,
+            &ioctl.error_code);
+    kfree(data);
+    if (retval) {
+        return retval;
+    }
+
+    if (__copy_to_user((void __user *) arg, &ioctl, sizeof(ioctl))) {
+        retval = -EFAULT;
+    }
+
+    EC_MASTER_DBG(master, 1, "Finished SoE write request.\n");
+    return retval;
+}
+
+/*****************************************************************************/
+
+/** Read or write a list of IDNs via SoE.
+ *
+ * The data of all transfers are kept in one kernel buffer.
+ *
+ * \return Zero if all transfers succeeded, -EIO if at least one of them
+ *         failed, otherwise a negative error code.
+ */
+static ATTRIBUTES int ec_ioctl_slave_soe_idns(
+        ec_master_t *master, /**< EtherCAT master. */
+        void *arg, /**< ioctl() argument. */
+        ec_direction_t dir /**< Transfer direction. */
+        )
+{
+    ec_ioctl_slave_soe_idns_t ioctl;
+    ec_soe_idn_transfer_t *transfers;
+    uint8_t **user_data;
+    u8 *data = NULL;
+    size_t total_size = 0, offset = 0;
+    unsigned int i;
+    int retval;
+
+    if (copy_from_user(&ioctl, (void __user *) arg, sizeof(ioctl))) {
+        return -EFAULT;
+    }
+
+    if (!ioctl.count || ioctl.count > 0x10000) {
+        return -EINVAL;
+    }
+
+    if (!(transfers = vmalloc(ioctl.count * sizeof(*transfers)))) {
+        return -ENOMEM;
+    }
+
+    if (!(user_data = vmalloc(ioctl.count * sizeof(*user_data)))) {
+        retval = -ENOMEM;
+        goto out_free_transfers;
+    }
+
+    if (copy_from_user(transfers, (void __user *) ioctl.transfers,
+                ioctl.count * sizeof(*transfers))) {
+        retval = -EFAULT;
+        goto out_free_user_data;
+    }
+
+    for (i = 0; i < ioctl.count; i++) {
+        if (transfers[i].size > SIZE_MAX - total_size) {
+            retval = -EINVAL;
+            goto out_free_user_data;
+        }
+        total_size += transfers[i].size;
+    }
+
+    if (total_size && !(data = vmalloc(total_size))) {
+        EC_MASTER_ERR(master, "Failed to allocate %zu bytes of IDN data.\n",
+                total_size);
+        retval = -ENOMEM;
+        goto out_free_user_data;
+    }
+
+    for (i = 0; i < ioctl.count; i++) {
+        user_data[i] = transfers[i].data;
+        transfers[i].data = data + offset;
+        if (dir == EC_DIR_OUTPUT && copy_from_user(transfers[i].data,
+                    (void __user *) user_data[i], transfers[i].size)) {
+            retval = -EFAULT;
+            goto out_free_data;
+        }
+        offset += transfers[i].size;
+    }
+
+    if (dir == EC_DIR_OUTPUT) {
+        retval = ecrt_master_write_idns(master, ioctl.slave_position,
+                transfers, ioctl.count);
+    } else {
+        retval = ecrt_master_read_idns(master, ioctl.slave_position,
+                transfers, ioctl.count);
+    }
+    if (retval && retval != -EIO) {
+        goto out_free_data;
+    }
+
+    for (i = 0; i < ioctl.count; i++) {
+        if (dir == EC_DIR_INPUT && transfers[i].result_size
+                && copy_to_user((void __user *) user_data[i],
+                    transfers[i].data, transfers[i].result_size)) {
+            retval = -EFAULT;
+            goto out_free_data;
+        }
+        transfers[i].data = user_data[i];
+    }
+
+    if (copy_to_user((void __user *) ioctl.transfers, transfers,
+                ioctl.count * sizeof(*transfers))) {
+        retval = -EFAULT;
+    }
+
+    EC_MASTER_DBG(master, 1, "Finished %u SoE %s requests.\n",
+            ioctl.count, dir == EC_DIR_OUTPUT ? "write" : "read");
+
+out_free_data:
+    if (data) {
+        vfree(data);
+    }
+out_free_user_data:
+    vfree(user_data);
+out_free_transfers:
+    vfree(transfers);
+    return retval;
+}
+
+/*****************************************************************************/
+
+/** ioctl() function to use.
+ */
+#ifdef EC_IOCTL_RTDM
+#define EC_IOCTL ec_ioctl_rtdm
+#else
+#define EC_IOCTL ec_ioctl
+#endif
+
+/** Called when an ioctl() command is issued.
+ *
+ * \return ioctl() return code.
+ */
+long EC_IOCTL(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx, /**< Device context. */
+        unsigned int cmd, /**< ioctl() command identifier. */
+        void *arg /**< ioctl() argument. */
         )
 {
 #if DEBUG_LATENCY
     cycles_t a = get_cycles(), b;
     unsigned int t;
 #endif
-    int ret;
-
-    switch (cmd) {
-        case EC_IOCTL_MODULE:
-            ret = ec_ioctl_module(arg);
+    int ret;
+
+    switch (cmd) {
+        case EC_IOCTL_MODULE:
+            ret = ec_ioctl_module(arg);
+            break;
+        case EC_IOCTL_MASTER:
+            ret = ec_ioctl_master(master, arg);
+            break;
+        case EC_IOCTL_SLAVE:
+            ret = ec_ioctl_slave(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SYNC:
+            ret = ec_ioctl_slave_sync(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SYNC_PDO:
+            ret = ec_ioctl_slave_sync_pdo(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SYNC_PDO_ENTRY:
+            ret = ec_ioctl_slave_sync_pdo_entry(master, arg);
+            break;
+        case EC_IOCTL_DOMAIN:
+            ret = ec_ioctl_domain(master, arg);
+            break;
+        case EC_IOCTL_DOMAIN_FMMU:
+            ret = ec_ioctl_domain_fmmu(master, arg);
+            break;
+        case EC_IOCTL_DOMAIN_DATA:
+            ret = ec_ioctl_domain_data(master, arg);
+            break;
+        case EC_IOCTL_MAP_READ_ONLY:
+            ret = ec_ioctl_map_read_only(master, arg, ctx);
+            break;
+        case EC_IOCTL_MASTER_DEBUG:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_master_debug(master, arg);
+            break;
+        case EC_IOCTL_MASTER_RESCAN:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_master_rescan(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_STATE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_state(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SDO:
+            ret = ec_ioctl_slave_sdo(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SDO_ENTRY:
+            ret = ec_ioctl_slave_sdo_entry(master, arg);
+            break;
+        case EC_IOCTL_DICT_IMPORT:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_dict_import(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+            ret = ec_ioctl_slave_sdo_upload(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_sdo_download(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SII_READ:
+            ret = ec_ioctl_slave_sii_read(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SII_WRITE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_sii_write(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SII_READ_BATCH:
+            ret = ec_ioctl_slave_sii_read_batch(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SII_WRITE_BATCH:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_sii_write_batch(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_REG_READ:
+            ret = ec_ioctl_slave_reg_read(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_reg_write(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_REG_READ_BATCH:
+            ret = ec_ioctl_slave_reg_batch(master, arg, EC_DIR_INPUT);
+            break;
+        case EC_IOCTL_SLAVE_REG_WRITE_BATCH:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_reg_batch(master, arg, EC_DIR_OUTPUT);
+            break;
+        case EC_IOCTL_SLAVE_FOE_READ:
+            ret = ec_ioctl_slave_foe_read(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_FOE_WRITE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_foe_write(master, arg);
+            break;
+#ifndef EC_IOCTL_RTDM
+        case EC_IOCTL_FOE_JOB_START:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_foe_job_start(master, arg, ctx);
+            break;
+        case EC_IOCTL_FOE_JOB_STATUS:
+            ret = ec_ioctl_foe_job_status(master, arg, ctx);
+            break;
+        case EC_IOCTL_FOE_STREAM_START:
+            ret = ec_ioctl_foe_stream_start(master, arg, ctx);
+            break;
+        case EC_IOCTL_FOE_STREAM_TRANSFER:
+            ret = ec_ioctl_foe_stream_transfer(master, arg, ctx);
+            break;
+#endif
+        case EC_IOCTL_SLAVE_SOE_READ:
+            ret = ec_ioctl_slave_soe_read(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SOE_WRITE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_soe_write(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SOE_READ_IDNS:
+            ret = ec_ioctl_slave_soe_idns(master, arg, EC_DIR_INPUT);
+            break;
+        case EC_IOCTL_SLAVE_SOE_WRITE_IDNS:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_slave_soe_idns(master, arg, EC_DIR_OUTPUT);
+            break;
+        case EC_IOCTL_CONFIG:
+            ret = ec_ioctl_config(master, arg);
+            break;
+        case EC_IOCTL_CONFIG_PDO:
+            ret = ec_ioctl_config_pdo(master, arg);
+            break;
+        case EC_IOCTL_CONFIG_PDO_ENTRY:
+            ret = ec_ioctl_config_pdo_entry(master, arg);
+            break;
+        case EC_IOCTL_CONFIG_SDO:
+            ret = ec_ioctl_config_sdo(master, arg);
+            break;
+        case EC_IOCTL_CONFIG_IDN:
+            ret = ec_ioctl_config_idn(master, arg);
+            break;
+#ifdef EC_EOE
+        case EC_IOCTL_EOE_HANDLER:
+            ret = ec_ioctl_eoe_handler(master, arg);
+            break;
+#endif
+        case EC_IOCTL_REQUEST:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_request(master, arg, ctx);
+            break;
+#ifndef EC_IOCTL_RTDM
+        case EC_IOCTL_REQUEST_SHARED:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_request_shared(master, arg, ctx);
+            break;
+#endif
+        case EC_IOCTL_CREATE_DOMAIN:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_create_domain(master, arg, ctx);
+            break;
+        case EC_IOCTL_CREATE_SLAVE_CONFIG:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_create_slave_config(master, arg, ctx);
+            break;
+        case EC_IOCTL_SELECT_REF_CLOCK:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_select_ref_clock(master, arg, ctx);
+            break;
+        case EC_IOCTL_SELECT_DC_DOMAIN:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_select_dc_domain(master, arg, ctx);
+            break;
+        case EC_IOCTL_ACTIVATE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_activate(master, arg, ctx);
+            break;
+        case EC_IOCTL_DEACTIVATE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_deactivate(master, arg, ctx);
+            break;
+        case EC_IOCTL_SEND:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_send(master, arg, ctx);
+            break;
+        case EC_IOCTL_SEND_AT:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_send_at(master, arg, ctx);
+            break;
+        case EC_IOCTL_RECEIVE_WAIT:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_receive_wait(master, arg, ctx);
+            break;
+        case EC_IOCTL_TIMED_CYCLE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_timed_cycle(master, arg, ctx);
+            break;
+        case EC_IOCTL_TRAFFIC_CLASS:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_traffic_class(master, arg, ctx);
+            break;
+        case EC_IOCTL_CYCLE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_cycle(master, arg, ctx);
+            break;
+        case EC_IOCTL_CYCLE_SHARED:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_cycle_shared(master, arg, ctx);
+            break;
+#ifndef EC_IOCTL_RTDM
+        case EC_IOCTL_DOMAIN_NOTIFY:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_domain_notify(master, arg, ctx);
+            break;
+#endif
+        case EC_IOCTL_RECEIVE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_receive(master, arg, ctx);
             break;
-        case EC_IOCTL_MASTER:
-            ret = ec_ioctl_master(master, arg);
+        case EC_IOCTL_MASTER_STATE:
+            ret = ec_ioctl_master_state(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE:
-            ret = ec_ioctl_slave(master, arg);
+        case EC_IOCTL_MASTER_LINK_STATE:
+            ret = ec_ioctl_master_link_state(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_SYNC:
-            ret = ec_ioctl_slave_sync(master, arg);
+        case EC_IOCTL_APP_TIME:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_app_time(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_SYNC_PDO:
-            ret = ec_ioctl_slave_sync_pdo(master, arg);
+        case EC_IOCTL_SYNC_REF:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sync_ref(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_SYNC_PDO_ENTRY:
-            ret = ec_ioctl_slave_sync_pdo_entry(master, arg);
+        case EC_IOCTL_SYNC_REF_TO:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sync_ref_to(master, arg, ctx);
             break;
-        case EC_IOCTL_DOMAIN:
-            ret = ec_ioctl_domain(master, arg);
+        case EC_IOCTL_SYNC_SLAVES:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sync_slaves(master, arg, ctx);
             break;
-        case EC_IOCTL_DOMAIN_FMMU:
-            ret = ec_ioctl_domain_fmmu(master, arg);
+        case EC_IOCTL_REF_CLOCK_TIME:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_ref_clock_time(master, arg, ctx);
             break;
-        case EC_IOCTL_DOMAIN_DATA:
-            ret = ec_ioctl_domain_data(master, arg);
+        case EC_IOCTL_REF_CLOCK_TIME64:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_ref_clock_time64(master, arg, ctx);
             break;
-        case EC_IOCTL_MASTER_DEBUG:
+        case EC_IOCTL_DC_SERVO:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_master_debug(master, arg);
+            ret = ec_ioctl_dc_servo(master, arg, ctx);
             break;
-        case EC_IOCTL_MASTER_RESCAN:
+        case EC_IOCTL_NEXT_SEND_TIME:
+            ret = ec_ioctl_next_send_time(master, arg, ctx);
+            break;
+        case EC_IOCTL_DC_STATS:
+            ret = ec_ioctl_dc_stats(master, arg);
+            break;
+        case EC_IOCTL_DC_STATS_RESET:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_master_rescan(master, arg);
+            ret = ec_ioctl_dc_stats_reset(master);
             break;
-        case EC_IOCTL_SLAVE_STATE:
+        case EC_IOCTL_SYNC0_CALIBRATE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_slave_state(master, arg);
+            ret = ec_ioctl_sync0_calibrate(master, arg);
             break;
-        case EC_IOCTL_SLAVE_SDO:
-            ret = ec_ioctl_slave_sdo(master, arg);
+        case EC_IOCTL_SYNC0_SHIFT_CORRECTION:
+            ret = ec_ioctl_sync0_shift_correction(master, arg);
             break;
-        case EC_IOCTL_SLAVE_SDO_ENTRY:
-            ret = ec_ioctl_slave_sdo_entry(master, arg);
+        case EC_IOCTL_LATENCY_STATS:
+            ret = ec_ioctl_latency_stats(master, arg);
             break;
-        case EC_IOCTL_SLAVE_SDO_UPLOAD:
-            ret = ec_ioctl_slave_sdo_upload(master, arg);
+        case EC_IOCTL_DOMAIN_LATENCY_STATS:
+            ret = ec_ioctl_domain_latency_stats(master, arg);
             break;
-        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+        case EC_IOCTL_LATENCY_STATS_RESET:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_slave_sdo_download(master, arg);
+            ret = ec_ioctl_latency_stats_reset(master);
             break;
-        case EC_IOCTL_SLAVE_SII_READ:
-            ret = ec_ioctl_slave_sii_read(master, arg);
+        case EC_IOCTL_STARTUP_PROFILE:
+            ret = ec_ioctl_startup_profile(master, arg);
+            break;
+        case EC_IOCTL_STARTUP_PROFILE_RESET:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_startup_profile_reset(master);
+            break;
+        case EC_IOCTL_CAPTURE_START:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_capture_start(master, arg);
+            break;
+        case EC_IOCTL_CAPTURE_STOP:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_capture_stop(master);
+            break;
+        case EC_IOCTL_CAPTURE_STATE:
+            ret = ec_ioctl_capture_state(master, arg);
+            break;
+        case EC_IOCTL_CAPTURE_READ:
+            ret = ec_ioctl_capture_read(master, arg);
+            break;
+        case EC_IOCTL_DATAGRAM_STATS:
+            ret = ec_ioctl_datagram_stats(master, arg);
+            break;
+        case EC_IOCTL_SLAVE_SNAPSHOT:
+            ret = ec_ioctl_slave_snapshot(master, arg);
+            break;
+        case EC_IOCTL_MONITOR:
+            ret = ec_ioctl_monitor(master, arg);
+            break;
+        case EC_IOCTL_SYNC_MON_QUEUE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sync_mon_queue(master, arg, ctx);
+            break;
+        case EC_IOCTL_SYNC_MON_PROCESS:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sync_mon_process(master, arg, ctx);
+            break;
+        case EC_IOCTL_RESET:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_reset(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_SYNC:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_sync(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_WATCHDOG:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_watchdog(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_ADD_PDO:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_add_pdo(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_CLEAR_PDOS:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_clear_pdos(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_ADD_ENTRY:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_add_entry(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_CLEAR_ENTRIES:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_clear_entries(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_REG_PDO_ENTRY:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_reg_pdo_entry(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_REG_PDO_POS:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_reg_pdo_pos(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_REG_PDO_ARRAY:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_reg_pdo_array(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_DC_LATCH:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+        case EC_IOCTL_SC_REG_FMMU:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_dc_latch(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_DC:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_dc(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_SDO:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_sdo(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_EMERG_SIZE:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_emerg_size(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_EMERG_POP:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_emerg_pop(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_EMERG_CLEAR:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_sc_emerg_clear(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_EMERG_OVERRUNS:
+            ret = ec_ioctl_sc_emerg_overruns(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_SII_WRITE:
+        case EC_IOCTL_SC_SDO_REQUEST:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_slave_sii_write(master, arg);
-            break;
-        case EC_IOCTL_SLAVE_REG_READ:
-            ret = ec_ioctl_slave_reg_read(master, arg);
+            ret = ec_ioctl_sc_create_sdo_request(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_REG_WRITE:
+        case EC_IOCTL_SC_REG_REQUEST:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_slave_reg_write(master, arg);
-            break;
-        case EC_IOCTL_SLAVE_FOE_READ:
-            ret = ec_ioctl_slave_foe_read(master, arg);
+            ret = ec_ioctl_sc_create_reg_request(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_FOE_WRITE:
+        case EC_IOCTL_SC_VOE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_slave_foe_write(master, arg);
+            ret = ec_ioctl_sc_create_voe_handler(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_SOE_READ:
-            ret = ec_ioctl_slave_soe_read(master, arg);
+        case EC_IOCTL_SC_STATE:
+            ret = ec_ioctl_sc_state(master, arg, ctx);
             break;
-        case EC_IOCTL_SLAVE_SOE_WRITE:
+        case EC_IOCTL_SC_STATES:
+            ret = ec_ioctl_sc_states(master, arg, ctx);
+            break;
+        case EC_IOCTL_SC_IDN:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_slave_soe_write(master, arg);
-            break;
-        case EC_IOCTL_CONFIG:
-            ret = ec_ioctl_config(master, arg);
-            break;
-        case EC_IOCTL_CONFIG_PDO:
-            ret = ec_ioctl_config_pdo(master, arg);
-            break;
-        case EC_IOCTL_CONFIG_PDO_ENTRY:
-            ret = ec_ioctl_config_pdo_entry(master, arg);
-            break;
-        case EC_IOCTL_CONFIG_SDO:
-            ret = ec_ioctl_config_sdo(master, arg);
+            ret = ec_ioctl_sc_idn(master, arg, ctx);
             break;
-        case EC_IOCTL_CONFIG_IDN:
-            ret = ec_ioctl_config_idn(master, arg);
+        case EC_IOCTL_DOMAIN_SIZE:
+            ret = ec_ioctl_domain_size(master, arg, ctx);
             break;
-#ifdef EC_EOE
-        case EC_IOCTL_EOE_HANDLER:
-            ret = ec_ioctl_eoe_handler(master, arg);
+        case EC_IOCTL_DOMAIN_OFFSET:
+            ret = ec_ioctl_domain_offset(master, arg, ctx);
             break;
-#endif
-        case EC_IOCTL_REQUEST:
+        case EC_IOCTL_DOMAIN_PROCESS:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_request(master, arg, ctx);
+            ret = ec_ioctl_domain_process(master, arg, ctx);
             break;
-        case EC_IOCTL_CREATE_DOMAIN:
+        case EC_IOCTL_DOMAIN_QUEUE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_create_domain(master, arg, ctx);
+            ret = ec_ioctl_domain_queue(master, arg, ctx);
             break;
-        case EC_IOCTL_CREATE_SLAVE_CONFIG:
+        case EC_IOCTL_DOMAIN_QUEUE_OUTPUTS:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_create_slave_config(master, arg, ctx);
+            ret = ec_ioctl_domain_queue_outputs(master, arg, ctx);
             break;
-        case EC_IOCTL_SELECT_REF_CLOCK:
+        case EC_IOCTL_DOMAIN_QUEUE_INPUTS:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_select_ref_clock(master, arg, ctx);
+            ret = ec_ioctl_domain_queue_inputs(master, arg, ctx);
             break;
-        case EC_IOCTL_ACTIVATE:
+        case EC_IOCTL_DOMAIN_STATE:
+            ret = ec_ioctl_domain_state(master, arg, ctx);
+            break;
+        case EC_IOCTL_DOMAIN_REDUNDANCY:
+            ret = ec_ioctl_domain_redundancy(master, arg, ctx);
+            break;
+        case EC_IOCTL_DOMAIN_HISTORY:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_activate(master, arg, ctx);
+            ret = ec_ioctl_domain_history(master, arg, ctx);
             break;
-        case EC_IOCTL_DEACTIVATE:
+        case EC_IOCTL_DOMAIN_HISTORY_STATE:
+            ret = ec_ioctl_domain_history_state(master, arg, ctx);
+            break;
+        case EC_IOCTL_DOMAIN_HISTORY_FREEZE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_deactivate(master, arg, ctx);
+            ret = ec_ioctl_domain_history_freeze(master, arg);
             break;
-        case EC_IOCTL_SEND:
+        case EC_IOCTL_DOMAIN_HISTORY_READ:
+            ret = ec_ioctl_domain_history_read(master, arg);
+            break;
+        case EC_IOCTL_DOMAIN_TIMEOUT:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_send(master, arg, ctx);
+            ret = ec_ioctl_domain_timeout(master, arg, ctx);
             break;
-        case EC_IOCTL_RECEIVE:
+        case EC_IOCTL_DOMAIN_OVERLAP:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_receive(master, arg, ctx);
+            ret = ec_ioctl_domain_overlap(master, arg, ctx);
             break;
-        case EC_IOCTL_MASTER_STATE:
-            ret = ec_ioctl_master_state(master, arg, ctx);
-            break;
-        case EC_IOCTL_MASTER_LINK_STATE:
-            ret = ec_ioctl_master_link_state(master, arg, ctx);
+        case EC_IOCTL_DOMAIN_DOUBLE_BUFFER:
+            if (!ctx->writable) {
+                ret = -EPERM;
+                break;
+            }
+            ret = ec_ioctl_domain_double_buffer(master, arg, ctx);
             break;
-        case EC_IOCTL_APP_TIME:
+        case EC_IOCTL_DOMAIN_SPLIT_IO:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_app_time(master, arg, ctx);
+            ret = ec_ioctl_domain_split_io(master, arg, ctx);
             break;
-        case EC_IOCTL_SYNC_REF:
+        case EC_IOCTL_DOMAIN_PIPELINE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sync_ref(master, arg, ctx);
+            ret = ec_ioctl_domain_pipeline(master, arg, ctx);
             break;
-        case EC_IOCTL_SYNC_REF_TO:
+        case EC_IOCTL_DOMAIN_DIVISOR:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sync_ref_to(master, arg, ctx);
+            ret = ec_ioctl_domain_divisor(master, arg, ctx);
             break;
-        case EC_IOCTL_SYNC_SLAVES:
+        case EC_IOCTL_DOMAIN_SEGMENT:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sync_slaves(master, arg, ctx);
+            ret = ec_ioctl_domain_segment(master, arg, ctx);
             break;
-        case EC_IOCTL_REF_CLOCK_TIME:
+        case EC_IOCTL_DOMAIN_ALIGNMENT:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_ref_clock_time(master, arg, ctx);
+            ret = ec_ioctl_domain_alignment(master, arg, ctx);
             break;
-        case EC_IOCTL_SYNC_MON_QUEUE:
+        case EC_IOCTL_DOMAIN_ROUTE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sync_mon_queue(master, arg, ctx);
+            ret = ec_ioctl_domain_route(master, arg, ctx);
             break;
-        case EC_IOCTL_SYNC_MON_PROCESS:
+        case EC_IOCTL_CONFIG_BATCH:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sync_mon_process(master, arg, ctx);
+            ret = ec_ioctl_config_batch(master, arg, ctx);
             break;
-        case EC_IOCTL_RESET:
+        case EC_IOCTL_SDO_REQUEST_BATCH:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_reset(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_batch(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_SYNC:
+        case EC_IOCTL_DOMAIN_CHANGED_INPUTS:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_sync(master, arg, ctx);
+            ret = ec_ioctl_domain_changed_inputs(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_WATCHDOG:
+        case EC_IOCTL_SDO_REQUEST_INDEX:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_watchdog(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_index(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_ADD_PDO:
+        case EC_IOCTL_SDO_REQUEST_TIMEOUT:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_add_pdo(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_timeout(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_CLEAR_PDOS:
+        case EC_IOCTL_SDO_REQUEST_STATE:
+            ret = ec_ioctl_sdo_request_state(master, arg, ctx);
+            break;
+        case EC_IOCTL_SDO_REQUEST_READ:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_clear_pdos(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_read(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_ADD_ENTRY:
+        case EC_IOCTL_SDO_REQUEST_WRITE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_add_entry(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_write(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_CLEAR_ENTRIES:
+        case EC_IOCTL_SDO_REQUEST_DATA:
+            ret = ec_ioctl_sdo_request_data(master, arg, ctx);
+            break;
+        case EC_IOCTL_SDO_REQUEST_MEMORY:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_clear_entries(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_memory(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_REG_PDO_ENTRY:
+        case EC_IOCTL_REG_REQUEST_DATA:
+            ret = ec_ioctl_reg_request_data(master, arg, ctx);
+            break;
+        case EC_IOCTL_REG_REQUEST_STATE:
+            ret = ec_ioctl_reg_request_state(master, arg, ctx);
+            break;
+        case EC_IOCTL_REG_REQUEST_WRITE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_reg_pdo_entry(master, arg, ctx);
+            ret = ec_ioctl_reg_request_write(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_REG_PDO_POS:
+        case EC_IOCTL_REG_REQUEST_READ:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_reg_pdo_pos(master, arg, ctx);
+            ret = ec_ioctl_reg_request_read(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_DC:
+        case EC_IOCTL_VOE_SEND_HEADER:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_dc(master, arg, ctx);
+            ret = ec_ioctl_voe_send_header(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_SDO:
+        case EC_IOCTL_VOE_REC_HEADER:
+            ret = ec_ioctl_voe_rec_header(master, arg, ctx);
+            break;
+        case EC_IOCTL_VOE_READ:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_sdo(master, arg, ctx);
+            ret = ec_ioctl_voe_read(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_EMERG_SIZE:
+        case EC_IOCTL_VOE_READ_NOSYNC:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_emerg_size(master, arg, ctx);
+            ret = ec_ioctl_voe_read_nosync(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_EMERG_POP:
+        case EC_IOCTL_VOE_WRITE:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_emerg_pop(master, arg, ctx);
+            ret = ec_ioctl_voe_write(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_EMERG_CLEAR:
+        case EC_IOCTL_VOE_EXEC:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_emerg_clear(master, arg, ctx);
+            ret = ec_ioctl_voe_exec(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_EMERG_OVERRUNS:
-            ret = ec_ioctl_sc_emerg_overruns(master, arg, ctx);
+        case EC_IOCTL_VOE_DATA:
+            ret = ec_ioctl_voe_data(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_SDO_REQUEST:
+        case EC_IOCTL_VOE_OFFSET:
+            ret = ec_ioctl_voe_offset(master, arg, ctx);
+            break;
+#ifndef EC_IOCTL_RTDM
+        case EC_IOCTL_SDO_REQUEST_EVENTFD:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_create_sdo_request(master, arg, ctx);
+            ret = ec_ioctl_sdo_request_eventfd(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_REG_REQUEST:
+        case EC_IOCTL_REG_REQUEST_EVENTFD:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_create_reg_request(master, arg, ctx);
+            ret = ec_ioctl_reg_request_eventfd(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_VOE:
+        case EC_IOCTL_VOE_EVENTFD:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_create_voe_handler(master, arg, ctx);
+            ret = ec_ioctl_voe_eventfd(master, arg, ctx);
             break;
-        case EC_IOCTL_SC_STATE:
-            ret = ec_ioctl_sc_state(master, arg, ctx);
-            break;
-        case EC_IOCTL_SC_IDN:
+        case EC_IOCTL_EMERG_EVENTFD:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_sc_idn(master, arg, ctx);
-            break;
-        case EC_IOCTL_DOMAIN_SIZE:
-            ret = ec_ioctl_domain_size(master, arg, ctx);
+            ret = ec_ioctl_emerg_eventfd(master, arg, ctx);
             break;
-        case EC_IOCTL_DOMAIN_OFFSET:
-            ret = ec_ioctl_domain_offset(master, arg, ctx);
-            break;
-        case EC_IOCTL_DOMAIN_PROCESS:
+#endif
+        case EC_IOCTL_SET_SEND_INTERVAL:
             if (!ctx->writable) {
                 ret = -EPERM;
                 break;
             }
-            ret = ec_ioctl_domain_process(master, arg, ctx);
+            ret = ec_ioctl_set_send_interval(master, arg, ctx);
+            break;
+        default:
+            ret = -ENOTTY;
+            break;
+    }
+
+#if DEBUG_LATENCY
+    b = get_cycles();
+    t = (unsigned int) ((b - a) * 1000LL) / cpu_khz;
+    if (t > 50) {
+        EC_MASTER_WARN(master, "ioctl(0x%02x) took %u us.\n",
+                _IOC_NR(cmd), t);
+    }
+#endif
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+#ifndef EC_IOCTL_RTDM
+
+/** Called when a file handle is polled.
+ *
+ * While the domain selected with EC_IOCTL_DOMAIN_NOTIFY is in flight, the
+ * devices are polled in the context of the caller. Between the attempts, the
+ * caller sleeps for the poll interval. The file handle becomes readable, as
+ * soon as all datagrams of the domain were received or timed out, until the
+ * domain is processed.
+ *
+ * \return Poll mask.
+ */
+unsigned int ec_ioctl_poll(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx, /**< Device context. */
+        struct file *filp, /**< File handle. */
+        poll_table *wait /**< Poll table. */
+        )
+{
+    if (!ctx->notify_domain) {
+        return POLLERR;
+    }
+
+    poll_wait(filp, &ctx->poll_queue, wait);
+
+    if (ec_domain_in_flight(ctx->notify_domain)) {
+        down(&master->io_sem);
+        ecrt_master_receive(master);
+        up(&master->io_sem);
+        ec_ioctl_publish_states(master, ctx);
+
+        if (ec_domain_in_flight(ctx->notify_domain)) {
+            hrtimer_start(&ctx->poll_timer, ctx->poll_interval,
+                    HRTIMER_MODE_REL);
+            return 0;
+        }
+    }
+
+    return ctx->notify_processed ? 0 : POLLIN | POLLRDNORM;
+}
+
+#endif
+
+/*****************************************************************************/
+
+#if defined(EC_HAVE_URING_CMD) && !defined(EC_IOCTL_RTDM)
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 7, 0)
+#include <linux/io_uring/cmd.h>
+#else
+#include <linux/io_uring.h>
+#endif
+
+/* The task work callbacks get a token instead of the issue flags from 6.15
+ * on. */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 15, 0)
+#define EC_URING_TW_ARG io_tw_token_t tw
+#define EC_URING_TW_FLAGS IO_URING_F_UNLOCKED
+#else
+#define EC_URING_TW_ARG unsigned int issue_flags
+#define EC_URING_TW_FLAGS issue_flags
+#endif
+
+/** Acyclic request submitted via io_uring.
+ */
+struct ec_ioctl_uring_req {
+    struct io_uring_cmd *cmd; /**< io_uring command. */
+    ec_master_t *master; /**< EtherCAT master. */
+    unsigned int op; /**< ioctl request number. */
+    void __user *arg; /**< Userspace address of the ioctl argument. */
+    union {
+        ec_ioctl_slave_sdo_upload_t sdo_upload;
+        ec_ioctl_slave_sdo_download_t sdo_download;
+        ec_ioctl_slave_reg_t reg;
+        ec_ioctl_slave_foe_t foe;
+    } io; /**< Copy of the ioctl argument. */
+    union {
+        ec_sdo_request_t sdo;
+        ec_reg_request_t reg;
+        ec_foe_request_t foe;
+    } req; /**< Request processed by the slave state machine. */
+};
+
+/*****************************************************************************/
+
+/** Returns the io_uring request of a command.
+ */
+static inline struct ec_ioctl_uring_req **ec_ioctl_uring_pdu(
+        struct io_uring_cmd *cmd /**< io_uring command. */
+        )
+{
+    return (struct ec_ioctl_uring_req **) cmd->pdu;
+}
+
+/*****************************************************************************/
+
+/** Clears the request of an io_uring request.
+ */
+static void ec_ioctl_uring_clear(
+        struct ec_ioctl_uring_req *ur /**< io_uring request. */
+        )
+{
+    switch (ur->op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            ec_sdo_request_clear(&ur->req.sdo);
             break;
-        case EC_IOCTL_DOMAIN_QUEUE:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
-            }
-            ret = ec_ioctl_domain_queue(master, arg, ctx);
+        case EC_IOCTL_SLAVE_REG_READ:
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            ec_reg_request_clear(&ur->req.reg);
             break;
-        case EC_IOCTL_DOMAIN_STATE:
-            ret = ec_ioctl_domain_state(master, arg, ctx);
+        default:
+            ec_foe_request_clear(&ur->req.foe);
             break;
-        case EC_IOCTL_SDO_REQUEST_INDEX:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+    }
+}
+
+/*****************************************************************************/
+
+/** Copies the results of an io_uring request to userspace.
+ *
+ * \return Result of the request like the one of the equivalent ioctl().
+ */
+static int ec_ioctl_uring_results(
+        struct ec_ioctl_uring_req *ur /**< io_uring request. */
+        )
+{
+    size_t size = sizeof(ur->io.reg);
+    int ret = 0;
+
+    switch (ur->op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+            size = sizeof(ur->io.sdo_upload);
+            ur->io.sdo_upload.abort_code = ur->req.sdo.abort_code;
+            ur->io.sdo_upload.data_size = 0;
+            if (ur->req.sdo.state != EC_INT_REQUEST_SUCCESS) {
+                ret = ur->req.sdo.errno ? -ur->req.sdo.errno : -EIO;
+            } else if (ur->req.sdo.data_size > ur->io.sdo_upload.target_size) {
+                ret = -EOVERFLOW;
+            } else if (copy_to_user(
+                        (void __user *) ur->io.sdo_upload.target,
+                        ur->req.sdo.data, ur->req.sdo.data_size)) {
+                return -EFAULT;
+            } else {
+                ur->io.sdo_upload.data_size = ur->req.sdo.data_size;
             }
-            ret = ec_ioctl_sdo_request_index(master, arg, ctx);
             break;
-        case EC_IOCTL_SDO_REQUEST_TIMEOUT:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            size = sizeof(ur->io.sdo_download);
+            ur->io.sdo_download.abort_code = ur->req.sdo.abort_code;
+            if (ur->req.sdo.state != EC_INT_REQUEST_SUCCESS) {
+                ret = ur->req.sdo.errno ? -ur->req.sdo.errno : -EIO;
             }
-            ret = ec_ioctl_sdo_request_timeout(master, arg, ctx);
             break;
-        case EC_IOCTL_SDO_REQUEST_STATE:
-            ret = ec_ioctl_sdo_request_state(master, arg, ctx);
-            break;
-        case EC_IOCTL_SDO_REQUEST_READ:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+
+        case EC_IOCTL_SLAVE_REG_READ:
+            if (ur->req.reg.state != EC_INT_REQUEST_SUCCESS) {
+                return -EIO;
+            }
+            if (copy_to_user((void __user *) ur->io.reg.data,
+                        ur->req.reg.data, ur->io.reg.size)) {
+                return -EFAULT;
+            }
+            return 0;
+
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            return ur->req.reg.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
+
+        case EC_IOCTL_SLAVE_FOE_READ:
+            size = sizeof(ur->io.foe);
+            ur->io.foe.result = ur->req.foe.result;
+            ur->io.foe.error_code = ur->req.foe.error_code;
+            ur->io.foe.data_size = 0;
+            if (ur->req.foe.state != EC_INT_REQUEST_SUCCESS) {
+                ret = -EIO;
+            } else if (ur->req.foe.data_size > ur->io.foe.buffer_size) {
+                return -EOVERFLOW;
+            } else if (copy_to_user((void __user *) ur->io.foe.buffer,
+                        ur->req.foe.buffer, ur->req.foe.data_size)) {
+                return -EFAULT;
+            } else {
+                ur->io.foe.data_size = ur->req.foe.data_size;
             }
-            ret = ec_ioctl_sdo_request_read(master, arg, ctx);
             break;
-        case EC_IOCTL_SDO_REQUEST_WRITE:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+
+        case EC_IOCTL_SLAVE_FOE_WRITE:
+            size = sizeof(ur->io.foe);
+            ur->io.foe.result = ur->req.foe.result;
+            ur->io.foe.error_code = ur->req.foe.error_code;
+            if (ur->req.foe.state != EC_INT_REQUEST_SUCCESS) {
+                ret = -EIO;
             }
-            ret = ec_ioctl_sdo_request_write(master, arg, ctx);
             break;
-        case EC_IOCTL_SDO_REQUEST_DATA:
-            ret = ec_ioctl_sdo_request_data(master, arg, ctx);
+    }
+
+    if (copy_to_user(ur->arg, &ur->io, size)) {
+        ret = -EFAULT;
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Completes an io_uring request in the context of the submitting task.
+ *
+ * The slave state machine may still run the notification, that scheduled
+ * this, so the master semaphore is taken once before the request is freed.
+ */
+static void ec_ioctl_uring_finish(
+        struct io_uring_cmd *cmd, /**< io_uring command. */
+        EC_URING_TW_ARG /**< Task work argument. */
+        )
+{
+    struct ec_ioctl_uring_req *ur = *ec_ioctl_uring_pdu(cmd);
+    int ret;
+
+    down(&ur->master->master_sem);
+    up(&ur->master->master_sem);
+
+    ret = ec_ioctl_uring_results(ur);
+    ec_ioctl_uring_clear(ur);
+    kfree(ur);
+
+    io_uring_cmd_done(cmd, ret, 0, EC_URING_TW_FLAGS);
+}
+
+/*****************************************************************************/
+
+/** Completion callback of the SDO requests.
+ */
+static void ec_ioctl_uring_sdo_complete(
+        ec_sdo_request_t *req, /**< SDO request. */
+        void *data /**< io_uring request. */
+        )
+{
+    struct ec_ioctl_uring_req *ur = data;
+
+    io_uring_cmd_complete_in_task(ur->cmd, ec_ioctl_uring_finish);
+}
+
+/*****************************************************************************/
+
+/** Completion callback of the register requests.
+ */
+static void ec_ioctl_uring_reg_complete(
+        ec_reg_request_t *req, /**< Register request. */
+        void *data /**< io_uring request. */
+        )
+{
+    struct ec_ioctl_uring_req *ur = data;
+
+    io_uring_cmd_complete_in_task(ur->cmd, ec_ioctl_uring_finish);
+}
+
+/*****************************************************************************/
+
+/** Completion callback of the FoE requests.
+ */
+static void ec_ioctl_uring_foe_complete(
+        ec_foe_request_t *req, /**< FoE request. */
+        void *data /**< io_uring request. */
+        )
+{
+    struct ec_ioctl_uring_req *ur = data;
+
+    io_uring_cmd_complete_in_task(ur->cmd, ec_ioctl_uring_finish);
+}
+
+/*****************************************************************************/
+
+/** Prepares the request of an io_uring request from the ioctl argument.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_ioctl_uring_prepare(
+        struct ec_ioctl_uring_req *ur /**< io_uring request. */
+        )
+{
+    ec_ioctl_slave_sdo_upload_t *up = &ur->io.sdo_upload;
+    ec_ioctl_slave_sdo_download_t *down = &ur->io.sdo_download;
+    ec_ioctl_slave_foe_t *foe = &ur->io.foe;
+    size_t size;
+    int ret;
+
+    switch (ur->op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+            size = sizeof(*up);
             break;
-        case EC_IOCTL_REG_REQUEST_DATA:
-            ret = ec_ioctl_reg_request_data(master, arg, ctx);
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            size = sizeof(*down);
             break;
-        case EC_IOCTL_REG_REQUEST_STATE:
-            ret = ec_ioctl_reg_request_state(master, arg, ctx);
+        case EC_IOCTL_SLAVE_REG_READ:
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            size = sizeof(ur->io.reg);
             break;
-        case EC_IOCTL_REG_REQUEST_WRITE:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
-            }
-            ret = ec_ioctl_reg_request_write(master, arg, ctx);
+        default:
+            size = sizeof(*foe);
             break;
-        case EC_IOCTL_REG_REQUEST_READ:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+    }
+
+    if (copy_from_user(&ur->io, ur->arg, size)) {
+        return -EFAULT;
+    }
+
+    switch (ur->op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+            ec_sdo_request_init(&ur->req.sdo);
+            if (up->complete_access) {
+                ecrt_sdo_request_index_complete(&ur->req.sdo, up->sdo_index);
+            } else {
+                ecrt_sdo_request_index(&ur->req.sdo, up->sdo_index,
+                        up->sdo_entry_subindex);
             }
-            ret = ec_ioctl_reg_request_read(master, arg, ctx);
+            ecrt_sdo_request_read(&ur->req.sdo);
             break;
-        case EC_IOCTL_VOE_SEND_HEADER:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            ec_sdo_request_init(&ur->req.sdo);
+            ret = ec_sdo_request_alloc(&ur->req.sdo, down->data_size);
+            if (ret) {
+                return ret;
             }
-            ret = ec_ioctl_voe_send_header(master, arg, ctx);
-            break;
-        case EC_IOCTL_VOE_REC_HEADER:
-            ret = ec_ioctl_voe_rec_header(master, arg, ctx);
-            break;
-        case EC_IOCTL_VOE_READ:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+            if (copy_from_user(ur->req.sdo.data,
+                        (void __user *) down->data, down->data_size)) {
+                return -EFAULT;
             }
-            ret = ec_ioctl_voe_read(master, arg, ctx);
-            break;
-        case EC_IOCTL_VOE_READ_NOSYNC:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+            ur->req.sdo.data_size = down->data_size;
+            if (down->complete_access) {
+                ecrt_sdo_request_index_complete(&ur->req.sdo,
+                        down->sdo_index);
+            } else {
+                ecrt_sdo_request_index(&ur->req.sdo, down->sdo_index,
+                        down->sdo_entry_subindex);
             }
-            ret = ec_ioctl_voe_read_nosync(master, arg, ctx);
+            ecrt_sdo_request_write(&ur->req.sdo);
             break;
-        case EC_IOCTL_VOE_WRITE:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+
+        case EC_IOCTL_SLAVE_REG_READ:
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            if (!ur->io.reg.size || ur->io.reg.emergency) {
+                return -EINVAL;
+            }
+            ret = ec_reg_request_init(&ur->req.reg, ur->io.reg.size);
+            if (ret) {
+                return ret;
+            }
+            if (ur->op == EC_IOCTL_SLAVE_REG_READ) {
+                ecrt_reg_request_read(&ur->req.reg, ur->io.reg.address,
+                        ur->io.reg.size);
+            } else {
+                if (copy_from_user(ur->req.reg.data,
+                            (void __user *) ur->io.reg.data,
+                            ur->io.reg.size)) {
+                    return -EFAULT;
+                }
+                ecrt_reg_request_write(&ur->req.reg, ur->io.reg.address,
+                        ur->io.reg.size);
             }
-            ret = ec_ioctl_voe_write(master, arg, ctx);
             break;
-        case EC_IOCTL_VOE_EXEC:
-            if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+
+        default:
+            foe->file_name[sizeof(foe->file_name) - 1] = 0;
+            ec_foe_request_init(&ur->req.foe, foe->file_name);
+            if (ur->op == EC_IOCTL_SLAVE_FOE_READ) {
+                ret = ec_foe_request_alloc(&ur->req.foe, 10000); // FIXME
+                if (ret) {
+                    return ret;
+                }
+                ec_foe_request_read(&ur->req.foe);
+            } else {
+                ret = ec_foe_request_alloc(&ur->req.foe, foe->buffer_size);
+                if (ret) {
+                    return ret;
+                }
+                if (copy_from_user(ur->req.foe.buffer,
+                            (void __user *) foe->buffer, foe->buffer_size)) {
+                    return -EFAULT;
+                }
+                ur->req.foe.data_size = foe->buffer_size;
+                ec_foe_request_write(&ur->req.foe);
             }
-            ret = ec_ioctl_voe_exec(master, arg, ctx);
             break;
-        case EC_IOCTL_VOE_DATA:
-            ret = ec_ioctl_voe_data(master, arg, ctx);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Called when an io_uring command is issued.
+ *
+ * The request is queued for the slave state machine and the command returns
+ * at once. The slave state machine completes the command via the request's
+ * completion callback.
+ *
+ * \return -EIOCBQUEUED on success, otherwise a negative error code.
+ */
+int ec_ioctl_uring_cmd(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_ioctl_context_t *ctx, /**< Device context. */
+        struct io_uring_cmd *cmd, /**< io_uring command. */
+        unsigned int issue_flags /**< Issue flags. */
+        )
+{
+    struct ec_ioctl_uring_req *ur;
+    uint16_t position;
+    ec_slave_t *slave;
+    int ret;
+
+    switch (cmd->cmd_op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+        case EC_IOCTL_SLAVE_REG_READ:
+        case EC_IOCTL_SLAVE_FOE_READ:
             break;
-        case EC_IOCTL_SET_SEND_INTERVAL:
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+        case EC_IOCTL_SLAVE_REG_WRITE:
+        case EC_IOCTL_SLAVE_FOE_WRITE:
             if (!ctx->writable) {
-                ret = -EPERM;
-                break;
+                return -EPERM;
             }
-            ret = ec_ioctl_set_send_interval(master, arg, ctx);
             break;
         default:
-            ret = -ENOTTY;
+            return -ENOTTY;
+    }
+
+    /* Queueing needs the master semaphore and may fault in user memory, so
+     * let io_uring retry from a worker, that may sleep. */
+    if (issue_flags & IO_URING_F_NONBLOCK) {
+        return -EAGAIN;
+    }
+
+    if (!(ur = kzalloc(sizeof(*ur), GFP_KERNEL))) {
+        return -ENOMEM;
+    }
+
+    ur->cmd = cmd;
+    ur->master = master;
+    ur->op = cmd->cmd_op;
+    ur->arg = u64_to_user_ptr(
+            READ_ONCE(*(const u64 *) io_uring_sqe_cmd(cmd->sqe)));
+    *ec_ioctl_uring_pdu(cmd) = ur;
+
+    ret = ec_ioctl_uring_prepare(ur);
+    if (ret) {
+        goto out_clear;
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_clear;
+    }
+
+    switch (ur->op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+            position = ur->io.sdo_upload.slave_position;
+            break;
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            position = ur->io.sdo_download.slave_position;
+            break;
+        case EC_IOCTL_SLAVE_REG_READ:
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            position = ur->io.reg.slave_position;
+            break;
+        default:
+            position = ur->io.foe.slave_position;
             break;
     }
 
-#if DEBUG_LATENCY
-    b = get_cycles();
-    t = (unsigned int) ((b - a) * 1000LL) / cpu_khz;
-    if (t > 50) {
-        EC_MASTER_WARN(master, "ioctl(0x%02x) took %u us.\n",
-                _IOC_NR(cmd), t);
+    if (!(slave = ec_master_find_slave(master, 0, position))) {
+        up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n", position);
+        ret = -EINVAL;
+        goto out_clear;
     }
-#endif
 
+    switch (ur->op) {
+        case EC_IOCTL_SLAVE_SDO_UPLOAD:
+        case EC_IOCTL_SLAVE_SDO_DOWNLOAD:
+            ecrt_sdo_request_callback(&ur->req.sdo,
+                    ec_ioctl_uring_sdo_complete, ur);
+            list_add_tail(&ur->req.sdo.list, &slave->sdo_requests);
+            break;
+        case EC_IOCTL_SLAVE_REG_READ:
+        case EC_IOCTL_SLAVE_REG_WRITE:
+            ecrt_reg_request_callback(&ur->req.reg,
+                    ec_ioctl_uring_reg_complete, ur);
+            list_add_tail(&ur->req.reg.list, &slave->reg_requests);
+            break;
+        default:
+            ur->req.foe.complete_cb = ec_ioctl_uring_foe_complete;
+            ur->req.foe.cb_data = ur;
+            list_add_tail(&ur->req.foe.list, &slave->foe_requests);
+            break;
+    }
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+    return -EIOCBQUEUED;
+
+out_clear:
+    ec_ioctl_uring_clear(ur);
+    kfree(ur);
     return ret;
 }
 
+#endif
+
 /*****************************************************************************/
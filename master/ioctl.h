@@ -56,7 +56,7 @@
  *
  * Increment this when changing the ioctl interface!
  */
-#define EC_IOCTL_VERSION_MAGIC 30
+#define EC_IOCTL_VERSION_MAGIC 92
 
 // Command-line tool
 #define EC_IOCTL_MODULE                EC_IOR(0x00, ec_ioctl_module_t)
@@ -97,7 +97,7 @@
 #define EC_IOCTL_CREATE_DOMAIN          EC_IO(0x1f)
 #define EC_IOCTL_CREATE_SLAVE_CONFIG  EC_IOWR(0x20, ec_ioctl_config_t)
 #define EC_IOCTL_SELECT_REF_CLOCK      EC_IOW(0x21, uint32_t)
-#define EC_IOCTL_ACTIVATE              EC_IOR(0x22, ec_ioctl_master_activate_t)
+#define EC_IOCTL_ACTIVATE             EC_IOWR(0x22, ec_ioctl_master_activate_t)
 #define EC_IOCTL_DEACTIVATE             EC_IO(0x23)
 #define EC_IOCTL_SEND                   EC_IO(0x24)
 #define EC_IOCTL_RECEIVE                EC_IO(0x25)
@@ -153,6 +153,91 @@
 #define EC_IOCTL_VOE_EXEC             EC_IOWR(0x57, ec_ioctl_voe_t)
 #define EC_IOCTL_VOE_DATA             EC_IOWR(0x58, ec_ioctl_voe_t)
 #define EC_IOCTL_SET_SEND_INTERVAL     EC_IOW(0x59, size_t)
+#define EC_IOCTL_DOMAIN_TIMEOUT        EC_IOW(0x5a, ec_ioctl_domain_timeout_t)
+#define EC_IOCTL_CYCLE                 EC_IOW(0x5b, ec_ioctl_cycle_t)
+#define EC_IOCTL_DOMAIN_NOTIFY         EC_IOW(0x5c, ec_ioctl_domain_notify_t)
+#define EC_IOCTL_RECEIVE_WAIT          EC_IOW(0x5d, uint64_t)
+#define EC_IOCTL_TIMED_CYCLE           EC_IOW(0x5e, uint32_t)
+#define EC_IOCTL_TRAFFIC_CLASS         EC_IOW(0x5f, ec_ioctl_traffic_class_t)
+#define EC_IOCTL_DOMAIN_OVERLAP          EC_IO(0x60)
+#define EC_IOCTL_DOMAIN_CHANGED_INPUTS \
+    EC_IOW(0x61, ec_ioctl_domain_changed_inputs_t)
+#define EC_IOCTL_DOMAIN_DOUBLE_BUFFER    EC_IO(0x62)
+#define EC_IOCTL_DOMAIN_PIPELINE       EC_IOW(0x63, ec_ioctl_domain_pipeline_t)
+#define EC_IOCTL_DOMAIN_DIVISOR         EC_IOW(0x64, ec_ioctl_domain_divisor_t)
+#define EC_IOCTL_DOMAIN_ALIGNMENT     EC_IOW(0x65, ec_ioctl_domain_alignment_t)
+#define EC_IOCTL_DOMAIN_ROUTE           EC_IOW(0x66, ec_ioctl_domain_route_t)
+#define EC_IOCTL_CONFIG_BATCH         EC_IOWR(0x67, ec_ioctl_config_batch_t)
+#define EC_IOCTL_SDO_REQUEST_BATCH \
+    EC_IOW(0x68, ec_ioctl_sdo_request_batch_t)
+#define EC_IOCTL_SDO_REQUEST_EVENTFD \
+    EC_IOW(0x69, ec_ioctl_request_eventfd_t)
+#define EC_IOCTL_REG_REQUEST_EVENTFD \
+    EC_IOW(0x6a, ec_ioctl_request_eventfd_t)
+#define EC_IOCTL_VOE_EVENTFD \
+    EC_IOW(0x6b, ec_ioctl_request_eventfd_t)
+#define EC_IOCTL_DICT_IMPORT           EC_IOW(0x6c, ec_ioctl_dict_import_t)
+#define EC_IOCTL_SDO_REQUEST_MEMORY    EC_IOW(0x6d, ec_ioctl_sdo_request_t)
+#define EC_IOCTL_FOE_JOB_START          EC_IOW(0x6e, ec_ioctl_foe_job_t)
+#define EC_IOCTL_FOE_JOB_STATUS       EC_IOWR(0x6f, ec_ioctl_foe_job_t)
+#define EC_IOCTL_VOE_OFFSET           EC_IOWR(0x70, ec_ioctl_voe_t)
+#define EC_IOCTL_SLAVE_SOE_READ_IDNS \
+    EC_IOWR(0x71, ec_ioctl_slave_soe_idns_t)
+#define EC_IOCTL_SLAVE_SOE_WRITE_IDNS \
+    EC_IOWR(0x72, ec_ioctl_slave_soe_idns_t)
+#define EC_IOCTL_SLAVE_REG_READ_BATCH \
+    EC_IOW(0x73, ec_ioctl_slave_reg_batch_t)
+#define EC_IOCTL_SLAVE_REG_WRITE_BATCH \
+    EC_IOW(0x74, ec_ioctl_slave_reg_batch_t)
+#define EC_IOCTL_DC_SERVO              EC_IOR(0x75, ec_ioctl_dc_servo_t)
+#define EC_IOCTL_DC_STATS              EC_IOR(0x76, ec_ioctl_dc_stats_t)
+#define EC_IOCTL_DC_STATS_RESET         EC_IO(0x77)
+#define EC_IOCTL_SELECT_DC_DOMAIN      EC_IOW(0x78, uint32_t)
+#define EC_IOCTL_NEXT_SEND_TIME       EC_IOWR(0x79, ec_ioctl_next_send_time_t)
+#define EC_IOCTL_REF_CLOCK_TIME64      EC_IOR(0x7a, uint64_t)
+#define EC_IOCTL_SC_DC_LATCH           EC_IOW(0x7b, ec_ioctl_sc_dc_latch_t)
+#define EC_IOCTL_DOMAIN_SEGMENT       EC_IOW(0x7c, ec_ioctl_domain_segment_t)
+#define EC_IOCTL_LATENCY_STATS         EC_IOR(0x7d, ec_ioctl_latency_stats_t)
+#define EC_IOCTL_DOMAIN_LATENCY_STATS \
+    EC_IOWR(0x7e, ec_ioctl_domain_latency_stats_t)
+#define EC_IOCTL_LATENCY_STATS_RESET    EC_IO(0x7f)
+#define EC_IOCTL_CAPTURE_START         EC_IOW(0x80, ec_ioctl_capture_start_t)
+#define EC_IOCTL_CAPTURE_STOP           EC_IO(0x81)
+#define EC_IOCTL_CAPTURE_STATE       EC_IOWR(0x82, ec_ioctl_capture_state_t)
+#define EC_IOCTL_CAPTURE_READ        EC_IOWR(0x83, ec_ioctl_capture_read_t)
+#define EC_IOCTL_DATAGRAM_STATS     EC_IOWR(0x84, ec_ioctl_datagram_stats_t)
+#define EC_IOCTL_SLAVE_SNAPSHOT     EC_IOWR(0x85, ec_ioctl_slave_snapshot_t)
+#define EC_IOCTL_FOE_STREAM_START       EC_IOW(0x86, ec_ioctl_foe_stream_t)
+#define EC_IOCTL_FOE_STREAM_TRANSFER  EC_IOWR(0x87, ec_ioctl_foe_stream_t)
+#define EC_IOCTL_SLAVE_SII_READ_BATCH \
+    EC_IOWR(0x88, ec_ioctl_slave_sii_batch_t)
+#define EC_IOCTL_SLAVE_SII_WRITE_BATCH \
+    EC_IOWR(0x89, ec_ioctl_slave_sii_batch_t)
+#define EC_IOCTL_MONITOR                EC_IOWR(0x8a, ec_ioctl_monitor_t)
+#define EC_IOCTL_SC_REG_PDO_ARRAY  EC_IOWR(0x8b, ec_ioctl_reg_pdo_array_t)
+#define EC_IOCTL_SC_STATES            EC_IOWR(0x8c, ec_ioctl_sc_states_t)
+#define EC_IOCTL_CYCLE_SHARED           EC_IO(0x8d)
+#define EC_IOCTL_MAP_READ_ONLY    EC_IOR(0x8e, ec_ioctl_map_read_only_t)
+#define EC_IOCTL_REQUEST_SHARED         EC_IO(0x8f)
+#define EC_IOCTL_EMERG_EVENTFD         EC_IOW(0x90, int32_t)
+#define EC_IOCTL_DOMAIN_REDUNDANCY    EC_IOWR(0x91, ec_ioctl_domain_redundancy_t)
+#define EC_IOCTL_STARTUP_PROFILE     EC_IOWR(0x92, ec_ioctl_startup_profile_t)
+#define EC_IOCTL_STARTUP_PROFILE_RESET  EC_IO(0x93)
+#define EC_IOCTL_SEND_AT               EC_IOW(0x94, uint64_t)
+#define EC_IOCTL_DOMAIN_SPLIT_IO          EC_IO(0x95)
+#define EC_IOCTL_DOMAIN_QUEUE_OUTPUTS     EC_IO(0x96)
+#define EC_IOCTL_DOMAIN_QUEUE_INPUTS      EC_IO(0x97)
+#define EC_IOCTL_SYNC0_CALIBRATE       EC_IOW(0x98, uint32_t)
+#define EC_IOCTL_SYNC0_SHIFT_CORRECTION \
+    EC_IOWR(0x99, ec_ioctl_sync0_shift_correction_t)
+#define EC_IOCTL_SC_REG_FMMU          EC_IOW(0x9a, ec_ioctl_sc_reg_fmmu_t)
+#define EC_IOCTL_DOMAIN_HISTORY      EC_IOW(0x9b, ec_ioctl_domain_history_t)
+#define EC_IOCTL_DOMAIN_HISTORY_STATE \
+    EC_IOWR(0x9c, ec_ioctl_domain_history_state_t)
+#define EC_IOCTL_DOMAIN_HISTORY_FREEZE \
+    EC_IOW(0x9d, ec_ioctl_domain_history_freeze_t)
+#define EC_IOCTL_DOMAIN_HISTORY_READ \
+    EC_IOWR(0x9e, ec_ioctl_domain_history_read_t)
 
 /*****************************************************************************/
 
@@ -186,6 +271,8 @@ typedef struct {
         uint64_t tx_bytes;
         uint64_t rx_bytes;
         uint64_t tx_errors;
+        uint32_t round_trip_time;
+        uint32_t max_round_trip_time;
         int32_t tx_frame_rates[EC_RATE_COUNT];
         int32_t rx_frame_rates[EC_RATE_COUNT];
         int32_t tx_byte_rates[EC_RATE_COUNT];
@@ -204,6 +291,16 @@ typedef struct {
     uint64_t app_time;
     uint64_t dc_ref_time;
     uint16_t ref_clock;
+    struct ec_ioctl_traffic_class_info {
+        uint32_t priority;
+        uint32_t budget;
+        uint64_t datagrams;
+        uint64_t bytes;
+        uint64_t deferred;
+        uint64_t held;
+    } traffic_classes[EC_TC_COUNT];
+    uint32_t eoe_share;
+    uint32_t bus_delay;
 } ec_ioctl_master_t;
 
 /*****************************************************************************/
@@ -238,12 +335,26 @@ typedef struct {
         uint32_t receive_time;
         uint16_t next_slave;
         uint32_t delay_to_next_dc;
+        uint8_t invalid_frames;
+        uint8_t rx_errors;
+        uint8_t forwarded_rx_errors;
+        uint8_t lost_links;
+        uint32_t error_total;
+        uint32_t error_delta;
     } ports[EC_MAX_PORTS];
+    uint32_t error_samples;
+    uint32_t error_interval;
+    uint8_t processing_unit_errors;
+    uint8_t pdi_errors;
     uint8_t fmmu_bit;
     uint8_t dc_supported;
     ec_slave_dc_range_t dc_range;
     uint8_t has_dc_system_time;
     uint32_t transmission_delay;
+    uint32_t dc_diff_samples;
+    int32_t dc_diff;
+    uint32_t dc_diff_max;
+    int32_t dc_drift;
     uint8_t al_state;
     uint8_t error_flag;
     uint8_t sync_count;
@@ -312,6 +423,11 @@ typedef struct {
     uint16_t working_counter[EC_MAX_NUM_DEVICES];
     uint16_t expected_working_counter;
     uint32_t fmmu_count;
+    uint32_t datagram_count;
+    uint32_t datagram_bytes;
+    uint32_t cycle_divisor;
+    uint32_t wc_fault_count;
+    uint16_t wc_fault_slaves[EC_MAX_WC_FAULT_SLAVES];
 } ec_ioctl_domain_t;
 
 /*****************************************************************************/
@@ -327,6 +443,7 @@ typedef struct {
     uint8_t sync_index;
     ec_direction_t dir;
     uint32_t logical_address;
+    uint32_t data_offset;
     uint32_t data_size;
 } ec_ioctl_domain_fmmu_t;
 
@@ -337,6 +454,9 @@ typedef struct {
     uint32_t domain_index;
     uint32_t data_size;
     uint8_t *target;
+
+    // outputs
+    uint32_t process_count;
 } ec_ioctl_domain_data_t;
 
 /*****************************************************************************/
@@ -356,6 +476,7 @@ typedef struct {
 
     // outputs
     uint16_t sdo_index;
+    uint8_t object_code;
     uint8_t max_subindex;
     int8_t name[EC_IOCTL_STRING_SIZE];
 } ec_ioctl_slave_sdo_t;
@@ -378,11 +499,45 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    uint8_t subindex;
+    uint16_t data_type;
+    uint16_t bit_length;
+    uint8_t read_access[EC_SDO_ENTRY_ACCESS_COUNT];
+    uint8_t write_access[EC_SDO_ENTRY_ACCESS_COUNT];
+    int8_t description[EC_IOCTL_STRING_SIZE];
+} ec_ioctl_dict_entry_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    uint16_t index;
+    uint8_t object_code;
+    uint8_t max_subindex;
+    int8_t name[EC_IOCTL_STRING_SIZE];
+    uint16_t entry_count;
+    ec_ioctl_dict_entry_t *entries;
+} ec_ioctl_dict_sdo_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t vendor_id;
+    uint32_t product_code;
+    uint32_t revision_number;
+    uint32_t sdo_count;
+    ec_ioctl_dict_sdo_t *sdos;
+} ec_ioctl_dict_import_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint16_t slave_position;
     uint16_t sdo_index;
     uint8_t sdo_entry_subindex;
+    uint8_t complete_access;
     size_t target_size;
     uint8_t *target;
 
@@ -418,6 +573,43 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint16_t slave_position;
+
+    // outputs
+    uint32_t word_offset; /**< Read: Offset of the image in words. */
+    uint32_t nwords; /**< Read: Size of the image. */
+    ec_request_state_t state; /**< Write: Result. */
+    uint8_t verify_error; /**< Write: The words read back differ. */
+} ec_ioctl_slave_sii_batch_slave_t;
+
+/*****************************************************************************/
+
+/** SII of several slaves.
+ *
+ * EC_IOCTL_SLAVE_SII_READ_BATCH copies the SII images, that the master read
+ * during the bus scan, one after another to words. If nwords is too small,
+ * only data_nwords is returned.
+ *
+ * EC_IOCTL_SLAVE_SII_WRITE_BATCH writes the same nwords words at offset to
+ * all slaves in parallel, and optionally reads them back.
+ */
+typedef struct {
+    // inputs
+    uint32_t slave_count;
+    ec_ioctl_slave_sii_batch_slave_t *slaves;
+    uint16_t offset;
+    uint8_t verify;
+    uint32_t nwords;
+    uint16_t *words;
+
+    // outputs
+    uint32_t data_nwords;
+} ec_ioctl_slave_sii_batch_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint16_t slave_position;
@@ -429,6 +621,274 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint32_t slave_count;
+    const uint16_t *slave_positions;
+    uint16_t address;
+    size_t size; // per slave
+    uint8_t *data; // slave_count * size bytes
+
+    // outputs
+    uint16_t *working_counters; // per slave
+} ec_ioctl_slave_reg_batch_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // outputs
+    int32_t correction;
+    int32_t time_result;
+    uint64_t time;
+} ec_ioctl_dc_servo_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t margin;
+
+    // outputs
+    uint64_t time;
+} ec_ioctl_next_send_time_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t margin;
+
+    // outputs
+    int32_t correction;
+} ec_ioctl_sync0_shift_correction_t;
+
+/*****************************************************************************/
+
+#define EC_IOCTL_DC_HISTOGRAM_BINS 16
+
+typedef struct {
+    uint64_t count;
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+    uint32_t bins[EC_IOCTL_DC_HISTOGRAM_BINS];
+} ec_ioctl_dc_histogram_t;
+
+typedef struct {
+    // outputs
+    uint32_t cycle_time;
+    ec_ioctl_dc_histogram_t sync_monitor;
+    ec_ioctl_dc_histogram_t ref_offset;
+    ec_ioctl_dc_histogram_t send_jitter;
+    uint32_t sync0_cycles_left;
+    ec_ioctl_dc_histogram_t sync0_margin;
+} ec_ioctl_dc_stats_t;
+
+/*****************************************************************************/
+
+#define EC_IOCTL_LATENCY_HISTOGRAM_BINS 20
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+    uint32_t bins[EC_IOCTL_LATENCY_HISTOGRAM_BINS];
+} ec_ioctl_latency_histogram_t;
+
+typedef struct {
+    // outputs
+    ec_ioctl_latency_histogram_t send;
+    ec_ioctl_latency_histogram_t receive;
+} ec_ioctl_latency_stats_t;
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+
+    // outputs
+    ec_ioctl_latency_histogram_t round_trip;
+    ec_ioctl_latency_histogram_t process;
+} ec_ioctl_domain_latency_stats_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    uint64_t start; // ns since the profile was reset
+    uint32_t duration; // us
+    uint16_t slave_position; // EC_STARTUP_MASTER for master events
+    uint8_t phase; // ec_startup_phase_t
+    uint8_t flags; // EC_STARTUP_FAILED
+} ec_ioctl_startup_event_t;
+
+typedef struct {
+    // inputs
+    uint32_t offset;
+    uint32_t max_events;
+    ec_ioctl_startup_event_t *events;
+
+    // outputs
+    uint32_t event_count;
+    uint32_t lost;
+} ec_ioctl_startup_profile_t;
+
+/*****************************************************************************/
+
+#define EC_IOCTL_CAPTURE_UNMATCHED 0x01
+#define EC_IOCTL_CAPTURE_WC_CHANGE 0x02
+
+#define EC_IOCTL_CAPTURE_FRAME_SIZE 1514
+
+typedef struct {
+    // inputs
+    uint32_t triggers;
+    uint32_t post_frames;
+} ec_ioctl_capture_start_t;
+
+typedef struct {
+    // inputs
+    uint32_t dev_idx;
+
+    // outputs
+    uint32_t ring_size;
+    uint8_t active;
+    uint8_t triggered;
+    uint32_t start_seq;
+    uint32_t seq;
+} ec_ioctl_capture_state_t;
+
+typedef struct {
+    uint64_t time;
+    uint32_t seq;
+    uint16_t size;
+    uint8_t dir;
+    uint8_t data[EC_IOCTL_CAPTURE_FRAME_SIZE];
+} ec_ioctl_capture_frame_t;
+
+typedef struct {
+    // inputs
+    uint32_t dev_idx;
+    uint32_t seq;
+    uint32_t max_frames;
+    ec_ioctl_capture_frame_t *frames;
+
+    // outputs
+    uint32_t frame_count;
+} ec_ioctl_capture_read_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t position;
+
+    // outputs
+    uint32_t datagram_count;
+    int32_t domain_index;
+    uint8_t device_index;
+    uint8_t type;
+    uint16_t data_size;
+    char name[EC_DATAGRAM_NAME_SIZE];
+    uint64_t received;
+    uint32_t rtt_min;
+    uint32_t rtt_avg;
+    uint32_t rtt_max;
+    uint32_t timeouts;
+    uint32_t late;
+    uint32_t late_max;
+    uint32_t skips;
+} ec_ioctl_datagram_stats_t;
+
+/*****************************************************************************/
+
+/** Snapshot of all slaves with their sync managers, PDOs and PDO entries.
+ *
+ * For each slave, the buffer contains an ec_ioctl_slave_t, followed by its
+ * sync_count sync managers. Each ec_ioctl_slave_sync_t is followed by its
+ * pdo_count PDOs, and each ec_ioctl_slave_sync_pdo_t by its entry_count
+ * entries (ec_ioctl_slave_sync_pdo_entry_t). The records are not aligned.
+ *
+ * If the buffer is too small, only data_size and slave_count are returned.
+ */
+typedef struct {
+    // inputs
+    uint8_t *buffer;
+    uint32_t buffer_size;
+
+    // outputs
+    uint32_t data_size;
+    uint32_t slave_count;
+} ec_ioctl_slave_snapshot_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    uint32_t index;
+    uint16_t working_counter;
+    uint16_t expected_working_counter;
+    uint8_t redundancy_active;
+    uint32_t process_count;
+} ec_ioctl_monitor_domain_t;
+
+typedef struct {
+    char name[EC_DATAGRAM_NAME_SIZE];
+    uint16_t slave_position;
+    uint8_t open;
+    uint32_t rx_rate;
+    uint32_t tx_rate;
+    uint32_t tx_dropped;
+} ec_ioctl_monitor_eoe_t;
+
+/** Bus and cycle health, collected with a single call for monitoring.
+ *
+ * Statistics recorded by the application are copied without locking. The
+ * slave states, domains and EoE handlers are only returned, if the master
+ * semaphore is free at the time of the call (topology_valid); the call never
+ * waits for it. The arrays are filled up to their capacity, the counts
+ * return the actual numbers.
+ */
+typedef struct {
+    // inputs
+    uint8_t *slave_states;
+    uint32_t slave_capacity;
+    ec_ioctl_monitor_domain_t *domains;
+    uint32_t domain_capacity;
+    ec_ioctl_monitor_eoe_t *eoe_handlers;
+    uint32_t eoe_capacity;
+
+    // outputs
+    uint8_t phase;
+    uint8_t active;
+    uint8_t topology_valid;
+    uint32_t slave_count;
+    uint32_t domain_count;
+    uint32_t eoe_handler_count;
+    struct {
+        uint8_t link_state;
+        uint64_t tx_errors;
+        int32_t tx_frame_rate;
+        int32_t rx_frame_rate;
+    } devices[EC_MAX_NUM_DEVICES];
+    uint32_t num_devices;
+    uint64_t tx_count;
+    uint64_t rx_count;
+    int32_t tx_frame_rate;
+    int32_t rx_frame_rate;
+    int32_t loss_rate;
+    uint64_t cycles;
+    uint32_t frames;
+    uint32_t frames_max;
+    uint32_t fsm_exec_time;
+    uint32_t fsm_exec_time_max;
+    ec_ioctl_latency_histogram_t send;
+    ec_ioctl_latency_histogram_t receive;
+    uint32_t dc_cycle_time;
+    ec_ioctl_dc_histogram_t sync_monitor;
+    ec_ioctl_dc_histogram_t ref_offset;
+} ec_ioctl_monitor_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint16_t slave_position;
@@ -445,6 +905,61 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint16_t slave_position;
+
+    // outputs
+    ec_request_state_t state;
+    size_t progress;
+    uint32_t result;
+    uint32_t error_code;
+} ec_ioctl_foe_job_slave_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t slave_count;
+    ec_ioctl_foe_job_slave_t *slaves;
+    size_t buffer_size;
+    uint8_t *buffer;
+    char file_name[32];
+
+    // outputs
+    uint32_t busy_count;
+} ec_ioctl_foe_job_t;
+
+/*****************************************************************************/
+
+/** Streamed FoE transfer.
+ *
+ * EC_IOCTL_FOE_STREAM_START queues a transfer with a kernel window of
+ * window_size bytes. Every EC_IOCTL_FOE_STREAM_TRANSFER then waits, until
+ * the state machine needs the next block, and passes up to buffer_size
+ * bytes from (write) or to (read) buffer. data_size returns the number of
+ * bytes consumed or delivered. A write sets end with the last block.
+ */
+typedef struct {
+    // inputs
+    uint16_t slave_position;
+    uint8_t dir; /**< EC_DIR_OUTPUT (write) or EC_DIR_INPUT (read). */
+    uint8_t end;
+    uint32_t window_size;
+    uint8_t *buffer;
+    uint32_t buffer_size;
+    char file_name[32];
+
+    // outputs
+    uint32_t data_size;
+    ec_request_state_t state;
+    size_t progress;
+    uint32_t result;
+    uint32_t error_code;
+} ec_ioctl_foe_stream_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint16_t slave_position;
@@ -474,6 +989,15 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint16_t slave_position;
+    uint32_t count;
+    ec_soe_idn_transfer_t *transfers; // results are output
+} ec_ioctl_slave_soe_idns_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t config_index;
@@ -586,6 +1110,9 @@ typedef struct {
     uint32_t tx_rate;
     uint32_t tx_queued_frames;
     uint32_t tx_queue_size;
+    uint32_t tx_queued_bytes;
+    uint32_t tx_queue_bytes;
+    uint32_t tx_dropped;
 } ec_ioctl_eoe_handler_t;
 
 #endif
@@ -593,13 +1120,26 @@ typedef struct {
 /*****************************************************************************/
 
 typedef struct {
+    // inputs
+    uint32_t map_flags;
+
     // outputs
     void *process_data;
     size_t process_data_size;
+    size_t state_offset;
+    size_t mmap_size;
 } ec_ioctl_master_activate_t;
 
 /*****************************************************************************/
 
+typedef struct {
+    // outputs
+    size_t state_offset;
+    size_t mmap_size;
+} ec_ioctl_map_read_only_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t config_index;
@@ -638,6 +1178,38 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint32_t config_index;
+    uint16_t entry_index;
+    uint8_t entry_subindex;
+    uint32_t domain_index;
+
+    // outputs
+    ec_pdo_array_t array;
+} ec_ioctl_reg_pdo_array_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t config_index;
+    uint32_t domain_index;
+} ec_ioctl_sc_dc_latch_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t config_index;
+    uint32_t domain_index;
+    uint16_t address;
+    uint32_t size;
+    ec_direction_t dir;
+} ec_ioctl_sc_reg_fmmu_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t config_index;
@@ -672,6 +1244,16 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint32_t count;
+
+    // outputs
+    ec_slave_config_state_t *states;
+} ec_ioctl_sc_states_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t config_index;
@@ -694,20 +1276,260 @@ typedef struct {
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+
+    // outputs
+    ec_domain_redundancy_t stats;
+} ec_ioctl_domain_redundancy_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t depth;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t flags;
+} ec_ioctl_domain_history_t;
+
+/*****************************************************************************/
+
+#define EC_IOCTL_HISTORY_NOT_MAPPED 0xffffffff
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+
+    // outputs
+    uint32_t depth;
+    uint32_t record_size;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t flags;
+    uint32_t seq;
+    uint8_t frozen;
+    uint32_t map_offset; /**< Offset of the ring in the memory-mapped area,
+                           or EC_IOCTL_HISTORY_NOT_MAPPED. */
+} ec_ioctl_domain_history_state_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t freeze;
+} ec_ioctl_domain_history_freeze_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t seq;
+    uint32_t max_records;
+    uint8_t *records; /**< Memory for \a max_records records of
+                        \a record_size bytes. */
+
+    // outputs
+    uint32_t record_count;
+} ec_ioctl_domain_history_read_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t timeout_us;
+} ec_ioctl_domain_timeout_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t traffic_class;
+    uint32_t priority;
+    uint32_t budget;
+} ec_ioctl_traffic_class_t;
+
+/*****************************************************************************/
+
+/** Maximum number of domains in ec_ioctl_cycle_t::domain_mask. */
+#define EC_IOCTL_CYCLE_MAX_DOMAINS 32
+
+typedef struct {
+    // inputs
+    uint32_t flags;
+    uint32_t domain_mask;
+    uint64_t app_time;
+} ec_ioctl_cycle_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t poll_interval_us;
+} ec_ioctl_domain_notify_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+
+    // outputs
+    uint8_t *bitmap;
+} ec_ioctl_domain_changed_inputs_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t depth;
+} ec_ioctl_domain_pipeline_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t divisor;
+    uint32_t phase;
+} ec_ioctl_domain_divisor_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t alignment;
+} ec_ioctl_domain_alignment_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t domain_index;
+    uint32_t segment;
+} ec_ioctl_domain_segment_t;
+
+/*****************************************************************************/
+
+typedef struct {
+    // inputs
+    uint32_t src_domain_index;
+    uint32_t src_offset;
+    uint32_t src_bit;
+    uint32_t dst_domain_index;
+    uint32_t dst_offset;
+    uint32_t dst_bit;
+    uint32_t bits;
+} ec_ioctl_domain_route_t;
+
+/*****************************************************************************/
+
+/** Version of the configuration batch record format. */
+#define EC_IOCTL_CONFIG_BATCH_VERSION 1
+
+/** Configuration index meaning "no slave configuration selected". */
+#define EC_IOCTL_CONFIG_BATCH_NO_CONFIG 0xFFFFFFFF
+
+/** Configuration batch record types.
+ */
+typedef enum {
+    EC_IOCTL_BATCH_CONFIG, /**< Get or create a slave configuration and
+                             select it for the following records. */
+    EC_IOCTL_BATCH_SYNC, /**< Configure a sync manager. */
+    EC_IOCTL_BATCH_CLEAR_PDOS, /**< Clear a PDO assignment. */
+    EC_IOCTL_BATCH_ADD_PDO, /**< Add a PDO to an assignment. */
+    EC_IOCTL_BATCH_CLEAR_ENTRIES, /**< Clear a PDO mapping. */
+    EC_IOCTL_BATCH_ADD_ENTRY, /**< Add an entry to a PDO mapping. */
+    EC_IOCTL_BATCH_REG_PDO_ENTRY /**< Register a PDO entry. */
+} ec_ioctl_batch_type_t;
+
+/** Configuration batch record.
+ *
+ * Records do not contain pointers and refer to the selected slave
+ * configuration only, so that a batch can be built anywhere in memory.
+ */
+typedef struct {
+    // inputs
+    uint32_t type; /**< Record type (see ec_ioctl_batch_type_t). */
+    union {
+        struct {
+            uint16_t alias;
+            uint16_t position;
+            uint32_t vendor_id;
+            uint32_t product_code;
+        } config; /**< EC_IOCTL_BATCH_CONFIG. */
+        struct {
+            uint8_t sync_index;
+            uint8_t dir;
+            uint8_t watchdog_mode;
+        } sync; /**< EC_IOCTL_BATCH_SYNC. */
+        struct {
+            uint8_t sync_index;
+            uint16_t index;
+        } pdo; /**< EC_IOCTL_BATCH_CLEAR_PDOS, EC_IOCTL_BATCH_ADD_PDO and
+                 EC_IOCTL_BATCH_CLEAR_ENTRIES. */
+        struct {
+            uint16_t pdo_index;
+            uint16_t entry_index;
+            uint8_t entry_subindex;
+            uint8_t entry_bit_length;
+        } entry; /**< EC_IOCTL_BATCH_ADD_ENTRY. */
+        struct {
+            uint16_t entry_index;
+            uint8_t entry_subindex;
+            uint32_t domain_index;
+        } reg; /**< EC_IOCTL_BATCH_REG_PDO_ENTRY. */
+    } u;
+
+    // outputs
+    int32_t result; /**< Configuration index, process data offset, zero or
+                      a negative error code. */
+    uint32_t bit_position; /**< Bit position of a registered entry. */
+} ec_ioctl_config_record_t;
+
+typedef struct {
+    // inputs
+    uint32_t version;
+    uint32_t config_index;
+    uint32_t record_count;
+    ec_ioctl_config_record_t *records;
+
+    // outputs
+    uint32_t processed;
+} ec_ioctl_config_batch_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t config_index;
+    ec_direction_t dir;
 
     // inputs/outputs
     uint32_t request_index;
     uint16_t sdo_index;
     uint8_t sdo_subindex;
+    uint8_t complete_access;
     size_t size;
     uint8_t *data;
     uint32_t timeout;
     ec_request_state_t state;
 } ec_ioctl_sdo_request_t;
 
+typedef struct {
+    // inputs
+    uint32_t count;
+    ec_ioctl_sdo_request_t *requests;
+} ec_ioctl_sdo_request_batch_t;
+
 /*****************************************************************************/
 
 typedef struct {
@@ -737,10 +1559,21 @@ typedef struct {
     size_t size;
     uint8_t *data;
     ec_request_state_t state;
+    size_t offset;
 } ec_ioctl_voe_t;
 
 /*****************************************************************************/
 
+typedef struct {
+    // inputs
+    uint32_t config_index;
+    uint32_t request_index; /**< SDO request, register request or VoE
+                              handler index. */
+    int32_t fd; /**< Eventfd file descriptor, or -1. */
+} ec_ioctl_request_eventfd_t;
+
+/*****************************************************************************/
+
 typedef struct {
     // inputs
     uint32_t dev_idx;
@@ -751,8 +1584,88 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Maximum number of domains published in the state page. */
+#define EC_IOCTL_STATE_MAX_DOMAINS 64
+
+/** Maximum number of slave configuration states published in the state
+ * page. */
+#define EC_IOCTL_STATE_MAX_CONFIGS 1024
+
+/** Location of a domain's process data in the memory-mapped area.
+ *
+ * \a sequence is odd while ecrt_domain_process() writes the received inputs
+ * to the process data, so that read-only mappers can detect torn reads.
+ */
+typedef struct {
+    uint32_t offset; /**< Offset of the process data. */
+    uint32_t size; /**< Size of the process data. */
+    uint32_t sequence; /**< Sequence counter. */
+} ec_ioctl_domain_map_t;
+
+/** State page.
+ *
+ * Published by the kernel in the memory-mapped area behind the process data,
+ * so that the application can read the master, link, domain and slave
+ * configuration states without a system call. Updates are guarded by
+ * \a sequence, which is odd while an update is in progress.
+ *
+ * The \a cycle descriptor is written by the application instead. It is read
+ * by EC_IOCTL_CYCLE_SHARED, so that the cyclic calls need no argument
+ * copying. \a cycle_trigger is also written by the application, see
+ * ecrt_master_trigger_cycle().
+ *
+ * Bit n of \a emerg_pending is set, as long as the CoE emergency ring of the
+ * slave configuration with index n is not empty. Bit n of \a emerg_summary
+ * is set, if any bit of emerg_pending[n] is set. Both are updated atomically
+ * and are not guarded by \a sequence.
+ */
+typedef struct {
+    uint32_t sequence;
+    uint32_t cycle_counter; /**< Incremented after each master-timed cycle. */
+    uint32_t num_devices;
+    uint32_t domain_count;
+    ec_master_state_t master_state;
+    ec_master_link_state_t link_states[EC_MAX_NUM_DEVICES];
+    ec_domain_state_t domain_states[EC_IOCTL_STATE_MAX_DOMAINS];
+    uint32_t config_count;
+    ec_slave_config_state_t config_states[EC_IOCTL_STATE_MAX_CONFIGS];
+    ec_ioctl_cycle_t cycle; /**< Cycle descriptor (written by the
+                              application). */
+    ec_ioctl_domain_map_t domain_maps[EC_IOCTL_STATE_MAX_DOMAINS];
+    uint32_t emerg_summary; /**< Summary of \a emerg_pending. */
+    uint32_t emerg_pending[EC_IOCTL_STATE_MAX_CONFIGS / 32];
+    uint32_t cycle_trigger; /**< Incremented by the application to trigger
+                              a master-timed cycle. */
+} ec_ioctl_state_page_t;
+
+/*****************************************************************************/
+
+/* Acyclic requests via io_uring.
+ *
+ * Kernels from 6.6 on accept the requests EC_IOCTL_SLAVE_SDO_UPLOAD,
+ * EC_IOCTL_SLAVE_SDO_DOWNLOAD, EC_IOCTL_SLAVE_REG_READ,
+ * EC_IOCTL_SLAVE_REG_WRITE, EC_IOCTL_SLAVE_FOE_READ and
+ * EC_IOCTL_SLAVE_FOE_WRITE also as IORING_OP_URING_CMD submissions on the
+ * master file descriptor: \a cmd_op is the ioctl request number and the
+ * first 8 bytes of the command area hold the address of the ioctl argument.
+ * The argument and the data it points to must stay valid until the
+ * completion is reaped. The completion's result is the return value of the
+ * ioctl; the outputs are written to the argument. Thus a single thread can
+ * keep many mailbox transfers in flight.
+ */
+
 #ifdef __KERNEL__
 
+#include <linux/hrtimer.h>
+#include <linux/poll.h>
+#include <linux/version.h>
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+/** Defined, if the master device supports io_uring commands. */
+#define EC_HAVE_URING_CMD
+struct io_uring_cmd;
+#endif
+
 /** Context data structure for file handles.
  */
 typedef struct {
@@ -760,15 +1673,49 @@ typedef struct {
     unsigned int requested; /**< Master was requested via this file handle. */
     uint8_t *process_data; /**< Total process data area. */
     size_t process_data_size; /**< Size of the \a process_data. */
+    size_t mmap_size; /**< Size of the memory area behind \a process_data,
+                        that is mapped to user space. */
+    ec_ioctl_state_page_t *state; /**< State page in the mapped memory. */
+    unsigned int read_only_map; /**< The memory of the application,
+                                  that activated the master, is mapped
+                                  read-only via this file handle. */
+    uint32_t map_flags; /**< Memory mapping flags (EC_MAP_*). The
+                          #EC_MAP_CONTIGUOUS flag is only set, if
+                          \a process_data was allocated contiguously. */
+    ec_domain_t *notify_domain; /**< Domain, whose completion is signalled
+                                  via poll(), or NULL. */
+    unsigned int notify_processed; /**< The completed \a notify_domain was
+                                     processed. */
+    ktime_t poll_interval; /**< Interval to poll the devices in poll(),
+                             while \a notify_domain is in flight. */
+    struct hrtimer poll_timer; /**< Timer to wake up poll(). */
+    wait_queue_head_t poll_queue; /**< Wait queue for poll(). */
+    struct ec_ioctl_foe_job *foe_job; /**< FoE job started via this file
+                                        handle, or NULL. */
+    struct ec_ioctl_foe_stream *foe_stream; /**< Streamed FoE transfer
+                                              started via this file handle,
+                                              or NULL. */
+    struct eventfd_ctx *emerg_eventfd; /**< Eventfd signalled on CoE
+                                         emergencies, or NULL. */
 } ec_ioctl_context_t;
 
 long ec_ioctl(ec_master_t *, ec_ioctl_context_t *, unsigned int,
         void __user *);
+unsigned int ec_ioctl_poll(ec_master_t *, ec_ioctl_context_t *,
+        struct file *, poll_table *);
+void ec_ioctl_foe_job_abort(ec_master_t *, ec_ioctl_context_t *);
+void ec_ioctl_foe_stream_abort(ec_master_t *, ec_ioctl_context_t *);
+void ec_ioctl_release(ec_master_t *, ec_ioctl_context_t *);
+#ifdef EC_HAVE_URING_CMD
+int ec_ioctl_uring_cmd(ec_master_t *, ec_ioctl_context_t *,
+        struct io_uring_cmd *, unsigned int);
+#endif
 
 #ifdef EC_RTDM
 
 long ec_ioctl_rtdm(ec_master_t *, ec_ioctl_context_t *, unsigned int,
         void __user *);
+int ec_ioctl_rtdm_cycle(ec_master_t *, ec_ioctl_context_t *);
 int ec_rtdm_mmap(ec_ioctl_context_t *, void **);
 
 #endif
@@ -36,6 +36,7 @@
 
 #include <linux/slab.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 
 #include "mailbox.h"
 #include "datagram.h"
@@ -43,12 +44,29 @@
 
 /*****************************************************************************/
 
+/** Checks, if a datagram belongs to the slave state machines.
+ *
+ * \return Non-zero, if the datagram is from the external datagram ring.
+ */
+static int ec_slave_mbox_fsm_datagram(
+        const ec_slave_t *slave, /**< slave */
+        const ec_datagram_t *datagram /**< datagram */
+        )
+{
+    const ec_master_t *master = slave->master;
+
+    return datagram >= master->ext_datagram_ring
+        && datagram < master->ext_datagram_ring + master->ext_ring_size;
+}
+
+/*****************************************************************************/
+
 /**
    Prepares a mailbox-send datagram.
    \return Pointer to mailbox datagram data, or ERR_PTR() code.
 */
 
-uint8_t *ec_slave_mbox_prepare_send(const ec_slave_t *slave, /**< slave */
+uint8_t *ec_slave_mbox_prepare_send(ec_slave_t *slave, /**< slave */
                                     ec_datagram_t *datagram, /**< datagram */
                                     uint8_t type, /**< mailbox protocol */
                                     size_t size /**< size of the data */
@@ -82,18 +100,120 @@ uint8_t *ec_slave_mbox_prepare_send(const ec_slave_t *slave, /**< slave */
     EC_WRITE_U8 (datagram->data + 4, 0x00); // channel & priority
     EC_WRITE_U8 (datagram->data + 5, type); // underlying protocol type
 
+    slave->mbox_status_sync = 1;
+    slave->mbox_repeat_requested = 0;
+
+    if (ec_slave_mbox_fsm_datagram(slave, datagram)) {
+        // the response is not expected before half the usual response time
+        slave->mbox_sent_time = ktime_to_ns(ktime_get());
+        slave->mbox_poll_next = slave->mbox_sent_time +
+            min_t(u32, slave->mbox_response_time / 2, EC_MBOX_POLL_MAX_NS);
+        slave->mbox_poll_interval = 0;
+    }
     return datagram->data + EC_MBOX_HEADER_SIZE;
 }
 
 /*****************************************************************************/
 
+/** Checks, if a mailbox state check can be answered from the mailbox
+ * status area.
+ *
+ * This is only done for the datagrams of the slave state machines, because
+ * they are executed in the master thread together with the master state
+ * machine, that reads the area. The area content must have been read after
+ * the last mailbox access, otherwise it could be outdated.
+ *
+ * \return Non-zero, if the mailbox status area content can be used.
+ */
+static int ec_slave_mbox_status_valid(
+        ec_slave_t *slave, /**< slave */
+        const ec_datagram_t *datagram /**< datagram */
+        )
+{
+    ec_master_t *master = slave->master;
+    const ec_fsm_master_t *fsm = &master->fsm;
+
+    if (!slave->mbox_status_mapped
+            || !ec_slave_mbox_fsm_datagram(slave, datagram)) {
+        return 0;
+    }
+
+    if (slave->mbox_status_sync) {
+        slave->mbox_status_sync = 0;
+        slave->mbox_status_seq = fsm->mbox_seq;
+    }
+
+    return (int) (fsm->mbox_valid_seq - slave->mbox_status_seq) > 0
+        && slave->station_address <= fsm->mbox_size;
+}
+
+/*****************************************************************************/
+
+/** Checks, if a mailbox state check shall be answered with an empty mailbox
+ * without a bus round trip.
+ *
+ * While a slave FSM waits for a response, the checks back off exponentially
+ * from every cycle up to EC_MBOX_POLL_MAX_NS, so that slow responses do not
+ * cause a check datagram in every cycle. Like the mailbox status area, this
+ * is only done for the datagrams of the slave state machines.
+ *
+ * \return Non-zero, if the check shall be skipped.
+ */
+static int ec_slave_mbox_poll_deferred(
+        ec_slave_t *slave, /**< slave */
+        const ec_datagram_t *datagram /**< datagram */
+        )
+{
+    u64 now;
+
+    if (!slave->mbox_poll_next
+            || !ec_slave_mbox_fsm_datagram(slave, datagram)) {
+        return 0;
+    }
+
+    now = ktime_to_ns(ktime_get());
+    if (now < slave->mbox_poll_next) {
+        return 1;
+    }
+
+    slave->mbox_poll_next = now + slave->mbox_poll_interval;
+    if (!slave->mbox_poll_interval) {
+        slave->mbox_poll_interval = EC_MBOX_POLL_MIN_NS;
+    } else if (slave->mbox_poll_interval < EC_MBOX_POLL_MAX_NS / 2) {
+        slave->mbox_poll_interval *= 2;
+    } else {
+        slave->mbox_poll_interval = EC_MBOX_POLL_MAX_NS;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Marks a datagram as received without a bus round trip.
+ */
+static void ec_slave_mbox_complete_locally(
+        ec_datagram_t *datagram /**< datagram */
+        )
+{
+    datagram->working_counter = 1;
+    datagram->state = EC_DATAGRAM_RECEIVED;
+#ifdef EC_HAVE_CYCLES
+    datagram->cycles_sent = get_cycles();
+    datagram->cycles_received = datagram->cycles_sent;
+#endif
+    datagram->jiffies_sent = jiffies;
+    datagram->jiffies_received = datagram->jiffies_sent;
+}
+
+/*****************************************************************************/
+
 /**
    Prepares a datagram for checking the mailbox state.
    \todo Determine sync manager used for receive mailbox
    \return 0 in case of success, else < 0
 */
 
-int ec_slave_mbox_prepare_check(const ec_slave_t *slave, /**< slave */
+int ec_slave_mbox_prepare_check(ec_slave_t *slave, /**< slave */
                                 ec_datagram_t *datagram /**< datagram */
                                 )
 {
@@ -102,6 +222,25 @@ int ec_slave_mbox_prepare_check(const ec_slave_t *slave, /**< slave */
         return ret;
 
     ec_datagram_zero(datagram);
+
+    if (slave->mbox_stash_valid) {
+        // a response was already read via the mailbox data area
+        EC_WRITE_U8(datagram->data + 5, 0x08);
+        ec_slave_mbox_complete_locally(datagram);
+    } else if (slave->mbox_data_active
+            && ec_slave_mbox_fsm_datagram(slave, datagram)) {
+        // the master reads the send mailbox, see ec_fsm_master
+        ec_slave_mbox_complete_locally(datagram);
+    } else if (ec_slave_mbox_status_valid(slave, datagram)) {
+        // answer from the mailbox status area without a bus round trip
+        EC_WRITE_U8(datagram->data + 5, slave->master->fsm.mbox_status[
+                slave->station_address - 1]);
+        ec_slave_mbox_complete_locally(datagram);
+    } else if (ec_slave_mbox_poll_deferred(slave, datagram)) {
+        // answer with an empty mailbox, the response is not expected yet
+        ec_slave_mbox_complete_locally(datagram);
+    }
+
     return 0;
 }
 
@@ -124,7 +263,7 @@ int ec_slave_mbox_check(const ec_datagram_t *datagram /**< datagram */)
    \return 0 in case of success, else < 0
 */
 
-int ec_slave_mbox_prepare_fetch(const ec_slave_t *slave, /**< slave */
+int ec_slave_mbox_prepare_fetch(ec_slave_t *slave, /**< slave */
                                 ec_datagram_t *datagram /**< datagram */
                                 )
 {
@@ -135,6 +274,83 @@ int ec_slave_mbox_prepare_fetch(const ec_slave_t *slave, /**< slave */
         return ret;
 
     ec_datagram_zero(datagram);
+    slave->mbox_status_sync = 1;
+
+    if (slave->mbox_poll_next
+            && ec_slave_mbox_fsm_datagram(slave, datagram)) {
+        // learn the response time for the next request
+        s32 sample = min_t(u64, ktime_to_ns(ktime_get())
+                - slave->mbox_sent_time, 2 * EC_MBOX_POLL_MAX_NS);
+        s32 average = slave->mbox_response_time;
+
+        slave->mbox_response_time = average + (sample - average) / 4;
+        slave->mbox_poll_next = 0ULL;
+    }
+
+    if (slave->mbox_stash_valid) {
+        // hand over the response read via the mailbox data area
+        memcpy(datagram->data, slave->mbox_stash,
+                min(datagram->data_size, slave->mbox_stash_size));
+        slave->mbox_stash_valid = 0;
+        ec_slave_mbox_complete_locally(datagram);
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Requests the repetition of the last mailbox response.
+ *
+ * If a mailbox response got lost on the way to the master, the slave can be
+ * asked to write it to the send mailbox again by toggling the repeat request
+ * bit of the send mailbox sync manager. Afterwards, the mailbox can be
+ * checked and fetched as usual.
+ *
+ * The repetition is requested at most once per mailbox request.
+ *
+ * \return 0 in case of success, else < 0
+ */
+int ec_slave_mbox_request_repeat(ec_slave_t *slave, /**< slave */
+                                 ec_datagram_t *datagram /**< datagram */
+                                 )
+{
+    int ret;
+
+    if (slave->mbox_repeat_requested)
+        return -EALREADY;
+
+    slave->mbox_repeat_toggle = !slave->mbox_repeat_toggle;
+
+    ret = ec_slave_mbox_prepare_repeat(slave, datagram);
+    if (ret) {
+        slave->mbox_repeat_toggle = !slave->mbox_repeat_toggle;
+        return ret;
+    }
+
+    slave->mbox_repeat_requested = 1;
+    slave->mbox_status_sync = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Prepares a datagram to write the repeat request bit.
+ *
+ * This can be used to resend the datagram of
+ * ec_slave_mbox_request_repeat() on timeout.
+ *
+ * \return 0 in case of success, else < 0
+ */
+int ec_slave_mbox_prepare_repeat(const ec_slave_t *slave, /**< slave */
+                                 ec_datagram_t *datagram /**< datagram */
+                                 )
+{
+    // SM1 activation register
+    int ret = ec_datagram_fpwr(datagram, slave->station_address, 0x080E, 1);
+    if (ret)
+        return ret;
+
+    EC_WRITE_U8(datagram->data, 0x01 | (slave->mbox_repeat_toggle << 1));
     return 0;
 }
 
@@ -47,11 +47,13 @@
 
 /*****************************************************************************/
 
-uint8_t *ec_slave_mbox_prepare_send(const ec_slave_t *, ec_datagram_t *,
+uint8_t *ec_slave_mbox_prepare_send(ec_slave_t *, ec_datagram_t *,
                                     uint8_t, size_t);
-int      ec_slave_mbox_prepare_check(const ec_slave_t *, ec_datagram_t *);
+int      ec_slave_mbox_prepare_check(ec_slave_t *, ec_datagram_t *);
 int      ec_slave_mbox_check(const ec_datagram_t *);
-int      ec_slave_mbox_prepare_fetch(const ec_slave_t *, ec_datagram_t *);
+int      ec_slave_mbox_prepare_fetch(ec_slave_t *, ec_datagram_t *);
+int      ec_slave_mbox_request_repeat(ec_slave_t *, ec_datagram_t *);
+int      ec_slave_mbox_prepare_repeat(const ec_slave_t *, ec_datagram_t *);
 uint8_t *ec_slave_mbox_fetch(const ec_slave_t *, const ec_datagram_t *,
                              uint8_t *, size_t *);
 
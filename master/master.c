@@ -42,12 +42,16 @@
 #include <linux/device.h>
 #include <linux/version.h>
 #include <linux/hrtimer.h>
+#include <linux/rcupdate.h>
+#include <linux/if_vlan.h>
+#include <asm/div64.h>
 
 #include "globals.h"
 #include "slave.h"
 #include "slave_config.h"
 #include "device.h"
 #include "datagram.h"
+#include "datagram_pair.h"
 
 #ifdef EC_EOE
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
@@ -58,6 +62,9 @@
 #endif
 
 #include "master.h"
+#include "debugfs.h"
+#include "payload.h"
+#include "trace.h"
 
 /*****************************************************************************/
 
@@ -69,11 +76,24 @@
  */
 #define FORCE_OUTPUT_CORRUPTED 0
 
-#ifdef EC_HAVE_CYCLES
+#ifdef EC_EOE
+
+/** Interval of the mailbox checks of idle EoE handlers [ns].
+ */
+#define EC_EOE_IDLE_PERIOD 1000000
 
-/** Frame timeout in cycles.
+/** Processing interval of the EoE thread, while handlers are busy [ns].
  */
-static cycles_t timeout_cycles;
+#define EC_EOE_BUSY_PERIOD 100000
+
+/** Number of idle periods, after which the mailbox of an idle EoE handler is
+ * checked, if its slave has the mailbox status mapped.
+ */
+#define EC_EOE_MAPPED_POLLS 100
+
+#endif
+
+#ifdef EC_HAVE_CYCLES
 
 /** Timeout for external datagram injection [cycles].
  */
@@ -81,10 +101,6 @@ static cycles_t ext_injection_timeout_cycles;
 
 #else
 
-/** Frame timeout in jiffies.
- */
-static unsigned long timeout_jiffies;
-
 /** Timeout for external datagram injection [jiffies].
  */
 static unsigned long ext_injection_timeout_jiffies;
@@ -105,10 +121,22 @@ static int ec_master_idle_thread(void *);
 static int ec_master_operation_thread(void *);
 #ifdef EC_EOE
 static int ec_master_eoe_thread(void *);
+static void ec_master_eoe_deactivate(ec_master_t *, ec_eoe_t *);
 #endif
 void ec_master_find_dc_ref_clock(ec_master_t *);
 void ec_master_clear_device_stats(ec_master_t *);
 void ec_master_update_device_stats(ec_master_t *);
+static void ec_master_sort_traffic_classes(ec_master_t *);
+static void ec_master_dc_servo_reset(ec_dc_servo_t *);
+static void ec_master_dc_stats_clear(ec_dc_stats_t *);
+static void ec_master_dc_stats_send(ec_master_t *);
+static void ec_master_dc_stats_sync0(ec_master_t *);
+static void ec_master_latency_stats_clear(ec_master_t *);
+static void ec_master_update_fsm_counters(ec_master_t *, ktime_t);
+static void ec_master_dc_servo_update(ec_master_t *);
+static u32 ec_master_frame_time(const ec_master_t *);
+static void ec_master_queue_slave_sync(ec_master_t *);
+static void ec_master_take_ext_datagrams(ec_master_t *);
 
 /*****************************************************************************/
 
@@ -117,12 +145,10 @@ void ec_master_update_device_stats(ec_master_t *);
 void ec_master_init_static(void)
 {
 #ifdef EC_HAVE_CYCLES
-    timeout_cycles = (cycles_t) EC_IO_TIMEOUT /* us */ * (cpu_khz / 1000);
     ext_injection_timeout_cycles =
         (cycles_t) EC_SDO_INJECTION_TIMEOUT /* us */ * (cpu_khz / 1000);
 #else
     // one jiffy may always elapse between time measurement
-    timeout_jiffies = max(EC_IO_TIMEOUT * HZ / 1000000, 1);
     ext_injection_timeout_jiffies =
         max(EC_SDO_INJECTION_TIMEOUT * HZ / 1000000, 1);
 #endif
@@ -141,7 +167,14 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
         const uint8_t *backup_mac, /**< MAC address of backup device */
         dev_t device_number, /**< Character device number. */
         struct class *class, /**< Device class. */
-        unsigned int debug_level /**< Debug level (module parameter). */
+        unsigned int debug_level, /**< Debug level (module parameter). */
+        unsigned int ext_ring_size, /**< Size of the external datagram ring
+                                     (module parameter). */
+        int cpu, /**< CPU to bind the master threads to, or -1 (module
+                   parameter). */
+        const uint16_t *vlan_tcis /**< VLAN tag control information for
+                                    every device, or zero (module
+                                    parameter). */
         )
 {
     int ret;
@@ -149,6 +182,10 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     master->index = index;
     master->reserved = 0;
+    master->shared = 0;
+    master->activations = 0;
+    INIT_LIST_HEAD(&master->kept_mem);
+    master->cpu = cpu;
 
     sema_init(&master->master_sem, 1);
 
@@ -179,12 +216,29 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     master->slaves = NULL;
     master->slave_count = 0;
+    seqcount_init(&master->slaves_seq);
+    master->alias_index = NULL;
+    master->alias_index_mask = 0;
 
     INIT_LIST_HEAD(&master->configs);
+    master->config_count = 0;
+    master->config_index = NULL;
+    master->config_index_size = 0;
+    memset(master->config_hash, 0, sizeof(master->config_hash));
     INIT_LIST_HEAD(&master->domains);
 
     master->app_time = 0ULL;
     master->dc_ref_time = 0ULL;
+    ec_master_dc_servo_reset(&master->dc_servo);
+    ec_master_dc_stats_clear(&master->dc_stats);
+    master->dc_stats.cycle_time = 0;
+    ec_master_latency_stats_clear(master);
+    ec_startup_profile_init(&master->startup_profile);
+    memset(&master->counters, 0, sizeof(master->counters));
+    seqcount_init(&master->counters.cycle_seq);
+    seqcount_init(&master->counters.fsm_seq);
+    seqcount_init(&master->counters.eoe_seq);
+    master->debugfs_dir = NULL;
 
     master->scan_busy = 0;
     master->allow_scan = 1;
@@ -195,40 +249,86 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     sema_init(&master->config_sem, 1);
     init_waitqueue_head(&master->config_queue);
 
-    INIT_LIST_HEAD(&master->datagram_queue);
     master->datagram_index = 0;
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++) {
+        master->sent_datagrams[i] = NULL;
+    }
 
-    INIT_LIST_HEAD(&master->ext_datagram_queue);
-    sema_init(&master->ext_queue_sem, 1);
+    for (i = 0; i < EC_EXT_QUEUE_SIZE; i++) {
+        master->ext_datagram_queue[i] = NULL;
+    }
+    master->ext_queue_idx_rt = 0;
+    master->ext_queue_idx_eoe = 0;
 
     master->ext_ring_idx_rt = 0;
     master->ext_ring_idx_fsm = 0;
 
     // init external datagram ring
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    master->ext_ring_size = ext_ring_size;
+    master->ext_datagram_ring = kmalloc_node(
+            sizeof(ec_datagram_t) * ext_ring_size, GFP_KERNEL,
+            ec_master_node(master));
+    if (!master->ext_datagram_ring) {
+        EC_MASTER_ERR(master, "Failed to allocate external"
+                " datagram ring of size %u.\n", ext_ring_size);
+        return -ENOMEM;
+    }
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_t *datagram = &master->ext_datagram_ring[i];
         ec_datagram_init(datagram);
         snprintf(datagram->name, EC_DATAGRAM_NAME_SIZE, "ext-%u", i);
+        datagram->traffic_class = EC_TC_MAILBOX;
     }
 
     // send interval in IDLE phase
+    master->queued_bytes = 0;
+    master->bus_delay = 0;
+    master->tx_launch_time = 0ULL;
     ec_master_set_send_interval(master, 1000000 / HZ);
 
     master->fsm_slave = NULL;
+    master->fsm_sweep_jiffies = jiffies;
     INIT_LIST_HEAD(&master->fsm_exec_list);
     master->fsm_exec_count = 0U;
+    INIT_LIST_HEAD(&master->fsm_ready_list);
+    init_llist_head(&master->config_kick_list);
 
     master->debug_level = debug_level;
     master->stats.timeouts = 0;
     master->stats.corrupted = 0;
     master->stats.unmatched = 0;
+    master->stats.late = 0;
+    master->stats.late_max = 0;
+    master->stats.index_deferred = 0;
     master->stats.output_jiffies = 0;
+    ec_rt_log_init(&master->rt_log, index);
+
+    for (i = 0; i < EC_TC_COUNT; i++) {
+        ec_traffic_class_info_t *tc = &master->traffic_classes[i];
+        tc->priority = i;
+        tc->budget = 0;
+        tc->datagrams = 0;
+        tc->bytes = 0;
+        tc->deferred = 0;
+        tc->held = 0;
+    }
+    ec_master_sort_traffic_classes(master);
+
+#ifdef EC_EOE
+    master->eoe_share = min(ec_eoe_share, 100U);
+#else
+    master->eoe_share = 0;
+#endif
 
     master->thread = NULL;
+    init_waitqueue_head(&master->idle_queue);
+    master->idle_irq_event = 0;
 
 #ifdef EC_EOE
     master->eoe_thread = NULL;
     INIT_LIST_HEAD(&master->eoe_handlers);
+    INIT_LIST_HEAD(&master->eoe_active);
+    spin_lock_init(&master->eoe_lock);
 #endif
 
     sema_init(&master->io_sem, 1);
@@ -238,24 +338,45 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     master->app_send_cb = NULL;
     master->app_receive_cb = NULL;
     master->app_cb_data = NULL;
-
-    INIT_LIST_HEAD(&master->sii_requests);
+    master->timed_cycle_flags = 0;
+    master->cycle_cb = NULL;
+    master->cycle_cb_data = NULL;
+    master->cycle_trigger = 0;
+    master->cycle_trigger_ext = NULL;
+    master->cycle_trigger_seen = 0;
+    master->mapped_mem = NULL;
+    master->mapped_mem_size = 0;
+    master->mapped_mem_flags = 0;
+
+    INIT_LIST_HEAD(&master->sii_cache);
+    INIT_LIST_HEAD(&master->dict_cache);
+    INIT_LIST_HEAD(&master->sii_data);
     INIT_LIST_HEAD(&master->emerg_reg_requests);
+    INIT_LIST_HEAD(&master->reg_batches);
 
     init_waitqueue_head(&master->request_queue);
 
     // init devices
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
-        ret = ec_device_init(&master->devices[dev_idx], master);
+        ret = ec_device_init(&master->devices[dev_idx], master,
+                vlan_tcis[dev_idx]);
         if (ret < 0) {
             goto out_clear_devices;
         }
+        if (vlan_tcis[dev_idx]) {
+            EC_MASTER_INFO(master, "Tagging frames of %s device with"
+                    " VLAN ID %u, priority %u.\n",
+                    ec_device_names[dev_idx != 0],
+                    vlan_tcis[dev_idx] & VLAN_VID_MASK,
+                    vlan_tcis[dev_idx] >> VLAN_PRIO_SHIFT);
+        }
     }
 
     // init state machine datagram
     ec_datagram_init(&master->fsm_datagram);
     snprintf(master->fsm_datagram.name, EC_DATAGRAM_NAME_SIZE, "master-fsm");
+    master->fsm_datagram.traffic_class = EC_TC_MASTER_FSM;
     ret = ec_datagram_prealloc(&master->fsm_datagram, EC_MAX_DATA_SIZE);
     if (ret < 0) {
         ec_datagram_clear(&master->fsm_datagram);
@@ -267,7 +388,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     ec_fsm_master_init(&master->fsm, master, &master->fsm_datagram);
 
     // alloc external datagram ring
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_t *datagram = &master->ext_datagram_ring[i];
         ret = ec_datagram_prealloc(datagram, EC_MAX_DATA_SIZE);
         if (ret) {
@@ -281,7 +402,8 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     ec_datagram_init(&master->ref_sync_datagram);
     snprintf(master->ref_sync_datagram.name, EC_DATAGRAM_NAME_SIZE,
             "refsync");
-    ret = ec_datagram_prealloc(&master->ref_sync_datagram, 4);
+    master->ref_sync_datagram.traffic_class = EC_TC_DC;
+    ret = ec_datagram_prealloc(&master->ref_sync_datagram, 8);
     if (ret < 0) {
         ec_datagram_clear(&master->ref_sync_datagram);
         EC_MASTER_ERR(master, "Failed to allocate reference"
@@ -292,7 +414,8 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     // init sync datagram
     ec_datagram_init(&master->sync_datagram);
     snprintf(master->sync_datagram.name, EC_DATAGRAM_NAME_SIZE, "sync");
-    ret = ec_datagram_prealloc(&master->sync_datagram, 4);
+    master->sync_datagram.traffic_class = EC_TC_DC;
+    ret = ec_datagram_prealloc(&master->sync_datagram, 8);
     if (ret < 0) {
         ec_datagram_clear(&master->sync_datagram);
         EC_MASTER_ERR(master, "Failed to allocate"
@@ -304,6 +427,7 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     ec_datagram_init(&master->sync_mon_datagram);
     snprintf(master->sync_mon_datagram.name, EC_DATAGRAM_NAME_SIZE,
             "syncmon");
+    master->sync_mon_datagram.traffic_class = EC_TC_DC;
     ret = ec_datagram_brd(&master->sync_mon_datagram, 0x092c, 4);
     if (ret < 0) {
         ec_datagram_clear(&master->sync_mon_datagram);
@@ -314,6 +438,8 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
 
     master->dc_ref_config = NULL;
     master->dc_ref_clock = NULL;
+    master->dc_domain = NULL;
+    master->dc_ref_sync_pending = 0;
 
     // init character device
     ret = ec_cdev_init(&master->cdev, master, device_number);
@@ -351,6 +477,8 @@ int ec_master_init(ec_master_t *master, /**< EtherCAT master */
     }
 #endif
 
+    ec_debugfs_master_init(master);
+
     return 0;
 
 #ifdef EC_RTDM
@@ -370,7 +498,7 @@ out_clear_sync:
 out_clear_ref_sync:
     ec_datagram_clear(&master->ref_sync_datagram);
 out_clear_ext_datagrams:
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_clear(&master->ext_datagram_ring[i]);
     }
     ec_fsm_master_clear(&master->fsm);
@@ -379,6 +507,8 @@ out_clear_devices:
     for (; dev_idx > 0; dev_idx--) {
         ec_device_clear(&master->devices[dev_idx - 1]);
     }
+    kfree(master->ext_datagram_ring);
+    ec_startup_profile_clear(&master->startup_profile);
     return ret;
 }
 
@@ -392,6 +522,8 @@ void ec_master_clear(
 {
     unsigned int dev_idx, i;
 
+    ec_debugfs_master_clear(master);
+
 #ifdef EC_RTDM
     ec_rtdm_dev_clear(&master->rtdm_dev);
 #endif
@@ -410,14 +542,17 @@ void ec_master_clear(
     ec_master_clear_domains(master);
     ec_master_clear_slave_configs(master);
     ec_master_clear_slaves(master);
+    ec_master_sii_cache_clear(master);
+    ec_master_dict_cache_clear(master);
 
     ec_datagram_clear(&master->sync_mon_datagram);
     ec_datagram_clear(&master->sync_datagram);
     ec_datagram_clear(&master->ref_sync_datagram);
 
-    for (i = 0; i < EC_EXT_RING_SIZE; i++) {
+    for (i = 0; i < master->ext_ring_size; i++) {
         ec_datagram_clear(&master->ext_datagram_ring[i]);
     }
+    kfree(master->ext_datagram_ring);
 
     ec_fsm_master_clear(&master->fsm);
     ec_datagram_clear(&master->fsm_datagram);
@@ -426,6 +561,8 @@ void ec_master_clear(
             dev_idx++) {
         ec_device_clear(&master->devices[dev_idx]);
     }
+
+    ec_startup_profile_clear(&master->startup_profile);
 }
 
 /*****************************************************************************/
@@ -441,7 +578,10 @@ void ec_master_clear_eoe_handlers(
 
     list_for_each_entry_safe(eoe, next, &master->eoe_handlers, list) {
         list_del(&eoe->list);
+        ec_master_flush_datagram_ext(master, &eoe->datagram);
+        ec_master_flush_datagram_ext(master, &eoe->rx_datagram);
         ec_eoe_clear(eoe);
+        ec_master_eoe_deactivate(master, eoe);
         kfree(eoe);
     }
 }
@@ -456,13 +596,48 @@ void ec_master_clear_slave_configs(ec_master_t *master)
     ec_slave_config_t *sc, *next;
 
     master->dc_ref_config = NULL;
-    master->fsm.sdo_request = NULL; // mark sdo_request as invalid
+
+    // forget the configurations with new requests
+    init_llist_head(&master->config_kick_list);
 
     list_for_each_entry_safe(sc, next, &master->configs, list) {
         list_del(&sc->list);
         ec_slave_config_clear(sc);
         kfree(sc);
     }
+
+    master->config_count = 0;
+    kfree(master->config_index);
+    master->config_index = NULL;
+    master->config_index_size = 0;
+    memset(master->config_hash, 0, sizeof(master->config_hash));
+}
+
+/*****************************************************************************/
+
+/** Publishes the number of slaves to lockless readers.
+ *
+ * The slave information ioctl() does not take the master semaphore. It reads
+ * the slaves inside an RCU read-side critical section and retries, if the
+ * slave count changed meanwhile. If slaves are removed, this waits until
+ * those readers are done, so that the removed slaves can be cleared.
+ */
+void ec_master_publish_slaves(
+        ec_master_t *master, /**< EtherCAT master. */
+        unsigned int slave_count /**< New number of slaves. */
+        )
+{
+    unsigned int old_count = master->slave_count;
+
+    preempt_disable();
+    write_seqcount_begin(&master->slaves_seq);
+    master->slave_count = slave_count;
+    write_seqcount_end(&master->slaves_seq);
+    preempt_enable();
+
+    if (slave_count < old_count) {
+        synchronize_rcu();
+    }
 }
 
 /*****************************************************************************/
@@ -471,31 +646,20 @@ void ec_master_clear_slave_configs(ec_master_t *master)
  */
 void ec_master_clear_slaves(ec_master_t *master)
 {
-    ec_slave_t *slave;
+    ec_slave_t *slave, *end = master->slaves + master->slave_count;
 
     master->dc_ref_clock = NULL;
 
-    // External requests are obsolete, so we wake pending waiters and remove
-    // them from the list.
-
-    while (!list_empty(&master->sii_requests)) {
-        ec_sii_write_request_t *request =
-            list_entry(master->sii_requests.next,
-                    ec_sii_write_request_t, list);
-        list_del_init(&request->list); // dequeue
-        EC_MASTER_WARN(master, "Discarding SII request, slave %u about"
-                " to be deleted.\n", request->slave->ring_position);
-        request->state = EC_INT_REQUEST_FAILURE;
-        wake_up_all(&master->request_queue);
-    }
-
     master->fsm_slave = NULL;
     INIT_LIST_HEAD(&master->fsm_exec_list);
     master->fsm_exec_count = 0;
+    INIT_LIST_HEAD(&master->fsm_ready_list);
 
-    for (slave = master->slaves;
-            slave < master->slaves + master->slave_count;
-            slave++) {
+    ec_master_invalidate_slave_index(master);
+
+    ec_master_publish_slaves(master, 0);
+
+    for (slave = master->slaves; slave < end; slave++) {
         ec_slave_clear(slave);
     }
 
@@ -503,8 +667,281 @@ void ec_master_clear_slaves(ec_master_t *master)
         kfree(master->slaves);
         master->slaves = NULL;
     }
+}
 
-    master->slave_count = 0;
+/*****************************************************************************/
+
+/** Searches the SII cache for a slave's SII image.
+ *
+ * An image matches, if the SII header words (configuration area and
+ * identity) are equal.
+ *
+ * \return Cached image, or NULL if not found.
+ */
+const ec_sii_image_t *ec_master_sii_cache_find(
+        const ec_master_t *master, /**< EtherCAT master. */
+        const uint16_t *header /**< EC_SII_HEADER_WORDS words read from the
+                                 slave. */
+        )
+{
+    const ec_sii_image_t *image;
+
+    list_for_each_entry(image, &master->sii_cache, list) {
+        if (!memcmp(image->words, header,
+                    EC_SII_HEADER_WORDS * sizeof(uint16_t))) {
+            return image;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Stores a slave's SII image in the SII cache.
+ *
+ * An image with the same identity is replaced.
+ */
+void ec_master_sii_cache_store(
+        ec_master_t *master, /**< EtherCAT master. */
+        const uint16_t *words, /**< SII contents. */
+        size_t nwords /**< SII size in words. */
+        )
+{
+    ec_sii_image_t *image, *next;
+    size_t size = nwords * sizeof(uint16_t);
+
+    if (nwords < EC_SII_HEADER_WORDS) {
+        return;
+    }
+
+    list_for_each_entry_safe(image, next, &master->sii_cache, list) {
+        // compare vendor ID, product code, revision and serial number
+        if (!memcmp(image->words + 0x0008, words + 0x0008,
+                    8 * sizeof(uint16_t))) {
+            list_del(&image->list);
+            kfree(image);
+        }
+    }
+
+    if (!(image = kmalloc(sizeof(ec_sii_image_t) + size, GFP_KERNEL))) {
+        EC_MASTER_WARN(master, "Failed to allocate SII cache memory.\n");
+        return;
+    }
+
+    image->nwords = nwords;
+    image->words = (uint16_t *) (image + 1);
+    memcpy(image->words, words, size);
+    list_add_tail(&image->list, &master->sii_cache);
+}
+
+/*****************************************************************************/
+
+/** Clears the SII cache.
+ */
+void ec_master_sii_cache_clear(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_sii_image_t *image, *next;
+
+    list_for_each_entry_safe(image, next, &master->sii_cache, list) {
+        list_del(&image->list);
+        kfree(image);
+    }
+}
+
+/*****************************************************************************/
+
+/** Searches the dictionary cache for the SDO dictionary of a slave type.
+ *
+ * \return Cached dictionary, or NULL if not found.
+ */
+ec_dict_t *ec_master_dict_cache_find(
+        const ec_master_t *master, /**< EtherCAT master. */
+        uint32_t vendor_id, /**< Vendor ID. */
+        uint32_t product_code, /**< Product code. */
+        uint32_t revision_number /**< Revision number. */
+        )
+{
+    ec_dict_t *dict;
+
+    list_for_each_entry(dict, &master->dict_cache, list) {
+        if (dict->vendor_id == vendor_id
+                && dict->product_code == product_code
+                && dict->revision_number == revision_number) {
+            return dict;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Stores an SDO dictionary in the dictionary cache.
+ *
+ * A cached dictionary of the same slave type is replaced. Slaves, that use
+ * the replaced dictionary, keep it until they are deleted.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_master_dict_cache_store(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_dict_t *dict /**< Dictionary to store. */
+        )
+{
+    ec_dict_t *old;
+
+    old = ec_master_dict_cache_find(master, dict->vendor_id,
+            dict->product_code, dict->revision_number);
+    if (old) {
+        if (old->reader) {
+            // a slave is still reading it from the bus
+            return -EBUSY;
+        }
+        list_del_init(&old->list);
+        if (!old->refs) {
+            ec_dict_clear(old);
+            kfree(old);
+        }
+    }
+
+    list_add_tail(&dict->list, &master->dict_cache);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Clears the dictionary cache.
+ *
+ * Dictionaries still used by slaves are freed together with the last slave.
+ */
+void ec_master_dict_cache_clear(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_dict_t *dict, *next;
+
+    list_for_each_entry_safe(dict, next, &master->dict_cache, list) {
+        list_del_init(&dict->list);
+        if (!dict->refs) {
+            ec_dict_clear(dict);
+            kfree(dict);
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Searches the shared SII category data for the given category words.
+ *
+ * \return Matching data, or NULL if not found.
+ */
+ec_sii_data_t *ec_master_find_sii_data(
+        const ec_master_t *master, /**< EtherCAT master. */
+        const uint16_t *words, /**< Category words of a slave. */
+        size_t nwords /**< Number of category words. */
+        )
+{
+    ec_sii_data_t *data;
+    uint32_t hash = ec_sii_data_hash(words, nwords);
+
+    list_for_each_entry(data, &master->sii_data, list) {
+        if (data->hash == hash && data->nwords == nwords
+                && !memcmp(data->words, words, nwords * sizeof(uint16_t))) {
+            return data;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Shares completely parsed SII category data with subsequent slaves.
+ *
+ * The data are removed from the list, when the last slave releases them.
+ */
+void ec_master_share_sii_data(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_sii_data_t *data /**< SII category data. */
+        )
+{
+    list_add_tail(&data->list, &master->sii_data);
+}
+
+/*****************************************************************************/
+
+/** Removes the slaves at the end of the slave list.
+ *
+ * Used, if slaves at the end of the bus disappeared, while the remaining
+ * slaves are unchanged. The remaining slaves are not touched, so they can
+ * keep their state and exchange process data.
+ */
+void ec_master_truncate_slaves(
+        ec_master_t *master, /**< EtherCAT master. */
+        unsigned int slave_count /**< Number of slaves to keep. */
+        )
+{
+    ec_slave_t *slave, *end = master->slaves + master->slave_count;
+    unsigned int i;
+#ifdef EC_EOE
+    ec_eoe_t *eoe, *next_eoe;
+#endif
+
+    if (slave_count >= master->slave_count) {
+        return;
+    }
+
+#ifdef EC_EOE
+    ec_master_eoe_stop(master);
+    list_for_each_entry_safe(eoe, next_eoe, &master->eoe_handlers, list) {
+        if (eoe->slave < master->slaves + slave_count) {
+            continue;
+        }
+        list_del(&eoe->list);
+        ec_master_flush_datagram_ext(master, &eoe->datagram);
+        ec_master_flush_datagram_ext(master, &eoe->rx_datagram);
+        ec_eoe_clear(eoe);
+        ec_master_eoe_deactivate(master, eoe);
+        kfree(eoe);
+    }
+#endif
+
+    ec_master_publish_slaves(master, slave_count);
+
+    for (slave = master->slaves + slave_count; slave < end; slave++) {
+        if (!list_empty(&slave->fsm.list)) {
+            list_del_init(&slave->fsm.list);
+            master->fsm_exec_count--;
+        }
+        list_del_init(&slave->fsm.ready);
+        ec_slave_clear(slave);
+    }
+
+    if (master->fsm_slave >= master->slaves + slave_count) {
+        master->fsm_slave = master->slaves;
+    }
+
+    // the ports to the removed slaves are closed now
+    for (slave = master->slaves; slave < master->slaves + slave_count;
+            slave++) {
+        for (i = 0; i < EC_MAX_PORTS; i++) {
+            if (slave->ports[i].next_slave >= master->slaves + slave_count) {
+                slave->ports[i].next_slave = NULL;
+                slave->ports[i].link.link_up = 0;
+                slave->ports[i].link.loop_closed = 1;
+            }
+        }
+    }
+
+    ec_master_calc_dc(master);
+    ec_master_index_slaves(master);
+
+#ifdef EC_EOE
+    ec_master_eoe_start(master);
+#endif
 }
 
 /*****************************************************************************/
@@ -515,6 +952,8 @@ void ec_master_clear_domains(ec_master_t *master)
 {
     ec_domain_t *domain, *next;
 
+    ecrt_master_select_dc_domain(master, NULL);
+
     list_for_each_entry_safe(domain, next, &master->domains, list) {
         list_del(&domain->list);
         ec_domain_clear(domain);
@@ -566,6 +1005,37 @@ void ec_master_internal_receive_cb(
 
 /*****************************************************************************/
 
+/** Creates and wakes up a master thread.
+ *
+ * The thread is bound to the CPU given by the thread_cpu module parameter,
+ * if any.
+ *
+ * \return Thread, or an error pointer.
+ */
+static struct task_struct *ec_master_run_thread(
+        ec_master_t *master, /**< EtherCAT master */
+        int (*thread_func)(void *), /**< thread function to start */
+        const char *name /**< Thread name. */
+        )
+{
+    struct task_struct *thread;
+
+    thread = kthread_create_on_node(thread_func, master,
+            ec_master_node(master), "%s", name);
+    if (IS_ERR(thread)) {
+        return thread;
+    }
+
+    if (master->cpu >= 0) {
+        kthread_bind(thread, master->cpu);
+    }
+
+    wake_up_process(thread);
+    return thread;
+}
+
+/*****************************************************************************/
+
 /** Starts the master thread.
  *
  * \retval  0 Success.
@@ -578,7 +1048,7 @@ int ec_master_thread_start(
         )
 {
     EC_MASTER_INFO(master, "Starting %s thread.\n", name);
-    master->thread = kthread_run(thread_func, master, name);
+    master->thread = ec_master_run_thread(master, thread_func, name);
     if (IS_ERR(master->thread)) {
         int err = (int) PTR_ERR(master->thread);
         EC_MASTER_ERR(master, "Failed to start master thread (error %i)!\n",
@@ -609,6 +1079,7 @@ void ec_master_thread_stop(
 
     kthread_stop(master->thread);
     master->thread = NULL;
+    ec_rt_log_flush(&master->rt_log);
     EC_MASTER_INFO(master, "Master thread exited.\n");
 
     if (master->fsm_datagram.state != EC_DATAGRAM_SENT) {
@@ -773,6 +1244,10 @@ void ec_master_leave_operation_phase(
         ecrt_master_deactivate(master); // also clears config
     } else {
         ec_master_clear_config(master);
+        master->timed_cycle_flags = 0;
+        master->cycle_cb = NULL;
+        master->cycle_cb_data = NULL;
+        master->cycle_trigger_ext = NULL;
     }
 
     /* Re-allow scanning for IDLE phase. */
@@ -785,42 +1260,102 @@ void ec_master_leave_operation_phase(
 
 /*****************************************************************************/
 
+/** Adds a datagram to the queued bytes accounting.
+ *
+ * The current payload size is accounted, which may have changed since the
+ * datagram was queued before.
+ */
+static inline void ec_master_account_datagram(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_datagram_t *datagram /**< datagram */
+        )
+{
+    master->queued_bytes += datagram->data_size - datagram->queued_size;
+    datagram->queued_size = datagram->data_size;
+}
+
+/*****************************************************************************/
+
+/** Removes a datagram from the queued bytes accounting.
+ *
+ * Has to be called, when a datagram leaves the EC_DATAGRAM_QUEUED state or
+ * the datagram queue.
+ */
+static inline void ec_master_unaccount_datagram(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_datagram_t *datagram /**< datagram */
+        )
+{
+    master->queued_bytes -= datagram->queued_size;
+    datagram->queued_size = 0;
+}
+
+/*****************************************************************************/
+
 /** Injects external datagrams that fit into the datagram queue.
+ *
+ * All external datagrams share the same injection timeout, so the ring order
+ * is the order of their deadlines. If the oldest pending datagram does not
+ * fit, younger ones that fit may overtake it, as long as it has waited for
+ * less than half of the timeout. After that, nothing is injected until the
+ * queue has drained enough for it. Overtaking datagrams are skipped when the
+ * ring index reaches them, because their state is not EC_DATAGRAM_INIT
+ * anymore.
  */
 void ec_master_inject_external_datagrams(
-        ec_master_t *master /**< EtherCAT master */
+        ec_master_t *master, /**< EtherCAT master */
+        unsigned int *injected, /**< Number of injected datagrams (output). */
+        unsigned int *deferred /**< Number of deferred injections (output).
+                                */
         )
 {
     ec_datagram_t *datagram;
-    size_t queue_size = 0, new_queue_size = 0;
+    ec_device_index_t dev_idx;
+    size_t queue_size, new_queue_size = 0;
+    unsigned int idx, idx_rt, idx_fsm, blocked = 0;
 #if DEBUG_INJECT
     unsigned int datagram_count = 0;
 #endif
 
-    if (master->ext_ring_idx_rt == master->ext_ring_idx_fsm) {
+    /* The acquire pairs with the release in
+     * ec_master_release_external_datagram(), so that the slot contents
+     * written by the FSM side are visible once its index is. */
+    *injected = 0;
+    *deferred = 0;
+
+    idx_rt = master->ext_ring_idx_rt;
+    idx_fsm = smp_load_acquire(&master->ext_ring_idx_fsm);
+
+    if (idx_rt == idx_fsm) {
         // nothing to inject
         return;
     }
 
-    list_for_each_entry(datagram, &master->datagram_queue, queue) {
-        if (datagram->state == EC_DATAGRAM_QUEUED) {
-            queue_size += datagram->data_size;
+    /* A datagram cleared while being queued leaves its bytes accounted, so
+     * resynchronize whenever the queues are empty. */
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        if (!list_empty(&master->devices[dev_idx].datagram_queue)) {
+            break;
         }
     }
+    if (dev_idx == ec_master_num_devices(master)) {
+        master->queued_bytes = 0;
+    }
+    queue_size = master->queued_bytes;
 
 #if DEBUG_INJECT
     EC_MASTER_DBG(master, 1, "Injecting datagrams, queue_size=%zu\n",
             queue_size);
 #endif
 
-    while (master->ext_ring_idx_rt != master->ext_ring_idx_fsm) {
-        datagram = &master->ext_datagram_ring[master->ext_ring_idx_rt];
+    for (idx = idx_rt; idx != idx_fsm;
+            idx = (idx + 1) % master->ext_ring_size) {
+        datagram = &master->ext_datagram_ring[idx];
 
         if (datagram->state != EC_DATAGRAM_INIT) {
             // skip datagram
-            master->ext_ring_idx_rt =
-                (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
-            continue;
+            goto next;
         }
 
         new_queue_size = queue_size + datagram->data_size;
@@ -837,6 +1372,7 @@ void ec_master_inject_external_datagrams(
             datagram->jiffies_sent = 0;
             ec_master_queue_datagram(master, datagram);
             queue_size = new_queue_size;
+            (*injected)++;
         }
         else if (datagram->data_size > master->max_queue_size) {
             datagram->state = EC_DATAGRAM_ERROR;
@@ -871,24 +1407,44 @@ void ec_master_inject_external_datagrams(
                 time_us = (unsigned int)
                     ((jiffies - datagram->jiffies_sent) * 1000000 / HZ);
 #endif
-                EC_MASTER_ERR(master, "Timeout %u us: Injecting"
-                        " external datagram %s size=%zu,"
-                        " max_queue_size=%zu\n", time_us, datagram->name,
-                        datagram->data_size, master->max_queue_size);
+                EC_MASTER_RT_ERR(master, EC_RT_LOG_INJECTION,
+                        "Timeout %u us: Injecting external datagram %s"
+                        " size=%zu, max_queue_size=%zu\n", time_us,
+                        datagram->name, datagram->data_size,
+                        master->max_queue_size);
 #endif
             }
             else {
+                master->traffic_classes[datagram->traffic_class].held++;
+                (*deferred)++;
 #if DEBUG_INJECT
                 EC_MASTER_DBG(master, 1, "Deferred injecting"
                         " external datagram %s size=%u, queue_size=%u\n",
                         datagram->name, datagram->data_size, queue_size);
 #endif
-                break;
+                if (!blocked) {
+                    // only let younger datagrams overtake for a while
+#ifdef EC_HAVE_CYCLES
+                    if (cycles_now - datagram->cycles_sent
+                            > ext_injection_timeout_cycles / 2)
+#else
+                    if (jiffies - datagram->jiffies_sent
+                            > ext_injection_timeout_jiffies / 2)
+#endif
+                    {
+                        break;
+                    }
+                    blocked = 1;
+                }
+                continue;
             }
         }
 
-        master->ext_ring_idx_rt =
-            (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
+next:
+        if (!blocked) {
+            idx_rt = (idx + 1) % master->ext_ring_size;
+            smp_store_release(&master->ext_ring_idx_rt, idx_rt);
+        }
     }
 
 #if DEBUG_INJECT
@@ -906,15 +1462,57 @@ void ec_master_set_send_interval(
         unsigned int send_interval /**< Send interval */
         )
 {
+    unsigned int budget = send_interval * 1000;
+
+    // the last frame has to be back before the next send
+    if (budget > 2 * master->bus_delay) {
+        budget -= master->bus_delay;
+    } else {
+        budget /= 2;
+    }
+
     master->send_interval = send_interval;
-    master->max_queue_size =
-        (send_interval * 1000) / EC_BYTE_TRANSMISSION_TIME_NS;
+    master->max_queue_size = budget / EC_BYTE_TRANSMISSION_TIME_NS;
     master->max_queue_size -= master->max_queue_size / 10;
 }
 
 /*****************************************************************************/
 
+/** Updates the bus delay with a measured frame round trip time.
+ *
+ * The round trip time is modelled as the transmission time of the frame
+ * plus a delay, that does not depend on the frame size. The delay is
+ * smoothed over several frames and reduces the datagram queue budget.
+ */
+void ec_master_update_bus_delay(
+        ec_master_t *master, /**< EtherCAT master */
+        u32 round_trip_time, /**< Hardware round trip time in ns. */
+        size_t frame_size /**< Size of the frame in byte. */
+        )
+{
+    u32 transmission = frame_size * EC_BYTE_TRANSMISSION_TIME_NS;
+    u32 delay = master->bus_delay;
+    s32 sample;
+
+    sample = round_trip_time > transmission ?
+        round_trip_time - transmission : 0;
+    delay = (s32) delay + (sample - (s32) delay) / 8;
+
+    if (delay != master->bus_delay) {
+        master->bus_delay = delay;
+        ec_master_set_send_interval(master, master->send_interval);
+    }
+}
+
+/*****************************************************************************/
+
 /** Searches for a free datagram in the external datagram ring.
+ *
+ * The external datagram ring is a single-producer/single-consumer ring: The
+ * FSM side (master thread) fills the slot at \a ext_ring_idx_fsm and
+ * publishes it with ec_master_release_external_datagram(), the RT side
+ * consumes slots in ec_master_inject_external_datagrams(). Neither side
+ * takes a lock.
  *
  * \return Next free datagram, or NULL.
  */
@@ -922,11 +1520,14 @@ ec_datagram_t *ec_master_get_external_datagram(
         ec_master_t *master /**< EtherCAT master */
         )
 {
-    if ((master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE !=
-            master->ext_ring_idx_rt) {
-        ec_datagram_t *datagram =
-            &master->ext_datagram_ring[master->ext_ring_idx_fsm];
-        return datagram;
+    unsigned int idx_fsm = master->ext_ring_idx_fsm;
+
+    /* The acquire pairs with the release in
+     * ec_master_inject_external_datagrams(), so that the slot is only
+     * reused after the RT side has finished with it. */
+    if ((idx_fsm + 1) % master->ext_ring_size !=
+            smp_load_acquire(&master->ext_ring_idx_rt)) {
+        return &master->ext_datagram_ring[idx_fsm];
     }
     else {
         return NULL;
@@ -935,6 +1536,19 @@ ec_datagram_t *ec_master_get_external_datagram(
 
 /*****************************************************************************/
 
+/** Hands the datagram obtained by ec_master_get_external_datagram() over to
+ * the RT side.
+ */
+static void ec_master_release_external_datagram(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    smp_store_release(&master->ext_ring_idx_fsm,
+            (master->ext_ring_idx_fsm + 1) % master->ext_ring_size);
+}
+
+/*****************************************************************************/
+
 /** Places a datagram in the datagram queue.
  */
 void ec_master_queue_datagram(
@@ -942,107 +1556,433 @@ void ec_master_queue_datagram(
         ec_datagram_t *datagram /**< datagram */
         )
 {
-    ec_datagram_t *queued_datagram;
+    struct list_head *queue =
+        &master->devices[datagram->device_index].datagram_queue;
 
     /* It is possible, that a datagram in the queue is re-initialized with the
      * ec_datagram_<type>() methods and then shall be queued with this method.
      * In that case, the state is already reset to EC_DATAGRAM_INIT. Check if
      * the datagram is queued to avoid duplicate queuing (which results in an
      * infinite loop!). Set the state to EC_DATAGRAM_QUEUED again, probably
-     * causing an unmatched datagram. */
-    list_for_each_entry(queued_datagram, &master->datagram_queue, queue) {
-        if (queued_datagram == datagram) {
-            datagram->skip_count++;
+     * causing an unmatched datagram.
+     *
+     * The queue list head is re-initialized every time a datagram is removed
+     * from the queue, so it tells about queue membership in constant time.
+     * The device index may have changed in the meantime, so the datagram is
+     * moved to the queue of its current device. */
+    if (!list_empty(&datagram->queue)) {
+        datagram->skip_count++;
+        datagram->stats.skips++;
 #ifdef EC_RT_SYSLOG
-            EC_MASTER_DBG(master, 1,
-                    "Datagram %p already queued (skipping).\n", datagram);
+        EC_MASTER_RT_DBG(master, 1, EC_RT_LOG_DATAGRAM,
+                "Datagram %p already queued (skipping).\n", datagram);
 #endif
-            datagram->state = EC_DATAGRAM_QUEUED;
-            return;
-        }
+        list_move_tail(&datagram->queue, queue);
+        ec_master_account_datagram(master, datagram);
+        datagram->state = EC_DATAGRAM_QUEUED;
+        return;
     }
 
-    list_add_tail(&datagram->queue, &master->datagram_queue);
+    list_add_tail(&datagram->queue, queue);
+    ec_master_account_datagram(master, datagram);
     datagram->state = EC_DATAGRAM_QUEUED;
+    trace_ec_datagram_queue(master->index, datagram->device_index, datagram);
 }
 
 /*****************************************************************************/
 
 /** Places a datagram in the non-application datagram queue.
+ *
+ * The queue is a lock-free single-producer/single-consumer ring. The only
+ * producer is the EoE thread, the consumer is ec_master_take_ext_datagrams().
+ *
+ * \retval 0 Success.
+ * \retval -ENOBUFS The queue is full. Try again later.
  */
-void ec_master_queue_datagram_ext(
+int ec_master_queue_datagram_ext(
         ec_master_t *master, /**< EtherCAT master */
         ec_datagram_t *datagram /**< datagram */
         )
 {
-    down(&master->ext_queue_sem);
-    list_add_tail(&datagram->queue, &master->ext_datagram_queue);
-    up(&master->ext_queue_sem);
+    unsigned int idx = master->ext_queue_idx_eoe;
+    unsigned int next = (idx + 1) % EC_EXT_QUEUE_SIZE;
+
+    if (next == smp_load_acquire(&master->ext_queue_idx_rt)) {
+        return -ENOBUFS;
+    }
+
+    master->ext_datagram_queue[idx] = datagram;
+    smp_store_release(&master->ext_queue_idx_eoe, next);
+    return 0;
 }
 
 /*****************************************************************************/
 
-/** Sends the datagrams in the queue for a certain device.
+/** Removes a datagram from the non-application datagram queue.
  *
+ * Has to be called before a queued datagram is cleared. The slots are
+ * exchanged atomically, so that the consumer either takes the datagram
+ * before, or finds an empty slot.
  */
-void ec_master_send_datagrams(
+void ec_master_flush_datagram_ext(
         ec_master_t *master, /**< EtherCAT master */
-        ec_device_index_t device_index /**< Device index. */
+        const ec_datagram_t *datagram /**< datagram */
         )
 {
-    ec_datagram_t *datagram, *next;
-    size_t datagram_size;
-    uint8_t *frame_data, *cur_data = NULL;
-    void *follows_word;
+    unsigned int i;
+
+    for (i = 0; i < EC_EXT_QUEUE_SIZE; i++) {
+        if (master->ext_datagram_queue[i] == datagram) {
+            (void) cmpxchg(&master->ext_datagram_queue[i],
+                    (ec_datagram_t *) datagram, NULL);
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Precomputes the frame templates for the cyclic domain datagrams.
+ *
+ * For each device, the datagrams of all domains (in the order they are
+ * usually queued) that fit into the first frame are preset in the transmit
+ * socket buffers.
+ */
+void ec_master_build_frame_templates(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    const ec_datagram_t *datagrams[EC_FRAME_TEMPLATE_SIZE];
+    ec_device_index_t dev_idx;
+    ec_domain_t *domain;
+    ec_datagram_pair_t *pair;
+    unsigned int count;
+    size_t frame_size, datagram_size;
+
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        count = 0;
+        frame_size = EC_FRAME_HEADER_SIZE;
+
+        list_for_each_entry(domain, &master->domains, list) {
+            list_for_each_entry(pair, &domain->datagram_pairs, list) {
+                const ec_datagram_t *datagram = &pair->datagrams[dev_idx];
+
+                if (pair->pipeline_slot) {
+                    continue; // only the first pipeline slot is templated
+                }
+
+                if (pair->input_phase) {
+                    continue; // sent later, see ecrt_domain_queue_inputs()
+                }
+
+                if (datagram == master->devices[dev_idx].tx_pinned_datagram) {
+                    continue; // sent in its own frame
+                }
+
+                datagram_size = EC_DATAGRAM_HEADER_SIZE
+                    + datagram->data_size + EC_DATAGRAM_FOOTER_SIZE;
+                if (count == EC_FRAME_TEMPLATE_SIZE
+                        || frame_size + datagram_size > ETH_DATA_LEN) {
+                    goto set_template;
+                }
+                datagrams[count++] = datagram;
+                frame_size += datagram_size;
+            }
+        }
+
+set_template:
+        EC_MASTER_DBG(master, 1, "Frame template for %s device"
+                " has %u datagrams.\n", ec_device_names[dev_idx != 0],
+                count);
+        ec_device_set_frame_template(&master->devices[dev_idx],
+                datagrams, count);
+    }
+}
+
+/*****************************************************************************/
+
+/** Removes the frame templates from all devices.
+ */
+void ec_master_clear_frame_templates(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    ec_device_index_t dev_idx;
+
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ec_device_set_frame_template(&master->devices[dev_idx], NULL, 0);
+    }
+}
+
+/*****************************************************************************/
+
+/** Assigns the next free index to a datagram that is about to be sent.
+ *
+ * The datagram is registered in the table of sent datagrams, so that
+ * ec_master_receive_datagrams() can match it. Indices of datagrams in
+ * flight are never reused, so that a late frame can not match a newer
+ * datagram. Indices of timed out datagrams are only reused, if no other
+ * index is free, because a late response to them may still arrive.
+ *
+ * \return Zero on success, -EBUSY if all indices are in flight.
+ */
+static int ec_master_assign_index(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_datagram_t *datagram /**< Datagram to send. */
+        )
+{
+    ec_datagram_t **slot, **timed_out = NULL;
+    uint8_t index = master->datagram_index;
+    unsigned int i;
+
+    ec_datagram_release_slot(datagram);
+
+    for (i = 0; i < EC_DATAGRAM_INDEX_COUNT; i++, index++) {
+        slot = &master->sent_datagrams[index];
+        if (!*slot) {
+            break;
+        }
+        if (!timed_out && (*slot)->state != EC_DATAGRAM_SENT) {
+            timed_out = slot;
+        }
+    }
+
+    if (i == EC_DATAGRAM_INDEX_COUNT) {
+        if (!timed_out) {
+            return -EBUSY;
+        }
+        // late responses to the former datagram are unmatched from now on
+        slot = timed_out;
+        (*slot)->sent_slot = NULL;
+    }
+
+    datagram->index = slot - master->sent_datagrams;
+    master->datagram_index = datagram->index + 1;
+    *slot = datagram;
+    datagram->sent_slot = slot;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Appends a sent datagram to the device's list of datagrams waiting for
+ * reception.
+ *
+ * The list is kept sorted by the timeout deadline. As most datagrams share
+ * the same timeout, the insertion position is searched from the tail.
+ */
+static void ec_master_add_sent_datagram(
+        ec_device_t *device, /**< EtherCAT device. */
+        ec_datagram_t *datagram, /**< Sent datagram. */
+        ktime_t now /**< Sending time. */
+        )
+{
+    ec_datagram_t *pos;
+
+    datagram->deadline = ktime_add(now, datagram->timeout);
+
+    list_for_each_entry_reverse(pos, &device->sent_queue, sent) {
+        if (ktime_to_ns(pos->deadline) <= ktime_to_ns(datagram->deadline)) {
+            break;
+        }
+    }
+
+    list_add(&datagram->sent, &pos->sent);
+}
+
+/*****************************************************************************/
+
+/** Sorts the traffic classes by their priority.
+ *
+ * Classes with the same priority keep the order of their definition.
+ */
+static void ec_master_sort_traffic_classes(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    unsigned int i, j;
+    ec_traffic_class_t tc;
+
+    for (i = 0; i < EC_TC_COUNT; i++) {
+        tc = (ec_traffic_class_t) i;
+        for (j = i; j > 0 && master->traffic_classes[tc].priority
+                < master->traffic_classes[master->tc_order[j - 1]].priority;
+                j--) {
+            master->tc_order[j] = master->tc_order[j - 1];
+        }
+        master->tc_order[j] = tc;
+    }
+}
+
+/*****************************************************************************/
+
+/** State of sending the datagram queue of a device.
+ *
+ * Allows to send the frames of several devices interleaved, see
+ * ec_master_send().
+ */
+typedef struct {
+    size_t tc_left[EC_TC_COUNT]; /**< Bytes left in the budget of each
+                                   traffic class. */
+    unsigned int frame_count; /**< Number of frames sent. */
+    unsigned int more; /**< More datagrams waiting for a frame. */
 #ifdef EC_HAVE_CYCLES
-    cycles_t cycles_start, cycles_sent, cycles_end;
+    cycles_t cycles_start; /**< Start of sending. */
 #endif
-    unsigned long jiffies_sent;
-    unsigned int frame_count, more_datagrams_waiting;
-    struct list_head sent_datagrams;
+} ec_master_tx_state_t;
+
+/*****************************************************************************/
+
+/** Starts sending the datagrams in the queue for a certain device.
+ *
+ * Sends the pinned datagram, if queued. The other datagrams are sent with
+ * ec_master_send_frame().
+ */
+static void ec_master_send_start(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index, /**< Device index. */
+        ec_master_tx_state_t *tx /**< Sending state. */
+        )
+{
+    ec_device_t *device = &master->devices[device_index];
+    ec_datagram_t *datagram;
+    unsigned int tc_pos;
 
 #ifdef EC_HAVE_CYCLES
-    cycles_start = get_cycles();
+    tx->cycles_start = get_cycles();
 #endif
-    frame_count = 0;
-    INIT_LIST_HEAD(&sent_datagrams);
+    tx->frame_count = 0;
+    tx->more = 1;
+
+    for (tc_pos = 0; tc_pos < EC_TC_COUNT; tc_pos++) {
+        size_t budget = master->traffic_classes[tc_pos].budget;
+        tx->tc_left[tc_pos] = budget ? budget : (size_t) -1;
+    }
 
     EC_MASTER_DBG(master, 2, "%s(device_index = %u)\n",
             __func__, device_index);
 
-    do {
-        frame_data = NULL;
-        follows_word = NULL;
-        more_datagrams_waiting = 0;
-
-        // fill current frame with datagrams
-        list_for_each_entry(datagram, &master->datagram_queue, queue) {
-            if (datagram->state != EC_DATAGRAM_QUEUED ||
-                    datagram->device_index != device_index) {
+    // the zero-copy datagram already lives in its own frame
+    datagram = device->tx_pinned_datagram;
+    if (datagram && datagram->state == EC_DATAGRAM_QUEUED
+            && !ec_master_assign_index(master, datagram)) {
+        ec_device_send_pinned(device);
+        ec_master_unaccount_datagram(master, datagram);
+        datagram->state = EC_DATAGRAM_SENT;
+#ifdef EC_HAVE_CYCLES
+        datagram->cycles_sent = get_cycles();
+#endif
+        datagram->jiffies_sent = jiffies;
+        datagram->tx_slot = device->tx_ring_size;
+        list_del(&datagram->sent);
+        ec_master_add_sent_datagram(device, datagram, ktime_get());
+        master->traffic_classes[datagram->traffic_class].datagrams++;
+        master->traffic_classes[datagram->traffic_class].bytes +=
+            EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+            + EC_DATAGRAM_FOOTER_SIZE;
+        tx->frame_count++;
+    }
+}
+
+/*****************************************************************************/
+
+/** Sends the next frame with datagrams from the queue of a certain device.
+ *
+ * The queued datagrams are put into the frame by traffic class, in the
+ * order of the class priorities, as long as the class' byte budget allows.
+ * \a tx->more is cleared, if no datagrams are left to send.
+ */
+static void ec_master_send_frame(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index, /**< Device index. */
+        ec_master_tx_state_t *tx /**< Sending state. */
+        )
+{
+    ec_device_t *device = &master->devices[device_index];
+    ec_datagram_t *datagram, *next;
+    size_t datagram_size;
+    uint8_t *frame_data = NULL, *cur_data = NULL;
+    void *follows_word = NULL;
+    unsigned int template_pos = 0, *template_valid = NULL;
+    unsigned int frame_pos = 0, plan_count = 0;
+    size_t plan_size = 0;
+#ifdef EC_HAVE_CYCLES
+    cycles_t cycles_sent;
+#endif
+    unsigned long jiffies_sent;
+    ktime_t ktime_sent;
+    unsigned int frame_datagrams, tc_pos;
+    LIST_HEAD(sent_datagrams);
+    ec_traffic_class_t tc;
+
+    tx->more = 0;
+
+    // fill the frame with datagrams, class by class
+    for (tc_pos = 0; tc_pos < EC_TC_COUNT; tc_pos++) {
+        tc = master->tc_order[tc_pos];
+        list_for_each_entry(datagram, &device->datagram_queue, queue) {
+            if (datagram->state != EC_DATAGRAM_QUEUED
+                    || datagram->traffic_class != tc) {
                 continue;
             }
 
+            datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+                + EC_DATAGRAM_FOOTER_SIZE;
+            if (datagram_size > tx->tc_left[tc]) {
+                continue; // budget exhausted, leave it for the next cycle
+            }
+
             if (!frame_data) {
                 // fetch pointer to transmit socket buffer
-                frame_data =
-                    ec_device_tx_data(&master->devices[device_index]);
+                frame_data = ec_device_tx_data(device);
+                if (unlikely(!frame_data)) {
+                    // leave the remaining datagrams for the next cycle
+                    EC_MASTER_DBG(master, 1, "All transmit buffers of %s"
+                            " device in flight.\n",
+                            ec_device_names[device_index != 0]);
+                    tx->more = 0;
+                    goto frame_filled;
+                }
                 cur_data = frame_data + EC_FRAME_HEADER_SIZE;
+                template_valid =
+                    &device->tx_template_valid[device->tx_ring_index];
             }
 
             // does the current datagram fit in the frame?
-            datagram_size = EC_DATAGRAM_HEADER_SIZE + datagram->data_size
-                + EC_DATAGRAM_FOOTER_SIZE;
             if (cur_data - frame_data + datagram_size > ETH_DATA_LEN) {
-                more_datagrams_waiting = 1;
-                break;
+                /* Leave it for the next frame, but continue filling the
+                 * current frame with smaller datagrams (first fit). */
+                tx->more = 1;
+                if (ETH_DATA_LEN - (cur_data - frame_data)
+                        < EC_DATAGRAM_HEADER_SIZE
+                        + EC_DATAGRAM_FOOTER_SIZE) {
+                    goto frame_filled; // frame is full
+                }
+                continue;
             }
 
-            list_add_tail(&datagram->sent, &sent_datagrams);
-            datagram->index = master->datagram_index++;
+            if (unlikely(ec_master_assign_index(master, datagram))) {
+                // leave the remaining datagrams for the next cycle
+                master->stats.index_deferred++;
+                tx->more = 0;
+                goto frame_filled;
+            }
+            list_move_tail(&datagram->sent, &sent_datagrams);
+            tx->tc_left[tc] -= datagram_size;
 
             EC_MASTER_DBG(master, 2, "Adding datagram 0x%02X\n",
                     datagram->index);
 
+            // leading template datagrams form the receive plan
+            if (plan_count == frame_pos
+                    && plan_count < device->tx_template_count
+                    && device->tx_template[plan_count] == datagram) {
+                plan_count++;
+                plan_size += datagram_size;
+            }
+            frame_pos++;
+
             // set "datagram following" flag in previous datagram
             if (follows_word) {
                 EC_WRITE_U16(follows_word,
@@ -1050,132 +1990,405 @@ void ec_master_send_datagrams(
             }
 
             // EtherCAT datagram header
-            EC_WRITE_U8 (cur_data, datagram->type);
-            EC_WRITE_U8 (cur_data + 1, datagram->index);
-            memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
-            EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
-            EC_WRITE_U16(cur_data + 8, 0x0000);
+            if (template_pos < *template_valid
+                    && device->tx_template[template_pos] == datagram) {
+                // header preset by the frame template
+                EC_WRITE_U8 (cur_data + 1, datagram->index);
+                EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+                template_pos++;
+            }
+            else {
+                EC_WRITE_U8 (cur_data, datagram->type);
+                EC_WRITE_U8 (cur_data + 1, datagram->index);
+                memcpy(cur_data + 2, datagram->address, EC_ADDR_LEN);
+                EC_WRITE_U16(cur_data + 6, datagram->data_size & 0x7FF);
+                EC_WRITE_U16(cur_data + 8, 0x0000);
+
+                if (template_pos <= *template_valid
+                        && template_pos < device->tx_template_count
+                        && device->tx_template[template_pos]
+                        == datagram) {
+                    // template header restored
+                    *template_valid = ++template_pos;
+                }
+                else if (template_pos <= EC_FRAME_TEMPLATE_SIZE) {
+                    // template headers overwritten from here on
+                    if (template_pos < *template_valid) {
+                        *template_valid = template_pos;
+                    }
+                    template_pos = EC_FRAME_TEMPLATE_SIZE + 1;
+                }
+            }
             follows_word = cur_data + 6;
             cur_data += EC_DATAGRAM_HEADER_SIZE;
 
             // EtherCAT datagram data
-            memcpy(cur_data, datagram->data, datagram->data_size);
+            memcpy(cur_data, datagram->tx_data ? datagram->tx_data
+                    : datagram->data, datagram->data_size);
             cur_data += datagram->data_size;
 
             // EtherCAT datagram footer
             EC_WRITE_U16(cur_data, 0x0000); // reset working counter
             cur_data += EC_DATAGRAM_FOOTER_SIZE;
         }
+    }
 
-        if (list_empty(&sent_datagrams)) {
-            EC_MASTER_DBG(master, 2, "nothing to send.\n");
-            break;
-        }
+frame_filled:
+    if (list_empty(&sent_datagrams)) {
+        EC_MASTER_DBG(master, 2, "nothing to send.\n");
+        tx->more = 0;
+        return;
+    }
 
-        // EtherCAT frame header
-        EC_WRITE_U16(frame_data, ((cur_data - frame_data
-                        - EC_FRAME_HEADER_SIZE) & 0x7FF) | 0x1000);
+    // EtherCAT frame header
+    EC_WRITE_U16(frame_data, ((cur_data - frame_data
+                    - EC_FRAME_HEADER_SIZE) & 0x7FF) | 0x1000);
 
-        // pad frame
-        while (cur_data - frame_data < ETH_ZLEN - ETH_HLEN)
-            EC_WRITE_U8(cur_data++, 0x00);
+    // pad frame
+    if (cur_data - frame_data < ETH_ZLEN - ETH_HLEN
+            && template_pos < *template_valid) {
+        // padding overwrites the following template headers
+        *template_valid = template_pos;
+    }
+    while (cur_data - frame_data < ETH_ZLEN - ETH_HLEN)
+        EC_WRITE_U8(cur_data++, 0x00);
+
+    EC_MASTER_DBG(master, 2, "frame size: %zu\n", cur_data - frame_data);
 
-        EC_MASTER_DBG(master, 2, "frame size: %zu\n", cur_data - frame_data);
+    device->rx_plan[device->tx_ring_index].count = plan_count;
+    device->rx_plan[device->tx_ring_index].size = plan_size;
 
-        // send frame
-        ec_device_send(&master->devices[device_index],
-                cur_data - frame_data);
+    // send frame
+    ec_device_send(device, cur_data - frame_data);
 #ifdef EC_HAVE_CYCLES
-        cycles_sent = get_cycles();
+    cycles_sent = get_cycles();
 #endif
-        jiffies_sent = jiffies;
+    jiffies_sent = jiffies;
+    ktime_sent = ktime_get();
 
-        // set datagram states and sending timestamps
-        list_for_each_entry_safe(datagram, next, &sent_datagrams, sent) {
-            datagram->state = EC_DATAGRAM_SENT;
+    // set datagram states and sending timestamps and wait for reception
+    frame_datagrams = 0;
+    list_for_each_entry_safe(datagram, next, &sent_datagrams, sent) {
+        ec_traffic_class_info_t *info =
+            &master->traffic_classes[datagram->traffic_class];
+
+        ec_master_unaccount_datagram(master, datagram);
+        datagram->state = EC_DATAGRAM_SENT;
 #ifdef EC_HAVE_CYCLES
-            datagram->cycles_sent = cycles_sent;
+        datagram->cycles_sent = cycles_sent;
 #endif
-            datagram->jiffies_sent = jiffies_sent;
-            list_del_init(&datagram->sent); // empty list of sent datagrams
-        }
+        datagram->jiffies_sent = jiffies_sent;
+        datagram->tx_slot = device->tx_ring_index;
+        list_del(&datagram->sent);
+        ec_master_add_sent_datagram(device, datagram, ktime_sent);
+        info->datagrams++;
+        info->bytes += EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+            + EC_DATAGRAM_FOOTER_SIZE;
+        frame_datagrams++;
+    }
+
+    trace_ec_frame_send(master->index, device_index,
+            cur_data - frame_data, frame_datagrams);
+    tx->frame_count++;
+}
+
+/*****************************************************************************/
+
+/** Finishes sending the datagrams in the queue for a certain device.
+ */
+static void ec_master_send_finish(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_index_t device_index, /**< Device index. */
+        ec_master_tx_state_t *tx /**< Sending state. */
+        )
+{
+    ec_device_t *device = &master->devices[device_index];
+    ec_datagram_t *datagram;
+#ifdef EC_HAVE_CYCLES
+    cycles_t cycles_end;
+#endif
+
+    // hand the last frame to the driver, so that it notifies the hardware
+    ec_device_flush(device);
 
-        frame_count++;
+    // count the datagrams left for the next cycle
+    list_for_each_entry(datagram, &device->datagram_queue, queue) {
+        if (datagram->state == EC_DATAGRAM_QUEUED) {
+            master->traffic_classes[datagram->traffic_class].deferred++;
+        }
     }
-    while (more_datagrams_waiting);
 
 #ifdef EC_HAVE_CYCLES
     if (unlikely(master->debug_level > 1)) {
         cycles_end = get_cycles();
         EC_MASTER_DBG(master, 0, "%s()"
-                " sent %u frames in %uus.\n", __func__, frame_count,
-               (unsigned int) (cycles_end - cycles_start) * 1000 / cpu_khz);
+                " sent %u frames in %uus.\n", __func__, tx->frame_count,
+               (unsigned int) (cycles_end - tx->cycles_start) * 1000
+               / cpu_khz);
     }
 #endif
 }
 
 /*****************************************************************************/
 
-/** Processes a received frame.
+/** Checks, if an unmatched datagram is the late response to a datagram that
+ * timed out before.
  *
- * This function is called by the network driver for every received frame.
+ * Late responses are counted separately from unmatched datagrams, together
+ * with the time they arrived after the missed deadline.
  *
- * \return 0 in case of success, else < 0
+ * \return Non-zero, if the datagram arrived late.
  */
-void ec_master_receive_datagrams(
+static int ec_master_match_late_datagram(
         ec_master_t *master, /**< EtherCAT master */
-        ec_device_t *device, /**< EtherCAT device */
-        const uint8_t *frame_data, /**< frame data */
-        size_t size /**< size of the received data */
+        uint8_t type, /**< Datagram type. */
+        uint8_t index, /**< Datagram index. */
+        size_t data_size /**< Data size. */
         )
 {
-    size_t frame_size, data_size;
-    uint8_t datagram_type, datagram_index;
-    unsigned int cmd_follows, matched;
-    const uint8_t *cur_data;
-    ec_datagram_t *datagram;
+    ec_datagram_t *datagram = master->sent_datagrams[index];
+    unsigned int dev_idx;
+    ktime_t deadline;
+    u32 lateness;
 
-    if (unlikely(size < EC_FRAME_HEADER_SIZE)) {
-        if (master->debug_level || FORCE_OUTPUT_CORRUPTED) {
-            EC_MASTER_DBG(master, 0, "Corrupted frame received"
-                    " on %s (size %zu < %u byte):\n",
-                    device->dev->name, size, EC_FRAME_HEADER_SIZE);
-            ec_print_data(frame_data, size);
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        if (ec_device_timeout_history_match(&master->devices[dev_idx],
+                    index, type, data_size, &deadline)) {
+            break;
         }
-        master->stats.corrupted++;
-#ifdef EC_RT_SYSLOG
-        ec_master_output_stats(master);
-#endif
-        return;
     }
 
-    cur_data = frame_data;
+    if (dev_idx == ec_master_num_devices(master)) {
+        return 0;
+    }
 
-    // check length of entire frame
-    frame_size = EC_READ_U16(cur_data) & 0x07FF;
-    cur_data += EC_FRAME_HEADER_SIZE;
+    lateness = (u32) ktime_us_delta(ktime_get(), deadline);
+    master->stats.late++;
+    if (lateness > master->stats.late_max) {
+        master->stats.late_max = lateness;
+    }
 
-    if (unlikely(frame_size > size)) {
-        if (master->debug_level || FORCE_OUTPUT_CORRUPTED) {
-            EC_MASTER_DBG(master, 0, "Corrupted frame received"
-                    " on %s (invalid frame size %zu for "
-                    "received size %zu):\n", device->dev->name,
-                    frame_size, size);
-            ec_print_data(frame_data, size);
+    // account it to the datagram, if it still owns the index
+    if (datagram && datagram->state != EC_DATAGRAM_SENT
+            && datagram->type == type && datagram->data_size == data_size) {
+        datagram->stats.late++;
+        if (lateness > datagram->stats.late_max) {
+            datagram->stats.late_max = lateness;
         }
-        master->stats.corrupted++;
-#ifdef EC_RT_SYSLOG
-        ec_master_output_stats(master);
-#endif
-        return;
+        ec_datagram_release_slot(datagram);
     }
 
-    cmd_follows = 1;
-    while (cmd_follows) {
-        // process datagram header
-        datagram_type  = EC_READ_U8 (cur_data);
-        datagram_index = EC_READ_U8 (cur_data + 1);
-        data_size      = EC_READ_U16(cur_data + 6) & 0x07FF;
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Completes a datagram, whose response was found in a received frame.
+ */
+static void ec_master_datagram_received(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_t *device, /**< Receiving EtherCAT device. */
+        ec_datagram_t *datagram, /**< Matched datagram. */
+        const uint8_t *data, /**< Payload of the response. */
+        size_t size, /**< Size of the received frame. */
+        int *delay_measured /**< Non-zero, if the bus delay was already
+                              measured with the frame. */
+        )
+{
+    if (datagram->type != EC_DATAGRAM_APWR &&
+            datagram->type != EC_DATAGRAM_FPWR &&
+            datagram->type != EC_DATAGRAM_BWR &&
+            datagram->type != EC_DATAGRAM_LWR) {
+        // copy received data into the datagram memory,
+        // if something has been read
+        memcpy(datagram->data, data, datagram->data_size);
+    }
+
+    // set the datagram's working counter
+    datagram->working_counter = EC_READ_U16(data + datagram->data_size);
+
+    // dequeue the received datagram
+    datagram->rx_device_index = device - master->devices;
+#ifdef EC_HAVE_CYCLES
+    datagram->cycles_received =
+        master->devices[EC_DEVICE_MAIN].cycles_poll;
+#endif
+    datagram->jiffies_received =
+        master->devices[EC_DEVICE_MAIN].jiffies_poll;
+    ec_datagram_stats_received(datagram);
+    if (device->rx_hw_time) {
+        datagram->hw_time_received = device->rx_hw_time;
+        datagram->hw_time_sent = device->tx_hw_time[datagram->tx_slot];
+        if (datagram->hw_time_sent
+                && datagram->hw_time_received > datagram->hw_time_sent) {
+            u32 rtt = (u32) (datagram->hw_time_received
+                    - datagram->hw_time_sent);
+            device->round_trip_time = rtt;
+            if (rtt > device->max_round_trip_time) {
+                device->max_round_trip_time = rtt;
+            }
+            if (!*delay_measured) {
+                ec_master_update_bus_delay(master, rtt,
+                        device->header_size + size);
+                *delay_measured = 1;
+            }
+        }
+    } else {
+        datagram->hw_time_received = 0;
+        datagram->hw_time_sent = 0;
+    }
+    ec_master_unaccount_datagram(master, datagram);
+    list_del_init(&datagram->queue);
+    list_del_init(&datagram->sent);
+    ec_datagram_release_slot(datagram);
+    trace_ec_datagram_receive(master->index, device - master->devices,
+            datagram);
+
+    /* The state is set last, because EoE handlers evaluate their datagrams
+     * without a common lock, see ec_master_take_ext_datagrams(). */
+    smp_store_release(&datagram->state, EC_DATAGRAM_RECEIVED);
+}
+
+/*****************************************************************************/
+
+/** Processes the planned part of a received frame.
+ *
+ * If the frame starts with the template datagrams of the transmitted frame
+ * (see ec_rx_plan_t), they are validated with a few header comparisons and
+ * completed in one pass, without the bounds checks and the matching of
+ * unmatched or late responses of the generic parser.
+ *
+ * \return Non-zero, if further datagrams follow, that have to be parsed
+ *         beginning at \a cur_data.
+ */
+static int ec_master_receive_planned(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_t *device, /**< Receiving EtherCAT device. */
+        const uint8_t *frame_data, /**< Frame data. */
+        size_t size, /**< Size of the received data. */
+        const uint8_t **cur_data, /**< Parsing position. */
+        int *delay_measured /**< Non-zero, if the bus delay was already
+                              measured with the frame. */
+        )
+{
+    const uint8_t *data = frame_data + EC_FRAME_HEADER_SIZE;
+    const ec_datagram_t *first;
+    const ec_device_t *sender;
+    const ec_rx_plan_t *plan;
+    ec_datagram_t *datagram;
+    unsigned int i, count;
+    int follows = 0;
+
+    // the first datagram tells the transmitted frame and its plan
+    first = master->sent_datagrams[EC_READ_U8(data + 1)];
+    if (!first || first->state != EC_DATAGRAM_SENT) {
+        return 1;
+    }
+    sender = &master->devices[first->device_index];
+    if (first->tx_slot >= sender->tx_ring_size) {
+        return 1; // pinned frame
+    }
+    plan = &sender->rx_plan[first->tx_slot];
+    count = plan->count;
+    if (!count || EC_FRAME_HEADER_SIZE + plan->size > size) {
+        return 1;
+    }
+
+    // validate all planned headers before touching a datagram
+    for (i = 0; i < count; i++) {
+        datagram = master->sent_datagrams[EC_READ_U8(data + 1)];
+        if (datagram != sender->tx_template[i]
+                || datagram->state != EC_DATAGRAM_SENT
+                || EC_READ_U8(data) != datagram->type
+                || (EC_READ_U16(data + 6) & 0x07FF)
+                != datagram->data_size) {
+            return 1;
+        }
+        data += EC_DATAGRAM_HEADER_SIZE + datagram->data_size
+            + EC_DATAGRAM_FOOTER_SIZE;
+    }
+
+    data = frame_data + EC_FRAME_HEADER_SIZE;
+    for (i = 0; i < count; i++) {
+        datagram = master->sent_datagrams[EC_READ_U8(data + 1)];
+        follows = EC_READ_U16(data + 6) & 0x8000;
+        data += EC_DATAGRAM_HEADER_SIZE;
+        ec_master_datagram_received(master, device, datagram, data, size,
+                delay_measured);
+        data += datagram->data_size + EC_DATAGRAM_FOOTER_SIZE;
+    }
+
+    *cur_data = data;
+    return follows;
+}
+
+/*****************************************************************************/
+
+/** Processes a received frame.
+ *
+ * This function is called by the network driver for every received frame.
+ * The datagrams of the receive plan are processed by
+ * ec_master_receive_planned(), the remaining ones are parsed one by one.
+ *
+ * \return 0 in case of success, else < 0
+ */
+void ec_master_receive_datagrams(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_device_t *device, /**< EtherCAT device */
+        const uint8_t *frame_data, /**< frame data */
+        size_t size /**< size of the received data */
+        )
+{
+    size_t frame_size, data_size;
+    uint8_t datagram_type, datagram_index;
+    unsigned int cmd_follows;
+    const uint8_t *cur_data;
+    ec_datagram_t *datagram;
+    int delay_measured = 0;
+
+    if (unlikely(size < EC_FRAME_HEADER_SIZE)) {
+        if (master->debug_level || FORCE_OUTPUT_CORRUPTED) {
+            EC_MASTER_DBG(master, 0, "Corrupted frame received"
+                    " on %s (size %zu < %u byte):\n",
+                    device->dev->name, size, EC_FRAME_HEADER_SIZE);
+            ec_print_data(frame_data, size);
+        }
+        master->stats.corrupted++;
+#ifdef EC_RT_SYSLOG
+        ec_master_output_stats(master);
+#endif
+        return;
+    }
+
+    cur_data = frame_data;
+
+    // check length of entire frame
+    frame_size = EC_READ_U16(cur_data) & 0x07FF;
+    cur_data += EC_FRAME_HEADER_SIZE;
+
+    if (unlikely(frame_size > size)) {
+        if (master->debug_level || FORCE_OUTPUT_CORRUPTED) {
+            EC_MASTER_DBG(master, 0, "Corrupted frame received"
+                    " on %s (invalid frame size %zu for "
+                    "received size %zu):\n", device->dev->name,
+                    frame_size, size);
+            ec_print_data(frame_data, size);
+        }
+        master->stats.corrupted++;
+#ifdef EC_RT_SYSLOG
+        ec_master_output_stats(master);
+#endif
+        return;
+    }
+
+    cmd_follows = ec_master_receive_planned(master, device, frame_data, size,
+            &cur_data, &delay_measured);
+    while (cmd_follows) {
+        // process datagram header
+        datagram_type  = EC_READ_U8 (cur_data);
+        datagram_index = EC_READ_U8 (cur_data + 1);
+        data_size      = EC_READ_U16(cur_data + 6) & 0x07FF;
         cmd_follows    = EC_READ_U16(cur_data + 6) & 0x8000;
         cur_data += EC_DATAGRAM_HEADER_SIZE;
 
@@ -1194,21 +2407,28 @@ void ec_master_receive_datagrams(
             return;
         }
 
-        // search for matching datagram in the queue
-        matched = 0;
-        list_for_each_entry(datagram, &master->datagram_queue, queue) {
-            if (datagram->index == datagram_index
-                && datagram->state == EC_DATAGRAM_SENT
-                && datagram->type == datagram_type
-                && datagram->data_size == data_size) {
-                matched = 1;
-                break;
-            }
-        }
+        // look up the matching datagram in the table of sent datagrams
+        datagram = master->sent_datagrams[datagram_index];
 
         // no matching datagram was found
-        if (!matched) {
+        if (!datagram
+                || datagram->state != EC_DATAGRAM_SENT
+                || datagram->type != datagram_type
+                || datagram->data_size != data_size) {
+            if (ec_master_match_late_datagram(master, datagram_type,
+                        datagram_index, data_size)) {
+#ifdef EC_RT_SYSLOG
+                ec_master_output_stats(master);
+#endif
+                cur_data += data_size + EC_DATAGRAM_FOOTER_SIZE;
+                continue;
+            }
+
             master->stats.unmatched++;
+            trace_ec_datagram_unmatched(master->index,
+                    device - master->devices, datagram_type, datagram_index,
+                    data_size);
+            ec_master_capture_trigger(master, EC_CAPTURE_UNMATCHED);
 #ifdef EC_RT_SYSLOG
             ec_master_output_stats(master);
 #endif
@@ -1227,29 +2447,26 @@ void ec_master_receive_datagrams(
             continue;
         }
 
-        if (datagram->type != EC_DATAGRAM_APWR &&
-                datagram->type != EC_DATAGRAM_FPWR &&
-                datagram->type != EC_DATAGRAM_BWR &&
-                datagram->type != EC_DATAGRAM_LWR) {
-            // copy received data into the datagram memory,
-            // if something has been read
-            memcpy(datagram->data, cur_data, data_size);
-        }
-        cur_data += data_size;
+        ec_master_datagram_received(master, device, datagram, cur_data,
+                size, &delay_measured);
+        cur_data += data_size + EC_DATAGRAM_FOOTER_SIZE;
+    }
+}
 
-        // set the datagram's working counter
-        datagram->working_counter = EC_READ_U16(cur_data);
-        cur_data += EC_DATAGRAM_FOOTER_SIZE;
+/*****************************************************************************/
 
-        // dequeue the received datagram
-        datagram->state = EC_DATAGRAM_RECEIVED;
-#ifdef EC_HAVE_CYCLES
-        datagram->cycles_received =
-            master->devices[EC_DEVICE_MAIN].cycles_poll;
-#endif
-        datagram->jiffies_received =
-            master->devices[EC_DEVICE_MAIN].jiffies_poll;
-        list_del_init(&datagram->queue);
+/** Notifies the capture rings of all devices about an event.
+ */
+void ec_master_capture_trigger(
+        ec_master_t *master, /**< EtherCAT master */
+        unsigned int event /**< Event (EC_CAPTURE_UNMATCHED etc.). */
+        )
+{
+    unsigned int dev_idx;
+
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ec_capture_trigger(&master->devices[dev_idx].capture, event);
     }
 }
 
@@ -1258,7 +2475,8 @@ void ec_master_receive_datagrams(
 /** Output master statistics.
  *
  * This function outputs statistical data on demand, but not more often than
- * necessary. The output happens at most once a second.
+ * necessary. The output happens at most once a second. As it is called from
+ * realtime context, the messages go to the RT log.
  */
 void ec_master_output_stats(ec_master_t *master /**< EtherCAT master */)
 {
@@ -1266,23 +2484,44 @@ void ec_master_output_stats(ec_master_t *master /**< EtherCAT master */)
         master->stats.output_jiffies = jiffies;
 
         if (master->stats.timeouts) {
-            EC_MASTER_WARN(master, "%u datagram%s TIMED OUT!\n",
+            EC_MASTER_RT_WARN(master, EC_RT_LOG_STATS,
+                    "%u datagram%s TIMED OUT!\n",
                     master->stats.timeouts,
                     master->stats.timeouts == 1 ? "" : "s");
             master->stats.timeouts = 0;
         }
         if (master->stats.corrupted) {
-            EC_MASTER_WARN(master, "%u frame%s CORRUPTED!\n",
+            EC_MASTER_RT_WARN(master, EC_RT_LOG_STATS,
+                    "%u frame%s CORRUPTED!\n",
                     master->stats.corrupted,
                     master->stats.corrupted == 1 ? "" : "s");
             master->stats.corrupted = 0;
         }
         if (master->stats.unmatched) {
-            EC_MASTER_WARN(master, "%u datagram%s UNMATCHED!\n",
+            EC_MASTER_RT_WARN(master, EC_RT_LOG_STATS,
+                    "%u datagram%s UNMATCHED!\n",
                     master->stats.unmatched,
                     master->stats.unmatched == 1 ? "" : "s");
             master->stats.unmatched = 0;
         }
+        if (master->stats.late) {
+            EC_MASTER_RT_WARN(master, EC_RT_LOG_STATS,
+                    "%u datagram%s arrived LATE"
+                    " (up to %u us after the timeout)!\n",
+                    master->stats.late,
+                    master->stats.late == 1 ? "" : "s",
+                    master->stats.late_max);
+            master->stats.late = 0;
+            master->stats.late_max = 0;
+        }
+        if (master->stats.index_deferred) {
+            EC_MASTER_RT_WARN(master, EC_RT_LOG_STATS,
+                    "%u send%s DEFERRED, because all"
+                    " datagram indices were in flight!\n",
+                    master->stats.index_deferred,
+                    master->stats.index_deferred == 1 ? "" : "s");
+            master->stats.index_deferred = 0;
+        }
     }
 }
 
@@ -1321,6 +2560,10 @@ void ec_master_clear_device_stats(
 /*****************************************************************************/
 
 /** Updates the common device statistics.
+ *
+ * Applies the rate filters at most once a second. This is called from the
+ * idle and operation threads, so the realtime context only has to increment
+ * the frame and byte counters.
  */
 void ec_master_update_device_stats(
         ec_master_t *master /**< EtherCAT master */
@@ -1443,11 +2686,97 @@ void ec_master_nanosleep(const unsigned long nsecs)
     } while (t.task && !signal_pending(current));
 }
 
+/*****************************************************************************/
+
+/** Sleeps until the next wakeup time of a periodic schedule.
+ *
+ * The wakeup times are absolute, so that the schedule does not drift with
+ * the run time of the thread. If \a anchor is non-zero, the wakeups are
+ * placed half a period after it (and after every following period), so that
+ * the thread runs between two sends of the application. Otherwise, the
+ * previous wakeup time is continued. A missed wakeup restarts the schedule.
+ */
+static void ec_master_sleep_periodic(
+        ktime_t *next, /**< Previous wakeup time (input), next wakeup time
+                         (output). */
+        u32 period, /**< Period in ns. */
+        u64 anchor /**< Time to align the schedule to in ns, or zero. */
+        )
+{
+    u64 now = ktime_to_ns(ktime_get()), target, periods;
+
+    if (anchor && period) {
+        target = anchor + period / 2;
+        if (target <= now) {
+            periods = now - target;
+            do_div(periods, period);
+            target += (periods + 1) * period;
+        }
+    } else {
+        target = ktime_to_ns(*next) + period;
+        if (target <= now) {
+            target = now + period;
+        }
+    }
+
+    *next = ns_to_ktime(target);
+    set_current_state(TASK_INTERRUPTIBLE);
+    schedule_hrtimeout(next, HRTIMER_MODE_ABS);
+}
+
 #endif // EC_USE_HRTIMER
 
 /*****************************************************************************/
 
+/** Schedules the FSM of a slave for serving new requests.
+ *
+ * Has to be called with the master semaphore held. The kick is dropped, if
+ * the FSM is busy or not ready. It is kicked again, when it becomes ready.
+ */
+void ec_master_kick_slave_fsm(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    ec_fsm_slave_t *fsm = &slave->fsm;
+
+    if (ec_fsm_slave_is_ready(fsm) && list_empty(&fsm->ready)) {
+        list_add_tail(&fsm->ready, &master->fsm_ready_list);
+    }
+}
+
+/*****************************************************************************/
+
+/** Executes a ready slave FSM and adds it to the execution list, if it
+ * started processing a request.
+ */
+static void ec_master_start_slave_fsm(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_fsm_slave_t *fsm /**< Ready slave FSM. */
+        )
+{
+    ec_datagram_t *datagram = ec_master_get_external_datagram(master);
+
+    if (ec_fsm_slave_exec(fsm, datagram)) {
+        ec_master_release_external_datagram(master);
+        list_add_tail(&fsm->list, &master->fsm_exec_list);
+        master->fsm_exec_count++;
+#if DEBUG_INJECT
+        EC_MASTER_DBG(master, 1, "New slave %u FSM"
+                " consumed datagram %s, now %u FSMs in list.\n",
+                fsm->slave->ring_position, datagram->name,
+                master->fsm_exec_count);
+#endif
+    }
+}
+
+/*****************************************************************************/
+
 /** Execute slave FSMs.
+ *
+ * Slave FSMs are started, when they are kicked by a new request. A slow
+ * sweep over all slaves catches the work, that does not come with a request.
+ * So the cost scales with the number of requests, not with the bus size.
  */
 void ec_master_exec_slave_fsms(
         ec_master_t *master /**< EtherCAT master. */
@@ -1455,6 +2784,8 @@ void ec_master_exec_slave_fsms(
 {
     ec_datagram_t *datagram;
     ec_fsm_slave_t *fsm, *next;
+    ec_slave_config_t *sc, *next_sc;
+    struct llist_node *kicked;
     unsigned int count = 0;
 
     list_for_each_entry_safe(fsm, next, &master->fsm_exec_list, list) {
@@ -1470,8 +2801,8 @@ void ec_master_exec_slave_fsms(
                 fsm->datagram->state == EC_DATAGRAM_QUEUED ||
                 fsm->datagram->state == EC_DATAGRAM_SENT) {
             // previous datagram was not sent or received yet.
-            // wait until next thread execution
-            return;
+            // skip this FSM until next thread execution
+            continue;
         }
 
         datagram = ec_master_get_external_datagram(master);
@@ -1492,8 +2823,7 @@ void ec_master_exec_slave_fsms(
             EC_MASTER_DBG(master, 1, "FSM consumed datagram %s\n",
                     datagram->name);
 #endif
-            master->ext_ring_idx_fsm =
-                (master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE;
+            ec_master_release_external_datagram(master);
         }
         else {
             // FSM finished
@@ -1503,28 +2833,44 @@ void ec_master_exec_slave_fsms(
             EC_MASTER_DBG(master, 1, "FSM finished. %u remaining.\n",
                     master->fsm_exec_count);
 #endif
+            // serve the requests, that were issued while busy
+            ec_master_kick_slave_fsm(master, fsm->slave);
+        }
+    }
+
+    /* Kick the slaves of the configurations with new internal requests. The
+     * flag is cleared first, so that a request issued meanwhile kicks the
+     * configuration again. */
+    kicked = llist_del_all(&master->config_kick_list);
+    llist_for_each_entry_safe(sc, next_sc, kicked, kick_node) {
+        clear_bit(0, &sc->kicked);
+        smp_mb();
+        if (sc->slave) {
+            ec_master_kick_slave_fsm(master, sc->slave);
+        }
+    }
+
+    // the number of concurrent slave FSMs scales with the ring size
+    while (master->fsm_exec_count < master->ext_ring_size / 2
+            && !list_empty(&master->fsm_ready_list)) {
+        fsm = list_first_entry(&master->fsm_ready_list, ec_fsm_slave_t,
+                ready);
+        list_del_init(&fsm->ready);
+
+        if (ec_fsm_slave_is_ready(fsm)) {
+            ec_master_start_slave_fsm(master, fsm);
         }
     }
 
-    while (master->fsm_exec_count < EC_EXT_RING_SIZE / 2
+    if (time_before(jiffies, master->fsm_sweep_jiffies)) {
+        return;
+    }
+
+    while (master->fsm_exec_count < master->ext_ring_size / 2
             && count < master->slave_count) {
 
         if (ec_fsm_slave_is_ready(&master->fsm_slave->fsm)) {
-            datagram = ec_master_get_external_datagram(master);
-
-            if (ec_fsm_slave_exec(&master->fsm_slave->fsm, datagram)) {
-                master->ext_ring_idx_fsm =
-                    (master->ext_ring_idx_fsm + 1) % EC_EXT_RING_SIZE;
-                list_add_tail(&master->fsm_slave->fsm.list,
-                        &master->fsm_exec_list);
-                master->fsm_exec_count++;
-#if DEBUG_INJECT
-                EC_MASTER_DBG(master, 1, "New slave %u FSM"
-                        " consumed datagram %s, now %u FSMs in list.\n",
-                        master->fsm_slave->ring_position, datagram->name,
-                        master->fsm_exec_count);
-#endif
-            }
+            ec_master_start_slave_fsm(master, &master->fsm_slave->fsm);
         }
 
         master->fsm_slave++;
@@ -1533,8 +2879,127 @@ void ec_master_exec_slave_fsms(
         }
         count++;
     }
+
+    if (count == master->slave_count) {
+        // sweep completed
+        master->fsm_sweep_jiffies =
+            jiffies + msecs_to_jiffies(EC_SLAVE_FSM_SWEEP_MS);
+    }
+}
+
+/*****************************************************************************/
+
+/** Queues the datagrams produced by the master state machine.
+ *
+ * Besides the FSM datagram, these are the datagrams of the slave scan state
+ * machines and of the slave configuration units
+ * running in parallel, the AL and mailbox status area datagrams, the
+ * read-ahead AL state datagrams and the register batch datagrams.
+ */
+static void ec_master_queue_fsm_datagrams(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    unsigned int i;
+
+    if (!master->fsm.monitor_hold) {
+        ec_master_queue_datagram(master, &master->fsm_datagram);
+    }
+
+    for (i = 0; i < EC_FSM_MASTER_SCANS; i++) {
+        if (master->fsm.scan_mask & (1 << i)) {
+            ec_master_queue_datagram(master, &master->fsm.scan_datagrams[i]);
+        }
+    }
+    master->fsm.scan_mask = 0;
+
+    for (i = 0; i < EC_MAX_FSM_MASTER_CONFIGS; i++) {
+        if (master->fsm.config_mask & (1 << i)) {
+            ec_master_queue_datagram(master,
+                    &master->fsm.configs[i].datagram);
+        }
+    }
+    master->fsm.config_mask = 0;
+
+    if (master->fsm.al_queue) {
+        ec_master_queue_datagram(master, &master->fsm.al_datagram);
+        master->fsm.al_queue = 0;
+    }
+
+    if (master->fsm.mbox_queue) {
+        ec_master_queue_datagram(master, &master->fsm.mbox_datagram);
+        master->fsm.mbox_queue = 0;
+    }
+
+    for (i = 0; i < EC_FSM_MASTER_MBOX_DATAGRAMS; i++) {
+        if (master->fsm.mbox_data_mask & (1U << i)) {
+            ec_master_queue_datagram(master,
+                    &master->fsm.mbox_data_datagrams[i]);
+        }
+    }
+    master->fsm.mbox_data_mask = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_STATE_DATAGRAMS; i++) {
+        if (master->fsm.state_mask & (1U << i)) {
+            ec_master_queue_datagram(master, &master->fsm.state_datagrams[i]);
+        }
+    }
+    master->fsm.state_mask = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_REG_DATAGRAMS; i++) {
+        if (master->fsm.reg_mask & (1U << i)) {
+            ec_master_queue_datagram(master, &master->fsm.reg_datagrams[i]);
+        }
+    }
+    master->fsm.reg_mask = 0;
+
+    for (i = 0; i < EC_FSM_MASTER_DC_DATAGRAMS; i++) {
+        if (master->fsm.dc_mask & (1U << i)) {
+            ec_master_queue_datagram(master, &master->fsm.dc_datagrams[i]);
+        }
+    }
+    master->fsm.dc_mask = 0;
+}
+
+/*****************************************************************************/
+
+/** Enables or disables the receive interrupts of the master's devices.
+ */
+static void ec_master_idle_irq_enable(
+        ec_master_t *master, /**< EtherCAT master */
+        int enable /**< Non-zero to enable the interrupts. */
+        )
+{
+    unsigned int dev_idx;
+
+    down(&master->io_sem);
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ec_device_irq_enable(&master->devices[dev_idx], enable);
+    }
+    up(&master->io_sem);
+}
+
+/*****************************************************************************/
+
+#ifdef EC_DEBUG_IF
+
+/** Passes the frames queued for the debug interfaces to the network stack.
+ */
+static void ec_master_debug_flush(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    unsigned int dev_idx;
+
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        ec_debug_flush(&master->devices[dev_idx].dbg);
+    }
 }
 
+#endif
+
 /*****************************************************************************/
 
 /** Master kernel thread function for IDLE phase.
@@ -1542,20 +3007,34 @@ void ec_master_exec_slave_fsms(
 static int ec_master_idle_thread(void *priv_data)
 {
     ec_master_t *master = (ec_master_t *) priv_data;
-    int fsm_exec;
+    int fsm_exec, irq;
+    ktime_t fsm_start;
 #ifdef EC_USE_HRTIMER
+    ktime_t next_wakeup = ktime_get();
     size_t sent_bytes;
 #endif
 
     // send interval in IDLE phase
     ec_master_set_send_interval(master, 1000000 / HZ);
 
+    // wait for receive interrupts, if the main device supports them
+    irq = ec_idle_irq && master->devices[EC_DEVICE_MAIN].irq_control;
+    if (irq) {
+        ec_master_idle_irq_enable(master, 1);
+    }
+
     EC_MASTER_DBG(master, 1, "Idle thread running with send interval = %u us,"
-            " max data size=%zu\n", master->send_interval,
-            master->max_queue_size);
+            " max data size=%zu%s\n", master->send_interval,
+            master->max_queue_size, irq ? ", receive interrupts" : "");
 
     while (!kthread_should_stop()) {
         ec_datagram_output_stats(&master->fsm_datagram);
+        ec_master_update_device_stats(master);
+        ec_rt_log_flush(&master->rt_log);
+
+        /* Interrupts of frames, that arrive after this, wake up the
+         * thread below. */
+        xchg(&master->idle_irq_event, 0);
 
         // receive
         down(&master->io_sem);
@@ -1567,16 +3046,18 @@ static int ec_master_idle_thread(void *priv_data)
             break;
         }
 
+        fsm_start = ktime_get();
         fsm_exec = ec_fsm_master_exec(&master->fsm);
 
         ec_master_exec_slave_fsms(master);
+        ec_master_update_fsm_counters(master, fsm_start);
 
         up(&master->master_sem);
 
         // queue and send
         down(&master->io_sem);
         if (fsm_exec) {
-            ec_master_queue_datagram(master, &master->fsm_datagram);
+            ec_master_queue_fsm_datagrams(master);
         }
         ecrt_master_send(master);
 #ifdef EC_USE_HRTIMER
@@ -1585,22 +3066,36 @@ static int ec_master_idle_thread(void *priv_data)
 #endif
         up(&master->io_sem);
 
+#ifdef EC_DEBUG_IF
+        ec_master_debug_flush(master);
+#endif
+
         if (ec_fsm_master_idle(&master->fsm)) {
 #ifdef EC_USE_HRTIMER
-            ec_master_nanosleep(master->send_interval * 1000);
+            ec_master_sleep_periodic(&next_wakeup,
+                    master->send_interval * NSEC_PER_USEC, 0ULL);
 #else
             set_current_state(TASK_INTERRUPTIBLE);
             schedule_timeout(1);
 #endif
+        } else if (irq) {
+            // sleep until the response arrives
+            wait_event_interruptible_timeout(master->idle_queue,
+                    master->idle_irq_event || kthread_should_stop(), 1);
         } else {
 #ifdef EC_USE_HRTIMER
-            ec_master_nanosleep(sent_bytes * EC_BYTE_TRANSMISSION_TIME_NS);
+            ec_master_nanosleep(sent_bytes * EC_BYTE_TRANSMISSION_TIME_NS
+                    + master->bus_delay);
 #else
             schedule();
 #endif
         }
     }
 
+    if (irq) {
+        ec_master_idle_irq_enable(master, 0);
+    }
+
     EC_MASTER_DBG(master, 1, "Master IDLE thread exiting...\n");
 
     return 0;
@@ -1608,18 +3103,149 @@ static int ec_master_idle_thread(void *priv_data)
 
 /*****************************************************************************/
 
-/** Master kernel thread function for OPERATION phase.
+/** Runs one bus cycle on behalf of the application.
+ *
+ * Called by the operation thread in master-timed mode, see
+ * ecrt_master_set_timed_cycle().
  */
-static int ec_master_operation_thread(void *priv_data)
+static void ec_master_timed_cycle(
+        ec_master_t *master /**< EtherCAT master. */
+        )
 {
-    ec_master_t *master = (ec_master_t *) priv_data;
+    unsigned int flags = master->timed_cycle_flags;
+    ec_domain_t *domain;
+    u64 app_time;
 
-    EC_MASTER_DBG(master, 1, "Operation thread running"
+    down(&master->io_sem);
+
+    if (flags & EC_CYCLE_RECEIVE) {
+        ecrt_master_receive(master);
+    }
+
+    if (flags & EC_CYCLE_PROCESS) {
+        list_for_each_entry(domain, &master->domains, list) {
+            ecrt_domain_process(domain);
+        }
+    }
+
+    if (flags & (EC_CYCLE_APP_TIME | EC_CYCLE_SYNC_REF_TO)) {
+        // EtherCAT system time starts at 2000-01-01
+        app_time = ktime_to_ns(ktime_get_real())
+            - 946684800ULL * NSEC_PER_SEC;
+
+        if (flags & EC_CYCLE_APP_TIME) {
+            ecrt_master_application_time(master, app_time);
+        }
+        if (flags & EC_CYCLE_SYNC_REF_TO) {
+            ecrt_master_sync_reference_clock_to(master, app_time);
+        }
+    }
+
+    if (flags & EC_CYCLE_SYNC_REF) {
+        ecrt_master_sync_reference_clock(master);
+    }
+
+    if (flags & EC_CYCLE_SYNC_SLAVES) {
+        ecrt_master_sync_slave_clocks(master);
+    }
+
+    if (flags & EC_CYCLE_SYNC_MON_QUEUE) {
+        ecrt_master_sync_monitor_queue(master);
+    }
+
+    if (flags & EC_CYCLE_QUEUE) {
+        list_for_each_entry(domain, &master->domains, list) {
+            if (!domain->cycle_divisor) {
+                ecrt_domain_queue(domain);
+            }
+        }
+    }
+
+    if (flags & EC_CYCLE_SEND) {
+        ecrt_master_send(master);
+    }
+
+    up(&master->io_sem);
+
+    if (master->cycle_cb) {
+        master->cycle_cb(master, master->cycle_cb_data);
+    }
+}
+
+/*****************************************************************************/
+
+/** Busy-polls for the application's trigger of the next bus cycle.
+ *
+ * Gives up after a send interval, or a millisecond, if no send interval is
+ * set, so that the state machines keep running while the application does
+ * not trigger cycles.
+ *
+ * \return Non-zero, if a cycle was triggered.
+ */
+static int ec_master_poll_cycle_trigger(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    const uint32_t *trigger = master->cycle_trigger_ext ?
+        master->cycle_trigger_ext : &master->cycle_trigger;
+    u64 timeout_ns = master->send_interval ?
+        (u64) master->send_interval * NSEC_PER_USEC : NSEC_PER_MSEC;
+    ktime_t deadline = ktime_add_ns(ktime_get(), timeout_ns);
+    uint32_t value;
+
+    while ((value = READ_ONCE(*trigger)) == master->cycle_trigger_seen) {
+        if (kthread_should_stop()
+                || ktime_to_ns(ktime_get()) >= ktime_to_ns(deadline)) {
+            cond_resched();
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    smp_rmb(); // the outputs were written before the trigger
+    master->cycle_trigger_seen = value;
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Master kernel thread function for OPERATION phase.
+ */
+static int ec_master_operation_thread(void *priv_data)
+{
+    ec_master_t *master = (ec_master_t *) priv_data;
+    ktime_t next_cycle = ktime_get(), now, fsm_start;
+
+    EC_MASTER_DBG(master, 1, "Operation thread running"
             " with fsm interval = %u us, max data size=%zu\n",
             master->send_interval, master->max_queue_size);
 
     while (!kthread_should_stop()) {
+        if (master->timed_cycle_flags & EC_CYCLE_TRIGGERED) {
+            if (ec_master_poll_cycle_trigger(master)) {
+                ec_master_timed_cycle(master);
+            }
+        } else if (master->timed_cycle_flags) {
+            next_cycle = ktime_add_ns(next_cycle,
+                    (u64) master->send_interval * NSEC_PER_USEC);
+            now = ktime_get();
+            if (ktime_to_ns(next_cycle) < ktime_to_ns(now)) {
+                // cycle overrun, restart the schedule
+                next_cycle = now;
+            }
+
+            set_current_state(TASK_INTERRUPTIBLE);
+            schedule_hrtimeout(&next_cycle, HRTIMER_MODE_ABS);
+            if (kthread_should_stop()) {
+                break;
+            }
+
+            ec_master_timed_cycle(master);
+        }
+
         ec_datagram_output_stats(&master->fsm_datagram);
+        ec_master_update_device_stats(master);
+        ec_rt_log_flush(&master->rt_log);
 
         if (master->injection_seq_rt == master->injection_seq_fsm) {
             // output statistics
@@ -1630,6 +3256,7 @@ static int ec_master_operation_thread(void *priv_data)
                 break;
             }
 
+            fsm_start = ktime_get();
             if (ec_fsm_master_exec(&master->fsm)) {
                 // Inject datagrams (let the RT thread queue them, see
                 // ecrt_master_send())
@@ -1637,13 +3264,25 @@ static int ec_master_operation_thread(void *priv_data)
             }
 
             ec_master_exec_slave_fsms(master);
+            ec_master_update_fsm_counters(master, fsm_start);
 
             up(&master->master_sem);
         }
 
+#ifdef EC_DEBUG_IF
+        ec_master_debug_flush(master);
+#endif
+
+        if (master->timed_cycle_flags) {
+            continue; // the cycle timer or trigger paces the thread
+        }
+
 #ifdef EC_USE_HRTIMER
-        // the op thread should not work faster than the sending RT thread
-        ec_master_nanosleep(master->send_interval * 1000);
+        // the op thread should not work faster than the sending RT thread,
+        // and runs in between its sends
+        ec_master_sleep_periodic(&next_cycle,
+                master->send_interval * NSEC_PER_USEC,
+                READ_ONCE(master->app_send_time));
 #else
         if (ec_fsm_master_idle(&master->fsm)) {
             set_current_state(TASK_INTERRUPTIBLE);
@@ -1667,6 +3306,7 @@ static int ec_master_operation_thread(void *priv_data)
 void ec_master_eoe_start(ec_master_t *master /**< EtherCAT master */)
 {
     struct sched_param param = { .sched_priority = 0 };
+    struct task_struct *thread;
 
     if (master->eoe_thread) {
         EC_MASTER_WARN(master, "EoE already running!\n");
@@ -1676,25 +3316,22 @@ void ec_master_eoe_start(ec_master_t *master /**< EtherCAT master */)
     if (list_empty(&master->eoe_handlers))
         return;
 
-    if (!master->send_cb || !master->receive_cb) {
-        EC_MASTER_WARN(master, "No EoE processing"
-                " because of missing callbacks!\n");
-        return;
-    }
-
     EC_MASTER_INFO(master, "Starting EoE thread.\n");
-    master->eoe_thread = kthread_run(ec_master_eoe_thread, master,
+    thread = ec_master_run_thread(master, ec_master_eoe_thread,
             "EtherCAT-EoE");
-    if (IS_ERR(master->eoe_thread)) {
-        int err = (int) PTR_ERR(master->eoe_thread);
+    if (IS_ERR(thread)) {
+        int err = (int) PTR_ERR(thread);
         EC_MASTER_ERR(master, "Failed to start EoE thread (error %i)!\n",
                 err);
-        master->eoe_thread = NULL;
         return;
     }
 
-    sched_setscheduler(master->eoe_thread, SCHED_NORMAL, &param);
-    set_user_nice(master->eoe_thread, 0);
+    sched_setscheduler(thread, SCHED_NORMAL, &param);
+    set_user_nice(thread, 0);
+
+    spin_lock_bh(&master->eoe_lock);
+    master->eoe_thread = thread;
+    spin_unlock_bh(&master->eoe_lock);
 }
 
 /*****************************************************************************/
@@ -1703,72 +3340,197 @@ void ec_master_eoe_start(ec_master_t *master /**< EtherCAT master */)
  */
 void ec_master_eoe_stop(ec_master_t *master /**< EtherCAT master */)
 {
-    if (master->eoe_thread) {
+    struct task_struct *thread;
+
+    spin_lock_bh(&master->eoe_lock);
+    thread = master->eoe_thread;
+    master->eoe_thread = NULL; // no more wakeups
+    spin_unlock_bh(&master->eoe_lock);
+
+    if (thread) {
         EC_MASTER_INFO(master, "Stopping EoE thread.\n");
 
-        kthread_stop(master->eoe_thread);
-        master->eoe_thread = NULL;
+        kthread_stop(thread);
         EC_MASTER_INFO(master, "EoE thread exited.\n");
     }
 }
 
 /*****************************************************************************/
 
+/** Marks an EoE handler for processing and wakes up the EoE thread.
+ *
+ * This can be called from the transmit function of the network device,
+ * so the handler list is protected by a spinlock.
+ */
+void ec_master_eoe_activate(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_eoe_t *eoe /**< EoE handler */
+        )
+{
+    spin_lock_bh(&master->eoe_lock);
+    eoe->wakeup = 1;
+    if (list_empty(&eoe->active)) {
+        list_add_tail(&eoe->active, &master->eoe_active);
+    }
+    if (master->eoe_thread) {
+        wake_up_process(master->eoe_thread);
+    }
+    spin_unlock_bh(&master->eoe_lock);
+}
+
+/*****************************************************************************/
+
+/** Removes an EoE handler from the list of active handlers.
+ *
+ * Has to be called before the handler is freed.
+ */
+static void ec_master_eoe_deactivate(
+        ec_master_t *master, /**< EtherCAT master */
+        ec_eoe_t *eoe /**< EoE handler */
+        )
+{
+    spin_lock_bh(&master->eoe_lock);
+    list_del_init(&eoe->active);
+    spin_unlock_bh(&master->eoe_lock);
+}
+
+/*****************************************************************************/
+
+/** Activates the EoE handlers of slaves, that signal mailbox data in the
+ * mailbox status area.
+ *
+ * Called by the master state machine after a valid read of the area.
+ */
+void ec_master_eoe_mbox_ready(
+        ec_master_t *master /**< EtherCAT master */
+        )
+{
+    const ec_fsm_master_t *fsm = &master->fsm;
+    ec_eoe_t *eoe;
+
+    list_for_each_entry(eoe, &master->eoe_handlers, list) {
+        const ec_slave_t *slave = eoe->slave;
+
+        if (ec_eoe_is_open(eoe) && slave->mbox_status_mapped
+                && slave->station_address
+                && slave->station_address <= fsm->mbox_size
+                && fsm->mbox_status[slave->station_address - 1] & 0x08) {
+            ec_master_eoe_activate(master, eoe);
+        }
+    }
+}
+
+/*****************************************************************************/
+
 /** Does the Ethernet over EtherCAT processing.
+ *
+ * Only the handlers in the active list are processed. Handlers are
+ * activated by the network stack when frames are to be sent, by the master
+ * state machine when the mailbox status area signals data, and regularly
+ * to check the mailboxes of idle handlers. Busy handlers stay active. The
+ * processing is paced with a high-resolution timeout.
  */
 static int ec_master_eoe_thread(void *priv_data)
 {
     ec_master_t *master = (ec_master_t *) priv_data;
-    ec_eoe_t *eoe;
-    unsigned int none_open, sth_to_send, all_idle;
+    ec_eoe_t *eoe, *next;
+    LIST_HEAD(active);
+    unsigned int sth_to_send, polls = 0;
+    ktime_t now, next_poll, expires;
+    ec_eoe_counters_t counters;
 
     EC_MASTER_DBG(master, 1, "EoE thread running.\n");
 
-    while (!kthread_should_stop()) {
-        none_open = 1;
-        all_idle = 1;
+    next_poll = ktime_get();
 
-        list_for_each_entry(eoe, &master->eoe_handlers, list) {
-            if (ec_eoe_is_open(eoe)) {
-                none_open = 0;
-                break;
+    while (!kthread_should_stop()) {
+        now = ktime_get();
+
+        if (ktime_to_ns(now) >= ktime_to_ns(next_poll)) {
+            // check the mailboxes of the idle handlers. Handlers of slaves
+            // with mapped mailbox status are woken up by the master state
+            // machine, so they are checked seldom.
+            polls++;
+            memset(&counters, 0, sizeof(counters));
+            list_for_each_entry(eoe, &master->eoe_handlers, list) {
+                if (ec_eoe_is_open(eoe) && (!eoe->slave->mbox_status_mapped
+                            || !(polls % EC_EOE_MAPPED_POLLS))) {
+                    ec_master_eoe_activate(master, eoe);
+                }
+                if (ec_eoe_is_open(eoe)) {
+                    counters.handlers++;
+                    counters.rx_rate += eoe->rx_rate;
+                    counters.tx_rate += eoe->tx_rate;
+                }
             }
+            next_poll = ktime_add_ns(now, EC_EOE_IDLE_PERIOD);
+
+            preempt_disable();
+            write_seqcount_begin(&master->counters.eoe_seq);
+            master->counters.eoe = counters;
+            write_seqcount_end(&master->counters.eoe_seq);
+            preempt_enable();
         }
-        if (none_open)
-            goto schedule;
 
-        // receive datagrams
-        master->receive_cb(master->cb_data);
+        spin_lock_bh(&master->eoe_lock);
+        list_splice_init(&master->eoe_active, &active);
+        list_for_each_entry(eoe, &active, active) {
+            eoe->wakeup = 0;
+        }
+        spin_unlock_bh(&master->eoe_lock);
+
+        if (!list_empty(&active)) {
+            /* Without callbacks, the application's ecrt_master_receive()
+             * and ecrt_master_send() exchange the datagrams, see
+             * ec_master_take_ext_datagrams(). */
+            if (master->receive_cb) {
+                master->receive_cb(master->cb_data);
+            }
 
-        // actual EoE processing
-        sth_to_send = 0;
-        list_for_each_entry(eoe, &master->eoe_handlers, list) {
-            ec_eoe_run(eoe);
-            if (eoe->queue_datagram) {
-                sth_to_send = 1;
+            // actual EoE processing
+            sth_to_send = 0;
+            list_for_each_entry(eoe, &active, active) {
+                ec_eoe_run(eoe);
+                if (ec_eoe_queue_pending(eoe)) {
+                    ec_eoe_queue(eoe);
+                    sth_to_send = 1;
+                }
             }
-            if (!ec_eoe_is_idle(eoe)) {
-                all_idle = 0;
+
+            if (sth_to_send && master->send_cb) {
+                // (try to) send datagrams
+                master->send_cb(master->cb_data);
             }
-        }
 
-        if (sth_to_send) {
-            list_for_each_entry(eoe, &master->eoe_handlers, list) {
-                ec_eoe_queue(eoe);
+            // keep the busy handlers active
+            spin_lock_bh(&master->eoe_lock);
+            list_for_each_entry_safe(eoe, next, &active, active) {
+                if (ec_eoe_is_open(eoe) && (eoe->wakeup
+                            || !ec_eoe_is_idle(eoe)
+                            || ec_eoe_queue_pending(eoe))) {
+                    list_move_tail(&eoe->active, &master->eoe_active);
+                } else {
+                    list_del_init(&eoe->active);
+                }
             }
-            // (try to) send datagrams
-            down(&master->ext_queue_sem);
-            master->send_cb(master->cb_data);
-            up(&master->ext_queue_sem);
+            spin_unlock_bh(&master->eoe_lock);
         }
 
-schedule:
-        if (all_idle) {
-            set_current_state(TASK_INTERRUPTIBLE);
-            schedule_timeout(1);
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (kthread_should_stop()) {
+            __set_current_state(TASK_RUNNING);
+            break;
+        }
+
+        spin_lock_bh(&master->eoe_lock);
+        if (list_empty(&master->eoe_active)) {
+            expires = next_poll;
         } else {
-            schedule();
+            expires = ktime_add_ns(ktime_get(), EC_EOE_BUSY_PERIOD);
         }
+        spin_unlock_bh(&master->eoe_lock);
+
+        schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
     }
 
     EC_MASTER_DBG(master, 1, "EoE thread exiting...\n");
@@ -1793,19 +3555,121 @@ void ec_master_attach_slave_configs(
 
 /*****************************************************************************/
 
+/** Builds the alias index of the slaves.
+ *
+ * The index maps every effective alias to the first slave using it, so that
+ * ec_master_find_slave() does not have to search the slaves. It is built
+ * when a bus scan is completed and invalidated whenever the slaves or their
+ * aliases change. While it is invalid, the slaves are searched linearly.
+ */
+void ec_master_index_slaves(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_slave_alias_slot_t *slot;
+    unsigned int size = 16, i, mask;
+
+    ec_master_invalidate_slave_index(master);
+
+    while (size < 2 * master->slave_count && size < 0x10000) {
+        size *= 2;
+    }
+    mask = size - 1;
+
+    master->alias_index = kzalloc(size * sizeof(*slot), GFP_KERNEL);
+    if (!master->alias_index) {
+        return; // fall back to searching
+    }
+
+    for (i = 0; i < master->slave_count; i++) {
+        uint16_t alias = master->slaves[i].effective_alias;
+
+        if (!alias) {
+            continue;
+        }
+
+        // linear probing; a slot of the same alias keeps the first slave
+        slot = &master->alias_index[alias & mask];
+        while (slot->alias && slot->alias != alias) {
+            slot = &master->alias_index[(slot - master->alias_index + 1)
+                & mask];
+        }
+        if (!slot->alias) {
+            slot->alias = alias;
+            slot->index = i;
+        }
+    }
+
+    master->alias_index_mask = mask;
+}
+
+/*****************************************************************************/
+
+/** Invalidates the alias index of the slaves.
+ */
+void ec_master_invalidate_slave_index(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    kfree(master->alias_index);
+    master->alias_index = NULL;
+    master->alias_index_mask = 0;
+}
+
+/*****************************************************************************/
+
+/** Looks up the first slave with the given alias in the alias index.
+ *
+ * \retval >=0 Index of the slave.
+ * \retval -ENOENT No slave uses the alias.
+ * \retval -EAGAIN The index is invalid.
+ */
+static int ec_master_lookup_alias(
+        const ec_master_t *master, /**< EtherCAT master. */
+        uint16_t alias /**< Slave alias (non-zero). */
+        )
+{
+    const ec_slave_alias_slot_t *slot;
+    unsigned int i;
+
+    if (!master->alias_index) {
+        return -EAGAIN;
+    }
+
+    for (i = alias & master->alias_index_mask; ;
+            i = (i + 1) & master->alias_index_mask) {
+        slot = &master->alias_index[i];
+        if (slot->alias == alias) {
+            return slot->index;
+        }
+        if (!slot->alias) {
+            return -ENOENT;
+        }
+    }
+}
+
+/*****************************************************************************/
+
 /** Common implementation for ec_master_find_slave()
  * and ec_master_find_slave_const().
  */
 #define EC_FIND_SLAVE \
     do { \
         if (alias) { \
-            for (; slave < master->slaves + master->slave_count; \
-                    slave++) { \
-                if (slave->effective_alias == alias) \
-                break; \
+            int index = ec_master_lookup_alias(master, alias); \
+            if (index >= 0) { \
+                slave += index; \
+            } else if (index == -ENOENT) { \
+                return NULL; \
+            } else { \
+                for (; slave < master->slaves + master->slave_count; \
+                        slave++) { \
+                    if (slave->effective_alias == alias) \
+                    break; \
+                } \
+                if (slave == master->slaves + master->slave_count) \
+                return NULL; \
             } \
-            if (slave == master->slaves + master->slave_count) \
-            return NULL; \
         } \
         \
         slave += position; \
@@ -1856,31 +3720,11 @@ unsigned int ec_master_config_count(
         const ec_master_t *master /**< EtherCAT master. */
         )
 {
-    const ec_slave_config_t *sc;
-    unsigned int count = 0;
-
-    list_for_each_entry(sc, &master->configs, list) {
-        count++;
-    }
-
-    return count;
+    return master->config_count;
 }
 
 /*****************************************************************************/
 
-/** Common implementation for ec_master_get_config()
- * and ec_master_get_config_const().
- */
-#define EC_FIND_CONFIG \
-    do { \
-        list_for_each_entry(sc, &master->configs, list) { \
-            if (pos--) \
-                continue; \
-            return sc; \
-        } \
-        return NULL; \
-    } while (0)
-
 /** Get a slave configuration via its position in the list.
  *
  * \return Slave configuration or \a NULL.
@@ -1890,8 +3734,7 @@ ec_slave_config_t *ec_master_get_config(
         unsigned int pos /**< List position. */
         )
 {
-    ec_slave_config_t *sc;
-    EC_FIND_CONFIG;
+    return pos < master->config_count ? master->config_index[pos] : NULL;
 }
 
 /** Get a slave configuration via its position in the list.
@@ -1905,8 +3748,59 @@ const ec_slave_config_t *ec_master_get_config_const(
         unsigned int pos /**< List position. */
         )
 {
-    const ec_slave_config_t *sc;
-    EC_FIND_CONFIG;
+    return pos < master->config_count ? master->config_index[pos] : NULL;
+}
+
+/*****************************************************************************/
+
+/** Hash bucket of a slave configuration.
+ *
+ * \return Bucket index.
+ */
+static inline unsigned int ec_master_config_hash(
+        uint16_t alias, /**< Slave alias. */
+        uint16_t position /**< Slave position. */
+        )
+{
+    return (alias * 31 + position) % EC_CONFIG_HASH_SIZE;
+}
+
+/*****************************************************************************/
+
+/** Adds a slave configuration to the list and the lookup tables.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_master_add_config(
+        ec_master_t *master, /**< EtherCAT master. */
+        ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    unsigned int bucket = ec_master_config_hash(sc->alias, sc->position);
+
+    if (master->config_count == master->config_index_size) {
+        unsigned int size = master->config_index_size ?
+            2 * master->config_index_size : 32;
+        ec_slave_config_t **index =
+            kmalloc(size * sizeof(*index), GFP_KERNEL);
+
+        if (!index) {
+            return -ENOMEM;
+        }
+        if (master->config_count) {
+            memcpy(index, master->config_index,
+                    master->config_count * sizeof(*index));
+        }
+        kfree(master->config_index);
+        master->config_index = index;
+        master->config_index_size = size;
+    }
+
+    master->config_index[master->config_count++] = sc;
+    sc->hash_next = master->config_hash[bucket];
+    master->config_hash[bucket] = sc;
+    list_add_tail(&sc->list, &master->configs);
+    return 0;
 }
 
 /*****************************************************************************/
@@ -2056,6 +3950,7 @@ void ec_master_find_dc_ref_clock(
         )
 {
     ec_slave_t *slave, *ref = NULL;
+    size_t size;
 
     if (master->dc_ref_config) {
         // Use application-selected reference clock
@@ -2099,85 +3994,113 @@ void ec_master_find_dc_ref_clock(
         EC_MASTER_INFO(master, "No DC reference clock found.\n");
     }
 
-    // These calls always succeed, because the
-    // datagrams have been pre-allocated.
+    /* Transfer the whole system time of a 64 bit reference clock. 32 bit
+     * slaves ignore the upper half of the written time.
+     *
+     * These calls always succeed, because the datagrams have been
+     * pre-allocated. */
+    size = ref && ref->base_dc_range == EC_DC_64 ? 8 : 4;
     ec_datagram_fpwr(&master->ref_sync_datagram,
-            ref ? ref->station_address : 0xffff, 0x0910, 4);
+            ref ? ref->station_address : 0xffff, 0x0910, size);
     ec_datagram_frmw(&master->sync_datagram,
-            ref ? ref->station_address : 0xffff, 0x0910, 4);
+            ref ? ref->station_address : 0xffff, 0x0910, size);
 }
 
 /*****************************************************************************/
 
-/** Calculates the bus topology; recursion function.
+/** Calculates the bus topology.
  *
- * \return Zero on success, otherwise a negative error code.
+ * The slaves are numbered in frame order, so the slave behind an open port
+ * is always the next one in the slave list, that is not assigned yet. The
+ * tree is walked iteratively using the port 0 connections to return to the
+ * upstream slave; this needs constant stack space and time proportional to
+ * the number of slaves.
+ *
+ * Besides the port connections, every slave gets the end of its subtree
+ * (ec_slave::subtree_end) and the next slave with DC support
+ * (ec_slave::first_dc_slave), so that lookups on the tree are cheap.
  */
-int ec_master_calc_topology_rec(
-        ec_master_t *master, /**< EtherCAT master. */
-        ec_slave_t *port0_slave, /**< Slave at port 0. */
-        unsigned int *slave_position /**< Slave position. */
+void ec_master_calc_topology(
+        ec_master_t *master /**< EtherCAT master. */
         )
 {
-    ec_slave_t *slave = master->slaves + *slave_position;
-    unsigned int port_index;
-    int ret;
-
     static const unsigned int next_table[EC_MAX_PORTS] = {
         3, 2, 0, 1
     };
+    ec_slave_t *slaves = master->slaves;
+    ec_slave_t *end = slaves + master->slave_count;
+    ec_slave_t *slave, *next, *dc_slave = NULL, *parent;
+    unsigned int port_index, error = 0;
+
+    if (master->slave_count == 0)
+        return;
 
-    slave->ports[0].next_slave = port0_slave;
+    for (slave = end; slave > slaves; slave--) {
+        if (slave[-1].base_dc_supported) {
+            dc_slave = slave - 1;
+        }
+        slave[-1].first_dc_slave = dc_slave;
+    }
 
+    slave = slaves;
+    next = slaves + 1;
+    slave->ports[0].next_slave = NULL;
+    for (port_index = 1; port_index < EC_MAX_PORTS; port_index++) {
+        slave->ports[port_index].next_slave = NULL;
+    }
     port_index = 3;
-    while (port_index != 0) {
-        if (!slave->ports[port_index].link.loop_closed) {
-            *slave_position = *slave_position + 1;
-            if (*slave_position < master->slave_count) {
-                slave->ports[port_index].next_slave =
-                    master->slaves + *slave_position;
-                ret = ec_master_calc_topology_rec(master,
-                        slave, slave_position);
-                if (ret) {
-                    return ret;
+
+    while (slave) {
+        while (port_index != 0) {
+            if (!slave->ports[port_index].link.loop_closed) {
+                if (next < end) {
+                    break;
+                }
+                if (!error) {
+                    EC_MASTER_ERR(master,
+                            "Failed to calculate bus topology.\n");
+                    error = 1;
                 }
-            } else {
-                return -1;
             }
+            port_index = next_table[port_index];
         }
 
-        port_index = next_table[port_index];
-    }
+        if (port_index != 0) {
+            // descend to the slave behind the open port
+            slave->ports[port_index].next_slave = next;
+            parent = slave;
+            slave = next++;
+            slave->ports[0].next_slave = parent;
+            for (port_index = 1; port_index < EC_MAX_PORTS; port_index++) {
+                slave->ports[port_index].next_slave = NULL;
+            }
+            port_index = 3;
+            continue;
+        }
 
-    return 0;
+        // all ports done, return to the upstream slave
+        slave->subtree_end = next;
+        parent = slave->ports[0].next_slave;
+        if (parent) {
+            port_index = 3;
+            while (parent->ports[port_index].next_slave != slave) {
+                port_index = next_table[port_index];
+            }
+            port_index = next_table[port_index];
+        }
+        slave = parent;
+    }
 }
 
 /*****************************************************************************/
 
-/** Calculates the bus topology.
+/** Calculates the bus transmission delays.
  */
-void ec_master_calc_topology(
+void ec_master_calc_transmission_delays(
         ec_master_t *master /**< EtherCAT master. */
         )
 {
-    unsigned int slave_position = 0;
-
-    if (master->slave_count == 0)
-        return;
-
-    if (ec_master_calc_topology_rec(master, NULL, &slave_position))
-        EC_MASTER_ERR(master, "Failed to calculate bus topology.\n");
-}
-
-/*****************************************************************************/
-
-/** Calculates the bus transmission delays.
- */
-void ec_master_calc_transmission_delays(
-        ec_master_t *master /**< EtherCAT master. */
-        )
-{
-    ec_slave_t *slave;
+    ec_slave_t *slave;
 
     for (slave = master->slaves;
             slave < master->slaves + master->slave_count;
@@ -2186,8 +4109,7 @@ void ec_master_calc_transmission_delays(
     }
 
     if (master->dc_ref_clock) {
-        uint32_t delay = 0;
-        ec_slave_calc_transmission_delays_rec(master->dc_ref_clock, &delay);
+        ec_slave_calc_transmission_delays(master->dc_ref_clock);
     }
 }
 
@@ -2229,6 +4151,9 @@ void ec_master_request_op(
         slave = master->slaves + i;
         if (slave->config) {
             ec_slave_request_state(slave, EC_SLAVE_STATE_OP);
+        } else if (slave->requested_state == EC_SLAVE_STATE_SAFEOP) {
+            // handed over, but not used by the new application
+            ec_slave_request_state(slave, EC_SLAVE_STATE_PREOP);
         }
     }
 
@@ -2293,10 +4218,40 @@ ec_domain_t *ecrt_master_create_domain(
 
 /*****************************************************************************/
 
+/** Determines the DC cycle time of the bus configuration.
+ *
+ * Uses the SYNC0 cycle of the application-selected reference clock, or of
+ * the first slave configuration with DC enabled.
+ *
+ * \return Cycle time in ns, or zero.
+ */
+static u32 ec_master_dc_cycle_time(
+        const ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    const ec_slave_config_t *sc;
+
+    sc = master->dc_ref_config;
+    if (sc && sc->dc_assign_activate && sc->dc_sync[0].cycle_time) {
+        return sc->dc_sync[0].cycle_time;
+    }
+
+    list_for_each_entry(sc, &master->configs, list) {
+        if (sc->dc_assign_activate && sc->dc_sync[0].cycle_time) {
+            return sc->dc_sync[0].cycle_time;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 int ecrt_master_activate(ec_master_t *master)
 {
     uint32_t domain_offset;
     ec_domain_t *domain;
+    ktime_t start = ktime_get();
     int ret;
 #ifdef EC_EOE
     int eoe_was_running;
@@ -2325,6 +4280,11 @@ int ecrt_master_activate(ec_master_t *master)
 
     up(&master->master_sem);
 
+    // mailbox transfers during operation shall not hit the page allocator
+    if (ec_payload_reserve(EC_PAYLOAD_RESERVE + 2 * master->slave_count)) {
+        EC_MASTER_WARN(master, "Failed to reserve payload memory.\n");
+    }
+
     // restart EoE process and master thread with new locking
 
     ec_master_thread_stop(master);
@@ -2333,6 +4293,8 @@ int ecrt_master_activate(ec_master_t *master)
     ec_master_eoe_stop(master);
 #endif
 
+    ec_master_build_frame_templates(master);
+
     EC_MASTER_DBG(master, 1, "FSM datagram is %p.\n", &master->fsm_datagram);
 
     master->injection_seq_fsm = 0;
@@ -2357,6 +4319,17 @@ int ecrt_master_activate(ec_master_t *master)
     /* Allow scanning after a topology change. */
     master->allow_scan = 1;
 
+    down(&master->master_sem);
+    ec_startup_profile_record(&master->startup_profile, EC_STARTUP_ACTIVATE,
+            EC_STARTUP_MASTER, start, 0);
+    up(&master->master_sem);
+
+    ec_master_dc_stats_clear(&master->dc_stats);
+    master->dc_stats.cycle_time = ec_master_dc_cycle_time(master);
+    ec_master_latency_stats_clear(master);
+    master->send_latency = 0;
+    master->app_send_time = 0ULL;
+
     master->active = 1;
 
     // notify state machine, that the configuration shall now be applied
@@ -2391,13 +4364,30 @@ void ecrt_master_deactivate(ec_master_t *master)
     master->send_cb = ec_master_internal_send_cb;
     master->receive_cb = ec_master_internal_receive_cb;
     master->cb_data = master;
+    master->timed_cycle_flags = 0;
+    master->cycle_cb = NULL;
+    master->cycle_cb_data = NULL;
+    master->cycle_trigger_ext = NULL;
 
+    ec_master_clear_frame_templates(master);
     ec_master_clear_config(master);
 
     for (slave = master->slaves;
             slave < master->slaves + master->slave_count;
             slave++) {
 
+        /* In handover mode, configured slaves wait in SAFEOP for the next
+         * application, so that an unchanged configuration can be resumed
+         * without going through INIT. Their outputs are in the safe state
+         * meanwhile. */
+        if (ec_handover && slave->config_applied && !slave->error_flag
+                && (slave->current_state == EC_SLAVE_STATE_SAFEOP
+                    || slave->current_state == EC_SLAVE_STATE_OP)) {
+            slave->group_op = 0;
+            ec_slave_request_state(slave, EC_SLAVE_STATE_SAFEOP);
+            continue;
+        }
+
         // set states for all slaves
         ec_slave_request_state(slave, EC_SLAVE_STATE_PREOP);
 
@@ -2417,6 +4407,7 @@ void ecrt_master_deactivate(ec_master_t *master)
 
     master->app_time = 0ULL;
     master->dc_ref_time = 0ULL;
+    ec_master_dc_servo_reset(&master->dc_servo);
 
 #ifdef EC_EOE
     if (eoe_was_running) {
@@ -2437,29 +4428,121 @@ void ecrt_master_deactivate(ec_master_t *master)
 
 /*****************************************************************************/
 
-void ecrt_master_send(ec_master_t *master)
+/** Sums up the totals, whose differences over a send cycle make up the cycle
+ * counters.
+ */
+static void ec_master_cycle_totals(
+        const ec_master_t *master, /**< EtherCAT master. */
+        u64 *frames, /**< Frames sent (output). */
+        u64 *bytes, /**< Bytes sent (output). */
+        u64 *queued /**< Datagrams sent or left in the queue (output). */
+        )
+{
+    unsigned int i;
+
+    *frames = master->device_stats.tx_count;
+    *bytes = master->device_stats.tx_bytes;
+    *queued = 0;
+
+    for (i = 0; i < EC_TC_COUNT; i++) {
+        *queued += master->traffic_classes[i].datagrams
+            + master->traffic_classes[i].deferred;
+    }
+}
+
+/*****************************************************************************/
+
+/** Publishes the counters of a send cycle.
+ */
+static void ec_master_update_cycle_counters(
+        ec_master_t *master, /**< EtherCAT master. */
+        u64 frames, /**< Frames sent before the cycle. */
+        u64 bytes, /**< Bytes sent before the cycle. */
+        u64 queued, /**< Datagrams queued before the cycle. */
+        unsigned int injected, /**< Injected external datagrams. */
+        unsigned int deferred /**< Deferred external datagrams. */
+        )
+{
+    ec_cycle_counters_t *c = &master->counters.cycle;
+    u64 frames_now, bytes_now, queued_now;
+
+    ec_master_cycle_totals(master, &frames_now, &bytes_now, &queued_now);
+
+    preempt_disable();
+    write_seqcount_begin(&master->counters.cycle_seq);
+    c->cycles++;
+    c->frames = (u32) (frames_now - frames);
+    c->frames_max = max(c->frames_max, c->frames);
+    c->bytes = (u32) (bytes_now - bytes);
+    c->bytes_max = max(c->bytes_max, c->bytes);
+    c->queued = (u32) (queued_now - queued);
+    c->queued_max = max(c->queued_max, c->queued);
+    c->injected += injected;
+    c->deferred += deferred;
+    write_seqcount_end(&master->counters.cycle_seq);
+    preempt_enable();
+}
+
+/*****************************************************************************/
+
+/** Publishes the duration of a state machine execution.
+ */
+static void ec_master_update_fsm_counters(
+        ec_master_t *master, /**< EtherCAT master. */
+        ktime_t start /**< Start of the execution. */
+        )
+{
+    ec_fsm_counters_t *c = &master->counters.fsm;
+    u32 exec_time = (u32) ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    preempt_disable();
+    write_seqcount_begin(&master->counters.fsm_seq);
+    c->exec_count++;
+    c->exec_time = exec_time;
+    c->exec_time_max = max(c->exec_time_max, exec_time);
+    write_seqcount_end(&master->counters.fsm_seq);
+    preempt_enable();
+}
+
+/*****************************************************************************/
+
+/** Sends the queued datagrams.
+ *
+ * Does all of ecrt_master_send() except queuing the domain datagrams.
+ *
+ * The frames of the devices are built in turns. With redundancy, the first
+ * frame of each device is handed to the hardware at once, so that the main
+ * and backup frames are on the wire in parallel, while the remaining frames
+ * are built.
+ */
+static void ec_master_send(ec_master_t *master /**< EtherCAT master. */)
 {
     ec_datagram_t *datagram, *n;
     ec_device_index_t dev_idx;
+    unsigned int injected, deferred, sending = 0;
+    u64 frames, bytes, queued;
+    ec_master_tx_state_t tx[EC_MAX_NUM_DEVICES];
 
     if (master->injection_seq_rt != master->injection_seq_fsm) {
-        // inject datagram produced by master FSM
-        ec_master_queue_datagram(master, &master->fsm_datagram);
+        // inject datagrams produced by master FSM
+        ec_master_queue_fsm_datagrams(master);
         master->injection_seq_rt = master->injection_seq_fsm;
     }
 
-    ec_master_inject_external_datagrams(master);
+    ec_master_inject_external_datagrams(master, &injected, &deferred);
+    ec_master_cycle_totals(master, &frames, &bytes, &queued);
 
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
         if (unlikely(!master->devices[dev_idx].link_state)) {
             // link is down, no datagram can be sent
             list_for_each_entry_safe(datagram, n,
-                    &master->datagram_queue, queue) {
-                if (datagram->device_index == dev_idx) {
-                    datagram->state = EC_DATAGRAM_ERROR;
-                    list_del_init(&datagram->queue);
-                }
+                    &master->devices[dev_idx].datagram_queue, queue) {
+                datagram->state = EC_DATAGRAM_ERROR;
+                ec_master_unaccount_datagram(master, datagram);
+                list_del_init(&datagram->queue);
+                list_del_init(&datagram->sent);
+                ec_datagram_release_slot(datagram);
             }
 
             if (!master->devices[dev_idx].dev) {
@@ -2474,39 +4557,137 @@ void ecrt_master_send(ec_master_t *master)
             continue;
         }
 
-        // send frames
-        ec_master_send_datagrams(master, dev_idx);
+        // free the transmit ring entries of the last cycle
+        ec_device_reclaim(&master->devices[dev_idx]);
+        ec_master_send_start(master, dev_idx, &tx[dev_idx]);
+        sending |= 1 << dev_idx;
+    }
+
+    while (sending) {
+        for (dev_idx = EC_DEVICE_MAIN;
+                dev_idx < ec_master_num_devices(master); dev_idx++) {
+            if (!(sending & (1 << dev_idx))) {
+                continue;
+            }
+
+            ec_master_send_frame(master, dev_idx, &tx[dev_idx]);
+
+            if (!tx[dev_idx].more) {
+                ec_master_send_finish(master, dev_idx, &tx[dev_idx]);
+                sending &= ~(1 << dev_idx);
+            } else if (tx[dev_idx].frame_count == 1
+                    && ec_master_num_devices(master) > 1) {
+                ec_device_flush(&master->devices[dev_idx]);
+            }
+        }
+    }
+
+    ec_master_update_cycle_counters(master, frames, bytes, queued,
+            injected, deferred);
+}
+
+/*****************************************************************************/
+
+void ecrt_master_send(ec_master_t *master)
+{
+    ec_domain_t *domain;
+    ktime_t start = ktime_get();
+
+    if (master->active) {
+        if (unlikely(master->latency_stats.reset)) {
+            ec_master_latency_stats_clear(master);
+        }
+
+        list_for_each_entry(domain, &master->domains, list) {
+            ec_domain_auto_queue(domain);
+            if (domain == master->dc_domain && domain->queue_pending
+                    && master->dc_ref_clock) {
+                // DC datagrams go in front of the domain's datagrams
+                if (master->dc_ref_sync_pending) {
+                    ec_master_queue_datagram(master,
+                            &master->ref_sync_datagram);
+                    master->dc_ref_sync_pending = 0;
+                }
+                ec_master_queue_slave_sync(master);
+            }
+            ec_domain_queue_datagrams(domain);
+        }
+        ec_master_take_ext_datagrams(master);
+        ec_master_dc_stats_send(master);
+        WRITE_ONCE(master->app_send_time, ktime_to_ns(start));
+    }
+
+    ec_master_send(master);
+
+    if (master->active) {
+        u32 latency = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+        if (latency > master->send_latency) {
+            master->send_latency = latency;
+        } else {
+            master->send_latency -= (master->send_latency - latency)
+                >> EC_SEND_LATENCY_DECAY_SHIFT;
+        }
+
+        ec_latency_histogram_add(&master->latency_stats.send, latency);
     }
 }
 
 /*****************************************************************************/
 
+int ecrt_master_send_at(ec_master_t *master, uint64_t tx_time_ns)
+{
+    master->tx_launch_time = tx_time_ns;
+    ecrt_master_send(master);
+    master->tx_launch_time = 0ULL;
+    return 0;
+}
+
+/*****************************************************************************/
+
 void ecrt_master_receive(ec_master_t *master)
 {
     unsigned int dev_idx;
+    ec_device_t *device;
     ec_datagram_t *datagram, *next;
+    ktime_t start = ktime_get(), now;
 
     // receive datagrams
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
         ec_device_poll(&master->devices[dev_idx]);
     }
-    ec_master_update_device_stats(master);
+    now = ktime_get();
+
+    /* dequeue all datagrams that timed out. The sent queue is ordered by
+     * deadline, so the sweep can stop at the first datagram that has not
+     * timed out. */
+    for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
+            dev_idx++) {
+        device = &master->devices[dev_idx];
 
-    // dequeue all datagrams that timed out
-    list_for_each_entry_safe(datagram, next, &master->datagram_queue, queue) {
-        if (datagram->state != EC_DATAGRAM_SENT) continue;
+        list_for_each_entry_safe(datagram, next,
+                &device->sent_queue, sent) {
+            if (datagram->state != EC_DATAGRAM_SENT) {
+                // re-queued in the meantime
+                list_del_init(&datagram->sent);
+                continue;
+            }
 
-#ifdef EC_HAVE_CYCLES
-        if (master->devices[EC_DEVICE_MAIN].cycles_poll -
-                datagram->cycles_sent > timeout_cycles) {
-#else
-        if (master->devices[EC_DEVICE_MAIN].jiffies_poll -
-                datagram->jiffies_sent > timeout_jiffies) {
-#endif
+            if (ktime_to_ns(now) <= ktime_to_ns(datagram->deadline)) {
+                break;
+            }
+
+            /* The datagram keeps its entry in the table of sent datagrams,
+             * so that a late response can be accounted to it. */
+            ec_master_unaccount_datagram(master, datagram);
             list_del_init(&datagram->queue);
-            datagram->state = EC_DATAGRAM_TIMED_OUT;
+            list_del_init(&datagram->sent);
+            datagram->stats.timeouts++;
             master->stats.timeouts++;
+            ec_device_timeout_history_add(device, datagram);
+            trace_ec_datagram_timeout(master->index, dev_idx, datagram);
+            smp_store_release(&datagram->state, EC_DATAGRAM_TIMED_OUT);
 
 #ifdef EC_RT_SYSLOG
             ec_master_output_stats(master);
@@ -2515,35 +4696,188 @@ void ecrt_master_receive(ec_master_t *master)
                 unsigned int time_us;
 #ifdef EC_HAVE_CYCLES
                 time_us = (unsigned int)
-                    (master->devices[EC_DEVICE_MAIN].cycles_poll -
-                        datagram->cycles_sent) * 1000 / cpu_khz;
+                    (device->cycles_poll - datagram->cycles_sent)
+                    * 1000 / cpu_khz;
 #else
                 time_us = (unsigned int)
-                    ((master->devices[EC_DEVICE_MAIN].jiffies_poll -
-                            datagram->jiffies_sent) * 1000000 / HZ);
+                    ((device->jiffies_poll - datagram->jiffies_sent)
+                     * 1000000 / HZ);
 #endif
-                EC_MASTER_DBG(master, 0, "TIMED OUT datagram %p,"
-                        " index %02X waited %u us.\n",
+                EC_MASTER_RT_DBG(master, 0, EC_RT_LOG_DATAGRAM,
+                        "TIMED OUT datagram %p, index %02X waited %u us.\n",
                         datagram, datagram->index, time_us);
             }
 #endif /* RT_SYSLOG */
         }
     }
+
+    if (master->active) {
+        ec_latency_histogram_add(&master->latency_stats.receive,
+                ktime_to_ns(ktime_sub(ktime_get(), start)));
+    }
 }
 
 /*****************************************************************************/
 
-void ecrt_master_send_ext(ec_master_t *master)
+/** Checks, if any of the application's cyclic datagrams waits for reception.
+ *
+ * \return Non-zero, if a domain or distributed clocks datagram was sent and
+ *         not yet received.
+ */
+static int ec_master_cyclic_awaiting_reception(
+        const ec_master_t *master /**< EtherCAT master. */
+        )
 {
-    ec_datagram_t *datagram, *next;
+    const ec_domain_t *domain;
 
-    list_for_each_entry_safe(datagram, next, &master->ext_datagram_queue,
-            queue) {
-        list_del(&datagram->queue);
-        ec_master_queue_datagram(master, datagram);
+    if (master->ref_sync_datagram.state == EC_DATAGRAM_SENT
+            || master->sync_datagram.state == EC_DATAGRAM_SENT
+            || master->sync_mon_datagram.state == EC_DATAGRAM_SENT) {
+        return 1;
     }
 
-    ecrt_master_send(master);
+    list_for_each_entry(domain, &master->domains, list) {
+        if (ec_domain_awaiting_reception(domain)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_receive_wait(ec_master_t *master, uint64_t deadline_ns)
+{
+    while (1) {
+        ecrt_master_receive(master);
+
+        if (!ec_master_cyclic_awaiting_reception(master)) {
+            return 0;
+        }
+
+        if ((uint64_t) ktime_to_ns(ktime_get()) >= deadline_ns) {
+            return -ETIMEDOUT;
+        }
+
+        cpu_relax();
+    }
+}
+
+/*****************************************************************************/
+
+int ecrt_master_set_timed_cycle(ec_master_t *master, unsigned int flags)
+{
+    EC_MASTER_DBG(master, 1, "ecrt_master_set_timed_cycle(master = 0x%p,"
+            " flags = 0x%x)\n", master, flags);
+
+    if (master->active) {
+        EC_MASTER_ERR(master, "Master-timed cycle can not be changed"
+                " while the master is active!\n");
+        return -EBUSY;
+    }
+
+    if (flags && !(flags & EC_CYCLE_TRIGGERED) && !master->send_interval) {
+        EC_MASTER_ERR(master, "Master-timed cycle needs a send interval!\n");
+        return -EINVAL;
+    }
+
+    master->timed_cycle_flags = flags;
+    master->cycle_trigger_seen = master->cycle_trigger;
+    return 0;
+}
+
+/*****************************************************************************/
+
+void ecrt_master_trigger_cycle(ec_master_t *master)
+{
+    smp_wmb(); // publish the outputs before the trigger
+    WRITE_ONCE(master->cycle_trigger, master->cycle_trigger + 1);
+}
+
+/*****************************************************************************/
+
+int ecrt_master_set_traffic_class(ec_master_t *master,
+        ec_traffic_class_t traffic_class, unsigned int priority,
+        size_t budget)
+{
+    ec_traffic_class_info_t *tc;
+
+    if ((unsigned int) traffic_class >= EC_TC_COUNT
+            || (traffic_class == EC_TC_CYCLIC && budget)) {
+        EC_MASTER_ERR(master, "Invalid traffic class %u or budget %zu.\n",
+                (unsigned int) traffic_class, budget);
+        return -EINVAL;
+    }
+
+    if (master->active) {
+        EC_MASTER_ERR(master, "Traffic classes can only be set"
+                " before activation.\n");
+        return -EBUSY;
+    }
+
+    EC_MASTER_DBG(master, 1, "ecrt_master_set_traffic_class(master = 0x%p,"
+            " traffic_class = %u, priority = %u, budget = %zu)\n",
+            master, (unsigned int) traffic_class, priority, budget);
+
+    down(&master->io_sem);
+    tc = &master->traffic_classes[traffic_class];
+    tc->priority = priority;
+    tc->budget = budget;
+    ec_master_sort_traffic_classes(master);
+    up(&master->io_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Queues the datagrams of the non-application datagram queue.
+ *
+ * This is called by ecrt_master_send() in operation phase, so that the EoE
+ * datagrams are exchanged in the application's cycle without any callbacks
+ * and without a lock shared with the EoE thread: The EoE thread hands its
+ * datagrams over via the lock-free queue, and evaluates them as soon as
+ * their state was set to a final state by ecrt_master_receive(). Callers are
+ * serialized by the application (or the master's \a io_sem in idle phase).
+ */
+static void ec_master_take_ext_datagrams(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_datagram_t *datagram;
+    unsigned int idx = master->ext_queue_idx_rt;
+    unsigned int end = smp_load_acquire(&master->ext_queue_idx_eoe);
+    size_t budget = master->max_queue_size * master->eoe_share / 100;
+    size_t queue_size = 0;
+
+    while (idx != end) {
+        /* Check the EoE share of the cycle before taking the datagram. The
+         * first datagram is always taken, so that EoE keeps going even if
+         * its share is smaller than a mailbox. */
+        datagram = READ_ONCE(master->ext_datagram_queue[idx]);
+        if (datagram && master->eoe_share) {
+            if (queue_size && queue_size + datagram->data_size > budget) {
+                master->traffic_classes[datagram->traffic_class].held++;
+                break;
+            }
+            queue_size += datagram->data_size;
+        }
+
+        datagram = xchg(&master->ext_datagram_queue[idx], NULL);
+        if (datagram) {
+            ec_master_queue_datagram(master, datagram);
+        }
+        idx = (idx + 1) % EC_EXT_QUEUE_SIZE;
+    }
+    smp_store_release(&master->ext_queue_idx_rt, idx);
+}
+
+/*****************************************************************************/
+
+void ecrt_master_send_ext(ec_master_t *master)
+{
+    ec_master_take_ext_datagrams(master);
+    ec_master_send(master);
 }
 
 /*****************************************************************************/
@@ -2555,22 +4889,21 @@ ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
         uint32_t product_code)
 {
     ec_slave_config_t *sc;
-    unsigned int found = 0;
-
+    int ret;
 
     EC_MASTER_DBG(master, 1, "ecrt_master_slave_config(master = 0x%p,"
             " alias = %u, position = %u, vendor_id = 0x%08x,"
             " product_code = 0x%08x)\n",
             master, alias, position, vendor_id, product_code);
 
-    list_for_each_entry(sc, &master->configs, list) {
+    for (sc = master->config_hash[ec_master_config_hash(alias, position)];
+            sc; sc = sc->hash_next) {
         if (sc->alias == alias && sc->position == position) {
-            found = 1;
             break;
         }
     }
 
-    if (found) { // config with same alias/position already existing
+    if (sc) { // config with same alias/position already existing
         if (sc->vendor_id != vendor_id || sc->product_code != product_code) {
             EC_MASTER_ERR(master, "Slave type mismatch. Slave was"
                     " configured as 0x%08X/0x%08X before. Now configuring"
@@ -2595,10 +4928,19 @@ ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
 
         down(&master->master_sem);
 
+        ret = ec_master_add_config(master, sc);
+        if (ret) {
+            up(&master->master_sem);
+            EC_MASTER_ERR(master, "Failed to allocate memory"
+                    " for slave configuration index.\n");
+            ec_slave_config_clear(sc);
+            kfree(sc);
+            return ERR_PTR(ret);
+        }
+
         // try to find the addressed slave
         ec_slave_config_attach(sc);
         ec_slave_config_load_default_sync_config(sc);
-        list_add_tail(&sc->list, &master->configs);
 
         up(&master->master_sem);
     }
@@ -2639,6 +4981,30 @@ int ecrt_master_select_reference_clock(ec_master_t *master,
 
 /*****************************************************************************/
 
+int ecrt_master_select_dc_domain(ec_master_t *master, ec_domain_t *domain)
+{
+    ec_traffic_class_t tc = domain ? EC_TC_CYCLIC : EC_TC_DC;
+
+    EC_MASTER_DBG(master, 1, "ecrt_master_select_dc_domain(master = 0x%p,"
+            " domain = 0x%p)\n", master, domain);
+
+    if (master->active && domain) {
+        EC_MASTER_ERR(master, "Can not select the DC domain"
+                " while the master is active!\n");
+        return -EBUSY;
+    }
+
+    /* The DC datagrams share the traffic class of the process data, so that
+     * they are sent in the same frame as the domain's datagrams. */
+    master->ref_sync_datagram.traffic_class = tc;
+    master->sync_datagram.traffic_class = tc;
+    master->dc_domain = domain;
+    master->dc_ref_sync_pending = 0;
+    return 0;
+}
+
+/*****************************************************************************/
+
 int ecrt_master(ec_master_t *master, ec_master_info_t *master_info)
 {
     EC_MASTER_DBG(master, 1, "ecrt_master(master = 0x%p,"
@@ -2768,6 +5134,27 @@ int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
 
 /*****************************************************************************/
 
+int ecrt_master_slave_config_states(const ec_master_t *master,
+        ec_slave_config_state_t *states, unsigned int count)
+{
+    const ec_slave_config_t *sc;
+    unsigned int i = 0;
+
+    /* no locking of master_sem needed, because configurations are not
+     * deleted while the application uses them. */
+
+    list_for_each_entry(sc, &master->configs, list) {
+        if (i >= count) {
+            break;
+        }
+        ecrt_slave_config_state(sc, &states[i++]);
+    }
+
+    return i;
+}
+
+/*****************************************************************************/
+
 void ecrt_master_application_time(ec_master_t *master, uint64_t app_time)
 {
     master->app_time = app_time;
@@ -2798,15 +5185,43 @@ int ecrt_master_reference_clock_time(ec_master_t *master, uint32_t *time)
 
 /*****************************************************************************/
 
-void ecrt_master_sync_reference_clock(ec_master_t *master)
+int ecrt_master_reference_clock_time64(ec_master_t *master, uint64_t *time)
 {
-    if (master->dc_ref_clock) {
-        EC_WRITE_U32(master->ref_sync_datagram.data, master->app_time);
-        ec_master_queue_datagram(master, &master->ref_sync_datagram);
-    }
-}
+    ec_datagram_t *datagram = &master->sync_datagram;
+    uint32_t delay;
 
-/*****************************************************************************/
+    if (!master->dc_ref_clock) {
+        return -ENXIO;
+    }
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED) {
+        return -EIO;
+    }
+
+    delay = master->dc_ref_clock->transmission_delay;
+
+    if (datagram->data_size == 8) {
+        *time = EC_READ_U64(datagram->data) - delay;
+    } else {
+        /* Extend a 32 bit time by the application time at the sync. The
+         * clocks are synchronized, so the distance is less than 2 s. */
+        u64 app_time = master->dc_servo.app_time;
+        uint32_t low = EC_READ_U32(datagram->data) - delay;
+
+        *time = app_time + (s32) (low - (uint32_t) app_time);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+void ecrt_master_sync_reference_clock(ec_master_t *master)
+{
+    ecrt_master_sync_reference_clock_to(master, master->app_time);
+}
+
+/*****************************************************************************/
 
 void ecrt_master_sync_reference_clock_to(
         ec_master_t *master,
@@ -2814,35 +5229,489 @@ void ecrt_master_sync_reference_clock_to(
         )
 {
     if (master->dc_ref_clock) {
-        EC_WRITE_U32(master->ref_sync_datagram.data, sync_time);
-        ec_master_queue_datagram(master, &master->ref_sync_datagram);
+        if (master->ref_sync_datagram.data_size == 8) {
+            EC_WRITE_U64(master->ref_sync_datagram.data, sync_time);
+        } else {
+            EC_WRITE_U32(master->ref_sync_datagram.data, sync_time);
+        }
+        if (master->dc_domain) {
+            master->dc_ref_sync_pending = 1;
+        } else {
+            ec_master_queue_datagram(master, &master->ref_sync_datagram);
+        }
     }
 }
 
 /*****************************************************************************/
 
+/** Queues the DC drift compensation datagram.
+ */
+static void ec_master_queue_slave_sync(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    // record the last result, if the application did not ask for it
+    ec_master_dc_servo_update(master);
+    ec_datagram_zero(&master->sync_datagram);
+    ec_master_queue_datagram(master, &master->sync_datagram);
+    master->dc_servo.pending = 1;
+    master->dc_servo.app_time = master->app_time;
+}
+
+/*****************************************************************************/
+
 void ecrt_master_sync_slave_clocks(ec_master_t *master)
 {
-    if (master->dc_ref_clock) {
-        ec_datagram_zero(&master->sync_datagram);
-        ec_master_queue_datagram(master, &master->sync_datagram);
+    // with a DC domain, ecrt_master_send() takes care of this
+    if (master->dc_ref_clock && !master->dc_domain) {
+        ec_master_queue_slave_sync(master);
+    }
+}
+
+/*****************************************************************************/
+
+/** Adds a sample to a DC histogram.
+ */
+static void ec_dc_histogram_add(
+        ec_dc_histogram_t *hist, /**< DC histogram. */
+        s32 value /**< Sample in ns. */
+        )
+{
+    u32 abs_value = value < 0 ? -(u32) value : value;
+    unsigned int bin = fls(abs_value >> 6);
+
+    if (!hist->count || value < hist->min) {
+        hist->min = value;
+    }
+    if (!hist->count || value > hist->max) {
+        hist->max = value;
+    }
+    hist->count++;
+    hist->sum += value;
+    hist->bins[min(bin, EC_DC_HISTOGRAM_BINS - 1U)]++;
+}
+
+/*****************************************************************************/
+
+/** Clears the DC statistics.
+ *
+ * Keeps the cycle time.
+ */
+static void ec_master_dc_stats_clear(
+        ec_dc_stats_t *stats /**< DC statistics. */
+        )
+{
+    stats->reset = 0;
+    stats->last_send = 0ULL;
+    stats->sync_mon_pending = 0;
+    memset(&stats->sync_monitor, 0, sizeof(stats->sync_monitor));
+    memset(&stats->ref_offset, 0, sizeof(stats->ref_offset));
+    memset(&stats->send_jitter, 0, sizeof(stats->send_jitter));
+    stats->sync0_calibrate = 0;
+    stats->sync0_cycles_left = 0;
+    stats->sync0_anchor = 0;
+    memset(&stats->sync0_margin, 0, sizeof(stats->sync0_margin));
+}
+
+/*****************************************************************************/
+
+/** Records the send time jitter relative to the DC cycle.
+ *
+ * Also executes a pending statistics reset. Called by ecrt_master_send().
+ */
+static void ec_master_dc_stats_send(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_dc_stats_t *stats = &master->dc_stats;
+    u64 now;
+    s64 jitter;
+
+    if (unlikely(stats->reset)) {
+        ec_master_dc_stats_clear(stats);
+    }
+
+    if (unlikely(stats->sync0_calibrate)) {
+        stats->sync0_cycles_left = stats->sync0_calibrate;
+        stats->sync0_calibrate = 0;
+        memset(&stats->sync0_margin, 0, sizeof(stats->sync0_margin));
+    }
+
+    if (!stats->cycle_time) {
+        return;
+    }
+
+    now = ktime_to_ns(ktime_get());
+    if (stats->last_send) {
+        jitter = (s64) (now - stats->last_send) - stats->cycle_time;
+        if (jitter > INT_MAX) {
+            jitter = INT_MAX;
+        }
+        ec_dc_histogram_add(&stats->send_jitter, jitter);
+    }
+    stats->last_send = now;
+}
+
+/*****************************************************************************/
+
+/** Adds a sample to a latency histogram.
+ */
+void ec_latency_histogram_add(
+        ec_latency_histogram_t *hist, /**< Latency histogram. */
+        u32 value /**< Duration in ns. */
+        )
+{
+    unsigned int bin = fls(value >> 6);
+
+    if (!hist->count || value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->count++;
+    hist->sum += value;
+    hist->bins[min(bin, EC_LATENCY_HISTOGRAM_BINS - 1U)]++;
+}
+
+/*****************************************************************************/
+
+/** Clears the latency statistics of the master and of all domains.
+ */
+static void ec_master_latency_stats_clear(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_latency_stats_t *stats = &master->latency_stats;
+    ec_domain_t *domain;
+
+    stats->reset = 0;
+    memset(&stats->send, 0, sizeof(stats->send));
+    memset(&stats->receive, 0, sizeof(stats->receive));
+
+    list_for_each_entry(domain, &master->domains, list) {
+        memset(&domain->round_trip, 0, sizeof(domain->round_trip));
+        memset(&domain->process_time, 0, sizeof(domain->process_time));
+    }
+}
+
+/*****************************************************************************/
+
+/** Records the SYNC0 margins of a received sync datagram.
+ *
+ * For each slave configuration with SYNC0, calculates the time from the end
+ * of the process data frame passing the slave to its next SYNC0 event. The
+ * smallest margin of the cycle is added to the histogram. Margins are
+ * unwrapped against the first one of the calibration window, so that frames
+ * arriving after the SYNC0 event show up as negative values instead of
+ * almost a full cycle.
+ */
+static void ec_master_dc_stats_sync0(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_dc_stats_t *stats = &master->dc_stats;
+    const ec_slave_config_t *sc;
+    u64 ref_time;
+    u32 frame_time;
+    s32 margin = 0;
+    unsigned int found = 0;
+
+    if (!master->dc_ref_time
+            || ecrt_master_reference_clock_time64(master, &ref_time)) {
+        return;
+    }
+
+    frame_time = ec_master_frame_time(master);
+
+    list_for_each_entry(sc, &master->configs, list) {
+        u32 cycle = sc->dc_sync[0].cycle_time, remainder;
+        s32 m;
+        u64 diff;
+
+        if (!sc->dc_assign_activate || !cycle || !sc->slave) {
+            continue;
+        }
+
+        /* The SYNC0 events are in phase with ec_master::dc_ref_time, see
+         * ec_fsm_slave_config_enter_dc_start(). */
+        diff = ref_time + sc->slave->transmission_delay + frame_time
+            - master->dc_ref_time - sc->dc_sync[0].shift_time;
+        remainder = do_div(diff, cycle);
+        m = cycle - remainder;
+
+        if (stats->sync0_margin.count) {
+            if (m - stats->sync0_anchor > (s32) (cycle / 2)) {
+                m -= cycle;
+            } else if (stats->sync0_anchor - m > (s32) (cycle / 2)) {
+                m += cycle;
+            }
+        }
+
+        if (!found || m < margin) {
+            margin = m;
+            found = 1;
+        }
+    }
+
+    if (!found) {
+        return;
+    }
+
+    if (!stats->sync0_margin.count) {
+        stats->sync0_anchor = margin;
+    }
+    ec_dc_histogram_add(&stats->sync0_margin, margin);
+    stats->sync0_cycles_left--;
+}
+
+/*****************************************************************************/
+
+/** Resets the DC servo.
+ */
+static void ec_master_dc_servo_reset(
+        ec_dc_servo_t *servo /**< DC servo. */
+        )
+{
+    servo->pending = 0;
+    servo->app_time = 0ULL;
+    servo->valid = 0;
+    servo->diff = 0;
+    servo->filter = 0LL;
+    servo->integral = 0LL;
+    servo->correction = 0;
+}
+
+/*****************************************************************************/
+
+/** Evaluates the last sync datagram in the DC servo.
+ *
+ * Runs a PI controller on the difference between the application time and
+ * the returned reference clock time. Does nothing, if the result of the
+ * sync datagram was already evaluated.
+ */
+static void ec_master_dc_servo_update(
+        ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    ec_dc_servo_t *servo = &master->dc_servo;
+    s32 correction;
+    u32 ref_time;
+
+    if (!servo->pending
+            || master->sync_datagram.state == EC_DATAGRAM_QUEUED
+            || master->sync_datagram.state == EC_DATAGRAM_SENT) {
+        return;
+    }
+
+    servo->pending = 0;
+
+    if (master->sync_datagram.state != EC_DATAGRAM_RECEIVED
+            || !master->dc_ref_clock) {
+        servo->correction = 0; // skip the cycle, keep the integral
+        return;
+    }
+
+    ref_time = EC_READ_U32(master->sync_datagram.data) -
+        master->dc_ref_clock->transmission_delay;
+    servo->diff = (u32) servo->app_time - ref_time;
+    ec_dc_histogram_add(&master->dc_stats.ref_offset, servo->diff);
+
+    if (unlikely(master->dc_stats.sync0_cycles_left)) {
+        ec_master_dc_stats_sync0(master);
+    }
+
+    if (!servo->valid) {
+        servo->filter = (s64) servo->diff << EC_DC_SERVO_FILTER_SHIFT;
+        servo->valid = 1;
+    } else {
+        servo->filter += servo->diff -
+            (servo->filter >> EC_DC_SERVO_FILTER_SHIFT);
+    }
+
+    correction = (servo->diff >> EC_DC_SERVO_KP_SHIFT) +
+        (s32) ((servo->integral + servo->diff) >> EC_DC_SERVO_KI_SHIFT);
+
+    // integrate only while not saturated (anti-windup)
+    if (correction > EC_DC_SERVO_MAX_CORRECTION) {
+        correction = EC_DC_SERVO_MAX_CORRECTION;
+    } else if (correction < -EC_DC_SERVO_MAX_CORRECTION) {
+        correction = -EC_DC_SERVO_MAX_CORRECTION;
+    } else {
+        servo->integral += servo->diff;
+    }
+
+    servo->correction = correction;
+}
+
+/*****************************************************************************/
+
+int32_t ecrt_master_dc_cycle_correction(ec_master_t *master)
+{
+    ec_master_dc_servo_update(master);
+    return master->dc_servo.correction;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_dc_time(ec_master_t *master, uint64_t *time)
+{
+    ec_dc_servo_t *servo = &master->dc_servo;
+
+    if (!master->dc_ref_clock) {
+        return -ENXIO;
     }
+
+    ec_master_dc_servo_update(master);
+
+    if (!servo->valid) {
+        return -EAGAIN;
+    }
+
+    *time = servo->app_time - (servo->filter >> EC_DC_SERVO_FILTER_SHIFT);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Calculates the time needed to transmit the process data frame.
+ *
+ * \return Transmission time in ns.
+ */
+static u32 ec_master_frame_time(
+        const ec_master_t *master /**< EtherCAT master. */
+        )
+{
+    const ec_domain_t *domain;
+    const ec_datagram_pair_t *datagram_pair;
+    size_t size = master->devices[EC_DEVICE_MAIN].header_size
+        + EC_FRAME_HEADER_SIZE;
+
+    list_for_each_entry(domain, &master->domains, list) {
+        list_for_each_entry(datagram_pair, &domain->datagram_pairs, list) {
+            size += EC_DATAGRAM_HEADER_SIZE + EC_DATAGRAM_FOOTER_SIZE
+                + datagram_pair->datagrams[EC_DEVICE_MAIN].data_size;
+        }
+    }
+
+    if (master->dc_domain) {
+        size += EC_DATAGRAM_HEADER_SIZE + EC_DATAGRAM_FOOTER_SIZE
+            + master->sync_datagram.data_size;
+    }
+
+    return size * EC_BYTE_TRANSMISSION_TIME_NS;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_next_send_time(ec_master_t *master, uint32_t margin,
+        uint64_t *time)
+{
+    const ec_slave_config_t *sc;
+    u64 app_time = master->app_time, send_time = 0ULL;
+    u32 lead = margin + ec_master_frame_time(master) + master->send_latency;
+
+    if (!master->dc_ref_clock) {
+        return -ENXIO;
+    }
+
+    if (!master->active || !master->dc_ref_time) {
+        return -EAGAIN;
+    }
+
+    list_for_each_entry(sc, &master->configs, list) {
+        const ec_slave_t *slave = sc->slave;
+        u32 cycle = sc->dc_sync[0].cycle_time, remainder;
+        u64 diff, t;
+
+        if (!sc->dc_assign_activate || !cycle) {
+            continue;
+        }
+
+        /* The SYNC0 events are in phase with ec_master::dc_ref_time, see
+         * ec_fsm_slave_config_enter_dc_start(). */
+        t = app_time + lead + (slave ? slave->transmission_delay : 0);
+        diff = t - master->dc_ref_time - sc->dc_sync[0].shift_time;
+        remainder = do_div(diff, cycle);
+        t += cycle - remainder; // next SYNC0 event after the frame arrived
+        t -= lead + (slave ? slave->transmission_delay : 0);
+
+        if (!send_time || t < send_time) {
+            send_time = t;
+        }
+    }
+
+    if (!send_time) {
+        return -EAGAIN;
+    }
+
+    *time = send_time;
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_sync0_calibrate(ec_master_t *master, uint32_t cycles)
+{
+    if (!master->dc_ref_clock) {
+        return -ENXIO;
+    }
+
+    if (!cycles) {
+        return -EINVAL;
+    }
+
+    master->dc_stats.sync0_calibrate = cycles;
+    return 0;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_sync0_shift_correction(ec_master_t *master, uint32_t margin,
+        int32_t *correction)
+{
+    const ec_dc_stats_t *stats = &master->dc_stats;
+
+    if (!master->dc_ref_clock) {
+        return -ENXIO;
+    }
+
+    if (stats->sync0_calibrate || stats->sync0_cycles_left
+            || !stats->sync0_margin.count) {
+        return -EAGAIN;
+    }
+
+    *correction = (s32) margin - stats->sync0_margin.min;
+    return 0;
 }
 
 /*****************************************************************************/
 
 void ecrt_master_sync_monitor_queue(ec_master_t *master)
 {
+    // record the last result, if the application did not ask for it
+    if (master->sync_mon_datagram.state == EC_DATAGRAM_RECEIVED) {
+        ecrt_master_sync_monitor_process(master);
+    }
+
     ec_datagram_zero(&master->sync_mon_datagram);
     ec_master_queue_datagram(master, &master->sync_mon_datagram);
+    master->dc_stats.sync_mon_pending = 1;
 }
 
 /*****************************************************************************/
 
 uint32_t ecrt_master_sync_monitor_process(ec_master_t *master)
 {
+    uint32_t time_diff;
+
     if (master->sync_mon_datagram.state == EC_DATAGRAM_RECEIVED) {
-        return EC_READ_U32(master->sync_mon_datagram.data) & 0x7fffffff;
+        time_diff = EC_READ_U32(master->sync_mon_datagram.data) & 0x7fffffff;
+        if (master->dc_stats.sync_mon_pending) {
+            master->dc_stats.sync_mon_pending = 0;
+            ec_dc_histogram_add(&master->dc_stats.sync_monitor, time_diff);
+        }
+        return time_diff;
     } else {
         return 0xffffffff;
     }
@@ -2855,7 +5724,6 @@ int ecrt_master_sdo_download(ec_master_t *master, uint16_t slave_position,
         size_t data_size, uint32_t *abort_code)
 {
     ec_sdo_request_t request;
-    ec_slave_t *slave;
     int ret;
 
     EC_MASTER_DBG(master, 1, "%s(master = 0x%p,"
@@ -2863,60 +5731,22 @@ int ecrt_master_sdo_download(ec_master_t *master, uint16_t slave_position,
             " data = 0x%p, data_size = %zu, abort_code = 0x%p)\n",
             __func__, master, slave_position, index, subindex,
             data, data_size, abort_code);
-
-    if (!data_size) {
-        EC_MASTER_ERR(master, "Zero data size!\n");
-        return -EINVAL;
-    }
-
-    ec_sdo_request_init(&request);
-    ecrt_sdo_request_index(&request, index, subindex);
-    ret = ec_sdo_request_alloc(&request, data_size);
-    if (ret) {
-        ec_sdo_request_clear(&request);
-        return ret;
-    }
-
-    memcpy(request.data, data, data_size);
-    request.data_size = data_size;
-    ecrt_sdo_request_write(&request);
-
-    if (down_interruptible(&master->master_sem)) {
-        ec_sdo_request_clear(&request);
-        return -EINTR;
-    }
-
-    if (!(slave = ec_master_find_slave(master, 0, slave_position))) {
-        up(&master->master_sem);
-        EC_MASTER_ERR(master, "Slave %u does not exist!\n", slave_position);
-        ec_sdo_request_clear(&request);
-        return -EINVAL;
-    }
-
-    EC_SLAVE_DBG(slave, 1, "Scheduling SDO download request.\n");
-
-    // schedule request.
-    list_add_tail(&request.list, &slave->sdo_requests);
-
-    up(&master->master_sem);
-
-    // wait for processing through FSM
-    if (wait_event_interruptible(master->request_queue,
-                request.state != EC_INT_REQUEST_QUEUED)) {
-        // interrupted by signal
-        down(&master->master_sem);
-        if (request.state == EC_INT_REQUEST_QUEUED) {
-            list_del(&request.list);
-            up(&master->master_sem);
-            ec_sdo_request_clear(&request);
-            return -EINTR;
-        }
-        // request already processing: interrupt not possible.
-        up(&master->master_sem);
+
+    if (!data_size) {
+        EC_MASTER_ERR(master, "Zero data size!\n");
+        return -EINVAL;
     }
 
-    // wait until master FSM has finished processing
-    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+    ec_sdo_request_init(&request);
+    ecrt_sdo_request_index(&request, index, subindex);
+    ecrt_sdo_request_external_memory(&request, data, data_size);
+    ecrt_sdo_request_write(&request);
+
+    ret = ec_master_exec_sdo_request(master, slave_position, &request);
+    if (ret) {
+        ec_sdo_request_clear(&request);
+        return ret;
+    }
 
     *abort_code = request.abort_code;
 
@@ -2939,7 +5769,6 @@ int ecrt_master_sdo_download_complete(ec_master_t *master,
         size_t data_size, uint32_t *abort_code)
 {
     ec_sdo_request_t request;
-    ec_slave_t *slave;
     int ret;
 
     EC_MASTER_DBG(master, 1, "%s(master = 0x%p,"
@@ -2954,35 +5783,75 @@ int ecrt_master_sdo_download_complete(ec_master_t *master,
     }
 
     ec_sdo_request_init(&request);
-    ecrt_sdo_request_index(&request, index, 0);
-    ret = ec_sdo_request_alloc(&request, data_size);
+    ecrt_sdo_request_index_complete(&request, index);
+    ecrt_sdo_request_external_memory(&request, data, data_size);
+    ecrt_sdo_request_write(&request);
+
+    ret = ec_master_exec_sdo_request(master, slave_position, &request);
     if (ret) {
         ec_sdo_request_clear(&request);
         return ret;
     }
 
-    request.complete_access = 1;
-    memcpy(request.data, data, data_size);
-    request.data_size = data_size;
-    ecrt_sdo_request_write(&request);
+    *abort_code = request.abort_code;
+
+    if (request.state == EC_INT_REQUEST_SUCCESS) {
+        ret = 0;
+    } else if (request.errno) {
+        ret = -request.errno;
+    } else {
+        ret = -EIO;
+    }
+
+    ec_sdo_request_clear(&request);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/** Fetches the entry descriptions of an SDO, if they are still pending.
+ *
+ * Entry descriptions of objects, that are not mapped to any PDO, are not
+ * read together with the SDO dictionary, but on the first access. They are
+ * kept in the dictionary afterwards.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_master_fetch_sdo_entries(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        uint16_t index /**< Index of the SDO. */
+        )
+{
+    ec_sdo_entries_request_t request;
+    ec_slave_t *slave;
+    const ec_sdo_t *sdo;
+
+    INIT_LIST_HEAD(&request.list);
+    request.index = index;
+    request.state = EC_INT_REQUEST_QUEUED;
 
     if (down_interruptible(&master->master_sem)) {
-        ec_sdo_request_clear(&request);
         return -EINTR;
     }
 
     if (!(slave = ec_master_find_slave(master, 0, slave_position))) {
         up(&master->master_sem);
         EC_MASTER_ERR(master, "Slave %u does not exist!\n", slave_position);
-        ec_sdo_request_clear(&request);
         return -EINVAL;
     }
 
-    EC_SLAVE_DBG(slave, 1, "Scheduling SDO download request"
-            " (complete access).\n");
+    sdo = ec_slave_get_sdo_const(slave, index);
+    if (!sdo || !sdo->entries_pending) {
+        up(&master->master_sem);
+        return 0;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Scheduling SDO entry description request.\n");
 
     // schedule request.
-    list_add_tail(&request.list, &slave->sdo_requests);
+    list_add_tail(&request.list, &slave->dict_requests);
+    ec_master_kick_slave_fsm(master, slave);
 
     up(&master->master_sem);
 
@@ -2994,87 +5863,110 @@ int ecrt_master_sdo_download_complete(ec_master_t *master,
         if (request.state == EC_INT_REQUEST_QUEUED) {
             list_del(&request.list);
             up(&master->master_sem);
-            ec_sdo_request_clear(&request);
             return -EINTR;
         }
         // request already processing: interrupt not possible.
         up(&master->master_sem);
     }
 
-    // wait until master FSM has finished processing
+    // wait until slave FSM has finished processing
     wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
 
-    *abort_code = request.abort_code;
-
-    if (request.state == EC_INT_REQUEST_SUCCESS) {
-        ret = 0;
-    } else if (request.errno) {
-        ret = -request.errno;
-    } else {
-        ret = -EIO;
-    }
-
-    ec_sdo_request_clear(&request);
-    return ret;
+    return request.state == EC_INT_REQUEST_SUCCESS ? 0 : -EIO;
 }
 
 /*****************************************************************************/
 
-int ecrt_master_sdo_upload(ec_master_t *master, uint16_t slave_position,
-        uint16_t index, uint8_t subindex, uint8_t *target,
-        size_t target_size, size_t *result_size, uint32_t *abort_code)
+/** Queues an SDO request for a slave and waits for its completion.
+ *
+ * \return Zero, if the request was processed (see its state for the result),
+ *         otherwise a negative error code.
+ */
+int ec_master_exec_sdo_request(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        ec_sdo_request_t *request /**< SDO request. */
+        )
 {
-    ec_sdo_request_t request;
     ec_slave_t *slave;
-    int ret = 0;
-
-    EC_MASTER_DBG(master, 1, "%s(master = 0x%p,"
-            " slave_position = %u, index = 0x%04X, subindex = 0x%02X,"
-            " target = 0x%p, target_size = %zu, result_size = 0x%p,"
-            " abort_code = 0x%p)\n",
-            __func__, master, slave_position, index, subindex,
-            target, target_size, result_size, abort_code);
-
-    ec_sdo_request_init(&request);
-    ecrt_sdo_request_index(&request, index, subindex);
-    ecrt_sdo_request_read(&request);
 
     if (down_interruptible(&master->master_sem)) {
-        ec_sdo_request_clear(&request);
         return -EINTR;
     }
 
     if (!(slave = ec_master_find_slave(master, 0, slave_position))) {
         up(&master->master_sem);
-        ec_sdo_request_clear(&request);
         EC_MASTER_ERR(master, "Slave %u does not exist!\n", slave_position);
         return -EINVAL;
     }
 
-    EC_SLAVE_DBG(slave, 1, "Scheduling SDO upload request.\n");
+    EC_SLAVE_DBG(slave, 1, "Scheduling SDO %s request%s.\n",
+            request->dir == EC_DIR_INPUT ? "upload" : "download",
+            request->complete_access ? " (complete access)" : "");
 
     // schedule request.
-    list_add_tail(&request.list, &slave->sdo_requests);
+    list_add_tail(&request->list, &slave->sdo_requests);
+    ec_master_kick_slave_fsm(master, slave);
 
     up(&master->master_sem);
 
     // wait for processing through FSM
     if (wait_event_interruptible(master->request_queue,
-                request.state != EC_INT_REQUEST_QUEUED)) {
+                request->state != EC_INT_REQUEST_QUEUED)) {
         // interrupted by signal
         down(&master->master_sem);
-        if (request.state == EC_INT_REQUEST_QUEUED) {
-            list_del(&request.list);
+        if (request->state == EC_INT_REQUEST_QUEUED) {
+            list_del(&request->list);
             up(&master->master_sem);
-            ec_sdo_request_clear(&request);
             return -EINTR;
         }
         // request already processing: interrupt not possible.
         up(&master->master_sem);
     }
 
-    // wait until master FSM has finished processing
-    wait_event(master->request_queue, request.state != EC_INT_REQUEST_BUSY);
+    // wait until slave FSM has finished processing
+    wait_event(master->request_queue,
+            request->state != EC_INT_REQUEST_BUSY);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Executes an SDO upload request.
+ *
+ * The data are uploaded directly into the target buffer.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_master_sdo_upload(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        uint16_t index, /**< Index of the SDO. */
+        uint8_t subindex, /**< Subindex of the SDO. */
+        uint8_t complete_access, /**< Use complete access. */
+        uint8_t *target, /**< Target buffer for the upload. */
+        size_t target_size, /**< Size of the target buffer. */
+        size_t *result_size, /**< Uploaded data size. */
+        uint32_t *abort_code /**< Abort code of the SDO upload. */
+        )
+{
+    ec_sdo_request_t request;
+    int ret;
+
+    ec_sdo_request_init(&request);
+    ecrt_sdo_request_external_memory(&request, target, target_size);
+    if (complete_access) {
+        ecrt_sdo_request_index_complete(&request, index);
+    } else {
+        ecrt_sdo_request_index(&request, index, subindex);
+    }
+    ecrt_sdo_request_read(&request);
+
+    ret = ec_master_exec_sdo_request(master, slave_position, &request);
+    if (ret) {
+        ec_sdo_request_clear(&request);
+        return ret;
+    }
 
     *abort_code = request.abort_code;
 
@@ -3086,15 +5978,7 @@ int ecrt_master_sdo_upload(ec_master_t *master, uint16_t slave_position,
             ret = -EIO;
         }
     } else {
-        if (request.data_size > target_size) {
-            EC_SLAVE_ERR(slave, "%s(): Buffer too small.\n", __func__);
-            ret = -EOVERFLOW;
-        }
-        else {
-            memcpy(target, request.data, request.data_size);
-            *result_size = request.data_size;
-            ret = 0;
-        }
+        *result_size = request.data_size;
     }
 
     ec_sdo_request_clear(&request);
@@ -3103,6 +5987,71 @@ int ecrt_master_sdo_upload(ec_master_t *master, uint16_t slave_position,
 
 /*****************************************************************************/
 
+int ecrt_master_sdo_upload(ec_master_t *master, uint16_t slave_position,
+        uint16_t index, uint8_t subindex, uint8_t *target,
+        size_t target_size, size_t *result_size, uint32_t *abort_code)
+{
+    EC_MASTER_DBG(master, 1, "%s(master = 0x%p,"
+            " slave_position = %u, index = 0x%04X, subindex = 0x%02X,"
+            " target = 0x%p, target_size = %zu, result_size = 0x%p,"
+            " abort_code = 0x%p)\n",
+            __func__, master, slave_position, index, subindex,
+            target, target_size, result_size, abort_code);
+
+    return ec_master_sdo_upload(master, slave_position, index, subindex, 0,
+            target, target_size, result_size, abort_code);
+}
+
+/*****************************************************************************/
+
+int ecrt_master_sdo_upload_complete(ec_master_t *master,
+        uint16_t slave_position, uint16_t index, uint8_t *target,
+        size_t target_size, size_t *result_size, uint32_t *abort_code)
+{
+    EC_MASTER_DBG(master, 1, "%s(master = 0x%p,"
+            " slave_position = %u, index = 0x%04X,"
+            " target = 0x%p, target_size = %zu, result_size = 0x%p,"
+            " abort_code = 0x%p)\n",
+            __func__, master, slave_position, index,
+            target, target_size, result_size, abort_code);
+
+    return ec_master_sdo_upload(master, slave_position, index, 0, 1,
+            target, target_size, result_size, abort_code);
+}
+
+/*****************************************************************************/
+
+int ecrt_master_sdo_requests_submit(ec_master_t *master,
+        ec_sdo_request_t *const *requests, const ec_direction_t *dirs,
+        unsigned int count)
+{
+    unsigned int i;
+
+    EC_MASTER_DBG(master, 1, "%s(master = 0x%p, requests = 0x%p,"
+            " dirs = 0x%p, count = %u)\n",
+            __func__, master, requests, dirs, count);
+
+    for (i = 0; i < count; i++) {
+        if (dirs[i] != EC_DIR_INPUT && dirs[i] != EC_DIR_OUTPUT) {
+            EC_MASTER_ERR(master, "Invalid direction %u"
+                    " of SDO request %u!\n", dirs[i], i);
+            return -EINVAL;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (dirs[i] == EC_DIR_OUTPUT) {
+            ecrt_sdo_request_write(requests[i]);
+        } else {
+            ecrt_sdo_request_read(requests[i]);
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 int ecrt_master_write_idn(ec_master_t *master, uint16_t slave_position,
         uint8_t drive_no, uint16_t idn, uint8_t *data, size_t data_size,
         uint16_t *error_code)
@@ -3147,6 +6096,7 @@ int ecrt_master_write_idn(ec_master_t *master, uint16_t slave_position,
 
     // schedule SoE write request.
     list_add_tail(&request.list, &slave->soe_requests);
+    ec_master_kick_slave_fsm(master, slave);
 
     up(&master->master_sem);
 
@@ -3213,6 +6163,7 @@ int ecrt_master_read_idn(ec_master_t *master, uint16_t slave_position,
 
     // schedule request.
     list_add_tail(&request.list, &slave->soe_requests);
+    ec_master_kick_slave_fsm(master, slave);
 
     up(&master->master_sem);
 
@@ -3263,6 +6214,186 @@ int ecrt_master_read_idn(ec_master_t *master, uint16_t slave_position,
 
 /*****************************************************************************/
 
+/** Checks, if all SoE requests were processed.
+ *
+ * \return Non-zero, if no request is queued or busy.
+ */
+static int ec_master_soe_requests_done(
+        const ec_soe_request_t *requests, /**< SoE requests. */
+        unsigned int count /**< Number of requests. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        if (requests[i].state == EC_INT_REQUEST_QUEUED
+                || requests[i].state == EC_INT_REQUEST_BUSY) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*****************************************************************************/
+
+/** Transfers several IDNs of a slave.
+ *
+ * All requests are queued at once, so that the slave FSM processes them back
+ * to back.
+ *
+ * \retval  0 All IDNs were transferred.
+ * \retval -EIO At least one of the transfers failed.
+ * \retval <0 Other error code.
+ */
+static int ec_master_transfer_idns(
+        ec_master_t *master, /**< EtherCAT master. */
+        uint16_t slave_position, /**< Slave position. */
+        ec_soe_idn_transfer_t *transfers, /**< IDN transfers. */
+        unsigned int count, /**< Number of \a transfers. */
+        ec_direction_t dir /**< Transfer direction. */
+        )
+{
+    ec_soe_request_t *requests;
+    ec_slave_t *slave;
+    unsigned int i;
+    int ret = 0;
+
+    if (!count) {
+        return 0;
+    }
+
+    if (count > UINT_MAX / sizeof(*requests)) {
+        return -EINVAL;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (transfers[i].drive_no > 7) {
+            EC_MASTER_ERR(master, "Invalid drive number!\n");
+            return -EINVAL;
+        }
+    }
+
+    requests = kmalloc(count * sizeof(*requests), GFP_KERNEL);
+    if (!requests) {
+        EC_MASTER_ERR(master, "Failed to allocate %u SoE requests.\n",
+                count);
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        ec_soe_request_t *req = &requests[i];
+
+        ec_soe_request_init(req);
+        ec_soe_request_set_drive_no(req, transfers[i].drive_no);
+        ec_soe_request_set_idn(req, transfers[i].idn);
+
+        if (dir == EC_DIR_OUTPUT) {
+            ret = ec_soe_request_alloc(req, transfers[i].size);
+            if (ret) {
+                count = i + 1;
+                goto out_clear;
+            }
+            memcpy(req->data, transfers[i].data, transfers[i].size);
+            req->data_size = transfers[i].size;
+            ec_soe_request_write(req);
+        } else {
+            ec_soe_request_read(req);
+        }
+    }
+
+    if (down_interruptible(&master->master_sem)) {
+        ret = -EINTR;
+        goto out_clear;
+    }
+
+    if (!(slave = ec_master_find_slave(master, 0, slave_position))) {
+        up(&master->master_sem);
+        EC_MASTER_ERR(master, "Slave %u does not exist!\n", slave_position);
+        ret = -EINVAL;
+        goto out_clear;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "Scheduling %u SoE %s requests.\n", count,
+            dir == EC_DIR_OUTPUT ? "write" : "read");
+
+    for (i = 0; i < count; i++) {
+        list_add_tail(&requests[i].list, &slave->soe_requests);
+    }
+    ec_master_kick_slave_fsm(master, slave);
+
+    up(&master->master_sem);
+
+    // wait for processing through FSM
+    if (wait_event_interruptible(master->request_queue,
+                ec_master_soe_requests_done(requests, count))) {
+        // interrupted by signal: abort the requests not yet started
+        down(&master->master_sem);
+        for (i = 0; i < count; i++) {
+            if (requests[i].state == EC_INT_REQUEST_QUEUED) {
+                list_del(&requests[i].list);
+                requests[i].state = EC_INT_REQUEST_FAILURE;
+            }
+        }
+        up(&master->master_sem);
+
+        // the busy request can not be interrupted
+        wait_event(master->request_queue,
+                ec_master_soe_requests_done(requests, count));
+    }
+
+    for (i = 0; i < count; i++) {
+        ec_soe_request_t *req = &requests[i];
+        ec_soe_idn_transfer_t *transfer = &transfers[i];
+
+        transfer->error_code = req->error_code;
+        transfer->result_size = 0;
+
+        if (req->state != EC_INT_REQUEST_SUCCESS) {
+            transfer->result = -EIO;
+        } else if (dir == EC_DIR_OUTPUT) {
+            transfer->result = 0;
+        } else if (req->data_size > transfer->size) {
+            transfer->result = -EOVERFLOW;
+        } else {
+            memcpy(transfer->data, req->data, req->data_size);
+            transfer->result_size = req->data_size;
+            transfer->result = 0;
+        }
+
+        if (transfer->result) {
+            ret = -EIO;
+        }
+    }
+
+out_clear:
+    for (i = 0; i < count; i++) {
+        ec_soe_request_clear(&requests[i]);
+    }
+    kfree(requests);
+    return ret;
+}
+
+/*****************************************************************************/
+
+int ecrt_master_read_idns(ec_master_t *master, uint16_t slave_position,
+        ec_soe_idn_transfer_t *transfers, unsigned int count)
+{
+    return ec_master_transfer_idns(master, slave_position, transfers, count,
+            EC_DIR_INPUT);
+}
+
+/*****************************************************************************/
+
+int ecrt_master_write_idns(ec_master_t *master, uint16_t slave_position,
+        ec_soe_idn_transfer_t *transfers, unsigned int count)
+{
+    return ec_master_transfer_idns(master, slave_position, transfers, count,
+            EC_DIR_OUTPUT);
+}
+
+/*****************************************************************************/
+
 void ecrt_master_reset(ec_master_t *master)
 {
     ec_slave_config_t *sc;
@@ -3282,27 +6413,44 @@ EXPORT_SYMBOL(ecrt_master_create_domain);
 EXPORT_SYMBOL(ecrt_master_activate);
 EXPORT_SYMBOL(ecrt_master_deactivate);
 EXPORT_SYMBOL(ecrt_master_send);
+EXPORT_SYMBOL(ecrt_master_send_at);
 EXPORT_SYMBOL(ecrt_master_send_ext);
+EXPORT_SYMBOL(ecrt_master_set_traffic_class);
 EXPORT_SYMBOL(ecrt_master_receive);
+EXPORT_SYMBOL(ecrt_master_receive_wait);
+EXPORT_SYMBOL(ecrt_master_set_timed_cycle);
+EXPORT_SYMBOL(ecrt_master_trigger_cycle);
 EXPORT_SYMBOL(ecrt_master_callbacks);
 EXPORT_SYMBOL(ecrt_master);
 EXPORT_SYMBOL(ecrt_master_get_slave);
 EXPORT_SYMBOL(ecrt_master_slave_config);
 EXPORT_SYMBOL(ecrt_master_select_reference_clock);
+EXPORT_SYMBOL(ecrt_master_select_dc_domain);
 EXPORT_SYMBOL(ecrt_master_state);
+EXPORT_SYMBOL(ecrt_master_slave_config_states);
 EXPORT_SYMBOL(ecrt_master_link_state);
 EXPORT_SYMBOL(ecrt_master_application_time);
 EXPORT_SYMBOL(ecrt_master_sync_reference_clock);
 EXPORT_SYMBOL(ecrt_master_sync_reference_clock_to);
 EXPORT_SYMBOL(ecrt_master_sync_slave_clocks);
 EXPORT_SYMBOL(ecrt_master_reference_clock_time);
+EXPORT_SYMBOL(ecrt_master_reference_clock_time64);
+EXPORT_SYMBOL(ecrt_master_dc_cycle_correction);
+EXPORT_SYMBOL(ecrt_master_dc_time);
+EXPORT_SYMBOL(ecrt_master_next_send_time);
+EXPORT_SYMBOL(ecrt_master_sync0_calibrate);
+EXPORT_SYMBOL(ecrt_master_sync0_shift_correction);
 EXPORT_SYMBOL(ecrt_master_sync_monitor_queue);
 EXPORT_SYMBOL(ecrt_master_sync_monitor_process);
 EXPORT_SYMBOL(ecrt_master_sdo_download);
 EXPORT_SYMBOL(ecrt_master_sdo_download_complete);
 EXPORT_SYMBOL(ecrt_master_sdo_upload);
+EXPORT_SYMBOL(ecrt_master_sdo_upload_complete);
+EXPORT_SYMBOL(ecrt_master_sdo_requests_submit);
 EXPORT_SYMBOL(ecrt_master_write_idn);
 EXPORT_SYMBOL(ecrt_master_read_idn);
+EXPORT_SYMBOL(ecrt_master_read_idns);
+EXPORT_SYMBOL(ecrt_master_write_idns);
 EXPORT_SYMBOL(ecrt_master_reset);
 
 /** \endcond */
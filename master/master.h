@@ -39,9 +39,12 @@
 
 #include <linux/version.h>
 #include <linux/list.h>
+#include <linux/llist.h>
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/kthread.h>
+#include <linux/seqlock.h>
+#include <linux/topology.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 27)
 #include <linux/semaphore.h>
@@ -54,11 +57,21 @@
 #include "ethernet.h"
 #include "fsm_master.h"
 #include "cdev.h"
+#include "startup_profile.h"
+#include "rt_log.h"
 
 #ifdef EC_RTDM
 #include "rtdm.h"
 #endif
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 14, 0)
+/* Acquire/release accessors for older kernels. */
+#define smp_load_acquire(p) \
+    ({ typeof(*(p)) ___v = ACCESS_ONCE(*(p)); smp_mb(); ___v; })
+#define smp_store_release(p, v) \
+    do { smp_mb(); ACCESS_ONCE(*(p)) = (v); } while (0)
+#endif
+
 /*****************************************************************************/
 
 /** Convenience macro for printing master-specific information to syslog.
@@ -116,13 +129,106 @@
         } \
     } while (0)
 
+/** Convenience macro for printing master-specific errors from realtime
+ * context.
+ *
+ * Like EC_MASTER_ERR(), but the message is deferred to the master's RT log
+ * and rate-limited per \a type, so that the cycle never waits for the
+ * console.
+ *
+ * \param master EtherCAT master
+ * \param type message type (ec_rt_log_type_t)
+ * \param fmt format string (like in printf())
+ * \param args arguments (optional)
+ */
+#define EC_MASTER_RT_ERR(master, type, fmt, args...) \
+    ec_rt_log(&master->rt_log, type, EC_RT_LOG_ERR, \
+            "EtherCAT ERROR %u: " fmt, master->index, ##args)
 
-/** Size of the external datagram ring.
+/** Convenience macro for printing master-specific warnings from realtime
+ * context, see EC_MASTER_RT_ERR().
+ */
+#define EC_MASTER_RT_WARN(master, type, fmt, args...) \
+    ec_rt_log(&master->rt_log, type, EC_RT_LOG_WARN, \
+            "EtherCAT WARNING %u: " fmt, master->index, ##args)
+
+/** Convenience macro for printing master-specific information from realtime
+ * context, see EC_MASTER_RT_ERR().
+ */
+#define EC_MASTER_RT_INFO(master, type, fmt, args...) \
+    ec_rt_log(&master->rt_log, type, EC_RT_LOG_INFO, \
+            "EtherCAT %u: " fmt, master->index, ##args)
+
+/** Convenience macro for printing master-specific debug messages from
+ * realtime context, see EC_MASTER_RT_ERR() and EC_MASTER_DBG().
+ */
+#define EC_MASTER_RT_DBG(master, level, type, fmt, args...) \
+    do { \
+        if (master->debug_level >= level) { \
+            ec_rt_log(&master->rt_log, type, EC_RT_LOG_DBG, \
+                    "EtherCAT DEBUG %u: " fmt, master->index, ##args); \
+        } \
+    } while (0)
+
+
+/** Default size of the external datagram ring.
  *
- * The external datagram ring is used for slave FSMs.
+ * The external datagram ring is used for slave FSMs. Half of its size is the
+ * number of slave FSMs that can be executed concurrently. It can be set per
+ * master via the ext_ring_size module parameter.
  */
 #define EC_EXT_RING_SIZE 32
 
+/** Minimum size of the external datagram ring.
+ */
+#define EC_MIN_EXT_RING_SIZE 4
+
+/** Maximum size of the external datagram ring.
+ */
+#define EC_MAX_EXT_RING_SIZE 1024
+
+/** Size of the external datagram queue.
+ *
+ * The external datagram queue passes EoE datagrams to
+ * ecrt_master_send_ext(). Its capacity is one less than its size.
+ */
+#define EC_EXT_QUEUE_SIZE 64
+
+/** Default share of the cycle for EoE datagrams in percent.
+ *
+ * \see ec_master::eoe_share
+ */
+#define EC_EOE_SHARE 25
+
+/** Number of hash buckets for looking up slave configurations by alias and
+ * position.
+ */
+#define EC_CONFIG_HASH_SIZE 256
+
+/** Proportional gain of the DC servo as a right shift (1/4).
+ */
+#define EC_DC_SERVO_KP_SHIFT 2
+
+/** Integral gain of the DC servo as a right shift (1/256).
+ */
+#define EC_DC_SERVO_KI_SHIFT 8
+
+/** Time constant of the filtered DC time in cycles as a shift (16 cycles).
+ */
+#define EC_DC_SERVO_FILTER_SHIFT 4
+
+/** Maximum DC servo correction per cycle in ns.
+ */
+#define EC_DC_SERVO_MAX_CORRECTION 1000
+
+/** Number of bins of the DC statistics histograms.
+ *
+ * Bin 0 counts absolute values below 64 ns, bin i counts absolute values
+ * from 2^(i + 5) ns to below 2^(i + 6) ns. The last bin also collects all
+ * larger values.
+ */
+#define EC_DC_HISTOGRAM_BINS 16
+
 /*****************************************************************************/
 
 /** EtherCAT master phase.
@@ -145,6 +251,10 @@ typedef struct {
     unsigned int corrupted; /**< corrupted frames */
     unsigned int unmatched; /**< unmatched datagrams (received, but not
                                queued any longer) */
+    unsigned int late; /**< datagrams received after their timeout */
+    u32 late_max; /**< maximum lateness after the timeout in us */
+    unsigned int index_deferred; /**< sends, that left datagrams queued,
+                                   because all indices were in flight */
     unsigned long output_jiffies; /**< time of last output */
 } ec_stats_t;
 
@@ -181,6 +291,185 @@ typedef struct {
 
 /*****************************************************************************/
 
+/** Traffic class settings and statistics.
+ */
+typedef struct {
+    unsigned int priority; /**< Transmit priority (lower values first). */
+    size_t budget; /**< Bytes per send cycle and device, or zero. */
+    u64 datagrams; /**< Number of datagrams sent. */
+    u64 bytes; /**< Number of bytes sent, including datagram headers. */
+    u64 deferred; /**< Number of datagrams left queued after sending. */
+    u64 held; /**< Number of datagrams held back before queuing, because the
+                share of the cycle was used up. */
+} ec_traffic_class_info_t;
+
+/*****************************************************************************/
+
+/** DC servo making the application clock follow the reference clock.
+ *
+ * Evaluates the reference clock time returned by the sync datagram.
+ *
+ * \see ecrt_master_dc_cycle_correction()
+ */
+typedef struct {
+    unsigned int pending; /**< The sync datagram was queued, its result is
+                            not evaluated yet. */
+    u64 app_time; /**< Application time when the sync datagram was queued. */
+    unsigned int valid; /**< At least one sample was evaluated. */
+    s32 diff; /**< Last application time minus reference clock time. */
+    s64 filter; /**< Filtered \a diff, scaled by the filter time constant. */
+    s64 integral; /**< Sum of the differences. */
+    s32 correction; /**< Correction for the next cycle in ns. */
+} ec_dc_servo_t;
+
+/*****************************************************************************/
+
+/** Histogram of DC time values.
+ */
+typedef struct {
+    u64 count; /**< Number of samples. */
+    s64 sum; /**< Sum of all samples in ns. */
+    s32 min; /**< Minimum sample in ns. */
+    s32 max; /**< Maximum sample in ns. */
+    u32 bins[EC_DC_HISTOGRAM_BINS]; /**< Sample counts by absolute value.
+                                      \see EC_DC_HISTOGRAM_BINS */
+} ec_dc_histogram_t;
+
+/** Decay of the send latency peak per ecrt_master_send() call.
+ *
+ * Shift of the divisor for the difference to a smaller measurement.
+ */
+#define EC_SEND_LATENCY_DECAY_SHIFT 6
+
+/*****************************************************************************/
+
+/** DC synchronization statistics.
+ *
+ * Recorded in the application context, read and reset via ioctl().
+ */
+typedef struct {
+    unsigned int reset; /**< Reset requested from non-realtime context. */
+    u32 cycle_time; /**< DC cycle time in ns, or zero if unknown. */
+    u64 last_send; /**< Time of the last ecrt_master_send() call in ns. */
+    unsigned int sync_mon_pending; /**< The sync monitoring datagram was
+                                     queued and not evaluated yet. */
+    ec_dc_histogram_t sync_monitor; /**< Sync monitoring results. */
+    ec_dc_histogram_t ref_offset; /**< Application time minus reference
+                                    clock time. */
+    ec_dc_histogram_t send_jitter; /**< Deviation of the send interval from
+                                     the DC cycle time. */
+    u32 sync0_calibrate; /**< Length of a requested SYNC0 calibration window
+                           in cycles, taken over by ecrt_master_send(). */
+    u32 sync0_cycles_left; /**< Sync datagrams to evaluate until the SYNC0
+                             calibration window is complete. */
+    s32 sync0_anchor; /**< First SYNC0 margin of the calibration window. */
+    ec_dc_histogram_t sync0_margin; /**< Time from the end of the process
+                                      data frame passing a slave to its next
+                                      SYNC0 event. */
+} ec_dc_stats_t;
+
+/*****************************************************************************/
+
+/** Number of bins of the latency histograms.
+ *
+ * Bin 0 counts durations below 64 ns, bin i counts durations from
+ * 2^(i + 5) ns to below 2^(i + 6) ns. The last bin also collects all longer
+ * durations.
+ */
+#define EC_LATENCY_HISTOGRAM_BINS 20
+
+/** Histogram of durations.
+ */
+typedef struct {
+    u64 count; /**< Number of samples. */
+    u64 sum; /**< Sum of all samples in ns. */
+    u32 min; /**< Minimum sample in ns. */
+    u32 max; /**< Maximum sample in ns. */
+    u32 bins[EC_LATENCY_HISTOGRAM_BINS]; /**< Sample counts.
+                                           \see EC_LATENCY_HISTOGRAM_BINS */
+} ec_latency_histogram_t;
+
+/*****************************************************************************/
+
+/** Latency statistics of the cyclic master calls.
+ *
+ * Recorded in the application context, read and reset via ioctl(). The
+ * domains record their own round-trip and process times.
+ */
+typedef struct {
+    unsigned int reset; /**< Reset requested from non-realtime context. */
+    ec_latency_histogram_t send; /**< Durations of ecrt_master_send(). */
+    ec_latency_histogram_t receive; /**< Durations of
+                                      ecrt_master_receive(). */
+} ec_latency_stats_t;
+
+/*****************************************************************************/
+
+/** Slot of the alias index, see ec_master_index_slaves().
+ */
+typedef struct {
+    uint16_t alias; /**< Effective alias, or zero if the slot is free. */
+    uint16_t index; /**< Index of the first slave with this alias. */
+} ec_slave_alias_slot_t;
+
+/*****************************************************************************/
+
+/** Cyclic performance counters, see ec_master_counters_t.
+ */
+typedef struct {
+    u64 cycles; /**< Number of send cycles. */
+    u32 frames; /**< Frames sent in the last cycle. */
+    u32 frames_max; /**< Maximum number of frames per cycle. */
+    u32 bytes; /**< Bytes sent in the last cycle. */
+    u32 bytes_max; /**< Maximum number of bytes per cycle. */
+    u32 queued; /**< Datagrams queued in the last cycle. */
+    u32 queued_max; /**< Maximum number of datagrams queued per cycle. */
+    u64 injected; /**< Number of injected external datagrams. */
+    u64 deferred; /**< Number of deferred external datagram injections. */
+} ec_cycle_counters_t;
+
+/** State machine performance counters, see ec_master_counters_t.
+ */
+typedef struct {
+    u64 exec_count; /**< Number of master/slave state machine executions. */
+    u32 exec_time; /**< Duration of the last execution in ns. */
+    u32 exec_time_max; /**< Maximum duration of an execution in ns. */
+} ec_fsm_counters_t;
+
+/** EoE performance counters, see ec_master_counters_t.
+ */
+typedef struct {
+    u32 handlers; /**< Number of opened EoE handlers. */
+    u32 rx_rate; /**< Sum of the receive rates in byte/s. */
+    u32 tx_rate; /**< Sum of the transmit rates in byte/s. */
+} ec_eoe_counters_t;
+
+/** Performance counters, exported via debugfs.
+ *
+ * Every group has a single writer and its own sequence counter, so readers
+ * neither take the master semaphore nor delay the writer.
+ */
+typedef struct {
+    seqcount_t cycle_seq; /**< Sequence counter of \a cycle. */
+    ec_cycle_counters_t cycle; /**< Written by ecrt_master_send(). */
+    seqcount_t fsm_seq; /**< Sequence counter of \a fsm. */
+    ec_fsm_counters_t fsm; /**< Written by the idle/operation thread. */
+    seqcount_t eoe_seq; /**< Sequence counter of \a eoe. */
+    ec_eoe_counters_t eoe; /**< Written by the EoE thread. */
+} ec_master_counters_t;
+
+/*****************************************************************************/
+
+/** Cached SII image.
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    size_t nwords; /**< Size of the SII contents in words. */
+    uint16_t *words; /**< SII contents. */
+} ec_sii_image_t;
+
+/*****************************************************************************/
+
 #if EC_MAX_NUM_DEVICES < 1
 #error Invalid number of devices
 #endif
@@ -193,7 +482,14 @@ typedef struct {
  */
 struct ec_master {
     unsigned int index; /**< Index. */
-    unsigned int reserved; /**< \a True, if the master is in use. */
+    unsigned int reserved; /**< Number of applications using the master. */
+    unsigned int shared; /**< The applications share the master (see
+                           ec_request_master_shared_err()). */
+    unsigned int activations; /**< Number of sharing applications, that
+                                activated the master. */
+    struct list_head kept_mem; /**< Mapped memory of sharing applications,
+                                 that released the master before the
+                                 others. */
 
     ec_cdev_t cdev; /**< Master character device. */
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
@@ -230,9 +526,23 @@ struct ec_master {
 
     ec_slave_t *slaves; /**< Array of slaves on the bus. */
     unsigned int slave_count; /**< Number of slaves on the bus. */
+    seqcount_t slaves_seq; /**< Sequence counter of \a slaves and \a
+                             slave_count for lockless readers. */
+    ec_slave_alias_slot_t *alias_index; /**< Open addressing table mapping
+                                          each alias to the first slave
+                                          using it, or NULL while invalid. */
+    unsigned int alias_index_mask; /**< Number of slots in \a alias_index
+                                     minus one. */
 
     /* Configuration applied by the application. */
     struct list_head configs; /**< List of slave configurations. */
+    unsigned int config_count; /**< Number of slave configurations. */
+    ec_slave_config_t **config_index; /**< Slave configurations by list
+                                        position. */
+    unsigned int config_index_size; /**< Capacity of \a config_index. */
+    ec_slave_config_t *config_hash[EC_CONFIG_HASH_SIZE]; /**< Slave
+                                   configurations hashed by alias and
+                                   position. */
     struct list_head domains; /**< List of domains. */
 
     u64 app_time; /**< Time of the last ecrt_master_sync() call. */
@@ -246,6 +556,18 @@ struct ec_master {
     ec_slave_config_t *dc_ref_config; /**< Application-selected DC reference
                                         clock slave config. */
     ec_slave_t *dc_ref_clock; /**< DC reference clock slave. */
+    ec_domain_t *dc_domain; /**< Domain, in front of whose datagrams the DC
+                              datagrams are sent, or NULL. */
+    unsigned int dc_ref_sync_pending; /**< The reference clock sync datagram
+                                        waits for \a dc_domain. */
+    ec_dc_servo_t dc_servo; /**< DC servo following the reference clock. */
+    ec_dc_stats_t dc_stats; /**< DC synchronization statistics. */
+    ec_latency_stats_t latency_stats; /**< Latency statistics. */
+    ec_startup_profile_t startup_profile; /**< Startup timeline profile. */
+    ec_master_counters_t counters; /**< Performance counters. */
+    struct dentry *debugfs_dir; /**< Debugfs directory, or NULL. */
+    u32 send_latency; /**< Peak duration of ecrt_master_send() in ns, decaying
+                        slowly. */
 
     unsigned int scan_busy; /**< Current scan state. */
     unsigned int allow_scan; /**< \a True, if slave scanning is allowed. */
@@ -260,36 +582,91 @@ struct ec_master {
     wait_queue_head_t config_queue; /**< Queue for processes that wait for
                                       slave configuration. */
 
-    struct list_head datagram_queue; /**< Datagram queue. */
-    uint8_t datagram_index; /**< Current datagram index. */
-
-    struct list_head ext_datagram_queue; /**< Queue for non-application
-                                           datagrams. */
-    struct semaphore ext_queue_sem; /**< Semaphore protecting the \a
-                                      ext_datagram_queue. */
-
-    ec_datagram_t ext_datagram_ring[EC_EXT_RING_SIZE]; /**< External datagram
-                                                         ring. */
+    uint8_t datagram_index; /**< Next datagram index to assign. */
+    ec_datagram_t *sent_datagrams[EC_DATAGRAM_INDEX_COUNT]; /**< Datagrams
+                                                              in flight,
+                                                              indexed by
+                                                              their index. */
+
+    ec_datagram_t *ext_datagram_queue[EC_EXT_QUEUE_SIZE]; /**< Lock-free
+                                                             queue for
+                                                             non-application
+                                                             datagrams. */
+    unsigned int ext_queue_idx_rt; /**< Index in external datagram queue for
+                                     RT (consumer) side. Written with release
+                                     semantics by the consumer only. */
+    unsigned int ext_queue_idx_eoe; /**< Index in external datagram queue for
+                                      EoE (producer) side. Written with
+                                      release semantics by the producer
+                                      only. */
+
+    int cpu; /**< CPU the master threads are bound to, or -1 (thread_cpu
+               module parameter). */
+
+    ec_datagram_t *ext_datagram_ring; /**< External datagram ring. */
+    unsigned int ext_ring_size; /**< Number of datagrams in the external
+                                  datagram ring. */
     unsigned int ext_ring_idx_rt; /**< Index in external datagram ring for RT
-                                    side. */
+                                    (consumer) side. Written with release
+                                    semantics by the consumer only. */
     unsigned int ext_ring_idx_fsm; /**< Index in external datagram ring for
-                                     FSM side. */
+                                     FSM (producer) side. Written with release
+                                     semantics by the producer only. */
     unsigned int send_interval; /**< Interval between two calls to
                                   ecrt_master_send(). */
     size_t max_queue_size; /**< Maximum size of datagram queue */
-
-    ec_slave_t *fsm_slave; /**< Slave that is queried next for FSM exec. */
+    size_t queued_bytes; /**< Payload bytes of the datagrams in state
+                           EC_DATAGRAM_QUEUED on all devices. Maintained
+                           incrementally, see ec_master_queue_datagram(). */
+    u64 app_send_time; /**< Time of the last ecrt_master_send() call of the
+                         application in ns, or zero. The operation thread
+                         aligns its schedule to it. */
+    u64 tx_launch_time; /**< Launch time of the frames sent by
+                          ecrt_master_send_at() in ns (CLOCK_TAI), or zero
+                          to send immediately. */
+    u32 bus_delay; /**< Smoothed part of the frame round trip time in ns,
+                     that does not depend on the frame size (forwarding and
+                     propagation delays). Measured via hardware time stamps,
+                     zero, if they are not available. */
+    unsigned int eoe_share; /**< Share of \a max_queue_size in percent, that
+                              ecrt_master_send_ext() may fill with EoE
+                              datagrams, or zero for no limit. The datagrams
+                              of the slave FSMs are injected into the rest,
+                              so neither can starve the other. */
+
+    ec_slave_t *fsm_slave; /**< Slave that is queried next by the sweep
+                             over all slave FSMs. */
+    unsigned long fsm_sweep_jiffies; /**< Time of the next sweep over all
+                                       slave FSMs. */
     struct list_head fsm_exec_list; /**< Slave FSM execution list. */
     unsigned int fsm_exec_count; /**< Number of entries in execution list. */
+    struct list_head fsm_ready_list; /**< Ready slave FSMs with new requests,
+                                       see ec_master_kick_slave_fsm(). */
+    struct llist_head config_kick_list; /**< Slave configurations with new
+                                          internal requests. Lock-free, as
+                                          these are issued from realtime
+                                          context. */
 
     unsigned int debug_level; /**< Master debug level. */
     ec_stats_t stats; /**< Cyclic statistics. */
+    ec_rt_log_t rt_log; /**< Deferred log for realtime context. */
+    ec_traffic_class_info_t traffic_classes[EC_TC_COUNT]; /**< Traffic class
+                                                            settings and
+                                                            statistics. */
+    ec_traffic_class_t tc_order[EC_TC_COUNT]; /**< Traffic classes in the
+                                                order of transmission. */
 
     struct task_struct *thread; /**< Master thread. */
+    wait_queue_head_t idle_queue; /**< Queue for the idle thread waiting for
+                                    receive interrupts. */
+    unsigned int idle_irq_event; /**< A receive interrupt occurred. */
 
 #ifdef EC_EOE
     struct task_struct *eoe_thread; /**< EoE thread. */
     struct list_head eoe_handlers; /**< Ethernet over EtherCAT handlers. */
+    struct list_head eoe_active; /**< EoE handlers, that have to be
+                                   processed by the EoE thread. */
+    spinlock_t eoe_lock; /**< Lock for \a eoe_active and \a eoe_thread. */
 #endif
 
     struct semaphore io_sem; /**< Semaphore used in \a IDLE phase. */
@@ -303,9 +680,35 @@ struct ec_master {
                                       callback. */
     void *app_cb_data; /**< Application callback data. */
 
-    struct list_head sii_requests; /**< SII write requests. */
+    unsigned int timed_cycle_flags; /**< Actions (EC_CYCLE_*) of the bus cycle
+                                      run by the operation thread, or zero if
+                                      the application runs the cycle. */
+    void (*cycle_cb)(ec_master_t *, void *); /**< Called after each bus cycle
+                                               run by the operation thread.
+                                               */
+    void *cycle_cb_data; /**< Data parameter of \a cycle_cb. */
+    uint32_t cycle_trigger; /**< Incremented by ecrt_master_trigger_cycle()
+                              of kernel applications. */
+    const uint32_t *cycle_trigger_ext; /**< Trigger counter written by a
+                                         userspace application, or NULL to
+                                         use \a cycle_trigger. */
+    uint32_t cycle_trigger_seen; /**< Last trigger counter value, that a
+                                   cycle was run for. */
+    uint8_t *mapped_mem; /**< Process data and state page of the
+                           application, that monitoring tools may map
+                           read-only, or NULL. Protected by \a master_sem. */
+    size_t mapped_mem_size; /**< Size of \a mapped_mem. */
+    uint32_t mapped_mem_flags; /**< Allocation flags (EC_MAP_*) of
+                                 \a mapped_mem. */
+
+    struct list_head sii_cache; /**< Cached SII images (ec_sii_image_t). */
+    struct list_head dict_cache; /**< Cached SDO dictionaries (ec_dict_t). */
+    struct list_head sii_data; /**< SII category data shared by slaves
+                                 (ec_sii_data_t). */
     struct list_head emerg_reg_requests; /**< Emergency register access
                                            requests. */
+    struct list_head reg_batches; /**< Register batch requests
+                                    (ec_reg_batch_t). */
 
     wait_queue_head_t request_queue; /**< Wait queue for external requests
                                        from user space. */
@@ -318,7 +721,8 @@ void ec_master_init_static(void);
 
 // master creation/deletion
 int ec_master_init(ec_master_t *, unsigned int, const uint8_t *,
-        const uint8_t *, dev_t, struct class *, unsigned int);
+        const uint8_t *, dev_t, struct class *, unsigned int, unsigned int,
+        int, const uint16_t *);
 void ec_master_clear(ec_master_t *);
 
 /** Number of Ethernet devices.
@@ -329,6 +733,14 @@ void ec_master_clear(ec_master_t *);
 #define ec_master_num_devices(MASTER) 1
 #endif
 
+/** NUMA node for memory used in the send/receive path.
+ *
+ * This is the node of the CPU the master threads are bound to, or any node,
+ * if the threads are not bound.
+ */
+#define ec_master_node(MASTER) \
+    ((MASTER)->cpu >= 0 ? cpu_to_node((MASTER)->cpu) : NUMA_NO_NODE)
+
 // phase transitions
 int ec_master_enter_idle_phase(ec_master_t *);
 void ec_master_leave_idle_phase(ec_master_t *);
@@ -339,16 +751,22 @@ void ec_master_leave_operation_phase(ec_master_t *);
 // EoE
 void ec_master_eoe_start(ec_master_t *);
 void ec_master_eoe_stop(ec_master_t *);
+void ec_master_eoe_activate(ec_master_t *, ec_eoe_t *);
+void ec_master_eoe_mbox_ready(ec_master_t *);
 #endif
 
 // datagram IO
 void ec_master_receive_datagrams(ec_master_t *, ec_device_t *,
         const uint8_t *, size_t);
 void ec_master_queue_datagram(ec_master_t *, ec_datagram_t *);
-void ec_master_queue_datagram_ext(ec_master_t *, ec_datagram_t *);
+int ec_master_queue_datagram_ext(ec_master_t *, ec_datagram_t *);
+void ec_master_flush_datagram_ext(ec_master_t *, const ec_datagram_t *);
+void ec_master_build_frame_templates(ec_master_t *);
+void ec_master_clear_frame_templates(ec_master_t *);
 
 // misc.
 void ec_master_set_send_interval(ec_master_t *, unsigned int);
+void ec_master_update_bus_delay(ec_master_t *, u32, size_t);
 void ec_master_attach_slave_configs(ec_master_t *);
 ec_slave_t *ec_master_find_slave(ec_master_t *, uint16_t, uint16_t);
 const ec_slave_t *ec_master_find_slave_const(const ec_master_t *, uint16_t,
@@ -357,7 +775,12 @@ void ec_master_output_stats(ec_master_t *);
 #ifdef EC_EOE
 void ec_master_clear_eoe_handlers(ec_master_t *);
 #endif
+void ec_master_publish_slaves(ec_master_t *, unsigned int);
 void ec_master_clear_slaves(ec_master_t *);
+void ec_master_truncate_slaves(ec_master_t *, unsigned int);
+void ec_master_index_slaves(ec_master_t *);
+void ec_master_invalidate_slave_index(ec_master_t *);
+void ec_master_kick_slave_fsm(ec_master_t *, ec_slave_t *);
 
 unsigned int ec_master_config_count(const ec_master_t *);
 ec_slave_config_t *ec_master_get_config(
@@ -374,18 +797,51 @@ const ec_eoe_t *ec_master_get_eoe_handler_const(const ec_master_t *, uint16_t);
 #endif
 
 int ec_master_debug_level(ec_master_t *, unsigned int);
+int ec_master_fetch_sdo_entries(ec_master_t *, uint16_t, uint16_t);
+int ec_master_exec_sdo_request(ec_master_t *, uint16_t, ec_sdo_request_t *);
 
 ec_domain_t *ecrt_master_create_domain_err(ec_master_t *);
 ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *, uint16_t,
         uint16_t, uint32_t, uint32_t);
 
 void ec_master_calc_dc(ec_master_t *);
+
+void ec_latency_histogram_add(ec_latency_histogram_t *, u32);
+void ec_master_capture_trigger(ec_master_t *, unsigned int);
+
+const ec_sii_image_t *ec_master_sii_cache_find(const ec_master_t *,
+        const uint16_t *);
+void ec_master_sii_cache_store(ec_master_t *, const uint16_t *, size_t);
+void ec_master_sii_cache_clear(ec_master_t *);
+ec_dict_t *ec_master_dict_cache_find(const ec_master_t *, uint32_t, uint32_t,
+        uint32_t);
+int ec_master_dict_cache_store(ec_master_t *, ec_dict_t *);
+void ec_master_dict_cache_clear(ec_master_t *);
+ec_sii_data_t *ec_master_find_sii_data(const ec_master_t *,
+        const uint16_t *, size_t);
+void ec_master_share_sii_data(ec_master_t *, ec_sii_data_t *);
 void ec_master_request_op(ec_master_t *);
 
 void ec_master_internal_send_cb(void *);
 void ec_master_internal_receive_cb(void *);
 
 extern const unsigned int rate_intervals[EC_RATE_COUNT]; // see master.c
+extern unsigned int ec_sii_cache; // see module.c
+extern unsigned int ec_al_status_fmmu; // see module.c
+extern unsigned int ec_group_op; // see module.c
+extern unsigned int ec_reuse_config; // see module.c
+extern unsigned int ec_handover; // see module.c
+extern unsigned int ec_mbox_status_fmmu; // see module.c
+extern unsigned int ec_mbox_data_fmmu; // see module.c
+extern unsigned int ec_dict_cache; // see module.c
+extern unsigned int ec_idle_irq; // see module.c
+#ifdef EC_DEBUG_IF
+extern unsigned int ec_debug_sample; // see module.c
+extern unsigned int ec_debug_filter; // see module.c
+#endif
+#ifdef EC_EOE
+extern unsigned int ec_eoe_share; // see module.c
+#endif
 
 /*****************************************************************************/
 
@@ -36,10 +36,14 @@
 #include <linux/module.h>
 #include <linux/device.h>
 #include <linux/err.h>
+#include <linux/version.h>
+#include <linux/eventfd.h>
 
 #include "globals.h"
 #include "master.h"
 #include "device.h"
+#include "debugfs.h"
+#include "payload.h"
 
 /*****************************************************************************/
 
@@ -58,7 +62,54 @@ static char *main_devices[MAX_MASTERS]; /**< Main devices parameter. */
 static unsigned int master_count; /**< Number of masters. */
 static char *backup_devices[MAX_MASTERS]; /**< Backup devices parameter. */
 static unsigned int backup_count; /**< Number of backup devices. */
+static unsigned int main_vlans[MAX_MASTERS]; /**< Main device VLAN tag
+                                               parameter. */
+static unsigned int main_vlan_count; /**< Number of main device VLAN tags. */
+static unsigned int backup_vlans[MAX_MASTERS]; /**< Backup device VLAN tag
+                                                 parameter. */
+static unsigned int backup_vlan_count; /**< Number of backup device VLAN
+                                         tags. */
 static unsigned int debug_level;  /**< Debug level parameter. */
+static unsigned int ext_ring_sizes[MAX_MASTERS]; /**< External datagram ring
+                                                   size parameter. */
+static unsigned int ext_ring_size_count; /**< Number of external datagram
+                                           ring sizes. */
+static int thread_cpus[MAX_MASTERS]; /**< Thread CPU parameter. */
+static unsigned int thread_cpu_count; /**< Number of thread CPUs. */
+unsigned int ec_tx_ring_size = EC_TX_RING_SIZE; /**< Transmit ring size
+                                                  parameter. */
+unsigned int ec_fsm_master_configs = EC_FSM_MASTER_CONFIGS; /**< Number of
+                                                              parallel slave
+                                                              configurations
+                                                              parameter. */
+unsigned int ec_sii_cache; /**< SII cache parameter. */
+unsigned int ec_al_status_fmmu; /**< AL status FMMU parameter. */
+unsigned int ec_group_op; /**< Grouped OP request parameter. */
+unsigned int ec_reuse_config; /**< Configuration reuse parameter. */
+unsigned int ec_handover; /**< Application handover parameter. */
+unsigned int ec_mbox_status_fmmu; /**< Mailbox status FMMU parameter. */
+unsigned int ec_mbox_data_fmmu; /**< Mailbox data FMMU parameter. */
+unsigned int ec_dict_cache; /**< SDO dictionary cache parameter. */
+unsigned int ec_idle_irq; /**< Interrupt-driven idle phase parameter. */
+unsigned int ec_error_monitor_interval; /**< Error counter monitor
+                                          parameter. */
+unsigned int ec_dc_monitor_interval; /**< DC time difference monitor
+                                       parameter. */
+unsigned int ec_monitor_interval; /**< Bus monitoring interval parameter. */
+#ifdef EC_DEBUG_IF
+unsigned int ec_debug_sample = 1; /**< Debug interface sampling rate
+                                    parameter. */
+unsigned int ec_debug_filter; /**< Debug interface filter parameter. */
+#endif
+#ifdef EC_EOE
+unsigned int ec_eoe_tx_queue_bytes = EC_EOE_TX_QUEUE_BYTES; /**< EoE transmit
+                                                              queue size
+                                                              parameter. */
+unsigned int ec_eoe_tx_queue_delay = EC_EOE_TX_QUEUE_DELAY; /**< EoE transmit
+                                                              queue delay
+                                                              parameter. */
+unsigned int ec_eoe_share = EC_EOE_SHARE; /**< EoE cycle share parameter. */
+#endif
 
 static ec_master_t *masters; /**< Array of masters. */
 static struct semaphore master_sem; /**< Master semaphore. */
@@ -83,8 +134,82 @@ module_param_array(main_devices, charp, &master_count, S_IRUGO);
 MODULE_PARM_DESC(main_devices, "MAC addresses of main devices");
 module_param_array(backup_devices, charp, &backup_count, S_IRUGO);
 MODULE_PARM_DESC(backup_devices, "MAC addresses of backup devices");
+module_param_array_named(main_vlan, main_vlans, uint, &main_vlan_count,
+        S_IRUGO);
+MODULE_PARM_DESC(main_vlan, "IEEE 802.1Q tags of the main device frames"
+        " (PCP << 13 | VID, 0 = untagged)");
+module_param_array_named(backup_vlan, backup_vlans, uint,
+        &backup_vlan_count, S_IRUGO);
+MODULE_PARM_DESC(backup_vlan, "IEEE 802.1Q tags of the backup device frames"
+        " (PCP << 13 | VID, 0 = untagged)");
 module_param_named(debug_level, debug_level, uint, S_IRUGO);
 MODULE_PARM_DESC(debug_level, "Debug level");
+module_param_named(tx_ring_size, ec_tx_ring_size, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_ring_size, "Number of transmit socket buffers");
+module_param_named(parallel_configs, ec_fsm_master_configs, uint, S_IRUGO);
+MODULE_PARM_DESC(parallel_configs,
+        "Maximum number of slaves to configure in parallel");
+module_param_named(sii_cache, ec_sii_cache, uint, S_IRUGO);
+MODULE_PARM_DESC(sii_cache, "Reuse SII contents of known slaves on rescan");
+module_param_named(al_status_fmmu, ec_al_status_fmmu, uint, S_IRUGO);
+MODULE_PARM_DESC(al_status_fmmu, "Read AL states via spare FMMUs");
+module_param_named(group_op, ec_group_op, uint, S_IRUGO);
+MODULE_PARM_DESC(group_op, "Request OP for all configured slaves at once");
+module_param_named(reuse_config, ec_reuse_config, uint, S_IRUGO);
+MODULE_PARM_DESC(reuse_config,
+        "Skip configuring slaves with unchanged configurations");
+module_param_named(handover, ec_handover, uint, S_IRUGO);
+MODULE_PARM_DESC(handover,
+        "Keep configured slaves in SAFEOP between two applications");
+module_param_named(mbox_status_fmmu, ec_mbox_status_fmmu, uint, S_IRUGO);
+MODULE_PARM_DESC(mbox_status_fmmu, "Read mailbox states via spare FMMUs");
+module_param_named(mbox_data_fmmu, ec_mbox_data_fmmu, uint, S_IRUGO);
+MODULE_PARM_DESC(mbox_data_fmmu,
+        "Read mailbox responses of many slaves at once via spare FMMUs");
+module_param_named(dict_cache, ec_dict_cache, uint, S_IRUGO);
+MODULE_PARM_DESC(dict_cache,
+        "Share SDO dictionaries among slaves of the same type");
+module_param_named(idle_irq, ec_idle_irq, uint, S_IRUGO);
+MODULE_PARM_DESC(idle_irq,
+        "Wait for receive interrupts instead of polling in idle phase");
+module_param_named(error_monitor_interval, ec_error_monitor_interval, uint,
+        S_IRUGO);
+MODULE_PARM_DESC(error_monitor_interval,
+        "Interval for reading the slave error counters in ms (0 = off)");
+module_param_named(dc_monitor_interval, ec_dc_monitor_interval, uint,
+        S_IRUGO);
+MODULE_PARM_DESC(dc_monitor_interval,
+        "Interval for reading the slave DC time differences in ms (0 = off)");
+module_param_named(monitor_interval, ec_monitor_interval, uint, S_IRUGO);
+MODULE_PARM_DESC(monitor_interval,
+        "Maximum bus monitoring interval in ms, while all slaves are in OP"
+        " (0 = every cycle)");
+#ifdef EC_DEBUG_IF
+module_param_named(debug_sample, ec_debug_sample, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(debug_sample,
+        "Mirror only every n-th frame per direction to the debug interfaces");
+module_param_named(debug_filter, ec_debug_filter, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(debug_filter,
+        "Debug interface filter (1 = only frames with acyclic datagrams)");
+#endif
+#ifdef EC_EOE
+module_param_named(eoe_tx_queue_bytes, ec_eoe_tx_queue_bytes, uint, S_IRUGO);
+MODULE_PARM_DESC(eoe_tx_queue_bytes,
+        "Maximum number of bytes in an EoE transmit queue");
+module_param_named(eoe_tx_queue_delay, ec_eoe_tx_queue_delay, uint, S_IRUGO);
+MODULE_PARM_DESC(eoe_tx_queue_delay,
+        "Maximum time in ms a frame may wait in an EoE transmit queue");
+module_param_named(eoe_share, ec_eoe_share, uint, S_IRUGO);
+MODULE_PARM_DESC(eoe_share,
+        "Percentage of each cycle reserved for EoE (0 = no limit)");
+#endif
+module_param_array_named(ext_ring_size, ext_ring_sizes, uint,
+        &ext_ring_size_count, S_IRUGO);
+MODULE_PARM_DESC(ext_ring_size, "External datagram ring sizes per master");
+module_param_array_named(thread_cpu, thread_cpus, int, &thread_cpu_count,
+        S_IRUGO);
+MODULE_PARM_DESC(thread_cpu,
+        "CPUs to bind the master and EoE threads to per master (-1: any)");
 
 /** \endcond */
 
@@ -103,6 +228,43 @@ int __init ec_init_module(void)
 
     sema_init(&master_sem, 1);
 
+    if (ec_tx_ring_size < 1 || ec_tx_ring_size > EC_MAX_TX_RING_SIZE) {
+        EC_ERR("Invalid transmit ring size %u (1 to %u allowed)!\n",
+                ec_tx_ring_size, EC_MAX_TX_RING_SIZE);
+        ret = -EINVAL;
+        goto out_return;
+    }
+
+    if (ec_fsm_master_configs < 1
+            || ec_fsm_master_configs > EC_MAX_FSM_MASTER_CONFIGS) {
+        EC_ERR("Invalid number of parallel configurations %u"
+                " (1 to %u allowed)!\n",
+                ec_fsm_master_configs, EC_MAX_FSM_MASTER_CONFIGS);
+        ret = -EINVAL;
+        goto out_return;
+    }
+
+    for (i = 0; i < ext_ring_size_count; i++) {
+        if (ext_ring_sizes[i] < EC_MIN_EXT_RING_SIZE
+                || ext_ring_sizes[i] > EC_MAX_EXT_RING_SIZE) {
+            EC_ERR("Invalid external datagram ring size %u"
+                    " (%u to %u allowed)!\n", ext_ring_sizes[i],
+                    EC_MIN_EXT_RING_SIZE, EC_MAX_EXT_RING_SIZE);
+            ret = -EINVAL;
+            goto out_return;
+        }
+    }
+
+    for (i = 0; i < thread_cpu_count; i++) {
+        if (thread_cpus[i] < -1 || (thread_cpus[i] >= 0
+                    && (thread_cpus[i] >= nr_cpu_ids
+                        || !cpu_online(thread_cpus[i])))) {
+            EC_ERR("Invalid thread CPU %i!\n", thread_cpus[i]);
+            ret = -EINVAL;
+            goto out_return;
+        }
+    }
+
     if (master_count) {
         if (alloc_chrdev_region(&device_number,
                     0, master_count, "EtherCAT")) {
@@ -119,6 +281,12 @@ int __init ec_init_module(void)
         goto out_cdev;
     }
 
+    ret = ec_payload_init_module();
+    if (ret)
+        goto out_class_destroy;
+
+    ec_debugfs_init_module();
+
     // zero MAC addresses
     memset(macs, 0x00, sizeof(uint8_t) * MAX_MASTERS * 2 * ETH_ALEN);
 
@@ -133,6 +301,13 @@ int __init ec_init_module(void)
             if (ret)
                 goto out_class;
         }
+
+        if ((i < main_vlan_count && main_vlans[i] > 0xFFFF)
+                || (i < backup_vlan_count && backup_vlans[i] > 0xFFFF)) {
+            EC_ERR("Invalid VLAN tag for master %u.\n", i);
+            ret = -EINVAL;
+            goto out_class;
+        }
     }
 
     // initialize static master variables
@@ -149,8 +324,34 @@ int __init ec_init_module(void)
     }
 
     for (i = 0; i < master_count; i++) {
+        // a single ring size applies to all masters
+        unsigned int ext_ring_size = EC_EXT_RING_SIZE;
+        int cpu = -1;
+        uint16_t vlan_tcis[EC_MAX_NUM_DEVICES];
+
+        if (i < ext_ring_size_count) {
+            ext_ring_size = ext_ring_sizes[i];
+        } else if (ext_ring_size_count == 1) {
+            ext_ring_size = ext_ring_sizes[0];
+        }
+
+        if (i < thread_cpu_count) {
+            cpu = thread_cpus[i];
+        }
+
+        memset(vlan_tcis, 0x00, sizeof(vlan_tcis));
+        if (i < main_vlan_count) {
+            vlan_tcis[EC_DEVICE_MAIN] = main_vlans[i];
+        }
+#if EC_MAX_NUM_DEVICES > 1
+        if (i < backup_vlan_count) {
+            vlan_tcis[EC_DEVICE_BACKUP] = backup_vlans[i];
+        }
+#endif
+
         ret = ec_master_init(&masters[i], i, macs[i][0], macs[i][1],
-                    device_number, class, debug_level);
+                    device_number, class, debug_level, ext_ring_size, cpu,
+                    vlan_tcis);
         if (ret)
             goto out_free_masters;
     }
@@ -164,6 +365,9 @@ out_free_masters:
         ec_master_clear(&masters[i]);
     kfree(masters);
 out_class:
+    ec_debugfs_cleanup_module();
+    ec_payload_cleanup_module();
+out_class_destroy:
     class_destroy(class);
 out_cdev:
     if (master_count)
@@ -189,6 +393,8 @@ void __exit ec_cleanup_module(void)
     if (master_count)
         kfree(masters);
 
+    ec_debugfs_cleanup_module();
+    ec_payload_cleanup_module();
     class_destroy(class);
 
     if (master_count)
@@ -521,20 +727,24 @@ ec_device_t *ecdev_offer(
  * Application interface
  *****************************************************************************/
 
-/** Request a master.
+/** Requests a master for exclusive or shared use.
  *
- * Same as ecrt_request_master(), but with ERR_PTR() return value.
+ * Only the first application enters the OPERATION phase. Further
+ * applications can join, if all of them request the master shared and the
+ * master was not activated yet.
  *
- * \return Requested master.
+ * \return Requested master, or an ERR_PTR() code.
  */
-ec_master_t *ecrt_request_master_err(
-        unsigned int master_index /**< Master index. */
+static ec_master_t *ec_request_master(
+        unsigned int master_index, /**< Master index. */
+        unsigned int shared /**< Share the master with other applications. */
         )
 {
     ec_master_t *master, *errptr = NULL;
-    unsigned int dev_idx = EC_DEVICE_MAIN;
+    unsigned int dev_idx = EC_DEVICE_MAIN, first;
 
-    EC_INFO("Requesting master %u...\n", master_index);
+    EC_INFO("Requesting master %u%s...\n", master_index,
+            shared ? " (shared)" : "");
 
     if (master_index >= master_count) {
         EC_ERR("Invalid master index %u.\n", master_index);
@@ -548,13 +758,18 @@ ec_master_t *ecrt_request_master_err(
         goto out_return;
     }
 
-    if (master->reserved) {
+    if (master->reserved
+            && (!shared || !master->shared || master->active)) {
         up(&master_sem);
         EC_MASTER_ERR(master, "Master already in use!\n");
         errptr = ERR_PTR(-EBUSY);
         goto out_return;
     }
-    master->reserved = 1;
+    first = !master->reserved;
+    master->reserved++;
+    if (first) {
+        master->shared = shared;
+    }
     up(&master_sem);
 
     if (down_interruptible(&master->device_sem)) {
@@ -562,7 +777,7 @@ ec_master_t *ecrt_request_master_err(
         goto out_release;
     }
 
-    if (master->phase != EC_IDLE) {
+    if (master->phase != (first ? EC_IDLE : EC_OPERATION)) {
         up(&master->device_sem);
         EC_MASTER_ERR(master, "Master still waiting for devices!\n");
         errptr = ERR_PTR(-ENODEV);
@@ -581,7 +796,7 @@ ec_master_t *ecrt_request_master_err(
 
     up(&master->device_sem);
 
-    if (ec_master_enter_operation_phase(master)) {
+    if (first && ec_master_enter_operation_phase(master)) {
         EC_MASTER_ERR(master, "Failed to enter OPERATION phase!\n");
         errptr = ERR_PTR(-EIO);
         goto out_module_put;
@@ -596,13 +811,47 @@ ec_master_t *ecrt_request_master_err(
         module_put(device->module);
     }
  out_release:
-    master->reserved = 0;
+    down(&master_sem);
+    master->reserved--;
+    up(&master_sem);
  out_return:
     return errptr;
 }
 
 /*****************************************************************************/
 
+/** Request a master.
+ *
+ * Same as ecrt_request_master(), but with ERR_PTR() return value.
+ *
+ * \return Requested master.
+ */
+ec_master_t *ecrt_request_master_err(
+        unsigned int master_index /**< Master index. */
+        )
+{
+    return ec_request_master(master_index, 0);
+}
+
+/*****************************************************************************/
+
+/** Request a master, that is shared with other userspace applications.
+ *
+ * Every application uses its own slave configurations and domains and
+ * cycles them independently. The master is activated, as soon as all
+ * applications activated it.
+ *
+ * \return Requested master, or an ERR_PTR() code.
+ */
+ec_master_t *ec_request_master_shared_err(
+        unsigned int master_index /**< Master index. */
+        )
+{
+    return ec_request_master(master_index, 1);
+}
+
+/*****************************************************************************/
+
 ec_master_t *ecrt_request_master(unsigned int master_index)
 {
     ec_master_t *master = ecrt_request_master_err(master_index);
@@ -623,14 +872,21 @@ void ecrt_release_master(ec_master_t *master)
         return;
     }
 
-    ec_master_leave_operation_phase(master);
+    if (master->reserved == 1) {
+        ec_master_leave_operation_phase(master);
+    }
 
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
             dev_idx++) {
         module_put(master->devices[dev_idx].module);
     }
 
-    master->reserved = 0;
+    down(&master_sem);
+    if (!--master->reserved) {
+        master->shared = 0;
+        master->activations = 0;
+    }
+    up(&master_sem);
 
     EC_MASTER_INFO(master, "Released.\n");
 }
@@ -658,6 +914,56 @@ const ec_request_state_t ec_request_state_translation_table[] = {
 
 /*****************************************************************************/
 
+/** Replaces the eventfd context, that signals the completion of a request.
+ *
+ * The context is looked up in the file descriptor table of the calling
+ * process. A negative \a fd only releases the current context.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_request_eventfd(
+        struct eventfd_ctx **eventfd, /**< Eventfd context of the request. */
+        int fd /**< Eventfd file descriptor, or -1. */
+        )
+{
+    struct eventfd_ctx *ctx = NULL;
+
+    if (fd >= 0) {
+        ctx = eventfd_ctx_fdget(fd);
+        if (IS_ERR(ctx)) {
+            return PTR_ERR(ctx);
+        }
+    }
+
+    if (*eventfd) {
+        eventfd_ctx_put(*eventfd);
+    }
+
+    *eventfd = ctx;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Signals the completion of a request via its eventfd context, if any.
+ */
+void ec_request_eventfd_signal(
+        struct eventfd_ctx *eventfd /**< Eventfd context, or NULL. */
+        )
+{
+    if (!eventfd) {
+        return;
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+    eventfd_signal(eventfd);
+#else
+    eventfd_signal(eventfd, 1);
+#endif
+}
+
+/*****************************************************************************/
+
 /** \cond */
 
 module_init(ec_init_module);
@@ -0,0 +1,208 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Pool for datagram and request payload memory.
+
+   Payloads of up to EC_PAYLOAD_SIZE bytes are allocated from a dedicated
+   slab cache and are always given the full object size, so that a buffer,
+   that grows on demand, is allocated at most once. Freed objects are kept
+   in a reserve, that is filled in advance by ec_payload_reserve(), so that
+   mailbox transfers and reconfigurations during operation take their
+   memory from the reserve instead of the page allocator.
+*/
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include "payload.h"
+
+/*****************************************************************************/
+
+/** Free object in the reserve.
+ */
+typedef struct ec_payload_free {
+    struct ec_payload_free *next; /**< Next free object. */
+} ec_payload_free_t;
+
+static struct kmem_cache *ec_payload_cache; /**< Cache of payload objects. */
+static DEFINE_SPINLOCK(ec_payload_lock); /**< Protects the reserve. */
+static ec_payload_free_t *ec_payload_reserve_list; /**< Free objects. */
+static unsigned int ec_payload_reserve_count; /**< Number of free objects. */
+static unsigned int ec_payload_reserve_size; /**< Number of free objects to
+                                               keep. */
+
+/*****************************************************************************/
+
+/** Creates the payload cache.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_payload_init_module(void)
+{
+    ec_payload_cache = kmem_cache_create("ec_payload", EC_PAYLOAD_SIZE, 0,
+            0, NULL);
+    if (!ec_payload_cache) {
+        EC_ERR("Failed to create payload cache.\n");
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Frees the reserve and destroys the payload cache.
+ */
+void ec_payload_cleanup_module(void)
+{
+    while (ec_payload_reserve_list) {
+        ec_payload_free_t *obj = ec_payload_reserve_list;
+        ec_payload_reserve_list = obj->next;
+        kmem_cache_free(ec_payload_cache, obj);
+    }
+
+    ec_payload_reserve_count = 0;
+    ec_payload_reserve_size = 0;
+    kmem_cache_destroy(ec_payload_cache);
+}
+
+/*****************************************************************************/
+
+/** Fills the reserve up to at least the given number of objects.
+ *
+ * The reserve is shared by all masters and never shrinks.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_payload_reserve(
+        unsigned int count /**< Number of objects to keep in reserve. */
+        )
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&ec_payload_lock, flags);
+    if (count > ec_payload_reserve_size) {
+        ec_payload_reserve_size = count;
+    }
+
+    while (ec_payload_reserve_count < ec_payload_reserve_size) {
+        ec_payload_free_t *obj;
+
+        spin_unlock_irqrestore(&ec_payload_lock, flags);
+        obj = kmem_cache_alloc(ec_payload_cache, GFP_KERNEL);
+        if (!obj) {
+            EC_ERR("Failed to fill the payload reserve.\n");
+            return -ENOMEM;
+        }
+        spin_lock_irqsave(&ec_payload_lock, flags);
+
+        obj->next = ec_payload_reserve_list;
+        ec_payload_reserve_list = obj;
+        ec_payload_reserve_count++;
+    }
+    spin_unlock_irqrestore(&ec_payload_lock, flags);
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Allocates payload memory.
+ *
+ * \return Pointer to the memory, or NULL if out of memory.
+ */
+void *ec_payload_alloc(
+        size_t size, /**< Number of bytes needed. */
+        size_t *mem_size /**< Actual size of the returned memory. */
+        )
+{
+    ec_payload_free_t *obj;
+    unsigned long flags;
+
+    if (size > EC_PAYLOAD_SIZE) {
+        *mem_size = size;
+        return kmalloc(size, GFP_KERNEL);
+    }
+
+    spin_lock_irqsave(&ec_payload_lock, flags);
+    obj = ec_payload_reserve_list;
+    if (obj) {
+        ec_payload_reserve_list = obj->next;
+        ec_payload_reserve_count--;
+    }
+    spin_unlock_irqrestore(&ec_payload_lock, flags);
+
+    if (!obj) {
+        obj = kmem_cache_alloc(ec_payload_cache, GFP_KERNEL);
+    }
+
+    *mem_size = EC_PAYLOAD_SIZE;
+    return obj;
+}
+
+/*****************************************************************************/
+
+/** Frees payload memory.
+ */
+void ec_payload_free(
+        void *data, /**< Memory returned by ec_payload_alloc(), or NULL. */
+        size_t mem_size /**< Size returned by ec_payload_alloc(). */
+        )
+{
+    ec_payload_free_t *obj = data;
+    unsigned long flags;
+
+    if (!data) {
+        return;
+    }
+
+    if (mem_size > EC_PAYLOAD_SIZE) {
+        kfree(data);
+        return;
+    }
+
+    spin_lock_irqsave(&ec_payload_lock, flags);
+    if (ec_payload_reserve_count < ec_payload_reserve_size) {
+        obj->next = ec_payload_reserve_list;
+        ec_payload_reserve_list = obj;
+        ec_payload_reserve_count++;
+        obj = NULL;
+    }
+    spin_unlock_irqrestore(&ec_payload_lock, flags);
+
+    if (obj) {
+        kmem_cache_free(ec_payload_cache, obj);
+    }
+}
+
+/*****************************************************************************/
@@ -0,0 +1,66 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Pool for datagram and request payload memory.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_PAYLOAD_H__
+#define __EC_PAYLOAD_H__
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** Size of the pooled payload objects.
+ *
+ * Every payload of up to this size (a whole datagram, and thus every
+ * mailbox) is served by the pool. Larger payloads are allocated directly.
+ */
+#define EC_PAYLOAD_SIZE EC_MAX_DATA_SIZE
+
+/** Payload objects reserved per master on activation, in addition to two
+ * per slave.
+ */
+#define EC_PAYLOAD_RESERVE 32
+
+/*****************************************************************************/
+
+int ec_payload_init_module(void);
+void ec_payload_cleanup_module(void);
+int ec_payload_reserve(unsigned int);
+void *ec_payload_alloc(size_t, size_t *);
+void ec_payload_free(void *, size_t);
+
+/*****************************************************************************/
+
+#endif
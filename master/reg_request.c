@@ -36,7 +36,9 @@
 #include <linux/module.h>
 #include <linux/jiffies.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
 
+#include "slave_config.h"
 #include "reg_request.h"
 
 /*****************************************************************************/
@@ -56,6 +58,7 @@ int ec_reg_request_init(
     }
 
     INIT_LIST_HEAD(&reg->list);
+    reg->config = NULL;
     reg->mem_size = size;
     memset(reg->data, 0x00, size);
     reg->dir = EC_DIR_INVALID;
@@ -63,6 +66,9 @@ int ec_reg_request_init(
     reg->transfer_size = 0;
     reg->state = EC_INT_REQUEST_INIT;
     reg->ring_position = 0;
+    reg->complete_cb = NULL;
+    reg->cb_data = NULL;
+    reg->eventfd = NULL;
     return 0;
 }
 
@@ -77,6 +83,92 @@ void ec_reg_request_clear(
     if (reg->data) {
         kfree(reg->data);
     }
+
+    ec_request_eventfd(&reg->eventfd, -1);
+}
+
+/*****************************************************************************/
+
+/** Notifies the application about the completion of the request.
+ *
+ * Signals the eventfd and calls the completion callback, if set. The
+ * callback is the last access to the request, because it may free it.
+ */
+void ec_reg_request_notify(
+        ec_reg_request_t *reg /**< Register request. */
+        )
+{
+    ec_request_eventfd_signal(reg->eventfd);
+
+    if (reg->complete_cb) {
+        reg->complete_cb(reg, reg->cb_data);
+    }
+}
+
+/*****************************************************************************/
+
+/** Register batch request constructor.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+int ec_reg_batch_init(
+        ec_reg_batch_t *batch, /**< Register batch request. */
+        unsigned int count, /**< Number of slaves. */
+        size_t size /**< Data size per slave. */
+        )
+{
+    INIT_LIST_HEAD(&batch->list);
+    batch->dir = EC_DIR_INVALID;
+    batch->address = 0;
+    batch->transfer_size = size;
+    batch->traffic_class = EC_TC_MASTER_FSM;
+    batch->count = count;
+    batch->index = 0;
+    batch->state = EC_INT_REQUEST_INIT;
+    batch->data = NULL;
+    batch->working_counters = NULL;
+
+    if (!count || size > EC_MAX_DATA_SIZE) {
+        batch->positions = NULL;
+        return -EINVAL;
+    }
+
+    batch->positions = kcalloc(count, sizeof(*batch->positions), GFP_KERNEL);
+    batch->working_counters =
+        kcalloc(count, sizeof(*batch->working_counters), GFP_KERNEL);
+    batch->data = vzalloc(count * size);
+    if (!batch->positions || !batch->working_counters || !batch->data) {
+        EC_ERR("Failed to allocate register batch memory for %u slaves.\n",
+                count);
+        ec_reg_batch_clear(batch);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Register batch request destructor.
+ */
+void ec_reg_batch_clear(
+        ec_reg_batch_t *batch /**< Register batch request. */
+        )
+{
+    if (batch->positions) {
+        kfree(batch->positions);
+        batch->positions = NULL;
+    }
+
+    if (batch->working_counters) {
+        kfree(batch->working_counters);
+        batch->working_counters = NULL;
+    }
+
+    if (batch->data) {
+        vfree(batch->data);
+        batch->data = NULL;
+    }
 }
 
 /*****************************************************************************
@@ -104,6 +196,9 @@ void ecrt_reg_request_write(ec_reg_request_t *reg, uint16_t address,
     reg->address = address;
     reg->transfer_size = min(size, reg->mem_size);
     reg->state = EC_INT_REQUEST_QUEUED;
+    if (reg->config) {
+        ec_slave_config_kick(reg->config);
+    }
 }
 
 /*****************************************************************************/
@@ -115,6 +210,18 @@ void ecrt_reg_request_read(ec_reg_request_t *reg, uint16_t address,
     reg->address = address;
     reg->transfer_size = min(size, reg->mem_size);
     reg->state = EC_INT_REQUEST_QUEUED;
+    if (reg->config) {
+        ec_slave_config_kick(reg->config);
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_reg_request_callback(ec_reg_request_t *reg,
+        void (*cb)(ec_reg_request_t *, void *), void *cb_data)
+{
+    reg->complete_cb = cb;
+    reg->cb_data = cb_data;
 }
 
 /*****************************************************************************/
@@ -125,6 +232,7 @@ EXPORT_SYMBOL(ecrt_reg_request_data);
 EXPORT_SYMBOL(ecrt_reg_request_state);
 EXPORT_SYMBOL(ecrt_reg_request_write);
 EXPORT_SYMBOL(ecrt_reg_request_read);
+EXPORT_SYMBOL(ecrt_reg_request_callback);
 
 /** \endcond */
 
@@ -47,6 +47,8 @@
  */
 struct ec_reg_request {
     struct list_head list; /**< List item. */
+    ec_slave_config_t *config; /**< Slave configuration of an internal
+                                 request, or NULL. */
     size_t mem_size; /**< Size of data memory. */
     uint8_t *data; /**< Pointer to data memory. */
     ec_direction_t dir; /**< Direction. EC_DIR_OUTPUT means writing to the
@@ -55,12 +57,45 @@ struct ec_reg_request {
     size_t transfer_size; /**< Size of the data to transfer. */
     ec_internal_request_state_t state; /**< Request state. */
     uint16_t ring_position; /**< Ring position for emergency requests. */
+    void (*complete_cb)(ec_reg_request_t *, void *); /**< Completion
+                                                       callback. */
+    void *cb_data; /**< Data for \a complete_cb. */
+    struct eventfd_ctx *eventfd; /**< Eventfd signalled on completion. */
 };
 
 /*****************************************************************************/
 
 int ec_reg_request_init(ec_reg_request_t *, size_t);
 void ec_reg_request_clear(ec_reg_request_t *);
+void ec_reg_request_notify(ec_reg_request_t *);
+
+/*****************************************************************************/
+
+/** Register batch request.
+ *
+ * Transfers the same register range of several slaves. The master state
+ * machine packs one FPRD/FPWR datagram per slave into the frames of a
+ * cycle, so that all slaves are served in a few cycles.
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    ec_direction_t dir; /**< Direction. EC_DIR_OUTPUT means writing to the
+                          slaves, EC_DIR_INPUT means reading from them. */
+    uint16_t address; /**< Register address. */
+    size_t transfer_size; /**< Size of the data to transfer per slave. */
+    ec_traffic_class_t traffic_class; /**< Traffic class of the
+                                        datagrams. */
+    unsigned int count; /**< Number of slaves. */
+    uint16_t *positions; /**< Ring positions of the slaves. */
+    uint8_t *data; /**< Data memory, \a transfer_size bytes per slave. */
+    uint16_t *working_counters; /**< Working counter per slave. One means,
+                                  that the slave was accessed. */
+    unsigned int index; /**< Index of the next slave to process. */
+    ec_internal_request_state_t state; /**< Request state. */
+} ec_reg_batch_t;
+
+int ec_reg_batch_init(ec_reg_batch_t *, unsigned int, size_t);
+void ec_reg_batch_clear(ec_reg_batch_t *);
 
 /*****************************************************************************/
 
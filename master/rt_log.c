@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Deferred logging from realtime context.
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/jiffies.h>
+#include <linux/bitops.h>
+
+#include "master.h"
+#include "rt_log.h"
+
+/*****************************************************************************/
+
+/** Constructor.
+ */
+void ec_rt_log_init(
+        ec_rt_log_t *log, /**< RT log. */
+        unsigned int master_index /**< Index of the owning master. */
+        )
+{
+    unsigned int i;
+
+    log->master_index = master_index;
+
+    for (i = 0; i < EC_RT_LOG_SIZE; i++) {
+        log->msgs[i].seq = 0;
+    }
+
+    atomic_set(&log->write_seq, 0);
+    log->read_seq = 0;
+
+    for (i = 0; i < EC_RT_LOG_TYPES; i++) {
+        log->limits[i].jiffies = jiffies;
+        log->limits[i].count = 0;
+        atomic_set(&log->limits[i].suppressed, 0);
+    }
+
+    atomic_set(&log->dropped, 0);
+    log->flushing = 0;
+}
+
+/*****************************************************************************/
+
+/** Formats a message into the RT log.
+ *
+ * This never blocks and may be called from any context. The message is
+ * printed by the next ec_rt_log_flush().
+ */
+void ec_rt_log(
+        ec_rt_log_t *log, /**< RT log. */
+        ec_rt_log_type_t type, /**< Message type for rate limiting. */
+        ec_rt_log_level_t level, /**< Message level. */
+        const char *fmt, /**< Format string. */
+        ... /**< Arguments. */
+        )
+{
+    ec_rt_log_limit_t *limit = &log->limits[type];
+    ec_rt_log_msg_t *msg;
+    unsigned int seq;
+    va_list args;
+
+    if (jiffies - limit->jiffies >= HZ) {
+        limit->jiffies = jiffies;
+        limit->count = 0;
+    }
+
+    if (limit->count >= EC_RT_LOG_BURST) {
+        atomic_inc(&limit->suppressed);
+        return;
+    }
+
+    limit->count++;
+
+    // reserve a slot
+    do {
+        seq = atomic_read(&log->write_seq);
+        if (seq - smp_load_acquire(&log->read_seq) >= EC_RT_LOG_SIZE) {
+            atomic_inc(&log->dropped);
+            return;
+        }
+    } while (atomic_cmpxchg(&log->write_seq, seq, seq + 1) != seq);
+
+    msg = &log->msgs[seq % EC_RT_LOG_SIZE];
+    msg->level = level;
+
+    va_start(args, fmt);
+    vsnprintf(msg->text, EC_RT_LOG_TEXT_SIZE, fmt, args);
+    va_end(args);
+
+    smp_store_release(&msg->seq, seq + 1);
+}
+
+/*****************************************************************************/
+
+/** Prints a message of the RT log with its level.
+ */
+static void ec_rt_log_print(
+        const ec_rt_log_msg_t *msg /**< Message. */
+        )
+{
+    switch (msg->level) {
+        case EC_RT_LOG_ERR:
+            printk(KERN_ERR "%s", msg->text);
+            break;
+        case EC_RT_LOG_WARN:
+            printk(KERN_WARNING "%s", msg->text);
+            break;
+        case EC_RT_LOG_INFO:
+            printk(KERN_INFO "%s", msg->text);
+            break;
+        default:
+            printk(KERN_DEBUG "%s", msg->text);
+            break;
+    }
+}
+
+/*****************************************************************************/
+
+/** Prints the pending messages of the RT log to the syslog.
+ *
+ * Called from the master thread, never from realtime context. Concurrent
+ * calls return immediately.
+ */
+void ec_rt_log_flush(
+        ec_rt_log_t *log /**< RT log. */
+        )
+{
+    static const char *type_names[EC_RT_LOG_TYPES] = {
+        "statistics", "datagram", "injection", "domain"
+    };
+    ec_rt_log_msg_t *msg;
+    unsigned int seq, i, count;
+
+    if (test_and_set_bit(0, &log->flushing)) {
+        return;
+    }
+
+    while (1) {
+        seq = log->read_seq;
+        msg = &log->msgs[seq % EC_RT_LOG_SIZE];
+        if (smp_load_acquire(&msg->seq) != seq + 1) {
+            break;
+        }
+
+        ec_rt_log_print(msg);
+        smp_store_release(&log->read_seq, seq + 1);
+    }
+
+    for (i = 0; i < EC_RT_LOG_TYPES; i++) {
+        if ((count = atomic_xchg(&log->limits[i].suppressed, 0))) {
+            printk(KERN_WARNING "EtherCAT WARNING %u: %u %s message%s"
+                    " suppressed.\n", log->master_index, count,
+                    type_names[i], count == 1 ? "" : "s");
+        }
+    }
+
+    if ((count = atomic_xchg(&log->dropped, 0))) {
+        printk(KERN_WARNING "EtherCAT WARNING %u: %u message%s dropped,"
+                " RT log full.\n", log->master_index, count,
+                count == 1 ? "" : "s");
+    }
+
+    clear_bit(0, &log->flushing);
+}
+
+/*****************************************************************************/
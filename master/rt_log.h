@@ -0,0 +1,130 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Deferred logging from realtime context.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_RT_LOG_H__
+#define __EC_RT_LOG_H__
+
+#include <linux/atomic.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** Number of messages in the RT log ring (power of 2). */
+#define EC_RT_LOG_SIZE 64
+
+/** Maximum length of a message including the prefix. */
+#define EC_RT_LOG_TEXT_SIZE 128
+
+/** Messages per type and second, that are passed to the ring. */
+#define EC_RT_LOG_BURST 10
+
+/*****************************************************************************/
+
+/** RT log message type.
+ *
+ * The rate limit is applied per type.
+ */
+typedef enum {
+    EC_RT_LOG_STATS, /**< Frame statistics of the master. */
+    EC_RT_LOG_DATAGRAM, /**< Datagram queuing and timeouts. */
+    EC_RT_LOG_INJECTION, /**< Injection of internal datagrams. */
+    EC_RT_LOG_DOMAIN, /**< Domain working counter and redundancy. */
+    EC_RT_LOG_TYPES /**< Number of types. */
+} ec_rt_log_type_t;
+
+/** RT log message level.
+ */
+typedef enum {
+    EC_RT_LOG_ERR, /**< Error. */
+    EC_RT_LOG_WARN, /**< Warning. */
+    EC_RT_LOG_INFO, /**< Information. */
+    EC_RT_LOG_DBG /**< Debug message. */
+} ec_rt_log_level_t;
+
+/*****************************************************************************/
+
+/** RT log message.
+ */
+typedef struct {
+    unsigned int seq; /**< Sequence number + 1, as soon as the message is
+                        complete. */
+    ec_rt_log_level_t level; /**< Message level. */
+    char text[EC_RT_LOG_TEXT_SIZE]; /**< Formatted message. */
+} ec_rt_log_msg_t;
+
+/** Rate limit of an RT log message type.
+ */
+typedef struct {
+    unsigned long jiffies; /**< Start of the current interval. */
+    unsigned int count; /**< Messages in the current interval. */
+    atomic_t suppressed; /**< Messages suppressed since the last flush. */
+} ec_rt_log_limit_t;
+
+/** Deferred log for realtime context.
+ *
+ * Messages from the cyclic realtime functions are formatted into a lock-free
+ * ring instead of being passed to printk() directly, which could block the
+ * realtime cycle on the console. The ring is flushed to the syslog by the
+ * master thread. Producers reserve a slot with a compare-and-exchange on the
+ * write sequence, so the ring is safe for concurrent producers; there is a
+ * single consumer. If the ring is full, messages are dropped and counted.
+ *
+ * The rate limit counters are not protected against concurrent producers, a
+ * lost update only affects the limit of the current interval.
+ */
+typedef struct {
+    unsigned int master_index; /**< Index of the owning master. */
+    ec_rt_log_msg_t msgs[EC_RT_LOG_SIZE]; /**< Message ring. */
+    atomic_t write_seq; /**< Sequence number of the next message to write. */
+    unsigned int read_seq; /**< Sequence number of the next message to read
+                             (written by the consumer). */
+    ec_rt_log_limit_t limits[EC_RT_LOG_TYPES]; /**< Rate limits. */
+    atomic_t dropped; /**< Messages dropped since the last flush, because
+                        the ring was full. */
+    unsigned long flushing; /**< Bit 0 is set, while a flush is running. */
+} ec_rt_log_t;
+
+/*****************************************************************************/
+
+void ec_rt_log_init(ec_rt_log_t *, unsigned int);
+void ec_rt_log(ec_rt_log_t *, ec_rt_log_type_t, ec_rt_log_level_t,
+        const char *, ...) __attribute__((format(printf, 4, 5)));
+void ec_rt_log_flush(ec_rt_log_t *);
+
+/*****************************************************************************/
+
+#endif
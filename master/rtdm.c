@@ -154,6 +154,10 @@ int ec_rtdm_open(
     ctx->ioctl_ctx.requested = 0;
     ctx->ioctl_ctx.process_data = NULL;
     ctx->ioctl_ctx.process_data_size = 0;
+    ctx->ioctl_ctx.mmap_size = 0;
+    ctx->ioctl_ctx.state = NULL;
+    ctx->ioctl_ctx.read_only_map = 0;
+    ctx->ioctl_ctx.emerg_eventfd = NULL;
 
 #if DEBUG
     EC_MASTER_INFO(rtdm_dev->master, "RTDM device %s opened.\n",
@@ -203,6 +207,11 @@ int ec_rtdm_ioctl(
     ec_rtdm_context_t *ctx = (ec_rtdm_context_t *) context->dev_private;
     ec_rtdm_dev_t *rtdm_dev = (ec_rtdm_dev_t *) context->device->device_data;
 
+    if (likely(request == EC_IOCTL_CYCLE_SHARED)) {
+        // cyclic calls take the fast path without argument copying
+        return ec_ioctl_rtdm_cycle(rtdm_dev->master, &ctx->ioctl_ctx);
+    }
+
 #if DEBUG
     EC_MASTER_INFO(rtdm_dev->master, "ioctl(request = %u, ctl = %02x)"
             " on RTDM device %s.\n", request, _IOC_NR(request),
@@ -227,7 +236,7 @@ int ec_rtdm_mmap(
     int ret;
 
     ret = rtdm_mmap_to_user(ctx->user_info,
-            ioctl_ctx->process_data, ioctl_ctx->process_data_size,
+            ioctl_ctx->process_data, ioctl_ctx->mmap_size,
             PROT_READ | PROT_WRITE,
             user_address,
             NULL, NULL);
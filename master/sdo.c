@@ -46,16 +46,18 @@
  */
 void ec_sdo_init(
         ec_sdo_t *sdo, /**< SDO. */
-        ec_slave_t *slave, /**< Parent slave. */
+        ec_dict_t *dict, /**< Parent dictionary. */
         uint16_t index /**< SDO index. */
         )
 {
-    sdo->slave = slave;
+    sdo->dict = dict;
     sdo->index = index;
     sdo->object_code = 0x00;
     sdo->name = NULL;
     sdo->max_subindex = 0;
     INIT_LIST_HEAD(&sdo->entries);
+    sdo->entries_pending = 0;
+    sdo->entries_busy = 0;
 }
 
 /*****************************************************************************/
@@ -67,18 +69,28 @@ void ec_sdo_init(
 void ec_sdo_clear(
         ec_sdo_t *sdo /**< SDO. */
         )
+{
+    ec_sdo_clear_entries(sdo);
+
+    if (sdo->name)
+        kfree(sdo->name);
+}
+
+/*****************************************************************************/
+
+/** Clears and frees all entries of an SDO.
+ */
+void ec_sdo_clear_entries(
+        ec_sdo_t *sdo /**< SDO. */
+        )
 {
     ec_sdo_entry_t *entry, *next;
 
-    // free all entries
     list_for_each_entry_safe(entry, next, &sdo->entries, list) {
         list_del(&entry->list);
         ec_sdo_entry_clear(entry);
         kfree(entry);
     }
-
-    if (sdo->name)
-        kfree(sdo->name);
 }
 
 /*****************************************************************************/
@@ -48,18 +48,32 @@
  */
 struct ec_sdo {
     struct list_head list; /**< List item. */
-    ec_slave_t *slave; /**< Parent slave. */
+    ec_dict_t *dict; /**< Parent dictionary. */
     uint16_t index; /**< SDO index. */
     uint8_t object_code; /**< Object code. */
     char *name; /**< SDO name. */
     uint8_t max_subindex; /**< Maximum subindex. */
     struct list_head entries; /**< List of entries. */
+    uint8_t entries_pending; /**< The entry descriptions were not fetched
+                               yet. They are fetched on first access. */
+    uint8_t entries_busy; /**< The entry descriptions are being fetched. */
 };
 
 /*****************************************************************************/
 
-void ec_sdo_init(ec_sdo_t *, ec_slave_t *, uint16_t);
+/** Request to fetch the pending entry descriptions of an SDO.
+ */
+typedef struct {
+    struct list_head list; /**< List item. */
+    uint16_t index; /**< SDO index. */
+    ec_internal_request_state_t state; /**< Request state. */
+} ec_sdo_entries_request_t;
+
+/*****************************************************************************/
+
+void ec_sdo_init(ec_sdo_t *, ec_dict_t *, uint16_t);
 void ec_sdo_clear(ec_sdo_t *);
+void ec_sdo_clear_entries(ec_sdo_t *);
 
 ec_sdo_entry_t *ec_sdo_get_entry(ec_sdo_t *, uint8_t);
 const ec_sdo_entry_t *ec_sdo_get_entry_const(const ec_sdo_t *, uint8_t);
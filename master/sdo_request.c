@@ -37,6 +37,8 @@
 #include <linux/jiffies.h>
 #include <linux/slab.h>
 
+#include "payload.h"
+#include "slave_config.h"
 #include "sdo_request.h"
 
 /*****************************************************************************/
@@ -57,16 +59,21 @@ void ec_sdo_request_init(
         ec_sdo_request_t *req /**< SDO request. */
         )
 {
+    req->config = NULL;
     req->complete_access = 0;
     req->data = NULL;
     req->mem_size = 0;
     req->data_size = 0;
+    req->external_memory = 0;
     req->dir = EC_DIR_INVALID;
     req->issue_timeout = 0; // no timeout
     req->response_timeout = EC_SDO_REQUEST_RESPONSE_TIMEOUT;
     req->state = EC_INT_REQUEST_INIT;
     req->errno = 0;
     req->abort_code = 0x00000000;
+    req->complete_cb = NULL;
+    req->cb_data = NULL;
+    req->eventfd = NULL;
 }
 
 /*****************************************************************************/
@@ -78,6 +85,7 @@ void ec_sdo_request_clear(
         )
 {
     ec_sdo_request_clear_data(req);
+    ec_request_eventfd(&req->eventfd, -1);
 }
 
 /*****************************************************************************/
@@ -107,13 +115,14 @@ void ec_sdo_request_clear_data(
         ec_sdo_request_t *req /**< SDO request. */
         )
 {
-    if (req->data) {
-        kfree(req->data);
-        req->data = NULL;
+    if (req->data && !req->external_memory) {
+        ec_payload_free(req->data, req->mem_size);
     }
 
+    req->data = NULL;
     req->mem_size = 0;
     req->data_size = 0;
+    req->external_memory = 0;
 }
 
 /*****************************************************************************/
@@ -121,8 +130,11 @@ void ec_sdo_request_clear_data(
 /** Pre-allocates the data memory.
  *
  * If the \a mem_size is already bigger than \a size, nothing is done.
+ * External memory is never re-allocated.
  *
- * \return 0 on success, otherwise -ENOMEM.
+ * \retval 0 Success.
+ * \retval -ENOMEM Allocation failed.
+ * \retval -EOVERFLOW \a size exceeds the external memory.
  */
 int ec_sdo_request_alloc(
         ec_sdo_request_t *req, /**< SDO request. */
@@ -132,14 +144,20 @@ int ec_sdo_request_alloc(
     if (size <= req->mem_size)
         return 0;
 
+    if (req->external_memory) {
+        EC_ERR("%zu bytes of SDO data do not fit into the external"
+                " memory (%zu bytes).\n", size, req->mem_size);
+        return -EOVERFLOW;
+    }
+
     ec_sdo_request_clear_data(req);
 
-    if (!(req->data = (uint8_t *) kmalloc(size, GFP_KERNEL))) {
+    if (!(req->data = ec_payload_alloc(size, &req->mem_size))) {
         EC_ERR("Failed to allocate %zu bytes of SDO memory.\n", size);
+        req->mem_size = 0;
         return -ENOMEM;
     }
 
-    req->mem_size = size;
     req->data_size = 0;
     return 0;
 }
@@ -180,6 +198,22 @@ int ec_sdo_request_timed_out(const ec_sdo_request_t *req /**< SDO request. */)
         && jiffies - req->jiffies_start > HZ * req->issue_timeout / 1000;
 }
 
+/*****************************************************************************/
+
+/** Notifies the application about the completion of the request.
+ *
+ * Signals the eventfd and calls the completion callback, if set. The
+ * callback is the last access to the request, because it may free it.
+ */
+void ec_sdo_request_notify(ec_sdo_request_t *req /**< SDO request. */)
+{
+    ec_request_eventfd_signal(req->eventfd);
+
+    if (req->complete_cb) {
+        req->complete_cb(req, req->cb_data);
+    }
+}
+
 /*****************************************************************************
  * Application interface.
  ****************************************************************************/
@@ -189,6 +223,16 @@ void ecrt_sdo_request_index(ec_sdo_request_t *req, uint16_t index,
 {
     req->index = index;
     req->subindex = subindex;
+    req->complete_access = 0;
+}
+
+/*****************************************************************************/
+
+void ecrt_sdo_request_index_complete(ec_sdo_request_t *req, uint16_t index)
+{
+    req->index = index;
+    req->subindex = 0;
+    req->complete_access = 1;
 }
 
 /*****************************************************************************/
@@ -207,6 +251,24 @@ uint8_t *ecrt_sdo_request_data(ec_sdo_request_t *req)
 
 /*****************************************************************************/
 
+int ecrt_sdo_request_external_memory(ec_sdo_request_t *req, uint8_t *data,
+        size_t size)
+{
+    if (!data || !size) {
+        return -EINVAL;
+    }
+
+    ec_sdo_request_clear_data(req);
+
+    req->data = data;
+    req->mem_size = size;
+    req->data_size = size;
+    req->external_memory = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
 size_t ecrt_sdo_request_data_size(const ec_sdo_request_t *req)
 {
     return req->data_size;
@@ -228,6 +290,9 @@ void ecrt_sdo_request_read(ec_sdo_request_t *req)
     req->errno = 0;
     req->abort_code = 0x00000000;
     req->jiffies_start = jiffies;
+    if (req->config) {
+        ec_slave_config_kick(req->config);
+    }
 }
 
 /*****************************************************************************/
@@ -239,6 +304,18 @@ void ecrt_sdo_request_write(ec_sdo_request_t *req)
     req->errno = 0;
     req->abort_code = 0x00000000;
     req->jiffies_start = jiffies;
+    if (req->config) {
+        ec_slave_config_kick(req->config);
+    }
+}
+
+/*****************************************************************************/
+
+void ecrt_sdo_request_callback(ec_sdo_request_t *req,
+        void (*cb)(ec_sdo_request_t *, void *), void *cb_data)
+{
+    req->complete_cb = cb;
+    req->cb_data = cb_data;
 }
 
 /*****************************************************************************/
@@ -246,12 +323,15 @@ void ecrt_sdo_request_write(ec_sdo_request_t *req)
 /** \cond */
 
 EXPORT_SYMBOL(ecrt_sdo_request_index);
+EXPORT_SYMBOL(ecrt_sdo_request_index_complete);
 EXPORT_SYMBOL(ecrt_sdo_request_timeout);
 EXPORT_SYMBOL(ecrt_sdo_request_data);
+EXPORT_SYMBOL(ecrt_sdo_request_external_memory);
 EXPORT_SYMBOL(ecrt_sdo_request_data_size);
 EXPORT_SYMBOL(ecrt_sdo_request_state);
 EXPORT_SYMBOL(ecrt_sdo_request_read);
 EXPORT_SYMBOL(ecrt_sdo_request_write);
+EXPORT_SYMBOL(ecrt_sdo_request_callback);
 
 /** \endcond */
 
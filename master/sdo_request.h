@@ -47,11 +47,15 @@
  */
 struct ec_sdo_request {
     struct list_head list; /**< List item. */
+    ec_slave_config_t *config; /**< Slave configuration of an internal
+                                 request, or NULL. */
     uint16_t index; /**< SDO index. */
     uint8_t subindex; /**< SDO subindex. */
     uint8_t *data; /**< Pointer to SDO data. */
     size_t mem_size; /**< Size of SDO data memory. */
     size_t data_size; /**< Size of SDO data. */
+    uint8_t external_memory; /**< \a data is provided by the application.
+                               It is neither re-allocated nor freed. */
     uint8_t complete_access; /**< SDO shall be transferred completely. */
     uint32_t issue_timeout; /**< Maximum time in ms, the processing of the
                               request may take. */
@@ -66,6 +70,10 @@ struct ec_sdo_request {
                                      request was sent. */
     int errno; /**< Error number. */
     uint32_t abort_code; /**< SDO request abort code. Zero on success. */
+    void (*complete_cb)(ec_sdo_request_t *, void *); /**< Completion
+                                                       callback. */
+    void *cb_data; /**< Data for \a complete_cb. */
+    struct eventfd_ctx *eventfd; /**< Eventfd signalled on completion. */
 };
 
 /*****************************************************************************/
@@ -77,6 +85,7 @@ int ec_sdo_request_copy(ec_sdo_request_t *, const ec_sdo_request_t *);
 int ec_sdo_request_alloc(ec_sdo_request_t *, size_t);
 int ec_sdo_request_copy_data(ec_sdo_request_t *, const uint8_t *, size_t);
 int ec_sdo_request_timed_out(const ec_sdo_request_t *);
+void ec_sdo_request_notify(ec_sdo_request_t *);
 
 /*****************************************************************************/
 
@@ -0,0 +1,139 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   SII category data functions.
+*/
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+#include <linux/jhash.h>
+
+#include "pdo.h"
+#include "sii_data.h"
+
+/*****************************************************************************/
+
+/** Calculates the hash of SII category words.
+ *
+ * \return Hash value.
+ */
+uint32_t ec_sii_data_hash(
+        const uint16_t *words, /**< Category words. */
+        size_t nwords /**< Number of category words. */
+        )
+{
+    return jhash(words, nwords * sizeof(uint16_t), 0);
+}
+
+/*****************************************************************************/
+
+/** Creates empty SII category data for the given category words.
+ *
+ * The words are copied, so that slaves with the same SII contents can be
+ * found later. The caller holds the first reference.
+ *
+ * \return Pointer to the data, or NULL if out of memory.
+ */
+ec_sii_data_t *ec_sii_data_create(
+        const uint16_t *words, /**< Category words. */
+        size_t nwords /**< Number of category words. */
+        )
+{
+    ec_sii_data_t *data;
+    size_t size = nwords * sizeof(uint16_t);
+
+    if (!(data = kmalloc(sizeof(ec_sii_data_t) + size, GFP_KERNEL))) {
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&data->list);
+    data->hash = ec_sii_data_hash(words, nwords);
+    memcpy(data + 1, words, size);
+    data->words = (const uint16_t *) (data + 1);
+    data->nwords = nwords;
+    data->strings = NULL;
+    data->string_count = 0;
+    data->syncs = NULL;
+    data->sync_count = 0;
+    INIT_LIST_HEAD(&data->pdos);
+    data->pdos_parsed = 0;
+    data->refs = 1;
+    return data;
+}
+
+/*****************************************************************************/
+
+/** Releases a slave's reference to the SII category data.
+ *
+ * The data are freed, if they are not used any more.
+ */
+void ec_sii_data_release(
+        ec_sii_data_t *data /**< SII category data. */
+        )
+{
+    ec_pdo_t *pdo, *next_pdo;
+    unsigned int i;
+
+    if (data->refs) {
+        data->refs--;
+    }
+
+    if (data->refs) {
+        return;
+    }
+
+    list_del_init(&data->list);
+
+    if (data->strings) {
+        for (i = 0; i < data->string_count; i++) {
+            kfree(data->strings[i]);
+        }
+        kfree(data->strings);
+    }
+
+    if (data->syncs) {
+        for (i = 0; i < data->sync_count; i++) {
+            ec_sync_clear(&data->syncs[i]);
+        }
+        kfree(data->syncs);
+    }
+
+    list_for_each_entry_safe(pdo, next_pdo, &data->pdos, list) {
+        list_del(&pdo->list);
+        ec_pdo_clear(pdo);
+        kfree(pdo);
+    }
+
+    kfree(data);
+}
+
+/*****************************************************************************/
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   SII category data.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_SII_DATA_H__
+#define __EC_SII_DATA_H__
+
+#include <linux/list.h>
+
+#include "globals.h"
+#include "sync.h"
+
+/*****************************************************************************/
+
+/** SII category data of a slave model.
+ *
+ * Slaves with identical SII category words have identical strings, sync
+ * manager descriptions and PDO descriptions, so the data parsed for the
+ * first slave are shared by all matching slaves. Apart from the PDO
+ * descriptions, that are parsed on demand, shared data are not modified any
+ * more.
+ */
+struct ec_sii_data {
+    struct list_head list; /**< Item of the master's list of shared SII
+                             data. Empty, if the data are not shared. */
+    uint32_t hash; /**< Hash of the category words. */
+    const uint16_t *words; /**< Category words, the data were parsed from. */
+    size_t nwords; /**< Number of category words. */
+    char **strings; /**< Strings in SII categories. */
+    unsigned int string_count; /**< Number of SII strings. */
+    ec_sync_t *syncs; /**< SYNC MANAGER categories with the default PDO
+                        assignment. */
+    unsigned int sync_count; /**< Number of sync managers. */
+    struct list_head pdos; /**< SII [RT]XPDO categories. */
+    unsigned int pdos_parsed; /**< The [RT]XPDO categories were parsed. */
+    unsigned int refs; /**< Number of slaves using the data. */
+};
+
+/*****************************************************************************/
+
+uint32_t ec_sii_data_hash(const uint16_t *, size_t);
+ec_sii_data_t *ec_sii_data_create(const uint16_t *, size_t);
+void ec_sii_data_release(ec_sii_data_t *);
+
+/*****************************************************************************/
+
+#endif
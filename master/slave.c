@@ -36,6 +36,7 @@
 
 #include <linux/module.h>
 #include <linux/delay.h>
+#include <linux/rculist.h>
 
 #include "globals.h"
 #include "datagram.h"
@@ -54,6 +55,33 @@ char *ec_slave_sii_string(ec_slave_t *, unsigned int);
 
 /*****************************************************************************/
 
+/** DC transmission delay correction of an ESC type.
+ */
+typedef struct {
+    uint8_t type; /**< ESC type (register 0x0000). */
+    uint8_t revision; /**< ESC revision (register 0x0001), or 0xff for all
+                        revisions. */
+    int32_t correction; /**< Correction in ns. */
+} ec_dc_delay_correction_t;
+
+/** DC transmission delay corrections.
+ *
+ * The port delays are calculated from the frame round trip times assuming,
+ * that a frame spends the same time on the way to a slave as on the way
+ * back. ESCs with a longer processing delay in forward direction than in
+ * return direction are listed here. The correction is added to the delay
+ * to the slave and subtracted from the delay back, so that the round trip
+ * time is preserved.
+ *
+ * The table is terminated by an entry with type zero. The first matching
+ * entry is used.
+ */
+static const ec_dc_delay_correction_t ec_dc_delay_corrections[] = {
+    {0x00, 0x00, 0}
+};
+
+/*****************************************************************************/
+
 /**
    Slave constructor.
    \return 0 in case of success, else < 0
@@ -89,6 +117,25 @@ void ec_slave_init(
     slave->base_revision = 0;
     slave->base_build = 0;
     slave->base_fmmu_count = 0;
+    slave->al_status_mapped = 0;
+    slave->group_op = 0;
+    slave->config_applied = 0;
+    slave->config_fingerprint = 0;
+    slave->mbox_status_mapped = 0;
+    slave->mbox_status_sync = 1;
+    slave->mbox_status_seq = 0;
+    slave->mbox_data_mapped = 0;
+    slave->mbox_data_active = 0;
+    slave->mbox_data_offset = 0;
+    slave->mbox_stash = NULL;
+    slave->mbox_stash_size = 0;
+    slave->mbox_stash_valid = 0;
+    slave->mbox_sent_time = 0ULL;
+    slave->mbox_response_time = 0;
+    slave->mbox_poll_next = 0ULL;
+    slave->mbox_poll_interval = 0;
+    slave->mbox_repeat_toggle = 0;
+    slave->mbox_repeat_requested = 0;
     slave->base_sync_count = 0;
 
     for (i = 0; i < EC_MAX_PORTS; i++) {
@@ -103,16 +150,32 @@ void ec_slave_init(
 
         slave->ports[i].next_slave = NULL;
         slave->ports[i].delay_to_next_dc = 0U;
+
+        memset(&slave->ports[i].errors, 0, sizeof(slave->ports[i].errors));
     }
 
+    slave->error_samples = 0;
+    slave->error_jiffies = 0;
+    slave->error_interval = 0;
+    slave->processing_unit_errors = 0;
+    slave->pdi_errors = 0;
+    slave->dc_diff_samples = 0;
+    slave->dc_diff_jiffies = 0;
+    slave->dc_diff = 0;
+    slave->dc_diff_max = 0;
+    slave->dc_drift = 0;
+
     slave->base_fmmu_bit_operation = 0;
     slave->base_dc_supported = 0;
     slave->base_dc_range = EC_DC_32;
     slave->has_dc_system_time = 0;
     slave->transmission_delay = 0U;
+    slave->subtree_end = slave + 1;
+    slave->first_dc_slave = NULL;
 
     slave->sii_words = NULL;
     slave->sii_nwords = 0;
+    slave->sii_read_size = 0;
 
     slave->sii.alias = 0x0000;
     slave->sii.vendor_id = 0x00000000;
@@ -129,8 +192,7 @@ void ec_slave_init(
     slave->sii.std_tx_mailbox_size = 0x0000;
     slave->sii.mailbox_protocols = 0;
 
-    slave->sii.strings = NULL;
-    slave->sii.string_count = 0;
+    slave->sii.data = NULL;
 
     slave->sii.has_general = 0;
     slave->sii.group = NULL;
@@ -143,18 +205,19 @@ void ec_slave_init(
 
     slave->sii.syncs = NULL;
     slave->sii.sync_count = 0;
+    slave->sii.pdos_loaded = 0;
 
-    INIT_LIST_HEAD(&slave->sii.pdos);
-
-    INIT_LIST_HEAD(&slave->sdo_dictionary);
+    slave->dict = NULL;
 
     slave->sdo_dictionary_fetched = 0;
     slave->jiffies_preop = 0;
 
     INIT_LIST_HEAD(&slave->sdo_requests);
     INIT_LIST_HEAD(&slave->reg_requests);
+    INIT_LIST_HEAD(&slave->sii_requests);
     INIT_LIST_HEAD(&slave->foe_requests);
     INIT_LIST_HEAD(&slave->soe_requests);
+    INIT_LIST_HEAD(&slave->dict_requests);
 
     // create state machine object
     ec_fsm_slave_init(&slave->fsm, slave);
@@ -169,10 +232,6 @@ void ec_slave_init(
 
 void ec_slave_clear(ec_slave_t *slave /**< EtherCAT slave */)
 {
-    ec_sdo_t *sdo, *next_sdo;
-    unsigned int i;
-    ec_pdo_t *pdo, *next_pdo;
-
     // abort all pending requests
 
     while (!list_empty(&slave->sdo_requests)) {
@@ -182,6 +241,7 @@ void ec_slave_clear(ec_slave_t *slave /**< EtherCAT slave */)
         EC_SLAVE_WARN(slave, "Discarding SDO request,"
                 " slave about to be deleted.\n");
         request->state = EC_INT_REQUEST_FAILURE;
+        ec_sdo_request_notify(request);
     }
 
     while (!list_empty(&slave->reg_requests)) {
@@ -191,6 +251,16 @@ void ec_slave_clear(ec_slave_t *slave /**< EtherCAT slave */)
         EC_SLAVE_WARN(slave, "Discarding register request,"
                 " slave about to be deleted.\n");
         reg->state = EC_INT_REQUEST_FAILURE;
+        ec_reg_request_notify(reg);
+    }
+
+    while (!list_empty(&slave->sii_requests)) {
+        ec_sii_write_request_t *request = list_entry(
+                slave->sii_requests.next, ec_sii_write_request_t, list);
+        list_del_init(&request->list); // dequeue
+        EC_SLAVE_WARN(slave, "Discarding SII request,"
+                " slave about to be deleted.\n");
+        request->state = EC_INT_REQUEST_FAILURE;
     }
 
     while (!list_empty(&slave->foe_requests)) {
@@ -200,6 +270,7 @@ void ec_slave_clear(ec_slave_t *slave /**< EtherCAT slave */)
         EC_SLAVE_WARN(slave, "Discarding FoE request,"
                 " slave about to be deleted.\n");
         request->state = EC_INT_REQUEST_FAILURE;
+        ec_foe_request_notify(request);
     }
 
     while (!list_empty(&slave->soe_requests)) {
@@ -211,40 +282,46 @@ void ec_slave_clear(ec_slave_t *slave /**< EtherCAT slave */)
         request->state = EC_INT_REQUEST_FAILURE;
     }
 
+    while (!list_empty(&slave->dict_requests)) {
+        ec_sdo_entries_request_t *request = list_entry(
+                slave->dict_requests.next, ec_sdo_entries_request_t, list);
+        list_del_init(&request->list); // dequeue
+        EC_SLAVE_WARN(slave, "Discarding SDO entry description request,"
+                " slave about to be deleted.\n");
+        request->state = EC_INT_REQUEST_FAILURE;
+    }
+
     wake_up_all(&slave->master->request_queue);
 
     if (slave->config) {
         ec_slave_config_detach(slave->config);
     }
 
-    // free all SDOs
-    list_for_each_entry_safe(sdo, next_sdo, &slave->sdo_dictionary, list) {
-        list_del(&sdo->list);
-        ec_sdo_clear(sdo);
-        kfree(sdo);
-    }
-
-    // free all strings
-    if (slave->sii.strings) {
-        for (i = 0; i < slave->sii.string_count; i++)
-            kfree(slave->sii.strings[i]);
-        kfree(slave->sii.strings);
+    // release the SDO dictionary
+    if (slave->dict) {
+        if (slave->dict->reader == slave) {
+            // incomplete, do not share
+            slave->dict->reader = NULL;
+            list_del_init(&slave->dict->list);
+        }
+        ec_dict_release(slave->dict);
+        slave->dict = NULL;
     }
 
     // free all sync managers
     ec_slave_clear_sync_managers(slave);
 
-    // free all SII PDOs
-    list_for_each_entry_safe(pdo, next_pdo, &slave->sii.pdos, list) {
-        list_del(&pdo->list);
-        ec_pdo_clear(pdo);
-        kfree(pdo);
-    }
+    // release strings and PDO descriptions
+    ec_slave_clear_sii_data(slave);
 
     if (slave->sii_words) {
         kfree(slave->sii_words);
     }
 
+    if (slave->mbox_stash) {
+        kfree(slave->mbox_stash);
+    }
+
     ec_fsm_slave_clear(&slave->fsm);
 }
 
@@ -263,6 +340,29 @@ void ec_slave_clear_sync_managers(ec_slave_t *slave /**< EtherCAT slave. */)
         kfree(slave->sii.syncs);
         slave->sii.syncs = NULL;
     }
+    slave->sii.sync_count = 0;
+    slave->sii.pdos_loaded = 0;
+}
+
+/*****************************************************************************/
+
+/** Releases the slave's SII category data.
+ *
+ * The general category fields point to the strings of the category data, so
+ * they are reset, too.
+ */
+void ec_slave_clear_sii_data(ec_slave_t *slave /**< EtherCAT slave. */)
+{
+    if (slave->sii.data) {
+        ec_sii_data_release(slave->sii.data);
+        slave->sii.data = NULL;
+    }
+
+    slave->sii.has_general = 0;
+    slave->sii.group = NULL;
+    slave->sii.image = NULL;
+    slave->sii.order = NULL;
+    slave->sii.name = NULL;
 }
 
 /*****************************************************************************/
@@ -284,6 +384,14 @@ void ec_slave_set_state(ec_slave_t *slave, /**< EtherCAT slave */
             EC_SLAVE_DBG(slave, 0, "%s -> %s.\n", old_state, cur_state);
         }
         slave->current_state = new_state;
+
+        if (new_state != EC_SLAVE_STATE_PREOP
+                && new_state != EC_SLAVE_STATE_SAFEOP
+                && new_state != EC_SLAVE_STATE_OP) {
+            // the applied configuration may be lost
+            slave->config_applied = 0;
+            slave->mbox_status_mapped = 0;
+        }
     }
 }
 
@@ -315,15 +423,16 @@ int ec_slave_fetch_sii_strings(
         size_t data_size /**< number of bytes */
         )
 {
+    ec_sii_data_t *sii_data = slave->sii.data;
     int i, err;
     size_t size;
     off_t offset;
 
-    slave->sii.string_count = data[0];
+    sii_data->string_count = data[0];
 
-    if (slave->sii.string_count) {
-        if (!(slave->sii.strings =
-                    kmalloc(sizeof(char *) * slave->sii.string_count,
+    if (sii_data->string_count) {
+        if (!(sii_data->strings =
+                    kmalloc(sizeof(char *) * sii_data->string_count,
                         GFP_KERNEL))) {
             EC_SLAVE_ERR(slave, "Failed to allocate string array memory.\n");
             err = -ENOMEM;
@@ -331,17 +440,17 @@ int ec_slave_fetch_sii_strings(
         }
 
         offset = 1;
-        for (i = 0; i < slave->sii.string_count; i++) {
+        for (i = 0; i < sii_data->string_count; i++) {
             size = data[offset];
             // allocate memory for string structure and data at a single blow
-            if (!(slave->sii.strings[i] =
+            if (!(sii_data->strings[i] =
                         kmalloc(sizeof(char) * size + 1, GFP_KERNEL))) {
                 EC_SLAVE_ERR(slave, "Failed to allocate string memory.\n");
                 err = -ENOMEM;
                 goto out_free;
             }
-            memcpy(slave->sii.strings[i], data + offset + 1, size);
-            slave->sii.strings[i][size] = 0x00; // append binary zero
+            memcpy(sii_data->strings[i], data + offset + 1, size);
+            sii_data->strings[i][size] = 0x00; // append binary zero
             offset += 1 + size;
         }
     }
@@ -350,11 +459,11 @@ int ec_slave_fetch_sii_strings(
 
 out_free:
     for (i--; i >= 0; i--)
-        kfree(slave->sii.strings[i]);
-    kfree(slave->sii.strings);
-    slave->sii.strings = NULL;
+        kfree(sii_data->strings[i]);
+    kfree(sii_data->strings);
+    sii_data->strings = NULL;
 out_zero:
-    slave->sii.string_count = 0;
+    sii_data->string_count = 0;
     return err;
 }
 
@@ -412,7 +521,9 @@ int ec_slave_fetch_sii_general(
 
 /** Fetches data from a SYNC MANAGER category.
  *
- * Appends the sync managers described in the category to the existing ones.
+ * Appends the sync managers described in the category to the existing ones
+ * of the category data. The slave's own sync managers are initialized from
+ * them by ec_slave_init_sii_syncs().
  *
  * \return 0 in case of success, else < 0
  */
@@ -423,6 +534,7 @@ int ec_slave_fetch_sii_syncs(
         )
 {
     unsigned int i, count, total_count;
+    ec_sii_data_t *sii_data = slave->sii.data;
     ec_sync_t *sync;
     size_t memsize;
     ec_sync_t *syncs;
@@ -438,7 +550,7 @@ int ec_slave_fetch_sii_syncs(
     count = data_size / 8;
 
     if (count) {
-        total_count = count + slave->sii.sync_count;
+        total_count = count + sii_data->sync_count;
         if (total_count > EC_MAX_SYNC_MANAGERS) {
             EC_SLAVE_ERR(slave, "Exceeded maximum number of"
                     " sync managers!\n");
@@ -451,25 +563,25 @@ int ec_slave_fetch_sii_syncs(
             return -ENOMEM;
         }
 
-        for (i = 0; i < slave->sii.sync_count; i++)
-            ec_sync_init_copy(syncs + i, slave->sii.syncs + i);
+        for (i = 0; i < sii_data->sync_count; i++)
+            ec_sync_init_copy(syncs + i, sii_data->syncs + i);
 
         // initialize new sync managers
         for (i = 0; i < count; i++, data += 8) {
-            index = i + slave->sii.sync_count;
+            index = i + sii_data->sync_count;
             sync = &syncs[index];
 
-            ec_sync_init(sync, slave);
+            ec_sync_init(sync, NULL);
             sync->physical_start_address = EC_READ_U16(data);
             sync->default_length = EC_READ_U16(data + 2);
             sync->control_register = EC_READ_U8(data + 4);
             sync->enable = EC_READ_U8(data + 6);
         }
 
-        if (slave->sii.syncs)
-            kfree(slave->sii.syncs);
-        slave->sii.syncs = syncs;
-        slave->sii.sync_count = total_count;
+        if (sii_data->syncs)
+            kfree(sii_data->syncs);
+        sii_data->syncs = syncs;
+        sii_data->sync_count = total_count;
     }
 
     return 0;
@@ -489,6 +601,7 @@ int ec_slave_fetch_sii_pdos(
         ec_direction_t dir /**< PDO direction. */
         )
 {
+    ec_sii_data_t *sii_data = slave->sii.data;
     int ret;
     ec_pdo_t *pdo;
     ec_pdo_entry_t *entry;
@@ -511,7 +624,7 @@ int ec_slave_fetch_sii_pdos(
             kfree(pdo);
             return ret;
         }
-        list_add_tail(&pdo->list, &slave->sii.pdos);
+        list_add_tail(&pdo->list, &sii_data->pdos);
 
         data_size -= 8;
         data += 8;
@@ -541,15 +654,14 @@ int ec_slave_fetch_sii_pdos(
 
         // if sync manager index is positive, the PDO is mapped by default
         if (pdo->sync_index >= 0) {
-            ec_sync_t *sync;
-
-            if (!(sync = ec_slave_get_sync(slave, pdo->sync_index))) {
+            if (pdo->sync_index >= sii_data->sync_count) {
                 EC_SLAVE_ERR(slave, "Invalid SM index %i for PDO 0x%04X.",
                         pdo->sync_index, pdo->index);
                 return -ENOENT;
             }
 
-            ret = ec_pdo_list_add_pdo_copy(&sync->pdos, pdo);
+            ret = ec_pdo_list_add_pdo_copy(
+                    &sii_data->syncs[pdo->sync_index].pdos, pdo);
             if (ret)
                 return ret;
         }
@@ -560,6 +672,143 @@ int ec_slave_fetch_sii_pdos(
 
 /*****************************************************************************/
 
+/** Initializes the slave's sync managers from the SII category data.
+ *
+ * The sync managers carry the current PDO assignment, that may differ from
+ * the default assignment, so every slave needs its own copies.
+ *
+ * \return 0 in case of success, else < 0
+ */
+int ec_slave_init_sii_syncs(
+        ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    const ec_sii_data_t *sii_data = slave->sii.data;
+    unsigned int i;
+
+    ec_slave_clear_sync_managers(slave);
+
+    if (!sii_data || !sii_data->sync_count) {
+        return 0;
+    }
+
+    if (!(slave->sii.syncs = kmalloc(sizeof(ec_sync_t) *
+                    sii_data->sync_count, GFP_KERNEL))) {
+        EC_SLAVE_ERR(slave, "Failed to allocate memory for sync managers.\n");
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < sii_data->sync_count; i++) {
+        ec_sync_init_copy(&slave->sii.syncs[i], &sii_data->syncs[i]);
+        slave->sii.syncs[i].slave = slave;
+    }
+
+    slave->sii.sync_count = sii_data->sync_count;
+    slave->sii.pdos_loaded = sii_data->pdos_parsed;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Parses the [RT]xPDO categories of the slave's SII category data.
+ *
+ * The category words were already checked during the scan.
+ *
+ * \return 0 in case of success, else < 0
+ */
+static int ec_slave_parse_sii_pdos(
+        ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    const ec_sii_data_t *sii_data = slave->sii.data;
+    const uint16_t *cat_word = sii_data->words;
+    const uint16_t *end = sii_data->words + sii_data->nwords;
+    uint16_t cat_type, cat_size;
+    int ret;
+
+    while (cat_word + 2 <= end && EC_READ_U16(cat_word) != 0xFFFF) {
+        cat_type = EC_READ_U16(cat_word) & 0x7FFF;
+        cat_size = EC_READ_U16(cat_word + 1);
+        cat_word += 2;
+
+        if (cat_word + cat_size > end) {
+            break;
+        }
+
+        if (cat_type == 0x0032 || cat_type == 0x0033) {
+            ret = ec_slave_fetch_sii_pdos(slave, (const uint8_t *) cat_word,
+                    cat_size * 2, cat_type == 0x0032 ?
+                    EC_DIR_INPUT : EC_DIR_OUTPUT); // TxPDO / RxPDO
+            if (ret) {
+                return ret;
+            }
+        }
+
+        cat_word += cat_size;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Loads the default PDO assignment from the SII category data.
+ *
+ * The [RT]xPDO categories are not evaluated during the scan, because most
+ * slaves are configured with application-defined PDOs anyway. They are
+ * parsed once per (shared) category data, as soon as a configuration is
+ * attached or the PDOs are queried. Sync managers, whose assignment was
+ * already read from the slave, are left untouched.
+ *
+ * \return 0 in case of success, else < 0
+ */
+int ec_slave_load_sii_pdos(
+        ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    ec_sii_data_t *sii_data = slave->sii.data;
+    ec_sync_t *sync;
+    unsigned int i;
+    int ret;
+
+    if (slave->sii.pdos_loaded || !sii_data) {
+        return 0;
+    }
+
+    if (!sii_data->pdos_parsed) {
+        // never parse twice, the PDOs would be appended again
+        sii_data->pdos_parsed = 1;
+        EC_SLAVE_DBG(slave, 1, "Parsing SII PDO categories.\n");
+        ret = ec_slave_parse_sii_pdos(slave);
+        if (ret) {
+            EC_SLAVE_ERR(slave, "Failed to parse SII PDO categories.\n");
+            return ret;
+        }
+    }
+
+    for (i = 0; i < slave->sii.sync_count && i < sii_data->sync_count;
+            i++) {
+        sync = &slave->sii.syncs[i];
+        if (sync->pdos_cached || !list_empty(&sync->pdos.list)) {
+            continue; // assignment read from the slave
+        }
+
+        ret = ec_pdo_list_copy(&sync->pdos, &sii_data->syncs[i].pdos);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    slave->sii.pdos_loaded = 1;
+
+    if (slave->dict) {
+        ec_slave_attach_pdo_names(slave);
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
 /**
    Searches the string list for an index.
    \return 0 in case of success, else < 0
@@ -573,12 +822,12 @@ char *ec_slave_sii_string(
     if (!index--)
         return NULL;
 
-    if (index >= slave->sii.string_count) {
+    if (!slave->sii.data || index >= slave->sii.data->string_count) {
         EC_SLAVE_DBG(slave, 1, "String %u not found.\n", index);
         return NULL;
     }
 
-    return slave->sii.strings[index];
+    return slave->sii.data->strings[index];
 }
 
 /*****************************************************************************/
@@ -615,7 +864,13 @@ void ec_slave_sdo_dict_info(const ec_slave_t *slave, /**< EtherCAT slave */
     ec_sdo_t *sdo;
     ec_sdo_entry_t *entry;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
+    if (!slave->dict) {
+        *sdo_count = 0;
+        *entry_count = 0;
+        return;
+    }
+
+    list_for_each_entry(sdo, &slave->dict->sdos, list) {
         sdos++;
         list_for_each_entry(entry, &sdo->entries, list) {
             entries++;
@@ -640,7 +895,11 @@ ec_sdo_t *ec_slave_get_sdo(
 {
     ec_sdo_t *sdo;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
+    if (!slave->dict) {
+        return NULL;
+    }
+
+    list_for_each_entry(sdo, &slave->dict->sdos, list) {
         if (sdo->index != index)
             continue;
         return sdo;
@@ -666,7 +925,11 @@ const ec_sdo_t *ec_slave_get_sdo_const(
 {
     const ec_sdo_t *sdo;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
+    if (!slave->dict) {
+        return NULL;
+    }
+
+    list_for_each_entry(sdo, &slave->dict->sdos, list) {
         if (sdo->index != index)
             continue;
         return sdo;
@@ -688,7 +951,11 @@ const ec_sdo_t *ec_slave_get_sdo_by_pos_const(
 {
     const ec_sdo_t *sdo;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
+    if (!slave->dict) {
+        return NULL;
+    }
+
+    list_for_each_entry(sdo, &slave->dict->sdos, list) {
         if (sdo_position--)
             continue;
         return sdo;
@@ -707,18 +974,52 @@ uint16_t ec_slave_sdo_count(
         const ec_slave_t *slave /**< EtherCAT slave. */
         )
 {
+    const ec_dict_t *dict;
     const ec_sdo_t *sdo;
     uint16_t count = 0;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
-        count++;
+    // may be called without the master semaphore, see ec_ioctl_slave()
+    rcu_read_lock();
+    if ((dict = READ_ONCE(slave->dict))) {
+        list_for_each_entry_rcu(sdo, &dict->sdos, list) {
+            count++;
+        }
     }
+    rcu_read_unlock();
 
     return count;
 }
 
 /*****************************************************************************/
 
+/** Checks, if an SDO is mapped to one of the PDOs of the slave.
+ *
+ * \return Non-zero, if the SDO is mapped.
+ */
+int ec_slave_sdo_mapped(
+        const ec_slave_t *slave, /**< Slave. */
+        uint16_t index /**< SDO index. */
+        )
+{
+    unsigned int i;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+
+    for (i = 0; i < slave->sii.sync_count; i++) {
+        list_for_each_entry(pdo, &slave->sii.syncs[i].pdos.list, list) {
+            list_for_each_entry(entry, &pdo->entries, list) {
+                if (entry->index == index) {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** Finds a mapped PDO.
  * \returns The desired PDO object, or NULL.
  */
@@ -745,6 +1046,60 @@ const ec_pdo_t *ec_slave_find_pdo(
 
 /*****************************************************************************/
 
+/** Forgets the cached PDO configuration, that an SDO download may change.
+ *
+ * Downloads to the PDO assignment objects (0x1C10 + sync manager index)
+ * invalidate the respective sync manager, downloads to the PDO mapping
+ * objects invalidate the sync managers the PDO is assigned to.
+ */
+void ec_slave_invalidate_pdo_cache(
+        ec_slave_t *slave, /**< Slave. */
+        uint16_t sdo_index /**< Index of the downloaded SDO. */
+        )
+{
+    unsigned int i;
+    ec_sync_t *sync;
+
+    if (sdo_index >= 0x1C10 && sdo_index < 0x1C10 + EC_MAX_SYNC_MANAGERS) {
+        if ((sync = ec_slave_get_sync(slave, sdo_index - 0x1C10))) {
+            sync->pdos_cached = 0;
+        }
+        return;
+    }
+
+    if ((sdo_index < 0x1600 || sdo_index >= 0x1800)
+            && (sdo_index < 0x1A00 || sdo_index >= 0x1C00)) {
+        return; // no PDO mapping object
+    }
+
+    for (i = 0; i < slave->sii.sync_count; i++) {
+        sync = &slave->sii.syncs[i];
+        if (ec_pdo_list_find_pdo_const(&sync->pdos, sdo_index)) {
+            sync->pdos_cached = 0;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** Forgets the whole cached PDO configuration.
+ *
+ * Used, if the slave may have lost power, so that it runs with its default
+ * PDO configuration again.
+ */
+void ec_slave_clear_pdo_cache(
+        ec_slave_t *slave /**< Slave. */
+        )
+{
+    unsigned int i;
+
+    for (i = 0; i < slave->sii.sync_count; i++) {
+        slave->sii.syncs[i].pdos_cached = 0;
+    }
+}
+
+/*****************************************************************************/
+
 /** Find name for a PDO and its entries.
  */
 void ec_slave_find_names_for_pdo(
@@ -756,7 +1111,11 @@ void ec_slave_find_names_for_pdo(
     ec_pdo_entry_t *pdo_entry;
     const ec_sdo_entry_t *sdo_entry;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list) {
+    if (!slave->dict) {
+        return;
+    }
+
+    list_for_each_entry(sdo, &slave->dict->sdos, list) {
         if (sdo->index == pdo->index) {
             ec_pdo_set_name(pdo, sdo->name);
         } else {
@@ -883,6 +1242,10 @@ uint32_t ec_slave_calc_rtt_sum(
 /*****************************************************************************/
 
 /** Finds the next slave supporting DC delay measurement.
+ *
+ * Returns the first slave with DC support in frame order, starting with the
+ * given slave and ending with the last slave behind it. Uses the topology
+ * calculated by ec_master_calc_topology().
  *
  * \return Next DC slave, or NULL.
  */
@@ -890,34 +1253,43 @@ ec_slave_t *ec_slave_find_next_dc_slave(
         ec_slave_t *slave /**< EtherCAT slave. */
         )
 {
-    unsigned int port_index;
-    ec_slave_t *dc_slave = NULL;
+    ec_slave_t *dc_slave = slave->first_dc_slave;
 
-    if (slave->base_dc_supported) {
-        dc_slave = slave;
+    if (dc_slave && dc_slave < slave->subtree_end) {
+        return dc_slave;
     } else {
-        port_index = ec_slave_get_next_port(slave, 0);
+        return NULL;
+    }
+}
 
-        while (port_index != 0) {
-            ec_slave_t *next = slave->ports[port_index].next_slave;
+/*****************************************************************************/
 
-            if (next) {
-                dc_slave = ec_slave_find_next_dc_slave(next);
+/** Looks up the transmission delay correction of a slave's ESC.
+ *
+ * \return Correction in ns.
+ */
+int32_t ec_slave_dc_delay_correction(
+        const ec_slave_t *slave /**< EtherCAT slave. */
+        )
+{
+    const ec_dc_delay_correction_t *c;
 
-                if (dc_slave) {
-                    break;
-                }
-            }
-            port_index = ec_slave_get_next_port(slave, port_index);
+    for (c = ec_dc_delay_corrections; c->type; c++) {
+        if (c->type == slave->base_type && (c->revision == 0xff
+                    || c->revision == slave->base_revision)) {
+            return c->correction;
         }
     }
 
-    return dc_slave;
+    return 0;
 }
 
 /*****************************************************************************/
 
 /** Calculates the port transmission delays.
+ *
+ * The ESC specific corrections from ec_slave_dc_delay_correction() are
+ * applied to the delay towards the next DC slave.
  */
 void ec_slave_calc_port_delays(
         ec_slave_t *slave /**< EtherCAT slave. */
@@ -925,7 +1297,8 @@ void ec_slave_calc_port_delays(
 {
     unsigned int port_index;
     ec_slave_t *next_slave, *next_dc;
-    uint32_t rtt, next_rtt_sum;
+    uint32_t rtt, next_rtt_sum, delay;
+    int32_t correction;
 
     if (!slave->base_dc_supported)
         return;
@@ -944,10 +1317,21 @@ void ec_slave_calc_port_delays(
                 slave->ports[prev_port].receive_time;
             next_rtt_sum = ec_slave_calc_rtt_sum(next_dc);
 
-            slave->ports[port_index].delay_to_next_dc =
-                (rtt - next_rtt_sum) / 2; // FIXME
-            next_dc->ports[0].delay_to_next_dc =
-                (rtt - next_rtt_sum) / 2;
+            delay = (rtt - next_rtt_sum) / 2;
+            correction = ec_slave_dc_delay_correction(next_dc);
+            if (correction < 0 && delay < (uint32_t) -correction) {
+                correction = -delay;
+            } else if (correction > 0 && delay < (uint32_t) correction) {
+                correction = delay;
+            }
+
+            slave->ports[port_index].delay_to_next_dc = delay + correction;
+            next_dc->ports[0].delay_to_next_dc = delay - correction;
+
+            if (correction) {
+                EC_SLAVE_DBG(next_dc, 1, "Applied delay correction"
+                        " of %i ns.\n", correction);
+            }
 
 #if 0
             EC_SLAVE_DBG(slave, 1, "delay %u:%u rtt=%u"
@@ -963,38 +1347,181 @@ void ec_slave_calc_port_delays(
 
 /*****************************************************************************/
 
-/** Recursively calculates transmission delays.
+/** Calculates the transmission delays of the DC slaves.
+ *
+ * Walks the DC slaves behind the reference clock in frame order and sums up
+ * the port delays on the way. Instead of recursing, the walk returns to the
+ * previous DC slave via the port 0 connections, so the stack usage does not
+ * depend on the bus size.
  */
-void ec_slave_calc_transmission_delays_rec(
-        ec_slave_t *slave, /**< Current slave. */
-        uint32_t *delay /**< Sum of delays. */
+void ec_slave_calc_transmission_delays(
+        ec_slave_t *ref /**< DC reference clock. */
         )
 {
+    ec_slave_t *slave = ref, *next_dc, *child;
+    uint32_t delay = 0;
     unsigned int i;
-    ec_slave_t *next_dc;
 
-    EC_SLAVE_DBG(slave, 1, "%s(delay = %u ns)\n", __func__, *delay);
+    slave->transmission_delay = delay;
+    EC_SLAVE_DBG(slave, 1, "%s(delay = %u ns)\n", __func__, delay);
+    i = ec_slave_get_next_port(slave, 0);
 
-    slave->transmission_delay = *delay;
+    while (1) {
+        next_dc = NULL;
 
-    i = ec_slave_get_next_port(slave, 0);
+        while (i != 0) {
+            next_dc = ec_slave_find_next_dc_slave(
+                    slave->ports[i].next_slave);
+            if (next_dc) {
+                break;
+            }
+            i = ec_slave_get_next_port(slave, i);
+        }
 
-    while (i != 0) {
-        ec_slave_port_t *port = &slave->ports[i];
-        next_dc = ec_slave_find_next_dc_slave(port->next_slave);
         if (next_dc) {
-            *delay = *delay + port->delay_to_next_dc;
-#if 0
-            EC_SLAVE_DBG(slave, 1, "%u:%u %u\n",
-                    slave->ring_position, i, *delay);
-#endif
-            ec_slave_calc_transmission_delays_rec(next_dc, delay);
+            // descend to the next DC slave
+            delay += slave->ports[i].delay_to_next_dc;
+            slave = next_dc;
+            slave->transmission_delay = delay;
+            EC_SLAVE_DBG(slave, 1, "%s(delay = %u ns)\n", __func__, delay);
+            i = ec_slave_get_next_port(slave, 0);
+            continue;
+        }
+
+        // all ports done, return to the previous DC slave
+        delay += slave->ports[0].delay_to_next_dc;
+        if (slave == ref) {
+            break;
         }
 
+        child = slave;
+        do {
+            child = child->ports[0].next_slave;
+        } while (!child->base_dc_supported);
+
+        // continue behind the port leading to the subtree of the slave
+        i = ec_slave_get_next_port(child, 0);
+        while (i != 0) {
+            ec_slave_t *next = child->ports[i].next_slave;
+            if (slave >= next && slave < next->subtree_end) {
+                break;
+            }
+            i = ec_slave_get_next_port(child, i);
+        }
+        slave = child;
         i = ec_slave_get_next_port(slave, i);
     }
+}
+
+/*****************************************************************************/
+
+/** Returns the increment of an error counter.
+ *
+ * The counters are cleared by writing to them, so a value less than the
+ * last one is a fresh count.
+ *
+ * \return Counter increment.
+ */
+static unsigned int ec_slave_error_increment(
+        uint8_t last, /**< Last counter value. */
+        uint8_t value /**< Current counter value. */
+        )
+{
+    return value >= last ? value - last : value;
+}
+
+/*****************************************************************************/
+
+/** Evaluates a sample of the error counter registers.
+ *
+ * The per-port increments are accumulated, beginning with the second
+ * sample.
+ */
+void ec_slave_update_error_counters(
+        ec_slave_t *slave, /**< EtherCAT slave. */
+        const uint8_t *data /**< Contents of the registers 0x0300 to
+                              0x0313. */
+        )
+{
+    unsigned long now = jiffies;
+    unsigned int i;
+
+    for (i = 0; i < EC_MAX_PORTS; i++) {
+        ec_slave_port_errors_t *errors = &slave->ports[i].errors;
+        uint8_t invalid_frames = EC_READ_U8(data + 2 * i),
+                rx_errors = EC_READ_U8(data + 2 * i + 1),
+                forwarded_rx_errors = EC_READ_U8(data + 0x08 + i),
+                lost_links = EC_READ_U8(data + 0x10 + i);
+
+        if (slave->error_samples) {
+            errors->delta =
+                ec_slave_error_increment(errors->invalid_frames,
+                        invalid_frames)
+                + ec_slave_error_increment(errors->rx_errors, rx_errors)
+                + ec_slave_error_increment(errors->forwarded_rx_errors,
+                        forwarded_rx_errors)
+                + ec_slave_error_increment(errors->lost_links, lost_links);
+            errors->total += errors->delta;
+        }
+
+        errors->invalid_frames = invalid_frames;
+        errors->rx_errors = rx_errors;
+        errors->forwarded_rx_errors = forwarded_rx_errors;
+        errors->lost_links = lost_links;
+    }
 
-    *delay = *delay + slave->ports[0].delay_to_next_dc;
+    slave->processing_unit_errors = EC_READ_U8(data + 0x0C);
+    slave->pdi_errors = EC_READ_U8(data + 0x0D);
+
+    if (slave->error_samples) {
+        slave->error_interval = jiffies_to_msecs(now - slave->error_jiffies);
+    }
+    slave->error_jiffies = now;
+    slave->error_samples++;
+}
+
+/*****************************************************************************/
+
+/** Evaluates a sample of the DC system time difference register.
+ *
+ * The drift is the change of the difference per second, low-pass filtered
+ * over the last few samples.
+ */
+void ec_slave_update_dc_time_diff(
+        ec_slave_t *slave, /**< EtherCAT slave. */
+        uint32_t value /**< Contents of the register 0x092C. */
+        )
+{
+    unsigned long now = jiffies;
+    uint32_t abs_diff = value & 0x7fffffff;
+    int32_t diff = value & 0x80000000 ? -(int32_t) abs_diff : abs_diff;
+    unsigned int interval;
+
+    if (slave->dc_diff_samples
+            && (interval = jiffies_to_msecs(now - slave->dc_diff_jiffies))) {
+        s64 change = (s64) diff - slave->dc_diff;
+        u64 rate = (change < 0 ? -change : change) * 1000;
+        int32_t drift;
+
+        do_div(rate, interval);
+        drift = rate > INT_MAX ? INT_MAX : rate;
+        if (change < 0) {
+            drift = -drift;
+        }
+
+        if (slave->dc_diff_samples == 1) {
+            slave->dc_drift = drift;
+        } else {
+            slave->dc_drift += drift / 4 - slave->dc_drift / 4;
+        }
+    }
+
+    slave->dc_diff = diff;
+    if (abs_diff > slave->dc_diff_max) {
+        slave->dc_diff_max = abs_diff;
+    }
+    slave->dc_diff_jiffies = now;
+    slave->dc_diff_samples++;
 }
 
 /*****************************************************************************/
@@ -45,6 +45,8 @@
 #include "pdo.h"
 #include "sync.h"
 #include "sdo.h"
+#include "dict.h"
+#include "sii_data.h"
 #include "fsm_slave.h"
 
 /*****************************************************************************/
@@ -113,11 +115,29 @@
 
 /*****************************************************************************/
 
+/** Error counters of a slave port.
+ *
+ * Sampled from the registers 0x0300 to 0x0313 by the error counter monitor
+ * of the master state machine.
+ */
+typedef struct {
+    uint8_t invalid_frames; /**< Invalid frame counter. */
+    uint8_t rx_errors; /**< RX error counter. */
+    uint8_t forwarded_rx_errors; /**< Forwarded RX error counter. */
+    uint8_t lost_links; /**< Lost link counter. */
+    uint32_t total; /**< Sum of the counter increments since the first
+                      sample. */
+    uint32_t delta; /**< Counter increments in the last sample interval. */
+} ec_slave_port_errors_t;
+
+/*****************************************************************************/
+
 /** Slave port.
  */
 typedef struct {
     ec_slave_port_desc_t desc; /**< Port descriptors. */
     ec_slave_port_link_t link; /**< Port link status. */
+    ec_slave_port_errors_t errors; /**< Error counters. */
     ec_slave_t *next_slave; /**< Connected slaves. */
     uint32_t receive_time; /**< Port receive times for delay
                                             measurement. */
@@ -146,9 +166,9 @@ typedef struct {
     uint16_t std_tx_mailbox_size; /**< Standard transmit mailbox size. */
     uint16_t mailbox_protocols; /**< Supported mailbox protocols. */
 
-    // Strings
-    char **strings; /**< Strings in SII categories. */
-    unsigned int string_count; /**< Number of SII strings. */
+    // Strings, sync manager and PDO descriptions
+    ec_sii_data_t *data; /**< Category data, possibly shared with other
+                           slaves with the same SII contents, or NULL. */
 
     // General
     unsigned int has_general; /**< General category present. */
@@ -162,11 +182,11 @@ typedef struct {
     int16_t current_on_ebus; /**< Power consumption in mA. */
 
     // SyncM
-    ec_sync_t *syncs; /**< SYNC MANAGER categories. */
+    ec_sync_t *syncs; /**< Sync managers with the current PDO assignment,
+                        initialized from the category data. */
     unsigned int sync_count; /**< Number of sync managers. */
-
-    // [RT]XPDO
-    struct list_head pdos; /**< SII [RT]XPDO categories. */
+    unsigned int pdos_loaded; /**< The default PDO assignment was loaded
+                                into \a syncs, see ec_slave_load_sii_pdos(). */
 } ec_sii_t;
 
 /*****************************************************************************/
@@ -205,6 +225,51 @@ struct ec_slave
     uint8_t base_revision; /**< Revision. */
     uint16_t base_build; /**< Build number. */
     uint8_t base_fmmu_count; /**< Number of supported FMMUs. */
+    uint8_t al_status_mapped; /**< The AL status is mapped to the AL status
+                                area (see EC_AL_STATUS_LOGICAL_BASE). */
+    uint8_t group_op; /**< The slave is configured and waits in SAFEOP for
+                        the master to request OP for all slaves at once. */
+    uint8_t config_applied; /**< The configuration with the fingerprint
+                              \a config_fingerprint was applied, and the
+                              slave did not leave PREOP, SAFEOP or OP
+                              since. */
+    uint32_t config_fingerprint; /**< Fingerprint of the applied
+                                   configuration (see
+                                   ec_slave_config_fingerprint()). */
+    uint8_t mbox_status_mapped; /**< The send mailbox status is mapped to the
+                                  mailbox status area (see
+                                  EC_MBOX_STATUS_LOGICAL_BASE). */
+    uint8_t mbox_status_sync; /**< Mailbox data were sent or fetched, so the
+                                mailbox status area has to be read again
+                                before it can be used. */
+    unsigned int mbox_status_seq; /**< Sequence number of the last mailbox
+                                    status area read, that was prepared
+                                    before the last mailbox access. */
+    uint8_t mbox_data_mapped; /**< The send mailbox is mapped to the mailbox
+                                data area (see EC_MBOX_DATA_LOGICAL_BASE). */
+    uint8_t mbox_data_active; /**< The slave is configured, so the master
+                                reads its send mailbox via the mailbox data
+                                area instead of the slave FSM. */
+    uint32_t mbox_data_offset; /**< Offset of the send mailbox in the mailbox
+                                 data area: The sum of the send mailbox sizes
+                                 of all slaves before in the ring. */
+    uint8_t *mbox_stash; /**< Response read via the mailbox data area, that
+                           was not fetched yet, or NULL. */
+    size_t mbox_stash_size; /**< Size of \a mbox_stash. */
+    uint8_t mbox_stash_valid; /**< \a mbox_stash contains a response. */
+    u64 mbox_sent_time; /**< Time of the last mailbox request in ns. */
+    u32 mbox_response_time; /**< Smoothed time in ns from a mailbox request
+                              until its response could be fetched. */
+    u64 mbox_poll_next; /**< Mailbox checks before this time (in ns) are
+                          answered with an empty mailbox without a bus
+                          round trip, or zero. */
+    u32 mbox_poll_interval; /**< Current mailbox check interval in ns. It is
+                              doubled with every empty mailbox. */
+    uint8_t mbox_repeat_toggle; /**< Current state of the repeat request bit
+                                  of the send mailbox sync manager. */
+    uint8_t mbox_repeat_requested; /**< The repetition of the response to
+                                     the last mailbox request was already
+                                     requested. */
     uint8_t base_sync_count; /**< Number of supported sync managers. */
     uint8_t base_fmmu_bit_operation; /**< FMMU bit operation is supported. */
     uint8_t base_dc_supported; /**< Distributed clocks are supported. */
@@ -212,24 +277,53 @@ struct ec_slave
     uint8_t has_dc_system_time; /**< The slave supports the DC system time
                                   register. Otherwise it can only be used for
                                   delay measurement. */
+    unsigned int error_samples; /**< Number of error counter samples. */
+    unsigned long error_jiffies; /**< Time of the last error counter
+                                   sample. */
+    unsigned int error_interval; /**< Time between the last two error
+                                   counter samples [ms]. */
+    uint8_t processing_unit_errors; /**< ECAT processing unit error
+                                      counter. */
+    uint8_t pdi_errors; /**< PDI error counter. */
+    unsigned int dc_diff_samples; /**< Number of DC system time difference
+                                    samples. */
+    unsigned long dc_diff_jiffies; /**< Time of the last DC system time
+                                     difference sample. */
+    int32_t dc_diff; /**< Last DC system time difference [ns]. Positive, if
+                       the local clock is ahead of the reference clock. */
+    uint32_t dc_diff_max; /**< Maximum absolute DC system time difference
+                            since the first sample [ns]. */
+    int32_t dc_drift; /**< Filtered change of the DC system time difference
+                        [ns/s]. */
     uint32_t transmission_delay; /**< DC system time transmission delay
                                    (offset from reference clock). */
+    ec_slave_t *subtree_end; /**< Slave following the last slave connected
+                               behind the ports 1 to 3. Slaves are numbered
+                               in frame order, so the slaves in between form
+                               the subtree of this one. */
+    ec_slave_t *first_dc_slave; /**< First slave with DC support at or after
+                                  this one in the slave list, or NULL. */
 
     // SII
     uint16_t *sii_words; /**< Complete SII image. */
     size_t sii_nwords; /**< Size of the SII contents in words. */
+    uint8_t sii_read_size; /**< Number of bytes the slave delivers per SII
+                             read (4 or 8, 0 if unknown). */
 
     // Slave information interface
     ec_sii_t sii; /**< Extracted SII data. */
 
-    struct list_head sdo_dictionary; /**< SDO dictionary list */
+    ec_dict_t *dict; /**< SDO dictionary, possibly shared with other slaves
+                       of the same type, or NULL. */
     uint8_t sdo_dictionary_fetched; /**< Dictionary has been fetched. */
     unsigned long jiffies_preop; /**< Time, the slave went to PREOP. */
 
     struct list_head sdo_requests; /**< SDO access requests. */
     struct list_head reg_requests; /**< Register access requests. */
+    struct list_head sii_requests; /**< SII write requests. */
     struct list_head foe_requests; /**< FoE write requests. */
     struct list_head soe_requests; /**< SoE write requests. */
+    struct list_head dict_requests; /**< SDO entry description requests. */
 
     ec_fsm_slave_t fsm; /**< Slave state machine. */
 };
@@ -242,6 +336,7 @@ void ec_slave_init(ec_slave_t *, ec_master_t *, ec_device_index_t,
 void ec_slave_clear(ec_slave_t *);
 
 void ec_slave_clear_sync_managers(ec_slave_t *);
+void ec_slave_clear_sii_data(ec_slave_t *);
 
 void ec_slave_request_state(ec_slave_t *, ec_slave_state_t);
 void ec_slave_set_state(ec_slave_t *, ec_slave_state_t);
@@ -252,6 +347,8 @@ int ec_slave_fetch_sii_general(ec_slave_t *, const uint8_t *, size_t);
 int ec_slave_fetch_sii_syncs(ec_slave_t *, const uint8_t *, size_t);
 int ec_slave_fetch_sii_pdos(ec_slave_t *, const uint8_t *, size_t,
         ec_direction_t);
+int ec_slave_init_sii_syncs(ec_slave_t *);
+int ec_slave_load_sii_pdos(ec_slave_t *);
 
 // misc.
 ec_sync_t *ec_slave_get_sync(ec_slave_t *, uint8_t);
@@ -262,11 +359,18 @@ ec_sdo_t *ec_slave_get_sdo(ec_slave_t *, uint16_t);
 const ec_sdo_t *ec_slave_get_sdo_const(const ec_slave_t *, uint16_t);
 const ec_sdo_t *ec_slave_get_sdo_by_pos_const(const ec_slave_t *, uint16_t);
 uint16_t ec_slave_sdo_count(const ec_slave_t *);
+int ec_slave_sdo_mapped(const ec_slave_t *, uint16_t);
 const ec_pdo_t *ec_slave_find_pdo(const ec_slave_t *, uint16_t);
+void ec_slave_invalidate_pdo_cache(ec_slave_t *, uint16_t);
+void ec_slave_clear_pdo_cache(ec_slave_t *);
 void ec_slave_attach_pdo_names(ec_slave_t *);
 
+int32_t ec_slave_dc_delay_correction(const ec_slave_t *);
 void ec_slave_calc_port_delays(ec_slave_t *);
-void ec_slave_calc_transmission_delays_rec(ec_slave_t *, uint32_t *);
+void ec_slave_calc_transmission_delays(ec_slave_t *);
+
+void ec_slave_update_error_counters(ec_slave_t *, const uint8_t *);
+void ec_slave_update_dc_time_diff(ec_slave_t *, uint32_t);
 
 /*****************************************************************************/
 
@@ -38,6 +38,7 @@
 
 #include <linux/module.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
 
 #include "globals.h"
 #include "master.h"
@@ -64,6 +65,7 @@ void ec_slave_config_init(
     unsigned int i;
 
     sc->master = master;
+    sc->owner = NULL;
 
     sc->alias = alias;
     sc->position = position;
@@ -76,6 +78,8 @@ void ec_slave_config_init(
 
     for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++)
         ec_sync_config_init(&sc->sync_configs[i]);
+    sc->entry_index = NULL;
+    sc->entry_index_mask = 0;
 
     sc->used_fmmus = 0;
     sc->dc_assign_activate = 0x0000;
@@ -91,6 +95,8 @@ void ec_slave_config_init(
     INIT_LIST_HEAD(&sc->soe_configs);
 
     ec_coe_emerg_ring_init(&sc->emerg_ring, sc);
+
+    sc->kicked = 0;
 }
 
 /*****************************************************************************/
@@ -110,6 +116,7 @@ void ec_slave_config_clear(
     ec_soe_request_t *soe, *next_soe;
 
     ec_slave_config_detach(sc);
+    ec_slave_config_invalidate_entry_index(sc);
 
     // Free sync managers
     for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++)
@@ -181,7 +188,7 @@ int ec_slave_config_prepare_fmmu(
     for (i = 0; i < sc->used_fmmus; i++) {
         fmmu = &sc->fmmu_configs[i];
         if (fmmu->domain == domain && fmmu->sync_index == sync_index)
-            return fmmu->logical_start_address;
+            return fmmu->data_offset;
     }
 
     if (sc->used_fmmus == EC_MAX_FMMUS) {
@@ -195,7 +202,113 @@ int ec_slave_config_prepare_fmmu(
     ec_fmmu_config_init(fmmu, sc, domain, sync_index, dir);
     up(&sc->master->master_sem);
 
-    return fmmu->logical_start_address;
+    return fmmu->data_offset;
+}
+
+/*****************************************************************************/
+
+/** Adds data to a fingerprint (FNV-1a).
+ *
+ * \return Updated fingerprint.
+ */
+static uint32_t ec_slave_config_hash(
+        uint32_t hash, /**< Fingerprint so far. */
+        const void *data, /**< Data to add. */
+        size_t size /**< Size of \a data in bytes. */
+        )
+{
+    const uint8_t *byte = data;
+
+    while (size--) {
+        hash = (hash ^ *byte++) * 16777619U;
+    }
+
+    return hash;
+}
+
+/** Adds an integer value to a fingerprint.
+ */
+#define EC_CONFIG_HASH_VALUE(HASH, VALUE) \
+    do { \
+        uint32_t value = (VALUE); \
+        HASH = ec_slave_config_hash(HASH, &value, sizeof(value)); \
+    } while (0)
+
+/*****************************************************************************/
+
+/** Calculates a fingerprint of everything, that the slave configuration
+ * state machine applies to a slave.
+ *
+ * Slaves, that are still configured with a configuration of the same
+ * fingerprint, do not have to be configured again.
+ *
+ * \return Fingerprint.
+ */
+uint32_t ec_slave_config_fingerprint(
+        const ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    uint32_t hash = 2166136261U;
+    const ec_sync_config_t *sync;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    const ec_fmmu_config_t *fmmu;
+    const ec_sdo_request_t *req;
+    const ec_soe_request_t *soe;
+    unsigned int i;
+
+    EC_CONFIG_HASH_VALUE(hash, sc->vendor_id);
+    EC_CONFIG_HASH_VALUE(hash, sc->product_code);
+    EC_CONFIG_HASH_VALUE(hash, sc->watchdog_divider);
+    EC_CONFIG_HASH_VALUE(hash, sc->watchdog_intervals);
+
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        sync = &sc->sync_configs[i];
+        EC_CONFIG_HASH_VALUE(hash, sync->dir);
+        EC_CONFIG_HASH_VALUE(hash, sync->watchdog_mode);
+        list_for_each_entry(pdo, &sync->pdos.list, list) {
+            EC_CONFIG_HASH_VALUE(hash, pdo->index);
+            list_for_each_entry(entry, &pdo->entries, list) {
+                EC_CONFIG_HASH_VALUE(hash, entry->index);
+                EC_CONFIG_HASH_VALUE(hash, entry->subindex);
+                EC_CONFIG_HASH_VALUE(hash, entry->bit_length);
+            }
+        }
+    }
+
+    EC_CONFIG_HASH_VALUE(hash, sc->used_fmmus);
+    for (i = 0; i < sc->used_fmmus; i++) {
+        fmmu = &sc->fmmu_configs[i];
+        EC_CONFIG_HASH_VALUE(hash, fmmu->sync_index);
+        EC_CONFIG_HASH_VALUE(hash, fmmu->register_address);
+        EC_CONFIG_HASH_VALUE(hash, fmmu->dir);
+        EC_CONFIG_HASH_VALUE(hash, fmmu->logical_start_address);
+        EC_CONFIG_HASH_VALUE(hash, fmmu->data_size);
+    }
+
+    EC_CONFIG_HASH_VALUE(hash, sc->dc_assign_activate);
+    for (i = 0; i < EC_SYNC_SIGNAL_COUNT; i++) {
+        EC_CONFIG_HASH_VALUE(hash, sc->dc_sync[i].cycle_time);
+        EC_CONFIG_HASH_VALUE(hash, sc->dc_sync[i].shift_time);
+    }
+
+    list_for_each_entry(req, &sc->sdo_configs, list) {
+        EC_CONFIG_HASH_VALUE(hash, req->index);
+        EC_CONFIG_HASH_VALUE(hash, req->subindex);
+        EC_CONFIG_HASH_VALUE(hash, req->complete_access);
+        EC_CONFIG_HASH_VALUE(hash, req->data_size);
+        hash = ec_slave_config_hash(hash, req->data, req->data_size);
+    }
+
+    list_for_each_entry(soe, &sc->soe_configs, list) {
+        EC_CONFIG_HASH_VALUE(hash, soe->drive_no);
+        EC_CONFIG_HASH_VALUE(hash, soe->idn);
+        EC_CONFIG_HASH_VALUE(hash, soe->al_state);
+        EC_CONFIG_HASH_VALUE(hash, soe->data_size);
+        hash = ec_slave_config_hash(hash, soe->data, soe->data_size);
+    }
+
+    return hash;
 }
 
 /*****************************************************************************/
@@ -255,6 +368,15 @@ int ec_slave_config_attach(
     slave->config = sc;
     sc->slave = slave;
 
+    // the default PDO assignment is the base of the PDO configuration
+    if (ec_slave_load_sii_pdos(slave)) {
+        EC_CONFIG_WARN(sc, "Failed to load the default PDO assignment"
+                " of slave %u.\n", slave->ring_position);
+    }
+
+    // serve the internal requests issued in the meantime
+    ec_master_kick_slave_fsm(sc->master, slave);
+
     EC_CONFIG_DBG(sc, 1, "Attached slave %u.\n", slave->ring_position);
     return 0;
 }
@@ -268,10 +390,19 @@ void ec_slave_config_detach(
         )
 {
     if (sc->slave) {
+        ec_sdo_request_t *req;
         ec_reg_request_t *reg;
 
         sc->slave->config = NULL;
 
+        // invalidate processing SDO request
+        list_for_each_entry(req, &sc->sdo_requests, list) {
+            if (sc->slave->fsm.sdo_request == req) {
+                sc->slave->fsm.sdo_request = NULL;
+                break;
+            }
+        }
+
         // invalidate processing register request
         list_for_each_entry(reg, &sc->reg_requests, list) {
             if (sc->slave->fsm.reg_request == reg) {
@@ -286,6 +417,23 @@ void ec_slave_config_detach(
 
 /*****************************************************************************/
 
+/** Notifies the master of a new internal request of the configuration.
+ *
+ * This may be called from realtime context, so the configuration is only
+ * put into the master's lock-free list. The master thread then schedules the
+ * FSM of the attached slave, see ec_master_exec_slave_fsms().
+ */
+void ec_slave_config_kick(
+        ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    if (!test_and_set_bit(0, &sc->kicked)) {
+        llist_add(&sc->kick_node, &sc->master->config_kick_list);
+    }
+}
+
+/*****************************************************************************/
+
 /** Loads the default PDO assignment from the slave object.
  */
 void ec_slave_config_load_default_sync_config(ec_slave_config_t *sc)
@@ -307,6 +455,155 @@ void ec_slave_config_load_default_sync_config(ec_slave_config_t *sc)
             ec_pdo_list_copy(&sync_config->pdos, &sync->pdos);
         }
     }
+
+    ec_slave_config_invalidate_entry_index(sc);
+}
+
+/*****************************************************************************/
+
+/** Invalidates the PDO entry index.
+ *
+ * This has to be called whenever the PDO assignment or mapping of the
+ * configuration changes.
+ */
+void ec_slave_config_invalidate_entry_index(
+        ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    kfree(sc->entry_index);
+    sc->entry_index = NULL;
+    sc->entry_index_mask = 0;
+}
+
+/*****************************************************************************/
+
+/** Builds the PDO entry index.
+ *
+ * The index maps every mapped PDO entry to the sync manager and bit offset
+ * of its first occurrence, so that registering an entry does not have to
+ * walk the PDO lists. It is built on the first registration after the PDO
+ * configuration changed. The caller must hold master_sem.
+ *
+ * \return Zero on success, otherwise a negative error code.
+ */
+static int ec_slave_config_index_entries(
+        ec_slave_config_t *sc /**< Slave configuration. */
+        )
+{
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    ec_slave_config_entry_slot_t *slot;
+    unsigned int sync_index, count = 0, size = 16, mask, bit_offset;
+
+    for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++) {
+        list_for_each_entry(pdo, &sc->sync_configs[sync_index].pdos.list,
+                list) {
+            list_for_each_entry(entry, &pdo->entries, list) {
+                count++;
+            }
+        }
+    }
+
+    while (size < 2 * count) {
+        size *= 2;
+    }
+    mask = size - 1;
+
+    sc->entry_index = kzalloc(size * sizeof(*slot), GFP_KERNEL);
+    if (!sc->entry_index) {
+        return -ENOMEM;
+    }
+    sc->entry_index_mask = mask;
+
+    for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++) {
+        bit_offset = 0;
+
+        list_for_each_entry(pdo, &sc->sync_configs[sync_index].pdos.list,
+                list) {
+            list_for_each_entry(entry, &pdo->entries, list) {
+                uint32_t key = (entry->index << 8 | entry->subindex) + 1;
+
+                // linear probing; the first occurrence is kept
+                slot = &sc->entry_index[hash_32(key, 32) & mask];
+                while (slot->key && slot->key != key) {
+                    slot = &sc->entry_index[
+                        (slot - sc->entry_index + 1) & mask];
+                }
+                if (!slot->key) {
+                    slot->key = key;
+                    slot->bit_offset = bit_offset;
+                    slot->sync_index = sync_index;
+                }
+
+                bit_offset += entry->bit_length;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** Locates a mapped PDO entry.
+ *
+ * Uses the PDO entry index, which is built if necessary. If that fails, the
+ * PDO lists are searched.
+ *
+ * \return Zero on success, or -ENOENT if the entry is not mapped.
+ */
+static int ec_slave_config_find_entry(
+        ec_slave_config_t *sc, /**< Slave configuration. */
+        uint16_t index, /**< PDO entry index. */
+        uint8_t subindex, /**< PDO entry subindex. */
+        uint8_t *sync_index, /**< Sync manager index. */
+        unsigned int *bit_offset /**< Bit offset in the sync manager. */
+        )
+{
+    uint32_t key = (index << 8 | subindex) + 1;
+    const ec_slave_config_entry_slot_t *slot;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    unsigned int i;
+    int ret = -ENOENT;
+
+    down(&sc->master->master_sem);
+
+    if (sc->entry_index || !ec_slave_config_index_entries(sc)) {
+        for (i = hash_32(key, 32) & sc->entry_index_mask; ;
+                i = (i + 1) & sc->entry_index_mask) {
+            slot = &sc->entry_index[i];
+            if (slot->key == key) {
+                *sync_index = slot->sync_index;
+                *bit_offset = slot->bit_offset;
+                ret = 0;
+                break;
+            }
+            if (!slot->key) {
+                break;
+            }
+        }
+        up(&sc->master->master_sem);
+        return ret;
+    }
+
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++) {
+        *bit_offset = 0;
+
+        list_for_each_entry(pdo, &sc->sync_configs[i].pdos.list, list) {
+            list_for_each_entry(entry, &pdo->entries, list) {
+                if (entry->index == index && entry->subindex == subindex) {
+                    *sync_index = i;
+                    up(&sc->master->master_sem);
+                    return 0;
+                }
+                *bit_offset += entry->bit_length;
+            }
+        }
+    }
+
+    up(&sc->master->master_sem);
+    return ret;
 }
 
 /*****************************************************************************/
@@ -583,6 +880,7 @@ int ecrt_slave_config_pdo_assign_add(ec_slave_config_t *sc,
     pdo->sync_index = sync_index;
 
     ec_slave_config_load_default_mapping(sc, pdo);
+    ec_slave_config_invalidate_entry_index(sc);
 
     up(&sc->master->master_sem);
     return 0;
@@ -603,6 +901,7 @@ void ecrt_slave_config_pdo_assign_clear(ec_slave_config_t *sc,
 
     down(&sc->master->master_sem);
     ec_pdo_list_clear_pdos(&sc->sync_configs[sync_index].pdos);
+    ec_slave_config_invalidate_entry_index(sc);
     up(&sc->master->master_sem);
 }
 
@@ -632,6 +931,7 @@ int ecrt_slave_config_pdo_mapping_add(ec_slave_config_t *sc,
         down(&sc->master->master_sem);
         entry = ec_pdo_add_entry(pdo, entry_index, entry_subindex,
                 entry_bit_length);
+        ec_slave_config_invalidate_entry_index(sc);
         up(&sc->master->master_sem);
         if (IS_ERR(entry))
             retval = PTR_ERR(entry);
@@ -662,6 +962,7 @@ void ecrt_slave_config_pdo_mapping_clear(ec_slave_config_t *sc,
     if (pdo) {
         down(&sc->master->master_sem);
         ec_pdo_clear_entries(pdo);
+        ec_slave_config_invalidate_entry_index(sc);
         up(&sc->master->master_sem);
     } else {
         EC_CONFIG_WARN(sc, "PDO 0x%04X is not assigned.\n", pdo_index);
@@ -746,48 +1047,35 @@ int ecrt_slave_config_reg_pdo_entry(
         )
 {
     uint8_t sync_index;
-    const ec_sync_config_t *sync_config;
     unsigned int bit_offset, bit_pos;
-    ec_pdo_t *pdo;
-    ec_pdo_entry_t *entry;
     int sync_offset;
 
     EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, index = 0x%04X, "
             "subindex = 0x%02X, domain = 0x%p, bit_position = 0x%p)\n",
             __func__, sc, index, subindex, domain, bit_position);
 
-    for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++) {
-        sync_config = &sc->sync_configs[sync_index];
-        bit_offset = 0;
-
-        list_for_each_entry(pdo, &sync_config->pdos.list, list) {
-            list_for_each_entry(entry, &pdo->entries, list) {
-                if (entry->index != index || entry->subindex != subindex) {
-                    bit_offset += entry->bit_length;
-                } else {
-                    bit_pos = bit_offset % 8;
-                    if (bit_position) {
-                        *bit_position = bit_pos;
-                    } else if (bit_pos) {
-                        EC_CONFIG_ERR(sc, "PDO entry 0x%04X:%02X does"
-                                " not byte-align.\n", index, subindex);
-                        return -EFAULT;
-                    }
-
-                    sync_offset = ec_slave_config_prepare_fmmu(
-                            sc, domain, sync_index, sync_config->dir);
-                    if (sync_offset < 0)
-                        return sync_offset;
+    if (ec_slave_config_find_entry(sc, index, subindex,
+                &sync_index, &bit_offset)) {
+        EC_CONFIG_ERR(sc, "PDO entry 0x%04X:%02X is not mapped.\n",
+                index, subindex);
+        return -ENOENT;
+    }
 
-                    return sync_offset + bit_offset / 8;
-                }
-            }
-        }
+    bit_pos = bit_offset % 8;
+    if (bit_position) {
+        *bit_position = bit_pos;
+    } else if (bit_pos) {
+        EC_CONFIG_ERR(sc, "PDO entry 0x%04X:%02X does"
+                " not byte-align.\n", index, subindex);
+        return -EFAULT;
     }
 
-    EC_CONFIG_ERR(sc, "PDO entry 0x%04X:%02X is not mapped.\n",
-           index, subindex);
-    return -ENOENT;
+    sync_offset = ec_slave_config_prepare_fmmu(sc, domain, sync_index,
+            sc->sync_configs[sync_index].dir);
+    if (sync_offset < 0)
+        return sync_offset;
+
+    return sync_offset + bit_offset / 8;
 }
 
 /*****************************************************************************/
@@ -857,6 +1145,85 @@ int ecrt_slave_config_reg_pdo_entry_pos(
 
 /*****************************************************************************/
 
+int ecrt_slave_config_reg_pdo_array(
+        ec_slave_config_t *sc,
+        uint16_t index,
+        uint8_t subindex,
+        ec_domain_t *domain,
+        ec_pdo_array_t *array
+        )
+{
+    uint8_t sync_index;
+    const ec_sync_config_t *sync_config;
+    unsigned int bit_offset, first = 0, prev = 0, stride = 0, count = 0,
+                 bit_length = 0;
+    ec_pdo_t *pdo;
+    ec_pdo_entry_t *entry;
+    int sync_offset;
+
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, index = 0x%04X, "
+            "subindex = 0x%02X, domain = 0x%p, array = 0x%p)\n",
+            __func__, sc, index, subindex, domain, array);
+
+    for (sync_index = 0; sync_index < EC_MAX_SYNC_MANAGERS; sync_index++) {
+        sync_config = &sc->sync_configs[sync_index];
+        bit_offset = 0;
+
+        list_for_each_entry(pdo, &sync_config->pdos.list, list) {
+            list_for_each_entry(entry, &pdo->entries, list) {
+                if (entry->index != index || entry->subindex != subindex) {
+                    bit_offset += entry->bit_length;
+                    continue;
+                }
+
+                if (bit_offset % 8 || (entry->bit_length != 8
+                            && entry->bit_length != 16
+                            && entry->bit_length != 32)) {
+                    EC_CONFIG_ERR(sc, "PDO entry 0x%04X:%02X is not a"
+                            " byte-aligned 8, 16 or 32 bit sample.\n",
+                            index, subindex);
+                    return -EFAULT;
+                }
+
+                if (!count) {
+                    first = bit_offset;
+                    bit_length = entry->bit_length;
+                } else if (entry->bit_length != bit_length
+                        || (count > 1 && bit_offset - prev != stride)) {
+                    EC_CONFIG_ERR(sc, "Samples of PDO entry 0x%04X:%02X"
+                            " are not equidistant.\n", index, subindex);
+                    return -EINVAL;
+                } else {
+                    stride = bit_offset - prev;
+                }
+
+                prev = bit_offset;
+                count++;
+                bit_offset += entry->bit_length;
+            }
+        }
+
+        if (count) {
+            sync_offset = ec_slave_config_prepare_fmmu(
+                    sc, domain, sync_index, sync_config->dir);
+            if (sync_offset < 0)
+                return sync_offset;
+
+            array->offset = sync_offset + first / 8;
+            array->stride = count > 1 ? stride / 8 : bit_length / 8;
+            array->count = count;
+            array->bit_length = bit_length;
+            return 0;
+        }
+    }
+
+    EC_CONFIG_ERR(sc, "PDO entry 0x%04X:%02X is not mapped.\n",
+           index, subindex);
+    return -ENOENT;
+}
+
+/*****************************************************************************/
+
 void ecrt_slave_config_dc(ec_slave_config_t *sc, uint16_t assign_activate,
         uint32_t sync0_cycle_time, int32_t sync0_shift_time,
         uint32_t sync1_cycle_time, int32_t sync1_shift_time)
@@ -876,6 +1243,57 @@ void ecrt_slave_config_dc(ec_slave_config_t *sc, uint16_t assign_activate,
 
 /*****************************************************************************/
 
+int ecrt_slave_config_reg_fmmu(ec_slave_config_t *sc, ec_domain_t *domain,
+        uint16_t address, size_t size, ec_direction_t dir)
+{
+    unsigned int i;
+    ec_fmmu_config_t *fmmu;
+
+    EC_CONFIG_DBG(sc, 1, "%s(sc = 0x%p, domain = 0x%p, address = 0x%04X,"
+            " size = %zu, dir = %u)\n",
+            __func__, sc, domain, address, size, dir);
+
+    if (!size || size > 0xffff || address + size > 0x10000
+            || (dir != EC_DIR_INPUT && dir != EC_DIR_OUTPUT)) {
+        EC_CONFIG_ERR(sc, "Invalid register mapping 0x%04X/%zu!\n",
+                address, size);
+        return -EINVAL;
+    }
+
+    // registers already mapped?
+    for (i = 0; i < sc->used_fmmus; i++) {
+        fmmu = &sc->fmmu_configs[i];
+        if (fmmu->domain == domain && fmmu->sync_index == EC_FMMU_NO_SYNC
+                && fmmu->register_address == address
+                && fmmu->data_size == size && fmmu->dir == dir) {
+            return fmmu->data_offset;
+        }
+    }
+
+    if (sc->used_fmmus == EC_MAX_FMMUS) {
+        EC_CONFIG_ERR(sc, "FMMU limit reached!\n");
+        return -EOVERFLOW;
+    }
+
+    fmmu = &sc->fmmu_configs[sc->used_fmmus++];
+
+    down(&sc->master->master_sem);
+    ec_fmmu_config_init_registers(fmmu, sc, domain, address, size, dir);
+    up(&sc->master->master_sem);
+
+    return fmmu->data_offset;
+}
+
+/*****************************************************************************/
+
+int ecrt_slave_config_dc_latch(ec_slave_config_t *sc, ec_domain_t *domain)
+{
+    return ecrt_slave_config_reg_fmmu(sc, domain, EC_DC_LATCH_ADDRESS,
+            EC_DC_LATCH_SIZE, EC_DIR_INPUT);
+}
+
+/*****************************************************************************/
+
 int ecrt_slave_config_sdo(ec_slave_config_t *sc, uint16_t index,
         uint8_t subindex, const uint8_t *data, size_t size)
 {
@@ -1061,6 +1479,7 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request_err(
     // prepare data for optional writing
     memset(req->data, 0x00, size);
     req->data_size = size;
+    req->config = sc;
 
     down(&sc->master->master_sem);
     list_add_tail(&req->list, &sc->sdo_requests);
@@ -1104,6 +1523,7 @@ ec_reg_request_t *ecrt_slave_config_create_reg_request_err(
         kfree(reg);
         return ERR_PTR(ret);
     }
+    reg->config = sc;
 
     down(&sc->master->master_sem);
     list_add_tail(&reg->list, &sc->reg_requests);
@@ -1248,7 +1668,10 @@ EXPORT_SYMBOL(ecrt_slave_config_pdo_mapping_add);
 EXPORT_SYMBOL(ecrt_slave_config_pdo_mapping_clear);
 EXPORT_SYMBOL(ecrt_slave_config_pdos);
 EXPORT_SYMBOL(ecrt_slave_config_reg_pdo_entry);
+EXPORT_SYMBOL(ecrt_slave_config_reg_pdo_array);
 EXPORT_SYMBOL(ecrt_slave_config_dc);
+EXPORT_SYMBOL(ecrt_slave_config_reg_fmmu);
+EXPORT_SYMBOL(ecrt_slave_config_dc_latch);
 EXPORT_SYMBOL(ecrt_slave_config_sdo);
 EXPORT_SYMBOL(ecrt_slave_config_sdo8);
 EXPORT_SYMBOL(ecrt_slave_config_sdo16);
@@ -38,6 +38,7 @@
 #define __EC_SLAVE_CONFIG_H__
 
 #include <linux/list.h>
+#include <linux/llist.h>
 
 #include "globals.h"
 #include "slave.h"
@@ -113,11 +114,27 @@
 
 /*****************************************************************************/
 
+/** Slot of the PDO entry index of a slave configuration.
+ */
+typedef struct {
+    uint32_t key; /**< (Index << 8 | subindex) + 1, or zero if the slot is
+                    free. */
+    uint32_t bit_offset; /**< Bit offset of the entry in the sync manager's
+                           process data. */
+    uint8_t sync_index; /**< Index of the sync manager. */
+} ec_slave_config_entry_slot_t;
+
+/*****************************************************************************/
+
 /** EtherCAT slave configuration.
  */
 struct ec_slave_config {
     struct list_head list; /**< List item. */
+    ec_slave_config_t *hash_next; /**< Next configuration in the same bucket
+                                    of the master's hash table. */
     ec_master_t *master; /**< Master owning the slave configuration. */
+    const void *owner; /**< File handle context of the userspace application,
+                         that created the configuration, or NULL. */
 
     uint16_t alias; /**< Slave alias. */
     uint16_t position; /**< Index after alias. If alias is zero, this is the
@@ -135,6 +152,12 @@ struct ec_slave_config {
 
     ec_sync_config_t sync_configs[EC_MAX_SYNC_MANAGERS]; /**< Sync manager
                                                    configurations. */
+    ec_slave_config_entry_slot_t *entry_index; /**< Open addressing table
+                                                 locating the mapped PDO
+                                                 entries, or NULL while
+                                                 invalid. */
+    unsigned int entry_index_mask; /**< Number of slots in \a entry_index
+                                     minus one. */
     ec_fmmu_config_t fmmu_configs[EC_MAX_FMMUS]; /**< FMMU configurations. */
     uint8_t used_fmmus; /**< Number of FMMUs used. */
     uint16_t dc_assign_activate; /**< Vendor-specific AssignActivate word. */
@@ -147,6 +170,10 @@ struct ec_slave_config {
     struct list_head soe_configs; /**< List of SoE configurations. */
 
     ec_coe_emerg_ring_t emerg_ring; /**< CoE emergency ring buffer. */
+
+    struct llist_node kick_node; /**< Item of the master's list of
+                                   configurations with new requests. */
+    unsigned long kicked; /**< Bit 0 is set, while \a kick_node is listed. */
 };
 
 /*****************************************************************************/
@@ -157,8 +184,11 @@ void ec_slave_config_clear(ec_slave_config_t *);
 
 int ec_slave_config_attach(ec_slave_config_t *);
 void ec_slave_config_detach(ec_slave_config_t *);
+void ec_slave_config_kick(ec_slave_config_t *);
 
 void ec_slave_config_load_default_sync_config(ec_slave_config_t *);
+void ec_slave_config_invalidate_entry_index(ec_slave_config_t *);
+uint32_t ec_slave_config_fingerprint(const ec_slave_config_t *);
 
 unsigned int ec_slave_config_sdo_count(const ec_slave_config_t *);
 const ec_sdo_request_t *ec_slave_config_get_sdo_by_pos_const(
@@ -37,6 +37,7 @@
 #include <linux/jiffies.h>
 #include <linux/slab.h>
 
+#include "payload.h"
 #include "soe_request.h"
 
 /*****************************************************************************/
@@ -131,7 +132,7 @@ void ec_soe_request_clear_data(
         )
 {
     if (req->data) {
-        kfree(req->data);
+        ec_payload_free(req->data, req->mem_size);
         req->data = NULL;
     }
 
@@ -157,12 +158,12 @@ int ec_soe_request_alloc(
 
     ec_soe_request_clear_data(req);
 
-    if (!(req->data = (uint8_t *) kmalloc(size, GFP_KERNEL))) {
+    if (!(req->data = ec_payload_alloc(size, &req->mem_size))) {
         EC_ERR("Failed to allocate %zu bytes of SoE memory.\n", size);
+        req->mem_size = 0;
         return -ENOMEM;
     }
 
-    req->mem_size = size;
     req->data_size = 0;
     return 0;
 }
@@ -208,14 +209,19 @@ int ec_soe_request_append_data(
 {
     if (req->data_size + size > req->mem_size) {
         size_t new_size = req->mem_size ? req->mem_size * 2 : size;
-        uint8_t *new_data = (uint8_t *) kmalloc(new_size, GFP_KERNEL);
+        uint8_t *new_data;
+
+        if (new_size < req->data_size + size) {
+            new_size = req->data_size + size;
+        }
+        new_data = ec_payload_alloc(new_size, &new_size);
         if (!new_data) {
             EC_ERR("Failed to allocate %zu bytes of SoE memory.\n",
                     new_size);
             return -ENOMEM;
         }
         memcpy(new_data, req->data, req->data_size);
-        kfree(req->data);
+        ec_payload_free(req->data, req->mem_size);
         req->data = new_data;
         req->mem_size = new_size;
     }
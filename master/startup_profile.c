@@ -0,0 +1,182 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Startup timeline profile.
+*/
+
+/*****************************************************************************/
+
+#include <linux/vmalloc.h>
+
+#include "startup_profile.h"
+
+/*****************************************************************************/
+
+/** Constructor.
+ *
+ * If the event memory can not be allocated, all events are counted as lost.
+ */
+void ec_startup_profile_init(
+        ec_startup_profile_t *profile /**< Startup profile. */
+        )
+{
+    profile->events =
+        vmalloc(EC_STARTUP_PROFILE_SIZE * sizeof(ec_startup_event_t));
+    profile->count = 0;
+    profile->lost = 0;
+    profile->origin = ktime_get();
+}
+
+/*****************************************************************************/
+
+/** Destructor.
+ */
+void ec_startup_profile_clear(
+        ec_startup_profile_t *profile /**< Startup profile. */
+        )
+{
+    if (profile->events) {
+        vfree(profile->events);
+        profile->events = NULL;
+    }
+}
+
+/*****************************************************************************/
+
+/** Discards all events and restarts the timeline.
+ */
+void ec_startup_profile_reset(
+        ec_startup_profile_t *profile /**< Startup profile. */
+        )
+{
+    profile->count = 0;
+    profile->lost = 0;
+    profile->origin = ktime_get();
+}
+
+/*****************************************************************************/
+
+/** Records a phase, that ends now.
+ */
+void ec_startup_profile_record(
+        ec_startup_profile_t *profile, /**< Startup profile. */
+        ec_startup_phase_t phase, /**< Phase. */
+        u16 position, /**< Slave ring position, or EC_STARTUP_MASTER. */
+        ktime_t start, /**< Start of the phase. */
+        unsigned int flags /**< Event flags. */
+        )
+{
+    ec_startup_event_t *event;
+    s64 offset, duration;
+
+    if (!profile->events || profile->count >= EC_STARTUP_PROFILE_SIZE) {
+        profile->lost++;
+        return;
+    }
+
+    // phases started before a reset are cut at the origin
+    offset = ktime_to_ns(ktime_sub(start, profile->origin));
+    if (offset < 0) {
+        start = profile->origin;
+        offset = 0;
+    }
+    duration = ktime_us_delta(ktime_get(), start);
+
+    event = &profile->events[profile->count++];
+    event->start = offset;
+    event->duration = min_t(s64, duration, 0xFFFFFFFF);
+    event->position = position;
+    event->phase = phase;
+    event->flags = flags;
+}
+
+/*****************************************************************************/
+
+/** Constructor.
+ */
+void ec_startup_timer_init(
+        ec_startup_timer_t *timer /**< Phase timer. */
+        )
+{
+    timer->running = 0;
+    timer->phase = EC_STARTUP_BUS_SCAN;
+    timer->position = EC_STARTUP_MASTER;
+    timer->start = ktime_set(0, 0);
+}
+
+/*****************************************************************************/
+
+/** Starts a phase.
+ *
+ * A different running phase is recorded as finished. Starting the running
+ * phase again does nothing, so that all states belonging to a phase can
+ * start it.
+ */
+void ec_startup_timer_start(
+        ec_startup_profile_t *profile, /**< Startup profile. */
+        ec_startup_timer_t *timer, /**< Phase timer. */
+        ec_startup_phase_t phase, /**< Phase to start. */
+        u16 position /**< Slave ring position, or EC_STARTUP_MASTER. */
+        )
+{
+    if (timer->running) {
+        if (timer->phase == phase && timer->position == position) {
+            return;
+        }
+        ec_startup_timer_stop(profile, timer, 0);
+    }
+
+    timer->running = 1;
+    timer->phase = phase;
+    timer->position = position;
+    timer->start = ktime_get();
+}
+
+/*****************************************************************************/
+
+/** Records the running phase, if any, as finished.
+ */
+void ec_startup_timer_stop(
+        ec_startup_profile_t *profile, /**< Startup profile. */
+        ec_startup_timer_t *timer, /**< Phase timer. */
+        unsigned int failed /**< The phase ended with an error. */
+        )
+{
+    if (!timer->running) {
+        return;
+    }
+
+    ec_startup_profile_record(profile, timer->phase, timer->position,
+            timer->start, failed ? EC_STARTUP_FAILED : 0);
+    timer->running = 0;
+}
+
+/*****************************************************************************/
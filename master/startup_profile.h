@@ -0,0 +1,103 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   Startup timeline profile.
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_STARTUP_PROFILE_H__
+#define __EC_STARTUP_PROFILE_H__
+
+#include <linux/types.h>
+#include <linux/ktime.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** Maximum number of events in a startup profile.
+ */
+#define EC_STARTUP_PROFILE_SIZE 4096
+
+/*****************************************************************************/
+
+/** Startup profile event.
+ */
+typedef struct {
+    u64 start; /**< Start in ns since the profile was reset. */
+    u32 duration; /**< Duration in us. */
+    u16 position; /**< Slave ring position, or EC_STARTUP_MASTER. */
+    u8 phase; /**< Phase (see ec_startup_phase_t). */
+    u8 flags; /**< Flags (see EC_STARTUP_FAILED). */
+} ec_startup_event_t;
+
+/** Startup timeline profile.
+ *
+ * Records the durations of the scan, configuration and activation phases
+ * from loading the master module on, so that slow phases and slaves can be
+ * identified. Events are appended until the memory is full. Written and read
+ * with the master semaphore held.
+ */
+typedef struct {
+    ec_startup_event_t *events; /**< Event memory, or NULL. */
+    unsigned int count; /**< Number of recorded events. */
+    unsigned int lost; /**< Events not recorded, because the memory was
+                         full. */
+    ktime_t origin; /**< Time of the last reset. */
+} ec_startup_profile_t;
+
+/** Timer for the phases of a state machine.
+ */
+typedef struct {
+    unsigned int running; /**< A phase is running. */
+    ec_startup_phase_t phase; /**< Running phase. */
+    u16 position; /**< Slave ring position, or EC_STARTUP_MASTER. */
+    ktime_t start; /**< Start of the running phase. */
+} ec_startup_timer_t;
+
+/*****************************************************************************/
+
+void ec_startup_profile_init(ec_startup_profile_t *);
+void ec_startup_profile_clear(ec_startup_profile_t *);
+void ec_startup_profile_reset(ec_startup_profile_t *);
+void ec_startup_profile_record(ec_startup_profile_t *, ec_startup_phase_t,
+        u16, ktime_t, unsigned int);
+
+void ec_startup_timer_init(ec_startup_timer_t *);
+void ec_startup_timer_start(ec_startup_profile_t *, ec_startup_timer_t *,
+        ec_startup_phase_t, u16);
+void ec_startup_timer_stop(ec_startup_profile_t *, ec_startup_timer_t *,
+        unsigned int);
+
+/*****************************************************************************/
+
+#endif
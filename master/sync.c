@@ -54,6 +54,7 @@ void ec_sync_init(
     sync->control_register = 0x00;
     sync->enable = 0x00;
     ec_pdo_list_init(&sync->pdos);
+    sync->pdos_cached = 0;
 }
 
 /*****************************************************************************/
@@ -72,6 +73,7 @@ void ec_sync_init_copy(
    sync->enable = other->enable;
    ec_pdo_list_init(&sync->pdos);
    ec_pdo_list_copy(&sync->pdos, &other->pdos);
+   sync->pdos_cached = 0; // not known for this sync manager
 }
 
 /*****************************************************************************/
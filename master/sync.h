@@ -51,6 +51,10 @@ typedef struct {
     uint8_t control_register; /**< Control register value. */
     uint8_t enable; /**< Enable bit. */
     ec_pdo_list_t pdos; /**< Current PDO assignment. */
+    uint8_t pdos_cached; /**< \a pdos were read from or written to the slave
+                           via CoE, so they reflect its PDO assignment and
+                           mapping. Cleared, as soon as an SDO download may
+                           change them. */
 } ec_sync_t;
 
 /*****************************************************************************/
@@ -0,0 +1,272 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   EtherCAT master tracepoints.
+
+   The events are defined in the "ethercat" trace system and cost nothing,
+   as long as they are not enabled, e. g. via trace-cmd or perf.
+*/
+
+/*****************************************************************************/
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ethercat
+
+#if !defined(__EC_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __EC_TRACE_H__
+
+#include <linux/tracepoint.h>
+
+#include "datagram.h"
+
+/*****************************************************************************/
+
+#define ec_trace_datagram_type(type) \
+    __print_symbolic(type, \
+            { EC_DATAGRAM_NONE, "NONE" }, \
+            { EC_DATAGRAM_APRD, "APRD" }, \
+            { EC_DATAGRAM_APWR, "APWR" }, \
+            { EC_DATAGRAM_APRW, "APRW" }, \
+            { EC_DATAGRAM_FPRD, "FPRD" }, \
+            { EC_DATAGRAM_FPWR, "FPWR" }, \
+            { EC_DATAGRAM_FPRW, "FPRW" }, \
+            { EC_DATAGRAM_BRD, "BRD" }, \
+            { EC_DATAGRAM_BWR, "BWR" }, \
+            { EC_DATAGRAM_BRW, "BRW" }, \
+            { EC_DATAGRAM_LRD, "LRD" }, \
+            { EC_DATAGRAM_LWR, "LWR" }, \
+            { EC_DATAGRAM_LRW, "LRW" }, \
+            { EC_DATAGRAM_ARMW, "ARMW" }, \
+            { EC_DATAGRAM_FRMW, "FRMW" })
+
+/*****************************************************************************/
+
+/** Events, that refer to a datagram of the master.
+ */
+DECLARE_EVENT_CLASS(ec_datagram_class,
+
+    TP_PROTO(unsigned int master_index, unsigned int dev_idx,
+        const ec_datagram_t *datagram),
+
+    TP_ARGS(master_index, dev_idx, datagram),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, master_index)
+        __field(unsigned int, dev_idx)
+        __field(u8, type)
+        __field(u8, index)
+        __field(u16, working_counter)
+        __field(size_t, data_size)
+        __array(char, name, EC_DATAGRAM_NAME_SIZE)
+    ),
+
+    TP_fast_assign(
+        __entry->master_index = master_index;
+        __entry->dev_idx = dev_idx;
+        __entry->type = datagram->type;
+        __entry->index = datagram->index;
+        __entry->working_counter = datagram->working_counter;
+        __entry->data_size = datagram->data_size;
+        memcpy(__entry->name, datagram->name, EC_DATAGRAM_NAME_SIZE);
+        __entry->name[EC_DATAGRAM_NAME_SIZE - 1] = 0;
+    ),
+
+    TP_printk("master=%u dev=%u %s index=0x%02x size=%zu wc=%u name=%s",
+        __entry->master_index, __entry->dev_idx,
+        ec_trace_datagram_type(__entry->type), __entry->index,
+        __entry->data_size, __entry->working_counter, __entry->name)
+);
+
+/** A datagram was queued for sending.
+ */
+DEFINE_EVENT(ec_datagram_class, ec_datagram_queue,
+    TP_PROTO(unsigned int master_index, unsigned int dev_idx,
+        const ec_datagram_t *datagram),
+    TP_ARGS(master_index, dev_idx, datagram)
+);
+
+/** A received datagram was matched to a sent one.
+ */
+DEFINE_EVENT(ec_datagram_class, ec_datagram_receive,
+    TP_PROTO(unsigned int master_index, unsigned int dev_idx,
+        const ec_datagram_t *datagram),
+    TP_ARGS(master_index, dev_idx, datagram)
+);
+
+/** A sent datagram timed out.
+ */
+DEFINE_EVENT(ec_datagram_class, ec_datagram_timeout,
+    TP_PROTO(unsigned int master_index, unsigned int dev_idx,
+        const ec_datagram_t *datagram),
+    TP_ARGS(master_index, dev_idx, datagram)
+);
+
+/*****************************************************************************/
+
+/** A received datagram did not match any sent datagram.
+ */
+TRACE_EVENT(ec_datagram_unmatched,
+
+    TP_PROTO(unsigned int master_index, unsigned int dev_idx, u8 type,
+        u8 index, size_t data_size),
+
+    TP_ARGS(master_index, dev_idx, type, index, data_size),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, master_index)
+        __field(unsigned int, dev_idx)
+        __field(u8, type)
+        __field(u8, index)
+        __field(size_t, data_size)
+    ),
+
+    TP_fast_assign(
+        __entry->master_index = master_index;
+        __entry->dev_idx = dev_idx;
+        __entry->type = type;
+        __entry->index = index;
+        __entry->data_size = data_size;
+    ),
+
+    TP_printk("master=%u dev=%u %s index=0x%02x size=%zu",
+        __entry->master_index, __entry->dev_idx,
+        ec_trace_datagram_type(__entry->type), __entry->index,
+        __entry->data_size)
+);
+
+/*****************************************************************************/
+
+/** A frame was handed to the network driver.
+ */
+TRACE_EVENT(ec_frame_send,
+
+    TP_PROTO(unsigned int master_index, unsigned int dev_idx, size_t size,
+        unsigned int datagram_count),
+
+    TP_ARGS(master_index, dev_idx, size, datagram_count),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, master_index)
+        __field(unsigned int, dev_idx)
+        __field(size_t, size)
+        __field(unsigned int, datagram_count)
+    ),
+
+    TP_fast_assign(
+        __entry->master_index = master_index;
+        __entry->dev_idx = dev_idx;
+        __entry->size = size;
+        __entry->datagram_count = datagram_count;
+    ),
+
+    TP_printk("master=%u dev=%u size=%zu datagrams=%u",
+        __entry->master_index, __entry->dev_idx, __entry->size,
+        __entry->datagram_count)
+);
+
+/*****************************************************************************/
+
+/** The working counter sum of a domain changed.
+ */
+TRACE_EVENT(ec_domain_wc_change,
+
+    TP_PROTO(unsigned int master_index, unsigned int domain_index,
+        u16 working_counter, u16 expected_working_counter),
+
+    TP_ARGS(master_index, domain_index, working_counter,
+        expected_working_counter),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, master_index)
+        __field(unsigned int, domain_index)
+        __field(u16, working_counter)
+        __field(u16, expected_working_counter)
+    ),
+
+    TP_fast_assign(
+        __entry->master_index = master_index;
+        __entry->domain_index = domain_index;
+        __entry->working_counter = working_counter;
+        __entry->expected_working_counter = expected_working_counter;
+    ),
+
+    TP_printk("master=%u domain=%u wc=%u/%u",
+        __entry->master_index, __entry->domain_index,
+        __entry->working_counter, __entry->expected_working_counter)
+);
+
+/*****************************************************************************/
+
+/** A state machine changed its state.
+ *
+ * The states are printed as the names of their state functions. The slave
+ * position is -1 for the master state machine.
+ */
+TRACE_EVENT(ec_fsm_state,
+
+    TP_PROTO(unsigned int master_index, int slave_position,
+        const void *old_state, const void *new_state),
+
+    TP_ARGS(master_index, slave_position, old_state, new_state),
+
+    TP_STRUCT__entry(
+        __field(unsigned int, master_index)
+        __field(int, slave_position)
+        __field(const void *, old_state)
+        __field(const void *, new_state)
+    ),
+
+    TP_fast_assign(
+        __entry->master_index = master_index;
+        __entry->slave_position = slave_position;
+        __entry->old_state = old_state;
+        __entry->new_state = new_state;
+    ),
+
+    TP_printk("master=%u slave=%d %ps -> %ps",
+        __entry->master_index, __entry->slave_position,
+        __entry->old_state, __entry->new_state)
+);
+
+/*****************************************************************************/
+
+#endif // __EC_TRACE_H__
+
+/*****************************************************************************/
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace
+
+#include <trace/define_trace.h>
+
+/*****************************************************************************/
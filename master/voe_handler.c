@@ -38,6 +38,7 @@
 #include "master.h"
 #include "slave_config.h"
 #include "mailbox.h"
+#include "payload.h"
 #include "voe_handler.h"
 
 /** VoE mailbox type.
@@ -86,6 +87,9 @@ int ec_voe_handler_init(
     voe->dir = EC_DIR_INVALID;
     voe->state = ec_voe_handler_state_error;
     voe->request_state = EC_INT_REQUEST_INIT;
+    voe->complete_cb = NULL;
+    voe->cb_data = NULL;
+    voe->eventfd = NULL;
 
     ec_datagram_init(&voe->datagram);
     return ec_datagram_prealloc(&voe->datagram,
@@ -101,6 +105,7 @@ void ec_voe_handler_clear(
         )
 {
     ec_datagram_clear(&voe->datagram);
+    ec_request_eventfd(&voe->eventfd, -1);
 }
 
 /*****************************************************************************/
@@ -120,6 +125,61 @@ size_t ec_voe_handler_mem_size(
         return 0;
 }
 
+/*****************************************************************************/
+
+/** Lets the handler use external memory.
+ *
+ * The current content of the handler's memory is copied, as far as it
+ * fits. \a mem has to be at least \a size bytes large and is not freed by
+ * the handler. It is used to place the data in memory mapped to user space.
+ */
+void ec_voe_handler_external_memory(
+        ec_voe_handler_t *voe, /**< VoE handler. */
+        uint8_t *mem, /**< External memory. */
+        size_t size /**< Size of \a mem, at least the current memory size. */
+        )
+{
+    ec_datagram_t *datagram = &voe->datagram;
+
+    if (datagram->data) {
+        memcpy(mem, datagram->data, min(datagram->mem_size, size));
+        if (datagram->data_origin == EC_ORIG_INTERNAL) {
+            ec_payload_free(datagram->data, datagram->mem_size);
+        }
+    }
+
+    datagram->data = mem;
+    datagram->data_origin = EC_ORIG_EXTERNAL;
+    datagram->mem_size = size;
+}
+
+/*****************************************************************************/
+
+/** Checks, if the slave's mailboxes fit into external handler memory.
+ *
+ * Internal memory is re-allocated by the mailbox functions, but external
+ * memory can not grow.
+ *
+ * \return Non-zero, if the mailboxes fit.
+ */
+static int ec_voe_handler_mbox_fits(
+        const ec_voe_handler_t *voe /**< VoE handler. */
+        )
+{
+    const ec_slave_t *slave = voe->config->slave;
+    const ec_datagram_t *datagram = &voe->datagram;
+
+    if (datagram->data_origin == EC_ORIG_INTERNAL
+            || (slave->configured_rx_mailbox_size <= datagram->mem_size
+                && slave->configured_tx_mailbox_size <= datagram->mem_size)) {
+        return 1;
+    }
+
+    EC_SLAVE_ERR(slave, "Mailboxes do not fit into %zu bytes of"
+            " mapped VoE memory!\n", datagram->mem_size);
+    return 0;
+}
+
 /*****************************************************************************
  * Application interface.
  ****************************************************************************/
@@ -190,6 +250,8 @@ void ecrt_voe_handler_write(ec_voe_handler_t *voe, size_t size)
 
 ec_request_state_t ecrt_voe_handler_execute(ec_voe_handler_t *voe)
 {
+    ec_internal_request_state_t old_state = voe->request_state;
+
     if (voe->config->slave) { // FIXME locking?
         voe->state(voe);
         if (voe->request_state == EC_INT_REQUEST_BUSY) {
@@ -200,9 +262,27 @@ ec_request_state_t ecrt_voe_handler_execute(ec_voe_handler_t *voe)
         voe->request_state = EC_INT_REQUEST_FAILURE;
     }
 
+    if (old_state == EC_INT_REQUEST_BUSY
+            && voe->request_state != EC_INT_REQUEST_BUSY) {
+        // operation completed
+        if (voe->complete_cb) {
+            voe->complete_cb(voe, voe->cb_data);
+        }
+        ec_request_eventfd_signal(voe->eventfd);
+    }
+
     return ec_request_state_translation_table[voe->request_state];
 }
 
+/*****************************************************************************/
+
+void ecrt_voe_handler_callback(ec_voe_handler_t *voe,
+        void (*cb)(ec_voe_handler_t *, void *), void *cb_data)
+{
+    voe->complete_cb = cb;
+    voe->cb_data = cb_data;
+}
+
 /******************************************************************************
  * State functions.
  *****************************************************************************/
@@ -227,6 +307,12 @@ void ec_voe_handler_state_write_start(ec_voe_handler_t *voe)
         return;
     }
 
+    if (!ec_voe_handler_mbox_fits(voe)) {
+        voe->state = ec_voe_handler_state_error;
+        voe->request_state = EC_INT_REQUEST_FAILURE;
+        return;
+    }
+
     data = ec_slave_mbox_prepare_send(slave, &voe->datagram,
             EC_MBOX_TYPE_VOE, EC_VOE_HEADER_SIZE + voe->data_size);
     if (IS_ERR(data)) {
@@ -307,6 +393,12 @@ void ec_voe_handler_state_read_start(ec_voe_handler_t *voe)
         return;
     }
 
+    if (!ec_voe_handler_mbox_fits(voe)) {
+        voe->state = ec_voe_handler_state_error;
+        voe->request_state = EC_INT_REQUEST_FAILURE;
+        return;
+    }
+
     ec_slave_mbox_prepare_check(slave, datagram); // can not fail.
 
     voe->jiffies_start = jiffies;
@@ -447,6 +539,12 @@ void ec_voe_handler_state_read_nosync_start(ec_voe_handler_t *voe)
         return;
     }
 
+    if (!ec_voe_handler_mbox_fits(voe)) {
+        voe->state = ec_voe_handler_state_error;
+        voe->request_state = EC_INT_REQUEST_FAILURE;
+        return;
+    }
+
     ec_slave_mbox_prepare_fetch(slave, datagram); // can not fail.
 
     voe->jiffies_start = jiffies;
@@ -554,6 +652,7 @@ EXPORT_SYMBOL(ecrt_voe_handler_data_size);
 EXPORT_SYMBOL(ecrt_voe_handler_read);
 EXPORT_SYMBOL(ecrt_voe_handler_write);
 EXPORT_SYMBOL(ecrt_voe_handler_execute);
+EXPORT_SYMBOL(ecrt_voe_handler_callback);
 
 /** \endcond */
 
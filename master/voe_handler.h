@@ -60,6 +60,10 @@ struct ec_voe_handler {
     ec_internal_request_state_t request_state; /**< Handler state. */
     unsigned int retries; /**< retries upon datagram timeout */
     unsigned long jiffies_start; /**< Timestamp for timeout calculation. */
+    void (*complete_cb)(ec_voe_handler_t *, void *); /**< Completion
+                                                       callback. */
+    void *cb_data; /**< Data for \a complete_cb. */
+    struct eventfd_ctx *eventfd; /**< Eventfd signalled on completion. */
 };
 
 /*****************************************************************************/
@@ -67,6 +71,7 @@ struct ec_voe_handler {
 int ec_voe_handler_init(ec_voe_handler_t *, ec_slave_config_t *, size_t);
 void ec_voe_handler_clear(ec_voe_handler_t *);
 size_t ec_voe_handler_mem_size(const ec_voe_handler_t *);
+void ec_voe_handler_external_memory(ec_voe_handler_t *, uint8_t *, size_t);
 
 /*****************************************************************************/
 
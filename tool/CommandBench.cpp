@@ -0,0 +1,498 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+#include "CommandBench.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Default number of transfers per slave. */
+#define DEFAULT_COUNT 100
+
+/** Size of the SDO upload buffer. */
+#define UPLOAD_BUFFER_SIZE (64 * 1024)
+
+/** Size of the kernel window for FoE reads. */
+#define FOE_WINDOW_SIZE 0x10000
+
+/*****************************************************************************/
+
+CommandBench::CommandBench():
+    Command("bench", "Measure the latency and throughput of acyclic"
+            " transfers.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandBench::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] sdo <INDEX> <SUBINDEX> [<COUNT>]" << endl
+        << binaryBaseName << " " << getName()
+        << " [OPTIONS] reg <ADDRESS> <SIZE> [<COUNT>]" << endl
+        << binaryBaseName << " " << getName()
+        << " [OPTIONS] foe <FILENAME> [<COUNT>]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "Every selected slave gets <COUNT> (default "
+        << DEFAULT_COUNT << ") requests" << endl
+        << "of the given kind, one after another: SDO uploads, register"
+        << endl
+        << "reads or FoE reads of a whole file. Slaves, that do not" << endl
+        << "support the mailbox protocol, are skipped." << endl
+        << endl
+        << "For every slave, the transfers are first run alone. Then," << endl
+        << "if several slaves are selected, all slaves are run" << endl
+        << "concurrently, to measure the aggregate of the slave state" << endl
+        << "machines working in parallel." << endl
+        << endl
+        << "The output contains the number of transfers and errors, the"
+        << endl
+        << "minimum, the 50%, 90% and 99% percentiles and the maximum"
+        << endl
+        << "of the transfer latencies in microseconds, and the transfers"
+        << endl
+        << "and bytes per second." << endl
+        << endl
+        << "The requests take the same way as the ones of the upload,"
+        << endl
+        << "reg_read and foe_read commands and are subject to the same"
+        << endl
+        << "bandwidth limits of the acyclic traffic, so that the cyclic"
+        << endl
+        << "operation is not disturbed." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  INDEX    is the SDO index." << endl
+        << "  SUBINDEX is the SDO entry subindex." << endl
+        << "  ADDRESS  is the register address." << endl
+        << "  SIZE     is the number of register bytes to read." << endl
+        << "  FILENAME is the name of the file on the slaves." << endl
+        << "  COUNT    is the number of transfers per slave." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master   -m <index>  Master index. Default: 0." << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of"
+        << endl
+        << "                         the 'slaves' command." << endl
+        << "  --verbose  -v          Report the skipped slaves." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandBench::execute(const StringVector &args)
+{
+    SlaveList slaves, selected;
+    SlaveList::const_iterator si;
+    vector<Worker> workers;
+    Result total;
+    unsigned int i;
+    double start;
+    unsigned long long sequentialTransfers = 0;
+    double sequentialDuration = 0.0;
+
+    parseArguments(args);
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    master = &m;
+    slaves = selectedSlaves(m);
+
+    for (si = slaves.begin(); si != slaves.end(); si++) {
+        if ((protocol == Sdo && !(si->mailbox_protocols & EC_MBOX_COE))
+                || (protocol == Foe
+                    && !(si->mailbox_protocols & EC_MBOX_FOE))) {
+            if (getVerbosity() == Verbose) {
+                cerr << "Skipping slave " << si->position
+                    << " without " << (protocol == Sdo ? "CoE" : "FoE")
+                    << "." << endl;
+            }
+            continue;
+        }
+        selected.push_back(*si);
+    }
+
+    if (selected.empty()) {
+        throwCommandException("No slave to benchmark!");
+    }
+
+    workers.resize(selected.size());
+    for (si = selected.begin(), i = 0; si != selected.end(); si++, i++) {
+        workers[i].bench = this;
+        workers[i].result.position = si->position;
+    }
+
+    cout << "Sequential:" << endl;
+    outputHeader();
+    for (i = 0; i < workers.size(); i++) {
+        Result &result = workers[i].result;
+        stringstream label;
+
+        run(result);
+        sequentialTransfers += result.latencies.size();
+        sequentialDuration += result.duration;
+
+        label << result.position;
+        outputResult(label.str(), result);
+    }
+
+    if (workers.size() < 2) {
+        return;
+    }
+
+    start = now();
+    for (i = 0; i < workers.size(); i++) {
+        if (pthread_create(&workers[i].thread, NULL, workerThread,
+                    &workers[i])) {
+            break;
+        }
+    }
+    workers.resize(i); // drop the slaves without a thread
+    for (i = 0; i < workers.size(); i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    total.position = 0;
+    total.errors = 0;
+    total.bytes = 0;
+    total.duration = now() - start;
+
+    cout << endl << "Parallel (" << workers.size() << " slaves):" << endl;
+    outputHeader();
+    for (i = 0; i < workers.size(); i++) {
+        const Result &result = workers[i].result;
+        stringstream label;
+
+        label << result.position;
+        outputResult(label.str(), result);
+
+        total.latencies.insert(total.latencies.end(),
+                result.latencies.begin(), result.latencies.end());
+        total.errors += result.errors;
+        total.bytes += result.bytes;
+    }
+    outputResult("all", total);
+
+    if (sequentialTransfers && sequentialDuration > 0.0
+            && total.duration > 0.0) {
+        cout << endl << "Speed-up of the parallel run: " << fixed
+            << setprecision(2)
+            << (total.latencies.size() / total.duration)
+            / (sequentialTransfers / sequentialDuration) << endl;
+    }
+}
+
+/****************************************************************************/
+
+/** Parses the protocol, its arguments and the transfer count.
+ */
+void CommandBench::parseArguments(const StringVector &args)
+{
+    stringstream err;
+    unsigned int numArgs = 0, value;
+
+    if (args.empty()) {
+        err << "'" << getName() << "' needs a protocol argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args[0] == "sdo") {
+        protocol = Sdo;
+        numArgs = 3;
+    } else if (args[0] == "reg") {
+        protocol = Reg;
+        numArgs = 3;
+    } else if (args[0] == "foe") {
+        protocol = Foe;
+        numArgs = 2;
+    } else {
+        err << "Invalid protocol '" << args[0] << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size() < numArgs || args.size() > numArgs + 1) {
+        err << "Invalid number of arguments for '" << args[0] << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    if (protocol == Foe) {
+        if (args[1].size() >= 32) { // size of the ioctl file name
+            err << "File name '" << args[1] << "' too long!";
+            throwInvalidUsageException(err);
+        }
+        fileName = args[1];
+    } else {
+        stringstream strAddress, strSecond;
+
+        strAddress << args[1];
+        strAddress
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> value;
+        if (strAddress.fail() || value > 0xffff) {
+            err << "Invalid " << (protocol == Sdo ? "SDO index" : "address")
+                << " '" << args[1] << "'!";
+            throwInvalidUsageException(err);
+        }
+        address = value;
+
+        strSecond << args[2];
+        strSecond
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> value;
+        if (protocol == Sdo) {
+            if (strSecond.fail() || value > 0xff) {
+                err << "Invalid SDO subindex '" << args[2] << "'!";
+                throwInvalidUsageException(err);
+            }
+            subIndex = value;
+        } else {
+            if (strSecond.fail() || !value
+                    || (uint32_t) address + value > 0xffff) {
+                err << "Invalid size '" << args[2] << "'!";
+                throwInvalidUsageException(err);
+            }
+            size = value;
+        }
+    }
+
+    count = DEFAULT_COUNT;
+    if (args.size() > numArgs) {
+        stringstream strCount;
+        strCount << args[numArgs];
+        strCount >> count;
+        if (strCount.fail() || !strCount.eof() || !count) {
+            err << "Invalid count '" << args[numArgs] << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+}
+
+/****************************************************************************/
+
+/** Runs the transfers with a slave.
+ */
+void CommandBench::run(Result &result)
+{
+    unsigned int i;
+    double start, end = 0.0;
+
+    result.latencies.clear();
+    result.errors = 0;
+    result.lastError.clear();
+    result.bytes = 0;
+    result.duration = 0.0;
+
+    start = now();
+    for (i = 0; i < count; i++) {
+        size_t bytes = 0;
+        double t = now();
+
+        if (transfer(result.position, bytes, result.lastError)) {
+            end = now();
+            result.latencies.push_back((end - t) * 1e6);
+            result.bytes += bytes;
+        } else {
+            end = now();
+            result.errors++;
+        }
+    }
+    result.duration = end - start;
+}
+
+/****************************************************************************/
+
+/** Executes a single transfer.
+ *
+ * \return true, if the transfer succeeded.
+ */
+bool CommandBench::transfer(
+        uint16_t position,
+        size_t &bytes,
+        string &error
+        )
+{
+    try {
+        if (protocol == Sdo) {
+            ec_ioctl_slave_sdo_upload_t io;
+            vector<uint8_t> target(UPLOAD_BUFFER_SIZE);
+
+            io.slave_position = position;
+            io.sdo_index = address;
+            io.sdo_entry_subindex = subIndex;
+            io.complete_access = 0;
+            io.target_size = target.size();
+            io.target = &target[0];
+            master->sdoUpload(&io);
+            bytes = io.data_size;
+        } else if (protocol == Reg) {
+            ec_ioctl_slave_reg_t io;
+            vector<uint8_t> data(size);
+
+            io.slave_position = position;
+            io.emergency = 0;
+            io.address = address;
+            io.size = size;
+            io.data = &data[0];
+            master->readReg(&io);
+            bytes = size;
+        } else {
+            ec_ioctl_foe_stream_t io;
+            vector<uint8_t> block(FOE_WINDOW_SIZE);
+
+            memset(&io, 0, sizeof(io));
+            io.slave_position = position;
+            io.dir = EC_DIR_INPUT;
+            io.window_size = FOE_WINDOW_SIZE;
+            strncpy(io.file_name, fileName.c_str(),
+                    sizeof(io.file_name) - 1);
+            master->startFoeStream(&io);
+
+            do {
+                io.buffer = &block[0];
+                io.buffer_size = block.size();
+                master->transferFoeStream(&io);
+            } while (io.state == EC_REQUEST_BUSY);
+
+            if (io.state != EC_REQUEST_SUCCESS) {
+                stringstream err;
+                err << "FoE read failed with result " << io.result
+                    << ", error code 0x" << hex << setfill('0')
+                    << setw(8) << io.error_code << ".";
+                error = err.str();
+                return false;
+            }
+            bytes = io.progress;
+        }
+    } catch (MasterDeviceSdoAbortException &e) {
+        stringstream err;
+        err << "SDO transfer aborted with code 0x" << hex << setfill('0')
+            << setw(8) << e.abortCode << ".";
+        error = err.str();
+        return false;
+    } catch (MasterDeviceException &e) {
+        error = e.what();
+        return false;
+    }
+
+    return true;
+}
+
+/****************************************************************************/
+
+/** Thread function of the parallel run.
+ */
+void *CommandBench::workerThread(void *arg)
+{
+    Worker *worker = (Worker *) arg;
+    worker->bench->run(worker->result);
+    return NULL;
+}
+
+/****************************************************************************/
+
+/** Returns the monotonic time in seconds.
+ */
+double CommandBench::now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/****************************************************************************/
+
+void CommandBench::outputHeader()
+{
+    cout << "Slave  Transfers  Errors      Min      50%      90%"
+        << "      99%      Max  Transfers/s      Bytes/s" << endl;
+}
+
+/****************************************************************************/
+
+/** Outputs the statistics of a slave, or of all slaves.
+ */
+void CommandBench::outputResult(const string &label, const Result &result)
+{
+    vector<double> latencies(result.latencies);
+    const double percentiles[] = {50.0, 90.0, 99.0};
+    unsigned int i;
+
+    cout << setfill(' ') << dec << setw(5) << label
+        << "  " << setw(9) << latencies.size()
+        << "  " << setw(6) << result.errors
+        << fixed << setprecision(0);
+
+    if (latencies.empty()) {
+        cout << "        -        -        -        -        -";
+    } else {
+        sort(latencies.begin(), latencies.end());
+        cout << "  " << setw(7) << latencies.front();
+        for (i = 0; i < sizeof(percentiles) / sizeof(double); i++) {
+            // nearest rank
+            size_t rank = (size_t) ceil(percentiles[i] / 100.0
+                    * latencies.size());
+            cout << "  " << setw(7) << latencies[max(rank, (size_t) 1) - 1];
+        }
+        cout << "  " << setw(7) << latencies.back();
+    }
+
+    if (result.duration > 0.0) {
+        cout << setprecision(1)
+            << "  " << setw(11) << latencies.size() / result.duration
+            << "  " << setprecision(0)
+            << setw(11) << result.bytes / result.duration;
+    } else {
+        cout << "            -            -";
+    }
+    cout << endl;
+
+    if (!result.lastError.empty() && result.errors) {
+        cerr << "Slave " << label << ": " << result.lastError << endl;
+    }
+}
+
+/*****************************************************************************/
@@ -0,0 +1,92 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#ifndef __COMMANDBENCH_H__
+#define __COMMANDBENCH_H__
+
+#include <pthread.h>
+
+#include "Command.h"
+
+/****************************************************************************/
+
+class CommandBench:
+    public Command
+{
+    public:
+        CommandBench();
+
+        string helpString(const string &) const;
+        void execute(const StringVector &);
+
+    protected:
+        enum Protocol {
+            Sdo,
+            Reg,
+            Foe
+        };
+
+        /** Transfers with a slave. */
+        struct Result {
+            uint16_t position;
+            vector<double> latencies; /**< Latencies of the successful
+                                        transfers in us. */
+            unsigned int errors;
+            string lastError;
+            unsigned long long bytes;
+            double duration; /**< Wall time of all transfers in s. */
+        };
+
+        /** Slave benchmarked by a thread of the parallel run. */
+        struct Worker {
+            CommandBench *bench;
+            pthread_t thread;
+            Result result;
+        };
+
+        MasterDevice *master;
+        Protocol protocol;
+        uint16_t address; /**< SDO index or register address. */
+        uint8_t subIndex;
+        size_t size; /**< Register size. */
+        string fileName;
+        unsigned int count;
+
+        void parseArguments(const StringVector &);
+        void run(Result &);
+        bool transfer(uint16_t, size_t &, string &);
+        static void *workerThread(void *);
+        static double now();
+        static void outputHeader();
+        static void outputResult(const string &, const Result &);
+};
+
+/****************************************************************************/
+
+#endif
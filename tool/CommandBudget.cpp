@@ -0,0 +1,301 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandBudget.h"
+#include "CommandMaster.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Maximum EtherCAT payload of a frame (Ethernet payload minus the EtherCAT
+ * frame header).
+ */
+#define FRAME_PAYLOAD (1500 - EC_FRAME_HEADER_SIZE)
+
+/** Bytes on the wire per frame besides the EtherCAT payload: Preamble and
+ * start of frame delimiter (8), Ethernet header (14), EtherCAT frame header
+ * (2), frame check sequence (4) and inter-frame gap (12).
+ */
+#define FRAME_OVERHEAD 40
+
+/** Minimum EtherCAT payload of a frame (minimum Ethernet payload minus the
+ * EtherCAT frame header).
+ */
+#define FRAME_MIN_PAYLOAD (46 - EC_FRAME_HEADER_SIZE)
+
+/** Size of the DC datagrams, that synchronize the reference clock and the
+ * slave clocks in every cycle.
+ */
+#define DC_DATAGRAM_SIZE 8
+
+/** Assumed forwarding delay of a slave in ns (both directions), if no
+ * delays were measured.
+ */
+#define SLAVE_DELAY 1000
+
+/*****************************************************************************/
+
+CommandBudget::CommandBudget():
+    Command("budget", "Estimate the bus capacity of the configuration.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandBudget::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS] [CYCLE]"
+        << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "From the domains of the active configuration, the DC" << endl
+        << "datagrams and the byte budgets of the acyclic traffic" << endl
+        << "classes, the command calculates the cyclic frames, their"
+        << endl
+        << "wire time at 100 MBit/s and the round trip time, that" << endl
+        << "additionally contains the forwarding and propagation delays"
+        << endl
+        << "of the bus. These are taken from the master's hardware time"
+        << endl
+        << "stamps, from the measured DC transmission delays, or" << endl
+        << "assumed with " << SLAVE_DELAY << " ns per slave, in this order."
+        << endl
+        << endl
+        << "The minimum cycle time is the time until the cyclic and the"
+        << endl
+        << "budgeted acyclic frames of a cycle are back. Acyclic traffic"
+        << endl
+        << "classes without a budget are not included. The headroom is"
+        << endl
+        << "the rest of the cycle. Domains with a cycle divisor are" << endl
+        << "counted in every cycle (worst case)." << endl
+        << endl
+        << "If the application recorded latency statistics (see the" << endl
+        << "'latency' command), the measured round trip times of the"
+        << endl
+        << "domains are shown for comparison." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  CYCLE  Cycle time in ns. Default: The DC cycle time" << endl
+        << "         recorded by the master (see the 'dc' command)." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master -m <index>  Master index. Default: 0." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandBudget::execute(const StringVector &args)
+{
+    ec_ioctl_master_t master;
+    ec_ioctl_slave_t slave;
+    ec_ioctl_dc_stats_t dc_stats;
+    ec_ioctl_latency_stats_t latency_stats;
+    uint32_t cycle_time = 0, cyclic_bytes = 0, acyclic_bytes = 0;
+    uint32_t max_delay = 0, bus_delay, cyclic_time, total_time;
+    unsigned int i, cyclic_frames, total_frames;
+    const char *delay_source;
+    string unbudgeted;
+
+    if (args.size() > 1) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most one argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size() == 1) {
+        stringstream str;
+        str << args[0];
+        str >> cycle_time;
+        if (str.fail() || !cycle_time) {
+            stringstream err;
+            err << "Invalid cycle time '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    m.getMaster(&master);
+
+    if (!cycle_time) {
+        m.getDcStats(&dc_stats);
+        cycle_time = dc_stats.cycle_time;
+    }
+    if (!cycle_time) {
+        stringstream err;
+        err << "No cycle time recorded by the master, please specify one!";
+        throwCommandException(err);
+    }
+
+    for (i = 0; i < master.slave_count; i++) {
+        m.getSlave(&slave, i);
+        if (slave.transmission_delay > max_delay) {
+            max_delay = slave.transmission_delay;
+        }
+    }
+
+    cout << "Cycle time:       " << cycle_time << " ns" << endl
+        << "Slaves:           " << master.slave_count << endl
+        << "Cyclic datagrams:" << endl;
+
+    for (i = 0; i < master.domain_count; i++) {
+        ec_ioctl_domain_t domain;
+
+        m.getDomain(&domain, i);
+        cout << "  Domain " << setw(3) << i << ": " << setw(4)
+            << domain.datagram_count << " datagrams, " << setw(6)
+            << domain.datagram_bytes << " bytes";
+        if (domain.cycle_divisor > 1) {
+            cout << " (every " << domain.cycle_divisor << " cycles)";
+        }
+        cout << endl;
+        cyclic_bytes += domain.datagram_bytes + domain.datagram_count
+            * (EC_DATAGRAM_HEADER_SIZE + EC_DATAGRAM_FOOTER_SIZE);
+    }
+
+    if (master.ref_clock != 0xffff) {
+        cout << "  DC:         " << setw(4) << 2 << " datagrams, " << setw(6)
+            << 2 * DC_DATAGRAM_SIZE << " bytes" << endl;
+        cyclic_bytes += 2 * (DC_DATAGRAM_SIZE + EC_DATAGRAM_HEADER_SIZE
+                + EC_DATAGRAM_FOOTER_SIZE);
+    }
+
+    for (i = 0; i < EC_TC_COUNT; i++) {
+        if (i == EC_TC_CYCLIC || i == EC_TC_DC) {
+            continue;
+        }
+        if (master.traffic_classes[i].budget) {
+            acyclic_bytes += master.traffic_classes[i].budget;
+        } else {
+            if (!unbudgeted.empty()) {
+                unbudgeted += ", ";
+            }
+            unbudgeted += CommandMaster::trafficClassName(i);
+        }
+    }
+
+    if (master.bus_delay) {
+        bus_delay = master.bus_delay;
+        delay_source = "measured";
+    } else if (max_delay) {
+        bus_delay = 2 * max_delay;
+        delay_source = "from DC transmission delays";
+    } else {
+        bus_delay = master.slave_count * SLAVE_DELAY;
+        delay_source = "assumed";
+    }
+
+    cyclic_frames = frameCount(cyclic_bytes);
+    cyclic_time = wireTime(cyclic_bytes, cyclic_frames);
+    total_frames = frameCount(cyclic_bytes + acyclic_bytes);
+    total_time = wireTime(cyclic_bytes + acyclic_bytes, total_frames);
+
+    cout << "Cyclic frames:    " << cyclic_frames << " (" << cyclic_bytes
+        << " bytes)" << endl
+        << "Cyclic wire time: " << cyclic_time << " ns" << endl
+        << "Bus delay:        " << bus_delay << " ns (" << delay_source
+        << ")" << endl
+        << "Round trip time:  " << cyclic_time + bus_delay << " ns" << endl
+        << "Acyclic budget:   " << acyclic_bytes << " bytes";
+    if (!unbudgeted.empty()) {
+        cout << " (unlimited: " << unbudgeted << ")";
+    }
+    cout << endl
+        << "Total frames:     " << total_frames << endl
+        << "Minimum cycle:    " << total_time + bus_delay << " ns" << endl
+        << "Headroom:         "
+        << (int64_t) cycle_time - total_time - bus_delay << " ns ("
+        << fixed << setprecision(1)
+        << 100.0 * ((int64_t) cycle_time - total_time - bus_delay)
+        / cycle_time << " %)" << endl;
+
+    m.getLatencyStats(&latency_stats);
+    if (!latency_stats.send.count) {
+        return;
+    }
+
+    cout << "Measured round trip times:" << endl;
+    for (i = 0; i < master.domain_count; i++) {
+        ec_ioctl_domain_latency_stats_t data;
+
+        m.getDomainLatencyStats(&data, i);
+        if (!data.round_trip.count) {
+            continue;
+        }
+        cout << "  Domain " << setw(3) << i << ": mean "
+            << data.round_trip.sum / data.round_trip.count << " ns, max "
+            << data.round_trip.max << " ns";
+        if (data.round_trip.max > cycle_time) {
+            cout << " (exceeds the cycle time)";
+        }
+        cout << endl;
+    }
+}
+
+/****************************************************************************/
+
+/** Calculates the number of frames needed for the given EtherCAT payload.
+ *
+ * Assumes, that the datagrams fill the frames completely, so this is a
+ * lower bound.
+ */
+unsigned int CommandBudget::frameCount(uint32_t bytes)
+{
+    return (bytes + FRAME_PAYLOAD - 1) / FRAME_PAYLOAD;
+}
+
+/****************************************************************************/
+
+/** Calculates the wire time of frames at 100 MBit/s.
+ *
+ * \return Time in ns.
+ */
+uint32_t CommandBudget::wireTime(uint32_t bytes, unsigned int frames)
+{
+    if (frames == 1 && bytes < FRAME_MIN_PAYLOAD) {
+        bytes = FRAME_MIN_PAYLOAD;
+    }
+
+    return (bytes + frames * FRAME_OVERHEAD) * EC_BYTE_TRANSMISSION_TIME_NS;
+}
+
+/*****************************************************************************/
@@ -32,6 +32,7 @@
 #include <iostream>
 #include <iomanip>
 #include <string.h>
+#include <ctype.h>
 using namespace std;
 
 #include "CommandCStruct.h"
@@ -51,6 +52,7 @@ string CommandCStruct::helpString(const string &binaryBaseName) const
     stringstream str;
 
     str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << binaryBaseName << " " << getName() << " [OPTIONS] layout" << endl
         << endl
         << getBriefDescription() << endl
         << endl
@@ -58,10 +60,33 @@ string CommandCStruct::helpString(const string &binaryBaseName) const
         << "ecrt_slave_config_pdos() function of the application" << endl
         << "interface." << endl
         << endl
+        << "With the 'layout' argument, a header with the process data"
+        << endl
+        << "layout of the configured domains is generated instead. For"
+        << endl
+        << "every mapped PDO entry, it defines the byte offset and bit"
+        << endl
+        << "position in the domain (as #define and, for C++11, as"
+        << endl
+        << "constexpr), and for every slave configuration and sync"
+        << endl
+        << "manager a packed struct overlaying its process data. The"
+        << endl
+        << "offsets are compile-time constants instead of the results"
+        << endl
+        << "of ecrt_domain_reg_pdo_entry_list(), so the header is only"
+        << endl
+        << "valid for an unchanged configuration. The overlays assume a"
+        << endl
+        << "little-endian host." << endl
+        << endl
         << "Command-specific options:" << endl
         << "  --alias    -a <alias>" << endl
         << "  --position -p <pos>    Slave selection. See the help of" << endl
         << "                         the 'slaves' command." << endl
+        << "  --domain   -d <index>  Domain selection for 'layout'. If"
+        << endl
+        << "                         omitted, all domains are used." << endl
         << endl
         << numericInfo();
 
@@ -76,18 +101,27 @@ void CommandCStruct::execute(const StringVector &args)
     SlaveList slaves;
     SlaveList::const_iterator si;
 
-    if (args.size()) {
+    if (args.size() > 1 || (args.size() == 1 && args[0] != "layout")) {
         stringstream err;
-        err << "'" << getName() << "' takes no arguments!";
+        err << "'" << getName()
+            << "' takes either no or 'layout' argument!";
         throwInvalidUsageException(err);
     }
 
+    if (args.size() == 1) {
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::Read);
+        generateDomainLayout(m);
+        return;
+    }
+
     masterIndices = getMasterIndices();
     MasterIndexList::const_iterator mi;
     for (mi = masterIndices.begin();
             mi != masterIndices.end(); mi++) {
         MasterDevice m(*mi);
         m.open(MasterDevice::Read);
+        m.loadSlaveSnapshot();
         slaves = selectedSlaves(m);
 
         for (si = slaves.begin(); si != slaves.end(); si++) {
@@ -207,3 +241,253 @@ void CommandCStruct::generateSlaveCStruct(
 }
 
 /*****************************************************************************/
+
+void CommandCStruct::generateDomainLayout(MasterDevice &m)
+{
+    ec_ioctl_master_t master;
+    DomainList domains;
+    DomainList::const_iterator di;
+    ec_ioctl_domain_fmmu_t fmmu;
+    LayoutEntryList entries;
+    LayoutEntryList::const_iterator ei;
+    stringstream defines, constants, structs;
+    unsigned int i, bitPos, gap;
+
+    m.getMaster(&master);
+    domains = selectedDomains(m, master);
+
+    if (master.phase != 2) {
+        stringstream err;
+        err << "Master " << m.getIndex() << " is not in operation."
+            << " The layout requires an activated configuration.";
+        throwCommandException(err);
+    }
+
+    for (di = domains.begin(); di != domains.end(); di++) {
+        stringstream domainId;
+
+        domainId << "domain" << dec << di->index;
+
+        defines << "/* Domain " << di->index << ": " << di->data_size
+            << " byte at logical address 0x" << hex << setfill('0')
+            << setw(8) << di->logical_base_address << " */" << endl
+            << "#define " << upper(domainId.str()) << "_SIZE "
+            << dec << di->data_size << endl
+            << endl;
+
+        constants << "namespace " << domainId.str() << " {" << endl
+            << "constexpr unsigned int size = " << di->data_size << ";"
+            << endl;
+
+        for (i = 0; i < di->fmmu_count; i++) {
+            stringstream regionId;
+            string prefix;
+
+            m.getFmmu(&fmmu, di->index, i);
+            loadLayoutEntries(m, fmmu, entries);
+
+            regionId << domainId.str() << "_sc" << fmmu.slave_config_alias
+                << "_" << fmmu.slave_config_position
+                << "_sm" << (unsigned int) fmmu.sync_index;
+            prefix = upper(regionId.str());
+
+            defines << "/* Slave config " << fmmu.slave_config_alias
+                << ":" << fmmu.slave_config_position
+                << ", sync manager " << (unsigned int) fmmu.sync_index
+                << " (" << (fmmu.dir == EC_DIR_OUTPUT ? "outputs" : "inputs")
+                << ") */" << endl
+                << "#define " << prefix << "_OFFSET "
+                << fmmu.data_offset << endl
+                << "#define " << prefix << "_SIZE "
+                << fmmu.data_size << endl;
+
+            constants << "namespace " << regionId.str().substr(
+                    domainId.str().size() + 1) << " {" << endl
+                << "constexpr unsigned int offset = " << fmmu.data_offset
+                << ";" << endl
+                << "constexpr unsigned int size = " << fmmu.data_size << ";"
+                << endl;
+
+            structs << "struct " << regionId.str() << " {" << endl;
+
+            bitPos = 0;
+            gap = 0;
+            for (ei = entries.begin(); ei != entries.end(); ei++) {
+                string id = layoutEntryId(*ei);
+                unsigned int bits = ei->bitLength;
+                unsigned int byteOffset =
+                    fmmu.data_offset + ei->bitPos / 8;
+
+                if (!ei->index) { // gap
+                    if (bitPos % 8 == 0 && bits % 8 == 0) {
+                        structs << "    uint8_t gap" << gap++ << "["
+                            << bits / 8 << "];" << endl;
+                    } else {
+                        while (bits) {
+                            unsigned int n = bits > 32 ? 32 : bits;
+                            structs << "    uint32_t : " << n << ";"
+                                << endl;
+                            bits -= n;
+                        }
+                    }
+                    bitPos += ei->bitLength;
+                    continue;
+                }
+
+                defines << "#define " << prefix << "_" << upper(id)
+                    << "_OFFSET " << byteOffset << endl
+                    << "#define " << prefix << "_" << upper(id)
+                    << "_BIT " << ei->bitPos % 8 << endl;
+
+                constants << "constexpr unsigned int " << id
+                    << "_offset = " << byteOffset << ";" << endl
+                    << "constexpr unsigned int " << id
+                    << "_bit = " << ei->bitPos % 8 << ";" << endl;
+
+                structs << "    ";
+                if (bitPos % 8 == 0 && (bits == 8 || bits == 16
+                            || bits == 32 || bits == 64)) {
+                    structs << "uint" << bits << "_t " << id << ";";
+                } else {
+                    structs << (bits > 32 ? "uint64_t " : "uint32_t ")
+                        << id << " : " << bits << ";";
+                }
+                structs << " /* 0x" << hex << setfill('0') << setw(4)
+                    << ei->index << ":" << setw(2)
+                    << (unsigned int) ei->subindex << dec;
+                if (!ei->name.empty()) {
+                    structs << " " << ei->name;
+                }
+                structs << " */" << endl;
+
+                bitPos += ei->bitLength;
+            }
+
+            structs << "} __attribute__ ((packed));" << endl
+                << "typedef char " << regionId.str() << "_size_check["
+                << "sizeof(struct " << regionId.str() << ") == "
+                << fmmu.data_size << " ? 1 : -1];" << endl
+                << "#define " << prefix << "(PD) \\" << endl
+                << "    ((struct " << regionId.str() << " *) ((PD) + "
+                << prefix << "_OFFSET))" << endl
+                << endl;
+
+            defines << endl;
+            constants << "}" << endl;
+        }
+
+        constants << "}" << endl;
+    }
+
+    cout << "/* Process data layout of master " << m.getIndex()
+        << ", generated by 'ethercat " << getName() << " layout'." << endl
+        << " *" << endl
+        << " * Only valid for the configuration, that was active at" << endl
+        << " * generation time. The struct overlays assume a" << endl
+        << " * little-endian host." << endl
+        << " */" << endl
+        << endl
+        << "#ifndef __ETHERCAT_LAYOUT_MASTER" << m.getIndex() << "_H__"
+        << endl
+        << "#define __ETHERCAT_LAYOUT_MASTER" << m.getIndex() << "_H__"
+        << endl
+        << endl
+        << "#include <stdint.h>" << endl
+        << endl
+        << defines.str()
+        << structs.str()
+        << "#if defined(__cplusplus) && __cplusplus >= 201103L" << endl
+        << endl
+        << "namespace ethercat_layout {" << endl
+        << "namespace master" << m.getIndex() << " {" << endl
+        << constants.str()
+        << "}" << endl
+        << "}" << endl
+        << endl
+        << "#endif" << endl
+        << endl
+        << "#endif" << endl;
+}
+
+/*****************************************************************************/
+
+/** Loads the PDO entries mapped by the sync manager of an FMMU.
+ *
+ * The bit positions are calculated in the same way as in
+ * ecrt_slave_config_reg_pdo_entry().
+ */
+void CommandCStruct::loadLayoutEntries(
+        MasterDevice &m,
+        const ec_ioctl_domain_fmmu_t &fmmu,
+        LayoutEntryList &entries
+        )
+{
+    ec_ioctl_master_t master;
+    ec_ioctl_config_t config;
+    ec_ioctl_config_pdo_t pdo;
+    ec_ioctl_config_pdo_entry_t entry;
+    unsigned int i, j, k, bitPos = 0;
+
+    entries.clear();
+
+    m.getMaster(&master);
+    for (i = 0; i < master.config_count; i++) {
+        m.getConfig(&config, i);
+        if (config.alias == fmmu.slave_config_alias
+                && config.position == fmmu.slave_config_position) {
+            break;
+        }
+    }
+    if (i == master.config_count) {
+        stringstream err;
+        err << "Slave config " << fmmu.slave_config_alias << ":"
+            << fmmu.slave_config_position << " not found!";
+        throwCommandException(err);
+    }
+
+    for (j = 0; j < config.syncs[fmmu.sync_index].pdo_count; j++) {
+        m.getConfigPdo(&pdo, i, fmmu.sync_index, j);
+
+        for (k = 0; k < pdo.entry_count; k++) {
+            LayoutEntry e;
+
+            m.getConfigPdoEntry(&entry, i, fmmu.sync_index, j, k);
+            e.index = entry.index;
+            e.subindex = entry.subindex;
+            e.bitLength = entry.bit_length;
+            e.bitPos = bitPos;
+            e.name = (const char *) entry.name;
+            entries.push_back(e);
+
+            bitPos += entry.bit_length;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+string CommandCStruct::layoutEntryId(const LayoutEntry &entry)
+{
+    stringstream str;
+
+    str << "e" << hex << setfill('0') << setw(4) << entry.index
+        << "_" << setw(2) << (unsigned int) entry.subindex;
+
+    return str.str();
+}
+
+/*****************************************************************************/
+
+string CommandCStruct::upper(const string &str)
+{
+    string ret(str);
+    string::iterator i;
+
+    for (i = ret.begin(); i != ret.end(); i++) {
+        *i = toupper(*i);
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
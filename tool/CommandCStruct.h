@@ -45,6 +45,22 @@ class CommandCStruct:
 
     protected:
         void generateSlaveCStruct(MasterDevice &, const ec_ioctl_slave_t &);
+        void generateDomainLayout(MasterDevice &);
+
+        /** Mapped PDO entry within an FMMU region. */
+        struct LayoutEntry {
+            uint16_t index;
+            uint8_t subindex;
+            uint8_t bitLength;
+            unsigned int bitPos; /**< Relative to the region start. */
+            string name;
+        };
+        typedef vector<LayoutEntry> LayoutEntryList;
+
+        void loadLayoutEntries(MasterDevice &,
+                const ec_ioctl_domain_fmmu_t &, LayoutEntryList &);
+        static string layoutEntryId(const LayoutEntry &);
+        static string upper(const string &);
 };
 
 /****************************************************************************/
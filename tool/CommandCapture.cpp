@@ -0,0 +1,299 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "CommandCapture.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Number of frames read with one ioctl() call.
+ */
+#define CAPTURE_READ_FRAMES 64
+
+/** Default number of frames captured after a trigger event.
+ */
+#define DEFAULT_POST_FRAMES 100
+
+/*****************************************************************************/
+
+CommandCapture::CommandCapture():
+    Command("capture", "Capture frames and export them as pcap.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandCapture::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " start [unmatched] [wc] [<frames>]" << endl
+        << binaryBaseName << " " << getName() << " stop" << endl
+        << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master keeps a ring of the last "
+        << "sent and received frames" << endl
+        << "per device, including a time stamp. 'start' (re-)starts"
+        << endl
+        << "capturing, 'stop' stops it." << endl
+        << endl
+        << "Trigger arguments stop the capture <frames> frames (default"
+        << endl
+        << DEFAULT_POST_FRAMES << ") after the first of the given events:"
+        << endl
+        << "  unmatched  A received datagram could not be matched."
+        << endl
+        << "  wc         The working counter of a domain changed." << endl
+        << endl
+        << "Without arguments, the capture state is shown, or the frames"
+        << endl
+        << "captured since the last start are written to a pcap file."
+        << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master      -m <index>  Master index. Default: 0." << endl
+        << "  --output-file -o <file>   Write the captured frames of"
+        << endl
+        << "                            all devices to a pcap file."
+        << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandCapture::execute(const StringVector &args)
+{
+    string cmd;
+
+    if (args.size()) {
+        cmd = args[0];
+        transform(cmd.begin(), cmd.end(),
+                cmd.begin(), (int (*) (int)) std::tolower);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+
+    if (cmd == "start") {
+        m.open(MasterDevice::ReadWrite);
+        start(m, args);
+    } else if (cmd == "stop") {
+        if (args.size() > 1) {
+            stringstream err;
+            err << "'" << getName() << " stop' takes no arguments!";
+            throwInvalidUsageException(err);
+        }
+        m.open(MasterDevice::ReadWrite);
+        m.stopCapture();
+    } else if (cmd.empty()) {
+        m.open(MasterDevice::Read);
+        if (getOutputFile().empty()) {
+            showState(m);
+        } else {
+            writePcap(m);
+        }
+    } else {
+        stringstream err;
+        err << "Invalid argument '" << args[0] << "'!";
+        throwInvalidUsageException(err);
+    }
+}
+
+/****************************************************************************/
+
+void CommandCapture::start(MasterDevice &m, const StringVector &args)
+{
+    ec_ioctl_capture_start_t data;
+    StringVector::const_iterator ai;
+
+    data.triggers = 0;
+    data.post_frames = DEFAULT_POST_FRAMES;
+
+    for (ai = args.begin() + 1; ai != args.end(); ai++) {
+        string arg = *ai;
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+
+        if (arg == "unmatched") {
+            data.triggers |= EC_IOCTL_CAPTURE_UNMATCHED;
+        } else if (arg == "wc") {
+            data.triggers |= EC_IOCTL_CAPTURE_WC_CHANGE;
+        } else {
+            stringstream str;
+            str << arg;
+            str >> resetiosflags(ios::basefield) // guess base from prefix
+                >> data.post_frames;
+            if (str.fail()) {
+                stringstream err;
+                err << "Invalid argument '" << *ai << "'!";
+                throwInvalidUsageException(err);
+            }
+        }
+    }
+
+    m.startCapture(&data);
+}
+
+/****************************************************************************/
+
+void CommandCapture::showState(MasterDevice &m)
+{
+    ec_ioctl_master_t master;
+    ec_ioctl_capture_state_t state;
+    unsigned int dev_idx;
+
+    m.getMaster(&master);
+
+    for (dev_idx = 0; dev_idx < master.num_devices; dev_idx++) {
+        uint32_t count;
+
+        m.getCaptureState(&state, dev_idx);
+        count = min(state.seq - state.start_seq, state.ring_size);
+
+        cout << (dev_idx ? "Backup" : "Main") << " device "
+            << dev_idx << ": "
+            << (state.active ? "capturing" : "stopped")
+            << (state.triggered ? " (triggered)" : "")
+            << ", " << count << "/" << state.ring_size
+            << " frames" << endl;
+    }
+}
+
+/****************************************************************************/
+
+/** Sort order of captured frames.
+ */
+static bool frameTimeLess(
+        const ec_ioctl_capture_frame_t &a,
+        const ec_ioctl_capture_frame_t &b
+        )
+{
+    return a.time < b.time;
+}
+
+/** Writes a value in host byte order.
+ */
+template <class T>
+static void writeValue(ofstream &file, T value)
+{
+    file.write((const char *) &value, sizeof(value));
+}
+
+/****************************************************************************/
+
+void CommandCapture::writePcap(MasterDevice &m)
+{
+    ec_ioctl_master_t master;
+    ec_ioctl_capture_state_t state;
+    ec_ioctl_capture_read_t data;
+    vector<ec_ioctl_capture_frame_t> frames;
+    vector<ec_ioctl_capture_frame_t>::const_iterator fi;
+    unsigned int dev_idx;
+    ofstream file;
+
+    m.getMaster(&master);
+
+    for (dev_idx = 0; dev_idx < master.num_devices; dev_idx++) {
+        m.getCaptureState(&state, dev_idx);
+
+        data.dev_idx = dev_idx;
+        data.seq = state.start_seq;
+        if (state.seq - state.start_seq > state.ring_size) {
+            data.seq = state.seq - state.ring_size;
+        }
+
+        while (data.seq != state.seq) {
+            size_t offset = frames.size();
+
+            frames.resize(offset + CAPTURE_READ_FRAMES);
+            data.max_frames = CAPTURE_READ_FRAMES;
+            data.frames = &frames[offset];
+            m.readCapture(&data);
+            frames.resize(offset + data.frame_count);
+
+            if (!data.frame_count) {
+                // overwritten in the meantime
+                data.seq++;
+            }
+            data.seq += data.frame_count;
+        }
+    }
+
+    stable_sort(frames.begin(), frames.end(), frameTimeLess);
+
+    file.open(getOutputFile().c_str(), ios::out | ios::binary);
+    if (file.fail()) {
+        stringstream err;
+        err << "Failed to open '" << getOutputFile() << "'!";
+        throwCommandException(err);
+    }
+
+    // pcap header with nanosecond resolution, link type Ethernet
+    writeValue<uint32_t>(file, 0xa1b23c4d);
+    writeValue<uint16_t>(file, 2);
+    writeValue<uint16_t>(file, 4);
+    writeValue<int32_t>(file, 0);
+    writeValue<uint32_t>(file, 0);
+    writeValue<uint32_t>(file, EC_IOCTL_CAPTURE_FRAME_SIZE);
+    writeValue<uint32_t>(file, 1);
+
+    for (fi = frames.begin(); fi != frames.end(); fi++) {
+        writeValue<uint32_t>(file, fi->time / 1000000000ULL);
+        writeValue<uint32_t>(file, fi->time % 1000000000ULL);
+        writeValue<uint32_t>(file, fi->size);
+        writeValue<uint32_t>(file, fi->size);
+        file.write((const char *) fi->data, fi->size);
+    }
+
+    file.close();
+    if (file.fail()) {
+        stringstream err;
+        err << "Failed to write '" << getOutputFile() << "'!";
+        throwCommandException(err);
+    }
+
+    if (getVerbosity() != Quiet) {
+        cerr << frames.size() << " frames written to '"
+            << getOutputFile() << "'." << endl;
+    }
+}
+
+/*****************************************************************************/
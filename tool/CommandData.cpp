@@ -29,7 +29,13 @@
  *
  ****************************************************************************/
 
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
 #include <iostream>
+#include <iomanip>
+#include <vector>
 using namespace std;
 
 #include "CommandData.h"
@@ -37,6 +43,69 @@ using namespace std;
 
 /*****************************************************************************/
 
+/** Default sampling rate of the stream mode in Hz.
+ */
+#define DEFAULT_STREAM_RATE 1000
+
+/** Header of a binary stream record, followed by the process data.
+ *
+ * All fields are in host byte order.
+ */
+typedef struct {
+    uint64_t time; /**< Sampling time in ns since the epoch. */
+    uint32_t domain_index; /**< Domain index. */
+    uint32_t process_count; /**< Domain cycle counter. */
+    uint32_t data_size; /**< Size of the following process data. */
+} __attribute__ ((packed)) stream_record_t;
+
+static volatile sig_atomic_t streaming;
+
+static void stopStream(int)
+{
+    streaming = 0;
+}
+
+/*****************************************************************************/
+
+/** Copies a domain's process data from the read-only mapping.
+ *
+ * The copy is repeated, if the master processed the domain meanwhile.
+ *
+ * \return false, if the mapping does not describe the domain.
+ */
+static bool readMappedData(
+        const uint8_t *mem,
+        const ec_ioctl_state_page_t *state,
+        const ec_ioctl_domain_t &domain,
+        unsigned char *target,
+        uint32_t *processCount
+        )
+{
+    const volatile ec_ioctl_domain_map_t *map;
+    uint32_t seq;
+
+    if (domain.index >= *(const volatile uint32_t *) &state->domain_count) {
+        return false;
+    }
+
+    map = &state->domain_maps[domain.index];
+    if (map->size != domain.data_size) {
+        return false;
+    }
+
+    do {
+        seq = map->sequence;
+        __sync_synchronize();
+        memcpy(target, mem + map->offset, domain.data_size);
+        __sync_synchronize();
+    } while ((seq & 1) || seq != map->sequence);
+
+    *processCount = seq / 2;
+    return true;
+}
+
+/*****************************************************************************/
+
 CommandData::CommandData():
     Command("data", "Output binary domain process data.")
 {
@@ -49,11 +118,33 @@ string CommandData::helpString(const string &binaryBaseName) const
     stringstream str;
 
     str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << binaryBaseName << " " << getName()
+        << " [OPTIONS] stream [<rate>] [bin|csv]" << endl
         << endl
         << getBriefDescription() << endl
         << endl
         << "Data of multiple domains are concatenated." << endl
         << endl
+        << "With the 'stream' argument, the process data are sampled"
+        << endl
+        << "continuously with <rate> Hz (default "
+        << DEFAULT_STREAM_RATE << ") until the command" << endl
+        << "is interrupted. A record is written only if the domain"
+        << endl
+        << "was processed since the last sample. The records are" << endl
+        << "timestamped and carry the domain's cycle counter:" << endl
+        << "  bin  Binary: 64 bit time in ns since the epoch, 32 bit"
+        << endl
+        << "       domain index, cycle counter and data size, followed"
+        << endl
+        << "       by the data (host byte order, default)." << endl
+        << "  csv  One line per record: time,domain,cycle,data as hex."
+        << endl
+        << "While an application is running, its process data are"
+        << endl
+        << "mapped read-only, so that sampling needs no system calls."
+        << endl
+        << endl
         << "Command-specific options:" << endl
         << "  --domain -d <index>  Positive numerical domain index." << endl
         << "                       If omitted, data of all domains" << endl
@@ -73,9 +164,41 @@ void CommandData::execute(const StringVector &args)
     DomainList::const_iterator di;
 
     if (args.size()) {
-        stringstream err;
-        err << "'" << getName() << "' takes no arguments!";
-        throwInvalidUsageException(err);
+        string arg = args[0];
+        unsigned int rate = DEFAULT_STREAM_RATE;
+        bool csv = false;
+        StringVector::const_iterator ai;
+
+        transform(arg.begin(), arg.end(), arg.begin(),
+                (int (*) (int)) std::tolower);
+        if (arg != "stream") {
+            stringstream err;
+            err << "Invalid argument '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+
+        for (ai = args.begin() + 1; ai != args.end(); ai++) {
+            if (*ai == "bin") {
+                csv = false;
+            } else if (*ai == "csv") {
+                csv = true;
+            } else {
+                stringstream str(*ai);
+                str >> rate;
+                if (str.fail() || !str.eof() || !rate) {
+                    stringstream err;
+                    err << "Invalid stream argument '" << *ai << "'!";
+                    throwInvalidUsageException(err);
+                }
+            }
+        }
+
+        ec_ioctl_master_t io;
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::Read);
+        m.getMaster(&io);
+        streamDomainData(m, selectedDomains(m, io), rate, csv);
+        return;
     }
 
     masterIndices = getMasterIndices();
@@ -126,3 +249,108 @@ void CommandData::outputDomainData(
 }
 
 /****************************************************************************/
+
+void CommandData::streamDomainData(
+        MasterDevice &m,
+        const DomainList &domains,
+        unsigned int rate,
+        bool csv
+        )
+{
+    struct StreamDomain {
+        const ec_ioctl_domain_t *domain;
+        vector<unsigned char> data;
+        uint32_t lastCount;
+        bool sampled;
+    };
+    vector<StreamDomain> streamDomains;
+    DomainList::const_iterator di;
+    vector<StreamDomain>::iterator si;
+    ec_ioctl_domain_data_t data;
+    struct timespec wakeup, now;
+    uint64_t period = 1000000000ULL / rate;
+    const uint8_t *mem;
+    const ec_ioctl_state_page_t *state = NULL;
+    size_t stateOffset;
+
+    for (di = domains.begin(); di != domains.end(); di++) {
+        if (di->data_size) {
+            StreamDomain sd;
+            sd.domain = &*di;
+            sd.data.resize(di->data_size);
+            sd.lastCount = 0;
+            sd.sampled = false;
+            streamDomains.push_back(sd);
+        }
+    }
+
+    if (streamDomains.empty()) {
+        return;
+    }
+
+    // read the process data of a running application without ioctl()s
+    mem = m.mapReadOnly(&stateOffset);
+    if (mem) {
+        state = (const ec_ioctl_state_page_t *) (mem + stateOffset);
+    }
+
+    streaming = 1;
+    signal(SIGINT, stopStream);
+    signal(SIGTERM, stopStream);
+    signal(SIGPIPE, stopStream);
+
+    clock_gettime(CLOCK_MONOTONIC, &wakeup);
+
+    while (streaming) {
+        for (si = streamDomains.begin(); si != streamDomains.end(); si++) {
+            if (!state || !readMappedData(mem, state, *si->domain,
+                        &si->data[0], &data.process_count)) {
+                m.getData(&data, si->domain->index, si->domain->data_size,
+                        &si->data[0]);
+            }
+
+            if (si->sampled && data.process_count == si->lastCount) {
+                continue; // not processed since the last sample
+            }
+            si->sampled = true;
+            si->lastCount = data.process_count;
+
+            clock_gettime(CLOCK_REALTIME, &now);
+            uint64_t time = (uint64_t) now.tv_sec * 1000000000ULL
+                + now.tv_nsec;
+
+            if (csv) {
+                cout << dec << time << "," << si->domain->index << ","
+                    << data.process_count << "," << hex << setfill('0');
+                for (unsigned int i = 0; i < si->data.size(); i++) {
+                    cout << setw(2) << (unsigned int) si->data[i];
+                }
+                cout << "\n";
+            } else {
+                stream_record_t record;
+                record.time = time;
+                record.domain_index = si->domain->index;
+                record.process_count = data.process_count;
+                record.data_size = si->data.size();
+                cout.write((const char *) &record, sizeof(record));
+                cout.write((const char *) &si->data[0], si->data.size());
+            }
+        }
+
+        cout.flush();
+        if (!cout.good()) {
+            break;
+        }
+
+        wakeup.tv_nsec += period;
+        while (wakeup.tv_nsec >= 1000000000L) {
+            wakeup.tv_nsec -= 1000000000L;
+            wakeup.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+    }
+
+    cout.flush();
+}
+
+/****************************************************************************/
@@ -45,6 +45,8 @@ class CommandData:
 
     protected:
         void outputDomainData(MasterDevice &, const ec_ioctl_domain_t &);
+        void streamDomainData(MasterDevice &, const DomainList &,
+                unsigned int, bool);
 };
 
 /****************************************************************************/
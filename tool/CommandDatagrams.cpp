@@ -0,0 +1,160 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandDatagrams.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandDatagrams::CommandDatagrams():
+    Command("datagrams", "Show datagram round trip and loss statistics.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandDatagrams::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master keeps statistics for its own datagrams, the" << endl
+        << "master state machine datagrams, the domain datagrams and" << endl
+        << "the EoE datagrams. One line is displayed per datagram:" << endl
+        << endl
+        << "1  Datagram name." << endl
+        << "2  Datagram type and device (main/backup)." << endl
+        << "3  Data size in byte." << endl
+        << "4  Number of receptions." << endl
+        << "5  Minimum, mean and maximum round trip time in us." << endl
+        << "6  Number of timeouts." << endl
+        << "7  Number of responses that arrived after a timeout and" << endl
+        << "   their maximum lateness after the timeout in us." << endl
+        << "8  Number of requeues before the datagram was received."
+        << endl
+        << endl
+        << "Datagrams that were never sent are omitted, unless the" << endl
+        << "--verbose option is given." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master  -m <index>  Master index. Default: 0." << endl
+        << "  --verbose -v          Show unused datagrams, too." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandDatagrams::execute(const StringVector &args)
+{
+    ec_ioctl_master_t io;
+    ec_ioctl_datagram_stats_t data;
+    unsigned int i, count;
+
+    if (args.size()) {
+        stringstream err;
+        err << "'" << getName() << "' takes no arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    m.getMaster(&io);
+
+    cout << left << setw(20) << "Name" << " "
+        << setw(12) << "Type" << right
+        << " " << setw(5) << "Size"
+        << " " << setw(12) << "Received"
+        << " " << setw(10) << "RTT min"
+        << " " << setw(10) << "mean"
+        << " " << setw(10) << "max"
+        << " " << setw(8) << "Timeouts"
+        << " " << setw(8) << "Late"
+        << " " << setw(8) << "LateMax"
+        << " " << setw(8) << "Skips" << endl;
+
+    m.getDatagramStats(&data, 0);
+    count = data.datagram_count;
+
+    for (i = 0; i < count; i++) {
+        if (i) {
+            m.getDatagramStats(&data, i);
+        }
+
+        if (getVerbosity() != Verbose && !data.received && !data.timeouts
+                && !data.late && !data.skips) {
+            continue;
+        }
+
+        stringstream type;
+        type << typeString(data.type);
+        if (io.num_devices > 1) {
+            type << (data.device_index ? "/backup" : "/main");
+        }
+
+        cout << left << setw(20) << data.name << " "
+            << setw(12) << type.str() << right << dec
+            << " " << setw(5) << data.data_size
+            << " " << setw(12) << data.received
+            << fixed << setprecision(1)
+            << " " << setw(10) << data.rtt_min / 1000.0
+            << " " << setw(10) << data.rtt_avg / 1000.0
+            << " " << setw(10) << data.rtt_max / 1000.0
+            << " " << setw(8) << data.timeouts
+            << " " << setw(8) << data.late
+            << " " << setw(8) << data.late_max
+            << " " << setw(8) << data.skips << endl;
+    }
+}
+
+/****************************************************************************/
+
+const char *CommandDatagrams::typeString(uint8_t type)
+{
+    static const char *types[] = {
+        "?", "APRD", "APWR", "APRW", "FPRD", "FPWR", "FPRW", "BRD", "BWR",
+        "BRW", "LRD", "LWR", "LRW", "ARMW", "FRMW"
+    };
+
+    if (type < sizeof(types) / sizeof(types[0])) {
+        return types[type];
+    }
+    return "?";
+}
+
+/*****************************************************************************/
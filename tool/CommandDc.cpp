@@ -0,0 +1,297 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+#include "CommandDc.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandDc::CommandDc():
+    Command("dc", "Show distributed clocks synchronization statistics.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandDc::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << binaryBaseName << " " << getName() << " reset" << endl
+        << binaryBaseName << " " << getName() << " calibrate [CYCLES]"
+        << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master records the following values in the application"
+        << endl
+        << "context:" << endl
+        << endl
+        << "  Sync monitor     Results of ecrt_master_sync_monitor_process()"
+        << endl
+        << "                   (register 0x092C)." << endl
+        << "  Reference clock  Application time minus reference clock time,"
+        << endl
+        << "                   sampled by ecrt_master_sync_slave_clocks()."
+        << endl
+        << "  Send jitter      Deviation of the ecrt_master_send() interval"
+        << endl
+        << "                   from the DC cycle time of the configuration."
+        << endl
+        << "  SYNC0 margin     Time from the end of the process data frame"
+        << endl
+        << "                   passing a slave to its next SYNC0 event,"
+        << endl
+        << "                   recorded during a calibration window."
+        << endl
+        << endl
+        << "If the master's DC monitor is enabled (module parameter" << endl
+        << "dc_monitor_interval), the system time difference of every"
+        << endl
+        << "slave (register 0x092C) is sampled as well, and the slaves"
+        << endl
+        << "with the largest difference and drift are shown. With the"
+        << endl
+        << "--verbose option, all sampled slaves are listed." << endl
+        << endl
+        << "Histogram bins are counted by absolute value in ns. With the"
+        << endl
+        << "'reset' argument, the statistics are cleared with the next"
+        << endl
+        << "cycle." << endl
+        << endl
+        << "With the 'calibrate' argument, the SYNC0 margin is recorded"
+        << endl
+        << "for the next CYCLES (default: 1000) cycles of the running"
+        << endl
+        << "application. Afterwards, the SYNC0 shift correction is shown,"
+        << endl
+        << "that would reduce the smallest margin to zero. Add a safety"
+        << endl
+        << "margin before applying it to the SYNC0 shift times." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master -m <index>  Master index. Default: 0." << endl
+        << "  --verbose  -v        List the time difference of every"
+        << endl
+        << "                       slave." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandDc::execute(const StringVector &args)
+{
+    bool reset = false, calibrate = false;
+    uint32_t cycles = 1000;
+    ec_ioctl_dc_stats_t stats;
+
+    if (args.size() > 2) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most two arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size() >= 1) {
+        string arg = args[0];
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+        if (arg == "reset" && args.size() == 1) {
+            reset = true;
+        } else if (arg == "calibrate") {
+            calibrate = true;
+        } else {
+            stringstream err;
+            err << "'" << getName()
+                << "' takes either no, 'reset' or 'calibrate' argument!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    if (args.size() == 2) {
+        stringstream str;
+        str << args[1];
+        str >> cycles;
+        if (str.fail() || !cycles) {
+            stringstream err;
+            err << "Invalid number of cycles '" << args[1] << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(reset || calibrate ? MasterDevice::ReadWrite : MasterDevice::Read);
+
+    if (reset) {
+        m.resetDcStats();
+        return;
+    }
+
+    if (calibrate) {
+        m.calibrateSync0(cycles);
+        return;
+    }
+
+    m.getDcStats(&stats);
+
+    cout << "DC cycle time: ";
+    if (stats.cycle_time) {
+        cout << stats.cycle_time << " ns" << endl;
+    } else {
+        cout << "unknown (no send jitter recorded)" << endl;
+    }
+
+    showHistogram("Sync monitor", stats.sync_monitor);
+    showHistogram("Reference clock", stats.ref_offset);
+    showHistogram("Send jitter", stats.send_jitter);
+    showHistogram("SYNC0 margin", stats.sync0_margin);
+    if (stats.sync0_cycles_left) {
+        cout << "  Calibrating, " << stats.sync0_cycles_left
+            << " cycles left." << endl;
+    } else if (stats.sync0_margin.count) {
+        cout << "  Shift correction for zero margin: "
+            << -(int64_t) stats.sync0_margin.min << " ns" << endl;
+    }
+    showSlaves(m);
+}
+
+/****************************************************************************/
+
+void CommandDc::showSlaves(MasterDevice &m)
+{
+    ec_ioctl_master_t master;
+    ec_ioctl_slave_t slave;
+    unsigned int i, count = 0;
+    uint16_t max_diff_pos = 0, max_drift_pos = 0;
+    uint32_t max_diff = 0, max_drift = 0;
+
+    m.getMaster(&master);
+
+    for (i = 0; i < master.slave_count; i++) {
+        uint32_t diff, drift;
+
+        m.getSlave(&slave, i);
+        if (!slave.dc_diff_samples) {
+            continue;
+        }
+
+        if (!count++ && getVerbosity() == Verbose) {
+            cout << "Slave time differences:" << endl
+                << "  Slave    Diff [ns]  Max. [ns]  Drift [ns/s]"
+                << "  Samples" << endl;
+        }
+
+        if (getVerbosity() == Verbose) {
+            cout << "  " << setw(5) << i
+                << "  " << setw(11) << slave.dc_diff
+                << "  " << setw(9) << slave.dc_diff_max
+                << "  " << setw(12) << slave.dc_drift
+                << "  " << setw(7) << slave.dc_diff_samples << endl;
+        }
+
+        diff = slave.dc_diff < 0 ? -(int64_t) slave.dc_diff : slave.dc_diff;
+        if (count == 1 || diff > max_diff) {
+            max_diff = diff;
+            max_diff_pos = i;
+        }
+        drift =
+            slave.dc_drift < 0 ? -(int64_t) slave.dc_drift : slave.dc_drift;
+        if (count == 1 || drift > max_drift) {
+            max_drift = drift;
+            max_drift_pos = i;
+        }
+    }
+
+    if (!count) {
+        return;
+    }
+
+    cout << "Slave monitor (" << count << " slaves):" << endl
+        << "  Largest difference: " << max_diff << " ns at slave "
+        << max_diff_pos << endl
+        << "  Largest drift:      " << max_drift << " ns/s at slave "
+        << max_drift_pos << endl;
+}
+
+/****************************************************************************/
+
+void CommandDc::showHistogram(
+        const char *title,
+        const ec_ioctl_dc_histogram_t &hist
+        )
+{
+    unsigned int i, first, last;
+
+    cout << title << ":" << endl
+        << "  Samples: " << hist.count << endl;
+
+    if (!hist.count) {
+        return;
+    }
+
+    cout << "  Minimum: " << hist.min << " ns" << endl
+        << "  Maximum: " << hist.max << " ns" << endl
+        << "  Mean:    " << hist.sum / (int64_t) hist.count << " ns" << endl;
+
+    // only show the range of non-empty bins
+    for (first = 0; first < EC_IOCTL_DC_HISTOGRAM_BINS - 1; first++) {
+        if (hist.bins[first]) {
+            break;
+        }
+    }
+    for (last = EC_IOCTL_DC_HISTOGRAM_BINS - 1; last > first; last--) {
+        if (hist.bins[last]) {
+            break;
+        }
+    }
+
+    for (i = first; i <= last; i++) {
+        uint32_t lower = i ? 1U << (i + 5) : 0;
+
+        cout << "  " << setw(8) << lower;
+        if (i < EC_IOCTL_DC_HISTOGRAM_BINS - 1) {
+            cout << " .. " << setw(8) << (1U << (i + 6)) - 1;
+        } else {
+            cout << " ..         ";
+        }
+        cout << " ns: " << setw(10) << hist.bins[i]
+            << " (" << fixed << setprecision(1)
+            << 100.0 * hist.bins[i] / hist.count << " %)" << endl;
+    }
+}
+
+/*****************************************************************************/
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandDictExport.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandDictExport::CommandDictExport():
+    Command("dict_export", "Output a slave's SDO dictionary for import.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandDictExport::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "This command requires a single slave to be selected." << endl
+        << endl
+        << "The dictionary is written to stdout as text. It can be" << endl
+        << "loaded again with the 'dict_import' command, for example" << endl
+        << "after reloading the master module, so that slaves of the" << endl
+        << "same type do not have to read it from the bus. Entry" << endl
+        << "descriptions, that were not yet read from the slave, are" << endl
+        << "read before." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of" << endl
+        << "                         the 'slaves' command." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandDictExport::execute(const StringVector &args)
+{
+    SlaveList slaves;
+    ec_ioctl_slave_sdo_t sdo;
+    ec_ioctl_slave_sdo_entry_t entry;
+    unsigned int i, j, k;
+
+    if (args.size()) {
+        stringstream err;
+        err << "'" << getName() << "' takes no arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    slaves = selectedSlaves(m);
+
+    if (slaves.size() != 1) {
+        throwSingleSlaveRequired(slaves.size());
+    }
+    const ec_ioctl_slave_t &slave = slaves.front();
+
+    if (!slave.sdo_count) {
+        stringstream err;
+        err << "Slave " << slave.position << " has no SDO dictionary!";
+        throwCommandException(err);
+    }
+
+    cout << "# SDO dictionary of slave " << slave.position << endl
+        << hex << setfill('0')
+        << "vendor 0x" << setw(8) << slave.vendor_id << endl
+        << "product 0x" << setw(8) << slave.product_code << endl
+        << "revision 0x" << setw(8) << slave.revision_number << endl;
+
+    for (i = 0; i < slave.sdo_count; i++) {
+        m.getSdo(&sdo, slave.position, i);
+
+        cout << "sdo 0x" << setw(4) << sdo.sdo_index
+            << " 0x" << setw(2) << (unsigned int) sdo.object_code
+            << " 0x" << setw(2) << (unsigned int) sdo.max_subindex
+            << " " << sdo.name << endl;
+
+        for (j = 0; j <= sdo.max_subindex; j++) {
+            try {
+                m.getSdoEntry(&entry, slave.position, -i, j);
+            }
+            catch (MasterDeviceException &e) {
+                continue;
+            }
+
+            cout << "entry 0x" << setw(4) << sdo.sdo_index
+                << " 0x" << setw(2) << j
+                << " 0x" << setw(4) << entry.data_type
+                << " " << dec << entry.bit_length << hex << " ";
+            for (k = 0; k < EC_SDO_ENTRY_ACCESS_COUNT; k++) {
+                cout << (entry.read_access[k] ? "r" : "-")
+                    << (entry.write_access[k] ? "w" : "-");
+            }
+            cout << " " << entry.description << endl;
+        }
+    }
+}
+
+/*****************************************************************************/
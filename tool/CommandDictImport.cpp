@@ -0,0 +1,228 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string.h>
+using namespace std;
+
+#include "CommandDictImport.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandDictImport::CommandDictImport():
+    Command("dict_import", "Load an SDO dictionary into the master.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandDictImport::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] <FILENAME>" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The dictionary is stored in the master's dictionary" << endl
+        << "cache. Slaves with the same vendor ID, product code and" << endl
+        << "revision number, that did not read their dictionary yet," << endl
+        << "use it instead of reading it from the bus. A cached" << endl
+        << "dictionary of the same slave type is replaced." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  FILENAME must be a path to a file in the format written" << endl
+        << "           by the 'dict_export' command. If it is '-'," << endl
+        << "           data are read from stdin." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandDictImport::execute(const StringVector &args)
+{
+    stringstream err;
+    ec_ioctl_dict_import_t data;
+    vector<ec_ioctl_dict_sdo_t> sdos;
+    vector<EntryVector> entries;
+    ifstream file;
+    unsigned int i;
+
+    if (args.size() != 1) {
+        err << "'" << getName() << "' takes exactly one argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args[0] == "-") {
+        loadDict(&data, sdos, entries, cin);
+    } else {
+        file.open(args[0].c_str(), ifstream::in);
+        if (file.fail()) {
+            err << "Failed to open '" << args[0] << "'!";
+            throwCommandException(err);
+        }
+        loadDict(&data, sdos, entries, file);
+        file.close();
+    }
+
+    if (sdos.empty()) {
+        err << "The file contains no SDOs!";
+        throwCommandException(err);
+    }
+
+    for (i = 0; i < sdos.size(); i++) {
+        sdos[i].entry_count = entries[i].size();
+        sdos[i].entries = entries[i].size() ? &entries[i][0] : NULL;
+    }
+    data.sdo_count = sdos.size();
+    data.sdos = &sdos[0];
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::ReadWrite);
+    m.importDict(&data);
+
+    if (getVerbosity() == Verbose) {
+        cerr << "Imported " << sdos.size() << " SDOs." << endl;
+    }
+}
+
+/*****************************************************************************/
+
+void CommandDictImport::loadDict(
+        ec_ioctl_dict_import_t *data,
+        vector<ec_ioctl_dict_sdo_t> &sdos,
+        vector<EntryVector> &entries,
+        istream &in
+        )
+{
+    string line, keyword, text, access;
+    unsigned int lineNumber = 0, index, subindex, value, i;
+    bool identity[3] = {false, false, false};
+
+    while (getline(in, line)) {
+        stringstream str(line), err;
+        lineNumber++;
+
+        str >> resetiosflags(ios::basefield); // guess base from prefix
+
+        if (!(str >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        if (keyword == "vendor" || keyword == "product"
+                || keyword == "revision") {
+            str >> value;
+            if (str.fail()) {
+                err << "Invalid number in line " << lineNumber << "!";
+                throwCommandException(err);
+            }
+
+            if (keyword == "vendor") {
+                data->vendor_id = value;
+                identity[0] = true;
+            } else if (keyword == "product") {
+                data->product_code = value;
+                identity[1] = true;
+            } else {
+                data->revision_number = value;
+                identity[2] = true;
+            }
+        } else if (keyword == "sdo") {
+            ec_ioctl_dict_sdo_t sdo;
+
+            str >> index >> value >> subindex;
+            if (str.fail()) {
+                err << "Invalid number in line " << lineNumber << "!";
+                throwCommandException(err);
+            }
+            getline(str >> ws, text);
+
+            memset(&sdo, 0, sizeof(sdo));
+            sdo.index = index;
+            sdo.object_code = value;
+            sdo.max_subindex = subindex;
+            strncpy((char *) sdo.name, text.c_str(),
+                    EC_IOCTL_STRING_SIZE - 1);
+            sdos.push_back(sdo);
+            entries.push_back(EntryVector());
+        } else if (keyword == "entry") {
+            ec_ioctl_dict_entry_t entry;
+
+            memset(&entry, 0, sizeof(entry));
+            str >> index >> subindex >> value;
+            entry.subindex = subindex;
+            entry.data_type = value;
+            str >> value >> access;
+            entry.bit_length = value;
+            if (str.fail()) {
+                err << "Invalid number in line " << lineNumber << "!";
+                throwCommandException(err);
+            }
+            getline(str >> ws, text);
+
+            if (sdos.empty() || sdos.back().index != index) {
+                err << "Entry without SDO in line " << lineNumber << "!";
+                throwCommandException(err);
+            }
+
+            if (access.size() != 2 * EC_SDO_ENTRY_ACCESS_COUNT) {
+                err << "Invalid access rights in line " << lineNumber << "!";
+                throwCommandException(err);
+            }
+
+            for (i = 0; i < EC_SDO_ENTRY_ACCESS_COUNT; i++) {
+                entry.read_access[i] = access[2 * i] == 'r';
+                entry.write_access[i] = access[2 * i + 1] == 'w';
+            }
+            strncpy((char *) entry.description, text.c_str(),
+                    EC_IOCTL_STRING_SIZE - 1);
+            entries.back().push_back(entry);
+        } else {
+            err << "Invalid keyword '" << keyword << "' in line "
+                << lineNumber << "!";
+            throwCommandException(err);
+        }
+    }
+
+    if (!identity[0] || !identity[1] || !identity[2]) {
+        stringstream err;
+        err << "The file does not specify vendor ID, product code"
+            << " and revision number!";
+        throwCommandException(err);
+    }
+}
+
+/*****************************************************************************/
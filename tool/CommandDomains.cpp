@@ -63,25 +63,35 @@ string CommandDomains::helpString(const string &binaryBaseName) const
         << "counter sum. If the values are equal, all PDOs were" << endl
         << "exchanged during the last cycle." << endl
         << endl
-        << "If the --verbose option is given, the participating slave" << endl
-        << "configurations/FMMUs and the current process data are" << endl
-        << "additionally displayed:" << endl
+        << "After a working counter drop, the master reads the AL" << endl
+        << "states of the domain's slaves. The ring positions of the" << endl
+        << "slaves found faulty are displayed below the domain." << endl
+        << endl
+        << "If the --verbose option is given, the datagram statistics,"
+        << endl
+        << "the participating slave configurations/FMMUs and the" << endl
+        << "current process data are additionally displayed:" << endl
         << endl
         << "Domain1: LogBaseAddr 0x00000006, Size   6, WorkingCounter 0/1"
         << endl
+        << "  Datagram domain1-0-main: Received 1000, RoundTrip"
+        << " 21.3/24.0/40.2," << endl
+        << "    Timeouts 0, Late 0 (max 0 us), Skips 0" << endl
         << "  SlaveConfig 1001:0, SM3 ( Input), LogAddr 0x00000006, Size 6"
         << endl
         << "    00 00 00 00 00 00" << endl
         << endl
-        << "The process data are displayed as hexadecimal bytes." << endl
+        << "The round trip times (minimum/mean/maximum) are displayed" << endl
+        << "in us, see also the 'datagrams' command. The process data" << endl
+        << "are displayed as hexadecimal bytes." << endl
         << endl
         << "Command-specific options:" << endl
         << "  --domain  -d <index>  Positive numerical domain index." << endl
         << "                        If ommitted, all domains are" << endl
         << "                        displayed." << endl
         << endl
-        << "  --verbose -v          Show FMMUs and process data" << endl
-        << "                        in addition." << endl
+        << "  --verbose -v          Show datagram statistics, FMMUs" << endl
+        << "                        and process data in addition." << endl
         << endl
         << numericInfo();
 
@@ -167,9 +177,24 @@ void CommandDomains::showDomain(
     }
     cout << endl;
 
+    if (domain.wc_fault_count) {
+        cout << indent << "  Faulty after last WC drop: "
+            << domain.wc_fault_count << " slave(s), positions";
+        for (i = 0; i < domain.wc_fault_count
+                && i < EC_MAX_WC_FAULT_SLAVES; i++) {
+            cout << " " << domain.wc_fault_slaves[i];
+        }
+        if (domain.wc_fault_count > EC_MAX_WC_FAULT_SLAVES) {
+            cout << " ...";
+        }
+        cout << endl;
+    }
+
     if (!domain.data_size || getVerbosity() != Verbose)
         return;
 
+    showDatagrams(m, domain, indent);
+
     processData = new unsigned char[domain.data_size];
 
     try {
@@ -184,16 +209,20 @@ void CommandDomains::showDomain(
 
         cout << indent << "  SlaveConfig "
             << dec << fmmu.slave_config_alias
-            << ":" << fmmu.slave_config_position
-            << ", SM" << (unsigned int) fmmu.sync_index << " ("
-            << setfill(' ') << setw(6)
+            << ":" << fmmu.slave_config_position;
+        if (fmmu.sync_index == 0xff) {
+            cout << ", Registers (";
+        } else {
+            cout << ", SM" << (unsigned int) fmmu.sync_index << " (";
+        }
+        cout << setfill(' ') << setw(6)
             << (fmmu.dir == EC_DIR_INPUT ? "Input" : "Output")
             << "), LogAddr 0x"
             << hex << setfill('0')
             << setw(8) << fmmu.logical_address
             << ", Size " << dec << fmmu.data_size << endl;
 
-        dataOffset = fmmu.logical_address - domain.logical_base_address;
+        dataOffset = fmmu.data_offset;
         if (dataOffset + fmmu.data_size > domain.data_size) {
             stringstream err;
             delete [] processData;
@@ -215,3 +244,38 @@ void CommandDomains::showDomain(
 }
 
 /*****************************************************************************/
+
+void CommandDomains::showDatagrams(
+        MasterDevice &m,
+        const ec_ioctl_domain_t &domain,
+        const string &indent
+        )
+{
+    ec_ioctl_datagram_stats_t data;
+    unsigned int i, count;
+
+    m.getDatagramStats(&data, 0);
+    count = data.datagram_count;
+
+    for (i = 0; i < count; i++) {
+        if (i) {
+            m.getDatagramStats(&data, i);
+        }
+
+        if (data.domain_index != (int32_t) domain.index) {
+            continue;
+        }
+
+        cout << indent << "  Datagram " << data.name
+            << ": Received " << dec << data.received
+            << ", RoundTrip " << fixed << setprecision(1)
+            << data.rtt_min / 1000.0 << "/"
+            << data.rtt_avg / 1000.0 << "/"
+            << data.rtt_max / 1000.0 << "," << endl
+            << indent << "    Timeouts " << data.timeouts
+            << ", Late " << data.late << " (max " << data.late_max << " us)"
+            << ", Skips " << data.skips << endl;
+    }
+}
+
+/*****************************************************************************/
@@ -46,6 +46,8 @@ class CommandDomains:
     protected:
         void showDomain(MasterDevice &, const ec_ioctl_master_t &,
                 const ec_ioctl_domain_t &, bool);
+        void showDatagrams(MasterDevice &, const ec_ioctl_domain_t &,
+                const string &);
 };
 
 /****************************************************************************/
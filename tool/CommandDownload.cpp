@@ -50,10 +50,20 @@ string CommandDownload::helpString(const string &binaryBaseName) const
     str << binaryBaseName << " " << getName()
         << " [OPTIONS] <INDEX> <SUBINDEX> <VALUE>" << endl
         << " [OPTIONS] <INDEX> <VALUE>" << endl
+        << " [OPTIONS] <INDEX>:<SUBINDEX> <VALUE> [...]" << endl
         << endl
         << getBriefDescription() << endl
         << endl
-        << "This command requires a single slave to be selected." << endl
+        << "The first two calls require a single slave to be selected."
+        << endl
+        << endl
+        << "The third call writes multiple entries to all selected" << endl
+        << "slaves. The slaves are accessed concurrently, the entries"
+        << endl
+        << "of a slave are written in the given order. Example:" << endl
+        << endl
+        << "  " << binaryBaseName << " " << getName()
+        << " -p 0-49 0x6060:00 8 0x6081:00 1000" << endl
         << endl
         << "The data type of the SDO entry is taken from the SDO" << endl
         << "dictionary by default. It can be overridden with the" << endl
@@ -96,6 +106,37 @@ void CommandDownload::execute(const StringVector &args)
     const DataType *dataType = NULL;
     SlaveList slaves;
 
+    if (args.size() && isSdoAddress(args[0])) {
+        if (args.size() % 2) {
+            err << "'" << getName() << "' takes pairs of entries and"
+                << " values!";
+            throwInvalidUsageException(err);
+        }
+
+        values.clear();
+        for (unsigned int i = 0; i < args.size(); i += 2) {
+            Value value;
+            value.address = parseSdoAddress(args[i]);
+            value.value = args[i + 1];
+            if (value.value == "-") {
+                err << "Reading values from standard input is not"
+                    << " supported for multiple entries!";
+                throwInvalidUsageException(err);
+            }
+            values.push_back(value);
+        }
+
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::ReadWrite);
+        slaves = selectedSlaves(m);
+        if (slaves.empty()) {
+            err << "No slaves selected!";
+            throwCommandException(err);
+        }
+        transferConcurrently(m, slaves);
+        return;
+    }
+
     if (args.size() != 2 && args.size() != 3) {
         err << "'" << getName() << "' takes 2 or 3 arguments!";
         throwInvalidUsageException(err);
@@ -241,3 +282,59 @@ void CommandDownload::execute(const StringVector &args)
 }
 
 /*****************************************************************************/
+
+void CommandDownload::transferSlave(
+        MasterDevice &m,
+        const ec_ioctl_slave_t &slave
+        )
+{
+    vector<Value>::const_iterator vi;
+
+    for (vi = values.begin(); vi != values.end(); vi++) {
+        ec_ioctl_slave_sdo_download_t data;
+        const DataType *dataType;
+
+        data.slave_position = slave.position;
+        data.sdo_index = vi->address.index;
+        data.sdo_entry_subindex = vi->address.subindex;
+        data.complete_access = 0;
+        data.data = NULL;
+
+        try {
+            dataType = entryDataType(m, slave.position, vi->address);
+
+            if (dataType->byteSize) {
+                data.data_size = dataType->byteSize;
+            } else {
+                data.data_size = DefaultBufferSize;
+            }
+            data.data = new uint8_t[data.data_size + 1];
+
+            data.data_size = interpretAsType(
+                    dataType, vi->value, data.data, data.data_size);
+            m.sdoDownload(&data);
+        } catch (MasterDeviceSdoAbortException &e) {
+            stringstream err;
+            err << "SDO transfer aborted with code 0x"
+                << setfill('0') << hex << setw(8) << e.abortCode
+                << ": " << abortText(e.abortCode);
+            printError(slave, vi->address, err.str());
+        } catch (MasterDeviceException &e) {
+            printError(slave, vi->address, e.what());
+        } catch (CommandException &e) {
+            printError(slave, vi->address, e.what());
+        } catch (InvalidUsageException &e) {
+            printError(slave, vi->address, e.what());
+        } catch (SizeException &e) {
+            printError(slave, vi->address, e.what());
+        } catch (ios::failure &e) {
+            stringstream err;
+            err << "Invalid value '" << vi->value << "'!";
+            printError(slave, vi->address, err.str());
+        }
+
+        delete [] data.data;
+    }
+}
+
+/*****************************************************************************/
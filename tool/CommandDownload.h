@@ -45,6 +45,15 @@ class CommandDownload:
 
     protected:
         enum {DefaultBufferSize = 1024};
+
+        /** Multi-object mode entry with its value. */
+        struct Value {
+            SdoAddress address;
+            string value;
+        };
+        vector<Value> values; /**< Multi-object mode entries. */
+
+        void transferSlave(MasterDevice &, const ec_ioctl_slave_t &);
 };
 
 /****************************************************************************/
@@ -54,6 +54,13 @@ string CommandEoe::helpString(const string &binaryBaseName) const
         << getBriefDescription() << endl
         << endl
         << "The TxRate and RxRate are displayed in Byte/s." << endl
+        << endl
+        << "TxQueue and TxQueueBytes show the number of queued frames and"
+        << endl
+        << "bytes together with their limits. TxDrop counts the frames, that"
+        << endl
+        << "were dropped, because they waited longer than the maximum delay."
+        << endl
         << endl;
 
     return str.str();
@@ -93,16 +100,17 @@ void CommandEoe::execute(const StringVector &args)
 
             cout << indent << "Interface  Slave  State  "
                 << "RxBytes  RxRate  "
-                << "TxBytes  TxRate  TxQueue"
+                << "TxBytes  TxRate  TxQueue      TxQueueBytes  TxDrop"
                 << endl;
         }
 
         for (i = 0; i < master.eoe_handler_count; i++) {
-            stringstream queue;
+            stringstream queue, queueBytes;
 
             m.getEoeHandler(&eoe, i);
 
             queue << eoe.tx_queued_frames << "/" << eoe.tx_queue_size;
+            queueBytes << eoe.tx_queued_bytes << "/" << eoe.tx_queue_bytes;
 
             cout << indent
                 << setw(9) << eoe.name << "  "
@@ -112,7 +120,9 @@ void CommandEoe::execute(const StringVector &args)
                 << setw(6) << eoe.rx_rate << "  "
                 << setw(7) << eoe.tx_bytes << "  "
                 << setw(6) << eoe.tx_rate << "  "
-                << setw(7) << queue.str()
+                << setw(11) << left << queue.str() << "  "
+                << setw(12) << queueBytes.str() << right << "  "
+                << setw(6) << eoe.tx_dropped
                 << endl;
         }
     }
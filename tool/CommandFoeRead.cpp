@@ -31,6 +31,8 @@
 
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <vector>
 using namespace std;
 
 #include "CommandFoeRead.h"
@@ -78,10 +80,12 @@ string CommandFoeRead::helpString(const string &binaryBaseName) const
 void CommandFoeRead::execute(const StringVector &args)
 {
     SlaveList slaves;
-    ec_ioctl_slave_t *slave;
-    ec_ioctl_slave_foe_t data;
-    unsigned int i;
+    ec_ioctl_foe_stream_t io;
     stringstream err;
+    ofstream file;
+    ostream *out = &cout;
+    vector<uint8_t> block(windowSize);
+    string path = getOutputFile();
 
     if (args.size() != 1) {
         err << "'" << getName() << "' takes exactly one argument!";
@@ -95,44 +99,55 @@ void CommandFoeRead::execute(const StringVector &args)
     if (slaves.size() != 1) {
         throwSingleSlaveRequired(slaves.size());
     }
-    slave = &slaves.front();
-    data.slave_position = slave->position;
-
-    /* FIXME: No good idea to have a fixed buffer size.
-     * Read in chunks and fill a buffer instead.
-     */
-    data.offset = 0;
-    data.buffer_size = 0x8800;
-    data.buffer = new uint8_t[data.buffer_size];
-
-    strncpy(data.file_name, args[0].c_str(), sizeof(data.file_name) - 1);
-
-    try {
-        m.readFoe(&data);
-    } catch (MasterDeviceException &e) {
-        delete [] data.buffer;
-        if (data.result) {
-            if (data.result == FOE_OPCODE_ERROR) {
-                err << "FoE read aborted with error code 0x"
-                    << setw(8) << setfill('0') << hex << data.error_code
-                    << ": " << errorText(data.error_code);
-            } else {
-                err << "Failed to write via FoE: "
-                    << resultText(data.result);
-            }
+
+    if (!path.empty() && path != "-") {
+        file.open(path.c_str(), ofstream::out | ofstream::binary);
+        if (file.fail()) {
+            err << "Failed to open '" << path << "'!";
             throwCommandException(err);
-        } else {
-            throw e;
         }
+        out = &file;
     }
 
-    // TODO --output-file
-    for (i = 0; i < data.data_size; i++) {
-        uint8_t *w = data.buffer + i;
-        cout << *(uint8_t *) w ;
+    memset(&io, 0, sizeof(io));
+    io.slave_position = slaves.front().position;
+    io.dir = EC_DIR_INPUT;
+    io.window_size = windowSize;
+    strncpy(io.file_name, args[0].c_str(), sizeof(io.file_name) - 1);
+
+    m.startFoeStream(&io);
+
+    // write every block as soon as it was received
+    do {
+        io.buffer = &block[0];
+        io.buffer_size = block.size();
+        m.transferFoeStream(&io);
+
+        if (io.data_size) {
+            out->write((const char *) &block[0], io.data_size);
+            if (out->fail()) {
+                err << "Failed to write FoE data!";
+                throwCommandException(err);
+            }
+        }
+    } while (io.state == EC_REQUEST_BUSY);
+
+    out->flush();
+
+    if (io.state != EC_REQUEST_SUCCESS) {
+        if (io.result == FOE_OPCODE_ERROR) {
+            err << "FoE read aborted with error code 0x"
+                << setw(8) << setfill('0') << hex << io.error_code
+                << ": " << errorText(io.error_code);
+        } else {
+            err << "Failed to read via FoE: " << resultText(io.result);
+        }
+        throwCommandException(err);
     }
 
-    delete [] data.buffer;
+    if (getVerbosity() == Verbose) {
+        cerr << "Read " << io.progress << " bytes via FoE." << endl;
+    }
 }
 
 /*****************************************************************************/
@@ -57,7 +57,9 @@ string CommandFoeWrite::helpString(const string &binaryBaseName) const
         << endl
         << getBriefDescription() << endl
         << endl
-        << "This command requires a single slave to be selected." << endl
+        << "If several slaves are selected, the file is written to" << endl
+        << "all of them in parallel. With --verbose, the progress of" << endl
+        << "every slave is reported." << endl
         << endl
         << "Arguments:" << endl
         << "  FILENAME can either be a path to a file, or '-'. In" << endl
@@ -86,6 +88,7 @@ void CommandFoeWrite::execute(const StringVector &args)
     stringstream err;
     ec_ioctl_slave_foe_t data;
     ifstream file;
+    istream *in;
     SlaveList slaves;
     string storeFileName;
 
@@ -95,7 +98,7 @@ void CommandFoeWrite::execute(const StringVector &args)
     }
 
     if (args[0] == "-") {
-        loadFoeData(&data, cin);
+        in = &cin;
         if (getOutputFile().empty()) {
             err << "Please specify a filename for the slave side"
                 << " with --output-file!";
@@ -109,8 +112,7 @@ void CommandFoeWrite::execute(const StringVector &args)
             err << "Failed to open '" << args[0] << "'!";
             throwCommandException(err);
         }
-        loadFoeData(&data, file);
-        file.close();
+        in = &file;
         if (getOutputFile().empty()) {
             char *cpy = strdup(args[0].c_str()); // basename can modify
                                                  // the string contents
@@ -122,49 +124,32 @@ void CommandFoeWrite::execute(const StringVector &args)
     }
 
     MasterDevice m(getSingleMasterIndex());
-    try {
-        m.open(MasterDevice::ReadWrite);
-    } catch (MasterDeviceException &e) {
-        if (data.buffer_size)
-            delete [] data.buffer;
-        throw e;
-    }
+    m.open(MasterDevice::ReadWrite);
 
     slaves = selectedSlaves(m);
-    if (slaves.size() != 1) {
-        if (data.buffer_size)
-            delete [] data.buffer;
+    if (slaves.empty()) {
         throwSingleSlaveRequired(slaves.size());
     }
-    data.slave_position = slaves.front().position;
 
-    // write data via foe to the slave
+    if (slaves.size() == 1) {
+        writeStream(m, slaves.front().position, *in, storeFileName);
+        return;
+    }
+
+    // the parallel job shares one kernel buffer, so load the whole file
+    loadFoeData(&data, *in);
+    data.slave_position = slaves.front().position;
     data.offset = 0;
+    memset(data.file_name, 0, sizeof(data.file_name));
     strncpy(data.file_name, storeFileName.c_str(),
             sizeof(data.file_name) - 1);
 
     try {
-        m.writeFoe(&data);
-    } catch (MasterDeviceException &e) {
+        writeParallel(m, slaves, &data);
+    } catch (...) {
         if (data.buffer_size)
             delete [] data.buffer;
-        if (data.result) {
-            if (data.result == FOE_OPCODE_ERROR) {
-                err << "FoE write aborted with error code 0x"
-                    << setw(8) << setfill('0') << hex << data.error_code
-                    << ": " << errorText(data.error_code);
-            } else {
-                err << "Failed to write via FoE: "
-                    << resultText(data.result);
-            }
-            throwCommandException(err);
-        } else {
-            throw e;
-        }
-    }
-
-    if (getVerbosity() == Verbose) {
-        cerr << "FoE writing finished." << endl;
+        throw;
     }
 
     if (data.buffer_size)
@@ -198,3 +183,154 @@ void CommandFoeWrite::loadFoeData(
 }
 
 /*****************************************************************************/
+
+/** Writes the file to a single slave.
+ *
+ * The file is passed to the kernel block by block, whenever the FoE state
+ * machine needs new data, so the memory needed does not depend on the file
+ * size.
+ */
+void CommandFoeWrite::writeStream(
+        MasterDevice &m,
+        uint16_t position,
+        istream &in,
+        const string &fileName
+        )
+{
+    stringstream err;
+    ec_ioctl_foe_stream_t io;
+    vector<uint8_t> block(windowSize);
+    size_t offset = 0, fill = 0;
+    bool end = false;
+    unsigned int reported = 0;
+
+    memset(&io, 0, sizeof(io));
+    io.slave_position = position;
+    io.dir = EC_DIR_OUTPUT;
+    io.window_size = windowSize;
+    strncpy(io.file_name, fileName.c_str(), sizeof(io.file_name) - 1);
+
+    m.startFoeStream(&io);
+
+    do {
+        if (!fill && !end) {
+            in.read((char *) &block[0], block.size());
+            if (in.bad()) {
+                err << "Failed to read FoE data!";
+                throwCommandException(err);
+            }
+            fill = in.gcount();
+            offset = 0;
+            end = !in;
+        }
+
+        io.buffer = &block[0] + offset;
+        io.buffer_size = fill;
+        io.end = end;
+        m.transferFoeStream(&io);
+        offset += io.data_size;
+        fill -= io.data_size;
+
+        // report the progress in steps of 64 KiB
+        if (getVerbosity() == Verbose && io.progress / 0x10000 > reported) {
+            reported = io.progress / 0x10000;
+            cerr << io.progress << " bytes written." << endl;
+        }
+    } while (io.state == EC_REQUEST_BUSY);
+
+    if (io.state != EC_REQUEST_SUCCESS) {
+        if (io.result == FOE_OPCODE_ERROR) {
+            err << "FoE write aborted with error code 0x"
+                << setw(8) << setfill('0') << hex << io.error_code
+                << ": " << errorText(io.error_code);
+        } else {
+            err << "Failed to write via FoE: " << resultText(io.result);
+        }
+        throwCommandException(err);
+    }
+
+    if (getVerbosity() == Verbose) {
+        cerr << "FoE writing finished." << endl;
+    }
+}
+
+/*****************************************************************************/
+
+/** Writes the file to several slaves in parallel.
+ */
+void CommandFoeWrite::writeParallel(
+        MasterDevice &m,
+        const SlaveList &slaves,
+        const ec_ioctl_slave_foe_t *data
+        )
+{
+    stringstream err;
+    ec_ioctl_foe_job_t job;
+    vector<ec_ioctl_foe_job_slave_t> states(slaves.size());
+    vector<unsigned int> reported(slaves.size(), 0);
+    SlaveList::const_iterator si;
+    unsigned int i, failed = 0;
+
+    for (si = slaves.begin(), i = 0; si != slaves.end(); si++, i++) {
+        memset(&states[i], 0, sizeof(states[i]));
+        states[i].slave_position = si->position;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.slave_count = states.size();
+    job.slaves = &states[0];
+    job.buffer_size = data->buffer_size;
+    job.buffer = data->buffer;
+    memcpy(job.file_name, data->file_name, sizeof(job.file_name));
+
+    m.startFoeJob(&job);
+
+    do {
+        m.getFoeJobStatus(&job);
+
+        if (getVerbosity() != Verbose) {
+            continue;
+        }
+
+        // report every slave in steps of 10 percent
+        for (i = 0; i < states.size(); i++) {
+            unsigned int percent = job.buffer_size ?
+                states[i].progress * 100 / job.buffer_size : 100;
+            percent -= percent % 10;
+            if (percent > reported[i]) {
+                cerr << "Slave " << states[i].slave_position << ": "
+                    << percent << "%" << endl;
+                reported[i] = percent;
+            }
+        }
+    } while (job.busy_count);
+
+    for (i = 0; i < states.size(); i++) {
+        if (states[i].state == EC_REQUEST_SUCCESS) {
+            continue;
+        }
+
+        cerr << "Slave " << states[i].slave_position << ": ";
+        if (states[i].result == FOE_OPCODE_ERROR) {
+            cerr << "FoE write aborted with error code 0x"
+                << setw(8) << setfill('0') << hex << states[i].error_code
+                << dec << ": " << errorText(states[i].error_code) << endl;
+        } else {
+            cerr << "Failed to write via FoE: "
+                << resultText(states[i].result) << endl;
+        }
+        failed++;
+    }
+
+    if (failed) {
+        err << "FoE write failed for " << failed << " of "
+            << states.size() << " slaves!";
+        throwCommandException(err);
+    }
+
+    if (getVerbosity() == Verbose) {
+        cerr << "FoE writing finished." << endl;
+    }
+}
+
+/*****************************************************************************/
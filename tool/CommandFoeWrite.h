@@ -45,6 +45,10 @@ class CommandFoeWrite:
 
     protected:
         void loadFoeData(ec_ioctl_slave_foe_t *, const istream &);
+        void writeStream(MasterDevice &, uint16_t, istream &,
+                const string &);
+        void writeParallel(MasterDevice &, const SlaveList &,
+                const ec_ioctl_slave_foe_t *);
 };
 
 /****************************************************************************/
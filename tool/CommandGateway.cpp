@@ -0,0 +1,791 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <signal.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+#include "CommandGateway.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** UDP port of the EtherCAT mailbox gateway (ETG.8200). */
+#define DEFAULT_PORT 0x88A4
+
+/** Maximum number of slaves served concurrently. */
+#define MAX_GATEWAY_THREADS 16
+
+/** Maximum number of pending requests per slave. Further requests are
+ * dropped and have to be repeated by the client. */
+#define MAX_QUEUE_DEPTH 32
+
+/** Size of the upload buffer. */
+#define UPLOAD_BUFFER_SIZE (64 * 1024)
+
+#define FRAME_TYPE_MAILBOX 5
+#define MBOX_HEADER_SIZE 6
+#define MIN_MAILBOX_SIZE (MBOX_HEADER_SIZE + 10)
+#define MBOX_TYPE_ERROR 0x00
+#define MBOX_TYPE_COE 0x03
+#define COE_SERVICE_SDO_REQUEST 0x02
+#define COE_SERVICE_SDO_RESPONSE 0x03
+
+/* Mailbox error codes (ETG.1000.4). */
+#define MBXERR_UNSUPPORTEDPROTOCOL 0x0002
+#define MBXERR_SERVICENOTSUPPORTED 0x0004
+#define MBXERR_SIZETOOSHORT 0x0006
+
+/* SDO abort codes. */
+#define ABORT_TOGGLE 0x05030000
+#define ABORT_COMMAND 0x05040001
+#define ABORT_LENGTH_HIGH 0x06070012
+#define ABORT_LENGTH_LOW 0x06070013
+#define ABORT_GENERAL 0x08000000
+
+static volatile sig_atomic_t serving;
+
+static void stopGateway(int)
+{
+    serving = 0;
+}
+
+/*****************************************************************************/
+
+CommandGateway::CommandGateway():
+    Command("gateway", "Serve remote mailbox requests via UDP.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandGateway::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS] [<port>]"
+        << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The command acts as an EtherCAT mailbox gateway (ETG.8200)"
+        << endl
+        << "until it is interrupted. Remote tools send mailboxes in"
+        << endl
+        << "EtherCAT frames of type 5 to UDP <port> (default "
+        << DEFAULT_PORT << ")." << endl
+        << "The address field of the mailbox header contains the" << endl
+        << "station address of the slave, which is the ring position"
+        << endl
+        << "plus one." << endl
+        << endl
+        << "CoE SDO requests (expedited, normal and segmented, with" << endl
+        << "or without complete access) are executed by the master's"
+        << endl
+        << "slave state machines and answered with the corresponding"
+        << endl
+        << "CoE response. The requests of different slaves are" << endl
+        << "processed concurrently, those of a slave in order. Other"
+        << endl
+        << "mailbox protocols and CoE services are answered with a" << endl
+        << "mailbox error." << endl
+        << endl
+        << "The slaves are determined at startup, so the command has"
+        << endl
+        << "to be restarted after the bus has changed." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master -m <index>  Master index. Default: 0." << endl
+        << "  --verbose -v         Output every request." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandGateway::execute(const StringVector &args)
+{
+    unsigned int port = DEFAULT_PORT, i;
+    struct sockaddr_in addr;
+    vector<pthread_t> threads;
+
+    if (args.size() > 1) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most one argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size()) {
+        stringstream str;
+        str << args[0];
+        str >> resetiosflags(ios::basefield) // guess base from prefix
+            >> port;
+        if (str.fail() || !port || port > 0xffff) {
+            stringstream err;
+            err << "Invalid port '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::ReadWrite);
+    master = &m;
+    loadChannels();
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        stringstream err;
+        err << "Failed to create socket: " << strerror(errno);
+        throwCommandException(err);
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        stringstream err;
+        err << "Failed to bind to UDP port " << port << ": "
+            << strerror(errno);
+        close(sock);
+        throwCommandException(err);
+    }
+
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+    stopping = false;
+
+    for (i = 0; i < channels.size() && i < MAX_GATEWAY_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, workerThread, this)) {
+            break;
+        }
+        threads.push_back(thread);
+    }
+
+    if (getVerbosity() != Quiet) {
+        cerr << "Serving " << channels.size() << " slave(s) on UDP port "
+            << port << " with " << threads.size() << " thread(s)."
+            << endl;
+    }
+
+    serving = 1;
+    signal(SIGINT, stopGateway);
+    signal(SIGTERM, stopGateway);
+
+    if (!threads.empty()) {
+        receive();
+    }
+
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+
+    for (i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+    close(sock);
+}
+
+/****************************************************************************/
+
+/** Creates a channel for every slave with a mailbox.
+ */
+void CommandGateway::loadChannels()
+{
+    ec_ioctl_master_t data;
+    ec_ioctl_slave_t slave;
+    unsigned int i;
+
+    master->getMaster(&data);
+    channels.clear();
+
+    for (i = 0; i < data.slave_count; i++) {
+        master->getSlave(&slave, i);
+        if (slave.std_tx_mailbox_size < MIN_MAILBOX_SIZE) {
+            continue;
+        }
+
+        Channel &channel = channels[i + 1];
+        channel.position = i;
+        channel.mailboxSize = slave.std_tx_mailbox_size;
+        channel.coe = slave.mailbox_protocols & EC_MBOX_COE;
+        channel.busy = false;
+        channel.session.active = false;
+    }
+}
+
+/****************************************************************************/
+
+/** Receives mailboxes and queues them to the channels.
+ */
+void CommandGateway::receive()
+{
+    uint8_t frame[2048];
+    struct pollfd pfd;
+    Request request;
+    socklen_t addrLen;
+    ssize_t size;
+    uint16_t header, length, address;
+    ChannelMap::iterator ci;
+
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+
+    while (serving) {
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue; // timeout or interrupted
+        }
+
+        addrLen = sizeof(request.client);
+        size = recvfrom(sock, frame, sizeof(frame), 0,
+                (struct sockaddr *) &request.client, &addrLen);
+        if (size < 2 + MBOX_HEADER_SIZE) {
+            continue;
+        }
+
+        header = EC_READ_U16(frame);
+        length = header & 0x07ff;
+        if ((header >> 12) != FRAME_TYPE_MAILBOX
+                || length < MBOX_HEADER_SIZE || length > size - 2
+                || EC_READ_U16(frame + 2) > length - MBOX_HEADER_SIZE) {
+            if (getVerbosity() == Verbose) {
+                cerr << "Dropping invalid frame from "
+                    << inet_ntoa(request.client.sin_addr) << "." << endl;
+            }
+            continue;
+        }
+
+        address = EC_READ_U16(frame + 4);
+        request.mailbox.assign(frame + 2,
+                frame + 2 + MBOX_HEADER_SIZE + EC_READ_U16(frame + 2));
+
+        pthread_mutex_lock(&mutex);
+        ci = channels.find(address);
+        if (ci == channels.end()
+                || ci->second.queue.size() >= MAX_QUEUE_DEPTH) {
+            pthread_mutex_unlock(&mutex);
+            if (getVerbosity() == Verbose) {
+                cerr << "Dropping mailbox for station address " << address
+                    << (ci == channels.end() ? " (unknown)." : " (busy).")
+                    << endl;
+            }
+            continue;
+        }
+        ci->second.queue.push_back(request);
+        if (!ci->second.busy && ci->second.queue.size() == 1) {
+            ready.push_back(&ci->second);
+            pthread_cond_signal(&cond);
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+}
+
+/****************************************************************************/
+
+void *CommandGateway::workerThread(void *arg)
+{
+    ((CommandGateway *) arg)->work();
+    return NULL;
+}
+
+/****************************************************************************/
+
+/** Processes the requests of ready channels, one channel at a time.
+ */
+void CommandGateway::work()
+{
+    sigset_t mask;
+
+    // leave the signals to the receiving thread
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    pthread_mutex_lock(&mutex);
+
+    while (1) {
+        while (!stopping && ready.empty()) {
+            pthread_cond_wait(&cond, &mutex);
+        }
+        if (stopping) {
+            break;
+        }
+
+        Channel *channel = ready.front();
+        ready.pop_front();
+        Request request = channel->queue.front();
+        channel->queue.pop_front();
+        channel->busy = true;
+        pthread_mutex_unlock(&mutex);
+
+        process(*channel, request);
+
+        pthread_mutex_lock(&mutex);
+        channel->busy = false;
+        if (!channel->queue.empty()) {
+            ready.push_back(channel);
+            pthread_cond_signal(&cond);
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/****************************************************************************/
+
+void CommandGateway::process(Channel &channel, const Request &request)
+{
+    const uint8_t *data = &request.mailbox[MBOX_HEADER_SIZE];
+    size_t size = request.mailbox.size() - MBOX_HEADER_SIZE;
+    uint8_t type = request.mailbox[5] & 0x0f;
+
+    if (getVerbosity() == Verbose) {
+        cerr << inet_ntoa(request.client.sin_addr) << ": slave "
+            << channel.position << ", type 0x" << hex
+            << (unsigned int) type << dec << ", " << size << " byte."
+            << endl;
+    }
+
+    if (type != MBOX_TYPE_COE || !channel.coe) {
+        replyError(request, MBXERR_UNSUPPORTEDPROTOCOL);
+        return;
+    }
+
+    if (size < 2) {
+        replyError(request, MBXERR_SIZETOOSHORT);
+        return;
+    }
+
+    if ((EC_READ_U16(data) >> 12) != COE_SERVICE_SDO_REQUEST) {
+        replyError(request, MBXERR_SERVICENOTSUPPORTED);
+        return;
+    }
+
+    if (size < 10) {
+        replyError(request, MBXERR_SIZETOOSHORT);
+        return;
+    }
+
+    processSdo(channel, request, data + 2, size - 2);
+}
+
+/****************************************************************************/
+
+/** Processes an SDO request.
+ *
+ * \a sdo points to the command specifier, followed by at least 7 bytes.
+ */
+void CommandGateway::processSdo(
+        Channel &channel,
+        const Request &request,
+        const uint8_t *sdo,
+        size_t size
+        )
+{
+    Session &session = channel.session;
+    uint8_t cmd = sdo[0];
+    uint16_t index = EC_READ_U16(sdo + 1);
+    uint8_t subindex = sdo[3];
+    bool completeAccess = cmd & 0x10;
+    uint8_t toggle = (cmd >> 4) & 1;
+    uint8_t response[8];
+    size_t dataSize;
+
+    switch (cmd >> 5) {
+        case 1: // initiate download
+            session.active = false;
+            if (cmd & 0x02) { // expedited
+                dataSize = (cmd & 0x01) ? 4 - ((cmd >> 2) & 0x03) : 4;
+                download(channel, request, index, subindex,
+                        completeAccess, sdo + 4, dataSize);
+                break;
+            }
+
+            session.size = EC_READ_U32(sdo + 4);
+            dataSize = size - 8;
+            if (dataSize >= session.size) {
+                download(channel, request, index, subindex,
+                        completeAccess, sdo + 8, session.size);
+                break;
+            }
+
+            // segments follow
+            session.active = true;
+            session.upload = false;
+            session.index = index;
+            session.subindex = subindex;
+            session.completeAccess = completeAccess;
+            session.data.assign(sdo + 8, sdo + 8 + dataSize);
+            session.toggle = 0;
+
+            memset(response, 0, sizeof(response));
+            response[0] = 0x60; // initiate download response
+            EC_WRITE_U16(response + 1, index);
+            response[3] = subindex;
+            replySdo(request, response, sizeof(response));
+            break;
+
+        case 0: // download segment
+            if (!session.active || session.upload) {
+                replyAbort(channel, request, index, subindex,
+                        ABORT_COMMAND);
+                break;
+            }
+            if (toggle != session.toggle) {
+                replyAbort(channel, request, session.index,
+                        session.subindex, ABORT_TOGGLE);
+                break;
+            }
+
+            dataSize = size > 8 ? size - 1 : 7 - ((cmd >> 1) & 0x07);
+            if (session.data.size() + dataSize > session.size) {
+                replyAbort(channel, request, session.index,
+                        session.subindex, ABORT_LENGTH_HIGH);
+                break;
+            }
+            session.data.insert(session.data.end(), sdo + 1,
+                    sdo + 1 + dataSize);
+            session.toggle = !session.toggle;
+
+            if (!(cmd & 0x01)) { // more segments follow
+                memset(response, 0, sizeof(response));
+                response[0] = 0x20 | (toggle << 4);
+                replySdo(request, response, sizeof(response));
+                break;
+            }
+
+            session.active = false;
+            if (session.data.size() != session.size) {
+                replyAbort(channel, request, session.index,
+                        session.subindex, ABORT_LENGTH_LOW);
+                break;
+            }
+
+            try {
+                ec_ioctl_slave_sdo_download_t data;
+
+                data.slave_position = channel.position;
+                data.sdo_index = session.index;
+                data.sdo_entry_subindex = session.subindex;
+                data.complete_access = session.completeAccess;
+                data.data_size = session.data.size();
+                data.data = session.data.empty() ? NULL : &session.data[0];
+                master->sdoDownload(&data);
+            } catch (MasterDeviceSdoAbortException &e) {
+                replyAbort(channel, request, session.index,
+                        session.subindex, e.abortCode);
+                break;
+            } catch (MasterDeviceException &e) {
+                replyAbort(channel, request, session.index,
+                        session.subindex, ABORT_GENERAL);
+                break;
+            }
+
+            memset(response, 0, sizeof(response));
+            response[0] = 0x20 | (toggle << 4);
+            replySdo(request, response, sizeof(response));
+            break;
+
+        case 2: // initiate upload
+            session.active = false;
+            upload(channel, request, index, subindex, completeAccess);
+            break;
+
+        case 3: // upload segment
+            if (!session.active || !session.upload) {
+                replyAbort(channel, request, index, subindex,
+                        ABORT_COMMAND);
+                break;
+            }
+            if (toggle != session.toggle) {
+                replyAbort(channel, request, session.index,
+                        session.subindex, ABORT_TOGGLE);
+                break;
+            }
+            uploadSegment(channel, request, toggle);
+            break;
+
+        case 4: // abort from the client, no response
+            session.active = false;
+            break;
+
+        default:
+            session.active = false;
+            replyAbort(channel, request, index, subindex, ABORT_COMMAND);
+            break;
+    }
+}
+
+/****************************************************************************/
+
+/** Executes a download and replies with the initiate download response.
+ */
+void CommandGateway::download(
+        Channel &channel,
+        const Request &request,
+        uint16_t index,
+        uint8_t subindex,
+        bool completeAccess,
+        const uint8_t *data,
+        size_t size
+        )
+{
+    ec_ioctl_slave_sdo_download_t io;
+    vector<uint8_t> buffer(data, data + size);
+    uint8_t response[8];
+
+    io.slave_position = channel.position;
+    io.sdo_index = index;
+    io.sdo_entry_subindex = subindex;
+    io.complete_access = completeAccess;
+    io.data_size = buffer.size();
+    io.data = buffer.empty() ? NULL : &buffer[0];
+
+    try {
+        master->sdoDownload(&io);
+    } catch (MasterDeviceSdoAbortException &e) {
+        replyAbort(channel, request, index, subindex, e.abortCode);
+        return;
+    } catch (MasterDeviceException &e) {
+        replyAbort(channel, request, index, subindex, ABORT_GENERAL);
+        return;
+    }
+
+    memset(response, 0, sizeof(response));
+    response[0] = 0x60; // initiate download response
+    EC_WRITE_U16(response + 1, index);
+    response[3] = subindex;
+    replySdo(request, response, sizeof(response));
+}
+
+/****************************************************************************/
+
+/** Executes an upload and replies with the initiate upload response.
+ *
+ * Data exceeding the slave's mailbox are kept for the following upload
+ * segment requests.
+ */
+void CommandGateway::upload(
+        Channel &channel,
+        const Request &request,
+        uint16_t index,
+        uint8_t subindex,
+        bool completeAccess
+        )
+{
+    Session &session = channel.session;
+    ec_ioctl_slave_sdo_upload_t io;
+    vector<uint8_t> response(8);
+    size_t maxData;
+
+    session.data.resize(UPLOAD_BUFFER_SIZE);
+    io.slave_position = channel.position;
+    io.sdo_index = index;
+    io.sdo_entry_subindex = subindex;
+    io.complete_access = completeAccess;
+    io.target_size = session.data.size();
+    io.target = &session.data[0];
+
+    try {
+        master->sdoUpload(&io);
+    } catch (MasterDeviceSdoAbortException &e) {
+        replyAbort(channel, request, index, subindex, e.abortCode);
+        return;
+    } catch (MasterDeviceException &e) {
+        replyAbort(channel, request, index, subindex, ABORT_GENERAL);
+        return;
+    }
+    session.data.resize(io.data_size);
+
+    EC_WRITE_U16(&response[1], index);
+    response[3] = subindex;
+
+    if (io.data_size <= 4) { // expedited
+        response[0] = 0x43 | ((4 - io.data_size) << 2);
+        memcpy(&response[4], &session.data[0], io.data_size);
+        replySdo(request, &response[0], response.size());
+        return;
+    }
+
+    response[0] = 0x41; // normal, size indicated
+    EC_WRITE_U32(&response[4], io.data_size);
+
+    // CoE header and SDO header take 10 bytes
+    maxData = channel.mailboxSize - MBOX_HEADER_SIZE - 10;
+    session.offset = min(maxData, session.data.size());
+    response.insert(response.end(), session.data.begin(),
+            session.data.begin() + session.offset);
+    replySdo(request, &response[0], response.size());
+
+    if (session.offset < session.data.size()) {
+        session.active = true;
+        session.upload = true;
+        session.index = index;
+        session.subindex = subindex;
+        session.toggle = 0;
+    }
+}
+
+/****************************************************************************/
+
+/** Replies with the next upload segment.
+ */
+void CommandGateway::uploadSegment(
+        Channel &channel,
+        const Request &request,
+        uint8_t toggle
+        )
+{
+    Session &session = channel.session;
+    vector<uint8_t> response(1);
+    size_t maxData, size;
+
+    // CoE header and segment header take 3 bytes
+    maxData = channel.mailboxSize - MBOX_HEADER_SIZE - 3;
+    size = min(maxData, session.data.size() - session.offset);
+
+    response[0] = toggle << 4;
+    if (size < 7) {
+        response[0] |= (7 - size) << 1;
+    }
+    response.insert(response.end(), session.data.begin() + session.offset,
+            session.data.begin() + session.offset + size);
+    if (response.size() < 8) {
+        response.resize(8);
+    }
+
+    session.offset += size;
+    if (session.offset == session.data.size()) {
+        response[0] |= 0x01; // last segment
+        session.active = false;
+    }
+    session.toggle = !session.toggle;
+
+    replySdo(request, &response[0], response.size());
+}
+
+/****************************************************************************/
+
+/** Sends a mailbox to the client, answering a request.
+ */
+void CommandGateway::reply(
+        const Request &request,
+        uint8_t type,
+        const uint8_t *data,
+        size_t size
+        )
+{
+    vector<uint8_t> frame(2 + MBOX_HEADER_SIZE + size);
+
+    EC_WRITE_U16(&frame[0],
+            ((MBOX_HEADER_SIZE + size) & 0x07ff) | (FRAME_TYPE_MAILBOX << 12));
+    EC_WRITE_U16(&frame[2], size);
+    EC_WRITE_U16(&frame[4], EC_READ_U16(&request.mailbox[2])); // address
+    frame[6] = 0x00; // channel and priority
+    frame[7] = (request.mailbox[5] & 0x70) | type; // counter of request
+    if (size) {
+        memcpy(&frame[2 + MBOX_HEADER_SIZE], data, size);
+    }
+
+    sendto(sock, &frame[0], frame.size(), 0,
+            (const struct sockaddr *) &request.client,
+            sizeof(request.client));
+}
+
+/****************************************************************************/
+
+/** Sends a CoE SDO response.
+ */
+void CommandGateway::replySdo(
+        const Request &request,
+        const uint8_t *sdo,
+        size_t size
+        )
+{
+    vector<uint8_t> data(2 + size);
+
+    EC_WRITE_U16(&data[0], COE_SERVICE_SDO_RESPONSE << 12);
+    memcpy(&data[2], sdo, size);
+    reply(request, MBOX_TYPE_COE, &data[0], data.size());
+}
+
+/****************************************************************************/
+
+/** Sends an SDO abort and ends a segmented transfer.
+ */
+void CommandGateway::replyAbort(
+        Channel &channel,
+        const Request &request,
+        uint16_t index,
+        uint8_t subindex,
+        uint32_t abortCode
+        )
+{
+    uint8_t data[10];
+
+    channel.session.active = false;
+
+    EC_WRITE_U16(data, COE_SERVICE_SDO_REQUEST << 12);
+    data[2] = 0x80; // abort transfer
+    EC_WRITE_U16(data + 3, index);
+    data[5] = subindex;
+    EC_WRITE_U32(data + 6, abortCode);
+    reply(request, MBOX_TYPE_COE, data, sizeof(data));
+}
+
+/****************************************************************************/
+
+/** Sends a mailbox error.
+ */
+void CommandGateway::replyError(const Request &request, uint16_t detail)
+{
+    uint8_t data[4];
+
+    EC_WRITE_U16(data, 0x0001); // mailbox command
+    EC_WRITE_U16(data + 2, detail);
+    reply(request, MBOX_TYPE_ERROR, data, sizeof(data));
+}
+
+/*****************************************************************************/
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#ifndef __COMMANDGATEWAY_H__
+#define __COMMANDGATEWAY_H__
+
+#include <pthread.h>
+#include <netinet/in.h>
+#include <map>
+#include <deque>
+
+#include "Command.h"
+
+/****************************************************************************/
+
+class CommandGateway:
+    public Command
+{
+    public:
+        CommandGateway();
+
+        string helpString(const string &) const;
+        void execute(const StringVector &);
+
+    protected:
+        /** Mailbox received from a client. */
+        struct Request {
+            struct sockaddr_in client;
+            vector<uint8_t> mailbox; /**< Mailbox header and data. */
+        };
+
+        /** State of a segmented SDO transfer. */
+        struct Session {
+            bool active;
+            bool upload;
+            uint16_t index;
+            uint8_t subindex;
+            bool completeAccess;
+            vector<uint8_t> data;
+            size_t size; /**< Complete size of a download. */
+            size_t offset; /**< Data uploaded so far. */
+            uint8_t toggle;
+        };
+
+        /** Requests addressed to a slave.
+         *
+         * The requests of a slave are processed in order, those of
+         * different slaves concurrently.
+         */
+        struct Channel {
+            uint16_t position;
+            uint16_t mailboxSize; /**< Size of the slave's send mailbox. */
+            bool coe;
+            list<Request> queue;
+            bool busy;
+            Session session;
+        };
+        typedef map<uint16_t, Channel> ChannelMap; /**< By station
+                                                     address. */
+
+        MasterDevice *master;
+        int sock;
+        ChannelMap channels;
+        deque<Channel *> ready; /**< Channels with requests, that are
+                                  not processed at the moment. */
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        bool stopping;
+
+        void loadChannels();
+        void receive();
+        static void *workerThread(void *);
+        void work();
+        void process(Channel &, const Request &);
+        void processSdo(Channel &, const Request &, const uint8_t *,
+                size_t);
+        void download(Channel &, const Request &, uint16_t, uint8_t,
+                bool, const uint8_t *, size_t);
+        void upload(Channel &, const Request &, uint16_t, uint8_t, bool);
+        void uploadSegment(Channel &, const Request &, uint8_t);
+        void reply(const Request &, uint8_t, const uint8_t *, size_t);
+        void replySdo(const Request &, const uint8_t *, size_t);
+        void replyAbort(Channel &, const Request &, uint16_t, uint8_t,
+                uint32_t);
+        void replyError(const Request &, uint16_t);
+};
+
+/****************************************************************************/
+
+#endif
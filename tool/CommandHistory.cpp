@@ -0,0 +1,243 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include "CommandHistory.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Number of records read with one ioctl() call.
+ */
+#define HISTORY_READ_RECORDS 64
+
+/*****************************************************************************/
+
+CommandHistory::CommandHistory():
+    Command("history", "Freeze and export the process data history.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandHistory::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " freeze|resume [OPTIONS]"
+        << endl
+        << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "An application can let the master record the process data"
+        << endl
+        << "of a domain in a ring each time the domain is queued (see"
+        << endl
+        << "ecrt_domain_history()). 'freeze' stops the recording, so"
+        << endl
+        << "that the records preceding a fault are kept, 'resume'"
+        << endl
+        << "continues it." << endl
+        << endl
+        << "Without arguments, the history state is shown, or the"
+        << endl
+        << "records are written to a CSV file with the columns domain,"
+        << endl
+        << "sequence number, cycle counter, time in ns since the epoch"
+        << endl
+        << "and the recorded bytes in hexadecimal." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master      -m <index>  Master index. Default: 0." << endl
+        << "  --domain      -d <index>  Positive numerical domain index."
+        << endl
+        << "                            If omitted, all domains are"
+        << endl
+        << "                            used." << endl
+        << "  --output-file -o <file>   Write the records to a CSV file."
+        << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandHistory::execute(const StringVector &args)
+{
+    string cmd;
+    ec_ioctl_master_t io;
+    DomainList domains;
+    DomainList::const_iterator di;
+
+    if (args.size() > 1) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most one argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size()) {
+        cmd = args[0];
+        transform(cmd.begin(), cmd.end(),
+                cmd.begin(), (int (*) (int)) std::tolower);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+
+    if (cmd == "freeze" || cmd == "resume") {
+        m.open(MasterDevice::ReadWrite);
+        m.getMaster(&io);
+        domains = selectedDomains(m, io);
+        for (di = domains.begin(); di != domains.end(); di++) {
+            m.freezeHistory(di->index, cmd == "freeze");
+        }
+    } else if (cmd.empty()) {
+        m.open(MasterDevice::Read);
+        m.getMaster(&io);
+        domains = selectedDomains(m, io);
+        if (getOutputFile().empty()) {
+            showState(m, domains);
+        } else {
+            writeCsv(m, domains);
+        }
+    } else {
+        stringstream err;
+        err << "Invalid argument '" << args[0] << "'!";
+        throwInvalidUsageException(err);
+    }
+}
+
+/****************************************************************************/
+
+void CommandHistory::showState(MasterDevice &m, const DomainList &domains)
+{
+    ec_ioctl_domain_history_state_t state;
+    DomainList::const_iterator di;
+
+    for (di = domains.begin(); di != domains.end(); di++) {
+        m.getHistoryState(&state, di->index);
+
+        cout << "Domain" << dec << di->index << ": ";
+        if (!state.depth) {
+            cout << "no history" << endl;
+            continue;
+        }
+
+        cout << (state.frozen ? "frozen" : "recording")
+            << ", " << min(state.seq, state.depth) << "/" << state.depth
+            << " records of " << state.size << " byte at offset "
+            << state.offset << endl;
+    }
+}
+
+/****************************************************************************/
+
+void CommandHistory::writeCsv(MasterDevice &m, const DomainList &domains)
+{
+    ec_ioctl_domain_history_state_t state;
+    ec_ioctl_domain_history_read_t data;
+    vector<uint8_t> records;
+    DomainList::const_iterator di;
+    unsigned int i, j, count = 0;
+    ofstream file;
+
+    file.open(getOutputFile().c_str(), ios::out);
+    if (file.fail()) {
+        stringstream err;
+        err << "Failed to open '" << getOutputFile() << "'!";
+        throwCommandException(err);
+    }
+
+    file << "domain,seq,cycle,time,data" << endl;
+
+    for (di = domains.begin(); di != domains.end(); di++) {
+        m.getHistoryState(&state, di->index);
+        if (!state.depth) {
+            continue;
+        }
+
+        records.resize(HISTORY_READ_RECORDS * state.record_size);
+        data.domain_index = di->index;
+        data.seq = 0;
+        if (state.seq > state.depth) {
+            data.seq = state.seq - state.depth;
+        }
+
+        while (data.seq != state.seq) {
+            data.max_records = min(state.seq - data.seq,
+                    (uint32_t) HISTORY_READ_RECORDS);
+            data.records = &records[0];
+            m.readHistory(&data);
+
+            for (i = 0; i < data.record_count; i++) {
+                const uint8_t *mem = &records[i * state.record_size];
+                const ec_history_record_t *record =
+                    (const ec_history_record_t *) mem;
+
+                file << dec << di->index << "," << record->seq - 1 << ","
+                    << record->cycle << "," << record->time << ","
+                    << hex << setfill('0');
+                for (j = 0; j < state.size; j++) {
+                    file << setw(2) << (unsigned int)
+                        mem[sizeof(ec_history_record_t) + j];
+                }
+                file << setfill(' ') << endl;
+                count++;
+            }
+
+            if (!data.record_count) {
+                // overwritten in the meantime
+                data.seq++;
+            }
+            data.seq += data.record_count;
+        }
+    }
+
+    file.close();
+    if (file.fail()) {
+        stringstream err;
+        err << "Failed to write '" << getOutputFile() << "'!";
+        throwCommandException(err);
+    }
+
+    if (getVerbosity() != Quiet) {
+        cerr << dec << count << " records written to '"
+            << getOutputFile() << "'." << endl;
+    }
+}
+
+/*****************************************************************************/
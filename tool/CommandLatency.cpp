@@ -0,0 +1,188 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+#include "CommandLatency.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandLatency::CommandLatency():
+    Command("latency", "Show cyclic latency statistics.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandLatency::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << binaryBaseName << " " << getName() << " reset" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "While the master is in operation, it records the following"
+        << endl
+        << "durations in the application context:" << endl
+        << endl
+        << "  Send        Duration of ecrt_master_send()." << endl
+        << "  Receive     Duration of ecrt_master_receive()." << endl
+        << endl
+        << "For every domain:" << endl
+        << endl
+        << "  Round trip  Time from sending the domain's datagrams"
+        << endl
+        << "              until the reception of the last one." << endl
+        << "  Process     Duration of ecrt_domain_process()." << endl
+        << endl
+        << "Histogram bins are counted in ns. With the 'reset' argument,"
+        << endl
+        << "the statistics are cleared with the next cycle." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master -m <index>  Master index. Default: 0." << endl
+        << "  --domain -d <index>  Positive numerical domain index." << endl
+        << "                       If ommitted, all domains are" << endl
+        << "                       displayed." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandLatency::execute(const StringVector &args)
+{
+    bool reset = false;
+    ec_ioctl_master_t io;
+    ec_ioctl_latency_stats_t stats;
+    DomainList domains;
+    DomainList::const_iterator di;
+
+    if (args.size() > 1) {
+        stringstream err;
+        err << "'" << getName() << "' takes either no or 'reset' argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size() == 1) {
+        string arg = args[0];
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+        if (arg != "reset") {
+            stringstream err;
+            err << "'" << getName()
+                << "' takes either no or 'reset' argument!";
+            throwInvalidUsageException(err);
+        }
+
+        reset = true;
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(reset ? MasterDevice::ReadWrite : MasterDevice::Read);
+
+    if (reset) {
+        m.resetLatencyStats();
+        return;
+    }
+
+    m.getLatencyStats(&stats);
+    showHistogram("Send", stats.send);
+    showHistogram("Receive", stats.receive);
+
+    m.getMaster(&io);
+    domains = selectedDomains(m, io);
+
+    for (di = domains.begin(); di != domains.end(); di++) {
+        ec_ioctl_domain_latency_stats_t data;
+
+        m.getDomainLatencyStats(&data, di->index);
+        cout << "Domain" << dec << di->index << ":" << endl;
+        showHistogram("  Round trip", data.round_trip);
+        showHistogram("  Process", data.process);
+    }
+}
+
+/****************************************************************************/
+
+void CommandLatency::showHistogram(
+        const char *title,
+        const ec_ioctl_latency_histogram_t &hist
+        )
+{
+    unsigned int i, first, last;
+    const char *indent = title[0] == ' ' ? "  " : "";
+
+    cout << title << ":" << endl
+        << indent << "  Samples: " << hist.count << endl;
+
+    if (!hist.count) {
+        return;
+    }
+
+    cout << indent << "  Minimum: " << hist.min << " ns" << endl
+        << indent << "  Maximum: " << hist.max << " ns" << endl
+        << indent << "  Mean:    " << hist.sum / hist.count << " ns" << endl;
+
+    // only show the range of non-empty bins
+    for (first = 0; first < EC_IOCTL_LATENCY_HISTOGRAM_BINS - 1; first++) {
+        if (hist.bins[first]) {
+            break;
+        }
+    }
+    for (last = EC_IOCTL_LATENCY_HISTOGRAM_BINS - 1; last > first; last--) {
+        if (hist.bins[last]) {
+            break;
+        }
+    }
+
+    for (i = first; i <= last; i++) {
+        uint32_t lower = i ? 1U << (i + 5) : 0;
+
+        cout << indent << "  " << setw(8) << lower;
+        if (i < EC_IOCTL_LATENCY_HISTOGRAM_BINS - 1) {
+            cout << " .. " << setw(8) << (1U << (i + 6)) - 1;
+        } else {
+            cout << " ..         ";
+        }
+        cout << " ns: " << setw(10) << hist.bins[i]
+            << " (" << fixed << setprecision(1)
+            << 100.0 * hist.bins[i] / hist.count << " %)" << endl;
+    }
+}
+
+/*****************************************************************************/
@@ -65,6 +65,21 @@ string CommandMaster::helpString(const string &binaryBaseName) const
 
 /****************************************************************************/
 
+const char *CommandMaster::trafficClassName(unsigned int tc)
+{
+    switch (tc) {
+        case EC_TC_CYCLIC: return "Cyclic";
+        case EC_TC_DC: return "Distributed clocks";
+        case EC_TC_MASTER_FSM: return "Master FSM";
+        case EC_TC_MAILBOX: return "Slave mailbox";
+        case EC_TC_EOE: return "EoE";
+        case EC_TC_DIAGNOSIS: return "Diagnosis";
+        default: return "???";
+    }
+}
+
+/****************************************************************************/
+
 void CommandMaster::execute(const StringVector &args)
 {
 	MasterIndexList masterIndices;
@@ -135,7 +150,15 @@ void CommandMaster::execute(const StringVector &args)
                 << "      Rx bytes:    "
                 << data.devices[dev_idx].rx_bytes << endl
                 << "      Tx errors:   "
-                << data.devices[dev_idx].tx_errors << endl
+                << data.devices[dev_idx].tx_errors << endl;
+            if (data.devices[dev_idx].max_round_trip_time) {
+                cout << "      Round trip [ns]: "
+                    << data.devices[dev_idx].round_trip_time
+                    << " (max. "
+                    << data.devices[dev_idx].max_round_trip_time
+                    << ")" << endl;
+            }
+            cout
                 << "      Tx frame rate [1/s]: "
                 << setfill(' ') << setprecision(0) << fixed;
             for (j = 0; j < EC_RATE_COUNT; j++) {
@@ -256,6 +279,34 @@ void CommandMaster::execute(const StringVector &args)
         }
         cout << setprecision(0) << endl;
 
+        cout << "  Traffic classes:" << endl;
+        for (j = 0; j < EC_TC_COUNT; j++) {
+            const ec_ioctl_master_t::ec_ioctl_traffic_class_info *tc =
+                &data.traffic_classes[j];
+            cout << "    " << trafficClassName(j) << ":" << endl
+                << "      Priority:    " << tc->priority << endl
+                << "      Budget:      ";
+            if (tc->budget) {
+                cout << tc->budget << " byte/cycle";
+            } else {
+                cout << "unlimited";
+            }
+            cout << endl
+                << "      Datagrams:   " << tc->datagrams << endl
+                << "      Bytes:       " << tc->bytes << endl
+                << "      Deferred:    " << tc->deferred << endl
+                << "      Held:        " << tc->held << endl;
+            if (j == EC_TC_EOE) {
+                cout << "      Cycle share: ";
+                if (data.eoe_share) {
+                    cout << data.eoe_share << " %";
+                } else {
+                    cout << "unlimited";
+                }
+                cout << endl;
+            }
+        }
+
         cout << "  Distributed clocks:" << endl
             << "    Reference clock:   ";
         if (data.ref_clock != 0xffff) {
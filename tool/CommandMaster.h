@@ -43,6 +43,8 @@ class CommandMaster:
         string helpString(const string &) const;
         void execute(const StringVector &);
 
+        static const char *trafficClassName(unsigned int);
+
     private:
         enum {ColWidth = 6};
 };
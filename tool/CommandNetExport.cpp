@@ -0,0 +1,158 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string.h>
+using namespace std;
+
+#include "CommandNetExport.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandNetExport::CommandNetExport():
+    Command("net_export", "Output a network description for the library.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandNetExport::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "For every selected slave, a slave configuration with its" << endl
+        << "position, identity and current PDO assignment and mapping" << endl
+        << "is written to stdout as text. The file can be completed" << endl
+        << "with 'sdo', 'dc' and 'watchdog' lines and loaded by an" << endl
+        << "application with ecrt_master_load_config(), instead of" << endl
+        << "configuring the slaves one by one." << endl
+        << endl
+        << "Note that the PDO information can either originate" << endl
+        << "from the SII or from the CoE communication area, see" << endl
+        << "the help of the 'xml' command." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of" << endl
+        << "                         the 'slaves' command." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandNetExport::execute(const StringVector &args)
+{
+    SlaveList slaves;
+    SlaveList::const_iterator si;
+
+    if (args.size()) {
+        stringstream err;
+        err << "'" << getName() << "' takes no arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    m.loadSlaveSnapshot();
+    slaves = selectedSlaves(m);
+
+    cout << "# Network description of master " << m.getIndex() << endl;
+
+    for (si = slaves.begin(); si != slaves.end(); si++) {
+        exportSlave(m, *si);
+    }
+}
+
+/****************************************************************************/
+
+void CommandNetExport::exportSlave(
+        MasterDevice &m,
+        const ec_ioctl_slave_t &slave
+        )
+{
+    ec_ioctl_slave_sync_t sync;
+    ec_ioctl_slave_sync_pdo_t pdo;
+    ec_ioctl_slave_sync_pdo_entry_t entry;
+    unsigned int i, j, k;
+
+    cout << endl
+        << "# Slave " << dec << slave.position;
+    if (strlen(slave.order)) {
+        cout << ", " << slave.order;
+    }
+    cout << ", revision 0x" << hex << setfill('0') << setw(8)
+        << slave.revision_number << endl
+        << "config 0 " << dec << slave.position
+        << " 0x" << hex << setw(8) << slave.vendor_id
+        << " 0x" << setw(8) << slave.product_code << endl;
+
+    for (i = 0; i < slave.sync_count; i++) {
+        m.getSync(&sync, slave.position, i);
+
+        cout << "sync " << dec << (unsigned int) sync.sync_index
+            << (EC_READ_BIT(&sync.control_register, 2) ?
+                    " output" : " input")
+            << (EC_READ_BIT(&sync.control_register, 6) ?
+                    " enable" : " disable") << endl;
+
+        for (j = 0; j < sync.pdo_count; j++) {
+            m.getPdo(&pdo, slave.position, i, j);
+
+            cout << "pdo 0x" << hex << setw(4) << pdo.index;
+            if (strlen((const char *) pdo.name)) {
+                cout << " # " << pdo.name;
+            }
+            cout << endl;
+
+            for (k = 0; k < pdo.entry_count; k++) {
+                m.getPdoEntry(&entry, slave.position, i, j, k);
+
+                cout << "entry 0x" << hex << setw(4) << entry.index
+                    << " 0x" << setw(2) << (unsigned int) entry.subindex
+                    << " " << dec << (unsigned int) entry.bit_length;
+                if (strlen((const char *) entry.name)) {
+                    cout << " # " << entry.name;
+                }
+                cout << endl;
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
@@ -52,7 +52,10 @@ string CommandRegRead::helpString(const string &binaryBaseName) const
         << endl
         << getBriefDescription() << endl
         << endl
-        << "This command requires a single slave to be selected." << endl
+        << "If several slaves are selected (for example with a" << endl
+        << "position range like '0-7'), the register range of all of" << endl
+        << "them is read at once, and one line is output per slave," << endl
+        << "starting with the slave position." << endl
         << endl
         << "Arguments:" << endl
         << "  ADDRESS is the register address. Must" << endl
@@ -145,9 +148,14 @@ void CommandRegRead::execute(const StringVector &args)
     m.open(MasterDevice::Read);
     slaves = selectedSlaves(m);
 
-    if (slaves.size() != 1) {
+    if (slaves.empty()) {
         throwSingleSlaveRequired(slaves.size());
     }
+
+    if (slaves.size() > 1) {
+        readBatch(m, slaves, dataType, io.address, io.size);
+        return;
+    }
     io.slave_position = slaves.front().position;
     io.emergency = false;
 
@@ -171,3 +179,47 @@ void CommandRegRead::execute(const StringVector &args)
 }
 
 /*****************************************************************************/
+
+void CommandRegRead::readBatch(
+        MasterDevice &m,
+        const SlaveList &slaves,
+        const DataType *dataType,
+        uint16_t address,
+        size_t size
+        )
+{
+    ec_ioctl_slave_reg_batch_t io;
+    vector<uint16_t> positions, workingCounters(slaves.size());
+    vector<uint8_t> data(slaves.size() * size);
+    SlaveList::const_iterator si;
+    unsigned int i;
+
+    for (si = slaves.begin(); si != slaves.end(); si++) {
+        positions.push_back(si->position);
+    }
+
+    io.slave_count = positions.size();
+    io.slave_positions = &positions[0];
+    io.address = address;
+    io.size = size;
+    io.data = &data[0];
+    io.working_counters = &workingCounters[0];
+
+    m.readRegBatch(&io);
+
+    for (i = 0; i < positions.size(); i++) {
+        cout << dec << setfill(' ') << setw(5) << positions[i] << "  ";
+        if (workingCounters[i] != 1) {
+            cout << "(no response)" << endl;
+            continue;
+        }
+
+        try {
+            outputData(cout, dataType, &data[i * size], size);
+        } catch (SizeException &e) {
+            throwCommandException(e.what());
+        }
+    }
+}
+
+/*****************************************************************************/
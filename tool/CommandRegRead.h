@@ -44,6 +44,10 @@ class CommandRegRead:
 
         string helpString(const string &) const;
         void execute(const StringVector &);
+
+    protected:
+        void readBatch(MasterDevice &, const SlaveList &, const DataType *,
+                uint16_t, size_t);
 };
 
 /****************************************************************************/
@@ -27,8 +27,12 @@
  *
  ****************************************************************************/
 
+#include <string.h>
+
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <vector>
 using namespace std;
 
 #include "CommandSiiRead.h"
@@ -47,11 +51,18 @@ string CommandSiiRead::helpString(const string &binaryBaseName) const
 {
     stringstream str;
 
-    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] [DIRECTORY]" << endl
         << endl
         << getBriefDescription() << endl
         << endl
-        << "This command requires a single slave to be selected." << endl
+        << "Without a DIRECTORY, this command requires a single slave" << endl
+        << "to be selected." << endl
+        << endl
+        << "With a DIRECTORY, the SII contents of all selected slaves" << endl
+        << "are stored there in files named sii<POSITION>.bin. The" << endl
+        << "master serves the contents it read during the bus scan," << endl
+        << "so the bus is not accessed." << endl
         << endl
         << "Without the --verbose option, binary SII contents are" << endl
         << "output." << endl
@@ -84,8 +95,8 @@ void CommandSiiRead::execute(const StringVector &args)
     uint16_t categoryType, categorySize;
     stringstream err;
 
-    if (args.size()) {
-        err << "'" << getName() << "' takes no arguments!";
+    if (args.size() > 1) {
+        err << "'" << getName() << "' takes at most one argument!";
         throwInvalidUsageException(err);
     }
 
@@ -93,6 +104,11 @@ void CommandSiiRead::execute(const StringVector &args)
     m.open(MasterDevice::Read);
     slaves = selectedSlaves(m);
 
+    if (args.size()) {
+        storeImages(m, slaves, args[0]);
+        return;
+    }
+
     if (slaves.size() != 1) {
         throwSingleSlaveRequired(slaves.size());
     }
@@ -180,6 +196,83 @@ void CommandSiiRead::execute(const StringVector &args)
 
 /****************************************************************************/
 
+/** Stores the SII contents of several slaves in a directory.
+ *
+ * All images are fetched with a single ioctl().
+ */
+void CommandSiiRead::storeImages(
+        MasterDevice &m,
+        const SlaveList &slaves,
+        const string &dir
+        )
+{
+    stringstream err;
+    ec_ioctl_slave_sii_batch_t data;
+    vector<ec_ioctl_slave_sii_batch_slave_t> entries(slaves.size());
+    vector<uint16_t> words;
+    SlaveList::const_iterator si;
+    unsigned int i;
+
+    if (slaves.empty()) {
+        return;
+    }
+
+    memset(&data, 0, sizeof(data));
+
+    for (si = slaves.begin(), i = 0; si != slaves.end(); si++, i++) {
+        memset(&entries[i], 0, sizeof(entries[i]));
+        entries[i].slave_position = si->position;
+        data.data_nwords += si->sii_nwords;
+    }
+
+    data.slave_count = entries.size();
+    data.slaves = &entries[0];
+
+    // retry once, if an image changed since the slaves were listed
+    for (i = 0; i < 2; i++) {
+        words.resize(data.data_nwords ? data.data_nwords : 1);
+        data.nwords = words.size();
+        data.words = &words[0];
+        m.readSiiBatch(&data);
+        if (data.data_nwords <= data.nwords) {
+            break;
+        }
+    }
+
+    if (data.data_nwords > data.nwords) {
+        err << "SII contents changed while reading!";
+        throwCommandException(err);
+    }
+
+    for (i = 0; i < entries.size(); i++) {
+        stringstream path;
+        ofstream file;
+
+        path << dir << "/sii" << entries[i].slave_position << ".bin";
+        file.open(path.str().c_str(), ofstream::out | ofstream::binary);
+        if (file.fail()) {
+            err << "Failed to open '" << path.str() << "'!";
+            throwCommandException(err);
+        }
+
+        file.write((const char *) (&words[0] + entries[i].word_offset),
+                entries[i].nwords * 2);
+        file.close();
+        if (file.fail()) {
+            err << "Failed to write '" << path.str() << "'!";
+            throwCommandException(err);
+        }
+
+        if (getVerbosity() == Verbose) {
+            cerr << "Slave " << entries[i].slave_position << ": "
+                << entries[i].nwords << " words stored in "
+                << path.str() << endl;
+        }
+    }
+}
+
+/****************************************************************************/
+
 const CommandSiiRead::CategoryName CommandSiiRead::categoryNames[] = {
     {0x000a, "STRINGS"},
     {0x0014, "DataTypes"},
@@ -44,6 +44,8 @@ class CommandSiiRead:
         void execute(const StringVector &);
 
     protected:
+        void storeImages(MasterDevice &, const SlaveList &, const string &);
+
         struct CategoryName {
             uint16_t type;
             const char *name;
@@ -27,9 +27,12 @@
  *
  ****************************************************************************/
 
+#include <string.h>
+
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <vector>
 using namespace std;
 
 #include "CommandSiiWrite.h"
@@ -54,7 +57,9 @@ string CommandSiiWrite::helpString(const string &binaryBaseName) const
         << endl
         << getBriefDescription() << endl
         << endl
-        << "This command requires a single slave to be selected." << endl
+        << "If several slaves are selected, the contents are written" << endl
+        << "to all of them in parallel. The master reads the written" << endl
+        << "words back and compares them." << endl
         << endl
         << "The file contents are checked for validity and integrity." << endl
         << "These checks can be overridden with the --force option." << endl
@@ -119,26 +124,77 @@ void CommandSiiWrite::execute(const StringVector &args)
     }
 
     slaves = selectedSlaves(m);
-    if (slaves.size() != 1) {
+    if (slaves.empty()) {
         delete [] data.words;
         throwSingleSlaveRequired(slaves.size());
     }
-    data.slave_position = slaves.front().position;
 
     // send data to master
     data.offset = 0;
     try {
-        m.writeSii(&data);
-    } catch (MasterDeviceException &e) {
+        writeBatch(m, slaves, &data);
+    } catch (...) {
         delete [] data.words;
-        throw e;
+        throw;
+    }
+
+    delete [] data.words;
+}
+
+/*****************************************************************************/
+
+/** Writes the SII contents to all slaves in parallel.
+ *
+ * Every slave's words are read back and compared by the master.
+ */
+void CommandSiiWrite::writeBatch(
+        MasterDevice &m,
+        const SlaveList &slaves,
+        const ec_ioctl_slave_sii_t *data
+        )
+{
+    stringstream err;
+    ec_ioctl_slave_sii_batch_t batch;
+    vector<ec_ioctl_slave_sii_batch_slave_t> entries(slaves.size());
+    SlaveList::const_iterator si;
+    unsigned int i, failed = 0;
+
+    for (si = slaves.begin(), i = 0; si != slaves.end(); si++, i++) {
+        memset(&entries[i], 0, sizeof(entries[i]));
+        entries[i].slave_position = si->position;
+    }
+
+    memset(&batch, 0, sizeof(batch));
+    batch.slave_count = entries.size();
+    batch.slaves = &entries[0];
+    batch.offset = data->offset;
+    batch.verify = 1;
+    batch.nwords = data->nwords;
+    batch.words = data->words;
+
+    m.writeSiiBatch(&batch);
+
+    for (i = 0; i < entries.size(); i++) {
+        if (entries[i].state == EC_REQUEST_SUCCESS) {
+            continue;
+        }
+
+        cerr << "Slave " << entries[i].slave_position << ": "
+            << (entries[i].verify_error ?
+                    "SII verification failed." : "Failed to write SII.")
+            << endl;
+        failed++;
+    }
+
+    if (failed) {
+        err << "SII writing failed for " << failed << " of "
+            << entries.size() << " slaves!";
+        throwCommandException(err);
     }
 
     if (getVerbosity() == Verbose) {
         cerr << "SII writing finished." << endl;
     }
-
-    delete [] data.words;
 }
 
 /*****************************************************************************/
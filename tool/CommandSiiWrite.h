@@ -46,6 +46,8 @@ class CommandSiiWrite:
     protected:
         void loadSiiData(ec_ioctl_slave_sii_t *, const istream &);
         void checkSiiData(const ec_ioctl_slave_sii_t *data);
+        void writeBatch(MasterDevice &, const SlaveList &,
+                const ec_ioctl_slave_sii_t *);
 };
 
 /****************************************************************************/
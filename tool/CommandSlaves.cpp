@@ -74,7 +74,10 @@ string CommandSlaves::helpString(const string &binaryBaseName) const
         << "\\- Absolute ring position in the bus." << endl
         << endl
         << "If the --verbose option is given, a detailed (multi-line)" << endl
-        << "description is output for each slave." << endl
+        << "description is output for each slave. It contains the" << endl
+        << "port error counters, if the master's error counter" << endl
+        << "monitor is enabled (module parameter" << endl
+        << "error_monitor_interval)." << endl
         << endl
         << "Slave selection:" << endl
         << "  Slaves for this and other commands can be selected with" << endl
@@ -125,6 +128,7 @@ void CommandSlaves::execute(const StringVector &args)
             mi != masterIndices.end(); mi++) {
         MasterDevice m(*mi);
         m.open(MasterDevice::Read);
+        m.loadSlaveSnapshot();
         slaves = selectedSlaves(m);
 
         if (getVerbosity() == Verbose) {
@@ -288,6 +292,12 @@ void CommandSlaves::showSlaves(
             }
             cout << "  DC system time transmission delay: "
                 << dec << si->transmission_delay << " ns" << endl;
+            if (si->dc_diff_samples) {
+                cout << "  DC system time difference: " << si->dc_diff
+                    << " ns (max. " << si->dc_diff_max << " ns, drift "
+                    << si->dc_drift << " ns/s, " << si->dc_diff_samples
+                    << " samples)" << endl;
+            }
         } else {
             cout << "no" << endl;
         }
@@ -355,6 +365,44 @@ void CommandSlaves::showSlaves(
             cout << endl;
         }
 
+        if (si->error_samples) {
+            cout << "Error counters (" << dec << si->error_samples
+                << " samples):" << endl
+                << "Port  Invalid  RxError  FwdRxError  LostLink"
+                << "     Total  Rate [1/s]" << endl;
+
+            for (i = 0; i < EC_MAX_PORTS; i++) {
+                if (si->ports[i].desc == EC_PORT_NOT_IMPLEMENTED
+                        || si->ports[i].desc == EC_PORT_NOT_CONFIGURED) {
+                    continue;
+                }
+
+                cout << "   " << i << "  " << setfill(' ') << right
+                    << setw(7) << (unsigned int) si->ports[i].invalid_frames
+                    << "  " << setw(7)
+                    << (unsigned int) si->ports[i].rx_errors
+                    << "  " << setw(10)
+                    << (unsigned int) si->ports[i].forwarded_rx_errors
+                    << "  " << setw(8)
+                    << (unsigned int) si->ports[i].lost_links
+                    << "  " << setw(8) << si->ports[i].error_total
+                    << "  " << setw(10);
+                if (si->error_interval) {
+                    cout << fixed << setprecision(2)
+                        << si->ports[i].error_delta * 1000.0
+                        / si->error_interval;
+                } else {
+                    cout << "-";
+                }
+                cout << endl;
+            }
+
+            cout << "  Processing unit errors: "
+                << (unsigned int) si->processing_unit_errors
+                << ", PDI errors: " << (unsigned int) si->pdi_errors
+                << endl;
+        }
+
         if (si->mailbox_protocols) {
             list<string> protoList;
             list<string>::const_iterator protoIter;
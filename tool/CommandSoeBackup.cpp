@@ -0,0 +1,262 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandSoeBackup.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** IDN-list of all backup operation data.
+ */
+#define IDN_BACKUP_LIST 192
+
+/** Data size to try first for every IDN.
+ */
+#define DEFAULT_DATA_SIZE 1024
+
+/** Maximum data size of an IDN (list with 4 bytes of length information).
+ */
+#define MAX_DATA_SIZE (0xffff + 4)
+
+/*****************************************************************************/
+
+CommandSoeBackup::CommandSoeBackup():
+    Command("soe_backup", "Save the SoE parameters of a drive.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandSoeBackup::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] [<DRIVE> [<IDN> ...]]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "This command requires a single slave to be selected." << endl
+        << endl
+        << "All IDNs are read in one go, which is much faster than" << endl
+        << "reading them one by one with the 'soe_read' command." << endl
+        << "One line is written to stdout for every IDN, containing" << endl
+        << "the drive number, the IDN and the data as hex bytes. The" << endl
+        << "output can be restored with the 'soe_restore' command." << endl
+        << "IDNs that can not be read are reported on stderr." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  DRIVE    is the drive number (0 - 7). If omitted, 0 is assumed."
+        << endl
+        << "  IDN      is an IDN to save (see the 'soe_read' command). If"
+        << endl
+        << "           no IDNs are given, the IDNs listed in S-0-0192"
+        << endl
+        << "           (backup operation data) are saved." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of" << endl
+        << "                         the 'slaves' command." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandSoeBackup::execute(const StringVector &args)
+{
+    SlaveList slaves;
+    stringstream err;
+    uint8_t drive_no = 0;
+    vector<uint16_t> idns;
+    vector<ec_soe_idn_transfer_t> transfers;
+    vector<uint8_t> data;
+    ec_ioctl_slave_soe_idns_t io;
+    unsigned int i, failed = 0;
+
+    if (args.size() >= 1) {
+        stringstream str;
+        unsigned int number;
+        str << args[0];
+        str
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> number;
+        if (str.fail() || number > 7) {
+            err << "Invalid drive number '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+        drive_no = number;
+    }
+
+    for (i = 1; i < args.size(); i++) {
+        try {
+            idns.push_back(parseIdn(args[i]));
+        } catch (runtime_error &e) {
+            err << "Invalid IDN '" << args[i] << "': " << e.what();
+            throwInvalidUsageException(err);
+        }
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    slaves = selectedSlaves(m);
+    if (slaves.size() != 1) {
+        throwSingleSlaveRequired(slaves.size());
+    }
+    io.slave_position = slaves.front().position;
+
+    if (idns.empty()) {
+        ec_ioctl_slave_soe_read_t read;
+        size_t list_size;
+
+        data.resize(MAX_DATA_SIZE);
+        read.slave_position = io.slave_position;
+        read.drive_no = drive_no;
+        read.idn = IDN_BACKUP_LIST;
+        read.mem_size = data.size();
+        read.data = &data[0];
+
+        try {
+            m.readSoe(&read);
+        } catch (MasterDeviceSoeException &e) {
+            err << "Failed to read the list of backup IDNs: "
+                << errorMsg(e.errorCode);
+            throwCommandException(err);
+        }
+
+        if (read.data_size < 4) {
+            err << "Invalid list of backup IDNs!";
+            throwCommandException(err);
+        }
+
+        // list: current length, maximum length, and 16 bit IDNs
+        list_size = EC_READ_U16(&data[0]);
+        if (list_size > read.data_size - 4) {
+            list_size = read.data_size - 4;
+        }
+        for (i = 0; i + 1 < list_size; i += 2) {
+            idns.push_back(EC_READ_U16(&data[4 + i]));
+        }
+
+        if (idns.empty()) {
+            err << "The list of backup IDNs is empty!";
+            throwCommandException(err);
+        }
+    }
+
+    transfers.resize(idns.size());
+    data.resize(idns.size() * DEFAULT_DATA_SIZE);
+    for (i = 0; i < idns.size(); i++) {
+        transfers[i].drive_no = drive_no;
+        transfers[i].idn = idns[i];
+        transfers[i].data = &data[i * DEFAULT_DATA_SIZE];
+        transfers[i].size = DEFAULT_DATA_SIZE;
+    }
+
+    io.count = transfers.size();
+    io.transfers = &transfers[0];
+    m.readSoeIdns(&io);
+
+    // read the IDNs, that did not fit, again, with the maximum size
+    for (i = 0; i < transfers.size(); i++) {
+        ec_soe_idn_transfer_t *transfer = &transfers[i];
+
+        if (transfer->result != -EOVERFLOW) {
+            continue;
+        }
+
+        vector<uint8_t> big(MAX_DATA_SIZE);
+        transfer->data = &big[0];
+        transfer->size = big.size();
+        io.count = 1;
+        io.transfers = transfer;
+        m.readSoeIdns(&io);
+        transfer->data = &data[i * DEFAULT_DATA_SIZE];
+
+        if (transfer->result) {
+            continue;
+        }
+
+        output(transfer, &big[0]);
+        transfer->result = 1; // already written
+    }
+
+    for (i = 0; i < transfers.size(); i++) {
+        const ec_soe_idn_transfer_t *transfer = &transfers[i];
+
+        if (transfer->result > 0) {
+            continue;
+        }
+
+        if (transfer->result) {
+            cerr << "Failed to read " << outputIdn(transfer->idn);
+            if (transfer->error_code) {
+                cerr << ": " << errorMsg(transfer->error_code);
+            }
+            cerr << endl;
+            failed++;
+            continue;
+        }
+
+        output(transfer, transfer->data);
+    }
+
+    if (getVerbosity() == Verbose) {
+        cerr << "Saved " << transfers.size() - failed << " of "
+            << transfers.size() << " IDNs." << endl;
+    }
+}
+
+/****************************************************************************/
+
+void CommandSoeBackup::output(
+        const ec_soe_idn_transfer_t *transfer,
+        const uint8_t *data
+        )
+{
+    size_t i;
+
+    cout << (unsigned int) transfer->drive_no << " "
+        << outputIdn(transfer->idn);
+
+    cout << hex << setfill('0');
+    for (i = 0; i < transfer->result_size; i++) {
+        cout << " " << setw(2) << (unsigned int) data[i];
+    }
+    cout << dec << endl;
+}
+
+/*****************************************************************************/
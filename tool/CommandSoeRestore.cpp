@@ -0,0 +1,223 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string.h>
+using namespace std;
+
+#include "CommandSoeRestore.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandSoeRestore::CommandSoeRestore():
+    Command("soe_restore", "Restore the SoE parameters of a drive.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandSoeRestore::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] <FILENAME>" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "This command requires a single slave to be selected." << endl
+        << endl
+        << "All IDNs are written in one go, in the order of the file."
+        << endl
+        << "Most drives accept parameters only in the parameterization"
+        << endl
+        << "phase (CP2), so the drive may have to be switched there" << endl
+        << "first. IDNs that can not be written are reported." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  FILENAME must be a path to a file in the format written" << endl
+        << "           by the 'soe_backup' command. Empty lines and lines"
+        << endl
+        << "           starting with '#' are ignored. If it is '-'," << endl
+        << "           data are read from stdin." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --alias    -a <alias>" << endl
+        << "  --position -p <pos>    Slave selection. See the help of" << endl
+        << "                         the 'slaves' command." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandSoeRestore::execute(const StringVector &args)
+{
+    SlaveList slaves;
+    stringstream err;
+    vector<ec_soe_idn_transfer_t> transfers;
+    vector<uint8_t> data;
+    ec_ioctl_slave_soe_idns_t io;
+    ifstream file;
+    size_t offset = 0;
+    unsigned int i, failed;
+
+    if (args.size() != 1) {
+        err << "'" << getName() << "' takes exactly one argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args[0] == "-") {
+        loadIdns(transfers, data, cin);
+    } else {
+        file.open(args[0].c_str(), ifstream::in);
+        if (file.fail()) {
+            err << "Failed to open '" << args[0] << "'!";
+            throwCommandException(err);
+        }
+        loadIdns(transfers, data, file);
+        file.close();
+    }
+
+    if (transfers.empty()) {
+        err << "The file contains no IDNs!";
+        throwCommandException(err);
+    }
+
+    for (i = 0; i < transfers.size(); i++) {
+        transfers[i].data = transfers[i].size ? &data[offset] : NULL;
+        offset += transfers[i].size;
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::ReadWrite);
+    slaves = selectedSlaves(m);
+    if (slaves.size() != 1) {
+        throwSingleSlaveRequired(slaves.size());
+    }
+
+    io.slave_position = slaves.front().position;
+    io.count = transfers.size();
+    io.transfers = &transfers[0];
+    failed = m.writeSoeIdns(&io);
+
+    for (i = 0; i < transfers.size(); i++) {
+        const ec_soe_idn_transfer_t *transfer = &transfers[i];
+
+        if (!transfer->result) {
+            continue;
+        }
+
+        cerr << "Failed to write " << outputIdn(transfer->idn);
+        if (transfer->error_code) {
+            cerr << ": " << errorMsg(transfer->error_code);
+        }
+        cerr << endl;
+    }
+
+    if (failed) {
+        err << "Failed to write " << failed << " of " << transfers.size()
+            << " IDNs!";
+        throwCommandException(err);
+    }
+
+    if (getVerbosity() == Verbose) {
+        cerr << "Restored " << transfers.size() << " IDNs." << endl;
+    }
+}
+
+/*****************************************************************************/
+
+void CommandSoeRestore::loadIdns(
+        vector<ec_soe_idn_transfer_t> &transfers,
+        vector<uint8_t> &data,
+        istream &in
+        )
+{
+    string line;
+    unsigned int lineNumber = 0;
+    stringstream err;
+
+    while (getline(in, line)) {
+        stringstream str(line);
+        ec_soe_idn_transfer_t transfer;
+        unsigned int number;
+        string word;
+
+        lineNumber++;
+
+        if (!(str >> word) || word[0] == '#') {
+            continue;
+        }
+
+        stringstream drive(word);
+        drive >> resetiosflags(ios::basefield) >> number;
+        if (drive.fail() || number > 7) {
+            err << "Invalid drive number in line " << lineNumber << "!";
+            throwCommandException(err);
+        }
+
+        memset(&transfer, 0, sizeof(transfer));
+        transfer.drive_no = number;
+
+        if (!(str >> word)) {
+            err << "Missing IDN in line " << lineNumber << "!";
+            throwCommandException(err);
+        }
+
+        try {
+            transfer.idn = parseIdn(word);
+        } catch (runtime_error &e) {
+            err << "Invalid IDN '" << word << "' in line " << lineNumber
+                << ": " << e.what();
+            throwCommandException(err);
+        }
+
+        while (str >> word) {
+            stringstream byte(word);
+            byte >> hex >> number;
+            if (byte.fail() || word.size() > 2) {
+                err << "Invalid data byte '" << word << "' in line "
+                    << lineNumber << "!";
+                throwCommandException(err);
+            }
+            data.push_back(number);
+            transfer.size++;
+        }
+
+        transfers.push_back(transfer);
+    }
+}
+
+/*****************************************************************************/
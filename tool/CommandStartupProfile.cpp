@@ -0,0 +1,322 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+using namespace std;
+
+#include "CommandStartupProfile.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Number of events fetched with one ioctl() call.
+ */
+#define EVENT_CHUNK 256
+
+/** Number of slaves shown in the list of the slowest slaves.
+ */
+#define SLOWEST_SLAVES 10
+
+/*****************************************************************************/
+
+CommandStartupProfile::CommandStartupProfile():
+    Command("startup-profile", "Show the startup timeline.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandStartupProfile::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << binaryBaseName << " " << getName() << " reset" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "From loading the master module on, the master records the"
+        << endl
+        << "duration of the following phases:" << endl
+        << endl
+        << "  bus scan  Scan of the whole bus." << endl
+        << "  activate  Activation by the application." << endl
+        << "  scan      Slave scan: Addressing and registers." << endl
+        << "  sii       Slave scan: Reading the SII." << endl
+        << "  mailbox   Slave scan: PDO assignment via CoE." << endl
+        << "  init      Configuration: INIT and clearing." << endl
+        << "  preop     Configuration: Mailbox setup and PREOP." << endl
+        << "  sdo       Configuration: SDO and SoE configuration." << endl
+        << "  pdo       Configuration: PDOs, watchdog and FMMUs." << endl
+        << "  dc        Configuration: Distributed clocks." << endl
+        << "  safeop    Configuration: SAFEOP." << endl
+        << "  op        Configuration: OP." << endl
+        << endl
+        << "The summary lists the number of runs of each phase, how many"
+        << endl
+        << "of them failed, and the slowest slaves. Repeated runs of a"
+        << endl
+        << "phase are retries after a failure or an abort. With the"
+        << endl
+        << "'reset' argument, the recorded events are discarded and the"
+        << endl
+        << "timeline restarts." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master  -m <index>  Master index. Default: 0." << endl
+        << "  --verbose -v          Show every event of the timeline."
+        << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandStartupProfile::execute(const StringVector &args)
+{
+    bool reset = false;
+    ec_ioctl_startup_profile_t data;
+    ec_ioctl_startup_event_t chunk[EVENT_CHUNK];
+    EventVector events;
+
+    if (args.size() > 1) {
+        stringstream err;
+        err << "'" << getName() << "' takes either no or 'reset' argument!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size() == 1) {
+        string arg = args[0];
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+        if (arg != "reset") {
+            stringstream err;
+            err << "'" << getName()
+                << "' takes either no or 'reset' argument!";
+            throwInvalidUsageException(err);
+        }
+
+        reset = true;
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(reset ? MasterDevice::ReadWrite : MasterDevice::Read);
+
+    if (reset) {
+        m.resetStartupProfile();
+        return;
+    }
+
+    data.offset = 0;
+    do {
+        data.max_events = EVENT_CHUNK;
+        data.events = chunk;
+        m.getStartupProfile(&data);
+
+        if (data.offset >= data.event_count) {
+            break;
+        }
+
+        unsigned int count = min(data.event_count - data.offset,
+                (uint32_t) EVENT_CHUNK);
+        events.insert(events.end(), chunk, chunk + count);
+        data.offset += count;
+    } while (data.offset < data.event_count);
+
+    if (getVerbosity() == Verbose) {
+        showTimeline(events);
+        cout << endl;
+    }
+
+    showSummary(events);
+
+    if (data.lost) {
+        cout << endl << data.lost
+            << " events were not recorded, because the profile is full."
+            << endl;
+    }
+}
+
+/****************************************************************************/
+
+string CommandStartupProfile::phaseName(uint8_t phase)
+{
+    static const char *names[] = {
+        "bus scan",
+        "activate",
+        "scan",
+        "sii",
+        "mailbox",
+        "init",
+        "preop",
+        "sdo",
+        "pdo",
+        "dc",
+        "safeop",
+        "op"
+    };
+
+    if (phase < sizeof(names) / sizeof(names[0])) {
+        return names[phase];
+    }
+
+    stringstream str;
+    str << "phase " << (unsigned int) phase;
+    return str.str();
+}
+
+/****************************************************************************/
+
+string CommandStartupProfile::slaveName(uint16_t position)
+{
+    if (position == EC_STARTUP_MASTER) {
+        return "master";
+    }
+
+    stringstream str;
+    str << position;
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandStartupProfile::showTimeline(const EventVector &events)
+{
+    EventVector::const_iterator ev;
+
+    cout << "Start [ms]  Duration [ms]  Slave   Phase" << endl;
+
+    for (ev = events.begin(); ev != events.end(); ev++) {
+        cout << fixed << setprecision(3)
+            << setw(10) << ev->start / 1e6 << "  "
+            << setw(13) << ev->duration / 1e3 << "  "
+            << left << setw(6) << slaveName(ev->slave_position) << "  "
+            << setw(8) << phaseName(ev->phase) << right;
+        if (ev->flags & EC_STARTUP_FAILED) {
+            cout << "  failed";
+        }
+        cout << endl;
+    }
+}
+
+/****************************************************************************/
+
+void CommandStartupProfile::showSummary(const EventVector &events)
+{
+    struct PhaseInfo {
+        unsigned int count;
+        unsigned int failed;
+        uint64_t total;
+        uint32_t max;
+        uint16_t slowest;
+    } phases[EC_STARTUP_PHASE_COUNT] = {};
+    typedef map<uint16_t, uint64_t> SlaveMap;
+    SlaveMap slaves;
+    vector<pair<uint64_t, uint16_t> > ranking;
+    EventVector::const_iterator ev;
+    SlaveMap::const_iterator si;
+    uint64_t last_op = 0;
+    unsigned int i;
+
+    for (ev = events.begin(); ev != events.end(); ev++) {
+        if (ev->phase >= EC_STARTUP_PHASE_COUNT) {
+            continue;
+        }
+
+        PhaseInfo &info = phases[ev->phase];
+        info.count++;
+        if (ev->flags & EC_STARTUP_FAILED) {
+            info.failed++;
+        }
+        info.total += ev->duration;
+        if (info.count == 1 || ev->duration > info.max) {
+            info.max = ev->duration;
+            info.slowest = ev->slave_position;
+        }
+
+        if (ev->slave_position != EC_STARTUP_MASTER) {
+            slaves[ev->slave_position] += ev->duration;
+        }
+
+        if (ev->phase == EC_STARTUP_OP
+                && !(ev->flags & EC_STARTUP_FAILED)) {
+            uint64_t end = ev->start + ev->duration * 1000ULL;
+            last_op = max(last_op, end);
+        }
+    }
+
+    cout << "Phase     Runs  Failed  Total [ms]    Max [ms]  Slowest"
+        << endl;
+
+    for (i = 0; i < EC_STARTUP_PHASE_COUNT; i++) {
+        const PhaseInfo &info = phases[i];
+
+        if (!info.count) {
+            continue;
+        }
+
+        cout << left << setw(8) << phaseName(i) << right
+            << setw(6) << info.count
+            << setw(8) << info.failed
+            << fixed << setprecision(3)
+            << setw(12) << info.total / 1e3
+            << setw(12) << info.max / 1e3
+            << "  " << slaveName(info.slowest) << endl;
+    }
+
+    if (last_op) {
+        cout << endl << "Last slave in OP after " << fixed << setprecision(3)
+            << last_op / 1e6 << " ms." << endl;
+    }
+
+    if (slaves.empty()) {
+        return;
+    }
+
+    for (si = slaves.begin(); si != slaves.end(); si++) {
+        ranking.push_back(make_pair(si->second, si->first));
+    }
+    sort(ranking.rbegin(), ranking.rend());
+
+    cout << endl << "Slowest slaves:" << endl
+        << "Slave  Total [ms]" << endl;
+
+    for (i = 0; i < ranking.size() && i < SLOWEST_SLAVES; i++) {
+        cout << left << setw(5) << ranking[i].second << right
+            << fixed << setprecision(3)
+            << setw(12) << ranking[i].first / 1e3 << endl;
+    }
+}
+
+/*****************************************************************************/
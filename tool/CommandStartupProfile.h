@@ -0,0 +1,59 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#ifndef __COMMANDSTARTUPPROFILE_H__
+#define __COMMANDSTARTUPPROFILE_H__
+
+#include <vector>
+
+#include "Command.h"
+
+/****************************************************************************/
+
+class CommandStartupProfile:
+    public Command
+{
+    public:
+        CommandStartupProfile();
+
+        string helpString(const string &) const;
+        void execute(const StringVector &);
+
+    protected:
+        typedef vector<ec_ioctl_startup_event_t> EventVector;
+
+        static string phaseName(uint8_t);
+        static string slaveName(uint16_t);
+        static void showTimeline(const EventVector &);
+        static void showSummary(const EventVector &);
+};
+
+/****************************************************************************/
+
+#endif
@@ -0,0 +1,468 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#include <signal.h>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+#include "CommandTop.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+static volatile sig_atomic_t monitoring;
+
+static void stopMonitor(int)
+{
+    monitoring = 0;
+}
+
+/*****************************************************************************/
+
+CommandTop::CommandTop():
+    Command("top", "Monitor bus and cycle health continuously.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandTop::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] [<interval> [<count>]]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "Every <interval> seconds (default 1), the following is"
+        << endl
+        << "displayed until the command is interrupted, or <count>"
+        << endl
+        << "updates were shown:" << endl
+        << endl
+        << "  - Link states, frame rates and frame loss." << endl
+        << "  - Send cycles per second and frames per cycle." << endl
+        << "  - Latencies of ecrt_master_send() and" << endl
+        << "    ecrt_master_receive() in the last interval." << endl
+        << "  - DC deviations in the last interval." << endl
+        << "  - Working counter state and cycle rate of every domain."
+        << endl
+        << "  - Throughput of the EoE handlers." << endl
+        << "  - AL states of all slaves." << endl
+        << endl
+        << "All values are collected with a single ioctl() per update,"
+        << endl
+        << "which never waits for the master. If the master is busy,"
+        << endl
+        << "the previous domains, EoE handlers and slave states are"
+        << endl
+        << "shown and marked as stale." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --master -m <index>  Master index. Default: 0." << endl
+        << endl
+        << numericInfo();
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandTop::execute(const StringVector &args)
+{
+    double interval = 1.0;
+    unsigned int count = 0, updates = 0;
+    Sample samples[2];
+    unsigned int current = 0;
+    struct timespec wakeup;
+    long period;
+    bool terminal = isatty(STDOUT_FILENO);
+
+    if (args.size() > 2) {
+        stringstream err;
+        err << "'" << getName() << "' takes at most two arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    if (args.size() > 0) {
+        stringstream str;
+        str << args[0];
+        str >> interval;
+        if (str.fail() || !str.eof() || interval < 0.01) {
+            stringstream err;
+            err << "Invalid interval '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    if (args.size() > 1) {
+        stringstream str;
+        str << args[1];
+        str >> count;
+        if (str.fail() || !str.eof() || !count) {
+            stringstream err;
+            err << "Invalid count '" << args[1] << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+
+    // the first sample only serves as a reference for the rates
+    samples[1].topologyStale = true;
+    poll(m, samples[0], samples[1]);
+    period = (long) (interval * 1e9);
+
+    monitoring = 1;
+    signal(SIGINT, stopMonitor);
+    signal(SIGTERM, stopMonitor);
+    signal(SIGPIPE, stopMonitor);
+
+    wakeup = samples[0].time;
+
+    while (monitoring) {
+        wakeup.tv_nsec += period % 1000000000L;
+        wakeup.tv_sec += period / 1000000000L;
+        while (wakeup.tv_nsec >= 1000000000L) {
+            wakeup.tv_nsec -= 1000000000L;
+            wakeup.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+        if (!monitoring) {
+            break;
+        }
+
+        poll(m, samples[!current], samples[current]);
+        current = !current;
+
+        show(m.getIndex(), samples[current], samples[!current], terminal);
+        if (!cout.good() || (count && ++updates >= count)) {
+            break;
+        }
+    }
+}
+
+/****************************************************************************/
+
+/** Polls the monitor data.
+ *
+ * The arrays are sized by the previous sample. If the topology could not be
+ * read, it is taken over from the previous sample.
+ */
+void CommandTop::poll(
+        MasterDevice &m,
+        Sample &sample,
+        const Sample &previous
+        )
+{
+    ec_ioctl_monitor_t &data = sample.data;
+
+    sample.slaveStates.resize(previous.slaveStates.size());
+    sample.domains.resize(previous.domains.size());
+    sample.eoeHandlers.resize(previous.eoeHandlers.size());
+
+    while (1) {
+        data.slave_states =
+            sample.slaveStates.empty() ? NULL : &sample.slaveStates[0];
+        data.slave_capacity = sample.slaveStates.size();
+        data.domains = sample.domains.empty() ? NULL : &sample.domains[0];
+        data.domain_capacity = sample.domains.size();
+        data.eoe_handlers =
+            sample.eoeHandlers.empty() ? NULL : &sample.eoeHandlers[0];
+        data.eoe_capacity = sample.eoeHandlers.size();
+
+        m.getMonitor(&data);
+        clock_gettime(CLOCK_MONOTONIC, &sample.time);
+
+        if (!data.topology_valid
+                || (data.slave_count == data.slave_capacity
+                    && data.domain_count == data.domain_capacity
+                    && data.eoe_handler_count == data.eoe_capacity)) {
+            break;
+        }
+
+        // the bus or the configuration changed: retry
+        sample.slaveStates.resize(data.slave_count);
+        sample.domains.resize(data.domain_count);
+        sample.eoeHandlers.resize(data.eoe_handler_count);
+    }
+
+    sample.topologyStale = !data.topology_valid;
+    if (sample.topologyStale) {
+        sample.slaveStates = previous.slaveStates;
+        sample.domains = previous.domains;
+        sample.eoeHandlers = previous.eoeHandlers;
+    }
+}
+
+/****************************************************************************/
+
+void CommandTop::show(
+        unsigned int masterIndex,
+        const Sample &sample,
+        const Sample &previous,
+        bool terminal
+        )
+{
+    const ec_ioctl_monitor_t &data = sample.data;
+    double seconds = (sample.time.tv_sec - previous.time.tv_sec)
+        + (sample.time.tv_nsec - previous.time.tv_nsec) / 1e9;
+    unsigned int i, j;
+
+    if (seconds <= 0.0) {
+        seconds = 1.0;
+    }
+
+    if (terminal) {
+        cout << "\033[H\033[2J"; // home and clear screen
+    } else {
+        cout << endl;
+    }
+
+    cout << "Master" << masterIndex << "  Phase: ";
+    switch (data.phase) {
+        case 0:  cout << "Waiting for device(s)..."; break;
+        case 1:  cout << "Idle"; break;
+        case 2:  cout << "Operation"; break;
+        default: cout << "???";
+    }
+    cout << "  Active: " << (data.active ? "yes" : "no") << endl;
+
+    for (i = EC_DEVICE_MAIN; i < data.num_devices; i++) {
+        cout << "  " << (i == EC_DEVICE_MAIN ? "Main:  " : "Backup:")
+            << " link " << (data.devices[i].link_state ? "UP  " : "DOWN")
+            << "  Tx " << setw(7) << data.devices[i].tx_frame_rate
+            << " frames/s  Rx " << setw(7) << data.devices[i].rx_frame_rate
+            << " frames/s  Tx errors " << data.devices[i].tx_errors
+            << endl;
+    }
+
+    cout << "  Frames: Tx " << data.tx_frame_rate
+        << "/s  Rx " << data.rx_frame_rate
+        << "/s  Lost " << data.loss_rate << "/s"
+        << "  (total Tx " << data.tx_count
+        << ", lost " << data.tx_count - data.rx_count << ")" << endl;
+
+    cout << "  Cycles: " << fixed << setprecision(1)
+        << (data.cycles - previous.data.cycles) / seconds << "/s"
+        << "  Frames/cycle " << data.frames
+        << " (max " << data.frames_max << ")"
+        << "  FSM " << data.fsm_exec_time
+        << " ns (max " << data.fsm_exec_time_max << " ns)" << endl;
+
+    cout << endl << "Latency        Samples     Mean    P99 <      Max"
+        << endl;
+    showLatency("  Send", data.send, previous.data.send);
+    showLatency("  Receive", data.receive, previous.data.receive);
+
+    cout << endl << "DC             Samples     Mean    P99 <      Max"
+        << endl;
+    showDc("  Sync monitor", data.sync_monitor,
+            previous.data.sync_monitor);
+    showDc("  Ref. offset", data.ref_offset, previous.data.ref_offset);
+
+    cout << endl << "Domains" << (sample.topologyStale ? " (stale)" : "")
+        << endl;
+    for (i = 0; i < sample.domains.size(); i++) {
+        const ec_ioctl_monitor_domain_t &domain = sample.domains[i];
+        uint32_t cycles = 0;
+
+        for (j = 0; j < previous.domains.size(); j++) {
+            if (previous.domains[j].index == domain.index) {
+                cycles = domain.process_count
+                    - previous.domains[j].process_count;
+                break;
+            }
+        }
+
+        cout << "  Domain" << domain.index << ": WC "
+            << domain.working_counter << "/"
+            << domain.expected_working_counter << " ";
+        if (!domain.working_counter) {
+            cout << "ZERO      ";
+        } else if (domain.working_counter ==
+                domain.expected_working_counter) {
+            cout << "COMPLETE  ";
+        } else {
+            cout << "INCOMPLETE";
+        }
+        cout << (domain.redundancy_active ? "  redundancy active" : "")
+            << "  " << fixed << setprecision(1) << cycles / seconds
+            << " cycles/s" << endl;
+    }
+
+    if (!sample.eoeHandlers.empty()) {
+        cout << endl << "EoE" << (sample.topologyStale ? " (stale)" : "")
+            << endl;
+        for (i = 0; i < sample.eoeHandlers.size(); i++) {
+            const ec_ioctl_monitor_eoe_t &eoe = sample.eoeHandlers[i];
+
+            cout << "  " << setw(12) << left << eoe.name << right << " ";
+            if (eoe.slave_position == 0xffff) {
+                cout << "     -";
+            } else {
+                cout << setw(6) << eoe.slave_position;
+            }
+            cout << "  " << (eoe.open ? "up  " : "down")
+                << "  Rx " << rateString(eoe.rx_rate)
+                << "  Tx " << rateString(eoe.tx_rate)
+                << "  Dropped " << eoe.tx_dropped << endl;
+        }
+    }
+
+    cout << endl << "Slaves" << (sample.topologyStale ? " (stale)" : "")
+        << endl;
+    for (i = 0; i < sample.slaveStates.size(); i++) {
+        cout << (i % 6 ? "" : " ")
+            << " " << setw(4) << i << " "
+            << setw(12) << left << alStateString(sample.slaveStates[i])
+            << right;
+        if (i % 6 == 5 || i + 1 == sample.slaveStates.size()) {
+            cout << endl;
+        }
+    }
+
+    cout.flush();
+}
+
+/****************************************************************************/
+
+/** Displays the statistics of a latency histogram in the last interval.
+ */
+void CommandTop::showLatency(
+        const char *title,
+        const ec_ioctl_latency_histogram_t &hist,
+        const ec_ioctl_latency_histogram_t &previous
+        )
+{
+    uint64_t count = hist.count, sum = hist.sum, acc = 0;
+    unsigned int i;
+
+    if (count >= previous.count) { // otherwise reset meanwhile
+        count -= previous.count;
+        sum -= previous.sum;
+    }
+
+    cout << setw(12) << left << title << right << setw(10) << count;
+    if (!count) {
+        cout << endl;
+        return;
+    }
+
+    for (i = 0; i < EC_IOCTL_LATENCY_HISTOGRAM_BINS - 1; i++) {
+        uint32_t bin = hist.bins[i];
+        if (hist.count >= previous.count) {
+            bin -= previous.bins[i];
+        }
+        acc += bin;
+        if (acc * 100 >= count * 99) {
+            break;
+        }
+    }
+
+    cout << setw(9) << sum / count;
+    if (i < EC_IOCTL_LATENCY_HISTOGRAM_BINS - 1) {
+        cout << setw(9) << (1U << (i + 6));
+    } else {
+        cout << setw(9) << "-";
+    }
+    cout << setw(9) << hist.max << " ns" << endl;
+}
+
+/****************************************************************************/
+
+/** Displays the statistics of a DC histogram in the last interval.
+ *
+ * The percentile is based on the absolute deviations.
+ */
+void CommandTop::showDc(
+        const char *title,
+        const ec_ioctl_dc_histogram_t &hist,
+        const ec_ioctl_dc_histogram_t &previous
+        )
+{
+    uint64_t count = hist.count, acc = 0;
+    int64_t sum = hist.sum;
+    unsigned int i;
+
+    if (count >= previous.count) { // otherwise reset meanwhile
+        count -= previous.count;
+        sum -= previous.sum;
+    }
+
+    cout << setw(14) << left << title << right << setw(8) << count;
+    if (!count) {
+        cout << endl;
+        return;
+    }
+
+    for (i = 0; i < EC_IOCTL_DC_HISTOGRAM_BINS - 1; i++) {
+        uint32_t bin = hist.bins[i];
+        if (hist.count >= previous.count) {
+            bin -= previous.bins[i];
+        }
+        acc += bin;
+        if (acc * 100 >= count * 99) {
+            break;
+        }
+    }
+
+    cout << setw(9) << sum / (int64_t) count;
+    if (i < EC_IOCTL_DC_HISTOGRAM_BINS - 1) {
+        cout << setw(9) << (1U << (i + 6));
+    } else {
+        cout << setw(9) << "-";
+    }
+    cout << setw(9) << max(-hist.min, hist.max) << " ns" << endl;
+}
+
+/****************************************************************************/
+
+string CommandTop::rateString(double rate)
+{
+    stringstream str;
+
+    str << fixed << setprecision(1);
+    if (rate >= 1e6) {
+        str << setw(6) << rate / 1e6 << " MB/s";
+    } else if (rate >= 1e3) {
+        str << setw(6) << rate / 1e3 << " kB/s";
+    } else {
+        str << setw(6) << rate << "  B/s";
+    }
+
+    return str.str();
+}
+
+/*****************************************************************************/
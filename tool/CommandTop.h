@@ -0,0 +1,72 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+#ifndef __COMMANDTOP_H__
+#define __COMMANDTOP_H__
+
+#include <time.h>
+
+#include "Command.h"
+
+/****************************************************************************/
+
+class CommandTop:
+    public Command
+{
+    public:
+        CommandTop();
+
+        string helpString(const string &) const;
+        void execute(const StringVector &);
+
+    protected:
+        /** Result of a single poll. */
+        struct Sample {
+            ec_ioctl_monitor_t data;
+            struct timespec time;
+            bool topologyStale;
+            vector<uint8_t> slaveStates;
+            vector<ec_ioctl_monitor_domain_t> domains;
+            vector<ec_ioctl_monitor_eoe_t> eoeHandlers;
+        };
+
+        static void poll(MasterDevice &, Sample &, const Sample &);
+        static void show(unsigned int, const Sample &, const Sample &,
+                bool);
+        static void showLatency(const char *,
+                const ec_ioctl_latency_histogram_t &,
+                const ec_ioctl_latency_histogram_t &);
+        static void showDc(const char *, const ec_ioctl_dc_histogram_t &,
+                const ec_ioctl_dc_histogram_t &);
+        static string rateString(double);
+};
+
+/****************************************************************************/
+
+#endif
@@ -49,10 +49,23 @@ string CommandUpload::helpString(const string &binaryBaseName) const
 
     str << binaryBaseName << " " << getName()
         << " [OPTIONS] <INDEX> <SUBINDEX>" << endl
+        << binaryBaseName << " " << getName()
+        << " [OPTIONS] <INDEX>" << endl
+        << binaryBaseName << " " << getName()
+        << " [OPTIONS] <INDEX>:<SUBINDEX> [...]" << endl
         << endl
         << getBriefDescription() << endl
         << endl
-        << "This command requires a single slave to be selected." << endl
+        << "The first two calls require a single slave to be selected."
+        << endl
+        << endl
+        << "The third call reads multiple entries from all selected" << endl
+        << "slaves. The slaves are accessed concurrently, and each" << endl
+        << "value is output as soon as it is read, preceded by the" << endl
+        << "slave position and the entry. Example:" << endl
+        << endl
+        << "  " << binaryBaseName << " " << getName()
+        << " -p 0-49 0x6064:00 0x606C:00" << endl
         << endl
         << "The data type of the SDO entry is taken from the SDO" << endl
         << "dictionary by default. It can be overridden with the" << endl
@@ -60,6 +73,13 @@ string CommandUpload::helpString(const string &binaryBaseName) const
         << "information service or the SDO is not in the dictionary," << endl
         << "the --type option is mandatory."  << endl
         << endl
+        << "The second call (without <SUBINDEX>) uses the complete" << endl
+        << "access method and reads all subindices at once. The" << endl
+        << "data are output as octet_string, unless --type is given." << endl
+        << "With a fixed-size type, subindex 0 is skipped and the" << endl
+        << "remaining data are output as an array of that type. Use" << endl
+        << "'binary' to output the data unformatted." << endl
+        << endl
         << typeInfo()
         << endl
         << "Arguments:" << endl
@@ -88,11 +108,32 @@ void CommandUpload::execute(const StringVector &args)
     ec_ioctl_slave_sdo_upload_t data;
     const DataType *dataType = NULL;
     unsigned int uval;
+    size_t offset;
+
+    if (args.size() && isSdoAddress(args[0])) {
+        StringVector::const_iterator ai;
 
-    if (args.size() != 2) {
-        err << "'" << getName() << "' takes two arguments!";
+        addresses.clear();
+        for (ai = args.begin(); ai != args.end(); ai++) {
+            addresses.push_back(parseSdoAddress(*ai));
+        }
+
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::Read);
+        slaves = selectedSlaves(m);
+        if (slaves.empty()) {
+            err << "No slaves selected!";
+            throwCommandException(err);
+        }
+        transferConcurrently(m, slaves);
+        return;
+    }
+
+    if (args.size() != 1 && args.size() != 2) {
+        err << "'" << getName() << "' takes 1 or 2 arguments!";
         throwInvalidUsageException(err);
     }
+    data.complete_access = args.size() == 1;
 
     strIndex << args[0];
     strIndex
@@ -103,15 +144,19 @@ void CommandUpload::execute(const StringVector &args)
         throwInvalidUsageException(err);
     }
 
-    strSubIndex << args[1];
-    strSubIndex
-        >> resetiosflags(ios::basefield) // guess base from prefix
-        >> uval;
-    if (strSubIndex.fail() || uval > 0xff) {
-        err << "Invalid SDO subindex '" << args[1] << "'!";
-        throwInvalidUsageException(err);
+    if (data.complete_access) {
+        data.sdo_entry_subindex = 0;
+    } else {
+        strSubIndex << args[1];
+        strSubIndex
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> uval;
+        if (strSubIndex.fail() || uval > 0xff) {
+            err << "Invalid SDO subindex '" << args[1] << "'!";
+            throwInvalidUsageException(err);
+        }
+        data.sdo_entry_subindex = uval;
     }
-    data.sdo_entry_subindex = uval;
 
     MasterDevice m(getSingleMasterIndex());
     m.open(MasterDevice::Read);
@@ -126,6 +171,8 @@ void CommandUpload::execute(const StringVector &args)
             err << "Invalid data type '" << getDataType() << "'!";
             throwInvalidUsageException(err);
         }
+    } else if (data.complete_access) { // whole SDO: output raw data
+        dataType = findDataType("octet_string");
     } else { // no data type specified: fetch from dictionary
         ec_ioctl_slave_sdo_entry_t entry;
 
@@ -145,7 +192,7 @@ void CommandUpload::execute(const StringVector &args)
         }
     }
 
-    if (dataType->byteSize) {
+    if (dataType->byteSize && !data.complete_access) {
         data.target_size = dataType->byteSize;
     } else {
         data.target_size = DefaultBufferSize;
@@ -168,8 +215,14 @@ void CommandUpload::execute(const StringVector &args)
 
     m.close();
 
+    // complete access with a fixed-size type: output the array elements
+    // behind subindex 0, which is padded to 16 bit
+    offset = data.complete_access && dataType->byteSize
+        && data.data_size >= 2 ? 2 : 0;
+
     try {
-        outputData(cout, dataType, data.target, data.data_size);
+        outputData(cout, dataType, data.target + offset,
+                data.data_size - offset);
     } catch (SizeException &e) {
         delete [] data.target;
         throwCommandException(e.what());
@@ -179,3 +232,56 @@ void CommandUpload::execute(const StringVector &args)
 }
 
 /*****************************************************************************/
+
+void CommandUpload::transferSlave(
+        MasterDevice &m,
+        const ec_ioctl_slave_t &slave
+        )
+{
+    vector<SdoAddress>::const_iterator ai;
+
+    for (ai = addresses.begin(); ai != addresses.end(); ai++) {
+        ec_ioctl_slave_sdo_upload_t data;
+        const DataType *dataType;
+        stringstream result;
+
+        data.slave_position = slave.position;
+        data.sdo_index = ai->index;
+        data.sdo_entry_subindex = ai->subindex;
+        data.complete_access = 0;
+        data.target = NULL;
+
+        try {
+            dataType = entryDataType(m, slave.position, *ai);
+
+            if (dataType->byteSize) {
+                data.target_size = dataType->byteSize;
+            } else {
+                data.target_size = DefaultBufferSize;
+            }
+            data.target = new uint8_t[data.target_size + 1];
+
+            m.sdoUpload(&data);
+            outputData(result, dataType, data.target, data.data_size);
+            printResult(slave, *ai, result.str());
+        } catch (MasterDeviceSdoAbortException &e) {
+            stringstream err;
+            err << "SDO transfer aborted with code 0x"
+                << setfill('0') << hex << setw(8) << e.abortCode
+                << ": " << abortText(e.abortCode);
+            printError(slave, *ai, err.str());
+        } catch (MasterDeviceException &e) {
+            printError(slave, *ai, e.what());
+        } catch (CommandException &e) {
+            printError(slave, *ai, e.what());
+        } catch (InvalidUsageException &e) {
+            printError(slave, *ai, e.what());
+        } catch (SizeException &e) {
+            printError(slave, *ai, e.what());
+        }
+
+        delete [] data.target;
+    }
+}
+
+/*****************************************************************************/
@@ -45,6 +45,10 @@ class CommandUpload:
 
     protected:
         enum {DefaultBufferSize = 64 * 1024};
+
+        vector<SdoAddress> addresses; /**< Multi-object mode entries. */
+
+        void transferSlave(MasterDevice &, const ec_ioctl_slave_t &);
 };
 
 /****************************************************************************/
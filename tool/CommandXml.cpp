@@ -82,6 +82,7 @@ void CommandXml::execute(const StringVector &args)
 
     MasterDevice m(getSingleMasterIndex());
     m.open(MasterDevice::Read);
+    m.loadSlaveSnapshot();
     slaves = selectedSlaves(m);
 
     cout << "<?xml version=\"1.0\" ?>" << endl;
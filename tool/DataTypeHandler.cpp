@@ -33,6 +33,8 @@
 #include <iostream>
 #endif
 
+#include <stdio.h>
+#include <string.h>
 #include <iomanip>
 #include <sstream>
 using namespace std;
@@ -77,7 +79,10 @@ string DataTypeHandler::typeInfo()
 		<< "  float, double," << endl
 		<< "  string, octet_string, unicode_string." << endl
         << "For sign-and-magnitude coding, use the following types:" << endl
-        << "  sm8, sm16, sm32, sm64" << endl;
+        << "  sm8, sm16, sm32, sm64" << endl
+        << "Data of a multiple of the type size are output as an" << endl
+        << "array, one element per line. The 'binary' type outputs" << endl
+        << "the data unformatted, e. g. for piping into other tools." << endl;
 	return s.str();
 }
 
@@ -185,6 +190,7 @@ size_t DataTypeHandler::interpretAsType(
         case 0x0009: // string
         case 0x000a: // octet_string
         case 0x000b: // unicode_string
+        case 0xfffa: // binary
             dataSize = str.str().size();
             if (dataSize > targetSize) {
                 stringstream err;
@@ -273,7 +279,7 @@ void DataTypeHandler::outputData(
     uint16_t typeCode;
 
     if (type) {
-        if (type->byteSize && dataSize != type->byteSize) {
+        if (type->byteSize && (!dataSize || dataSize % type->byteSize)) {
             stringstream err;
             err << "Data type mismatch. Expected " << type->name
                 << " with " << type->byteSize << " byte, but got "
@@ -285,138 +291,192 @@ void DataTypeHandler::outputData(
         typeCode = 0xffff; // raw data
     }
 
-    o << setfill('0');
+    if (type && type->byteSize) {
+        outputArray(o, type, (const uint8_t *) data,
+                dataSize / type->byteSize);
+        return;
+    }
 
     switch (typeCode) {
-        case 0x0001: // bool
-            {
-                int val = (int) *(int8_t *) data;
-                o << "0x" << hex << setw(2) << val
-                    << " " << dec << val << endl;
-            }
+        case 0x0009: // string
+            o << string((const char *) data, dataSize) << endl;
             break;
+        case 0x000a: // octet_string
+            o << string((const char *) data, dataSize) << flush;
+            break;
+        case 0x000b: // unicode_string
+			// FIXME encoding
+            o << string((const char *) data, dataSize) << endl;
+            break;
+        case 0xfffa: // binary
+            o.write((const char *) data, dataSize);
+            o.flush();
+            break;
+
+        default:
+            printRawData(o, (const uint8_t *) data, dataSize); // FIXME
+            break;
+    }
+}
+
+/****************************************************************************/
+
+/** Outputs an array of a fixed-size data type, one element per line.
+ *
+ * The elements are formatted into a single buffer, which is written at
+ * once, so that large arrays do not pay the iostream formatting per value.
+ */
+void DataTypeHandler::outputArray(
+        ostream &o,
+        const DataType *type,
+        const uint8_t *data,
+        size_t count
+        )
+{
+    string buffer;
+    char line[64];
+    size_t i;
+    int len;
+
+    buffer.reserve(count * 32);
+
+    for (i = 0; i < count; i++) {
+        len = formatElement(line, sizeof(line), type->code,
+                data + i * type->byteSize);
+        if (len < 0) { // no native type
+            printRawData(o, data, count * type->byteSize);
+            return;
+        }
+        buffer.append(line, len);
+    }
+
+    o.write(buffer.data(), buffer.size());
+}
+
+/****************************************************************************/
+
+/** Formats a single value of a fixed-size data type, followed by a newline.
+ *
+ * \return Length of the formatted string, or -1 if the data type has no
+ *         native representation.
+ */
+int DataTypeHandler::formatElement(
+        char *buf,
+        size_t size,
+        uint16_t typeCode,
+        const uint8_t *data
+        )
+{
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+    int len;
+
+    switch (typeCode) {
+        case 0x0001: // bool
         case 0x0002: // int8
             {
-                int val = (int) *(int8_t *) data;
-                o << "0x" << hex << setw(2) << val
-                    << " " << dec << val << endl;
+                int val = (int8_t) data[0];
+                len = snprintf(buf, size, "0x%02x %d\n", val, val);
             }
             break;
         case 0x0003: // int16
-            {
-                int16_t val = le16_to_cpup(data);
-                o << "0x" << hex << setw(4) << val
-                    << " " << dec << val << endl;
-            }
+            memcpy(&u16, data, 2);
+            u16 = le16_to_cpu(u16);
+            len = snprintf(buf, size, "0x%04x %d\n",
+                    u16, (int) (int16_t) u16);
             break;
         case 0x0004: // int32
-            {
-                int32_t val = le32_to_cpup(data);
-                o << "0x" << hex << setw(8) << val
-                    << " " << dec << val << endl;
-            }
+            memcpy(&u32, data, 4);
+            u32 = le32_to_cpu(u32);
+            len = snprintf(buf, size, "0x%08x %d\n", u32, (int32_t) u32);
             break;
         case 0x0005: // uint8
-            {
-                unsigned int val = (unsigned int) *(uint8_t *) data;
-                o << "0x" << hex << setw(2) << val
-                    << " " << dec << val << endl;
-            }
+            len = snprintf(buf, size, "0x%02x %u\n", data[0], data[0]);
             break;
         case 0x0006: // uint16
-            {
-                uint16_t val = le16_to_cpup(data);
-                o << "0x" << hex << setw(4) << val
-                    << " " << dec << val << endl;
-            }
+            memcpy(&u16, data, 2);
+            u16 = le16_to_cpu(u16);
+            len = snprintf(buf, size, "0x%04x %u\n", u16, u16);
             break;
         case 0x0007: // uint32
-            {
-                uint32_t val = le32_to_cpup(data);
-                o << "0x" << hex << setw(8) << val
-                    << " " << dec << val << endl;
-            }
+            memcpy(&u32, data, 4);
+            u32 = le32_to_cpu(u32);
+            len = snprintf(buf, size, "0x%08x %u\n", u32, u32);
             break;
         case 0x0008: // float
             {
-                uint32_t val = le32_to_cpup(data);
-				float fval = *(float *) (void *) &val;
-                o << fval << endl;
+                float fval;
+                memcpy(&u32, data, 4);
+                u32 = le32_to_cpu(u32);
+                memcpy(&fval, &u32, 4);
+                len = snprintf(buf, size, "%g\n", fval);
             }
             break;
-        case 0x0009: // string
-            o << string((const char *) data, dataSize) << endl;
-            break;
-        case 0x000a: // octet_string
-            o << string((const char *) data, dataSize) << flush;
-            break;
-        case 0x000b: // unicode_string
-			// FIXME encoding
-            o << string((const char *) data, dataSize) << endl;
-            break;
         case 0x0011: // double
             {
-                uint64_t val = le64_to_cpup(data);
-				double fval = *(double *) (void *) &val;
-                o << fval << endl;
+                double fval;
+                memcpy(&u64, data, 8);
+                u64 = le64_to_cpu(u64);
+                memcpy(&fval, &u64, 8);
+                len = snprintf(buf, size, "%g\n", fval);
             }
             break;
         case 0x0015: // int64
-            {
-                int64_t val = le64_to_cpup(data);
-                o << "0x" << hex << setw(16) << val
-                    << " " << dec << val << endl;
-            }
+            memcpy(&u64, data, 8);
+            u64 = le64_to_cpu(u64);
+            len = snprintf(buf, size, "0x%016llx %lld\n",
+                    (unsigned long long) u64, (long long) (int64_t) u64);
             break;
         case 0x001b: // uint64
-            {
-                uint64_t val = le64_to_cpup(data);
-                o << "0x" << hex << setw(16) << val
-                    << " " << dec << val << endl;
-            }
+            memcpy(&u64, data, 8);
+            u64 = le64_to_cpu(u64);
+            len = snprintf(buf, size, "0x%016llx %llu\n",
+                    (unsigned long long) u64, (unsigned long long) u64);
             break;
         case 0xfffb: // sm8
             {
-                int8_t val = *(uint8_t *) data;
+                int8_t val = data[0];
                 int8_t smval = val < 0 ? (val & 0x7f) * -1 : val;
-
-                o << "0x" << hex << setw(2) << (int) val
-                    << " " << dec << (int) smval << endl;
+                len = snprintf(buf, size, "0x%02x %d\n",
+                        (int) val, (int) smval);
             }
             break;
         case 0xfffc: // sm16
             {
-                int16_t val = le16_to_cpup(data);
-                int16_t smval = val < 0 ? (val & 0x7fff) * -1 : val;
-
-                o << "0x" << hex << setw(4) << val
-                    << " " << dec << smval << endl;
+                int16_t val, smval;
+                memcpy(&u16, data, 2);
+                val = le16_to_cpu(u16);
+                smval = val < 0 ? (val & 0x7fff) * -1 : val;
+                len = snprintf(buf, size, "0x%04x %d\n",
+                        (uint16_t) val, (int) smval);
             }
             break;
         case 0xfffd: // sm32
             {
-                int32_t val = le32_to_cpup(data);
-                int32_t smval = val < 0 ? (val & 0x7fffffffUL) * -1 : val;
-
-                o << "0x" << hex << setw(8) << val
-                    << " " << dec << smval << endl;
+                int32_t val, smval;
+                memcpy(&u32, data, 4);
+                val = le32_to_cpu(u32);
+                smval = val < 0 ? (val & 0x7fffffffUL) * -1 : val;
+                len = snprintf(buf, size, "0x%08x %d\n",
+                        (uint32_t) val, smval);
             }
             break;
         case 0xfffe: // sm64
             {
-                int64_t val = le64_to_cpup(data);
-                int64_t smval =
-                    val < 0 ? (val & 0x7fffffffffffffffULL) * -1 : val;
-
-                o << "0x" << hex << setw(16) << val
-                    << " " << dec << smval << endl;
+                int64_t val, smval;
+                memcpy(&u64, data, 8);
+                val = le64_to_cpu(u64);
+                smval = val < 0 ? (val & 0x7fffffffffffffffULL) * -1 : val;
+                len = snprintf(buf, size, "0x%016llx %lld\n",
+                        (unsigned long long) val, (long long) smval);
             }
             break;
-
         default:
-            printRawData(o, (const uint8_t *) data, dataSize); // FIXME
-            break;
+            return -1;
     }
+
+    return len < (int) size ? len : (int) size - 1;
 }
 
 /****************************************************************************/
@@ -468,6 +528,7 @@ const DataTypeHandler::DataType DataTypeHandler::dataTypes[] = {
     {"sm16",           0xfffc, 2}, // sign-and-magnitude coding
     {"sm32",           0xfffd, 4}, // sign-and-magnitude coding
     {"sm64",           0xfffe, 8}, // sign-and-magnitude coding
+    {"binary",         0xfffa, 0}, // unformatted bytes
     {"raw",            0xffff, 0},
     {}
 };
@@ -68,6 +68,10 @@ class DataTypeHandler
 
         static void outputData(std::ostream &, const DataType *,
                 void *, size_t);
+        static void outputArray(std::ostream &, const DataType *,
+                const uint8_t *, size_t);
+        static int formatElement(char *, size_t, uint16_t,
+                const uint8_t *);
         static void printRawData(ostream &, const uint8_t *, size_t);
 
     private:
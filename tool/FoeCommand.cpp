@@ -32,6 +32,10 @@
 
 /*****************************************************************************/
 
+const unsigned int FoeCommand::windowSize = 0x10000;
+
+/*****************************************************************************/
+
 FoeCommand::FoeCommand(const string &name, const string &briefDesc):
     Command(name, briefDesc)
 {
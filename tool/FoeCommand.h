@@ -41,6 +41,10 @@ class FoeCommand:
         FoeCommand(const string &, const string &);
 
     protected:
+        static const unsigned int windowSize; /**< Size of the kernel
+                                                window for streamed
+                                                transfers. */
+
         static std::string resultText(int);
         static std::string errorText(int);
 };
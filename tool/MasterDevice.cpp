@@ -31,21 +31,48 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <pthread.h>
+
 #include <sstream>
 #include <iomanip>
+#include <map>
 using namespace std;
 
 #include "MasterDevice.h"
 
 /****************************************************************************/
 
+bool MasterDevice::shareDevices = false;
+
+/** Shared open device.
+ */
+struct SharedDevice {
+    int fd;
+    unsigned int masterCount;
+};
+
+/** Shared devices by master index and permissions.
+ */
+typedef map<pair<unsigned int, int>, SharedDevice> SharedDeviceMap;
+
+static SharedDeviceMap sharedDevices;
+static pthread_mutex_t sharedDevicesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************/
+
 MasterDevice::MasterDevice(unsigned int index):
     index(index),
     masterCount(0U),
-    fd(-1)
+    fd(-1),
+    shared(false),
+    mappedMem(NULL),
+    mappedSize(0),
+    mappedStateOffset(0),
+    snapshotLoaded(false)
 {
 }
 
@@ -71,25 +98,63 @@ void MasterDevice::open(Permissions perm)
 
     if (fd == -1) { // not already open
         ec_ioctl_module_t module_data;
+        pair<unsigned int, int> key(index, perm);
+
+        if (shareDevices) {
+            pthread_mutex_lock(&sharedDevicesMutex);
+            SharedDeviceMap::const_iterator si = sharedDevices.find(key);
+            if (si != sharedDevices.end()) {
+                fd = si->second.fd;
+                masterCount = si->second.masterCount;
+                shared = true;
+                pthread_mutex_unlock(&sharedDevicesMutex);
+                return;
+            }
+        }
+
         deviceName << "/dev/EtherCAT" << index;
 
         if ((fd = ::open(deviceName.str().c_str(),
                         perm == ReadWrite ? O_RDWR : O_RDONLY)) == -1) {
             stringstream err;
+            if (shareDevices) {
+                pthread_mutex_unlock(&sharedDevicesMutex);
+            }
             err << "Failed to open master device " << deviceName.str() << ": "
                 << strerror(errno);
             throw MasterDeviceException(err);
         }
 
-        getModule(&module_data);
+        try {
+            getModule(&module_data);
+        } catch (MasterDeviceException &e) {
+            if (shareDevices) {
+                pthread_mutex_unlock(&sharedDevicesMutex);
+            }
+            close();
+            throw e;
+        }
         if (module_data.ioctl_version_magic != EC_IOCTL_VERSION_MAGIC) {
             stringstream err;
+            if (shareDevices) {
+                pthread_mutex_unlock(&sharedDevicesMutex);
+            }
+            close();
             err << "ioctl() version magic is differing: "
                 << deviceName.str() << ": " << module_data.ioctl_version_magic
                 << ", ethercat tool: " << EC_IOCTL_VERSION_MAGIC;
             throw MasterDeviceException(err);
         }
         masterCount = module_data.master_count;
+
+        if (shareDevices) {
+            SharedDevice dev;
+            dev.fd = fd;
+            dev.masterCount = masterCount;
+            sharedDevices[key] = dev;
+            shared = true;
+            pthread_mutex_unlock(&sharedDevicesMutex);
+        }
     }
 }
 
@@ -97,10 +162,51 @@ void MasterDevice::open(Permissions perm)
 
 void MasterDevice::close()
 {
+    if (mappedMem) {
+        munmap(mappedMem, mappedSize);
+        mappedMem = NULL;
+        mappedSize = 0;
+    }
+
     if (fd != -1) {
-        ::close(fd);
+        if (!shared) {
+            ::close(fd);
+        }
         fd = -1;
+        shared = false;
+    }
+
+    snapshotLoaded = false;
+    snapshot.clear();
+}
+
+/****************************************************************************/
+
+/** Enables or disables sharing of the open devices.
+ *
+ * If enabled, each master device is opened only once per permission and
+ * kept open for all following MasterDevice objects until closeShared() is
+ * called.
+ */
+void MasterDevice::setShared(bool enable)
+{
+    shareDevices = enable;
+}
+
+/****************************************************************************/
+
+/** Closes all shared devices.
+ */
+void MasterDevice::closeShared()
+{
+    SharedDeviceMap::iterator si;
+
+    pthread_mutex_lock(&sharedDevicesMutex);
+    for (si = sharedDevices.begin(); si != sharedDevices.end(); si++) {
+        ::close(si->second.fd);
     }
+    sharedDevices.clear();
+    pthread_mutex_unlock(&sharedDevicesMutex);
 }
 
 /****************************************************************************/
@@ -251,8 +357,141 @@ void MasterDevice::getData(ec_ioctl_domain_data_t *data,
 
 /****************************************************************************/
 
+/** Maps the process data and the state page of the application read-only.
+ *
+ * \return Address of the mapping, or NULL, if no application activated the
+ *         master.
+ */
+const uint8_t *MasterDevice::mapReadOnly(size_t *stateOffset)
+{
+    ec_ioctl_map_read_only_t data;
+    void *mem;
+
+    if (!mappedMem) {
+        if (ioctl(fd, EC_IOCTL_MAP_READ_ONLY, &data) < 0) {
+            if (errno == ENXIO) {
+                return NULL;
+            }
+            stringstream err;
+            err << "Failed to map process data: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+
+        mem = mmap(0, data.mmap_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED) {
+            stringstream err;
+            err << "Failed to map process data: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+
+        mappedMem = mem;
+        mappedSize = data.mmap_size;
+        mappedStateOffset = data.state_offset;
+    }
+
+    *stateOffset = mappedStateOffset;
+    return (const uint8_t *) mappedMem;
+}
+
+/****************************************************************************/
+
+/** Fetches all slaves with their sync managers, PDOs and PDO entries with a
+ * single ioctl().
+ *
+ * Subsequent calls of getSlave(), getSync(), getPdo() and getPdoEntry() are
+ * answered from the snapshot until the device is closed.
+ */
+void MasterDevice::loadSlaveSnapshot()
+{
+    ec_ioctl_slave_snapshot_t data;
+    vector<uint8_t> buffer;
+
+    data.buffer = NULL;
+    data.buffer_size = 0;
+
+    while (1) {
+        if (ioctl(fd, EC_IOCTL_SLAVE_SNAPSHOT, &data) < 0) {
+            stringstream err;
+            err << "Failed to get slave snapshot: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+
+        if (data.data_size <= data.buffer_size) {
+            break;
+        }
+
+        // the bus may have changed in the meantime: retry
+        buffer.resize(data.data_size);
+        data.buffer = &buffer[0];
+        data.buffer_size = buffer.size();
+    }
+
+    buffer.resize(data.data_size);
+    parseSlaveSnapshot(buffer);
+}
+
+/****************************************************************************/
+
+void MasterDevice::parseSlaveSnapshot(const vector<uint8_t> &buffer)
+{
+    size_t offset = 0;
+
+    snapshot.clear();
+
+#define SNAPSHOT_READ(RECORD) \
+    do { \
+        if (offset + sizeof(RECORD) > buffer.size()) { \
+            snapshot.clear(); \
+            throw MasterDeviceException("Slave snapshot corrupted!"); \
+        } \
+        memcpy(&(RECORD), &buffer[offset], sizeof(RECORD)); \
+        offset += sizeof(RECORD); \
+    } while (0)
+
+    while (offset < buffer.size()) {
+        SnapshotSlave slave;
+        SNAPSHOT_READ(slave.slave);
+
+        slave.syncs.resize(slave.slave.sync_count);
+        for (unsigned int i = 0; i < slave.syncs.size(); i++) {
+            SnapshotSync &sync = slave.syncs[i];
+            SNAPSHOT_READ(sync.sync);
+
+            sync.pdos.resize(sync.sync.pdo_count);
+            for (unsigned int j = 0; j < sync.pdos.size(); j++) {
+                SnapshotPdo &pdo = sync.pdos[j];
+                SNAPSHOT_READ(pdo.pdo);
+
+                pdo.entries.resize(pdo.pdo.entry_count);
+                for (unsigned int k = 0; k < pdo.entries.size(); k++) {
+                    SNAPSHOT_READ(pdo.entries[k]);
+                }
+            }
+        }
+
+        snapshot.push_back(slave);
+    }
+
+#undef SNAPSHOT_READ
+
+    snapshotLoaded = true;
+}
+
+/****************************************************************************/
+
 void MasterDevice::getSlave(ec_ioctl_slave_t *slave, uint16_t slaveIndex)
 {
+    if (snapshotLoaded) {
+        if (slaveIndex >= snapshot.size()) {
+            stringstream err;
+            err << "Failed to get slave: Slave " << slaveIndex
+                << " does not exist!";
+            throw MasterDeviceException(err);
+        }
+        *slave = snapshot[slaveIndex].slave;
+        return;
+    }
+
     slave->position = slaveIndex;
 
     if (ioctl(fd, EC_IOCTL_SLAVE, slave)) {
@@ -292,6 +531,16 @@ void MasterDevice::getSync(
         uint8_t syncIndex
         )
 {
+    if (snapshotLoaded) {
+        if (slaveIndex >= snapshot.size()
+                || syncIndex >= snapshot[slaveIndex].syncs.size()) {
+            throw MasterDeviceException("Failed to get sync manager: "
+                    "Sync manager does not exist!");
+        }
+        *sync = snapshot[slaveIndex].syncs[syncIndex].sync;
+        return;
+    }
+
     sync->slave_position = slaveIndex;
     sync->sync_index = syncIndex;
 
@@ -311,6 +560,18 @@ void MasterDevice::getPdo(
         uint8_t pdoPos
         )
 {
+    if (snapshotLoaded) {
+        if (slaveIndex >= snapshot.size()
+                || syncIndex >= snapshot[slaveIndex].syncs.size()
+                || pdoPos >= snapshot[slaveIndex].syncs[syncIndex]
+                .pdos.size()) {
+            throw MasterDeviceException("Failed to get PDO: "
+                    "PDO does not exist!");
+        }
+        *pdo = snapshot[slaveIndex].syncs[syncIndex].pdos[pdoPos].pdo;
+        return;
+    }
+
     pdo->slave_position = slaveIndex;
     pdo->sync_index = syncIndex;
     pdo->pdo_pos = pdoPos;
@@ -332,6 +593,21 @@ void MasterDevice::getPdoEntry(
         uint8_t entryPos
         )
 {
+    if (snapshotLoaded) {
+        if (slaveIndex >= snapshot.size()
+                || syncIndex >= snapshot[slaveIndex].syncs.size()
+                || pdoPos >= snapshot[slaveIndex].syncs[syncIndex]
+                .pdos.size()
+                || entryPos >= snapshot[slaveIndex].syncs[syncIndex]
+                .pdos[pdoPos].entries.size()) {
+            throw MasterDeviceException("Failed to get PDO entry: "
+                    "PDO entry does not exist!");
+        }
+        *entry = snapshot[slaveIndex].syncs[syncIndex]
+            .pdos[pdoPos].entries[entryPos];
+        return;
+    }
+
     entry->slave_position = slaveIndex;
     entry->sync_index = syncIndex;
     entry->pdo_pos = pdoPos;
@@ -410,6 +686,45 @@ void MasterDevice::writeSii(
 
 /****************************************************************************/
 
+void MasterDevice::readSiiBatch(
+        ec_ioctl_slave_sii_batch_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_SLAVE_SII_READ_BATCH, data) < 0) {
+        stringstream err;
+        err << "Failed to read SII: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::writeSiiBatch(
+        ec_ioctl_slave_sii_batch_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_SLAVE_SII_WRITE_BATCH, data) < 0) {
+        stringstream err;
+        err << "Failed to write SII: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::importDict(
+        ec_ioctl_dict_import_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_DICT_IMPORT, data) < 0) {
+        stringstream err;
+        err << "Failed to import SDO dictionary: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::readReg(
         ec_ioctl_slave_reg_t *data
         )
@@ -423,6 +738,239 @@ void MasterDevice::readReg(
 
 /****************************************************************************/
 
+void MasterDevice::readRegBatch(
+        ec_ioctl_slave_reg_batch_t *data
+        )
+{
+    if (ioctl(fd, EC_IOCTL_SLAVE_REG_READ_BATCH, data) < 0) {
+        stringstream err;
+        err << "Failed to read registers: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getDcStats(ec_ioctl_dc_stats_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_DC_STATS, data) < 0) {
+        stringstream err;
+        err << "Failed to get DC statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::resetDcStats()
+{
+    if (ioctl(fd, EC_IOCTL_DC_STATS_RESET, 0) < 0) {
+        stringstream err;
+        err << "Failed to reset DC statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::calibrateSync0(uint32_t cycles)
+{
+    if (ioctl(fd, EC_IOCTL_SYNC0_CALIBRATE, &cycles) < 0) {
+        stringstream err;
+        err << "Failed to start SYNC0 calibration: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getLatencyStats(ec_ioctl_latency_stats_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_LATENCY_STATS, data) < 0) {
+        stringstream err;
+        err << "Failed to get latency statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getMonitor(ec_ioctl_monitor_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_MONITOR, data) < 0) {
+        stringstream err;
+        err << "Failed to get monitor data: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getDomainLatencyStats(
+        ec_ioctl_domain_latency_stats_t *data,
+        unsigned int domainIndex
+        )
+{
+    data->domain_index = domainIndex;
+
+    if (ioctl(fd, EC_IOCTL_DOMAIN_LATENCY_STATS, data) < 0) {
+        stringstream err;
+        err << "Failed to get latency statistics of domain "
+            << domainIndex << ": " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::resetLatencyStats()
+{
+    if (ioctl(fd, EC_IOCTL_LATENCY_STATS_RESET, 0) < 0) {
+        stringstream err;
+        err << "Failed to reset latency statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getStartupProfile(ec_ioctl_startup_profile_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_STARTUP_PROFILE, data) < 0) {
+        stringstream err;
+        err << "Failed to get startup profile: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::resetStartupProfile()
+{
+    if (ioctl(fd, EC_IOCTL_STARTUP_PROFILE_RESET, 0) < 0) {
+        stringstream err;
+        err << "Failed to reset startup profile: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::startCapture(ec_ioctl_capture_start_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_CAPTURE_START, data) < 0) {
+        stringstream err;
+        err << "Failed to start capture: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::stopCapture()
+{
+    if (ioctl(fd, EC_IOCTL_CAPTURE_STOP, 0) < 0) {
+        stringstream err;
+        err << "Failed to stop capture: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getCaptureState(
+        ec_ioctl_capture_state_t *data,
+        unsigned int devIdx
+        )
+{
+    data->dev_idx = devIdx;
+
+    if (ioctl(fd, EC_IOCTL_CAPTURE_STATE, data) < 0) {
+        stringstream err;
+        err << "Failed to get capture state: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::readCapture(ec_ioctl_capture_read_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_CAPTURE_READ, data) < 0) {
+        stringstream err;
+        err << "Failed to read captured frames: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getHistoryState(
+        ec_ioctl_domain_history_state_t *data,
+        unsigned int domainIndex
+        )
+{
+    data->domain_index = domainIndex;
+
+    if (ioctl(fd, EC_IOCTL_DOMAIN_HISTORY_STATE, data) < 0) {
+        stringstream err;
+        err << "Failed to get history state of domain " << domainIndex
+            << ": " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::freezeHistory(unsigned int domainIndex, bool freeze)
+{
+    ec_ioctl_domain_history_freeze_t data;
+
+    data.domain_index = domainIndex;
+    data.freeze = freeze;
+
+    if (ioctl(fd, EC_IOCTL_DOMAIN_HISTORY_FREEZE, &data) < 0) {
+        stringstream err;
+        err << "Failed to " << (freeze ? "freeze" : "resume")
+            << " history of domain " << domainIndex << ": ";
+        if (errno == ENODATA)
+            err << "No history enabled!";
+        else
+            err << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::readHistory(ec_ioctl_domain_history_read_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_DOMAIN_HISTORY_READ, data) < 0) {
+        stringstream err;
+        err << "Failed to read history records: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getDatagramStats(
+        ec_ioctl_datagram_stats_t *data,
+        unsigned int position
+        )
+{
+    data->position = position;
+
+    if (ioctl(fd, EC_IOCTL_DATAGRAM_STATS, data) < 0) {
+        stringstream err;
+        err << "Failed to get statistics of datagram " << position
+            << ": " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::writeReg(
         ec_ioctl_slave_reg_t *data
         )
@@ -462,6 +1010,58 @@ void MasterDevice::writeFoe(
 
 /****************************************************************************/
 
+void MasterDevice::startFoeJob(
+        ec_ioctl_foe_job_t *job
+        )
+{
+    if (ioctl(fd, EC_IOCTL_FOE_JOB_START, job) < 0) {
+        stringstream err;
+        err << "Failed to start FoE job: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getFoeJobStatus(
+        ec_ioctl_foe_job_t *job
+        )
+{
+    if (ioctl(fd, EC_IOCTL_FOE_JOB_STATUS, job) < 0) {
+        stringstream err;
+        err << "Failed to get FoE job status: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::startFoeStream(
+        ec_ioctl_foe_stream_t *stream
+        )
+{
+    if (ioctl(fd, EC_IOCTL_FOE_STREAM_START, stream) < 0) {
+        stringstream err;
+        err << "Failed to start FoE transfer: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::transferFoeStream(
+        ec_ioctl_foe_stream_t *stream
+        )
+{
+    if (ioctl(fd, EC_IOCTL_FOE_STREAM_TRANSFER, stream) < 0) {
+        stringstream err;
+        err << "Failed to transfer FoE data: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::setDebug(unsigned int debugLevel)
 {
     if (ioctl(fd, EC_IOCTL_MASTER_DEBUG, debugLevel) < 0) {
@@ -585,4 +1185,58 @@ void MasterDevice::writeSoe(ec_ioctl_slave_soe_write_t *data)
     }
 }
 
+/****************************************************************************/
+
+/** Reads a list of IDNs.
+ *
+ * \return Number of failed transfers. See the transfer results.
+ */
+int MasterDevice::readSoeIdns(ec_ioctl_slave_soe_idns_t *data)
+{
+    unsigned int i;
+    int failed = 0;
+
+    if (ioctl(fd, EC_IOCTL_SLAVE_SOE_READ_IDNS, data) < 0) {
+        if (errno != EIO) {
+            stringstream err;
+            err << "Failed to read IDNs: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+        for (i = 0; i < data->count; i++) {
+            if (data->transfers[i].result) {
+                failed++;
+            }
+        }
+    }
+
+    return failed;
+}
+
+/****************************************************************************/
+
+/** Writes a list of IDNs.
+ *
+ * \return Number of failed transfers. See the transfer results.
+ */
+int MasterDevice::writeSoeIdns(ec_ioctl_slave_soe_idns_t *data)
+{
+    unsigned int i;
+    int failed = 0;
+
+    if (ioctl(fd, EC_IOCTL_SLAVE_SOE_WRITE_IDNS, data) < 0) {
+        if (errno != EIO) {
+            stringstream err;
+            err << "Failed to write IDNs: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+        for (i = 0; i < data->count; i++) {
+            if (data->transfers[i].result) {
+                failed++;
+            }
+        }
+    }
+
+    return failed;
+}
+
 /*****************************************************************************/
@@ -32,6 +32,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 using namespace std;
 
 #include "ecrt.h"
@@ -121,6 +122,8 @@ class MasterDevice
         void getFmmu(ec_ioctl_domain_fmmu_t *, unsigned int, unsigned int);
         void getData(ec_ioctl_domain_data_t *, unsigned int, unsigned int,
                 unsigned char *);
+        const uint8_t *mapReadOnly(size_t *);
+        void loadSlaveSnapshot();
         void getSlave(ec_ioctl_slave_t *, uint16_t);
         void getSync(ec_ioctl_slave_sync_t *, uint16_t, uint8_t);
         void getPdo(ec_ioctl_slave_sync_pdo_t *, uint16_t, uint8_t, uint8_t);
@@ -130,8 +133,30 @@ class MasterDevice
         void getSdoEntry(ec_ioctl_slave_sdo_entry_t *, uint16_t, int, uint8_t);
         void readSii(ec_ioctl_slave_sii_t *);
         void writeSii(ec_ioctl_slave_sii_t *);
+        void readSiiBatch(ec_ioctl_slave_sii_batch_t *);
+        void writeSiiBatch(ec_ioctl_slave_sii_batch_t *);
+        void importDict(ec_ioctl_dict_import_t *);
         void readReg(ec_ioctl_slave_reg_t *);
         void writeReg(ec_ioctl_slave_reg_t *);
+        void readRegBatch(ec_ioctl_slave_reg_batch_t *);
+        void getDcStats(ec_ioctl_dc_stats_t *);
+        void resetDcStats();
+        void calibrateSync0(uint32_t);
+        void getLatencyStats(ec_ioctl_latency_stats_t *);
+        void getDomainLatencyStats(ec_ioctl_domain_latency_stats_t *,
+                unsigned int);
+        void resetLatencyStats();
+        void getStartupProfile(ec_ioctl_startup_profile_t *);
+        void resetStartupProfile();
+        void getMonitor(ec_ioctl_monitor_t *);
+        void startCapture(ec_ioctl_capture_start_t *);
+        void stopCapture();
+        void getCaptureState(ec_ioctl_capture_state_t *, unsigned int);
+        void readCapture(ec_ioctl_capture_read_t *);
+        void getHistoryState(ec_ioctl_domain_history_state_t *, unsigned int);
+        void freezeHistory(unsigned int, bool);
+        void readHistory(ec_ioctl_domain_history_read_t *);
+        void getDatagramStats(ec_ioctl_datagram_stats_t *, unsigned int);
         void setDebug(unsigned int);
         void rescan();
         void sdoDownload(ec_ioctl_slave_sdo_download_t *);
@@ -139,18 +164,60 @@ class MasterDevice
         void requestState(uint16_t, uint8_t);
         void readFoe(ec_ioctl_slave_foe_t *);
         void writeFoe(ec_ioctl_slave_foe_t *);
+        void startFoeJob(ec_ioctl_foe_job_t *);
+        void getFoeJobStatus(ec_ioctl_foe_job_t *);
+        void startFoeStream(ec_ioctl_foe_stream_t *);
+        void transferFoeStream(ec_ioctl_foe_stream_t *);
 #ifdef EC_EOE
         void getEoeHandler(ec_ioctl_eoe_handler_t *, uint16_t);
 #endif
         void readSoe(ec_ioctl_slave_soe_read_t *);
         void writeSoe(ec_ioctl_slave_soe_write_t *);
+        int readSoeIdns(ec_ioctl_slave_soe_idns_t *);
+        int writeSoeIdns(ec_ioctl_slave_soe_idns_t *);
 
         unsigned int getMasterCount() const {return masterCount;}
 
+        static void setShared(bool);
+        static void closeShared();
+
     private:
         unsigned int index;
         unsigned int masterCount;
         int fd;
+        bool shared; /**< \a fd belongs to the shared device table. */
+        void *mappedMem; /**< Read-only mapping of the application's
+                           memory, or NULL. */
+        size_t mappedSize; /**< Size of \a mappedMem. */
+        size_t mappedStateOffset; /**< Offset of the state page in
+                                    \a mappedMem. */
+
+        static bool shareDevices; /**< Keep the devices open and share them
+                                    between all MasterDevice objects. */
+
+        /** PDO with its entries from the slave snapshot. */
+        struct SnapshotPdo {
+            ec_ioctl_slave_sync_pdo_t pdo;
+            vector<ec_ioctl_slave_sync_pdo_entry_t> entries;
+        };
+
+        /** Sync manager with its PDOs from the slave snapshot. */
+        struct SnapshotSync {
+            ec_ioctl_slave_sync_t sync;
+            vector<SnapshotPdo> pdos;
+        };
+
+        /** Slave with its sync managers from the slave snapshot. */
+        struct SnapshotSlave {
+            ec_ioctl_slave_t slave;
+            vector<SnapshotSync> syncs;
+        };
+
+        bool snapshotLoaded; /**< getSlave(), getSync(), getPdo() and
+                               getPdoEntry() are served from \a snapshot. */
+        vector<SnapshotSlave> snapshot; /**< Slave snapshot. */
+
+        void parseSlaveSnapshot(const vector<uint8_t> &);
 };
 
 /****************************************************************************/
@@ -27,13 +27,232 @@
  *
  ****************************************************************************/
 
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
 #include "SdoCommand.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Maximum number of slaves accessed concurrently.
+ */
+#define MAX_TRANSFER_THREADS 64
 
 /*****************************************************************************/
 
 SdoCommand::SdoCommand(const string &name, const string &briefDesc):
-    Command(name, briefDesc)
+    Command(name, briefDesc),
+    failures(0)
+{
+    pthread_mutex_init(&outputMutex, NULL);
+}
+
+/*****************************************************************************/
+
+SdoCommand::~SdoCommand()
+{
+    pthread_mutex_destroy(&outputMutex);
+}
+
+/*****************************************************************************/
+
+/** Returns true, if the argument has the form <INDEX>:<SUBINDEX>.
+ */
+bool SdoCommand::isSdoAddress(const string &arg)
+{
+    return arg.find(':') != string::npos;
+}
+
+/*****************************************************************************/
+
+SdoCommand::SdoAddress SdoCommand::parseSdoAddress(const string &arg) const
+{
+    SdoAddress address;
+    string::size_type colon = arg.find(':');
+    stringstream strIndex, strSubIndex, err;
+    unsigned int index, subindex;
+
+    if (colon != string::npos) {
+        strIndex << arg.substr(0, colon);
+        strIndex
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> index;
+        strSubIndex << arg.substr(colon + 1);
+        strSubIndex
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> subindex;
+    }
+
+    if (colon == string::npos || strIndex.fail() || !strIndex.eof()
+            || index > 0xffff || strSubIndex.fail() || !strSubIndex.eof()
+            || subindex > 0xff) {
+        err << "Invalid SDO entry '" << arg << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    address.index = index;
+    address.subindex = subindex;
+    return address;
+}
+
+/*****************************************************************************/
+
+string SdoCommand::sdoAddressString(const SdoAddress &address)
+{
+    stringstream str;
+
+    str << "0x" << hex << uppercase << setfill('0')
+        << setw(4) << address.index << ":"
+        << setw(2) << (unsigned int) address.subindex;
+    return str.str();
+}
+
+/*****************************************************************************/
+
+/** Returns the data type of an SDO entry.
+ *
+ * The type is taken from the --type option or from the dictionary.
+ */
+const DataTypeHandler::DataType *SdoCommand::entryDataType(
+        MasterDevice &m,
+        uint16_t position,
+        const SdoAddress &address
+        ) const
+{
+    const DataType *dataType;
+    ec_ioctl_slave_sdo_entry_t entry;
+    stringstream err;
+
+    if (!getDataType().empty()) {
+        if (!(dataType = findDataType(getDataType()))) {
+            err << "Invalid data type '" << getDataType() << "'!";
+            throwInvalidUsageException(err);
+        }
+        return dataType;
+    }
+
+    try {
+        m.getSdoEntry(&entry, position, address.index, address.subindex);
+    } catch (MasterDeviceException &e) {
+        err << "Failed to determine SDO entry data type. "
+            << "Please specify --type.";
+        throwCommandException(err);
+    }
+    if (!(dataType = findDataType(entry.data_type))) {
+        err << "PDO entry has unknown data type 0x"
+            << hex << setfill('0') << setw(4) << entry.data_type << "!"
+            << " Please specify --type.";
+        throwCommandException(err);
+    }
+
+    return dataType;
+}
+
+/*****************************************************************************/
+
+/** Calls transferSlave() for all slaves, concurrently for different slaves.
+ *
+ * The kernel processes the requests of different slaves in parallel, so the
+ * duration is determined by the slowest slave.
+ */
+void SdoCommand::transferConcurrently(
+        MasterDevice &m,
+        const SlaveList &slaves
+        )
+{
+    SlaveQueue queue;
+    vector<pthread_t> threads;
+    unsigned int i;
+
+    queue.command = this;
+    queue.master = &m;
+    queue.slaves.assign(slaves.begin(), slaves.end());
+    queue.next = 0;
+    pthread_mutex_init(&queue.mutex, NULL);
+    failures = 0;
+
+    for (i = 0; i < queue.slaves.size() && i < MAX_TRANSFER_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, transferThread, &queue)) {
+            break;
+        }
+        threads.push_back(thread);
+    }
+
+    if (threads.empty()) { // execute in this thread
+        transferThread(&queue);
+    }
+
+    for (i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&queue.mutex);
+
+    if (failures) {
+        stringstream err;
+        err << failures << " transfer(s) failed.";
+        throwCommandException(err);
+    }
+}
+
+/*****************************************************************************/
+
+void *SdoCommand::transferThread(void *arg)
+{
+    SlaveQueue *queue = (SlaveQueue *) arg;
+
+    while (1) {
+        const ec_ioctl_slave_t *slave;
+
+        pthread_mutex_lock(&queue->mutex);
+        if (queue->next >= queue->slaves.size()) {
+            pthread_mutex_unlock(&queue->mutex);
+            break;
+        }
+        slave = &queue->slaves[queue->next++];
+        pthread_mutex_unlock(&queue->mutex);
+
+        queue->command->transferSlave(*queue->master, *slave);
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/** Prints the result of a transfer in multi-object mode.
+ */
+void SdoCommand::printResult(
+        const ec_ioctl_slave_t &slave,
+        const SdoAddress &address,
+        const string &result
+        )
+{
+    pthread_mutex_lock(&outputMutex);
+    cout << dec << slave.position << " " << sdoAddressString(address)
+        << " " << result;
+    cout.flush();
+    pthread_mutex_unlock(&outputMutex);
+}
+
+/*****************************************************************************/
+
+/** Prints the error of a transfer in multi-object mode.
+ */
+void SdoCommand::printError(
+        const ec_ioctl_slave_t &slave,
+        const SdoAddress &address,
+        const string &message
+        )
 {
+    pthread_mutex_lock(&outputMutex);
+    cerr << dec << slave.position << " " << sdoAddressString(address)
+        << ": " << message << endl;
+    failures++;
+    pthread_mutex_unlock(&outputMutex);
 }
 
 /****************************************************************************/
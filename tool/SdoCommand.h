@@ -30,6 +30,8 @@
 #ifndef __SDOCOMMAND_H__
 #define __SDOCOMMAND_H__
 
+#include <pthread.h>
+
 #include "Command.h"
 #include "DataTypeHandler.h"
 
@@ -41,10 +43,50 @@ class SdoCommand:
 {
     public:
         SdoCommand(const string &, const string &);
+        ~SdoCommand();
 
         static const char *abortText(uint32_t);
 
+    protected:
+        /** SDO entry address given as <INDEX>:<SUBINDEX>. */
+        struct SdoAddress {
+            uint16_t index;
+            uint8_t subindex;
+        };
+
+        static bool isSdoAddress(const string &);
+        SdoAddress parseSdoAddress(const string &) const;
+        static string sdoAddressString(const SdoAddress &);
+        const DataType *entryDataType(MasterDevice &, uint16_t,
+                const SdoAddress &) const;
+
+        void transferConcurrently(MasterDevice &, const SlaveList &);
+        /** Executes the transfers of a slave in multi-object mode.
+         *
+         * Called concurrently for different slaves.
+         */
+        virtual void transferSlave(MasterDevice &,
+                const ec_ioctl_slave_t &) {}
+        void printResult(const ec_ioctl_slave_t &, const SdoAddress &,
+                const string &);
+        void printError(const ec_ioctl_slave_t &, const SdoAddress &,
+                const string &);
+
     private:
+        pthread_mutex_t outputMutex; /**< Serializes the output of
+                                       concurrent transfers. */
+        unsigned int failures; /**< Failed concurrent transfers. */
+
+        struct SlaveQueue {
+            SdoCommand *command;
+            MasterDevice *master;
+            vector<ec_ioctl_slave_t> slaves;
+            unsigned int next;
+            pthread_mutex_t mutex;
+        };
+
+        static void *transferThread(void *);
+
         struct AbortMessage {
             uint32_t code;
             const char *message;
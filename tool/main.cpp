@@ -27,20 +27,32 @@
  *
  ****************************************************************************/
 
+#include <ctype.h>
 #include <getopt.h>
 #include <libgen.h> // basename()
+#include <pthread.h>
 #include <stdlib.h>
 
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <vector>
 using namespace std;
 
 #include "CommandAlias.h"
+#include "CommandBench.h"
+#include "CommandBudget.h"
+#include "CommandCapture.h"
 #include "CommandConfig.h"
 #include "CommandCrc.h"
 #include "CommandCStruct.h"
 #include "CommandData.h"
+#include "CommandDatagrams.h"
+#include "CommandDc.h"
 #include "CommandDebug.h"
+#include "CommandDictExport.h"
+#include "CommandDictImport.h"
 #include "CommandDomains.h"
 #include "CommandDownload.h"
 #ifdef EC_EOE
@@ -48,8 +60,12 @@ using namespace std;
 #endif
 #include "CommandFoeRead.h"
 #include "CommandFoeWrite.h"
+#include "CommandGateway.h"
 #include "CommandGraph.h"
+#include "CommandHistory.h"
+#include "CommandLatency.h"
 #include "CommandMaster.h"
+#include "CommandNetExport.h"
 #include "CommandPdos.h"
 #include "CommandRegRead.h"
 #include "CommandRegWrite.h"
@@ -58,9 +74,13 @@ using namespace std;
 #include "CommandSiiRead.h"
 #include "CommandSiiWrite.h"
 #include "CommandSlaves.h"
+#include "CommandSoeBackup.h"
 #include "CommandSoeRead.h"
+#include "CommandSoeRestore.h"
 #include "CommandSoeWrite.h"
+#include "CommandStartupProfile.h"
 #include "CommandStates.h"
+#include "CommandTop.h"
 #include "CommandUpload.h"
 #include "CommandVersion.h"
 #include "CommandXml.h"
@@ -88,6 +108,11 @@ bool emergency = false;
 bool helpRequested = false;
 string outputFile;
 string skin;
+string batchFile;
+
+/** Maximum number of concurrently executed batch commands.
+ */
+#define MAX_BATCH_THREADS 32
 
 /*****************************************************************************/
 
@@ -121,6 +146,19 @@ string usage()
         << "                         Default: '-' (all)."
         << endl
         << "  --force   -f           Force a command." << endl
+        << "  --batch   -b <file>    Execute the commands in <file> (one"
+        << endl
+        << "                         per line, '-' for stdin) with the"
+        << endl
+        << "                         master devices opened once."
+        << endl
+        << "                         Consecutive 'download' commands"
+        << endl
+        << "                         for different slaves are executed"
+        << endl
+        << "                         concurrently. Stops at the first"
+        << endl
+        << "                         failing line." << endl
         << "  --quiet   -q           Output less information." << endl
         << "  --verbose -v           Output more information." << endl
         << "  --help    -h           Show this help." << endl
@@ -137,7 +175,32 @@ string usage()
 
 /*****************************************************************************/
 
-void getOptions(int argc, char **argv)
+/** Resets the option variables to their defaults.
+ */
+void resetOptions()
+{
+    masters = "-";
+    positions = "-";
+    aliases = "-";
+    domains = "-";
+    dataTypeStr = "";
+    verbosity = Command::Normal;
+    force = false;
+    emergency = false;
+    helpRequested = false;
+    outputFile = "";
+    skin = "";
+    commandName = "";
+    commandArgs.clear();
+}
+
+/*****************************************************************************/
+
+/** Parses the command line.
+ *
+ * \return Zero on success, otherwise the exit code.
+ */
+int getOptions(int argc, char **argv, bool batchLine = false)
 {
     int c, argCount;
     stringstream str;
@@ -153,6 +216,7 @@ void getOptions(int argc, char **argv)
         {"skin",        required_argument, NULL, 's'},
         {"emergency",   no_argument,       NULL, 'e'},
         {"force",       no_argument,       NULL, 'f'},
+        {"batch",       required_argument, NULL, 'b'},
         {"quiet",       no_argument,       NULL, 'q'},
         {"verbose",     no_argument,       NULL, 'v'},
         {"help",        no_argument,       NULL, 'h'},
@@ -160,7 +224,8 @@ void getOptions(int argc, char **argv)
     };
 
     do {
-        c = getopt_long(argc, argv, "m:a:p:d:t:o:s:efqvh", longOptions, NULL);
+        c = getopt_long(argc, argv, "m:a:p:d:t:o:s:efb:qvh",
+                longOptions, NULL);
 
         switch (c) {
             case 'm':
@@ -199,6 +264,14 @@ void getOptions(int argc, char **argv)
                 force = true;
                 break;
 
+            case 'b':
+                if (batchLine) {
+                    cerr << "Batch files can not be nested!" << endl;
+                    return 1;
+                }
+                batchFile = optarg;
+                break;
+
             case 'q':
                 verbosity = Command::Quiet;
                 break;
@@ -212,6 +285,9 @@ void getOptions(int argc, char **argv)
                 break;
 
             case '?':
+                if (batchLine) {
+                    return 1;
+                }
                 cerr << endl << usage();
                 exit(1);
 
@@ -223,6 +299,15 @@ void getOptions(int argc, char **argv)
 
     argCount = argc - optind;
 
+    if (!argCount && batchLine) {
+        cerr << "Please specify a command!" << endl;
+        return 1;
+    }
+
+    if (!argCount && !batchFile.empty()) {
+        return 0;
+    }
+
     if (!argCount) {
         if (helpRequested) {
             cout << usage();
@@ -237,6 +322,8 @@ void getOptions(int argc, char **argv)
     commandName = argv[optind];
     while (++optind < argc)
         commandArgs.push_back(string(argv[optind]));
+
+    return 0;
 }
 
 /****************************************************************************/
@@ -246,6 +333,14 @@ list<Command *> getMatchingCommands(const string &cmdStr)
     CommandList::iterator ci;
     list<Command *> res;
 
+    // an exact match wins (a command name can be a prefix of another one)
+    for (ci = commandList.begin(); ci != commandList.end(); ci++) {
+        if ((*ci)->getName() == cmdStr) {
+            res.push_back(*ci);
+            return res;
+        }
+    }
+
     // find matching commands from beginning of the string
     for (ci = commandList.begin(); ci != commandList.end(); ci++) {
         if ((*ci)->matchesSubstr(cmdStr)) {
@@ -267,21 +362,410 @@ list<Command *> getMatchingCommands(const string &cmdStr)
 
 /****************************************************************************/
 
-int main(int argc, char **argv)
+/** Passes the option variables to a command.
+ */
+void applyOptions(Command *cmd)
+{
+    cmd->setMasters(masters);
+    cmd->setVerbosity(verbosity);
+    cmd->setAliases(aliases);
+    cmd->setPositions(positions);
+    cmd->setDomains(domains);
+    cmd->setDataType(dataTypeStr);
+    cmd->setOutputFile(outputFile);
+    cmd->setSkin(skin);
+    cmd->setEmergency(emergency);
+    cmd->setForce(force);
+}
+
+/****************************************************************************/
+
+/** Executes a command with the current option variables.
+ *
+ * \return Exit code.
+ */
+int executeCommand(Command *cmd, bool showHelp = true)
+{
+    try {
+        applyOptions(cmd);
+        cmd->execute(commandArgs);
+    } catch (InvalidUsageException &e) {
+        cerr << e.what() << endl;
+        if (showHelp) {
+            cerr << endl << cmd->helpString(binaryBaseName);
+        }
+        return 1;
+    } catch (CommandException &e) {
+        cerr << e.what() << endl;
+        return 1;
+    } catch (MasterDeviceException &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Looks up the command matching commandName.
+ *
+ * \return The command, or NULL, if there is no unique match.
+ */
+Command *findCommand(bool showUsage = true)
 {
-    int retval = 0;
     list<Command *> matchingCommands;
     list<Command *>::const_iterator ci;
+
+    matchingCommands = getMatchingCommands(commandName);
+
+    if (matchingCommands.size() == 1) {
+        return matchingCommands.front();
+    }
+
+    if (matchingCommands.size()) {
+        cerr << "Ambiguous command abbreviation! Matching:" << endl;
+        for (ci = matchingCommands.begin();
+                ci != matchingCommands.end();
+                ci++) {
+            cerr << (*ci)->getName() << endl;
+        }
+    } else {
+        cerr << "Unknown command " << commandName << "!" << endl;
+    }
+
+    if (showUsage) {
+        cerr << endl << usage();
+    }
+
+    return NULL;
+}
+
+/****************************************************************************/
+
+/** Batch download executed concurrently with others.
+ */
+struct BatchDownload {
+    unsigned int lineNumber;
+    string slaveSelection; /**< Masters, aliases and positions. */
+    CommandDownload command;
+    Command::StringVector args;
+    int retval;
+    string error;
+};
+
+/** Downloads for one slave selection, executed in order.
+ */
+typedef vector<BatchDownload *> BatchDownloadList;
+
+/** Shared state of the batch download threads.
+ */
+struct BatchDownloadQueue {
+    vector<BatchDownloadList> lists;
+    unsigned int next;
+    pthread_mutex_t mutex;
+};
+
+/****************************************************************************/
+
+/** Batch download thread: executes download lists until all are done.
+ */
+void *batchDownloadThread(void *arg)
+{
+    BatchDownloadQueue *queue = (BatchDownloadQueue *) arg;
+
+    while (1) {
+        BatchDownloadList *list;
+        BatchDownloadList::iterator di;
+
+        pthread_mutex_lock(&queue->mutex);
+        if (queue->next >= queue->lists.size()) {
+            pthread_mutex_unlock(&queue->mutex);
+            break;
+        }
+        list = &queue->lists[queue->next++];
+        pthread_mutex_unlock(&queue->mutex);
+
+        for (di = list->begin(); di != list->end(); di++) {
+            BatchDownload *d = *di;
+
+            try {
+                d->command.execute(d->args);
+            } catch (InvalidUsageException &e) {
+                d->error = e.what();
+            } catch (CommandException &e) {
+                d->error = e.what();
+            } catch (MasterDeviceException &e) {
+                d->error = e.what();
+            }
+
+            if (!d->error.empty()) {
+                d->retval = 1;
+                break; // keep the order for this slave
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/****************************************************************************/
+
+/** Executes pending batch downloads concurrently.
+ *
+ * Downloads with the same slave selection are executed in order by the same
+ * thread.
+ *
+ * \return Exit code.
+ */
+int flushBatchDownloads(vector<BatchDownload *> &downloads)
+{
+    BatchDownloadQueue queue;
+    map<string, unsigned int> listIndices;
+    vector<pthread_t> threads;
+    vector<BatchDownload *>::iterator di;
+    unsigned int i;
+    int retval = 0;
+
+    if (downloads.empty()) {
+        return 0;
+    }
+
+    for (di = downloads.begin(); di != downloads.end(); di++) {
+        const string &key = (*di)->slaveSelection;
+        map<string, unsigned int>::const_iterator li = listIndices.find(key);
+
+        if (li == listIndices.end()) {
+            listIndices[key] = queue.lists.size();
+            queue.lists.push_back(BatchDownloadList());
+            queue.lists.back().push_back(*di);
+        } else {
+            queue.lists[li->second].push_back(*di);
+        }
+    }
+
+    queue.next = 0;
+    pthread_mutex_init(&queue.mutex, NULL);
+
+    for (i = 0; i < queue.lists.size() && i < MAX_BATCH_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, batchDownloadThread, &queue)) {
+            break;
+        }
+        threads.push_back(thread);
+    }
+
+    if (threads.empty()) { // execute in this thread
+        batchDownloadThread(&queue);
+    }
+
+    for (i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&queue.mutex);
+
+    for (di = downloads.begin(); di != downloads.end(); di++) {
+        if ((*di)->retval) {
+            cerr << batchFile << ":" << (*di)->lineNumber << ": "
+                << (*di)->error << endl;
+            retval = (*di)->retval;
+        }
+        delete *di;
+    }
+
+    downloads.clear();
+    return retval;
+}
+
+/****************************************************************************/
+
+/** Splits a batch line into arguments.
+ *
+ * Arguments are separated by white space. Single and double quotes group
+ * white space, a backslash escapes the next character. Everything behind a
+ * '#' outside of quotes is ignored.
+ *
+ * \return Zero on success, otherwise non-zero.
+ */
+int splitBatchLine(const string &line, vector<string> &args)
+{
+    string arg;
+    bool inArg = false;
+    char quote = 0;
+    string::size_type i;
+
+    for (i = 0; i < line.size(); i++) {
+        char c = line[i];
+
+        if (c == '\\' && quote != '\'') {
+            if (++i == line.size()) {
+                return 1;
+            }
+            arg += line[i];
+            inArg = true;
+        } else if (quote) {
+            if (c == quote) {
+                quote = 0;
+            } else {
+                arg += c;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inArg = true;
+        } else if (c == '#') {
+            break;
+        } else if (isspace(c)) {
+            if (inArg) {
+                args.push_back(arg);
+                arg.clear();
+                inArg = false;
+            }
+        } else {
+            arg += c;
+            inArg = true;
+        }
+    }
+
+    if (quote) {
+        return 1;
+    }
+
+    if (inArg) {
+        args.push_back(arg);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Executes the commands of the batch file.
+ *
+ * \return Exit code.
+ */
+int executeBatch()
+{
+    ifstream file;
+    istream *in = &cin;
+    string line;
+    unsigned int lineNumber = 0;
+    vector<BatchDownload *> downloads;
+    int retval = 0;
+
+    if (batchFile != "-") {
+        file.open(batchFile.c_str());
+        if (!file.is_open()) {
+            cerr << "Failed to open " << batchFile << "!" << endl;
+            return 1;
+        }
+        in = &file;
+    }
+
+    MasterDevice::setShared(true);
+
+    while (!retval && getline(*in, line)) {
+        vector<string> args;
+        vector<char *> argv;
+        Command *cmd;
+        unsigned int i;
+
+        lineNumber++;
+
+        if (splitBatchLine(line, args)) {
+            cerr << batchFile << ":" << lineNumber
+                << ": Unterminated quote or escape!" << endl;
+            retval = 1;
+            break;
+        }
+
+        if (args.empty()) {
+            continue;
+        }
+
+        argv.push_back((char *) binaryBaseName.c_str());
+        for (i = 0; i < args.size(); i++) {
+            argv.push_back((char *) args[i].c_str());
+        }
+        argv.push_back(NULL);
+
+        resetOptions();
+        optind = 0; // re-initialize getopt
+        if (getOptions(argv.size() - 1, &argv[0], true)) {
+            cerr << batchFile << ":" << lineNumber << ": Invalid options."
+                << endl;
+            retval = 1;
+            break;
+        }
+
+        if (!(cmd = findCommand(false))) {
+            cerr << batchFile << ":" << lineNumber << ": Invalid command."
+                << endl;
+            retval = 1;
+            break;
+        }
+
+        if (helpRequested) {
+            cout << cmd->helpString(binaryBaseName);
+            continue;
+        }
+
+        if (cmd->getName() == "download") {
+            BatchDownload *d = new BatchDownload();
+            d->lineNumber = lineNumber;
+            d->slaveSelection = masters + "/" + aliases + "/" + positions;
+            d->args = commandArgs;
+            d->retval = 0;
+            applyOptions(&d->command);
+            downloads.push_back(d);
+            continue;
+        }
+
+        if ((retval = flushBatchDownloads(downloads))) {
+            break;
+        }
+
+        if ((retval = executeCommand(cmd, false))) {
+            cerr << batchFile << ":" << lineNumber << ": Command failed."
+                << endl;
+        }
+    }
+
+    if (!retval) {
+        retval = flushBatchDownloads(downloads);
+    } else {
+        vector<BatchDownload *>::iterator di;
+        for (di = downloads.begin(); di != downloads.end(); di++) {
+            delete *di;
+        }
+    }
+
+    MasterDevice::closeShared();
+    return retval;
+}
+
+/****************************************************************************/
+
+int main(int argc, char **argv)
+{
+    int retval = 0;
     Command *cmd;
 
     binaryBaseName = basename(argv[0]);
 
     commandList.push_back(new CommandAlias());
+    commandList.push_back(new CommandBench());
+    commandList.push_back(new CommandBudget());
+    commandList.push_back(new CommandCapture());
     commandList.push_back(new CommandConfig());
     commandList.push_back(new CommandCrc());
     commandList.push_back(new CommandCStruct());
     commandList.push_back(new CommandData());
+    commandList.push_back(new CommandDatagrams());
+    commandList.push_back(new CommandDc());
     commandList.push_back(new CommandDebug());
+    commandList.push_back(new CommandDictExport());
+    commandList.push_back(new CommandDictImport());
     commandList.push_back(new CommandDomains());
     commandList.push_back(new CommandDownload());
 #ifdef EC_EOE
@@ -289,8 +773,12 @@ int main(int argc, char **argv)
 #endif
     commandList.push_back(new CommandFoeRead());
     commandList.push_back(new CommandFoeWrite());
+    commandList.push_back(new CommandGateway());
     commandList.push_back(new CommandGraph());
+    commandList.push_back(new CommandHistory());
+    commandList.push_back(new CommandLatency());
     commandList.push_back(new CommandMaster());
+    commandList.push_back(new CommandNetExport());
     commandList.push_back(new CommandPdos());
     commandList.push_back(new CommandRegRead());
     commandList.push_back(new CommandRegWrite());
@@ -299,60 +787,30 @@ int main(int argc, char **argv)
     commandList.push_back(new CommandSiiRead());
     commandList.push_back(new CommandSiiWrite());
     commandList.push_back(new CommandSlaves());
+    commandList.push_back(new CommandSoeBackup());
     commandList.push_back(new CommandSoeRead());
+    commandList.push_back(new CommandSoeRestore());
     commandList.push_back(new CommandSoeWrite());
+    commandList.push_back(new CommandStartupProfile());
     commandList.push_back(new CommandStates());
+    commandList.push_back(new CommandTop());
     commandList.push_back(new CommandUpload());
     commandList.push_back(new CommandVersion());
     commandList.push_back(new CommandXml());
 
     getOptions(argc, argv);
 
-    matchingCommands = getMatchingCommands(commandName);
+    if (!batchFile.empty()) {
+        return executeBatch();
+    }
 
-    if (matchingCommands.size()) {
-        if (matchingCommands.size() == 1) {
-            cmd = matchingCommands.front();
-            if (!helpRequested) {
-                try {
-                    cmd->setMasters(masters);
-                    cmd->setVerbosity(verbosity);
-                    cmd->setAliases(aliases);
-                    cmd->setPositions(positions);
-                    cmd->setDomains(domains);
-                    cmd->setDataType(dataTypeStr);
-                    cmd->setOutputFile(outputFile);
-                    cmd->setSkin(skin);
-                    cmd->setEmergency(emergency);
-                    cmd->setForce(force);
-                    cmd->execute(commandArgs);
-                } catch (InvalidUsageException &e) {
-                    cerr << e.what() << endl << endl;
-                    cerr << cmd->helpString(binaryBaseName);
-                    retval = 1;
-                } catch (CommandException &e) {
-                    cerr << e.what() << endl;
-                    retval = 1;
-                } catch (MasterDeviceException &e) {
-                    cerr << e.what() << endl;
-                    retval = 1;
-                }
-            } else {
-                cout << cmd->helpString(binaryBaseName);
-            }
+    if ((cmd = findCommand())) {
+        if (!helpRequested) {
+            retval = executeCommand(cmd);
         } else {
-            cerr << "Ambiguous command abbreviation! Matching:" << endl;
-            for (ci = matchingCommands.begin();
-                    ci != matchingCommands.end();
-                    ci++) {
-                cerr << (*ci)->getName() << endl;
-            }
-            cerr << endl << usage();
-            retval = 1;
+            cout << cmd->helpString(binaryBaseName);
         }
     } else {
-        cerr << "Unknown command " << commandName << "!" << endl
-            << endl << usage();
         retval = 1;
     }
 
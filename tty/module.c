@@ -44,6 +44,7 @@
 #include <linux/serial.h>
 #include <linux/uaccess.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 
 #include "../master/globals.h"
 #include "../include/ectty.h"
@@ -53,8 +54,8 @@
 #define PFX "ec_tty: "
 
 #define EC_TTY_MAX_DEVICES 32
-#define EC_TTY_TX_BUFFER_SIZE 100
-#define EC_TTY_RX_BUFFER_SIZE 100
+#define EC_TTY_TX_BUFFER_SIZE 4096
+#define EC_TTY_RX_BUFFER_SIZE 4096
 
 #define EC_TTY_DEBUG 0
 
@@ -62,6 +63,8 @@
 
 char *ec_master_version_str = EC_MASTER_VERSION; /**< Version string. */
 unsigned int debug_level = 0;
+static unsigned int tx_buffer_size = EC_TTY_TX_BUFFER_SIZE;
+static unsigned int rx_buffer_size = EC_TTY_RX_BUFFER_SIZE;
 
 static struct tty_driver *tty_driver = NULL;
 ec_tty_t *ttys[EC_TTY_MAX_DEVICES];
@@ -80,6 +83,10 @@ MODULE_VERSION(EC_MASTER_VERSION);
 
 module_param_named(debug_level, debug_level, uint, S_IRUGO);
 MODULE_PARM_DESC(debug_level, "Debug level");
+module_param_named(tx_buffer_size, tx_buffer_size, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_buffer_size, "Size of the TX ring buffers in bytes");
+module_param_named(rx_buffer_size, rx_buffer_size, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_buffer_size, "Size of the RX ring buffers in bytes");
 
 /** \endcond */
 
@@ -99,16 +106,20 @@ struct ec_tty {
     int minor;
     struct device *dev;
 
-    uint8_t tx_buffer[EC_TTY_TX_BUFFER_SIZE];
+    uint8_t *tx_buffer;
+    unsigned int tx_buffer_size;
     unsigned int tx_read_idx;
     unsigned int tx_write_idx;
     unsigned int wakeup;
 
-    uint8_t rx_buffer[EC_TTY_RX_BUFFER_SIZE];
+    uint8_t *rx_buffer;
+    unsigned int rx_buffer_size;
     unsigned int rx_read_idx;
     unsigned int rx_write_idx;
+    spinlock_t rx_lock;
 
     struct timer_list timer;
+    unsigned int polled;
     struct tty_struct *tty;
     unsigned int open_count;
     struct semaphore sem;
@@ -131,6 +142,12 @@ int __init ec_tty_init_module(void)
 
     printk(KERN_INFO PFX "TTY driver %s\n", EC_MASTER_VERSION);
 
+    if (tx_buffer_size < 2 || rx_buffer_size < 2) {
+        printk(KERN_ERR PFX "Invalid ring buffer sizes %u/%u.\n",
+                tx_buffer_size, rx_buffer_size);
+        return -EINVAL;
+    }
+
     sema_init(&tty_sem, 1);
 
     for (i = 0; i < EC_TTY_MAX_DEVICES; i++) {
@@ -195,22 +212,37 @@ int ec_tty_init(ec_tty_t *t, int minor,
     struct ktermios *termios;
 
     t->minor = minor;
+    t->tx_buffer = NULL;
+    t->tx_buffer_size = tx_buffer_size;
     t->tx_read_idx = 0;
     t->tx_write_idx = 0;
     t->wakeup = 0;
+    t->rx_buffer = NULL;
+    t->rx_buffer_size = rx_buffer_size;
     t->rx_read_idx = 0;
     t->rx_write_idx = 0;
+    spin_lock_init(&t->rx_lock);
     init_timer(&t->timer);
+    t->polled = 0;
     t->tty = NULL;
     t->open_count = 0;
     sema_init(&t->sem, 1);
     t->ops = *ops;
     t->cb_data = cb_data;
 
+    t->tx_buffer = kmalloc(t->tx_buffer_size, GFP_KERNEL);
+    t->rx_buffer = kmalloc(t->rx_buffer_size, GFP_KERNEL);
+    if (!t->tx_buffer || !t->rx_buffer) {
+        printk(KERN_ERR PFX "Failed to allocate ring buffers.\n");
+        ret = -ENOMEM;
+        goto out_free;
+    }
+
     t->dev = tty_register_device(tty_driver, t->minor, NULL);
     if (IS_ERR(t->dev)) {
         printk(KERN_ERR PFX "Failed to register tty device.\n");
-        return PTR_ERR(t->dev);
+        ret = PTR_ERR(t->dev);
+        goto out_free;
     }
 
     // Tell the device-specific implementation about the initial cflags
@@ -234,7 +266,7 @@ int ec_tty_init(ec_tty_t *t, int minor,
         printk(KERN_ERR PFX "ERROR: Initial cflag 0x%x not accepted.\n",
                 cflag);
         tty_unregister_device(tty_driver, t->minor);
-        return ret;
+        goto out_free;
     }
 
     t->timer.function = ec_tty_wakeup;
@@ -242,6 +274,11 @@ int ec_tty_init(ec_tty_t *t, int minor,
     t->timer.expires = jiffies + 10;
     add_timer(&t->timer);
     return 0;
+
+out_free:
+    kfree(t->rx_buffer);
+    kfree(t->tx_buffer);
+    return ret;
 }
 
 /*****************************************************************************/
@@ -250,6 +287,8 @@ void ec_tty_clear(ec_tty_t *tty)
 {
     del_timer_sync(&tty->timer);
     tty_unregister_device(tty_driver, tty->minor);
+    kfree(tty->rx_buffer);
+    kfree(tty->tx_buffer);
 }
 
 /*****************************************************************************/
@@ -261,7 +300,7 @@ unsigned int ec_tty_tx_size(ec_tty_t *tty)
     if (tty->tx_write_idx >= tty->tx_read_idx) {
         ret = tty->tx_write_idx - tty->tx_read_idx;
     } else {
-        ret = EC_TTY_TX_BUFFER_SIZE + tty->tx_write_idx - tty->tx_read_idx;
+        ret = tty->tx_buffer_size + tty->tx_write_idx - tty->tx_read_idx;
     }
 
     return ret;
@@ -271,7 +310,7 @@ unsigned int ec_tty_tx_size(ec_tty_t *tty)
 
 unsigned int ec_tty_tx_space(ec_tty_t *tty)
 {
-    return EC_TTY_TX_BUFFER_SIZE - 1 - ec_tty_tx_size(tty);
+    return tty->tx_buffer_size - 1 - ec_tty_tx_size(tty);
 }
 
 /*****************************************************************************/
@@ -283,7 +322,7 @@ unsigned int ec_tty_rx_size(ec_tty_t *tty)
     if (tty->rx_write_idx >= tty->rx_read_idx) {
         ret = tty->rx_write_idx - tty->rx_read_idx;
     } else {
-        ret = EC_TTY_RX_BUFFER_SIZE + tty->rx_write_idx - tty->rx_read_idx;
+        ret = tty->rx_buffer_size + tty->rx_write_idx - tty->rx_read_idx;
     }
 
     return ret;
@@ -293,7 +332,7 @@ unsigned int ec_tty_rx_size(ec_tty_t *tty)
 
 unsigned int ec_tty_rx_space(ec_tty_t *tty)
 {
-    return EC_TTY_RX_BUFFER_SIZE - 1 - ec_tty_rx_size(tty);
+    return tty->rx_buffer_size - 1 - ec_tty_rx_size(tty);
 }
 
 /*****************************************************************************/
@@ -315,11 +354,14 @@ int ec_tty_get_serial_info(ec_tty_t *tty, struct serial_struct *data)
 
 /*****************************************************************************/
 
-/** Timer function.
+/** Wakes up writers and pushes received data into the TTY core.
+ *
+ * Called either by ectty_poll() in the application cycle, or by the fallback
+ * timer.
  */
-void ec_tty_wakeup(unsigned long data)
+void ec_tty_poll(ec_tty_t *tty)
 {
-    ec_tty_t *tty = (ec_tty_t *) data;
+    unsigned long flags;
     size_t to_recv;
 
     /* Wake up any process waiting to send data */
@@ -334,6 +376,7 @@ void ec_tty_wakeup(unsigned long data)
     }
 
     /* Push received data into TTY core. */
+    spin_lock_irqsave(&tty->rx_lock, flags);
     to_recv = ec_tty_rx_size(tty);
     if (to_recv && tty->tty) {
         unsigned char *cbuf;
@@ -364,7 +407,7 @@ void ec_tty_wakeup(unsigned long data)
             for (i = 0; i < to_recv; i++) {
                 cbuf[i] = tty->rx_buffer[tty->rx_read_idx];
                 tty->rx_read_idx =
-                    (tty->rx_read_idx + 1) % EC_TTY_RX_BUFFER_SIZE;
+                    (tty->rx_read_idx + 1) % tty->rx_buffer_size;
             }
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 9, 0)
             tty_flip_buffer_push(tty->tty->port);
@@ -373,6 +416,25 @@ void ec_tty_wakeup(unsigned long data)
 #endif
         }
     }
+    spin_unlock_irqrestore(&tty->rx_lock, flags);
+}
+
+/*****************************************************************************/
+
+/** Timer function.
+ *
+ * Polls the interface every jiffy, until the application takes over by
+ * calling ectty_poll().
+ */
+void ec_tty_wakeup(unsigned long data)
+{
+    ec_tty_t *tty = (ec_tty_t *) data;
+
+    if (tty->polled) {
+        return;
+    }
+
+    ec_tty_poll(tty);
 
     tty->timer.expires += 1;
     add_timer(&tty->timer);
@@ -456,7 +518,7 @@ static int ec_tty_write(
     data_size = min(ec_tty_tx_space(t), (unsigned int) count);
     for (i = 0; i < data_size; i++) {
         t->tx_buffer[t->tx_write_idx] = buffer[i];
-        t->tx_write_idx = (t->tx_write_idx + 1) % EC_TTY_TX_BUFFER_SIZE;
+        t->tx_write_idx = (t->tx_write_idx + 1) % t->tx_buffer_size;
     }
 
 #if EC_TTY_DEBUG >= 1
@@ -481,7 +543,7 @@ static void ec_tty_put_char(struct tty_struct *tty, unsigned char ch)
 
     if (ec_tty_tx_space(t)) {
         t->tx_buffer[t->tx_write_idx] = ch;
-        t->tx_write_idx = (t->tx_write_idx + 1) % EC_TTY_TX_BUFFER_SIZE;
+        t->tx_write_idx = (t->tx_write_idx + 1) % t->tx_buffer_size;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
         return 1;
 #endif
@@ -771,7 +833,7 @@ unsigned int ectty_tx_data(ec_tty_t *tty, uint8_t *buffer, size_t size)
 
     for (i = 0; i < data_size; i++) {
         buffer[i] = tty->tx_buffer[tty->tx_read_idx];
-        tty->tx_read_idx = (tty->tx_read_idx + 1) % EC_TTY_TX_BUFFER_SIZE;
+        tty->tx_read_idx = (tty->tx_read_idx + 1) % tty->tx_buffer_size;
     }
 
     if (data_size) {
@@ -800,16 +862,31 @@ void ectty_rx_data(ec_tty_t *tty, const uint8_t *buffer, size_t size)
             printk(KERN_WARNING PFX "Dropping %u bytes.\n", size - to_recv);
         }
 
-        for (i = 0; i < size; i++) {
+        for (i = 0; i < to_recv; i++) {
             tty->rx_buffer[tty->rx_write_idx] = buffer[i];
             tty->rx_write_idx =
-                (tty->rx_write_idx + 1) % EC_TTY_RX_BUFFER_SIZE;
+                (tty->rx_write_idx + 1) % tty->rx_buffer_size;
         }
     }
 }
 
 /*****************************************************************************/
 
+unsigned int ectty_rx_space(ec_tty_t *tty)
+{
+    return ec_tty_rx_space(tty);
+}
+
+/*****************************************************************************/
+
+void ectty_poll(ec_tty_t *tty)
+{
+    tty->polled = 1;
+    ec_tty_poll(tty);
+}
+
+/*****************************************************************************/
+
 /** \cond */
 
 module_init(ec_tty_init_module);
@@ -819,6 +896,8 @@ EXPORT_SYMBOL(ectty_create);
 EXPORT_SYMBOL(ectty_free);
 EXPORT_SYMBOL(ectty_tx_data);
 EXPORT_SYMBOL(ectty_rx_data);
+EXPORT_SYMBOL(ectty_rx_space);
+EXPORT_SYMBOL(ectty_poll);
 
 /** \endcond */
 